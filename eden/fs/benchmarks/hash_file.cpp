@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <fcntl.h>
+#include <folly/Exception.h>
+#include <folly/File.h>
+#include <folly/portability/GFlags.h>
+#include <folly/portability/OpenSSL.h>
+#include <sys/stat.h>
+#include <vector>
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/digest/Blake3.h"
+
+namespace {
+
+DEFINE_string(
+    filename,
+    "",
+    "Path of a file to hash, such as a large materialized file of an EdenFS "
+    "checkout. The file is read from the page cache after the first pass.");
+
+/**
+ * Hash the whole file per iteration, reading it in blocks of state.range(0)
+ * bytes like EdenFS does when computing the hash of a materialized file.
+ */
+template <typename Hasher>
+void hashFile(benchmark::State& state, Hasher&& hasher) {
+  if (FLAGS_filename.empty()) {
+    state.SkipWithError("--filename is required");
+    return;
+  }
+
+  folly::File file{FLAGS_filename, O_RDONLY | O_CLOEXEC};
+  std::vector<uint8_t> buf(state.range(0));
+  size_t totalRead = 0;
+  for (auto _ : state) {
+    off_t offset = 0;
+    while (true) {
+      auto result = ::pread(file.fd(), buf.data(), buf.size(), offset);
+      folly::checkUnixError(result, "pread failed");
+      if (result == 0) {
+        break;
+      }
+      hasher(buf.data(), result);
+      offset += result;
+    }
+    totalRead += offset;
+  }
+
+  state.SetBytesProcessed(totalRead);
+}
+
+void sha1(benchmark::State& state) {
+  SHA_CTX ctx;
+  SHA1_Init(&ctx);
+  hashFile(state, [&](const uint8_t* data, size_t size) {
+    SHA1_Update(&ctx, data, size);
+  });
+  uint8_t out[SHA_DIGEST_LENGTH];
+  SHA1_Final(out, &ctx);
+}
+
+void blake3(benchmark::State& state) {
+  Blake3 hasher;
+  hashFile(state, [&](const uint8_t* data, size_t size) {
+    hasher.update(data, size);
+  });
+}
+
+void blake3_parallel(benchmark::State& state) {
+  Blake3 hasher;
+  hashFile(state, [&](const uint8_t* data, size_t size) {
+    hasher.updateParallel(data, size);
+  });
+}
+
+// Compare small reads with the 256KB reads EdenFS hashes files with.
+BENCHMARK(sha1)->Arg(8 * 1024)->Arg(256 * 1024)->UseRealTime();
+BENCHMARK(blake3)->Arg(8 * 1024)->Arg(256 * 1024)->UseRealTime();
+BENCHMARK(blake3_parallel)->Arg(256 * 1024)->Arg(4096 * 1024)->UseRealTime();
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
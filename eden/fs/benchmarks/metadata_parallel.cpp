@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <folly/Conv.h>
+#include <folly/Exception.h>
+#include <folly/init/Init.h>
+#include <folly/portability/GFlags.h>
+#include <folly/portability/Unistd.h>
+#include <folly/synchronization/test/Barrier.h>
+#include <inttypes.h>
+#include <sys/stat.h>
+#include <sys/xattr.h>
+#include <array>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "eden/common/utils/benchharness/Bench.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+DEFINE_uint64(threads, 1, "The number of concurrent threads");
+DEFINE_uint64(iterations, 100000, "Number of operations per thread");
+DEFINE_uint64(
+    workingSet,
+    0,
+    "Number of the given paths to cycle through, or 0 for all of them");
+DEFINE_string(
+    op,
+    "stat",
+    "One of lstat (a lookup), stat, readdir or getxattr (of user.sha1)");
+DEFINE_int32(
+    edenfsPid,
+    0,
+    "If set, count the hardware and scheduler events of this EdenFS process "
+    "while the benchmark runs. Requires permission to profile it.");
+
+using namespace facebook::eden;
+
+namespace {
+
+enum class Op { Lstat, Stat, Readdir, Getxattr };
+
+Op parseOp(const std::string& name) {
+  if (name == "lstat") {
+    return Op::Lstat;
+  } else if (name == "stat") {
+    return Op::Stat;
+  } else if (name == "readdir") {
+    return Op::Readdir;
+  } else if (name == "getxattr") {
+    return Op::Getxattr;
+  }
+  throw std::invalid_argument(folly::to<std::string>("unknown op: ", name));
+}
+
+void runOp(Op op, const char* path) {
+  struct stat st;
+  switch (op) {
+    case Op::Lstat:
+      folly::checkUnixError(::lstat(path, &st), "lstat failed: ", path);
+      return;
+    case Op::Stat:
+      folly::checkUnixError(::stat(path, &st), "stat failed: ", path);
+      return;
+    case Op::Readdir: {
+      DIR* dir = ::opendir(path);
+      if (!dir) {
+        folly::throwSystemError("opendir failed: ", path);
+      }
+      while (::readdir(dir)) {
+      }
+      ::closedir(dir);
+      return;
+    }
+    case Op::Getxattr: {
+      char buf[64];
+#ifdef __APPLE__
+      auto result = ::getxattr(path, "user.sha1", buf, sizeof(buf), 0, 0);
+#else
+      auto result = ::getxattr(path, "user.sha1", buf, sizeof(buf));
+#endif
+      folly::checkUnixError(result, "getxattr failed: ", path);
+      return;
+    }
+  }
+}
+
+#ifdef __linux__
+/**
+ * Counts hardware and scheduler events of every thread of a process.
+ *
+ * Counters are opened per thread, since a process-wide counter only follows
+ * the threads created after it was opened.
+ */
+class ProcessCounters {
+ public:
+  explicit ProcessCounters(pid_t pid) {
+    auto taskDir = folly::to<std::string>("/proc/", pid, "/task");
+    DIR* dir = ::opendir(taskDir.c_str());
+    if (!dir) {
+      folly::throwSystemError("failed to list the threads of ", pid);
+    }
+    while (auto* entry = ::readdir(dir)) {
+      auto tid = folly::tryTo<pid_t>(entry->d_name);
+      if (!tid.hasValue()) {
+        continue;
+      }
+      for (size_t i = 0; i < kEvents.size(); ++i) {
+        auto fd = open(tid.value(), kEvents[i].type, kEvents[i].config);
+        if (fd != -1) {
+          fds_[i].push_back(fd);
+        }
+      }
+    }
+    ::closedir(dir);
+  }
+
+  ~ProcessCounters() {
+    for (auto& fds : fds_) {
+      for (auto fd : fds) {
+        ::close(fd);
+      }
+    }
+  }
+
+  void start() {
+    for (auto& fds : fds_) {
+      for (auto fd : fds) {
+        ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+    }
+  }
+
+  void stopAndPrint() {
+    printf("EdenFS counters\n");
+    for (size_t i = 0; i < kEvents.size(); ++i) {
+      uint64_t total = 0;
+      for (auto fd : fds_[i]) {
+        ::ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        uint64_t value = 0;
+        if (::read(fd, &value, sizeof(value)) == sizeof(value)) {
+          total += value;
+        }
+      }
+      if (fds_[i].empty()) {
+        printf("  %s: unavailable\n", kEvents[i].name);
+      } else {
+        printf("  %s: %" PRIu64 "\n", kEvents[i].name, total);
+      }
+    }
+  }
+
+ private:
+  struct Event {
+    const char* name;
+    uint32_t type;
+    uint64_t config;
+  };
+  static constexpr std::array<Event, 4> kEvents{{
+      {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+      {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+      {"cache misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+      {"context switches",
+       PERF_TYPE_SOFTWARE,
+       PERF_COUNT_SW_CONTEXT_SWITCHES},
+  }};
+
+  static int open(pid_t tid, uint32_t type, uint64_t config) {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_hv = 1;
+    return static_cast<int>(
+        ::syscall(SYS_perf_event_open, &attr, tid, -1, -1, 0));
+  }
+
+  std::array<std::vector<int>, kEvents.size()> fds_;
+};
+#endif
+
+} // namespace
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+
+  if (argc <= 1) {
+    fprintf(
+        stderr,
+        "Specify a list of paths on the command line. Each thread cycles "
+        "through them, starting at a different offset.\n");
+    return 1;
+  }
+
+  auto op = parseOp(FLAGS_op);
+  std::vector<std::string> paths{argv + 1, argv + argc};
+  if (FLAGS_workingSet != 0 && FLAGS_workingSet < paths.size()) {
+    paths.resize(FLAGS_workingSet);
+  }
+
+  // Load every path once, so that the measurement does not include the
+  // first lookups.
+  for (const auto& path : paths) {
+    runOp(op, path.c_str());
+  }
+
+#ifdef __linux__
+  std::unique_ptr<ProcessCounters> counters;
+  if (FLAGS_edenfsPid != 0) {
+    counters = std::make_unique<ProcessCounters>(FLAGS_edenfsPid);
+  }
+#else
+  if (FLAGS_edenfsPid != 0) {
+    fprintf(stderr, "Process counters are only supported on Linux.\n");
+  }
+#endif
+
+  folly::test::Barrier gate{static_cast<uint32_t>(FLAGS_threads + 1)};
+  std::mutex resultMutex;
+  StatAccumulator combined;
+
+  auto thread = [&](size_t threadIndex) {
+    StatAccumulator accum;
+    size_t index = threadIndex * paths.size() / FLAGS_threads;
+
+    gate.wait();
+    for (uint64_t i = 0; i < FLAGS_iterations; ++i) {
+      const char* path = paths[index].c_str();
+      if (++index == paths.size()) {
+        index = 0;
+      }
+
+      uint64_t start = getTime();
+      runOp(op, path);
+      accum.add(getTime() - start);
+    }
+
+    std::lock_guard guard{resultMutex};
+    combined.combine(accum);
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(FLAGS_threads);
+  for (size_t t = 0; t < FLAGS_threads; ++t) {
+    threads.emplace_back(thread, t);
+  }
+
+#ifdef __linux__
+  if (counters) {
+    counters->start();
+  }
+#endif
+  auto start = std::chrono::steady_clock::now();
+  gate.wait();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto elapsed = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start);
+#ifdef __linux__
+  if (counters) {
+    counters->stopAndPrint();
+  }
+#endif
+
+  auto total = FLAGS_threads * FLAGS_iterations;
+  printf(
+      "%s() over %zu paths with %" PRIu64 " threads\n"
+      "  minimum: %" PRIu64 " ns\n  average: %" PRIu64 " ns\n"
+      "  throughput: %.0f ops/s\n",
+      FLAGS_op.c_str(),
+      paths.size(),
+      FLAGS_threads,
+      combined.getMinimum(),
+      combined.getAverage(),
+      total / elapsed.count());
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <fcntl.h>
+#include <folly/Exception.h>
+#include <folly/File.h>
+#include <folly/portability/GFlags.h>
+#include <sys/stat.h>
+#include <vector>
+#include "eden/common/utils/benchharness/Bench.h"
+
+namespace {
+
+DEFINE_string(
+    filename,
+    "",
+    "Path of a large file to read sequentially. To measure EdenFS rather than "
+    "the kernel's caches, this should be a file of an EdenFS checkout that "
+    "was not materialized.");
+DEFINE_uint64(blocksize, 128 * 1024, "Size of each read in bytes");
+
+void sequential_reads(benchmark::State& state) {
+  if (FLAGS_filename.empty()) {
+    state.SkipWithError("--filename is required");
+    return;
+  }
+  if (FLAGS_blocksize == 0) {
+    state.SkipWithError("--blocksize must be positive");
+    return;
+  }
+
+  folly::File file{FLAGS_filename, O_RDONLY | O_CLOEXEC};
+  struct stat st;
+  folly::checkUnixError(::fstat(file.fd(), &st), "fstat failed");
+  if (st.st_size == 0) {
+    state.SkipWithError("the file is empty");
+    return;
+  }
+
+  std::vector<char> buf(FLAGS_blocksize);
+
+  // Drop the file from the page cache before every pass over it, so that
+  // every read goes to the filesystem instead of the kernel's cache.
+  auto dropCache = [&] {
+#ifdef __linux__
+    folly::checkPosixError(
+        ::posix_fadvise(file.fd(), 0, 0, POSIX_FADV_DONTNEED),
+        "posix_fadvise failed");
+#endif
+  };
+  dropCache();
+
+  off_t offset = 0;
+  size_t totalRead = 0;
+  for (auto _ : state) {
+    auto result = ::pread(file.fd(), buf.data(), buf.size(), offset);
+    folly::checkUnixError(result, "pread failed");
+    totalRead += result;
+    offset += result;
+    if (result == 0 || offset >= st.st_size) {
+      state.PauseTiming();
+      dropCache();
+      offset = 0;
+      state.ResumeTiming();
+    }
+  }
+
+  state.SetBytesProcessed(totalRead);
+}
+
+BENCHMARK(sequential_reads)
+    // By default, google benchmark shows throughput numbers in bytes per CPU
+    // second. That's not useful, so tell it we care about wall clock time.
+    ->UseRealTime();
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
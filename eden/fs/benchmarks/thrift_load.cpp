@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/Random.h>
+#include <folly/Utility.h>
+#include <folly/init/Init.h>
+#include <folly/io/async/AsyncSocket.h>
+#include <folly/portability/GFlags.h>
+#include <folly/synchronization/test/Barrier.h>
+#include <thrift/lib/cpp2/async/HeaderClientChannel.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cinttypes>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/service/gen-cpp2/EdenService.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+DEFINE_string(repo, "", "Path to the EdenFS checkout to query");
+DEFINE_uint32(clients, 16, "The number of concurrent Thrift clients");
+DEFINE_uint32(seconds, 10, "How long every client issues requests for");
+DEFINE_uint32(
+    attributesWeight,
+    4,
+    "Relative share of getAttributesFromFilesV2 calls");
+DEFINE_uint32(globWeight, 1, "Relative share of globFiles calls");
+DEFINE_uint32(statusWeight, 1, "Relative share of getScmStatusV2 calls");
+DEFINE_uint32(
+    changesWeight,
+    2,
+    "Relative share of getFilesChangedSince calls, from the journal position "
+    "at the start of the run");
+DEFINE_uint32(
+    attributesBatch,
+    64,
+    "Number of the given files whose attributes every call requests");
+DEFINE_string(glob, "**/*.cpp", "The pattern of the globFiles calls");
+
+using namespace facebook::eden;
+
+namespace {
+
+enum Method { kAttributes, kGlob, kStatus, kChanges, kMethodCount };
+constexpr const char* kMethodNames[] = {
+    "getAttributesFromFilesV2",
+    "globFiles",
+    "getScmStatusV2",
+    "getFilesChangedSince",
+};
+
+std::unique_ptr<EdenServiceAsyncClient> connect(
+    folly::EventBase& eventBase,
+    AbsolutePathPiece repo) {
+  auto socketPath = repo + ".eden/socket"_relpath;
+  auto socket = folly::AsyncSocket::newSocket(
+      &eventBase, folly::SocketAddress::makeFromPath(socketPath.view()));
+  return std::make_unique<EdenServiceAsyncClient>(
+      apache::thrift::HeaderClientChannel::newChannel(std::move(socket)));
+}
+
+struct Requests {
+  GetAttributesFromFilesParams attributes;
+  GlobParams glob;
+  GetScmStatusParams status;
+  std::string mountPoint;
+  JournalPosition start;
+};
+
+void call(
+    EdenServiceAsyncClient& client,
+    Method method,
+    const Requests& requests,
+    const std::vector<std::string>& files) {
+  switch (method) {
+    case kAttributes: {
+      auto params = requests.attributes;
+      for (size_t i = 0; i < FLAGS_attributesBatch; ++i) {
+        params.paths_ref()->push_back(
+            files[folly::Random::rand32(files.size())]);
+      }
+      GetAttributesFromFilesResultV2 result;
+      client.sync_getAttributesFromFilesV2(result, params);
+      return;
+    }
+    case kGlob: {
+      Glob result;
+      client.sync_globFiles(result, requests.glob);
+      return;
+    }
+    case kStatus: {
+      GetScmStatusResult result;
+      client.sync_getScmStatusV2(result, requests.status);
+      return;
+    }
+    case kChanges: {
+      FileDelta result;
+      client.sync_getFilesChangedSince(
+          result, requests.mountPoint, requests.start);
+      return;
+    }
+    case kMethodCount:
+      break;
+  }
+}
+
+void printLatencies(
+    Method method,
+    std::vector<uint64_t>& samples,
+    double seconds) {
+  if (samples.empty()) {
+    return;
+  }
+  std::sort(samples.begin(), samples.end());
+  auto at = [&](double quantile) {
+    return samples[static_cast<size_t>(quantile * (samples.size() - 1))];
+  };
+  printf(
+      "%-26s %8zu calls %10.1f/s  p50 %8" PRIu64 " us  p90 %8" PRIu64
+      " us  p99 %8" PRIu64 " us  p99.9 %8" PRIu64 " us  max %8" PRIu64
+      " us\n",
+      kMethodNames[method],
+      samples.size(),
+      samples.size() / seconds,
+      at(0.5),
+      at(0.9),
+      at(0.99),
+      at(0.999),
+      samples.back());
+}
+
+} // namespace
+
+/*
+ * Issues a weighted mix of the Thrift calls build tools make, from many
+ * concurrent clients against a running EdenFS, and reports the throughput
+ * and latency distribution of every method.
+ *
+ * The remaining arguments are the repository-relative paths of the files
+ * whose attributes are requested.
+ */
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  if (FLAGS_repo.empty() || FLAGS_clients == 0) {
+    fprintf(stderr, "Specify --repo and a nonzero number of --clients\n");
+    return 1;
+  }
+  std::vector<std::string> files{argv + 1, argv + argc};
+  if (FLAGS_attributesWeight > 0 && files.empty()) {
+    fprintf(stderr, "Specify the files whose attributes to request\n");
+    return 1;
+  }
+
+  std::array<uint32_t, kMethodCount> weights{
+      FLAGS_attributesWeight,
+      FLAGS_globWeight,
+      FLAGS_statusWeight,
+      FLAGS_changesWeight};
+  uint32_t totalWeight = 0;
+  for (auto weight : weights) {
+    totalWeight += weight;
+  }
+  if (totalWeight == 0) {
+    fprintf(stderr, "At least one method must have a nonzero weight\n");
+    return 1;
+  }
+
+  auto repo = canonicalPath(FLAGS_repo);
+  Requests requests;
+  requests.mountPoint = repo.view();
+  {
+    folly::EventBase eventBase;
+    auto client = connect(eventBase, repo);
+    client->sync_getCurrentJournalPosition(
+        requests.start, requests.mountPoint);
+  }
+
+  requests.attributes.mountPoint_ref() = requests.mountPoint;
+  requests.attributes.requestedAttributes_ref() =
+      folly::to_underlying(FileAttributes::SHA1_HASH) |
+      folly::to_underlying(FileAttributes::FILE_SIZE) |
+      folly::to_underlying(FileAttributes::SOURCE_CONTROL_TYPE);
+  requests.glob.mountPoint_ref() = requests.mountPoint;
+  requests.glob.globs_ref() = std::vector<std::string>{FLAGS_glob};
+  requests.status.mountPoint_ref() = requests.mountPoint;
+  requests.status.commit_ref() = *requests.start.snapshotHash_ref();
+
+  folly::test::Barrier gate{FLAGS_clients + 1};
+  std::mutex resultMutex;
+  std::array<std::vector<uint64_t>, kMethodCount> latencies;
+
+  std::vector<std::thread> threads;
+  threads.reserve(FLAGS_clients);
+  for (uint32_t c = 0; c < FLAGS_clients; ++c) {
+    threads.emplace_back([&] {
+      // The client must be destroyed before its event base.
+      folly::EventBase eventBase;
+      auto client = connect(eventBase, repo);
+      std::array<std::vector<uint64_t>, kMethodCount> samples;
+
+      gate.wait();
+      auto deadline = std::chrono::steady_clock::now() +
+          std::chrono::seconds{FLAGS_seconds};
+      while (std::chrono::steady_clock::now() < deadline) {
+        auto pick = folly::Random::rand32(totalWeight);
+        size_t method = 0;
+        while (pick >= weights[method]) {
+          pick -= weights[method++];
+        }
+
+        auto start = getTime();
+        call(*client, static_cast<Method>(method), requests, files);
+        samples[method].push_back((getTime() - start) / 1000);
+      }
+
+      std::lock_guard guard{resultMutex};
+      for (size_t method = 0; method < kMethodCount; ++method) {
+        latencies[method].insert(
+            latencies[method].end(),
+            samples[method].begin(),
+            samples[method].end());
+      }
+    });
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  gate.wait();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto seconds = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+
+  printf("%u clients for %.1f s\n", FLAGS_clients, seconds);
+  for (size_t method = 0; method < kMethodCount; ++method) {
+    printLatencies(static_cast<Method>(method), latencies[method], seconds);
+  }
+  return 0;
+}
@@ -0,0 +1,264 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <folly/Conv.h>
+#include <folly/Exception.h>
+#include <folly/String.h>
+#include <folly/init/Init.h>
+#include <folly/portability/GFlags.h>
+#include <folly/portability/Unistd.h>
+#include <inttypes.h>
+#include <sys/stat.h>
+#include <sys/xattr.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <climits>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "eden/common/utils/benchharness/Bench.h"
+
+/*
+ * Replays a recorded filesystem workload against a mount and reports the
+ * latency distribution of each operation.
+ *
+ * The trace is a text file with one operation per line:
+ *
+ *   <start time in microseconds> <thread id> <operation> <path>
+ *
+ * where operation is one of stat, lstat, read, readdir, readlink or getxattr
+ * and the path is relative to --root. Operations recorded on the same thread
+ * are replayed in order on one thread, and each starts at its recorded offset
+ * from the first operation in the trace, so both the concurrency and the
+ * inter-arrival times of the recording are kept. Errors such as ENOENT are
+ * part of a normal build workload: they are counted, not fatal.
+ */
+
+DEFINE_string(trace, "", "Path to the trace to replay");
+DEFINE_string(root, "", "Mount that the paths in the trace are relative to");
+DEFINE_double(
+    speed,
+    1.0,
+    "Replay speed relative to the recording. 0 replays every operation as "
+    "soon as the previous one on its thread completes");
+
+using namespace facebook::eden;
+
+namespace {
+
+enum class Op { Stat, Lstat, Read, Readdir, Readlink, Getxattr };
+constexpr std::array<const char*, 6> kOpNames{
+    "stat", "lstat", "read", "readdir", "readlink", "getxattr"};
+
+Op parseOp(folly::StringPiece name) {
+  for (size_t i = 0; i < kOpNames.size(); ++i) {
+    if (name == kOpNames[i]) {
+      return static_cast<Op>(i);
+    }
+  }
+  throw std::invalid_argument(folly::to<std::string>("unknown op: ", name));
+}
+
+struct TraceEntry {
+  uint64_t startUs;
+  Op op;
+  std::string path;
+};
+
+struct Sample {
+  Op op;
+  uint64_t latencyNs;
+  bool failed;
+};
+
+std::map<std::string, std::vector<TraceEntry>> loadTrace(
+    const std::string& tracePath,
+    const std::string& root) {
+  std::ifstream input{tracePath};
+  if (!input) {
+    folly::throwSystemError("failed to open trace ", tracePath);
+  }
+
+  std::map<std::string, std::vector<TraceEntry>> threads;
+  std::string line;
+  size_t lineNumber = 0;
+  while (std::getline(input, line)) {
+    ++lineNumber;
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    std::vector<folly::StringPiece> fields;
+    folly::split(' ', line, fields);
+    if (fields.size() != 4) {
+      throw std::invalid_argument(
+          folly::to<std::string>("malformed trace line ", lineNumber));
+    }
+    threads[fields[1].str()].push_back(TraceEntry{
+        folly::to<uint64_t>(fields[0]),
+        parseOp(fields[2]),
+        folly::to<std::string>(root, "/", fields[3])});
+  }
+  return threads;
+}
+
+bool runOp(const TraceEntry& entry) {
+  const char* path = entry.path.c_str();
+  struct stat st;
+  switch (entry.op) {
+    case Op::Stat:
+      return ::stat(path, &st) == 0;
+    case Op::Lstat:
+      return ::lstat(path, &st) == 0;
+    case Op::Read: {
+      int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+      if (fd == -1) {
+        return false;
+      }
+      char buf[64 * 1024];
+      ssize_t n;
+      while ((n = ::read(fd, buf, sizeof(buf))) > 0) {
+      }
+      ::close(fd);
+      return n == 0;
+    }
+    case Op::Readdir: {
+      DIR* dir = ::opendir(path);
+      if (!dir) {
+        return false;
+      }
+      while (::readdir(dir)) {
+      }
+      ::closedir(dir);
+      return true;
+    }
+    case Op::Readlink: {
+      char buf[PATH_MAX];
+      return ::readlink(path, buf, sizeof(buf)) != -1;
+    }
+    case Op::Getxattr: {
+      char buf[256];
+#ifdef __APPLE__
+      return ::getxattr(path, "user.sha1", buf, sizeof(buf), 0, 0) != -1;
+#else
+      return ::getxattr(path, "user.sha1", buf, sizeof(buf)) != -1;
+#endif
+    }
+  }
+  return false;
+}
+
+uint64_t percentile(const std::vector<uint64_t>& sorted, double p) {
+  auto index = static_cast<size_t>(p * (sorted.size() - 1));
+  return sorted[index];
+}
+
+void printReport(const std::vector<Sample>& samples) {
+  std::array<std::vector<uint64_t>, kOpNames.size()> latencies;
+  std::array<uint64_t, kOpNames.size()> failures{};
+  for (const auto& sample : samples) {
+    auto index = static_cast<size_t>(sample.op);
+    latencies[index].push_back(sample.latencyNs);
+    failures[index] += sample.failed;
+  }
+
+  printf(
+      "%-9s %8s %8s %10s %10s %10s %10s %10s\n",
+      "op",
+      "count",
+      "errors",
+      "min ns",
+      "p50 ns",
+      "p90 ns",
+      "p99 ns",
+      "max ns");
+  for (size_t i = 0; i < kOpNames.size(); ++i) {
+    auto& values = latencies[i];
+    if (values.empty()) {
+      continue;
+    }
+    std::sort(values.begin(), values.end());
+    printf(
+        "%-9s %8zu %8" PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIu64
+        " %10" PRIu64 " %10" PRIu64 "\n",
+        kOpNames[i],
+        values.size(),
+        failures[i],
+        values.front(),
+        percentile(values, 0.5),
+        percentile(values, 0.9),
+        percentile(values, 0.99),
+        values.back());
+  }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+
+  if (FLAGS_trace.empty() || FLAGS_root.empty()) {
+    fprintf(stderr, "Both --trace and --root must be specified.\n");
+    return 1;
+  }
+
+  auto threads = loadTrace(FLAGS_trace, FLAGS_root);
+  uint64_t firstUs = std::numeric_limits<uint64_t>::max();
+  for (const auto& [tid, entries] : threads) {
+    if (!entries.empty()) {
+      firstUs = std::min(firstUs, entries.front().startUs);
+    }
+  }
+
+  auto clock_overhead = measureClockOverhead();
+  printf(
+      "Replaying %zu threads. Clock overhead measured at %" PRIu64
+      " ns minimum, %" PRIu64 " ns average\n",
+      threads.size(),
+      clock_overhead.getMinimum(),
+      clock_overhead.getAverage());
+
+  std::mutex resultMutex;
+  std::vector<Sample> samples;
+  auto replayStart = std::chrono::steady_clock::now() + std::chrono::seconds{1};
+
+  auto replay = [&](const std::vector<TraceEntry>& entries) {
+    std::vector<Sample> local;
+    local.reserve(entries.size());
+    for (const auto& entry : entries) {
+      if (FLAGS_speed > 0) {
+        std::this_thread::sleep_until(
+            replayStart +
+            std::chrono::microseconds{static_cast<uint64_t>(
+                (entry.startUs - firstUs) / FLAGS_speed)});
+      }
+      uint64_t start = getTime();
+      bool succeeded = runOp(entry);
+      local.push_back(Sample{entry.op, getTime() - start, !succeeded});
+    }
+
+    std::lock_guard guard{resultMutex};
+    samples.insert(samples.end(), local.begin(), local.end());
+  };
+
+  std::vector<std::thread> replayThreads;
+  replayThreads.reserve(threads.size());
+  for (const auto& [tid, entries] : threads) {
+    replayThreads.emplace_back(replay, std::cref(entries));
+  }
+  for (auto& thread : replayThreads) {
+    thread.join();
+  }
+
+  printReport(samples);
+}
@@ -108,6 +108,7 @@ SUPPORTED_INODE_CATALOG_TYPES: Set[str] = {
     "legacy",
     "sqlite",
     "inmemory",
+    "mapped",
 }
 
 # Create a readme file with this name in the mount point directory.
@@ -45,6 +45,8 @@ from facebook.eden.constants import (
     DIS_NOT_RECURSIVE,
     DIS_REQUIRE_LOADED,
     DIS_REQUIRE_MATERIALIZED,
+    STATS_MEMORY_USAGE,
+    STATS_RSS_BYTES,
 )
 from facebook.eden.ttypes import (
     BlobMetadataOrError,
@@ -55,6 +57,8 @@ from facebook.eden.ttypes import (
     DebugGetScmBlobRequest,
     DebugJournalDelta,
     EdenError,
+    GetFetchHeatmapParams,
+    GetStatInfoParams,
     MountId,
     NoValueForKeyError,
     ScmBlobMetadata,
@@ -1457,6 +1461,70 @@ class LoggingCmd(Subcmd):
             print(category_fmt.format(name, level_str, handlers_str))
 
 
+@debug_cmd("memory", "Show the estimated memory usage of EdenFS subsystems")
+class DebugMemoryCmd(Subcmd):
+    def run(self, args: argparse.Namespace) -> int:
+        instance = cmd_util.get_eden_instance(args)
+        with instance.get_thrift_client_legacy() as client:
+            stat_info = client.getStatInfo(
+                GetStatInfoParams(statsMask=STATS_MEMORY_USAGE | STATS_RSS_BYTES)
+            )
+
+        memory_usage = stat_info.memoryUsage or {}
+        fmt = "{:<20} {:>12}\n"
+        out = sys.stdout
+        for subsystem, size in sorted(
+            memory_usage.items(), key=lambda item: item[1], reverse=True
+        ):
+            out.write(fmt.format(subsystem, stats_print.format_size(size)))
+
+        # The estimates are lower bounds: the rest of the resident memory is
+        # held by allocations no subsystem accounts for, like thrift buffers
+        # and allocator overhead.
+        if stat_info.vmRSSBytes is not None:
+            accounted = sum(memory_usage.values())
+            unaccounted = max(stat_info.vmRSSBytes - accounted, 0)
+            out.write(fmt.format("unaccounted", stats_print.format_size(unaccounted)))
+            out.write(
+                fmt.format("resident", stats_print.format_size(stat_info.vmRSSBytes))
+            )
+        return 0
+
+
+@debug_cmd(
+    "fetch_heatmap", "Show the directories EdenFS imported the most objects from"
+)
+class DebugFetchHeatmapCmd(Subcmd):
+    def setup_parser(self, parser: argparse.ArgumentParser) -> None:
+        parser.add_argument(
+            "--count",
+            type=int,
+            default=50,
+            help="The maximum number of directories to show (default: 50)",
+        )
+        parser.add_argument(
+            "path",
+            nargs="?",
+            help="The path to an EdenFS mount point. Uses `pwd` by default.",
+        )
+
+    def run(self, args: argparse.Namespace) -> int:
+        instance, checkout, _rel_path = cmd_util.require_checkout(args, args.path)
+        with instance.get_thrift_client_legacy() as client:
+            result = client.getFetchHeatmap(
+                GetFetchHeatmapParams(mountPoint=bytes(checkout.path), count=args.count)
+            )
+
+        # Counts with a non-zero error may be overestimated by that much.
+        out = sys.stdout
+        for directory in result.directories:
+            count = str(directory.fetchCount)
+            if directory.error:
+                count += f" (±{directory.error})"
+            out.write(f"{count:>16}  {os.fsdecode(directory.directory)}\n")
+        return 0
+
+
 @debug_cmd("journal_set_memory_limit", "Sets the journal memory limit")
 class DebugJournalSetMemoryLimitCmd(Subcmd):
     def setup_parser(self, parser: argparse.ArgumentParser) -> None:
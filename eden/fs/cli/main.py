@@ -1032,6 +1032,11 @@ is case-sensitive. This is not recommended and is intended only for testing."""
                 "InMemory overlay (inode catalog) type is only supported on Windows. "
                 "Use Legacy or Sqlite on Linux and MacOS."
             )
+        elif sys.platform == "win32" and overlay_type == "mapped":
+            raise Exception(
+                "Mapped overlay (inode catalog) type not supported on Windows. "
+                "Use Sqlite or InMemory on Windows."
+            )
 
         # This is a valid repository path.
         # Prepare a CheckoutConfig object for it.
@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/config/CacheEvictionPolicy.h"
+
+namespace facebook::eden {
+
+namespace {
+
+constexpr auto cacheEvictionPolicyStr = [] {
+  std::array<folly::StringPiece, 2> mapping{};
+  mapping[folly::to_underlying(CacheEvictionPolicy::Lru)] = "lru";
+  mapping[folly::to_underlying(CacheEvictionPolicy::TinyLfu)] = "tinylfu";
+  return mapping;
+}();
+
+} // namespace
+
+folly::StringPiece toString(CacheEvictionPolicy policy) {
+  return cacheEvictionPolicyStr[folly::to_underlying(policy)];
+}
+
+folly::Expected<CacheEvictionPolicy, std::string>
+FieldConverter<CacheEvictionPolicy>::fromString(
+    folly::StringPiece value,
+    const std::map<std::string, std::string>& /*unused*/) const {
+  for (auto i = 0ul; i < cacheEvictionPolicyStr.size(); i++) {
+    if (value.equals(
+            cacheEvictionPolicyStr[i], folly::AsciiCaseInsensitive())) {
+      return static_cast<CacheEvictionPolicy>(i);
+    }
+  }
+
+  return folly::makeUnexpected(fmt::format(
+      "Failed to convert value '{}' to a CacheEvictionPolicy.", value));
+}
+
+std::string FieldConverter<CacheEvictionPolicy>::toDebugString(
+    CacheEvictionPolicy value) const {
+  return toString(value).str();
+}
+
+} // namespace facebook::eden
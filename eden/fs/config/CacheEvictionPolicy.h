@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include "eden/fs/config/FieldConverter.h"
+
+namespace facebook::eden {
+
+/**
+ * Controls how the in-memory object caches decide what to keep.
+ */
+enum class CacheEvictionPolicy {
+  /**
+   * Every inserted object is admitted, and the least recently used object is
+   * evicted to make room.
+   */
+  Lru,
+
+  /**
+   * Like Lru, but a new object is only admitted when the cache is full if it
+   * has been requested more often recently than the object it would evict.
+   * This prevents one-off scans from flushing the working set.
+   */
+  TinyLfu,
+};
+
+folly::StringPiece toString(CacheEvictionPolicy policy);
+
+template <>
+class FieldConverter<CacheEvictionPolicy> {
+ public:
+  folly::Expected<CacheEvictionPolicy, std::string> fromString(
+      folly::StringPiece value,
+      const std::map<std::string, std::string>& convData) const;
+
+  std::string toDebugString(CacheEvictionPolicy value) const;
+};
+
+} // namespace facebook::eden
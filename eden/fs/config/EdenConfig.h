@@ -15,6 +15,7 @@
 #include <thrift/lib/cpp/concurrency/ThreadManager.h>
 
 #include "common/rust/shed/hostcaps/hostcaps.h"
+#include "eden/fs/config/CacheEvictionPolicy.h"
 #include "eden/fs/config/ConfigSetting.h"
 #include "eden/fs/config/ConfigSource.h"
 #include "eden/fs/config/ConfigVariables.h"
@@ -233,6 +234,16 @@ class EdenConfig : private ConfigSettingManager {
       std::chrono::minutes(5),
       this};
 
+  /**
+   * Only pick up on-disk config changes from a periodic task on the main
+   * EventBase, at least every 5 seconds, instead of from whichever thread
+   * happens to read the config once the last check is 5 seconds old.
+   */
+  ConfigSetting<bool> configReloadInBackground{
+      "config:reload-in-background",
+      true,
+      this};
+
   // [thrift]
 
   ConfigSetting<bool> allowUnixGroupRequests{
@@ -257,6 +268,35 @@ class EdenConfig : private ConfigSettingManager {
       std::thread::hardware_concurrency(),
       this};
 
+  /**
+   * Whether each Thrift method priority gets its own pool of worker threads,
+   * so that cheap IMPORTANT calls that clients poll, like
+   * getCurrentJournalPosition, don't wait behind a burst of globs or status
+   * calls. thrift:num-workers then sizes the pool for NORMAL calls.
+   */
+  ConfigSetting<bool> thriftPriorityLanes{
+      "thrift:priority-lanes",
+      true,
+      this};
+
+  /**
+   * With thrift:priority-lanes, the number of worker threads for each of the
+   * priorities above NORMAL.
+   */
+  ConfigSetting<size_t> thriftNumImportantWorkers{
+      "thrift:num-important-workers",
+      2,
+      this};
+
+  /**
+   * With thrift:priority-lanes, the number of worker threads for BEST_EFFORT
+   * calls, such as prefetches.
+   */
+  ConfigSetting<size_t> thriftNumBestEffortWorkers{
+      "thrift:num-best-effort-workers",
+      2,
+      this};
+
   /**
    * Maximum number of active Thrift requests.
    */
@@ -273,6 +313,15 @@ class EdenConfig : private ConfigSettingManager {
       std::chrono::seconds(30),
       this};
 
+  /**
+   * Minimum time between two notifications of a journal subscription. The
+   * changes made in the meantime are coalesced into the next notification.
+   */
+  ConfigSetting<std::chrono::nanoseconds> journalNotificationInterval{
+      "thrift:journal-notification-interval",
+      std::chrono::milliseconds(10),
+      this};
+
   // [ssl]
 
   ConfigSetting<AbsolutePath> clientCertificate{
@@ -318,6 +367,29 @@ class EdenConfig : private ConfigSettingManager {
       OneHourMinDuration(std::chrono::hours(24)),
       this};
 
+  /**
+   * When EdenFS's resident memory exceeds this many bytes, loaded inodes that
+   * haven't been used for the longest are unloaded until it is estimated to
+   * be back under 90% of it. Inodes used since the previous sweep are never
+   * unloaded this way.
+   *
+   * 0 disables memory pressure driven unloading. Not supported on Windows.
+   */
+  ConfigSetting<uint64_t> inodeUnloadRssWatermark{
+      "mount:inode-unload-rss-watermark",
+      0,
+      this};
+
+  /**
+   * How often inode usage is sampled when inodeUnloadRssWatermark is set. An
+   * inode is considered idle for as many sweeps as have found it unused, so
+   * this is the granularity of its age.
+   */
+  ConfigSetting<std::chrono::nanoseconds> inodeUnloadSweepInterval{
+      "mount:inode-unload-sweep-interval",
+      std::chrono::minutes(1),
+      this};
+
   /**
    * Specifies which directory children will be prefetched upon readdir.
    */
@@ -344,6 +416,28 @@ class EdenConfig : private ConfigSettingManager {
       false,
       this};
 
+  /**
+   * Checkouts to start remounting first when EdenFS starts, in this order.
+   * All checkouts are remounted concurrently, but those started first get
+   * ahead in the queues of the shared executors and local store. Checkouts
+   * not listed here follow, most recently checked out or committed to first.
+   */
+  ConfigSetting<std::vector<AbsolutePath>> startupMountPriority{
+      "mount:startup-priority",
+      std::vector<AbsolutePath>{},
+      this};
+
+  /**
+   * During a graceful restart, create the backing stores of all configured
+   * checkouts before asking the old process to give up its mounts. Opening
+   * the source control stores is read-only and can take a while, so doing it
+   * first keeps it out of the window in which the mounts are frozen.
+   */
+  ConfigSetting<bool> createBackingStoresBeforeTakeover{
+      "mount:create-backing-stores-before-takeover",
+      true,
+      this};
+
   // [store]
 
   /**
@@ -383,6 +477,82 @@ class EdenConfig : private ConfigSettingManager {
       20'000'000,
       this};
 
+  ConfigSetting<uint64_t> localStoreBlobContentSizeLimit{
+      "store:blobcontent-size-limit",
+      15'000'000'000,
+      this};
+
+  ConfigSetting<uint64_t> localStoreBlobContentHashSizeLimit{
+      "store:blobcontenthash-size-limit",
+      1'000'000'000,
+      this};
+
+  /**
+   * Automatic garbage collection evicts the least recently read objects of an
+   * oversized cache until it is at most this percentage of its limit.
+   */
+  ConfigSetting<uint32_t> localStoreGcTargetPercent{
+      "store:gc-target-percent",
+      80,
+      this};
+
+  /**
+   * Size in bytes of the memory-mapped segment that keeps recently read trees
+   * and blob metadata in front of the RocksDB local store, and that is used to
+   * warm the store on restart. 0 disables it. Takes effect on restart.
+   */
+  ConfigSetting<uint64_t> localStoreHotTierSize{
+      "store:hot-tier-size",
+      0,
+      this};
+
+  /**
+   * Number of bytes of LocalStore writes to queue in memory for the
+   * background writer before writers block. 0 disables the background writer
+   * so that writes go straight to the store. Takes effect on restart.
+   */
+  ConfigSetting<size_t> localStoreWriteBufferSize{
+      "store:write-buffer-size",
+      0,
+      this};
+
+  /**
+   * How long the background LocalStore writer waits for more writes to
+   * coalesce into a single batch before writing them.
+   */
+  ConfigSetting<std::chrono::nanoseconds> localStoreWriteFlushLatency{
+      "store:write-flush-latency",
+      std::chrono::milliseconds{10},
+      this};
+
+  /**
+   * Number of read-only connections the SQLite local store opens for gets,
+   * so that they run concurrently with each other and with writes. 0 runs
+   * every query on the single read-write connection. Takes effect on restart.
+   */
+  ConfigSetting<size_t> sqliteLocalStoreReadConnections{
+      "store:sqlite-read-connections",
+      4,
+      this};
+
+  /**
+   * Bytes of the SQLite local store that every connection may memory map
+   * (PRAGMA mmap_size). Takes effect on restart.
+   */
+  ConfigSetting<int64_t> sqliteLocalStoreMmapSize{
+      "store:sqlite-mmap-size",
+      256 * 1024 * 1024,
+      this};
+
+  /**
+   * Page cache of every SQLite local store connection (PRAGMA cache_size):
+   * pages when positive, KiB when negative. Takes effect on restart.
+   */
+  ConfigSetting<int64_t> sqliteLocalStoreCacheSize{
+      "store:sqlite-cache-size",
+      -16 * 1024,
+      this};
+
   /**
    * The minimum duration between logging occurrences of failed HgProxyHash
    * loads.
@@ -440,6 +610,19 @@ class EdenConfig : private ConfigSettingManager {
    * measures to shut down the fuse channel.
    * This value is only applicable to the macOS fuse implementation.
    */
+  /**
+   * How long the kernel may cache the attributes and directory entries of
+   * inodes. EdenFS invalidates them whenever they change other than through
+   * FUSE requests, such as on checkout, so they are cached indefinitely by
+   * default; lowering this is only useful to rule out stale kernel caches.
+   * Capped to 2^31 - 1 seconds. Only applies to mounts started after it is
+   * changed.
+   */
+  ConfigSetting<std::chrono::nanoseconds> fuseAttributeTimeout{
+      "fuse:attribute-timeout",
+      std::chrono::seconds(std::numeric_limits<int32_t>::max()),
+      this};
+
   ConfigSetting<std::chrono::nanoseconds> fuseDaemonTimeout{
       "fuse:daemon-timeout",
       std::chrono::nanoseconds::max(),
@@ -454,6 +637,56 @@ class EdenConfig : private ConfigSettingManager {
    */
   ConfigSetting<uint32_t> maximumFuseRequests{"fuse:max-requests", 1000, this};
 
+  /**
+   * The largest write the kernel may send in a single FUSE_WRITE request, and
+   * the largest read it may request. Each FUSE worker thread holds a buffer of
+   * about this size. Linux caps it to 256 pages, and to 32 pages before
+   * FUSE_MAX_PAGES (4.20).
+   */
+  ConfigSetting<uint32_t> fuseMaxWrite{"fuse:max-write", 1024 * 1024, this};
+
+  /**
+   * Whether each FUSE worker thread reads requests from its own clone of the
+   * FUSE device (FUSE_DEV_IOC_CLONE) rather than all sharing one. Replies are
+   * then matched to requests per clone, rather than under a single lock for
+   * the whole mount. Worker threads share the device if it cannot be cloned.
+   */
+  ConfigSetting<bool> fuseCloneDevicePerThread{
+      "fuse:clone-device-per-thread",
+      false,
+      this};
+
+  /**
+   * Whether to ask Linux for FUSE_READDIRPLUS, returning the attributes of
+   * directory entries with them. This saves a lookup per entry for listings
+   * whose entries are stat()ed, at the cost of loading the inode of each entry
+   * listed. Only applies to mounts started after it is changed.
+   */
+  ConfigSetting<bool> fuseUseReaddirplus{"fuse:use-readdirplus", false, this};
+
+  /**
+   * Controls the number of threads per mount sending invalidations to the
+   * kernel. Invalidations of unrelated inodes are sent concurrently, which
+   * helps checkouts when invalidations block on kernel locks held by
+   * in-flight requests. Only applies to mounts started after it is changed.
+   */
+  ConfigSetting<uint8_t> fuseNumInvalidationThreads{
+      "fuse:num-invalidation-threads",
+      1,
+      this};
+
+  /**
+   * The number of FUSE worker threads started with each mount. Another one is
+   * started whenever all of them are busy, up to --fuseNumThreads, so hosts
+   * with many mounts don't keep threads for the ones that are barely used.
+   * 0 starts all --fuseNumThreads threads with the mount. Only applies to
+   * mounts started after it is changed.
+   */
+  ConfigSetting<uint32_t> fuseInitialWorkerThreads{
+      "fuse:initial-worker-threads",
+      0,
+      this};
+
   // [nfs]
 
   /**
@@ -495,6 +728,17 @@ class EdenConfig : private ConfigSettingManager {
    */
   ConfigSetting<uint64_t> numNfsThreads{"nfs:num-servicing-threads", 8, this};
 
+  /**
+   * Number of threads that will service the NFS requests of each mount, in a
+   * thread pool dedicated to the mount so that a busy mount doesn't delay the
+   * requests of the others. When 0, the requests of all the mounts are
+   * serviced by the nfs:num-servicing-threads threads.
+   */
+  ConfigSetting<uint64_t> numNfsThreadsPerMount{
+      "nfs:num-servicing-threads-per-mount",
+      0,
+      this};
+
   /**
    * Maximum number of pending NFS requests. If more requests are inflight, the
    * NFS code will block.
@@ -644,6 +888,67 @@ class EdenConfig : private ConfigSettingManager {
    */
   ConfigSetting<bool> enforceParents{"hg:enforce-parents", true, this};
 
+  /**
+   * Whether EdenFS keeps the last status computed for each mount, with and
+   * without ignored files, and answers the next status call by only diffing
+   * the paths that the journal says changed since. A full diff is done when
+   * the commit changed or the journal no longer covers the time since.
+   */
+  ConfigSetting<bool> enableStatusCache{"hg:enable-status-cache", false, this};
+
+  /**
+   * A cached status is only updated when fewer than this many paths changed
+   * since it was computed. Otherwise the status is computed from scratch.
+   */
+  ConfigSetting<size_t> statusCacheMaxChangedPaths{
+      "hg:status-cache-max-changed-paths",
+      10000,
+      this};
+
+  /**
+   * When non-zero, status diffs walk up to this many source control trees at
+   * a time on the EdenFS CPU thread pool once they are fetched, instead of on
+   * the threads that fetched them.
+   */
+  ConfigSetting<size_t> diffConcurrency{"hg:diff-concurrency", 0, this};
+
+  /**
+   * Whether checkout fetches all of the source control trees that differ
+   * between the two commits while it diffs the working copy, before it
+   * updates any inodes, instead of fetching each of them as the inode update
+   * reaches it.
+   */
+  ConfigSetting<bool> prefetchCheckoutTrees{
+      "hg:checkout-prefetch-trees",
+      false,
+      this};
+
+  /**
+   * The number of pairs of source control trees whose differing entries are
+   * kept, for all mounts, so that diffs of commits that share subtrees do not
+   * fetch and compare them again. 0 disables the cache.
+   */
+  ConfigSetting<size_t> treeDiffCacheSize{"hg:tree-diff-cache-size", 0, this};
+
+  /**
+   * The number of distinct .gitignore files whose parsed rules are kept, for
+   * all mounts, so that status does not parse them again. 0 disables the
+   * cache.
+   */
+  ConfigSetting<size_t> gitIgnoreCacheSize{
+      "hg:gitignore-cache-size",
+      1024,
+      this};
+
+  /**
+   * The maximum number of entries and errors in each of the chunks that
+   * streamScmStatus sends.
+   */
+  ConfigSetting<size_t> statusStreamChunkSize{
+      "hg:status-stream-chunk-size",
+      1000,
+      this};
+
   /**
    * Controls whether EdenFS reads blob metadata directly from hg
    *
@@ -658,6 +963,17 @@ class EdenConfig : private ConfigSettingManager {
    */
   ConfigSetting<bool> fetchHgAuxMetadata{"hg:fetch-aux-metadata", true, this};
 
+  /**
+   * When importing trees, also fetch the aux metadata of their files if it
+   * didn't come with the trees, as it doesn't for trees read from the hg
+   * cache. The metadata is then cached in the LocalStore along with the tree
+   * instead of being fetched file by file later.
+   */
+  ConfigSetting<bool> fetchTreeChildAuxMetadata{
+      "hg:fetch-tree-child-aux-metadata",
+      true,
+      this};
+
   /**
    * Which object ID format should the HgBackingStore use?
    */
@@ -702,6 +1018,56 @@ class EdenConfig : private ConfigSettingManager {
       1024,
       this};
 
+  /**
+   * Whether HgQueuedBackingStore adapts the import batch sizes to how long
+   * batches take to import. The import-batch-size* settings above are then
+   * the initial batch sizes.
+   */
+  ConfigSetting<bool> adaptiveImportBatchSize{
+      "hg:adaptive-import-batch-size",
+      false,
+      this};
+
+  /**
+   * Bounds of the adaptive import batch sizes.
+   */
+  ConfigSetting<uint32_t> adaptiveImportBatchSizeMin{
+      "hg:adaptive-import-batch-size-min",
+      1,
+      this};
+  ConfigSetting<uint32_t> adaptiveImportBatchSizeMax{
+      "hg:adaptive-import-batch-size-max",
+      1024,
+      this};
+
+  /**
+   * Adaptive import batch sizes shrink when a batch takes longer than this to
+   * import, and grow while batches are full and take less.
+   */
+  ConfigSetting<std::chrono::nanoseconds> adaptiveImportBatchTargetLatency{
+      "hg:adaptive-import-batch-target-latency",
+      std::chrono::seconds{1},
+      this};
+
+  /**
+   * Whether import requests that the callers stopped waiting for, for
+   * instance because the FUSE request was interrupted, are dropped when
+   * dequeued rather than fetched.
+   */
+  ConfigSetting<bool> hgDropAbandonedImports{
+      "hg:drop-abandoned-imports",
+      true,
+      this};
+
+  /**
+   * Whether trees and blobs that the native backing store failed to fetch are
+   * imported through the hg debugedenimporthelper process. Spawning it and
+   * copying data through its pipe is slow; when disabled, these fetches fail
+   * instead. Resolving the manifest of a commit whose root tree isn't cached
+   * always uses the process.
+   */
+  ConfigSetting<bool> hgImporterFallback{"hg:importer-fallback", true, this};
+
   /**
    * Whether fetching trees should fall back on an external hg importer process.
    */
@@ -725,11 +1091,39 @@ class EdenConfig : private ConfigSettingManager {
       100,
       this};
 
+  /**
+   * Number of directories whose imports are counted, to report the
+   * directories EdenFS fetches from the most. 0 disables the counting.
+   */
+  ConfigSetting<uint32_t> hgFetchHeatmapCapacity{
+      "hg:fetch-heatmap-capacity",
+      4096,
+      this};
+
+  /**
+   * How many levels of directories above an imported object are counted in
+   * the fetch heatmap.
+   */
+  ConfigSetting<uint32_t> hgFetchHeatmapMaxDepth{
+      "hg:fetch-heatmap-max-depth",
+      6,
+      this};
+
   ConfigSetting<bool> hgEnableBlobMetaLocalStoreCaching{
       "hg:cache-blob-metadata-in-localstore",
       true,
       this};
 
+  /**
+   * Cache the blobs imported from Mercurial in the LocalStore by the BLAKE3
+   * hash of their contents, so that a file vendored at many paths or changed
+   * back and forth across commits is only stored once.
+   */
+  ConfigSetting<bool> hgEnableDeduplicatedBlobLocalStoreCaching{
+      "hg:cache-deduplicated-blobs-in-localstore",
+      false,
+      this};
+
   /**
    * List of paths to filter out when importing Mercurial trees.
    *
@@ -748,12 +1142,24 @@ class EdenConfig : private ConfigSettingManager {
 
   /**
    * Number of threads that will pull backingstore requests off the queue.
+   * Every git backing store also reads its objects with this many threads.
    */
   ConfigSetting<uint8_t> numBackingstoreThreads{
       "backingstore:num-servicing-threads",
       32,
       this};
 
+  /**
+   * Number of the backingstore:num-servicing-threads threads that only serve
+   * high priority requests, such as the ones of filesystem reads, so that
+   * they aren't stuck behind prefetches. At least one thread serves every
+   * priority. Only read at startup.
+   */
+  ConfigSetting<uint8_t> numHighPriorityBackingstoreThreads{
+      "backingstore:num-high-priority-servicing-threads",
+      2,
+      this};
+
   // [telemetry]
 
   /**
@@ -874,6 +1280,36 @@ class EdenConfig : private ConfigSettingManager {
       true,
       this};
 
+  /**
+   * 1 in how many inodes have their FUSE and NFS requests watched, to count
+   * the requests the kernel repeats instead of caching their replies. 0
+   * disables it.
+   */
+  ConfigSetting<uint32_t> kernelCacheSampleRate{
+      "telemetry:kernel-cache-sample-rate",
+      64,
+      this};
+
+  /**
+   * The maximum number of sampled inodes whose requests are remembered, per
+   * mount.
+   */
+  ConfigSetting<uint32_t> kernelCacheMaxSampledInodes{
+      "telemetry:kernel-cache-max-sampled-inodes",
+      4096,
+      this};
+
+  /**
+   * NFS lookup and getattr requests repeated within this duration count as
+   * missed by the client's attribute cache. The NFS client picks its own
+   * timeouts, at least 3 seconds for files by default (acregmin). FUSE uses
+   * fuse:attribute-timeout instead.
+   */
+  ConfigSetting<std::chrono::nanoseconds> nfsKernelCacheWindow{
+      "telemetry:nfs-kernel-cache-window",
+      std::chrono::seconds{3},
+      this};
+
   /**
    * Controls whether EdenFS makes use of ActivityBuffers to store past
    * events in memory.
@@ -892,6 +1328,36 @@ class EdenConfig : private ConfigSettingManager {
       100,
       this};
 
+  /**
+   * Sets the maximum memory, in bytes, the events of an ActivityBuffer can use
+   * before old events are evicted, whatever their number. This includes the
+   * paths of the events, and applies to hg:activity-buffer-size too.
+   */
+  ConfigSetting<uint64_t> activityBufferMaxBytes{
+      "telemetry:activitybuffer-max-bytes",
+      16 * 1024 * 1024,
+      this};
+
+  /**
+   * When a FUSE or NFS request has been outstanding for this long, the
+   * outstanding requests of its mount and the state of every EdenFS thread
+   * are logged to the structured logger, to diagnose hangs that can't be
+   * reproduced. 0 disables it.
+   */
+  ConfigSetting<std::chrono::nanoseconds> slowRequestThreshold{
+      "telemetry:slow-request-threshold",
+      std::chrono::seconds(10),
+      this};
+
+  /**
+   * How often the outstanding requests are checked against
+   * telemetry:slow-request-threshold.
+   */
+  ConfigSetting<std::chrono::nanoseconds> slowRequestCheckInterval{
+      "telemetry:slow-request-check-interval",
+      std::chrono::seconds(1),
+      this};
+
   // [experimental]
 
   /**
@@ -1003,6 +1469,53 @@ class EdenConfig : private ConfigSettingManager {
       16,
       this};
 
+  /**
+   * Number of independently locked shards the blob cache is split into. The
+   * cache size and minimum item count are divided evenly between shards.
+   * Higher values reduce lock contention on machines with many cores.
+   */
+  ConfigSetting<size_t> inMemoryBlobCacheShards{
+      "blobcache:shard-count",
+      1,
+      this};
+
+  /**
+   * Which eviction/admission policy the blob cache uses. "tinylfu" keeps
+   * frequently reused blobs cached across large one-off scans such as
+   * prefetches or recursive greps.
+   */
+  ConfigSetting<CacheEvictionPolicy> inMemoryBlobCacheEvictionPolicy{
+      "blobcache:eviction-policy",
+      CacheEvictionPolicy::Lru,
+      this};
+
+  /**
+   * Blobs of at least this many bytes are cached by the chunks that were
+   * read rather than whole, so that a large file that is only partially read
+   * doesn't take up the blob cache. 0 caches all blobs whole.
+   */
+  ConfigSetting<size_t> inMemoryBlobCacheChunkedThreshold{
+      "blobcache:chunked-blob-threshold",
+      0,
+      this};
+
+  /**
+   * Size of the chunks that blobs above the chunked threshold are cached in.
+   */
+  ConfigSetting<size_t> inMemoryBlobCacheChunkSize{
+      "blobcache:chunk-size",
+      1024 * 1024,
+      this};
+
+  /**
+   * The maximum number of bytes of chunks to keep cached, across all blobs
+   * cached by chunks. This is separate from the cache-size budget.
+   */
+  ConfigSetting<size_t> inMemoryBlobCacheChunkedSize{
+      "blobcache:chunked-cache-size",
+      40 * 1024 * 1024,
+      this};
+
   // [treecache]
 
   /**
@@ -1030,6 +1543,24 @@ class EdenConfig : private ConfigSettingManager {
       16,
       this};
 
+  /**
+   * Number of independently locked shards the tree cache is split into. The
+   * cache size and minimum item count are divided evenly between shards.
+   */
+  ConfigSetting<size_t> inMemoryTreeCacheShards{
+      "treecache:shard-count",
+      1,
+      this};
+
+  /**
+   * Which eviction/admission policy the tree cache uses. See
+   * blobcache:eviction-policy.
+   */
+  ConfigSetting<CacheEvictionPolicy> inMemoryTreeCacheEvictionPolicy{
+      "treecache:eviction-policy",
+      CacheEvictionPolicy::Lru,
+      this};
+
   // [notifications]
 
   /**
@@ -1129,6 +1660,42 @@ class EdenConfig : private ConfigSettingManager {
       1500,
       this};
 
+  /**
+   * Learn locally which directories have files read from them between
+   * checkouts, from the inode loads published to the inode trace bus, and
+   * prefetch the files of the predictive-prefetch-profiles:size directories
+   * read after the most checkouts in the background after each checkout, and
+   * when the mount starts other than by graceful restart. Unlike predictive
+   * prefetch profiles, this needs no remote service. Only read when a mount
+   * is created.
+   */
+  ConfigSetting<bool> enableLocalPredictivePrefetch{
+      "prefetch-profiles:local-predictive-prefetching-enabled",
+      false,
+      this};
+
+  /**
+   * The local predictive prefetch is cancelled once more than this many files
+   * are loaded from the mount within a second, so that it does not compete
+   * with the reads of whatever the user started.
+   */
+  ConfigSetting<uint64_t> localPredictivePrefetchMaxForegroundLoads{
+      "prefetch-profiles:local-predictive-prefetching-max-foreground-loads",
+      200,
+      this};
+
+  // [journal]
+
+  /**
+   * Save the journal of a mount in its client directory when it is unmounted,
+   * including for a graceful restart, and restore it when it is mounted
+   * again. Journal positions given out before the restart stay valid, so
+   * that clients like Watchman don't need to crawl the whole mount. Not
+   * supported on Windows, where the working copy can change while EdenFS
+   * isn't running. Only read when a mount is created.
+   */
+  ConfigSetting<bool> persistJournal{"journal:persist", true, this};
+
   // [redirections]
 
   /**
@@ -1161,6 +1728,26 @@ class EdenConfig : private ConfigSettingManager {
       false,
       this};
 
+  /**
+   * Whether InMemory inode catalogs are persisted to the overlay directory,
+   * as a snapshot and a log of the changes made since, so that they survive
+   * a restart. Catalogs created without it are lost when EdenFS exits.
+   */
+  ConfigSetting<bool> inMemoryCatalogPersistent{
+      "overlay:in-memory-catalog-persistent",
+      false,
+      this};
+
+  /**
+   * Overlay maintenance snapshots a persistent InMemory inode catalog once
+   * the log of changes since its last snapshot is larger than both this and
+   * the snapshot.
+   */
+  ConfigSetting<size_t> inMemoryCatalogSnapshotMinLogSize{
+      "overlay:in-memory-catalog-snapshot-min-log-size",
+      16 * 1024 * 1024,
+      this};
+
   /**
    * The synchronous mode used when using a SQLite backed overlay. Currently it
    * only supports "off" or "normal". Setting this to off may cause data loss.
@@ -1179,9 +1766,23 @@ class EdenConfig : private ConfigSettingManager {
       std::chrono::minutes(1),
       this};
 
+  /**
+   * When nonzero, Legacy and Mapped overlays are checkpointed on every
+   * overlay maintenance, and after a crash only the inodes written since the
+   * last checkpoint are checked instead of the whole overlay. The first write
+   * of each inode after a checkpoint waits for a journal entry to be synced,
+   * and once more than this many inodes have been written, the checkpoint is
+   * abandoned until the next one. Linux only.
+   */
+  ConfigSetting<size_t> overlayCheckpointMaxDirtyInodes{
+      "overlay:checkpoint-max-dirty-inodes",
+      0,
+      this};
+
   /**
    * Determines if EdenFS should enable the option to buffer overlay writes.
-   * This only works with SQLite backed overlays.
+   * Legacy overlays are only buffered when overlay:buffer-coalesce-window is
+   * also set.
    */
   ConfigSetting<bool> overlayBuffered{"overlay:buffered", true, this};
 
@@ -1195,12 +1796,103 @@ class EdenConfig : private ConfigSettingManager {
       64 * 1024 * 1024,
       this};
 
+  /**
+   * How long directory writes to a legacy overlay are buffered for before
+   * being written, so that a directory that changes repeatedly in that time
+   * is only written once. 0 disables buffering of legacy overlays.
+   */
+  ConfigSetting<std::chrono::nanoseconds> overlayBufferCoalesceWindow{
+      "overlay:buffer-coalesce-window",
+      std::chrono::nanoseconds{0},
+      this};
+
+  /**
+   * Whether legacy overlays append the changes to a directory's children to
+   * its file instead of rewriting the whole directory. Older versions of
+   * EdenFS can't read the directories written this way. Takes precedence over
+   * overlay:buffer-coalesce-window.
+   */
+  ConfigSetting<bool> overlayAppendDirChanges{
+      "overlay:append-dir-changes",
+      false,
+      this};
+
   /**
    * Number of OverlayFile and metadata cached in memory.
    */
   ConfigSetting<size_t> overlayFileAccessCacheSize{
       "overlay:file-access-cache-size",
-      100,
+      1024,
+      this};
+
+  /**
+   * Number of independently locked shards the OverlayFile cache is split
+   * into. The cache size is divided evenly between shards.
+   */
+  ConfigSetting<size_t> overlayFileAccessCacheShards{
+      "overlay:file-access-cache-shards",
+      8,
+      this};
+
+  /**
+   * Number of threads performing reads, writes and fsyncs of materialized
+   * files in the overlay. When nonzero, these no longer block the FUSE and NFS
+   * threads for the duration of the IO. When zero, they are performed on the
+   * thread handling the request.
+   */
+  ConfigSetting<size_t> overlayIoThreads{"overlay:io-threads", 0, this};
+
+  /**
+   * Maximum number of bytes of blob contents kept as files in the overlay so
+   * that materializing those blobs again clones them (with FICLONE on Linux
+   * or clonefile on macOS) instead of writing them. Only used when the
+   * overlay lives on a filesystem that supports cloning. 0 disables the
+   * cache.
+   */
+  ConfigSetting<uint64_t> overlayBlobFileCacheSize{
+      "overlay:blob-file-cache-size",
+      0,
+      this};
+
+  /**
+   * Blobs smaller than this are always written when they are materialized,
+   * since cloning a small file is no faster than writing it.
+   */
+  ConfigSetting<uint64_t> overlayBlobFileCacheMinBlobSize{
+      "overlay:blob-file-cache-min-blob-size",
+      1024 * 1024,
+      this};
+
+  /**
+   * Blobs of at least this many bytes are materialized without writing them
+   * to the overlay. Reads of the ranges that were not written since are
+   * served from the blob, which is kept in memory until the file is hashed or
+   * the mount is unmounted, when the rest of the blob is written. 0 disables
+   * sparse materialization.
+   */
+  ConfigSetting<uint64_t> overlaySparseMaterializationMinSize{
+      "overlay:sparse-materialization-min-size",
+      0,
+      this};
+
+  /**
+   * Maximum total size of the blobs kept in memory for sparsely materialized
+   * files, per mount. Once reached, blobs are materialized by writing them.
+   */
+  ConfigSetting<uint64_t> overlaySparseMaterializationMaxMemory{
+      "overlay:sparse-materialization-max-memory",
+      1024 * 1024 * 1024,
+      this};
+
+  /**
+   * Whether to keep the SHA-1 of materialized files in the overlay, along
+   * with the size and modification time of their overlay file, so that a
+   * status after a restart, or after the file was evicted from the overlay
+   * file cache, does not need to read files that did not change since.
+   */
+  ConfigSetting<bool> overlayPersistContentHashes{
+      "overlay:persist-content-hashes",
+      false,
       this};
 
   // [clone]
@@ -1248,6 +1940,58 @@ class EdenConfig : private ConfigSettingManager {
       true,
       this};
 
+  /**
+   * The number of (source control tree, glob) pairs whose results are kept,
+   * for all mounts, so that globs repeated against the same commits do not
+   * walk the same trees again. 0 disables the cache.
+   */
+  ConfigSetting<size_t> globResultCacheSize{
+      "glob:result-cache-size",
+      0,
+      this};
+
+  /**
+   * When non-zero, globs walk up to this many directories at a time on the
+   * EdenFS CPU thread pool once they are loaded, instead of on the threads
+   * that loaded them.
+   */
+  ConfigSetting<size_t> globConcurrency{"glob:concurrency", 0, this};
+
+  /**
+   * The minimum number of files in each of the chunks that streamGlobFiles
+   * sends, except for the last one.
+   */
+  ConfigSetting<size_t> globStreamChunkSize{
+      "glob:stream-chunk-size",
+      1000,
+      this};
+
+  /**
+   * The number of directories that globFilesInRepo walks at a time on the
+   * EdenFS CPU thread pool, for each request. Unlike glob:concurrency, this
+   * cannot be disabled, so that globbing many commits of a repository does
+   * not hold the threads that fetch its trees.
+   */
+  ConfigSetting<size_t> globRepoConcurrency{
+      "glob:repo-concurrency",
+      16,
+      this};
+
+  /**
+   * The number of the most expensive globs, by directories visited, whose
+   * costs are kept for debugGetExpensiveGlobs. 0 disables it.
+   */
+  ConfigSetting<size_t> globCostLogSize{"glob:cost-log-size", 20, this};
+
+  /**
+   * Globs that take at least this long are logged, with their costs, to the
+   * structured logger.
+   */
+  ConfigSetting<std::chrono::nanoseconds> globSlowThreshold{
+      "glob:slow-threshold",
+      std::chrono::seconds(5),
+      this};
+
   // [doctor]
 
   /**
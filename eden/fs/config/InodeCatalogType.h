@@ -15,6 +15,7 @@ enum class InodeCatalogType : uint8_t {
   Legacy = 0,
   Sqlite = 1,
   InMemory = 2,
+  Mapped = 3,
 };
 
 constexpr InodeCatalogType kInodeCatalogTypeDefault =
@@ -13,63 +13,65 @@
 
 #include <folly/logging/xlog.h>
 
-namespace {
-/// Throttle change checks to a maximum of one per
-/// kEdenConfigMinimumPollDuration.
-constexpr std::chrono::seconds kEdenConfigMinimumPollDuration{5};
-} // namespace
-
 namespace facebook::eden {
 
 ReloadableConfig::ReloadableConfig(std::shared_ptr<const EdenConfig> config)
-    : state_{ConfigState{std::move(config)}} {}
+    : config_{std::move(config)} {}
 
 ReloadableConfig::ReloadableConfig(
     std::shared_ptr<const EdenConfig> config,
     ConfigReloadBehavior reloadBehavior)
-    : state_{ConfigState{std::move(config)}}, reloadBehavior_{reloadBehavior} {}
+    : config_{std::move(config)}, reloadBehavior_{reloadBehavior} {}
 
 ReloadableConfig::~ReloadableConfig() = default;
 
 std::shared_ptr<const EdenConfig> ReloadableConfig::getEdenConfig(
     ConfigReloadBehavior reload) {
-  auto now = std::chrono::steady_clock::now();
-
   if (reloadBehavior_.has_value()) {
     reload = reloadBehavior_.value();
   }
 
-  bool shouldReload;
   switch (reload) {
     case ConfigReloadBehavior::NoReload:
-      shouldReload = false;
-      break;
-    case ConfigReloadBehavior::ForceReload:
-      shouldReload = true;
-      break;
+      return config_.load(std::memory_order_acquire);
+    case ConfigReloadBehavior::ForceReload: {
+      std::lock_guard guard{reloadMutex_};
+      return this->reload(std::chrono::steady_clock::now());
+    }
     case ConfigReloadBehavior::AutoReload: {
+      if (reloadInBackground_.load(std::memory_order_relaxed)) {
+        return config_.load(std::memory_order_acquire);
+      }
+      auto now = std::chrono::steady_clock::now();
       auto lastCheck = lastCheck_.load(std::memory_order_acquire);
-      shouldReload = now - lastCheck >= kEdenConfigMinimumPollDuration;
-      break;
+      if (now - lastCheck < kAutoReloadInterval) {
+        return config_.load(std::memory_order_acquire);
+      }
+      // Throttled callers need not wait for a reload that another thread is
+      // already doing; the snapshot they would have gotten before it is
+      // fine.
+      std::unique_lock guard{reloadMutex_, std::try_to_lock};
+      if (!guard.owns_lock()) {
+        return config_.load(std::memory_order_acquire);
+      }
+      return this->reload(now);
     }
     default:
       EDEN_BUG() << "Unexpected reload flag: " << enumValue(reload);
   }
+}
 
-  if (!shouldReload) {
-    return state_.rlock()->config;
-  }
-
-  auto state = state_.wlock();
-
+std::shared_ptr<const EdenConfig> ReloadableConfig::reload(
+    std::chrono::steady_clock::time_point now) {
   // Throttle the updates when using ConfigReloadBehavior::AutoReload
   lastCheck_.store(now, std::memory_order_release);
 
-  auto& config = state->config;
+  auto config = config_.load(std::memory_order_acquire);
   if (auto newConfig = config->maybeReload()) {
-    state->config = std::move(newConfig);
+    config_.store(newConfig, std::memory_order_release);
+    return newConfig;
   }
-  return state->config;
+  return config;
 }
 
 } // namespace facebook::eden
@@ -10,8 +10,10 @@
 #include <atomic>
 #include <chrono>
 #include <memory>
+#include <mutex>
+#include <optional>
 
-#include <folly/Synchronized.h>
+#include <folly/concurrency/AtomicSharedPtr.h>
 
 #include "eden/fs/config/gen-cpp2/eden_config_types.h"
 
@@ -53,24 +55,43 @@ class ReloadableConfig {
 
   ~ReloadableConfig();
 
+  /**
+   * Changes to the config files are checked for at most this often by
+   * AutoReload.
+   */
+  static constexpr std::chrono::seconds kAutoReloadInterval{5};
+
   /**
    * Get the EdenConfig data.
    *
    * The config data may be reloaded from disk depending on the value of the
-   * reload parameter.
+   * reload parameter. When no reload happens, this is a single atomic load of
+   * the current snapshot.
    */
   std::shared_ptr<const EdenConfig> getEdenConfig(
       ConfigReloadBehavior reload = ConfigReloadBehavior::AutoReload);
 
+  /**
+   * When enabled, AutoReload behaves like NoReload, and it is up to the
+   * owner to call getEdenConfig(ConfigReloadBehavior::ForceReload)
+   * periodically off the hot paths. This keeps the stat() calls of the
+   * config file checks out of the FUSE, NFS and import threads.
+   */
+  void setReloadInBackground(bool enabled) {
+    reloadInBackground_.store(enabled, std::memory_order_relaxed);
+  }
+
  private:
-  struct ConfigState {
-    std::shared_ptr<const EdenConfig> config;
-  };
+  std::shared_ptr<const EdenConfig> reload(
+      std::chrono::steady_clock::time_point now);
 
-  folly::Synchronized<ConfigState> state_;
+  folly::atomic_shared_ptr<const EdenConfig> config_;
+  // Serializes reloads, which replace config_.
+  std::mutex reloadMutex_;
   AtomicTimePoint<std::chrono::steady_clock> lastCheck_{
       std::chrono::steady_clock::time_point{},
   };
+  std::atomic<bool> reloadInBackground_{false};
 
   // When set, this overrides reload behavior passed to `getEdenConfig`.
   // Used in tests where we want to set the manually set the EdenConfig and
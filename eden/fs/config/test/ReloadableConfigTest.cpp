@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/config/ReloadableConfig.h"
+
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/config/EdenConfig.h"
+
+using namespace facebook::eden;
+
+namespace {
+
+/**
+ * Reports a change every time it is asked, and counts the checks.
+ */
+class AlwaysChangedConfigSource final : public ConfigSource {
+ public:
+  ConfigSourceType getSourceType() override {
+    return ConfigSourceType::UserConfig;
+  }
+  std::string getSourcePath() override {
+    return "";
+  }
+  FileChangeReason shouldReload() override {
+    ++checks;
+    return FileChangeReason::MTIME;
+  }
+  void reload(const ConfigVariables&, ConfigSettingMap&) override {}
+
+  int checks = 0;
+};
+
+struct ReloadableConfigTest : ::testing::Test {
+  void SetUp() override {
+    source = std::make_shared<AlwaysChangedConfigSource>();
+    auto config = std::make_shared<EdenConfig>(
+        ConfigVariables{},
+        canonicalPath("/tmp"),
+        canonicalPath("/tmp"),
+        EdenConfig::SourceVector{source});
+    // Constructing the EdenConfig applies its sources once.
+    source->checks = 0;
+    reloadable = std::make_unique<ReloadableConfig>(std::move(config));
+  }
+
+  std::shared_ptr<AlwaysChangedConfigSource> source;
+  std::unique_ptr<ReloadableConfig> reloadable;
+};
+
+TEST_F(ReloadableConfigTest, noReloadReturnsTheSameSnapshot) {
+  auto config = reloadable->getEdenConfig(ConfigReloadBehavior::NoReload);
+  EXPECT_EQ(
+      config, reloadable->getEdenConfig(ConfigReloadBehavior::NoReload));
+  EXPECT_EQ(0, source->checks);
+}
+
+TEST_F(ReloadableConfigTest, autoReloadIsThrottled) {
+  auto first = reloadable->getEdenConfig(ConfigReloadBehavior::AutoReload);
+  EXPECT_EQ(1, source->checks);
+  auto second = reloadable->getEdenConfig(ConfigReloadBehavior::AutoReload);
+  EXPECT_EQ(1, source->checks);
+  EXPECT_EQ(first, second);
+}
+
+TEST_F(ReloadableConfigTest, backgroundModeOnlyReloadsWhenForced) {
+  reloadable->setReloadInBackground(true);
+  auto before = reloadable->getEdenConfig(ConfigReloadBehavior::AutoReload);
+  EXPECT_EQ(0, source->checks);
+
+  auto reloaded = reloadable->getEdenConfig(ConfigReloadBehavior::ForceReload);
+  EXPECT_EQ(1, source->checks);
+  EXPECT_NE(before, reloaded);
+  EXPECT_EQ(
+      reloaded, reloadable->getEdenConfig(ConfigReloadBehavior::AutoReload));
+}
+
+} // namespace
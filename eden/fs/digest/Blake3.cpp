@@ -55,6 +55,18 @@ void Blake3::update(folly::StringPiece data) {
   update(data.data(), data.size());
 }
 
+void Blake3::updateParallel(const void* data, size_t size) {
+#ifdef BLAKE3_USE_TBB
+  // Below this, splitting the input between threads costs more than it saves.
+  constexpr size_t kMinParallelSize = 128 * 1024;
+  if (size >= kMinParallelSize) {
+    blake3_hasher_update_tbb(&hasher_, data, size);
+    return;
+  }
+#endif
+  update(data, size);
+}
+
 void Blake3::finalize(folly::MutableByteRange out) {
   if (out.size() != BLAKE3_OUT_LEN) {
     throw std::invalid_argument("Unexpected len");
@@ -34,6 +34,13 @@ struct Blake3 final {
   void update(folly::ByteRange data);
   void update(folly::StringPiece data);
 
+  /**
+   * Like update(), but when BLAKE3 is built with TBB support, hashes large
+   * inputs on several threads using BLAKE3's tree mode. Falls back to
+   * update() otherwise, and for inputs too small to benefit.
+   */
+  void updateParallel(const void* data, size_t size);
+
   void finalize(folly::MutableByteRange out);
 
  private:
@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/digest/HashMany.h"
+
+#include <cstring>
+
+#include <folly/CpuId.h>
+#include <folly/lang/Bits.h>
+#include <folly/ssl/OpenSSLHash.h>
+
+#include "eden/fs/digest/Blake3.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define EDEN_SHA1_LANES 1
+#endif
+
+namespace facebook::eden {
+
+namespace {
+
+void sha1EachWithOpenSSL(
+    folly::Range<const folly::ByteRange*> inputs,
+    std::vector<Sha1Digest>& out) {
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    folly::ssl::OpenSSLHash::sha1(folly::range(out[i]), inputs[i]);
+  }
+}
+
+#ifdef EDEN_SHA1_LANES
+
+constexpr size_t kLanes = 4;
+constexpr size_t kBlockSize = 64;
+constexpr uint32_t kInitialState[5] = {
+    0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+using Lanes = __m128i;
+
+inline Lanes add(Lanes a, Lanes b) {
+  return _mm_add_epi32(a, b);
+}
+
+inline Lanes bitXor(Lanes a, Lanes b) {
+  return _mm_xor_si128(a, b);
+}
+
+inline Lanes bitAnd(Lanes a, Lanes b) {
+  return _mm_and_si128(a, b);
+}
+
+inline Lanes bitOr(Lanes a, Lanes b) {
+  return _mm_or_si128(a, b);
+}
+
+/** Computes ~a & b. */
+inline Lanes bitAndNot(Lanes a, Lanes b) {
+  return _mm_andnot_si128(a, b);
+}
+
+template <int N>
+inline Lanes rotl(Lanes a) {
+  return _mm_or_si128(_mm_slli_epi32(a, N), _mm_srli_epi32(a, 32 - N));
+}
+
+inline Lanes splat(uint32_t value) {
+  return _mm_set1_epi32(static_cast<int>(value));
+}
+
+inline Lanes load(const uint32_t* values) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+}
+
+inline void store(uint32_t* values, Lanes lanes) {
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(values), lanes);
+}
+
+/**
+ * Runs the SHA-1 compression function on one 64-byte block per lane.
+ * state[i][lane] is word i of the lane's hash state.
+ */
+void compress(uint32_t (&state)[5][kLanes], const uint8_t* const* blocks) {
+  Lanes w[16];
+  for (size_t t = 0; t < 16; ++t) {
+    uint32_t words[kLanes];
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+      words[lane] = folly::Endian::big(
+          folly::loadUnaligned<uint32_t>(blocks[lane] + t * 4));
+    }
+    w[t] = load(words);
+  }
+
+  Lanes a = load(state[0]);
+  Lanes b = load(state[1]);
+  Lanes c = load(state[2]);
+  Lanes d = load(state[3]);
+  Lanes e = load(state[4]);
+
+  auto round = [&](size_t t, Lanes f, uint32_t k) {
+    if (t >= 16) {
+      w[t % 16] = rotl<1>(bitXor(
+          bitXor(w[(t + 13) % 16], w[(t + 8) % 16]),
+          bitXor(w[(t + 2) % 16], w[t % 16])));
+    }
+    Lanes temp = add(add(rotl<5>(a), f), add(add(e, splat(k)), w[t % 16]));
+    e = d;
+    d = c;
+    c = rotl<30>(b);
+    b = a;
+    a = temp;
+  };
+
+  size_t t = 0;
+  for (; t < 20; ++t) {
+    round(t, bitOr(bitAnd(b, c), bitAndNot(b, d)), 0x5A827999);
+  }
+  for (; t < 40; ++t) {
+    round(t, bitXor(bitXor(b, c), d), 0x6ED9EBA1);
+  }
+  for (; t < 60; ++t) {
+    round(t, bitOr(bitAnd(b, c), bitAnd(d, bitOr(b, c))), 0x8F1BBCDC);
+  }
+  for (; t < 80; ++t) {
+    round(t, bitXor(bitXor(b, c), d), 0xCA62C1D6);
+  }
+
+  store(state[0], add(load(state[0]), a));
+  store(state[1], add(load(state[1]), b));
+  store(state[2], add(load(state[2]), c));
+  store(state[3], add(load(state[3]), d));
+  store(state[4], add(load(state[4]), e));
+}
+
+/** The input a lane is hashing, and how far along it is. */
+struct Lane {
+  size_t input;
+  size_t block;
+  size_t fullBlocks;
+  size_t totalBlocks;
+  /** The padded final one or two blocks of the input. */
+  uint8_t tail[2 * kBlockSize];
+};
+
+/**
+ * Hashes the inputs kLanes at a time. A lane that finishes its input moves on
+ * to the next unhashed one, so inputs of different lengths keep every lane
+ * busy until the last few.
+ */
+void sha1EachInLanes(
+    folly::Range<const folly::ByteRange*> inputs,
+    std::vector<Sha1Digest>& out) {
+  static const uint8_t kIdleBlock[kBlockSize] = {};
+
+  uint32_t state[5][kLanes];
+  Lane lanes[kLanes];
+  bool active[kLanes];
+  size_t activeCount = 0;
+  size_t next = 0;
+
+  auto start = [&](size_t laneIndex) {
+    if (next == inputs.size()) {
+      active[laneIndex] = false;
+      return false;
+    }
+    auto& lane = lanes[laneIndex];
+    auto input = inputs[next];
+    lane.input = next++;
+    lane.block = 0;
+    lane.fullBlocks = input.size() / kBlockSize;
+    auto remainder = input.size() % kBlockSize;
+    // The padding is a 0x80 byte and the 8-byte big-endian bit length.
+    auto tailBlocks = remainder + 9 <= kBlockSize ? 1 : 2;
+    lane.totalBlocks = lane.fullBlocks + tailBlocks;
+
+    std::memset(lane.tail, 0, sizeof(lane.tail));
+    std::memcpy(
+        lane.tail, input.data() + lane.fullBlocks * kBlockSize, remainder);
+    lane.tail[remainder] = 0x80;
+    uint64_t bits = static_cast<uint64_t>(input.size()) * 8;
+    bits = folly::Endian::big(bits);
+    std::memcpy(lane.tail + tailBlocks * kBlockSize - 8, &bits, 8);
+
+    for (size_t i = 0; i < 5; ++i) {
+      state[i][laneIndex] = kInitialState[i];
+    }
+    active[laneIndex] = true;
+    return true;
+  };
+
+  for (size_t laneIndex = 0; laneIndex < kLanes; ++laneIndex) {
+    activeCount += start(laneIndex);
+  }
+
+  while (activeCount > 0) {
+    const uint8_t* blocks[kLanes];
+    for (size_t laneIndex = 0; laneIndex < kLanes; ++laneIndex) {
+      const auto& lane = lanes[laneIndex];
+      if (!active[laneIndex]) {
+        blocks[laneIndex] = kIdleBlock;
+      } else if (lane.block < lane.fullBlocks) {
+        blocks[laneIndex] =
+            inputs[lane.input].data() + lane.block * kBlockSize;
+      } else {
+        blocks[laneIndex] =
+            lane.tail + (lane.block - lane.fullBlocks) * kBlockSize;
+      }
+    }
+
+    compress(state, blocks);
+
+    for (size_t laneIndex = 0; laneIndex < kLanes; ++laneIndex) {
+      auto& lane = lanes[laneIndex];
+      if (!active[laneIndex] || ++lane.block < lane.totalBlocks) {
+        continue;
+      }
+      auto& digest = out[lane.input];
+      for (size_t i = 0; i < 5; ++i) {
+        folly::storeUnaligned(
+            digest.data() + i * 4, folly::Endian::big(state[i][laneIndex]));
+      }
+      if (!start(laneIndex)) {
+        --activeCount;
+      }
+    }
+  }
+}
+
+/**
+ * OpenSSL hashes a single input with the SHA extensions faster than lanes of
+ * plain SIMD arithmetic can hash four.
+ */
+bool hasShaInstructions() {
+  static const bool hasSha = folly::CpuId().sha();
+  return hasSha;
+}
+
+#endif
+
+} // namespace
+
+std::vector<Sha1Digest> sha1Many(folly::Range<const folly::ByteRange*> inputs) {
+  std::vector<Sha1Digest> out(inputs.size());
+#ifdef EDEN_SHA1_LANES
+  if (inputs.size() > 1 && !hasShaInstructions()) {
+    sha1EachInLanes(inputs, out);
+    return out;
+  }
+#endif
+  sha1EachWithOpenSSL(inputs, out);
+  return out;
+}
+
+std::vector<Blake3Digest> blake3Many(
+    folly::Range<const folly::ByteRange*> inputs,
+    std::optional<folly::ByteRange> key) {
+  std::vector<Blake3Digest> out(inputs.size());
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    auto hasher = Blake3::create(key);
+    hasher.update(inputs[i]);
+    hasher.finalize(folly::range(out[i]));
+  }
+  return out;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <array>
+#include <optional>
+#include <vector>
+
+#include <folly/Range.h>
+
+namespace facebook::eden {
+
+using Sha1Digest = std::array<uint8_t, 20>;
+using Blake3Digest = std::array<uint8_t, 32>;
+
+/**
+ * Compute the SHA-1 of each input.
+ *
+ * On x86 CPUs without the SHA extensions, the inputs are hashed four at a
+ * time, each in its own SIMD lane, which amortizes the per-block work and the
+ * per-call overhead of OpenSSL over many small inputs. Elsewhere, each input
+ * is hashed with OpenSSL, which uses the CPU's SHA instructions.
+ */
+std::vector<Sha1Digest> sha1Many(folly::Range<const folly::ByteRange*> inputs);
+
+/**
+ * Compute the BLAKE3 hash of each input, keyed when key is set.
+ *
+ * The BLAKE3 library only exposes its multi-input SIMD kernel for the chunks
+ * of a single input, so inputs are hashed one after the other.
+ */
+std::vector<Blake3Digest> blake3Many(
+    folly::Range<const folly::ByteRange*> inputs,
+    std::optional<folly::ByteRange> key);
+
+} // namespace facebook::eden
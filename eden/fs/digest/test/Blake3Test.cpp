@@ -7,7 +7,9 @@
 
 #include "eden/fs/digest/Blake3.h"
 
+#include <array>
 #include <string>
+#include <vector>
 
 #include <folly/Range.h>
 #include <folly/String.h>
@@ -66,4 +68,26 @@ TEST(Blake3, emptyKeyedBlake3Test) {
       folly::hexlify(folly::ByteRange(out.data(), out.size())),
       "e898b912a31fc35d7b3522173f5e8549ea08e3e8edd9b0586a3344d07d6d85f3");
 }
+
+TEST(Blake3, updateParallelMatchesUpdate) {
+  // Large enough to be split between threads when that is supported, and not
+  // a whole number of chunks.
+  std::vector<uint8_t> data(1024 * 1024 + 17);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = i % 251;
+  }
+
+  std::array<uint8_t, 32> expected;
+  Blake3 serial;
+  serial.update(data.data(), data.size());
+  serial.finalize(folly::MutableByteRange(expected.data(), expected.size()));
+
+  std::array<uint8_t, 32> out;
+  Blake3 parallel;
+  parallel.updateParallel(data.data(), 1000);
+  parallel.updateParallel(data.data() + 1000, data.size() - 1000);
+  parallel.finalize(folly::MutableByteRange(out.data(), out.size()));
+
+  EXPECT_EQ(expected, out);
+}
 } // namespace
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/digest/HashMany.h"
+
+#include <benchmark/benchmark.h>
+#include <folly/ssl/OpenSSLHash.h>
+
+using namespace facebook::eden;
+
+namespace {
+
+constexpr size_t kBlobCount = 1024;
+
+/** kBlobCount overlapping blobs of state.range(0) bytes. */
+struct Blobs {
+  explicit Blobs(size_t size) : data(size + kBlobCount) {
+    for (size_t i = 0; i < data.size(); ++i) {
+      data[i] = i % 251;
+    }
+    for (size_t i = 0; i < kBlobCount; ++i) {
+      ranges.emplace_back(data.data() + i, size);
+    }
+  }
+
+  std::vector<uint8_t> data;
+  std::vector<folly::ByteRange> ranges;
+};
+
+void sha1_one_at_a_time(benchmark::State& state) {
+  Blobs blobs(state.range(0));
+  Sha1Digest out;
+  for (auto _ : state) {
+    for (auto range : blobs.ranges) {
+      folly::ssl::OpenSSLHash::sha1(folly::range(out), range);
+      benchmark::DoNotOptimize(out);
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * kBlobCount * state.range(0));
+}
+BENCHMARK(sha1_one_at_a_time)->Arg(256)->Arg(4096);
+
+void sha1_many(benchmark::State& state) {
+  Blobs blobs(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(sha1Many(folly::range(blobs.ranges)));
+  }
+  state.SetBytesProcessed(state.iterations() * kBlobCount * state.range(0));
+}
+BENCHMARK(sha1_many)->Arg(256)->Arg(4096);
+
+void blake3_many(benchmark::State& state) {
+  Blobs blobs(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        blake3Many(folly::range(blobs.ranges), std::nullopt));
+  }
+  state.SetBytesProcessed(state.iterations() * kBlobCount * state.range(0));
+}
+BENCHMARK(blake3_many)->Arg(256)->Arg(4096);
+
+} // namespace
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/digest/HashMany.h"
+
+#include <vector>
+
+#include <folly/String.h>
+#include <folly/portability/GTest.h>
+#include <folly/ssl/OpenSSLHash.h>
+
+#include "eden/fs/digest/Blake3.h"
+
+using namespace facebook::eden;
+
+namespace {
+
+constexpr folly::StringPiece kKey = "19700101-1111111111111111111111#";
+
+template <size_t N>
+std::string hex(const std::array<uint8_t, N>& bytes) {
+  return folly::hexlify(folly::range(bytes));
+}
+
+TEST(HashMany, sha1KnownValues) {
+  std::vector<folly::ByteRange> inputs{
+      folly::ByteRange{folly::StringPiece{""}},
+      folly::ByteRange{folly::StringPiece{"abc"}},
+  };
+  auto out = sha1Many(folly::range(inputs));
+  ASSERT_EQ(2, out.size());
+  EXPECT_EQ("da39a3ee5e6b4b0d3255bfef95601890afd80709", hex(out[0]));
+  EXPECT_EQ("a9993e364706816aba3e25717850c26c9cd0d89d", hex(out[1]));
+}
+
+TEST(HashMany, matchesHashingOneAtATime) {
+  // Lengths around the 64-byte block size and its padding boundary, in more
+  // inputs than there are lanes, so that lanes finish at different times.
+  std::vector<uint8_t> data(5000);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = i * 31 % 256;
+  }
+  std::vector<folly::ByteRange> inputs;
+  for (size_t size : {0, 1, 55, 56, 63, 64, 65, 119, 120, 128, 1000, 5000}) {
+    inputs.emplace_back(data.data() + data.size() - size, size);
+  }
+
+  auto sha1s = sha1Many(folly::range(inputs));
+  auto blake3s = blake3Many(folly::range(inputs), std::nullopt);
+  auto keyedBlake3s = blake3Many(folly::range(inputs), folly::ByteRange{kKey});
+  ASSERT_EQ(inputs.size(), sha1s.size());
+  ASSERT_EQ(inputs.size(), blake3s.size());
+  ASSERT_EQ(inputs.size(), keyedBlake3s.size());
+
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    SCOPED_TRACE(inputs[i].size());
+
+    Sha1Digest sha1;
+    folly::ssl::OpenSSLHash::sha1(folly::range(sha1), inputs[i]);
+    EXPECT_EQ(hex(sha1), hex(sha1s[i]));
+
+    Blake3Digest blake3;
+    Blake3 hasher;
+    hasher.update(inputs[i]);
+    hasher.finalize(folly::range(blake3));
+    EXPECT_EQ(hex(blake3), hex(blake3s[i]));
+
+    Blake3 keyedHasher{folly::ByteRange{kKey}};
+    keyedHasher.update(inputs[i]);
+    keyedHasher.finalize(folly::range(blake3));
+    EXPECT_EQ(hex(blake3), hex(keyedBlake3s[i]));
+  }
+}
+
+TEST(HashMany, empty) {
+  EXPECT_TRUE(sha1Many({}).empty());
+  EXPECT_TRUE(blake3Many({}, std::nullopt).empty());
+}
+
+} // namespace
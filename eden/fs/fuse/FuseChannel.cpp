@@ -10,11 +10,16 @@
 #include "eden/fs/fuse/FuseChannel.h"
 #include <boost/cast.hpp>
 #include <fmt/core.h>
+#include <folly/Exception.h>
+#include <folly/container/F14Set.h>
 #include <folly/executors/QueuedImmediateExecutor.h>
 #include <folly/futures/Future.h>
 #include <folly/logging/xlog.h>
 #include <folly/system/ThreadName.h>
+#include <fcntl.h>
 #include <signal.h>
+#include <sys/ioctl.h>
+#include <algorithm>
 #include <chrono>
 #include <type_traits>
 #include "eden/common/utils/Synchronized.h"
@@ -22,6 +27,7 @@
 #include "eden/fs/fuse/FuseDispatcher.h"
 #include "eden/fs/fuse/FuseRequestContext.h"
 #include "eden/fs/privhelper/PrivHelper.h"
+#include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/telemetry/FsEventLogger.h"
 #include "eden/fs/utils/Bug.h"
 #include "eden/fs/utils/IDGen.h"
@@ -214,6 +220,24 @@ static_assert(CheckSize<FuseTraceEvent, 72>());
 // This is the minimum size used by libfuse so we use it too!
 constexpr size_t MIN_BUFSIZE = 0x21000;
 
+// Room for the headers preceding the data of a FUSE_WRITE request.
+constexpr size_t kWriteHeaderSize = 0x1000;
+
+// The largest max_pages the kernel accepts (FUSE_MAX_MAX_PAGES).
+constexpr size_t kMaxPages = 256;
+
+// How many of the slowest completed requests are kept for
+// getSlowestRequests().
+constexpr size_t kMaxSlowestRequests = 64;
+
+size_t computeBufferSize(size_t maxWrite) {
+  auto pageSize = size_t(getpagesize());
+  auto alignedMaxWrite = (maxWrite + pageSize - 1) / pageSize * pageSize;
+  return std::max(
+      std::min(alignedMaxWrite, kMaxPages * pageSize) + kWriteHeaderSize,
+      MIN_BUFSIZE);
+}
+
 using Handler = ImmediateFuture<folly::Unit> (FuseChannel::*)(
     FuseRequestContext& request,
     const fuse_in_header& header,
@@ -476,7 +500,13 @@ constexpr auto kFuseHandlers = [] {
       &FuseStats::fallocate,
       Write};
 #ifdef __linux__
-  handlers[FUSE_READDIRPLUS] = {"FUSE_READDIRPLUS", Read};
+  handlers[FUSE_READDIRPLUS] = {
+      "FUSE_READDIRPLUS",
+      &FuseChannel::fuseReadDirPlus,
+      &argrender::readdir,
+      &FuseStats::readdirplus,
+      Read,
+      SamplingGroup::Three};
   handlers[FUSE_RENAME2] = {"FUSE_RENAME2", Write};
   handlers[FUSE_LSEEK] = {"FUSE_LSEEK"};
   handlers[FUSE_COPY_FILE_RANGE] = {"FUSE_COPY_FILE_RANGE", Write};
@@ -692,14 +722,17 @@ std::ostream& operator<<(
             << ")";
 }
 
-void FuseChannel::replyError(const fuse_in_header& request, int errorCode) {
+void FuseChannel::replyError(
+    int fuseDevice,
+    const fuse_in_header& request,
+    int errorCode) {
   fuse_out_header err;
   err.len = sizeof(err);
   err.error = -errorCode;
   err.unique = request.unique;
   XLOG(DBG7) << "replyError unique=" << err.unique << " error=" << errorCode
              << " " << folly::errnoStr(errorCode);
-  auto res = write(fuseDevice_.fd(), &err, sizeof(err));
+  auto res = write(fuseDevice, &err, sizeof(err));
   if (res != sizeof(err)) {
     if (res < 0) {
       throwSystemError("replyError: error writing to fuse device");
@@ -710,6 +743,7 @@ void FuseChannel::replyError(const fuse_in_header& request, int errorCode) {
 }
 
 void FuseChannel::sendReply(
+    int fuseDevice,
     const fuse_in_header& request,
     folly::fbvector<iovec>&& vec) const {
   fuse_out_header out;
@@ -718,10 +752,11 @@ void FuseChannel::sendReply(
 
   vec.insert(vec.begin(), make_iovec(out));
 
-  sendRawReply(vec.data(), vec.size());
+  sendRawReply(fuseDevice, vec.data(), vec.size());
 }
 
 void FuseChannel::sendReply(
+    int fuseDevice,
     const fuse_in_header& request,
     const folly::IOBuf& buf) const {
   fuse_out_header out;
@@ -733,10 +768,11 @@ void FuseChannel::sendReply(
   vec.push_back(make_iovec(out));
   buf.appendToIov(&vec);
 
-  sendRawReply(vec.data(), vec.size());
+  sendRawReply(fuseDevice, vec.data(), vec.size());
 }
 
 void FuseChannel::sendReply(
+    int fuseDevice,
     const fuse_in_header& request,
     folly::ByteRange bytes) const {
   fuse_out_header out;
@@ -749,10 +785,11 @@ void FuseChannel::sendReply(
   iov[1].iov_base = const_cast<uint8_t*>(bytes.data());
   iov[1].iov_len = bytes.size();
 
-  sendRawReply(iov.data(), iov.size());
+  sendRawReply(fuseDevice, iov.data(), iov.size());
 }
 
-void FuseChannel::sendRawReply(const iovec iov[], size_t count) const {
+void FuseChannel::sendRawReply(int fuseDevice, const iovec iov[], size_t count)
+    const {
   // Ensure that the length is set correctly
   XDCHECK_EQ(iov[0].iov_len, sizeof(fuse_out_header));
   const auto header = reinterpret_cast<fuse_out_header*>(iov[0].iov_base);
@@ -761,7 +798,7 @@ void FuseChannel::sendRawReply(const iovec iov[], size_t count) const {
     header->len += iov[i].iov_len;
   }
 
-  const auto res = writev(fuseDevice_.fd(), iov, count);
+  const auto res = writev(fuseDevice, iov, count);
   const int err = errno;
   XLOG(DBG7) << "sendRawReply: unique=" << header->unique
              << " header->len=" << header->len << " wrote=" << res;
@@ -794,10 +831,18 @@ FuseChannel::FuseChannel(
     bool requireUtf8Path,
     int32_t maximumBackgroundRequests,
     bool useWriteBackCache,
+    size_t maxWrite,
+    bool cloneDevicePerThread,
+    bool useReaddirplus,
+    size_t numInvalidationThreads,
+    size_t initialThreads,
     size_t fuseTraceBusCapacity)
     : privHelper_{privHelper},
-      bufferSize_(std::max(size_t(getpagesize()) + 0x1000, MIN_BUFSIZE)),
+      bufferSize_(computeBufferSize(maxWrite)),
       numThreads_(numThreads),
+      initialThreads_(
+          initialThreads == 0 ? numThreads
+                              : std::min(initialThreads, numThreads)),
       dispatcher_(std::move(dispatcher)),
       straceLogger_(straceLogger),
       mountPath_(mountPath),
@@ -807,7 +852,10 @@ FuseChannel::FuseChannel(
       requireUtf8Path_{requireUtf8Path},
       maximumBackgroundRequests_{maximumBackgroundRequests},
       useWriteBackCache_{useWriteBackCache},
+      cloneDevicePerThread_{cloneDevicePerThread},
+      useReaddirplus_{useReaddirplus},
       fuseDevice_(std::move(fuseDevice)),
+      invalidationShards_(std::max<size_t>(numInvalidationThreads, 1)),
       processAccessLog_(std::move(processNameCache)),
       traceDetailedArguments_(std::make_shared<std::atomic<size_t>>(0)),
       traceBus_(TraceBus<FuseTraceEvent>::create(
@@ -842,6 +890,13 @@ FuseChannel::FuseChannel(
               durationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
                   event.monotonicTime - it->second.requestStartTime);
               state->requests.erase(it);
+              recordCompletedRequest(
+                  *state,
+                  CompletedRequest{
+                      event.getUnique(),
+                      event.getRequest(),
+                      durationNs,
+                      event.getResponseCode()});
             }
 
             if (fsEventLogger) {
@@ -908,20 +963,79 @@ void FuseChannel::startWorkerThreads() {
 
   try {
     state->workerThreads.reserve(numThreads_);
-    while (state->workerThreads.size() < numThreads_) {
-      state->workerThreads.emplace_back([this] { fuseWorkerThread(); });
+    bool cloneDevice = cloneDevicePerThread_;
+    while (state->workerThreads.size() < initialThreads_) {
+      startWorkerThread(state, cloneDevice);
     }
 
-    invalidationThread_ = std::thread([this] { invalidationThread(); });
+    for (auto& shard : invalidationShards_) {
+      shard.thread = std::thread([this, &shard] { invalidationThread(shard); });
+    }
+    state->numThreads = state->workerThreads.size();
   } catch (const std::exception& ex) {
     XLOG(ERR) << "Error starting FUSE worker threads: " << exceptionStr(ex);
     // Request any threads we did start to stop now.
     requestSessionExit(state, StopReason::INIT_FAILED);
-    stopInvalidationThread();
+    stopInvalidationThreads();
     throw;
   }
 }
 
+void FuseChannel::startWorkerThread(
+    const folly::Synchronized<State>::LockedPtr& state,
+    bool& cloneDevice) {
+  int fuseDevice = fuseDevice_.fd();
+  if (cloneDevice) {
+    try {
+      state->clonedDevices.push_back(cloneFuseDevice());
+      fuseDevice = state->clonedDevices.back().fd();
+    } catch (const std::exception& ex) {
+      XLOG(WARN) << "unable to clone the FUSE device of mount \""
+                 << mountPath_ << "\", sharing it between worker threads: "
+                 << exceptionStr(ex);
+      cloneDevice = false;
+    }
+  }
+  state->workerThreads.emplace_back(
+      [this, fuseDevice] { fuseWorkerThread(fuseDevice); });
+}
+
+void FuseChannel::startExtraWorkerThread() {
+  auto state = state_.wlock();
+  // Only add threads once the initial ones are all running, and not while
+  // requestSessionExit() may be signalling them to stop.
+  if (state->stopReason != StopReason::RUNNING || state->numThreads == 0 ||
+      state->workerThreads.size() >= numThreads_) {
+    return;
+  }
+
+  // Only clone the device if it worked for the initial threads.
+  bool cloneDevice = cloneDevicePerThread_ && !state->clonedDevices.empty();
+  try {
+    startWorkerThread(state, cloneDevice);
+  } catch (const std::exception& ex) {
+    XLOG(WARN) << "unable to start another FUSE worker thread for mount \""
+               << mountPath_ << "\": " << exceptionStr(ex);
+    return;
+  }
+  ++state->numThreads;
+  XLOG(DBG3) << "all FUSE worker threads of mount \"" << mountPath_
+             << "\" are busy, now running " << state->numThreads;
+}
+
+folly::File FuseChannel::cloneFuseDevice() const {
+#ifdef FUSE_DEV_IOC_CLONE
+  folly::File clone{"/dev/fuse", O_RDWR | O_CLOEXEC};
+  uint32_t sourceDevice = fuseDevice_.fd();
+  folly::checkUnixError(
+      ioctl(clone.fd(), FUSE_DEV_IOC_CLONE, &sourceDevice),
+      "FUSE_DEV_IOC_CLONE failed");
+  return clone;
+#else
+  throwSystemErrorExplicit(ENOTSUP, "FUSE devices cannot be cloned");
+#endif
+}
+
 void FuseChannel::destroy() {
   std::vector<std::thread> threads;
   {
@@ -955,52 +1069,147 @@ void FuseChannel::destroy() {
   }
 }
 
+FuseChannel::InvalidationShard& FuseChannel::getInvalidationShard(
+    InodeNumber ino) {
+  return invalidationShards_[ino.get() % invalidationShards_.size()];
+}
+
 void FuseChannel::invalidateInode(InodeNumber ino, off_t off, off_t len) {
-  // Add the entry to invalidationQueue_ and wake up the invalidation thread to
-  // send it.
-  invalidationQueue_.lock()->queue.emplace_back(ino, off, len);
-  invalidationCV_.notify_one();
+  // Add the entry to the queue of its shard and wake up the invalidation
+  // thread to send it.
+  auto& shard = getInvalidationShard(ino);
+  shard.queue.lock()->queue.emplace_back(ino, off, len);
+  shard.cv.notify_one();
 }
 
 void FuseChannel::invalidateEntry(InodeNumber parent, PathComponentPiece name) {
-  // Add the entry to invalidationQueue_ and wake up the invalidation thread to
-  // send it.
-  invalidationQueue_.lock()->queue.emplace_back(parent, name);
-  invalidationCV_.notify_one();
+  // Add the entry to the queue of its shard and wake up the invalidation
+  // thread to send it.
+  auto& shard = getInvalidationShard(parent);
+  shard.queue.lock()->queue.emplace_back(parent, name);
+  shard.cv.notify_one();
 }
 
 void FuseChannel::invalidateInodes(folly::Range<InodeNumber*> range) {
-  {
-    auto queue = invalidationQueue_.lock();
-    std::transform(
-        range.begin(),
-        range.end(),
-        std::back_insert_iterator(queue->queue),
-        [](const auto& inodeNum) { return InvalidationEntry(inodeNum, 0, 0); });
-  }
-  if (range.begin() != range.end()) {
-    invalidationCV_.notify_one();
+  auto numShards = invalidationShards_.size();
+  for (size_t index = 0; index < numShards; ++index) {
+    auto& shard = invalidationShards_[index];
+    bool added = false;
+    {
+      auto queue = shard.queue.lock();
+      for (auto inodeNum : range) {
+        if (inodeNum.get() % numShards == index) {
+          queue->queue.emplace_back(inodeNum, 0, 0);
+          added = true;
+        }
+      }
+    }
+    if (added) {
+      shard.cv.notify_one();
+    }
   }
 }
 
 ImmediateFuture<folly::Unit> FuseChannel::completeInvalidations() {
-  // Add a promise to the invalidation queue, which the invalidation thread
+  // Add a promise to each invalidation queue, which its invalidation thread
   // will fulfill once it reaches that element in the queue.
-  Promise<Unit> promise;
-  auto result = promise.getFuture();
-  {
-    auto state = invalidationQueue_.lock();
-    if (state->stop) {
-      // In the case of a concurrent unmount with a checkout, the unmount could
-      // win the race and thus have shutdown the invalidation thread. This is
-      // not an issue as the mount is gone at this point, let's thus return
-      // immediately.
-      return folly::unit;
+  std::vector<ImmediateFuture<folly::Unit>> futures;
+  futures.reserve(invalidationShards_.size());
+  for (auto& shard : invalidationShards_) {
+    Promise<Unit> promise;
+    auto result = promise.getSemiFuture();
+    {
+      auto state = shard.queue.lock();
+      if (state->stop) {
+        // In the case of a concurrent unmount with a checkout, the unmount
+        // could win the race and thus have shutdown the invalidation threads.
+        // This is not an issue as the mount is gone at this point, let's thus
+        // return immediately.
+        return folly::unit;
+      }
+      state->queue.emplace_back(std::move(promise));
+    }
+    shard.cv.notify_one();
+    futures.emplace_back(std::move(result));
+  }
+  return collectAllSafe(std::move(futures)).unit();
+}
+
+/**
+ * Drop the entries of a batch of invalidations that another entry of the same
+ * batch makes redundant. Entries are only compared with the ones between the
+ * same two FLUSH entries, so that a flush still completes only after every
+ * invalidation queued before it was sent.
+ *
+ * This method always runs in an invalidation thread.
+ */
+void FuseChannel::coalesceInvalidations(
+    std::vector<InvalidationEntry>& entries) {
+  if (entries.size() < 2) {
+    return;
+  }
+
+  std::vector<InvalidationEntry> result;
+  result.reserve(entries.size());
+  folly::F14FastSet<InodeNumber> fullyInvalidated;
+  folly::F14FastSet<InodeNumber> sentFullInvalidation;
+  folly::F14FastSet<std::pair<uint64_t, std::string_view>> sentEntries;
+  uint64_t coalesced = 0;
+
+  auto segmentBegin = entries.begin();
+  while (segmentBegin != entries.end()) {
+    auto segmentEnd = std::find_if(segmentBegin, entries.end(), [](auto& e) {
+      return e.type == InvalidationType::FLUSH;
+    });
+
+    fullyInvalidated.clear();
+    sentFullInvalidation.clear();
+    sentEntries.clear();
+    for (auto it = segmentBegin; it != segmentEnd; ++it) {
+      if (it->type == InvalidationType::INODE && it->range.offset == 0 &&
+          it->range.length == 0) {
+        fullyInvalidated.insert(it->inode);
+      }
+    }
+
+    for (auto it = segmentBegin; it != segmentEnd; ++it) {
+      bool redundant = false;
+      if (it->type == InvalidationType::INODE) {
+        // A full invalidation also drops the attributes and any range of the
+        // inode's data, so only the first one of the segment is needed.
+        if (fullyInvalidated.count(it->inode)) {
+          redundant = (it->range.offset != 0 || it->range.length != 0) ||
+              !sentFullInvalidation.insert(it->inode).second;
+        }
+      } else if (it->type == InvalidationType::DIR_ENTRY) {
+        redundant = sentEntries.count({it->inode.get(), it->name.view()}) != 0;
+      }
+
+      if (redundant) {
+        ++coalesced;
+        continue;
+      }
+      result.push_back(std::move(*it));
+      if (result.back().type == InvalidationType::DIR_ENTRY) {
+        // result never reallocates, so the name outlives this set.
+        sentEntries.emplace(
+            result.back().inode.get(), result.back().name.view());
+      }
     }
-    state->queue.emplace_back(std::move(promise));
+
+    if (segmentEnd == entries.end()) {
+      break;
+    }
+    result.push_back(std::move(*segmentEnd));
+    segmentBegin = std::next(segmentEnd);
+  }
+
+  if (coalesced > 0) {
+    XLOG(DBG6) << "coalesced " << coalesced << " of " << entries.size()
+               << " invalidation requests";
+    invalidationsCoalesced_.fetch_add(coalesced, std::memory_order_relaxed);
   }
-  invalidationCV_.notify_one();
-  return result;
+  entries = std::move(result);
 }
 
 /**
@@ -1015,10 +1224,14 @@ void FuseChannel::sendInvalidation(InvalidationEntry& entry) {
   try {
     switch (entry.type) {
       case InvalidationType::INODE:
+        invalidationsSent_.fetch_add(1, std::memory_order_relaxed);
+        dispatcher_->getStats()->increment(&FuseStats::invalidateInode);
         sendInvalidateInode(
             entry.inode, entry.range.offset, entry.range.length);
         return;
       case InvalidationType::DIR_ENTRY:
+        invalidationsSent_.fetch_add(1, std::memory_order_relaxed);
+        dispatcher_->getStats()->increment(&FuseStats::invalidateEntry);
         sendInvalidateEntry(entry.inode, entry.name);
         return;
       case InvalidationType::FLUSH:
@@ -1075,7 +1288,7 @@ void FuseChannel::sendInvalidateInode(
   iov[1].iov_len = sizeof(notify);
 
   try {
-    sendRawReply(iov.data(), iov.size());
+    sendRawReply(fuseDevice_.fd(), iov.data(), iov.size());
     XLOG(DBG7) << "sendInvalidateInode(ino=" << ino << ", off=" << off
                << ", len=" << len << ") OK!";
   } catch (const std::system_error& exc) {
@@ -1134,7 +1347,7 @@ void FuseChannel::sendInvalidateEntry(
   iov[3].iov_len = 1;
 
   try {
-    sendRawReply(iov.data(), iov.size());
+    sendRawReply(fuseDevice_.fd(), iov.data(), iov.size());
   } catch (const std::system_error& exc) {
     // Ignore ENOENT.  This can happen for inode numbers that we allocated on
     // our own and haven't actually told the kernel about yet.
@@ -1163,6 +1376,34 @@ FuseChannel::getOutstandingRequests() {
   return outstandingCalls;
 }
 
+std::vector<FuseChannel::CompletedRequest> FuseChannel::getSlowestRequests() {
+  auto slowestRequests = telemetryState_.rlock()->slowestRequests;
+  std::sort(
+      slowestRequests.begin(),
+      slowestRequests.end(),
+      [](const CompletedRequest& a, const CompletedRequest& b) {
+        return a.duration > b.duration;
+      });
+  return slowestRequests;
+}
+
+void FuseChannel::recordCompletedRequest(
+    TelemetryState& state,
+    CompletedRequest request) {
+  auto fasterThan = [](const CompletedRequest& a, const CompletedRequest& b) {
+    return a.duration > b.duration;
+  };
+  auto& heap = state.slowestRequests;
+  if (heap.size() < kMaxSlowestRequests) {
+    heap.push_back(std::move(request));
+    std::push_heap(heap.begin(), heap.end(), fasterThan);
+  } else if (request.duration > heap.front().duration) {
+    std::pop_heap(heap.begin(), heap.end(), fasterThan);
+    heap.back() = std::move(request);
+    std::push_heap(heap.begin(), heap.end(), fasterThan);
+  }
+}
+
 TraceDetailedArgumentsHandle FuseChannel::traceDetailedArguments() const {
   // We could implement something fancier here that just copies the shared_ptr
   // into a handle struct that increments upon taking ownership and decrements
@@ -1248,10 +1489,10 @@ void FuseChannel::initWorkerThread() noexcept {
   initPromise_.setValue(sessionCompletePromise_.getSemiFuture());
 
   // Continue to run like a normal FUSE worker thread.
-  fuseWorkerThread();
+  fuseWorkerThread(fuseDevice_.fd());
 }
 
-void FuseChannel::fuseWorkerThread() noexcept {
+void FuseChannel::fuseWorkerThread(int fuseDevice) noexcept {
   disablePthreadCancellation();
   setThreadName(fmt::format("fuse{}", mountPath_.basename()));
   setThreadSigmask();
@@ -1259,7 +1500,7 @@ void FuseChannel::fuseWorkerThread() noexcept {
       std::make_shared<RequestMetricsScope::LockedRequestWatchList>();
 
   try {
-    processSession();
+    processSession(fuseDevice);
   } catch (const std::exception& ex) {
     XLOG(ERR) << "unexpected error in FUSE worker thread: " << exceptionStr(ex);
     // Request that all other FUSE threads exit.
@@ -1281,17 +1522,18 @@ void FuseChannel::fuseWorkerThread() noexcept {
     // but there are still outstanding requests we will invoke
     // sessionComplete() when we process the final stage of the request
     // processing for the last request.
-    if (state->stoppedThreads == numThreads_ && state->pendingRequests == 0) {
+    if (state->numThreads != 0 && state->stoppedThreads == state->numThreads &&
+        state->pendingRequests == 0) {
       sessionComplete(std::move(state));
     }
   }
 }
 
-void FuseChannel::invalidationThread() noexcept {
+void FuseChannel::invalidationThread(InvalidationShard& shard) noexcept {
   setThreadName(fmt::format("inval{}", mountPath_.basename()));
 
   // We send all FUSE_NOTIFY_INVAL_ENTRY and FUSE_NOTIFY_INVAL_INODE requests
-  // in a dedicated thread.  These requests will block in the kernel until it
+  // in dedicated threads.  These requests will block in the kernel until it
   // can obtain the inode lock on the inode in question.
   //
   // It is possible that the kernel-level inode lock is already held by another
@@ -1310,17 +1552,18 @@ void FuseChannel::invalidationThread() noexcept {
     // Wait for entries to process
     std::vector<InvalidationEntry> entries;
     {
-      auto lockedQueue = invalidationQueue_.lock();
+      auto lockedQueue = shard.queue.lock();
       while (lockedQueue->queue.empty()) {
         if (lockedQueue->stop) {
           return;
         }
-        invalidationCV_.wait(lockedQueue.as_lock());
+        shard.cv.wait(lockedQueue.as_lock());
       }
       lockedQueue->queue.swap(entries);
     }
 
     // Process all of the entries we found
+    coalesceInvalidations(entries);
     for (auto& entry : entries) {
       sendInvalidation(entry);
     }
@@ -1328,16 +1571,18 @@ void FuseChannel::invalidationThread() noexcept {
   }
 }
 
-void FuseChannel::stopInvalidationThread() {
-  // Check that the thread is joinable just in case we were destroyed
-  // before the invalidation thread was started.
-  if (!invalidationThread_.joinable()) {
-    return;
-  }
+void FuseChannel::stopInvalidationThreads() {
+  for (auto& shard : invalidationShards_) {
+    // Check that the thread is joinable just in case we were destroyed
+    // before the invalidation threads were started.
+    if (!shard.thread.joinable()) {
+      continue;
+    }
 
-  invalidationQueue_.lock()->stop = true;
-  invalidationCV_.notify_one();
-  invalidationThread_.join();
+    shard.queue.lock()->stop = true;
+    shard.cv.notify_one();
+    shard.thread.join();
+  }
 }
 
 void FuseChannel::readInitPacket() {
@@ -1406,7 +1651,7 @@ void FuseChannel::readInitPacket() {
   }
 
   if (init.header.opcode != FUSE_INIT) {
-    replyError(init.header, EPROTO);
+    replyError(fuseDevice_.fd(), init.header, EPROTO);
     throw_<std::runtime_error>(
         "expected to receive FUSE_INIT for \"",
         mountPath_,
@@ -1420,7 +1665,7 @@ void FuseChannel::readInitPacket() {
   fuse_init_out connInfo = {};
   connInfo.major = init.init.major;
   connInfo.minor = init.init.minor;
-  connInfo.max_write = bufferSize_ - 4096;
+  connInfo.max_write = bufferSize_ - kWriteHeaderSize;
   connInfo.max_readahead = init.init.max_readahead;
 
   int32_t max_background = maximumBackgroundRequests_;
@@ -1440,9 +1685,8 @@ void FuseChannel::readInitPacket() {
   const auto capable = init.init.flags;
   auto& want = connInfo.flags;
 
-  // TODO: follow up and look at the new flags; particularly
-  // FUSE_DO_READDIRPLUS, FUSE_READDIRPLUS_AUTO. FUSE_SPLICE_XXX are interesting
-  // too, but may not directly benefit eden today.
+  // TODO: follow up and look at the new flags. FUSE_SPLICE_XXX are
+  // interesting, but may not directly benefit eden today.
   //
   // FUSE_ATOMIC_O_TRUNC is a nice optimization when the kernel supports it
   // and the FUSE daemon requires handling open/release for stateful file
@@ -1466,6 +1710,25 @@ void FuseChannel::readInitPacket() {
   want |= FUSE_CACHE_SYMLINKS;
   // We can handle almost any request in parallel.
   want |= FUSE_PARALLEL_DIROPS;
+  // The contents of an inode only change through the kernel, or when EdenFS
+  // invalidates them: checkout gives files whose contents change a new inode
+  // number. Keep cached pages until they are invalidated with
+  // invalidateInode(), rather than whenever getattr reports a new size.
+  want |= FUSE_EXPLICIT_INVAL_DATA;
+  // Without this, the kernel splits reads and writes into requests of at most
+  // 32 pages, whatever max_write is.
+  want |= FUSE_MAX_PAGES;
+  auto pageSize = size_t(getpagesize());
+  connInfo.max_pages = static_cast<uint16_t>(std::min<size_t>(
+      (connInfo.max_write + pageSize - 1) / pageSize, kMaxPages));
+  if (useReaddirplus_) {
+    // Return the attributes of directory entries along with them, saving the
+    // lookup of each entry when they are stat()ed. The kernel only asks for
+    // them for the start of a listing, or when the entries were stat()ed.
+    want |= FUSE_DO_READDIRPLUS | FUSE_READDIRPLUS_AUTO;
+  }
+#else
+  (void)useReaddirplus_;
 #endif
 
 #ifdef FUSE_WRITEBACK_CACHE
@@ -1479,7 +1742,8 @@ void FuseChannel::readInitPacket() {
 
 #ifdef FUSE_NO_OPEN_SUPPORT
   // File handles are stateless so the kernel does not need to send open() and
-  // release().
+  // release(). Files opened without FUSE_OPEN behave as if FOPEN_KEEP_CACHE
+  // was set, so their cached pages are kept across opens, as in fuseOpen().
   want |= FUSE_NO_OPEN_SUPPORT;
 #endif
 #ifdef FUSE_NO_OPENDIR_SUPPORT
@@ -1507,7 +1771,7 @@ void FuseChannel::readInitPacket() {
              << ", want=" << capsFlagsToLabel(want);
 
   if (init.init.major != FUSE_KERNEL_VERSION) {
-    replyError(init.header, EPROTO);
+    replyError(fuseDevice_.fd(), init.header, EPROTO);
     throw_<std::runtime_error>(
         "Unsupported FUSE kernel version ",
         init.init.major,
@@ -1532,12 +1796,13 @@ void FuseChannel::readInitPacket() {
       FUSE_KERNEL_MINOR_VERSION > 22,
       "Your kernel headers are too old to build Eden.");
   if (init.init.minor > 22) {
-    sendReply(init.header, connInfo);
+    sendReply(fuseDevice_.fd(), init.header, connInfo);
   } else {
     // If the protocol version predates the expansion of fuse_init_out, only
     // send the start of the packet.
     static_assert(FUSE_COMPAT_22_INIT_OUT_SIZE <= sizeof(connInfo));
     sendReply(
+        fuseDevice_.fd(),
         init.header,
         ByteRange{
             reinterpret_cast<const uint8_t*>(&connInfo),
@@ -1548,14 +1813,17 @@ void FuseChannel::readInitPacket() {
       FUSE_KERNEL_MINOR_VERSION == 19,
       "osxfuse: API/ABI likely changed, may need something like the"
       " linux code above to send the correct response to the kernel");
-  sendReply(init.header, connInfo);
+  sendReply(fuseDevice_.fd(), init.header, connInfo);
 #endif
 
   dispatcher_->initConnection(connInfo);
 }
 
-void FuseChannel::processSession() {
-  std::vector<char> buf(bufferSize_);
+void FuseChannel::processSession(int fuseDevice) {
+  // After a takeover, max_write is the one negotiated by the previous process,
+  // which may have been configured with a larger one.
+  std::vector<char> buf(
+      std::max(bufferSize_, connInfo_->max_write + kWriteHeaderSize));
   // Save this for the sanity check later in the loop to avoid
   // additional syscalls on each loop iteration.
   auto myPid = getpid();
@@ -1563,7 +1831,13 @@ void FuseChannel::processSession() {
   while (!stop_.load(std::memory_order_relaxed)) {
     // TODO: FUSE_SPLICE_READ allows using splice(2) here if we enable it.
     // We can look at turning this on once the main plumbing is complete.
-    auto res = read(fuseDevice_.fd(), buf.data(), buf.size());
+    idleThreads_.fetch_add(1, std::memory_order_acq_rel);
+    auto res = read(fuseDevice, buf.data(), buf.size());
+    if (idleThreads_.fetch_sub(1, std::memory_order_acq_rel) == 1 && res > 0) {
+      // Every other worker thread is busy: start one more, if allowed, so
+      // that the next request doesn't have to wait for one of them.
+      startExtraWorkerThread();
+    }
     if (UNLIKELY(res < 0)) {
       int error = errno;
       if (stop_.load(std::memory_order_relaxed)) {
@@ -1649,7 +1923,7 @@ void FuseChannel::processSession() {
       bool matched = false;
       for (auto fastTrack : kFastTracks) {
         if (namePiece == fastTrack) {
-          replyError(*header, ENODATA);
+          replyError(fuseDevice, *header, ENODATA);
           matched = true;
           break;
         }
@@ -1668,7 +1942,7 @@ void FuseChannel::processSession() {
     // to resolve this deadlock on kernel inode locks without rebooting the
     // system.
     if (UNLIKELY(static_cast<pid_t>(header->pid) == myPid)) {
-      replyError(*header, EIO);
+      replyError(fuseDevice, *header, EIO);
       XLOG(CRITICAL) << "Received FUSE request from our own pid: opcode="
                      << header->opcode << " nodeid=" << header->nodeid
                      << " pid=" << header->pid;
@@ -1682,7 +1956,7 @@ void FuseChannel::processSession() {
 
     switch (header->opcode) {
       case FUSE_INIT:
-        replyError(*header, EPROTO);
+        replyError(fuseDevice, *header, EPROTO);
         throw std::runtime_error(
             "received FUSE_INIT after we have been initialized!?");
 
@@ -1692,7 +1966,7 @@ void FuseChannel::processSession() {
         // Deliberately not handling locking; this causes
         // the kernel to do it for us
         XLOG(DBG7) << fuseOpcodeName(header->opcode);
-        replyError(*header, ENOSYS);
+        replyError(fuseDevice, *header, ENOSYS);
         break;
 
 #ifdef __linux__
@@ -1701,23 +1975,43 @@ void FuseChannel::processSession() {
         // for us.  Returning ENOSYS causes the kernel to implement it for us,
         // and will cause it to stop sending subsequent FUSE_LSEEK requests.
         XLOG(DBG7) << "FUSE_LSEEK";
-        replyError(*header, ENOSYS);
+        replyError(fuseDevice, *header, ENOSYS);
         break;
 #endif
 
       case FUSE_POLL:
         // We do not currently implement FUSE_POLL.
         XLOG(DBG7) << "FUSE_POLL";
-        replyError(*header, ENOSYS);
+        replyError(fuseDevice, *header, ENOSYS);
         break;
 
       case FUSE_INTERRUPT: {
         // no reply is required
         XLOG(DBG7) << "FUSE_INTERRUPT";
-        // Ignore it: we don't have a reliable way to guarantee
-        // that interrupting functions correctly.
-        // In addition, the kernel (certainly on macOS) may recycle
-        // ids too quickly for us to safely track by `unique` id.
+#ifdef __linux__
+        // The request keeps running, as we don't have a reliable way to
+        // interrupt it, but the imports it's waiting for can be dropped from
+        // the queues. The interrupt may be read before the request is
+        // registered, in which case it's ignored.
+        if (arg.size() >= sizeof(fuse_interrupt_in)) {
+          const auto* interrupt =
+              reinterpret_cast<const fuse_interrupt_in*>(arg.data());
+          std::shared_ptr<FuseRequestContext> interrupted;
+          {
+            auto state = state_.rlock();
+            auto it = state->interruptibleRequests.find(interrupt->unique);
+            if (it != state->interruptibleRequests.end()) {
+              interrupted = it->second.lock();
+            }
+          }
+          if (interrupted) {
+            interrupted->getFsObjectFetchContext().cancel();
+          }
+        }
+#else
+        // Ignore it: the kernel (certainly on macOS) may recycle ids too
+        // quickly for us to safely track by `unique` id.
+#endif
         break;
       }
 
@@ -1729,7 +2023,7 @@ void FuseChannel::processSession() {
         // we have responded, which in turn blocks our attempt to gracefully
         // unmount, so we respond here.  It doesn't hurt Linux to respond
         // so we do it for both platforms.
-        replyError(*header, 0);
+        replyError(fuseDevice, *header, 0);
         break;
 
       case FUSE_NOTIFY_REPLY:
@@ -1742,7 +2036,7 @@ void FuseChannel::processSession() {
       case FUSE_IOCTL:
         // Rather than the default ENOSYS, we need to return ENOTTY
         // to indicate that the requested ioctl is not supported
-        replyError(*header, ENOTTY);
+        replyError(fuseDevice, *header, ENOTTY);
         break;
 
       default: {
@@ -1759,9 +2053,19 @@ void FuseChannel::processSession() {
           // This is a shared_ptr because, due to timeouts, the internal request
           // lifetime may not match the FUSE request lifetime, so we capture it
           // in both. I'm sure this could be improved with some cleverness.
-          auto request = std::make_shared<FuseRequestContext>(this, *header);
-
-          ++state_.wlock()->pendingRequests;
+          auto request = std::make_shared<FuseRequestContext>(
+              this, *header, fuseDevice);
+          request->getFsObjectFetchContext().setDeadline(
+              std::chrono::steady_clock::now() + requestTimeout_);
+          request->getFsObjectFetchContext().setRequestId(requestId);
+
+          {
+            auto state = state_.wlock();
+            ++state->pendingRequests;
+#ifdef __linux__
+            state->interruptibleRequests.emplace(header->unique, request);
+#endif
+          }
 
           auto headerCopy = *header;
 
@@ -1796,13 +2100,20 @@ void FuseChannel::processSession() {
                 traceBus_->publish(FuseTraceEvent::finish(
                     requestId, headerCopy, request->getResult()));
 
+                // The kernel has its reply, possibly a timeout: imports that
+                // are still queued on behalf of this request may be dropped.
+                request->getFsObjectFetchContext().cancel();
+
                 // We may be complete; check to see if all requests are
                 // done and whether there are any threads remaining.
                 auto state = state_.wlock();
+#ifdef __linux__
+                state->interruptibleRequests.erase(headerCopy.unique);
+#endif
                 XCHECK_NE(state->pendingRequests, 0u)
                     << "pendingRequests double decrement";
-                if (--state->pendingRequests == 0 &&
-                    state->stoppedThreads == numThreads_) {
+                if (--state->pendingRequests == 0 && state->numThreads != 0 &&
+                    state->stoppedThreads == state->numThreads) {
                   sessionComplete(std::move(state));
                 }
               });
@@ -1826,7 +2137,7 @@ void FuseChannel::processSession() {
             });
 
         try {
-          replyError(*header, ENOSYS);
+          replyError(fuseDevice, *header, ENOSYS);
         } catch (const std::system_error& exc) {
           XLOG(ERR) << "Failed to write error response to fuse: " << exc.what();
           requestSessionExit(StopReason::FUSE_WRITE_ERROR);
@@ -1851,14 +2162,18 @@ void FuseChannel::sessionComplete(folly::Synchronized<State>::LockedPtr state) {
     data->fuseDevice = std::move(fuseDevice_);
     data->fuseSettings = connInfo_.value();
   }
+  // The kernel keeps the connection for as long as fuseDevice_ is open, even
+  // once its clones are closed.
+  state->clonedDevices.clear();
 
   // Unlock the state before the remaining steps
   state.unlock();
 
-  // Stop the invalidation thread.  We do not do this when requestSessionExit()
-  // is called since we want to continue to allow invalidation requests to be
-  // processed until all outstanding requests complete.
-  stopInvalidationThread();
+  // Stop the invalidation threads.  We do not do this when
+  // requestSessionExit() is called since we want to continue to allow
+  // invalidation requests to be processed until all outstanding requests
+  // complete.
+  stopInvalidationThreads();
 
   // Fulfill sessionCompletePromise
   sessionCompletePromise_.setValue(std::move(data));
@@ -2332,6 +2647,26 @@ ImmediateFuture<folly::Unit> FuseChannel::fuseReadDir(
       });
 }
 
+ImmediateFuture<folly::Unit> FuseChannel::fuseReadDirPlus(
+    FuseRequestContext& request,
+    const fuse_in_header& header,
+    ByteRange arg) {
+  auto read = reinterpret_cast<const fuse_read_in*>(arg.data());
+  XLOG(DBG7) << "FUSE_READDIRPLUS";
+  auto ino = InodeNumber{header.nodeid};
+  return dispatcher_
+      ->readdirplus(
+          ino,
+          FuseDirList{read->size, /*plus=*/true},
+          read->offset,
+          read->fh,
+          request.getObjectFetchContext())
+      .thenValue([&request](FuseDirList&& list) {
+        const auto buf = list.getBuf();
+        request.sendReply(StringPiece{buf});
+      });
+}
+
 ImmediateFuture<folly::Unit> FuseChannel::fuseReleaseDir(
     FuseRequestContext& request,
     const fuse_in_header& header,
@@ -2429,10 +2764,13 @@ ImmediateFuture<folly::Unit> FuseChannel::fuseBatchForget(
   const auto end = item + forgets->count;
   XLOG(DBG7) << "FUSE_BATCH_FORGET";
 
+  std::vector<std::pair<InodeNumber, uint32_t>> batch;
+  batch.reserve(forgets->count);
   while (item != end) {
-    dispatcher_->forget(InodeNumber{item->nodeid}, item->nlookup);
+    batch.emplace_back(InodeNumber{item->nodeid}, item->nlookup);
     ++item;
   }
+  dispatcher_->batchForget(batch);
   request.replyNone();
   return folly::unit;
 }
@@ -14,6 +14,7 @@
 #include <folly/futures/Promise.h>
 #include <folly/synchronization/CallOnce.h>
 #include <stdlib.h>
+#include <atomic>
 #include <condition_variable>
 #include <iosfwd>
 #include <memory>
@@ -224,6 +225,17 @@ class FuseChannel final : public FsChannel {
     std::chrono::steady_clock::time_point requestStartTime;
   };
 
+  struct CompletedRequest {
+    uint64_t unique;
+    FuseTraceEvent::RequestHeader request;
+    std::chrono::nanoseconds duration;
+    /**
+     * The response code sent to the kernel, if any. See
+     * FuseTraceEvent::getResponseCode().
+     */
+    std::optional<int64_t> result;
+  };
+
   /**
    * Construct the fuse channel and session structures that are
    * required by libfuse to communicate with the kernel using
@@ -250,6 +262,11 @@ class FuseChannel final : public FsChannel {
       bool requireUtf8Path,
       int32_t maximumBackgroundRequests,
       bool useWriteBackCache,
+      size_t maxWrite,
+      bool cloneDevicePerThread,
+      bool useReaddirplus,
+      size_t numInvalidationThreads,
+      size_t initialThreads,
       size_t fuseTraceBusCapacity);
 
   FuseChannel(const FuseChannel&) = delete;
@@ -385,6 +402,32 @@ class FuseChannel final : public FsChannel {
    */
   FOLLY_NODISCARD ImmediateFuture<folly::Unit> completeInvalidations() override;
 
+  /**
+   * Running totals of the invalidation requests handled by this channel.
+   *
+   * When an invalidation thread picks up several queued invalidations at
+   * once, the ones made redundant by another in the same batch are coalesced
+   * into it rather than sent to the kernel: repeated invalidations of the same
+   * directory entry, and invalidations of an inode that is also fully
+   * invalidated. Invalidations are never coalesced across a
+   * completeInvalidations() call.
+   */
+  struct InvalidationCounts {
+    uint64_t sent{0};
+    uint64_t coalesced{0};
+  };
+  InvalidationCounts getInvalidationCounts() const {
+    return InvalidationCounts{
+        invalidationsSent_.load(std::memory_order_relaxed),
+        invalidationsCoalesced_.load(std::memory_order_relaxed)};
+  }
+
+  /**
+   * The methods below write replies to fuseDevice, which must be the FUSE
+   * device the request was read from, as the kernel only matches replies with
+   * the requests read from the same device.
+   */
+
   /**
    * Sends a reply to a kernel request that consists only of the error
    * status (no additional payload).
@@ -393,7 +436,7 @@ class FuseChannel final : public FsChannel {
    * throws system_error if the write fails.  Writes can fail if the
    * data we send to the kernel is invalid.
    */
-  void replyError(const fuse_in_header& request, int err);
+  void replyError(int fuseDevice, const fuse_in_header& request, int err);
 
   /**
    * Sends a raw data packet to the kernel.
@@ -406,7 +449,7 @@ class FuseChannel final : public FsChannel {
    * throws system_error if the write fails.  Writes can fail if the
    * data we send to the kernel is invalid.
    */
-  void sendRawReply(const iovec iov[], size_t count) const;
+  void sendRawReply(int fuseDevice, const iovec iov[], size_t count) const;
 
   /**
    * Sends a range of contiguous bytes as a reply to the kernel.
@@ -417,11 +460,16 @@ class FuseChannel final : public FsChannel {
    * throws system_error if the write fails.  Writes can fail if the
    * data we send to the kernel is invalid.
    */
-  void sendReply(const fuse_in_header& request, folly::ByteRange bytes) const;
+  void sendReply(
+      int fuseDevice,
+      const fuse_in_header& request,
+      folly::ByteRange bytes) const;
 
-  void sendReply(const fuse_in_header& request, folly::StringPiece bytes)
-      const {
-    sendReply(request, folly::ByteRange{bytes});
+  void sendReply(
+      int fuseDevice,
+      const fuse_in_header& request,
+      folly::StringPiece bytes) const {
+    sendReply(fuseDevice, request, folly::ByteRange{bytes});
   }
 
   /**
@@ -433,8 +481,10 @@ class FuseChannel final : public FsChannel {
    * throws system_error if the write fails.  Writes can fail if the
    * data we send to the kernel is invalid.
    */
-  void sendReply(const fuse_in_header& request, folly::fbvector<iovec>&& vec)
-      const;
+  void sendReply(
+      int fuseDevice,
+      const fuse_in_header& request,
+      folly::fbvector<iovec>&& vec) const;
 
   /**
    * Sends a reply to a kernel request potentially consisting of multiple
@@ -443,7 +493,10 @@ class FuseChannel final : public FsChannel {
    * throws system_error if the write fails.  Writes can fail if the
    * data we send to the kernel is invalid.
    */
-  void sendReply(const fuse_in_header& request, const folly::IOBuf& buf) const;
+  void sendReply(
+      int fuseDevice,
+      const fuse_in_header& request,
+      const folly::IOBuf& buf) const;
 
   /**
    * Sends a reply to the kernel.
@@ -454,10 +507,14 @@ class FuseChannel final : public FsChannel {
    * data we send to the kernel is invalid.
    */
   template <typename T>
-  void sendReply(const fuse_in_header& request, const T& payload) const {
+  void sendReply(
+      int fuseDevice,
+      const fuse_in_header& request,
+      const T& payload) const {
     static_assert(std::is_standard_layout_v<T>);
     static_assert(std::is_trivial_v<T>);
     sendReply(
+        fuseDevice,
         request,
         folly::ByteRange{
             reinterpret_cast<const uint8_t*>(&payload), sizeof(T)});
@@ -473,6 +530,16 @@ class FuseChannel final : public FsChannel {
    */
   std::vector<FuseChannel::OutstandingRequest> getOutstandingRequests();
 
+  /**
+   * Returns the slowest FUSE requests that completed since the channel was
+   * started, from the slowest to the fastest. Like getOutstandingRequests(),
+   * this may very slightly lag reality.
+   *
+   * The latency distribution of each opcode is reported by the fuse.*_us
+   * stats; this is meant to find out what the outliers were.
+   */
+  std::vector<FuseChannel::CompletedRequest> getSlowestRequests();
+
   /**
    * While the returned handle is alive, FuseTraceEvents published on the
    * TraceBus will have detailed argument strings.
@@ -505,12 +572,28 @@ class FuseChannel final : public FsChannel {
   struct State {
     std::vector<std::thread> workerThreads;
 
+    /**
+     * The clones of fuseDevice_ the worker threads read from, if
+     * cloneDevicePerThread_ is set. They are closed once the session is
+     * complete, when no reply can be pending.
+     */
+    std::vector<folly::File> clonedDevices;
+
     /**
      * We count live requests to avoid shutting down the session while responses
      * are pending.
      */
     size_t pendingRequests{0};
 
+#ifdef __linux__
+    /**
+     * The live requests by FUSE unique id, so that FUSE_INTERRUPT can cancel
+     * their fetches. Linux never reuses unique ids.
+     */
+    std::unordered_map<uint64_t, std::weak_ptr<FuseRequestContext>>
+        interruptibleRequests;
+#endif
+
     /**
      * We track the number of stopped threads, to know when we are done and can
      * signal sessionCompletePromise_.  We only want to signal
@@ -524,6 +607,13 @@ class FuseChannel final : public FsChannel {
      */
     size_t stoppedThreads{0};
 
+    /**
+     * The number of worker threads that must stop before
+     * sessionCompletePromise_ is signalled. Zero until all the initial worker
+     * threads were successfully started.
+     */
+    size_t numThreads{0};
+
     /**
      * If destroyPending is true, the FuseChannel object should be
      * automatically destroyed when the last outstanding request finishes.
@@ -543,6 +633,11 @@ class FuseChannel final : public FsChannel {
    */
   struct TelemetryState {
     std::unordered_map<uint64_t, OutstandingRequest> requests;
+    /**
+     * The slowest completed requests, as a min-heap on duration so the
+     * fastest of them is the one replaced when a slower request completes.
+     */
+    std::vector<CompletedRequest> slowestRequests;
   };
 
   struct DataRange {
@@ -578,6 +673,14 @@ class FuseChannel final : public FsChannel {
     std::vector<InvalidationEntry> queue;
     bool stop{false};
   };
+  /**
+   * A queue of invalidations and the thread sending them to the kernel.
+   */
+  struct InvalidationShard {
+    folly::Synchronized<InvalidationQueue, std::mutex> queue;
+    std::condition_variable cv;
+    std::thread thread;
+  };
   friend std::ostream& operator<<(
       std::ostream& os,
       const InvalidationEntry& entry);
@@ -695,6 +798,10 @@ class FuseChannel final : public FsChannel {
       FuseRequestContext& request,
       const fuse_in_header& header,
       folly::ByteRange arg);
+  ImmediateFuture<folly::Unit> fuseReadDirPlus(
+      FuseRequestContext& request,
+      const fuse_in_header& header,
+      folly::ByteRange arg);
   ImmediateFuture<folly::Unit> fuseReleaseDir(
       FuseRequestContext& request,
       const fuse_in_header& header,
@@ -727,14 +834,26 @@ class FuseChannel final : public FsChannel {
  private:
   void setThreadSigmask();
   void initWorkerThread() noexcept;
-  void fuseWorkerThread() noexcept;
-  void invalidationThread() noexcept;
-  void stopInvalidationThread();
+  void fuseWorkerThread(int fuseDevice) noexcept;
+  InvalidationShard& getInvalidationShard(InodeNumber ino);
+  void invalidationThread(InvalidationShard& shard) noexcept;
+  void stopInvalidationThreads();
+  void coalesceInvalidations(std::vector<InvalidationEntry>& entries);
   void sendInvalidation(InvalidationEntry& entry);
   void sendInvalidateInode(InodeNumber ino, int64_t off, int64_t len);
   void sendInvalidateEntry(InodeNumber parent, PathComponentPiece name);
   void readInitPacket();
   void startWorkerThreads();
+  void startWorkerThread(
+      const folly::Synchronized<State>::LockedPtr& state,
+      bool& cloneDevice);
+  void startExtraWorkerThread();
+
+  /**
+   * Open a clone of fuseDevice_ with FUSE_DEV_IOC_CLONE, so that a worker
+   * thread reads requests and writes replies through its own device.
+   */
+  folly::File cloneFuseDevice() const;
 
   /**
    * sessionComplete() will fulfill the sessionCompletePromise_.
@@ -745,6 +864,10 @@ class FuseChannel final : public FsChannel {
    */
   void sessionComplete(folly::Synchronized<State>::LockedPtr state);
 
+  static void recordCompletedRequest(
+      TelemetryState& state,
+      CompletedRequest request);
+
   static bool isFuseDeviceValid(StopReason reason) {
     // The FuseDevice may still be used if the FuseChannel was stopped due to a
     // takeover request or because the FuseChannel object was destroyed without
@@ -761,9 +884,10 @@ class FuseChannel final : public FsChannel {
    * Dispatches fuse requests until the session is torn down.
    * This function blocks until the fuse session is stopped.
    * The intent is that this is called from each of the
-   * fuse worker threads provided by the MountPoint.
+   * fuse worker threads provided by the MountPoint, with the FUSE device the
+   * thread reads requests from.
    */
-  void processSession();
+  void processSession(int fuseDevice);
 
   /**
    * Requests that the worker threads terminate their processing loop.
@@ -779,7 +903,11 @@ class FuseChannel final : public FsChannel {
    * Constant state that does not change for the lifetime of the FuseChannel
    */
   const size_t bufferSize_{0};
+  // The maximum number of worker threads.
   const size_t numThreads_;
+  // The number of worker threads started with the channel. More are started,
+  // up to numThreads_, when all of them are busy.
+  const size_t initialThreads_;
   std::unique_ptr<FuseDispatcher> dispatcher_;
   const folly::Logger* const straceLogger_;
   const AbsolutePath mountPath_;
@@ -789,6 +917,8 @@ class FuseChannel final : public FsChannel {
   bool requireUtf8Path_;
   int32_t maximumBackgroundRequests_;
   bool useWriteBackCache_;
+  bool cloneDevicePerThread_;
+  bool useReaddirplus_;
 
   /*
    * connInfo_ is modified during the initialization process,
@@ -819,6 +949,8 @@ class FuseChannel final : public FsChannel {
    * All of this state uses locking or other synchronization.
    */
   std::atomic<bool> stop_{false};
+  // The number of worker threads waiting for a request from the kernel.
+  std::atomic<size_t> idleThreads_{0};
   folly::once_flag unmountLogFlag_;
   folly::Synchronized<State> state_;
   folly::Promise<StopFuture> initPromise_;
@@ -830,10 +962,13 @@ class FuseChannel final : public FsChannel {
   folly::Synchronized<std::unordered_set<FuseOpcode>> unhandledOpcodes_;
 
   // State for sending inode invalidation requests to the kernel
-  // These are processed in their own dedicated thread.
-  folly::Synchronized<InvalidationQueue, std::mutex> invalidationQueue_;
-  std::condition_variable invalidationCV_;
-  std::thread invalidationThread_;
+  // These are processed in their own dedicated threads. The invalidations of
+  // an inode and of the entries of a directory always go to the same shard,
+  // so they are sent in the order they were requested; invalidations of
+  // unrelated inodes may be sent concurrently.
+  std::vector<InvalidationShard> invalidationShards_;
+  std::atomic<uint64_t> invalidationsSent_{0};
+  std::atomic<uint64_t> invalidationsCoalesced_{0};
 
   ProcessAccessLog processAccessLog_;
 
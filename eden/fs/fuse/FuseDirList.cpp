@@ -16,18 +16,27 @@ using folly::StringPiece;
 
 namespace facebook::eden {
 
-FuseDirList::FuseDirList(size_t maxSize)
-    : buf_(new char[maxSize]), end_(buf_.get() + maxSize), cur_(buf_.get()) {}
+FuseDirList::FuseDirList(size_t maxSize, bool plus)
+    : buf_(new char[maxSize]),
+      end_(buf_.get() + maxSize),
+      cur_(buf_.get()),
+      plus_(plus) {}
 
 bool FuseDirList::add(StringPiece name, ino_t inode, dtype_t type, off_t off) {
   const size_t avail = end_ - cur_;
-  const auto entLength = FUSE_NAME_OFFSET + name.size();
+  const size_t entryParamSize = plus_ ? sizeof(fuse_entry_out) : 0;
+  const auto entLength = entryParamSize + FUSE_NAME_OFFSET + name.size();
   const auto fullSize = FUSE_DIRENT_ALIGN(entLength);
   if (fullSize > avail) {
     return false;
   }
 
-  fuse_dirent* const dirent = reinterpret_cast<fuse_dirent*>(cur_);
+  if (plus_) {
+    plusOffsets_.push_back(cur_ - buf_.get());
+    memset(cur_, 0, entryParamSize);
+  }
+  fuse_dirent* const dirent =
+      reinterpret_cast<fuse_dirent*>(cur_ + entryParamSize);
   dirent->ino = inode;
   dirent->off = off;
   dirent->namelen = name.size();
@@ -43,6 +52,11 @@ bool FuseDirList::add(StringPiece name, ino_t inode, dtype_t type, off_t off) {
   return true;
 }
 
+void FuseDirList::setEntryParam(size_t index, const fuse_entry_out& entry) {
+  XCHECK(plus_) << "entry parameters are only sent by FUSE_READDIRPLUS";
+  memcpy(buf_.get() + plusOffsets_.at(index), &entry, sizeof(entry));
+}
+
 StringPiece FuseDirList::getBuf() const {
   return StringPiece(buf_.get(), cur_ - buf_.get());
 }
@@ -50,16 +64,17 @@ StringPiece FuseDirList::getBuf() const {
 std::vector<FuseDirList::ExtractedEntry> FuseDirList::extract() const {
   std::vector<FuseDirList::ExtractedEntry> result;
 
+  const size_t entryParamSize = plus_ ? sizeof(fuse_entry_out) : 0;
   char* p = buf_.get();
   while (p != cur_) {
-    auto entry = reinterpret_cast<fuse_dirent*>(p);
+    auto entry = reinterpret_cast<fuse_dirent*>(p + entryParamSize);
     result.emplace_back(ExtractedEntry{
         std::string{entry->name, entry->name + entry->namelen},
         entry->ino,
         static_cast<dtype_t>(entry->type),
         static_cast<off_t>(entry->off)});
 
-    p += FUSE_DIRENT_ALIGN(FUSE_NAME_OFFSET + entry->namelen);
+    p += FUSE_DIRENT_ALIGN(entryParamSize + FUSE_NAME_OFFSET + entry->namelen);
   }
   return result;
 }
@@ -9,7 +9,9 @@
 #include <folly/Range.h>
 #include <sys/stat.h>
 #include <memory>
+#include <vector>
 #include "eden/fs/utils/DirType.h"
+#include "eden/fs/utils/FsChannelTypes.h"
 
 namespace facebook::eden {
 
@@ -20,6 +22,9 @@ class FuseDirList {
   std::unique_ptr<char[]> buf_;
   char* end_;
   char* cur_;
+  bool plus_;
+  // Offsets in buf_ of the entries of a FUSE_READDIRPLUS list.
+  std::vector<size_t> plusOffsets_;
 
  public:
   struct ExtractedEntry {
@@ -29,7 +34,13 @@ class FuseDirList {
     off_t offset;
   };
 
-  explicit FuseDirList(size_t maxSize);
+  /**
+   * A list for FUSE_READDIRPLUS, if plus is set, holds an entry parameter
+   * before each dirent. It is zeroed by add(), meaning that the kernel should
+   * not create a dentry for the entry, and can be filled in with
+   * setEntryParam().
+   */
+  explicit FuseDirList(size_t maxSize, bool plus = false);
 
   FuseDirList(const FuseDirList&) = delete;
   FuseDirList& operator=(const FuseDirList&) = delete;
@@ -42,6 +53,16 @@ class FuseDirList {
    */
   bool add(folly::StringPiece name, ino_t inode, dtype_t type, off_t off);
 
+  bool isPlus() const {
+    return plus_;
+  }
+
+  /**
+   * Set the entry parameter of the index-th entry of a FUSE_READDIRPLUS list.
+   * The kernel takes a reference on entry.nodeid, as for a lookup.
+   */
+  void setEntryParam(size_t index, const fuse_entry_out& entry);
+
   folly::StringPiece getBuf() const;
 
   /**
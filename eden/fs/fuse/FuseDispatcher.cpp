@@ -74,6 +74,13 @@ ImmediateFuture<fuse_entry_out> FuseDispatcher::lookup(
 
 void FuseDispatcher::forget(InodeNumber /*ino*/, unsigned long /*nlookup*/) {}
 
+void FuseDispatcher::batchForget(
+    folly::Range<const std::pair<InodeNumber, uint32_t>*> forgets) {
+  for (const auto& [ino, nlookup] : forgets) {
+    forget(ino, nlookup);
+  }
+}
+
 ImmediateFuture<FuseDispatcher::Attr> FuseDispatcher::getattr(
     InodeNumber /*ino*/,
     const ObjectFetchContextPtr& /*context*/) {
@@ -217,6 +224,15 @@ ImmediateFuture<FuseDirList> FuseDispatcher::readdir(
   FUSELL_NOT_IMPL();
 }
 
+ImmediateFuture<FuseDirList> FuseDispatcher::readdirplus(
+    InodeNumber,
+    FuseDirList&&,
+    off_t,
+    uint64_t,
+    const ObjectFetchContextPtr&) {
+  FUSELL_NOT_IMPL();
+}
+
 ImmediateFuture<struct fuse_kstatfs> FuseDispatcher::statfs(
     InodeNumber /*ino*/) {
   struct fuse_kstatfs info = {};
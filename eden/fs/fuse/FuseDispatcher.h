@@ -9,6 +9,7 @@
 
 #include <folly/Portability.h>
 #include <folly/Range.h>
+#include <utility>
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/store/IObjectStore.h"
 #include "eden/fs/utils/BufVec.h"
@@ -93,6 +94,14 @@ class FuseDispatcher {
    */
   virtual void forget(InodeNumber ino, unsigned long nlookup);
 
+  /**
+   * Forget about several inodes at once, as for FUSE_BATCH_FORGET.
+   *
+   * The default implementation calls forget() for each (ino, nlookup) pair.
+   */
+  virtual void batchForget(
+      folly::Range<const std::pair<InodeNumber, uint32_t>*> forgets);
+
   /**
    * The stat information and the cache TTL for the kernel
    *
@@ -397,6 +406,20 @@ class FuseDispatcher {
       uint64_t fh,
       const ObjectFetchContextPtr& context);
 
+  /**
+   * Read directory, with the attributes of its entries.
+   *
+   * Like readdir, but dirList is a FUSE_READDIRPLUS list: the entry parameter
+   * of each entry may be filled with FuseDirList::setEntryParam(), which
+   * counts as a lookup of the entry.
+   */
+  virtual ImmediateFuture<FuseDirList> readdirplus(
+      InodeNumber ino,
+      FuseDirList&& dirList,
+      off_t offset,
+      uint64_t fh,
+      const ObjectFetchContextPtr& context);
+
   /**
    * Get file system statistics
    *
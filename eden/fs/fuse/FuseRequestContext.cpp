@@ -21,14 +21,16 @@ namespace facebook::eden {
 
 FuseRequestContext::FuseRequestContext(
     FuseChannel* channel,
-    const fuse_in_header& fuseHeader)
+    const fuse_in_header& fuseHeader,
+    int fuseDevice)
     : RequestContext(
           channel->getProcessAccessLog(),
           makeRefPtr<FuseObjectFetchContext>(
               ProcessId{fuseHeader.pid},
               fuseHeader.opcode)),
       channel_(channel),
-      fuseHeader_(fuseHeader) {}
+      fuseHeader_(fuseHeader),
+      fuseDevice_(fuseDevice) {}
 
 fuse_in_header FuseRequestContext::stealReqWithResult(int64_t result) {
   if (result_.has_value()) {
@@ -82,7 +84,7 @@ void FuseRequestContext::timeoutErrorHandler(
 
 void FuseRequestContext::replyError(int err) {
   XCHECK(err >= 0) << "errno values are positive";
-  channel_->replyError(stealReqWithResult(-err), err);
+  channel_->replyError(fuseDevice_, stealReqWithResult(-err), err);
 }
 
 void FuseRequestContext::replyNone() {
@@ -49,9 +49,14 @@ class FuseObjectFetchContext : public FsObjectFetchContext {
  */
 class FuseRequestContext : public RequestContext {
  public:
-  explicit FuseRequestContext(
+  /**
+   * fuseDevice is the FUSE device the request was read from, which the reply
+   * is written to.
+   */
+  FuseRequestContext(
       FuseChannel* channel,
-      const fuse_in_header& fuseHeader);
+      const fuse_in_header& fuseHeader,
+      int fuseDevice);
 
   FuseRequestContext(const FuseRequestContext&) = delete;
   FuseRequestContext& operator=(const FuseRequestContext&) = delete;
@@ -87,6 +92,10 @@ class FuseRequestContext : public RequestContext {
       if (try_.hasException()) {
         if (auto* err = try_.tryGetExceptionObject<folly::FutureTimeout>()) {
           timeoutErrorHandler(*err, notifier);
+        } else if (try_.hasException<folly::OperationCancelled>()) {
+          // An import this request was waiting for was dropped because the
+          // request was interrupted.
+          replyError(EINTR);
         } else if (
             auto* err = try_.tryGetExceptionObject<std::system_error>()) {
           systemErrorHandler(*err, notifier);
@@ -112,7 +121,8 @@ class FuseRequestContext : public RequestContext {
 
   template <typename... T>
   void sendReply(T&&... payload) {
-    channel_->sendReply(stealReqWithResult(0), std::forward<T>(payload)...);
+    channel_->sendReply(
+        fuseDevice_, stealReqWithResult(0), std::forward<T>(payload)...);
   }
 
   /**
@@ -122,7 +132,8 @@ class FuseRequestContext : public RequestContext {
    */
   template <typename T>
   void sendReplyWithInode(uint64_t nodeid, T&& reply) {
-    channel_->sendReply(stealReqWithResult(nodeid), std::forward<T>(reply));
+    channel_->sendReply(
+        fuseDevice_, stealReqWithResult(nodeid), std::forward<T>(reply));
   }
 
   // Reply with a negative errno value or 0 for success
@@ -138,6 +149,7 @@ class FuseRequestContext : public RequestContext {
 
   FuseChannel* channel_;
   const fuse_in_header fuseHeader_;
+  const int fuseDevice_;
 
   std::optional<int64_t> result_;
 };
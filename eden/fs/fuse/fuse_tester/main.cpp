@@ -144,6 +144,11 @@ int main(int argc, char** argv) {
       /*requireUtf8Path=*/true,
       /*maximumBackgroundRequests=*/12 /* the default on Linux */,
       /*useWriteBackCache=*/false,
+      /*maxWrite=*/1024 * 1024,
+      /*cloneDevicePerThread=*/false,
+      /*useReaddirplus=*/false,
+      /*numInvalidationThreads=*/1,
+      /*initialThreads=*/0,
       /*fuseTraceBusCapacity=*/kTraceBusCapacity);
 
   XLOG(INFO) << "Starting FUSE...";
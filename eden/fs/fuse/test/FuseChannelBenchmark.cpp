@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/logging/Logger.h>
+#include <sys/stat.h>
+#include <array>
+#include <chrono>
+
+#include "eden/common/utils/ProcessNameCache.h"
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/fuse/FuseChannel.h"
+#include "eden/fs/fuse/FuseDispatcher.h"
+#include "eden/fs/telemetry/EdenStats.h"
+#include "eden/fs/testharness/FakeFuse.h"
+#include "eden/fs/utils/CaseSensitivity.h"
+
+/*
+ * Measures the request throughput of FuseChannel alone: requests are written
+ * to a FakeFuse device and answered by a dispatcher that replies immediately,
+ * so that only the decoding, scheduling and reply encoding are measured.
+ */
+
+namespace {
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+folly::Logger straceLogger{"eden.strace"};
+
+constexpr size_t kTraceBusCapacity = 25000;
+// Requests written before reading any response, enough to keep every channel
+// thread busy.
+constexpr size_t kPipelineDepth = 64;
+constexpr size_t kReadSize = 4096;
+constexpr InodeNumber kFileIno{2};
+constexpr char kFileName[] = "file";
+
+enum Op { kLookup, kGetattr, kRead };
+constexpr const char* kOpNames[] = {"lookup", "getattr", "read"};
+
+struct stat fileStat() {
+  struct stat st {};
+  st.st_ino = kFileIno.get();
+  st.st_mode = S_IFREG | 0644;
+  st.st_nlink = 1;
+  st.st_size = kReadSize;
+  return st;
+}
+
+/**
+ * Answers every lookup, getattr and read with the same regular file.
+ */
+class ImmediateDispatcher : public FuseDispatcher {
+ public:
+  using FuseDispatcher::FuseDispatcher;
+
+  ImmediateFuture<fuse_entry_out> lookup(
+      uint64_t /*requestID*/,
+      InodeNumber /*parent*/,
+      PathComponentPiece /*name*/,
+      const ObjectFetchContextPtr& /*context*/) override {
+    fuse_entry_out entry{};
+    entry.nodeid = kFileIno.get();
+    entry.attr = Attr{fileStat()}.asFuseAttr().attr;
+    return entry;
+  }
+
+  ImmediateFuture<Attr> getattr(
+      InodeNumber /*ino*/,
+      const ObjectFetchContextPtr& /*context*/) override {
+    return Attr{fileStat()};
+  }
+
+  ImmediateFuture<BufVec> read(
+      InodeNumber /*ino*/,
+      size_t size,
+      off_t /*off*/,
+      const ObjectFetchContextPtr& /*context*/) override {
+    return folly::IOBuf::wrapBuffer(data_.data(), std::min(size, kReadSize));
+  }
+
+ private:
+  std::array<char, kReadSize> data_{};
+};
+
+uint32_t sendRequest(FakeFuse& fuse, Op op) {
+  switch (op) {
+    case kLookup:
+      // The name must be sent with its terminating NUL.
+      return fuse.sendRequest(
+          FUSE_LOOKUP,
+          kRootNodeId.get(),
+          folly::ByteRange{
+              reinterpret_cast<const uint8_t*>(kFileName), sizeof(kFileName)});
+    case kGetattr:
+      return fuse.sendRequest(
+          FUSE_GETATTR, kFileIno.get(), fuse_getattr_in{});
+    case kRead: {
+      fuse_read_in read{};
+      read.size = kReadSize;
+      return fuse.sendRequest(FUSE_READ, kFileIno.get(), read);
+    }
+  }
+  return 0;
+}
+
+void fuseChannel(benchmark::State& state) {
+  auto op = static_cast<Op>(state.range(0));
+  auto threads = static_cast<size_t>(state.range(1));
+  state.SetLabel(kOpNames[op]);
+
+  FakeFuse fuse;
+  auto channel = makeFuseChannel(
+      nullptr,
+      fuse.start(),
+      canonicalPath("/fake/mount/path"),
+      threads,
+      std::make_unique<ImmediateDispatcher>(makeRefPtr<EdenStats>()),
+      &straceLogger,
+      std::make_shared<ProcessNameCache>(),
+      /*fsEventLogger=*/nullptr,
+      std::chrono::seconds(60),
+      /*notifications=*/nullptr,
+      CaseSensitivity::Sensitive,
+      /*requireUtf8Path=*/true,
+      /*maximumBackgroundRequests=*/12,
+      /*useWriteBackCache=*/false,
+      /*maxWrite=*/1024 * 1024,
+      /*cloneDevicePerThread=*/false,
+      /*useReaddirplus=*/false,
+      /*numInvalidationThreads=*/1,
+      /*initialThreads=*/0,
+      kTraceBusCapacity);
+
+  auto initFuture = channel->initialize();
+  fuse.sendInitRequest();
+  fuse.recvResponse();
+  auto stopFuture = std::move(initFuture).get(1s);
+
+  for (auto _ : state) {
+    for (size_t i = 0; i < kPipelineDepth; ++i) {
+      sendRequest(fuse, op);
+    }
+    for (size_t i = 0; i < kPipelineDepth; ++i) {
+      auto response = fuse.recvResponse();
+      if (response.header.error != 0) {
+        state.SkipWithError("FUSE request failed");
+        return;
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kPipelineDepth);
+}
+BENCHMARK(fuseChannel)
+    ->ArgNames({"op", "threads"})
+    ->ArgsProduct({{kLookup, kGetattr, kRead}, {1, 2, 4, 8}})
+    ->UseRealTime();
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
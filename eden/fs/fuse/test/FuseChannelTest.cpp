@@ -11,6 +11,7 @@
 #include <folly/logging/xlog.h>
 #include <folly/portability/GTest.h>
 #include <folly/test/TestUtils.h>
+#include <set>
 #include <unordered_map>
 #include "eden/common/utils/ProcessNameCache.h"
 #include "eden/fs/fuse/FuseDispatcher.h"
@@ -66,7 +67,8 @@ fuse_entry_out genRandomLookupResponse(uint64_t nodeid) {
 class FuseChannelTest : public ::testing::Test {
  protected:
   std::unique_ptr<FuseChannel, FsChannelDeleter> createChannel(
-      size_t numThreads = 2) {
+      size_t numThreads = 2,
+      size_t numInvalidationThreads = 1) {
     auto testDispatcher = std::make_unique<TestDispatcher>(stats_.copy());
     dispatcher_ = testDispatcher.get();
     return makeFuseChannel(
@@ -84,6 +86,11 @@ class FuseChannelTest : public ::testing::Test {
         /*requireUtf8Path=*/true,
         /*maximumBackgroundRequests=*/12,
         /*useWriteBackCache=*/false,
+        /*maxWrite=*/1024 * 1024,
+        /*cloneDevicePerThread=*/false,
+        /*useReaddirplus=*/false,
+        numInvalidationThreads,
+        /*initialThreads=*/0,
         /*fuseTraceBusCapacity*/ kTraceBusCapacity);
   }
 
@@ -365,10 +372,8 @@ TEST_F(FuseChannelTest, interruptLookups) {
 
     (void)fuse_.sendRequest(FUSE_INTERRUPT, FUSE_ROOT_ID, interruptData);
 
-    // For now FuseChannel never actually interrupts requests, so the
+    // FuseChannel only cancels the fetches of interrupted requests, so the
     // dispatcher will definitely receive the request.
-    // We may need to change this code in the future if we do add true
-    // interrupt support to FuseChannel.
     auto req = dispatcher_->waitForLookup(requestId);
 
     auto nodeId = 5 + i * 7;
@@ -379,3 +384,55 @@ TEST_F(FuseChannelTest, interruptLookups) {
     EXPECT_EQ(requestId, received.header.unique);
   }
 }
+
+TEST_F(FuseChannelTest, coalesceInvalidations) {
+  auto channel = createChannel();
+  auto completeFuture = performInit(channel.get());
+
+  // invalidateInodes() queues all of its inodes at once, so the invalidation
+  // thread processes them as a single batch.
+  std::vector<InodeNumber> inodes{
+      InodeNumber{5}, InodeNumber{6}, InodeNumber{5}, InodeNumber{5}};
+  channel->invalidateInodes(folly::range(inodes));
+  std::move(channel->completeInvalidations()).get(kTimeout);
+
+  auto counts = channel->getInvalidationCounts();
+  EXPECT_EQ(2, counts.sent);
+  EXPECT_EQ(2, counts.coalesced);
+
+  for (auto expectedIno : {5, 6}) {
+    auto response = fuse_.recvResponse();
+    EXPECT_EQ(0, response.header.unique);
+    EXPECT_EQ(FUSE_NOTIFY_INVAL_INODE, response.header.error);
+    ASSERT_EQ(sizeof(fuse_notify_inval_inode_out), response.body.size());
+    fuse_notify_inval_inode_out notify;
+    memcpy(&notify, response.body.data(), sizeof(notify));
+    EXPECT_EQ(expectedIno, notify.ino);
+  }
+}
+
+TEST_F(FuseChannelTest, shardedInvalidations) {
+  auto channel = createChannel(2, /*numInvalidationThreads=*/3);
+  auto completeFuture = performInit(channel.get());
+
+  std::vector<InodeNumber> inodes{
+      InodeNumber{5}, InodeNumber{6}, InodeNumber{7}, InodeNumber{8}};
+  channel->invalidateInodes(folly::range(inodes));
+  channel->invalidateInode(InodeNumber{9}, 0, 0);
+  // completeInvalidations() waits for every invalidation thread.
+  std::move(channel->completeInvalidations()).get(kTimeout);
+
+  EXPECT_EQ(5, channel->getInvalidationCounts().sent);
+
+  // Invalidations of different inodes may be sent in any order.
+  std::set<uint64_t> invalidated;
+  for (size_t i = 0; i < 5; ++i) {
+    auto response = fuse_.recvResponse();
+    EXPECT_EQ(FUSE_NOTIFY_INVAL_INODE, response.header.error);
+    ASSERT_EQ(sizeof(fuse_notify_inval_inode_out), response.body.size());
+    fuse_notify_inval_inode_out notify;
+    memcpy(&notify, response.body.data(), sizeof(notify));
+    invalidated.insert(notify.ino);
+  }
+  EXPECT_EQ((std::set<uint64_t>{5, 6, 7, 8, 9}), invalidated);
+}
@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/BufferedInodeCatalog.h"
+
+#include <folly/logging/xlog.h>
+#include <folly/system/ThreadName.h>
+
+namespace facebook::eden {
+
+namespace {
+
+/**
+ * A rough estimate of the memory used by a buffered directory, used to bound
+ * the size of the buffer.
+ */
+size_t estimateOverlayDirSize(const std::optional<overlay::OverlayDir>& odir) {
+  if (!odir) {
+    return 0;
+  }
+  size_t size = sizeof(overlay::OverlayDir);
+  for (const auto& [name, entry] : *odir->entries()) {
+    // Account for the node of the std::map as well.
+    size += sizeof(name) + sizeof(entry) + 4 * sizeof(void*);
+    size += name.size();
+    if (entry.hash_ref()) {
+      size += entry.hash_ref()->size();
+    }
+  }
+  return size;
+}
+
+} // namespace
+
+BufferedInodeCatalog::BufferedInodeCatalog(
+    std::unique_ptr<InodeCatalog> inner,
+    std::chrono::nanoseconds coalesceWindow,
+    size_t bufferSize)
+    : inner_{std::move(inner)},
+      coalesceWindow_{coalesceWindow},
+      bufferSize_{bufferSize} {
+  XCHECK(!inner_->supportsSemanticOperations())
+      << "BufferedInodeCatalog can't buffer semantic operations";
+  workerThread_ = std::thread{[this] {
+    folly::setThreadName("OverlayBuffer");
+    processOnWorkerThread();
+  }};
+}
+
+BufferedInodeCatalog::~BufferedInodeCatalog() {
+  stopWorkerThread();
+}
+
+void BufferedInodeCatalog::stopWorkerThread() {
+  {
+    auto state = state_.lock();
+    if (state->stopRequested) {
+      return;
+    }
+    state->stopRequested = true;
+    workCV_.notify_one();
+    flushedCV_.notify_all();
+  }
+
+  // The worker thread writes everything that is still buffered before
+  // exiting.
+  workerThread_.join();
+}
+
+void BufferedInodeCatalog::processOnWorkerThread() {
+  for (;;) {
+    {
+      auto state = state_.lock();
+      state->inflight.clear();
+
+      auto shouldWriteNow = [&] {
+        return state->stopRequested || state->flushWaiters > 0 ||
+            state->pendingSize >= bufferSize_;
+      };
+      workCV_.wait(state.as_lock(), [&] {
+        return !state->pending.empty() || state->stopRequested;
+      });
+      if (!state->pending.empty()) {
+        // Give the directories more time to change before writing them, so
+        // that a burst of changes to a directory only writes it once.
+        workCV_.wait_until(
+            state.as_lock(),
+            state->oldestPendingWrite + coalesceWindow_,
+            shouldWriteNow);
+      }
+      if (state->pending.empty()) {
+        XCHECK(state->stopRequested);
+        state->workerExited = true;
+        flushedCV_.notify_all();
+        return;
+      }
+
+      state->inflight.swap(state->pending);
+      state->pendingSize = 0;
+      // Writers may be waiting for room in the buffer.
+      flushedCV_.notify_all();
+    }
+
+    // inflight is only modified by this thread, so it can be read without
+    // the lock. The directories are copied since other threads may read them
+    // concurrently.
+    const auto& inflight = state_.unsafeGetUnlocked().inflight;
+    for (const auto& [inodeNumber, write] : inflight) {
+      try {
+        if (write.odir) {
+          inner_->saveOverlayDir(
+              inodeNumber, overlay::OverlayDir{*write.odir});
+        } else {
+          inner_->removeOverlayDir(inodeNumber);
+        }
+      } catch (const std::exception& ex) {
+        XLOG(ERR) << "Failed to write buffered overlay directory "
+                  << inodeNumber << ": " << ex.what();
+      }
+    }
+
+    auto state = state_.lock();
+    state->inflight.clear();
+    ++state->flushCount;
+    flushedCV_.notify_all();
+  }
+}
+
+void BufferedInodeCatalog::buffer(
+    InodeNumber inodeNumber,
+    std::optional<overlay::OverlayDir> odir) {
+  auto size = estimateOverlayDirSize(odir);
+
+  auto state = state_.lock();
+  flushedCV_.wait(state.as_lock(), [&] {
+    return state->pendingSize < bufferSize_ || state->workerExited;
+  });
+
+  if (state->workerExited) {
+    // Nothing will write the buffer anymore; write through instead.
+    state.unlock();
+    if (odir) {
+      inner_->saveOverlayDir(inodeNumber, std::move(*odir));
+    } else {
+      inner_->removeOverlayDir(inodeNumber);
+    }
+    return;
+  }
+
+  auto wasEmpty = state->pending.empty();
+  auto& write = state->pending[inodeNumber];
+  state->pendingSize -= write.size;
+  write = PendingWrite{std::move(odir), size};
+  state->pendingSize += size;
+
+  if (wasEmpty) {
+    state->oldestPendingWrite = std::chrono::steady_clock::now();
+    workCV_.notify_one();
+  } else if (state->pendingSize >= bufferSize_) {
+    workCV_.notify_one();
+  }
+}
+
+const BufferedInodeCatalog::PendingWrite* BufferedInodeCatalog::findWrite(
+    const State& state,
+    InodeNumber inodeNumber) {
+  if (auto it = state.pending.find(inodeNumber); it != state.pending.end()) {
+    return &it->second;
+  }
+  if (auto it = state.inflight.find(inodeNumber); it != state.inflight.end()) {
+    return &it->second;
+  }
+  return nullptr;
+}
+
+void BufferedInodeCatalog::flush() {
+  auto state = state_.lock();
+  // Wait for the round of writes that is in progress, if any, and for the one
+  // that will pick up the pending writes, if any.
+  auto target = state->flushCount + (state->inflight.empty() ? 0 : 1) +
+      (state->pending.empty() ? 0 : 1);
+  ++state->flushWaiters;
+  workCV_.notify_one();
+  flushedCV_.wait(state.as_lock(), [&] {
+    return state->flushCount >= target || state->workerExited;
+  });
+  --state->flushWaiters;
+}
+
+std::vector<InodeNumber> BufferedInodeCatalog::getAllParentInodeNumbers() {
+  flush();
+  return inner_->getAllParentInodeNumbers();
+}
+
+std::optional<InodeNumber> BufferedInodeCatalog::initOverlay(
+    bool createIfNonExisting,
+    bool bypassLockFile) {
+  return inner_->initOverlay(createIfNonExisting, bypassLockFile);
+}
+
+void BufferedInodeCatalog::close(std::optional<InodeNumber> nextInodeNumber) {
+  // All of the buffered writes must be written before the wrapped catalog is
+  // closed.
+  stopWorkerThread();
+  inner_->close(nextInodeNumber);
+}
+
+bool BufferedInodeCatalog::initialized() const {
+  return inner_->initialized();
+}
+
+std::optional<overlay::OverlayDir> BufferedInodeCatalog::loadOverlayDir(
+    InodeNumber inodeNumber) {
+  {
+    auto state = state_.lock();
+    if (auto* write = findWrite(*state, inodeNumber)) {
+      return write->odir;
+    }
+  }
+  return inner_->loadOverlayDir(inodeNumber);
+}
+
+std::optional<overlay::OverlayDir>
+BufferedInodeCatalog::loadAndRemoveOverlayDir(InodeNumber inodeNumber) {
+  std::optional<overlay::OverlayDir> odir;
+  {
+    auto state = state_.lock();
+    auto* write = findWrite(*state, inodeNumber);
+    if (!write) {
+      state.unlock();
+      return inner_->loadAndRemoveOverlayDir(inodeNumber);
+    }
+    if (!write->odir) {
+      return std::nullopt;
+    }
+    odir = write->odir;
+  }
+  // The directory may also have been written to the wrapped catalog already.
+  buffer(inodeNumber, std::nullopt);
+  return odir;
+}
+
+void BufferedInodeCatalog::saveOverlayDir(
+    InodeNumber inodeNumber,
+    overlay::OverlayDir&& odir) {
+  buffer(inodeNumber, std::move(odir));
+}
+
+void BufferedInodeCatalog::removeOverlayDir(InodeNumber inodeNumber) {
+  buffer(inodeNumber, std::nullopt);
+}
+
+bool BufferedInodeCatalog::hasOverlayDir(InodeNumber inodeNumber) {
+  {
+    auto state = state_.lock();
+    if (auto* write = findWrite(*state, inodeNumber)) {
+      return write->odir.has_value();
+    }
+  }
+  return inner_->hasOverlayDir(inodeNumber);
+}
+
+std::optional<fsck::InodeInfo> BufferedInodeCatalog::loadInodeInfo(
+    InodeNumber number) {
+  flush();
+  return inner_->loadInodeInfo(number);
+}
+
+InodeNumber BufferedInodeCatalog::nextInodeNumber() {
+  return inner_->nextInodeNumber();
+}
+
+InodeNumber BufferedInodeCatalog::scanLocalChanges(
+    std::shared_ptr<const EdenConfig> config,
+    AbsolutePathPiece mountPath,
+    InodeCatalog::LookupCallback& callback) {
+  flush();
+  return inner_->scanLocalChanges(std::move(config), mountPath, callback);
+}
+
+void BufferedInodeCatalog::maintenance() {
+  inner_->maintenance();
+}
+
+} // namespace facebook::eden
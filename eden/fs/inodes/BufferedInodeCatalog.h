@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <optional>
+#include <thread>
+
+#include "eden/fs/inodes/InodeCatalog.h"
+
+namespace facebook::eden {
+
+/**
+ * An InodeCatalog that buffers directory writes in memory and writes them to
+ * the wrapped InodeCatalog on a background thread.
+ *
+ * Every change to a directory saves the whole directory, so creating many
+ * files in one directory rewrites its record once per file. Writes are only
+ * flushed once the oldest buffered write is coalesceWindow old, and a
+ * directory saved several times within that window is only written once, with
+ * its latest contents.
+ *
+ * Reads are served from the buffer first, so callers never observe the
+ * buffering. Writes block when bufferSize bytes of directories are buffered,
+ * and all of the buffered writes are flushed by close().
+ *
+ * BufferedSqliteInodeCatalog predates this class and has a similar purpose for
+ * SqliteInodeCatalog, but doesn't coalesce writes.
+ */
+class BufferedInodeCatalog : public InodeCatalog {
+ public:
+  /**
+   * The wrapped InodeCatalog must not support semantic operations: those
+   * modify directories without going through saveOverlayDir.
+   */
+  BufferedInodeCatalog(
+      std::unique_ptr<InodeCatalog> inner,
+      std::chrono::nanoseconds coalesceWindow,
+      size_t bufferSize);
+
+  ~BufferedInodeCatalog() override;
+
+  bool supportsSemanticOperations() const override {
+    return false;
+  }
+
+  std::vector<InodeNumber> getAllParentInodeNumbers() override;
+
+  std::optional<InodeNumber> initOverlay(
+      bool createIfNonExisting,
+      bool bypassLockFile = false) override;
+
+  void close(std::optional<InodeNumber> nextInodeNumber) override;
+
+  bool initialized() const override;
+
+  std::optional<overlay::OverlayDir> loadOverlayDir(
+      InodeNumber inodeNumber) override;
+
+  std::optional<overlay::OverlayDir> loadAndRemoveOverlayDir(
+      InodeNumber inodeNumber) override;
+
+  void saveOverlayDir(InodeNumber inodeNumber, overlay::OverlayDir&& odir)
+      override;
+
+  void removeOverlayDir(InodeNumber inodeNumber) override;
+
+  bool hasOverlayDir(InodeNumber inodeNumber) override;
+
+  std::optional<fsck::InodeInfo> loadInodeInfo(InodeNumber number) override;
+
+  InodeNumber nextInodeNumber() override;
+
+  InodeNumber scanLocalChanges(
+      std::shared_ptr<const EdenConfig> config,
+      AbsolutePathPiece mountPath,
+      InodeCatalog::LookupCallback& callback) override;
+
+  void maintenance() override;
+
+  /**
+   * Returns once every write buffered before the call has been written to the
+   * wrapped InodeCatalog.
+   */
+  void flush();
+
+ private:
+  /**
+   * The latest write of a directory: its contents, or std::nullopt if it was
+   * removed.
+   */
+  struct PendingWrite {
+    std::optional<overlay::OverlayDir> odir;
+    size_t size = 0;
+  };
+
+  using PendingWrites = folly::F14NodeMap<InodeNumber, PendingWrite>;
+
+  struct State {
+    // Writes that haven't been picked up by the worker thread yet.
+    PendingWrites pending;
+    // Writes that the worker thread is currently writing to inner_. They are
+    // only looked at when a directory isn't in pending.
+    PendingWrites inflight;
+    // Total size of the writes in pending.
+    size_t pendingSize = 0;
+    // When the oldest write in pending was buffered.
+    std::chrono::steady_clock::time_point oldestPendingWrite;
+    // Number of times the worker thread finished writing inflight. This lets
+    // flush() wait for the writes it saw.
+    uint64_t flushCount = 0;
+    // Number of threads in flush(). The worker thread doesn't wait for the
+    // coalescing window while there are any.
+    size_t flushWaiters = 0;
+    bool stopRequested = false;
+    // Set once the worker thread has written everything and exited.
+    bool workerExited = false;
+  };
+
+  /**
+   * Buffer a write of the given directory, replacing any buffered write of it.
+   */
+  void buffer(InodeNumber inodeNumber, std::optional<overlay::OverlayDir> odir);
+
+  /**
+   * Look for a write of the given directory in the buffer.
+   */
+  static const PendingWrite* findWrite(
+      const State& state,
+      InodeNumber inodeNumber);
+
+  void processOnWorkerThread();
+
+  void stopWorkerThread();
+
+  const std::unique_ptr<InodeCatalog> inner_;
+  const std::chrono::nanoseconds coalesceWindow_;
+  const size_t bufferSize_;
+
+  folly::Synchronized<State, std::mutex> state_;
+  // Signaled when writes are buffered, and when a flush or stop is requested.
+  std::condition_variable workCV_;
+  // Signaled when the worker thread picks up the pending writes, when it is
+  // done writing them, and when it exits.
+  std::condition_variable flushedCV_;
+  std::thread workerThread_;
+};
+
+} // namespace facebook::eden
@@ -12,6 +12,7 @@
 #include <optional>
 
 #include "eden/fs/config/CheckoutConfig.h"
+#include "eden/fs/fuse/FuseChannel.h"
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/InodePtr.h"
 #include "eden/fs/inodes/TreeInode.h"
@@ -46,6 +47,14 @@ void CheckoutContext::start(
     std::shared_ptr<const Tree> toTree) {
   renameLock_ = std::move(renameLock);
 
+#ifndef _WIN32
+  if (auto* fuseChannel = mount_->getFuseChannel()) {
+    auto counts = fuseChannel->getInvalidationCounts();
+    invalidationsSentAtStart_ = counts.sent;
+    invalidationsCoalescedAtStart_ = counts.coalesced;
+  }
+#endif
+
   // Only update the parent if it is not a dry run.
   if (!isDryRun()) {
     std::optional<RootId> oldParent;
@@ -103,7 +112,21 @@ Future<vector<CheckoutConflict>> CheckoutContext::flush() {
     // operations may be blocked waiting on FUSE unlink() and rename()
     // operations complete.
     return mount_->flushInvalidations()
-        .thenValue([this](auto&&) { return std::move(*conflicts_.wlock()); })
+        .thenValue([this](auto&&) {
+#ifndef _WIN32
+          if (auto* fuseChannel = mount_->getFuseChannel()) {
+            // Other operations on the mount may have sent invalidations
+            // concurrently, so these counts are approximate.
+            auto counts = fuseChannel->getInvalidationCounts();
+            XLOG(DBG2) << "checkout sent "
+                       << counts.sent - invalidationsSentAtStart_
+                       << " invalidations to the kernel and coalesced "
+                       << counts.coalesced - invalidationsCoalescedAtStart_
+                       << " more";
+          }
+#endif
+          return std::move(*conflicts_.wlock());
+        })
         .semi()
         .via(&folly::QueuedImmediateExecutor::instance());
   }
@@ -156,5 +156,9 @@ class CheckoutContext {
   folly::Synchronized<std::vector<CheckoutConflict>> conflicts_;
 
   bool windowsSymlinksEnabled_;
+
+  // The invalidation counts of the FUSE channel when the checkout started.
+  uint64_t invalidationsSentAtStart_{0};
+  uint64_t invalidationsCoalescedAtStart_{0};
 };
 } // namespace facebook::eden
@@ -12,6 +12,7 @@
 #include <folly/logging/xlog.h>
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/FileInode.h"
+#include "eden/fs/inodes/Overlay.h"
 #include "eden/fs/inodes/TreeInode.h"
 #include "eden/fs/model/BlobMetadata.h"
 #include "eden/fs/store/BackingStore.h"
@@ -70,6 +71,66 @@ class UntrackedDiffEntry : public DeferredDiffEntry {
   ImmediateFuture<InodePtr> inodeFuture_;
 };
 
+/**
+ * An ignored, materialized and untracked directory whose inode is not loaded.
+ *
+ * Everything inside of it is ignored too, so its contents are listed straight
+ * from the overlay instead of loading an inode for it and for each of its
+ * subdirectories. This keeps large ignored build output directories from
+ * filling the InodeMap when the ignored files are listed.
+ */
+class IgnoredOverlayDiffEntry : public DeferredDiffEntry {
+ public:
+  IgnoredOverlayDiffEntry(
+      DiffContext* context,
+      RelativePath path,
+      TreeInodePtr parent,
+      InodeNumber inodeNumber)
+      : DeferredDiffEntry{context, std::move(path)},
+        parent_{std::move(parent)},
+        inodeNumber_{inodeNumber} {}
+
+  ImmediateFuture<folly::Unit> run() override {
+    std::vector<ImmediateFuture<folly::Unit>> scmFutures;
+    listIgnored(getPath(), inodeNumber_, scmFutures);
+    return collectAllSafe(std::move(scmFutures)).unit();
+  }
+
+ private:
+  void listIgnored(
+      RelativePathPiece path,
+      InodeNumber inodeNumber,
+      std::vector<ImmediateFuture<folly::Unit>>& scmFutures) {
+    if (context_->isCancelled()) {
+      return;
+    }
+
+    auto windowsSymlinksEnabled = context_->getWindowsSymlinksEnabled();
+    auto contents =
+        parent_->getMount()->getOverlay()->loadOverlayDir(inodeNumber);
+    for (const auto& [name, entry] : contents) {
+      auto entryPath = path + name;
+      XLOG(DBG9) << "diff: ignored file: " << entryPath;
+      context_->callback->ignoredPath(
+          entryPath,
+          filteredEntryDtype(entry.getDtype(), windowsSymlinksEnabled));
+      if (!entry.isDirectory()) {
+        continue;
+      }
+      if (entry.isMaterialized()) {
+        listIgnored(entryPath, entry.getInodeNumber(), scmFutures);
+      } else {
+        scmFutures.push_back(diffAddedTree(
+            context_, entryPath, entry.getHash(), nullptr, true));
+      }
+    }
+  }
+
+  // Keeps the mount, and thus its overlay, alive.
+  TreeInodePtr parent_;
+  InodeNumber inodeNumber_;
+};
+
 class ModifiedDiffEntry : public DeferredDiffEntry {
  public:
   ModifiedDiffEntry(
@@ -322,6 +383,15 @@ unique_ptr<DeferredDiffEntry> DeferredDiffEntry::createUntrackedEntry(
       context, std::move(path), std::move(inode), ignore, isIgnored);
 }
 
+unique_ptr<DeferredDiffEntry> DeferredDiffEntry::createIgnoredOverlayEntry(
+    DiffContext* context,
+    RelativePath path,
+    TreeInodePtr parent,
+    InodeNumber inodeNumber) {
+  return make_unique<IgnoredOverlayDiffEntry>(
+      context, std::move(path), std::move(parent), inodeNumber);
+}
+
 unique_ptr<DeferredDiffEntry> DeferredDiffEntry::createModifiedEntry(
     DiffContext* context,
     RelativePath path,
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <memory>
+#include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/inodes/InodePtrFwd.h"
 #include "eden/fs/utils/DirType.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -58,6 +59,17 @@ class DeferredDiffEntry {
       const GitIgnoreStack* ignore,
       bool isIgnored);
 
+  /**
+   * List everything inside of an ignored untracked directory from the
+   * overlay, without loading its inode. The directory must be a materialized
+   * child of parent whose inode is not loaded.
+   */
+  static std::unique_ptr<DeferredDiffEntry> createIgnoredOverlayEntry(
+      DiffContext* context,
+      RelativePath path,
+      TreeInodePtr parent,
+      InodeNumber inodeNumber);
+
   static std::unique_ptr<DeferredDiffEntry> createRemovedEntry(
       DiffContext* context,
       RelativePath path,
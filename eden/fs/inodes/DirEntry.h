@@ -12,7 +12,7 @@
 #include "eden/fs/model/ObjectId.h"
 #include "eden/fs/utils/CaseSensitivity.h"
 #include "eden/fs/utils/DirType.h"
-#include "eden/fs/utils/PathMap.h"
+#include "eden/fs/utils/HashedPathMap.h"
 #include "eden/fs/utils/StaticAssert.h"
 
 namespace facebook::eden {
@@ -181,6 +181,14 @@ class DirEntry {
    */
   TreeInode* FOLLY_NULLABLE asTreeOrNull() const;
 
+  /**
+   * Same as asTreeOrNull(), typed to make explicit that the TreeInode is
+   * only valid while the caller holds its parent's contents_ lock.
+   */
+  BorrowedInodePtr<TreeInode> borrowTreeOrNull() const {
+    return BorrowedInodePtr<TreeInode>{asTreeOrNull()};
+  }
+
   /**
    * Associates a loaded inode pointer with this entry. Does not take ownership.
    */
@@ -265,10 +273,13 @@ static_assert(CheckSize<DirEntry, 40>(), "DirEntry is five words");
 
 /**
  * Represents a directory in the overlay.
+ *
+ * Directories are mostly looked up by name, by the kernel and by checkout, so
+ * this is a HashedPathMap rather than a PathMap.
  */
-struct DirContents : PathMap<DirEntry> {
+struct DirContents : HashedPathMap<DirEntry> {
   explicit DirContents(CaseSensitivity caseSensitive)
-      : PathMap(caseSensitive) {}
+      : HashedPathMap(caseSensitive) {}
 };
 
 } // namespace facebook::eden
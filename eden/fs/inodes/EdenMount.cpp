@@ -12,6 +12,7 @@
 #include <folly/FBString.h>
 #include <folly/File.h>
 #include <folly/chrono/Conv.h>
+#include <folly/lang/Bits.h>
 #include <folly/futures/Future.h>
 #include <folly/io/async/EventBase.h>
 #include <folly/logging/Logger.h>
@@ -19,6 +20,7 @@
 #include <folly/portability/GFlags.h>
 #include <folly/stop_watch.h>
 #include <folly/system/Pid.h>
+#include <folly/system/ThreadId.h>
 #include <folly/system/ThreadName.h>
 
 #include "eden/fs/config/EdenConfig.h"
@@ -32,6 +34,7 @@
 #include "eden/fs/inodes/InodeError.h"
 #include "eden/fs/inodes/InodeMap.h"
 #include "eden/fs/inodes/InodeTable.h"
+#include "eden/fs/inodes/PrefetchPredictor.h"
 #include "eden/fs/inodes/ServerState.h"
 #include "eden/fs/inodes/TreeInode.h"
 #include "eden/fs/inodes/TreePrefetchLease.h"
@@ -54,11 +57,14 @@
 #include "eden/fs/store/ScmStatusDiffCallback.h"
 #include "eden/fs/store/StatsFetchContext.h"
 #include "eden/fs/store/TreeLookupProcessor.h"
+#include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/telemetry/StructuredLogger.h"
+#include "eden/fs/telemetry/TaskTrace.h"
 #include "eden/fs/utils/Bug.h"
 #include "eden/fs/utils/Clock.h"
 #include "eden/fs/utils/EdenError.h"
 #include "eden/fs/utils/FaultInjector.h"
+#include "eden/fs/utils/FileUtils.h"
 #include "eden/fs/utils/FsChannelTypes.h"
 #include "eden/fs/utils/Future.h"
 #include "eden/fs/utils/ImmediateFuture.h"
@@ -128,6 +134,12 @@ constexpr PathComponentPiece kDotEdenSymlinkName{"this-dir"_pc};
 
 namespace {
 constexpr PathComponentPiece kNfsdSocketName{"nfsd.socket"_pc};
+constexpr PathComponentPiece kPrefetchPredictorModelName{
+    "prefetch-predictor"_pc};
+constexpr PathComponentPiece kJournalName{"journal"_pc};
+// The number of directories the PrefetchPredictor keeps scores for, relative
+// to the number of directories prefetched after a checkout.
+constexpr size_t kPrefetchPredictorModelFactor = 4;
 }
 
 /**
@@ -204,6 +216,50 @@ class EdenMount::JournalDiffCallback : public DiffCallback {
   folly::Synchronized<Data> data_;
 };
 
+/**
+ * Fetches every source control tree that differs between the two commits of a
+ * checkout, so that they are already cached once TreeInode::checkout() walks
+ * them. The differences themselves are discarded: checkout computes its own
+ * actions as it compares each tree against the inodes.
+ */
+class EdenMount::CheckoutPrefetchCallback : public DiffCallback {
+ public:
+  void ignoredPath(RelativePathPiece, dtype_t) override {}
+
+  void addedPath(RelativePathPiece, dtype_t) override {}
+
+  void removedPath(RelativePathPiece, dtype_t) override {}
+
+  void modifiedPath(RelativePathPiece, dtype_t) override {}
+
+  void diffError(RelativePathPiece path, const folly::exception_wrapper& ew)
+      override {
+    // Checkout will fetch this tree again, and report the error if it fails.
+    XLOG(DBG3) << "error prefetching checkout trees for " << path << ": "
+               << folly::exceptionStr(ew);
+  }
+
+  FOLLY_NODISCARD ImmediateFuture<StatsFetchContext> performPrefetch(
+      EdenMount* mount,
+      const std::shared_ptr<const Tree>& fromTree,
+      const std::shared_ptr<const Tree>& toTree) {
+    auto diffContext =
+        mount->createDiffContext(this, folly::CancellationToken{});
+    auto rawContext = diffContext.get();
+
+    return diffTrees(
+               rawContext,
+               RelativePathPiece{},
+               fromTree->getHash(),
+               toTree->getHash(),
+               rawContext->getToplevelIgnore(),
+               false)
+        .thenValue([diffContext = std::move(diffContext)](folly::Unit) {
+          return diffContext->getStatsContext();
+        });
+  }
+};
+
 static constexpr folly::StringPiece kEdenStracePrefix = "eden.strace.";
 
 // We compute this when the process is initialized, but stash a copy
@@ -276,10 +332,18 @@ EdenMount::EdenMount(
 #ifndef _WIN32
       overlayFileAccess_{
           overlay_.get(),
-          serverState_->getEdenConfig()->overlayFileAccessCacheSize.getValue()},
+          serverState_->getEdenConfig()->overlayFileAccessCacheSize.getValue(),
+          serverState_->getEdenConfig()
+              ->overlayFileAccessCacheShards.getValue(),
+          serverState_->getEdenConfig()->overlayIoThreads.getValue(),
+          serverState_->getEdenConfig()
+              ->overlaySparseMaterializationMinSize.getValue(),
+          serverState_->getEdenConfig()
+              ->overlaySparseMaterializationMaxMemory.getValue(),
+          serverState_->getStats().copy()},
 #endif
       journal_{std::move(journal)},
-      mountGeneration_{globalProcessGeneration | ++mountGeneration},
+      mountGeneration_{restoreJournal()},
       straceLogger_{
           kEdenStracePrefix.str() + checkoutConfig_->getMountPath().value()},
       lastCheckoutTime_{EdenTimestamp{serverState_->getClock()->getRealtime()}},
@@ -290,6 +354,7 @@ EdenMount::EdenMount(
           serverState_->getEdenConfig()->InodeTraceBusCapacity.getValue())},
       clock_{serverState_->getClock()} {
   subscribeInodeActivityBuffer();
+  subscribePrefetchPredictor();
 }
 
 InodeCatalogType EdenMount::getInodeCatalogType(
@@ -988,6 +1053,12 @@ folly::SemiFuture<SerializedInodeMap> EdenMount::shutdownImpl(bool doTakeover) {
   return inodeMap_->shutdown(doTakeover)
       .thenValue([this](SerializedInodeMap inodeMap) {
         XLOG(DBG1) << "shutdown complete for EdenMount " << getPath();
+#ifndef _WIN32
+        // The blobs of sparse files are lost once this process exits.
+        overlayFileAccess_.completeSparseFiles();
+#endif
+        // The journal is complete once the inodes are unloaded.
+        saveJournal();
         // Close the Overlay object to make sure we have released its lock.
         // This is important during graceful restart to ensure that we have
         // released the lock before the new edenfs process begins to take over
@@ -1338,6 +1409,50 @@ ImmediateFuture<folly::Unit> EdenMount::waitForPendingWrites() const {
   }
 }
 
+namespace {
+
+/**
+ * Publish the stages of a finished checkout to the TaskTrace bus, as spans
+ * that start when the previous stage finished. The prefetch runs alongside
+ * the diff, so it starts with it.
+ */
+void traceCheckoutStages(
+    const CheckoutTimes& times,
+    std::chrono::steady_clock::time_point start) {
+  const auto& traceBus = TaskTraceEvent::getTraceBus();
+  if (!traceBus->hasSubscription()) {
+    return;
+  }
+  auto threadName = folly::getCurrentThreadName().value_or("<unknown>");
+  auto threadId = folly::getOSThreadID();
+  auto publishStage = [&](std::string_view name,
+                          CheckoutTimes::duration begin,
+                          CheckoutTimes::duration end) {
+    // Stages that didn't run, or didn't finish, have no time.
+    if (end <= begin) {
+      return;
+    }
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+    traceBus->publish(TaskTraceEvent{
+        name,
+        threadName,
+        threadId,
+        duration_cast<microseconds>(end - begin),
+        duration_cast<microseconds>((start + begin).time_since_epoch())});
+  };
+  publishStage("checkout::lookupTrees", {}, times.didLookupTrees);
+  publishStage("checkout::prefetch", times.didLookupTrees, times.didPrefetch);
+  publishStage("checkout::diff", times.didLookupTrees, times.didDiff);
+  publishStage(
+      "checkout::acquireRenameLock", times.didDiff, times.didAcquireRenameLock);
+  publishStage(
+      "checkout::checkout", times.didAcquireRenameLock, times.didCheckout);
+  publishStage("checkout::finish", times.didCheckout, times.didFinish);
+}
+
+} // namespace
+
 folly::Future<CheckoutResult> EdenMount::checkout(
     TreeInodePtr rootInode,
     const RootId& snapshotHash,
@@ -1436,6 +1551,30 @@ folly::Future<CheckoutResult> EdenMount::checkout(
                   treeResults) {
             XLOG(DBG7) << "Checkout: performDiff";
             checkoutTimes->didLookupTrees = stopWatch.elapsed();
+
+            // When enabled, fetch every source control tree that differs
+            // between the two commits while the working copy is diffed below,
+            // so that the importer is kept busy before the rename lock is
+            // taken rather than one tree at a time as the inode update reaches
+            // each directory.
+            auto prefetchFuture = ImmediateFuture<folly::Unit>{folly::unit};
+            if (getEdenConfig()->prefetchCheckoutTrees.getValue()) {
+              auto prefetchCallback =
+                  std::make_shared<CheckoutPrefetchCallback>();
+              prefetchFuture =
+                  prefetchCallback
+                      ->performPrefetch(
+                          this,
+                          std::get<0>(treeResults),
+                          std::get<1>(treeResults))
+                      .thenValue(
+                          [ctx, checkoutTimes, stopWatch, prefetchCallback](
+                              const StatsFetchContext& prefetchFetchContext) {
+                            ctx->getStatsContext().merge(prefetchFetchContext);
+                            checkoutTimes->didPrefetch = stopWatch.elapsed();
+                          });
+            }
+
             // Call JournalDiffCallback::performDiff() to compute the changes
             // between the original working directory state and the source
             // tree state.
@@ -1443,7 +1582,11 @@ folly::Future<CheckoutResult> EdenMount::checkout(
             // If we are doing a dry-run update we aren't going to create a
             // journal entry, so we can skip this step entirely.
             if (ctx->isDryRun()) {
-              return folly::makeFuture(treeResults);
+              return std::move(prefetchFuture)
+                  .thenValue(
+                      [treeResults](folly::Unit) { return treeResults; })
+                  .semi()
+                  .via(&folly::QueuedImmediateExecutor::instance());
             }
 
             auto& fromTree = std::get<0>(treeResults);
@@ -1451,13 +1594,16 @@ folly::Future<CheckoutResult> EdenMount::checkout(
             if (resumingCheckout) {
               trees.push_back(std::get<1>(treeResults));
             }
-            return journalDiffCallback
-                ->performDiff(this, rootInode, std::move(trees))
-                .thenValue([ctx, journalDiffCallback, treeResults](
-                               const StatsFetchContext& diffFetchContext) {
-                  ctx->getStatsContext().merge(diffFetchContext);
-                  return treeResults;
-                })
+            auto diffFuture =
+                journalDiffCallback
+                    ->performDiff(this, rootInode, std::move(trees))
+                    .thenValue([ctx, journalDiffCallback](
+                                   const StatsFetchContext& diffFetchContext) {
+                      ctx->getStatsContext().merge(diffFetchContext);
+                    });
+            return collectAllSafe(
+                       std::move(diffFuture), std::move(prefetchFuture))
+                .thenValue([treeResults](auto&&) { return treeResults; })
                 .semi()
                 .via(&folly::QueuedImmediateExecutor::instance());
           })
@@ -1570,8 +1716,13 @@ folly::Future<CheckoutResult> EdenMount::checkout(
 
             return result;
           })
-      .thenTry([this, ctx, stopWatch, oldParent, snapshotHash, checkoutMode](
-                   Try<CheckoutResult>&& result) {
+      .thenTry([this,
+                ctx,
+                checkoutTimes,
+                stopWatch,
+                oldParent,
+                snapshotHash,
+                checkoutMode](Try<CheckoutResult>&& result) {
         auto fetchStats = ctx->getStatsContext().computeStatistics();
 
         XLOG(DBG1) << (result.hasValue() ? "" : "failed ") << "checkout for "
@@ -1584,6 +1735,29 @@ folly::Future<CheckoutResult> EdenMount::checkout(
                    << fetchStats.blobMetadata.accessCount << " metadata ("
                    << fetchStats.blobMetadata.cacheHitRate << "% chr).";
 
+        using std::chrono::duration_cast;
+        using std::chrono::milliseconds;
+        XLOG(DBG2) << "checkout for " << this->getPath()
+                   << " finished stages at (ms): lookupTrees="
+                   << duration_cast<milliseconds>(checkoutTimes->didLookupTrees)
+                          .count()
+                   << " prefetch="
+                   << duration_cast<milliseconds>(checkoutTimes->didPrefetch)
+                          .count()
+                   << " diff="
+                   << duration_cast<milliseconds>(checkoutTimes->didDiff)
+                          .count()
+                   << " checkout="
+                   << duration_cast<milliseconds>(checkoutTimes->didCheckout)
+                          .count()
+                   << " finish="
+                   << duration_cast<milliseconds>(checkoutTimes->didFinish)
+                          .count();
+
+        traceCheckoutStages(
+            *checkoutTimes,
+            std::chrono::steady_clock::now() - stopWatch.elapsed());
+
         auto checkoutTimeInSeconds =
             std::chrono::duration<double>{stopWatch.elapsed()};
         auto event = FinishedCheckout{};
@@ -1624,6 +1798,139 @@ folly::Future<CheckoutResult> EdenMount::checkout(
       });
 }
 
+namespace {
+
+/**
+ * Records the files that differ between two commits for estimateCheckout().
+ */
+class CheckoutEstimateCallback : public DiffCallback {
+ public:
+  void ignoredPath(RelativePathPiece, dtype_t) override {}
+
+  void addedPath(RelativePathPiece path, dtype_t type) override {
+    record(path, type, /*inNewCommit=*/true);
+  }
+
+  void removedPath(RelativePathPiece path, dtype_t type) override {
+    record(path, type, /*inNewCommit=*/false);
+  }
+
+  void modifiedPath(RelativePathPiece path, dtype_t type) override {
+    record(path, type, /*inNewCommit=*/true);
+  }
+
+  void diffError(RelativePathPiece path, const folly::exception_wrapper& ew)
+      override {
+    XLOG(WARNING) << "error estimating checkout for " << path << ": "
+                  << folly::exceptionStr(ew);
+  }
+
+  std::vector<std::pair<RelativePath, bool>> extractChangedFiles() {
+    return std::move(*changedFiles_.wlock());
+  }
+
+ private:
+  void record(RelativePathPiece path, dtype_t type, bool inNewCommit) {
+    if (type != dtype_t::Dir) {
+      changedFiles_.wlock()->emplace_back(path.copy(), inNewCommit);
+    }
+  }
+
+  folly::Synchronized<std::vector<std::pair<RelativePath, bool>>>
+      changedFiles_;
+};
+
+/**
+ * Find out how checkout would find the inode at path, without loading any
+ * inode. Sets loaded if the inode is loaded, and materialized if it, or an
+ * unloaded directory containing it, is materialized.
+ */
+void lookupCheckoutImpact(
+    const TreeInodePtr& root,
+    RelativePathPiece path,
+    bool& loaded,
+    bool& materialized) {
+  loaded = false;
+  materialized = false;
+
+  // Each directory is referenced before its parent's lock is released, so
+  // that it can't be unloaded while it is being looked at.
+  auto tree = root;
+  auto components = path.components();
+  for (auto it = components.begin(); it != components.end(); ++it) {
+    TreeInodePtr child;
+    {
+      auto contents = tree->getContents().rlock();
+      auto entry = contents->entries.find(*it);
+      if (entry == contents->entries.end()) {
+        return;
+      }
+      if (std::next(it) == components.end()) {
+        loaded = entry->second.getInode() != nullptr;
+        materialized = entry->second.isMaterialized();
+        return;
+      }
+      child = entry->second.asTreePtrOrNull();
+      if (!child) {
+        // Checkout handles an unloaded directory as a whole. If it is
+        // materialized, it may hold local changes to any of its children.
+        materialized = entry->second.isDirectory() &&
+            entry->second.getInode() == nullptr &&
+            entry->second.isMaterialized();
+        return;
+      }
+    }
+    tree = std::move(child);
+  }
+}
+
+} // namespace
+
+ImmediateFuture<CheckoutEstimate> EdenMount::estimateCheckout(
+    const RootId& snapshotHash,
+    folly::CancellationToken cancellation) {
+  auto callback = std::make_shared<CheckoutEstimateCallback>();
+  auto diffContext = createDiffContext(callback.get(), std::move(cancellation));
+  auto rawContext = diffContext.get();
+
+  return diffRoots(rawContext, getCheckedOutRootId(), snapshotHash)
+      .thenValue([this,
+                  callback,
+                  diffContext = std::move(diffContext),
+                  rootInode = getRootInode()](folly::Unit) {
+        CheckoutEstimate estimate;
+        estimate.treesFetched =
+            diffContext->getStatsContext().countFetchesOfTypeAndOrigin(
+                ObjectFetchContext::Tree,
+                ObjectFetchContext::FromNetworkFetch);
+
+        auto changedFiles = callback->extractChangedFiles();
+        estimate.changedFiles = changedFiles.size();
+        for (const auto& [path, inNewCommit] : changedFiles) {
+          if (inNewCommit) {
+            ++estimate.blobsToFetch;
+          }
+          bool loaded;
+          bool materialized;
+          lookupCheckoutImpact(rootInode, path, loaded, materialized);
+          if (loaded) {
+            ++estimate.loadedInodesAffected;
+          }
+          if (materialized) {
+            ++estimate.materializedConflicts;
+          }
+        }
+
+        XLOG(DBG3) << "estimated checkout of " << getPath() << ": "
+                   << estimate.changedFiles << " changed files, "
+                   << estimate.treesFetched << " trees fetched, "
+                   << estimate.loadedInodesAffected << " loaded inodes, "
+                   << estimate.materializedConflicts
+                   << " possible conflicts";
+        return estimate;
+      });
+}
+
 void EdenMount::forgetStaleInodes() {
   inodeMap_->forgetStaleInodes();
 }
@@ -1722,7 +2029,7 @@ std::unique_ptr<DiffContext> EdenMount::createDiffContext(
     DiffCallback* callback,
     folly::CancellationToken cancellation,
     bool listIgnored) const {
-  return make_unique<DiffContext>(
+  auto context = make_unique<DiffContext>(
       callback,
       cancellation,
       listIgnored,
@@ -1730,6 +2037,13 @@ std::unique_ptr<DiffContext> EdenMount::createDiffContext(
       getCheckoutConfig()->getEnableWindowsSymlinks(),
       getObjectStore(),
       serverState_->getTopLevelIgnores());
+  auto concurrency = serverState_->getEdenConfig()->diffConcurrency.getValue();
+  if (concurrency > 0) {
+    context->setExecutor(serverState_->getThreadPool(), concurrency);
+  }
+  context->setGitIgnoreCache(serverState_->getGitIgnoreCache());
+  context->setTreeDiffCache(serverState_->getTreeDiffCache());
+  return context;
 }
 
 ImmediateFuture<Unit> EdenMount::diff(
@@ -1752,6 +2066,44 @@ ImmediateFuture<Unit> EdenMount::diff(
       });
 }
 
+folly::exception_wrapper EdenMount::checkDiffParent(
+    const RootId& commitHash) const {
+  auto parentInfo = parentState_.rlock();
+
+  if (std::holds_alternative<ParentCommitState::CheckoutInProgress>(
+          parentInfo->checkoutState)) {
+    return folly::exception_wrapper{newEdenError(
+        EdenErrorType::CHECKOUT_IN_PROGRESS,
+        "cannot compute status while a checkout is currently in progress")};
+  } else if (
+      auto* interrupted = std::get_if<ParentCommitState::InterruptedCheckout>(
+          &parentInfo->checkoutState)) {
+    return folly::exception_wrapper{newEdenError(
+        EdenErrorType::CHECKOUT_IN_PROGRESS,
+        fmt::format(
+            "cannot compute status while a checkout is in progress - please run 'hg update --clean {}' to resume it",
+            interrupted->toCommit))};
+  }
+
+  if (parentInfo->workingCopyParentRootId != commitHash) {
+    // Log this occurrence to Scuba
+    getServerState()->getStructuredLogger()->logEvent(ParentMismatch{
+        commitHash.value(), parentInfo->workingCopyParentRootId.value()});
+    return folly::exception_wrapper{newEdenError(
+        EdenErrorType::OUT_OF_DATE_PARENT,
+        "error computing status: requested parent commit is out-of-date: requested ",
+        commitHash,
+        ", but current parent commit is ",
+        parentInfo->workingCopyParentRootId,
+        ".\nTry running `eden doctor` to remediate")};
+  }
+
+  // TODO: Should we perhaps hold the parentInfo read-lock for the duration
+  // of the status operation?  This would block new checkout operations from
+  // starting until we have finished computing this status call.
+  return folly::exception_wrapper{};
+}
+
 ImmediateFuture<Unit> EdenMount::diff(
     TreeInodePtr rootInode,
     DiffCallback* callback,
@@ -1760,39 +2112,9 @@ ImmediateFuture<Unit> EdenMount::diff(
     bool enforceCurrentParent,
     folly::CancellationToken cancellation) const {
   if (enforceCurrentParent) {
-    auto parentInfo = parentState_.rlock();
-
-    if (std::holds_alternative<ParentCommitState::CheckoutInProgress>(
-            parentInfo->checkoutState)) {
-      return makeImmediateFuture<Unit>(newEdenError(
-          EdenErrorType::CHECKOUT_IN_PROGRESS,
-          "cannot compute status while a checkout is currently in progress"));
-    } else if (
-        auto* interrupted = std::get_if<ParentCommitState::InterruptedCheckout>(
-            &parentInfo->checkoutState)) {
-      return makeImmediateFuture<Unit>(newEdenError(
-          EdenErrorType::CHECKOUT_IN_PROGRESS,
-          fmt::format(
-              "cannot compute status while a checkout is in progress - please run 'hg update --clean {}' to resume it",
-              interrupted->toCommit)));
+    if (auto error = checkDiffParent(commitHash)) {
+      return makeImmediateFuture<Unit>(std::move(error));
     }
-
-    if (parentInfo->workingCopyParentRootId != commitHash) {
-      // Log this occurrence to Scuba
-      getServerState()->getStructuredLogger()->logEvent(ParentMismatch{
-          commitHash.value(), parentInfo->workingCopyParentRootId.value()});
-      return makeImmediateFuture<Unit>(newEdenError(
-          EdenErrorType::OUT_OF_DATE_PARENT,
-          "error computing status: requested parent commit is out-of-date: requested ",
-          commitHash,
-          ", but current parent commit is ",
-          parentInfo->workingCopyParentRootId,
-          ".\nTry running `eden doctor` to remediate"));
-    }
-
-    // TODO: Should we perhaps hold the parentInfo read-lock for the duration
-    // of the status operation?  This would block new checkout operations from
-    // starting until we have finished computing this status call.
   }
 
   // Create a DiffContext object for this diff operation.
@@ -1813,6 +2135,58 @@ ImmediateFuture<std::unique_ptr<ScmStatus>> EdenMount::diff(
     folly::CancellationToken cancellation,
     bool listIgnored,
     bool enforceCurrentParent) {
+  if (enforceCurrentParent) {
+    if (auto error = checkDiffParent(commitHash)) {
+      return makeImmediateFuture<std::unique_ptr<ScmStatus>>(std::move(error));
+    }
+  }
+
+  // Tools polling status after the same change tend to ask at once. As long
+  // as nothing was written in between, they can all share one diff.
+  auto latest = journal_->getLatest();
+  auto key = fmt::format(
+      "{}:{}:{}:{}",
+      commitHash.value(),
+      listIgnored,
+      latest ? latest->sequenceID : 0,
+      serverState_->getTopLevelIgnoresVersion());
+  return inFlightStatus_
+      .getOrCompute(
+          key,
+          [this,
+           rootInode = std::move(rootInode),
+           commitHash,
+           cancellation,
+           listIgnored]() mutable {
+            return computeStatus(
+                       std::move(rootInode),
+                       commitHash,
+                       cancellation,
+                       listIgnored)
+                .thenValue([cancellation](std::unique_ptr<ScmStatus> status) {
+                  // A cancelled diff stops early, so its result must not be
+                  // handed to the callers that joined it.
+                  if (cancellation.isCancellationRequested()) {
+                    throw folly::OperationCancelled{};
+                  }
+                  return std::move(*status);
+                });
+          })
+      .thenValue([](std::shared_ptr<const ScmStatus> status) {
+        return std::make_unique<ScmStatus>(*status);
+      });
+}
+
+ImmediateFuture<std::unique_ptr<ScmStatus>> EdenMount::computeStatus(
+    TreeInodePtr rootInode,
+    const RootId& commitHash,
+    folly::CancellationToken cancellation,
+    bool listIgnored) {
+  if (getEdenConfig()->enableStatusCache.getValue()) {
+    return diffWithStatusCache(
+        std::move(rootInode), commitHash, std::move(cancellation), listIgnored);
+  }
+
   auto callback = std::make_unique<ScmStatusDiffCallback>();
   auto callbackPtr = callback.get();
   return this
@@ -1821,13 +2195,164 @@ ImmediateFuture<std::unique_ptr<ScmStatus>> EdenMount::diff(
           callbackPtr,
           commitHash,
           listIgnored,
-          enforceCurrentParent,
+          /*enforceCurrentParent=*/false,
           std::move(cancellation))
       .thenValue([callback = std::move(callback)](auto&&) {
         return std::make_unique<ScmStatus>(callback->extractStatus());
       });
 }
 
+namespace {
+constexpr PathComponentPiece kIgnoreFilename{".gitignore"};
+
+/**
+ * Returns the paths that a status computed before the given journal range
+ * needs to be diffed again at to be brought up to date, or std::nullopt if
+ * it needs to be computed from scratch.
+ */
+std::optional<std::vector<RelativePath>> getStatusCacheChanges(
+    const JournalDeltaRange& range,
+    size_t maxChangedPaths) {
+  if (range.isTruncated || range.snapshotTransitions.size() > 1 ||
+      !range.uncleanPaths.empty() ||
+      range.changedFilesInOverlay.size() > maxChangedPaths) {
+    return std::nullopt;
+  }
+
+  std::vector<RelativePath> paths;
+  paths.reserve(range.changedFilesInOverlay.size());
+  for (const auto& [path, info] : range.changedFilesInOverlay) {
+    if (path.basename() == kIgnoreFilename) {
+      // Changing the ignore rules can change the status of everything in the
+      // directory.
+      auto dir = path.dirname();
+      if (dir.empty()) {
+        return std::nullopt;
+      }
+      paths.emplace_back(dir);
+    } else {
+      paths.push_back(path);
+    }
+  }
+  return paths;
+}
+
+/**
+ * Replace the entries of base at or inside the given paths with the entries
+ * of a diff restricted to them.
+ */
+ScmStatus updateStatus(
+    ScmStatus base,
+    const std::vector<RelativePath>& paths,
+    ScmStatus update) {
+  auto& entries = *base.entries();
+  for (const auto& path : paths) {
+    entries.erase(path.asString());
+    auto prefix = path.asString() + '/';
+    auto it = entries.lower_bound(prefix);
+    while (it != entries.end() &&
+           folly::StringPiece{it->first}.startsWith(prefix)) {
+      it = entries.erase(it);
+    }
+  }
+  for (auto& [path, status] : *update.entries()) {
+    entries.insert_or_assign(path, status);
+  }
+  base.errors() = std::move(*update.errors());
+  return base;
+}
+} // namespace
+
+ImmediateFuture<std::unique_ptr<ScmStatus>> EdenMount::diffWithStatusCache(
+    TreeInodePtr rootInode,
+    const RootId& commitHash,
+    folly::CancellationToken cancellation,
+    bool listIgnored) {
+  auto& stats = getStats();
+
+  // Read before diffing, so that changes made during the diff are diffed
+  // again by the next call.
+  auto latest = journal_->getLatest();
+  uint64_t sequence = latest ? latest->sequenceID : 0;
+  auto topLevelIgnoresVersion = serverState_->getTopLevelIgnoresVersion();
+
+  std::optional<ScmStatus> base;
+  uint64_t baseSequence = 0;
+  {
+    auto cache = statusCache_.rlock();
+    const auto& cached = (*cache)[listIgnored];
+    if (cached && cached->commitHash == commitHash &&
+        cached->topLevelIgnoresVersion == topLevelIgnoresVersion) {
+      base = cached->status;
+      baseSequence = cached->sequence;
+    }
+  }
+
+  std::vector<RelativePath> changedPaths;
+  if (base) {
+    std::unique_ptr<JournalDeltaRange> range;
+    if (baseSequence != sequence) {
+      range = journal_->accumulateRange(baseSequence + 1);
+    }
+    if (!range) {
+      stats->increment(&JournalStats::statusCacheHit);
+      return std::make_unique<ScmStatus>(std::move(*base));
+    }
+    std::optional<std::vector<RelativePath>> changes;
+    // On case-insensitive mounts, the journal may not spell paths the way the
+    // diff does.
+    if (getCheckoutConfig()->getCaseSensitive() == CaseSensitivity::Sensitive) {
+      changes = getStatusCacheChanges(
+          *range, getEdenConfig()->statusCacheMaxChangedPaths.getValue());
+    }
+    if (changes) {
+      changedPaths = std::move(*changes);
+    } else {
+      base.reset();
+    }
+  }
+  stats->increment(
+      base ? &JournalStats::statusCacheIncremental
+           : &JournalStats::statusCacheMiss);
+
+  auto callback = std::make_unique<ScmStatusDiffCallback>();
+  auto context = createDiffContext(callback.get(), cancellation, listIgnored);
+  if (base) {
+    context->restrictTo(changedPaths);
+  }
+  auto* contextPtr = context.get();
+
+  return diff(rootInode, contextPtr, commitHash)
+      .thenValue([this,
+                  // Keep the DiffContext and the mount alive until the diff
+                  // completes.
+                  context = std::move(context),
+                  rootInode,
+                  callback = std::move(callback),
+                  base = std::move(base),
+                  changedPaths = std::move(changedPaths),
+                  commitHash,
+                  listIgnored,
+                  sequence,
+                  topLevelIgnoresVersion](auto&&) mutable {
+        auto status = callback->extractStatus();
+        if (base) {
+          status =
+              updateStatus(std::move(*base), changedPaths, std::move(status));
+        }
+        // A cancelled diff may be missing entries.
+        if (status.errors()->empty() && !context->isCancelled()) {
+          auto cache = statusCache_.wlock();
+          auto& cached = (*cache)[listIgnored];
+          if (!cached || cached->sequence <= sequence) {
+            cached = CachedStatus{
+                commitHash, topLevelIgnoresVersion, sequence, status};
+          }
+        }
+        return std::make_unique<ScmStatus>(std::move(status));
+      });
+}
+
 void EdenMount::resetParent(const RootId& parent) {
   // Hold the snapshot lock around the entire operation.
   auto parentLock = parentState_.wlock();
@@ -1927,6 +2452,11 @@ std::unique_ptr<FuseChannel, FsChannelDeleter> makeFuseChannel(
       mount->getCheckoutConfig()->getRequireUtf8Path(),
       edenConfig->fuseMaximumRequests.getValue(),
       mount->getCheckoutConfig()->getUseWriteBackCache(),
+      edenConfig->fuseMaxWrite.getValue(),
+      edenConfig->fuseCloneDevicePerThread.getValue(),
+      edenConfig->fuseUseReaddirplus.getValue(),
+      edenConfig->fuseNumInvalidationThreads.getValue(),
+      edenConfig->fuseInitialWorkerThreads.getValue(),
       mount->getServerState()
           ->getEdenConfig()
           ->FuseTraceBusCapacity.getValue());
@@ -2307,9 +2837,11 @@ struct stat EdenMount::initStatData() const {
 
 std::optional<ActivityBuffer<InodeTraceEvent>>
 EdenMount::initInodeActivityBuffer() {
-  if (serverState_->getEdenConfig()->enableActivityBuffer.getValue()) {
+  auto config = serverState_->getEdenConfig();
+  if (config->enableActivityBuffer.getValue()) {
     return std::make_optional<ActivityBuffer<InodeTraceEvent>>(
-        serverState_->getEdenConfig()->activityBufferMaxEvents.getValue());
+        config->activityBufferMaxEvents.getValue(),
+        config->activityBufferMaxBytes.getValue());
   }
   return std::nullopt;
 }
@@ -2342,6 +2874,93 @@ void EdenMount::subscribeInodeActivityBuffer() {
   }
 }
 
+uint64_t EdenMount::restoreJournal() {
+  auto newGeneration = globalProcessGeneration | ++mountGeneration;
+#ifndef _WIN32
+  if (!serverState_->getEdenConfig()->persistJournal.getValue()) {
+    return newGeneration;
+  }
+  auto journalPath = checkoutConfig_->getClientDirectory() + kJournalName;
+  auto contents = readFile(journalPath);
+  if (contents.hasException()) {
+    // The mount wasn't unmounted cleanly, or wasn't mounted before.
+    return newGeneration;
+  }
+  // Changes made from now on aren't in the saved journal, it mustn't be
+  // restored after a crash.
+  std::remove(journalPath.c_str());
+
+  folly::ByteRange data{folly::StringPiece{contents.value()}};
+  if (data.size() < sizeof(uint64_t)) {
+    XLOG(WARN) << "ignoring truncated journal " << journalPath;
+    return newGeneration;
+  }
+  auto savedGeneration =
+      folly::Endian::big(folly::loadUnaligned<uint64_t>(data.data()));
+  data.advance(sizeof(uint64_t));
+  if (!journal_->deserialize(data)) {
+    XLOG(WARN) << "ignoring invalid journal " << journalPath;
+    return newGeneration;
+  }
+  XLOG(DBG2) << "restored the journal of " << getPath();
+  return savedGeneration;
+#else
+  // The working copy can be modified while EdenFS isn't running, without the
+  // journal recording it.
+  return newGeneration;
+#endif
+}
+
+void EdenMount::saveJournal() {
+#ifndef _WIN32
+  if (!serverState_->getEdenConfig()->persistJournal.getValue()) {
+    return;
+  }
+  auto journal = journal_->serialize();
+  std::string contents(sizeof(uint64_t), '\0');
+  folly::storeUnaligned(contents.data(), folly::Endian::big(mountGeneration_));
+  contents.append(
+      reinterpret_cast<const char*>(journal.data()), journal.length());
+
+  auto journalPath = checkoutConfig_->getClientDirectory() + kJournalName;
+  auto result = writeFileAtomic(
+      journalPath, folly::ByteRange{folly::StringPiece{contents}});
+  if (result.hasException()) {
+    XLOG(WARN) << "unable to save the journal of " << getPath() << ": "
+               << result.exception().what();
+  }
+#endif
+}
+
+void EdenMount::subscribePrefetchPredictor() {
+  auto config = serverState_->getEdenConfig();
+  if (!config->enableLocalPredictivePrefetch.getValue()) {
+    return;
+  }
+  prefetchPredictor_ = std::make_unique<PrefetchPredictor>(
+      checkoutConfig_->getClientDirectory() + kPrefetchPredictorModelName,
+      size_t{config->predictivePrefetchProfileSize.getValue()} *
+          kPrefetchPredictorModelFactor);
+  prefetchPredictorHandle_ = inodeTraceBus_->subscribeFunction(
+      fmt::format("inode-prefetchpredictor-{}", getPath().basename()),
+      [this](const InodeTraceEvent& event) {
+        if (event.inodeType != InodeType::FILE ||
+            event.eventType != InodeEventType::LOAD ||
+            event.progress != InodeEventProgress::END) {
+          return;
+        }
+        // As in subscribeInodeActivityBuffer, this acquires the InodeMap data_
+        // lock and an InodeBase's location_ lock, which is safe here.
+        try {
+          auto relativePath = inodeMap_->getPathForInode(event.ino);
+          if (relativePath.has_value()) {
+            prefetchPredictor_->recordFileLoad(*relativePath);
+          }
+        } catch (const std::system_error& /* e */) {
+        }
+      });
+}
+
 void EdenMount::publishInodeTraceEvent(InodeTraceEvent&& event) noexcept {
   if (!getEdenConfig()->enableInodeTraceBus.getValue()) {
     return;
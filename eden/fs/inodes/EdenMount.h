@@ -17,6 +17,7 @@
 #include <folly/futures/SharedPromise.h>
 #include <folly/logging/Logger.h>
 #include <folly/portability/GFlags.h>
+#include <array>
 #include <chrono>
 #include <memory>
 #include <mutex>
@@ -41,6 +42,7 @@
 #include "eden/fs/telemetry/ActivityBuffer.h"
 #include "eden/fs/telemetry/IActivityRecorder.h"
 #include "eden/fs/telemetry/TraceBus.h"
+#include "eden/fs/utils/InFlightDeduplicator.h"
 #include "eden/fs/utils/PathFuncs.h"
 
 #ifndef _WIN32
@@ -80,6 +82,7 @@ class Nfsd3;
 class ObjectStore;
 class Overlay;
 class OverlayFileAccess;
+class PrefetchPredictor;
 class PrjfsChannel;
 class ServerState;
 class Tree;
@@ -216,6 +219,7 @@ struct CheckoutTimes {
   using duration = std::chrono::steady_clock::duration;
   duration didLookupTrees{};
   duration didDiff{};
+  duration didPrefetch{};
   duration didAcquireRenameLock{};
   duration didCheckout{};
   duration didFinish{};
@@ -236,6 +240,26 @@ struct CheckoutResult {
   CheckoutTimes times;
 };
 
+/**
+ * An estimate of the work that checking out a commit would do, computed by
+ * EdenMount::estimateCheckout().
+ */
+struct CheckoutEstimate {
+  // Files and symlinks that differ between the two commits.
+  uint64_t changedFiles{0};
+  // Changed files that exist in the new commit. Checkout does not fetch their
+  // blobs, but reading all of them afterwards would.
+  uint64_t blobsToFetch{0};
+  // Source control trees that differ between the two commits and had to be
+  // fetched from the network to compute this estimate.
+  uint64_t treesFetched{0};
+  // Changed files whose inode is loaded, which checkout updates one by one.
+  uint64_t loadedInodesAffected{0};
+  // Changed files that are materialized, or inside a materialized directory
+  // that is not loaded. Each of these may become a checkout conflict.
+  uint64_t materializedConflicts{0};
+};
+
 struct SetPathObjectIdResultAndTimes {
   SetPathObjectIdResult result;
   SetPathObjectIdTimes times;
@@ -764,6 +788,18 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
       folly::StringPiece thriftMethodCaller,
       CheckoutMode checkoutMode = CheckoutMode::NORMAL);
 
+  /**
+   * Estimate the work that checkout() would do to move the working copy to
+   * snapshotHash, without changing anything.
+   *
+   * This diffs the source control trees of the current commit and
+   * snapshotHash, fetching the trees that differ as a side effect, and then
+   * looks up the inode of each changed file without loading any inode.
+   */
+  ImmediateFuture<CheckoutEstimate> estimateCheckout(
+      const RootId& snapshotHash,
+      folly::CancellationToken cancellation);
+
   /**
    * Chown the repository to the given uid and gid
    */
@@ -798,6 +834,21 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
       bool listIgnored = false,
       bool enforceCurrentParent = true);
 
+  /**
+   * This accepts a callback which will be invoked as differences are found.
+   * Note that the callback methods may be invoked simultaneously from multiple
+   * different threads, and the callback is responsible for performing
+   * synchronization (if it is needed). It will be packaged into a DiffContext
+   * and passed through the TreeInode diff() codepath
+   */
+  FOLLY_NODISCARD ImmediateFuture<folly::Unit> diff(
+      TreeInodePtr rootInode,
+      DiffCallback* callback,
+      const RootId& commitHash,
+      bool listIgnored,
+      bool enforceCurrentParent,
+      folly::CancellationToken cancellation) const;
+
   /**
    * This version of diff is primarily intended for testing.
    * Use diff(DiffCallback* callback, bool listIgnored) instead.
@@ -850,6 +901,15 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
     return *inodeTraceBus_;
   }
 
+  /**
+   * Returns the model of the directories read from between checkouts, or null
+   * unless local predictive prefetching was enabled when the mount was
+   * created.
+   */
+  PrefetchPredictor* getPrefetchPredictor() const {
+    return prefetchPredictor_.get();
+  }
+
   /**
    * Returns the last checkout time in the Eden mount.
    */
@@ -976,6 +1036,26 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
    */
   void subscribeInodeActivityBuffer();
 
+  /**
+   * Restore the journal saved by saveJournal() when the mount was last
+   * unmounted, if any, and return its mount generation. Otherwise, return a
+   * new mount generation.
+   */
+  uint64_t restoreJournal();
+
+  /**
+   * Save the journal and the mount generation in the client directory, for
+   * the next incarnation of the mount to carry on from them.
+   */
+  void saveJournal();
+
+  /**
+   * Creates prefetchPredictor_ if local predictive prefetching is enabled, and
+   * subscribes it to the file loads published to the inodeTraceBus_. As with
+   * subscribeInodeActivityBuffer, paths are computed by the subscriber.
+   */
+  void subscribePrefetchPredictor();
+
   /**
    * Helper function to publish a new InodeTraceEvent to the mount's
    * inodeTraceBus for telemetry. Used in FileInode, TreeInode, and InodeMap.
@@ -1123,6 +1203,7 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
   friend class RenameLock;
   friend class SharedRenameLock;
   class JournalDiffCallback;
+  class CheckoutPrefetchCallback;
 
   /**
    * Attempt to transition from expected -> newState.
@@ -1198,19 +1279,32 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
       bool listIgnored = false) const;
 
   /**
-   * This accepts a callback which will be invoked as differences are found.
-   * Note that the callback methods may be invoked simultaneously from multiple
-   * different threads, and the callback is responsible for performing
-   * synchronization (if it is needed). It will be packaged into a DiffContext
-   * and passed through the TreeInode diff() codepath
+   * Returns the error that a diff against commitHash fails with when it
+   * enforces the current parent, or an empty exception_wrapper if it may
+   * proceed.
    */
-  FOLLY_NODISCARD ImmediateFuture<folly::Unit> diff(
+  folly::exception_wrapper checkDiffParent(const RootId& commitHash) const;
+
+  /**
+   * The status diff() shared by the identical requests that arrive while it
+   * runs. The caller has already checked the working directory parent.
+   */
+  ImmediateFuture<std::unique_ptr<ScmStatus>> computeStatus(
       TreeInodePtr rootInode,
-      DiffCallback* callback,
       const RootId& commitHash,
-      bool listIgnored,
-      bool enforceCurrentParent,
-      folly::CancellationToken cancellation) const;
+      folly::CancellationToken cancellation,
+      bool listIgnored);
+
+  /**
+   * The diff() behind status calls when hg:enable-status-cache is set. It
+   * starts from the last status computed against the same commit, and only
+   * diffs the paths that the journal recorded changes to since then.
+   */
+  ImmediateFuture<std::unique_ptr<ScmStatus>> diffWithStatusCache(
+      TreeInodePtr rootInode,
+      const RootId& commitHash,
+      folly::CancellationToken cancellation,
+      bool listIgnored);
 
   /**
    * Signal to unmount() that fsChannelMount() or takeoverFuse() has started.
@@ -1327,6 +1421,8 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
   /**
    * A number to uniquely identify this particular incarnation of this mount.
    * We use bits from the process id and the time at which we were mounted.
+   * When the journal saved by a previous incarnation is restored, its
+   * generation is kept so that the positions it gave out stay valid.
    */
   const uint64_t mountGeneration_;
 
@@ -1351,6 +1447,26 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
    */
   std::atomic<EdenTimestamp> lastCheckoutTime_;
 
+  struct CachedStatus {
+    RootId commitHash;
+    size_t topLevelIgnoresVersion;
+    // The latest journal sequence number when the diff started.
+    uint64_t sequence;
+    ScmStatus status;
+  };
+
+  /**
+   * The last status computed without errors by diffWithStatusCache(),
+   * indexed by whether it lists ignored files.
+   */
+  folly::Synchronized<std::array<std::optional<CachedStatus>, 2>> statusCache_;
+
+  /**
+   * Status diffs in progress, keyed by commit, listIgnored, journal position
+   * and top-level ignores version.
+   */
+  InFlightDeduplicator<std::string, ScmStatus> inFlightStatus_;
+
   struct MountingUnmountingState {
     bool fsChannelMountStarted() const noexcept;
     bool fsChannelUnmountStarted() const noexcept;
@@ -1429,8 +1545,11 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
    */
   std::optional<ActivityBuffer<InodeTraceEvent>> inodeActivityBuffer_;
 
+  std::unique_ptr<PrefetchPredictor> prefetchPredictor_;
+
   std::shared_ptr<TraceBus<InodeTraceEvent>> inodeTraceBus_;
   TraceSubscriptionHandle<InodeTraceEvent> inodeTraceHandle_;
+  TraceSubscriptionHandle<InodeTraceEvent> prefetchPredictorHandle_;
 
   FsChannelPtr channel_;
 
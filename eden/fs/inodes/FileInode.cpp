@@ -166,6 +166,7 @@ void FileInode::LockedState::setMaterialized() {
 
 #ifndef _WIN32
   ptr_->readByteRanges.clear();
+  ptr_->readBlob.store(nullptr);
 #endif
 }
 
@@ -479,6 +480,7 @@ void FileInodeState::checkInvariants() {
       XCHECK(!blobLoadingPromise);
 #ifndef _WIN32
       XCHECK(readByteRanges.empty());
+      XDCHECK(!readBlob.load());
 #endif
       return;
   }
@@ -967,11 +969,12 @@ void FileInode::updateBlockCount(FOLLY_MAYBE_UNUSED struct stat& st) {
 }
 
 #ifndef _WIN32
-void FileInode::fsync(bool datasync) {
+ImmediateFuture<folly::Unit> FileInode::fsync(bool datasync) {
   auto state = LockedState{this};
-  if (state->isMaterialized()) {
-    getOverlayFileAccess(state)->fsync(*this, datasync);
+  if (!state->isMaterialized()) {
+    return folly::unit;
   }
+  return getOverlayFileAccess(state)->fsyncAsync(*this, datasync);
 }
 
 ImmediateFuture<folly::Unit> FileInode::fallocate(
@@ -1046,14 +1049,119 @@ ImmediateFuture<string> FileInode::readAll(
       });
 }
 
+#ifndef _WIN32
+namespace {
+/**
+ * Slice [off, off + size) out of the blob's IOBuf chain. The result shares the
+ * blob's buffers, so that channels can hand them to writev() or the XDR
+ * serializer without copying the data.
+ */
+std::tuple<BufVec, bool>
+readBlobRange(const Blob& blob, size_t size, FileOffset off) {
+  folly::io::Cursor cursor(&blob.getContents());
+
+  if (!cursor.canAdvance(off)) {
+    // Seek beyond EOF.  Return an empty result.
+    return {BufVec{folly::IOBuf::wrapBuffer("", 0)}, true};
+  }
+
+  cursor.skip(off);
+
+  std::unique_ptr<folly::IOBuf> result;
+  cursor.cloneAtMost(result, size);
+
+  return {BufVec{std::move(result)}, cursor.isAtEnd()};
+}
+} // namespace
+
+void FileInode::recordBlobReadLocked(
+    State& state,
+    const std::shared_ptr<const Blob>& blob,
+    FileOffset off,
+    size_t size) {
+  state.readByteRanges.add(off, off + size);
+  if (state.readByteRanges.covers(0, blob->getSize())) {
+    XLOG(DBG4) << "Inode " << getNodeId()
+               << " dropping interest for blob because it's been fully read.";
+    state.interestHandle.reset();
+    state.readByteRanges.clear();
+    state.readBlob.store(nullptr);
+  } else {
+    state.readBlob.store(blob);
+  }
+}
+#endif // !_WIN32
+
 ImmediateFuture<std::tuple<BufVec, bool>> FileInode::read(
     size_t size,
     FileOffset off,
     const ObjectFetchContextPtr& context) {
 #ifndef _WIN32
   XDCHECK_GE(off, 0);
+
+  // Build systems read the same files over and over: serve reads of a blob
+  // that is still being read without waiting for the state lock or fetching
+  // it from the BlobCache again.
+  if (auto blob = state_.unsafeGetUnlocked().readBlob.load()) {
+    auto result = readBlobRange(*blob, size, off);
+    // The read range and atime are best effort: if another thread holds the
+    // lock, the blob stays cached until a later read completes its coverage,
+    // or the file is materialized or unloaded.
+    if (auto state = state_.tryWLock();
+        state && state->readBlob.load() == blob) {
+      if (getMount()->getBlobCache()->contains(
+              state->nonMaterializedState.hash)) {
+        recordBlobReadLocked(*state, blob, off, size);
+      } else {
+        // The BlobCache evicted the blob: stop keeping it alive outside of
+        // its accounting, and forget the ranges as getCachedBlob() does.
+        state->interestHandle.reset();
+        state->readByteRanges.clear();
+        state->readBlob.store(nullptr);
+      }
+      updateAtimeLocked(*state);
+    }
+    return result;
+  }
+
+  auto state = LockedState{this};
+  if (state->isMaterialized()) {
+    logAccess(*context);
+    updateAtimeLocked(*state);
+    // TODO(xavierd): For materialized files, only return EOF when read
+    // returned no bytes. This will force some FS Channel (like NFS) to issue
+    // at least 2 read calls: one for reading the entire file, and the second
+    // one to get the EOF bit.
+    auto future = getOverlayFileAccess(state)->readAsync(*this, size, off);
+    state.unlock();
+    return std::move(future).thenValue([size](BufVec&& buf) {
+      auto eof = size != 0 && buf->empty();
+      return std::tuple<BufVec, bool>{std::move(buf), eof};
+    });
+  }
+
+  auto* blobCache = getMount()->getBlobCache();
+  if (state->tag == State::BLOB_NOT_LOADING &&
+      blobCache->isChunkingEnabled() &&
+      !blobCache->contains(state->nonMaterializedState.hash)) {
+    // The blob may be large enough to be cached by chunks: only the chunks
+    // that this read covers are kept in memory. Blobs that turn out to be
+    // small are cached whole, and later reads take the path below.
+    logAccess(*context);
+    updateAtimeLocked(*state);
+    auto hash = state->nonMaterializedState.hash;
+    state.unlock();
+    return getMount()
+        ->getBlobAccess()
+        ->getBlobRange(hash, static_cast<size_t>(off), size, context)
+        .thenValue([](BlobCache::RangeResult&& range) {
+          return std::tuple<BufVec, bool>{
+              BufVec{std::move(range.data)}, range.eof};
+        });
+  }
+
   return runWhileDataLoaded(
-      LockedState{this},
+      std::move(state),
       BlobCache::Interest::WantHandle,
       // This function is only called by FUSE.
       context,
@@ -1065,12 +1173,8 @@ ImmediateFuture<std::tuple<BufVec, bool>> FileInode::read(
           self->updateAtimeLocked(*state);
         };
 
-        // Materialized either before or during blob load.
+        // Materialized during blob load.
         if (state->isMaterialized()) {
-          // TODO(xavierd): For materialized files, only return EOF when
-          // read returned no bytes. This will force some FS Channel
-          // (like NFS) to issue at least 2 read calls: one for reading
-          // the entire file, and the second one to get the EOF bit.
           auto buf = self->getOverlayFileAccess(state)->read(*self, size, off);
           auto eof = size != 0 && buf->empty();
           return {std::move(buf), eof};
@@ -1081,29 +1185,8 @@ ImmediateFuture<std::tuple<BufVec, bool>> FileInode::read(
         XDCHECK_EQ(state->tag, State::BLOB_NOT_LOADING);
         XDCHECK(blob) << "blob missing after load completed";
 
-        state->readByteRanges.add(off, off + size);
-        if (state->readByteRanges.covers(0, blob->getSize())) {
-          XLOG(DBG4)
-              << "Inode " << self->getNodeId()
-              << " dropping interest for blob because it's been fully read.";
-          state->interestHandle.reset();
-          state->readByteRanges.clear();
-        }
-
-        auto buf = blob->getContents();
-        folly::io::Cursor cursor(&buf);
-
-        if (!cursor.canAdvance(off)) {
-          // Seek beyond EOF.  Return an empty result.
-          return {BufVec{folly::IOBuf::wrapBuffer("", 0)}, true};
-        }
-
-        cursor.skip(off);
-
-        std::unique_ptr<folly::IOBuf> result;
-        cursor.cloneAtMost(result, size);
-
-        return {BufVec{std::move(result)}, cursor.isAtEnd()};
+        self->recordBlobReadLocked(*state, blob, off, size);
+        return readBlobRange(*blob, size, off);
       });
 #else
   (void)size;
@@ -1120,8 +1203,14 @@ ImmediateFuture<size_t> FileInode::write(
     FileOffset off,
     const ObjectFetchContextPtr& fetchContext) {
 #ifndef _WIN32
+  auto state = LockedState{this};
+  if (state->isMaterialized() && getOverlayFileAccess(state)->isAsync()) {
+    state->materializedState.invalidate();
+    return writeAsyncImpl(state, std::move(buf), off);
+  }
+
   return runWhileMaterialized(
-      LockedState{this},
+      std::move(state),
       nullptr,
       [buf = std::move(buf), off, self = inodePtrFromThis()](
           LockedState&& state) {
@@ -1221,6 +1310,30 @@ size_t FileInode::writeImpl(
   return xfer;
 }
 
+ImmediateFuture<size_t>
+FileInode::writeAsyncImpl(LockedState& state, BufVec&& buf, FileOffset off) {
+  XDCHECK_EQ(state->tag, State::MATERIALIZED_IN_OVERLAY);
+
+  auto future =
+      getOverlayFileAccess(state)->writeAsync(*this, std::move(buf), off);
+
+  updateMtimeAndCtimeLocked(*state, getNow());
+
+  state.unlock();
+
+  return std::move(future).thenValue([self = inodePtrFromThis()](size_t xfer) {
+    {
+      // The size may have been cached again before the write landed.
+      auto stateLock = LockedState{self};
+      if (stateLock->isMaterialized()) {
+        stateLock->materializedState.invalidate();
+      }
+    }
+    self->updateJournal();
+    return xfer;
+  });
+}
+
 ImmediateFuture<size_t> FileInode::write(
     folly::StringPiece data,
     FileOffset off,
@@ -1230,6 +1343,11 @@ ImmediateFuture<size_t> FileInode::write(
   // If we are currently materialized we don't need to copy the input data.
   if (state->isMaterialized()) {
     state->materializedState.invalidate();
+    if (getOverlayFileAccess(state)->isAsync()) {
+      // The caller's buffer does not outlive this call.
+      auto buf = folly::IOBuf::copyBuffer(data.data(), data.size());
+      return writeAsyncImpl(state, BufVec{std::move(buf)}, off);
+    }
     struct iovec iov;
     iov.iov_base = const_cast<char*>(data.data());
     iov.iov_len = data.size();
@@ -1355,7 +1473,11 @@ void FileInode::materializeNow(
   }
 
   getOverlayFileAccess(state)->createFile(
-      getNodeId(), *blob, blobSha1, blobBlake3);
+      getNodeId(),
+      state->nonMaterializedState.hash,
+      std::move(blob),
+      blobSha1,
+      blobBlake3);
 
   state.setMaterialized();
 }
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <folly/Synchronized.h>
+#include <folly/concurrency/AtomicSharedPtr.h>
 #include <folly/futures/SharedPromise.h>
 #include <chrono>
 #include <optional>
@@ -21,6 +22,7 @@
 #include "eden/fs/store/ImportPriority.h"
 #include "eden/fs/utils/BufVec.h"
 #include "eden/fs/utils/CoverageSet.h"
+#include "eden/fs/utils/FreeListAllocator.h"
 
 namespace folly {
 class File;
@@ -176,10 +178,29 @@ struct FileInodeState {
    * Records the ranges that have been read() when not materialized.
    */
   CoverageSet readByteRanges;
+
+  /**
+   * The blob of a non-materialized file while it is still being read, i.e.
+   * while interestHandle is held because readByteRanges doesn't cover it yet.
+   *
+   * Unlike the rest of the state, this is loaded without the lock by
+   * FileInode::read(): the contents of a non-materialized file are immutable,
+   * so repeated reads can be served from it directly. It is only set with
+   * the lock held, and cleared before the file is materialized or once
+   * read() finds that the BlobCache no longer contains the blob.
+   */
+  folly::atomic_shared_ptr<const Blob> readBlob;
 #endif
 };
 
-class FileInode final : public InodeBaseMetadata<FileInodeState> {
+/**
+ * Represents a file in the file system.
+ *
+ * Loading a large directory allocates many FileInodes at once, and unloading
+ * frees them in bulk, so they are recycled through a FreeListAllocator.
+ */
+class FileInode final : public InodeBaseMetadata<FileInodeState>,
+                        public FreeListAllocated<FileInode> {
  public:
   using Base = InodeBaseMetadata<FileInodeState>;
 
@@ -336,7 +357,7 @@ class FileInode final : public InodeBaseMetadata<FileInodeState> {
       FileOffset off,
       const ObjectFetchContextPtr& fetchContext);
 
-  void fsync(bool datasync);
+  ImmediateFuture<folly::Unit> fsync(bool datasync);
 
   FOLLY_NODISCARD ImmediateFuture<folly::Unit> fallocate(
       uint64_t offset,
@@ -352,6 +373,11 @@ class FileInode final : public InodeBaseMetadata<FileInodeState> {
   ImmediateFuture<struct stat> stat(
       const ObjectFetchContextPtr& context) override;
 
+  /**
+   * Update the st_blocks field in a stat structure based on the st_size value.
+   */
+  static void updateBlockCount(struct stat& st);
+
  private:
   using State = FileInodeState;
   class LockedState;
@@ -519,12 +545,15 @@ class FileInode final : public InodeBaseMetadata<FileInodeState> {
       const struct iovec* iov,
       size_t numIovecs,
       FileOffset off);
-#endif // !_WIN32
 
   /**
-   * Update the st_blocks field in a stat structure based on the st_size value.
+   * Like writeImpl, but the write completes on the overlay IO threads after
+   * the lock is released. Writes are queued in the order they are issued
+   * under the lock, and a later truncate waits for them to complete.
    */
-  static void updateBlockCount(struct stat& st);
+  ImmediateFuture<size_t>
+  writeAsyncImpl(LockedState& state, BufVec&& buf, FileOffset off);
+#endif // !_WIN32
 
 #ifdef _WIN32
   /**
@@ -539,6 +568,18 @@ class FileInode final : public InodeBaseMetadata<FileInodeState> {
    */
   void logAccess(const ObjectFetchContext& fetchContext);
 
+#ifndef _WIN32
+  /**
+   * Record that [off, off + size) of the non-materialized blob was read, and
+   * drop this inode's interest in the blob once all of it has been.
+   */
+  void recordBlobReadLocked(
+      State& state,
+      const std::shared_ptr<const Blob>& blob,
+      FileOffset off,
+      size_t size);
+#endif // !_WIN32
+
   folly::Synchronized<State> state_;
 
   // So it can call inodePtrFromThis() for better error messages.
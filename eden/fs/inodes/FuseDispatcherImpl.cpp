@@ -9,6 +9,8 @@
 
 #include "eden/fs/inodes/FuseDispatcherImpl.h"
 #include <folly/logging/xlog.h>
+#include <algorithm>
+#include <limits>
 #include "eden/fs/fuse/FuseDirList.h"
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/FileInode.h"
@@ -46,6 +48,14 @@ fuse_entry_out computeEntryParam(const FuseDispatcher::Attr& attr) {
 
 constexpr int64_t kBrokenInodeCacheSeconds = 5;
 
+uint64_t computeAttrTimeoutSeconds(std::chrono::nanoseconds timeout) {
+  // The macOS kext adds the timeout to a timespec as a signed 32 bit value;
+  // see FuseDispatcher::Attr.
+  auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+  return std::clamp<int64_t>(
+      seconds.count(), 0, std::numeric_limits<int32_t>::max());
+}
+
 FuseDispatcher::Attr attrForInodeWithCorruptOverlay(InodeNumber ino) noexcept {
   struct stat st = {};
   st.st_ino = ino.get();
@@ -57,17 +67,45 @@ FuseDispatcher::Attr attrForInodeWithCorruptOverlay(InodeNumber ino) noexcept {
 FuseDispatcherImpl::FuseDispatcherImpl(EdenMount* mount)
     : FuseDispatcher(mount->getStats().copy()),
       mount_(mount),
-      inodeMap_(mount_->getInodeMap()) {}
+      inodeMap_(mount_->getInodeMap()),
+      attrTimeoutSeconds_(computeAttrTimeoutSeconds(
+          mount->getEdenConfig()->fuseAttributeTimeout.getValue())),
+      kernelCacheTracker_(
+          mount->getEdenConfig()->kernelCacheSampleRate.getValue(),
+          mount->getEdenConfig()->kernelCacheMaxSampledInodes.getValue(),
+          mount->getEdenConfig()->fuseAttributeTimeout.getValue()) {}
+
+FuseDispatcher::Attr FuseDispatcherImpl::makeAttr(const struct stat& st) const {
+  return FuseDispatcher::Attr{st, attrTimeoutSeconds_};
+}
+
+void FuseDispatcherImpl::recordKernelCacheRequest(
+    InodeNumber ino,
+    KernelCacheTracker::Request request) {
+  if (!kernelCacheTracker_.isSampled(ino)) {
+    return;
+  }
+  bool isLookup = request == KernelCacheTracker::Request::Lookup;
+  auto& stats = getStats();
+  stats->increment(
+      isLookup ? &FuseStats::sampledLookup : &FuseStats::sampledGetattr);
+  if (kernelCacheTracker_.recordRequest(
+          ino, request, KernelCacheTracker::Clock::now())) {
+    stats->increment(
+        isLookup ? &FuseStats::repeatedLookup : &FuseStats::repeatedGetattr);
+  }
+}
 
 ImmediateFuture<FuseDispatcher::Attr> FuseDispatcherImpl::getattr(
     InodeNumber ino,
     const ObjectFetchContextPtr& context) {
+  recordKernelCacheRequest(ino, KernelCacheTracker::Request::Getattr);
   return inodeMap_->lookupInode(ino)
       .thenValue([context = context.copy()](const InodePtr& inode) {
         return inode->stat(context);
       })
       .thenValue(
-          [](const struct stat& st) { return FuseDispatcher::Attr{st}; });
+          [this](const struct stat& st) { return makeAttr(st); });
 }
 
 ImmediateFuture<uint64_t> FuseDispatcherImpl::opendir(
@@ -101,13 +139,15 @@ ImmediateFuture<fuse_entry_out> FuseDispatcherImpl::lookup(
                   context = context.copy()](const TreeInodePtr& tree) {
         return tree->getOrLoadChild(name, context);
       })
-      .thenValue([context = context.copy()](const InodePtr& inode) {
+      .thenValue([this, context = context.copy()](const InodePtr& inode) {
+        recordKernelCacheRequest(
+            inode->getNodeId(), KernelCacheTracker::Request::Lookup);
         return makeImmediateFutureWith([&]() { return inode->stat(context); })
-            .thenTry([inode](folly::Try<struct stat> maybeStat) {
+            .thenTry([this, inode](folly::Try<struct stat> maybeStat) {
               if (maybeStat.hasValue()) {
                 inode->incFsRefcount();
                 return computeEntryParam(
-                    FuseDispatcher::Attr{maybeStat.value()});
+                    makeAttr(maybeStat.value()));
               } else {
                 // The most common case for stat() failing is if this file is
                 // materialized but the data for it in the overlay is missing
@@ -200,15 +240,18 @@ ImmediateFuture<FuseDispatcher::Attr> FuseDispatcherImpl::setattr(
 
         return inode->setattr(desired, context);
       })
-      .thenValue([](struct stat&& stat) {
-        return FuseDispatcher::Attr{std::move(stat)};
-      });
+      .thenValue([this](struct stat&& stat) { return makeAttr(stat); });
 }
 
 void FuseDispatcherImpl::forget(InodeNumber ino, unsigned long nlookup) {
   inodeMap_->decFsRefcount(ino, nlookup);
 }
 
+void FuseDispatcherImpl::batchForget(
+    folly::Range<const std::pair<InodeNumber, uint32_t>*> forgets) {
+  inodeMap_->decFsRefcounts(forgets);
+}
+
 ImmediateFuture<uint64_t> FuseDispatcherImpl::open(
     InodeNumber /*ino*/,
     int /*flags*/) {
@@ -233,13 +276,13 @@ ImmediateFuture<fuse_entry_out> FuseDispatcherImpl::create(
   // (and thus can be zero)
   mode = S_IFREG | (07777 & mode);
   return inodeMap_->lookupTreeInode(parent).thenValue(
-      [mode, childName = PathComponent{name}, context = context.copy()](
+      [this, mode, childName = PathComponent{name}, context = context.copy()](
           const TreeInodePtr& inode) {
         auto child = inode->mknod(childName, mode, 0, InvalidationRequired::No);
         return child->stat(context).thenValue(
-            [child](struct stat st) -> fuse_entry_out {
+            [this, child](struct stat st) -> fuse_entry_out {
               child->incFsRefcount();
-              return computeEntryParam(FuseDispatcher::Attr{st});
+              return computeEntryParam(makeAttr(st));
             });
       });
 }
@@ -250,10 +293,24 @@ ImmediateFuture<BufVec> FuseDispatcherImpl::read(
     off_t off,
     const ObjectFetchContextPtr& context) {
   return inodeMap_->lookupFileInode(ino).thenValue(
-      [context = context.copy(), size, off](FileInodePtr&& inode) {
+      [this, context = context.copy(), size, off](FileInodePtr&& inode) {
+        // Only the reads of files which aren't materialized are counted: those
+        // are the ones the kernel should cache until they are invalidated.
+        bool sampled = kernelCacheTracker_.isSampled(inode->getNodeId()) &&
+            !inode->isMaterialized();
         return inode->read(size, off, context)
-            .thenValue([](std::tuple<BufVec, bool>&& readRes) {
-              return std::get<BufVec>(std::move(readRes));
+            .thenValue([this, ino = inode->getNodeId(), off, sampled](
+                           std::tuple<BufVec, bool>&& readRes) {
+              auto buf = std::get<BufVec>(std::move(readRes));
+              if (sampled) {
+                auto length = buf->computeChainDataLength();
+                auto& stats = getStats();
+                stats->increment(&FuseStats::sampledReadBytes, length);
+                stats->increment(
+                    &FuseStats::repeatedReadBytes,
+                    kernelCacheTracker_.recordRead(ino, off, length));
+              }
+              return buf;
             });
       });
 }
@@ -335,6 +392,60 @@ ImmediateFuture<FuseDirList> FuseDispatcherImpl::readdir(
       });
 }
 
+ImmediateFuture<FuseDirList> FuseDispatcherImpl::readdirplus(
+    InodeNumber ino,
+    FuseDirList&& dirList,
+    off_t offset,
+    uint64_t /*fh*/,
+    const ObjectFetchContextPtr& context) {
+  return inodeMap_->lookupTreeInode(ino).thenValue(
+      [this, dirList = std::move(dirList), offset, context = context.copy()](
+          TreeInodePtr inode) mutable {
+        auto list = inode->fuseReaddir(std::move(dirList), offset, context);
+        auto entries = list.extract();
+
+        // Each child has to be loaded, as the kernel takes a reference on it
+        // like for a lookup, but all of them are looked up in this request
+        // rather than in one request each. The kernel does not create a
+        // dentry for the entries left without a parameter.
+        std::vector<ImmediateFuture<std::optional<fuse_entry_out>>> futures;
+        futures.reserve(entries.size());
+        for (const auto& entry : entries) {
+          if (entry.name == "." || entry.name == "..") {
+            futures.emplace_back(std::optional<fuse_entry_out>{});
+            continue;
+          }
+          futures.push_back(
+              inode->getOrLoadChild(PathComponent{entry.name}, context)
+                  .thenValue([this, context = context.copy()](InodePtr child) {
+                    return child->stat(context).thenValue(
+                        [this, child](struct stat st) {
+                          child->incFsRefcount();
+                          return std::optional<fuse_entry_out>{
+                              computeEntryParam(makeAttr(st))};
+                        });
+                  })
+                  .thenTry([](folly::Try<std::optional<fuse_entry_out>>&&
+                                  entryParam) {
+                    return entryParam.hasValue() ? entryParam.value()
+                                                 : std::nullopt;
+                  }));
+        }
+        return collectAllSafe(std::move(futures))
+            .thenValue(
+                [list = std::move(list)](
+                    std::vector<std::optional<fuse_entry_out>>&&
+                        entryParams) mutable {
+                  for (size_t i = 0; i < entryParams.size(); ++i) {
+                    if (entryParams[i]) {
+                      list.setEntryParam(i, *entryParams[i]);
+                    }
+                  }
+                  return std::move(list);
+                });
+      });
+}
+
 ImmediateFuture<fuse_entry_out> FuseDispatcherImpl::mknod(
     InodeNumber parent,
     PathComponentPiece name,
@@ -342,14 +453,17 @@ ImmediateFuture<fuse_entry_out> FuseDispatcherImpl::mknod(
     dev_t rdev,
     const ObjectFetchContextPtr& context) {
   return inodeMap_->lookupTreeInode(parent).thenValue(
-      [childName = PathComponent{name}, mode, rdev, context = context.copy()](
-          const TreeInodePtr& inode) {
+      [this,
+       childName = PathComponent{name},
+       mode,
+       rdev,
+       context = context.copy()](const TreeInodePtr& inode) {
         auto child =
             inode->mknod(childName, mode, rdev, InvalidationRequired::No);
         return child->stat(context).thenValue(
-            [child](struct stat st) -> fuse_entry_out {
+            [this, child](struct stat st) -> fuse_entry_out {
               child->incFsRefcount();
-              return computeEntryParam(FuseDispatcher::Attr{st});
+              return computeEntryParam(makeAttr(st));
             });
       });
 }
@@ -360,12 +474,12 @@ ImmediateFuture<fuse_entry_out> FuseDispatcherImpl::mkdir(
     mode_t mode,
     const ObjectFetchContextPtr& context) {
   return inodeMap_->lookupTreeInode(parent).thenValue(
-      [childName = PathComponent{name}, mode, context = context.copy()](
+      [this, childName = PathComponent{name}, mode, context = context.copy()](
           const TreeInodePtr& inode) {
         auto child = inode->mkdir(childName, mode, InvalidationRequired::No);
-        return child->stat(context).thenValue([child](struct stat st) {
+        return child->stat(context).thenValue([this, child](struct stat st) {
           child->incFsRefcount();
-          return computeEntryParam(FuseDispatcher::Attr{st});
+          return computeEntryParam(makeAttr(st));
         });
       });
 }
@@ -400,15 +514,16 @@ ImmediateFuture<fuse_entry_out> FuseDispatcherImpl::symlink(
     StringPiece link,
     const ObjectFetchContextPtr& context) {
   return inodeMap_->lookupTreeInode(parent).thenValue(
-      [linkContents = link.str(),
+      [this,
+       linkContents = link.str(),
        childName = PathComponent{name},
        context = context.copy()](const TreeInodePtr& inode) {
         auto symlinkInode =
             inode->symlink(childName, linkContents, InvalidationRequired::No);
         symlinkInode->incFsRefcount();
         return symlinkInode->stat(context).thenValue(
-            [symlinkInode](struct stat st) {
-              return computeEntryParam(FuseDispatcher::Attr{st});
+            [this, symlinkInode](struct stat st) {
+              return computeEntryParam(makeAttr(st));
             });
       });
 }
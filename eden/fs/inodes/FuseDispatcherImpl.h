@@ -8,6 +8,7 @@
 #pragma once
 
 #include "eden/fs/fuse/FuseDispatcher.h"
+#include "eden/fs/inodes/KernelCacheTracker.h"
 
 namespace facebook::eden {
 
@@ -42,6 +43,8 @@ class FuseDispatcherImpl : public FuseDispatcher {
       const ObjectFetchContextPtr& context) override;
 
   void forget(InodeNumber ino, unsigned long nlookup) override;
+  void batchForget(
+      folly::Range<const std::pair<InodeNumber, uint32_t>*> forgets) override;
   ImmediateFuture<uint64_t> open(InodeNumber ino, int flags) override;
   ImmediateFuture<std::string> readlink(
       InodeNumber ino,
@@ -119,6 +122,13 @@ class FuseDispatcherImpl : public FuseDispatcher {
       uint64_t fh,
       const ObjectFetchContextPtr& context) override;
 
+  ImmediateFuture<FuseDirList> readdirplus(
+      InodeNumber ino,
+      FuseDirList&& dirList,
+      off_t offset,
+      uint64_t fh,
+      const ObjectFetchContextPtr& context) override;
+
   ImmediateFuture<std::string> getxattr(
       InodeNumber ino,
       folly::StringPiece name,
@@ -126,6 +136,13 @@ class FuseDispatcherImpl : public FuseDispatcher {
   ImmediateFuture<std::vector<std::string>> listxattr(InodeNumber ino) override;
 
  private:
+  Attr makeAttr(const struct stat& st) const;
+
+  /** Count the requests repeated for the inodes sampled for kernel caching. */
+  void recordKernelCacheRequest(
+      InodeNumber ino,
+      KernelCacheTracker::Request request);
+
   // The EdenMount associated with this dispatcher.
   EdenMount* const mount_;
 
@@ -134,6 +151,12 @@ class FuseDispatcherImpl : public FuseDispatcher {
   // every FUSE request, and having it locally avoids having to dereference
   // mount_ first.
   InodeMap* const inodeMap_;
+
+  // How long the kernel may cache the attributes and entries we return, from
+  // fuse:attribute-timeout.
+  const uint64_t attrTimeoutSeconds_;
+
+  KernelCacheTracker kernelCacheTracker_;
 };
 
 } // namespace facebook::eden
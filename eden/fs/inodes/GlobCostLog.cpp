@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/GlobCostLog.h"
+
+#include <algorithm>
+
+namespace facebook::eden {
+
+namespace {
+bool isMoreExpensive(const GlobCost& a, const GlobCost& b) {
+  return a.directoriesVisited > b.directoriesVisited;
+}
+} // namespace
+
+GlobCostLog::GlobCostLog(size_t maxEntries)
+    : maxEntries_{std::max(maxEntries, size_t{1})} {}
+
+void GlobCostLog::record(GlobCost cost) {
+  auto costs = costs_.lock();
+  if (costs->size() < maxEntries_) {
+    costs->push_back(std::move(cost));
+    std::push_heap(costs->begin(), costs->end(), isMoreExpensive);
+    return;
+  }
+  if (!isMoreExpensive(cost, costs->front())) {
+    return;
+  }
+  std::pop_heap(costs->begin(), costs->end(), isMoreExpensive);
+  costs->back() = std::move(cost);
+  std::push_heap(costs->begin(), costs->end(), isMoreExpensive);
+}
+
+std::vector<GlobCost> GlobCostLog::getMostExpensive() const {
+  auto costs = *costs_.lock();
+  std::sort(costs.begin(), costs.end(), isMoreExpensive);
+  return costs;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "eden/common/os/ProcessId.h"
+
+namespace facebook::eden {
+
+/**
+ * The work done to evaluate a glob request.
+ */
+struct GlobCost {
+  // A description of the request, with its patterns.
+  std::string request;
+  OptionalProcessId clientPid;
+  uint64_t directoriesVisited = 0;
+  // The trees read from the in-memory or on-disk caches.
+  uint64_t treesFromCache = 0;
+  // The trees fetched from the backing store.
+  uint64_t treesFromBackingStore = 0;
+  uint64_t entriesMatched = 0;
+  // The time spent matching the entries of the directories.
+  std::chrono::microseconds matchingTime{0};
+  std::chrono::microseconds duration{0};
+};
+
+/**
+ * Keeps the costs of the most expensive globs evaluated since EdenFS started,
+ * ranked by the number of directories they visited, so that the callers
+ * scanning the whole repository can be found.
+ */
+class GlobCostLog {
+ public:
+  explicit GlobCostLog(size_t maxEntries);
+
+  GlobCostLog(const GlobCostLog&) = delete;
+  GlobCostLog& operator=(const GlobCostLog&) = delete;
+
+  void record(GlobCost cost);
+
+  /**
+   * Returns the costs kept, from the most expensive glob to the least.
+   */
+  std::vector<GlobCost> getMostExpensive() const;
+
+ private:
+  const size_t maxEntries_;
+  // A min-heap on the number of directories visited, so that the cheapest
+  // glob kept is the one replaced.
+  folly::Synchronized<std::vector<GlobCost>, std::mutex> costs_;
+};
+
+} // namespace facebook::eden
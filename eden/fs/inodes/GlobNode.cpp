@@ -6,6 +6,12 @@
  */
 
 #include "eden/fs/inodes/GlobNode.h"
+#include <folly/ScopeGuard.h>
+#include <folly/futures/Future.h>
+#include <folly/logging/xlog.h>
+#include <folly/stop_watch.h>
+#include <algorithm>
+#include <atomic>
 #include <iomanip>
 #include <iostream>
 #include "eden/fs/inodes/TreeInode.h"
@@ -146,12 +152,59 @@ struct TreeRoot {
 };
 } // namespace
 
+struct GlobNode::EvaluationExecutor {
+  EvaluationExecutor(
+      std::shared_ptr<folly::Executor> executor,
+      size_t maxConcurrency)
+      : executor{std::move(executor)}, maxConcurrency{maxConcurrency} {}
+
+  bool tryAcquireSlot() {
+    auto inUse = slotsInUse.load(std::memory_order_relaxed);
+    do {
+      if (inUse >= maxConcurrency) {
+        return false;
+      }
+    } while (!slotsInUse.compare_exchange_weak(
+        inUse, inUse + 1, std::memory_order_relaxed));
+    return true;
+  }
+
+  void releaseSlot() {
+    XDCHECK_GT(slotsInUse.load(std::memory_order_relaxed), 0u);
+    slotsInUse.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  const std::shared_ptr<folly::Executor> executor;
+  const size_t maxConcurrency;
+  std::atomic<size_t> slotsInUse{0};
+};
+
+template <typename Func>
+ImmediateFuture<folly::Unit> GlobNode::runOnExecutor(
+    EvaluationExecutor* executor,
+    Func func) {
+  if (!executor || !executor->tryAcquireSlot()) {
+    return func();
+  }
+  return folly::via(
+      executor->executor.get(), [executor, func = std::move(func)]() mutable {
+        SCOPE_EXIT {
+          // Only the synchronous part of the evaluation of the subtree counts
+          // against the concurrency limit, since the rest of it waits on
+          // fetches.
+          executor->releaseSlot();
+        };
+        return func().semi();
+      });
+}
+
 GlobNode::GlobNode(
     StringPiece pattern,
     bool includeDotfiles,
     bool hasSpecials,
     CaseSensitivity caseSensitive)
     : pattern_(pattern.str()),
+      caseSensitive_(caseSensitive),
       includeDotfiles_(includeDotfiles),
       hasSpecials_(hasSpecials) {
   if (includeDotfiles && (pattern == "**" || pattern == "*")) {
@@ -177,6 +230,7 @@ GlobNode::GlobNode(
 }
 
 void GlobNode::parse(StringPiece pattern) {
+  parsedPatterns_.push_back(pattern.str());
   GlobNode* parent = this;
   string normalizedPattern;
 
@@ -215,6 +269,9 @@ void GlobNode::parse(StringPiece pattern) {
       container->emplace_back(std::make_unique<GlobNode>(
           token, includeDotfiles_, hasSpecials, caseSensitive_));
       node = container->back().get();
+      if (container == &parent->recursiveChildren_) {
+        parent->indexRecursiveChild(node);
+      }
     }
 
     // If there are no more tokens remaining then we have a leaf node
@@ -274,19 +331,32 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateImpl(
                                 &globResult,
                                 &originRootId](
                                    std::shared_ptr<const Tree> dir) mutable {
-                      return innerNode->evaluateImpl(
-                          store,
-                          context,
-                          candidateName,
-                          TreeRoot(std::move(dir)),
-                          fileBlobsToPrefetch,
-                          globResult,
-                          originRootId);
+                      return runOnExecutor(
+                          innerNode->executor_.get(),
+                          [candidateName = std::move(candidateName),
+                           store,
+                           context = std::move(context),
+                           innerNode,
+                           fileBlobsToPrefetch,
+                           &globResult,
+                           &originRootId,
+                           dir = std::move(dir)]() mutable {
+                            return innerNode->evaluateTree(
+                                store,
+                                context,
+                                candidateName,
+                                std::move(dir),
+                                fileBlobsToPrefetch,
+                                globResult,
+                                originRootId);
+                          });
                     }));
           }
         }
       };
 
+  folly::stop_watch<std::chrono::microseconds> matchingTimer;
+  uint64_t entriesMatched = 0;
   {
     const auto& contents = root.lockContents();
     for (auto& node : children_) {
@@ -303,6 +373,7 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateImpl(
           if (node->isLeaf_) {
             globResult.wlock()->emplace_back(
                 rootPath + name, entry->second.getDtype(), originRootId);
+            ++entriesMatched;
 
             if (fileBlobsToPrefetch &&
                 root.entryShouldPrefetch(&entry->second)) {
@@ -322,6 +393,7 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateImpl(
             if (node->isLeaf_) {
               globResult.wlock()->emplace_back(
                   rootPath + name, entry.second.getDtype(), originRootId);
+              ++entriesMatched;
               if (fileBlobsToPrefetch &&
                   root.entryShouldPrefetch(&entry.second)) {
                 fileBlobsToPrefetch->wlock()->emplace_back(
@@ -336,6 +408,8 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateImpl(
       }
     }
   }
+  recordEvaluation(1, entriesMatched, matchingTimer.elapsed());
+  notifyResultsAdded(globResult);
 
   // Recursively load child inodes and evaluate matches
 
@@ -347,15 +421,27 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateImpl(
                                          node = item.second,
                                          fileBlobsToPrefetch,
                                          &globResult,
-                                         &originRootId](TreeInodePtr dir) {
-                               return node->evaluateImpl(
-                                   store,
-                                   context,
-                                   candidateName,
-                                   TreeInodePtrRoot(std::move(dir)),
-                                   fileBlobsToPrefetch,
-                                   globResult,
-                                   originRootId);
+                                         &originRootId](
+                                            TreeInodePtr dir) mutable {
+                               return runOnExecutor(
+                                   node->executor_.get(),
+                                   [store,
+                                    context = std::move(context),
+                                    candidateName = std::move(candidateName),
+                                    node,
+                                    fileBlobsToPrefetch,
+                                    &globResult,
+                                    &originRootId,
+                                    dir = std::move(dir)]() mutable {
+                                     return node->evaluateImpl(
+                                         store,
+                                         context,
+                                         candidateName,
+                                         TreeInodePtrRoot(std::move(dir)),
+                                         fileBlobsToPrefetch,
+                                         globResult,
+                                         originRootId);
+                                   });
                              }));
   }
 
@@ -401,11 +487,11 @@ ImmediateFuture<folly::Unit> GlobNode::evaluate(
     GlobNode::PrefetchList* fileBlobsToPrefetch,
     GlobNode::ResultList& globResult,
     const RootId& originRootId) const {
-  return evaluateImpl(
+  return evaluateTree(
              store.get(),
              context,
              rootPath,
-             TreeRoot(std::move(tree)),
+             std::move(tree),
              fileBlobsToPrefetch,
              globResult,
              originRootId)
@@ -413,6 +499,160 @@ ImmediateFuture<folly::Unit> GlobNode::evaluate(
       .ensure([store] {});
 }
 
+ImmediateFuture<folly::Unit> GlobNode::evaluateTree(
+    const ObjectStore* store,
+    const ObjectFetchContextPtr& context,
+    RelativePathPiece rootPath,
+    std::shared_ptr<const Tree> tree,
+    GlobNode::PrefetchList* fileBlobsToPrefetch,
+    GlobNode::ResultList& globResult,
+    const RootId& originRootId) const {
+  if (!resultCache_) {
+    return evaluateImpl(
+        store,
+        context,
+        rootPath,
+        TreeRoot(std::move(tree)),
+        fileBlobsToPrefetch,
+        globResult,
+        originRootId);
+  }
+
+  auto addResults = [this,
+                     rootPath = rootPath.copy(),
+                     fileBlobsToPrefetch,
+                     &globResult,
+                     &originRootId](const GlobTreeResults& results) {
+    {
+      auto lockedResults = globResult.wlock();
+      for (const auto& [name, dtype] : results.matches) {
+        lockedResults->emplace_back(rootPath + name, dtype, originRootId);
+      }
+    }
+    notifyResultsAdded(globResult);
+    if (fileBlobsToPrefetch && !results.blobsToPrefetch.empty()) {
+      auto lockedBlobs = fileBlobsToPrefetch->wlock();
+      lockedBlobs->insert(
+          lockedBlobs->end(),
+          results.blobsToPrefetch.begin(),
+          results.blobsToPrefetch.end());
+    }
+  };
+
+  auto treeId = tree->getHash();
+  if (auto cached = resultCache_->get(treeId, resultCacheKey_)) {
+    recordEvaluation(
+        0, cached->matches.size(), std::chrono::microseconds::zero());
+    addResults(*cached);
+    return folly::unit;
+  }
+
+  // Evaluate into lists of our own, relative to this tree, so that they can be
+  // cached. The blobs to prefetch are always collected since a later glob with
+  // the same patterns may want them.
+  auto treeResults = std::make_shared<ResultList>();
+  auto treeBlobs = std::make_shared<PrefetchList>();
+  return evaluateImpl(
+             store,
+             context,
+             RelativePathPiece{},
+             TreeRoot(std::move(tree)),
+             treeBlobs.get(),
+             *treeResults,
+             originRootId)
+      .thenValue([this,
+                  treeId = std::move(treeId),
+                  treeResults,
+                  treeBlobs,
+                  addResults = std::move(addResults)](folly::Unit) {
+        auto results = std::make_shared<GlobTreeResults>();
+        for (auto& result : *treeResults->wlock()) {
+          results->matches.emplace_back(std::move(result.name), result.dtype);
+        }
+        results->blobsToPrefetch = std::move(*treeBlobs->wlock());
+        addResults(*results);
+        resultCache_->insert(treeId, resultCacheKey_, std::move(results));
+      });
+}
+
+void GlobNode::setExecutor(
+    std::shared_ptr<folly::Executor> executor,
+    size_t maxConcurrency) {
+  setExecutor(
+      std::make_shared<EvaluationExecutor>(std::move(executor), maxConcurrency));
+}
+
+void GlobNode::setExecutor(std::shared_ptr<EvaluationExecutor> executor) {
+  for (auto& child : children_) {
+    child->setExecutor(executor);
+  }
+  executor_ = std::move(executor);
+}
+
+void GlobNode::setResultsCallback(
+    std::shared_ptr<ResultsCallback> callback) {
+  for (auto& child : children_) {
+    child->setResultsCallback(callback);
+  }
+  resultsCallback_ = std::move(callback);
+}
+
+void GlobNode::notifyResultsAdded(ResultList& globResult) const {
+  if (resultsCallback_) {
+    (*resultsCallback_)(globResult);
+  }
+}
+
+void GlobNode::setEvaluationStats(std::shared_ptr<EvaluationStats> stats) {
+  for (auto& child : children_) {
+    child->setEvaluationStats(stats);
+  }
+  evaluationStats_ = std::move(stats);
+}
+
+void GlobNode::recordEvaluation(
+    uint64_t directoriesVisited,
+    uint64_t entriesMatched,
+    std::chrono::microseconds matchingTime) const {
+  if (evaluationStats_) {
+    evaluationStats_->directoriesVisited.fetch_add(
+        directoriesVisited, std::memory_order_relaxed);
+    evaluationStats_->entriesMatched.fetch_add(
+        entriesMatched, std::memory_order_relaxed);
+    evaluationStats_->matchingTimeUs.fetch_add(
+        matchingTime.count(), std::memory_order_relaxed);
+  }
+}
+
+void GlobNode::setResultCache(std::shared_ptr<GlobResultCache> cache) {
+  // Identify the set of patterns regardless of their order and repetitions.
+  // Each one is prefixed with its length since patterns may contain any
+  // character.
+  auto patterns = parsedPatterns_;
+  std::sort(patterns.begin(), patterns.end());
+  patterns.erase(std::unique(patterns.begin(), patterns.end()), patterns.end());
+  auto key = fmt::format(
+      "{}{}{};",
+      includeDotfiles_ ? 'd' : '-',
+      caseSensitive_ == CaseSensitivity::Sensitive ? 's' : 'i',
+      patterns.size());
+  for (const auto& pattern : patterns) {
+    key += fmt::format("{}:{}", pattern.size(), pattern);
+  }
+  setResultCache(std::move(cache), key);
+}
+
+void GlobNode::setResultCache(
+    std::shared_ptr<GlobResultCache> cache,
+    const std::string& key) {
+  // Tokens never contain a '/', so they can be separated by one.
+  for (auto& child : children_) {
+    child->setResultCache(cache, fmt::format("{}/{}", key, child->pattern_));
+  }
+  resultCache_ = std::move(cache);
+  resultCacheKey_ = key;
+}
+
 StringPiece GlobNode::tokenize(StringPiece& pattern, bool* hasSpecials) {
   *hasSpecials = false;
 
@@ -451,6 +691,63 @@ GlobNode* GlobNode::lookupToken(
   return nullptr;
 }
 
+void GlobNode::indexRecursiveChild(const GlobNode* node) {
+  // Only index "**/" followed by a plain string, or by "*" and a plain
+  // string, which only compare the basename of the path.
+  StringPiece rest{node->pattern_};
+  if (caseSensitive_ == CaseSensitivity::Sensitive && !node->alwaysMatch_ &&
+      rest.removePrefix("**/")) {
+    bool isSuffix = rest.removePrefix("*");
+    if (rest.find_first_of("*?[\\/") == StringPiece::npos) {
+      if (isSuffix) {
+        recursiveSuffixes_.insert(rest.str());
+        auto it = std::lower_bound(
+            recursiveSuffixLengths_.begin(),
+            recursiveSuffixLengths_.end(),
+            rest.size());
+        if (it == recursiveSuffixLengths_.end() || *it != rest.size()) {
+          recursiveSuffixLengths_.insert(it, rest.size());
+        }
+      } else {
+        recursiveLiterals_.insert(rest.str());
+      }
+      return;
+    }
+  }
+  unindexedRecursiveChildren_.push_back(node);
+}
+
+bool GlobNode::matchesRecursiveChild(
+    RelativePathPiece candidateName,
+    PathComponentPiece basename,
+    bool inDotDirectory) const {
+  if (!inDotDirectory) {
+    auto name = basename.view();
+    if (recursiveLiterals_.find(name) != recursiveLiterals_.end()) {
+      return true;
+    }
+    // "*" does not match a leading dot without includeDotfiles.
+    if (includeDotfiles_ || name[0] != '.') {
+      for (auto length : recursiveSuffixLengths_) {
+        if (length > name.size()) {
+          break;
+        }
+        if (recursiveSuffixes_.find(name.substr(name.size() - length)) !=
+            recursiveSuffixes_.end()) {
+          return true;
+        }
+      }
+    }
+  }
+
+  for (const auto* node : unindexedRecursiveChildren_) {
+    if (node->alwaysMatch_ || node->matcher_.match(candidateName.view())) {
+      return true;
+    }
+  }
+  return false;
+}
+
 template <typename ROOT>
 ImmediateFuture<folly::Unit> GlobNode::evaluateRecursiveComponentImpl(
     const ObjectStore* store,
@@ -464,20 +761,25 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateRecursiveComponentImpl(
   TaskTraceBlock block{"GlobNode::evaluateRecursiveComponentImpl"};
   vector<RelativePath> subDirNames;
   vector<ImmediateFuture<folly::Unit>> futures;
+  // Without includeDotfiles, "**" does not match directories starting with a
+  // dot, so none of the indexed patterns can match inside of them.
+  auto startView = startOfRecursive.view();
+  bool inDotDirectory = !includeDotfiles_ &&
+      (startView.substr(0, 1) == "." ||
+       startView.find("/.") != std::string_view::npos);
+  folly::stop_watch<std::chrono::microseconds> matchingTimer;
+  uint64_t entriesMatched = 0;
   {
     const auto& contents = root.lockContents();
     for (auto& entry : root.iterate(contents)) {
       auto candidateName = startOfRecursive + entry.first;
 
-      for (auto& node : recursiveChildren_) {
-        if (node->alwaysMatch_ || node->matcher_.match(candidateName.view())) {
-          globResult.wlock()->emplace_back(
-              rootPath + candidateName, entry.second.getDtype(), originRootId);
-          if (fileBlobsToPrefetch && root.entryShouldPrefetch(&entry.second)) {
-            fileBlobsToPrefetch->wlock()->emplace_back(entry.second.getHash());
-          }
-          // No sense running multiple matches for this same file.
-          break;
+      if (matchesRecursiveChild(candidateName, entry.first, inDotDirectory)) {
+        globResult.wlock()->emplace_back(
+            rootPath + candidateName, entry.second.getDtype(), originRootId);
+        ++entriesMatched;
+        if (fileBlobsToPrefetch && root.entryShouldPrefetch(&entry.second)) {
+          fileBlobsToPrefetch->wlock()->emplace_back(entry.second.getHash());
         }
       }
 
@@ -496,21 +798,41 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateRecursiveComponentImpl(
                               this,
                               fileBlobsToPrefetch,
                               &globResult,
-                              &originRootId](std::shared_ptr<const Tree> tree) {
-                    return evaluateRecursiveComponentImpl(
-                        store,
-                        context,
-                        rootPath,
-                        candidateName,
-                        TreeRoot(std::move(tree)),
-                        fileBlobsToPrefetch,
-                        globResult,
-                        originRootId);
+                              &originRootId](
+                                 std::shared_ptr<const Tree> tree) mutable {
+                    return runOnExecutor(
+                        executor_.get(),
+                        [candidateName = std::move(candidateName),
+                         rootPath = std::move(rootPath),
+                         store,
+                         context = std::move(context),
+                         this,
+                         fileBlobsToPrefetch,
+                         &globResult,
+                         &originRootId,
+                         tree = std::move(tree)]() mutable {
+                          return evaluateRecursiveComponentImpl(
+                              store,
+                              context,
+                              rootPath,
+                              candidateName,
+                              TreeRoot(std::move(tree)),
+                              fileBlobsToPrefetch,
+                              globResult,
+                              originRootId);
+                        });
                   }));
         }
       }
     }
   }
+  // The first directory of the recursive component is counted by
+  // evaluateImpl().
+  recordEvaluation(
+      startOfRecursive.empty() ? 0 : 1,
+      entriesMatched,
+      matchingTimer.elapsed());
+  notifyResultsAdded(globResult);
 
   // Recursively load child inodes and evaluate matches
   for (auto& candidateName : subDirNames) {
@@ -525,16 +847,28 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateRecursiveComponentImpl(
                         this,
                         fileBlobsToPrefetch,
                         &globResult,
-                        &originRootId](TreeInodePtr dir) {
-              return evaluateRecursiveComponentImpl(
-                  store,
-                  context,
-                  rootPath,
-                  candidateName,
-                  TreeInodePtrRoot(std::move(dir)),
-                  fileBlobsToPrefetch,
-                  globResult,
-                  originRootId);
+                        &originRootId](TreeInodePtr dir) mutable {
+              return runOnExecutor(
+                  executor_.get(),
+                  [candidateName = std::move(candidateName),
+                   rootPath = std::move(rootPath),
+                   store,
+                   context = std::move(context),
+                   this,
+                   fileBlobsToPrefetch,
+                   &globResult,
+                   &originRootId,
+                   dir = std::move(dir)]() mutable {
+                    return evaluateRecursiveComponentImpl(
+                        store,
+                        context,
+                        rootPath,
+                        candidateName,
+                        TreeInodePtrRoot(std::move(dir)),
+                        fileBlobsToPrefetch,
+                        globResult,
+                        originRootId);
+                  });
             }));
   }
 
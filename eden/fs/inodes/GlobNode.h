@@ -6,7 +6,13 @@
  */
 
 #pragma once
+#include <folly/Executor.h>
+#include <folly/container/F14Set.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <ostream>
+#include "eden/fs/inodes/GlobResultCache.h"
 #include "eden/fs/inodes/InodePtrFwd.h"
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/model/git/GlobMatcher.h"
@@ -86,6 +92,21 @@ class GlobNode {
 
   using ResultList = folly::Synchronized<std::vector<GlobResult>>;
 
+  // Called with the list that results were just appended to.
+  using ResultsCallback = std::function<void(ResultList& globResult)>;
+
+  // Counters of the work done by the evaluation of a glob, updated by the
+  // subtrees as they are evaluated.
+  struct EvaluationStats {
+    // The directories whose entries were matched against the patterns.
+    std::atomic<uint64_t> directoriesVisited{0};
+    // The results found, including those taken from the result cache.
+    std::atomic<uint64_t> entriesMatched{0};
+    // The time spent matching the entries of these directories, on whichever
+    // threads they were matched.
+    std::atomic<uint64_t> matchingTimeUs{0};
+  };
+
   // Compile and add a new glob pattern to the tree.
   // Compilation splits the pattern into nodes, with one node for each
   // directory separator separated path component.
@@ -124,6 +145,41 @@ class GlobNode {
       ResultList& globResult,
       const RootId& originRootId) const;
 
+  /**
+   * Look up the results of evaluating the glob in source control trees in the
+   * given cache, and add the results computed by evaluate() to it. This must
+   * only be called on the root node, once all of the patterns are parsed.
+   */
+  void setResultCache(std::shared_ptr<GlobResultCache> cache);
+
+  /**
+   * Evaluate up to maxConcurrency subtrees at a time on the given executor
+   * once their trees or inodes are loaded, rather than on the thread that
+   * loaded them, so that the fetches of a whole level of a wide glob are
+   * issued before any of its directories is walked. Subtrees are evaluated
+   * inline while all of the slots are taken. This must only be called on the
+   * root node, once all of the patterns are parsed.
+   */
+  void setExecutor(
+      std::shared_ptr<folly::Executor> executor,
+      size_t maxConcurrency);
+
+  /**
+   * Call the given callback each time results are appended to a list during
+   * evaluate(), once the entries of a directory have been matched, so that
+   * the results found so far can be taken out of the list as the evaluation
+   * progresses. The list may be one that the node uses internally, which the
+   * callback must leave alone. This must only be called on the root node,
+   * once all of the patterns are parsed.
+   */
+  void setResultsCallback(std::shared_ptr<ResultsCallback> callback);
+
+  /**
+   * Count the work done by evaluate() in the given stats. This must only be
+   * called on the root node, once all of the patterns are parsed.
+   */
+  void setEvaluationStats(std::shared_ptr<EvaluationStats> stats);
+
   /**
    * Print a human-readable description of this GlobNode to stderr.
    *
@@ -155,6 +211,17 @@ class GlobNode {
   // inode children.
   // The difference is because a pattern like "**/foo" must be recursively
   // matched against all the children of the inode.
+  // Adds a node that was just added to recursiveChildren_ to the indexes
+  // below.
+  void indexRecursiveChild(const GlobNode* node);
+  // Returns true if any of recursiveChildren_ matches candidateName, the path
+  // of an entry relative to where the recursive match started. inDotDirectory
+  // is true if includeDotfiles_ is false and one of the directories of
+  // candidateName starts with a dot.
+  bool matchesRecursiveChild(
+      RelativePathPiece candidateName,
+      PathComponentPiece basename,
+      bool inDotDirectory) const;
   template <typename ROOT>
   ImmediateFuture<folly::Unit> evaluateRecursiveComponentImpl(
       const ObjectStore* store,
@@ -166,6 +233,44 @@ class GlobNode {
       ResultList& globResult,
       const RootId& originRootId) const;
 
+  struct EvaluationExecutor;
+
+  // Sets the executor of this node and its non-recursive descendants.
+  void setExecutor(std::shared_ptr<EvaluationExecutor> executor);
+
+  // Calls resultsCallback_, if any, on a list that results were appended to.
+  void notifyResultsAdded(ResultList& globResult) const;
+
+  // Adds to the evaluation stats, if any.
+  void recordEvaluation(
+      uint64_t directoriesVisited,
+      uint64_t entriesMatched,
+      std::chrono::microseconds matchingTime) const;
+
+  // Runs func, which evaluates a subtree, on the executor if there is one and
+  // one of its slots is free, and inline otherwise.
+  template <typename Func>
+  static ImmediateFuture<folly::Unit> runOnExecutor(
+      EvaluationExecutor* executor,
+      Func func);
+
+  // Sets the result cache of this node and its non-recursive descendants,
+  // given the key that identifies this node.
+  void setResultCache(
+      std::shared_ptr<GlobResultCache> cache,
+      const std::string& key);
+
+  // Evaluates this node against a source control tree, through the result
+  // cache if there is one.
+  ImmediateFuture<folly::Unit> evaluateTree(
+      const ObjectStore* store,
+      const ObjectFetchContextPtr& context,
+      RelativePathPiece rootPath,
+      std::shared_ptr<const Tree> tree,
+      PrefetchList* fileBlobsToPrefetch,
+      ResultList& globResult,
+      const RootId& originRootId) const;
+
   template <typename ROOT>
   ImmediateFuture<folly::Unit> evaluateImpl(
       const ObjectStore* store,
@@ -186,10 +291,33 @@ class GlobNode {
   std::vector<std::unique_ptr<GlobNode>> children_;
   // List of ** child rules
   std::vector<std::unique_ptr<GlobNode>> recursiveChildren_;
+  // The basenames of the recursiveChildren_ that are "**/" followed by a
+  // plain string, and the basename suffixes of the ones that are "**/*"
+  // followed by a plain string. An entry matched by any of them is found with
+  // a few hash lookups rather than by running every matcher against it.
+  folly::F14FastSet<std::string> recursiveLiterals_;
+  folly::F14FastSet<std::string> recursiveSuffixes_;
+  // The distinct lengths of recursiveSuffixes_, in increasing order.
+  std::vector<size_t> recursiveSuffixLengths_;
+  // The recursiveChildren_ that are not indexed above.
+  std::vector<const GlobNode*> unindexedRecursiveChildren_;
 
   // The case sensitivity of this glob node.
   CaseSensitivity caseSensitive_;
 
+  // The patterns given to parse(). Only set on the root node.
+  std::vector<std::string> parsedPatterns_;
+  // Set by setResultCache(). The key identifies both the set of patterns of
+  // the root and the position of this node below it.
+  std::shared_ptr<GlobResultCache> resultCache_;
+  std::string resultCacheKey_;
+  // Set by setExecutor(), and shared by all of the nodes of a glob.
+  std::shared_ptr<EvaluationExecutor> executor_;
+  // Set by setResultsCallback(), and shared by all of the nodes of a glob.
+  std::shared_ptr<ResultsCallback> resultsCallback_;
+  // Set by setEvaluationStats(), and shared by all of the nodes of a glob.
+  std::shared_ptr<EvaluationStats> evaluationStats_;
+
   // For a child GlobNode that is added to this GlobNode (presumably via
   // parse()), the GlobMatcher pattern associated with the child node should use
   // this value for its includeDotfiles parameter.
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/GlobResultCache.h"
+
+#include <algorithm>
+
+namespace facebook::eden {
+
+GlobResultCache::GlobResultCache(size_t maxEntries)
+    : cache_{folly::in_place, std::max(maxEntries, size_t{1})} {}
+
+std::string GlobResultCache::makeKey(
+    const ObjectId& tree,
+    std::string_view globKey) {
+  // Object ids have variable lengths, so prefix the tree id with its length
+  // to keep the keys of different pairs distinct.
+  auto treeBytes = tree.getBytes();
+  std::string key;
+  key.reserve(1 + treeBytes.size() + globKey.size());
+  key.push_back(static_cast<char>(treeBytes.size()));
+  key.append(reinterpret_cast<const char*>(treeBytes.data()), treeBytes.size());
+  key.append(globKey);
+  return key;
+}
+
+std::shared_ptr<const GlobTreeResults> GlobResultCache::get(
+    const ObjectId& tree,
+    std::string_view globKey) {
+  auto key = makeKey(tree, globKey);
+  auto cache = cache_.lock();
+  auto it = cache->find(key);
+  if (it == cache->end()) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+void GlobResultCache::insert(
+    const ObjectId& tree,
+    std::string_view globKey,
+    std::shared_ptr<const GlobTreeResults> results) {
+  auto key = makeKey(tree, globKey);
+  cache_.lock()->set(std::move(key), std::move(results));
+}
+
+} // namespace facebook::eden
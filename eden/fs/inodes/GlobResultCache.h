@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/utils/DirType.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * The matches of a glob in a source control tree, relative to that tree, and
+ * the files among them whose blobs are prefetched.
+ */
+struct GlobTreeResults {
+  std::vector<std::pair<RelativePath, dtype_t>> matches;
+  std::vector<ObjectId> blobsToPrefetch;
+};
+
+/**
+ * The results of recently evaluated globs in source control trees, keyed by
+ * the id of the tree and by a string identifying the glob, so that the same
+ * globs evaluated again against the same commits, in any mount, do not walk
+ * the trees again. Source control trees are immutable, so the entries never
+ * need to be invalidated.
+ */
+class GlobResultCache {
+ public:
+  explicit GlobResultCache(size_t maxEntries);
+
+  GlobResultCache(const GlobResultCache&) = delete;
+  GlobResultCache& operator=(const GlobResultCache&) = delete;
+
+  /**
+   * Returns the results of the given glob in the given tree, or nullptr if
+   * they are not cached.
+   */
+  std::shared_ptr<const GlobTreeResults> get(
+      const ObjectId& tree,
+      std::string_view globKey);
+
+  void insert(
+      const ObjectId& tree,
+      std::string_view globKey,
+      std::shared_ptr<const GlobTreeResults> results);
+
+ private:
+  static std::string makeKey(const ObjectId& tree, std::string_view globKey);
+
+  folly::Synchronized<
+      folly::EvictingCacheMap<
+          std::string,
+          std::shared_ptr<const GlobTreeResults>>,
+      std::mutex>
+      cache_;
+};
+
+} // namespace facebook::eden
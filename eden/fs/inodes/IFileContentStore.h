@@ -26,6 +26,8 @@ class IOBuf;
 
 namespace facebook::eden {
 
+class ObjectId;
+
 /**
  * Interface to manage materalized file data.
  */
@@ -98,6 +100,31 @@ class IFileContentStore {
   virtual folly::File createOverlayFile(
       InodeNumber inodeNumber,
       const folly::IOBuf& contents) = 0;
+
+  /**
+   * Like createOverlayFile(), for a FileInode being materialized from the
+   * blob with the given id. The file may be cloned from an earlier copy of
+   * the same blob rather than written.
+   */
+  virtual folly::File createOverlayFileFromBlob(
+      InodeNumber inodeNumber,
+      const ObjectId& blobId,
+      const folly::IOBuf& contents) = 0;
+
+  /**
+   * Create an overlay file of the given size whose contents are not written,
+   * and whose header marks it as incomplete until completeSparseOverlayFile()
+   * is called.
+   */
+  virtual folly::File createSparseOverlayFile(
+      InodeNumber inodeNumber,
+      uint64_t size) = 0;
+
+  /**
+   * Mark a file created by createSparseOverlayFile() as complete, once all
+   * of its contents have been written.
+   */
+  virtual void completeSparseOverlayFile(InodeNumber inodeNumber) = 0;
 #endif
 };
 
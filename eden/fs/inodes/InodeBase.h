@@ -9,6 +9,7 @@
 
 #include <folly/Synchronized.h>
 #include <folly/futures/Future.h>
+#include <algorithm>
 #include <atomic>
 #include <memory>
 #include <optional>
@@ -352,6 +353,50 @@ class InodeBase {
     return numFsReferences_.store(count, std::memory_order_release);
   }
 
+  /**
+   * The maximum number of sweeps an inode can be counted as idle for.
+   */
+  static constexpr uint8_t kMaxIdleSweeps = 15;
+
+  /**
+   * Record that this inode was used since the last
+   * InodeMap::sweepLoadedInodes().
+   */
+  void markAccessed() {
+    // Most accesses are of inodes that were already marked; avoid dirtying
+    // the cache line for them.
+    if (!(accessState_.load(std::memory_order_relaxed) & kAccessedBit)) {
+      accessState_.fetch_or(kAccessedBit, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * The number of consecutive InodeMap::sweepLoadedInodes() calls that found
+   * this inode unused since the previous one, up to kMaxIdleSweeps. Inodes
+   * used since the last sweep count as idle for 0 sweeps.
+   */
+  uint8_t getIdleSweeps() const {
+    auto state = accessState_.load(std::memory_order_relaxed);
+    return (state & kAccessedBit) ? 0 : state;
+  }
+
+  /**
+   * Only called by InodeMap::sweepLoadedInodes(), like the hand of a clock:
+   * the idle count is reset if the inode was used since the last sweep, and
+   * incremented otherwise. Returns the new idle count.
+   */
+  uint8_t sweepAccessState() {
+    auto state = accessState_.load(std::memory_order_relaxed);
+    uint8_t next;
+    do {
+      next = (state & kAccessedBit)
+          ? 0
+          : std::min<uint8_t>(state + 1, kMaxIdleSweeps);
+    } while (!accessState_.compare_exchange_weak(
+        state, next, std::memory_order_relaxed));
+    return next;
+  }
+
   /**
    * Get the parent directory of this inode.
    *
@@ -682,6 +727,15 @@ class InodeBase {
    */
   mutable std::atomic<uint32_t> ptrAcquireCount_{0};
 
+  static constexpr uint8_t kAccessedBit = 0x80;
+
+  /**
+   * The clock state used to unload idle inodes first: kAccessedBit is set
+   * when the inode is used, and the low bits count the sweeps that found it
+   * unused. Inodes start out as used.
+   */
+  std::atomic<uint8_t> accessState_{kAccessedBit};
+
   /**
    * Information about this Inode's location in the file system path.
    * Eden does not support hard links, so each Inode has exactly one location.
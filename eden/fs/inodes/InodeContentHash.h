@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/portability/SysStat.h>
+#include <cstdint>
+#include "eden/fs/model/Hash.h"
+#include "eden/fs/utils/StatTimes.h"
+
+namespace facebook::eden {
+
+/**
+ * The SHA-1 of a materialized file, along with the size and modification time
+ * of its overlay file when it was computed. The hash is only trusted while the
+ * overlay file still has that size and modification time.
+ *
+ * Warning: This data structure is serialized directly to disk via InodeTable.
+ * Do not change the order, sizes, or meanings of the fields. Instead, follow
+ * the same migration process as InodeMetadata.
+ */
+struct InodeContentHash {
+  enum { VERSION = 0 };
+
+  InodeContentHash() = default;
+
+  InodeContentHash(const struct stat& st, const Hash20& hash) noexcept
+      : size{static_cast<uint64_t>(st.st_size)},
+        mtimeSec{static_cast<int64_t>(stMtime(st).tv_sec)},
+        mtimeNsec{static_cast<int64_t>(stMtime(st).tv_nsec)},
+        sha1{hash} {}
+
+  /**
+   * Whether this hash was computed when the overlay file had the given stat.
+   */
+  bool matches(const struct stat& st) const noexcept {
+    auto mtime = stMtime(st);
+    return size == static_cast<uint64_t>(st.st_size) &&
+        mtimeSec == static_cast<int64_t>(mtime.tv_sec) &&
+        mtimeNsec == static_cast<int64_t>(mtime.tv_nsec);
+  }
+
+  uint64_t size{0};
+  int64_t mtimeSec{0};
+  int64_t mtimeNsec{0};
+  Hash20 sha1;
+};
+
+} // namespace facebook::eden
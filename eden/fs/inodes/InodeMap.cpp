@@ -13,6 +13,7 @@
 #include <folly/Likely.h>
 #include <folly/chrono/Conv.h>
 #include <folly/logging/xlog.h>
+#include <folly/memory/Malloc.h>
 
 #include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/config/ReloadableConfig.h"
@@ -261,16 +262,25 @@ void InodeMap::initializeFromOverlay(TreeInodePtr root, Overlay& overlay) {
 }
 
 ImmediateFuture<InodePtr> InodeMap::lookupInode(InodeNumber number) {
+  // Most lookups are of loaded inodes, which only need the read lock: don't
+  // make concurrent FS requests wait on each other for them.
+  if (auto inode = lookupLoadedInode(number)) {
+    inode->markAccessed();
+    return inode;
+  }
+
   // Lock the data.
   // We hold it while doing most of our work below, but explicitly unlock it
   // before triggering inode loading or before fulfilling any Promises.
   auto data = data_.wlock();
   std::vector<InodeTraceEvent> startLoadEvents;
 
-  // Check to see if this Inode is already loaded
+  // Check to see if this Inode was loaded since the check above
   auto loadedIter = data->loadedInodes_.find(number);
   if (loadedIter != data->loadedInodes_.end()) {
-    return loadedIter->second.getPtr();
+    auto inode = loadedIter->second.getPtr();
+    inode->markAccessed();
+    return inode;
   }
 
   // Look up the data in the unloadedInodes_ map.
@@ -639,15 +649,51 @@ std::optional<RelativePath> InodeMap::getPathForInodeHelper(
   }
 }
 void InodeMap::decFsRefcount(InodeNumber number, uint32_t count) {
-  InodePtr inodePtr;
-  {
+  // The FS refcount of loaded inodes is tracked by the inode itself, so only
+  // unloaded inodes need the write lock.
+  auto inodePtr = lookupLoadedInode(number);
+  if (!inodePtr) {
     auto data = data_.wlock();
     inodePtr = decFsRefcountHelper(data, number, count);
   }
   // Now release our lock before decrementing the inode's FS reference
   // count and immediately releasing our pointer reference.
   if (inodePtr) {
-    inodePtr->decFsRefcount();
+    inodePtr->decFsRefcount(count);
+  }
+}
+
+void InodeMap::decFsRefcounts(
+    folly::Range<const std::pair<InodeNumber, uint32_t>*> decrements) {
+  std::vector<std::pair<InodePtr, uint32_t>> loaded;
+  loaded.reserve(decrements.size());
+  std::vector<std::pair<InodeNumber, uint32_t>> unloaded;
+  {
+    auto data = data_.rlock();
+    for (const auto& [number, count] : decrements) {
+      auto it = data->loadedInodes_.find(number);
+      if (it != data->loadedInodes_.end()) {
+        loaded.emplace_back(it->second.getPtr(), count);
+      } else {
+        unloaded.emplace_back(number, count);
+      }
+    }
+  }
+
+  if (!unloaded.empty()) {
+    auto data = data_.wlock();
+    for (const auto& [number, count] : unloaded) {
+      // The inode may have been loaded since the check above.
+      if (auto inodePtr = decFsRefcountHelper(data, number, count)) {
+        loaded.emplace_back(std::move(inodePtr), count);
+      }
+    }
+  }
+
+  // As in decFsRefcount(), the lock must be released before the FS refcounts
+  // of loaded inodes are decremented and our pointers to them released.
+  for (auto& [inodePtr, count] : loaded) {
+    inodePtr->decFsRefcount(count);
   }
 }
 
@@ -1244,6 +1290,36 @@ InodeMap::InodeCounts InodeMap::getInodeCounts() const {
   return counts;
 }
 
+size_t InodeMap::estimateMemoryUsage() const {
+  // A node of an unordered_map holds the value and a pointer to the next node,
+  // and the map has an array of buckets.
+  auto mapUsage = [](const auto& map) {
+    using Value = typename std::decay_t<decltype(map)>::value_type;
+    return map.size() * folly::goodMallocSize(sizeof(Value) + sizeof(void*)) +
+        map.bucket_count() * sizeof(void*);
+  };
+
+  auto data = data_.rlock();
+  size_t usage =
+      data->numFileInodes_ * folly::goodMallocSize(sizeof(FileInode));
+  usage += data->numTreeInodes_ * folly::goodMallocSize(sizeof(TreeInode));
+  usage += data->loadedInodes_.size() * sizeof(DirContents::value_type);
+  usage += mapUsage(data->loadedInodes_);
+  usage += mapUsage(data->unloadedInodes_);
+  return usage;
+}
+
+std::vector<size_t> InodeMap::sweepLoadedInodes() {
+  std::vector<size_t> histogram(InodeBase::kMaxIdleSweeps + 1);
+  // Sweeping only updates atomics of the loaded inodes, which the read lock
+  // keeps alive, so it doesn't block lookups.
+  auto data = data_.rlock();
+  for (const auto& kv : data->loadedInodes_) {
+    ++histogram[kv.second->sweepAccessState()];
+  }
+  return histogram;
+}
+
 std::vector<InodeNumber> InodeMap::getReferencedInodes() const {
   std::vector<InodeNumber> inodes;
   {
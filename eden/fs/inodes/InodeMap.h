@@ -7,12 +7,14 @@
 
 #pragma once
 
+#include <folly/Range.h>
 #include <folly/Synchronized.h>
 #include <folly/futures/Future.h>
 #include <list>
 #include <memory>
 #include <optional>
 #include <unordered_map>
+#include <utility>
 
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/InodeNumber.h"
@@ -236,6 +238,17 @@ class InodeMap {
    */
   void decFsRefcount(InodeNumber number, uint32_t count = 1);
 
+  /**
+   * Decrement the FS refcounts of several inodes, as for a FUSE batch forget.
+   *
+   * This is equivalent to calling decFsRefcount() on each (number, count)
+   * pair, but takes the data lock once for the whole batch rather than once
+   * per inode. Inodes whose refcounts drop to zero are unloaded as usual,
+   * once the lock is released.
+   */
+  void decFsRefcounts(
+      folly::Range<const std::pair<InodeNumber, uint32_t>*> decrements);
+
   /**
    * See EdenMount::forgetStaleInodes
    */
@@ -404,6 +417,28 @@ class InodeMap {
   InodeCounts getInodeCounts() const;
 
   void recordPeriodicInodeUnload(size_t numInodesToUnload);
+
+  /**
+   * Estimate the memory used by the inodes of this map: the loaded inode
+   * objects, their entries in their parent directory, and the bookkeeping of
+   * this map for loaded and unloaded inodes.
+   *
+   * This is a lower bound: the entries of the unloaded children of loaded
+   * trees, and the data cached by inodes, are not counted.
+   */
+  size_t estimateMemoryUsage() const;
+
+  /**
+   * Advance the idle count of every loaded inode, see
+   * InodeBase::sweepAccessState().
+   *
+   * Returns a histogram of the loaded inodes by idle count: entry i is the
+   * number of inodes that have not been used for i sweeps, so entry 0 is the
+   * size of the working set since the previous sweep. The histogram has
+   * InodeBase::kMaxIdleSweeps + 1 entries.
+   */
+  std::vector<size_t> sweepLoadedInodes();
+
   /*
    * Return all referenced inodes (loaded and unloaded inodes whose
    * fs references is greater than zero).
@@ -183,6 +183,56 @@ class InodePtrImpl {
   InodeType* value_{nullptr};
 };
 
+/**
+ * A non-owning pointer to a loaded inode, for code holding the contents_ lock
+ * of the inode's parent TreeInode.
+ *
+ * While that lock is held the child can't be unloaded, so there is no need
+ * to update its reference count, which every InodePtr copy does atomically.
+ * A BorrowedInodePtr must not be used once the parent's lock is released:
+ * call copy() to get an InodePtr that outlives it.
+ */
+template <typename InodeTypeParam>
+class BorrowedInodePtr {
+ public:
+  using InodeType = InodeTypeParam;
+
+  constexpr BorrowedInodePtr() noexcept = default;
+  constexpr /* implicit */ BorrowedInodePtr(std::nullptr_t) noexcept {}
+
+  /**
+   * Borrows value, which must be a child of a TreeInode whose contents_ lock
+   * the caller holds.
+   */
+  explicit BorrowedInodePtr(InodeType* value) noexcept : value_{value} {}
+
+  explicit operator bool() const {
+    return value_ != nullptr;
+  }
+
+  InodeType* get() const {
+    return value_;
+  }
+  InodeType* operator->() const {
+    return value_;
+  }
+  InodeType& operator*() const {
+    return *value_;
+  }
+
+  /**
+   * Returns an owning pointer to the borrowed inode. Like the borrowed
+   * pointer itself, this must be called with the parent's lock held.
+   */
+  InodePtrImpl<InodeType> copy() const noexcept {
+    return value_ ? InodePtrImpl<InodeType>::newPtrLocked(value_)
+                  : InodePtrImpl<InodeType>{};
+  }
+
+ private:
+  InodeType* value_{nullptr};
+};
+
 /**
  * An InodePtrImpl pointing to InodeBase.
  *
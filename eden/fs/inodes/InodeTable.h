@@ -9,7 +9,12 @@
 
 #ifndef _WIN32
 
+#include <folly/container/F14Map.h>
+#include <algorithm>
+#include <limits>
 #include <optional>
+#include <vector>
+#include "eden/fs/inodes/InodeContentHash.h"
 #include "eden/fs/inodes/InodeMetadata.h"
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/utils/Bug.h"
@@ -42,6 +47,120 @@ struct InodeTableEntry {
   // corrupted entries?
   Record record;
 };
+
+/**
+ * Maps inode numbers to the index of their record in InodeTable's storage.
+ *
+ * Inode numbers are allocated sequentially, and most inodes with metadata
+ * have been allocated since the overlay was created, so they mostly form a
+ * dense range. That range is direct-indexed by inode number, costing 4 bytes
+ * per inode number instead of a hash map node per inode. Inode numbers that
+ * would leave the direct-indexed range less than half used go to a hash map.
+ */
+class InodeTableIndex {
+ public:
+  std::optional<size_t> find(InodeNumber ino) const {
+    auto value = ino.get();
+    if (value < dense_.size()) {
+      auto slot = dense_[value];
+      if (slot == kAbsent) {
+        return std::nullopt;
+      }
+      return slot - 1;
+    }
+    auto iter = sparse_.find(ino);
+    if (iter == sparse_.end()) {
+      return std::nullopt;
+    }
+    return iter->second;
+  }
+
+  /**
+   * Returns false, leaving the index unchanged, if ino is already indexed.
+   */
+  bool insert(InodeNumber ino, size_t index) {
+    if (find(ino)) {
+      return false;
+    }
+    ++size_;
+    auto value = ino.get();
+    if (value >= dense_.size() && shouldGrowDense(value)) {
+      growDense(value);
+    }
+    if (value < dense_.size()) {
+      dense_[value] = toSlot(index);
+    } else {
+      sparse_.emplace(ino, index);
+    }
+    return true;
+  }
+
+  /**
+   * Change the index of an inode that is already indexed.
+   */
+  void update(InodeNumber ino, size_t index) {
+    auto value = ino.get();
+    if (value < dense_.size()) {
+      XDCHECK_NE(kAbsent, dense_[value]);
+      dense_[value] = toSlot(index);
+    } else {
+      sparse_.at(ino) = index;
+    }
+  }
+
+  void erase(InodeNumber ino) {
+    auto value = ino.get();
+    if (value < dense_.size()) {
+      if (dense_[value] != kAbsent) {
+        dense_[value] = kAbsent;
+        --size_;
+      }
+    } else {
+      size_ -= sparse_.erase(ino);
+    }
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+ private:
+  /// Direct-indexed slots store the index plus one, so that zero is absent.
+  static constexpr uint32_t kAbsent = 0;
+  /// Always direct-index the first inode numbers of a mount.
+  static constexpr uint64_t kMinDenseSize = 1024;
+
+  static uint32_t toSlot(size_t index) {
+    XCHECK_LT(index, std::numeric_limits<uint32_t>::max());
+    return static_cast<uint32_t>(index + 1);
+  }
+
+  bool shouldGrowDense(uint64_t value) const {
+    return value < std::max<uint64_t>(kMinDenseSize, 2 * size_);
+  }
+
+  void growDense(uint64_t value) {
+    // Grow geometrically so that sparse_ is rescanned a logarithmic number of
+    // times, but without going under half usage.
+    auto limit = std::max<uint64_t>(kMinDenseSize, 2 * size_);
+    auto newSize = std::max<uint64_t>(
+        value + 1, std::min<uint64_t>(2 * dense_.size(), limit));
+    dense_.resize(newSize, kAbsent);
+
+    for (auto iter = sparse_.begin(); iter != sparse_.end();) {
+      if (iter->first.get() < newSize) {
+        dense_[iter->first.get()] = toSlot(iter->second);
+        iter = sparse_.erase(iter);
+      } else {
+        ++iter;
+      }
+    }
+  }
+
+  std::vector<uint32_t> dense_;
+  folly::F14FastMap<InodeNumber, size_t> sparse_;
+  size_t size_{0};
+};
 } // namespace detail
 
 /**
@@ -157,13 +276,12 @@ class InodeTable {
    */
   std::optional<Record> getOptional(InodeNumber ino) {
     auto state = state_.rlock();
-    auto iter = state->indices.find(ino);
-    if (iter == state->indices.end()) {
+    auto index = state->indices.find(ino);
+    if (!index) {
       return std::nullopt;
     } else {
-      auto index = iter->second;
-      XCHECK_LT(index, state->storage.size());
-      return state->storage[index].record;
+      XCHECK_LT(*index, state->storage.size());
+      return state->storage[*index].record;
     }
   }
 
@@ -177,16 +295,15 @@ class InodeTable {
   template <typename ModFn>
   Record modifyOrThrow(InodeNumber ino, ModFn&& fn) {
     auto state = state_.rlock();
-    auto iter = state->indices.find(ino);
-    if (iter == state->indices.end()) {
+    auto index = state->indices.find(ino);
+    if (!index) {
       throw std::out_of_range(
           folly::to<std::string>("no entry in InodeTable for inode ", ino));
     }
-    auto index = iter->second;
-    XCHECK_LT(index, state->storage.size());
-    fn(state->storage[index].record);
+    XCHECK_LT(*index, state->storage.size());
+    fn(state->storage[*index].record);
     // TODO: maybe trigger a background msync
-    return state->storage[index].record;
+    return state->storage[*index].record;
   }
 
   // TODO: replace with freeInodes - it's much more efficient to free a bunch
@@ -196,8 +313,8 @@ class InodeTable {
     auto& storage = state->storage;
     auto& indices = state->indices;
 
-    auto iter = indices.find(ino);
-    if (iter == indices.end()) {
+    auto index = indices.find(ino);
+    if (!index) {
       // While transitioning metadata from the overlay to the
       // InodeMetadataTable, it is common for there to be no metadata for an
       // inode whose number is known. The Overlay calls freeInode()
@@ -205,8 +322,8 @@ class InodeTable {
       return;
     }
 
-    size_t indexToDelete = iter->second;
-    indices.erase(iter);
+    size_t indexToDelete = *index;
+    indices.erase(ino);
 
     XDCHECK_GT(storage.size(), 0ul);
     size_t lastIndex = storage.size() - 1;
@@ -214,10 +331,11 @@ class InodeTable {
     if (lastIndex != indexToDelete) {
       auto lastInode = storage[lastIndex].inode;
       storage[indexToDelete] = storage[lastIndex];
-      indices[lastInode] = indexToDelete;
+      indices.update(lastInode, indexToDelete);
     }
 
     storage.pop_back();
+    storage.releaseUnusedCapacity();
   }
 
   /**
@@ -229,11 +347,14 @@ class InodeTable {
   template <typename ModifyFn>
   void forEachModify(ModifyFn&& fn) {
     auto state = state_.wlock();
-    for (auto& entry : state->indices) {
-      const auto& inode = entry.first;
-      auto index = entry.second;
-      auto& record = state->storage[index].record;
-      fn(inode, record);
+    auto& storage = state->storage;
+    for (size_t i = 0; i < storage.size(); ++i) {
+      auto& entry = storage[i];
+      // Skip the zeroed and duplicate records that aren't indexed.
+      if (state->indices.find(entry.inode) != i) {
+        continue;
+      }
+      fn(entry.inode, entry.record);
     }
   }
 
@@ -270,10 +391,8 @@ class InodeTable {
     // modify immediately.
     {
       auto state = state_.rlock();
-      auto iter = state->indices.find(ino);
-      if (LIKELY(iter != state->indices.end())) {
-        auto index = iter->second;
-        return modify(state->storage[index].record);
+      if (auto index = state->indices.find(ino); LIKELY(index.has_value())) {
+        return modify(state->storage[*index].record);
       }
     }
 
@@ -283,15 +402,13 @@ class InodeTable {
 
     auto state = state_.wlock();
     // Check again - something may have raced between the locks.
-    auto iter = state->indices.find(ino);
-    if (UNLIKELY(iter != state->indices.end())) {
-      auto index = iter->second;
-      return modify(state->storage[index].record);
+    if (auto index = state->indices.find(ino); UNLIKELY(index.has_value())) {
+      return modify(state->storage[*index].record);
     }
 
     size_t index = state->storage.size();
     state->storage.emplace_back(ino, record);
-    state->indices.emplace(ino, index);
+    state->indices.insert(ino, index);
     return result(state->storage[index].record);
   }
 
@@ -304,11 +421,10 @@ class InodeTable {
           // zeroes. Don't pretend this entry is valid.
           continue;
         }
-        auto ret = indices.insert({entry.inode, i});
-        if (!ret.second) {
+        if (!indices.insert(entry.inode, i)) {
           XLOG_FIRST_N(WARNING, 100)
               << "Duplicate records for the same inode: indices "
-              << indices[entry.inode] << " and " << i;
+              << *indices.find(entry.inode) << " and " << i;
           continue;
         }
       }
@@ -326,7 +442,7 @@ class InodeTable {
     mutable MappedDiskVector<Entry> storage;
 
     /// Maintains an index from inode number to index in storage_.
-    std::unordered_map<InodeNumber, size_t> indices;
+    detail::InodeTableIndex indices;
   };
 
   folly::Synchronized<State> state_;
@@ -338,6 +454,12 @@ static_assert(
 
 using InodeMetadataTable = InodeTable<InodeMetadata>;
 
+static_assert(
+    CheckSize<InodeContentHash, 48>(),
+    "Don't change InodeContentHash without implementing a migration path");
+
+using InodeContentHashTable = InodeTable<InodeContentHash>;
+
 } // namespace facebook::eden
 
 #endif
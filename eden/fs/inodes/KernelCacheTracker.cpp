@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/KernelCacheTracker.h"
+
+#include <folly/hash/Hash.h>
+#include <algorithm>
+
+namespace facebook::eden {
+
+KernelCacheTracker::KernelCacheTracker(
+    uint32_t sampleRate,
+    size_t maxInodes,
+    std::chrono::nanoseconds window)
+    : sampleRate_{sampleRate},
+      window_{window},
+      inodes_{std::in_place, std::max<size_t>(maxInodes, 1)} {}
+
+bool KernelCacheTracker::isSampled(InodeNumber ino) const {
+  // Inode numbers are allocated sequentially, hash them so that the sample
+  // isn't biased towards the inodes loaded at a given point.
+  return sampleRate_ != 0 &&
+      folly::hash::twang_mix64(ino.get()) % sampleRate_ == 0;
+}
+
+KernelCacheTracker::InodeState& KernelCacheTracker::getState(
+    folly::EvictingCacheMap<uint64_t, InodeState>& inodes,
+    InodeNumber ino) {
+  auto it = inodes.find(ino.get());
+  if (it == inodes.end()) {
+    inodes.set(ino.get(), InodeState{});
+    it = inodes.find(ino.get());
+  }
+  return it->second;
+}
+
+bool KernelCacheTracker::recordRequest(
+    InodeNumber ino,
+    Request request,
+    Clock::time_point now) {
+  auto inodes = inodes_.lock();
+  auto& state = getState(*inodes, ino);
+  auto& last =
+      request == Request::Lookup ? state.lastLookup : state.lastGetattr;
+  bool repeated = last != Clock::time_point{} && now - last < window_;
+  last = now;
+  return repeated;
+}
+
+uint64_t KernelCacheTracker::recordRead(
+    InodeNumber ino,
+    uint64_t offset,
+    uint64_t size) {
+  auto end = offset + size;
+  auto inodes = inodes_.lock();
+  auto& state = getState(*inodes, ino);
+  if (state.readStart == state.readEnd) {
+    state.readStart = offset;
+    state.readEnd = end;
+    return 0;
+  }
+  auto overlapStart = std::max(offset, state.readStart);
+  auto overlapEnd = std::min(end, state.readEnd);
+  state.readStart = std::min(offset, state.readStart);
+  state.readEnd = std::max(end, state.readEnd);
+  return overlapEnd > overlapStart ? overlapEnd - overlapStart : 0;
+}
+
+} // namespace facebook::eden
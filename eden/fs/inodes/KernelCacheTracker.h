@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <chrono>
+#include <mutex>
+
+#include "eden/fs/inodes/InodeNumber.h"
+
+namespace facebook::eden {
+
+/**
+ * Watches the requests the kernel sends for a sample of the inodes, to tell
+ * how well it caches them: a lookup or getattr repeated while the previous
+ * reply should still be cached, or file data read again, is work the kernel
+ * cache could have saved.
+ *
+ * Inodes are sampled by number, so that every request for a sampled inode is
+ * seen. Only the last sampled inodes seen are remembered, in bounded memory,
+ * and this costs a hash of the inode number for the others.
+ *
+ * This class is thread-safe.
+ */
+class KernelCacheTracker {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  enum class Request { Lookup, Getattr };
+
+  /**
+   * Track 1 in sampleRate inodes, up to maxInodes of them, and count the
+   * requests repeated within window. A sampleRate of 0 disables tracking.
+   */
+  KernelCacheTracker(
+      uint32_t sampleRate,
+      size_t maxInodes,
+      std::chrono::nanoseconds window);
+
+  KernelCacheTracker(const KernelCacheTracker&) = delete;
+  KernelCacheTracker& operator=(const KernelCacheTracker&) = delete;
+
+  bool isSampled(InodeNumber ino) const;
+
+  /**
+   * Record a request for a sampled inode and return whether the same request
+   * was made for it within the window.
+   */
+  bool recordRequest(InodeNumber ino, Request request, Clock::time_point now);
+
+  /**
+   * Record a read of a sampled inode and return how many of the bytes read
+   * were already read before.
+   *
+   * The bytes read are remembered as a single range spanning all of the
+   * reads, which is exact for files read sequentially and may overestimate
+   * the bytes read again for sparse reads.
+   */
+  uint64_t recordRead(InodeNumber ino, uint64_t offset, uint64_t size);
+
+ private:
+  struct InodeState {
+    Clock::time_point lastLookup;
+    Clock::time_point lastGetattr;
+    uint64_t readStart = 0;
+    uint64_t readEnd = 0;
+  };
+
+  InodeState& getState(
+      folly::EvictingCacheMap<uint64_t, InodeState>& inodes,
+      InodeNumber ino);
+
+  const uint32_t sampleRate_;
+  const std::chrono::nanoseconds window_;
+  folly::Synchronized<folly::EvictingCacheMap<uint64_t, InodeState>, std::mutex>
+      inodes_;
+};
+
+} // namespace facebook::eden
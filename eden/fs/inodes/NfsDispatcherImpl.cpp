@@ -40,11 +40,33 @@ NfsDispatcherImpl::NfsDispatcherImpl(EdenMount* mount)
     : NfsDispatcher(mount->getStats().copy(), mount->getClock()),
       mount_(mount),
       inodeMap_(mount_->getInodeMap()),
-      allowAppleDouble_(mount_->getEdenConfig()->allowAppleDouble.getValue()) {}
+      allowAppleDouble_(mount_->getEdenConfig()->allowAppleDouble.getValue()),
+      kernelCacheTracker_(
+          mount_->getEdenConfig()->kernelCacheSampleRate.getValue(),
+          mount_->getEdenConfig()->kernelCacheMaxSampledInodes.getValue(),
+          mount_->getEdenConfig()->nfsKernelCacheWindow.getValue()) {}
+
+void NfsDispatcherImpl::recordKernelCacheRequest(
+    InodeNumber ino,
+    KernelCacheTracker::Request request) {
+  if (!kernelCacheTracker_.isSampled(ino)) {
+    return;
+  }
+  bool isLookup = request == KernelCacheTracker::Request::Lookup;
+  auto& stats = getStats();
+  stats->increment(
+      isLookup ? &NfsStats::sampledLookup : &NfsStats::sampledGetattr);
+  if (kernelCacheTracker_.recordRequest(
+          ino, request, KernelCacheTracker::Clock::now())) {
+    stats->increment(
+        isLookup ? &NfsStats::repeatedLookup : &NfsStats::repeatedGetattr);
+  }
+}
 
 ImmediateFuture<struct stat> NfsDispatcherImpl::getattr(
     InodeNumber ino,
     const ObjectFetchContextPtr& context) {
+  recordKernelCacheRequest(ino, KernelCacheTracker::Request::Getattr);
   return inodeMap_->lookupInode(ino).thenValue(
       [context = context.copy()](const InodePtr& inode) {
         return statHelper(inode, context);
@@ -84,7 +106,9 @@ ImmediateFuture<std::tuple<InodeNumber, struct stat>> NfsDispatcherImpl::lookup(
                   context = context.copy()](const TreeInodePtr& inode) {
         return inode->getOrLoadChild(name, context);
       })
-      .thenValue([context = context.copy()](InodePtr&& inode) {
+      .thenValue([this, context = context.copy()](InodePtr&& inode) {
+        recordKernelCacheRequest(
+            inode->getNodeId(), KernelCacheTracker::Request::Lookup);
         auto statFut = statHelper(inode, context);
         return std::move(statFut).thenValue(
             [inode = std::move(inode)](
@@ -119,13 +143,26 @@ ImmediateFuture<NfsDispatcher::ReadRes> NfsDispatcherImpl::read(
     FileOffset offset,
     const ObjectFetchContextPtr& context) {
   return inodeMap_->lookupFileInode(ino).thenValue(
-      [context = context.copy(), size, offset](const FileInodePtr& inode) {
+      [this, context = context.copy(), size, offset](
+          const FileInodePtr& inode) {
+        // See FuseDispatcherImpl::read.
+        bool sampled = kernelCacheTracker_.isSampled(inode->getNodeId()) &&
+            !inode->isMaterialized();
         return inode->read(size, offset, context)
-            .thenValue(
-                [](std::tuple<std::unique_ptr<folly::IOBuf>, bool>&& res) {
-                  auto [data, isEof] = std::move(res);
-                  return ReadRes{std::move(data), isEof};
-                });
+            .thenValue([this, ino = inode->getNodeId(), offset, sampled](
+                           std::tuple<std::unique_ptr<folly::IOBuf>, bool>&&
+                               res) {
+              auto [data, isEof] = std::move(res);
+              if (sampled) {
+                auto length = data->computeChainDataLength();
+                auto& stats = getStats();
+                stats->increment(&NfsStats::sampledReadBytes, length);
+                stats->increment(
+                    &NfsStats::repeatedReadBytes,
+                    kernelCacheTracker_.recordRead(ino, offset, length));
+              }
+              return ReadRes{std::move(data), isEof};
+            });
       });
 }
 
@@ -330,14 +367,15 @@ ImmediateFuture<NfsDispatcher::ReaddirRes> NfsDispatcherImpl::readdir(
 ImmediateFuture<NfsDispatcher::ReaddirRes> NfsDispatcherImpl::readdirplus(
     InodeNumber dir,
     FileOffset offset,
-    uint32_t count,
+    uint32_t dirCount,
+    uint32_t maxCount,
     const ObjectFetchContextPtr& context) {
 #ifndef _WIN32
   return inodeMap_->lookupTreeInode(dir).thenValue(
-      [context = context.copy(), offset, count, this](
+      [context = context.copy(), offset, dirCount, maxCount, this](
           const TreeInodePtr& inode) {
-        auto [dirList, isEof] = inode->nfsReaddir(
-            NfsDirList{count, nfsv3Procs::readdirplus}, offset, context);
+        auto [dirList, isEof] =
+            inode->nfsReaddir(NfsDirList{dirCount, maxCount}, offset, context);
         auto& dirListRef = dirList.getListRef();
         std::vector<ImmediateFuture<folly::Unit>> futuresVec{};
         for (auto& entry : dirListRef) {
@@ -349,14 +387,19 @@ ImmediateFuture<NfsDispatcher::ReaddirRes> NfsDispatcherImpl::readdirplus(
                       return folly::unit;
                     }));
           } else {
+            // Children that were never loaded are stat()ed from their source
+            // control object rather than loaded.
             futuresVec.push_back(
-                inode->getOrLoadChild(PathComponent{entry.name}, context)
-                    .thenValue(
-                        [entry, context = context.copy()](InodePtr&& inodep) {
-                          return statHelper(inodep, context);
-                        })
-                    .thenTry([&entry](folly::Try<struct stat> st) {
+                inode->statChild(PathComponent{entry.name}, context)
+                    .thenTry([this, &entry](folly::Try<struct stat> st) {
                       entry.name_attributes = statToPostOpAttr(st);
+                      // The InodeMap can only resolve the handle of an inode
+                      // it knows of. Without a handle, the client sends a
+                      // LOOKUP, which loads the inode, before using it.
+                      if (!inodeMap_->isInodeLoadedOrRemembered(
+                              InodeNumber{entry.fileid})) {
+                        entry.name_handle = post_op_fh3{};
+                      }
                       return folly::unit;
                     }));
           }
@@ -374,7 +417,8 @@ ImmediateFuture<NfsDispatcher::ReaddirRes> NfsDispatcherImpl::readdirplus(
   // in production.
   (void)dir;
   (void)offset;
-  (void)count;
+  (void)dirCount;
+  (void)maxCount;
   (void)context;
   return makeImmediateFutureWith(
       []() -> NfsDispatcher::ReaddirRes { NOT_IMPLEMENTED(); });
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include "eden/fs/inodes/KernelCacheTracker.h"
 #include "eden/fs/nfs/NfsDispatcher.h"
 
 namespace facebook::eden {
@@ -102,7 +103,8 @@ class NfsDispatcherImpl : public NfsDispatcher {
   ImmediateFuture<NfsDispatcher::ReaddirRes> readdirplus(
       InodeNumber dir,
       FileOffset offset,
-      uint32_t count,
+      uint32_t dirCount,
+      uint32_t maxCount,
       const ObjectFetchContextPtr& context) override;
 
   ImmediateFuture<struct statfs> statfs(
@@ -110,10 +112,17 @@ class NfsDispatcherImpl : public NfsDispatcher {
       const ObjectFetchContextPtr& context) override;
 
  private:
+  /** Count the requests repeated for the inodes sampled for kernel caching. */
+  void recordKernelCacheRequest(
+      InodeNumber ino,
+      KernelCacheTracker::Request request);
+
   // The EdenMount associated with this dispatcher.
   EdenMount* const mount_;
   InodeMap* const inodeMap_;
 
   bool allowAppleDouble_;
+
+  KernelCacheTracker kernelCacheTracker_;
 };
 } // namespace facebook::eden
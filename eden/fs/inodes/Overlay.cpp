@@ -20,12 +20,14 @@
 #include <folly/stop_watch.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 #include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/inodes/BufferedInodeCatalog.h"
 #include "eden/fs/inodes/DirEntry.h"
 #include "eden/fs/inodes/IFileContentStore.h"
 #include "eden/fs/inodes/InodeBase.h"
 #include "eden/fs/inodes/InodeTable.h"
 #include "eden/fs/inodes/OverlayFile.h"
 #include "eden/fs/inodes/TreeInode.h"
+#include "eden/fs/inodes/mappedcatalog/MappedInodeCatalog.h"
 #include "eden/fs/inodes/memcatalog/MemInodeCatalog.h"
 #include "eden/fs/inodes/sqlitecatalog/BufferedSqliteInodeCatalog.h"
 #include "eden/fs/inodes/sqlitecatalog/SqliteInodeCatalog.h"
@@ -86,6 +88,12 @@ std::unique_ptr<InodeCatalog> makeInodeCatalog(
     XLOG(DBG4) << "Sqlite overlay being used.";
     return std::make_unique<SqliteInodeCatalog>(localDir, logger);
   } else if (inodeCatalogType == InodeCatalogType::InMemory) {
+    // Controlled via EdenConfig::inMemoryCatalogPersistent
+    if (config.inMemoryCatalogPersistent.getValue()) {
+      XLOG(DBG4) << "Persistent in-memory overlay being used.";
+      return std::make_unique<MemInodeCatalog>(
+          localDir, config.inMemoryCatalogSnapshotMinLogSize.getValue());
+    }
     XLOG(DBG4) << "In-memory overlay being used.";
     return std::make_unique<MemInodeCatalog>();
   }
@@ -95,12 +103,39 @@ std::unique_ptr<InodeCatalog> makeInodeCatalog(
     throw std::runtime_error(
         "Legacy overlay type is not supported. Please reclone.");
   }
+  if (inodeCatalogType == InodeCatalogType::Mapped) {
+    throw std::runtime_error(
+        "Mapped overlay type is not supported. Please reclone.");
+  }
   XLOG(DBG4) << "Sqlite overlay being used.";
   return std::make_unique<SqliteInodeCatalog>(localDir, logger);
 #else
-  XLOG(DBG4) << "Legacy overlay being used.";
-  return std::make_unique<FsInodeCatalog>(
+  if (inodeCatalogType == InodeCatalogType::Mapped) {
+    XLOG(DBG4) << "Mapped overlay being used.";
+    return std::make_unique<MappedInodeCatalog>(localDir);
+  }
+  // Controlled via EdenConfig::overlayAppendDirChanges
+  if (config.overlayAppendDirChanges.getValue()) {
+    XLOG(DBG4) << "Legacy overlay appending directory changes being used.";
+    return std::make_unique<FsInodeCatalog>(
+        static_cast<FileContentStore*>(fileContentStore),
+        /*appendDirChanges=*/true);
+  }
+  auto fsInodeCatalog = std::make_unique<FsInodeCatalog>(
       static_cast<FileContentStore*>(fileContentStore));
+  // Controlled via EdenConfig::overlayBuffered and
+  // EdenConfig::overlayBufferCoalesceWindow
+  auto coalesceWindow = config.overlayBufferCoalesceWindow.getValue();
+  if (inodeCatalogOptions.containsAllOf(INODE_CATALOG_BUFFERED) &&
+      coalesceWindow.count() > 0) {
+    XLOG(DBG4) << "Buffered legacy overlay being used.";
+    return std::make_unique<BufferedInodeCatalog>(
+        std::move(fsInodeCatalog),
+        coalesceWindow,
+        config.overlayBufferSize.getValue());
+  }
+  XLOG(DBG4) << "Legacy overlay being used.";
+  return fsInodeCatalog;
 #endif
 }
 
@@ -221,6 +256,7 @@ void Overlay::close() {
 
   closeAndWaitForOutstandingIO();
 #ifndef _WIN32
+  inodeContentHashTable_.reset();
   inodeMetadataTable_.reset();
 #endif // !_WIN32
 
@@ -292,6 +328,31 @@ void Overlay::initOverlay(
   if (fileContentStore_ && inodeCatalogType_ != InodeCatalogType::Legacy) {
     fileContentStore_->initialize(/*createIfNonExisting=*/true);
   }
+  if (optNextInodeNumber.has_value()) {
+    hadCleanStartup_ = true;
+  }
+#ifndef _WIN32
+  // A checkpoint left by the previous run must be removed even if
+  // checkpoints are now disabled, since the writes made from now on aren't
+  // journaled.
+  if (inodeCatalogType_ == InodeCatalogType::Legacy ||
+      inodeCatalogType_ == InodeCatalogType::Mapped) {
+    auto recovery = OverlayCheckpoint::loadAndRemove(localDir_);
+    if (recovery && !optNextInodeNumber.has_value()) {
+      optNextInodeNumber = OverlayCheckpoint::verify(
+          *recovery,
+          inodeCatalog_.get(),
+          static_cast<FileContentStore*>(fileContentStore_.get()));
+      if (optNextInodeNumber.has_value()) {
+        XLOG(INFO) << "Overlay " << localDir_
+                   << " was not shut down cleanly, but the "
+                   << recovery->dirtyInodes.size()
+                   << " inodes written since its last checkpoint are intact. "
+                   << " Skipping fsck scan.";
+      }
+    }
+  }
+#endif
   if (!optNextInodeNumber.has_value()) {
 #ifndef _WIN32
     // If the next-inode-number data is missing it means that this overlay was
@@ -314,7 +375,12 @@ void Overlay::initOverlay(
         inodeCatalog_.get(),
         static_cast<FileContentStore*>(fileContentStore_.get()),
         std::nullopt,
-        lookupCallback);
+        lookupCallback,
+        config->multiThreadedFsck.getValue()
+            ? std::max<size_t>(
+                  std::thread::hardware_concurrency(),
+                  OverlayChecker::kDefaultNumThreads)
+            : 1);
     folly::stop_watch<> fsckRuntime;
     checker.scanForErrors(progressCallback);
     auto result = checker.repairErrors();
@@ -337,8 +403,6 @@ void Overlay::initOverlay(
     // we end up here - it's a bug.
     EDEN_BUG() << "Tree Overlay is null value for NextInodeNumber";
 #endif
-  } else {
-    hadCleanStartup_ = true;
   }
 
   // On Windows, we need to scan the state of the repository every time at
@@ -365,6 +429,31 @@ void Overlay::initOverlay(
   inodeMetadataTable_ = InodeMetadataTable::open(
       (localDir_ + PathComponentPiece{FileContentStore::kMetadataFile})
           .c_str());
+  // Controlled via EdenConfig::overlayPersistContentHashes
+  if (config->overlayPersistContentHashes.getValue()) {
+    inodeContentHashTable_ = InodeContentHashTable::open(
+        (localDir_ + PathComponentPiece{FileContentStore::kContentHashFile})
+            .c_str());
+  }
+
+  // Controlled via EdenConfig::overlayBlobFileCacheSize
+  if (auto blobFileCacheSize = config->overlayBlobFileCacheSize.getValue()) {
+    static_cast<FileContentStore*>(fileContentStore_.get())
+        ->initBlobFileCache(
+            blobFileCacheSize,
+            config->overlayBlobFileCacheMinBlobSize.getValue());
+  }
+
+  // Checkpoints rely on every write being flushed by syncfs(), which a
+  // buffered catalog would defer past the checkpoint.
+  auto maxDirtyInodes = config->overlayCheckpointMaxDirtyInodes.getValue();
+  if (folly::kIsLinux && maxDirtyInodes > 0 &&
+      (inodeCatalogType_ == InodeCatalogType::Legacy ||
+       inodeCatalogType_ == InodeCatalogType::Mapped) &&
+      !dynamic_cast<BufferedInodeCatalog*>(inodeCatalog_.get())) {
+    checkpoint_ =
+        std::make_unique<OverlayCheckpoint>(localDir_, maxDirtyInodes);
+  }
 #endif // !_WIN32
 }
 
@@ -387,6 +476,13 @@ InodeNumber Overlay::allocateInodeNumber() {
   return InodeNumber{previous};
 }
 
+InodeNumber Overlay::allocateInodeNumbers(size_t count) {
+  XDCHECK_NE(0u, count);
+  auto previous = nextInodeNumber_.fetch_add(count);
+  XDCHECK_NE(0u, previous) << "allocateInodeNumbers called before initialize";
+  return InodeNumber{previous};
+}
+
 DirContents Overlay::loadOverlayDir(InodeNumber inodeNumber) {
   DurationScope statScope{stats_, &OverlayStats::loadOverlayDir};
   DirContents result(caseSensitive_);
@@ -396,6 +492,7 @@ DirContents Overlay::loadOverlayDir(InodeNumber inodeNumber) {
     return result;
   }
   const auto& dir = dirData.value();
+  result.reserve(dir.entries_ref()->size());
 
   bool shouldRewriteOverlay = false;
 
@@ -485,6 +582,9 @@ overlay::OverlayDir Overlay::serializeOverlayDir(
 
 void Overlay::saveOverlayDir(InodeNumber inodeNumber, const DirContents& dir) {
   DurationScope statScope{stats_, &OverlayStats::saveOverlayDir};
+#ifndef _WIN32
+  auto checkpointGuard = markDirty(inodeNumber);
+#endif
   inodeCatalog_->saveOverlayDir(
       inodeNumber, serializeOverlayDir(inodeNumber, dir));
 }
@@ -493,6 +593,9 @@ void Overlay::freeInodeFromMetadataTable(InodeNumber ino) {
 #ifndef _WIN32
   // TODO: batch request during GC
   getInodeMetadataTable()->freeInode(ino);
+  if (inodeContentHashTable_) {
+    inodeContentHashTable_->freeInode(ino);
+  }
 #else
   (void)ino;
 #endif
@@ -585,6 +688,7 @@ OverlayFile Overlay::createOverlayFile(
   XCHECK_LT(inodeNumber.get(), nextInodeNumber_.load(std::memory_order_relaxed))
       << "createOverlayFile called with unallocated inode number";
   XCHECK(fileContentStore_);
+  auto checkpointGuard = markDirty(inodeNumber);
   return OverlayFile(
       fileContentStore_->createOverlayFile(inodeNumber, contents),
       weak_from_this());
@@ -597,11 +701,64 @@ OverlayFile Overlay::createOverlayFile(
   XCHECK_LT(inodeNumber.get(), nextInodeNumber_.load(std::memory_order_relaxed))
       << "createOverlayFile called with unallocated inode number";
   XCHECK(fileContentStore_);
+  auto checkpointGuard = markDirty(inodeNumber);
   return OverlayFile(
       fileContentStore_->createOverlayFile(inodeNumber, contents),
       weak_from_this());
 }
 
+OverlayFile Overlay::createOverlayFileFromBlob(
+    InodeNumber inodeNumber,
+    const ObjectId& blobId,
+    const folly::IOBuf& contents) {
+  IORequest req{this};
+  XCHECK_LT(inodeNumber.get(), nextInodeNumber_.load(std::memory_order_relaxed))
+      << "createOverlayFileFromBlob called with unallocated inode number";
+  XCHECK(fileContentStore_);
+  auto checkpointGuard = markDirty(inodeNumber);
+  return OverlayFile(
+      fileContentStore_->createOverlayFileFromBlob(
+          inodeNumber, blobId, contents),
+      weak_from_this());
+}
+
+OverlayFile Overlay::createSparseOverlayFile(
+    InodeNumber inodeNumber,
+    uint64_t size) {
+  IORequest req{this};
+  XCHECK_LT(inodeNumber.get(), nextInodeNumber_.load(std::memory_order_relaxed))
+      << "createSparseOverlayFile called with unallocated inode number";
+  XCHECK(fileContentStore_);
+  auto checkpointGuard = markDirty(inodeNumber);
+  return OverlayFile(
+      fileContentStore_->createSparseOverlayFile(inodeNumber, size),
+      weak_from_this());
+}
+
+void Overlay::completeSparseOverlayFile(InodeNumber inodeNumber) {
+  IORequest req{this};
+  XCHECK(fileContentStore_);
+  auto checkpointGuard = markDirty(inodeNumber);
+  fileContentStore_->completeSparseOverlayFile(inodeNumber);
+}
+
+std::shared_lock<folly::SharedMutex> Overlay::markDirty(
+    InodeNumber inodeNumber) {
+  if (!checkpoint_) {
+    return {};
+  }
+  return checkpoint_->markDirty(inodeNumber);
+}
+
+std::shared_lock<folly::SharedMutex> Overlay::markDirty(
+    InodeNumber first,
+    InodeNumber second) {
+  if (!checkpoint_) {
+    return {};
+  }
+  return checkpoint_->markDirty(first, second);
+}
+
 #endif // !_WIN32
 
 InodeNumber Overlay::getMaxInodeNumber() {
@@ -689,6 +846,18 @@ void Overlay::handleGCRequest(GCRequest& request) {
   if (std::holds_alternative<GCRequest::MaintenanceRequest>(
           request.requestType)) {
     inodeCatalog_->maintenance();
+#ifndef _WIN32
+    if (checkpoint_) {
+      try {
+        checkpoint_->write([this] {
+          return InodeNumber{nextInodeNumber_.load(std::memory_order_relaxed)};
+        });
+      } catch (const std::exception& e) {
+        XLOG(WARN) << "Failed to checkpoint overlay " << localDir_ << ": "
+                   << e.what();
+      }
+    }
+#endif // !_WIN32
     return;
   }
 
@@ -767,6 +936,9 @@ void Overlay::addChild(
     const DirContents& content) {
   DurationScope statScope{stats_, &OverlayStats::addChild};
   if (supportsSemanticOperations_) {
+#ifndef _WIN32
+    auto checkpointGuard = markDirty(parent);
+#endif
     inodeCatalog_->addChild(
         parent, childEntry.first, serializeOverlayEntry(childEntry.second));
   } else {
@@ -780,6 +952,9 @@ void Overlay::removeChild(
     const DirContents& content) {
   DurationScope statScope{stats_, &OverlayStats::removeChild};
   if (supportsSemanticOperations_) {
+#ifndef _WIN32
+    auto checkpointGuard = markDirty(parent);
+#endif
     inodeCatalog_->removeChild(parent, childName);
   } else {
     saveOverlayDir(parent, content);
@@ -800,6 +975,9 @@ void Overlay::renameChild(
     const DirContents& dstContent) {
   DurationScope statScope{stats_, &OverlayStats::renameChild};
   if (supportsSemanticOperations_) {
+#ifndef _WIN32
+    auto checkpointGuard = markDirty(src, dst);
+#endif
     inodeCatalog_->renameChild(src, dst, srcName, dstName);
   } else {
     saveOverlayDir(src, srcContent);
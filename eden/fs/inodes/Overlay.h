@@ -30,6 +30,7 @@
 
 #ifndef _WIN32
 #include "eden/fs/inodes/fscatalog/FsInodeCatalog.h"
+#include "eden/fs/inodes/overlay/OverlayCheckpoint.h"
 #endif
 
 namespace facebook::eden {
@@ -42,6 +43,7 @@ struct DirContents;
 class InodeMap;
 class SerializedInodeMap;
 class InodeCatalog;
+class ObjectId;
 class IFileContentStore;
 class DirEntry;
 class EdenConfig;
@@ -54,6 +56,8 @@ struct InodeMetadata;
 template <typename T>
 class InodeTable;
 using InodeMetadataTable = InodeTable<InodeMetadata>;
+struct InodeContentHash;
+using InodeContentHashTable = InodeTable<InodeContentHash>;
 class OverlayFile;
 #endif
 
@@ -169,11 +173,17 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
    *   TreeInode::create() or TreeInode::mkdir().  In this case
    *   inodeCreated() should be called immediately afterwards to register the
    *   new child Inode object.
-   *
-   * TODO: It would be easy to extend this function to allocate a range of
-   * inode values in one atomic operation.
    */
   InodeNumber allocateInodeNumber();
+
+  /**
+   * Allocate count consecutive inode numbers in one atomic operation and
+   * return the first of them.
+   *
+   * TreeInode uses this to number all of the entries of a directory built
+   * from a source control tree at once.
+   */
+  InodeNumber allocateInodeNumbers(size_t count);
 #ifndef _WIN32
 
   /**
@@ -185,6 +195,15 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
     return inodeMetadataTable_.get();
   }
 
+  /**
+   * Returns the table of the SHA-1s of materialized files, or nullptr if
+   * overlay:persist-content-hashes is disabled. Records are removed along
+   * with the inode's metadata.
+   */
+  InodeContentHashTable* getInodeContentHashTable() const {
+    return inodeContentHashTable_.get();
+  }
+
 #endif // !_WIN32
 
   bool getWindowsSymlinksEnabled() const {
@@ -248,6 +267,27 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
       InodeNumber inodeNumber,
       const folly::IOBuf& contents);
 
+  /**
+   * Like createOverlayFile(), for a FileInode being materialized from the
+   * blob with the given id, which may be cloned from the blob file cache.
+   */
+  OverlayFile createOverlayFileFromBlob(
+      InodeNumber inodeNumber,
+      const ObjectId& blobId,
+      const folly::IOBuf& contents);
+
+  /**
+   * Create an overlay file of the given size without writing its contents.
+   * Its header marks it as incomplete until completeSparseOverlayFile() is
+   * called.
+   */
+  OverlayFile createSparseOverlayFile(InodeNumber inodeNumber, uint64_t size);
+
+  /**
+   * Mark a file created by createSparseOverlayFile() as complete.
+   */
+  void completeSparseOverlayFile(InodeNumber inodeNumber);
+
   /**
    * call statfs(2) on the filesystem in which the overlay is located
    */
@@ -383,6 +423,27 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
    * should be released first during shutdown.
    */
   std::unique_ptr<InodeMetadataTable> inodeMetadataTable_;
+
+  /**
+   * Disk-backed mapping from inode number to the SHA-1 of a materialized
+   * file. Only written during initialization.
+   */
+  std::unique_ptr<InodeContentHashTable> inodeContentHashTable_;
+
+  /**
+   * Set if overlay:checkpoint-max-dirty-inodes is enabled. Only written
+   * during initialization.
+   */
+  std::unique_ptr<OverlayCheckpoint> checkpoint_;
+
+  /**
+   * Journal inodeNumber in checkpoint_, if set, before it is written. The
+   * returned lock must be held until the write completes.
+   */
+  std::shared_lock<folly::SharedMutex> markDirty(InodeNumber inodeNumber);
+  std::shared_lock<folly::SharedMutex> markDirty(
+      InodeNumber first,
+      InodeNumber second);
 #endif // !_WIN32
 
   /**
@@ -9,32 +9,48 @@
 
 #include "eden/fs/inodes/OverlayFileAccess.h"
 
+#include <folly/Exception.h>
 #include <folly/Expected.h>
 #include <folly/Range.h>
+#include <folly/ScopeGuard.h>
+#include <folly/executors/SerialExecutor.h>
+#include <folly/hash/Hash.h>
+#include <folly/io/Cursor.h>
+#include <folly/lang/Bits.h>
 #include <folly/logging/xlog.h>
 #include <folly/portability/OpenSSL.h>
+#include <array>
+#include <cstring>
+#include <memory>
 
 #include "eden/fs/digest/Blake3.h"
 #include "eden/fs/inodes/FileInode.h"
 #include "eden/fs/inodes/InodeError.h"
 #include "eden/fs/inodes/InodePtr.h"
+#include "eden/fs/inodes/InodeTable.h"
 #include "eden/fs/inodes/Overlay.h"
 #include "eden/fs/inodes/OverlayFile.h"
 #include "eden/fs/inodes/TreeInode.h"
 #include "eden/fs/model/Blob.h"
+#include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/utils/Bug.h"
+#include "eden/fs/utils/UnboundedQueueExecutor.h"
 #include "folly/FileUtil.h"
 
 namespace facebook::eden {
 
-constexpr size_t kHashingBufSize = 8192;
+// Large reads let BLAKE3 hash many chunks at once with SIMD, or on several
+// threads, and amortize the per-call overhead of both hashes. Too large for
+// the stack of a fiber or a thread pool thread.
+constexpr size_t kHashingBufSize = 256 * 1024;
 
 template <typename Hasher>
 int hash(Hasher&& hasher, const OverlayFile& file) {
   FileOffset off = FileContentStore::kHeaderLength;
-  uint8_t buf[kHashingBufSize];
+  // Not zeroed: most files are much smaller than the buffer.
+  std::unique_ptr<uint8_t[]> buf{new uint8_t[kHashingBufSize]};
   while (true) {
-    const auto ret = file.preadNoInt(&buf, sizeof(buf), off);
+    const auto ret = file.preadNoInt(buf.get(), kHashingBufSize, off);
     if (ret.hasError()) {
       return ret.error();
     }
@@ -44,7 +60,7 @@ int hash(Hasher&& hasher, const OverlayFile& file) {
       break;
     }
 
-    hasher(buf, len);
+    hasher(buf.get(), len);
     off += len;
   }
 
@@ -57,6 +73,10 @@ int hash(Hasher&& hasher, const OverlayFile& file) {
  * overlay which impacts throughput under concurrent operations.
  */
 
+OverlayFileAccess::SparseContents::SparseContents(
+    std::shared_ptr<const Blob> b)
+    : blobSize{b->getSize()}, blob{std::move(b)} {}
+
 void OverlayFileAccess::Entry::Info::invalidateMetadata() {
   ++version;
   size = std::nullopt;
@@ -64,31 +84,60 @@ void OverlayFileAccess::Entry::Info::invalidateMetadata() {
   blake3 = std::nullopt;
 }
 
-OverlayFileAccess::State::State(size_t cacheSize) : entries{cacheSize} {
+void OverlayFileAccess::invalidateMetadata(
+    InodeNumber ino,
+    Entry::Info& info) {
+  info.invalidateMetadata();
+  if (info.sha1Persisted) {
+    // Holding the info lock orders this with getSha1() recording a new hash.
+    if (auto* hashTable = overlay_->getInodeContentHashTable()) {
+      hashTable->freeInode(ino);
+    }
+    info.sha1Persisted = false;
+  }
+}
+
+OverlayFileAccess::OverlayFileAccess(
+    Overlay* overlay,
+    size_t cacheSize,
+    size_t shardCount,
+    size_t ioThreadCount,
+    uint64_t sparseMinSize,
+    uint64_t sparseMaxMemory,
+    EdenStatsPtr stats)
+    : overlay_{overlay},
+      stats_{std::move(stats)},
+      sparseMinSize_{sparseMinSize},
+      sparseMaxMemory_{sparseMaxMemory},
+      shards_(std::max<size_t>(shardCount, 1)),
+      ioExecutor_{
+          ioThreadCount > 0 ? std::make_unique<UnboundedQueueExecutor>(
+                                  ioThreadCount, "OverlayIO")
+                            : nullptr} {
   if (cacheSize == 0) {
     throw std::range_error{"overlayFileCacheSize must be at least 1"};
   }
+  // Round up so that the cache as a whole keeps at least cacheSize files
+  // open.
+  auto shardSize = (cacheSize + shards_.size() - 1) / shards_.size();
+  for (auto& shard : shards_) {
+    shard.wlock()->entries.setMaxSize(shardSize);
+  }
 }
 
-OverlayFileAccess::OverlayFileAccess(Overlay* overlay, size_t cacheSize)
-    : overlay_{overlay}, state_{folly::in_place, cacheSize} {}
-
 OverlayFileAccess::~OverlayFileAccess() = default;
 
 void OverlayFileAccess::createEmptyFile(
     InodeNumber ino,
     const std::optional<std::string>& maybeBlake3Key) {
   auto file = overlay_->createOverlayFile(ino, folly::ByteRange{});
-  auto state = state_.wlock();
-  XCHECK(!state->entries.exists(ino))
-      << "Cannot create overlay file " << ino << " when it's already open!";
 
   // Computing the empty BLAKE3 hash for the given key
   auto blake3 = Blake3::create(maybeBlake3Key);
   Hash32 emptyBlake3;
   blake3.finalize(emptyBlake3.mutableBytes());
 
-  state->entries.set(
+  insertEntry(
       ino,
       std::make_shared<Entry>(
           std::move(file), size_t{0}, kEmptySha1, std::move(emptyBlake3)));
@@ -96,16 +145,124 @@ void OverlayFileAccess::createEmptyFile(
 
 void OverlayFileAccess::createFile(
     InodeNumber ino,
-    const Blob& blob,
+    const ObjectId& blobId,
+    std::shared_ptr<const Blob> blob,
     const std::optional<Hash20>& sha1,
     const std::optional<Hash32>& blake3) {
-  auto file = overlay_->createOverlayFile(ino, blob.getContents());
-  auto state = state_.wlock();
-  XCHECK(!state->entries.exists(ino))
-      << "Cannot create overlay file " << ino << " when it's already open!";
-  state->entries.set(
-      ino,
-      std::make_shared<Entry>(std::move(file), blob.getSize(), sha1, blake3));
+  auto size = blob->getSize();
+  if (sparseMinSize_ > 0 && size >= sparseMinSize_) {
+    auto sparse = std::make_shared<SparseContents>(blob);
+    bool reserved = false;
+    {
+      auto sparseFiles = sparseFiles_.wlock();
+      if (sparseFiles->totalSize + size <= sparseMaxMemory_) {
+        sparseFiles->totalSize += size;
+        sparseFiles->files.emplace(ino, sparse);
+        reserved = true;
+      }
+    }
+    if (reserved) {
+      OverlayFile file;
+      try {
+        file = overlay_->createSparseOverlayFile(ino, size);
+      } catch (const std::exception&) {
+        removeSparseFile(ino);
+        throw;
+      }
+      insertEntry(
+          ino,
+          std::make_shared<Entry>(
+              std::move(file), size, sha1, blake3, std::move(sparse)));
+      return;
+    }
+    XLOG(DBG3) << "Too many sparse overlay files in memory to materialize "
+               << ino << " sparsely";
+  }
+
+  auto file =
+      overlay_->createOverlayFileFromBlob(ino, blobId, blob->getContents());
+  insertEntry(
+      ino, std::make_shared<Entry>(std::move(file), size, sha1, blake3));
+}
+
+void OverlayFileAccess::completeSparseFiles() {
+  std::vector<InodeNumber> inodes;
+  {
+    auto sparseFiles = sparseFiles_.rlock();
+    inodes.reserve(sparseFiles->files.size());
+    for (const auto& file : sparseFiles->files) {
+      inodes.push_back(file.first);
+    }
+  }
+  for (auto ino : inodes) {
+    try {
+      auto entry = getEntryForInode(ino);
+      completeSparseFile(ino, *entry);
+    } catch (const std::exception& ex) {
+      // Most likely, the file was removed from the overlay after its inode
+      // was unlinked.
+      XLOG(DBG2) << "Unable to complete sparse overlay file " << ino << ": "
+                 << folly::exceptionStr(ex);
+      removeSparseFile(ino);
+    }
+  }
+}
+
+void OverlayFileAccess::completeSparseFile(InodeNumber ino, Entry& entry) {
+  if (!entry.sparse) {
+    return;
+  }
+  auto& sparse = *entry.sparse;
+  std::unique_lock<folly::SharedMutex> lock{sparse.mutex};
+  if (!sparse.blob) {
+    return;
+  }
+
+  auto st = entry.file.fstat();
+  if (st.hasError()) {
+    folly::throwSystemErrorExplicit(
+        st.error(), "unable to fstat sparse overlay file ", ino);
+  }
+  auto fileSize = std::max<FileOffset>(
+      st.value().st_size -
+          static_cast<FileOffset>(FileContentStore::kHeaderLength),
+      0);
+  auto end = std::min<uint64_t>(sparse.blobSize, fileSize);
+
+  for (auto [begin, gapEnd] : sparse.written.getGaps(0, end)) {
+    folly::io::Cursor cursor{&sparse.blob->getContents()};
+    cursor.skip(begin);
+    while (begin < gapEnd) {
+      auto bytes = cursor.peekBytes();
+      iovec iov;
+      iov.iov_base = const_cast<uint8_t*>(bytes.data());
+      iov.iov_len = std::min<size_t>(bytes.size(), gapEnd - begin);
+      auto xfer = entry.file.pwritev(
+          &iov, 1, begin + FileContentStore::kHeaderLength);
+      if (xfer.hasError()) {
+        folly::throwSystemErrorExplicit(
+            xfer.error(), "unable to complete sparse overlay file ", ino);
+      }
+      cursor.skip(xfer.value());
+      begin += xfer.value();
+    }
+  }
+  overlay_->completeSparseOverlayFile(ino);
+
+  XLOG(DBG4) << "Completed sparse overlay file " << ino;
+  sparse.blob.reset();
+  sparse.written.clear();
+  lock.unlock();
+  removeSparseFile(ino);
+}
+
+void OverlayFileAccess::removeSparseFile(InodeNumber ino) {
+  auto sparseFiles = sparseFiles_.wlock();
+  auto it = sparseFiles->files.find(ino);
+  if (it != sparseFiles->files.end()) {
+    sparseFiles->totalSize -= it->second->blobSize;
+    sparseFiles->files.erase(it);
+  }
 }
 
 FileOffset OverlayFileAccess::getFileSize(FileInode& inode) {
@@ -169,6 +326,27 @@ Hash20 OverlayFileAccess::getSha1(FileInode& inode) {
 
   // SHA-1 is not known, so recompute it. Do so while the lock is not held to
   // improve concurrency.
+  completeSparseFile(inode.getNodeId(), *entry);
+
+  // Unless it was recorded for the file as it is now. The file is stat'ed
+  // before it is read, so that a concurrent write makes a recorded hash stale
+  // rather than wrong.
+  auto* hashTable = overlay_->getInodeContentHashTable();
+  std::optional<struct stat> st;
+  if (hashTable) {
+    if (auto ret = entry->file.fstat(); ret.hasValue()) {
+      st = ret.value();
+      auto record = hashTable->getOptional(inode.getNodeId());
+      if (record && record->matches(*st)) {
+        stats_->increment(&OverlayStats::contentHashHit);
+        auto info = entry->info.wlock();
+        if (version == info->version) {
+          info->sha1 = record->sha1;
+        }
+        return record->sha1;
+      }
+    }
+  }
 
   SHA_CTX ctx;
   SHA1_Init(&ctx);
@@ -188,6 +366,10 @@ Hash20 OverlayFileAccess::getSha1(FileInode& inode) {
   auto info = entry->info.wlock();
   if (version == info->version) {
     info->sha1 = sha1;
+    if (st) {
+      hashTable->set(inode.getNodeId(), InodeContentHash{*st, sha1});
+      info->sha1Persisted = true;
+    }
   }
   return sha1;
 }
@@ -205,9 +387,12 @@ Hash32 OverlayFileAccess::getBlake3(
     version = info->version;
   }
 
+  completeSparseFile(inode.getNodeId(), *entry);
   auto blake3 = Blake3::create(maybeBlake3Key);
   if (auto r = hash(
-          [&blake3](const auto* buf, auto len) { blake3.update(buf, len); },
+          [&blake3](const auto* buf, auto len) {
+            blake3.updateParallel(buf, len);
+          },
           entry->file);
       r != 0) {
     throw InodeError(
@@ -228,51 +413,111 @@ Hash32 OverlayFileAccess::getBlake3(
 
 std::string OverlayFileAccess::readAllContents(FileInode& inode) {
   auto entry = getEntryForInode(inode.getNodeId());
+  completeSparseFile(inode.getNodeId(), *entry);
 
-  // Note that this code requires a write lock on the entry because the lseek()
-  // call modifies the file offset of the file descriptor. Otherwise, concurrent
-  // readAllContents() calls would step on each other.
-  //
-  // This violates our rule of not doing IO while locks are held, but
-  // readAllContents() is rare, primarily for files like .gitignore that Eden
-  // must read.
-  //
-  // TODO: implement readFile with pread instead of lseek.
-  auto info = entry->info.wlock();
-
-  auto rc = entry->file.lseek(FileContentStore::kHeaderLength, SEEK_SET);
-  if (rc.hasError()) {
-    throw InodeError(
-        rc.error(),
-        inode.inodePtrFromThis(),
-        "unable to seek in materialized FileInode");
+  // The file is shared by concurrent operations on the inode, so read it with
+  // pread rather than moving its offset.
+  std::string result;
+  FileOffset off = FileContentStore::kHeaderLength;
+  while (true) {
+    constexpr size_t kReadSize = 64 * 1024;
+    auto oldSize = result.size();
+    result.resize(oldSize + kReadSize);
+    auto ret = entry->file.preadNoInt(result.data() + oldSize, kReadSize, off);
+    if (ret.hasError()) {
+      throw InodeError(
+          ret.error(),
+          inode.inodePtrFromThis(),
+          "unable to read overlay file");
+    }
+    auto len = ret.value();
+    result.resize(oldSize + len);
+    if (len == 0) {
+      break;
+    }
+    off += len;
   }
-  auto result = entry->file.readFile();
+  return result;
+}
 
-  if (result.hasError()) {
-    throw InodeError(
-        result.error(),
-        inode.inodePtrFromThis(),
-        "unable to read overlay file");
+template <typename Fn>
+auto OverlayFileAccess::runSequenced(InodeNumber ino, Fn&& fn) {
+  folly::Executor::KeepAlive<folly::SequencedExecutor> executor;
+  {
+    auto queues = sequencedQueues_.lock();
+    auto& queue = (*queues)[ino];
+    if (!queue.executor) {
+      queue.executor = folly::SerialExecutor::create(
+          folly::getKeepAliveToken(ioExecutor_.get()));
+    }
+    ++queue.pending;
+    executor = queue.executor.copy();
   }
-  return result.value();
+  return folly::via(
+      std::move(executor), [this, ino, fn = std::forward<Fn>(fn)]() mutable {
+        SCOPE_EXIT {
+          finishSequenced(ino);
+        };
+        return fn();
+      });
 }
 
 BufVec OverlayFileAccess::read(FileInode& inode, size_t size, FileOffset off) {
   auto entry = getEntryForInode(inode.getNodeId());
+  return readEntry(*entry, inode.inodePtrFromThis(), size, off);
+}
+
+ImmediateFuture<BufVec>
+OverlayFileAccess::readAsync(FileInode& inode, size_t size, FileOffset off) {
+  if (!ioExecutor_) {
+    return makeImmediateFutureWith([&] { return read(inode, size, off); });
+  }
+  return folly::via(
+      ioExecutor_.get(),
+      [this, inode = inode.inodePtrFromThis(), size, off] {
+        auto entry = getEntryForInode(inode->getNodeId());
+        return readEntry(*entry, inode, size, off);
+      });
+}
+
+BufVec OverlayFileAccess::readEntry(
+    Entry& entry,
+    const InodePtr& inode,
+    size_t size,
+    FileOffset off) {
+  // Find the ranges that must come from the blob of a sparse file before
+  // reading it, so that a concurrent write can't leave holes in the result.
+  std::shared_lock<folly::SharedMutex> sparseLock;
+  std::vector<std::pair<size_t, size_t>> gaps;
+  if (entry.sparse) {
+    sparseLock = std::shared_lock<folly::SharedMutex>{entry.sparse->mutex};
+    auto blobSize = entry.sparse->blobSize;
+    if (entry.sparse->blob && static_cast<uint64_t>(off) < blobSize) {
+      gaps = entry.sparse->written.getGaps(
+          off, std::min<uint64_t>(off + size, blobSize));
+    }
+  }
 
   auto buf = folly::IOBuf::createCombined(size);
-  auto res = entry->file.preadNoInt(
+  auto res = entry.file.preadNoInt(
       buf->writableBuffer(), size, off + FileContentStore::kHeaderLength);
 
   if (res.hasError()) {
     throw InodeError(
-        res.error(),
-        inode.inodePtrFromThis(),
-        "pread failed during overlay file read");
+        res.error(), inode, "pread failed during overlay file read");
   }
 
   buf->append(res.value());
+  auto readEnd = static_cast<size_t>(off) + buf->length();
+  for (auto [begin, end] : gaps) {
+    end = std::min(end, readEnd);
+    if (begin >= end) {
+      break;
+    }
+    folly::io::Cursor cursor{&entry.sparse->blob->getContents()};
+    cursor.skip(begin);
+    cursor.pull(buf->writableData() + (begin - off), end - begin);
+  }
   return BufVec{std::move(buf)};
 }
 
@@ -282,23 +527,59 @@ size_t OverlayFileAccess::write(
     size_t iovcnt,
     FileOffset off) {
   auto entry = getEntryForInode(inode.getNodeId());
+  return writeEntry(*entry, inode.inodePtrFromThis(), iov, iovcnt, off);
+}
+
+ImmediateFuture<size_t> OverlayFileAccess::writeAsync(
+    FileInode& inode,
+    BufVec&& buf,
+    FileOffset off) {
+  if (!ioExecutor_) {
+    return makeImmediateFutureWith([&] {
+      auto vec = buf->getIov();
+      return write(inode, vec.data(), vec.size(), off);
+    });
+  }
+  return runSequenced(
+      inode.getNodeId(),
+      [this, inode = inode.inodePtrFromThis(), buf = std::move(buf), off] {
+        auto entry = getEntryForInode(inode->getNodeId());
+        auto vec = buf->getIov();
+        return writeEntry(*entry, inode, vec.data(), vec.size(), off);
+      });
+}
 
+size_t OverlayFileAccess::writeEntry(
+    Entry& entry,
+    const InodePtr& inode,
+    const struct iovec* iov,
+    size_t iovcnt,
+    FileOffset off) {
+  std::unique_lock<folly::SharedMutex> sparseLock;
+  if (entry.sparse) {
+    sparseLock = std::unique_lock<folly::SharedMutex>{entry.sparse->mutex};
+  }
   auto xfer =
-      entry->file.pwritev(iov, iovcnt, off + FileContentStore::kHeaderLength);
+      entry.file.pwritev(iov, iovcnt, off + FileContentStore::kHeaderLength);
   if (xfer.hasError()) {
-    throw InodeError(
-        xfer.error(),
-        inode.inodePtrFromThis(),
-        "pwritev failed during file write");
+    throw InodeError(xfer.error(), inode, "pwritev failed during file write");
   }
-  auto info = entry->info.wlock();
-  info->invalidateMetadata();
+  if (sparseLock && entry.sparse->blob) {
+    entry.sparse->written.add(off, off + xfer.value());
+  }
+  auto info = entry.info.wlock();
+  invalidateMetadata(inode->getNodeId(), *info);
 
   return xfer.value();
 }
 
 void OverlayFileAccess::truncate(FileInode& inode, FileOffset size) {
+  waitForSequenced(inode.getNodeId());
   auto entry = getEntryForInode(inode.getNodeId());
+  std::unique_lock<folly::SharedMutex> sparseLock;
+  if (entry->sparse) {
+    sparseLock = std::unique_lock<folly::SharedMutex>{entry->sparse->mutex};
+  }
   auto result = entry->file.ftruncate(size + FileContentStore::kHeaderLength);
   if (result.hasError()) {
     throw InodeError(
@@ -306,9 +587,15 @@ void OverlayFileAccess::truncate(FileInode& inode, FileOffset size) {
         inode.inodePtrFromThis(),
         "unable to ftruncate overlay file");
   }
+  // If the file grows again, the bytes past this size must read as zeros
+  // rather than come from the blob.
+  if (sparseLock && entry->sparse->blob &&
+      static_cast<uint64_t>(size) < entry->sparse->blobSize) {
+    entry->sparse->written.add(size, entry->sparse->blobSize);
+  }
 
   auto info = entry->info.wlock();
-  info->invalidateMetadata();
+  invalidateMetadata(inode.getNodeId(), *info);
 }
 
 void OverlayFileAccess::fsync(FileInode& inode, bool datasync) {
@@ -316,12 +603,48 @@ void OverlayFileAccess::fsync(FileInode& inode, bool datasync) {
   // That said, close() does not ensure data is synced, so it's safest to
   // reopen.
   auto entry = getEntryForInode(inode.getNodeId());
-  auto result = datasync ? entry->file.fdatasync() : entry->file.fsync();
+  fsyncEntry(*entry, inode.inodePtrFromThis(), datasync);
+}
+
+ImmediateFuture<folly::Unit> OverlayFileAccess::fsyncAsync(
+    FileInode& inode,
+    bool datasync) {
+  if (!ioExecutor_) {
+    return makeImmediateFutureWith([&] { fsync(inode, datasync); });
+  }
+  return runSequenced(
+      inode.getNodeId(), [this, inode = inode.inodePtrFromThis(), datasync] {
+        auto entry = getEntryForInode(inode->getNodeId());
+        fsyncEntry(*entry, inode, datasync);
+      });
+}
+
+void OverlayFileAccess::finishSequenced(InodeNumber ino) {
+  auto queues = sequencedQueues_.lock();
+  auto it = queues->find(ino);
+  XCHECK(it != queues->end());
+  if (--it->second.pending == 0) {
+    queues->erase(it);
+    sequencedDrainedCV_.notify_all();
+  }
+}
+
+void OverlayFileAccess::waitForSequenced(InodeNumber ino) {
+  if (!ioExecutor_) {
+    return;
+  }
+  auto queues = sequencedQueues_.lock();
+  sequencedDrainedCV_.wait(
+      queues.as_lock(), [&] { return queues->count(ino) == 0; });
+}
+
+void OverlayFileAccess::fsyncEntry(
+    Entry& entry,
+    const InodePtr& inode,
+    bool datasync) {
+  auto result = datasync ? entry.file.fdatasync() : entry.file.fsync();
   if (result.hasError()) {
-    throw InodeError(
-        result.error(),
-        inode.inodePtrFromThis(),
-        "unable to fsync overlay file");
+    throw InodeError(result.error(), inode, "unable to fsync overlay file");
   }
 }
 
@@ -329,6 +652,7 @@ void OverlayFileAccess::fallocate(
     FileInode& inode,
     uint64_t offset,
     uint64_t length) {
+  waitForSequenced(inode.getNodeId());
   auto entry = getEntryForInode(inode.getNodeId());
   auto result =
       entry->file.fallocate(offset, length + FileContentStore::kHeaderLength);
@@ -340,31 +664,86 @@ void OverlayFileAccess::fallocate(
   }
 }
 
+folly::Synchronized<OverlayFileAccess::State>& OverlayFileAccess::getShard(
+    InodeNumber ino) {
+  if (shards_.size() == 1) {
+    return shards_[0];
+  }
+  // Inode numbers are allocated sequentially, so mix them to spread recently
+  // created files across shards.
+  return shards_[folly::hash::twang_mix64(ino.get()) % shards_.size()];
+}
+
 OverlayFileAccess::EntryPtr OverlayFileAccess::getEntryForInode(
     InodeNumber ino) {
+  auto& shard = getShard(ino);
   {
-    auto state = state_.wlock();
+    auto state = shard.wlock();
     auto iter = state->entries.find(ino);
     if (iter != state->entries.end()) {
+      stats_->increment(&OverlayStats::fileAccessCacheHit);
       return iter->second;
     }
   }
+  stats_->increment(&OverlayStats::fileAccessCacheMiss);
 
   // No entry found. Open one while the lock is not held.
-  // TODO: A possible future optimization here is, if a SHA-1 is known when
-  // the blob is evicted, write it into an xattr when the blob is closed. When
-  // reopened, if the xattr exists, read it back out (and clear).
-  auto entry = std::make_shared<Entry>(
-      overlay_->openFileNoVerify(ino), std::nullopt, std::nullopt);
-
+  auto file = overlay_->openFileNoVerify(ino);
+  SparseContentsPtr sparse;
   {
-    auto state = state_.wlock();
-    state->entries.set(ino, entry);
+    auto sparseFiles = sparseFiles_.rlock();
+    auto it = sparseFiles->files.find(ino);
+    if (it != sparseFiles->files.end()) {
+      sparse = it->second;
+    }
   }
-
+  if (!sparse) {
+    // A sparse file that was never completed is missing whatever came from
+    // its blob, which only the process that created it had.
+    std::array<uint8_t, 8> header{};
+    auto ret = file.preadNoInt(header.data(), header.size(), 0);
+    uint32_t versionBE;
+    memcpy(&versionBE, header.data() + 4, sizeof(versionBE));
+    if (ret.hasValue() && ret.value() == header.size() &&
+        folly::Endian::big(versionBE) ==
+            FileContentStore::kSparseFileHeaderVersion) {
+      XLOG(ERR) << "overlay file for " << ino
+                << " was not completed before EdenFS exited";
+      folly::throwSystemErrorExplicit(
+          EIO, "overlay file for inode ", ino, " is incomplete");
+    }
+  }
+  auto entry = std::make_shared<Entry>(
+      std::move(file),
+      std::nullopt,
+      std::nullopt,
+      std::nullopt,
+      std::move(sparse));
+
+  auto state = shard.wlock();
+  // Another thread may have opened the file concurrently. Return its entry so
+  // that the inode has a single size and hash cache.
+  auto iter = state->entries.find(ino);
+  if (iter != state->entries.end()) {
+    return iter->second;
+  }
+  if (state->entries.size() >= state->entries.getMaxSize()) {
+    stats_->increment(&OverlayStats::fileAccessCacheEviction);
+  }
+  state->entries.set(ino, entry);
   return entry;
 }
 
+void OverlayFileAccess::insertEntry(InodeNumber ino, EntryPtr entry) {
+  auto state = getShard(ino).wlock();
+  XCHECK(!state->entries.exists(ino))
+      << "Cannot create overlay file " << ino << " when it's already open!";
+  if (state->entries.size() >= state->entries.getMaxSize()) {
+    stats_->increment(&OverlayStats::fileAccessCacheEviction);
+  }
+  state->entries.set(ino, std::move(entry));
+}
+
 } // namespace facebook::eden
 
 #endif
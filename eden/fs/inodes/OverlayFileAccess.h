@@ -8,29 +8,74 @@
 #pragma once
 
 #include <folly/File.h>
+#include <folly/SharedMutex.h>
 #include <folly/Synchronized.h>
 #include <folly/container/EvictingCacheMap.h>
+#include <folly/container/F14Map.h>
+#include <folly/executors/SequencedExecutor.h>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <vector>
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/inodes/InodePtr.h"
 #include "eden/fs/inodes/OverlayFile.h"
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/utils/BufVec.h"
+#include "eden/fs/utils/CoverageSet.h"
+#include "eden/fs/utils/ImmediateFuture.h"
+#include "eden/fs/utils/RefPtr.h"
 
 namespace facebook::eden {
 
 class Blob;
+class EdenStats;
 class FileInode;
+class ObjectId;
 class Overlay;
+class UnboundedQueueExecutor;
+
+using EdenStatsPtr = RefPtr<EdenStats>;
 
 /**
  * Provides a file handle caching layer between FileInode and the Overlay. Read
  * and write operations for different inodes can be interleaved, and the
  * OverlayFileAccess will keep a number of file handles open in LRU.
+ *
+ * The LRU is split into independently locked shards. All IO uses positional
+ * reads and writes, so a file handle is shared by every concurrent operation
+ * on its inode, and one that is evicted while in use is only closed once the
+ * last of them completes.
+ *
+ * When given IO threads, the *Async functions perform their IO on them, so
+ * that slow overlay storage does not block the calling thread. Otherwise they
+ * complete inline. Writes and fsyncs of an inode run in the order they were
+ * issued, and truncate() and fallocate() wait for them to complete first.
+ *
+ * Large blobs can be materialized sparsely: the overlay file is created at
+ * the size of the blob without writing it, and the ranges of the file that
+ * have not been written since are read from the blob, which is kept in
+ * memory. The rest of the blob is only written out when the whole file is
+ * needed (to hash it, for example) or when the overlay is closed, so an edit
+ * to a large file costs IO proportional to the bytes it touches.
  */
 class OverlayFileAccess {
  public:
-  explicit OverlayFileAccess(Overlay* overlay, size_t cacheSize);
+  /**
+   * cacheSize is divided evenly between shardCount shards.
+   *
+   * Blobs of at least sparseMinSize bytes are materialized sparsely, as long
+   * as the blobs of the incomplete files add up to at most sparseMaxMemory
+   * bytes. A sparseMinSize of 0 disables sparse materialization.
+   */
+  OverlayFileAccess(
+      Overlay* overlay,
+      size_t cacheSize,
+      size_t shardCount,
+      size_t ioThreadCount,
+      uint64_t sparseMinSize,
+      uint64_t sparseMaxMemory,
+      EdenStatsPtr stats);
   ~OverlayFileAccess();
 
   /**
@@ -46,7 +91,9 @@ class OverlayFileAccess {
 
   /**
    * Creates a new file in the overlay populated with the contents of the given
-   * blob. If a sha1 is given, it is cached in memory.
+   * blob, whose id is blobId. If a sha1 is given, it is cached in memory. The
+   * file may be created sparsely, in which case the blob is kept until the
+   * file is completed.
    *
    * The caller must verify the overlay file does not already exist. Calls to
    * any other OverlayFileAccess functions for this inode must occur after
@@ -54,10 +101,18 @@ class OverlayFileAccess {
    */
   void createFile(
       InodeNumber ino,
-      const Blob& blob,
+      const ObjectId& blobId,
+      std::shared_ptr<const Blob> blob,
       const std::optional<Hash20>& sha1,
       const std::optional<Hash32>& blake3);
 
+  /**
+   * Write out the rest of the blob of every sparsely materialized file, so
+   * that the overlay is complete. Must be called before the overlay is
+   * closed, once nothing else can access the overlay files.
+   */
+  void completeSparseFiles();
+
   /**
    * Return the size of the overlay file at the given inode number. The result
    * will never be negative.
@@ -90,6 +145,8 @@ class OverlayFileAccess {
    * requested size.
    */
   BufVec read(FileInode& inode, size_t size, FileOffset off);
+  ImmediateFuture<BufVec>
+  readAsync(FileInode& inode, size_t size, FileOffset off);
 
   /**
    * Writes data into the file at the specified offset. Returns the number of
@@ -100,6 +157,8 @@ class OverlayFileAccess {
       const struct iovec* iov,
       size_t iovcnt,
       FileOffset off);
+  ImmediateFuture<size_t>
+  writeAsync(FileInode& inode, BufVec&& buf, FileOffset off);
 
   /**
    * Sets the size of the file in the overlay.
@@ -111,6 +170,14 @@ class OverlayFileAccess {
    * metadata. It corresponds to datasync parameter to fuse_lowlevel_ops::fsync.
    */
   void fsync(FileInode& inode, bool datasync);
+  ImmediateFuture<folly::Unit> fsyncAsync(FileInode& inode, bool datasync);
+
+  /**
+   * Whether the *Async functions run on IO threads rather than inline.
+   */
+  bool isAsync() const {
+    return ioExecutor_ != nullptr;
+  }
 
   /**
    * Call fallocate(mode=0) or posix_fallocate on the backing overlay storage.
@@ -120,8 +187,8 @@ class OverlayFileAccess {
  private:
   /*
    * OverlayFileAccess can be accessed concurrently. There are two types of data
-   * to serialize under locks: the LRU cache (State::entries) and the per-inode,
-   * in-memory size and SHA-1 caches.
+   * to serialize under locks: the LRU caches (State::entries) and the
+   * per-inode, in-memory size and SHA-1 caches.
    *
    * A lock around the size and hash is necessary because they can be read and
    * updated by concurrent getFileSize and getSha1 calls. (And write() and
@@ -137,13 +204,35 @@ class OverlayFileAccess {
    * value back.
    */
 
+  /**
+   * The blob a sparse file was materialized from, and the ranges of the file
+   * that no longer come from it.
+   */
+  struct SparseContents {
+    explicit SparseContents(std::shared_ptr<const Blob> b);
+
+    const uint64_t blobSize;
+    // Held shared while reading the file, and exclusively while modifying it,
+    // so that reads see the ranges written so far consistently.
+    folly::SharedMutex mutex;
+    // Reset once the file is complete.
+    std::shared_ptr<const Blob> blob;
+    // Ranges of the file written, or truncated away, since it was created.
+    CoverageSet written;
+  };
+
+  using SparseContentsPtr = std::shared_ptr<SparseContents>;
+
   struct Entry {
     Entry(
         OverlayFile f,
         std::optional<size_t> s,
         const std::optional<Hash20>& sha1,
-        const std::optional<Hash32>& blake3 = std::nullopt)
-        : file{std::move(f)}, info{folly::in_place, s, sha1, blake3} {}
+        const std::optional<Hash32>& blake3 = std::nullopt,
+        SparseContentsPtr sparse = nullptr)
+        : file{std::move(f)},
+          sparse{std::move(sparse)},
+          info{folly::in_place, s, sha1, blake3} {}
 
     struct Info {
       Info(
@@ -158,30 +247,131 @@ class OverlayFileAccess {
       std::optional<Hash20> sha1;
       std::optional<Hash32> blake3;
       uint64_t version{0};
+      // Whether the content hash table may have a record for this file.
+      bool sha1Persisted{true};
     };
 
     const OverlayFile file;
+    // Set if the file was created sparsely in this process.
+    const SparseContentsPtr sparse;
     folly::Synchronized<Info> info;
   };
 
+  struct SparseFiles {
+    folly::F14FastMap<InodeNumber, SparseContentsPtr> files;
+    // Sum of the sizes of the blobs held by files.
+    uint64_t totalSize = 0;
+  };
+
+  /**
+   * Held by every operation using the entry, so that its file stays open
+   * after it is evicted until the last of them completes.
+   */
   using EntryPtr = std::shared_ptr<Entry>;
 
   struct State {
-    explicit State(size_t cacheSize);
-
-    folly::EvictingCacheMap<InodeNumber, EntryPtr> entries;
+    // Resized to the shard's share of the cache on construction.
+    folly::EvictingCacheMap<InodeNumber, EntryPtr> entries{1};
   };
 
   using LockedStatePtr = folly::Synchronized<State>::LockedPtr;
 
+  folly::Synchronized<State>& getShard(InodeNumber ino);
+
   /**
    * Looks up an entry for the given inode. If the entry exists, it is returned.
    * Otherwise, one is loaded (and an old entry evicted if the cache is full).
    */
   EntryPtr getEntryForInode(InodeNumber);
 
+  /**
+   * Inserts an entry for a newly created file.
+   */
+  void insertEntry(InodeNumber ino, EntryPtr entry);
+
+  static BufVec
+  readEntry(Entry& entry, const InodePtr& inode, size_t size, FileOffset off);
+  size_t writeEntry(
+      Entry& entry,
+      const InodePtr& inode,
+      const struct iovec* iov,
+      size_t iovcnt,
+      FileOffset off);
+  static void fsyncEntry(Entry& entry, const InodePtr& inode, bool datasync);
+
+  /**
+   * Run fn on the IO threads after the writes and fsyncs previously queued
+   * for ino.
+   */
+  template <typename Fn>
+  auto runSequenced(InodeNumber ino, Fn&& fn);
+
+  /**
+   * Called on the IO threads when an operation queued by runSequenced()
+   * completes.
+   */
+  void finishSequenced(InodeNumber ino);
+
+  /**
+   * Block until the operations queued by runSequenced() for ino complete.
+   * The caller must hold the inode's state lock, so that no more are queued.
+   */
+  void waitForSequenced(InodeNumber ino);
+
+  /**
+   * Write the ranges of the file that still come from its blob, if it was
+   * created sparsely, and mark it as complete.
+   */
+  void completeSparseFile(InodeNumber ino, Entry& entry);
+
+  /**
+   * Called with the entry's info locked when the file is modified.
+   */
+  void invalidateMetadata(InodeNumber ino, Entry::Info& info);
+
+  /**
+   * Forget a sparse file, releasing its blob.
+   */
+  void removeSparseFile(InodeNumber ino);
+
   Overlay* overlay_ = nullptr;
-  folly::Synchronized<State> state_;
+  EdenStatsPtr stats_;
+  const uint64_t sparseMinSize_;
+  const uint64_t sparseMaxMemory_;
+
+  /**
+   * Every incomplete sparse file. Unlike the entries, these are never
+   * evicted: their blob is the only copy of the rest of their contents.
+   */
+  folly::Synchronized<SparseFiles> sparseFiles_;
+
+  /**
+   * Never resized after construction.
+   */
+  std::vector<folly::Synchronized<State>> shards_;
+
+  struct SequencedQueue {
+    folly::Executor::KeepAlive<folly::SequencedExecutor> executor;
+    // Operations queued on executor that have not completed yet.
+    size_t pending = 0;
+  };
+
+  /**
+   * The inodes with operations queued by runSequenced(). An inode's queue is
+   * removed once it drains.
+   */
+  folly::Synchronized<
+      folly::F14FastMap<InodeNumber, SequencedQueue>,
+      std::mutex>
+      sequencedQueues_;
+  // Signaled when a queue in sequencedQueues_ drains.
+  std::condition_variable sequencedDrainedCV_;
+
+  /**
+   * Null unless IO threads were requested. Destroyed first, so that pending
+   * IO completes while the cache still exists.
+   */
+  std::unique_ptr<UnboundedQueueExecutor> ioExecutor_;
 };
 
 } // namespace facebook::eden
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/PrefetchPredictor.h"
+
+#include <fmt/format.h>
+#include <folly/Conv.h>
+#include <folly/String.h>
+#include <folly/logging/xlog.h>
+#include <algorithm>
+
+#include "eden/fs/utils/FileUtils.h"
+
+namespace facebook::eden {
+
+namespace {
+constexpr folly::StringPiece kModelHeader{"# eden prefetch predictor v1"};
+
+// How much the checkouts weigh in the score of a directory, relative to the
+// checkout after them.
+constexpr double kDecay = 0.8;
+
+// Directories whose score falls below this are forgotten. A directory loaded
+// after a single checkout is forgotten after 14 checkouts without it.
+constexpr double kMinScore = 0.05;
+} // namespace
+
+PrefetchPredictor::PrefetchPredictor(
+    AbsolutePath modelPath,
+    size_t maxDirectories)
+    : modelPath_{std::move(modelPath)}, maxDirectories_{maxDirectories} {
+  load(*state_.wlock());
+}
+
+void PrefetchPredictor::recordFileLoad(RelativePathPiece path) {
+  auto directory = path.dirname().view();
+  auto state = state_.wlock();
+  recordWarmupLoad(*state);
+  // The model file holds one directory per line.
+  if (directory.find('\n') != std::string_view::npos) {
+    return;
+  }
+  state->loadedSinceCheckout.emplace(directory);
+}
+
+void PrefetchPredictor::recordWarmupLoad(State& state) {
+  if (!state.warmup) {
+    return;
+  }
+  auto& warmup = *state.warmup;
+  auto now = std::chrono::steady_clock::now();
+  if (now - warmup.windowStart >= std::chrono::seconds{1}) {
+    warmup.windowStart = now;
+    warmup.loadsInWindow = 0;
+  }
+  if (++warmup.loadsInWindow > warmup.maxLoadsPerSecond) {
+    XLOG(DBG3) << "cancelling the predicted prefetch: more than "
+               << warmup.maxLoadsPerSecond << " files loaded in a second";
+    warmup.source.requestCancellation();
+    state.warmup.reset();
+  }
+}
+
+folly::CancellationToken PrefetchPredictor::startWarmup(
+    uint64_t maxLoadsPerSecond) {
+  auto state = state_.wlock();
+  if (state->warmup) {
+    state->warmup->source.requestCancellation();
+  }
+  state->warmup.emplace(Warmup{
+      folly::CancellationSource{},
+      maxLoadsPerSecond,
+      std::chrono::steady_clock::now()});
+  return state->warmup->source.getToken();
+}
+
+void PrefetchPredictor::checkoutCompleted() {
+  auto state = state_.wlock();
+  for (auto it = state->scores.begin(); it != state->scores.end();) {
+    it->second *= kDecay;
+    if (it->second < kMinScore) {
+      it = state->scores.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  for (const auto& directory : state->loadedSinceCheckout) {
+    state->scores[directory] += 1.0;
+  }
+  state->loadedSinceCheckout.clear();
+
+  if (state->scores.size() > maxDirectories_) {
+    std::vector<std::pair<std::string, double>> sorted{
+        state->scores.begin(), state->scores.end()};
+    std::nth_element(
+        sorted.begin(),
+        sorted.begin() + maxDirectories_,
+        sorted.end(),
+        [](const auto& a, const auto& b) { return a.second > b.second; });
+    sorted.resize(maxDirectories_);
+    state->scores =
+        folly::F14FastMap<std::string, double>{sorted.begin(), sorted.end()};
+  }
+
+  save(*state);
+}
+
+std::vector<RelativePath> PrefetchPredictor::getTopDirectories(
+    size_t count) const {
+  std::vector<std::pair<double, std::string_view>> sorted;
+  auto state = state_.rlock();
+  sorted.reserve(state->scores.size());
+  for (const auto& [directory, score] : state->scores) {
+    sorted.emplace_back(score, directory);
+  }
+  count = std::min(count, sorted.size());
+  std::partial_sort(
+      sorted.begin(),
+      sorted.begin() + count,
+      sorted.end(),
+      [](const auto& a, const auto& b) {
+        // Break ties by path so that the result is deterministic.
+        return a.first > b.first || (a.first == b.first && a.second < b.second);
+      });
+
+  std::vector<RelativePath> directories;
+  directories.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    directories.emplace_back(sorted[i].second);
+  }
+  return directories;
+}
+
+void PrefetchPredictor::load(State& state) const {
+  auto contents = readFile(modelPath_);
+  if (contents.hasException()) {
+    // There is no model before the first checkout.
+    XLOG(DBG3) << "unable to read prefetch model " << modelPath_ << ": "
+               << contents.exception().what();
+    return;
+  }
+
+  std::vector<folly::StringPiece> lines;
+  folly::split('\n', contents.value(), lines);
+  if (lines.empty() || lines[0] != kModelHeader) {
+    XLOG(WARN) << "ignoring prefetch model " << modelPath_
+               << " with an unknown format";
+    return;
+  }
+  for (size_t i = 1; i < lines.size(); ++i) {
+    folly::StringPiece scoreText, directory;
+    if (!folly::split<false>(' ', lines[i], scoreText, directory)) {
+      continue;
+    }
+    auto score = folly::tryTo<double>(scoreText);
+    if (!score.hasValue()) {
+      continue;
+    }
+    try {
+      state.scores[RelativePathPiece{directory}.asString()] = score.value();
+    } catch (const PathComponentValidationError&) {
+      continue;
+    }
+  }
+}
+
+void PrefetchPredictor::save(const State& state) const {
+  std::string contents = fmt::format("{}\n", kModelHeader);
+  for (const auto& [directory, score] : state.scores) {
+    contents += fmt::format("{} {}\n", score, directory);
+  }
+  auto result = writeFileAtomic(
+      modelPath_, folly::ByteRange{folly::StringPiece{contents}});
+  if (result.hasException()) {
+    XLOG(WARN) << "unable to save prefetch model " << modelPath_ << ": "
+               << result.exception().what();
+  }
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/CancellationToken.h>
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <folly/container/F14Set.h>
+#include <chrono>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * Learns which directories of a checkout are read from between checkouts, to
+ * predict the ones worth prefetching after the next checkout without asking
+ * a remote service.
+ *
+ * Each directory has a score: the number of checkouts after which files in it
+ * were loaded, with older checkouts weighing less than recent ones. The scores
+ * are saved in a file, typically in the client directory of the checkout, so
+ * that they carry over restarts.
+ */
+class PrefetchPredictor {
+ public:
+  /**
+   * Load the scores saved at modelPath, if any. At most maxDirectories
+   * directories are kept, the ones with the lowest scores being dropped.
+   */
+  PrefetchPredictor(AbsolutePath modelPath, size_t maxDirectories);
+
+  PrefetchPredictor(const PrefetchPredictor&) = delete;
+  PrefetchPredictor& operator=(const PrefetchPredictor&) = delete;
+
+  /**
+   * Record that the file at the given path was loaded.
+   */
+  void recordFileLoad(RelativePathPiece path);
+
+  /**
+   * Add the directories recorded since the previous checkout to the scores,
+   * and save them.
+   */
+  void checkoutCompleted();
+
+  /**
+   * Return up to count directories, from the highest score to the lowest.
+   */
+  std::vector<RelativePath> getTopDirectories(size_t count) const;
+
+  /**
+   * Start tracking a prefetch of the predicted directories. The returned token
+   * is cancelled as soon as more than maxLoadsPerSecond files are recorded
+   * within a second, as the prefetch would then slow down the user's own
+   * reads, or when the next warm-up starts.
+   */
+  folly::CancellationToken startWarmup(uint64_t maxLoadsPerSecond);
+
+ private:
+  struct Warmup {
+    folly::CancellationSource source;
+    uint64_t maxLoadsPerSecond;
+    std::chrono::steady_clock::time_point windowStart;
+    uint64_t loadsInWindow{0};
+  };
+
+  struct State {
+    folly::F14FastMap<std::string, double> scores;
+    // The directories recorded since the previous checkout.
+    folly::F14FastSet<std::string> loadedSinceCheckout;
+    std::optional<Warmup> warmup;
+  };
+
+  static void recordWarmupLoad(State& state);
+
+  void load(State& state) const;
+  void save(const State& state) const;
+
+  const AbsolutePath modelPath_;
+  const size_t maxDirectories_;
+  folly::Synchronized<State> state_;
+};
+
+} // namespace facebook::eden
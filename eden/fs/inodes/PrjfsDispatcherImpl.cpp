@@ -11,6 +11,7 @@
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
 #include <cpptoml.h>
+#include <folly/Function.h>
 #include <folly/executors/QueuedImmediateExecutor.h>
 #include <folly/logging/xlog.h>
 #include <folly/stop_watch.h>
@@ -27,6 +28,7 @@
 #include "eden/fs/utils/FaultInjector.h"
 #include "eden/fs/utils/FileUtils.h"
 #include "eden/fs/utils/PathFuncs.h"
+#include "eden/fs/utils/PathMap.h"
 #include "eden/fs/utils/SystemError.h"
 #include "eden/fs/utils/UnboundedQueueExecutor.h"
 
@@ -44,6 +46,37 @@ const std::string kConfigSocketPath{"socket"};
 const std::string kConfigClientPath{"client"};
 const std::string kConfigTable{"Config"};
 
+// Maximum number of trees whose entries are cached for enumerations. The
+// cache is cleared when full.
+constexpr size_t kMaxCachedDirEntries = 16 * 1024;
+
+// Maximum number of trees whose file sizes are kept for lookups. Lookups of
+// the children of a directory come in a burst, the trees are evicted in LRU
+// order.
+constexpr size_t kMaxCachedChildSizes = 256;
+
+// Trees with more files than this don't have their sizes fetched all at once:
+// a single lookup would fetch the metadata of the whole directory.
+constexpr size_t kMaxPrefetchedChildSizes = 4096;
+
+std::vector<PrjfsDirEntry> makeDirEntries(
+    const std::vector<PrjfsDirEntry::Ready>& cached,
+    bool isRoot) {
+  std::vector<PrjfsDirEntry> ret;
+  ret.reserve(cached.size() + isRoot);
+  for (const auto& entry : cached) {
+    ret.emplace_back(entry);
+  }
+  if (isRoot) {
+    ret.emplace_back(
+        kDotEdenPathComponent,
+        true,
+        std::nullopt,
+        ImmediateFuture<uint64_t>(0ull));
+  }
+  return ret;
+}
+
 std::string makeDotEdenConfig(EdenMount& mount) {
   auto rootTable = cpptoml::make_table();
   auto configTable = cpptoml::make_table();
@@ -66,6 +99,11 @@ std::string makeDotEdenConfig(EdenMount& mount) {
 PrjfsDispatcherImpl::PrjfsDispatcherImpl(EdenMount* mount)
     : PrjfsDispatcher(mount->getStats().copy()),
       mount_{mount},
+      childSizesCache_{
+          kMaxCachedChildSizes,
+          [objectStore = mount->getObjectStore()](const ObjectId& treeId) {
+            return fetchChildSizes(objectStore, treeId);
+          }},
       dotEdenConfig_{makeDotEdenConfig(*mount)},
       symlinksEnabled_{
           mount_->getCheckoutConfig()->getEnableWindowsSymlinks()} {}
@@ -92,10 +130,23 @@ ImmediateFuture<std::vector<PrjfsDirEntry>> PrjfsDispatcherImpl::opendir(
                                                 ->getEnableWindowsSymlinks(),
                         context = context.copy()](
                            std::variant<std::shared_ptr<const Tree>, TreeEntry>
-                               treeOrTreeEntry) mutable {
+                               treeOrTreeEntry) mutable
+                -> ImmediateFuture<std::vector<PrjfsDirEntry>> {
               auto& tree =
                   std::get<std::shared_ptr<const Tree>>(treeOrTreeEntry);
 
+              // Trees are immutable, enumerating one again only needs its
+              // sorted entries. Symlinks are resolved relative to the path of
+              // the tree, their trees aren't cached.
+              {
+                auto cache = dirEntriesCache_.rlock();
+                auto it = cache->find(tree->getHash());
+                if (it != cache->end()) {
+                  return makeDirEntries(*it->second, isRoot);
+                }
+              }
+              bool cacheable = true;
+
               std::vector<PrjfsDirEntry> ret;
               ret.reserve(tree->size() + isRoot);
               for (const auto& treeEntry : *tree) {
@@ -106,9 +157,10 @@ ImmediateFuture<std::vector<PrjfsDirEntry>> PrjfsDispatcherImpl::opendir(
                       std::nullopt,
                       ImmediateFuture<uint64_t>(0ull));
                 } else {
-                  auto optSymlinkTargetFut =
-                      (symlinksSupported &&
-                       treeEntry.second.getDtype() == dtype_t::Symlink)
+                  bool isSymlink = symlinksSupported &&
+                      treeEntry.second.getDtype() == dtype_t::Symlink;
+                  cacheable &= !isSymlink;
+                  auto optSymlinkTargetFut = isSymlink
                       ? std::make_optional(
                             objectStore
                                 ->getBlob(
@@ -147,15 +199,38 @@ ImmediateFuture<std::vector<PrjfsDirEntry>> PrjfsDispatcherImpl::opendir(
                 }
               }
 
-              if (isRoot) {
-                ret.emplace_back(
-                    kDotEdenPathComponent,
-                    true,
-                    std::nullopt,
-                    ImmediateFuture<uint64_t>(0ull));
+              if (!cacheable) {
+                if (isRoot) {
+                  ret.emplace_back(
+                      kDotEdenPathComponent,
+                      true,
+                      std::nullopt,
+                      ImmediateFuture<uint64_t>(0ull));
+                }
+                return ret;
               }
 
-              return ret;
+              std::vector<ImmediateFuture<PrjfsDirEntry::Ready>> readyEntries;
+              readyEntries.reserve(ret.size());
+              for (auto& entry : ret) {
+                readyEntries.push_back(entry.getFuture());
+              }
+              return collectAllSafe(std::move(readyEntries))
+                  .thenValue([this, treeId = tree->getHash(), isRoot](
+                                 std::vector<PrjfsDirEntry::Ready> entries) {
+                    std::sort(entries.begin(), entries.end());
+                    CachedDirEntries cached = std::make_shared<
+                        const std::vector<PrjfsDirEntry::Ready>>(
+                        std::move(entries));
+                    {
+                      auto cache = dirEntriesCache_.wlock();
+                      if (cache->size() >= kMaxCachedDirEntries) {
+                        cache->clear();
+                      }
+                      cache->emplace(treeId, cached);
+                    }
+                    return makeDirEntries(*cached, isRoot);
+                  });
             })
             .thenTry([this, path = std::move(path)](
                          folly::Try<std::vector<PrjfsDirEntry>> dirEntries) {
@@ -281,6 +356,78 @@ ImmediateFuture<bool> PrjfsDispatcherImpl::isFinalSymlinkPathDirectory(
       });
 }
 
+folly::Future<std::shared_ptr<PrjfsDispatcherImpl::ChildSizes>>
+PrjfsDispatcherImpl::fetchChildSizes(
+    std::shared_ptr<ObjectStore> objectStore,
+    const ObjectId& treeId) {
+  // The fetch is shared by the lookups of all the children, it isn't
+  // attributed to any of them.
+  auto context = ObjectFetchContext::getNullContext();
+  return objectStore->getTree(treeId, context)
+      .thenValue([objectStore, context = context.copy()](
+                     std::shared_ptr<const Tree> tree) {
+        std::vector<ObjectId> ids;
+        std::vector<ImmediateFuture<uint64_t>> sizes;
+        if (tree->size() <= kMaxPrefetchedChildSizes) {
+          for (const auto& [name, entry] : *tree) {
+            if (!entry.isTree()) {
+              ids.push_back(entry.getHash());
+              sizes.push_back(
+                  objectStore->getBlobSize(entry.getHash(), context));
+            }
+          }
+        }
+        return collectAll(std::move(sizes))
+            .thenValue([ids = std::move(ids)](
+                           std::vector<folly::Try<uint64_t>> sizes) {
+              // Files whose size couldn't be fetched are left out, their
+              // lookup fetches it again.
+              auto ret = std::make_shared<ChildSizes>();
+              ret->reserve(ids.size());
+              for (size_t i = 0; i < ids.size(); ++i) {
+                if (sizes[i].hasValue()) {
+                  ret->emplace(ids[i], sizes[i].value());
+                }
+              }
+              return ret;
+            });
+      })
+      .semi()
+      .via(&folly::QueuedImmediateExecutor::instance());
+}
+
+ImmediateFuture<uint64_t> PrjfsDispatcherImpl::getFileSize(
+    RelativePathPiece path,
+    const ObjectId& id,
+    const ObjectFetchContextPtr& context) {
+  return mount_->getTreeOrTreeEntry(path.dirname(), context)
+      .thenValue([this, id, context = context.copy()](
+                     std::variant<std::shared_ptr<const Tree>, TreeEntry>
+                         parent) -> ImmediateFuture<uint64_t> {
+        auto* tree = std::get_if<std::shared_ptr<const Tree>>(&parent);
+        if (!tree) {
+          return mount_->getObjectStore()->getBlobSize(id, context);
+        }
+        // The parent may have changed since the file was resolved, sizes are
+        // found by blob rather than by name.
+        auto treeId = (*tree)->getHash();
+        return ImmediateFuture<std::shared_ptr<ChildSizes>>{
+            childSizesCache_.get(treeId).semi()}
+            .thenTry([this, id, treeId, context = context.copy()](
+                         folly::Try<std::shared_ptr<ChildSizes>> sizes)
+                         -> ImmediateFuture<uint64_t> {
+              if (sizes.hasException()) {
+                // Don't keep the failure around for the other children.
+                childSizesCache_.erase(treeId);
+              } else if (auto it = sizes.value()->find(id);
+                         it != sizes.value()->end()) {
+                return it->second;
+              }
+              return mount_->getObjectStore()->getBlobSize(id, context);
+            });
+      });
+}
+
 ImmediateFuture<std::optional<LookupResult>> PrjfsDispatcherImpl::lookup(
     RelativePath path,
     const ObjectFetchContextPtr& context) {
@@ -299,9 +446,9 @@ ImmediateFuture<std::optional<LookupResult>> PrjfsDispatcherImpl::lookup(
               auto treeEntry = isDir
                   ? std::nullopt
                   : std::make_optional(std::get<TreeEntry>(treeOrTreeEntry));
-              auto sizeFut = isDir ? ImmediateFuture<uint64_t>{0ull}
-                                   : mount_->getObjectStore()->getBlobSize(
-                                         treeEntry->getHash(), context);
+              auto sizeFut = isDir
+                  ? ImmediateFuture<uint64_t>{0ull}
+                  : getFileSize(path, treeEntry->getHash(), context);
               bool isSymlink = !symlinksEnabled_ || isDir
                   ? false
                   : treeEntry->getDtype() == dtype_t::Symlink;
@@ -461,7 +608,7 @@ ImmediateFuture<bool> PrjfsDispatcherImpl::access(
       });
 }
 
-ImmediateFuture<std::string> PrjfsDispatcherImpl::read(
+ImmediateFuture<folly::IOBuf> PrjfsDispatcherImpl::read(
     RelativePath path,
     const ObjectFetchContextPtr& context) {
   return mount_->getServerState()
@@ -477,19 +624,16 @@ ImmediateFuture<std::string> PrjfsDispatcherImpl::read(
               auto& treeEntry = std::get<TreeEntry>(treeOrTreeEntry);
               return objectStore->getBlob(treeEntry.getHash(), context)
                   .thenValue([](std::shared_ptr<const Blob> blob) {
-                    // TODO(xavierd): directly return the Blob to the
-                    // caller.
-                    std::string res;
-                    blob->getContents().appendTo(res);
-                    return res;
+                    return blob->getContents().cloneAsValue();
                   });
             })
             .thenTry([this,
-                      path = std::move(path)](folly::Try<std::string> result) {
+                      path = std::move(path)](folly::Try<folly::IOBuf> result) {
               if (auto* exc =
                       result.tryGetExceptionObject<std::system_error>()) {
                 if (isEnoent(*exc) && path == kDotEdenConfigPath) {
-                  return folly::Try<std::string>{std::string(dotEdenConfig_)};
+                  return folly::Try<folly::IOBuf>{
+                      folly::IOBuf{folly::IOBuf::COPY_BUFFER, dotEdenConfig_}};
                 }
               }
               return result;
@@ -1005,7 +1149,8 @@ ImmediateFuture<folly::Unit> fileNotification(
     EdenMount& mount,
     RelativePath path,
     const ObjectFetchContextPtr& context,
-    bool dfatal_error = true) {
+    bool dfatal_error = true,
+    folly::Function<bool()> isSuperseded = nullptr) {
   auto receivedAt = std::chrono::steady_clock::now();
   folly::stop_watch<std::chrono::milliseconds> watch;
 
@@ -1013,8 +1158,19 @@ ImmediateFuture<folly::Unit> fileNotification(
   // non-immediately in the executor chosen by the caller thus creating a
   // not-ready ImmediateFuture to this effect.
   return makeNotReadyImmediateFuture()
-      .thenValue([&mount, path, receivedAt, context = context.copy(), watch](
-                     auto&&) mutable {
+      .thenValue([&mount,
+                  path,
+                  receivedAt,
+                  context = context.copy(),
+                  watch,
+                  isSuperseded = std::move(isSuperseded)](auto&&) mutable {
+        if (isSuperseded && isSuperseded()) {
+          // Handling a notification matches EdenFS's view of the path to its
+          // on-disk state. The notification received since on the same path
+          // will do so after this one would have.
+          mount.getStats()->increment(&PrjfsStats::fileNotificationCoalesced);
+          return folly::unit;
+        }
         auto fault = mount.getServerState()->getFaultInjector().checkAsync(
             "PrjfsDispatcherImpl::fileNotification", path);
 
@@ -1062,22 +1218,44 @@ ImmediateFuture<folly::Unit> fileNotification(
 
 } // namespace
 
+ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::coalescedFileNotification(
+    RelativePath path,
+    const ObjectFetchContextPtr& context) {
+  mount_->getStats()->increment(&PrjfsStats::fileNotificationQueued);
+  ++(*queuedNotifications_.wlock())[path];
+  auto isSuperseded = [this, path = path.copy()] {
+    auto queued = queuedNotifications_.wlock();
+    auto it = queued->find(path);
+    if (--it->second == 0) {
+      queued->erase(it);
+      return false;
+    }
+    return true;
+  };
+  return fileNotification(
+      *mount_,
+      std::move(path),
+      context,
+      /*dfatal_error=*/true,
+      std::move(isSuperseded));
+}
+
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::fileCreated(
     RelativePath path,
     const ObjectFetchContextPtr& context) {
-  return fileNotification(*mount_, std::move(path), context);
+  return coalescedFileNotification(std::move(path), context);
 }
 
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::dirCreated(
     RelativePath path,
     const ObjectFetchContextPtr& context) {
-  return fileNotification(*mount_, std::move(path), context);
+  return coalescedFileNotification(std::move(path), context);
 }
 
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::fileModified(
     RelativePath path,
     const ObjectFetchContextPtr& context) {
-  return fileNotification(*mount_, std::move(path), context);
+  return coalescedFileNotification(std::move(path), context);
 }
 
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::fileRenamed(
@@ -1086,8 +1264,8 @@ ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::fileRenamed(
     const ObjectFetchContextPtr& context) {
   // A rename is just handled like 2 notifications separate notifications on
   // the old and new paths.
-  auto oldNotification = fileNotification(*mount_, std::move(oldPath), context);
-  auto newNotification = fileNotification(*mount_, std::move(newPath), context);
+  auto oldNotification = coalescedFileNotification(std::move(oldPath), context);
+  auto newNotification = coalescedFileNotification(std::move(newPath), context);
 
   return collectAllSafe(std::move(oldNotification), std::move(newNotification))
       .thenValue(
@@ -1127,7 +1305,7 @@ ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::preDirRename(
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::fileDeleted(
     RelativePath path,
     const ObjectFetchContextPtr& context) {
-  return fileNotification(*mount_, std::move(path), context);
+  return coalescedFileNotification(std::move(path), context);
 }
 
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::preFileDelete(
@@ -1143,7 +1321,7 @@ ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::preFileDelete(
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::dirDeleted(
     RelativePath path,
     const ObjectFetchContextPtr& context) {
-  return fileNotification(*mount_, std::move(path), context);
+  return coalescedFileNotification(std::move(path), context);
 }
 
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::preDirDelete(
@@ -1161,7 +1339,7 @@ ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::preFileConvertedToFull(
     const ObjectFetchContextPtr& context) {
   // this is an asynchonous notification, so we have to treat this just like
   // all the other write notifications.
-  return fileNotification(*mount_, std::move(path), context);
+  return coalescedFileNotification(std::move(path), context);
 }
 
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::matchEdenViewOfFileToFS(
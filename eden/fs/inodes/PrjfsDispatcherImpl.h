@@ -7,9 +7,12 @@
 
 #pragma once
 
+#include <folly/container/F14Map.h>
+
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/prjfs/PrjfsDispatcher.h"
 #include "eden/fs/service/gen-cpp2/eden_types.h"
+#include "eden/fs/utils/LeaseCache.h"
 #include "eden/fs/utils/String.h"
 
 namespace facebook::eden {
@@ -34,7 +37,7 @@ class PrjfsDispatcherImpl : public PrjfsDispatcher {
       RelativePath path,
       const ObjectFetchContextPtr& context) override;
 
-  ImmediateFuture<std::string> read(
+  ImmediateFuture<folly::IOBuf> read(
       RelativePath path,
       const ObjectFetchContextPtr& context) override;
 
@@ -98,10 +101,54 @@ class PrjfsDispatcherImpl : public PrjfsDispatcher {
       const int remainingRecursionDepth = kMaxSymlinkChainDepth);
 
  private:
+  using CachedDirEntries =
+      std::shared_ptr<const std::vector<PrjfsDirEntry::Ready>>;
+  using ChildSizes = folly::F14FastMap<ObjectId, uint64_t>;
+
+  /**
+   * Return the size of the file at path, whose blob is id.
+   *
+   * ProjectedFS looks up the children of a directory one at a time. The first
+   * lookup of a file in a directory fetches the sizes of all the files in it,
+   * the following ones find theirs in childSizesCache_.
+   */
+  ImmediateFuture<uint64_t> getFileSize(
+      RelativePathPiece path,
+      const ObjectId& id,
+      const ObjectFetchContextPtr& context);
+
+  /**
+   * Queue the handling of a notification on path to the notification
+   * executor. A notification still queued when another one on the same path
+   * is received is skipped: a burst of modifications of a file is handled
+   * once.
+   */
+  ImmediateFuture<folly::Unit> coalescedFileNotification(
+      RelativePath path,
+      const ObjectFetchContextPtr& context);
+
+  static folly::Future<std::shared_ptr<ChildSizes>> fetchChildSizes(
+      std::shared_ptr<ObjectStore> objectStore,
+      const ObjectId& treeId);
+
   // The EdenMount associated with this dispatcher.
   EdenMount* const mount_;
   folly::Synchronized<std::unordered_set<RelativePath>> symlinkCheck_;
 
+  // Sorted entries of the source control trees enumerated, whose entries
+  // are not symlinks.
+  folly::Synchronized<folly::F14NodeMap<ObjectId, CachedDirEntries>>
+      dirEntriesCache_;
+
+  // Sizes of the files of the source control trees recently looked up in,
+  // keyed by tree.
+  LeaseCache<ObjectId, ChildSizes> childSizesCache_;
+
+  // Number of notifications queued on each path by
+  // coalescedFileNotification.
+  folly::Synchronized<folly::F14NodeMap<RelativePath, size_t>>
+      queuedNotifications_;
+
   const std::string dotEdenConfig_;
 
   bool symlinksEnabled_;
@@ -61,6 +61,41 @@ class FsObjectFetchContext : public ObjectFetchContext {
     return nullptr;
   }
 
+  folly::CancellationToken getCancellationToken() const override {
+    return cancellationSource_.getToken();
+  }
+
+  std::optional<std::chrono::steady_clock::time_point> getDeadline()
+      const override {
+    return deadline_;
+  }
+
+  uint64_t getRequestId() const override {
+    return requestId_;
+  }
+
+  /**
+   * Tell the fetches made with this context that the request doesn't wait
+   * for them anymore.
+   */
+  void cancel() {
+    cancellationSource_.requestCancellation();
+  }
+
+  /**
+   * Must be called before the context is used to fetch objects.
+   */
+  void setDeadline(std::chrono::steady_clock::time_point deadline) {
+    deadline_ = deadline;
+  }
+
+  /**
+   * Must be called before the context is used to fetch objects.
+   */
+  void setRequestId(uint64_t requestId) {
+    requestId_ = requestId;
+  }
+
   void deprioritize(uint64_t delta) override {
     ImportPriority prev = priority_.load(std::memory_order_acquire);
     priority_.compare_exchange_strong(
@@ -82,6 +117,10 @@ class FsObjectFetchContext : public ObjectFetchContext {
    * at the same time.
    */
   std::atomic<ImportPriority> priority_{kDefaultFsImportPriority};
+
+  folly::CancellationSource cancellationSource_;
+  std::optional<std::chrono::steady_clock::time_point> deadline_;
+  uint64_t requestId_ = 0;
 };
 
 using FsObjectFetchContextPtr = RefPtr<FsObjectFetchContext>;
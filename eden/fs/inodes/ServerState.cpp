@@ -12,8 +12,12 @@
 
 #include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/config/ReloadableConfig.h"
+#include "eden/fs/inodes/GlobCostLog.h"
+#include "eden/fs/inodes/GlobResultCache.h"
+#include "eden/fs/model/git/GitIgnoreCache.h"
 #include "eden/fs/model/git/TopLevelIgnores.h"
 #include "eden/fs/nfs/NfsServer.h"
+#include "eden/fs/store/TreeDiffCache.h"
 #include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/telemetry/FsEventLogger.h"
 #include "eden/fs/utils/Clock.h"
@@ -63,6 +67,7 @@ ServerState::ServerState(
                     privHelper_.get(),
                     mainEventBase,
                     initialConfig.numNfsThreads.getValue(),
+                    initialConfig.numNfsThreadsPerMount.getValue(),
                     initialConfig.maxNfsInflightRequests.getValue(),
                     initialConfig.runInternalRpcbind.getValue(),
                     structuredLogger_)
@@ -78,6 +83,26 @@ ServerState::ServerState(
       fsEventLogger_{
           initialConfig.requestSamplesPerMinute.getValue()
               ? std::make_shared<FsEventLogger>(config_, hiveLogger_)
+              : nullptr},
+      gitIgnoreCache_{
+          initialConfig.gitIgnoreCacheSize.getValue()
+              ? std::make_shared<GitIgnoreCache>(
+                    initialConfig.gitIgnoreCacheSize.getValue())
+              : nullptr},
+      treeDiffCache_{
+          initialConfig.treeDiffCacheSize.getValue()
+              ? std::make_shared<TreeDiffCache>(
+                    initialConfig.treeDiffCacheSize.getValue())
+              : nullptr},
+      globResultCache_{
+          initialConfig.globResultCacheSize.getValue()
+              ? std::make_shared<GlobResultCache>(
+                    initialConfig.globResultCacheSize.getValue())
+              : nullptr},
+      globCostLog_{
+          initialConfig.globCostLogSize.getValue()
+              ? std::make_shared<GlobCostLog>(
+                    initialConfig.globCostLogSize.getValue())
               : nullptr} {
   // It would be nice if we eventually built a more generic mechanism for
   // defining faults to be configured on start up.  (e.g., loading this from the
@@ -126,4 +151,18 @@ std::unique_ptr<TopLevelIgnores> ServerState::getTopLevelIgnores() {
       std::move(userGitIgnore), std::move(systemGitIgnore));
 }
 
+size_t ServerState::getTopLevelIgnoresVersion() {
+  auto edenConfig = getEdenConfig();
+
+  // Fetching the contents reloads the files if they changed.
+  auto userIgnoreFileMonitor = userIgnoreFileMonitor_.wlock();
+  (void)userIgnoreFileMonitor->getFileContents(
+      edenConfig->userIgnoreFile.getValue());
+  auto systemIgnoreFileMonitor = systemIgnoreFileMonitor_.wlock();
+  (void)systemIgnoreFileMonitor->getFileContents(
+      edenConfig->systemIgnoreFile.getValue());
+  return userIgnoreFileMonitor->getUpdateCount() +
+      systemIgnoreFileMonitor->getUpdateCount();
+}
+
 } // namespace facebook::eden
@@ -29,6 +29,7 @@ class EdenConfig;
 class EdenStats;
 class FaultInjector;
 class FsEventLogger;
+class GitIgnoreCache;
 class IHiveLogger;
 class NfsServer;
 class Notifier;
@@ -37,6 +38,9 @@ class ProcessNameCache;
 class ReloadableConfig;
 class StructuredLogger;
 class TopLevelIgnores;
+class TreeDiffCache;
+class GlobCostLog;
+class GlobResultCache;
 class UnboundedQueueExecutor;
 
 using EdenStatsPtr = RefPtr<EdenStats>;
@@ -115,6 +119,44 @@ class ServerState {
    */
   std::unique_ptr<TopLevelIgnores> getTopLevelIgnores();
 
+  /**
+   * A number that changes whenever the system or user git ignore files do, so
+   * that results computed with an earlier TopLevelIgnores can be told apart.
+   */
+  size_t getTopLevelIgnoresVersion();
+
+  /**
+   * The cache of parsed .gitignore files shared by the diffs of all mounts,
+   * or nullptr if hg:gitignore-cache-size is 0.
+   */
+  const std::shared_ptr<GitIgnoreCache>& getGitIgnoreCache() const {
+    return gitIgnoreCache_;
+  }
+
+  /**
+   * The cache of diffed pairs of source control trees shared by the diffs of
+   * all mounts, or nullptr if hg:tree-diff-cache-size is 0.
+   */
+  const std::shared_ptr<TreeDiffCache>& getTreeDiffCache() const {
+    return treeDiffCache_;
+  }
+
+  /**
+   * The cache of glob results in source control trees shared by the globs of
+   * all mounts, or nullptr if glob:result-cache-size is 0.
+   */
+  const std::shared_ptr<GlobResultCache>& getGlobResultCache() const {
+    return globResultCache_;
+  }
+
+  /**
+   * The costs of the most expensive globs, or nullptr if glob:cost-log-size
+   * is 0.
+   */
+  const std::shared_ptr<GlobCostLog>& getGlobCostLog() const {
+    return globCostLog_;
+  }
+
   /**
    * Get the UserInfo object describing the user running this edenfs process.
    */
@@ -205,5 +247,9 @@ class ServerState {
       systemIgnoreFileMonitor_;
   std::shared_ptr<Notifier> notifier_;
   std::shared_ptr<FsEventLogger> fsEventLogger_;
+  std::shared_ptr<GitIgnoreCache> gitIgnoreCache_;
+  std::shared_ptr<TreeDiffCache> treeDiffCache_;
+  std::shared_ptr<GlobResultCache> globResultCache_;
+  std::shared_ptr<GlobCostLog> globCostLog_;
 };
 } // namespace facebook::eden
@@ -158,8 +158,15 @@ TreeInode::TreeInode(
           name,
           initialMode,
           std::nullopt,
-          saveDirFromTree(ino, tree.get(), parent->getMount()),
-          tree->getHash()) {}
+          folly::kIsWindows
+              ? saveDirFromTree(ino, tree.get(), parent->getMount())
+              : buildDirFromTree(tree.get(), parent->getMount()),
+          tree->getHash()) {
+  // On Windows, the overlay must know of every directory that may have been
+  // placed on disk by ProjectedFS, which doesn't necessarily load inodes, so
+  // the entries are saved right away.
+  contents_.unsafeGetUnlocked().unsavedInodeNumbers = !folly::kIsWindows;
+}
 
 TreeInode::TreeInode(
     InodeNumber ino,
@@ -246,6 +253,7 @@ std::optional<ImmediateFuture<VirtualInode>> TreeInode::rlockGetOrFindChild(
   // Check to see if the entry is already loaded
   auto& entry = iter->second;
   if (auto inodePtr = entry.getInodePtr()) {
+    inodePtr->markAccessed();
     return VirtualInode{std::move(inodePtr)};
   }
 
@@ -299,6 +307,7 @@ TreeInode::loadChild(
   auto& entry = iter->second;
   folly::Promise<InodePtr> promise;
   auto returnFuture = promise.getSemiFuture();
+  saveInodeNumbersLocked(*contents);
   auto childNumber = entry.getInodeNumber();
   bool startLoad = getInodeMap()->startLoadingChildIfNotLoading(
       this, name, childNumber, entry.getInitialMode(), std::move(promise));
@@ -510,6 +519,7 @@ InodeNumber TreeInode::getChildInodeNumber(PathComponentPiece name) {
   if (iter == contents->entries.end()) {
     throw InodeError(ENOENT, inodePtrFromThis(), name);
   }
+  saveInodeNumbersLocked(*contents);
 
   auto& ent = iter->second;
   XDCHECK(
@@ -899,6 +909,7 @@ void TreeInode::materialize(const RenameLock* renameLock) {
           getLocationInfo(*renameLock).name));
       contents->setMaterialized();
       saveOverlayDir(contents->entries);
+      contents->unsavedInodeNumbers = false;
     }
 
     // Mark ourself materialized in our parent directory (if we have one)
@@ -956,6 +967,7 @@ void TreeInode::childMaterialized(
     childEntry.setMaterialized();
     contents->setMaterialized();
     saveOverlayDir(contents->entries);
+    contents->unsavedInodeNumbers = false;
   }
 
   // Materialize parent and publish materialization event only if newly
@@ -1028,6 +1040,7 @@ void TreeInode::childDematerialized(
     // see if we can dematerialize ourself.
     contents->setMaterialized();
     saveOverlayDir(contents->entries);
+    contents->unsavedInodeNumbers = false;
   }
 
   // Materialize parent and publish materialization event only if newly
@@ -1068,19 +1081,29 @@ void TreeInode::saveOverlayDir(
   return getOverlay()->saveOverlayDir(inodeNumber, contents);
 }
 
+void TreeInode::saveInodeNumbersLocked(TreeInodeState& state) const {
+  if (state.unsavedInodeNumbers) {
+    saveOverlayDir(state.entries);
+    state.unsavedInodeNumbers = false;
+  }
+}
+
 DirContents TreeInode::saveDirFromTree(
     InodeNumber inodeNumber,
     const Tree* tree,
     EdenMount* mount) {
-  auto overlay = mount->getOverlay();
-  auto dir = buildDirFromTree(
+  auto dir = buildDirFromTree(tree, mount);
+  // buildDirFromTree just allocated inode numbers; they should be saved.
+  mount->getOverlay()->saveOverlayDir(inodeNumber, dir);
+  return dir;
+}
+
+DirContents TreeInode::buildDirFromTree(const Tree* tree, EdenMount* mount) {
+  return buildDirFromTree(
       tree,
-      overlay,
+      mount->getOverlay(),
       mount->getCheckoutConfig()->getCaseSensitive(),
       mount->getCheckoutConfig()->getEnableWindowsSymlinks());
-  // buildDirFromTree just allocated inode numbers; they should be saved.
-  overlay->saveOverlayDir(inodeNumber, dir);
-  return dir;
 }
 
 DirContents TreeInode::buildDirFromTree(
@@ -1090,19 +1113,25 @@ DirContents TreeInode::buildDirFromTree(
     bool windowsSymlinksEnabled) {
   XCHECK(tree);
 
-  // A future optimization is for this code to allocate all of the inode numbers
-  // at once and then dole them out, one per entry. It would reduce the number
-  // of atomic operations from N to 1, though if the atomic is issued with the
-  // other work this loop is doing it may not matter much.
-
   DirContents dir(caseSensitive);
-  // TODO: O(N^2)
+  if (tree->size() == 0) {
+    return dir;
+  }
+  // Large source control directories are mostly never materialized, so their
+  // contents stay as built here: allocate exactly once rather than leaving the
+  // slack of repeated growth.
+  dir.reserve(tree->size());
+  // Number the entries from one block so that building a directory costs a
+  // single atomic operation on the overlay rather than one per entry.
+  auto nextInodeNumber = overlay->allocateInodeNumbers(tree->size()).get();
+  // The tree entries are sorted, so unless the tree and the mount disagree on
+  // case sensitivity each emplace appends to the end.
   for (const auto& treeEntry : *tree) {
     dir.emplace(
         treeEntry.first,
         modeFromTreeEntryType(filteredEntryType(
             treeEntry.second.getType(), windowsSymlinksEnabled)),
-        overlay->allocateInodeNumber(),
+        InodeNumber{nextInodeNumber++},
         treeEntry.second.getHash());
   }
   return dir;
@@ -1181,6 +1210,7 @@ FileInodePtr TreeInode::createImpl(
     auto inodeTimestamps = InodeTimestamps{now};
 
     // Record the new entry
+    saveInodeNumbersLocked(*contents);
     auto insertion = contents->entries.emplace(name, mode, childNumber);
     XCHECK(insertion.second)
         << "we already confirmed that this entry did not exist above";
@@ -1359,6 +1389,7 @@ TreeInodePtr TreeInode::mkdir(
     saveOverlayDir(childNumber, emptyDir);
 
     // Add a new entry to contents_.entries
+    saveInodeNumbersLocked(*contents);
     auto emplaceResult = contents->entries.emplace(name, mode, childNumber);
     XCHECK(emplaceResult.second)
         << "directory contents should not have changed since the check above";
@@ -1461,6 +1492,7 @@ void TreeInode::removeAllChildrenRecursively(
   // Step 3, Now all child nodes are removable, unless one of the directories
   // had a new entry added while the contents lock was not held.
   auto contents = contents_.wlock();
+  saveInodeNumbersLocked(*contents);
   auto it = contents->entries.begin();
   while (it != contents->entries.end()) {
     auto inodeNum = it->second.getInodeNumber();
@@ -1532,6 +1564,7 @@ InodePtr TreeInode::tryRemoveUnloadedChild(
     return node;
   }
 
+  saveInodeNumbersLocked(*contents);
   contents->entries.erase(it);
   if (InvalidationRequired::Yes == invalidate) {
     invalidateChannelEntryCache(*contents, inodeName, inodeNumber)
@@ -1833,7 +1866,7 @@ class TreeInode::TreeRenameLocks {
     return *destContentsLock_;
   }
 
-  const PathMap<DirEntry>::iterator& destChildIter() const {
+  const DirContents::iterator& destChildIter() const {
     return destChildIter_;
   }
   InodeBase* destChild() const {
@@ -1891,7 +1924,7 @@ class TreeInode::TreeRenameLocks {
    * This may point to destContents_->entries.end() if the destination child
    * does not exist.
    */
-  PathMap<DirEntry>::iterator destChildIter_;
+  DirContents::iterator destChildIter_;
 };
 
 ImmediateFuture<Unit> TreeInode::rename(
@@ -2048,7 +2081,7 @@ bool isAncestor(const RenameLock& renameLock, TreeInode* a, TreeInode* b) {
 ImmediateFuture<Unit> TreeInode::doRename(
     TreeRenameLocks&& locks,
     PathComponentPiece srcName,
-    PathMap<DirEntry>::iterator srcIter,
+    DirContents::iterator srcIter,
     TreeInodePtr destParent,
     PathComponentPiece destName,
     InvalidationRequired invalidate) {
@@ -2099,6 +2132,13 @@ ImmediateFuture<Unit> TreeInode::doRename(
   }
 
   // Success.
+  // The overlay is updated incrementally below, so it must already hold the
+  // entries of both directories.
+  saveInodeNumbersLocked(locks.srcInodeState());
+  if (destParent.get() != this) {
+    destParent->saveInodeNumbersLocked(locks.dstInodeState());
+  }
+
   // Update the destination with the source data (this copies in the hash if
   // it happens to be set).
   std::unique_ptr<InodeBase> deletedInode;
@@ -2328,6 +2368,12 @@ bool TreeInode::readdirImpl(
     }
   }
 
+  // The listing hands out the inode numbers of the entries, and offsets
+  // derived from them, so they must not change if this directory is unloaded.
+  if (contents_.rlock()->unsavedInodeNumbers) {
+    saveInodeNumbersLocked(*contents_.wlock());
+  }
+
   auto dir = contents_.rlock();
   auto& entries = dir->entries;
 
@@ -2392,6 +2438,65 @@ std::tuple<NfsDirList, bool> TreeInode::nfsReaddir(
   return {std::move(list), isEof};
 }
 
+#ifndef _WIN32
+ImmediateFuture<struct stat> TreeInode::statChild(
+    PathComponentPiece name,
+    const ObjectFetchContextPtr& context) {
+  InodeNumber ino;
+  mode_t initialMode = 0;
+  std::optional<ObjectId> hash;
+  {
+    auto contents = contents_.rlock();
+    auto iter = contents->entries.find(name);
+    if (iter == contents->entries.end()) {
+      return ImmediateFuture<struct stat>{
+          folly::Try<struct stat>{InodeError(ENOENT, inodePtrFromThis(), name)}};
+    }
+    const auto& entry = iter->second;
+    if (!entry.getInode()) {
+      ino = entry.getInodeNumber();
+      initialMode = entry.getInitialMode();
+      hash = entry.getOptionalHash();
+    }
+  }
+
+  if (!hash.has_value()) {
+    // The child is loaded, or its contents are only in the overlay.
+    return getOrLoadChild(name, context)
+        .thenValue([context = context.copy()](const InodePtr& child) {
+          return child->stat(context);
+        });
+  }
+
+  auto st = getMount()->initStatData();
+  st.st_ino = ino.get();
+  auto metadata = getMount()->getInodeMetadataTable()->getOptional(ino);
+  if (!metadata) {
+    // This is what InodeBase records when the child is first loaded.
+    metadata = getMount()->getInitialInodeMetadata(initialMode);
+  }
+  metadata->applyToStat(st);
+
+  if (S_ISDIR(initialMode)) {
+    return getObjectStore().getTree(*hash, context).thenValue(
+        [st](const std::shared_ptr<const Tree>& tree) mutable {
+          // See TreeInode::stat().
+          st.st_nlink = tree->size() + 2;
+          return st;
+        });
+  }
+
+  // See FileInode::stat().
+  st.st_nlink = 1;
+  return getObjectStore().getBlobSize(*hash, context).thenValue(
+      [st](uint64_t size) mutable {
+        st.st_size = size;
+        FileInode::updateBlockCount(st);
+        return st;
+      });
+}
+#endif
+
 InodeMap* TreeInode::getInodeMap() const {
   return getMount()->getInodeMap();
 }
@@ -2502,7 +2607,7 @@ ImmediateFuture<Unit> TreeInode::diff(
     inode = gitignoreEntry->getInodePtr();
     if (!inode) {
       gitignoreInodeFuture = loadChildLocked(
-                                 contents->entries,
+                                 *contents,
                                  kIgnoreFilename,
                                  *gitignoreEntry,
                                  pendingLoads,
@@ -2589,7 +2694,8 @@ ImmediateFuture<Unit> TreeInode::loadGitIgnoreThenDiff(
             context,
             currentPath,
             std::move(trees),
-            make_unique<GitIgnoreStack>(parentIgnore, ignoreFileContents),
+            context->makeIgnoreStack(
+                parentIgnore, std::move(ignoreFileContents)),
             isIgnored);
       });
 }
@@ -2632,6 +2738,8 @@ ImmediateFuture<Unit> TreeInode::computeDiff(
   std::vector<std::unique_ptr<DeferredDiffEntry>> deferredEntries;
   auto self = inodePtrFromThis();
   bool windowsSymlinksEnabled = context->getWindowsSymlinksEnabled();
+  // Whether the diff is restricted to some of the entries of this directory.
+  bool filterEntries = !context->coversAllOf(currentPath);
 
   // Grab the contents_ lock, and loop to find children that might be
   // different.  In this first pass we primarily build the list of children to
@@ -2695,10 +2803,19 @@ ImmediateFuture<Unit> TreeInode::computeDiff(
                     std::move(childPtr),
                     ignore.get(),
                     entryIgnored));
+          } else if (inodeEntry->isMaterialized() && entryIgnored) {
+            // Everything inside an ignored directory is ignored, so there is
+            // no need to load inodes to find out what it contains.
+            deferredEntries.emplace_back(
+                DeferredDiffEntry::createIgnoredOverlayEntry(
+                    context,
+                    entryPath,
+                    self,
+                    inodeEntry->getInodeNumber()));
           } else if (inodeEntry->isMaterialized()) {
             ImmediateFuture<InodePtr> inodeFuture =
                 self->loadChildLocked(
-                        contents->entries,
+                        *contents,
                         name,
                         *inodeEntry,
                         pendingLoads,
@@ -2782,7 +2899,7 @@ ImmediateFuture<Unit> TreeInode::computeDiff(
         // We'll have to load it to confirm if it is the same or different.
         ImmediateFuture<InodePtr> inodeFuture =
             self->loadChildLocked(
-                    contents->entries,
+                    *contents,
                     componentPath,
                     *inodeEntry,
                     pendingLoads,
@@ -2959,7 +3076,9 @@ ImmediateFuture<Unit> TreeInode::computeDiff(
         break;
       }
 
-      if (!matchingInodeIter) { // If the inode doesn't have this path...
+      if (filterEntries && !context->covers(currentPath + *earliestPath)) {
+        // The caller knows that this entry hasn't changed.
+      } else if (!matchingInodeIter) { // If the inode doesn't have this path...
         if (matchingScIters.size() == scIters.size()) { // ...but all trees do..
           // ...then this entry is considered removed.
           processRemoved(**matchingScIters[0]);
@@ -3450,7 +3569,7 @@ unique_ptr<CheckoutAction> TreeInode::processCheckoutEntry(
     // updated), but is not currently loaded. Start loading it and create a
     // CheckoutAction to process it once it is loaded.
     auto inodeFuture = loadChildLocked(
-        contents, name, entry, pendingLoads, ctx->getFetchContext());
+        state, name, entry, pendingLoads, ctx->getFetchContext());
     return make_unique<CheckoutAction>(
         ctx, oldScmEntry, newScmEntry, std::move(inodeFuture));
   } else {
@@ -3475,7 +3594,7 @@ unique_ptr<CheckoutAction> TreeInode::processCheckoutEntry(
         // We don't know if the files are different or not. The only way to know
         // for sure is to load the inode.
         auto inodeFuture = loadChildLocked(
-            contents, name, entry, pendingLoads, ctx->getFetchContext());
+            state, name, entry, pendingLoads, ctx->getFetchContext());
         return make_unique<CheckoutAction>(
             ctx, oldScmEntry, newScmEntry, std::move(inodeFuture));
       }
@@ -3495,7 +3614,7 @@ unique_ptr<CheckoutAction> TreeInode::processCheckoutEntry(
     // it just so we can accurately report the list of files with conflicts.
     if (entry.isDirectory()) {
       auto inodeFuture = loadChildLocked(
-          contents, name, entry, pendingLoads, ctx->getFetchContext());
+          state, name, entry, pendingLoads, ctx->getFetchContext());
       return make_unique<CheckoutAction>(
           ctx, oldScmEntry, newScmEntry, std::move(inodeFuture));
     }
@@ -3535,7 +3654,7 @@ unique_ptr<CheckoutAction> TreeInode::processCheckoutEntry(
         XLOG(DBG6) << "loading child inode after invalidation failed: inode="
                    << getNodeId() << " child=" << name;
         auto inodeFuture = loadChildLocked(
-            contents, name, entry, pendingLoads, ctx->getFetchContext());
+            state, name, entry, pendingLoads, ctx->getFetchContext());
         return make_unique<CheckoutAction>(
             ctx, oldScmEntry, newScmEntry, std::move(inodeFuture));
       }
@@ -4037,6 +4156,7 @@ void TreeInode::saveOverlayPostCheckout(
 
     // Update the overlay to include the new entries, even if dematerialized.
     saveOverlayDir(contents->entries);
+    contents->unsavedInodeNumbers = false;
   }
 
   if (stateChanged) {
@@ -4071,7 +4191,7 @@ void TreeInode::saveOverlayPostCheckout(
 }
 
 folly::Future<InodePtr> TreeInode::loadChildLocked(
-    DirContents& /* contents */,
+    TreeInodeState& state,
     PathComponentPiece name,
     DirEntry& entry,
     std::vector<IncompleteInodeLoad>& pendingLoads,
@@ -4080,6 +4200,7 @@ folly::Future<InodePtr> TreeInode::loadChildLocked(
 
   folly::Promise<InodePtr> promise;
   auto future = promise.getFuture();
+  saveInodeNumbersLocked(state);
   auto childNumber = entry.getInodeNumber();
   bool startLoad = getInodeMap()->startLoadingChildIfNotLoading(
       this, name, childNumber, entry.getInitialMode(), std::move(promise));
@@ -4200,6 +4321,20 @@ size_t TreeInode::unloadChildrenUnreferencedByFs() {
       [](InodeBase* child) { return child->getFsRefcount() == 0; });
 }
 
+size_t TreeInode::unloadChildrenIdleFor(uint8_t minIdleSweeps) {
+  auto treeChildren = getTreeChildren(this);
+  return unloadChildrenIf(
+      this,
+      getInodeMap(),
+      treeChildren,
+      [&](TreeInode& child) {
+        return child.unloadChildrenIdleFor(minIdleSweeps);
+      },
+      [&](InodeBase* child) {
+        return child->getIdleSweeps() >= minIdleSweeps;
+      });
+}
+
 namespace {
 ImmediateFuture<std::vector<TreeInodePtr>> getLoadedOrRememberedTreeChildren(
     TreeInode* self,
@@ -4366,25 +4501,81 @@ void TreeInode::forceMetadataUpdate() {
 ImmediateFuture<folly::Unit> TreeInode::ensureMaterialized(
     const ObjectFetchContextPtr& fetchContext,
     bool followSymlink) {
-  std::vector<ImmediateFuture<folly::Unit>> childFutures;
-  std::vector<PathComponent> names;
+  // Start loading all the children under a single lock acquisition, rather
+  // than taking the contents lock once per child.
+  std::vector<folly::Future<InodePtr>> fileFutures;
+  std::vector<folly::Future<InodePtr>> treeFutures;
+  std::vector<IncompleteInodeLoad> pendingLoads;
+  auto blobIds = std::make_shared<std::vector<ObjectId>>();
   {
-    auto contents = contents_.rlock();
-    names.reserve(contents->entries.size());
-    for (auto& entry : contents->entries) {
-      names.emplace_back(entry.first);
+    auto contents = contents_.wlock();
+    for (auto& [name, entry] : contents->entries) {
+      auto& futures = entry.isDirectory() ? treeFutures : fileFutures;
+      if (auto inode = entry.getInodePtr()) {
+        futures.emplace_back(std::move(inode));
+      } else {
+        futures.emplace_back(loadChildLocked(
+            *contents, name, entry, pendingLoads, fetchContext));
+      }
+
+      if (!entry.isDirectory() && !entry.isMaterialized() &&
+          (followSymlink || entry.getDtype() != dtype_t::Symlink)) {
+        blobIds->push_back(entry.getHash());
+      }
     }
   }
 
-  childFutures.reserve(names.size());
-  for (auto& name : names) {
+  // Hook up the pending load futures to properly complete the loading process
+  // when the futures are ready. We can only do this after releasing the
+  // contents_ lock.
+  for (auto& load : pendingLoads) {
+    load.finish();
+  }
+
+  std::vector<ImmediateFuture<folly::Unit>> childFutures;
+  childFutures.reserve(treeFutures.size() + 1);
+
+  // Walking the subdirectories dominates the materialization of a large
+  // subtree. Continue on the server thread pool so that they are walked in
+  // parallel, instead of one at a time on the thread that loaded them.
+  for (auto& treeFuture : treeFutures) {
     childFutures.emplace_back(
-        getOrLoadChild(name, fetchContext)
+        std::move(treeFuture)
+            .via(getMount()->getServerThreadPool().get())
             .thenValue([fetchContext = fetchContext.copy(),
                         followSymlink](InodePtr inodePtr) {
-              return inodePtr->ensureMaterialized(fetchContext, followSymlink);
-            }));
-  }
+              return inodePtr->ensureMaterialized(fetchContext, followSymlink)
+                  .semi();
+            })
+            .semi());
+  }
+
+  // Fetch the blobs of all the files in one batch, instead of one request
+  // per FileInode as each of them materializes. Errors are reported by the
+  // FileInodes themselves, which fetch any blob the batch failed to.
+  auto prefetched =
+      getObjectStore()
+          .prefetchBlobs(
+              ObjectIdRange{blobIds->data(), blobIds->size()}, fetchContext)
+          .ensure([blobIds] {});
+  childFutures.emplace_back(
+      std::move(prefetched)
+          .thenTry([fileFutures = std::move(fileFutures),
+                    fetchContext = fetchContext.copy(),
+                    followSymlink](folly::Try<folly::Unit>&&) mutable {
+            std::vector<ImmediateFuture<folly::Unit>> futures;
+            futures.reserve(fileFutures.size());
+            for (auto& fileFuture : fileFutures) {
+              futures.emplace_back(
+                  ImmediateFuture<InodePtr>{std::move(fileFuture).semi()}
+                      .thenValue([fetchContext = fetchContext.copy(),
+                                  followSymlink](InodePtr inodePtr) {
+                        return inodePtr->ensureMaterialized(
+                            fetchContext, followSymlink);
+                      }));
+            }
+            return collectAll(std::move(futures)).unit();
+          }));
 
   return collectAll(std::move(childFutures)).unit();
 }
@@ -4641,7 +4832,7 @@ void TreeInode::doPrefetch(
             inodeFutures.emplace_back(
                 lease.getTreeInode()
                     ->loadChildLocked(
-                        contents->entries, name, entry, pendingLoads, context)
+                        *contents, name, entry, pendingLoads, context)
                     .thenValue([context = context.copy()](InodePtr inode) {
                       return inode->stat(context).semi();
                     })
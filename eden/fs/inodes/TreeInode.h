@@ -16,6 +16,7 @@
 #include "eden/fs/inodes/CheckoutAction.h"
 #include "eden/fs/inodes/DirEntry.h"
 #include "eden/fs/inodes/InodeBase.h"
+#include "eden/fs/utils/FreeListAllocator.h"
 #include "eden/fs/utils/PathFuncs.h"
 
 namespace facebook::eden {
@@ -66,12 +67,24 @@ struct TreeInodeState {
    * treeHash will be none.
    */
   std::optional<ObjectId> treeHash;
+
+  /**
+   * True if the inode numbers of the entries were allocated when this
+   * directory was loaded from source control but haven't been saved to the
+   * overlay yet.
+   *
+   * Until one of them is handed out, they are private to this TreeInode and
+   * may be allocated afresh the next time the directory is loaded. See
+   * TreeInode::saveInodeNumbersLocked().
+   */
+  bool unsavedInodeNumbers{false};
 };
 
 /**
  * Represents a directory in the file system.
  */
-class TreeInode final : public InodeBaseMetadata<DirContents> {
+class TreeInode final : public InodeBaseMetadata<DirContents>,
+                        public FreeListAllocated<TreeInode> {
  public:
   using Base = InodeBaseMetadata<DirContents>;
 
@@ -211,6 +224,20 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
       off_t off,
       const ObjectFetchContextPtr& context);
 
+#ifndef _WIN32
+  /**
+   * Return the attributes of the child with the given name.
+   *
+   * Unlike getOrLoadChild(name) followed by stat(), this does not load the
+   * child's inode when it isn't loaded and isn't materialized: its attributes
+   * then come from the inode metadata table and from its source control
+   * object, so listing a large directory doesn't load all of its children.
+   */
+  ImmediateFuture<struct stat> statChild(
+      PathComponentPiece name,
+      const ObjectFetchContextPtr& context);
+#endif
+
   const folly::Synchronized<TreeInodeState>& getContents() const {
     return contents_;
   }
@@ -439,6 +466,14 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
    */
   size_t unloadChildrenUnreferencedByFs();
 
+  /**
+   * Unload all unreferenced inodes under this tree that have not been used
+   * for at least minIdleSweeps InodeMap::sweepLoadedInodes() calls.
+   *
+   * Returns the number of inodes unloaded.
+   */
+  size_t unloadChildrenIdleFor(uint8_t minIdleSweeps);
+
 #ifndef _WIN32
   /**
    * Unload all unreferenced inodes under this tree whose last access time is
@@ -517,6 +552,14 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
    */
   void childWasStat(bool isFile, const ObjectFetchContext& context);
 
+  /** Translates a Tree object from our store into a Dir object
+   * used to track the directory in the inode */
+  static DirContents buildDirFromTree(
+      const Tree* tree,
+      Overlay* overlay,
+      CaseSensitivity caseSensitive,
+      bool windowsSymlinksEnabled);
+
  private:
   class TreeRenameLocks;
   class IncompleteInodeLoad;
@@ -560,7 +603,7 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
   FOLLY_NODISCARD ImmediateFuture<folly::Unit> doRename(
       TreeRenameLocks&& locks,
       PathComponentPiece srcName,
-      PathMap<DirEntry>::iterator srcIter,
+      DirContents::iterator srcIter,
       TreeInodePtr destParent,
       PathComponentPiece destName,
       InvalidationRequired invalidate);
@@ -583,6 +626,17 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
   void saveOverlayDir(InodeNumber inodeNumber, const DirContents& contents)
       const;
 
+  /**
+   * Saves the entries to the overlay if their inode numbers haven't been.
+   *
+   * This must be called before handing out the inode number of any entry (by
+   * loading it or listing the directory) and before any incremental update of
+   * this directory in the overlay, so that the numbers stay the same if the
+   * directory is unloaded and loaded again. Directories that are loaded but
+   * never looked into thus don't cost an overlay write.
+   */
+  void saveInodeNumbersLocked(TreeInodeState& state) const;
+
   /**
    * Converts a Tree to a Dir and saves it to the Overlay under the given inode
    * number.
@@ -590,13 +644,11 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
   static DirContents
   saveDirFromTree(InodeNumber inodeNumber, const Tree* tree, EdenMount* mount);
 
-  /** Translates a Tree object from our store into a Dir object
-   * used to track the directory in the inode */
-  static DirContents buildDirFromTree(
-      const Tree* tree,
-      Overlay* overlay,
-      CaseSensitivity caseSensitive,
-      bool windowsSymlinksEnabled);
+  /**
+   * Converts a Tree to a Dir, allocating inode numbers for its entries, but
+   * doesn't save it.
+   */
+  static DirContents buildDirFromTree(const Tree* tree, EdenMount* mount);
 
   void updateAtime();
 
@@ -720,7 +772,7 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
    * lock.)
    */
   folly::Future<InodePtr> loadChildLocked(
-      DirContents& dir,
+      TreeInodeState& state,
       PathComponentPiece name,
       DirEntry& entry,
       std::vector<IncompleteInodeLoad>& pendingLoads,
@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/fscatalog/BlobFileCache.h"
+
+#include <fcntl.h>
+#include <folly/Exception.h>
+#include <folly/String.h>
+#include <folly/logging/xlog.h>
+#include <folly/portability/Unistd.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#elif defined(__APPLE__)
+#include <sys/clonefile.h>
+#endif
+
+#include "eden/fs/model/Hash.h"
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/utils/FileUtils.h"
+
+namespace facebook::eden {
+
+namespace {
+constexpr folly::StringPiece kTmpSuffix{".tmp"};
+}
+
+BlobFileCache::BlobFileCache(AbsolutePathPiece dir, uint64_t maxSize)
+    : dir_{dir}, maxSize_{maxSize} {
+  auto result = ::mkdir(dir_.c_str(), 0700);
+  if (result != 0 && errno != EEXIST) {
+    folly::throwSystemError("error creating blob file cache ", dir_.view());
+  }
+  dirFile_ = folly::File{dir_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC};
+
+  struct Existing {
+    std::string name;
+    uint64_t size;
+    struct timespec mtime;
+  };
+  std::vector<Existing> existing;
+  for (const auto& name : getAllDirectoryEntryNames(dir_).value()) {
+    auto nameStr = name.asString();
+    if (folly::StringPiece{nameStr}.endsWith(kTmpSuffix)) {
+      // Left behind by an insert that was interrupted.
+      unlinkat(dirFile_.fd(), nameStr.c_str(), 0);
+      continue;
+    }
+    struct stat st;
+    if (fstatat(dirFile_.fd(), nameStr.c_str(), &st, AT_SYMLINK_NOFOLLOW) !=
+            0 ||
+        !S_ISREG(st.st_mode)) {
+      continue;
+    }
+#ifdef __APPLE__
+    auto mtime = st.st_mtimespec;
+#else
+    auto mtime = st.st_mtim;
+#endif
+    existing.push_back(
+        Existing{std::move(nameStr), static_cast<uint64_t>(st.st_size), mtime});
+  }
+  // Files are touched when they are cloned, so the most recently modified
+  // ones are the most recently used.
+  std::sort(existing.begin(), existing.end(), [](const auto& a, const auto& b) {
+    return std::tie(a.mtime.tv_sec, a.mtime.tv_nsec) >
+        std::tie(b.mtime.tv_sec, b.mtime.tv_nsec);
+  });
+
+  auto state = state_.wlock();
+  for (auto& file : existing) {
+    state->totalSize += file.size;
+    state->lru.push_back(Entry{file.name, file.size});
+    state->index.emplace(std::move(file.name), std::prev(state->lru.end()));
+  }
+  evict(*state);
+}
+
+std::string BlobFileCache::getName(const ObjectId& blobId) {
+  // Object ids vary in length and may be long, so name the files after a
+  // hash of them.
+  return Hash20::sha1(blobId.getBytes()).toString();
+}
+
+bool BlobFileCache::cloneFile(int srcFd, int dstDirFd, const char* dstName) {
+#ifdef __linux__
+  int fd = openat(
+      dstDirFd,
+      dstName,
+      O_CREAT | O_WRONLY | O_CLOEXEC | O_NOFOLLOW | O_TRUNC,
+      0600);
+  if (fd < 0) {
+    return false;
+  }
+  folly::File dst{fd, /* ownsFd */ true};
+  if (ioctl(fd, FICLONE, srcFd) != 0) {
+    auto error = errno;
+    unlinkat(dstDirFd, dstName, 0);
+    errno = error;
+    return false;
+  }
+  return true;
+#elif defined(__APPLE__)
+  // Unlike FICLONE, fclonefileat() refuses to replace an existing file.
+  if (unlinkat(dstDirFd, dstName, 0) != 0 && errno != ENOENT) {
+    return false;
+  }
+  return fclonefileat(srcFd, dstDirFd, dstName, 0) == 0;
+#else
+  (void)srcFd;
+  (void)dstDirFd;
+  (void)dstName;
+  errno = EOPNOTSUPP;
+  return false;
+#endif
+}
+
+void BlobFileCache::onCloneError(int error) {
+  switch (error) {
+    case EOPNOTSUPP:
+#if defined(ENOTSUP) && ENOTSUP != EOPNOTSUPP
+    case ENOTSUP:
+#endif
+    case ENOTTY:
+    case EINVAL:
+    case EXDEV:
+      if (enabled_.exchange(false, std::memory_order_relaxed)) {
+        XLOG(INFO) << "The filesystem of " << dir_
+                   << " can't clone files; disabling the blob file cache: "
+                   << folly::errnoStr(error);
+      }
+      break;
+    default:
+      XLOG(WARN) << "Failed to clone a file in the blob file cache " << dir_
+                 << ": " << folly::errnoStr(error);
+  }
+}
+
+bool BlobFileCache::cloneTo(
+    const ObjectId& blobId,
+    int dstDirFd,
+    const char* dstName) {
+  if (!isEnabled()) {
+    return false;
+  }
+  auto name = getName(blobId);
+  folly::File src;
+  {
+    auto state = state_.wlock();
+    auto it = state->index.find(name);
+    if (it == state->index.end()) {
+      return false;
+    }
+    int fd = openat(
+        dirFile_.fd(), name.c_str(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+    if (fd < 0) {
+      XLOG(WARN) << "Blob file cache entry " << name << " in " << dir_
+                 << " disappeared: " << folly::errnoStr(errno);
+      state->totalSize -= it->second->size;
+      state->lru.erase(it->second);
+      state->index.erase(it);
+      return false;
+    }
+    src = folly::File{fd, /* ownsFd */ true};
+    state->lru.splice(state->lru.begin(), state->lru, it->second);
+  }
+  // Record the use so that the order of eviction survives a restart. If the
+  // file is evicted concurrently, the clone still succeeds from the open fd.
+  futimens(src.fd(), nullptr);
+
+  if (!cloneFile(src.fd(), dstDirFd, dstName)) {
+    onCloneError(errno);
+    return false;
+  }
+  return true;
+}
+
+void BlobFileCache::insert(
+    const ObjectId& blobId,
+    const folly::File& srcFile,
+    uint64_t size) {
+  if (!isEnabled() || size > maxSize_) {
+    return;
+  }
+  auto name = getName(blobId);
+  auto tmpName = name + kTmpSuffix.str();
+
+  auto state = state_.wlock();
+  if (state->index.count(name)) {
+    return;
+  }
+  if (!cloneFile(srcFile.fd(), dirFile_.fd(), tmpName.c_str())) {
+    onCloneError(errno);
+    return;
+  }
+  if (renameat(dirFile_.fd(), tmpName.c_str(), dirFile_.fd(), name.c_str()) !=
+      0) {
+    XLOG(WARN) << "Failed to add " << name << " to the blob file cache "
+               << dir_ << ": " << folly::errnoStr(errno);
+    unlinkat(dirFile_.fd(), tmpName.c_str(), 0);
+    return;
+  }
+  state->totalSize += size;
+  state->lru.push_front(Entry{name, size});
+  state->index.emplace(std::move(name), state->lru.begin());
+  evict(*state);
+}
+
+void BlobFileCache::evict(State& state) {
+  while (state.totalSize > maxSize_ && !state.lru.empty()) {
+    auto& entry = state.lru.back();
+    if (unlinkat(dirFile_.fd(), entry.name.c_str(), 0) != 0 &&
+        errno != ENOENT) {
+      XLOG(WARN) << "Failed to evict " << entry.name
+                 << " from the blob file cache " << dir_ << ": "
+                 << folly::errnoStr(errno);
+    }
+    state.totalSize -= entry.size;
+    state.index.erase(entry.name);
+    state.lru.pop_back();
+  }
+}
+
+} // namespace facebook::eden
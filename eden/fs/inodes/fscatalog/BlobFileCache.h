@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/File.h>
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <atomic>
+#include <list>
+#include <string>
+
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+class ObjectId;
+
+/**
+ * Complete overlay files holding the contents of blobs, keyed by blob id, so
+ * that materializing the same blob again can clone its file instead of
+ * writing the contents out. On filesystems with copy-on-write clones (btrfs,
+ * XFS, APFS), a clone shares the blocks of its source until either of them is
+ * modified, so materializing a large blob costs a metadata update rather than
+ * a write of the whole blob.
+ *
+ * The least recently cloned files are removed once the total size of the
+ * cache exceeds its limit. If the filesystem does not support cloning, the
+ * cache disables itself the first time a clone is attempted.
+ */
+class BlobFileCache {
+ public:
+  /**
+   * Open the cache in the given directory, creating it if necessary.
+   */
+  BlobFileCache(AbsolutePathPiece dir, uint64_t maxSize);
+
+  BlobFileCache(const BlobFileCache&) = delete;
+  BlobFileCache& operator=(const BlobFileCache&) = delete;
+
+  /**
+   * Whether cloning is (still) believed to be supported.
+   */
+  bool isEnabled() const {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Clone the file cached for blobId to dstName, relative to dstDirFd.
+   *
+   * Returns false if the blob is not cached or could not be cloned, in which
+   * case dstName does not exist.
+   */
+  bool cloneTo(const ObjectId& blobId, int dstDirFd, const char* dstName);
+
+  /**
+   * Cache a clone of srcFile, which must be a complete overlay file of `size`
+   * bytes holding the contents of blobId. Failures are logged and ignored.
+   */
+  void
+  insert(const ObjectId& blobId, const folly::File& srcFile, uint64_t size);
+
+  /**
+   * Clone srcFd to dstName, relative to dstDirFd, replacing dstName if it
+   * exists. Returns false and sets errno on failure.
+   */
+  static bool cloneFile(int srcFd, int dstDirFd, const char* dstName);
+
+ private:
+  struct Entry {
+    std::string name;
+    uint64_t size;
+  };
+
+  struct State {
+    // Most recently used first.
+    std::list<Entry> lru;
+    folly::F14FastMap<std::string, std::list<Entry>::iterator> index;
+    uint64_t totalSize = 0;
+  };
+
+  static std::string getName(const ObjectId& blobId);
+
+  /**
+   * Called when a clone fails. Disables the cache if the failure means that
+   * the filesystem can't clone files.
+   */
+  void onCloneError(int error);
+
+  void evict(State& state);
+
+  const AbsolutePath dir_;
+  const uint64_t maxSize_;
+  folly::File dirFile_;
+  std::atomic<bool> enabled_{true};
+  folly::Synchronized<State> state_;
+};
+
+} // namespace facebook::eden
@@ -17,13 +17,16 @@
 #include <folly/File.h>
 #include <folly/FileUtil.h>
 #include <folly/Range.h>
+#include <folly/hash/Checksum.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
 #include <folly/lang/ToAscii.h>
 #include <folly/logging/xlog.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 
+#include "eden/fs/inodes/fscatalog/BlobFileCache.h"
 #include "eden/fs/inodes/fscatalog/InodePath.h"
+#include "eden/fs/model/ObjectId.h"
 #include "eden/fs/service/gen-cpp2/eden_types.h"
 #include "eden/fs/utils/EdenError.h"
 #include "eden/fs/utils/FileUtils.h"
@@ -66,9 +69,30 @@ constexpr uint32_t kOverlayVersion = 1;
 constexpr size_t kInfoHeaderSize =
     kInfoHeaderMagic.size() + sizeof(kOverlayVersion);
 
+/**
+ * Directory files are rewritten without their OverlayDirDelta records once the
+ * records are larger than both the directory itself and this.
+ */
+constexpr uint64_t kMinDirDeltasCompactionSize = 64 * 1024;
+
+/**
+ * Offset of the directory length in the header of directory files with
+ * OverlayDirDelta records. It replaces the unused atime.tv_sec.
+ */
+constexpr size_t kDirLengthHeaderOffset =
+    FileContentStore::kHeaderIdentifierDir.size() + sizeof(uint32_t);
+
+/**
+ * Each OverlayDirDelta record starts with the big-endian length and CRC32C of
+ * the serialized delta that follows.
+ */
+constexpr size_t kDirDeltaRecordHeaderLength = 2 * sizeof(uint32_t);
+
 constexpr folly::StringPiece FileContentStore::kHeaderIdentifierDir;
 constexpr folly::StringPiece FileContentStore::kHeaderIdentifierFile;
 constexpr uint32_t FileContentStore::kHeaderVersion;
+constexpr uint32_t FileContentStore::kDirHeaderVersionWithDeltas;
+constexpr uint32_t FileContentStore::kSparseFileHeaderVersion;
 constexpr size_t FileContentStore::kHeaderLength;
 constexpr uint32_t FileContentStore::kNumShards;
 
@@ -81,6 +105,11 @@ static void doFormatSubdirPath(
   subdirPath[1] = hexdigit[inodeNum & 0xf];
 }
 
+FileContentStore::FileContentStore(AbsolutePathPiece localDir)
+    : localDir_{localDir} {}
+
+FileContentStore::~FileContentStore() = default;
+
 bool FsInodeCatalog::initialized() const {
   return core_->initialized();
 }
@@ -161,6 +190,7 @@ struct statfs FileContentStore::statFs() const {
 }
 
 void FileContentStore::close() {
+  blobFileCache_.reset();
   dirFile_.close();
   infoFile_.close();
 }
@@ -358,6 +388,88 @@ AbsolutePath FileContentStore::getAbsoluteFilePath(
   return localDir_ + RelativePathPiece(inodePath.c_str());
 }
 
+namespace {
+
+/**
+ * Parse a directory from the contents of its file following the header,
+ * applying the OverlayDirDelta records that follow it if there are any.
+ *
+ * validLength is set to the length of body up to the end of the last intact
+ * record.
+ */
+overlay::OverlayDir parseOverlayDir(
+    InodeNumber inodeNumber,
+    StringPiece header,
+    StringPiece body,
+    size_t& validLength) {
+  validLength = body.size();
+  IOBuf buf(IOBuf::WRAP_BUFFER, ByteRange{header});
+  folly::io::Cursor cursor(&buf);
+  cursor.skip(FileContentStore::kHeaderIdentifierDir.size());
+  if (cursor.readBE<uint32_t>() !=
+      FileContentStore::kDirHeaderVersionWithDeltas) {
+    return CompactSerializer::deserialize<overlay::OverlayDir>(body);
+  }
+
+  auto dirLength = cursor.readBE<uint64_t>();
+  if (dirLength > body.size()) {
+    throw newEdenError(
+        EIO,
+        EdenErrorType::POSIX_ERROR,
+        "Overlay file (inode ",
+        inodeNumber,
+        ") is too short for its directory: size=",
+        body.size(),
+        " expected=",
+        dirLength);
+  }
+  auto odir = CompactSerializer::deserialize<overlay::OverlayDir>(
+      body.subpiece(0, dirLength));
+  auto records = body.subpiece(dirLength);
+
+  auto& entries = *odir.entries_ref();
+  while (records.size() >= kDirDeltaRecordHeaderLength) {
+    uint32_t recordLength;
+    uint32_t recordChecksum;
+    memcpy(&recordLength, records.data(), sizeof(recordLength));
+    memcpy(
+        &recordChecksum,
+        records.data() + sizeof(recordLength),
+        sizeof(recordChecksum));
+    recordLength = folly::Endian::big(recordLength);
+    if (records.size() - kDirDeltaRecordHeaderLength < recordLength) {
+      break;
+    }
+    auto payload =
+        records.subpiece(kDirDeltaRecordHeaderLength, recordLength);
+    if (folly::crc32c(
+            reinterpret_cast<const uint8_t*>(payload.data()),
+            payload.size()) != folly::Endian::big(recordChecksum)) {
+      break;
+    }
+    auto delta =
+        CompactSerializer::deserialize<overlay::OverlayDirDelta>(payload);
+    records.advance(kDirDeltaRecordHeaderLength + recordLength);
+
+    for (const auto& name : *delta.removed_ref()) {
+      entries.erase(name);
+    }
+    for (auto& [name, entry] : *delta.added_ref()) {
+      entries.insert_or_assign(name, std::move(entry));
+    }
+  }
+  if (!records.empty()) {
+    // A record that was only partly written, because EdenFS crashed while it
+    // was appending it.
+    XLOG(WARN) << "Ignoring torn change record in overlay directory "
+               << inodeNumber;
+    validLength = body.size() - records.size();
+  }
+  return odir;
+}
+
+} // namespace
+
 std::optional<overlay::OverlayDir> FileContentStore::deserializeOverlayDir(
     InodeNumber inodeNumber) {
   // Open the file.  Return std::nullopt if the file does not exist.
@@ -393,9 +505,118 @@ std::optional<overlay::OverlayDir> FileContentStore::deserializeOverlayDir(
   StringPiece contents{serializedData};
   FileContentStore::validateHeader(
       inodeNumber, contents, FileContentStore::kHeaderIdentifierDir);
-  contents.advance(FileContentStore::kHeaderLength);
 
-  return CompactSerializer::deserialize<overlay::OverlayDir>(contents);
+  auto body = contents.subpiece(FileContentStore::kHeaderLength);
+  size_t validLength;
+  auto odir = parseOverlayDir(
+      inodeNumber,
+      contents.subpiece(0, FileContentStore::kHeaderLength),
+      body,
+      validLength);
+  if (validLength < body.size()) {
+    // Later records are appended at the end of the file: drop the torn one so
+    // that they follow the last intact record.
+    folly::checkUnixError(
+        folly::ftruncateNoInt(
+            file.fd(), FileContentStore::kHeaderLength + validLength),
+        "error truncating overlay file for inode ",
+        inodeNumber);
+  }
+  return odir;
+}
+
+FileContentStore::AppendResult FileContentStore::appendOverlayDirDelta(
+    InodeNumber inodeNumber,
+    const overlay::OverlayDirDelta& delta) {
+  auto path = FileContentStore::getFilePath(inodeNumber);
+  int fd = openat(dirFile_.fd(), path.c_str(), O_RDWR | O_CLOEXEC | O_NOFOLLOW);
+  if (fd == -1) {
+    int err = errno;
+    if (err == ENOENT) {
+      return AppendResult::NoDir;
+    }
+    folly::throwSystemErrorExplicit(
+        err,
+        "error opening overlay file for inode ",
+        inodeNumber,
+        " in ",
+        localDir_.view());
+  }
+  folly::File file{fd, /* ownsFd */ true};
+
+  std::array<char, kHeaderLength> header;
+  auto readResult = folly::preadFull(fd, header.data(), header.size(), 0);
+  folly::checkUnixError(
+      readResult, "error reading overlay file for inode ", inodeNumber);
+  validateHeader(
+      inodeNumber,
+      StringPiece{header.data(), static_cast<size_t>(readResult)},
+      kHeaderIdentifierDir);
+
+  struct stat st;
+  folly::checkUnixError(
+      fstat(fd, &st),
+      "error getting size of overlay file for inode ",
+      inodeNumber);
+  auto fileSize = static_cast<uint64_t>(st.st_size);
+
+  uint32_t versionBE;
+  memcpy(
+      &versionBE,
+      header.data() + kHeaderIdentifierDir.size(),
+      sizeof(versionBE));
+  uint64_t dirLength;
+  if (folly::Endian::big(versionBE) == kDirHeaderVersionWithDeltas) {
+    uint64_t dirLengthBE;
+    memcpy(
+        &dirLengthBE,
+        header.data() + kDirLengthHeaderOffset,
+        sizeof(dirLengthBE));
+    dirLength = folly::Endian::big(dirLengthBE);
+  } else {
+    // The directory is all there is in the file. Record its length so that
+    // the records appended after it can be told apart from it.
+    dirLength = fileSize - kHeaderLength;
+    auto newHeader = createDirHeaderWithDeltas(dirLength);
+    folly::checkUnixError(
+        folly::pwriteFull(fd, newHeader.data(), newHeader.size(), 0),
+        "error writing header of overlay file for inode ",
+        inodeNumber);
+  }
+
+  auto serializedDelta = CompactSerializer::serialize<std::string>(delta);
+  std::array<uint32_t, 2> recordHeaderBE{
+      folly::Endian::big(static_cast<uint32_t>(serializedDelta.size())),
+      folly::Endian::big(folly::crc32c(
+          reinterpret_cast<const uint8_t*>(serializedDelta.data()),
+          serializedDelta.size()))};
+  static_assert(sizeof(recordHeaderBE) == kDirDeltaRecordHeaderLength);
+  std::array<struct iovec, 2> iov;
+  iov[0].iov_base = recordHeaderBE.data();
+  iov[0].iov_len = sizeof(recordHeaderBE);
+  iov[1].iov_base = const_cast<char*>(serializedDelta.data());
+  iov[1].iov_len = serializedDelta.size();
+  folly::checkUnixError(
+      folly::pwritevFull(fd, iov.data(), iov.size(), fileSize),
+      "error appending to overlay file for inode ",
+      inodeNumber,
+      " in ",
+      localDir_.view());
+  // See createOverlayFileImpl.
+  if (inodeNumber == kRootNodeId) {
+    folly::checkUnixError(
+        folly::fdatasyncNoInt(fd),
+        "error flushing data to overlay file for inode ",
+        inodeNumber,
+        " in ",
+        localDir_.view());
+  }
+
+  auto deltasLength = fileSize - kHeaderLength - dirLength +
+      sizeof(recordHeaderBE) + serializedDelta.size();
+  return deltasLength > std::max(dirLength, kMinDirDeltasCompactionSize)
+      ? AppendResult::ShouldCompact
+      : AppendResult::Appended;
 }
 
 std::array<uint8_t, FileContentStore::kHeaderLength>
@@ -425,6 +646,17 @@ FileContentStore::createHeader(
   return headerStorage;
 }
 
+std::array<uint8_t, FileContentStore::kHeaderLength>
+FileContentStore::createDirHeaderWithDeltas(uint64_t dirLength) {
+  auto header = createHeader(kHeaderIdentifierDir, kDirHeaderVersionWithDeltas);
+  auto dirLengthBE = folly::Endian::big(dirLength);
+  memcpy(
+      header.data() + kDirLengthHeaderOffset,
+      &dirLengthBE,
+      sizeof(dirLengthBE));
+  return header;
+}
+
 folly::File FileContentStore::openFile(
     InodeNumber inodeNumber,
     folly::StringPiece headerId) {
@@ -601,6 +833,90 @@ folly::File FileContentStore::createOverlayFile(
   return createOverlayFileImpl(inodeNumber, iov.data(), iov.size());
 }
 
+folly::File FileContentStore::createOverlayFileFromBlob(
+    InodeNumber inodeNumber,
+    const ObjectId& blobId,
+    const IOBuf& contents) {
+  if (!blobFileCache_ || !blobFileCache_->isEnabled()) {
+    return createOverlayFile(inodeNumber, contents);
+  }
+  auto size = contents.computeChainDataLength();
+  if (size < blobFileCacheMinBlobSize_) {
+    return createOverlayFile(inodeNumber, contents);
+  }
+
+  auto tmpPath = getFileTmpPath(inodeNumber);
+  if (!blobFileCache_->cloneTo(blobId, dirFile_.fd(), tmpPath.data())) {
+    auto file = createOverlayFile(inodeNumber, contents);
+    blobFileCache_->insert(blobId, file, kHeaderLength + size);
+    return file;
+  }
+
+  bool success = false;
+  SCOPE_EXIT {
+    if (!success) {
+      unlinkat(dirFile_.fd(), tmpPath.data(), 0);
+    }
+  };
+  auto fd = openat(
+      dirFile_.fd(), tmpPath.data(), O_RDWR | O_CLOEXEC | O_NOFOLLOW);
+  folly::checkUnixError(
+      fd,
+      "failed to open cloned overlay file for inode ",
+      inodeNumber,
+      " in ",
+      localDir_.view());
+  folly::File file{fd, /* ownsFd */ true};
+
+  auto path = getFilePath(inodeNumber);
+  auto returnCode =
+      renameat(dirFile_.fd(), tmpPath.data(), dirFile_.fd(), path.c_str());
+  folly::checkUnixError(
+      returnCode,
+      "error committing overlay file for inode ",
+      inodeNumber,
+      " in ",
+      localDir_.view());
+  success = true;
+  return file;
+}
+
+folly::File FileContentStore::createSparseOverlayFile(
+    InodeNumber inodeNumber,
+    uint64_t size) {
+  auto header = createHeader(kHeaderIdentifierFile, kSparseFileHeaderVersion);
+  iovec iov;
+  iov.iov_base = header.data();
+  iov.iov_len = header.size();
+  auto file = createOverlayFileImpl(inodeNumber, &iov, 1);
+  folly::checkUnixError(
+      folly::ftruncateNoInt(file.fd(), kHeaderLength + size),
+      "error extending sparse overlay file for inode ",
+      inodeNumber,
+      " in ",
+      localDir_.view());
+  return file;
+}
+
+void FileContentStore::completeSparseOverlayFile(InodeNumber inodeNumber) {
+  auto file = openFileNoVerify(inodeNumber);
+  auto header = createHeader(kHeaderIdentifierFile, kHeaderVersion);
+  folly::checkUnixError(
+      folly::pwriteFull(file.fd(), header.data(), header.size(), 0),
+      "error completing sparse overlay file for inode ",
+      inodeNumber,
+      " in ",
+      localDir_.view());
+}
+
+void FileContentStore::initBlobFileCache(
+    uint64_t maxSize,
+    uint64_t minBlobSize) {
+  blobFileCache_ = std::make_unique<BlobFileCache>(
+      localDir_ + PathComponentPiece{kBlobFileCacheDir}, maxSize);
+  blobFileCacheMinBlobSize_ = minBlobSize;
+}
+
 void FileContentStore::validateHeader(
     InodeNumber inodeNumber,
     folly::StringPiece contents,
@@ -634,7 +950,9 @@ void FileContentStore::validateHeader(
 
   // Validate header version
   auto version = cursor.readBE<uint32_t>();
-  if (version != kHeaderVersion) {
+  if (version != kHeaderVersion &&
+      !(version == kDirHeaderVersionWithDeltas &&
+        headerId == kHeaderIdentifierDir)) {
     throw newEdenError(
         EINVAL,
         EdenErrorType::POSIX_ERROR,
@@ -658,6 +976,94 @@ void FsInodeCatalog::removeOverlayDir(InodeNumber inodeNumber) {
   core_->removeOverlayFile(inodeNumber);
 }
 
+void FsInodeCatalog::appendOverlayDirDelta(
+    InodeNumber inodeNumber,
+    overlay::OverlayDirDelta&& delta) {
+  switch (core_->appendOverlayDirDelta(inodeNumber, delta)) {
+    case FileContentStore::AppendResult::Appended:
+      return;
+    case FileContentStore::AppendResult::ShouldCompact: {
+      // Loading the directory applies the records, and saving it writes a new
+      // file without them.
+      auto odir = loadOverlayDir(inodeNumber);
+      if (odir) {
+        saveOverlayDir(inodeNumber, std::move(*odir));
+      }
+      return;
+    }
+    case FileContentStore::AppendResult::NoDir:
+      // Like SqliteInodeCatalog, treat a missing directory as empty.
+      if (!delta.added_ref()->empty()) {
+        overlay::OverlayDir odir;
+        odir.entries_ref() = std::move(*delta.added_ref());
+        saveOverlayDir(inodeNumber, std::move(odir));
+      }
+      return;
+  }
+}
+
+void FsInodeCatalog::addChild(
+    InodeNumber parent,
+    PathComponentPiece name,
+    overlay::OverlayEntry entry) {
+  overlay::OverlayDirDelta delta;
+  delta.added_ref()->emplace(name.asString(), std::move(entry));
+  appendOverlayDirDelta(parent, std::move(delta));
+}
+
+void FsInodeCatalog::removeChild(
+    InodeNumber parent,
+    PathComponentPiece childName) {
+  overlay::OverlayDirDelta delta;
+  delta.removed_ref()->push_back(childName.asString());
+  appendOverlayDirDelta(parent, std::move(delta));
+}
+
+bool FsInodeCatalog::hasChild(
+    InodeNumber parent,
+    PathComponentPiece childName) {
+  auto odir = loadOverlayDir(parent);
+  return odir && odir->entries_ref()->count(childName.asString()) != 0;
+}
+
+void FsInodeCatalog::renameChild(
+    InodeNumber src,
+    InodeNumber dst,
+    PathComponentPiece srcName,
+    PathComponentPiece dstName) {
+  // Reading the source directory is O(directory size), but the writes aren't.
+  auto srcDir = loadOverlayDir(src);
+  std::optional<overlay::OverlayEntry> entry;
+  if (srcDir) {
+    auto it = srcDir->entries_ref()->find(srcName.asString());
+    if (it != srcDir->entries_ref()->end()) {
+      entry = std::move(it->second);
+    }
+  }
+  if (!entry) {
+    throw newEdenError(
+        ENOENT,
+        EdenErrorType::POSIX_ERROR,
+        "cannot rename ",
+        srcName.view(),
+        ": it isn't in the overlay directory of inode ",
+        src);
+  }
+
+  overlay::OverlayDirDelta srcDelta;
+  srcDelta.removed_ref()->push_back(srcName.asString());
+  if (src == dst) {
+    srcDelta.added_ref()->emplace(dstName.asString(), std::move(*entry));
+    appendOverlayDirDelta(src, std::move(srcDelta));
+    return;
+  }
+
+  overlay::OverlayDirDelta dstDelta;
+  dstDelta.added_ref()->emplace(dstName.asString(), std::move(*entry));
+  appendOverlayDirDelta(src, std::move(srcDelta));
+  appendOverlayDirDelta(dst, std::move(dstDelta));
+}
+
 bool FileContentStore::hasOverlayFile(InodeNumber inodeNumber) {
   // TODO: It might be worth maintaining a memory-mapped set to rapidly
   // query whether the overlay has an entry for a particular inode.  As it is,
@@ -676,13 +1082,17 @@ bool FsInodeCatalog::hasOverlayDir(InodeNumber inodeNumber) {
 }
 
 namespace {
-overlay::OverlayDir loadDirectoryChildren(folly::File& file) {
+overlay::OverlayDir loadDirectoryChildren(
+    InodeNumber number,
+    StringPiece header,
+    folly::File& file) {
   std::string serializedData;
   if (!folly::readFile(file.fd(), serializedData)) {
     folly::throwSystemError("read failed");
   }
 
-  return CompactSerializer::deserialize<overlay::OverlayDir>(serializedData);
+  size_t validLength;
+  return parseOverlayDir(number, header, serializedData, validLength);
 }
 } // namespace
 
@@ -733,7 +1143,9 @@ std::optional<fsck::InodeInfo> FileContentStore::loadInodeInfo(
       headerContents.data() + FileContentStore::kHeaderIdentifierDir.size(),
       sizeof(uint32_t));
   auto version = folly::Endian::big(versionBE);
-  if (version != FileContentStore::kHeaderVersion) {
+  if (version != FileContentStore::kHeaderVersion &&
+      !(version == FileContentStore::kDirHeaderVersionWithDeltas &&
+        typeID == FileContentStore::kHeaderIdentifierDir)) {
     return inodeError("unknown overlay file format version ", version);
   }
 
@@ -749,7 +1161,12 @@ std::optional<fsck::InodeInfo> FileContentStore::loadInodeInfo(
 
   if (type == fsck::InodeType::Dir) {
     try {
-      return {fsck::InodeInfo(number, loadDirectoryChildren(file))};
+      return {fsck::InodeInfo(
+          number,
+          loadDirectoryChildren(
+              number,
+              StringPiece{headerContents.data(), headerContents.size()},
+              file))};
     } catch (const std::exception& ex) {
       return inodeError(
           "error parsing directory contents: ", folly::exceptionStr(ex));
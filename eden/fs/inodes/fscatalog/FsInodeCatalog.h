@@ -12,6 +12,7 @@
 #include <gtest/gtest_prod.h>
 #include <array>
 #include <condition_variable>
+#include <memory>
 #include <optional>
 #include "eden/fs/inodes/IFileContentStore.h"
 #include "eden/fs/inodes/InodeCatalog.h"
@@ -31,6 +32,7 @@ namespace facebook::eden {
 namespace overlay {
 class OverlayDir;
 }
+class BlobFileCache;
 class InodePath;
 
 /**
@@ -38,7 +40,9 @@ class InodePath;
  */
 class FileContentStore : public IFileContentStore {
  public:
-  explicit FileContentStore(AbsolutePathPiece localDir) : localDir_{localDir} {}
+  explicit FileContentStore(AbsolutePathPiece localDir);
+
+  ~FileContentStore() override;
 
   /**
    * Initialize the FileContentStore, acquire the "info" file lock and load the
@@ -92,6 +96,28 @@ class FileContentStore : public IFileContentStore {
       InodeNumber inodeNumber,
       const folly::IOBuf& contents) override;
 
+  /**
+   * Clones the file from the blob file cache if it is enabled and holds the
+   * blob, and otherwise writes the file and adds it to the cache.
+   */
+  folly::File createOverlayFileFromBlob(
+      InodeNumber inodeNumber,
+      const ObjectId& blobId,
+      const folly::IOBuf& contents) override;
+
+  folly::File createSparseOverlayFile(InodeNumber inodeNumber, uint64_t size)
+      override;
+
+  void completeSparseOverlayFile(InodeNumber inodeNumber) override;
+
+  /**
+   * Keep up to maxSize bytes of the blobs of at least minBlobSize bytes
+   * materialized by createOverlayFileFromBlob() in the "blobs" directory, so
+   * that they can be cloned when they are materialized again. Must be called
+   * after initialize().
+   */
+  void initBlobFileCache(uint64_t maxSize, uint64_t minBlobSize);
+
   /**
    * Remove the overlay directory data associated with the passed InodeNumber.
    */
@@ -157,6 +183,8 @@ class FileContentStore : public IFileContentStore {
   std::optional<fsck::InodeInfo> loadInodeInfo(InodeNumber number);
 
   static constexpr folly::StringPiece kMetadataFile{"metadata.table"};
+  static constexpr folly::StringPiece kContentHashFile{"contenthash.table"};
+  static constexpr folly::StringPiece kBlobFileCacheDir{"blobs"};
 
   /**
    * Constants for an header in overlay file.
@@ -164,6 +192,20 @@ class FileContentStore : public IFileContentStore {
   static constexpr folly::StringPiece kHeaderIdentifierDir{"OVDR"};
   static constexpr folly::StringPiece kHeaderIdentifierFile{"OVFL"};
   static constexpr uint32_t kHeaderVersion = 1;
+  /**
+   * The version of directory files that have OverlayDirDelta records appended
+   * after the directory. Their header holds the size of the directory, so that
+   * the records can be found. Each record is prefixed with its length and
+   * checksum, so that a torn trailing record can be detected.
+   */
+  static constexpr uint32_t kDirHeaderVersionWithDeltas = 2;
+  /**
+   * The version of files created by createSparseOverlayFile() that were never
+   * completed. The contents of the blob they were materialized from, which
+   * only the EdenFS process that created them knew, are missing from them, so
+   * they are corrupt once that process exits.
+   */
+  static constexpr uint32_t kSparseFileHeaderVersion = 2;
   static constexpr size_t kHeaderLength = 64;
   static constexpr uint32_t kNumShards = 256;
   static constexpr size_t kShardDirPathLength = 2;
@@ -204,6 +246,29 @@ class FileContentStore : public IFileContentStore {
       folly::StringPiece identifier,
       uint32_t version);
 
+  /**
+   * Creates the header of a directory file whose serialized directory is
+   * dirLength bytes long and followed by OverlayDirDelta records.
+   */
+  static std::array<uint8_t, kHeaderLength> createDirHeaderWithDeltas(
+      uint64_t dirLength);
+
+  enum class AppendResult {
+    // There is no file for this directory.
+    NoDir,
+    Appended,
+    // The records outgrew the directory itself; it should be rewritten.
+    ShouldCompact,
+  };
+
+  /**
+   * Append a change to the file of a directory, without rewriting the
+   * directory.
+   */
+  AppendResult appendOverlayDirDelta(
+      InodeNumber inodeNumber,
+      const overlay::OverlayDirDelta& delta);
+
   /**
    * Validates an entry's header.
    */
@@ -243,6 +308,12 @@ class FileContentStore : public IFileContentStore {
    * We maintain this so we can use openat(), unlinkat(), etc.
    */
   folly::File dirFile_;
+
+  /**
+   * Set by initBlobFileCache().
+   */
+  std::unique_ptr<BlobFileCache> blobFileCache_;
+  uint64_t blobFileCacheMinBlobSize_{0};
 };
 
 /**
@@ -252,10 +323,17 @@ class FileContentStore : public IFileContentStore {
  */
 class FsInodeCatalog : public InodeCatalog {
  public:
-  explicit FsInodeCatalog(FileContentStore* core) : core_(core) {}
+  /**
+   * If appendDirChanges is set, adding, removing and renaming children append
+   * a record of the change to the directory's file instead of rewriting it, so
+   * that they cost O(1) I/O regardless of the size of the directory. Older
+   * versions of EdenFS can't read directories that have such records.
+   */
+  explicit FsInodeCatalog(FileContentStore* core, bool appendDirChanges = false)
+      : core_(core), appendDirChanges_(appendDirChanges) {}
 
   bool supportsSemanticOperations() const override {
-    return false;
+    return appendDirChanges_;
   }
 
   std::vector<InodeNumber> getAllParentInodeNumbers() override {
@@ -299,12 +377,32 @@ class FsInodeCatalog : public InodeCatalog {
 
   bool hasOverlayDir(InodeNumber inodeNumber) override;
 
+  void addChild(
+      InodeNumber parent,
+      PathComponentPiece name,
+      overlay::OverlayEntry entry) override;
+
+  void removeChild(InodeNumber parent, PathComponentPiece childName) override;
+
+  bool hasChild(InodeNumber parent, PathComponentPiece childName) override;
+
+  void renameChild(
+      InodeNumber src,
+      InodeNumber dst,
+      PathComponentPiece srcName,
+      PathComponentPiece dstName) override;
+
   void maintenance() override {}
 
   std::optional<fsck::InodeInfo> loadInodeInfo(InodeNumber number) override;
 
  private:
+  void appendOverlayDirDelta(
+      InodeNumber inodeNumber,
+      overlay::OverlayDirDelta&& delta);
+
   FileContentStore* core_;
+  const bool appendDirChanges_;
 };
 
 } // namespace facebook::eden
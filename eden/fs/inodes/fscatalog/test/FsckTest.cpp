@@ -15,6 +15,7 @@
 #include <folly/portability/GTest.h>
 
 #include "eden/fs/inodes/fscatalog/FsInodeCatalog.h"
+#include "eden/fs/inodes/mappedcatalog/MappedInodeCatalog.h"
 #include "eden/fs/inodes/memcatalog/MemInodeCatalog.h"
 #include "eden/fs/inodes/overlay/OverlayChecker.h"
 #include "eden/fs/inodes/sqlitecatalog/SqliteInodeCatalog.h"
@@ -207,7 +208,10 @@ TestOverlay::TestOverlay(InodeCatalogType type)
       // temporary directory
       fcs_(tmpDirPath_ + "overlay"_pc),
       type_(type) {
-  if (type != InodeCatalogType::Legacy) {
+  if (type == InodeCatalogType::Mapped) {
+    inodeCatalog_ =
+        std::make_unique<MappedInodeCatalog>(tmpDirPath_ + "overlay"_pc);
+  } else if (type != InodeCatalogType::Legacy) {
     inodeCatalog_ = std::make_unique<SqliteInodeCatalog>(
         tmpDirPath_ + "overlay"_pc, std::make_shared<NullStructuredLogger>());
   } else {
@@ -216,7 +220,10 @@ TestOverlay::TestOverlay(InodeCatalogType type)
 }
 
 void TestOverlay::recreateSqliteInodeCatalog() {
-  if (type_ != InodeCatalogType::Legacy) {
+  if (type_ == InodeCatalogType::Mapped) {
+    inodeCatalog_ =
+        std::make_unique<MappedInodeCatalog>(tmpDirPath_ + "overlay"_pc);
+  } else if (type_ != InodeCatalogType::Legacy) {
     inodeCatalog_ = std::make_unique<SqliteInodeCatalog>(
         tmpDirPath_ + "overlay"_pc, std::make_shared<NullStructuredLogger>());
   }
@@ -520,7 +527,8 @@ TEST_P(FsckTest, testTruncatedDirData) {
   // directly manipluates the written overlay data on disk to simulate file
   // corruption, which is not applicable for sqlite backed overlays
   if (overlayType() == InodeCatalogType::Sqlite ||
-      overlayType() == InodeCatalogType::InMemory) {
+      overlayType() == InodeCatalogType::InMemory ||
+      overlayType() == InodeCatalogType::Mapped) {
     return;
   }
   auto testOverlay = make_shared<TestOverlay>(overlayType());
@@ -610,7 +618,8 @@ TEST_P(FsckTest, testMissingDirData) {
   // directly manipluates the written overlay metadata data on disk to simulate
   // file corruption, which is not applicable for sqlite backed overlays
   if (overlayType() == InodeCatalogType::Sqlite ||
-      overlayType() == InodeCatalogType::InMemory) {
+      overlayType() == InodeCatalogType::InMemory ||
+      overlayType() == InodeCatalogType::Mapped) {
     return;
   }
   auto testOverlay = make_shared<TestOverlay>(overlayType());
@@ -743,4 +752,5 @@ INSTANTIATE_TEST_SUITE_P(
     ::testing::Values(
         InodeCatalogType::Legacy,
         InodeCatalogType::Sqlite,
-        InodeCatalogType::InMemory));
+        InodeCatalogType::InMemory,
+        InodeCatalogType::Mapped));
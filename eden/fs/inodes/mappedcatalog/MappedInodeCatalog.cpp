@@ -0,0 +1,504 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/inodes/mappedcatalog/MappedInodeCatalog.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <folly/Exception.h>
+#include <folly/FileUtil.h>
+#include <folly/Utility.h>
+#include <folly/hash/Checksum.h>
+#include <folly/logging/xlog.h>
+#include <folly/portability/SysMman.h>
+#include <folly/portability/SysStat.h>
+#include <folly/portability/Unistd.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
+
+#include "eden/fs/utils/Throw.h"
+
+namespace facebook::eden {
+
+using apache::thrift::CompactSerializer;
+using folly::StringPiece;
+
+namespace {
+
+/**
+ * Layout of the file:
+ *
+ *   FileHeader, padded to kRecordsOffset
+ *   RecordHeader, serialized OverlayDir
+ *   RecordHeader (removal)
+ *   ...
+ *
+ * The latest record of a directory wins. The checksum covers the rest of the
+ * record header and the payload, so a record torn by a crash is detected
+ * when the file is loaded.
+ */
+struct FileHeader {
+  uint32_t magic;
+  uint32_t version;
+  // 0 while the catalog is open, so that an unclean shutdown is detected.
+  uint64_t nextInodeNumber;
+};
+static_assert(sizeof(FileHeader) == 16);
+
+struct RecordHeader {
+  uint32_t checksum;
+  uint32_t payloadLength;
+  uint64_t inodeNumber;
+  uint32_t type;
+  uint32_t reserved;
+};
+static_assert(sizeof(RecordHeader) == 24);
+
+constexpr uint32_t kFileMagic = 0x44524445; // "EDRD"
+constexpr uint32_t kFileVersion = 1;
+
+// Records start on the second page, so that the header can be rewritten
+// without touching them.
+constexpr uint64_t kRecordsOffset = 4096;
+
+constexpr uint32_t kRecordTypeDir = 1;
+constexpr uint32_t kRecordTypeRemove = 2;
+
+/**
+ * Size of the address space reserved for the mapping. Nothing is allocated
+ * for the parts of it past the end of the file.
+ */
+constexpr uint64_t kMaxFileSize = 64ull * 1024 * 1024 * 1024;
+
+/**
+ * Superseded records are only compacted away once there are more of them
+ * than live ones, and at least this many bytes of them.
+ */
+constexpr uint64_t kMinCompactionGarbage = 16 * 1024 * 1024;
+
+constexpr StringPiece kTempFileSuffix{".tmp"};
+
+uint32_t recordChecksum(const RecordHeader& header, StringPiece payload) {
+  auto crc = folly::crc32c(
+      reinterpret_cast<const uint8_t*>(&header) + sizeof(header.checksum),
+      sizeof(RecordHeader) - sizeof(header.checksum));
+  return folly::crc32c(
+      reinterpret_cast<const uint8_t*>(payload.data()), payload.size(), crc);
+}
+
+void writeFileHeader(int fd, uint64_t nextInodeNumber) {
+  FileHeader header{kFileMagic, kFileVersion, nextInodeNumber};
+  folly::checkUnixError(
+      folly::pwriteFull(fd, &header, sizeof(header), 0),
+      "failed to write the overlay directories file header");
+  folly::checkUnixError(
+      folly::fdatasyncNoInt(fd),
+      "failed to sync the overlay directories file header");
+}
+
+const char* mapFile(const folly::File& file) {
+  auto* mapping =
+      mmap(nullptr, kMaxFileSize, PROT_READ, MAP_SHARED, file.fd(), 0);
+  if (mapping == MAP_FAILED) {
+    folly::throwSystemError("failed to map the overlay directories file");
+  }
+  return static_cast<const char*>(mapping);
+}
+
+void unmapFile(const char* mapping) {
+  if (mapping) {
+    munmap(const_cast<char*>(mapping), kMaxFileSize);
+  }
+}
+
+} // namespace
+
+MappedInodeCatalog::MappedInodeCatalog(AbsolutePathPiece localDir)
+    : path_{localDir + PathComponentPiece{kFileName}} {}
+
+MappedInodeCatalog::~MappedInodeCatalog() {
+  unmapFile(state_.wlock()->mapping);
+}
+
+std::optional<InodeNumber> MappedInodeCatalog::initOverlay(
+    bool createIfNonExisting,
+    bool bypassLockFile) {
+  auto state = state_.wlock();
+
+  bool created = false;
+  int fd = folly::openNoInt(path_.c_str(), O_RDWR | O_CLOEXEC);
+  if (fd >= 0) {
+    state->file = folly::File{fd, /*ownsFd=*/true};
+  } else if (errno != ENOENT) {
+    folly::throwSystemError(
+        "error opening overlay directories file ", path_.view());
+  } else {
+    if (!createIfNonExisting) {
+      folly::throwSystemError("overlay does not exist at ", path_.view());
+    }
+    ensureDirectoryExists(path_.dirname());
+    // Write the header to a temporary file first, so that a crash never
+    // leaves a file without one behind.
+    auto tmpPath = path_.value() + kTempFileSuffix.str();
+    folly::File tmpFile{tmpPath, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644};
+    writeFileHeader(tmpFile.fd(), kRootNodeId.get() + 1);
+    folly::checkUnixError(
+        folly::ftruncateNoInt(tmpFile.fd(), kRecordsOffset),
+        "failed to extend ",
+        tmpPath);
+    folly::checkUnixError(
+        ::rename(tmpPath.c_str(), path_.c_str()),
+        "failed to create overlay directories file ",
+        path_.view());
+    state->file = std::move(tmpFile);
+    created = true;
+  }
+
+  if (!state->file.try_lock() && !bypassLockFile) {
+    folly::throwSystemError("failed to acquire overlay lock on ", path_.view());
+  }
+
+  FileHeader header;
+  auto bytesRead =
+      folly::preadFull(state->file.fd(), &header, sizeof(header), 0);
+  folly::checkUnixError(bytesRead, "failed to read ", path_.view());
+  if (static_cast<size_t>(bytesRead) != sizeof(header) ||
+      header.magic != kFileMagic) {
+    throw_<std::runtime_error>(
+        "Invalid overlay directories file header in ", path_);
+  }
+  if (header.version != kFileVersion) {
+    throw_<std::runtime_error>(
+        "Unsupported overlay directories file format ",
+        header.version,
+        " in ",
+        path_);
+  }
+
+  state->mapping = mapFile(state->file);
+  loadIndex(*state, path_);
+
+  // Until close() records the next inode number, the file reads as not shut
+  // down cleanly.
+  writeFileHeader(state->file.fd(), 0);
+
+  if (shouldCompact(*state)) {
+    compact(*state);
+  }
+
+  XLOG(DBG2) << "Loaded " << state->index.size() << " directories from "
+             << path_ << " (" << state->endOffset << " bytes)";
+
+  if (created) {
+    return InodeNumber{kRootNodeId.get() + 1};
+  }
+  if (header.nextInodeNumber == 0) {
+    return std::nullopt;
+  }
+  return InodeNumber{header.nextInodeNumber};
+}
+
+void MappedInodeCatalog::loadIndex(State& state, AbsolutePathPiece path) {
+  struct stat st;
+  folly::checkUnixError(
+      fstat(state.file.fd(), &st), "failed to stat ", path.view());
+  auto fileSize = static_cast<uint64_t>(st.st_size);
+  if (fileSize < kRecordsOffset) {
+    throw_<std::runtime_error>("Truncated overlay directories file ", path);
+  }
+  if (fileSize > kMaxFileSize) {
+    throw_<std::runtime_error>(
+        "Overlay directories file ", path, " is too large: ", fileSize);
+  }
+
+  state.index.clear();
+  state.liveSize = 0;
+
+  auto offset = kRecordsOffset;
+  while (offset + sizeof(RecordHeader) <= fileSize) {
+    RecordHeader header;
+    memcpy(&header, state.mapping + offset, sizeof(header));
+    auto recordSize = sizeof(RecordHeader) + header.payloadLength;
+    if (recordSize > fileSize - offset) {
+      break;
+    }
+    StringPiece payload{
+        state.mapping + offset + sizeof(RecordHeader), header.payloadLength};
+    if (header.checksum != recordChecksum(header, payload)) {
+      break;
+    }
+
+    InodeNumber inodeNumber{header.inodeNumber};
+    if (auto it = state.index.find(inodeNumber); it != state.index.end()) {
+      state.liveSize -= it->second.size;
+      state.index.erase(it);
+    }
+    if (header.type == kRecordTypeDir) {
+      state.index.emplace(inodeNumber, Location{offset, recordSize});
+      state.liveSize += recordSize;
+    } else if (header.type != kRecordTypeRemove) {
+      break;
+    }
+    offset += recordSize;
+  }
+
+  if (offset != fileSize) {
+    // This is the record that was being written when EdenFS crashed. The
+    // directory it saved reads as its previous version, and fsck will run
+    // since the file wasn't closed cleanly.
+    XLOG(WARN) << "Discarding " << (fileSize - offset)
+               << " bytes of invalid records at the end of " << path;
+    folly::checkUnixError(
+        folly::ftruncateNoInt(state.file.fd(), offset),
+        "failed to truncate ",
+        path.view());
+  }
+  state.endOffset = offset;
+}
+
+void MappedInodeCatalog::close(std::optional<InodeNumber> nextInodeNumber) {
+  auto state = state_.wlock();
+  if (!state->file) {
+    return;
+  }
+  if (nextInodeNumber) {
+    writeFileHeader(state->file.fd(), nextInodeNumber->get());
+  }
+  unmapFile(state->mapping);
+  *state = State{};
+}
+
+bool MappedInodeCatalog::initialized() const {
+  return bool(state_.rlock()->file);
+}
+
+uint64_t MappedInodeCatalog::getFileSize() const {
+  return state_.rlock()->endOffset;
+}
+
+void MappedInodeCatalog::appendRecord(
+    State& state,
+    InodeNumber inodeNumber,
+    uint32_t type,
+    StringPiece payload) {
+  auto recordSize = sizeof(RecordHeader) + payload.size();
+  if (state.endOffset + recordSize > kMaxFileSize) {
+    throw_<std::runtime_error>(
+        "Overlay directories file ", path_, " is full");
+  }
+
+  RecordHeader header{};
+  header.payloadLength = folly::to_narrow(payload.size());
+  header.inodeNumber = inodeNumber.get();
+  header.type = type;
+  header.checksum = recordChecksum(header, payload);
+
+  std::array<struct iovec, 2> iov;
+  iov[0].iov_base = &header;
+  iov[0].iov_len = sizeof(header);
+  iov[1].iov_base = const_cast<char*>(payload.data());
+  iov[1].iov_len = payload.size();
+  auto written = folly::pwritevFull(
+      state.file.fd(), iov.data(), iov.size(), state.endOffset);
+  if (written < 0 || static_cast<size_t>(written) != recordSize) {
+    // Drop whatever part of the record made it to the file, so that the next
+    // record doesn't follow an invalid one.
+    auto savedErrno = errno;
+    (void)folly::ftruncateNoInt(state.file.fd(), state.endOffset);
+    errno = savedErrno;
+    folly::throwSystemError(
+        "failed to write directory ", inodeNumber, " to ", path_.view());
+  }
+
+  if (inodeNumber == kRootNodeId) {
+    // Like FsInodeCatalog, make sure the root directory survives a crash,
+    // since a checkout can't be mounted without it.
+    folly::checkUnixError(
+        folly::fdatasyncNoInt(state.file.fd()),
+        "failed to sync ",
+        path_.view());
+  }
+
+  if (auto it = state.index.find(inodeNumber); it != state.index.end()) {
+    state.liveSize -= it->second.size;
+    state.index.erase(it);
+  }
+  if (type == kRecordTypeDir) {
+    state.index.emplace(inodeNumber, Location{state.endOffset, recordSize});
+    state.liveSize += recordSize;
+  }
+  state.endOffset += recordSize;
+}
+
+bool MappedInodeCatalog::shouldCompact(const State& state) {
+  auto garbage = state.endOffset - kRecordsOffset - state.liveSize;
+  return garbage > state.liveSize && garbage >= kMinCompactionGarbage;
+}
+
+void MappedInodeCatalog::compact(State& state) {
+  auto oldSize = state.endOffset;
+
+  std::vector<std::pair<InodeNumber, Location>> records{
+      state.index.begin(), state.index.end()};
+  std::sort(records.begin(), records.end(), [](const auto& a, const auto& b) {
+    return a.second.offset < b.second.offset;
+  });
+
+  auto tmpPath = path_.value() + kTempFileSuffix.str();
+  folly::File tmpFile{tmpPath, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644};
+  FileHeader header{kFileMagic, kFileVersion, 0};
+  folly::checkUnixError(
+      folly::pwriteFull(tmpFile.fd(), &header, sizeof(header), 0),
+      "failed to write ",
+      tmpPath);
+
+  folly::F14FastMap<InodeNumber, Location> index;
+  index.reserve(records.size());
+  auto offset = kRecordsOffset;
+  for (const auto& [inodeNumber, location] : records) {
+    folly::checkUnixError(
+        folly::pwriteFull(
+            tmpFile.fd(),
+            state.mapping + location.offset,
+            location.size,
+            offset),
+        "failed to write ",
+        tmpPath);
+    index.emplace(inodeNumber, Location{offset, location.size});
+    offset += location.size;
+  }
+  folly::checkUnixError(
+      folly::ftruncateNoInt(tmpFile.fd(), offset),
+      "failed to resize ",
+      tmpPath);
+  folly::checkUnixError(
+      folly::fdatasyncNoInt(tmpFile.fd()), "failed to sync ", tmpPath);
+
+  // Take the lock before the new file becomes visible, so that there is no
+  // window where another process could acquire it.
+  if (!tmpFile.try_lock()) {
+    folly::throwSystemError("failed to acquire overlay lock on ", tmpPath);
+  }
+  auto* mapping = mapFile(tmpFile);
+  if (::rename(tmpPath.c_str(), path_.c_str()) != 0) {
+    auto savedErrno = errno;
+    unmapFile(mapping);
+    errno = savedErrno;
+    folly::throwSystemError("failed to replace ", path_.view());
+  }
+
+  unmapFile(state.mapping);
+  state.file = std::move(tmpFile);
+  state.mapping = mapping;
+  state.index = std::move(index);
+  state.endOffset = offset;
+
+  XLOG(DBG2) << "Compacted " << path_ << " from " << oldSize << " to "
+             << offset << " bytes";
+}
+
+void MappedInodeCatalog::maintenance() {
+  auto state = state_.wlock();
+  if (state->file && shouldCompact(*state)) {
+    compact(*state);
+  }
+}
+
+overlay::OverlayDir MappedInodeCatalog::parseDir(
+    const State& state,
+    InodeNumber inodeNumber,
+    Location location) {
+  StringPiece payload{
+      state.mapping + location.offset + sizeof(RecordHeader),
+      location.size - sizeof(RecordHeader)};
+  try {
+    return CompactSerializer::deserialize<overlay::OverlayDir>(payload);
+  } catch (const std::exception& ex) {
+    throw_<std::runtime_error>(
+        "Failed to parse overlay directory ", inodeNumber, ": ", ex.what());
+  }
+}
+
+std::vector<InodeNumber> MappedInodeCatalog::getAllParentInodeNumbers() {
+  auto state = state_.rlock();
+  std::vector<std::pair<uint64_t, InodeNumber>> dirs;
+  dirs.reserve(state->index.size());
+  for (const auto& [inodeNumber, location] : state->index) {
+    dirs.emplace_back(location.offset, inodeNumber);
+  }
+  state.unlock();
+
+  std::sort(dirs.begin(), dirs.end());
+  std::vector<InodeNumber> result;
+  result.reserve(dirs.size());
+  for (const auto& dir : dirs) {
+    result.push_back(dir.second);
+  }
+  return result;
+}
+
+std::optional<overlay::OverlayDir> MappedInodeCatalog::loadOverlayDir(
+    InodeNumber inodeNumber) {
+  auto state = state_.rlock();
+  auto it = state->index.find(inodeNumber);
+  if (it == state->index.end()) {
+    return std::nullopt;
+  }
+  return parseDir(*state, inodeNumber, it->second);
+}
+
+std::optional<overlay::OverlayDir> MappedInodeCatalog::loadAndRemoveOverlayDir(
+    InodeNumber inodeNumber) {
+  auto state = state_.wlock();
+  auto it = state->index.find(inodeNumber);
+  if (it == state->index.end()) {
+    return std::nullopt;
+  }
+  auto odir = parseDir(*state, inodeNumber, it->second);
+  appendRecord(*state, inodeNumber, kRecordTypeRemove, StringPiece{});
+  return odir;
+}
+
+void MappedInodeCatalog::saveOverlayDir(
+    InodeNumber inodeNumber,
+    overlay::OverlayDir&& odir) {
+  auto serializedData = CompactSerializer::serialize<std::string>(odir);
+  auto state = state_.wlock();
+  appendRecord(*state, inodeNumber, kRecordTypeDir, serializedData);
+}
+
+void MappedInodeCatalog::removeOverlayDir(InodeNumber inodeNumber) {
+  auto state = state_.wlock();
+  if (state->index.count(inodeNumber) == 0) {
+    return;
+  }
+  appendRecord(*state, inodeNumber, kRecordTypeRemove, StringPiece{});
+}
+
+bool MappedInodeCatalog::hasOverlayDir(InodeNumber inodeNumber) {
+  return state_.rlock()->index.count(inodeNumber) != 0;
+}
+
+std::optional<fsck::InodeInfo> MappedInodeCatalog::loadInodeInfo(
+    InodeNumber number) {
+  auto state = state_.rlock();
+  auto it = state->index.find(number);
+  if (it == state->index.end()) {
+    return std::nullopt;
+  }
+  try {
+    return {fsck::InodeInfo(number, parseDir(*state, number, it->second))};
+  } catch (const std::exception& ex) {
+    return {fsck::InodeInfo(number, fsck::InodeType::Error, ex.what())};
+  }
+}
+
+} // namespace facebook::eden
+
+#endif
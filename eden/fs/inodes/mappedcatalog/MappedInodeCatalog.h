@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#ifndef _WIN32
+
+#include <folly/File.h>
+#include <folly/Range.h>
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <optional>
+
+#include "eden/fs/inodes/InodeCatalog.h"
+#include "eden/fs/inodes/InodeNumber.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * An InodeCatalog that stores all of the directories of an overlay in a
+ * single file, rather than one file per directory like FsInodeCatalog.
+ *
+ * The file is a log: every save or removal of a directory appends a record
+ * to it, and an in-memory index maps each directory to its latest record.
+ * Records are checksummed, so after a crash the file is truncated after the
+ * last complete record, and every directory reads as one of the versions
+ * that was saved. The file is memory-mapped, so loading a directory copies
+ * nothing but the deserialized entries, and opening the overlay is a
+ * sequential scan of the mapping.
+ *
+ * Once most of the file is made of superseded records, maintenance()
+ * rewrites it with only the latest record of each directory.
+ *
+ * Files are still stored by the FileContentStore.
+ */
+class MappedInodeCatalog : public InodeCatalog {
+ public:
+  explicit MappedInodeCatalog(AbsolutePathPiece localDir);
+
+  ~MappedInodeCatalog() override;
+
+  bool supportsSemanticOperations() const override {
+    return false;
+  }
+
+  /**
+   * Returns the directories in the order of their records in the file, so
+   * that loading them reads the file sequentially.
+   */
+  std::vector<InodeNumber> getAllParentInodeNumbers() override;
+
+  std::optional<InodeNumber> initOverlay(
+      bool createIfNonExisting,
+      bool bypassLockFile = false) override;
+
+  void close(std::optional<InodeNumber> nextInodeNumber) override;
+
+  bool initialized() const override;
+
+  std::optional<overlay::OverlayDir> loadOverlayDir(
+      InodeNumber inodeNumber) override;
+
+  std::optional<overlay::OverlayDir> loadAndRemoveOverlayDir(
+      InodeNumber inodeNumber) override;
+
+  void saveOverlayDir(InodeNumber inodeNumber, overlay::OverlayDir&& odir)
+      override;
+
+  void removeOverlayDir(InodeNumber inodeNumber) override;
+
+  bool hasOverlayDir(InodeNumber inodeNumber) override;
+
+  std::optional<fsck::InodeInfo> loadInodeInfo(InodeNumber number) override;
+
+  /**
+   * Rewrite the file without its superseded records if they take up most of
+   * it.
+   */
+  void maintenance() override;
+
+  /**
+   * Size of the file, including superseded records.
+   */
+  uint64_t getFileSize() const;
+
+  static constexpr folly::StringPiece kFileName{"directories"};
+
+ private:
+  struct Location {
+    uint64_t offset;
+    // Size of the record, including its header.
+    uint64_t size;
+  };
+
+  struct State {
+    folly::File file;
+    // The file is mapped once with a size large enough for it to grow into,
+    // so that appending to it never requires remapping it.
+    const char* mapping = nullptr;
+    uint64_t endOffset = 0;
+    // Total size of the records in index.
+    uint64_t liveSize = 0;
+    folly::F14FastMap<InodeNumber, Location> index;
+  };
+
+  /**
+   * Scan the records of the file, fill the index, and truncate the file after
+   * the last valid record.
+   */
+  static void loadIndex(State& state, AbsolutePathPiece path);
+
+  void appendRecord(
+      State& state,
+      InodeNumber inodeNumber,
+      uint32_t type,
+      folly::StringPiece payload);
+
+  static bool shouldCompact(const State& state);
+
+  /**
+   * Rewrite the file with only the records in the index.
+   */
+  void compact(State& state);
+
+  static overlay::OverlayDir
+  parseDir(const State& state, InodeNumber inodeNumber, Location location);
+
+  const AbsolutePath path_;
+  folly::Synchronized<State> state_;
+};
+
+} // namespace facebook::eden
+
+#endif
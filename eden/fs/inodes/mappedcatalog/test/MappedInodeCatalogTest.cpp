@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/mappedcatalog/MappedInodeCatalog.h"
+
+#include <folly/Conv.h>
+#include <folly/FileUtil.h>
+#include <folly/portability/GTest.h>
+#include <sys/stat.h>
+
+#include "eden/fs/testharness/TempFile.h"
+
+using namespace facebook::eden;
+
+namespace {
+
+overlay::OverlayDir makeDir(size_t entryCount) {
+  overlay::OverlayDir odir;
+  for (size_t i = 0; i < entryCount; ++i) {
+    overlay::OverlayEntry entry;
+    entry.mode_ref() = S_IFREG | 0644;
+    entry.inodeNumber_ref() = 100 + i;
+    odir.entries_ref()->emplace(folly::to<std::string>("file", i), entry);
+  }
+  return odir;
+}
+
+struct MappedInodeCatalogTest : ::testing::Test {
+  void SetUp() override {
+    catalog = openCatalog();
+  }
+
+  std::unique_ptr<MappedInodeCatalog> openCatalog(
+      std::optional<InodeNumber>* nextInodeNumber = nullptr) {
+    auto catalog = std::make_unique<MappedInodeCatalog>(localDir);
+    auto result = catalog->initOverlay(/*createIfNonExisting=*/true);
+    if (nextInodeNumber) {
+      *nextInodeNumber = result;
+    }
+    return catalog;
+  }
+
+  AbsolutePath filePath() const {
+    return localDir + PathComponentPiece{MappedInodeCatalog::kFileName};
+  }
+
+  folly::test::TemporaryDirectory testDir = makeTempDir();
+  AbsolutePath localDir = canonicalPath(testDir.path().string());
+  std::unique_ptr<MappedInodeCatalog> catalog;
+};
+
+} // namespace
+
+TEST_F(MappedInodeCatalogTest, save_load_and_remove) {
+  InodeNumber ino{10};
+  EXPECT_FALSE(catalog->hasOverlayDir(ino));
+  EXPECT_FALSE(catalog->loadOverlayDir(ino).has_value());
+
+  catalog->saveOverlayDir(ino, makeDir(1));
+  catalog->saveOverlayDir(ino, makeDir(3));
+  EXPECT_TRUE(catalog->hasOverlayDir(ino));
+  EXPECT_EQ(3, catalog->loadOverlayDir(ino)->entries_ref()->size());
+
+  auto odir = catalog->loadAndRemoveOverlayDir(ino);
+  ASSERT_TRUE(odir.has_value());
+  EXPECT_EQ(3, odir->entries_ref()->size());
+  EXPECT_FALSE(catalog->hasOverlayDir(ino));
+  EXPECT_FALSE(catalog->loadAndRemoveOverlayDir(ino).has_value());
+}
+
+TEST_F(MappedInodeCatalogTest, reopen_after_clean_shutdown) {
+  catalog->saveOverlayDir(InodeNumber{10}, makeDir(2));
+  catalog->saveOverlayDir(InodeNumber{11}, makeDir(1));
+  catalog->removeOverlayDir(InodeNumber{11});
+  catalog->close(InodeNumber{20});
+
+  std::optional<InodeNumber> nextInodeNumber;
+  catalog = openCatalog(&nextInodeNumber);
+  EXPECT_EQ(InodeNumber{20}, nextInodeNumber);
+  EXPECT_EQ(2, catalog->loadOverlayDir(InodeNumber{10})->entries_ref()->size());
+  EXPECT_FALSE(catalog->hasOverlayDir(InodeNumber{11}));
+}
+
+TEST_F(MappedInodeCatalogTest, reopen_after_crash) {
+  catalog->saveOverlayDir(InodeNumber{10}, makeDir(2));
+  // Simulate a crash by not closing the catalog.
+  auto crashed = std::move(catalog);
+
+  auto reopened = std::make_unique<MappedInodeCatalog>(localDir);
+  auto nextInodeNumber = reopened->initOverlay(
+      /*createIfNonExisting=*/true, /*bypassLockFile=*/true);
+  EXPECT_FALSE(nextInodeNumber.has_value());
+  EXPECT_TRUE(reopened->hasOverlayDir(InodeNumber{10}));
+}
+
+TEST_F(MappedInodeCatalogTest, torn_record_is_discarded) {
+  catalog->saveOverlayDir(InodeNumber{10}, makeDir(2));
+  catalog->saveOverlayDir(InodeNumber{10}, makeDir(5));
+  auto fullSize = catalog->getFileSize();
+  catalog->close(InodeNumber{20});
+
+  // Cut the second record in half, as a crash during its write would.
+  ASSERT_EQ(0, ::truncate(filePath().c_str(), fullSize - 20));
+
+  catalog = openCatalog();
+  EXPECT_EQ(2, catalog->loadOverlayDir(InodeNumber{10})->entries_ref()->size());
+  EXPECT_LT(catalog->getFileSize(), fullSize - 20);
+
+  // Writes after the discarded record are read back after reopening.
+  catalog->saveOverlayDir(InodeNumber{11}, makeDir(1));
+  catalog->close(InodeNumber{20});
+  catalog = openCatalog();
+  EXPECT_TRUE(catalog->hasOverlayDir(InodeNumber{11}));
+  EXPECT_EQ(2, catalog->loadOverlayDir(InodeNumber{10})->entries_ref()->size());
+}
+
+TEST_F(MappedInodeCatalogTest, load_inode_info) {
+  catalog->saveOverlayDir(InodeNumber{10}, makeDir(2));
+  catalog->saveOverlayDir(InodeNumber{11}, makeDir(2));
+
+  auto info = catalog->loadInodeInfo(InodeNumber{10});
+  ASSERT_TRUE(info.has_value());
+  EXPECT_EQ(fsck::InodeType::Dir, info->type);
+  EXPECT_EQ(2, info->children.entries_ref()->size());
+  EXPECT_FALSE(catalog->loadInodeInfo(InodeNumber{12}).has_value());
+}
+
+TEST_F(MappedInodeCatalogTest, parent_inodes_are_in_file_order) {
+  catalog->saveOverlayDir(InodeNumber{12}, makeDir(1));
+  catalog->saveOverlayDir(InodeNumber{10}, makeDir(1));
+  catalog->saveOverlayDir(InodeNumber{11}, makeDir(1));
+  catalog->saveOverlayDir(InodeNumber{12}, makeDir(2));
+  catalog->removeOverlayDir(InodeNumber{11});
+
+  std::vector<InodeNumber> expected{InodeNumber{10}, InodeNumber{12}};
+  EXPECT_EQ(expected, catalog->getAllParentInodeNumbers());
+}
+
+TEST_F(MappedInodeCatalogTest, maintenance_compacts_superseded_records) {
+  auto odir = makeDir(1000);
+  for (size_t i = 0; i < 2000; ++i) {
+    catalog->saveOverlayDir(InodeNumber{10}, overlay::OverlayDir{odir});
+  }
+  catalog->saveOverlayDir(InodeNumber{11}, makeDir(1));
+  auto sizeBefore = catalog->getFileSize();
+
+  catalog->maintenance();
+  EXPECT_LT(catalog->getFileSize() * 100, sizeBefore);
+  EXPECT_EQ(
+      1000, catalog->loadOverlayDir(InodeNumber{10})->entries_ref()->size());
+  EXPECT_TRUE(catalog->hasOverlayDir(InodeNumber{11}));
+
+  catalog->saveOverlayDir(InodeNumber{12}, makeDir(1));
+  catalog->close(InodeNumber{20});
+
+  std::optional<InodeNumber> nextInodeNumber;
+  catalog = openCatalog(&nextInodeNumber);
+  EXPECT_EQ(InodeNumber{20}, nextInodeNumber);
+  EXPECT_EQ(
+      1000, catalog->loadOverlayDir(InodeNumber{10})->entries_ref()->size());
+  EXPECT_TRUE(catalog->hasOverlayDir(InodeNumber{11}));
+  EXPECT_TRUE(catalog->hasOverlayDir(InodeNumber{12}));
+}
@@ -7,20 +7,145 @@
 
 #include "eden/fs/inodes/memcatalog/MemInodeCatalog.h"
 #include <algorithm>
+#include <array>
+#include <cstring>
 #include <utility>
+
+#include <folly/Exception.h>
+#include <folly/FileUtil.h>
+#include <folly/String.h>
+#include <folly/Utility.h>
+#include <folly/hash/Checksum.h>
+#include <folly/logging/xlog.h>
+#include <folly/portability/Unistd.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
+
+#include "eden/fs/inodes/overlay/gen-cpp2/overlay_types.h"
 #include "eden/fs/inodes/sqlitecatalog/WindowsFsck.h"
+#include "eden/fs/utils/Throw.h"
 
 namespace facebook::eden {
 
+using apache::thrift::CompactSerializer;
+using folly::StringPiece;
+
 // Initial Inode ID is root ID + 1
 constexpr auto kInitialNodeId = kRootNodeId.getRawValue() + 1;
 
+namespace {
+
+/**
+ * Layout of the snapshot file:
+ *
+ *   SnapshotHeader
+ *   SnapshotDirHeader, serialized OverlayDir
+ *   ...
+ *
+ * The snapshot is replaced atomically, so rather than checksumming each
+ * directory, a single checksum covers everything after the header.
+ */
+struct SnapshotHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t generation;
+  // 0 unless the snapshot was written by close().
+  uint64_t nextInodeNumber;
+  uint64_t dirCount;
+  uint32_t checksum;
+  uint32_t reserved;
+};
+static_assert(sizeof(SnapshotHeader) == 40);
+
+struct SnapshotDirHeader {
+  uint64_t inodeNumber;
+  uint32_t payloadLength;
+  uint32_t reserved;
+};
+static_assert(sizeof(SnapshotDirHeader) == 16);
+
+/**
+ * Layout of a log file:
+ *
+ *   LogHeader
+ *   RecordHeader, payload
+ *   ...
+ *
+ * As in MappedInodeCatalog, the checksum of a record covers the rest of its
+ * header and its payload, so that a record torn by a crash is detected when
+ * the log is replayed.
+ */
+struct LogHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t generation;
+};
+static_assert(sizeof(LogHeader) == 16);
+
+struct RecordHeader {
+  uint32_t checksum;
+  uint32_t payloadLength;
+  uint64_t inodeNumber;
+  uint32_t type;
+  uint32_t reserved;
+};
+static_assert(sizeof(RecordHeader) == 24);
+
+constexpr uint32_t kSnapshotMagic = 0x534d4445; // "EDMS"
+constexpr uint32_t kLogMagic = 0x4c4d4445; // "EDML"
+constexpr uint32_t kFileVersion = 1;
+
+// The payload is a serialized OverlayDir that replaces the directory.
+constexpr uint32_t kRecordTypeDir = 1;
+// The directory is removed. There is no payload.
+constexpr uint32_t kRecordTypeRemove = 2;
+// The payload is a serialized OverlayDirDelta applied to the directory.
+constexpr uint32_t kRecordTypeDelta = 3;
+
+constexpr StringPiece kTempFileSuffix{".tmp"};
+
+uint32_t recordChecksum(const RecordHeader& header, StringPiece payload) {
+  auto crc = folly::crc32c(
+      reinterpret_cast<const uint8_t*>(&header) + sizeof(header.checksum),
+      sizeof(RecordHeader) - sizeof(header.checksum));
+  return folly::crc32c(
+      reinterpret_cast<const uint8_t*>(payload.data()), payload.size(), crc);
+}
+
+void applyDelta(
+    folly::F14FastMap<InodeNumber, overlay::OverlayDir>& store,
+    InodeNumber inodeNumber,
+    overlay::OverlayDirDelta&& delta) {
+  auto itr = store.find(inodeNumber);
+  if (itr == store.end()) {
+    // Like addChild(), adding to a directory that doesn't exist creates it,
+    // and like removeChild(), removing from it does nothing.
+    if (delta.added()->empty()) {
+      return;
+    }
+    itr = store.emplace(inodeNumber, overlay::OverlayDir{}).first;
+  }
+  auto& entries = *itr->second.entries();
+  for (const auto& name : *delta.removed()) {
+    entries.erase(name);
+  }
+  for (auto& [name, entry] : *delta.added()) {
+    entries.insert_or_assign(name, std::move(entry));
+  }
+}
+
+} // namespace
+
+MemInodeCatalog::MemInodeCatalog(
+    AbsolutePathPiece localDir,
+    uint64_t snapshotMinLogSize)
+    : localDir_{localDir}, snapshotMinLogSize_{snapshotMinLogSize} {}
+
 /**
- * `Overlay` only uses this method to control cleanup, which in this case is
- * unneeded, so return false to bypass.
+ * `Overlay` only uses this method to control cleanup, which is only needed
+ * when the catalog is persisted.
  */
 bool MemInodeCatalog::initialized() const {
-  return false;
+  return isPersistent() && bool(log_.lock()->file);
 }
 
 std::vector<InodeNumber> MemInodeCatalog::getAllParentInodeNumbers() {
@@ -35,16 +160,371 @@ std::vector<InodeNumber> MemInodeCatalog::getAllParentInodeNumbers() {
 }
 
 std::optional<InodeNumber> MemInodeCatalog::initOverlay(
-    bool /* createIfNonExisting */,
+    bool createIfNonExisting,
     bool /* bypassLockFile */) {
-  nextInode_ = kInitialNodeId;
-  return InodeNumber(nextInode_.load());
+  if (!isPersistent()) {
+    nextInode_ = kInitialNodeId;
+    return InodeNumber(nextInode_.load());
+  }
+
+  std::lock_guard snapshotLock{snapshotMutex_};
+  auto store = store_.wlock();
+  auto log = log_.lock();
+  auto result = load(*store, *log, createIfNonExisting);
+  nextInode_ = result ? result->get() : kInitialNodeId;
+
+  XLOG(DBG2) << "Loaded " << store->size() << " directories from "
+             << *localDir_;
+  return result;
 }
 
-/**
- * Because `initialized` always returns false there is nothing to do on close.
- */
-void MemInodeCatalog::close(std::optional<InodeNumber> /*nextInodeNumber*/) {}
+AbsolutePath MemInodeCatalog::getLogPath(uint64_t generation) const {
+  return *localDir_ +
+      PathComponent{folly::to<std::string>(kLogFilePrefix, generation)};
+}
+
+std::optional<InodeNumber>
+MemInodeCatalog::load(Store& store, Log& log, bool createIfNonExisting) {
+  auto snapshotPath = *localDir_ + PathComponentPiece{kSnapshotFileName};
+  uint64_t generation = 1;
+  uint64_t nextInodeNumber = 0;
+  bool hasSnapshot = false;
+
+  std::string contents;
+  if (folly::readFile(snapshotPath.c_str(), contents)) {
+    hasSnapshot = true;
+    SnapshotHeader header;
+    if (contents.size() < sizeof(header)) {
+      throw_<std::runtime_error>(
+          "Truncated overlay directory snapshot ", snapshotPath);
+    }
+    memcpy(&header, contents.data(), sizeof(header));
+    if (header.magic != kSnapshotMagic) {
+      throw_<std::runtime_error>(
+          "Invalid overlay directory snapshot header in ", snapshotPath);
+    }
+    if (header.version != kFileVersion) {
+      throw_<std::runtime_error>(
+          "Unsupported overlay directory snapshot format ",
+          header.version,
+          " in ",
+          snapshotPath);
+    }
+    StringPiece body{contents};
+    body.advance(sizeof(header));
+    if (header.checksum !=
+        folly::crc32c(
+            reinterpret_cast<const uint8_t*>(body.data()), body.size())) {
+      throw_<std::runtime_error>(
+          "Corrupt overlay directory snapshot ", snapshotPath);
+    }
+
+    store.reserve(header.dirCount);
+    for (uint64_t i = 0; i < header.dirCount; ++i) {
+      SnapshotDirHeader dirHeader;
+      if (body.size() < sizeof(dirHeader)) {
+        throw_<std::runtime_error>(
+            "Truncated overlay directory snapshot ", snapshotPath);
+      }
+      memcpy(&dirHeader, body.data(), sizeof(dirHeader));
+      body.advance(sizeof(dirHeader));
+      if (body.size() < dirHeader.payloadLength) {
+        throw_<std::runtime_error>(
+            "Truncated overlay directory snapshot ", snapshotPath);
+      }
+      store.insert_or_assign(
+          InodeNumber{dirHeader.inodeNumber},
+          CompactSerializer::deserialize<overlay::OverlayDir>(
+              body.subpiece(0, dirHeader.payloadLength)));
+      body.advance(dirHeader.payloadLength);
+    }
+    generation = header.generation;
+    nextInodeNumber = header.nextInodeNumber;
+    snapshotSize_ = contents.size();
+  } else if (errno != ENOENT) {
+    folly::throwSystemError(
+        "error reading overlay directory snapshot ", snapshotPath.view());
+  }
+  snapshotGeneration_ = generation;
+
+  bool hasLog = false;
+  for (auto logGeneration = generation;; ++logGeneration) {
+    auto logPath = getLogPath(logGeneration);
+    int fd = folly::openNoInt(logPath.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+      if (errno == ENOENT) {
+        break;
+      }
+      folly::throwSystemError(
+          "error opening overlay directory log ", logPath.view());
+    }
+    log.file = folly::File{fd, /*ownsFd=*/true};
+    log.generation = logGeneration;
+    replayLog(store, log, logPath);
+    hasLog = true;
+  }
+
+  // A crash after the snapshot was written may have left the logs it
+  // supersedes behind.
+  for (auto logGeneration = generation - 1; logGeneration > 0;
+       --logGeneration) {
+    if (unlink(getLogPath(logGeneration).c_str()) != 0) {
+      break;
+    }
+  }
+
+  if (!hasSnapshot && !hasLog) {
+    if (!createIfNonExisting) {
+      throw_<std::runtime_error>("overlay does not exist at ", *localDir_);
+    }
+    ensureDirectoryExists(*localDir_);
+    startLog(log, generation);
+    return InodeNumber{kInitialNodeId};
+  }
+  if (!hasLog) {
+    startLog(log, generation);
+  }
+
+  // Only close() leaves no log behind, so a log means that the catalog was
+  // not closed cleanly.
+  if (hasLog || nextInodeNumber == 0) {
+    return std::nullopt;
+  }
+  return InodeNumber{nextInodeNumber};
+}
+
+void MemInodeCatalog::replayLog(
+    Store& store,
+    Log& log,
+    AbsolutePathPiece path) {
+  std::string contents;
+  if (!folly::readFile(log.file.fd(), contents)) {
+    folly::throwSystemError("error reading ", path.view());
+  }
+  LogHeader logHeader;
+  if (contents.size() < sizeof(logHeader)) {
+    throw_<std::runtime_error>("Truncated overlay directory log ", path);
+  }
+  memcpy(&logHeader, contents.data(), sizeof(logHeader));
+  if (logHeader.magic != kLogMagic || logHeader.version != kFileVersion ||
+      logHeader.generation != log.generation) {
+    throw_<std::runtime_error>(
+        "Invalid overlay directory log header in ", path);
+  }
+
+  uint64_t offset = sizeof(LogHeader);
+  size_t recordCount = 0;
+  while (offset + sizeof(RecordHeader) <= contents.size()) {
+    RecordHeader header;
+    memcpy(&header, contents.data() + offset, sizeof(header));
+    auto recordSize = sizeof(RecordHeader) + header.payloadLength;
+    if (recordSize > contents.size() - offset) {
+      break;
+    }
+    StringPiece payload{
+        contents.data() + offset + sizeof(RecordHeader), header.payloadLength};
+    if (header.checksum != recordChecksum(header, payload)) {
+      break;
+    }
+
+    InodeNumber inodeNumber{header.inodeNumber};
+    if (header.type == kRecordTypeDir) {
+      store.insert_or_assign(
+          inodeNumber,
+          CompactSerializer::deserialize<overlay::OverlayDir>(payload));
+    } else if (header.type == kRecordTypeRemove) {
+      store.erase(inodeNumber);
+    } else if (header.type == kRecordTypeDelta) {
+      applyDelta(
+          store,
+          inodeNumber,
+          CompactSerializer::deserialize<overlay::OverlayDirDelta>(payload));
+    } else {
+      break;
+    }
+    offset += recordSize;
+    ++recordCount;
+  }
+
+  if (offset != contents.size()) {
+    // This is the record that was being written when EdenFS crashed.
+    XLOG(WARN) << "Discarding " << (contents.size() - offset)
+               << " bytes of invalid records at the end of " << path;
+    folly::checkUnixError(
+        folly::ftruncateNoInt(log.file.fd(), offset),
+        "failed to truncate ",
+        path.view());
+  }
+  log.endOffset = offset;
+
+  XLOG(DBG2) << "Replayed " << recordCount << " records from " << path;
+}
+
+void MemInodeCatalog::startLog(Log& log, uint64_t generation) {
+  auto path = getLogPath(generation);
+  // Write the header to a temporary file first, so that a crash never leaves
+  // a log without one behind.
+  auto tmpPath = path.value() + kTempFileSuffix.str();
+  folly::File tmpFile{tmpPath, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644};
+  LogHeader header{kLogMagic, kFileVersion, generation};
+  folly::checkUnixError(
+      folly::pwriteFull(tmpFile.fd(), &header, sizeof(header), 0),
+      "failed to write ",
+      tmpPath);
+  folly::checkUnixError(
+      folly::fdatasyncNoInt(tmpFile.fd()), "failed to sync ", tmpPath);
+  folly::checkUnixError(
+      ::rename(tmpPath.c_str(), path.c_str()),
+      "failed to create overlay directory log ",
+      path.view());
+
+  log.file = std::move(tmpFile);
+  log.generation = generation;
+  log.endOffset = sizeof(LogHeader);
+}
+
+void MemInodeCatalog::appendToLog(
+    InodeNumber inodeNumber,
+    uint32_t type,
+    StringPiece payload) {
+  auto log = log_.lock();
+
+  auto recordSize = sizeof(RecordHeader) + payload.size();
+  RecordHeader header{};
+  header.payloadLength = folly::to_narrow(payload.size());
+  header.inodeNumber = inodeNumber.get();
+  header.type = type;
+  header.checksum = recordChecksum(header, payload);
+
+  std::array<struct iovec, 2> iov;
+  iov[0].iov_base = &header;
+  iov[0].iov_len = sizeof(header);
+  iov[1].iov_base = const_cast<char*>(payload.data());
+  iov[1].iov_len = payload.size();
+  auto written = folly::pwritevFull(
+      log->file.fd(), iov.data(), iov.size(), log->endOffset);
+  if (written < 0 || static_cast<size_t>(written) != recordSize) {
+    // Drop whatever part of the record made it to the log, so that the next
+    // record doesn't follow an invalid one.
+    auto savedErrno = errno;
+    (void)folly::ftruncateNoInt(log->file.fd(), log->endOffset);
+    errno = savedErrno;
+    folly::throwSystemError(
+        "failed to log a change to directory ",
+        inodeNumber,
+        " in ",
+        getLogPath(log->generation).view());
+  }
+  log->endOffset += recordSize;
+}
+
+void MemInodeCatalog::appendDeltaToLog(
+    InodeNumber inodeNumber,
+    const overlay::OverlayDirDelta& delta) {
+  appendToLog(
+      inodeNumber,
+      kRecordTypeDelta,
+      CompactSerializer::serialize<std::string>(delta));
+}
+
+void MemInodeCatalog::writeSnapshot(
+    const Store& store,
+    uint64_t generation,
+    std::optional<InodeNumber> nextInodeNumber) {
+  auto snapshotPath = *localDir_ + PathComponentPiece{kSnapshotFileName};
+
+  std::string data(sizeof(SnapshotHeader), '\0');
+  for (const auto& [inodeNumber, odir] : store) {
+    auto payload = CompactSerializer::serialize<std::string>(odir);
+    SnapshotDirHeader dirHeader{};
+    dirHeader.inodeNumber = inodeNumber.get();
+    dirHeader.payloadLength = folly::to_narrow(payload.size());
+    data.append(reinterpret_cast<const char*>(&dirHeader), sizeof(dirHeader));
+    data.append(payload);
+  }
+
+  SnapshotHeader header{};
+  header.magic = kSnapshotMagic;
+  header.version = kFileVersion;
+  header.generation = generation;
+  header.nextInodeNumber = nextInodeNumber ? nextInodeNumber->get() : 0;
+  header.dirCount = store.size();
+  header.checksum = folly::crc32c(
+      reinterpret_cast<const uint8_t*>(data.data()) + sizeof(header),
+      data.size() - sizeof(header));
+  memcpy(data.data(), &header, sizeof(header));
+
+  folly::writeFileAtomic(
+      snapshotPath.view(), data, 0644, folly::SyncType::WITH_SYNC);
+
+  for (auto logGeneration = snapshotGeneration_; logGeneration < generation;
+       ++logGeneration) {
+    auto logPath = getLogPath(logGeneration);
+    if (unlink(logPath.c_str()) != 0 && errno != ENOENT) {
+      XLOG(WARN) << "Failed to remove superseded overlay directory log "
+                 << logPath << ": " << folly::errnoStr(errno);
+    }
+  }
+  snapshotGeneration_ = generation;
+  snapshotSize_ = data.size();
+
+  XLOG(DBG2) << "Wrote a snapshot of " << store.size() << " directories ("
+             << data.size() << " bytes) to " << snapshotPath;
+}
+
+void MemInodeCatalog::close(std::optional<InodeNumber> nextInodeNumber) {
+  if (!isPersistent()) {
+    return;
+  }
+  std::lock_guard snapshotLock{snapshotMutex_};
+  auto store = store_.wlock();
+  auto log = log_.lock();
+  if (!log->file) {
+    return;
+  }
+  auto generation = log->generation + 1;
+  *log = Log{};
+  writeSnapshot(*store, generation, nextInodeNumber);
+}
+
+void MemInodeCatalog::maintenance() {
+  if (!isPersistent()) {
+    return;
+  }
+  std::lock_guard snapshotLock{snapshotMutex_};
+
+  Store snapshot;
+  uint64_t generation;
+  {
+    // Only the copy is made with the catalog locked; it is serialized and
+    // written once changes to it can proceed again.
+    auto store = store_.rlock();
+    auto log = log_.lock();
+    if (!log->file) {
+      return;
+    }
+    auto logSize = log->endOffset - sizeof(LogHeader);
+    if (logSize < snapshotMinLogSize_ || logSize < snapshotSize_) {
+      // Holding snapshotMutex_ keeps the log open, and syncing it without
+      // the locks above doesn't block changes.
+      int fd = log->file.fd();
+      log.unlock();
+      store.unlock();
+      folly::checkUnixError(
+          folly::fdatasyncNoInt(fd), "failed to sync overlay directory log");
+      return;
+    }
+    snapshot = *store;
+    generation = log->generation + 1;
+    startLog(*log, generation);
+  }
+  writeSnapshot(snapshot, generation, std::nullopt);
+}
+
+uint64_t MemInodeCatalog::getLogSize() const {
+  auto log = log_.lock();
+  return log->file ? log->endOffset : 0;
+}
 
 std::optional<overlay::OverlayDir> MemInodeCatalog::loadOverlayDir(
     InodeNumber inodeNumber) {
@@ -60,6 +540,9 @@ std::optional<overlay::OverlayDir> MemInodeCatalog::loadAndRemoveOverlayDir(
   auto store = store_.wlock();
   auto itr = store->find(inodeNumber);
   if (itr != store->end()) {
+    if (isPersistent()) {
+      appendToLog(inodeNumber, kRecordTypeRemove);
+    }
     auto overlayDir = std::move(itr->second);
     store->erase(itr);
     return overlayDir;
@@ -72,6 +555,12 @@ void MemInodeCatalog::saveOverlayDir(
     InodeNumber inodeNumber,
     overlay::OverlayDir&& odir) {
   auto store = store_.wlock();
+  if (isPersistent()) {
+    appendToLog(
+        inodeNumber,
+        kRecordTypeDir,
+        CompactSerializer::serialize<std::string>(odir));
+  }
   store->insert_or_assign(inodeNumber, std::move(odir));
 }
 
@@ -82,6 +571,9 @@ void MemInodeCatalog::removeOverlayDir(InodeNumber inodeNumber) {
     throw NonEmptyError("cannot delete non-empty directory");
   }
 
+  if (isPersistent()) {
+    appendToLog(inodeNumber, kRecordTypeRemove);
+  }
   store->erase(itr);
 }
 
@@ -97,6 +589,13 @@ void MemInodeCatalog::addChild(
     overlay::OverlayEntry entry) {
   auto store = store_.wlock();
   auto itr = store->find(parent);
+  if (isPersistent() &&
+      (itr == store->end() ||
+       itr->second.entries()->count(name.asString()) == 0)) {
+    overlay::OverlayDirDelta delta;
+    delta.added()->emplace(name.asString(), entry);
+    appendDeltaToLog(parent, delta);
+  }
   if (itr != store->end()) {
     itr->second.entries()->emplace(name.asString(), std::move(entry));
   } else {
@@ -113,6 +612,11 @@ void MemInodeCatalog::removeChild(
   auto itr = store->find(parent);
   if (itr != store->end()) {
     auto entries = itr->second.entries_ref();
+    if (isPersistent() && entries->count(childName.asString()) != 0) {
+      overlay::OverlayDirDelta delta;
+      delta.removed()->push_back(childName.asString());
+      appendDeltaToLog(parent, delta);
+    }
     entries->erase(childName.asString());
   }
 }
@@ -160,6 +664,16 @@ void MemInodeCatalog::renameChild(
     auto srcEntries = srcOdir->second.entries_ref();
     auto srcChild = srcEntries->find(srcName.asString());
     if (srcChild != srcEntries->end()) {
+      if (isPersistent()) {
+        // Logged in the order the changes are applied below, which matters
+        // when src and dst are the same directory.
+        overlay::OverlayDirDelta addDelta;
+        addDelta.added()->emplace(dstName.asString(), srcChild->second);
+        appendDeltaToLog(dst, addDelta);
+        overlay::OverlayDirDelta removeDelta;
+        removeDelta.removed()->push_back(srcName.asString());
+        appendDeltaToLog(src, removeDelta);
+      }
       if (dstOdir == store->end()) {
         // Create dst and include src child in entries
         overlay::OverlayDir odir;
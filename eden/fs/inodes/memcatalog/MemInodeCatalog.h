@@ -9,14 +9,20 @@
 
 #include "eden/fs/inodes/InodeCatalog.h"
 #include "eden/fs/inodes/InodeNumber.h"
+#include "eden/fs/utils/PathFuncs.h"
 
+#include <folly/File.h>
+#include <folly/Synchronized.h>
 #include <folly/container/F14Map.h>
+#include <mutex>
+#include <optional>
 
 namespace facebook::eden {
 
 namespace overlay {
 class OverlayDir;
-}
+class OverlayDirDelta;
+} // namespace overlay
 
 class NonEmptyError : public std::exception {
  public:
@@ -37,11 +43,30 @@ class NonEmptyError : public std::exception {
  * MemInodeCatalog provides interfaces to manipulate the overlay. It stores the
  * overlay's file system attributes and is responsible for obtaining and
  * releasing its locks ("initOverlay" and "close" respectively).
+ *
+ * By default nothing is persisted. When constructed with a directory, the
+ * directories held in memory remain the source of truth, but every change to
+ * them is also appended to a log file, and maintenance() periodically writes
+ * a snapshot of all of them and starts a new log. Opening the catalog reads
+ * the snapshot and replays the logs written since, each with a single
+ * sequential read. close() writes a final snapshot, so that after a clean
+ * shutdown only the snapshot is read.
+ *
+ * The log is not synced on every change; a change survives a crash of EdenFS
+ * immediately, and a crash of the machine once the next maintenance() has
+ * synced the log.
  */
 class MemInodeCatalog : public InodeCatalog {
  public:
   explicit MemInodeCatalog() {}
 
+  /**
+   * Persist the catalog to localDir. maintenance() snapshots the catalog once
+   * the log grows past both snapshotMinLogSize and the size of the previous
+   * snapshot.
+   */
+  MemInodeCatalog(AbsolutePathPiece localDir, uint64_t snapshotMinLogSize);
+
   bool supportsSemanticOperations() const override {
     return true;
   }
@@ -109,13 +134,92 @@ class MemInodeCatalog : public InodeCatalog {
       AbsolutePathPiece mountPath,
       InodeCatalog::LookupCallback& callback) override;
 
-  void maintenance() override {}
+  /**
+   * When persistent, snapshot the catalog if the log has grown large enough,
+   * and sync the log otherwise.
+   */
+  void maintenance() override;
 
   std::optional<fsck::InodeInfo> loadInodeInfo(InodeNumber number) override;
 
+  /**
+   * Size of the current log, including its header. Always 0 when not
+   * persistent.
+   */
+  uint64_t getLogSize() const;
+
+  static constexpr folly::StringPiece kSnapshotFileName{"dirs-snapshot"};
+  static constexpr folly::StringPiece kLogFilePrefix{"dirs-log."};
+
  private:
-  folly::Synchronized<folly::F14FastMap<InodeNumber, overlay::OverlayDir>>
-      store_;
+  using Store = folly::F14FastMap<InodeNumber, overlay::OverlayDir>;
+
+  struct Log {
+    folly::File file;
+    // Snapshot generation N holds the state of the catalog before any record
+    // of log generation N was written. Later logs continue where the
+    // previous one stops.
+    uint64_t generation = 0;
+    uint64_t endOffset = 0;
+  };
+
+  bool isPersistent() const {
+    return localDir_.has_value();
+  }
+
+  AbsolutePath getLogPath(uint64_t generation) const;
+
+  /**
+   * Read the snapshot from disk and replay the logs following it into
+   * store. Returns the next inode number if the catalog was closed cleanly.
+   */
+  std::optional<InodeNumber>
+  load(Store& store, Log& log, bool createIfNonExisting);
+
+  /**
+   * Replay the records of a log, and truncate it after the last valid one.
+   */
+  void replayLog(Store& store, Log& log, AbsolutePathPiece path);
+
+  /**
+   * Create a new, empty log and make it the current one.
+   */
+  void startLog(Log& log, uint64_t generation);
+
+  /**
+   * Record a change in the current log. Must be called with store_ locked
+   * for writing, and before the change is applied to it, so that the log
+   * stays in the order the changes were made in.
+   */
+  void appendToLog(
+      InodeNumber inodeNumber,
+      uint32_t type,
+      folly::StringPiece payload = {});
+  void appendDeltaToLog(
+      InodeNumber inodeNumber,
+      const overlay::OverlayDirDelta& delta);
+
+  /**
+   * Write a snapshot of store as the given generation and remove the logs it
+   * supersedes.
+   */
+  void writeSnapshot(
+      const Store& store,
+      uint64_t generation,
+      std::optional<InodeNumber> nextInodeNumber);
+
+  const std::optional<AbsolutePath> localDir_;
+  const uint64_t snapshotMinLogSize_ = 0;
+
+  // Lock ordering: store_ is always locked before log_.
+  folly::Synchronized<Store> store_;
+  folly::Synchronized<Log, std::mutex> log_;
+
+  // Serializes the writing of snapshots, and protects the members below.
+  std::mutex snapshotMutex_;
+  uint64_t snapshotGeneration_ = 0;
+  uint64_t snapshotSize_ = 0;
+
   std::atomic_uint64_t nextInode_{1};
 };
 
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/memcatalog/MemInodeCatalog.h"
+
+#include <folly/Conv.h>
+#include <folly/portability/GTest.h>
+#include <folly/portability/Unistd.h>
+#include <sys/stat.h>
+
+#include "eden/fs/inodes/overlay/gen-cpp2/overlay_types.h"
+#include "eden/fs/testharness/TempFile.h"
+
+using namespace facebook::eden;
+using namespace facebook::eden::path_literals;
+
+namespace {
+
+overlay::OverlayEntry makeEntry(uint64_t inodeNumber) {
+  overlay::OverlayEntry entry;
+  entry.mode_ref() = S_IFREG | 0644;
+  entry.inodeNumber_ref() = inodeNumber;
+  return entry;
+}
+
+overlay::OverlayDir makeDir(size_t entryCount) {
+  overlay::OverlayDir odir;
+  for (size_t i = 0; i < entryCount; ++i) {
+    odir.entries_ref()->emplace(
+        folly::to<std::string>("file", i), makeEntry(100 + i));
+  }
+  return odir;
+}
+
+struct PersistentMemInodeCatalogTest : ::testing::Test {
+  void SetUp() override {
+    catalog = openCatalog();
+  }
+
+  std::unique_ptr<MemInodeCatalog> openCatalog(
+      std::optional<InodeNumber>* nextInodeNumber = nullptr) {
+    auto catalog = std::make_unique<MemInodeCatalog>(
+        localDir, /*snapshotMinLogSize=*/1024);
+    auto result = catalog->initOverlay(/*createIfNonExisting=*/true);
+    if (nextInodeNumber) {
+      *nextInodeNumber = result;
+    }
+    return catalog;
+  }
+
+  AbsolutePath logPath(uint64_t generation) const {
+    auto name =
+        folly::to<std::string>(MemInodeCatalog::kLogFilePrefix, generation);
+    return localDir + PathComponent{name};
+  }
+
+  folly::test::TemporaryDirectory testDir = makeTempDir();
+  AbsolutePath localDir = canonicalPath(testDir.path().string());
+  std::unique_ptr<MemInodeCatalog> catalog;
+};
+
+} // namespace
+
+TEST_F(PersistentMemInodeCatalogTest, reopen_after_clean_shutdown) {
+  catalog->saveOverlayDir(InodeNumber{10}, makeDir(2));
+  catalog->addChild(InodeNumber{10}, "added"_pc, makeEntry(11));
+  catalog->removeChild(InodeNumber{10}, "file0"_pc);
+  catalog->saveOverlayDir(InodeNumber{12}, overlay::OverlayDir{});
+  catalog->removeOverlayDir(InodeNumber{12});
+  catalog->close(InodeNumber{20});
+
+  // A clean shutdown leaves only the snapshot behind.
+  EXPECT_NE(0, access(logPath(1).c_str(), F_OK));
+
+  std::optional<InodeNumber> nextInodeNumber;
+  catalog = openCatalog(&nextInodeNumber);
+  EXPECT_EQ(InodeNumber{20}, nextInodeNumber);
+  EXPECT_TRUE(catalog->hasChild(InodeNumber{10}, "added"_pc));
+  EXPECT_TRUE(catalog->hasChild(InodeNumber{10}, "file1"_pc));
+  EXPECT_FALSE(catalog->hasChild(InodeNumber{10}, "file0"_pc));
+  EXPECT_FALSE(catalog->hasOverlayDir(InodeNumber{12}));
+}
+
+TEST_F(PersistentMemInodeCatalogTest, reopen_after_crash_replays_log) {
+  catalog->saveOverlayDir(InodeNumber{10}, makeDir(2));
+  catalog->addChild(InodeNumber{11}, "dir"_pc, makeEntry(12));
+  catalog->renameChild(InodeNumber{10}, InodeNumber{11}, "file0"_pc, "b"_pc);
+  // Simulate a crash by not closing the catalog.
+  auto crashed = std::move(catalog);
+
+  std::optional<InodeNumber> nextInodeNumber{InodeNumber{1}};
+  catalog = openCatalog(&nextInodeNumber);
+  EXPECT_FALSE(nextInodeNumber.has_value());
+  EXPECT_FALSE(catalog->hasChild(InodeNumber{10}, "file0"_pc));
+  EXPECT_TRUE(catalog->hasChild(InodeNumber{10}, "file1"_pc));
+  EXPECT_TRUE(catalog->hasChild(InodeNumber{11}, "dir"_pc));
+  EXPECT_TRUE(catalog->hasChild(InodeNumber{11}, "b"_pc));
+}
+
+TEST_F(PersistentMemInodeCatalogTest, torn_record_is_discarded) {
+  catalog->saveOverlayDir(InodeNumber{10}, makeDir(2));
+  catalog->saveOverlayDir(InodeNumber{10}, makeDir(5));
+  auto fullSize = catalog->getLogSize();
+  auto crashed = std::move(catalog);
+
+  // Cut the second record in half, as a crash during its write would.
+  ASSERT_EQ(0, ::truncate(logPath(1).c_str(), fullSize - 20));
+
+  catalog = openCatalog();
+  EXPECT_EQ(2, catalog->loadOverlayDir(InodeNumber{10})->entries_ref()->size());
+  EXPECT_LT(catalog->getLogSize(), fullSize - 20);
+
+  // Changes after the discarded record are read back after reopening.
+  catalog->saveOverlayDir(InodeNumber{11}, makeDir(1));
+  crashed = std::move(catalog);
+  catalog = openCatalog();
+  EXPECT_TRUE(catalog->hasOverlayDir(InodeNumber{11}));
+  EXPECT_EQ(2, catalog->loadOverlayDir(InodeNumber{10})->entries_ref()->size());
+}
+
+TEST_F(PersistentMemInodeCatalogTest, maintenance_snapshots_large_logs) {
+  catalog->saveOverlayDir(InodeNumber{10}, makeDir(1));
+  catalog->maintenance();
+  // The log is still too small to be worth a snapshot.
+  EXPECT_EQ(0, access(logPath(1).c_str(), F_OK));
+
+  for (size_t i = 0; i < 100; ++i) {
+    catalog->saveOverlayDir(InodeNumber{11}, makeDir(10));
+  }
+  catalog->maintenance();
+  EXPECT_NE(0, access(logPath(1).c_str(), F_OK));
+  EXPECT_EQ(0, access(logPath(2).c_str(), F_OK));
+  EXPECT_LT(catalog->getLogSize(), 100);
+
+  // Changes made after the snapshot are replayed on top of it.
+  catalog->removeChild(InodeNumber{11}, "file3"_pc);
+  auto crashed = std::move(catalog);
+
+  catalog = openCatalog();
+  EXPECT_TRUE(catalog->hasOverlayDir(InodeNumber{10}));
+  EXPECT_EQ(9, catalog->loadOverlayDir(InodeNumber{11})->entries_ref()->size());
+  EXPECT_FALSE(catalog->hasChild(InodeNumber{11}, "file3"_pc));
+}
@@ -13,6 +13,8 @@
 #include <fcntl.h>
 #include <folly/portability/Unistd.h>
 #include <time.h>
+#include <algorithm>
+#include <unordered_set>
 
 #include <folly/Conv.h>
 #include <folly/ExceptionWrapper.h>
@@ -49,6 +51,9 @@ struct OverlayChecker::Impl {
   std::optional<InodeNumber> loadedNextInodeNumber;
   InodeCatalog::LookupCallback& lookupCallback;
   std::unordered_map<InodeNumber, InodeInfo> inodes;
+  // Inodes that are present in the overlay but haven't been loaded yet. Their
+  // entry in inodes is a placeholder that only holds their parents.
+  std::unordered_set<InodeNumber> unloadedInodes;
 
   Impl(
       InodeCatalog* inodeCatalog,
@@ -747,12 +752,14 @@ OverlayChecker::OverlayChecker(
     InodeCatalog* inodeCatalog,
     FileContentStore* fcs,
     optional<InodeNumber> nextInodeNumber,
-    InodeCatalog::LookupCallback& lookupCallback)
+    InodeCatalog::LookupCallback& lookupCallback,
+    size_t numThreads)
     : impl_{std::make_unique<Impl>(
           inodeCatalog,
           fcs,
           nextInodeNumber,
-          lookupCallback)} {}
+          lookupCallback)},
+      numThreads_{std::max<size_t>(numThreads, 1)} {}
 
 OverlayChecker::~OverlayChecker() {}
 
@@ -762,7 +769,6 @@ void OverlayChecker::scanForErrors(const ProgressCallback& progressCallback) {
     callback(0);
   }
   readInodes(progressCallback);
-  linkInodeChildren();
   scanForParentErrors();
   checkNextInodeNumber();
 
@@ -939,9 +945,9 @@ PathComponent OverlayChecker::findChildName(
     InodeNumber child) {
   // We just scan through all of the parents children to find the matching
   // entry.  While we could build a full map of children information during
-  // linkInodeChildren(), we only need this information when we actually find an
+  // readInodes(), we only need this information when we actually find an
   // error, which is hopefully rare.  Therefore we avoid doing as much work as
-  // possible during linkInodeChildren(), at the cost of doing extra work here
+  // possible during readInodes(), at the cost of doing extra work here
   // if we do actually need to compute paths.
   for (const auto& entry : *parentInfo.children.entries_ref()) {
     if (static_cast<uint64_t>(*entry.second.inodeNumber_ref()) == child.get()) {
@@ -950,7 +956,7 @@ PathComponent OverlayChecker::findChildName(
   }
 
   // This shouldn't ever happen unless we have a bug in the fsck code somehow.
-  // We should only get here if linkInodeChildren() found a parent-child
+  // We should only get here if readInodes() found a parent-child
   // relationship between these two inodes, and that relationship shouldn't ever
   // change during the fsck run.
   XLOG(DFATAL) << "bug in fsck code: cannot find child " << child
@@ -966,109 +972,78 @@ std::unique_ptr<OverlayChecker::Error> make_error(Args&&... args) {
 void OverlayChecker::readInodes(const ProgressCallback& progressCallback) {
   using namespace folly::gen;
 
-  auto threads = 4;
-  uint32_t progress10pct = 0;
-
   folly::Synchronized<std::vector<std::unique_ptr<Error>>> errors;
 
-  // TODO: parallelize these loads
+  // First list the inodes that are present in the overlay, which is much
+  // cheaper than loading them. Knowing all of them up front lets each inode
+  // be linked to its parents and children as soon as it is loaded, rather
+  // than in a separate pass over the whole graph once everything is loaded.
   std::vector<InodeNumber> dirs =
       this->impl_->inodeCatalog->getAllParentInodeNumbers();
-
-  for (const auto& d : dirs) {
-    auto inodeInfoOpt = loadInodeInfoFromInodeCatalog(d, errors);
-    if (inodeInfoOpt.has_value()) {
-      auto inodeInfo = inodeInfoOpt.value();
-      updateMaxInodeNumber(inodeInfo.number);
-      impl_->inodes.emplace(inodeInfo.number, inodeInfo);
-    }
+  for (auto number : dirs) {
+    addUnloadedInode(number);
   }
 
+  std::vector<InodeNumber> files;
   seq(0u, FileContentStore::kNumShards - 1) |
       pmap(
-          [this, &errors](
-              uint32_t shardID) -> std::vector<std::tuple<uint64_t, uint32_t>> {
-            // Get entries in directory
-            std::array<char, 2> subdirBuffer;
-            MutableStringPiece subdir{subdirBuffer.data(), subdirBuffer.size()};
-            FileContentStore::formatSubdirShardPath(shardID, subdir);
-            auto path = impl_->fcs->getLocalDir() + PathComponentPiece{subdir};
-
-            XLOG(DBG5) << "fsck:" << impl_->fcs->getLocalDir() << ": scanning "
-                       << path;
-
-            std::vector<std::tuple<uint64_t, uint32_t>> inodes;
-
-            boost::system::error_code error;
-            auto boostPath = boost::filesystem::path{path.value().c_str()};
-            auto iterator =
-                boost::filesystem::directory_iterator(boostPath, error);
-            if (error.value() != 0) {
-              errors.wlock()->push_back(
-                  make_error<ShardDirectoryEnumerationError>(path, error));
-              return inodes;
-            }
-
-            auto endIterator = boost::filesystem::directory_iterator();
-            while (iterator != endIterator) {
-              const auto& dirEntry = *iterator;
-              AbsolutePath inodePath = canonicalPath(dirEntry.path().string());
-              auto entryInodeNumber =
-                  folly::tryTo<uint64_t>(inodePath.basename().value());
-              if (entryInodeNumber.hasValue()) {
-                inodes.push_back(std::make_tuple(*entryInodeNumber, shardID));
-              } else {
-                errors.wlock()->push_back(
-                    make_error<UnexpectedOverlayFile>(inodePath));
-              }
-
-              iterator.increment(error);
-              if (error.value() != 0) {
-                errors.wlock()->push_back(
-                    make_error<ShardDirectoryEnumerationError>(path, error));
-                break;
-              }
-            }
-
-            return inodes;
-          },
-          threads) |
-      rconcat | move |
-      pmap(
-          [this, &errors](std::tuple<uint64_t, uint32_t> result)
-              -> std::optional<InodeInfo> {
-            return this->loadInodeSharded(
-                InodeNumber(std::get<0>(result)), std::get<1>(result), errors);
+          [this, &errors](uint32_t shardID) {
+            return listShard(shardID, errors);
           },
-          threads) |
-      move |
-      map([this, progressCallback, &progress10pct](
-              std::optional<InodeInfo> inodeInfoOpt) -> bool {
-        if (inodeInfoOpt.has_value()) {
-          auto inodeInfo = inodeInfoOpt.value();
-          ShardID shardID = static_cast<ShardID>(inodeInfo.number.get() & 0xff);
-          uint32_t progress = (10 * shardID) / FileContentStore::kNumShards;
-          if (progress > progress10pct) {
-            XLOG(INFO) << "fsck:" << impl_->fcs->getLocalDir() << ": scan "
-                       << progress << "0% complete: " << impl_->inodes.size()
-                       << " inodes scanned";
-            if (auto callback = progressCallback) {
-              callback(progress);
-            }
-            progress10pct = progress;
-          }
-
-          updateMaxInodeNumber(inodeInfo.number);
-          impl_->inodes.emplace(inodeInfo.number, inodeInfo);
-          if (impl_->inodes.size() % 10000 == 0) {
-            XLOG(DBG5) << "fsck: " << impl_->fcs->getLocalDir() << ": scanned "
-                       << impl_->inodes.size() << " inodes";
+          numThreads_) |
+      move | map([this, &files](std::vector<InodeNumber>&& shardInodes) {
+        for (auto number : shardInodes) {
+          // Dirs that are also listed by the InodeCatalog are only loaded
+          // once, from the InodeCatalog.
+          if (addUnloadedInode(number)) {
+            files.push_back(number);
           }
         }
         return true;
       }) |
       count;
 
+  auto total = dirs.size() + files.size();
+  size_t loaded = 0;
+  uint32_t progress10pct = 0;
+  auto addLoadedInode = [&](std::optional<InodeInfo>&& inodeInfoOpt) {
+    if (inodeInfoOpt.has_value()) {
+      addInode(std::move(*inodeInfoOpt));
+    }
+
+    ++loaded;
+    uint32_t progress = (10 * loaded) / total;
+    if (progress > progress10pct) {
+      XLOG(INFO) << "fsck:" << impl_->fcs->getLocalDir() << ": scan "
+                 << progress << "0% complete: " << loaded
+                 << " inodes scanned";
+      if (auto callback = progressCallback) {
+        callback(progress);
+      }
+      progress10pct = progress;
+    }
+    return true;
+  };
+
+  // Loading and parsing the inodes is spread across the threads, while
+  // linking them is done on this thread as their data arrives.
+  from(dirs) |
+      pmap(
+          [this, &errors](InodeNumber number) {
+            return loadInodeInfoFromInodeCatalog(number, errors);
+          },
+          numThreads_) |
+      move | map(addLoadedInode) | count;
+  from(files) |
+      pmap(
+          [this, &errors](InodeNumber number) {
+            return loadInodeInfoFromFileContentStore(number, errors);
+          },
+          numThreads_) |
+      move | map(addLoadedInode) | count;
+
+  linkUnloadedInodes();
+
   auto errorsLock = errors.wlock();
   while (!errorsLock->empty()) {
     addError(std::move(errorsLock->back()));
@@ -1079,22 +1054,53 @@ void OverlayChecker::readInodes(const ProgressCallback& progressCallback) {
              << impl_->inodes.size() << " inodes";
 }
 
-std::optional<InodeInfo> OverlayChecker::loadInodeSharded(
-    InodeNumber number,
+std::vector<InodeNumber> OverlayChecker::listShard(
     ShardID shardID,
     folly::Synchronized<std::vector<std::unique_ptr<Error>>>& errors) const {
-  XLOG(DBG9) << "fsck: loading inode " << number;
-
-  // Verify that we found this inode in the correct shard subdirectory.
-  // Ignore the data if it is in the wrong directory.
-  ShardID expectedShard = static_cast<ShardID>(number.get() & 0xff);
-  if (expectedShard != shardID) {
-    auto error = make_error<UnexpectedInodeShard>(number, shardID);
-    errors.wlock()->push_back(std::move(error));
-    return std::nullopt;
+  // Get entries in directory
+  std::array<char, 2> subdirBuffer;
+  MutableStringPiece subdir{subdirBuffer.data(), subdirBuffer.size()};
+  FileContentStore::formatSubdirShardPath(shardID, subdir);
+  auto path = impl_->fcs->getLocalDir() + PathComponentPiece{subdir};
+
+  XLOG(DBG5) << "fsck:" << impl_->fcs->getLocalDir() << ": scanning " << path;
+
+  std::vector<InodeNumber> inodes;
+
+  boost::system::error_code error;
+  auto boostPath = boost::filesystem::path{path.value().c_str()};
+  auto iterator = boost::filesystem::directory_iterator(boostPath, error);
+  if (error.value() != 0) {
+    errors.wlock()->push_back(
+        make_error<ShardDirectoryEnumerationError>(path, error));
+    return inodes;
   }
 
-  return loadInodeInfoFromFileContentStore(number, errors);
+  auto endIterator = boost::filesystem::directory_iterator();
+  while (iterator != endIterator) {
+    const auto& dirEntry = *iterator;
+    AbsolutePath inodePath = canonicalPath(dirEntry.path().string());
+    auto entryInodeNumber =
+        folly::tryTo<uint64_t>(inodePath.basename().value());
+    if (!entryInodeNumber.hasValue()) {
+      errors.wlock()->push_back(make_error<UnexpectedOverlayFile>(inodePath));
+    } else if ((*entryInodeNumber & 0xff) != shardID) {
+      // Ignore the data if it is in the wrong directory.
+      errors.wlock()->push_back(make_error<UnexpectedInodeShard>(
+          InodeNumber(*entryInodeNumber), shardID));
+    } else {
+      inodes.push_back(InodeNumber(*entryInodeNumber));
+    }
+
+    iterator.increment(error);
+    if (error.value() != 0) {
+      errors.wlock()->push_back(
+          make_error<ShardDirectoryEnumerationError>(path, error));
+      break;
+    }
+  }
+
+  return inodes;
 }
 
 std::optional<InodeInfo> OverlayChecker::loadInodeInfoFromInodeCatalog(
@@ -1121,41 +1127,87 @@ std::optional<InodeInfo> OverlayChecker::loadInodeInfoFromFileContentStore(
   return info;
 }
 
-void OverlayChecker::linkInodeChildren() {
-  for (const auto& [parentInodeNumber, parent] : impl_->inodes) {
-    for (const auto& [childName, child] : *parent.children.entries_ref()) {
-      auto childRawInode = *child.inodeNumber_ref();
-      if (childRawInode == 0) {
-        // Older versions of edenfs would leave the inode number set to 0
-        // if the child inode has never been loaded.  The child can't be
-        // present in the overlay if it doesn't have an inode number
-        // allocated for it yet.
-        //
-        // Newer versions of edenfs always allocate an inode number for all
-        // children, even if they haven't been loaded yet.
-        continue;
+bool OverlayChecker::addUnloadedInode(InodeNumber number) {
+  auto inserted =
+      impl_->inodes.try_emplace(number, number, InodeType::Error).second;
+  if (inserted) {
+    impl_->unloadedInodes.insert(number);
+  }
+  return inserted;
+}
+
+void OverlayChecker::addInode(InodeInfo&& loadedInfo) {
+  auto number = loadedInfo.number;
+  if (impl_->unloadedInodes.erase(number) == 0) {
+    return;
+  }
+  updateMaxInodeNumber(number);
+
+  // Keep the parents that were linked to this inode before it was loaded.
+  auto& info = impl_->inodes.at(number);
+  loadedInfo.parents = std::move(info.parents);
+  loadedInfo.modeFromParent = info.modeFromParent;
+  info = std::move(loadedInfo);
+
+  for (const auto& [childName, child] : *info.children.entries_ref()) {
+    auto childRawInode = *child.inodeNumber_ref();
+    if (childRawInode == 0) {
+      // Older versions of edenfs would leave the inode number set to 0
+      // if the child inode has never been loaded.  The child can't be
+      // present in the overlay if it doesn't have an inode number
+      // allocated for it yet.
+      //
+      // Newer versions of edenfs always allocate an inode number for all
+      // children, even if they haven't been loaded yet.
+      continue;
+    }
+
+    auto childInodeNumber = InodeNumber(childRawInode);
+    updateMaxInodeNumber(childInodeNumber);
+    auto childInfo = getInodeInfo(childInodeNumber);
+    if (!childInfo) {
+      const auto& hash = child.hash_ref();
+      if (!hash.has_value() || hash->empty()) {
+        // This child is materialized (since it doesn't have a hash
+        // linking it to a source control object).  It's a problem if the
+        // materialized data isn't actually present in the overlay.
+        addError<MissingMaterializedInode>(number, childName, child);
       }
+    } else {
+      // The child may not be loaded yet, in which case its InodeInfo is a
+      // placeholder that keeps the link until it is.
+      childInfo->addParent(number, *child.mode_ref());
 
-      auto childInodeNumber = InodeNumber(childRawInode);
-      updateMaxInodeNumber(childInodeNumber);
-      auto childInfo = getInodeInfo(childInodeNumber);
-      if (!childInfo) {
+      // TODO: It would be nice to also check for mismatch between
+      // childInfo->type and child.mode
+    }
+  }
+}
+
+void OverlayChecker::linkUnloadedInodes() {
+  // Inodes that were listed but couldn't be loaded are treated as missing
+  // from the overlay. This is rare, so finding the entries that refer to
+  // them can afford a scan of their parents.
+  for (auto number : impl_->unloadedInodes) {
+    auto iter = impl_->inodes.find(number);
+    auto parents = std::move(iter->second.parents);
+    impl_->inodes.erase(iter);
+
+    std::sort(parents.begin(), parents.end());
+    parents.erase(std::unique(parents.begin(), parents.end()), parents.end());
+    for (auto parent : parents) {
+      auto parentInfo = getInodeInfo(parent);
+      for (const auto& [childName, child] :
+           *parentInfo->children.entries_ref()) {
         const auto& hash = child.hash_ref();
-        if (!hash.has_value() || hash->empty()) {
-          // This child is materialized (since it doesn't have a hash
-          // linking it to a source control object).  It's a problem if the
-          // materialized data isn't actually present in the overlay.
-          addError<MissingMaterializedInode>(
-              parentInodeNumber, childName, child);
+        if (static_cast<uint64_t>(*child.inodeNumber_ref()) == number.get() &&
+            (!hash.has_value() || hash->empty())) {
+          addError<MissingMaterializedInode>(parent, childName, child);
         }
-      } else {
-        childInfo->addParent(parentInodeNumber, *child.mode_ref());
-
-        // TODO: It would be nice to also check for mismatch between
-        // childInfo->type and child.mode
       }
     }
   }
+  impl_->unloadedInodes.clear();
 }
 
 void OverlayChecker::scanForParentErrors() {
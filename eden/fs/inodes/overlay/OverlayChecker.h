@@ -54,6 +54,8 @@ class OverlayChecker {
 
   using ProgressCallback = std::function<void(uint16_t)>;
 
+  static constexpr size_t kDefaultNumThreads = 4;
+
   /**
    * Create a new OverlayChecker.
    *
@@ -61,12 +63,15 @@ class OverlayChecker {
    * FileContentStore for the duration of the check operation.  The caller is
    * responsible for ensuring that the InodeCatalog and FileContentStore objects
    * exist for at least as long as the OverlayChecker object.
+   *
+   * The overlay is read by numThreads threads.
    */
   OverlayChecker(
       InodeCatalog* inodeCatalog,
       FileContentStore* fcs,
       std::optional<InodeNumber> nextInodeNumber,
-      InodeCatalog::LookupCallback& lookupCallback);
+      InodeCatalog::LookupCallback& lookupCallback,
+      size_t numThreads = kDefaultNumThreads);
 
   ~OverlayChecker();
 
@@ -178,12 +183,10 @@ class OverlayChecker {
 
   using ShardID = uint32_t;
   void readInodes(const ProgressCallback& progressCallback = [](auto) {});
-  void readInodeSubdir(const AbsolutePath& path, ShardID shardID);
-  // loadInodeSharded and loadInodeInfoFromFileContentStore are called from a
+  // listShard and the loadInodeInfo functions are called from a
   // multi-threaded context, so make them const so they can't accidentally
   // mutate 'this'.
-  std::optional<fsck::InodeInfo> loadInodeSharded(
-      InodeNumber number,
+  std::vector<InodeNumber> listShard(
       ShardID shardID,
       folly::Synchronized<std::vector<std::unique_ptr<Error>>>& errors) const;
   std::optional<fsck::InodeInfo> loadInodeInfoFromFileContentStore(
@@ -193,7 +196,15 @@ class OverlayChecker {
       InodeNumber number,
       folly::Synchronized<std::vector<std::unique_ptr<Error>>>& errors) const;
 
-  void linkInodeChildren();
+  // Add a placeholder for an inode that is present in the overlay. Returns
+  // false if the inode was already added.
+  bool addUnloadedInode(InodeNumber number);
+  // Replace the placeholder of an inode with its data, and link it to its
+  // children.
+  void addInode(fsck::InodeInfo&& info);
+  // Drop the placeholders of the inodes that couldn't be loaded, and report
+  // the materialized entries that refer to them.
+  void linkUnloadedInodes();
   void scanForParentErrors();
   void checkNextInodeNumber();
 
@@ -214,6 +225,7 @@ class OverlayChecker {
   std::unique_ptr<Impl> impl_;
   std::vector<std::unique_ptr<Error>> errors_;
   uint64_t maxInodeNumber_{kRootNodeId.get()};
+  const size_t numThreads_;
 
   std::unordered_map<InodeNumber, PathInfo> pathCache_;
 };
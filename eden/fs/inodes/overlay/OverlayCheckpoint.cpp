@@ -0,0 +1,295 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/inodes/overlay/OverlayCheckpoint.h"
+
+#include <fcntl.h>
+#include <folly/Exception.h>
+#include <folly/FileUtil.h>
+#include <folly/String.h>
+#include <folly/logging/xlog.h>
+#include <folly/portability/Unistd.h>
+#include <sys/uio.h>
+#include <algorithm>
+#include <cstring>
+
+#include "eden/fs/inodes/InodeCatalog.h"
+#include "eden/fs/inodes/fscatalog/FsInodeCatalog.h"
+#include "eden/fs/inodes/overlay/OverlayCheckerUtil.h"
+
+namespace facebook::eden {
+
+namespace {
+
+constexpr uint32_t kCheckpointMagic = 0x45434b50; // "ECKP"
+constexpr uint32_t kJournalMagic = 0x45434a4e; // "ECJN"
+constexpr uint32_t kVersion = 1;
+
+struct CheckpointHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t generation;
+  uint64_t nextInodeNumber;
+};
+
+struct JournalHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t generation;
+};
+
+template <typename T>
+std::optional<T> parseHeader(folly::StringPiece data, uint32_t magic) {
+  T header;
+  if (data.size() < sizeof(header)) {
+    return std::nullopt;
+  }
+  memcpy(&header, data.data(), sizeof(header));
+  if (header.magic != magic || header.version != kVersion) {
+    return std::nullopt;
+  }
+  return header;
+}
+
+} // namespace
+
+std::optional<OverlayCheckpoint::Recovery> OverlayCheckpoint::loadAndRemove(
+    AbsolutePathPiece localDir) {
+  auto checkpointPath = localDir + PathComponentPiece{kCheckpointFile};
+  std::string checkpointData;
+  if (!folly::readFile(checkpointPath.c_str(), checkpointData)) {
+    if (errno != ENOENT) {
+      folly::throwSystemError("failed to read ", checkpointPath.view());
+    }
+    return std::nullopt;
+  }
+  std::string journalData;
+  auto journalPath = localDir + PathComponentPiece{kJournalFile};
+  auto journalRead = folly::readFile(journalPath.c_str(), journalData);
+
+  // Writes are about to resume without being journaled, so the checkpoint
+  // must be durably gone before this returns.
+  folly::checkUnixError(
+      unlink(checkpointPath.c_str()),
+      "failed to remove ",
+      checkpointPath.view());
+  folly::File dir{localDir.copy().c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC};
+  folly::checkUnixError(
+      folly::fsyncNoInt(dir.fd()), "failed to sync ", localDir.view());
+
+  auto checkpoint =
+      parseHeader<CheckpointHeader>(checkpointData, kCheckpointMagic);
+  if (!checkpoint || checkpointData.size() != sizeof(CheckpointHeader)) {
+    XLOG(WARN) << "Ignoring invalid overlay checkpoint " << checkpointPath;
+    return std::nullopt;
+  }
+  auto journal = journalRead
+      ? parseHeader<JournalHeader>(journalData, kJournalMagic)
+      : std::nullopt;
+  if (!journal || journal->generation != checkpoint->generation) {
+    // Too many inodes were written since the checkpoint, or the journal was
+    // being restarted for the next one.
+    XLOG(DBG2) << "Overlay checkpoint in " << localDir
+               << " does not match its journal";
+    return std::nullopt;
+  }
+
+  Recovery recovery;
+  recovery.nextInodeNumber = InodeNumber{checkpoint->nextInodeNumber};
+  // A partial entry at the end is from a write that never started.
+  auto entryCount =
+      (journalData.size() - sizeof(JournalHeader)) / sizeof(uint64_t);
+  recovery.dirtyInodes.reserve(entryCount);
+  for (size_t i = 0; i < entryCount; ++i) {
+    uint64_t inodeNumber;
+    memcpy(
+        &inodeNumber,
+        journalData.data() + sizeof(JournalHeader) + i * sizeof(uint64_t),
+        sizeof(inodeNumber));
+    recovery.dirtyInodes.emplace_back(inodeNumber);
+  }
+  return recovery;
+}
+
+std::optional<InodeNumber> OverlayCheckpoint::verify(
+    const Recovery& recovery,
+    InodeCatalog* inodeCatalog,
+    FileContentStore* fileContentStore) {
+  auto exists = [&](InodeNumber inodeNumber) {
+    return inodeCatalog->hasOverlayDir(inodeNumber) ||
+        fileContentStore->hasOverlayFile(inodeNumber);
+  };
+
+  auto nextInodeNumber = recovery.nextInodeNumber.get();
+  for (auto inodeNumber : recovery.dirtyInodes) {
+    nextInodeNumber = std::max(nextInodeNumber, inodeNumber.get() + 1);
+
+    std::optional<fsck::InodeInfo> info;
+    if (inodeCatalog->hasOverlayDir(inodeNumber)) {
+      info = inodeCatalog->loadInodeInfo(inodeNumber);
+    } else if (fileContentStore->hasOverlayFile(inodeNumber)) {
+      info = fileContentStore->loadInodeInfo(inodeNumber);
+    }
+    if (!info.has_value()) {
+      // The inode was removed after it was written.
+      continue;
+    }
+    if (info->type == fsck::InodeType::Error) {
+      XLOG(WARN) << "Inode " << inodeNumber
+                 << " was written since the last overlay checkpoint and is "
+                 << "corrupt: " << info->errorMsg;
+      return std::nullopt;
+    }
+
+    for (const auto& [name, entry] : *info->children.entries_ref()) {
+      auto childNumber = static_cast<uint64_t>(*entry.inodeNumber_ref());
+      if (childNumber == 0) {
+        continue;
+      }
+      nextInodeNumber = std::max(nextInodeNumber, childNumber + 1);
+      auto materialized = !entry.hash_ref() || entry.hash_ref()->empty();
+      if (materialized && !exists(InodeNumber{childNumber})) {
+        XLOG(WARN) << "Child " << name << " of inode " << inodeNumber
+                   << " is materialized but missing from the overlay";
+        return std::nullopt;
+      }
+    }
+  }
+  return InodeNumber{nextInodeNumber};
+}
+
+OverlayCheckpoint::OverlayCheckpoint(
+    AbsolutePathPiece localDir,
+    size_t maxDirtyInodes)
+    : checkpointPath_{localDir + PathComponentPiece{kCheckpointFile}},
+      maxDirtyInodes_{maxDirtyInodes} {
+  auto state = state_.lock();
+  state->journal = folly::File{
+      (localDir + PathComponentPiece{kJournalFile}).c_str(),
+      O_RDWR | O_CREAT | O_CLOEXEC,
+      0600};
+  invalidate(*state);
+}
+
+void OverlayCheckpoint::invalidate(State& state) {
+  folly::checkUnixError(
+      folly::ftruncateNoInt(state.journal.fd(), 0),
+      "failed to truncate the overlay checkpoint journal");
+  folly::checkUnixError(
+      folly::fdatasyncNoInt(state.journal.fd()),
+      "failed to sync the overlay checkpoint journal");
+  state.journalSize = 0;
+  state.journalValid = false;
+  state.checkpointWritten = false;
+  state.dirtyInodes.clear();
+}
+
+std::shared_lock<folly::SharedMutex> OverlayCheckpoint::markDirty(
+    InodeNumber inodeNumber) {
+  std::shared_lock<folly::SharedMutex> guard{writeBarrier_};
+  journalInode(*state_.lock(), inodeNumber);
+  return guard;
+}
+
+std::shared_lock<folly::SharedMutex> OverlayCheckpoint::markDirty(
+    InodeNumber first,
+    InodeNumber second) {
+  std::shared_lock<folly::SharedMutex> guard{writeBarrier_};
+  auto state = state_.lock();
+  journalInode(*state, first);
+  journalInode(*state, second);
+  return guard;
+}
+
+void OverlayCheckpoint::journalInode(State& state, InodeNumber inodeNumber) {
+  state.changed = true;
+  if (!state.journalValid || state.dirtyInodes.count(inodeNumber)) {
+    return;
+  }
+  if (state.dirtyInodes.size() >= maxDirtyInodes_) {
+    XLOG(DBG3) << "More than " << maxDirtyInodes_
+               << " inodes written since the last overlay checkpoint";
+    invalidate(state);
+    return;
+  }
+
+  auto entry = inodeNumber.get();
+  auto fd = state.journal.fd();
+  if (folly::pwriteFull(fd, &entry, sizeof(entry), state.journalSize) < 0 ||
+      folly::fdatasyncNoInt(fd) < 0) {
+    XLOG(WARN) << "Failed to append to the overlay checkpoint journal: "
+               << folly::errnoStr(errno);
+    invalidate(state);
+    return;
+  }
+  state.journalSize += sizeof(entry);
+  state.dirtyInodes.insert(inodeNumber);
+}
+
+void OverlayCheckpoint::write(
+    folly::FunctionRef<InodeNumber()> getNextInodeNumber) {
+#ifdef __linux__
+  uint64_t generation;
+  InodeNumber nextInodeNumber;
+  int fd;
+  {
+    // Start a new journal while no writes are in progress, so that every
+    // write is either flushed below or journaled.
+    std::unique_lock<folly::SharedMutex> barrier{writeBarrier_};
+    auto state = state_.lock();
+    if (state->checkpointWritten && !state->changed) {
+      return;
+    }
+    generation = state->generation + 1;
+    fd = state->journal.fd();
+    invalidate(*state);
+    JournalHeader header{kJournalMagic, kVersion, generation};
+    folly::checkUnixError(
+        folly::pwriteFull(fd, &header, sizeof(header), 0),
+        "failed to write the overlay checkpoint journal");
+    folly::checkUnixError(
+        folly::fdatasyncNoInt(fd),
+        "failed to sync the overlay checkpoint journal");
+    state->generation = generation;
+    state->journalSize = sizeof(header);
+    state->journalValid = true;
+    state->changed = false;
+    nextInodeNumber = getNextInodeNumber();
+  }
+
+  folly::checkUnixError(syncfs(fd), "failed to sync the overlay");
+
+  auto state = state_.lock();
+  if (!state->journalValid || state->generation != generation) {
+    return;
+  }
+  CheckpointHeader header{
+      kCheckpointMagic, kVersion, generation, nextInodeNumber.get()};
+  iovec iov;
+  iov.iov_base = &header;
+  iov.iov_len = sizeof(header);
+  if (auto err = folly::writeFileAtomicNoThrow(
+          checkpointPath_.view(),
+          &iov,
+          1,
+          0600,
+          folly::SyncType::WITH_SYNC)) {
+    folly::throwSystemErrorExplicit(
+        err, "failed to write ", checkpointPath_.view());
+  }
+  state->checkpointWritten = true;
+#else
+  // Without syncfs(), there is no way to know when the overlay is durable.
+  (void)getNextInodeNumber;
+#endif
+}
+
+} // namespace facebook::eden
+
+#endif
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#ifndef _WIN32
+
+#include <folly/File.h>
+#include <folly/Function.h>
+#include <folly/Range.h>
+#include <folly/SharedMutex.h>
+#include <folly/Synchronized.h>
+#include <folly/container/F14Set.h>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <vector>
+
+#include "eden/fs/inodes/InodeNumber.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+class FileContentStore;
+class InodeCatalog;
+
+/**
+ * Periodic checkpoints of an overlay, so that a crash of a mostly idle mount
+ * does not require a full fsck scan on the next startup.
+ *
+ * A checkpoint records that every overlay write made before it is durable,
+ * along with the next inode number at that time. Every inode written after a
+ * checkpoint is appended to a journal, and its write only proceeds once the
+ * journal entry is durable. After a crash, only the inodes in the journal can
+ * be inconsistent, so verifying them replaces the full scan.
+ *
+ * Writing a checkpoint flushes the whole filesystem the overlay lives on, so
+ * it is only available for overlays that write straight to their files, and
+ * only on Linux.
+ */
+class OverlayCheckpoint {
+ public:
+  struct Recovery {
+    InodeNumber nextInodeNumber;
+    std::vector<InodeNumber> dirtyInodes;
+  };
+
+  /**
+   * Load the checkpoint left by the previous run of the overlay, if it is
+   * complete, and remove it so that it can't be trusted by a later startup
+   * once this run starts writing to the overlay.
+   *
+   * This must be called on every startup of an overlay that may have been
+   * checkpointed, before anything is written to it.
+   */
+  static std::optional<Recovery> loadAndRemove(AbsolutePathPiece localDir);
+
+  /**
+   * Check that the inodes written since the checkpoint are readable and that
+   * every materialized child they reference exists.
+   *
+   * Returns the next inode number to use, or std::nullopt if the overlay must
+   * be fully scanned instead.
+   */
+  static std::optional<InodeNumber> verify(
+      const Recovery& recovery,
+      InodeCatalog* inodeCatalog,
+      FileContentStore* fileContentStore);
+
+  /**
+   * Checkpoints are abandoned until the next call to write() once more than
+   * maxDirtyInodes inodes have been written since the last one.
+   */
+  OverlayCheckpoint(AbsolutePathPiece localDir, size_t maxDirtyInodes);
+
+  OverlayCheckpoint(const OverlayCheckpoint&) = delete;
+  OverlayCheckpoint& operator=(const OverlayCheckpoint&) = delete;
+
+  /**
+   * Record that inodeNumber is about to be written.
+   *
+   * The returned lock must be held until the write is complete, so that a
+   * checkpoint never starts while a write is in progress.
+   */
+  [[nodiscard]] std::shared_lock<folly::SharedMutex> markDirty(
+      InodeNumber inodeNumber);
+
+  /**
+   * Like markDirty(InodeNumber), but for a write that touches two inodes.
+   * The write barrier is only taken once, as it must not be locked
+   * recursively.
+   */
+  [[nodiscard]] std::shared_lock<folly::SharedMutex> markDirty(
+      InodeNumber first,
+      InodeNumber second);
+
+  /**
+   * Write a new checkpoint if anything was written since the last one.
+   *
+   * This blocks until the filesystem has been flushed, so it should be
+   * called from a background thread.
+   */
+  void write(folly::FunctionRef<InodeNumber()> getNextInodeNumber);
+
+  static constexpr folly::StringPiece kCheckpointFile{"checkpoint"};
+  static constexpr folly::StringPiece kJournalFile{"checkpoint-journal"};
+
+ private:
+  struct State {
+    folly::File journal;
+    uint64_t journalSize = 0;
+    // Generation of the journal, which the checkpoint file must match.
+    uint64_t generation = 0;
+    // Whether every inode written since the journal was started is in it.
+    bool journalValid = false;
+    bool checkpointWritten = false;
+    // Whether any inode was written since the journal was started.
+    bool changed = true;
+    folly::F14FastSet<InodeNumber> dirtyInodes;
+  };
+
+  /**
+   * Empty the journal, so that the current checkpoint no longer applies.
+   */
+  static void invalidate(State& state);
+
+  void journalInode(State& state, InodeNumber inodeNumber);
+
+  const AbsolutePath checkpointPath_;
+  const size_t maxDirtyInodes_;
+  // Held shared by writes, and exclusively while a new journal is started.
+  folly::SharedMutex writeBarrier_;
+  folly::Synchronized<State, std::mutex> state_;
+};
+
+} // namespace facebook::eden
+
+#endif
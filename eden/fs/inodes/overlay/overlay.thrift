@@ -40,3 +40,11 @@ struct OverlayDir {
   // The contents of this dir.
   1: map<PathComponent, OverlayEntry> entries;
 }
+
+// A change to a directory that the legacy overlay appends to the directory's
+// file instead of rewriting the whole directory. The entries of removed are
+// removed before the entries of added are added or replaced.
+struct OverlayDirDelta {
+  1: map<PathComponent, OverlayEntry> added;
+  2: list<PathComponent> removed;
+}
@@ -23,6 +23,7 @@
 #include "eden/fs/utils/CaseSensitivity.h"
 #include "eden/fs/utils/DirType.h"
 #include "eden/fs/utils/FileUtils.h"
+#include "eden/fs/utils/PathMap.h"
 #include "eden/fs/utils/ProjfsUtil.h"
 
 namespace facebook::eden {
@@ -463,13 +464,17 @@ PathMap<FsckFileState> populateOnDiskChildrenState(
 
   WIN32_FIND_DATAW findFileData;
   // TODO: Should FIND_FIRST_EX_ON_DISK_ENTRIES_ONLY be used?
+  //
+  // Directories are listed in full, FIND_FIRST_EX_LARGE_FETCH has the
+  // underlying NtQueryDirectoryFile calls use a larger buffer, so that large
+  // directories are listed in fewer calls into the kernel.
   HANDLE h = FindFirstFileExW(
       absPath.c_str(),
       FindExInfoBasic,
       &findFileData,
       FindExSearchNameMatch,
       nullptr,
-      0);
+      FIND_FIRST_EX_LARGE_FETCH);
   if (h == INVALID_HANDLE_VALUE) {
     throw std::runtime_error(
         fmt::format("unable to iterate over directory - {}", path));
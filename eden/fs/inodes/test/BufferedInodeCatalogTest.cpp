@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/BufferedInodeCatalog.h"
+
+#include <folly/Conv.h>
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <folly/portability/GTest.h>
+#include <sys/stat.h>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+
+/**
+ * An in-memory InodeCatalog that counts the writes it receives.
+ */
+class CountingInodeCatalog : public InodeCatalog {
+ public:
+  struct State {
+    folly::F14FastMap<InodeNumber, overlay::OverlayDir> dirs;
+    size_t saveCount = 0;
+    size_t removeCount = 0;
+    bool closed = false;
+  };
+
+  bool supportsSemanticOperations() const override {
+    return false;
+  }
+
+  std::vector<InodeNumber> getAllParentInodeNumbers() override {
+    std::vector<InodeNumber> result;
+    for (const auto& entry : state->rlock()->dirs) {
+      result.push_back(entry.first);
+    }
+    return result;
+  }
+
+  std::optional<InodeNumber> initOverlay(bool, bool) override {
+    return InodeNumber{2};
+  }
+
+  void close(std::optional<InodeNumber>) override {
+    state->wlock()->closed = true;
+  }
+
+  bool initialized() const override {
+    return true;
+  }
+
+  std::optional<overlay::OverlayDir> loadOverlayDir(
+      InodeNumber inodeNumber) override {
+    auto locked = state->rlock();
+    auto it = locked->dirs.find(inodeNumber);
+    if (it == locked->dirs.end()) {
+      return std::nullopt;
+    }
+    return it->second;
+  }
+
+  std::optional<overlay::OverlayDir> loadAndRemoveOverlayDir(
+      InodeNumber inodeNumber) override {
+    auto odir = loadOverlayDir(inodeNumber);
+    removeOverlayDir(inodeNumber);
+    return odir;
+  }
+
+  void saveOverlayDir(InodeNumber inodeNumber, overlay::OverlayDir&& odir)
+      override {
+    auto locked = state->wlock();
+    locked->dirs.insert_or_assign(inodeNumber, std::move(odir));
+    ++locked->saveCount;
+  }
+
+  void removeOverlayDir(InodeNumber inodeNumber) override {
+    auto locked = state->wlock();
+    locked->dirs.erase(inodeNumber);
+    ++locked->removeCount;
+  }
+
+  bool hasOverlayDir(InodeNumber inodeNumber) override {
+    return state->rlock()->dirs.count(inodeNumber) != 0;
+  }
+
+  std::optional<fsck::InodeInfo> loadInodeInfo(InodeNumber) override {
+    return std::nullopt;
+  }
+
+  // Shared so the test can look at it after the catalog is handed over.
+  std::shared_ptr<folly::Synchronized<State>> state =
+      std::make_shared<folly::Synchronized<State>>();
+};
+
+overlay::OverlayDir makeDir(size_t entryCount) {
+  overlay::OverlayDir odir;
+  for (size_t i = 0; i < entryCount; ++i) {
+    overlay::OverlayEntry entry;
+    entry.mode_ref() = S_IFREG | 0644;
+    entry.inodeNumber_ref() = 100 + i;
+    odir.entries_ref()->emplace(folly::to<std::string>("file", i), entry);
+  }
+  return odir;
+}
+
+struct BufferedInodeCatalogTest : ::testing::Test {
+  void SetUp() override {
+    auto inner = std::make_unique<CountingInodeCatalog>();
+    innerState = inner->state;
+    catalog = std::make_unique<BufferedInodeCatalog>(
+        std::move(inner), 1h, 64 * 1024 * 1024);
+  }
+
+  std::shared_ptr<folly::Synchronized<CountingInodeCatalog::State>>
+      innerState;
+  std::unique_ptr<BufferedInodeCatalog> catalog;
+};
+
+} // namespace
+
+TEST_F(BufferedInodeCatalogTest, repeated_saves_are_written_once) {
+  InodeNumber ino{10};
+  for (size_t i = 1; i <= 100; ++i) {
+    catalog->saveOverlayDir(ino, makeDir(i));
+  }
+
+  // The writes are buffered, but reads see them.
+  EXPECT_EQ(0, innerState->rlock()->saveCount);
+  EXPECT_TRUE(catalog->hasOverlayDir(ino));
+  EXPECT_EQ(100, catalog->loadOverlayDir(ino)->entries_ref()->size());
+
+  catalog->flush();
+  EXPECT_EQ(1, innerState->rlock()->saveCount);
+  EXPECT_EQ(100, innerState->rlock()->dirs.at(ino).entries_ref()->size());
+}
+
+TEST_F(BufferedInodeCatalogTest, removing_a_buffered_dir) {
+  InodeNumber ino{10};
+  catalog->saveOverlayDir(ino, makeDir(1));
+  catalog->flush();
+
+  catalog->saveOverlayDir(ino, makeDir(2));
+  catalog->removeOverlayDir(ino);
+  EXPECT_FALSE(catalog->hasOverlayDir(ino));
+  EXPECT_FALSE(catalog->loadOverlayDir(ino).has_value());
+
+  catalog->flush();
+  auto state = innerState->rlock();
+  EXPECT_EQ(1, state->saveCount);
+  EXPECT_EQ(1, state->removeCount);
+  EXPECT_EQ(0, state->dirs.count(ino));
+}
+
+TEST_F(BufferedInodeCatalogTest, load_and_remove_returns_the_buffered_dir) {
+  InodeNumber ino{10};
+  catalog->saveOverlayDir(ino, makeDir(1));
+  catalog->flush();
+  catalog->saveOverlayDir(ino, makeDir(3));
+
+  auto odir = catalog->loadAndRemoveOverlayDir(ino);
+  ASSERT_TRUE(odir.has_value());
+  EXPECT_EQ(3, odir->entries_ref()->size());
+  EXPECT_FALSE(catalog->hasOverlayDir(ino));
+  EXPECT_FALSE(catalog->loadAndRemoveOverlayDir(ino).has_value());
+
+  catalog->flush();
+  EXPECT_EQ(0, innerState->rlock()->dirs.count(ino));
+}
+
+TEST_F(BufferedInodeCatalogTest, close_writes_the_buffered_dirs) {
+  catalog->saveOverlayDir(InodeNumber{10}, makeDir(1));
+  catalog->saveOverlayDir(InodeNumber{11}, makeDir(2));
+  catalog->close(InodeNumber{12});
+
+  auto state = innerState->rlock();
+  EXPECT_TRUE(state->closed);
+  EXPECT_EQ(2, state->dirs.size());
+}
+
+TEST(BufferedInodeCatalog, a_full_buffer_is_written_without_waiting) {
+  auto inner = std::make_unique<CountingInodeCatalog>();
+  auto innerState = inner->state;
+  // A buffer too small for a single directory.
+  BufferedInodeCatalog catalog{std::move(inner), 1h, 1};
+
+  catalog.saveOverlayDir(InodeNumber{10}, makeDir(1));
+  // This blocks until the worker thread picked up the first directory, which
+  // it does right away since the buffer is full.
+  catalog.saveOverlayDir(InodeNumber{11}, makeDir(1));
+  catalog.saveOverlayDir(InodeNumber{12}, makeDir(1));
+  EXPECT_TRUE(catalog.hasOverlayDir(InodeNumber{10}));
+
+  catalog.close(std::nullopt);
+  EXPECT_EQ(3, innerState->rlock()->saveCount);
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <fmt/format.h>
+
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/inodes/TreeInode.h"
+#include "eden/fs/service/gen-cpp2/eden_types.h"
+#include "eden/fs/testharness/SyntheticBackingStore.h"
+#include "eden/fs/testharness/TestMount.h"
+
+namespace {
+
+using namespace facebook::eden;
+
+/**
+ * 111 directories of 100 files each.
+ */
+SyntheticBackingStore::Options checkoutRepo(uint32_t changedFilesPercent) {
+  SyntheticBackingStore::Options options;
+  options.maxDepth = 2;
+  options.fanOut = 10;
+  options.filesPerDir = 100;
+  options.changedFilesPercent = changedFilesPercent;
+  return options;
+}
+
+/**
+ * 1111 directories of 900 files each: about a million entries.
+ */
+SyntheticBackingStore::Options statusRepo() {
+  SyntheticBackingStore::Options options;
+  options.maxDepth = 3;
+  options.fanOut = 10;
+  options.filesPerDir = 900;
+  return options;
+}
+
+/**
+ * Mounts commit 1 of the synthetic repository, with `materialized` files
+ * modified in the working copy, spread over the top-level directories.
+ */
+std::unique_ptr<TestMount> makeMount(
+    const SyntheticBackingStore::Options& options,
+    bool loadAllInodes,
+    int64_t materialized) {
+  auto mount = std::make_unique<TestMount>();
+  mount->initialize(
+      std::make_shared<SyntheticBackingStore>(options), RootId{"1"});
+  if (loadAllInodes) {
+    mount->loadAllInodes();
+  }
+  for (int64_t i = 0; i < materialized; ++i) {
+    mount->overwriteFile(
+        fmt::format(
+            "dir{}/file{}",
+            i % options.fanOut,
+            (i / options.fanOut) % options.filesPerDir),
+        "modified\n");
+  }
+  return mount;
+}
+
+void runCheckout(TestMount& mount, const RootId& commit) {
+  auto* executor = mount.getServerExecutor().get();
+  mount.getEdenMount()
+      ->checkout(mount.getRootInode(), commit, std::nullopt, __func__)
+      .via(executor)
+      .getVia(executor);
+}
+
+/**
+ * Checks out commit 2 from commit 1, with the changed files percentage, the
+ * number of materialized files, and whether every inode was loaded first as
+ * arguments. Every iteration starts from a new mount, so caches are cold
+ * unless the inodes are loaded.
+ */
+void checkout(benchmark::State& state) {
+  auto options = checkoutRepo(state.range(0));
+  bool warm = state.range(1);
+  auto materialized = state.range(2);
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto mount = makeMount(options, warm, materialized);
+    state.ResumeTiming();
+
+    runCheckout(*mount, RootId{"2"});
+
+    state.PauseTiming();
+    mount.reset();
+    state.ResumeTiming();
+  }
+}
+BENCHMARK(checkout)
+    ->ArgNames({"changed%", "warm", "materialized"})
+    ->Args({1, false, 0})
+    ->Args({1, true, 0})
+    ->Args({10, false, 0})
+    ->Args({10, true, 0})
+    ->Args({10, true, 1000})
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * Computes the status of a clean or partially materialized mount of about a
+ * million entries, with every inode loaded.
+ */
+void status(benchmark::State& state) {
+  auto mount = makeMount(statusRepo(), true, state.range(0));
+  auto* executor = mount->getServerExecutor().get();
+
+  for (auto _ : state) {
+    auto status = mount->getEdenMount()
+                      ->diff(
+                          mount->getRootInode(),
+                          RootId{"1"},
+                          folly::CancellationToken{},
+                          /*listIgnored=*/false,
+                          /*enforceCurrentParent=*/false)
+                      .semi()
+                      .via(executor)
+                      .getVia(executor);
+    benchmark::DoNotOptimize(status);
+  }
+}
+BENCHMARK(status)
+    ->ArgNames({"materialized"})
+    ->Arg(0)
+    ->Arg(1000)
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -884,6 +884,75 @@ TEST(Checkout, addSubdirectory) {
   }
 }
 
+TEST(Checkout, estimateCheckout) {
+  auto builder1 = FakeTreeBuilder();
+  builder1.setFile("src/main.c", "int main() { return 0; }\n");
+  builder1.setFile("src/test/test.c", "testy tests");
+  builder1.setFile("doc/readme.txt", "docs\n");
+  builder1.setFile("lib/a.c", "a\n");
+  TestMount testMount{RootId{"1"}, builder1};
+
+  auto builder2 = builder1.clone();
+  builder2.replaceFile("src/main.c", "int main() { return 1; }\n");
+  builder2.replaceFile("src/test/test.c", "new tests");
+  builder2.removeFile("doc/readme.txt");
+  builder2.setFile("lib/b.c", "b\n");
+  builder2.finalize(testMount.getBackingStore(), true);
+  auto commit2 = testMount.getBackingStore()->putCommit("2", builder2);
+  commit2->setReady();
+
+  // Load src/main.c and locally modify src/test/test.c.
+  auto mainInode = testMount.getFileInode("src/main.c");
+  testMount.overwriteFile("src/test/test.c", "local tests");
+
+  auto estimate = testMount.getEdenMount()
+                      ->estimateCheckout(RootId{"2"}, folly::CancellationToken{})
+                      .get(10s);
+  EXPECT_EQ(4, estimate.changedFiles);
+  EXPECT_EQ(3, estimate.blobsToFetch);
+  EXPECT_EQ(2, estimate.loadedInodesAffected);
+  EXPECT_EQ(1, estimate.materializedConflicts);
+
+  // Estimating does not check anything out.
+  EXPECT_EQ(RootId{"1"}, testMount.getEdenMount()->getCheckedOutRootId());
+  EXPECT_FILE_INODE(
+      testMount.getFileInode("src/main.c"), "int main() { return 0; }\n", 0644);
+  EXPECT_TRUE(testMount.hasFileAt("doc/readme.txt"));
+}
+
+TEST(Checkout, prefetchTrees) {
+  auto builder1 = FakeTreeBuilder();
+  builder1.setFile("src/main.c", "int main() { return 0; }\n");
+  builder1.setFile("src/test/test.c", "testy tests");
+  builder1.setFile("doc/readme.txt", "docs\n");
+  TestMount testMount{builder1};
+  testMount.updateEdenConfig({{"hg:checkout-prefetch-trees", "true"}});
+
+  auto builder2 = builder1.clone();
+  builder2.replaceFile("src/test/test.c", "new tests");
+  builder2.setFile("src/lib/lib.c", "lib\n");
+  builder2.removeFile("doc/readme.txt");
+  builder2.finalize(testMount.getBackingStore(), true);
+  auto commit2 = testMount.getBackingStore()->putCommit("2", builder2);
+  commit2->setReady();
+
+  auto executor = testMount.getServerExecutor().get();
+  auto checkoutResult =
+      testMount.getEdenMount()
+          ->checkout(
+              testMount.getRootInode(), RootId("2"), std::nullopt, __func__)
+          .waitVia(executor);
+  ASSERT_TRUE(checkoutResult.isReady());
+  auto result = std::move(checkoutResult).get();
+  EXPECT_EQ(0, result.conflicts.size());
+  EXPECT_LE(result.times.didPrefetch, result.times.didDiff);
+
+  EXPECT_FILE_INODE(
+      testMount.getFileInode("src/test/test.c"), "new tests", 0644);
+  EXPECT_FILE_INODE(testMount.getFileInode("src/lib/lib.c"), "lib\n", 0644);
+  EXPECT_FALSE(testMount.hasFileAt("doc/readme.txt"));
+}
+
 void testRemoveSubdirectory(LoadBehavior loadType) {
   // Build the destination source control tree first
   auto destBuilder = FakeTreeBuilder();
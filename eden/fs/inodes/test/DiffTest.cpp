@@ -115,6 +115,13 @@ class DiffTest {
         .thenValue([](std::unique_ptr<ScmStatus>&& result) { return *result; });
   }
 
+  ScmStatus mountDiff(bool listIgnored = false) {
+    auto df =
+        diffFuture(listIgnored).semi().via(mount_.getServerExecutor().get());
+    mount_.drainServerExecutor();
+    return EXPECT_FUTURE_RESULT(df);
+  }
+
   ScmStatus resetCommitAndDiff(FakeTreeBuilder& builder, bool loadInodes);
 
   void checkNoChanges() {
@@ -671,6 +678,36 @@ TEST(DiffTest, ignoredFileInMountAndInTree) {
           std::make_pair("src/foo/ignore.txt", ScmFileStatus::IGNORED)));
 }
 
+// Ignored untracked directories are listed from the overlay without loading
+// their inodes.
+TEST(DiffTest, ignoredDirectoryNotLoaded) {
+  DiffTest test({
+      {".gitignore", "junk/\n"},
+      {"a/b.txt", "test\n"},
+  });
+
+  test.getMount().mkdir("junk");
+  test.getMount().addFile("junk/stuff.txt", "new\n");
+  test.getMount().mkdir("junk/sub");
+  test.getMount().addFile("junk/sub/deep.txt", "new\n");
+  test.getMount().addFile("junk/sub/.gitignore", "!deep.txt\n");
+  test.getMount().getEdenMount()->getRootInode()->unloadChildrenNow();
+
+  auto result = test.diff(true);
+  EXPECT_THAT(
+      *result.entries_ref(),
+      UnorderedElementsAre(
+          std::make_pair("junk/stuff.txt", ScmFileStatus::IGNORED),
+          std::make_pair("junk/sub/deep.txt", ScmFileStatus::IGNORED),
+          std::make_pair("junk/sub/.gitignore", ScmFileStatus::IGNORED)));
+
+  auto rootInode = test.getMount().getEdenMount()->getRootInode();
+  auto contents = rootInode->getContents().rlock();
+  auto junk = contents->entries.find("junk"_pc);
+  ASSERT_NE(contents->entries.end(), junk);
+  EXPECT_EQ(nullptr, junk->second.getInode());
+}
+
 // Test with a file that matches a .gitignore pattern but also is already in the
 // Tree but removed from mount (so we should report the file removal)
 TEST(DiffTest, ignoredFileNotInMountButInTree) {
@@ -1597,6 +1634,51 @@ TEST(DiffTest, fileNotReady) {
           std::make_pair("doc/d.txt", ScmFileStatus::MODIFIED)));
 }
 
+TEST(DiffTest, statusCacheIsUpdatedFromJournal) {
+  DiffTest test;
+  auto& mount = test.getMount();
+  mount.updateEdenConfig({{"hg:enable-status-cache", "true"}});
+
+  auto checkMatchesFullDiff = [&](bool listIgnored) {
+    auto cached = test.mountDiff(listIgnored);
+    auto full = test.diff(listIgnored);
+    EXPECT_THAT(
+        *cached.entries_ref(),
+        UnorderedElementsAreArray(*full.entries_ref()));
+  };
+
+  checkMatchesFullDiff(false);
+  checkMatchesFullDiff(true);
+
+  mount.overwriteFile("src/1.txt", "This file has been updated.\n");
+  checkMatchesFullDiff(false);
+
+  mount.mkdir("src/new");
+  mount.addFile("src/new/file.txt", "extra stuff");
+  mount.addFile("src/a/new.txt", "extra stuff");
+  checkMatchesFullDiff(false);
+  checkMatchesFullDiff(true);
+
+  // Restoring a file removes it from the status.
+  mount.overwriteFile("src/1.txt", "This is src/1.txt.\n");
+  mount.deleteFile("src/a/b/3.txt");
+  checkMatchesFullDiff(false);
+
+  // New ignore rules apply to files that didn't change themselves.
+  mount.addFile("src/.gitignore", "new.txt\nnew\n");
+  checkMatchesFullDiff(false);
+  checkMatchesFullDiff(true);
+
+  auto result = test.mountDiff(true);
+  EXPECT_THAT(
+      *result.entries_ref(),
+      UnorderedElementsAre(
+          std::make_pair("src/.gitignore", ScmFileStatus::ADDED),
+          std::make_pair("src/a/b/3.txt", ScmFileStatus::REMOVED),
+          std::make_pair("src/a/new.txt", ScmFileStatus::IGNORED),
+          std::make_pair("src/new/file.txt", ScmFileStatus::IGNORED)));
+}
+
 TEST(DiffTest, cancelledDiff) {
   TestMount mount;
   auto backingStore = mount.getBackingStore();
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/Conv.h>
+#include <folly/init/Init.h>
+#include <folly/portability/GFlags.h>
+#include <folly/stop_watch.h>
+
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/config/InodeCatalogType.h"
+#include "eden/fs/inodes/DirEntry.h"
+#include "eden/fs/inodes/Overlay.h"
+#include "eden/fs/inodes/TreeInode.h"
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/telemetry/EdenStats.h"
+#include "eden/fs/telemetry/NullStructuredLogger.h"
+#include "eden/fs/testharness/TempFile.h"
+#include "eden/fs/utils/Memory.h"
+
+using namespace facebook::eden;
+
+DEFINE_uint64(entries, 100000, "Number of entries in the directory");
+DEFINE_uint64(nameLength, 20, "Length of each entry name");
+DEFINE_uint64(
+    hashLength,
+    21,
+    "Length of each object ID. Hg proxy hashes are 21 bytes, or more when "
+    "they embed the path.");
+
+namespace {
+
+/**
+ * Heap usage of the entries of a DirContents, computed the same way as
+ * Tree::getSizeBytes() so the two can be compared.
+ */
+size_t estimateDirContentsSize(const DirContents& contents) {
+  size_t size = folly::goodMallocSize(
+      sizeof(DirContents::value_type) * contents.capacity());
+  size += contents.getIndexSizeBytes();
+  for (const auto& entry : contents) {
+    size += estimateIndirectMemoryUsage(entry.first.value());
+    if (auto* hash = entry.second.getHashPtr();
+        hash && hash->size() > ObjectId::kMaxInlineSize) {
+      size += folly::goodMallocSize(hash->size());
+    }
+  }
+  return size;
+}
+
+/**
+ * Zero-pads i to width, so that the results sort in numerical order.
+ */
+std::string paddedNumber(uint64_t i, size_t width) {
+  auto number = folly::to<std::string>(i);
+  if (number.size() < width) {
+    number.insert(0, width - number.size(), '0');
+  }
+  return number;
+}
+
+TreePtr makeTree() {
+  Tree::container entries{kPathMapDefaultCaseSensitive};
+  entries.reserve(FLAGS_entries);
+  for (uint64_t i = 0; i < FLAGS_entries; ++i) {
+    auto name = paddedNumber(i, FLAGS_nameLength);
+    auto hash = paddedNumber(i, FLAGS_hashLength);
+    entries.emplace(
+        PathComponent{name},
+        ObjectId{folly::ByteRange{folly::StringPiece{hash}}},
+        i % 10 == 0 ? TreeEntryType::TREE : TreeEntryType::REGULAR_FILE);
+  }
+  return std::make_shared<const Tree>(std::move(entries), ObjectId{});
+}
+
+void benchmarkBuildDirFromTree() {
+  // Loading a TreeInode for an unmaterialized source control directory builds
+  // its DirContents from the Tree. Directories like node_modules or vendored
+  // third-party code are rarely materialized, so this is what most of the
+  // loaded directories of a large mount look like in memory.
+  auto tempDir = makeTempDir();
+  auto overlay = Overlay::create(
+      canonicalPath(tempDir.path().string()),
+      kPathMapDefaultCaseSensitive,
+      InodeCatalogType::InMemory,
+      kDefaultInodeCatalogOptions,
+      std::make_shared<NullStructuredLogger>(),
+      makeRefPtr<EdenStats>(),
+      true,
+      *EdenConfig::createTestEdenConfig());
+  overlay->initialize(EdenConfig::createTestEdenConfig()).get();
+
+  auto tree = makeTree();
+
+  folly::stop_watch<> timer;
+  auto contents = TreeInode::buildDirFromTree(
+      tree.get(), overlay.get(), kPathMapDefaultCaseSensitive, false);
+  auto elapsed = timer.elapsed();
+
+  auto treeSize = tree->getSizeBytes();
+  auto contentsSize = estimateDirContentsSize(contents);
+  printf(
+      "Built DirContents of %zu entries in %.2f ms\n",
+      contents.size(),
+      std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(
+          elapsed)
+          .count());
+  printf(
+      "sizeof(DirEntry): %zu, sizeof(DirContents::value_type): %zu\n",
+      sizeof(DirEntry),
+      sizeof(DirContents::value_type));
+  printf(
+      "Tree: %zu bytes (%.1f per entry)\n",
+      treeSize,
+      static_cast<double>(treeSize) / tree->size());
+  printf(
+      "DirContents: %zu bytes (%.1f per entry, capacity %zu)\n",
+      contentsSize,
+      static_cast<double>(contentsSize) / contents.size(),
+      contents.capacity());
+
+  overlay->close();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  folly::init(&argc, &argv);
+
+  if (FLAGS_entries == 0) {
+    fprintf(stderr, "error: entries must be positive\n");
+    return 1;
+  }
+
+  benchmarkBuildDirFromTree();
+
+  return 0;
+}
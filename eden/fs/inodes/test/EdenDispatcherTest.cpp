@@ -9,9 +9,12 @@
 
 #include "eden/fs/fuse/FuseDispatcher.h"
 
+#include <map>
+
 #include <folly/experimental/TestUtil.h>
 #include <folly/portability/GTest.h>
 #include <folly/test/TestUtils.h>
+#include "eden/fs/fuse/FuseDirList.h"
 #include "eden/fs/model/Blob.h"
 #include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/testharness/FakeTreeBuilder.h"
@@ -162,4 +165,47 @@ TEST(RawEdenDispatcherTest, lookup_returns_valid_inode_for_bad_file) {
   EXPECT_EQ(entry.nodeid, entry.attr.ino);
 }
 
+TEST(RawEdenDispatcherTest, readdirplus_returns_entry_params) {
+  FakeTreeBuilder builder;
+  builder.setFile("file", "contents");
+  builder.setFile("dir/child", "contents");
+  TestMount mount{builder};
+
+  auto list = mount.getDispatcher()
+                  ->readdirplus(
+                      kRootNodeId,
+                      FuseDirList{4096, /*plus=*/true},
+                      0,
+                      0,
+                      ObjectFetchContext::getNullContext())
+                  .get(0ms);
+
+  auto buf = list.getBuf();
+  auto entries = list.extract();
+  size_t offset = 0;
+  std::map<std::string, fuse_entry_out> entryParams;
+  for (const auto& entry : entries) {
+    fuse_entry_out entryParam;
+    memcpy(&entryParam, buf.data() + offset, sizeof(entryParam));
+    entryParams[entry.name] = entryParam;
+    offset += FUSE_DIRENT_ALIGN(
+        sizeof(fuse_entry_out) + FUSE_NAME_OFFSET + entry.name.size());
+  }
+  EXPECT_EQ(buf.size(), offset);
+
+  ASSERT_EQ(4, entryParams.size());
+  EXPECT_EQ(0, entryParams["."].nodeid);
+  EXPECT_EQ(0, entryParams[".."].nodeid);
+
+  auto file = mount.getFileInode("file");
+  EXPECT_EQ(file->getNodeId().get(), entryParams["file"].nodeid);
+  EXPECT_EQ(8, entryParams["file"].attr.size);
+  EXPECT_EQ(1, file->debugGetFsRefcount());
+
+  auto dir = mount.getTreeInode("dir");
+  EXPECT_EQ(dir->getNodeId().get(), entryParams["dir"].nodeid);
+  EXPECT_TRUE(S_ISDIR(entryParams["dir"].attr.mode));
+  EXPECT_EQ(1, dir->debugGetFsRefcount());
+}
+
 #endif
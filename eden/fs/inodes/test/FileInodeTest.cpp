@@ -15,6 +15,8 @@
 #include <folly/test/TestUtils.h>
 #include <chrono>
 
+#include "eden/fs/inodes/InodeTable.h"
+#include "eden/fs/inodes/Overlay.h"
 #include "eden/fs/inodes/TreeInode.h"
 #include "eden/fs/store/IObjectStore.h"
 #include "eden/fs/testharness/FakeBackingStore.h"
@@ -677,6 +679,66 @@ TEST(FileInode, dropsCacheWhenMaterialized) {
   EXPECT_FALSE(blobCache->contains(hash));
 }
 
+TEST(FileInode, readsAfterWriteReturnTheWrittenData) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"bigfile.txt", "1234567890ab"}});
+  TestMount mount{builder};
+
+  auto inode = mount.getFileInode("bigfile.txt");
+  auto read = [&](size_t size, FileOffset off) {
+    auto result =
+        inode->read(size, off, ObjectFetchContext::getNullContext()).get(0ms);
+    return std::get<0>(result)->moveToFbString();
+  };
+
+  // The second read is served from the blob cached by the first one.
+  EXPECT_EQ("1234", read(4, 0));
+  EXPECT_EQ("5678", read(4, 4));
+
+  inode->write("data"_sp, 4, ObjectFetchContext::getNullContext()).get(0ms);
+  EXPECT_EQ("data", read(4, 4));
+}
+
+TEST(FileInode, readsShareTheBlobBuffer) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"bigfile.txt", "1234567890ab"}});
+  TestMount mount{builder};
+
+  auto inode = mount.getFileInode("bigfile.txt");
+  auto result =
+      inode->read(4, 4, ObjectFetchContext::getNullContext()).get(0ms);
+  auto& data = std::get<0>(result);
+  EXPECT_EQ("5678", data->cloneCoalescedAsValue().moveToFbString());
+  // The data was sliced out of the blob rather than copied.
+  EXPECT_TRUE(data->isShared());
+}
+
+TEST(FileInode, stopsServingBlobEvictedFromCache) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"bigfile.txt", "1234567890ab"}});
+  TestMount mount{builder};
+  auto blobCache = mount.getBlobCache();
+
+  auto inode = mount.getFileInode("bigfile.txt");
+  auto hash = inode->getObjectId().value();
+  auto read = [&](size_t size, FileOffset off) {
+    auto result =
+        inode->read(size, off, ObjectFetchContext::getNullContext()).get(0ms);
+    return std::get<0>(result)->moveToFbString();
+  };
+
+  EXPECT_EQ("1234", read(4, 0));
+  blobCache->clear();
+
+  // Served by the blob the inode still holds, which it then drops.
+  EXPECT_EQ("5678", read(4, 4));
+  EXPECT_FALSE(blobCache->contains(hash));
+
+  // So the next read loads the blob into the cache again.
+  EXPECT_EQ("90ab", read(4, 8));
+  EXPECT_TRUE(blobCache->contains(hash));
+}
+
 TEST(FileInode, dropsCacheWhenUnloaded) {
   FakeTreeBuilder builder;
   builder.setFiles({{"bigfile.txt", "1234567890ab"}});
@@ -712,6 +774,135 @@ TEST(FileInode, reloadsBlobIfCacheIsEvicted) {
       << "reading should insert hash " << hash << " into cache";
 }
 
+TEST(FileInode, overlayIoThreads) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"file.txt", "1234567890ab"}});
+  TestMount mount;
+  mount.updateEdenConfig({{"overlay:io-threads", "2"}});
+  mount.initialize(builder);
+
+  auto inode = mount.getFileInode("file.txt");
+  // The first write materializes the file, the second goes to the IO threads.
+  inode->write("abcd"_sp, 0, ObjectFetchContext::getNullContext()).get(1s);
+  inode->write("efgh"_sp, 4, ObjectFetchContext::getNullContext()).get(1s);
+  inode->fsync(/*datasync=*/true).get(1s);
+
+  auto result =
+      inode->read(12, 0, ObjectFetchContext::getNullContext()).get(1s);
+  auto& data = std::get<0>(result);
+  EXPECT_EQ("abcdefgh90ab", data->cloneCoalescedAsValue().moveToFbString());
+
+  auto attr = getFileAttr(mount, inode);
+  EXPECT_EQ(12, attr.st_size);
+}
+
+TEST(FileInode, overlayIoThreadsKeepWritesInOrder) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"file.txt", "1234567890ab"}});
+  TestMount mount;
+  mount.updateEdenConfig({{"overlay:io-threads", "4"}});
+  mount.initialize(builder);
+
+  auto inode = mount.getFileInode("file.txt");
+  inode->write("abcd"_sp, 0, ObjectFetchContext::getNullContext()).get(1s);
+
+  std::vector<ImmediateFuture<size_t>> writes;
+  for (char c = 'a'; c <= 'z'; ++c) {
+    writes.push_back(inode->write(
+        std::string(4, c), 0, ObjectFetchContext::getNullContext()));
+  }
+  DesiredMetadata desired;
+  desired.size = 2;
+  auto attr =
+      inode->setattr(desired, ObjectFetchContext::getNullContext()).get(1s);
+  for (auto& write : writes) {
+    std::move(write).get(1s);
+  }
+  EXPECT_EQ(2, attr.st_size);
+
+  auto result =
+      inode->read(12, 0, ObjectFetchContext::getNullContext()).get(1s);
+  auto& data = std::get<0>(result);
+  EXPECT_EQ("zz", data->cloneCoalescedAsValue().moveToFbString());
+}
+
+TEST(FileInode, sparseMaterialization) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"file.txt", "1234567890ab"}});
+  TestMount mount;
+  mount.updateEdenConfig({{"overlay:sparse-materialization-min-size", "1"}});
+  mount.initialize(builder);
+
+  auto readAll = [&] {
+    auto inode = mount.getFileInode("file.txt");
+    auto result =
+        inode->read(12, 0, ObjectFetchContext::getNullContext()).get(1s);
+    return std::get<0>(result)->cloneCoalescedAsValue().moveToFbString();
+  };
+
+  {
+    auto inode = mount.getFileInode("file.txt");
+    inode->write("cd"_sp, 2, ObjectFetchContext::getNullContext()).get(1s);
+  }
+  // Only the written range comes from the overlay file.
+  EXPECT_EQ("12cd567890ab", readAll());
+
+  // The rest of the blob is written out when the overlay is closed.
+  mount.remount();
+  EXPECT_EQ("12cd567890ab", readAll());
+
+  auto inode = mount.getFileInode("file.txt");
+  EXPECT_EQ(
+      Hash20::sha1(folly::ByteRange{"12cd567890ab"_sp}),
+      inode->getSha1(ObjectFetchContext::getNullContext()).get(1s));
+}
+
+TEST(FileInode, persistedContentHash) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"file.txt", "1234567890ab"}});
+  TestMount mount;
+  mount.updateEdenConfig({{"overlay:persist-content-hashes", "true"}});
+  mount.initialize(builder);
+
+  auto getSha1 = [&] {
+    return mount.getFileInode("file.txt")
+        ->getSha1(ObjectFetchContext::getNullContext())
+        .get(1s);
+  };
+  auto getRecord = [&] {
+    auto ino = mount.getFileInode("file.txt")->getNodeId();
+    return mount.getEdenMount()
+        ->getOverlay()
+        ->getInodeContentHashTable()
+        ->getOptional(ino);
+  };
+
+  mount.getFileInode("file.txt")
+      ->write("cd"_sp, 2, ObjectFetchContext::getNullContext())
+      .get(1s);
+  auto sha1 = Hash20::sha1(folly::ByteRange{"12cd567890ab"_sp});
+  EXPECT_EQ(sha1, getSha1());
+  auto record = getRecord();
+  ASSERT_TRUE(record.has_value());
+  EXPECT_EQ(sha1, record->sha1);
+
+  // After a restart, the recorded hash is used as long as the file did not
+  // change.
+  mount.remount();
+  auto bogus = Hash20::sha1(folly::ByteRange{"bogus"_sp});
+  record->sha1 = bogus;
+  mount.getEdenMount()->getOverlay()->getInodeContentHashTable()->set(
+      mount.getFileInode("file.txt")->getNodeId(), *record);
+  EXPECT_EQ(bogus, getSha1());
+
+  // Writing to the file forgets it.
+  mount.getFileInode("file.txt")
+      ->write("ef"_sp, 4, ObjectFetchContext::getNullContext())
+      .get(1s);
+  EXPECT_FALSE(getRecord().has_value());
+  EXPECT_EQ(Hash20::sha1(folly::ByteRange{"12cdef7890ab"_sp}), getSha1());
+}
+
 // TODO: test multiple flags together
 // TODO: ensure ctime is updated after every call to setattr()
 // TODO: ensure mtime is updated after opening a file, writing to it, then
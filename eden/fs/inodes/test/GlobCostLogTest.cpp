@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/GlobCostLog.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+
+namespace {
+GlobCost makeCost(std::string request, uint64_t directoriesVisited) {
+  GlobCost cost;
+  cost.request = std::move(request);
+  cost.directoriesVisited = directoriesVisited;
+  return cost;
+}
+
+std::vector<std::string> getRequests(const GlobCostLog& log) {
+  std::vector<std::string> requests;
+  for (const auto& cost : log.getMostExpensive()) {
+    requests.push_back(cost.request);
+  }
+  return requests;
+}
+} // namespace
+
+TEST(GlobCostLogTest, keepsMostExpensiveGlobs) {
+  GlobCostLog log{3};
+  EXPECT_TRUE(log.getMostExpensive().empty());
+
+  log.record(makeCost("a", 10));
+  log.record(makeCost("b", 1));
+  log.record(makeCost("c", 100));
+  EXPECT_EQ((std::vector<std::string>{"c", "a", "b"}), getRequests(log));
+
+  // Cheaper than all of the globs kept.
+  log.record(makeCost("d", 0));
+  EXPECT_EQ((std::vector<std::string>{"c", "a", "b"}), getRequests(log));
+
+  log.record(makeCost("e", 50));
+  log.record(makeCost("f", 1000));
+  EXPECT_EQ((std::vector<std::string>{"f", "c", "e"}), getRequests(log));
+}
@@ -17,8 +17,10 @@
 #include <folly/portability/GTest.h>
 #include <folly/test/TestUtils.h>
 
+#include "eden/fs/inodes/GlobResultCache.h"
 #include "eden/fs/inodes/TreeInode.h"
 #include "eden/fs/model/TestOps.h"
+#include "eden/fs/store/StatsFetchContext.h"
 #include "eden/fs/testharness/FakeBackingStore.h"
 #include "eden/fs/testharness/FakeTreeBuilder.h"
 #include "eden/fs/testharness/TestChecks.h"
@@ -225,6 +227,45 @@ TEST_P(GlobNodeTest, starStarBeginning) {
   EXPECT_EQ(expect, matches);
 }
 
+TEST_P(GlobNodeTest, manyRecursivePatterns) {
+  // Mix patterns that are looked up by basename with one that is matched.
+  GlobNode globRoot(
+      /*includeDotfiles=*/false, mount_.getConfig()->getCaseSensitive());
+  globRoot.parse("**/*.txt");
+  globRoot.parse("**/b.txt");
+  globRoot.parse("**/.watchmanconfig");
+  globRoot.parse("**/root");
+  globRoot.parse("**/s?b");
+
+  auto matches = doGlob(globRoot, kZeroRootId);
+  std::vector<GlobResult> expect{
+      GlobResult(".watchmanconfig"_relpath, dtype_t::Regular, kZeroRootId),
+      GlobResult("dir/a.txt"_relpath, dtype_t::Regular, kZeroRootId),
+      GlobResult("dir/sub"_relpath, dtype_t::Dir, kZeroRootId),
+      GlobResult("dir/sub/b.txt"_relpath, dtype_t::Regular, kZeroRootId),
+  };
+  EXPECT_EQ(expect, matches);
+}
+
+TEST_P(GlobNodeTest, evaluateOnExecutor) {
+  GlobNode globRoot(
+      /*includeDotfiles=*/true, mount_.getConfig()->getCaseSensitive());
+  globRoot.parse("dir/*");
+  globRoot.parse("**/*.txt");
+  globRoot.setExecutor(mount_.getServerExecutor(), 1);
+
+  auto matches = doGlob(globRoot, kZeroRootId);
+  std::sort(matches.begin(), matches.end());
+  std::vector<GlobResult> expect{
+      GlobResult("dir/a.txt"_relpath, dtype_t::Regular, kZeroRootId),
+      GlobResult("dir/sub"_relpath, dtype_t::Dir, kZeroRootId),
+      GlobResult("dir/sub/b.txt"_relpath, dtype_t::Regular, kZeroRootId),
+  };
+  // dir/a.txt is matched by both patterns.
+  matches.erase(std::unique(matches.begin(), matches.end()), matches.end());
+  EXPECT_EQ(expect, matches);
+}
+
 #ifndef _WIN32
 TEST_P(GlobNodeTest, recursiveTxtWithChanges) {
   // Ensure that we enumerate things from the overlay
@@ -479,3 +520,63 @@ TEST(GlobNodeTest, testCaseInsensitive) {
   };
   EXPECT_EQ(expect, matches);
 }
+
+TEST(GlobNodeTest, resultCache) {
+  auto mount = TestMount{};
+  auto builder = FakeTreeBuilder{};
+  builder.setFiles(
+      {{"dir/a.txt", "a"}, {"dir/sub/b.txt", "b"}, {"dir/sub/c.h", "c"}});
+  mount.initialize(builder, /*startReady=*/true);
+
+  auto objectStore = mount.getEdenMount()->getObjectStore();
+  auto rootTree =
+      objectStore
+          ->getRootTree(
+              mount.getEdenMount()->getCheckedOutRootId(),
+              ObjectFetchContext::getNullContext())
+          .get(kSmallTimeout);
+  auto cache = std::make_shared<GlobResultCache>(100);
+
+  auto glob = [&](uint64_t& treeFetches) {
+    GlobNode globRoot(
+        /*includeDotfiles=*/false, mount.getConfig()->getCaseSensitive());
+    globRoot.parse("dir/**/*.txt");
+    globRoot.parse("dir/sub/*.h");
+    globRoot.setResultCache(cache);
+
+    auto context = makeRefPtr<StatsFetchContext>();
+    GlobNode::PrefetchList prefetchList;
+    GlobNode::ResultList results;
+    globRoot
+        .evaluate(
+            objectStore,
+            context.as<ObjectFetchContext>(),
+            RelativePathPiece(),
+            rootTree,
+            &prefetchList,
+            results,
+            kZeroRootId)
+        .get(kSmallTimeout);
+    treeFetches = context->countFetchesOfType(ObjectFetchContext::Tree);
+
+    auto matches = std::move(*results.wlock());
+    std::sort(matches.begin(), matches.end());
+    EXPECT_EQ(3, prefetchList.rlock()->size());
+    return matches;
+  };
+
+  std::vector<GlobResult> expect{
+      GlobResult("dir/a.txt"_relpath, dtype_t::Regular, kZeroRootId),
+      GlobResult("dir/sub/b.txt"_relpath, dtype_t::Regular, kZeroRootId),
+      GlobResult("dir/sub/c.h"_relpath, dtype_t::Regular, kZeroRootId),
+  };
+
+  uint64_t firstTreeFetches = 0;
+  EXPECT_EQ(expect, glob(firstTreeFetches));
+  EXPECT_NE(0, firstTreeFetches);
+
+  // The same patterns against the same tree are answered from the cache.
+  uint64_t secondTreeFetches = 0;
+  EXPECT_EQ(expect, glob(secondTreeFetches));
+  EXPECT_EQ(0, secondTreeFetches);
+}
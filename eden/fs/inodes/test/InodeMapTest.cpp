@@ -558,6 +558,47 @@ TEST(InodeMap, unloadedFileMetadataIsForgotten) {
   EXPECT_FALSE(mount.hasMetadata(file1ino));
   EXPECT_FALSE(mount.hasMetadata(file2ino));
 }
+
+TEST(InodeMap, estimateMemoryUsageCountsLoadedInodes) {
+  FakeTreeBuilder builder;
+  builder.setFile("dir/file.txt", "contents");
+  TestMount mount{builder};
+  auto inodeMap = mount.getEdenMount()->getInodeMap();
+
+  auto before = inodeMap->estimateMemoryUsage();
+  EXPECT_GE(before, sizeof(TreeInode));
+
+  auto file = mount.getFileInode("dir/file.txt"_relpath);
+  EXPECT_GE(
+      inodeMap->estimateMemoryUsage(),
+      before + sizeof(TreeInode) + sizeof(FileInode));
+}
+
+TEST(InodeMap, decFsRefcountsOfLoadedAndUnloadedInodes) {
+  FakeTreeBuilder builder;
+  builder.setFile("dir1/file.txt", "contents");
+  builder.setFile("dir2/file.txt", "contents");
+  TestMount mount{builder};
+  auto inodeMap = mount.getEdenMount()->getInodeMap();
+
+  auto file1 = mount.getFileInode("dir1/file.txt"_relpath);
+  auto file1ino = file1->getNodeId();
+  file1->incFsRefcount(3);
+
+  auto file2ino = mount.getFileInode("dir2/file.txt"_relpath)->getNodeId();
+  mount.getFileInode("dir2/file.txt"_relpath)->incFsRefcount();
+  mount.getTreeInode("dir2"_relpath)->unloadChildrenNow();
+  EXPECT_FALSE(inodeMap->lookupLoadedInode(file2ino));
+  EXPECT_EQ(1, inodeMap->getInodeCounts().unloadedInodeCount);
+
+  std::vector<std::pair<InodeNumber, uint32_t>> forgets{
+      {file1ino, 2}, {file2ino, 1}};
+  inodeMap->decFsRefcounts(forgets);
+
+  EXPECT_EQ(1, file1->debugGetFsRefcount());
+  // The unloaded inode was unreferenced, and so forgotten.
+  EXPECT_EQ(0, inodeMap->getInodeCounts().unloadedInodeCount);
+}
 #endif
 
 struct InodePersistenceTreeTest : ::testing::Test {
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/init/Init.h>
+#include <folly/memory/Malloc.h>
+#include <folly/memory/MallctlHelper.h>
+#include <folly/portability/GFlags.h>
+#include <deque>
+#include <vector>
+
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/testharness/SyntheticBackingStore.h"
+#include "eden/fs/testharness/TestMount.h"
+
+using namespace facebook::eden;
+
+DEFINE_uint32(depth, 2, "Depth of the synthetic repository");
+DEFINE_uint32(fanOut, 32, "Subdirectories in every directory above the leaves");
+DEFINE_uint32(
+    filesPerDir,
+    32,
+    "Files in every directory. A second repository with twice as many is "
+    "loaded to separate the per-directory and per-entry costs.");
+
+DEFINE_double(maxTreeBytes, 0, "Fail above this many bytes per Tree");
+DEFINE_double(maxTreeEntryBytes, 0, "Fail above this many bytes per entry");
+DEFINE_double(maxTreeInodeBytes, 0, "Fail above this many bytes per TreeInode");
+DEFINE_double(maxDirEntryBytes, 0, "Fail above this many bytes per DirEntry");
+DEFINE_double(maxFileInodeBytes, 0, "Fail above this many bytes per FileInode");
+
+namespace {
+
+/**
+ * The number of bytes currently allocated, according to jemalloc.
+ */
+int64_t allocatedBytes() {
+  // Flush this thread's cache, and refresh the statistics.
+  folly::mallctlCall("thread.tcache.flush");
+  folly::mallctlWrite<uint64_t>("epoch", 1);
+  size_t allocated = 0;
+  folly::mallctlRead("stats.allocated", &allocated);
+  return static_cast<int64_t>(allocated);
+}
+
+/**
+ * Runs an asynchronous operation of the mount to completion.
+ */
+template <typename T>
+T run(TestMount& mount, ImmediateFuture<T> future) {
+  auto* executor = mount.getServerExecutor().get();
+  return std::move(future).semi().via(executor).getVia(executor);
+}
+
+struct Shape {
+  std::vector<ObjectId> treeIds;
+  std::vector<RelativePath> directories;
+  std::vector<RelativePath> files;
+  // The entries of every tree, and of every directory but the root.
+  size_t treeEntries = 0;
+  size_t dirEntries = 0;
+};
+
+Shape walk(SyntheticBackingStore& store) {
+  const auto& context = ObjectFetchContext::getNullContext();
+  Shape shape;
+  std::deque<std::pair<RelativePath, TreePtr>> pending;
+  pending.emplace_back(
+      RelativePath{}, store.getRootTree(RootId{"1"}, context).get());
+  while (!pending.empty()) {
+    auto [path, tree] = std::move(pending.front());
+    pending.pop_front();
+    shape.treeIds.push_back(tree->getHash());
+    shape.treeEntries += tree->size();
+    if (!path.empty()) {
+      shape.directories.push_back(path);
+      shape.dirEntries += tree->size();
+    }
+    for (const auto& [name, entry] : *tree) {
+      if (entry.isTree()) {
+        pending.emplace_back(
+            path + name, store.getTree(entry.getHash(), context).get().tree);
+      } else {
+        shape.files.push_back(path + name);
+      }
+    }
+  }
+  return shape;
+}
+
+struct Footprint {
+  Shape shape;
+  int64_t trees = 0;
+  int64_t treeInodes = 0;
+  int64_t fileInodes = 0;
+};
+
+Footprint measure(uint32_t filesPerDir) {
+  SyntheticBackingStore::Options options;
+  options.maxDepth = FLAGS_depth;
+  options.fanOut = FLAGS_fanOut;
+  options.filesPerDir = filesPerDir;
+  auto store = std::make_shared<SyntheticBackingStore>(options);
+  const auto& context = ObjectFetchContext::getNullContext();
+
+  Footprint footprint;
+  footprint.shape = walk(*store);
+  const auto& shape = footprint.shape;
+
+  {
+    std::vector<TreePtr> trees;
+    trees.reserve(shape.treeIds.size());
+    auto before = allocatedBytes();
+    for (const auto& id : shape.treeIds) {
+      trees.push_back(store->getTree(id, context).get().tree);
+    }
+    footprint.trees = allocatedBytes() - before;
+  }
+
+  TestMount mount;
+  mount.initialize(store, RootId{"1"});
+
+  // Fill the object store's caches first, so that loading inodes doesn't
+  // grow them.
+  auto objectStore = mount.getEdenMount()->getObjectStore();
+  for (const auto& id : shape.treeIds) {
+    run(mount, objectStore->getTree(id, context));
+  }
+
+  auto before = allocatedBytes();
+  for (const auto& directory : shape.directories) {
+    mount.getTreeInode(directory);
+  }
+  footprint.treeInodes = allocatedBytes() - before;
+
+  before = allocatedBytes();
+  for (const auto& file : shape.files) {
+    mount.getFileInode(file);
+  }
+  footprint.fileInodes = allocatedBytes() - before;
+
+  return footprint;
+}
+
+/**
+ * Splits the bytes allocated for objects that each hold some entries into a
+ * fixed cost per object and a cost per entry, from two samples of the same
+ * objects with different entry counts.
+ */
+std::pair<double, double> split(
+    size_t objects,
+    int64_t bytes1,
+    size_t entries1,
+    int64_t bytes2,
+    size_t entries2) {
+  auto perEntry = static_cast<double>(bytes2 - bytes1) /
+      static_cast<double>(entries2 - entries1);
+  auto perObject = (bytes1 - perEntry * entries1) / objects;
+  return {perObject, perEntry};
+}
+
+bool report(const char* name, double bytes, double max) {
+  bool regressed = max > 0 && bytes > max;
+  printf(
+      "%-12s %10.1f bytes%s\n", name, bytes, regressed ? "  REGRESSED" : "");
+  return !regressed;
+}
+
+} // namespace
+
+/*
+ * Reports the memory used per loaded inode and cached tree of a synthetic
+ * repository, as measured by jemalloc, and fails if any exceeds its --max
+ * flag.
+ */
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  if (!folly::usingJEMalloc()) {
+    fprintf(stderr, "This benchmark must be linked with jemalloc\n");
+    return 1;
+  }
+
+  auto small = measure(FLAGS_filesPerDir);
+  auto large = measure(2 * FLAGS_filesPerDir);
+
+  auto [tree, treeEntry] = split(
+      small.shape.treeIds.size(),
+      small.trees,
+      small.shape.treeEntries,
+      large.trees,
+      large.shape.treeEntries);
+  auto [treeInode, dirEntry] = split(
+      small.shape.directories.size(),
+      small.treeInodes,
+      small.shape.dirEntries,
+      large.treeInodes,
+      large.shape.dirEntries);
+  auto fileInode = static_cast<double>(large.fileInodes) /
+      static_cast<double>(large.shape.files.size());
+
+  printf(
+      "%zu directories of %u and %u files\n",
+      small.shape.treeIds.size(),
+      FLAGS_filesPerDir,
+      2 * FLAGS_filesPerDir);
+  bool ok = true;
+  ok &= report("Tree", tree, FLAGS_maxTreeBytes);
+  ok &= report("TreeEntry", treeEntry, FLAGS_maxTreeEntryBytes);
+  ok &= report("TreeInode", treeInode, FLAGS_maxTreeInodeBytes);
+  ok &= report("DirEntry", dirEntry, FLAGS_maxDirEntryBytes);
+  ok &= report("FileInode", fileInode, FLAGS_maxFileInodeBytes);
+  return ok ? 0 : 1;
+}
@@ -291,3 +291,27 @@ TEST(InodePtr, baseCasting) {
   }
   EXPECT_REFCOUNT(kRootRefCount + 1, rootPtr);
 }
+
+TEST(InodePtr, borrowedChild) {
+  FakeTreeBuilder builder;
+  builder.setFile("src/main.c", "int main() {}\n");
+  TestMount testMount{builder};
+  auto rootPtr = testMount.getEdenMount()->getRootInode();
+  auto srcPtr = testMount.getTreeInode("src");
+  auto srcRefCount = InodePtrTestHelper::getRefcount(srcPtr);
+
+  auto contents = rootPtr->getContents().rlock();
+  auto borrowed = contents->entries.find(PathComponentPiece{"src"})
+                      ->second.borrowTreeOrNull();
+  ASSERT_TRUE(borrowed);
+  EXPECT_EQ(srcPtr.get(), borrowed.get());
+  EXPECT_REFCOUNT(srcRefCount, srcPtr);
+
+  {
+    auto copied = borrowed.copy();
+    EXPECT_EQ(srcPtr.get(), copied.get());
+    EXPECT_REFCOUNT(srcRefCount + 1, srcPtr);
+  }
+  EXPECT_REFCOUNT(srcRefCount, srcPtr);
+  EXPECT_FALSE(BorrowedInodePtr<TreeInode>{});
+}
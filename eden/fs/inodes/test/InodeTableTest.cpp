@@ -164,6 +164,55 @@ TEST_F(InodeTableTest, setDefault) {
   EXPECT_EQ(14, inodeTable->setDefault(1_ino, 16));
 }
 
+TEST_F(InodeTableTest, sparse_and_dense_inode_numbers) {
+  // Inode numbers far past the number of records aren't direct-indexed, but
+  // must behave the same.
+  auto far = InodeNumber{1000000};
+  {
+    auto inodeTable = InodeTable<Int>::open(tablePath);
+    inodeTable->set(far, 1);
+    for (uint64_t i = 1; i <= 3000; ++i) {
+      inodeTable->set(InodeNumber{i}, static_cast<int>(i));
+    }
+    inodeTable->freeInode(2_ino);
+    inodeTable->freeInode(InodeNumber{2999});
+  }
+
+  auto inodeTable = InodeTable<Int>::open(tablePath);
+  EXPECT_EQ(1, inodeTable->getOrThrow(far));
+  EXPECT_EQ(1, inodeTable->getOrThrow(1_ino));
+  EXPECT_EQ(std::nullopt, inodeTable->getOptional(2_ino));
+  EXPECT_EQ(2998, inodeTable->getOrThrow(InodeNumber{2998}));
+  EXPECT_EQ(std::nullopt, inodeTable->getOptional(InodeNumber{2999}));
+  EXPECT_EQ(3000, inodeTable->getOrThrow(InodeNumber{3000}));
+  EXPECT_EQ(std::nullopt, inodeTable->getOptional(InodeNumber{3001}));
+
+  size_t count = 0;
+  inodeTable->forEachModify([&](const InodeNumber& ino, Int& record) {
+    EXPECT_EQ(ino == far ? 1 : static_cast<int>(ino.get()), record.value);
+    ++count;
+  });
+  EXPECT_EQ(2999, count);
+}
+
+TEST_F(InodeTableTest, freeing_inodes_shrinks_the_file) {
+  auto inodeTable = InodeTable<Int>::open(tablePath);
+  constexpr uint64_t N = 1000000;
+  for (uint64_t i = 1; i <= N; ++i) {
+    inodeTable->set(InodeNumber{i}, 0);
+  }
+  struct stat st;
+  ASSERT_EQ(0, stat(tablePath.c_str(), &st));
+  auto fullSize = st.st_size;
+
+  for (uint64_t i = 2; i <= N; ++i) {
+    inodeTable->freeInode(InodeNumber{i});
+  }
+  ASSERT_EQ(0, stat(tablePath.c_str(), &st));
+  EXPECT_LT(st.st_size, fullSize / 10);
+  EXPECT_EQ(0, inodeTable->getOrThrow(1_ino));
+}
+
 // TEST(INodeTable, set) {}
 // TEST(INodeTable, getOrThrow) {}
 // TEST(INodeTable, getOptional) {}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/KernelCacheTracker.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+constexpr auto kLookup = KernelCacheTracker::Request::Lookup;
+constexpr auto kGetattr = KernelCacheTracker::Request::Getattr;
+} // namespace
+
+TEST(KernelCacheTrackerTest, counts_requests_repeated_within_window) {
+  KernelCacheTracker tracker{1, 100, 1s};
+  InodeNumber ino{42};
+  ASSERT_TRUE(tracker.isSampled(ino));
+
+  KernelCacheTracker::Clock::time_point start{10s};
+  EXPECT_FALSE(tracker.recordRequest(ino, kGetattr, start));
+  EXPECT_TRUE(tracker.recordRequest(ino, kGetattr, start + 500ms));
+  // The window starts again from each request.
+  EXPECT_TRUE(tracker.recordRequest(ino, kGetattr, start + 1400ms));
+  EXPECT_FALSE(tracker.recordRequest(ino, kGetattr, start + 3s));
+
+  // Lookups are tracked separately from getattrs.
+  EXPECT_FALSE(tracker.recordRequest(ino, kLookup, start + 3s));
+  EXPECT_TRUE(tracker.recordRequest(ino, kLookup, start + 3s));
+}
+
+TEST(KernelCacheTrackerTest, counts_bytes_read_again) {
+  KernelCacheTracker tracker{1, 100, 1s};
+  InodeNumber ino{42};
+
+  EXPECT_EQ(0, tracker.recordRead(ino, 0, 4096));
+  EXPECT_EQ(0, tracker.recordRead(ino, 4096, 4096));
+  EXPECT_EQ(8192, tracker.recordRead(ino, 0, 8192));
+  EXPECT_EQ(4096, tracker.recordRead(ino, 4096, 8192));
+  EXPECT_EQ(0, tracker.recordRead(InodeNumber{43}, 0, 4096));
+}
+
+TEST(KernelCacheTrackerTest, forgets_least_recent_inodes) {
+  KernelCacheTracker tracker{1, 2, 1s};
+  EXPECT_EQ(0, tracker.recordRead(InodeNumber{1}, 0, 10));
+  EXPECT_EQ(0, tracker.recordRead(InodeNumber{2}, 0, 10));
+  EXPECT_EQ(0, tracker.recordRead(InodeNumber{3}, 0, 10));
+  EXPECT_EQ(10, tracker.recordRead(InodeNumber{3}, 0, 10));
+  EXPECT_EQ(0, tracker.recordRead(InodeNumber{1}, 0, 10));
+}
+
+TEST(KernelCacheTrackerTest, samples_a_fraction_of_inodes) {
+  KernelCacheTracker disabled{0, 100, 1s};
+  KernelCacheTracker tracker{16, 100, 1s};
+  size_t sampled = 0;
+  for (uint64_t ino = 1; ino <= 16000; ++ino) {
+    EXPECT_FALSE(disabled.isSampled(InodeNumber{ino}));
+    sampled += tracker.isSampled(InodeNumber{ino});
+  }
+  EXPECT_GT(sampled, 500);
+  EXPECT_LT(sampled, 1500);
+}
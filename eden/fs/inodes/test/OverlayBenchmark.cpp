@@ -5,6 +5,7 @@
  * GNU General Public License version 2.
  */
 
+#include <fmt/format.h>
 #include <folly/init/Init.h>
 #include <folly/portability/GFlags.h>
 #include <folly/stop_watch.h>
@@ -25,6 +26,15 @@ DEFINE_string(
     overlayType,
     kDefaultInodeCatalogType == InodeCatalogType::Sqlite ? "Sqlite" : "Legacy",
     "Type of overlay to be used. Defaults: Windows - Sqlite; Linux|macOS - Legacy");
+DEFINE_uint64(
+    dirEntries,
+    10000,
+    "Number of files created in a single directory by the directory benchmark");
+DEFINE_bool(
+    appendDirChanges,
+    false,
+    "Whether legacy overlays append directory changes instead of rewriting "
+    "the directory (overlay:append-dir-changes)");
 
 namespace {
 
@@ -110,6 +120,64 @@ void benchmarkOverlayTreeWrites(
           .count());
 }
 
+void benchmarkOverlayDirCreates(
+    AbsolutePathPiece overlayPath,
+    InodeCatalogType overlayType) {
+  // Creating many files in a single directory, as untarring an archive or
+  // generating code does, changes the directory once per file. Unless the
+  // overlay supports recording individual changes, each of those rewrites
+  // the whole directory.
+  auto config = EdenConfig::createTestEdenConfig();
+  config->overlayAppendDirChanges.setValue(
+      FLAGS_appendDirChanges, ConfigSourceType::CommandLine, true);
+
+  auto overlay = Overlay::create(
+      overlayPath,
+      kPathMapDefaultCaseSensitive,
+      overlayType,
+      kDefaultInodeCatalogOptions,
+      std::make_shared<NullStructuredLogger>(),
+      makeRefPtr<EdenStats>(),
+      true,
+      *config);
+  overlay->initialize(config).get();
+
+  ObjectId hash{folly::ByteRange{"abcdabcdabcdabcdabcd"_sp}};
+
+  auto dirIno = overlay->allocateInodeNumber();
+  DirContents contents(kPathMapDefaultCaseSensitive);
+  overlay->saveOverlayDir(dirIno, contents);
+
+  uint64_t N = FLAGS_dirEntries;
+
+  folly::stop_watch<> timer;
+
+  for (uint64_t i = 0; i < N; i++) {
+    auto insertion = contents.emplace(
+        PathComponent{fmt::format("file{}", i)},
+        S_IFREG | 0644,
+        overlay->allocateInodeNumber(),
+        hash);
+    overlay->addChild(dirIno, *insertion.first, contents);
+  }
+
+  auto elapsed = timer.elapsed();
+
+  printf(
+      "Total elapsed time to create %" SCNu64 " files in a directory: %.2f s\n",
+      N,
+      std::chrono::duration_cast<std::chrono::duration<double>>(elapsed)
+          .count());
+  printf(
+      "Average time per file: %.2f us\n",
+      static_cast<double>(
+          std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(
+              elapsed / N)
+              .count()));
+
+  overlay->close();
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -123,6 +191,8 @@ int main(int argc, char* argv[]) {
   auto overlayPath = normalizeBestEffort(FLAGS_overlayPath.c_str());
   auto overlayType = inodeCatalogTypeFromString(FLAGS_overlayType);
   benchmarkOverlayTreeWrites(overlayPath, overlayType.value());
+  benchmarkOverlayDirCreates(
+      overlayPath + "dir-creates"_pc, overlayType.value());
 
   return 0;
 }
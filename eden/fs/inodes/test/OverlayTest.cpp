@@ -11,8 +11,10 @@
 #include "eden/fs/inodes/fscatalog/FsInodeCatalog.h"
 #include "eden/fs/inodes/test/OverlayTestUtil.h"
 
+#include <fmt/format.h>
 #include <folly/Exception.h>
 #include <folly/Expected.h>
+#include <folly/File.h>
 #include <folly/FileUtil.h>
 #include <folly/Range.h>
 #include <folly/executors/CPUThreadPoolExecutor.h>
@@ -21,6 +23,7 @@
 #include <folly/portability/GTest.h>
 #include <folly/synchronization/test/Barrier.h>
 #include <folly/test/TestUtils.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
 #include <algorithm>
 
 #include "eden/fs/inodes/EdenMount.h"
@@ -204,6 +207,15 @@ TEST_F(OverlayTest, testTimeStampsInOverlayOnMountAndUnmount) {
   }
 }
 
+TEST_F(OverlayTest, allocateInodeNumbersReturnsConsecutiveBlock) {
+  auto overlay = mount_.getEdenMount()->getOverlay();
+
+  auto first = overlay->allocateInodeNumbers(3);
+  auto next = overlay->allocateInodeNumber();
+  EXPECT_EQ(first.get() + 3, next.get());
+  EXPECT_EQ(next.get() + 1, overlay->allocateInodeNumbers(1).get());
+}
+
 TEST_F(OverlayTest, roundTripThroughSaveAndLoad) {
   auto hash = ObjectId::fromHex("0123456789012345678901234567890123456789");
 
@@ -325,6 +337,104 @@ TEST(PlainOverlayTest, unclean_overlay_is_dirty) {
   EXPECT_FALSE(overlay->hadCleanStartup());
 }
 
+TEST(PlainOverlayTest, unclean_overlay_recovers_from_checkpoint) {
+  folly::test::TemporaryDirectory testDir;
+  auto localDir = canonicalPath(testDir.path().string());
+  auto config = EdenConfig::createTestEdenConfig();
+  config->overlayCheckpointMaxDirtyInodes.setValue(
+      100, ConfigSourceType::CommandLine, true);
+  auto openOverlay = [&] {
+    auto overlay = Overlay::create(
+        localDir,
+        kPathMapDefaultCaseSensitive,
+        kInodeCatalogType,
+        kInodeCatalogOptions,
+        std::make_shared<NullStructuredLogger>(),
+        makeRefPtr<EdenStats>(),
+        true,
+        *config);
+    overlay->initialize(config).get();
+    return overlay;
+  };
+  auto checkpointPath =
+      localDir + PathComponentPiece{OverlayCheckpoint::kCheckpointFile};
+
+  {
+    auto overlay = openOverlay();
+    auto ino2 = overlay->allocateInodeNumber();
+    overlay->createOverlayFile(ino2, folly::ByteRange{"contents"_sp});
+    DirContents root(kPathMapDefaultCaseSensitive);
+    root.emplace("f"_pc, S_IFREG | 0644, ino2);
+    overlay->saveOverlayDir(kRootNodeId, root);
+
+    overlay->maintenance();
+    overlay->flushPendingAsync().get();
+
+    // Written after the checkpoint, so only found through its journal.
+    auto ino3 = overlay->allocateInodeNumber();
+    overlay->createOverlayFile(ino3, folly::ByteRange{"contents"_sp});
+    root.emplace("g"_pc, S_IFREG | 0644, ino3);
+    overlay->saveOverlayDir(kRootNodeId, root);
+  }
+  if (!folly::kIsLinux) {
+    return;
+  }
+  EXPECT_EQ(0, access(checkpointPath.c_str(), F_OK));
+  if (unlink((localDir + "next-inode-number"_pc).c_str())) {
+    folly::throwSystemError("removing saved inode number");
+  }
+
+  auto overlay = openOverlay();
+  EXPECT_FALSE(overlay->hadCleanStartup());
+  EXPECT_EQ(3_ino, overlay->getMaxInodeNumber());
+  // The checkpoint doesn't apply to the writes of this run.
+  EXPECT_NE(0, access(checkpointPath.c_str(), F_OK));
+}
+
+TEST(PlainOverlayTest, blob_file_cache_copies_are_independent) {
+  folly::test::TemporaryDirectory testDir;
+  auto localDir = canonicalPath(testDir.path().string());
+  auto config = EdenConfig::createTestEdenConfig();
+  config->overlayBlobFileCacheSize.setValue(
+      1024 * 1024, ConfigSourceType::CommandLine, true);
+  config->overlayBlobFileCacheMinBlobSize.setValue(
+      1, ConfigSourceType::CommandLine, true);
+  auto overlay = Overlay::create(
+      localDir,
+      kPathMapDefaultCaseSensitive,
+      kInodeCatalogType,
+      kInodeCatalogOptions,
+      std::make_shared<NullStructuredLogger>(),
+      makeRefPtr<EdenStats>(),
+      true,
+      *config);
+  overlay->initialize(config).get();
+
+  // Whether or not the filesystem can clone files, materializing the same
+  // blob twice must produce two separate files.
+  auto blobId = ObjectId::fromHex("0123456789abcdef0123456789abcdef01234567");
+  auto contents = folly::IOBuf::copyBuffer("contents");
+  auto ino2 = overlay->allocateInodeNumber();
+  auto file2 = overlay->createOverlayFileFromBlob(ino2, blobId, *contents);
+  auto ino3 = overlay->allocateInodeNumber();
+  auto file3 = overlay->createOverlayFileFromBlob(ino3, blobId, *contents);
+
+  iovec iov;
+  iov.iov_base = const_cast<char*>("C");
+  iov.iov_len = 1;
+  ASSERT_TRUE(file2.pwritev(&iov, 1, FileContentStore::kHeaderLength));
+
+  auto readContents = [](const OverlayFile& file) {
+    std::string data(8, '\0');
+    auto bytesRead = file.preadNoInt(
+        data.data(), data.size(), FileContentStore::kHeaderLength);
+    EXPECT_EQ(8, bytesRead.value());
+    return data;
+  };
+  EXPECT_EQ("Contents", readContents(file2));
+  EXPECT_EQ("contents", readContents(file3));
+}
+
 enum class OverlayRestartMode {
   CLEAN,
   UNCLEAN,
@@ -766,6 +876,138 @@ TEST(OverlayInodePath, defaultInodePathIsEmpty) {
   EXPECT_STREQ(path.c_str(), "");
 }
 
+namespace {
+overlay::OverlayEntry makeOverlayEntry(InodeNumber ino) {
+  overlay::OverlayEntry entry;
+  entry.mode_ref() = S_IFREG | 0644;
+  entry.inodeNumber_ref() = ino.get();
+  return entry;
+}
+
+std::vector<std::pair<std::string, int64_t>> overlayDirChildren(
+    const overlay::OverlayDir& odir) {
+  std::vector<std::pair<std::string, int64_t>> children;
+  for (const auto& [name, entry] : *odir.entries_ref()) {
+    children.emplace_back(name, *entry.inodeNumber_ref());
+  }
+  return children;
+}
+} // namespace
+
+class AppendDirChangesTest : public ::testing::Test {
+ public:
+  AppendDirChangesTest()
+      : testDir_{makeTempDir("eden_AppendDirChangesTest")},
+        fileContentStore_{canonicalPath(testDir_.path().string())},
+        catalog{&fileContentStore_, /*appendDirChanges=*/true} {
+    catalog.initOverlay(/*createIfNonExisting=*/true);
+  }
+
+  ~AppendDirChangesTest() override {
+    catalog.close(std::nullopt);
+  }
+
+  off_t getFileSize(InodeNumber ino) {
+    struct stat st;
+    folly::checkUnixError(::stat(
+        fileContentStore_.getAbsoluteFilePath(ino).c_str(), &st));
+    return st.st_size;
+  }
+
+  folly::test::TemporaryDirectory testDir_;
+  FileContentStore fileContentStore_;
+  FsInodeCatalog catalog;
+};
+
+TEST_F(AppendDirChangesTest, changes_are_applied_when_loading) {
+  overlay::OverlayDir odir;
+  odir.entries_ref()->emplace("a", makeOverlayEntry(11_ino));
+  catalog.saveOverlayDir(10_ino, std::move(odir));
+  auto savedSize = getFileSize(10_ino);
+
+  catalog.addChild(10_ino, "b"_pc, makeOverlayEntry(12_ino));
+  catalog.removeChild(10_ino, "a"_pc);
+  catalog.renameChild(10_ino, 10_ino, "b"_pc, "c"_pc);
+  catalog.renameChild(10_ino, 20_ino, "c"_pc, "d"_pc);
+  catalog.addChild(10_ino, "e"_pc, makeOverlayEntry(13_ino));
+
+  // The changes were appended rather than rewriting the directory.
+  EXPECT_GT(getFileSize(10_ino), savedSize);
+
+  using Children = std::vector<std::pair<std::string, int64_t>>;
+  EXPECT_EQ(
+      (Children{{"e", 13}}),
+      overlayDirChildren(catalog.loadOverlayDir(10_ino).value()));
+  // 20 had no directory, it is created by the rename.
+  EXPECT_EQ(
+      (Children{{"d", 12}}),
+      overlayDirChildren(catalog.loadOverlayDir(20_ino).value()));
+  EXPECT_TRUE(catalog.hasChild(10_ino, "e"_pc));
+  EXPECT_FALSE(catalog.hasChild(10_ino, "a"_pc));
+
+  // fsck reads the changes as well.
+  auto info = catalog.loadInodeInfo(10_ino);
+  ASSERT_TRUE(info.has_value());
+  EXPECT_EQ(fsck::InodeType::Dir, info->type) << info->errorMsg;
+  EXPECT_EQ((Children{{"e", 13}}), overlayDirChildren(info->children));
+
+  // Saving the whole directory drops the changes.
+  catalog.saveOverlayDir(10_ino, catalog.loadOverlayDir(10_ino).value());
+  EXPECT_LT(getFileSize(10_ino), savedSize + 8);
+}
+
+TEST_F(AppendDirChangesTest, torn_records_are_dropped_before_appending) {
+  overlay::OverlayDir odir;
+  odir.entries_ref()->emplace("a", makeOverlayEntry(11_ino));
+  catalog.saveOverlayDir(10_ino, std::move(odir));
+  catalog.addChild(10_ino, "b"_pc, makeOverlayEntry(12_ino));
+  auto intactSize = getFileSize(10_ino);
+
+  // A complete record with the wrong checksum, then a partly written one.
+  std::string torn{
+      "\0\0\0\4\0\0\0\0abcd"
+      "\0\0\0\x40\0\0",
+      18};
+  {
+    folly::File file{
+        fileContentStore_.getAbsoluteFilePath(10_ino).c_str(),
+        O_WRONLY | O_APPEND};
+    ASSERT_EQ(
+        static_cast<ssize_t>(torn.size()),
+        folly::writeFull(file.fd(), torn.data(), torn.size()));
+  }
+
+  using Children = std::vector<std::pair<std::string, int64_t>>;
+  EXPECT_EQ(
+      (Children{{"a", 11}, {"b", 12}}),
+      overlayDirChildren(catalog.loadOverlayDir(10_ino).value()));
+  EXPECT_EQ(intactSize, getFileSize(10_ino));
+
+  // The next record follows the last intact one, so it isn't lost.
+  catalog.addChild(10_ino, "c"_pc, makeOverlayEntry(13_ino));
+  EXPECT_EQ(
+      (Children{{"a", 11}, {"b", 12}, {"c", 13}}),
+      overlayDirChildren(catalog.loadOverlayDir(10_ino).value()));
+}
+
+TEST_F(AppendDirChangesTest, changes_are_compacted) {
+  catalog.saveOverlayDir(10_ino, overlay::OverlayDir{});
+  constexpr size_t kChildren = 5000;
+  for (size_t i = 0; i < kChildren; ++i) {
+    catalog.addChild(
+        10_ino,
+        PathComponent{fmt::format("a_rather_long_file_name_{}", i)},
+        makeOverlayEntry(InodeNumber{100 + i}));
+  }
+
+  auto odir = catalog.loadOverlayDir(10_ino).value();
+  EXPECT_EQ(kChildren, odir.entries_ref()->size());
+  // The records never grow much larger than the directory.
+  auto dirSize =
+      apache::thrift::CompactSerializer::serialize<std::string>(odir).size();
+  EXPECT_LT(getFileSize(10_ino), 2 * dirSize + 64 * 1024 + 4096);
+}
+
 class DebugDumpOverlayInodesTest : public ::testing::Test {
  public:
   DebugDumpOverlayInodesTest()
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/PrefetchPredictor.h"
+
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/testharness/TempFile.h"
+
+using namespace facebook::eden;
+using namespace facebook::eden::path_literals;
+
+namespace {
+
+struct PrefetchPredictorTest : ::testing::Test {
+  folly::test::TemporaryDirectory tempDir = makeTempDir();
+  AbsolutePath modelPath =
+      canonicalPath(tempDir.path().string()) + "prefetch-predictor"_pc;
+};
+
+} // namespace
+
+TEST_F(PrefetchPredictorTest, ranksDirectoriesByCheckouts) {
+  PrefetchPredictor predictor{modelPath, 100};
+  EXPECT_TRUE(predictor.getTopDirectories(10).empty());
+
+  predictor.recordFileLoad("src/a/foo.cpp"_relpath);
+  predictor.recordFileLoad("src/a/bar.cpp"_relpath);
+  predictor.recordFileLoad("src/b/foo.cpp"_relpath);
+  predictor.checkoutCompleted();
+
+  predictor.recordFileLoad("src/a/foo.cpp"_relpath);
+  predictor.recordFileLoad("README"_relpath);
+  predictor.checkoutCompleted();
+
+  // Files loaded after a checkout are only recorded until the next one.
+  predictor.recordFileLoad("docs/index.md"_relpath);
+
+  EXPECT_EQ(
+      (std::vector<RelativePath>{
+          RelativePath{"src/a"}, RelativePath{""}, RelativePath{"src/b"}}),
+      predictor.getTopDirectories(10));
+  EXPECT_EQ(
+      std::vector<RelativePath>{RelativePath{"src/a"}},
+      predictor.getTopDirectories(1));
+}
+
+TEST_F(PrefetchPredictorTest, modelIsSaved) {
+  {
+    PrefetchPredictor predictor{modelPath, 100};
+    predictor.recordFileLoad("src/a/foo.cpp"_relpath);
+    predictor.recordFileLoad("dir with spaces/file"_relpath);
+    predictor.checkoutCompleted();
+    predictor.recordFileLoad("src/a/foo.cpp"_relpath);
+    predictor.checkoutCompleted();
+  }
+
+  PrefetchPredictor predictor{modelPath, 100};
+  EXPECT_EQ(
+      (std::vector<RelativePath>{
+          RelativePath{"src/a"}, RelativePath{"dir with spaces"}}),
+      predictor.getTopDirectories(10));
+}
+
+TEST_F(PrefetchPredictorTest, keepsHighestScores) {
+  PrefetchPredictor predictor{modelPath, 2};
+  predictor.recordFileLoad("a/file"_relpath);
+  predictor.checkoutCompleted();
+  predictor.recordFileLoad("a/file"_relpath);
+  predictor.recordFileLoad("b/file"_relpath);
+  predictor.checkoutCompleted();
+  predictor.recordFileLoad("a/file"_relpath);
+  predictor.recordFileLoad("b/file"_relpath);
+  predictor.recordFileLoad("c/file"_relpath);
+  predictor.checkoutCompleted();
+
+  EXPECT_EQ(
+      (std::vector<RelativePath>{RelativePath{"a"}, RelativePath{"b"}}),
+      predictor.getTopDirectories(10));
+}
+
+TEST_F(PrefetchPredictorTest, warmupIsCancelledByForegroundLoads) {
+  PrefetchPredictor predictor{modelPath, 100};
+  auto token = predictor.startWarmup(3);
+  for (int i = 0; i < 3; ++i) {
+    predictor.recordFileLoad("a/file"_relpath);
+  }
+  EXPECT_FALSE(token.isCancellationRequested());
+  predictor.recordFileLoad("a/file"_relpath);
+  EXPECT_TRUE(token.isCancellationRequested());
+}
+
+TEST_F(PrefetchPredictorTest, nextWarmupCancelsThePreviousOne) {
+  PrefetchPredictor predictor{modelPath, 100};
+  auto first = predictor.startWarmup(100);
+  auto second = predictor.startWarmup(100);
+  EXPECT_TRUE(first.isCancellationRequested());
+  EXPECT_FALSE(second.isCancellationRequested());
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/init/Init.h>
+#include <folly/portability/GFlags.h>
+#include <folly/stop_watch.h>
+#include <cinttypes>
+
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/inodes/GlobNode.h"
+#include "eden/fs/inodes/TreeInode.h"
+#include "eden/fs/service/gen-cpp2/eden_types.h"
+#include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/testharness/SyntheticBackingStore.h"
+#include "eden/fs/testharness/TestMount.h"
+
+using namespace facebook::eden;
+
+DEFINE_uint32(depth, 3, "Depth of the synthetic repository");
+DEFINE_uint32(fanOut, 8, "Subdirectories in every directory above the leaves");
+DEFINE_uint32(filesPerDir, 16, "Files in every directory");
+DEFINE_uint64(minFileSize, 128, "Size of the smallest files, in bytes");
+DEFINE_uint64(maxFileSize, 64 * 1024, "Size of the largest files, in bytes");
+DEFINE_uint32(
+    changedFilesPercent,
+    1,
+    "Percentage of the files that differ between the two checked out commits");
+DEFINE_uint64(latencyUs, 0, "Latency of every backing store fetch");
+DEFINE_uint64(
+    bandwidthBytesPerSecond,
+    0,
+    "Bandwidth shared by all backing store fetches, or 0 for unlimited");
+
+namespace {
+
+template <typename Func>
+void timed(folly::StringPiece name, Func&& func) {
+  folly::stop_watch<std::chrono::microseconds> watch;
+  func();
+  printf(
+      "%-10s %10.3f ms\n",
+      name.str().c_str(),
+      watch.elapsed().count() / 1000.0);
+}
+
+/**
+ * Runs an asynchronous operation of the mount to completion.
+ */
+template <typename T>
+T run(TestMount& mount, ImmediateFuture<T> future) {
+  auto* executor = mount.getServerExecutor().get();
+  return std::move(future).semi().via(executor).getVia(executor);
+}
+
+} // namespace
+
+/*
+ * Measures checkout, status, glob and prefetch end to end on an in-process
+ * mount of a synthetic repository, with simulated network costs.
+ */
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+
+  SyntheticBackingStore::Options options;
+  options.maxDepth = FLAGS_depth;
+  options.fanOut = FLAGS_fanOut;
+  options.filesPerDir = FLAGS_filesPerDir;
+  options.minFileSize = FLAGS_minFileSize;
+  options.maxFileSize = FLAGS_maxFileSize;
+  options.changedFilesPercent = FLAGS_changedFilesPercent;
+  options.latency = std::chrono::microseconds{FLAGS_latencyUs};
+  options.bandwidthBytesPerSecond = FLAGS_bandwidthBytesPerSecond;
+  auto backingStore = std::make_shared<SyntheticBackingStore>(options);
+  printf("Repository with %" PRIu64 " files\n", backingStore->getFileCount());
+
+  TestMount mount;
+  timed("mount", [&] { mount.initialize(backingStore, RootId{"1"}); });
+  auto edenMount = mount.getEdenMount();
+
+  GlobNode::ResultList globResults;
+  GlobNode::PrefetchList prefetchIds;
+  timed("glob", [&] {
+    GlobNode glob{/*includeDotfiles=*/false, kPathMapDefaultCaseSensitive};
+    glob.parse("**/*");
+    run(mount,
+        glob.evaluate(
+            edenMount->getObjectStore(),
+            ObjectFetchContext::getNullContext(),
+            RelativePathPiece{},
+            mount.getRootInode(),
+            &prefetchIds,
+            globResults,
+            RootId{"1"}));
+  });
+
+  timed("prefetch", [&] {
+    auto ids = prefetchIds.wlock();
+    run(mount,
+        edenMount->getObjectStore()->prefetchBlobs(
+            ObjectIdRange{ids->data(), ids->size()},
+            ObjectFetchContext::getNullContext()));
+  });
+
+  timed("checkout", [&] {
+    auto* executor = mount.getServerExecutor().get();
+    edenMount
+        ->checkout(mount.getRootInode(), RootId{"2"}, std::nullopt, __func__)
+        .via(executor)
+        .getVia(executor);
+  });
+
+  timed("status", [&] {
+    run(mount,
+        edenMount->diff(
+            mount.getRootInode(), RootId{"2"}, folly::CancellationToken{}));
+  });
+
+  return 0;
+}
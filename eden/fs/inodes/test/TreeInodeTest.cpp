@@ -29,6 +29,7 @@
 #include "eden/fs/testharness/TestUtil.h"
 #include "eden/fs/utils/CaseSensitivity.h"
 #include "eden/fs/utils/FaultInjector.h"
+#include "eden/fs/utils/StatTimes.h"
 
 using namespace facebook::eden;
 using namespace std::chrono_literals;
@@ -251,6 +252,48 @@ TEST(TreeInode, nfsReaddirEofIsCorrect) {
   ASSERT_NE(listingSizesReturned.count(6), 0);
 }
 
+#ifndef _WIN32
+TEST(TreeInode, statChildDoesNotLoadUnloadedChildren) {
+  FakeTreeBuilder builder;
+  builder.setFile("file", "contents");
+  builder.setFile("dir/a", "");
+  builder.setFile("dir/b", "");
+  TestMount mount{builder};
+  auto root = mount.getEdenMount()->getRootInode();
+
+  auto fileSt = root->statChild("file"_pc, ObjectFetchContext::getNullContext())
+                    .get(kFutureTimeout);
+  EXPECT_TRUE(S_ISREG(fileSt.st_mode));
+  EXPECT_EQ(8, fileSt.st_size);
+  EXPECT_EQ(1, fileSt.st_nlink);
+
+  auto dirSt = root->statChild("dir"_pc, ObjectFetchContext::getNullContext())
+                   .get(kFutureTimeout);
+  EXPECT_TRUE(S_ISDIR(dirSt.st_mode));
+  EXPECT_EQ(4, dirSt.st_nlink);
+
+  {
+    auto contents = root->getContents().rlock();
+    EXPECT_EQ(nullptr, contents->entries.find("file"_pc)->second.getInode());
+    EXPECT_EQ(nullptr, contents->entries.find("dir"_pc)->second.getInode());
+  }
+
+  // Once loaded, the child reports the same attributes.
+  auto file = mount.getFileInode("file");
+  auto loadedSt =
+      file->stat(ObjectFetchContext::getNullContext()).get(kFutureTimeout);
+  EXPECT_EQ(fileSt.st_ino, loadedSt.st_ino);
+  EXPECT_EQ(fileSt.st_mode, loadedSt.st_mode);
+  EXPECT_EQ(fileSt.st_size, loadedSt.st_size);
+  EXPECT_EQ(stMtimepoint(fileSt), stMtimepoint(loadedSt));
+
+  EXPECT_THROW_ERRNO(
+      root->statChild("missing"_pc, ObjectFetchContext::getNullContext())
+          .get(kFutureTimeout),
+      ENOENT);
+}
+#endif
+
 namespace {
 
 // 500 is big enough for ~9 entries
@@ -381,6 +424,37 @@ TEST(TreeInode, fuzzConcurrentModificationAndReaddir) {
   }
   std::cout << "Ran " << iterations << " iterations" << std::endl;
 }
+
+TEST(TreeInode, loadingTreeDoesNotSaveEntriesUntilAChildIsLoaded) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"dir/a", ""}, {"dir/b", ""}});
+  TestMount mount{builder};
+
+  auto dir = mount.getTreeInode("dir"_relpath);
+  EXPECT_FALSE(mount.hasOverlayDir(dir->getNodeId()));
+
+  auto a = mount.getFileInode("dir/a"_relpath);
+  EXPECT_TRUE(mount.hasOverlayDir(dir->getNodeId()));
+
+  // The numbers survive the directory being unloaded.
+  auto aNumber = a->getNodeId();
+  a.reset();
+  dir.reset();
+  mount.getEdenMount()->getRootInode()->unloadChildrenNow();
+  EXPECT_EQ(aNumber, mount.getFileInode("dir/a"_relpath)->getNodeId());
+}
+
+TEST(TreeInode, readdirSavesEntries) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"dir/a", ""}, {"dir/b", ""}});
+  TestMount mount{builder};
+
+  auto dir = mount.getTreeInode("dir"_relpath);
+  EXPECT_FALSE(mount.hasOverlayDir(dir->getNodeId()));
+
+  dir->fuseReaddir(FuseDirList{4096}, 0, ObjectFetchContext::getNullContext());
+  EXPECT_TRUE(mount.hasOverlayDir(dir->getNodeId()));
+}
 #endif
 
 TEST(TreeInode, create) {
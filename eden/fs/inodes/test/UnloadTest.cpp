@@ -157,4 +157,37 @@ TEST(UnloadUnreferencedByFuse, inodesReferencedByFuseAreNotUnloaded) {
   EXPECT_EQ(0, counts.unloadedInodeCount);
 }
 
+TEST(UnloadIdleInodes, inodesUsedSinceTheLastSweepAreNotUnloaded) {
+  FakeTreeBuilder builder;
+  builder.setFile("src/a.txt", "a");
+  builder.setFile("src/b.txt", "b");
+  TestMount testMount{builder};
+
+  const auto* edenMount = testMount.getEdenMount().get();
+  auto inodeMap = edenMount->getInodeMap();
+
+  auto a = testMount.getInode("src/a.txt"_relpath)->getNodeId();
+  auto b = testMount.getInode("src/b.txt"_relpath)->getNodeId();
+
+  // root + src + a.txt + b.txt + .eden + 4 .eden entries, all used since they
+  // were loaded.
+  auto histogram = inodeMap->sweepLoadedInodes();
+  EXPECT_EQ(9, histogram[0]);
+  EXPECT_EQ(0, histogram[1]);
+  EXPECT_EQ(0, edenMount->getRootInode()->unloadChildrenIdleFor(1));
+
+  // Path lookups start at the root without going through the InodeMap, so
+  // only src and a.txt are used here.
+  testMount.getInode("src/a.txt"_relpath);
+  histogram = inodeMap->sweepLoadedInodes();
+  EXPECT_EQ(2, histogram[0]);
+  EXPECT_EQ(7, histogram[1]);
+  EXPECT_EQ(0, edenMount->getRootInode()->unloadChildrenIdleFor(2));
+
+  // b.txt + .eden + 4 .eden entries
+  EXPECT_EQ(6, edenMount->getRootInode()->unloadChildrenIdleFor(1));
+  EXPECT_TRUE(inodeMap->lookupLoadedInode(a));
+  EXPECT_FALSE(inodeMap->lookupLoadedInode(b));
+}
+
 #endif
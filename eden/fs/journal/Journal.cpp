@@ -6,6 +6,9 @@
  */
 
 #include "eden/fs/journal/Journal.h"
+#include <folly/Utility.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBufQueue.h>
 #include <folly/logging/xlog.h>
 #include "eden/fs/journal/JournalDelta.h"
 
@@ -102,29 +105,27 @@ Journal::Journal(EdenStatsPtr edenStats) : edenStats_{std::move(edenStats)} {
 }
 
 void Journal::recordCreated(RelativePathPiece fileName) {
-  addDelta(FileChangeJournalDelta(fileName, FileChangeJournalDelta::CREATED));
+  addFileChange(FileChangeAction::Created, fileName);
 }
 
 void Journal::recordRemoved(RelativePathPiece fileName) {
-  addDelta(FileChangeJournalDelta(fileName, FileChangeJournalDelta::REMOVED));
+  addFileChange(FileChangeAction::Removed, fileName);
 }
 
 void Journal::recordChanged(RelativePathPiece fileName) {
-  addDelta(FileChangeJournalDelta(fileName, FileChangeJournalDelta::CHANGED));
+  addFileChange(FileChangeAction::Changed, fileName);
 }
 
 void Journal::recordRenamed(
     RelativePathPiece oldName,
     RelativePathPiece newName) {
-  addDelta(FileChangeJournalDelta(
-      oldName, newName, FileChangeJournalDelta::RENAMED));
+  addFileChange(FileChangeAction::Renamed, oldName, newName);
 }
 
 void Journal::recordReplaced(
     RelativePathPiece oldName,
     RelativePathPiece newName) {
-  addDelta(FileChangeJournalDelta(
-      oldName, newName, FileChangeJournalDelta::REPLACED));
+  addFileChange(FileChangeAction::Replaced, oldName, newName);
 }
 
 void Journal::recordHashUpdate(RootId toHash) {
@@ -153,7 +154,7 @@ void Journal::recordUncleanPaths(
   addDelta(std::move(delta), std::move(toHash));
 }
 
-void Journal::truncateIfNecessary(DeltaState& deltaState) {
+void Journal::truncateIfNecessary(DeltaState& deltaState) const {
   while (JournalDeltaPtr front = deltaState.frontPtr()) {
     if (estimateMemoryUsage(deltaState) <= deltaState.memoryLimit) {
       break;
@@ -184,10 +185,7 @@ bool Journal::compact(
 }
 
 template <typename T>
-bool Journal::addDeltaBeforeNotifying(T&& delta, DeltaState& deltaState) {
-  delta.sequenceID = deltaState.nextSequence++;
-  delta.time = std::chrono::steady_clock::now();
-
+void Journal::mergeDelta(T&& delta, DeltaState& deltaState) const {
   truncateIfNecessary(deltaState);
 
   // We will compact the delta if possible. We can compact the delta if it is
@@ -215,12 +213,74 @@ bool Journal::addDeltaBeforeNotifying(T&& delta, DeltaState& deltaState) {
   }
 
   deltaState.stats->earliestTimestamp = deltaState.frontPtr()->time;
+}
 
-  bool shouldNotify = deltaState.lastModificationHasBeenObserved;
-  deltaState.lastModificationHasBeenObserved = false;
+template <typename T>
+bool Journal::sequenceDelta(
+    T& delta,
+    std::vector<PendingFileChange>& fileChanges) {
+  auto pendingState = pendingState_.lock();
+  delta.sequenceID = pendingState->nextSequence++;
+  delta.time = std::chrono::steady_clock::now();
+  fileChanges.swap(pendingState->fileChanges);
+
+  bool shouldNotify = pendingState->lastModificationHasBeenObserved;
+  pendingState->lastModificationHasBeenObserved = false;
   return shouldNotify;
 }
 
+void Journal::mergeFileChanges(
+    std::vector<PendingFileChange> fileChanges,
+    DeltaState& deltaState) const {
+  for (auto& change : fileChanges) {
+    auto& paths = deltaState.paths;
+    FileChangeJournalDelta delta;
+    switch (change.action) {
+      case FileChangeAction::Created:
+        delta = FileChangeJournalDelta{
+            paths.intern(change.path1), FileChangeJournalDelta::CREATED};
+        break;
+      case FileChangeAction::Removed:
+        delta = FileChangeJournalDelta{
+            paths.intern(change.path1), FileChangeJournalDelta::REMOVED};
+        break;
+      case FileChangeAction::Changed:
+        delta = FileChangeJournalDelta{
+            paths.intern(change.path1), FileChangeJournalDelta::CHANGED};
+        break;
+      case FileChangeAction::Renamed:
+        delta = FileChangeJournalDelta{
+            paths.intern(change.path1),
+            paths.intern(change.path2),
+            FileChangeJournalDelta::RENAMED};
+        break;
+      case FileChangeAction::Replaced:
+        delta = FileChangeJournalDelta{
+            paths.intern(change.path1),
+            paths.intern(change.path2),
+            FileChangeJournalDelta::REPLACED};
+        break;
+    }
+    delta.sequenceID = change.sequenceID;
+    delta.time = change.time;
+    mergeDelta(std::move(delta), deltaState);
+  }
+}
+
+Journal::LockedDeltaState Journal::lockDeltaState(bool observe) const {
+  auto deltaState = deltaState_.lock();
+  std::vector<PendingFileChange> fileChanges;
+  {
+    auto pendingState = pendingState_.lock();
+    fileChanges.swap(pendingState->fileChanges);
+    if (observe) {
+      pendingState->lastModificationHasBeenObserved = true;
+    }
+  }
+  mergeFileChanges(std::move(fileChanges), *deltaState);
+  return deltaState;
+}
+
 void Journal::notifySubscribers() const {
   auto subscribers = subscriberState_.rlock()->subscribers;
   for (auto& sub : subscribers) {
@@ -228,11 +288,27 @@ void Journal::notifySubscribers() const {
   }
 }
 
-void Journal::addDelta(FileChangeJournalDelta&& delta) {
+void Journal::addFileChange(
+    FileChangeAction action,
+    RelativePathPiece path1,
+    RelativePathPiece path2) {
   bool shouldNotify;
+  bool shouldMerge;
   {
-    auto deltaState = deltaState_.lock();
-    shouldNotify = addDeltaBeforeNotifying(std::move(delta), *deltaState);
+    auto pendingState = pendingState_.lock();
+    pendingState->fileChanges.push_back(PendingFileChange{
+        pendingState->nextSequence++,
+        std::chrono::steady_clock::now(),
+        action,
+        path1.copy(),
+        path2.copy()});
+    shouldMerge = pendingState->fileChanges.size() >= kMaxPendingFileChanges;
+
+    shouldNotify = pendingState->lastModificationHasBeenObserved;
+    pendingState->lastModificationHasBeenObserved = false;
+  }
+  if (shouldMerge) {
+    lockDeltaState();
   }
   if (shouldNotify) {
     notifySubscribers();
@@ -243,13 +319,16 @@ void Journal::addDelta(RootUpdateJournalDelta&& delta, RootId newRootId) {
   bool shouldNotify;
   {
     auto deltaState = deltaState_.lock();
+    std::vector<PendingFileChange> fileChanges;
+    shouldNotify = sequenceDelta(delta, fileChanges);
+    mergeFileChanges(std::move(fileChanges), *deltaState);
 
     // If the hashes were not set to anything, default to copying
     // the value from the prior journal entry
     if (delta.fromHash == RootId{}) {
       delta.fromHash = deltaState->currentHash;
     }
-    shouldNotify = addDeltaBeforeNotifying(std::move(delta), *deltaState);
+    mergeDelta(std::move(delta), *deltaState);
     deltaState->currentHash = std::move(newRootId);
   }
   if (shouldNotify) {
@@ -257,9 +336,8 @@ void Journal::addDelta(RootUpdateJournalDelta&& delta, RootId newRootId) {
   }
 }
 
-std::optional<JournalDeltaInfo> Journal::getLatest() {
-  auto deltaState = deltaState_.lock();
-  deltaState->lastModificationHasBeenObserved = true;
+std::optional<JournalDeltaInfo> Journal::getLatest(bool observe) {
+  auto deltaState = lockDeltaState(observe);
   if (deltaState->empty()) {
     return std::nullopt;
   } else {
@@ -315,10 +393,17 @@ bool Journal::isSubscriberValid(uint64_t id) const {
 }
 
 std::optional<InternalJournalStats> Journal::getStats() {
-  return deltaState_.lock()->stats;
+  return lockDeltaState()->stats;
 }
 
 namespace {
+bool isPathUnder(RelativePathPiece path, RelativePathPiece root) {
+  auto prefix = root.view();
+  return path.view().starts_with(prefix) &&
+      path.view().size() > prefix.size() &&
+      path.view()[prefix.size()] == kDirSeparator;
+}
+
 folly::StringPiece eventCharacterizationFor(const PathChangeInfo& ci) {
   if (ci.existedBefore && !ci.existedAfter) {
     return "Removed";
@@ -332,6 +417,180 @@ folly::StringPiece eventCharacterizationFor(const PathChangeInfo& ci) {
 }
 } // namespace
 
+namespace {
+constexpr uint32_t kSerializedJournalVersion = 1;
+
+enum SerializedDeltaType : uint8_t {
+  kFileChangeDelta = 0,
+  kRootUpdateDelta = 1,
+};
+
+// Bits of the flags of a serialized FileChangeJournalDelta.
+enum FileChangeFlags : uint8_t {
+  kPath1Valid = 1 << 0,
+  kPath2Valid = 1 << 1,
+  kPath1ExistedBefore = 1 << 2,
+  kPath1ExistedAfter = 1 << 3,
+  kPath2ExistedBefore = 1 << 4,
+  kPath2ExistedAfter = 1 << 5,
+};
+
+void writeString(folly::io::QueueAppender& appender, folly::StringPiece str) {
+  appender.writeBE<uint32_t>(folly::to_narrow(str.size()));
+  appender.push(folly::ByteRange{str});
+}
+
+std::string readString(folly::io::Cursor& cursor) {
+  auto size = cursor.readBE<uint32_t>();
+  return cursor.readFixedString(size);
+}
+} // namespace
+
+folly::IOBuf Journal::serialize() const {
+  folly::IOBufQueue queue{folly::IOBufQueue::cacheChainLength()};
+  folly::io::QueueAppender appender{&queue, 64 * 1024};
+
+  auto deltaState = lockDeltaState();
+  appender.writeBE<uint32_t>(kSerializedJournalVersion);
+  appender.writeBE<uint64_t>(pendingState_.lock()->nextSequence);
+  writeString(appender, deltaState->currentHash.value());
+  appender.writeBE<uint64_t>(
+      deltaState->fileChangeDeltas.size() +
+      deltaState->hashUpdateDeltas.size());
+
+  // The deltas are written from the oldest to the newest.
+  auto fileChangeIt = deltaState->fileChangeDeltas.begin();
+  auto hashUpdateIt = deltaState->hashUpdateDeltas.begin();
+  auto fileChangeEnd = deltaState->fileChangeDeltas.end();
+  auto hashUpdateEnd = deltaState->hashUpdateDeltas.end();
+  while (fileChangeIt != fileChangeEnd || hashUpdateIt != hashUpdateEnd) {
+    bool isFileChange = hashUpdateIt == hashUpdateEnd ||
+        (fileChangeIt != fileChangeEnd &&
+         fileChangeIt->sequenceID < hashUpdateIt->sequenceID);
+    if (isFileChange) {
+      const auto& delta = *fileChangeIt++;
+      uint8_t flags = (delta.isPath1Valid ? kPath1Valid : 0) |
+          (delta.isPath2Valid ? kPath2Valid : 0) |
+          (delta.info1.existedBefore ? kPath1ExistedBefore : 0) |
+          (delta.info1.existedAfter ? kPath1ExistedAfter : 0) |
+          (delta.info2.existedBefore ? kPath2ExistedBefore : 0) |
+          (delta.info2.existedAfter ? kPath2ExistedAfter : 0);
+      appender.write<uint8_t>(kFileChangeDelta);
+      appender.writeBE<uint64_t>(delta.sequenceID);
+      appender.write<uint8_t>(flags);
+      writeString(appender, delta.path1.toRelativePath().view());
+      writeString(appender, delta.path2.toRelativePath().view());
+    } else {
+      const auto& delta = *hashUpdateIt++;
+      appender.write<uint8_t>(kRootUpdateDelta);
+      appender.writeBE<uint64_t>(delta.sequenceID);
+      writeString(appender, delta.fromHash.value());
+      appender.writeBE<uint64_t>(delta.uncleanPaths.size());
+      for (const auto& path : delta.uncleanPaths) {
+        writeString(appender, path.view());
+      }
+    }
+  }
+  deltaState.unlock();
+
+  auto buf = queue.move();
+  buf->coalesce();
+  return std::move(*buf);
+}
+
+bool Journal::deserialize(folly::ByteRange data) {
+  DeltaState loaded;
+  SequenceNumber nextSequence = 0;
+  auto now = std::chrono::steady_clock::now();
+
+  try {
+    folly::IOBuf buf{folly::IOBuf::WRAP_BUFFER, data};
+    folly::io::Cursor cursor{&buf};
+    if (cursor.readBE<uint32_t>() != kSerializedJournalVersion) {
+      return false;
+    }
+    nextSequence = cursor.readBE<uint64_t>();
+    loaded.currentHash = RootId{readString(cursor)};
+
+    auto count = cursor.readBE<uint64_t>();
+    SequenceNumber previousSequence = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+      auto type = cursor.read<uint8_t>();
+      auto sequenceID = cursor.readBE<uint64_t>();
+      if (sequenceID <= previousSequence ||
+          sequenceID >= nextSequence) {
+        return false;
+      }
+      previousSequence = sequenceID;
+
+      if (type == kFileChangeDelta) {
+        auto flags = cursor.read<uint8_t>();
+        FileChangeJournalDelta delta;
+        delta.sequenceID = sequenceID;
+        delta.time = now;
+        delta.isPath1Valid = flags & kPath1Valid;
+        delta.isPath2Valid = flags & kPath2Valid;
+        delta.info1 = PathChangeInfo{
+            bool(flags & kPath1ExistedBefore),
+            bool(flags & kPath1ExistedAfter)};
+        delta.info2 = PathChangeInfo{
+            bool(flags & kPath2ExistedBefore),
+            bool(flags & kPath2ExistedAfter)};
+        auto path1 = RelativePath{readString(cursor)};
+        auto path2 = RelativePath{readString(cursor)};
+        if (delta.isPath1Valid) {
+          delta.path1 = loaded.paths.intern(path1);
+        }
+        if (delta.isPath2Valid) {
+          delta.path2 = loaded.paths.intern(path2);
+        }
+        loaded.deltaMemoryUsage += delta.estimateMemoryUsage();
+        loaded.appendDelta(std::move(delta));
+      } else if (type == kRootUpdateDelta) {
+        RootUpdateJournalDelta delta;
+        delta.sequenceID = sequenceID;
+        delta.time = now;
+        delta.fromHash = RootId{readString(cursor)};
+        auto uncleanCount = cursor.readBE<uint64_t>();
+        for (uint64_t j = 0; j < uncleanCount; ++j) {
+          delta.uncleanPaths.emplace(readString(cursor));
+        }
+        loaded.deltaMemoryUsage += delta.estimateMemoryUsage();
+        loaded.appendDelta(std::move(delta));
+      } else {
+        return false;
+      }
+    }
+    if (!cursor.isAtEnd()) {
+      return false;
+    }
+  } catch (const std::out_of_range&) {
+    // The data is truncated.
+    return false;
+  } catch (const PathComponentValidationError&) {
+    return false;
+  }
+
+  if (!loaded.empty()) {
+    loaded.stats = InternalJournalStats();
+    loaded.stats->entryCount =
+        loaded.fileChangeDeltas.size() + loaded.hashUpdateDeltas.size();
+    loaded.stats->earliestTimestamp = now;
+    loaded.stats->latestTimestamp = now;
+  }
+
+  auto deltaState = deltaState_.lock();
+  {
+    auto pendingState = pendingState_.lock();
+    pendingState->nextSequence = nextSequence;
+    pendingState->fileChanges.clear();
+  }
+  loaded.memoryLimit = deltaState->memoryLimit;
+  *deltaState = std::move(loaded);
+  truncateIfNecessary(*deltaState);
+  return true;
+}
+
 void Journal::setMemoryLimit(size_t limit) {
   auto deltaState = deltaState_.lock();
   deltaState->memoryLimit = limit;
@@ -343,7 +602,7 @@ size_t Journal::getMemoryLimit() const {
 }
 
 size_t Journal::estimateMemoryUsage() const {
-  return estimateMemoryUsage(*deltaState_.lock());
+  return estimateMemoryUsage(*lockDeltaState());
 }
 
 template <typename T>
@@ -365,6 +624,7 @@ size_t Journal::estimateMemoryUsage(const DeltaState& deltaState) const {
   if (deltaState.stats) {
     memoryUsage += deltaState.deltaMemoryUsage;
   }
+  memoryUsage += deltaState.paths.estimateMemoryUsage();
   return memoryUsage;
 }
 
@@ -372,10 +632,11 @@ void Journal::flush() {
   bool shouldNotify;
   {
     auto deltaState = deltaState_.lock();
-    ++deltaState->nextSequence;
+    ++pendingState_.lock()->nextSequence;
     auto lastHash = deltaState->currentHash;
     deltaState->fileChangeDeltas.clear();
     deltaState->hashUpdateDeltas.clear();
+    deltaState->paths = JournalPathInterner{};
     deltaState->stats = std::nullopt;
     auto delta = RootUpdateJournalDelta();
     /* Tracking the hash correctly when the journal is flushed is important
@@ -386,7 +647,10 @@ void Journal::flush() {
      * flush operation.
      */
     delta.fromHash = lastHash;
-    shouldNotify = addDeltaBeforeNotifying(std::move(delta), *deltaState);
+    // The pending file changes are flushed with the merged ones.
+    std::vector<PendingFileChange> fileChanges;
+    shouldNotify = sequenceDelta(delta, fileChanges);
+    mergeDelta(std::move(delta), *deltaState);
   }
   if (shouldNotify) {
     notifySubscribers();
@@ -394,12 +658,13 @@ void Journal::flush() {
 }
 
 std::unique_ptr<JournalDeltaRange> Journal::accumulateRange(
-    SequenceNumber from) {
+    SequenceNumber from,
+    RelativePathPiece root) {
   XDCHECK(from > 0);
   std::unique_ptr<JournalDeltaRange> result = nullptr;
 
   size_t filesAccumulated = 0;
-  auto deltaState = deltaState_.lock();
+  auto deltaState = lockDeltaState(/*observe=*/true);
   // If this is going to be truncated, handle it before iterating.
   if (!deltaState->empty() && deltaState->getFrontSequenceID() > from) {
     result = std::make_unique<JournalDeltaRange>();
@@ -410,7 +675,6 @@ std::unique_ptr<JournalDeltaRange> Journal::accumulateRange(
         from,
         std::nullopt,
         [&](const FileChangeJournalDelta& current) -> void {
-          ++filesAccumulated;
           if (!result) {
             result = std::make_unique<JournalDeltaRange>();
             result->toSequence = current.sequenceID;
@@ -421,7 +685,12 @@ std::unique_ptr<JournalDeltaRange> Journal::accumulateRange(
           result->fromSequence = current.sequenceID;
           result->fromTime = current.time;
 
-          for (auto& entry : current.getChangedFilesInOverlay()) {
+          auto changedFiles = current.getChangedFilesInOverlay(root);
+          if (changedFiles.empty()) {
+            return;
+          }
+          ++filesAccumulated;
+          for (auto& entry : changedFiles) {
             auto& name = entry.first;
             auto& currentInfo = entry.second;
             auto* resultInfo =
@@ -453,8 +722,16 @@ std::unique_ptr<JournalDeltaRange> Journal::accumulateRange(
           result->snapshotTransitions.push_back(current.fromHash);
 
           // Merge the unclean status list
-          result->uncleanPaths.insert(
-              current.uncleanPaths.begin(), current.uncleanPaths.end());
+          if (root.empty()) {
+            result->uncleanPaths.insert(
+                current.uncleanPaths.begin(), current.uncleanPaths.end());
+          } else {
+            for (const auto& path : current.uncleanPaths) {
+              if (isPathUnder(path, root)) {
+                result->uncleanPaths.insert(path);
+              }
+            }
+          }
         });
   }
 
@@ -474,7 +751,6 @@ std::unique_ptr<JournalDeltaRange> Journal::accumulateRange(
         result->snapshotTransitions.begin(), result->snapshotTransitions.end());
   }
 
-  deltaState->lastModificationHasBeenObserved = true;
   return result;
 }
 
@@ -484,7 +760,7 @@ std::vector<DebugJournalDelta> Journal::getDebugRawJournalInfo(
     long mountGeneration,
     RootIdCodec& rootIdCodec) const {
   auto result = std::vector<DebugJournalDelta>();
-  auto deltaState = deltaState_.lock();
+  auto deltaState = lockDeltaState();
   RootId currentHash = deltaState->currentHash;
   forEachDelta(
       *deltaState,
@@ -9,11 +9,13 @@
 
 #include <folly/Function.h>
 #include <folly/Synchronized.h>
+#include <folly/io/IOBuf.h>
 #include <algorithm>
 #include <cstdint>
 #include <memory>
 #include <optional>
 #include <unordered_map>
+#include <vector>
 #include "eden/fs/journal/JournalDelta.h"
 #include "eden/fs/model/RootId.h"
 #include "eden/fs/service/gen-cpp2/streamingeden_types.h"
@@ -109,8 +111,11 @@ class Journal {
   /**
    * Returns a copy of the tip of the journal.
    * Will return a nullopt if the journal is empty.
+   *
+   * Unless observe is false, this counts as observing the latest modification,
+   * for subscribers to be notified of the next one.
    */
-  std::optional<JournalDeltaInfo> getLatest();
+  std::optional<JournalDeltaInfo> getLatest(bool observe = true);
 
   /**
    * Returns an accumulation of all deltas with sequence number >= limitSequence
@@ -119,10 +124,15 @@ class Journal {
    *
    * The default limit value indicates that all deltas should be summed.
    *
+   * If root isn't empty, only the changed and unclean paths under it are
+   * accumulated. The deltas of other paths are skipped without building their
+   * paths, but still count in the sequence range and snapshot transitions.
+   *
    * If the limitSequence means that no deltas will match, returns nullptr.
    */
   std::unique_ptr<JournalDeltaRange> accumulateRange(
-      SequenceNumber limitSequence = 1);
+      SequenceNumber limitSequence = 1,
+      RelativePathPiece root = RelativePathPiece{});
 
   // Subscription functionality:
 
@@ -172,6 +182,20 @@ class Journal {
    * */
   void flush();
 
+  /**
+   * Serialize the deltas of the journal and its current position, for a
+   * journal in a later process to carry on from them with deserialize().
+   * The times of the deltas aren't kept.
+   */
+  folly::IOBuf serialize() const;
+
+  /**
+   * Replace the deltas of the journal with the ones serialized in data, which
+   * get the current time. Returns false, leaving the journal unchanged, if
+   * data isn't a valid serialized journal.
+   */
+  bool deserialize(folly::ByteRange data);
+
   void setMemoryLimit(size_t limit);
 
   size_t getMemoryLimit() const;
@@ -179,21 +203,72 @@ class Journal {
   size_t estimateMemoryUsage() const;
 
  private:
+  enum class FileChangeAction : uint8_t {
+    Created,
+    Removed,
+    Changed,
+    Renamed,
+    Replaced,
+  };
+
+  /**
+   * Record a file change and notify subscribers.
+   *
+   * The change is appended to the pending file changes, merged in the
+   * DeltaState by the next reader of the journal.
+   */
+  void addFileChange(
+      FileChangeAction action,
+      RelativePathPiece path1,
+      RelativePathPiece path2 = RelativePathPiece{});
+
   /** Add a delta to the journal and notify subscribers.
    * The delta will have a new sequence number and timestamp
    * applied.
    */
-  void addDelta(FileChangeJournalDelta&& delta);
   void addDelta(RootUpdateJournalDelta&& delta, RootId newRootId);
 
   static constexpr size_t kDefaultJournalMemoryLimit = 1000000000;
 
-  struct DeltaState {
+  /**
+   * The pending file changes are merged by the writer adding this many of
+   * them, bounding the memory they use when the journal isn't read.
+   */
+  static constexpr size_t kMaxPendingFileChanges = 1024;
+
+  /** A file change recorded but not merged in the DeltaState yet. */
+  struct PendingFileChange {
+    SequenceNumber sequenceID;
+    std::chrono::steady_clock::time_point time;
+    FileChangeAction action;
+    RelativePath path1;
+    RelativePath path2;
+  };
+
+  /**
+   * File changes are the bulk of the journal writes. Recording them only
+   * appends to this state, so that writers contend on a short critical section
+   * rather than with the readers of the DeltaState and the truncation of the
+   * journal.
+   *
+   * When both are held, the DeltaState lock is acquired first.
+   */
+  struct PendingState {
     /**
      * The sequence number that we'll use for the next entry that we link into
      * the chain.
      */
     SequenceNumber nextSequence{1};
+    std::vector<PendingFileChange> fileChanges;
+
+    // Set to false when a delta is added.
+    // Set to true when getLatest() or accumulateRange() are called.
+    // If true before calling addDelta, subscribers are notified.
+    bool lastModificationHasBeenObserved = true;
+  };
+  folly::Synchronized<PendingState, std::mutex> pendingState_;
+
+  struct DeltaState {
     /**
      * All recorded entries. Newer (more recent) deltas are added to the back of
      * the appropriate deque.
@@ -201,16 +276,13 @@ class Journal {
     std::deque<FileChangeJournalDelta> fileChangeDeltas;
     std::deque<RootUpdateJournalDelta> hashUpdateDeltas;
     RootId currentHash;
+    /// The directories of the paths of fileChangeDeltas.
+    JournalPathInterner paths;
     /// The stats about this Journal up to the latest delta.
     std::optional<InternalJournalStats> stats;
     size_t memoryLimit = kDefaultJournalMemoryLimit;
     size_t deltaMemoryUsage = 0;
 
-    // Set to false when a delta is added.
-    // Set to true when getLatest() or accumulateRange() are called.
-    // If true before calling addDelta, subscribers are notified.
-    bool lastModificationHasBeenObserved = true;
-
     JournalDeltaPtr frontPtr() noexcept;
     void popFront();
     JournalDeltaPtr backPtr() noexcept;
@@ -233,20 +305,39 @@ class Journal {
       }
     }
   };
-  folly::Synchronized<DeltaState, std::mutex> deltaState_;
+  /**
+   * Mutable since readers merge the pending file changes in it, which doesn't
+   * change what the journal holds.
+   */
+  mutable folly::Synchronized<DeltaState, std::mutex> deltaState_;
+  using LockedDeltaState = decltype(deltaState_)::LockedPtr;
+
+  /**
+   * Lock the DeltaState and merge the pending file changes in it. Readers
+   * reporting the latest modification to subscribers set observe to true.
+   */
+  LockedDeltaState lockDeltaState(bool observe = false) const;
+
+  /**
+   * Merge the pending file changes taken from the PendingState in the
+   * DeltaState, in the order of their sequence numbers.
+   */
+  void mergeFileChanges(
+      std::vector<PendingFileChange> fileChanges,
+      DeltaState& deltaState) const;
 
   /**
    * Removes the oldest deltas until the memory usage of the journal is below
    * the journal's memory limit.
    */
-  void truncateIfNecessary(DeltaState& deltaState);
+  void truncateIfNecessary(DeltaState& deltaState) const;
 
   /**
    * Tries to compact a new Journal Delta with an old one if possible,
    * returning true if it did compact it and false if not
    */
-  bool compact(FileChangeJournalDelta& delta, DeltaState& deltaState);
-  bool compact(RootUpdateJournalDelta& delta, DeltaState& deltaState);
+  static bool compact(FileChangeJournalDelta& delta, DeltaState& deltaState);
+  static bool compact(RootUpdateJournalDelta& delta, DeltaState& deltaState);
 
   struct SubscriberState {
     SubscriberId nextSubscriberId{1};
@@ -254,15 +345,25 @@ class Journal {
   };
 
   /**
-   * Add a delta to the journal without notifying subscribers.
-   * The delta will have a new sequence number and timestamp
-   * applied. A lock to the deltaState must be held and passed to this
-   * function.
+   * Add a delta, which already has its sequence number and timestamp, to the
+   * DeltaState without notifying subscribers. A lock to the deltaState must be
+   * held and passed to this function.
+   */
+  template <typename T>
+  void mergeDelta(T&& delta, DeltaState& deltaState) const;
+
+  /**
+   * Give the next sequence number and the current time to a delta, and take
+   * the pending file changes that precede it. A lock to the deltaState must be
+   * held while calling this function, for the delta to be merged after these
+   * file changes.
    *
    * Returns true if subscribers should be notified.
    */
   template <typename T>
-  [[nodiscard]] bool addDeltaBeforeNotifying(T&& delta, DeltaState& deltaState);
+  [[nodiscard]] bool sequenceDelta(
+      T& delta,
+      std::vector<PendingFileChange>& fileChanges);
 
   /**
    * Notify subscribers that a change has happened. Must not be called while
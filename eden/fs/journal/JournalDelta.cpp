@@ -12,43 +12,43 @@
 namespace facebook::eden {
 
 FileChangeJournalDelta::FileChangeJournalDelta(
-    RelativePathPiece fileName,
+    JournalPath fileName,
     FileChangeJournalDelta::Created)
-    : path1{fileName.copy()},
+    : path1{std::move(fileName)},
       info1{PathChangeInfo{false, true}},
       isPath1Valid{true} {}
 
 FileChangeJournalDelta::FileChangeJournalDelta(
-    RelativePathPiece fileName,
+    JournalPath fileName,
     FileChangeJournalDelta::Removed)
-    : path1{fileName.copy()},
+    : path1{std::move(fileName)},
       info1{PathChangeInfo{true, false}},
       isPath1Valid{true} {}
 
 FileChangeJournalDelta::FileChangeJournalDelta(
-    RelativePathPiece fileName,
+    JournalPath fileName,
     FileChangeJournalDelta::Changed)
-    : path1{fileName.copy()},
+    : path1{std::move(fileName)},
       info1{PathChangeInfo{true, true}},
       isPath1Valid{true} {}
 
 FileChangeJournalDelta::FileChangeJournalDelta(
-    RelativePathPiece oldName,
-    RelativePathPiece newName,
+    JournalPath oldName,
+    JournalPath newName,
     FileChangeJournalDelta::Renamed)
-    : path1{oldName.copy()},
-      path2{newName.copy()},
+    : path1{std::move(oldName)},
+      path2{std::move(newName)},
       info1{PathChangeInfo{true, false}},
       info2{PathChangeInfo{false, true}},
       isPath1Valid{true},
       isPath2Valid{true} {}
 
 FileChangeJournalDelta::FileChangeJournalDelta(
-    RelativePathPiece oldName,
-    RelativePathPiece newName,
+    JournalPath oldName,
+    JournalPath newName,
     FileChangeJournalDelta::Replaced)
-    : path1{oldName.copy()},
-      path2{newName.copy()},
+    : path1{std::move(oldName)},
+      path2{std::move(newName)},
       info1{PathChangeInfo{true, false}},
       info2{PathChangeInfo{true, true}},
       isPath1Valid{true},
@@ -57,15 +57,11 @@ FileChangeJournalDelta::FileChangeJournalDelta(
 size_t FileChangeJournalDelta::estimateMemoryUsage() const {
   size_t mem = sizeof(FileChangeJournalDelta);
 
-  /* NOTE: The following code assumes an unordered_set is separated into an
-   * array of buckets, each one being a chain of nodes containing a next
-   * pointer, a key-value pair, and a stored hash
-   */
   if (isPath1Valid) {
-    mem += facebook::eden::estimateIndirectMemoryUsage(path1);
+    mem += path1.estimateIndirectMemoryUsage();
   }
   if (isPath2Valid) {
-    mem += facebook::eden::estimateIndirectMemoryUsage(path2);
+    mem += path2.estimateIndirectMemoryUsage();
   }
 
   return mem;
@@ -99,13 +95,13 @@ size_t RootUpdateJournalDelta::estimateMemoryUsage() const {
 }
 
 std::unordered_map<RelativePath, PathChangeInfo>
-FileChangeJournalDelta::getChangedFilesInOverlay() const {
+FileChangeJournalDelta::getChangedFilesInOverlay(RelativePathPiece root) const {
   std::unordered_map<RelativePath, PathChangeInfo> changedFilesInOverlay;
-  if (isPath1Valid) {
-    changedFilesInOverlay[path1] = info1;
+  if (isPath1Valid && path1.isUnder(root)) {
+    changedFilesInOverlay[path1.toRelativePath()] = info1;
   }
-  if (isPath2Valid) {
-    changedFilesInOverlay[path2] = info2;
+  if (isPath2Valid && path2.isUnder(root)) {
+    changedFilesInOverlay[path2.toRelativePath()] = info2;
   }
   return changedFilesInOverlay;
 }
@@ -11,6 +11,7 @@
 #include <type_traits>
 #include <unordered_set>
 #include <variant>
+#include "eden/fs/journal/JournalPath.h"
 #include "eden/fs/model/RootId.h"
 #include "eden/fs/utils/PathFuncs.h"
 
@@ -74,16 +75,16 @@ class FileChangeJournalDelta : public JournalDelta {
   FileChangeJournalDelta& operator=(FileChangeJournalDelta&&) = default;
   FileChangeJournalDelta(const FileChangeJournalDelta&) = delete;
   FileChangeJournalDelta& operator=(const FileChangeJournalDelta&) = delete;
-  FileChangeJournalDelta(RelativePathPiece fileName, Created);
-  FileChangeJournalDelta(RelativePathPiece fileName, Removed);
-  FileChangeJournalDelta(RelativePathPiece fileName, Changed);
+  FileChangeJournalDelta(JournalPath fileName, Created);
+  FileChangeJournalDelta(JournalPath fileName, Removed);
+  FileChangeJournalDelta(JournalPath fileName, Changed);
 
   /**
    * "Renamed" means that that newName was created as a result of the mv(1).
    */
   FileChangeJournalDelta(
-      RelativePathPiece oldName,
-      RelativePathPiece newName,
+      JournalPath oldName,
+      JournalPath newName,
       Renamed);
 
   /**
@@ -91,20 +92,24 @@ class FileChangeJournalDelta : public JournalDelta {
    * of the mv(1).
    */
   FileChangeJournalDelta(
-      RelativePathPiece oldName,
-      RelativePathPiece newName,
+      JournalPath oldName,
+      JournalPath newName,
       Replaced);
 
   /** Which of these paths actually contain information */
-  RelativePath path1;
-  RelativePath path2;
+  JournalPath path1;
+  JournalPath path2;
   PathChangeInfo info1;
   PathChangeInfo info2;
   bool isPath1Valid = false;
   bool isPath2Valid = false;
 
-  std::unordered_map<RelativePath, PathChangeInfo> getChangedFilesInOverlay()
-      const;
+  /**
+   * The changed paths, with some information about the changes. If root isn't
+   * empty, only the paths under it are returned.
+   */
+  std::unordered_map<RelativePath, PathChangeInfo> getChangedFilesInOverlay(
+      RelativePathPiece root = RelativePathPiece{}) const;
 
   /** Checks whether this delta is a modification */
   bool isModification() const;
@@ -113,7 +118,10 @@ class FileChangeJournalDelta : public JournalDelta {
    * sequenceID [whether they do the same action] */
   bool isSameAction(const FileChangeJournalDelta& other) const;
 
-  /** Get memory used (in bytes) by this Delta */
+  /**
+   * Get memory used (in bytes) by this Delta, not counting its directories
+   * shared with the other deltas.
+   */
   size_t estimateMemoryUsage() const;
 };
 
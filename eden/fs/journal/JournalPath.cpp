@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/journal/JournalPath.h"
+#include <fmt/format.h>
+#include <folly/memory/Malloc.h>
+#include <algorithm>
+#include "eden/fs/utils/Memory.h"
+
+namespace facebook::eden {
+
+namespace {
+// Don't bother pruning fewer directories than this.
+constexpr size_t kMinPruneSize = 64;
+} // namespace
+
+RelativePath JournalPath::toRelativePath() const {
+  if (!directory_ || directory_->view().empty()) {
+    return RelativePath{name_, detail::SkipPathSanityCheck{}};
+  }
+  return RelativePath{
+      fmt::format("{}{}{}", directory_->view(), kDirSeparatorStr, name_),
+      detail::SkipPathSanityCheck{}};
+}
+
+bool JournalPath::isUnder(RelativePathPiece directory) const {
+  if (directory.empty()) {
+    return true;
+  }
+  auto own = directory_ ? directory_->view() : std::string_view{};
+  auto prefix = directory.view();
+  return own.starts_with(prefix) &&
+      (own.size() == prefix.size() || own[prefix.size()] == kDirSeparator);
+}
+
+size_t JournalPath::estimateIndirectMemoryUsage() const {
+  return facebook::eden::estimateIndirectMemoryUsage(name_);
+}
+
+bool JournalPath::operator==(const JournalPath& other) const {
+  if (name_ != other.name_) {
+    return false;
+  }
+  // Interned directories are compared by address, but paths from different
+  // interners may still share their directory.
+  if (directory_ == other.directory_) {
+    return true;
+  }
+  auto directory = directory_ ? directory_->view() : std::string_view{};
+  auto otherDirectory =
+      other.directory_ ? other.directory_->view() : std::string_view{};
+  return directory == otherDirectory;
+}
+
+JournalPath JournalPathInterner::intern(RelativePathPiece path) {
+  auto dirname = path.dirname();
+  auto it = directories_.find(dirname.view());
+  if (it == directories_.end()) {
+    if (directories_.size() >= std::max(kMinPruneSize, 2 * sizeAfterPrune_)) {
+      prune();
+    }
+    auto directory = std::make_shared<const RelativePath>(dirname.copy());
+    memoryUsage_ += estimateDirectoryMemoryUsage(*directory);
+    it = directories_.emplace(directory->view(), std::move(directory)).first;
+  }
+  return JournalPath{it->second, std::string{path.basename().view()}};
+}
+
+void JournalPathInterner::prune() {
+  for (auto it = directories_.begin(); it != directories_.end();) {
+    if (it->second.use_count() == 1) {
+      memoryUsage_ -= estimateDirectoryMemoryUsage(*it->second);
+      it = directories_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  sizeAfterPrune_ = directories_.size();
+}
+
+size_t JournalPathInterner::estimateDirectoryMemoryUsage(
+    const RelativePath& directory) {
+  // The slot in the map, the allocation of make_shared holding the reference
+  // counts with the path, and the path's own storage.
+  return sizeof(decltype(directories_)::value_type) +
+      folly::goodMallocSize(2 * sizeof(long) + sizeof(RelativePath)) +
+      facebook::eden::estimateIndirectMemoryUsage(directory);
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/container/F14Map.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * A path recorded in the Journal.
+ *
+ * The directory of the path is shared with all the other paths of the journal
+ * in the same directory, only the final component being owned by the path.
+ * Since most file names fit in the inline storage of a std::string, a
+ * JournalPath usually doesn't allocate any memory of its own.
+ *
+ * JournalPaths are created by a JournalPathInterner.
+ */
+class JournalPath {
+ public:
+  /** An empty path. */
+  JournalPath() = default;
+
+  RelativePath toRelativePath() const;
+
+  /**
+   * Whether this path is in the given directory or in one of its
+   * subdirectories. Every path is under the empty directory.
+   *
+   * Unlike toRelativePath, this doesn't allocate.
+   */
+  bool isUnder(RelativePathPiece directory) const;
+
+  /** Get the memory (in bytes) used by this path and not shared with others */
+  size_t estimateIndirectMemoryUsage() const;
+
+  bool operator==(const JournalPath& other) const;
+  bool operator!=(const JournalPath& other) const {
+    return !(*this == other);
+  }
+
+ private:
+  friend class JournalPathInterner;
+
+  JournalPath(std::shared_ptr<const RelativePath> directory, std::string name)
+      : directory_{std::move(directory)}, name_{std::move(name)} {}
+
+  std::shared_ptr<const RelativePath> directory_;
+  std::string name_;
+};
+
+/**
+ * Shares the directories of the paths recorded in the Journal.
+ *
+ * A directory stays interned while JournalPaths in it remain, and is forgotten
+ * at some point after the last of them is destroyed.
+ *
+ * This class isn't thread-safe, the Journal uses it under its lock.
+ */
+class JournalPathInterner {
+ public:
+  JournalPathInterner() = default;
+  JournalPathInterner(JournalPathInterner&&) = default;
+  JournalPathInterner& operator=(JournalPathInterner&&) = default;
+  JournalPathInterner(const JournalPathInterner&) = delete;
+  JournalPathInterner& operator=(const JournalPathInterner&) = delete;
+
+  JournalPath intern(RelativePathPiece path);
+
+  /** Get memory used (in bytes) by the interned directories */
+  size_t estimateMemoryUsage() const {
+    return memoryUsage_;
+  }
+
+ private:
+  /** Forget the directories that no JournalPath refers to anymore. */
+  void prune();
+
+  static size_t estimateDirectoryMemoryUsage(const RelativePath& directory);
+
+  /** The keys are views of the values. */
+  folly::F14FastMap<std::string_view, std::shared_ptr<const RelativePath>>
+      directories_;
+  size_t memoryUsage_ = 0;
+  /**
+   * The number of directories after the last prune. Pruning again once twice
+   * as many are interned keeps its cost constant per interned directory.
+   */
+  size_t sizeAfterPrune_ = 0;
+};
+
+} // namespace facebook::eden
@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <fmt/format.h>
+#include <atomic>
+
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/journal/Journal.h"
+
+namespace {
+
+using namespace facebook::eden;
+
+constexpr size_t kDirectories = 100;
+constexpr size_t kFilesPerDirectory = 100;
+
+RelativePath filePath(size_t directory, size_t file) {
+  return RelativePath{fmt::format("dir{}/sub/file{}", directory, file)};
+}
+
+/**
+ * A journal holding a change to every file of kDirectories directories.
+ */
+std::unique_ptr<Journal> makeJournal() {
+  auto journal = std::make_unique<Journal>(makeRefPtr<EdenStats>());
+  for (size_t file = 0; file < kFilesPerDirectory; ++file) {
+    for (size_t directory = 0; directory < kDirectories; ++directory) {
+      journal->recordChanged(filePath(directory, file));
+    }
+  }
+  return journal;
+}
+
+void accumulate_range_whole_mount(benchmark::State& state) {
+  auto journal = makeJournal();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(journal->accumulateRange());
+  }
+  state.SetItemsProcessed(
+      state.iterations() * kDirectories * kFilesPerDirectory);
+}
+BENCHMARK(accumulate_range_whole_mount);
+
+void accumulate_range_one_directory(benchmark::State& state) {
+  auto journal = makeJournal();
+  auto root = RelativePath{"dir42"};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(journal->accumulateRange(1, root));
+  }
+  state.SetItemsProcessed(
+      state.iterations() * kDirectories * kFilesPerDirectory);
+}
+BENCHMARK(accumulate_range_one_directory);
+
+void record_changed(benchmark::State& state) {
+  static std::unique_ptr<Journal> journal;
+  if (state.thread_index() == 0) {
+    journal = std::make_unique<Journal>(makeRefPtr<EdenStats>());
+  }
+  std::vector<RelativePath> paths;
+  for (size_t file = 0; file < kFilesPerDirectory; ++file) {
+    paths.push_back(filePath(state.thread_index(), file));
+  }
+
+  size_t i = 0;
+  for (auto _ : state) {
+    // Cycle through files so that the deltas aren't compacted.
+    journal->recordChanged(paths[i++ % paths.size()]);
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  if (state.thread_index() == 0) {
+    journal.reset();
+  }
+}
+BENCHMARK(record_changed)->Threads(1)->Threads(4)->Threads(8)->Threads(16);
+
+void record_created(benchmark::State& state) {
+  static std::unique_ptr<Journal> journal;
+  if (state.thread_index() == 0) {
+    journal = std::make_unique<Journal>(makeRefPtr<EdenStats>());
+  }
+  std::vector<RelativePath> paths;
+  for (size_t file = 0; file < kFilesPerDirectory; ++file) {
+    paths.push_back(filePath(state.thread_index(), file));
+  }
+
+  size_t i = 0;
+  for (auto _ : state) {
+    journal->recordCreated(paths[i++ % paths.size()]);
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  if (state.thread_index() == 0) {
+    journal.reset();
+  }
+}
+BENCHMARK(record_created)->Threads(1)->Threads(4)->Threads(8)->Threads(16);
+
+/**
+ * A journal of the given number of deltas, each to a different file.
+ */
+std::unique_ptr<Journal> makeJournalOfSize(size_t deltas) {
+  auto journal = std::make_unique<Journal>(makeRefPtr<EdenStats>());
+  for (size_t i = 0; i < deltas; ++i) {
+    journal->recordChanged(filePath(i % kDirectories, i / kDirectories));
+  }
+  return journal;
+}
+
+void accumulate_range_history(benchmark::State& state) {
+  auto deltas = state.range(0);
+  auto journal = makeJournalOfSize(deltas);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(journal->accumulateRange());
+  }
+  state.SetItemsProcessed(state.iterations() * deltas);
+}
+BENCHMARK(accumulate_range_history)
+    ->Arg(10'000)
+    ->Arg(100'000)
+    ->Arg(1'000'000)
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * Measures the time to record a history of the given number of deltas, and
+ * reports the memory used per delta.
+ */
+void memory_per_delta(benchmark::State& state) {
+  auto deltas = state.range(0);
+  size_t memoryUsage = 0;
+  for (auto _ : state) {
+    auto journal = makeJournalOfSize(deltas);
+    memoryUsage = journal->estimateMemoryUsage();
+
+    state.PauseTiming();
+    journal.reset();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * deltas);
+  state.counters["bytes_per_delta"] =
+      static_cast<double>(memoryUsage) / deltas;
+}
+BENCHMARK(memory_per_delta)
+    ->Arg(10'000)
+    ->Arg(100'000)
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * Records changes with the given number of subscribers. The journal only
+ * notifies again once its latest delta was observed, so every iteration
+ * observes it, whatever the number of subscribers, to measure the cost of
+ * the notifications alone.
+ */
+void record_changed_with_subscribers(benchmark::State& state) {
+  Journal journal{makeRefPtr<EdenStats>()};
+  std::atomic<size_t> notifications{0};
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    journal.registerSubscriber(
+        [&] { notifications.fetch_add(1, std::memory_order_relaxed); });
+  }
+  std::vector<RelativePath> paths;
+  for (size_t file = 0; file < kFilesPerDirectory; ++file) {
+    paths.push_back(filePath(0, file));
+  }
+
+  size_t i = 0;
+  for (auto _ : state) {
+    journal.recordChanged(paths[i++ % paths.size()]);
+    benchmark::DoNotOptimize(journal.getLatest());
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["notifications"] = benchmark::Counter(
+      static_cast<double>(notifications.load()),
+      benchmark::Counter::kAvgIterations);
+  journal.cancelAllSubscribers();
+}
+BENCHMARK(record_changed_with_subscribers)->Arg(0)->Arg(1)->Arg(16);
+
+void record_changed_while_accumulating(benchmark::State& state) {
+  static std::unique_ptr<Journal> journal;
+  if (state.thread_index() == 0) {
+    journal = makeJournal();
+  }
+  auto path = filePath(state.thread_index(), 0);
+
+  for (auto _ : state) {
+    // One thread reads the journal while the others write to it.
+    if (state.thread_index() == 0) {
+      benchmark::DoNotOptimize(journal->accumulateRange());
+    } else {
+      journal->recordChanged(path);
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  if (state.thread_index() == 0) {
+    journal.reset();
+  }
+}
+BENCHMARK(record_changed_while_accumulating)->Threads(4);
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -9,6 +9,7 @@
 
 #include <folly/portability/GMock.h>
 #include <folly/portability/GTest.h>
+#include <thread>
 
 #include "eden/fs/model/RootId.h"
 
@@ -144,6 +145,37 @@ TEST_F(JournalTest, accumulateRangeRemoveCreateUpdate) {
       summed->changedFilesInOverlay[RelativePath{"test.txt"}].existedAfter);
 }
 
+TEST_F(JournalTest, accumulate_range_under_root) {
+  journal.recordChanged("foo/bar"_relpath);
+  journal.recordChanged("foobar/baz"_relpath);
+  journal.recordRenamed("qux/a"_relpath, "foo/sub/b"_relpath);
+  journal.recordUncleanPaths(
+      RootId{}, RootId{"1111"}, {RelativePath{"foo/c"}, RelativePath{"d"}});
+  journal.recordCreated("qux/e"_relpath);
+
+  auto summed = journal.accumulateRange(1, "foo"_relpath);
+  ASSERT_NE(nullptr, summed);
+  // The range covers the deltas outside of the root.
+  EXPECT_EQ(1, summed->fromSequence);
+  EXPECT_EQ(5, summed->toSequence);
+  EXPECT_EQ(2, summed->snapshotTransitions.size());
+  EXPECT_EQ(2, summed->changedFilesInOverlay.size());
+  EXPECT_EQ(
+      PathChangeInfo(true, true),
+      summed->changedFilesInOverlay.at(RelativePath{"foo/bar"}));
+  EXPECT_EQ(
+      PathChangeInfo(false, true),
+      summed->changedFilesInOverlay.at(RelativePath{"foo/sub/b"}));
+  EXPECT_EQ(
+      (std::unordered_set<RelativePath>{RelativePath{"foo/c"}}),
+      summed->uncleanPaths);
+
+  summed = journal.accumulateRange(5, "foo"_relpath);
+  ASSERT_NE(nullptr, summed);
+  EXPECT_EQ(5, summed->fromSequence);
+  EXPECT_TRUE(summed->changedFilesInOverlay.empty());
+}
+
 namespace {
 
 void checkHashMatches(
@@ -420,6 +452,26 @@ TEST_F(JournalTest, memory_usage) {
   }
 }
 
+TEST_F(JournalTest, paths_share_their_directory) {
+  std::string directory(200, 'd');
+  journal.recordCreated(RelativePath{directory + "/file0"});
+  uint64_t firstMem = journal.estimateMemoryUsage();
+  for (int i = 1; i <= 100; i++) {
+    journal.recordCreated(
+        RelativePath{directory + "/file" + std::to_string(i)});
+  }
+  // The directory is only held once.
+  uint64_t memPerDelta = (journal.estimateMemoryUsage() - firstMem) / 100;
+  EXPECT_LT(memPerDelta, directory.size());
+
+  auto summed = journal.accumulateRange();
+  ASSERT_NE(nullptr, summed);
+  EXPECT_EQ(101, summed->changedFilesInOverlay.size());
+  EXPECT_EQ(
+      PathChangeInfo(false, true),
+      summed->changedFilesInOverlay.at(RelativePath{directory + "/file42"}));
+}
+
 TEST_F(JournalTest, set_get_memory_limit) {
   journal.setMemoryLimit(500);
   ASSERT_EQ(500, journal.getMemoryLimit());
@@ -629,6 +681,21 @@ TEST_F(
   EXPECT_EQ(3u, journal.getLatest()->sequenceID);
 }
 
+TEST_F(JournalTest, peeking_at_the_latest_change_is_not_an_observation) {
+  unsigned calls = 0;
+  auto sub = journal.registerSubscriber([&] { ++calls; });
+  (void)sub;
+
+  journal.recordChanged("foo"_relpath);
+  EXPECT_EQ(1u, calls);
+  EXPECT_EQ(1u, journal.getLatest(/*observe=*/false)->sequenceID);
+  journal.recordChanged("bar"_relpath);
+  EXPECT_EQ(1u, calls);
+  EXPECT_EQ(2u, journal.getLatest()->sequenceID);
+  journal.recordChanged("foo"_relpath);
+  EXPECT_EQ(2u, calls);
+}
+
 TEST_F(JournalTest, all_subscribers_are_notified_after_any_observation) {
   unsigned calls1 = 0;
   unsigned calls2 = 0;
@@ -657,3 +724,88 @@ TEST_F(JournalTest, all_subscribers_are_notified_after_any_observation) {
   EXPECT_EQ(2u, calls1);
   EXPECT_EQ(2u, calls2);
 }
+
+TEST_F(JournalTest, concurrent_writes_are_all_recorded_in_order) {
+  constexpr int kThreads = 4;
+  constexpr int kChangesPerThread = 1000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < kChangesPerThread; ++i) {
+        journal.recordCreated(RelativePath{
+            "dir" + std::to_string(t) + "/file" + std::to_string(i)});
+        if (i % 100 == 0) {
+          journal.recordHashUpdate(RootId{std::to_string(t)});
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  auto summed = journal.accumulateRange();
+  ASSERT_NE(nullptr, summed);
+  EXPECT_FALSE(summed->isTruncated);
+  EXPECT_EQ(1, summed->fromSequence);
+  EXPECT_EQ(kThreads * kChangesPerThread, summed->changedFilesInOverlay.size());
+
+  auto deltas = journal.getDebugRawJournalInfo(1, std::nullopt, 0, codec);
+  EXPECT_EQ(kThreads * (kChangesPerThread + 10), deltas.size());
+  for (size_t i = 1; i < deltas.size(); ++i) {
+    EXPECT_EQ(
+        *deltas[i - 1].fromPosition_ref()->sequenceNumber_ref(),
+        *deltas[i].fromPosition_ref()->sequenceNumber_ref() + 1);
+  }
+}
+
+TEST_F(JournalTest, serialized_journal_carries_on) {
+  journal.recordHashUpdate(RootId{"1111"});
+  journal.recordCreated("foo"_relpath);
+  journal.recordRenamed("foo"_relpath, "bar"_relpath);
+  journal.recordUncleanPaths(
+      RootId{"1111"}, RootId{"2222"}, {RelativePath{"baz"}});
+  journal.recordRemoved("bar"_relpath);
+  auto serialized = journal.serialize();
+
+  Journal restored{edenStats.copy()};
+  ASSERT_TRUE(restored.deserialize(serialized.coalesce()));
+
+  auto latest = restored.getLatest();
+  ASSERT_TRUE(latest);
+  EXPECT_EQ(5, latest->sequenceID);
+  EXPECT_EQ(RootId{"2222"}, latest->toHash);
+
+  auto summed = restored.accumulateRange(2);
+  ASSERT_NE(nullptr, summed);
+  EXPECT_FALSE(summed->isTruncated);
+  EXPECT_EQ(2, summed->fromSequence);
+  EXPECT_EQ(5, summed->toSequence);
+  EXPECT_EQ(
+      (std::vector<RootId>{RootId{"1111"}, RootId{"2222"}}),
+      summed->snapshotTransitions);
+  EXPECT_EQ(
+      (std::unordered_set<RelativePath>{RelativePath{"baz"}}),
+      summed->uncleanPaths);
+  EXPECT_EQ(2, summed->changedFilesInOverlay.size());
+  EXPECT_EQ(
+      PathChangeInfo(false, false),
+      summed->changedFilesInOverlay.at(RelativePath{"foo"}));
+  EXPECT_EQ(
+      PathChangeInfo(false, false),
+      summed->changedFilesInOverlay.at(RelativePath{"bar"}));
+
+  // New deltas follow the restored ones.
+  restored.recordChanged("qux"_relpath);
+  EXPECT_EQ(6, restored.getLatest()->sequenceID);
+}
+
+TEST_F(JournalTest, invalid_serialized_journal_is_rejected) {
+  journal.recordChanged("foo"_relpath);
+  auto serialized = journal.serialize();
+  auto data = serialized.coalesce();
+
+  Journal restored{edenStats.copy()};
+  EXPECT_FALSE(restored.deserialize(data.subpiece(0, data.size() - 1)));
+  EXPECT_FALSE(restored.getLatest());
+}
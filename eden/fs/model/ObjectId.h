@@ -31,6 +31,11 @@ class ObjectId {
   // 20-byte hashes inline.
   using Storage = folly::fbstring;
 
+  /**
+   * ObjectIds up to this many bytes are stored without a heap allocation.
+   */
+  static constexpr size_t kMaxInlineSize = 23;
+
   /**
    * Create an empty object id
    */
@@ -7,6 +7,7 @@
 
 #include "eden/fs/model/Tree.h"
 #include <folly/io/IOBuf.h>
+#include "eden/fs/utils/Memory.h"
 
 namespace facebook::eden {
 
@@ -19,10 +20,15 @@ size_t Tree::getSizeBytes() const {
   size_t internal_size = sizeof(*this);
 
   size_t indirect_size =
-      folly::goodMallocSize(sizeof(TreeEntry) * entries_.capacity());
+      folly::goodMallocSize(sizeof(value_type) * entries_.capacity());
 
   for (auto& entry : entries_) {
     indirect_size += estimateIndirectMemoryUsage(entry.first.value());
+    // Most ObjectIds fit in the fbstring's inline storage, but Hg proxy hashes
+    // that embed a path do not.
+    if (entry.second.getHash().size() > ObjectId::kMaxInlineSize) {
+      indirect_size += folly::goodMallocSize(entry.second.getHash().size());
+    }
   }
   return internal_size + indirect_size;
 }
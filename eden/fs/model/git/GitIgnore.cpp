@@ -7,7 +7,11 @@
 
 #include "eden/fs/model/git/GitIgnore.h"
 
+#include <folly/container/F14Map.h>
 #include <algorithm>
+#include <limits>
+#include <string>
+#include <vector>
 #include "eden/fs/model/git/GitIgnorePattern.h"
 
 using folly::StringPiece;
@@ -15,16 +19,113 @@ using std::string;
 
 namespace facebook::eden {
 
+/**
+ * The patterns of a gitignore file, along with indexes of the ones that only
+ * compare basenames with a plain string, which are looked up rather than
+ * tried one at a time.
+ */
+struct GitIgnore::Rules {
+  static constexpr size_t kNone = std::numeric_limits<size_t>::max();
+
+  /**
+   * The highest precedence patterns for a given string, among those that match
+   * any type of file and those that only match directories.
+   */
+  struct Lookup {
+    size_t any{kNone};
+    size_t dirOnly{kNone};
+
+    void add(size_t index, bool mustBeDir) {
+      auto& best = mustBeDir ? dirOnly : any;
+      best = std::min(best, index);
+    }
+
+    size_t get(FileType fileType) const {
+      return fileType == TYPE_DIR ? std::min(any, dirOnly) : any;
+    }
+  };
+
+  explicit Rules(std::vector<GitIgnorePattern> patterns);
+
+  MatchResult
+  match(RelativePathPiece path, PathComponentPiece basename, FileType fileType)
+      const;
+
+  /*
+   * Sorted from highest to lowest precedence (the reverse of the order they
+   * are actually listed in the .gitignore file).
+   */
+  std::vector<GitIgnorePattern> patterns;
+  folly::F14FastMap<std::string, Lookup> literals;
+  folly::F14FastMap<std::string, Lookup> suffixes;
+  // The distinct lengths of the keys of suffixes, in increasing order.
+  std::vector<size_t> suffixLengths;
+  // The indexes of the other patterns, in increasing order.
+  std::vector<size_t> others;
+};
+
+GitIgnore::Rules::Rules(std::vector<GitIgnorePattern> p)
+    : patterns{std::move(p)} {
+  for (size_t index = 0; index < patterns.size(); ++index) {
+    const auto& pattern = patterns[index];
+    if (auto literal = pattern.getLiteralBasename()) {
+      literals[literal->str()].add(index, pattern.mustBeDir());
+    } else if (auto suffix = pattern.getBasenameSuffix()) {
+      suffixes[suffix->str()].add(index, pattern.mustBeDir());
+      suffixLengths.push_back(suffix->size());
+    } else {
+      others.push_back(index);
+    }
+  }
+  std::sort(suffixLengths.begin(), suffixLengths.end());
+  suffixLengths.erase(
+      std::unique(suffixLengths.begin(), suffixLengths.end()),
+      suffixLengths.end());
+}
+
+GitIgnore::MatchResult GitIgnore::Rules::match(
+    RelativePathPiece path,
+    PathComponentPiece basename,
+    FileType fileType) const {
+  // Find the highest precedence indexed pattern that matches, then only try
+  // the other patterns that take precedence over it.
+  auto name = basename.view();
+  size_t best = kNone;
+  if (auto it = literals.find(name); it != literals.end()) {
+    best = it->second.get(fileType);
+  }
+  for (auto length : suffixLengths) {
+    if (length > name.size()) {
+      break;
+    }
+    auto it = suffixes.find(name.substr(name.size() - length));
+    if (it != suffixes.end()) {
+      best = std::min(best, it->second.get(fileType));
+    }
+  }
+
+  for (auto index : others) {
+    if (index > best) {
+      break;
+    }
+    auto result = patterns[index].match(path, basename, fileType);
+    if (result != NO_MATCH) {
+      return result;
+    }
+  }
+
+  if (best != kNone) {
+    return patterns[best].getMatchResult();
+  }
+  return NO_MATCH;
+}
+
 GitIgnore::GitIgnore() {}
 
 GitIgnore::GitIgnore(GitIgnore const&) = default;
 GitIgnore& GitIgnore::operator=(GitIgnore const&) = default;
-GitIgnore::GitIgnore(GitIgnore&&) noexcept(
-    std::is_nothrow_move_constructible<std::vector<GitIgnorePattern>>::value) =
-    default;
-GitIgnore& GitIgnore::operator=(GitIgnore&&) noexcept(
-    std::is_nothrow_move_assignable<std::vector<GitIgnorePattern>>::value) =
-    default;
+GitIgnore::GitIgnore(GitIgnore&&) noexcept = default;
+GitIgnore& GitIgnore::operator=(GitIgnore&&) noexcept = default;
 GitIgnore::~GitIgnore() {}
 
 void GitIgnore::loadFile(StringPiece contents) {
@@ -66,21 +167,21 @@ void GitIgnore::loadFile(StringPiece contents) {
   // reverse them so that we can do a forward walk through our patterns and
   // stop at the first match.
   std::reverse(newRules.begin(), newRules.end());
-  std::swap(rules_, newRules);
+  if (newRules.empty()) {
+    rules_.reset();
+  } else {
+    rules_ = std::make_shared<const Rules>(std::move(newRules));
+  }
 }
 
 GitIgnore::MatchResult GitIgnore::match(
     RelativePathPiece path,
     PathComponentPiece basename,
     FileType fileType) const {
-  for (const auto& pattern : rules_) {
-    auto result = pattern.match(path, basename, fileType);
-    if (result != NO_MATCH) {
-      return result;
-    }
+  if (!rules_) {
+    return NO_MATCH;
   }
-
-  return NO_MATCH;
+  return rules_->match(path, basename, fileType);
 }
 
 string GitIgnore::matchString(MatchResult result) {
@@ -8,13 +8,12 @@
 #pragma once
 
 #include <folly/Range.h>
+#include <memory>
 #include <vector>
 #include "eden/fs/utils/PathFuncs.h"
 
 namespace facebook::eden {
 
-class GitIgnorePattern;
-
 /**
  * A GitIgnore object represents the contents of a single .gitignore file
  *
@@ -43,6 +42,9 @@ class GitIgnorePattern;
  * untracked files inside this directory (and any children directories) are
  * always ignored: explicit include rules cannot be used to unignore files
  * inside an ignored directory.
+ *
+ * The parsed rules are immutable and shared between copies, so copying a
+ * GitIgnore is cheap.
  */
 class GitIgnore {
  public:
@@ -91,8 +93,7 @@ class GitIgnore {
 
   GitIgnore();
   virtual ~GitIgnore();
-  GitIgnore(GitIgnore&&) noexcept(
-      std::is_nothrow_move_constructible<std::vector<GitIgnorePattern>>::value);
+  GitIgnore(GitIgnore&&) noexcept;
   GitIgnore(GitIgnore const&);
   GitIgnore& operator=(GitIgnore const&);
 
@@ -103,8 +104,7 @@ class GitIgnore {
    * providing synchronization between this operation and anyone else using the
    * GitIgnore object from other threads.
    */
-  GitIgnore& operator=(GitIgnore&&) noexcept(
-      std::is_nothrow_move_assignable<std::vector<GitIgnorePattern>>::value);
+  GitIgnore& operator=(GitIgnore&&) noexcept;
 
   /**
    * Parse the contents of a gitignore file.
@@ -162,7 +162,7 @@ class GitIgnore {
    * @return true if there are no rules.
    */
   bool empty() const {
-    return rules_.empty();
+    return !rules_;
   }
 
   /**
@@ -173,12 +173,13 @@ class GitIgnore {
   static std::string matchString(MatchResult result);
 
  private:
+  struct Rules;
+
   /*
-   * The patterns loaded from the gitignore file.  These are sorted from
-   * highest to lowest precedence (the reverse of the order they are actually
-   * listed in the .gitignore file).
+   * The patterns loaded from the gitignore file, or nullptr if there are
+   * none.
    */
-  std::vector<GitIgnorePattern> rules_;
+  std::shared_ptr<const Rules> rules_;
 };
 
 } // namespace facebook::eden
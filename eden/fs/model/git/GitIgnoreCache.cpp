@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/model/git/GitIgnoreCache.h"
+
+#include <algorithm>
+
+namespace facebook::eden {
+
+GitIgnoreCache::GitIgnoreCache(size_t maxEntries)
+    : cache_{folly::in_place, std::max(maxEntries, size_t{1})} {}
+
+GitIgnore GitIgnoreCache::get(std::string contents) {
+  {
+    auto cache = cache_.lock();
+    auto it = cache->find(contents);
+    if (it != cache->end()) {
+      return it->second;
+    }
+  }
+
+  // Parse while the lock is not held. Concurrent misses for the same contents
+  // parse them more than once, but get equivalent rules.
+  GitIgnore ignore;
+  ignore.loadFile(contents);
+  cache_.lock()->set(std::move(contents), ignore);
+  return ignore;
+}
+
+} // namespace facebook::eden
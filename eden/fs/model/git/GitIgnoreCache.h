@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <mutex>
+#include <string>
+#include "eden/fs/model/git/GitIgnore.h"
+
+namespace facebook::eden {
+
+/**
+ * The parsed rules of recently loaded gitignore files, keyed by their
+ * contents, so that every diff, in every mount, does not parse the same
+ * .gitignore files again.
+ */
+class GitIgnoreCache {
+ public:
+  explicit GitIgnoreCache(size_t maxEntries);
+
+  GitIgnoreCache(const GitIgnoreCache&) = delete;
+  GitIgnoreCache& operator=(const GitIgnoreCache&) = delete;
+
+  /**
+   * Returns the rules of a gitignore file with the given contents, parsing
+   * them if they are not cached.
+   */
+  GitIgnore get(std::string contents);
+
+ private:
+  folly::Synchronized<
+      folly::EvictingCacheMap<std::string, GitIgnore>,
+      std::mutex>
+      cache_;
+};
+
+} // namespace facebook::eden
@@ -137,11 +137,34 @@ optional<GitIgnorePattern> GitIgnorePattern::parseLine(StringPiece line) {
     return std::nullopt;
   }
 
-  return GitIgnorePattern(flags, std::move(matcher).value());
+  // Note patterns that match basenames against a plain string, or a "*"
+  // followed by one, so that GitIgnore can look them up rather than try them
+  // one at a time. These make up most of the patterns in practice.
+  std::string literal;
+  if (flags & FLAG_BASENAME_ONLY) {
+    auto isPlain = [](StringPiece str) {
+      return str.find_first_of("*?[\\") == StringPiece::npos;
+    };
+    if (isPlain(line)) {
+      flags |= FLAG_LITERAL;
+      literal = line.str();
+    } else if (line.size() > 1 && line[0] == '*' && isPlain(line.subpiece(1))) {
+      flags |= FLAG_SUFFIX;
+      literal = line.subpiece(1).str();
+    }
+  }
+
+  return GitIgnorePattern(
+      flags, std::move(matcher).value(), std::move(literal));
 }
 
-GitIgnorePattern::GitIgnorePattern(uint32_t flags, GlobMatcher&& matcher)
-    : flags_(flags), matcher_(std::move(matcher)) {}
+GitIgnorePattern::GitIgnorePattern(
+    uint32_t flags,
+    GlobMatcher&& matcher,
+    std::string literal)
+    : flags_(flags),
+      matcher_(std::move(matcher)),
+      literal_(std::move(literal)) {}
 
 GitIgnorePattern::~GitIgnorePattern() {}
 
@@ -9,6 +9,7 @@
 
 #include <folly/Range.h>
 #include <optional>
+#include <string>
 #include "eden/fs/model/git/GitIgnore.h"
 #include "eden/fs/model/git/GlobMatcher.h"
 
@@ -69,6 +70,42 @@ class GitIgnorePattern {
       PathComponentPiece basename,
       GitIgnore::FileType fileType) const;
 
+  /**
+   * If this pattern matches exactly the basenames equal to some string,
+   * returns that string.
+   */
+  std::optional<folly::StringPiece> getLiteralBasename() const {
+    if (flags_ & FLAG_LITERAL) {
+      return folly::StringPiece{literal_};
+    }
+    return std::nullopt;
+  }
+
+  /**
+   * If this pattern matches exactly the basenames ending with some string
+   * (that is, it is "*" followed by that string), returns that string.
+   */
+  std::optional<folly::StringPiece> getBasenameSuffix() const {
+    if (flags_ & FLAG_SUFFIX) {
+      return folly::StringPiece{literal_};
+    }
+    return std::nullopt;
+  }
+
+  /**
+   * Whether this pattern only matches directories.
+   */
+  bool mustBeDir() const {
+    return flags_ & FLAG_MUST_BE_DIR;
+  }
+
+  /**
+   * The result of match() for the paths that match this pattern.
+   */
+  GitIgnore::MatchResult getMatchResult() const {
+    return (flags_ & FLAG_INCLUDE) ? GitIgnore::INCLUDE : GitIgnore::EXCLUDE;
+  }
+
  private:
   /**
    * Flag values that can be bitwise-ORed to create the flags_ value.
@@ -82,9 +119,16 @@ class GitIgnorePattern {
     // The pattern did not contain /, so it only matches against the last
     // component of any path.
     FLAG_BASENAME_ONLY = 0x04,
+    // The pattern only matches basenames equal to literal_.
+    FLAG_LITERAL = 0x08,
+    // The pattern only matches basenames ending with literal_.
+    FLAG_SUFFIX = 0x10,
   };
 
-  GitIgnorePattern(uint32_t flags, GlobMatcher&& matcher);
+  GitIgnorePattern(
+      uint32_t flags,
+      GlobMatcher&& matcher,
+      std::string literal = {});
 
   /**
    * A bit set of the Flags defined above.
@@ -94,6 +138,10 @@ class GitIgnorePattern {
    * The GlobMatcher object for performing matching.
    */
   GlobMatcher matcher_;
+  /**
+   * Set along with FLAG_LITERAL or FLAG_SUFFIX.
+   */
+  std::string literal_;
 };
 
 } // namespace facebook::eden
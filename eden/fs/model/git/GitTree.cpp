@@ -7,9 +7,10 @@
 
 #include "eden/fs/model/git/GitTree.h"
 #include <fmt/format.h>
-#include <folly/io/Cursor.h>
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
+#include <limits>
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/model/TreeEntry.h"
@@ -29,75 +30,140 @@ enum GitModeMask {
   SYMLINK = 0120000,
 };
 
-TreePtr deserializeGitTree(const ObjectId& hash, const IOBuf* treeData) {
-  folly::io::Cursor cursor(treeData);
+namespace {
+
+// A mode should only be 6 or 7 characters.
+constexpr size_t kMaxModeLength = 10;
+constexpr size_t kHashSize = Hash20::RAW_SIZE;
+
+TreeEntryType parseMode(
+    const ObjectId& hash,
+    const unsigned char* begin,
+    const unsigned char* end) {
+  if (begin == end) {
+    throw invalid_argument("Tree entry has an empty mode.");
+  }
+  uint32_t mode = 0;
+  for (auto p = begin; p != end; ++p) {
+    if (*p < '0' || *p > '7') {
+      throw invalid_argument("Did not parse expected number of octal chars.");
+    }
+    mode = mode * 8 + (*p - '0');
+  }
+
+  switch (mode) {
+    case GitModeMask::DIRECTORY:
+      return TreeEntryType::TREE;
+    case GitModeMask::REGULAR_FILE:
+      return TreeEntryType::REGULAR_FILE;
+    case GitModeMask::REGULAR_EXECUTABLE_FILE:
+      return TreeEntryType::EXECUTABLE_FILE;
+    case GitModeMask::SYMLINK:
+      return TreeEntryType::SYMLINK;
+    case GitModeMask::GIT_LINK:
+      throwf<std::domain_error>(
+          "Gitlinks are not currently supported: {:o} in object {}",
+          mode,
+          hash);
+  }
+  throw invalid_argument(
+      fmt::format("Unrecognized mode: {:o} in object {}", mode, hash));
+}
+
+/**
+ * Returns the first c in [begin, begin + maxLength) and before end, or
+ * nullptr.
+ */
+const unsigned char* findByte(
+    const unsigned char* begin,
+    const unsigned char* end,
+    char c,
+    size_t maxLength = std::numeric_limits<size_t>::max()) {
+  return static_cast<const unsigned char*>(
+      memchr(begin, c, std::min(maxLength, static_cast<size_t>(end - begin))));
+}
+
+} // namespace
+
+// Entries are parsed straight out of the contiguous tree data. The names and
+// hashes are not copied into temporary strings, and memchr, which libc
+// vectorizes, finds the end of each name.
+TreePtr deserializeGitTree(const ObjectId& hash, folly::ByteRange treeData) {
+  auto p = treeData.begin();
+  auto end = treeData.end();
 
   // Find the end of the header and extract the size.
-  if (cursor.readFixedString(5) != "tree ") {
+  if (treeData.size() < 5 || memcmp(p, "tree ", 5) != 0) {
     throw invalid_argument("Contents did not start with expected header.");
   }
+  p += 5;
 
   // 25 characters is long enough to represent any legitimate length
   size_t maxSizeLength = 25;
-  auto sizeStr = cursor.readTerminatedString('\0', maxSizeLength);
-  auto contentSize = folly::to<unsigned int>(sizeStr);
-  if (contentSize != cursor.length()) {
+  auto sizeEnd = findByte(p, end, '\0', maxSizeLength + 1);
+  if (!sizeEnd) {
+    throw invalid_argument("Header is not nul terminated.");
+  }
+  auto contentSize =
+      folly::to<unsigned int>(folly::StringPiece{folly::ByteRange{p, sizeEnd}});
+  p = sizeEnd + 1;
+  if (contentSize != static_cast<size_t>(end - p)) {
     throw invalid_argument("Size in header should match contents");
   }
 
-  // Scan the data and populate entries, as appropriate.
+  // Every entry ends with the nul byte after its name and a hash, so they
+  // can be counted ahead of time to size the entries once.
+  size_t entryCount = 0;
+  for (auto q = p; q != end; ++entryCount) {
+    auto nameEnd = findByte(q, end, '\0');
+    if (!nameEnd || static_cast<size_t>(end - nameEnd) <= kHashSize) {
+      break;
+    }
+    q = nameEnd + 1 + kHashSize;
+  }
+
+  // Scan the data and populate entries, as appropriate. Git sorts trees
+  // almost like PathMap does, so entries are mostly appended in order.
   Tree::container entries{kPathMapDefaultCaseSensitive};
-  while (!cursor.isAtEnd()) {
-    // Extract the mode.
-    // This should only be 6 or 7 characters.
-    // Stop scanning if we haven't seen a space in 10 characters
-    size_t maxModeLength = 10;
-    auto modeStr = cursor.readTerminatedString(' ', maxModeLength);
-    size_t modeEndIndex;
-    auto mode = std::stoi(modeStr, &modeEndIndex, /* base */ 8);
-    if (modeEndIndex != modeStr.size()) {
-      throw invalid_argument("Did not parse expected number of octal chars.");
+  entries.reserve(entryCount);
+  while (p != end) {
+    // Stop scanning if we haven't seen a space in kMaxModeLength characters.
+    auto modeEnd = findByte(p, end, ' ', kMaxModeLength + 1);
+    if (!modeEnd) {
+      throw invalid_argument("Tree entry mode is not space terminated.");
     }
+    auto fileType = parseMode(hash, p, modeEnd);
+    p = modeEnd + 1;
 
     // Extract the name.
-    auto name = cursor.readTerminatedString();
+    auto nameEnd = findByte(p, end, '\0');
+    if (!nameEnd) {
+      throw invalid_argument("Tree entry name is not nul terminated.");
+    }
+    auto name = folly::StringPiece{folly::ByteRange{p, nameEnd}};
+    p = nameEnd + 1;
 
     // Extract the hash.
-    Hash20::Storage hashBytes;
-    cursor.pull(hashBytes.data(), hashBytes.size());
-
-    // Determine the individual fields from the mode.
-
-    TreeEntryType fileType;
-    if (mode == GitModeMask::DIRECTORY) {
-      fileType = TreeEntryType::TREE;
-    } else if (mode == GitModeMask::REGULAR_FILE) {
-      fileType = TreeEntryType::REGULAR_FILE;
-    } else if (mode == GitModeMask::REGULAR_EXECUTABLE_FILE) {
-      fileType = TreeEntryType::EXECUTABLE_FILE;
-    } else if (mode == GitModeMask::SYMLINK) {
-      fileType = TreeEntryType::SYMLINK;
-    } else if (mode == GitModeMask::GIT_LINK) {
-      throwf<std::domain_error>(
-          "Gitlinks are not currently supported: {:o} in object {}",
-          mode,
-          hash);
-    } else {
-      throw invalid_argument(
-          fmt::format("Unrecognized mode: {:o} in object {}", mode, hash));
+    if (static_cast<size_t>(end - p) < kHashSize) {
+      throw invalid_argument("Tree entry hash is truncated.");
     }
+    ObjectId id{folly::ByteRange{p, kHashSize}};
+    p += kHashSize;
 
-    auto pathName = PathComponentPiece{name};
-    entries.emplace(pathName, ObjectId(hashBytes), fileType);
+    entries.emplace(PathComponentPiece{name}, std::move(id), fileType);
   }
 
   return std::make_shared<TreePtr::element_type>(std::move(entries), hash);
 }
 
-// Convenience wrapper which accepts a ByteRange
-TreePtr deserializeGitTree(const ObjectId& hash, folly::ByteRange treeData) {
-  IOBuf buf(IOBuf::WRAP_BUFFER, treeData);
-  return deserializeGitTree(hash, &buf);
+TreePtr deserializeGitTree(const ObjectId& hash, const IOBuf* treeData) {
+  if (!treeData->isChained()) {
+    return deserializeGitTree(
+        hash, folly::ByteRange{treeData->data(), treeData->length()});
+  }
+  auto coalesced = treeData->cloneCoalescedAsValue();
+  return deserializeGitTree(
+      hash, folly::ByteRange{coalesced.data(), coalesced.length()});
 }
 
 } // namespace facebook::eden
@@ -10,6 +10,7 @@
 #include <fmt/core.h>
 #include <folly/logging/xlog.h>
 #include <algorithm>
+#include <array>
 #include <limits>
 
 using folly::Expected;
@@ -60,6 +61,13 @@ enum : uint8_t {
   GLOB_CHAR_CLASS_NEGATED = ']',
   GLOB_CHAR_CLASS_END = '\x00',
   GLOB_CHAR_CLASS_RANGE = '\x01',
+  // GLOB_CHAR_CLASS and GLOB_CHAR_CLASS_NEGATED are only used while parsing a
+  // bracket expression. Once it is parsed, it is replaced with
+  // GLOB_CHAR_CLASS_BITMAP, which is followed by kCharClassBitmapSize bytes
+  // holding one bit for each character, set if the character matches. This
+  // lets a character be matched with a single lookup rather than by scanning
+  // the list of characters and ranges.
+  GLOB_CHAR_CLASS_BITMAP = 'B',
   // GLOB_QMARK matches any single character except for '/'
   GLOB_QMARK = '?',
   // GLOB_ENDS_WITH matches a literal section at the end of the string.
@@ -72,6 +80,45 @@ enum : uint8_t {
   GLOB_FALSE = 'F',
 };
 
+constexpr size_t kCharClassBitmapSize = 256 / 8;
+
+/**
+ * Replace the GLOB_CHAR_CLASS or GLOB_CHAR_CLASS_NEGATED data that starts at
+ * classIdx and runs to the end of the pattern buffer with a
+ * GLOB_CHAR_CLASS_BITMAP.
+ */
+void compileCharClassBitmap(vector<uint8_t>* pattern, size_t classIdx) {
+  std::array<uint8_t, kCharClassBitmapSize> bitmap{};
+  auto set = [&](uint8_t ch) { bitmap[ch >> 3] |= (1 << (ch & 7)); };
+
+  bool negated = (*pattern)[classIdx] == GLOB_CHAR_CLASS_NEGATED;
+  size_t idx = classIdx + 1;
+  while ((*pattern)[idx] != GLOB_CHAR_CLASS_END) {
+    if ((*pattern)[idx] == GLOB_CHAR_CLASS_RANGE) {
+      for (unsigned ch = (*pattern)[idx + 1]; ch <= (*pattern)[idx + 2]; ++ch) {
+        set(ch);
+      }
+      idx += 3;
+    } else {
+      set((*pattern)[idx]);
+      ++idx;
+    }
+  }
+  XDCHECK_EQ(idx + 1, pattern->size());
+
+  if (negated) {
+    for (auto& byte : bitmap) {
+      byte = ~byte;
+    }
+  }
+  // A character class never matches a '/'.
+  bitmap['/' >> 3] &= ~(1 << ('/' & 7));
+
+  pattern->resize(classIdx);
+  pattern->push_back(GLOB_CHAR_CLASS_BITMAP);
+  pattern->insert(pattern->end(), bitmap.begin(), bitmap.end());
+}
+
 /// A set of character intervals. This is used during parsing to deduplicate
 /// ranges within a character class.
 class CharIntervalSet {
@@ -139,20 +186,65 @@ namespace facebook::eden {
 
 namespace {
 
-bool isStringPieceEqual(
-    std::string_view left,
-    std::string_view right,
+// Maps each byte to its ASCII lowercase form.
+constexpr std::array<uint8_t, 256> kAsciiLower = [] {
+  std::array<uint8_t, 256> table{};
+  for (size_t c = 0; c < table.size(); ++c) {
+    table[c] = static_cast<uint8_t>(
+        c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c);
+  }
+  return table;
+}();
+
+/**
+ * Compare text with a literal of the pattern. When matching case
+ * insensitively, the literals are lowercased when the pattern is compiled, so
+ * only the text needs to be folded.
+ */
+bool isLiteralEqual(
+    std::string_view text,
+    std::string_view literal,
     CaseSensitivity caseSensitive) {
   if (caseSensitive == CaseSensitivity::Sensitive) {
-    return left == right;
-  } else {
-    return std::equal(
-        left.begin(),
-        left.end(),
-        right.begin(),
-        right.end(),
-        folly::AsciiCaseInsensitive{});
+    return text == literal;
+  }
+  if (text.size() != literal.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < text.size(); ++i) {
+    if (kAsciiLower[static_cast<uint8_t>(text[i])] !=
+        static_cast<uint8_t>(literal[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Find the first occurrence of a non-empty literal of the pattern in text,
+ * which is lowercased when matching case insensitively.
+ */
+size_t findLiteral(
+    std::string_view text,
+    std::string_view literal,
+    CaseSensitivity caseSensitive) {
+  if (caseSensitive == CaseSensitivity::Sensitive) {
+    return text.find(literal);
   }
+  if (text.size() < literal.size()) {
+    return std::string_view::npos;
+  }
+  // Look for the first byte of the literal before comparing the rest of it.
+  auto first = static_cast<uint8_t>(literal[0]);
+  auto rest = literal.substr(1);
+  size_t last = text.size() - literal.size();
+  for (size_t i = 0; i <= last; ++i) {
+    if (kAsciiLower[static_cast<uint8_t>(text[i])] == first &&
+        isLiteralEqual(text.substr(i + 1, rest.size()), rest, caseSensitive)) {
+      return i;
+    }
+  }
+  return std::string_view::npos;
 }
 
 char toLower(char c) {
@@ -227,6 +319,11 @@ Expected<GlobMatcher, string> GlobMatcher::create(
   };
 
   auto appendLiteralChar = [&](char c) {
+    // Literals are stored lowercase when matching case insensitively, so that
+    // only the text needs to be folded when matching.
+    if (caseSensitive == CaseSensitivity::Insensitive) {
+      c = toLower(c);
+    }
     if (curOpcodeIdx >= 0 && result[curOpcodeIdx] == GLOB_LITERAL &&
         result[curOpcodeIdx + 1] < 0xff) {
       // Just append this byte to the end of the current literal section.
@@ -356,6 +453,8 @@ Expected<size_t, string> GlobMatcher::parseBracketExpr(
   XDCHECK_LT(idx, glob.size());
   XDCHECK_EQ(glob[idx], '[');
 
+  auto classIdx = pattern->size();
+
   // Check for a leading '!' or '^'
   if (idx + 1 >= glob.size()) {
     return folly::makeUnexpected<string>("unterminated bracket sequence");
@@ -519,6 +618,7 @@ Expected<size_t, string> GlobMatcher::parseBracketExpr(
     addCharClassRange(interval.first, interval.second, pattern);
   }
   pattern->push_back(GLOB_CHAR_CLASS_END);
+  compileCharClassBitmap(pattern, classIdx);
   return idx;
 }
 
@@ -639,7 +739,7 @@ bool GlobMatcher::tryMatchAt(
         if (text.size() - textIdx != length) {
           return false;
         }
-        return isStringPieceEqual(
+        return isLiteralEqual(
             text.substr(textIdx, length),
             std::string_view{reinterpret_cast<const char*>(literal), length},
             caseSensitive_);
@@ -649,7 +749,7 @@ bool GlobMatcher::tryMatchAt(
       if (text.size() - textIdx < length) {
         return false;
       }
-      if (!isStringPieceEqual(
+      if (!isLiteralEqual(
               text.substr(textIdx, length),
               std::string_view{reinterpret_cast<const char*>(literal), length},
               caseSensitive_)) {
@@ -686,16 +786,8 @@ bool GlobMatcher::tryMatchAt(
         patternIdx += 2 + literalLength;
         auto nextSlash = text.find('/', textIdx);
         while (true) {
-          auto textPiece = text.substr(textIdx);
-          auto literalIdx = caseSensitive_ == CaseSensitivity::Sensitive
-              ? qfind(
-                    folly::StringPiece{textPiece},
-                    folly::StringPiece{literalPattern},
-                    folly::AsciiCaseSensitive{})
-              : qfind(
-                    folly::StringPiece{textPiece},
-                    folly::StringPiece{literalPattern},
-                    folly::AsciiCaseInsensitive{});
+          auto literalIdx =
+              findLiteral(text.substr(textIdx), literalPattern, caseSensitive_);
           if (literalIdx == std::string_view::npos) {
             // No match.
             return false;
@@ -750,7 +842,7 @@ bool GlobMatcher::tryMatchAt(
       if (text.size() - textIdx < length) {
         return false;
       }
-      if (!isStringPieceEqual(
+      if (!isLiteralEqual(
               text.substr(text.size() - length),
               std::string_view{reinterpret_cast<const char*>(literal), length},
               caseSensitive_)) {
@@ -823,14 +915,10 @@ bool GlobMatcher::tryMatchAt(
         return false;
       }
 
-      if (pattern_[patternIdx] == GLOB_CHAR_CLASS) {
-        // An inclusive character class
-        if (!charClassMatch(ch, &patternIdx)) {
-          return false;
-        }
-      } else if (pattern_[patternIdx] == GLOB_CHAR_CLASS_NEGATED) {
-        // An exclusive character class
-        if (charClassMatch(ch, &patternIdx)) {
+      if (pattern_[patternIdx] == GLOB_CHAR_CLASS_BITMAP) {
+        const uint8_t* bitmap = pattern_.data() + patternIdx + 1;
+        patternIdx += 1 + kCharClassBitmapSize;
+        if (!(bitmap[ch >> 3] & (1 << (ch & 7)))) {
           return false;
         }
       } else if (pattern_[patternIdx] == GLOB_QMARK) {
@@ -851,55 +939,4 @@ bool GlobMatcher::tryMatchAt(
   return textIdx == text.size();
 }
 
-bool GlobMatcher::charClassMatch(uint8_t ch, size_t* patternIdx) const {
-  size_t idx = *patternIdx + 1;
-  while (true) {
-    XDCHECK_LT(idx, pattern_.size());
-    if (pattern_[idx] == GLOB_CHAR_CLASS_END) {
-      // Reached the end of the character class with no match.
-      *patternIdx = idx + 1;
-      return false;
-    } else if (pattern_[idx] == GLOB_CHAR_CLASS_RANGE) {
-      XDCHECK_LT(idx + 2, pattern_.size());
-      uint8_t lowBound = pattern_[idx + 1];
-      uint8_t highBound = pattern_[idx + 2];
-      idx += 3;
-      if (lowBound <= ch && ch <= highBound) {
-        // Found a match
-        break;
-      }
-    } else {
-      if (ch == pattern_[idx]) {
-        // Found a match
-        ++idx;
-        break;
-      }
-      ++idx;
-    }
-  }
-
-  // If we broke out of the loop then we found a match.
-  // Advance patternIdx to the end of the character class.
-  //
-  // We just keep scanning through the data until we find GLOB_CHAR_CLASS_END.
-  //
-  // In theory we could put a length byte after the GLOB_CHAR_CLASS opcode,
-  // similar to what we do for GLOB_LITERAL, so we could avoid scanning here.
-  // However this would introduce some complications: we would potentially have
-  // to re-arrange the data so it fits in 255 bytes.  (Any character class can
-  // be represented in 255 bytes, but our naive literal encoding currently
-  // might end up using more than 255 bytes.)  In practice character class data
-  // is normally very short, so the cost of a scan doesn't really matter here.
-  while (true) {
-    if (pattern_[idx] == GLOB_CHAR_CLASS_END) {
-      *patternIdx = idx + 1;
-      return true;
-    } else if (pattern_[idx] == GLOB_CHAR_CLASS_RANGE) {
-      idx += 3;
-    } else {
-      ++idx;
-    }
-  }
-}
-
 } // namespace facebook::eden
@@ -103,17 +103,6 @@ class GlobMatcher {
   bool tryMatchAt(std::string_view text, size_t textIdx, size_t patternIdx)
       const;
 
-  /**
-   * Check to see if the given character matches the character class opcode
-   * starting at the specified index in the pattern buffer.
-   *
-   * Returns true if the character matches, and false otherwise.
-   *
-   * The patternIdx argument is updated to point to the next opcode after this
-   * character calss.
-   */
-  bool charClassMatch(uint8_t ch, size_t* patternIdx) const;
-
   /**
    * pattern_ is a pre-processed version of the glob pattern.
    *
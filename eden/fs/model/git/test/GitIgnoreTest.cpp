@@ -8,6 +8,7 @@
 #include <folly/portability/GTest.h>
 
 #include "eden/fs/model/git/GitIgnore.h"
+#include "eden/fs/model/git/GitIgnoreCache.h"
 
 using namespace facebook::eden;
 
@@ -668,3 +669,51 @@ TEST(GitIgnore, directory) {
   // path known to be a file.  It expects ignored directories earlier in the
   // path to have already been filtered out.
 }
+
+TEST(GitIgnore, indexedPatternPrecedence) {
+  // Patterns that are looked up by basename must still follow "last match
+  // wins" with respect to each other and to the other patterns.
+  GitIgnore ignore;
+  ignore.loadFile(
+      "*.o\n"
+      "!keep.o\n"
+      "build/*.o\n"
+      "out\n"
+      "!out/\n"
+      "*.tar.gz\n"
+      "!*.gz\n"
+      "*~\n"
+      "!important.txt~\n");
+
+  EXPECT_IGNORE(ignore, EXCLUDE, "foo.o");
+  EXPECT_IGNORE(ignore, INCLUDE, "keep.o");
+  EXPECT_IGNORE(ignore, EXCLUDE, "build/keep.o");
+  EXPECT_IGNORE(ignore, INCLUDE, "src/keep.o");
+  EXPECT_IGNORE(ignore, EXCLUDE, ".o");
+  EXPECT_IGNORE(ignore, NO_MATCH, "foo.oo");
+
+  EXPECT_IGNORE(ignore, EXCLUDE, "out");
+  EXPECT_IGNORE_DIR(ignore, INCLUDE, "out");
+  EXPECT_IGNORE_DIR(ignore, INCLUDE, "src/out");
+
+  EXPECT_IGNORE(ignore, INCLUDE, "foo.tar.gz");
+  EXPECT_IGNORE(ignore, INCLUDE, "foo.gz");
+  EXPECT_IGNORE(ignore, NO_MATCH, "foo.tar");
+
+  EXPECT_IGNORE(ignore, EXCLUDE, "notes.txt~");
+  EXPECT_IGNORE(ignore, INCLUDE, "important.txt~");
+  EXPECT_IGNORE(ignore, EXCLUDE, "~");
+}
+
+TEST(GitIgnore, cache) {
+  GitIgnoreCache cache{2};
+  auto ignore = cache.get("*.o\n");
+  EXPECT_IGNORE(ignore, EXCLUDE, "foo.o");
+  EXPECT_IGNORE(ignore, NO_MATCH, "foo.c");
+
+  // The same contents give the same rules.
+  EXPECT_IGNORE(cache.get("*.o\n"), EXCLUDE, "foo.o");
+  EXPECT_IGNORE(cache.get("*.c\n"), EXCLUDE, "foo.c");
+  EXPECT_IGNORE(cache.get("*.h\n"), EXCLUDE, "foo.h");
+  EXPECT_TRUE(cache.get("").empty());
+}
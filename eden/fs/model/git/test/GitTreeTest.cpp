@@ -163,6 +163,36 @@ TEST(GitTree, deserializeEmpty) {
   EXPECT_EQ(0, tree->size());
 }
 
+TEST(GitTree, deserializeChainedBuffer) {
+  auto gitTreeObject = folly::to<string>(
+      string("tree 61\x00", 8),
+      string("100644 a.txt\x00", 13),
+      toBinaryHash("3a8f8eb91101860fd8484154885838bf322964d0"),
+      string("40000 a\x00", 8),
+      toBinaryHash("e95798e17f694c227b7a8441cc5c7dae50a187d0"));
+  ObjectId hash = ObjectId::sha1(StringPiece{gitTreeObject});
+
+  // Split the object in the middle of the first name. Git sorts a.txt
+  // before the directory a, unlike Tree.
+  auto buf = IOBuf::copyBuffer(gitTreeObject.data(), 16);
+  buf->prependChain(IOBuf::copyBuffer(
+      gitTreeObject.data() + 16, gitTreeObject.size() - 16));
+  auto tree = deserializeGitTree(hash, buf.get());
+
+  ASSERT_EQ(2, tree->size());
+  EXPECT_EQ("a", tree->begin()->first);
+  EXPECT_TRUE(tree->begin()->second.isTree());
+  EXPECT_EQ(
+      ObjectId::fromHex("e95798e17f694c227b7a8441cc5c7dae50a187d0"),
+      tree->begin()->second.getHash());
+  auto file = *tree->find("a.txt"_pc);
+  EXPECT_EQ(
+      facebook::eden::TreeEntryType::REGULAR_FILE, file.second.getType());
+  EXPECT_EQ(
+      ObjectId::fromHex("3a8f8eb91101860fd8484154885838bf322964d0"),
+      file.second.getHash());
+}
+
 TEST(GitTree, testBadDeserialize) {
   ObjectId zero = ObjectId::fromHex("0000000000000000000000000000000000000000");
   // Partial header
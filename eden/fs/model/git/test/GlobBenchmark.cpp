@@ -325,6 +325,37 @@ GBENCHMARK(basenameGlob2_re2_case_insensitive)(benchmark::State& state) {
       state, "\\.[^/]*\\.sw[^/]", basenameCorpus, CaseSensitivity::Insensitive);
 }
 
+GBENCHMARK(charClass_globmatch)(benchmark::State& state) {
+  runBenchmark<GlobMatcherImpl>(state, "*.[chm]", basenameCorpus);
+}
+
+GBENCHMARK(charClass_globmatch_case_insensitive)(benchmark::State& state) {
+  runBenchmark<GlobMatcherImpl>(
+      state, "*.[chm]", basenameCorpus, CaseSensitivity::Insensitive);
+}
+
+GBENCHMARK(charClass_wildmatch)(benchmark::State& state) {
+  runBenchmark<WildmatchImpl>(state, "*.[chm]", basenameCorpus);
+}
+
+GBENCHMARK(charClass_re2)(benchmark::State& state) {
+  runBenchmark<RE2Impl>(state, "[^/]*\\.[chm]", basenameCorpus);
+}
+
+GBENCHMARK(negatedCharClass_globmatch)(benchmark::State& state) {
+  runBenchmark<GlobMatcherImpl>(
+      state, "[![:upper:]]*[![:digit:]_-]", basenameCorpus);
+}
+
+GBENCHMARK(negatedCharClass_wildmatch)(benchmark::State& state) {
+  runBenchmark<WildmatchImpl>(
+      state, "[![:upper:]]*[![:digit:]_-]", basenameCorpus);
+}
+
+GBENCHMARK(negatedCharClass_re2)(benchmark::State& state) {
+  runBenchmark<RE2Impl>(state, "[^/A-Z][^/]*[^/0-9_-]", basenameCorpus);
+}
+
 GBENCHMARK(fullpath_globmatch)(benchmark::State& state) {
   runBenchmark<GlobMatcherImpl>(state, "**/*io*o*", fullnameCorpus);
 }
@@ -355,4 +386,13 @@ GBENCHMARK(fullpath_re2_case_insensitive)(benchmark::State& state) {
       CaseSensitivity::Insensitive);
 }
 
+GBENCHMARK(substring_globmatch)(benchmark::State& state) {
+  runBenchmark<GlobMatcherImpl>(state, "*Test*", basenameCorpus);
+}
+
+GBENCHMARK(substring_globmatch_case_insensitive)(benchmark::State& state) {
+  runBenchmark<GlobMatcherImpl>(
+      state, "*Test*", basenameCorpus, CaseSensitivity::Insensitive);
+}
+
 BENCHMARK_MAIN();
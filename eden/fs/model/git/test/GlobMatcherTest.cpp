@@ -433,6 +433,16 @@ TEST(Glob, testRangeMerging) {
   EXPECT_NOMATCH("A", "[b-ca-c]");
 }
 
+TEST(Glob, testHighBytesInCharClass) {
+  EXPECT_MATCH("\xe9", "[\xe0-\xff]");
+  EXPECT_MATCH("\xff", "[\xe0-\xff]");
+  EXPECT_NOMATCH("\xdf", "[\xe0-\xff]");
+  EXPECT_MATCH("\x80", "[!\x01-\x7f]");
+  EXPECT_NOMATCH("a", "[!\x01-\x7f]");
+  EXPECT_MATCH("\xff", "[^a]");
+  EXPECT_NOMATCH("/", "[!a]");
+}
+
 TEST(Glob, testCaseInsensitive) {
   EXPECT_CASE_INSENSITIVE_MATCH("a", "[A-Z]");
   EXPECT_CASE_INSENSITIVE_MATCH("A", "[a-z]");
@@ -451,6 +461,12 @@ TEST(Glob, testCaseInsensitive) {
   EXPECT_CASE_INSENSITIVE_MATCH("Abc", "a*");
   EXPECT_CASE_INSENSITIVE_MATCH("ABC", "A?c");
   EXPECT_CASE_INSENSITIVE_MATCH("ABC", "A[b]c");
+  EXPECT_CASE_INSENSITIVE_MATCH("fooBARbaz", "*bar*");
+  EXPECT_CASE_INSENSITIVE_MATCH("foobarbaz", "*BaR*");
+  EXPECT_CASE_INSENSITIVE_MATCH("foo/Bar.TXT", "**/*.txt");
+  EXPECT_CASE_INSENSITIVE_MATCH("FOO.txt", "*.TxT");
+  EXPECT_CASE_INSENSITIVE_NOMATCH("foo/BAR", "*bar");
+  EXPECT_CASE_INSENSITIVE_NOMATCH("foobaz", "*BAR*");
 
   EXPECT_CASE_INSENSITIVE_MATCH("A", "[Abc]");
   EXPECT_CASE_INSENSITIVE_MATCH("a", "[Abc]");
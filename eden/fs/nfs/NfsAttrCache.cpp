@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/nfs/NfsAttrCache.h"
+
+namespace facebook::eden {
+
+NfsAttrCache::NfsAttrCache(size_t maxEntries) : maxEntries_{maxEntries} {}
+
+uint64_t NfsAttrCache::getGeneration() const {
+  return state_.rlock()->generation;
+}
+
+std::optional<fattr3> NfsAttrCache::get(InodeNumber ino) const {
+  auto state = state_.rlock();
+  auto it = state->entries.find(ino);
+  if (it == state->entries.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+void NfsAttrCache::insert(
+    InodeNumber ino,
+    const fattr3& attr,
+    uint64_t generation) {
+  auto state = state_.wlock();
+  if (state->generation != generation) {
+    return;
+  }
+  if (state->entries.size() >= maxEntries_) {
+    state->entries.clear();
+  }
+  state->entries.insert_or_assign(ino, attr);
+}
+
+void NfsAttrCache::invalidate(InodeNumber ino) {
+  auto state = state_.wlock();
+  state->generation++;
+  state->entries.erase(ino);
+}
+
+void NfsAttrCache::invalidateAll() {
+  auto state = state_.wlock();
+  state->generation++;
+  state->entries.clear();
+}
+
+} // namespace facebook::eden
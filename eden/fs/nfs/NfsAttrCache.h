@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <optional>
+
+#include "eden/fs/inodes/InodeNumber.h"
+#include "eden/fs/nfs/NfsdRpc.h"
+
+namespace facebook::eden {
+
+/**
+ * Attributes of the inodes of a mount, as last replied to a GETATTR.
+ *
+ * NFS clients revalidate their caches with a GETATTR whenever they use a file,
+ * the attributes of most of these did not change since the previous one.
+ *
+ * Attributes are computed without holding the cache lock, and may therefore
+ * be outdated by the time they are inserted. To not cache these, the
+ * generation must be read before computing the attributes, and passed to
+ * insert(): attributes are only cached if no invalidation happened since.
+ */
+class NfsAttrCache {
+ public:
+  /**
+   * Cache the attributes of at most maxEntries inodes. The cache is cleared
+   * when it is full.
+   */
+  explicit NfsAttrCache(size_t maxEntries);
+
+  NfsAttrCache(const NfsAttrCache&) = delete;
+  NfsAttrCache& operator=(const NfsAttrCache&) = delete;
+
+  /**
+   * Return the generation to pass to insert().
+   */
+  uint64_t getGeneration() const;
+
+  /**
+   * Return the cached attributes of the inode, if any.
+   */
+  std::optional<fattr3> get(InodeNumber ino) const;
+
+  /**
+   * Cache the attributes of the inode, unless the cache was invalidated since
+   * generation was returned by getGeneration().
+   */
+  void insert(InodeNumber ino, const fattr3& attr, uint64_t generation);
+
+  /**
+   * Drop the cached attributes of the inode. Must be called once a change to
+   * the inode completed.
+   */
+  void invalidate(InodeNumber ino);
+
+  /**
+   * Drop all the cached attributes.
+   */
+  void invalidateAll();
+
+ private:
+  struct State {
+    folly::F14FastMap<InodeNumber, fattr3> entries;
+    uint64_t generation = 0;
+  };
+
+  const size_t maxEntries_;
+  folly::Synchronized<State> state_;
+};
+
+} // namespace facebook::eden
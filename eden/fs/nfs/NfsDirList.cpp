@@ -45,41 +45,54 @@ NfsDirList::NfsDirList(uint32_t count, nfsv3Procs listType)
     : remaining_(computeInitialRemaining(count)),
       list_(computeListType(listType)) {}
 
+NfsDirList::NfsDirList(uint32_t dirCount, uint32_t maxCount)
+    : remaining_(computeInitialRemaining(dirCount)),
+      remainingMax_(computeInitialRemaining(maxCount)),
+      list_(computeListType(nfsv3Procs::readdirplus)) {}
+
 bool NfsDirList::add(
     folly::StringPiece name,
     InodeNumber ino,
     uint64_t offset) {
-  auto fn = [name, ino, offset](auto&& list, uint32_t& remainingSize) {
-    size_t neededSize;
-    using ListType = std::decay_t<decltype(list->list)>;
-    using EntryT = typename ListType::value_type;
-
+  // The serialized sizes include a boolean indicating that this is not the end
+  // of the list.
+  if (XdrList<entryplus3>* list = std::get_if<XdrList<entryplus3>>(&list_)) {
     // For entryplus3s, we initially add an empty post_op_attr. This is
     // because we don't have access to stat data in this layer. In a
     // separate layer, we will fill in the post_op_attr with the
-    // appropriate stat data. For entry3s, we don't need this extra data.
-    EntryT entry = EntryT{ino, name.str(), offset};
+    // appropriate stat data, so account for it against maxcount already.
+    static const size_t kAttributesSize =
+        XdrTrait<post_op_attr>::serializedSize(post_op_attr{fattr3{}}) -
+        XdrTrait<post_op_attr>::serializedSize(post_op_attr{});
+    entryplus3 entry{ino, name.str(), offset};
 
-    // The serialized size includes a boolean indicating that this is not
-    // the end of the list.
-    neededSize = XdrTrait<EntryT>::serializedSize(entry) +
+    size_t neededSize = XdrTrait<uint64_t>::serializedSize(entry.fileid) +
+        XdrTrait<std::string>::serializedSize(entry.name) +
+        XdrTrait<uint64_t>::serializedSize(entry.cookie) +
         XdrTrait<bool>::serializedSize(true);
-
-    if (neededSize > remainingSize) {
+    size_t neededMaxSize = XdrTrait<entryplus3>::serializedSize(entry) +
+        kAttributesSize + XdrTrait<bool>::serializedSize(true);
+    if (neededSize > remaining_ || neededMaxSize > remainingMax_) {
       return false;
     }
 
-    remainingSize -= neededSize;
+    remaining_ -= neededSize;
+    remainingMax_ -= neededMaxSize;
     list->list.push_back(std::move(entry));
     return true;
-  };
+  }
 
-  if (XdrList<entryplus3>* list = std::get_if<XdrList<entryplus3>>(&list_)) {
-    return fn(list, remaining_);
-  } else {
-    XdrList<entry3>* entry3List = &std::get<XdrList<entry3>>(list_);
-    return fn(entry3List, remaining_);
+  auto& list = std::get<XdrList<entry3>>(list_);
+  entry3 entry{ino, name.str(), offset};
+  size_t neededSize = XdrTrait<entry3>::serializedSize(entry) +
+      XdrTrait<bool>::serializedSize(true);
+  if (neededSize > remaining_) {
+    return false;
   }
+
+  remaining_ -= neededSize;
+  list.list.push_back(std::move(entry));
+  return true;
 }
 
 } // namespace facebook::eden
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <limits>
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/nfs/NfsdRpc.h"
 
@@ -28,6 +29,14 @@ class NfsDirList {
  public:
   explicit NfsDirList(uint32_t count, nfsv3Procs listType);
 
+  /**
+   * Build a READDIRPLUS list. Per RFC 1813, dirCount bounds the size of the
+   * fileid, name and cookie of the entries, while maxCount bounds the size of
+   * the whole reply, including the attributes and file handle of each entry
+   * that are filled in after the entry is added.
+   */
+  NfsDirList(uint32_t dirCount, uint32_t maxCount);
+
   NfsDirList(NfsDirList&&) = default;
   NfsDirList& operator=(NfsDirList&&) = default;
 
@@ -61,6 +70,7 @@ class NfsDirList {
 
  private:
   uint32_t remaining_;
+  uint32_t remainingMax_{std::numeric_limits<uint32_t>::max()};
   std::variant<XdrList<entry3>, XdrList<entryplus3>> list_{};
 };
 
@@ -358,8 +358,9 @@ class NfsDispatcher {
 
   /**
    * Variant of readdir that reads the content of the directory referenced by
-   * the InodeNumber dir and also reads stat data for each file. As with
-   * readdir, a maximum of count bytes will be added to the returned NfsDirList.
+   * the InodeNumber dir and also reads stat data for each file. The entries
+   * added to the returned NfsDirList are bounded by dirCount and maxCount as
+   * described in NfsDirList's constructor.
    *
    * Readdirplus behaves similarly to readdir for very large directories. See
    * the comment above for more info.
@@ -368,7 +369,8 @@ class NfsDispatcher {
   virtual ImmediateFuture<ReaddirRes> readdirplus(
       InodeNumber dir,
       FileOffset offset,
-      uint32_t count,
+      uint32_t dirCount,
+      uint32_t maxCount,
       const ObjectFetchContextPtr& context) = 0;
 
   virtual ImmediateFuture<struct statfs> statfs(
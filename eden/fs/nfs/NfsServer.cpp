@@ -18,6 +18,7 @@ NfsServer::NfsServer(
     PrivHelper* privHelper,
     folly::EventBase* evb,
     uint64_t numServicingThreads,
+    uint64_t numMountServicingThreads,
     uint64_t maxInflightRequests,
     bool shouldRunOurOwnRpcbindServer,
     const std::shared_ptr<StructuredLogger>& structuredLogger)
@@ -27,6 +28,8 @@ NfsServer::NfsServer(
           numServicingThreads,
           std::make_unique<EdenTaskQueue>(maxInflightRequests),
           std::make_unique<folly::NamedThreadFactory>("NfsThreadPool"))),
+      numMountServicingThreads_{numMountServicingThreads},
+      maxInflightRequests_{maxInflightRequests},
       rpcbindd_(
           shouldRunOurOwnRpcbindServer
               ? std::make_shared<Rpcbindd>(evb_, threadPool_, structuredLogger)
@@ -75,11 +78,19 @@ NfsServer::NfsMountInfo NfsServer::registerMount(
     CaseSensitivity caseSensitive,
     uint32_t iosize,
     size_t traceBusCapacity) {
+  auto threadPool = threadPool_;
+  if (numMountServicingThreads_ != 0) {
+    threadPool = std::make_shared<folly::CPUThreadPoolExecutor>(
+        numMountServicingThreads_,
+        std::make_unique<EdenTaskQueue>(maxInflightRequests_),
+        std::make_unique<folly::NamedThreadFactory>("NfsMountThreadPool"));
+  }
+
   auto nfsd = std::unique_ptr<Nfsd3, FsChannelDeleter>{new Nfsd3{
       privHelper_,
       AbsolutePath{path},
       evb_,
-      threadPool_,
+      std::move(threadPool),
       std::move(dispatcher),
       straceLogger,
       std::move(processNameCache),
@@ -35,7 +35,9 @@ class NfsServer {
    * This will handle the lifetime of the various programs involved in the NFS
    * protocol including mountd and nfsd. The requests will be serviced by a
    * blocking thread pool initialized with numServicingThreads and
-   * maxInflightRequests.
+   * maxInflightRequests. When numMountServicingThreads isn't 0, the requests
+   * of each mount are instead serviced by a thread pool dedicated to the mount
+   * with that many threads.
    *
    * One mountd program will be created per NfsServer, while one nfsd program
    * will be created per-mount point, this allows nfsd program to be only aware
@@ -45,6 +47,7 @@ class NfsServer {
       PrivHelper* privHelper,
       folly::EventBase* evb,
       uint64_t numServicingThreads,
+      uint64_t numMountServicingThreads,
       uint64_t maxInflightRequests,
       bool shouldRunOurOwnRpcbindServer,
       const std::shared_ptr<StructuredLogger>& structuredLogger);
@@ -122,6 +125,8 @@ class NfsServer {
   PrivHelper* const privHelper_;
   folly::EventBase* evb_;
   std::shared_ptr<folly::Executor> threadPool_;
+  const uint64_t numMountServicingThreads_;
+  const uint64_t maxInflightRequests_;
   std::shared_ptr<Rpcbindd> rpcbindd_;
   Mountd mountd_;
 };
@@ -7,6 +7,7 @@
 
 #include "eden/fs/nfs/Nfsd3.h"
 
+#include <chrono>
 #include <memory>
 
 #include <folly/Utility.h>
@@ -19,6 +20,7 @@
 #include "eden/fs/nfs/NfsdRpc.h"
 #include "eden/fs/privhelper/PrivHelper.h"
 #include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/telemetry/FsEventLogger.h"
 #include "eden/fs/telemetry/LogEvent.h"
 #include "eden/fs/telemetry/RequestMetricsScope.h"
@@ -38,6 +40,54 @@ namespace facebook::eden {
 namespace {
 static_assert(CheckSize<NfsTraceEvent, 40>());
 
+/**
+ * Maximum number of inodes whose attributes are cached by a mount. fattr3 is
+ * 84 bytes, this bounds the cache to a few tens of MB.
+ */
+constexpr size_t kMaxAttrCacheEntries = 256 * 1024;
+
+/**
+ * Largest read and write advertised to clients, iosize being the preferred
+ * one. Clients are mounted with iosize, but may negotiate up to this.
+ */
+constexpr uint32_t kMaxIoSize = 1024 * 1024;
+
+/**
+ * Which cached attributes an NFS procedure may change.
+ */
+enum class AttrChange {
+  // The procedure doesn't change attributes.
+  None,
+  // The procedure changes the attributes of the inode whose file handle starts
+  // its arguments, if only its atime.
+  Inode,
+  // The procedure changes the attributes of several inodes, like the
+  // directories whose entries it adds or removes.
+  All,
+};
+
+AttrChange nfsProcAttrChange(uint32_t procNumber) {
+  switch (static_cast<nfsv3Procs>(procNumber)) {
+    case nfsv3Procs::setattr:
+    case nfsv3Procs::read:
+    case nfsv3Procs::write:
+    case nfsv3Procs::readdir:
+    case nfsv3Procs::readdirplus:
+      return AttrChange::Inode;
+    case nfsv3Procs::create:
+    case nfsv3Procs::mkdir:
+    case nfsv3Procs::symlink:
+    case nfsv3Procs::mknod:
+    case nfsv3Procs::remove:
+    case nfsv3Procs::rmdir:
+    case nfsv3Procs::rename:
+    case nfsv3Procs::link:
+      return AttrChange::All;
+    default:
+      return AttrChange::None;
+  }
+}
+
 class Nfsd3ServerProcessor final : public RpcServerProcessor {
  public:
   explicit Nfsd3ServerProcessor(
@@ -49,7 +99,8 @@ class Nfsd3ServerProcessor final : public RpcServerProcessor {
       folly::Promise<FsStopDataPtr>& stopPromise,
       ProcessAccessLog& processAccessLog,
       std::atomic<size_t>& traceDetailedArguments,
-      std::shared_ptr<TraceBus<NfsTraceEvent>>& traceBus)
+      std::shared_ptr<TraceBus<NfsTraceEvent>>& traceBus,
+      NfsAttrCache& attrCache)
       : dispatcher_(std::move(dispatcher)),
         straceLogger_(straceLogger),
         structuredLogger_(structuredLogger),
@@ -59,7 +110,8 @@ class Nfsd3ServerProcessor final : public RpcServerProcessor {
         processAccessLog_{processAccessLog},
         traceDetailedArguments_(traceDetailedArguments),
         metadataSizeMismatchLogged_(false),
-        traceBus_(traceBus) {}
+        traceBus_(traceBus),
+        attrCache_(attrCache) {}
 
   Nfsd3ServerProcessor(const Nfsd3ServerProcessor&) = delete;
   Nfsd3ServerProcessor(Nfsd3ServerProcessor&&) = delete;
@@ -188,6 +240,8 @@ class Nfsd3ServerProcessor final : public RpcServerProcessor {
   // size metadata.
   std::atomic_bool metadataSizeMismatchLogged_;
   std::shared_ptr<TraceBus<NfsTraceEvent>>& traceBus_;
+  // Owned by the nfs3d, like the stopPromise_.
+  NfsAttrCache& attrCache_;
 };
 
 /**
@@ -274,7 +328,9 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::null(
 ImmediateFuture<PathComponent> extractPathComponent(std::string str) {
   return makeImmediateFutureWith([&]() {
     try {
-      return PathComponent{str};
+      // Names are deserialized into their own string, move it to not allocate
+      // a copy of it.
+      return PathComponent{std::move(str)};
     } catch (const PathComponentNotUtf8& ex) {
       throw std::system_error(EINVAL, std::system_category(), ex.what());
     }
@@ -289,23 +345,32 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::getattr(
 
   auto args = XdrTrait<GETATTR3args>::deserialize(deser);
 
+  if (auto attr = attrCache_.get(args.object.ino)) {
+    dispatcher_->getStats()->increment(&NfsStats::attrCacheHit);
+    GETATTR3res res{{{nfsstat3::NFS3_OK, GETATTR3resok{*attr}}}};
+    XdrTrait<GETATTR3res>::serialize(ser, res);
+    return folly::unit;
+  }
+  dispatcher_->getStats()->increment(&NfsStats::attrCacheMiss);
+
+  auto generation = attrCache_.getGeneration();
   return dispatcher_->getattr(args.object.ino, context.getObjectFetchContext())
-      .thenTry(
-          [ser = std::move(ser)](const folly::Try<struct stat>& try_) mutable {
-            if (try_.hasException()) {
-              GETATTR3res res{
-                  {{exceptionToNfsError(try_.exception()), std::monostate{}}}};
-              XdrTrait<GETATTR3res>::serialize(ser, res);
-            } else {
-              const auto& stat = try_.value();
-
-              GETATTR3res res{
-                  {{nfsstat3::NFS3_OK, GETATTR3resok{statToFattr3(stat)}}}};
-              XdrTrait<GETATTR3res>::serialize(ser, res);
-            }
+      .thenTry([this, ser = std::move(ser), ino = args.object.ino, generation](
+                   const folly::Try<struct stat>& try_) mutable {
+        if (try_.hasException()) {
+          GETATTR3res res{
+              {{exceptionToNfsError(try_.exception()), std::monostate{}}}};
+          XdrTrait<GETATTR3res>::serialize(ser, res);
+        } else {
+          auto attr = statToFattr3(try_.value());
+          attrCache_.insert(ino, attr, generation);
 
-            return folly::unit;
-          });
+          GETATTR3res res{{{nfsstat3::NFS3_OK, GETATTR3resok{attr}}}};
+          XdrTrait<GETATTR3res>::serialize(ser, res);
+        }
+
+        return folly::unit;
+      });
 }
 
 ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::setattr(
@@ -629,11 +694,17 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::read(
 /**
  * Generate a unique per-EdenFS instance write cookie.
  *
- * TODO(xavierd): Note that for now this will always be 0 as this is to handle
- * the case where the server restart while the client isn't aware.
+ * A client that sees the cookie change between a WRITE and the following
+ * COMMIT assumes that the server restarted and lost the data, and writes it
+ * again. Using the time at which the first cookie was generated makes it
+ * differ between an EdenFS and the one that took over its mounts.
  */
 writeverf3 makeWriteVerf() {
-  return 0;
+  static const writeverf3 verf = folly::to_unsigned(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count());
+  return verf;
 }
 
 ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::write(
@@ -676,11 +747,10 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::write(
                     /*file_wcc*/ statToWccData(
                         writeRes.preStat, writeRes.postStat),
                     /*count*/ folly::to_narrow(writeRes.written),
-                    // TODO(xavierd): the following is a total lie and we
-                    // should call inode->fdatasync() in the case where
-                    // args.stable is anything other than
-                    // stable_how::UNSTABLE. For testing purpose, this is
-                    // OK.
+                    // The data was written to the overlay, where it
+                    // survives EdenFS crashing or restarting: this is as
+                    // stable as it needs to be for a client that runs on
+                    // the same host, and spares it from sending COMMITs.
                     /*committed*/ stable_how::FILE_SYNC,
                     /*verf*/ makeWriteVerf(),
                 }}}};
@@ -1233,12 +1303,12 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::readdirplus(
     return folly::unit;
   }
 
-  // TODO(T107744453): Should probably acount for args.maxcount somewhere
   return dispatcher_
       ->readdirplus(
           args.dir.ino,
           args.cookie,
           args.dircount,
+          args.maxcount,
           context.getObjectFetchContext())
       .thenTry([this, ino = args.dir.ino, ser = std::move(ser), &context](
                    folly::Try<NfsDispatcher::ReaddirRes> try_) mutable {
@@ -1252,15 +1322,6 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::readdirplus(
                 XdrTrait<READDIRPLUS3res>::serialize(ser, res);
               } else {
                 auto& readdirRes = try_.value();
-                /* TODO @cuev: This is prob where we'd use args.maxcount:
-                 *
-                 * From rfc 1813 section 3.3.17:
-                 *
-                 * maxcount
-                 *    The maximum size of the READDIRPLUS3resok structure, in
-                 *    bytes. The size must include all XDR overhead. The server
-                 *    is free to return fewer than maxcount bytes of data.
-                 */
                 READDIRPLUS3res res{
                     {{nfsstat3::NFS3_OK,
                       READDIRPLUS3resok{
@@ -1345,10 +1406,10 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::fsinfo(
         FSINFO3resok{
             // TODO(xavierd): fill the post_op_attr.
             post_op_attr{},
-            /*rtmax=*/iosize_,
+            /*rtmax=*/std::max(iosize_, kMaxIoSize),
             /*rtpref=*/iosize_,
             /*rtmult=*/1,
-            /*wtmax=*/iosize_,
+            /*wtmax=*/std::max(iosize_, kMaxIoSize),
             /*wtpref=*/iosize_,
             /*wtmult=*/1,
             /*dtpref=*/iosize_,
@@ -1390,11 +1451,36 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::pathconf(
 }
 
 ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::commit(
-    folly::io::Cursor /*deser*/,
+    folly::io::Cursor deser,
     folly::io::QueueAppender ser,
     NfsRequestContext& context) {
-  serializeReply(ser, accept_stat::PROC_UNAVAIL, context.getXid());
-  return folly::unit;
+  serializeReply(ser, accept_stat::SUCCESS, context.getXid());
+  auto args = XdrTrait<COMMIT3args>::deserialize(deser);
+
+  // All the WRITEs are replied to as FILE_SYNC, there is therefore never any
+  // unstable data to commit. Clients may still send a COMMIT, reply with the
+  // current attributes of the file.
+  return dispatcher_->getattr(args.file.ino, context.getObjectFetchContext())
+      .thenTry([ser = std::move(ser)](
+                   const folly::Try<struct stat>& tryStat) mutable {
+        if (tryStat.hasException()) {
+          COMMIT3res res{
+              {{exceptionToNfsError(tryStat.exception()), COMMIT3resfail{}}}};
+          XdrTrait<COMMIT3res>::serialize(ser, res);
+        } else {
+          COMMIT3res res{
+              {{nfsstat3::NFS3_OK,
+                COMMIT3resok{
+                    /*file_wcc*/ wcc_data{
+                        /*before*/ pre_op_attr{},
+                        /*after*/ statToPostOpAttr(tryStat),
+                    },
+                    /*verf*/ makeWriteVerf(),
+                }}}};
+          XdrTrait<COMMIT3res>::serialize(ser, res);
+        }
+        return folly::unit;
+      });
 }
 
 NfsArgsDetails formatNull(folly::io::Cursor /*deser*/) {
@@ -1671,9 +1757,15 @@ NfsArgsDetails formatPathconf(folly::io::Cursor deser) {
   return {fmt::format(FMT_STRING("ino={}"), args.object.ino), args.object.ino};
 }
 
-NfsArgsDetails formatCommit(folly::io::Cursor /*deser*/) {
-  // TODO(xavierd): Fill this in.
-  return {""};
+NfsArgsDetails formatCommit(folly::io::Cursor deser) {
+  auto args = XdrTrait<COMMIT3args>::deserialize(deser);
+  return {
+      fmt::format(
+          FMT_STRING("ino={}, offset={}, count={}"),
+          args.file.ino,
+          args.offset,
+          args.count),
+      args.file.ino};
 }
 
 using Handler = ImmediateFuture<folly::Unit> (Nfsd3ServerProcessor::*)(
@@ -1933,11 +2025,23 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::dispatchRpc(
   // The data that contextRef reference to is alive for the duration of the
   // handler function and is deleted when context unique_ptr goes out of the
   // scope at the `ensure` lambda.
+  auto args = deser;
   return makeImmediateFutureWith([&] {
            return (this->*handlerEntry.handler)(
                std::move(deser), std::move(ser), *context);
          })
-      .thenTry([&handlerEntry](folly::Try<folly::Unit>&& res) {
+      .thenTry([this, &handlerEntry, args, procNumber](
+                   folly::Try<folly::Unit>&& res) mutable {
+        // Invalidate the attributes once the change completed so that a
+        // GETATTR that raced with it doesn't cache the previous ones.
+        auto attrChange = nfsProcAttrChange(procNumber);
+        if (attrChange == AttrChange::Inode && res.hasValue()) {
+          attrCache_.invalidate(XdrTrait<nfs_fh3>::deserialize(args).ino);
+        } else if (attrChange != AttrChange::None) {
+          // Also when the arguments of the procedure couldn't be parsed.
+          attrCache_.invalidateAll();
+        }
+
         if (res.hasException()) {
           if (auto* err = res.exception().get_exception<RpcParsingError>()) {
             err->setProcedureContext(std::string{handlerEntry.name});
@@ -1982,6 +2086,8 @@ Nfsd3::Nfsd3(
     size_t traceBusCapacity)
     : privHelper_{privHelper},
       mountPath_{std::move(mountPath)},
+      stats_{dispatcher->getStats().copy()},
+      attrCache_{kMaxAttrCacheEntries},
       server_(RpcServer::create(
           std::make_shared<Nfsd3ServerProcessor>(
               std::move(dispatcher),
@@ -1992,13 +2098,17 @@ Nfsd3::Nfsd3(
               stopPromise_,
               processAccessLog_,
               traceDetailedArguments_,
-              traceBus_),
+              traceBus_,
+              attrCache_),
           evb,
           std::move(threadPool),
-          structuredLogger)),
+          structuredLogger,
+          /*transferSize=*/iosize)),
       processAccessLog_(std::move(processNameCache)),
       invalidationExecutor_{
           folly::SerialExecutor::create(folly::getGlobalCPUExecutor())},
+      pendingInvalidations_{std::make_shared<
+          folly::Synchronized<folly::F14FastSet<AbsolutePath>>>()},
       traceDetailedArguments_{0},
       traceBus_{TraceBus<NfsTraceEvent>::create("NfsTrace", traceBusCapacity)} {
   traceSubscriptionHandles_.push_back(traceBus_->subscribeFunction(
@@ -2065,7 +2175,25 @@ folly::SemiFuture<folly::Unit> Nfsd3::unmount() {
 }
 
 void Nfsd3::invalidate(AbsolutePath path, mode_t mode) {
-  invalidationExecutor_->add([path = std::move(path), mode]() {
+  // The inodes of the path aren't known here, and may have changed along
+  // with their parent directory.
+  attrCache_.invalidateAll();
+
+  stats_->increment(&NfsStats::invalidationRequested);
+  // Checkout invalidates a directory for each of its changed entries. An
+  // invalidation that didn't run yet will observe all the changes made until
+  // it does: don't queue the path twice.
+  if (!pendingInvalidations_->wlock()->insert(path).second) {
+    return;
+  }
+
+  invalidationExecutor_->add([path = std::move(path),
+                              mode,
+                              pendingInvalidations = pendingInvalidations_,
+                              stats = stats_.copy()]() {
+    // Changes made from now on need another invalidation.
+    pendingInvalidations->wlock()->erase(path);
+    stats->increment(&NfsStats::invalidationPerformed);
     try {
       XLOG(DBG9) << "Invalidating: " << path.c_str() << " mode: " << mode;
       { chmod(path.c_str(), mode); }
@@ -2100,6 +2228,9 @@ void Nfsd3::invalidateInodes(
 }
 
 ImmediateFuture<folly::Unit> Nfsd3::completeInvalidations() {
+  // Called once a checkout completed: files it changed may not have been
+  // followed by an invalidation of their directory.
+  attrCache_.invalidateAll();
   folly::Promise<folly::Unit> promise;
   auto result = promise.getFuture();
   invalidationExecutor_->add([promise = std::move(promise)]() mutable {
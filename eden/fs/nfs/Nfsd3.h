@@ -10,7 +10,10 @@
 // Implementation of the NFSv3 protocol as described in:
 // https://tools.ietf.org/html/rfc1813
 
+#include <folly/container/F14Set.h>
+
 #include "eden/fs/inodes/FsChannel.h"
+#include "eden/fs/nfs/NfsAttrCache.h"
 #include "eden/fs/nfs/NfsDispatcher.h"
 #include "eden/fs/nfs/rpc/RpcServer.h"
 #include "eden/fs/telemetry/TraceBus.h"
@@ -287,17 +290,23 @@ class Nfsd3 final : public FsChannel {
 
   PrivHelper* const privHelper_;
   AbsolutePath mountPath_;
+  EdenStatsPtr stats_;
 
   folly::Synchronized<TelemetryState> telemetryState_;
   std::vector<TraceSubscriptionHandle<NfsTraceEvent>> traceSubscriptionHandles_;
 
   folly::Promise<FsStopDataPtr> stopPromise_;
+  NfsAttrCache attrCache_;
   std::shared_ptr<RpcServer> server_;
   ProcessAccessLog processAccessLog_;
   // It is critical that this is a SerialExecutor. invalidation for parent
   // directories should happen after children, and we flush invalidations by
   // adding one work item to the queue.
   folly::Executor::KeepAlive<folly::Executor> invalidationExecutor_;
+  // The paths queued on the invalidationExecutor_ and not yet invalidated.
+  // Shared with the queued invalidations, which may outlive the Nfsd3.
+  std::shared_ptr<folly::Synchronized<folly::F14FastSet<AbsolutePath>>>
+      pendingInvalidations_;
   std::atomic<size_t> traceDetailedArguments_;
   // The TraceBus must be the last member because its subscribed functions may
   // close over `this` and can run until the TraceBus itself is deallocated.
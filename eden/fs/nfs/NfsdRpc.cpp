@@ -139,6 +139,9 @@ EDEN_XDR_SERDE_IMPL(
     case_insensitive,
     case_preserving);
 EDEN_XDR_SERDE_IMPL(PATHCONF3resfail, obj_attributes);
+EDEN_XDR_SERDE_IMPL(COMMIT3args, file, offset, count);
+EDEN_XDR_SERDE_IMPL(COMMIT3resok, file_wcc, verf);
+EDEN_XDR_SERDE_IMPL(COMMIT3resfail, file_wcc);
 
 RpcParsingError constructInodeParsingError(
     folly::io::Cursor cursor,
@@ -7,14 +7,17 @@
 
 #include "eden/fs/nfs/rpc/RpcServer.h"
 
+#include <algorithm>
 #include <tuple>
 
 #include <folly/Exception.h>
 #include <folly/String.h>
+#include <folly/Utility.h>
 #include <folly/executors/QueuedImmediateExecutor.h>
 #include <folly/futures/Future.h>
 #include <folly/io/IOBufQueue.h>
 #include <folly/io/async/AsyncSocket.h>
+#include <folly/portability/Sockets.h>
 
 #include "eden/fs/nfs/rpc/Rpc.h"
 #include "eden/fs/telemetry/LogEvent.h"
@@ -37,10 +40,41 @@ FsChannelInfo RpcStopData::extractTakeoverInfo() {
   return NfsChannelData{std::move(socketToKernel)};
 }
 
+namespace {
+constexpr size_t kMinMaxReadSize = 64 * 1024;
+
+// Room for the RPC and procedure headers of a request or reply, in addition to
+// its data.
+constexpr size_t kHeadersSize = 4 * 1024;
+
+// Number of requests or replies carrying transferSize bytes that fit in the
+// socket buffers.
+constexpr size_t kSocketBufferTransfers = 4;
+
+/**
+ * Grow the send and receive buffers of the socket to at least size. The
+ * buffers are never shrunk, the system may already size them better than we
+ * would, like for TCP.
+ */
+void growSocketBuffers(AsyncSocket& sock, size_t size) {
+  for (auto option : {SO_SNDBUF, SO_RCVBUF}) {
+    int current = 0;
+    socklen_t currentLen = sizeof(current);
+    if (sock.getSockOpt(SOL_SOCKET, option, &current, &currentLen) == 0 &&
+        folly::to_unsigned(current) >= size) {
+      continue;
+    }
+    int value = folly::to_narrow(folly::to_signed(size));
+    if (sock.setSockOpt(SOL_SOCKET, option, &value) != 0) {
+      XLOG(DBG2) << "unable to grow the socket buffers to " << size
+                 << " bytes: " << folly::errnoStr(errno);
+    }
+  }
+}
+} // namespace
+
 void RpcConnectionHandler::getReadBuffer(void** bufP, size_t* lenP) {
-  // TODO(xavierd): Should maxSize be configured to be at least the
-  // configured NFS iosize?
-  constexpr size_t maxSize = 64 * 1024;
+  const size_t maxSize = maxReadSize_;
   constexpr size_t minReadSize = 4 * 1024;
 
   // We want to issue a recv(2) of at least minReadSize, and bound it to
@@ -112,13 +146,19 @@ RpcConnectionHandler::RpcConnectionHandler(
     AsyncSocket::UniquePtr&& socket,
     std::shared_ptr<folly::Executor> threadPool,
     const std::shared_ptr<StructuredLogger>& structuredLogger,
+    size_t transferSize,
     std::weak_ptr<RpcServer> owningServer)
     : proc_(proc),
       sock_(std::move(socket)),
       threadPool_(std::move(threadPool)),
       errorLogger_(structuredLogger),
+      maxReadSize_{std::max(kMinMaxReadSize, transferSize + kHeadersSize)},
       state_(sock_->getEventBase()),
       owningServer_(std::move(owningServer)) {
+  if (transferSize != 0) {
+    growSocketBuffers(
+        *sock_, kSocketBufferTransfers * (transferSize + kHeadersSize));
+  }
   sock_->setReadCB(this);
   proc_->clientConnected();
 }
@@ -223,18 +263,37 @@ std::string displayBuffer(folly::IOBuf* buf) {
   auto bytes = buf->coalesce();
   return folly::hexDump(bytes.data(), bytes.size());
 }
+
+/**
+ * Requests complete, and are replied to, in any order, so a slow request only
+ * delays the ones that need the same thread pool workers or locks. Bound the
+ * number of requests of a connection that are dispatched at once so that a
+ * client can't queue an unbounded amount of work: the rest wait in the socket.
+ */
+constexpr size_t kMaxPendingRequests = 1024;
 } // namespace
 
 void RpcConnectionHandler::tryConsumeReadBuffer() noexcept {
   // Iterate over all the complete fragments and dispatch these to the
   // threadPool_.
   while (true) {
+    auto& state = state_.get();
+    if (state.pendingRequests >= kMaxPendingRequests) {
+      if (!state.readingPaused && !state.stopReason.has_value()) {
+        XLOG(DBG3) << state.pendingRequests
+                   << " pending requests, pausing reads from the socket";
+        state.readingPaused = true;
+        sock_->setReadCB(nullptr);
+      }
+      break;
+    }
+
     auto buf = readOneRequest();
     if (!buf) {
       break;
     }
     XLOG(DBG7) << "received a request";
-    state_.get().pendingRequests += 1;
+    state.pendingRequests += 1;
     // Send the work to a thread pool to increase the number of inflight
     // requests that can be handled concurrently.
     threadPool_->add(
@@ -273,6 +332,18 @@ void RpcConnectionHandler::tryConsumeReadBuffer() noexcept {
   }
 }
 
+void RpcConnectionHandler::resumeReading() noexcept {
+  auto& state = state_.get();
+  state.readingPaused = false;
+  // Complete requests may still be buffered, even while shutting down: they
+  // were received and must be replied to.
+  tryConsumeReadBuffer();
+  if (!state.readingPaused && !state.stopReason.has_value()) {
+    XLOG(DBG3) << "resuming reads from the socket";
+    sock_->setReadCB(this);
+  }
+}
+
 std::unique_ptr<folly::IOBuf> RpcConnectionHandler::readOneRequest() noexcept {
   if (!readBuf_.front()) {
     return nullptr;
@@ -467,6 +538,9 @@ void RpcConnectionHandler::dispatchAndReply(
         auto& state = this->state_.get();
         state.pendingRequests -= 1;
         XLOG(DBG7) << state.pendingRequests << " more requests to process";
+        if (state.readingPaused) {
+          resumeReading();
+        }
         if (state.pendingRequests == 0 && state.stopReason.has_value()) {
           // We are shutting down and the last request has been
           // handled, so signal that all pending requests have
@@ -488,6 +562,7 @@ void RpcServer::connectionAccepted(
       std::move(socket),
       threadPool_,
       structuredLogger_,
+      transferSize_,
       weak_from_this()));
 
   // At this point we could stop accepting connections with this callback for
@@ -532,10 +607,15 @@ std::shared_ptr<RpcServer> RpcServer::create(
     std::shared_ptr<RpcServerProcessor> proc,
     folly::EventBase* evb,
     std::shared_ptr<folly::Executor> threadPool,
-    const std::shared_ptr<StructuredLogger>& structuredLogger) {
+    const std::shared_ptr<StructuredLogger>& structuredLogger,
+    size_t transferSize) {
   return std::shared_ptr<RpcServer>{
       new RpcServer{
-          std::move(proc), evb, std::move(threadPool), structuredLogger},
+          std::move(proc),
+          evb,
+          std::move(threadPool),
+          structuredLogger,
+          transferSize},
       [](RpcServer* p) { p->destroy(); }};
 }
 
@@ -543,10 +623,12 @@ RpcServer::RpcServer(
     std::shared_ptr<RpcServerProcessor> proc,
     folly::EventBase* evb,
     std::shared_ptr<folly::Executor> threadPool,
-    const std::shared_ptr<StructuredLogger>& structuredLogger)
+    const std::shared_ptr<StructuredLogger>& structuredLogger,
+    size_t transferSize)
     : evb_(evb),
       threadPool_(threadPool),
       structuredLogger_(structuredLogger),
+      transferSize_{transferSize},
       serverSocket_(new AsyncServerSocket(evb_)),
       proc_(std::move(proc)),
       state_{evb} {}
@@ -579,6 +661,7 @@ void RpcServer::initializeConnectedSocket(folly::File socket) {
           evb_, folly::NetworkSocket::fromFd(socket.release())),
       threadPool_,
       structuredLogger_,
+      transferSize_,
       weak_from_this()));
 }
 
@@ -127,6 +127,7 @@ class RpcConnectionHandler : public folly::DelayedDestruction,
       folly::AsyncSocket::UniquePtr&& socket,
       std::shared_ptr<folly::Executor> threadPool,
       const std::shared_ptr<StructuredLogger>& structuredLogger,
+      size_t transferSize,
       std::weak_ptr<RpcServer> owningServer);
 
   // AsyncReader::ReadCallback
@@ -155,9 +156,18 @@ class RpcConnectionHandler : public folly::DelayedDestruction,
   /**
    * Parse the buffer that was just read from the socket. Complete RPC buffers
    * will be dispatched to the RpcServerProcessor.
+   *
+   * Once too many requests are pending, the remaining ones are left in the
+   * buffer and reading from the socket is paused until some complete.
    */
   void tryConsumeReadBuffer() noexcept;
 
+  /**
+   * Dispatch the requests left in the buffer by tryConsumeReadBuffer() and,
+   * unless shutting down, resume reading from the socket.
+   */
+  void resumeReading() noexcept;
+
   /**
    * Delete the reader, called when the socket is closed or on takeover.
    *
@@ -227,6 +237,11 @@ class RpcConnectionHandler : public folly::DelayedDestruction,
    */
   std::shared_ptr<StructuredLogger> errorLogger_;
 
+  /**
+   * Maximum size of a read from the socket.
+   */
+  const size_t maxReadSize_;
+
   folly::IOBufQueue readBuf_{folly::IOBufQueue::cacheChainLength()};
 
   /**
@@ -241,6 +256,10 @@ class RpcConnectionHandler : public folly::DelayedDestruction,
 
     // number of requests we are in the middle of processing
     size_t pendingRequests = 0;
+
+    // Whether reading from the socket was paused because too many requests
+    // are pending.
+    bool readingPaused = false;
   };
 
   EventBaseState<State> state_;
@@ -271,12 +290,17 @@ class RpcServer final : public std::enable_shared_from_this<RpcServer>,
    *
    * Request will be received on the passed EventBase and dispatched to the
    * RpcServerProcessor on the passed in threadPool.
+   *
+   * transferSize is the size of the largest data carried by a request or a
+   * reply, like the NFS read and write sizes. The reads from the sockets and
+   * the socket buffers are sized so that several of these fit in them.
    */
   static std::shared_ptr<RpcServer> create(
       std::shared_ptr<RpcServerProcessor> proc,
       folly::EventBase* evb,
       std::shared_ptr<folly::Executor> threadPool,
-      const std::shared_ptr<StructuredLogger>& structuredLogger);
+      const std::shared_ptr<StructuredLogger>& structuredLogger,
+      size_t transferSize = 0);
 
   /**
    * RpcServer must be torn down on its EventBase. destroy() is called by the
@@ -341,7 +365,8 @@ class RpcServer final : public std::enable_shared_from_this<RpcServer>,
       std::shared_ptr<RpcServerProcessor> proc,
       folly::EventBase* evb,
       std::shared_ptr<folly::Executor> threadPool,
-      const std::shared_ptr<StructuredLogger>& structuredLogger);
+      const std::shared_ptr<StructuredLogger>& structuredLogger,
+      size_t transferSize);
 
   ~RpcServer() override;
 
@@ -368,6 +393,10 @@ class RpcServer final : public std::enable_shared_from_this<RpcServer>,
   // Logger for logging anomalous things to Scuba
   std::shared_ptr<StructuredLogger> structuredLogger_;
 
+  // Size of the largest data carried by a request or reply, 0 if they carry
+  // none.
+  const size_t transferSize_;
+
   // listening socket for this server.
   folly::AsyncServerSocket::UniquePtr serverSocket_;
 
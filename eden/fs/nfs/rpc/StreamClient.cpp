@@ -21,6 +21,8 @@ constexpr size_t kDefaultBufferSize = 1024;
 StreamClient::StreamClient(folly::SocketAddress&& addr)
     : addr_(std::move(addr)) {}
 
+StreamClient::StreamClient(folly::NetworkSocket socket) : s_(socket) {}
+
 void StreamClient::connect() {
   sockaddr_storage socketAddress;
   auto len = addr_.getAddress(&socketAddress);
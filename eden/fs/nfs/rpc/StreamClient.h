@@ -25,6 +25,13 @@ class StreamClient {
 
  public:
   explicit StreamClient(folly::SocketAddress&& addr);
+
+  /**
+   * Talk over an already connected socket, such as one end of a socketpair,
+   * instead of calling connect(). The socket remains owned by the caller.
+   */
+  explicit StreamClient(folly::NetworkSocket socket);
+
   void connect();
 
   std::pair<std::unique_ptr<folly::IOBufQueue>, folly::io::QueueAppender>
@@ -7,6 +7,7 @@
 
 #ifndef _WIN32
 
+#include <fmt/format.h>
 #include <folly/portability/GTest.h>
 #include "eden/fs/nfs/NfsDirList.h"
 #include "eden/fs/nfs/NfsdRpc.h"
@@ -29,6 +30,26 @@ TEST(DirListTest, size) {
   EXPECT_EQ(computeInitialOverhead(), kNfsDirListInitialOverhead);
 }
 
+TEST(DirListTest, readdirplusFitsInMaxCount) {
+  constexpr uint32_t kMaxCount = 1024;
+  NfsDirList list{/*dirCount=*/4096, kMaxCount};
+  uint64_t offset = 0;
+  while (list.add(
+      fmt::format("entry{}", offset), InodeNumber{offset + 1}, offset + 1)) {
+    ++offset;
+  }
+  EXPECT_GT(offset, 0);
+
+  // Fill in the attributes, as NfsDispatcher::readdirplus does.
+  auto entries = list.extractList<entryplus3>();
+  for (auto& entry : entries.list) {
+    entry.name_attributes = post_op_attr{fattr3{}};
+  }
+  READDIRPLUS3resok res{
+      post_op_attr{fattr3{}}, 0, dirlistplus3{std::move(entries), false}};
+  EXPECT_LE(XdrTrait<READDIRPLUS3resok>::serializedSize(res), kMaxCount);
+}
+
 } // namespace facebook::eden
 
 #endif
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include <folly/portability/GTest.h>
+#include "eden/fs/nfs/NfsAttrCache.h"
+
+namespace facebook::eden {
+
+namespace {
+fattr3 makeAttr(uint64_t fileid, uint64_t size) {
+  fattr3 attr{};
+  attr.fileid = fileid;
+  attr.size = size;
+  return attr;
+}
+} // namespace
+
+TEST(NfsAttrCacheTest, getReturnsInsertedAttributes) {
+  NfsAttrCache cache{10};
+  EXPECT_FALSE(cache.get(InodeNumber{2}).has_value());
+
+  cache.insert(InodeNumber{2}, makeAttr(2, 42), cache.getGeneration());
+  EXPECT_EQ(makeAttr(2, 42), cache.get(InodeNumber{2}));
+  EXPECT_FALSE(cache.get(InodeNumber{3}).has_value());
+}
+
+TEST(NfsAttrCacheTest, invalidate) {
+  NfsAttrCache cache{10};
+  cache.insert(InodeNumber{2}, makeAttr(2, 42), cache.getGeneration());
+  cache.insert(InodeNumber{3}, makeAttr(3, 42), cache.getGeneration());
+
+  cache.invalidate(InodeNumber{2});
+  EXPECT_FALSE(cache.get(InodeNumber{2}).has_value());
+  EXPECT_TRUE(cache.get(InodeNumber{3}).has_value());
+
+  cache.invalidateAll();
+  EXPECT_FALSE(cache.get(InodeNumber{3}).has_value());
+}
+
+TEST(NfsAttrCacheTest, attributesComputedBeforeInvalidationAreNotCached) {
+  NfsAttrCache cache{10};
+  auto generation = cache.getGeneration();
+  // A change to any inode completes while the attributes are computed.
+  cache.invalidate(InodeNumber{3});
+  cache.insert(InodeNumber{2}, makeAttr(2, 42), generation);
+  EXPECT_FALSE(cache.get(InodeNumber{2}).has_value());
+
+  cache.insert(InodeNumber{2}, makeAttr(2, 43), cache.getGeneration());
+  EXPECT_EQ(makeAttr(2, 43), cache.get(InodeNumber{2}));
+}
+
+TEST(NfsAttrCacheTest, clearedWhenFull) {
+  NfsAttrCache cache{2};
+  cache.insert(InodeNumber{2}, makeAttr(2, 42), cache.getGeneration());
+  cache.insert(InodeNumber{3}, makeAttr(3, 42), cache.getGeneration());
+  cache.insert(InodeNumber{4}, makeAttr(4, 42), cache.getGeneration());
+
+  EXPECT_FALSE(cache.get(InodeNumber{2}).has_value());
+  EXPECT_FALSE(cache.get(InodeNumber{3}).has_value());
+  EXPECT_TRUE(cache.get(InodeNumber{4}).has_value());
+}
+
+} // namespace facebook::eden
+
+#endif
@@ -0,0 +1,296 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/Exception.h>
+#include <folly/File.h>
+#include <folly/Utility.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/logging/Logger.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <array>
+#include <chrono>
+#include <system_error>
+
+#include "eden/common/utils/ProcessNameCache.h"
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/nfs/NfsDispatcher.h"
+#include "eden/fs/nfs/Nfsd3.h"
+#include "eden/fs/nfs/NfsdRpc.h"
+#include "eden/fs/nfs/rpc/StreamClient.h"
+#include "eden/fs/telemetry/EdenStats.h"
+#include "eden/fs/telemetry/NullStructuredLogger.h"
+#include "eden/fs/utils/CaseSensitivity.h"
+#include "eden/fs/utils/Clock.h"
+
+/*
+ * Measures the request throughput of Nfsd3 alone: XDR encoded calls are
+ * written to one end of a socketpair whose other end is served by Nfsd3, and
+ * are answered by a dispatcher that replies immediately.
+ */
+
+namespace {
+
+using namespace facebook::eden;
+
+folly::Logger straceLogger{"eden.strace"};
+
+constexpr size_t kTraceBusCapacity = 25000;
+// Calls written before reading any reply, enough to keep every thread of the
+// pool busy.
+constexpr size_t kPipelineDepth = 64;
+constexpr uint32_t kReadSize = 4096;
+constexpr InodeNumber kFileIno{2};
+
+enum Op { kLookup, kGetattr, kRead };
+constexpr const char* kOpNames[] = {"lookup", "getattr", "read"};
+
+struct stat fileStat(InodeNumber ino) {
+  struct stat st {};
+  st.st_ino = ino.get();
+  st.st_mode = ino == kRootNodeId ? S_IFDIR | 0755 : S_IFREG | 0644;
+  st.st_nlink = 1;
+  st.st_size = kReadSize;
+  return st;
+}
+
+template <typename T>
+ImmediateFuture<T> notSupported() {
+  return makeImmediateFuture<T>(
+      std::system_error(ENOSYS, std::generic_category()));
+}
+
+/**
+ * Answers every lookup, getattr and read as if the root directory held a
+ * single regular file, and fails every other procedure.
+ */
+class ImmediateDispatcher : public NfsDispatcher {
+ public:
+  explicit ImmediateDispatcher(EdenStatsPtr stats)
+      : NfsDispatcher(std::move(stats), clock_) {}
+
+  ImmediateFuture<struct stat> getattr(
+      InodeNumber ino,
+      const ObjectFetchContextPtr& /*context*/) override {
+    return fileStat(ino);
+  }
+
+  ImmediateFuture<SetattrRes> setattr(
+      InodeNumber /*ino*/,
+      DesiredMetadata /*desired*/,
+      const ObjectFetchContextPtr& /*context*/) override {
+    return notSupported<SetattrRes>();
+  }
+
+  ImmediateFuture<InodeNumber> getParent(
+      InodeNumber /*ino*/,
+      const ObjectFetchContextPtr& /*context*/) override {
+    return kRootNodeId;
+  }
+
+  ImmediateFuture<std::tuple<InodeNumber, struct stat>> lookup(
+      InodeNumber /*dir*/,
+      PathComponent /*name*/,
+      const ObjectFetchContextPtr& /*context*/) override {
+    return std::tuple{kFileIno, fileStat(kFileIno)};
+  }
+
+  ImmediateFuture<std::string> readlink(
+      InodeNumber /*ino*/,
+      const ObjectFetchContextPtr& /*context*/) override {
+    return notSupported<std::string>();
+  }
+
+  ImmediateFuture<ReadRes> read(
+      InodeNumber /*ino*/,
+      size_t size,
+      FileOffset /*offset*/,
+      const ObjectFetchContextPtr& /*context*/) override {
+    return ReadRes{
+        folly::IOBuf::wrapBuffer(
+            data_.data(), std::min(size, size_t{kReadSize})),
+        /*isEof=*/true};
+  }
+
+  ImmediateFuture<WriteRes> write(
+      InodeNumber /*ino*/,
+      std::unique_ptr<folly::IOBuf> /*data*/,
+      FileOffset /*offset*/,
+      const ObjectFetchContextPtr& /*context*/) override {
+    return notSupported<WriteRes>();
+  }
+
+  ImmediateFuture<CreateRes> create(
+      InodeNumber /*dir*/,
+      PathComponent /*name*/,
+      mode_t /*mode*/,
+      const ObjectFetchContextPtr& /*context*/) override {
+    return notSupported<CreateRes>();
+  }
+
+  ImmediateFuture<MkdirRes> mkdir(
+      InodeNumber /*dir*/,
+      PathComponent /*name*/,
+      mode_t /*mode*/,
+      const ObjectFetchContextPtr& /*context*/) override {
+    return notSupported<MkdirRes>();
+  }
+
+  ImmediateFuture<SymlinkRes> symlink(
+      InodeNumber /*dir*/,
+      PathComponent /*name*/,
+      std::string /*data*/,
+      const ObjectFetchContextPtr& /*context*/) override {
+    return notSupported<SymlinkRes>();
+  }
+
+  ImmediateFuture<MknodRes> mknod(
+      InodeNumber /*ino*/,
+      PathComponent /*name*/,
+      mode_t /*mode*/,
+      dev_t /*rdev*/,
+      const ObjectFetchContextPtr& /*context*/) override {
+    return notSupported<MknodRes>();
+  }
+
+  ImmediateFuture<UnlinkRes> unlink(
+      InodeNumber /*dir*/,
+      PathComponent /*name*/,
+      const ObjectFetchContextPtr& /*context*/) override {
+    return notSupported<UnlinkRes>();
+  }
+
+  ImmediateFuture<RmdirRes> rmdir(
+      InodeNumber /*dir*/,
+      PathComponent /*name*/,
+      const ObjectFetchContextPtr& /*context*/) override {
+    return notSupported<RmdirRes>();
+  }
+
+  ImmediateFuture<RenameRes> rename(
+      InodeNumber /*fromIno*/,
+      PathComponent /*fromName*/,
+      InodeNumber /*toIno*/,
+      PathComponent /*toName*/,
+      const ObjectFetchContextPtr& /*context*/) override {
+    return notSupported<RenameRes>();
+  }
+
+  ImmediateFuture<ReaddirRes> readdir(
+      InodeNumber /*dir*/,
+      FileOffset /*offset*/,
+      uint32_t /*count*/,
+      const ObjectFetchContextPtr& /*context*/) override {
+    return notSupported<ReaddirRes>();
+  }
+
+  ImmediateFuture<ReaddirRes> readdirplus(
+      InodeNumber /*dir*/,
+      FileOffset /*offset*/,
+      uint32_t /*dirCount*/,
+      uint32_t /*maxCount*/,
+      const ObjectFetchContextPtr& /*context*/) override {
+    return notSupported<ReaddirRes>();
+  }
+
+  ImmediateFuture<struct statfs> statfs(
+      InodeNumber /*dir*/,
+      const ObjectFetchContextPtr& /*context*/) override {
+    return notSupported<struct statfs>();
+  }
+
+ private:
+  static inline UnixClock clock_;
+  std::array<char, kReadSize> data_{};
+};
+
+void sendCall(StreamClient& client, Op op) {
+  switch (op) {
+    case kLookup:
+      client.serializeCall(
+          kNfsdProgNumber,
+          kNfsd3ProgVersion,
+          folly::to_underlying(nfsv3Procs::lookup),
+          LOOKUP3args{diropargs3{nfs_fh3{kRootNodeId}, "file"}});
+      return;
+    case kGetattr:
+      client.serializeCall(
+          kNfsdProgNumber,
+          kNfsd3ProgVersion,
+          folly::to_underlying(nfsv3Procs::getattr),
+          GETATTR3args{nfs_fh3{kFileIno}});
+      return;
+    case kRead:
+      client.serializeCall(
+          kNfsdProgNumber,
+          kNfsd3ProgVersion,
+          folly::to_underlying(nfsv3Procs::read),
+          READ3args{nfs_fh3{kFileIno}, 0, kReadSize});
+      return;
+  }
+}
+
+void nfsd3(benchmark::State& state) {
+  auto op = static_cast<Op>(state.range(0));
+  auto threads = static_cast<size_t>(state.range(1));
+  state.SetLabel(kOpNames[op]);
+
+  int fds[2];
+  folly::checkUnixError(
+      ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), "socketpair failed");
+  folly::File clientSocket{fds[0], /*ownsFd=*/true};
+  folly::File serverSocket{fds[1], /*ownsFd=*/true};
+
+  folly::ScopedEventBaseThread evbThread;
+  auto* evb = evbThread.getEventBase();
+  std::unique_ptr<Nfsd3, FsChannelDeleter> nfsd;
+  evb->runInEventBaseThreadAndWait([&] {
+    nfsd.reset(new Nfsd3{
+        /*privHelper=*/nullptr,
+        canonicalPath("/fake/mount/path"),
+        evb,
+        std::make_shared<folly::CPUThreadPoolExecutor>(threads),
+        std::make_unique<ImmediateDispatcher>(makeRefPtr<EdenStats>()),
+        &straceLogger,
+        std::make_shared<ProcessNameCache>(),
+        /*fsEventLogger=*/nullptr,
+        std::make_shared<NullStructuredLogger>(),
+        std::chrono::seconds(60),
+        /*notifications=*/nullptr,
+        CaseSensitivity::Sensitive,
+        /*iosize=*/1024 * 1024,
+        kTraceBusCapacity});
+    nfsd->initialize(std::move(serverSocket));
+  });
+
+  // Replies may arrive in any order once there is more than one thread, so
+  // they are only checked for success, which receiveChunk() does.
+  StreamClient client{folly::NetworkSocket::fromFd(clientSocket.fd())};
+  for (auto _ : state) {
+    for (size_t i = 0; i < kPipelineDepth; ++i) {
+      sendCall(client, op);
+    }
+    for (size_t i = 0; i < kPipelineDepth; ++i) {
+      benchmark::DoNotOptimize(client.receiveChunk());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kPipelineDepth);
+
+  // Closing the socket lets Nfsd3 tear down its connection before it is
+  // destroyed on its EventBase.
+  clientSocket.close();
+  nfsd.reset();
+}
+BENCHMARK(nfsd3)
+    ->ArgNames({"op", "threads"})
+    ->ArgsProduct({{kLookup, kGetattr, kRead}, {1, 2, 4, 8}})
+    ->UseRealTime();
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
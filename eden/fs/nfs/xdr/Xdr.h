@@ -297,6 +297,9 @@ void serialize_variable(
 /**
  * Serialize an IOBuf chain. This is serialized like a variable sized array,
  * ie: size first, followed by the content and aligned on a 4-byte boundary.
+ *
+ * The content is not copied: the chain is cloned into the output queue, and
+ * written to the socket as is by AsyncSocket::writeChain.
  */
 void serialize_iobuf(
     folly::io::QueueAppender& appender,
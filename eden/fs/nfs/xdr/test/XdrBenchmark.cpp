@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/nfs/xdr/Xdr.h"
+
+#include <benchmark/benchmark.h>
+
+namespace facebook::eden {
+
+/**
+ * Shaped like the arguments of the NFS procedures that operate on a directory
+ * entry: a fixed size file handle followed by a name.
+ */
+struct DirEntryArgs {
+  uint64_t handle;
+  std::string name;
+};
+EDEN_XDR_SERDE_DECL(DirEntryArgs, handle, name);
+EDEN_XDR_SERDE_IMPL(DirEntryArgs, handle, name);
+
+namespace {
+
+std::unique_ptr<folly::IOBuf> serializeArgs(size_t nameLength) {
+  folly::IOBufQueue queue{folly::IOBufQueue::cacheChainLength()};
+  folly::io::QueueAppender appender{&queue, 1024};
+  XdrTrait<DirEntryArgs>::serialize(
+      appender, DirEntryArgs{42, std::string(nameLength, 'a')});
+  return queue.move();
+}
+
+void BM_deserializeDirEntryArgs(benchmark::State& state) {
+  auto buf = serializeArgs(state.range(0));
+  for (auto _ : state) {
+    folly::io::Cursor cursor{buf.get()};
+    benchmark::DoNotOptimize(XdrTrait<DirEntryArgs>::deserialize(cursor));
+  }
+}
+// Names short enough to fit in std::string's inline buffer, and longer ones.
+BENCHMARK(BM_deserializeDirEntryArgs)->Arg(8)->Arg(64);
+
+void BM_deserializeInteger(benchmark::State& state) {
+  auto buf = serializeArgs(8);
+  for (auto _ : state) {
+    folly::io::Cursor cursor{buf.get()};
+    benchmark::DoNotOptimize(XdrTrait<uint64_t>::deserialize(cursor));
+  }
+}
+BENCHMARK(BM_deserializeInteger);
+
+} // namespace
+
+} // namespace facebook::eden
@@ -139,6 +139,30 @@ TEST(XdrSerialize, iobuf) {
   roundtrip(std::move(buf));
 }
 
+TEST(XdrSerialize, iobufIsNotCopied) {
+  // Large enough to not be packed into the buffer of the length.
+  auto data = folly::IOBuf::create(64 * 1024);
+  data->append(data->capacity());
+  memset(data->writableData(), 'a', data->length());
+
+  folly::IOBufQueue queue{folly::IOBufQueue::cacheChainLength()};
+  {
+    folly::io::QueueAppender appender{&queue, 1024};
+    XdrTrait<std::unique_ptr<folly::IOBuf>>::serialize(appender, data);
+  }
+  EXPECT_EQ(
+      queue.chainLength(),
+      XdrTrait<std::unique_ptr<folly::IOBuf>>::serializedSize(data));
+
+  auto result = queue.move();
+  bool shared = false;
+  for (const auto& buf : *result) {
+    shared |= buf.data() == data->data();
+  }
+  EXPECT_TRUE(shared);
+  EXPECT_TRUE(data->isShared());
+}
+
 struct ListElement {
   uint32_t value;
 };
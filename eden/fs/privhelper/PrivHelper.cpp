@@ -8,11 +8,22 @@
 #include "eden/fs/privhelper/PrivHelper.h"
 
 #include <folly/File.h>
+#include <folly/Try.h>
 #include <folly/futures/Future.h>
 #include <folly/io/async/EventBase.h>
 
 namespace facebook::eden {
 
+folly::Future<std::vector<folly::Try<folly::Unit>>> PrivHelper::bindMounts(
+    std::vector<std::pair<std::string, std::string>> bindMounts) {
+  std::vector<folly::Future<folly::Unit>> futures;
+  futures.reserve(bindMounts.size());
+  for (const auto& [clientPath, mountPath] : bindMounts) {
+    futures.push_back(bindMount(clientPath, mountPath));
+  }
+  return folly::collectAllUnsafe(std::move(futures));
+}
+
 void PrivHelper::setLogFileBlocking(folly::File logFile) {
   folly::EventBase evb;
   attachEventBase(&evb);
@@ -13,12 +13,17 @@
 #include <sys/types.h>
 #include <chrono>
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace folly {
 class EventBase;
 class File;
 template <typename T>
 class Future;
+template <typename T>
+class Try;
 struct Unit;
 } // namespace folly
 
@@ -93,6 +98,15 @@ class PrivHelper {
       folly::StringPiece clientPath,
       folly::StringPiece mountPath) = 0;
 
+  /**
+   * Create several bind mounts with one request, returning the outcome of
+   * each (clientPath, mountPath) pair in order.
+   *
+   * The default implementation issues one bindMount() call per entry.
+   */
+  FOLLY_NODISCARD virtual folly::Future<std::vector<folly::Try<folly::Unit>>>
+  bindMounts(std::vector<std::pair<std::string, std::string>> bindMounts);
+
   FOLLY_NODISCARD virtual folly::Future<folly::Unit> bindUnMount(
       folly::StringPiece mountPath) = 0;
 
@@ -392,6 +392,82 @@ void PrivHelperConn::parseBindMountRequest(
   checkAtEnd(cursor, "bind mount request");
 }
 
+UnixSocket::Message PrivHelperConn::serializeBindMountBatchRequest(
+    uint32_t xid,
+    const std::vector<std::pair<std::string, std::string>>& bindMounts) {
+  auto msg = serializeRequestPacket(xid, REQ_MOUNT_BIND_BATCH);
+  Appender appender(&msg.data, kDefaultBufferSize);
+
+  appender.write<uint32_t>(bindMounts.size());
+  for (const auto& [clientPath, mountPath] : bindMounts) {
+    serializeString(appender, mountPath);
+    serializeString(appender, clientPath);
+  }
+  return msg;
+}
+
+void PrivHelperConn::parseBindMountBatchRequest(
+    Cursor& cursor,
+    std::vector<std::pair<std::string, std::string>>& bindMounts) {
+  auto n = cursor.read<uint32_t>();
+  while (n-- != 0) {
+    auto mountPath = deserializeString(cursor);
+    auto clientPath = deserializeString(cursor);
+    bindMounts.emplace_back(std::move(clientPath), std::move(mountPath));
+  }
+  checkAtEnd(cursor, "bind mount batch request");
+}
+
+void PrivHelperConn::serializeBindMountBatchResponse(
+    Appender& appender,
+    const std::vector<folly::exception_wrapper>& errors) {
+  appender.write<uint32_t>(errors.size());
+  for (const auto& error : errors) {
+    appender.write<uint8_t>(error ? 1 : 0);
+    if (!error) {
+      continue;
+    }
+    if (auto* ex = error.get_exception<std::exception>()) {
+      serializeErrorResponse(appender, *ex);
+    } else {
+      serializeErrorResponse(appender, error.what());
+    }
+  }
+}
+
+std::vector<folly::Try<folly::Unit>>
+PrivHelperConn::parseBindMountBatchResponse(const UnixSocket::Message& msg) {
+  Cursor cursor(&msg.data);
+  PrivHelperPacket packet = parsePacket(cursor);
+  if (packet.metadata.msg_type == RESP_ERROR) {
+    rethrowErrorResponse(cursor);
+  } else if (packet.metadata.msg_type != REQ_MOUNT_BIND_BATCH) {
+    throwf<std::runtime_error>(
+        "unexpected response type {} for request {} of type {}",
+        packet.metadata.msg_type,
+        packet.metadata.transaction_id,
+        REQ_MOUNT_BIND_BATCH);
+  }
+
+  std::vector<folly::Try<folly::Unit>> results;
+  auto n = cursor.read<uint32_t>();
+  results.reserve(n);
+  while (n-- != 0) {
+    if (cursor.read<uint8_t>() == 0) {
+      results.emplace_back(folly::unit);
+      continue;
+    }
+    try {
+      rethrowErrorResponse(cursor);
+    } catch (const std::exception& ex) {
+      results.emplace_back(
+          folly::exception_wrapper{std::current_exception(), ex});
+    }
+  }
+  checkAtEnd(cursor, "bind mount batch response");
+  return results;
+}
+
 UnixSocket::Message PrivHelperConn::serializeSetDaemonTimeoutRequest(
     uint32_t xid,
     std::chrono::nanoseconds duration) {
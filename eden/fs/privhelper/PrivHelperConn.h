@@ -7,10 +7,15 @@
 
 #pragma once
 
+#include <folly/ExceptionWrapper.h>
 #include <folly/Range.h>
+#include <folly/Try.h>
 #include <folly/io/Cursor.h>
 #include <cinttypes>
 #include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 #include "eden/fs/utils/UnixSocket.h"
 
 namespace folly {
@@ -48,6 +53,7 @@ class PrivHelperConn {
     REQ_SET_USE_EDENFS = 10,
     REQ_MOUNT_NFS = 11,
     REQ_UNMOUNT_NFS = 12,
+    REQ_MOUNT_BIND_BATCH = 13,
   };
 
   // This structure should never change. If fields need to be added to the
@@ -137,6 +143,23 @@ class PrivHelperConn {
       std::string& clientPath,
       std::string& mountPath);
 
+  /**
+   * Each entry is a (clientPath, mountPath) pair. The response reports the
+   * outcome of every entry in the same order, so that one failed bind mount
+   * does not fail the others.
+   */
+  static UnixSocket::Message serializeBindMountBatchRequest(
+      uint32_t xid,
+      const std::vector<std::pair<std::string, std::string>>& bindMounts);
+  static void parseBindMountBatchRequest(
+      folly::io::Cursor& cursor,
+      std::vector<std::pair<std::string, std::string>>& bindMounts);
+  static void serializeBindMountBatchResponse(
+      folly::io::Appender& appender,
+      const std::vector<folly::exception_wrapper>& errors);
+  static std::vector<folly::Try<folly::Unit>> parseBindMountBatchResponse(
+      const UnixSocket::Message& msg);
+
   static UnixSocket::Message serializeBindUnMountRequest(
       uint32_t xid,
       folly::StringPiece mountPath);
@@ -110,6 +110,8 @@ class PrivHelperClientImpl : public PrivHelper,
   Future<Unit> nfsUnmount(StringPiece mountPath) override;
   Future<Unit> bindMount(StringPiece clientPath, StringPiece mountPath)
       override;
+  Future<vector<folly::Try<Unit>>> bindMounts(
+      vector<std::pair<string, string>> bindMounts) override;
   folly::Future<folly::Unit> bindUnMount(folly::StringPiece mountPath) override;
   Future<Unit> takeoverShutdown(StringPiece mountPath) override;
   Future<Unit> takeoverStartup(
@@ -433,6 +435,29 @@ Future<Unit> PrivHelperClientImpl::bindMount(
       });
 }
 
+Future<vector<folly::Try<Unit>>> PrivHelperClientImpl::bindMounts(
+    vector<std::pair<string, string>> bindMounts) {
+  auto xid = getNextXid();
+  auto request =
+      PrivHelperConn::serializeBindMountBatchRequest(xid, bindMounts);
+
+  return sendAndRecv(xid, std::move(request))
+      .thenValue([](UnixSocket::Message&& response) {
+        return PrivHelperConn::parseBindMountBatchResponse(response);
+      })
+      .thenError(
+          folly::tag_t<PrivHelperError>{},
+          [this, bindMounts = std::move(bindMounts)](
+              const PrivHelperError& ex) mutable {
+            // A privhelper that predates batching, e.g. one kept across a
+            // graceful restart, rejects the whole request. Fall back to one
+            // request per bind mount.
+            XLOG(DBG2) << "privhelper rejected batched bind mount, "
+                       << "falling back to individual requests: " << ex.what();
+            return PrivHelper::bindMounts(std::move(bindMounts));
+          });
+}
+
 folly::Future<folly::Unit> PrivHelperClientImpl::bindUnMount(
     folly::StringPiece mountPath) {
   auto xid = getNextXid();
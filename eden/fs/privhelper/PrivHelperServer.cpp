@@ -13,6 +13,7 @@
 #include <boost/algorithm/string/predicate.hpp>
 #include <fcntl.h>
 #include <folly/Exception.h>
+#include <folly/ExceptionWrapper.h>
 #include <folly/Expected.h>
 #include <folly/File.h>
 #include <folly/FileUtil.h>
@@ -947,6 +948,31 @@ UnixSocket::Message PrivHelperServer::processBindMountMsg(Cursor& cursor) {
   return makeResponse();
 }
 
+UnixSocket::Message PrivHelperServer::processBindMountBatchMsg(
+    Cursor& cursor) {
+  std::vector<std::pair<string, string>> bindMounts;
+  PrivHelperConn::parseBindMountBatchRequest(cursor, bindMounts);
+  XLOG(DBG3) << "bind mount batch of " << bindMounts.size();
+
+  // Every entry gets the same checks as a single bind mount request, but a
+  // failure only fails its own entry.
+  std::vector<folly::exception_wrapper> errors;
+  errors.reserve(bindMounts.size());
+  for (const auto& entry : bindMounts) {
+    errors.push_back(folly::try_and_catch([&] {
+      const auto& [clientPath, mountPath] = entry;
+      XLOG(DBG3) << "bind mount \"" << mountPath << "\"";
+      findMatchingMountPrefix(mountPath);
+      bindMount(clientPath.c_str(), mountPath.c_str());
+    }));
+  }
+
+  auto response = makeResponse();
+  Appender appender(&response.data, 1024);
+  PrivHelperConn::serializeBindMountBatchResponse(appender, errors);
+  return response;
+}
+
 UnixSocket::Message PrivHelperServer::processBindUnMountMsg(Cursor& cursor) {
   string mountPath;
   PrivHelperConn::parseBindUnMountRequest(cursor, mountPath);
@@ -1174,6 +1200,8 @@ UnixSocket::Message PrivHelperServer::processMessage(
       return processMountNfsMsg(cursor);
     case PrivHelperConn::REQ_MOUNT_BIND:
       return processBindMountMsg(cursor);
+    case PrivHelperConn::REQ_MOUNT_BIND_BATCH:
+      return processBindMountBatchMsg(cursor);
     case PrivHelperConn::REQ_UNMOUNT_FUSE:
       return processUnmountMsg(cursor);
     case PrivHelperConn::REQ_UNMOUNT_NFS:
@@ -83,6 +83,7 @@ class PrivHelperServer : private UnixSocket::ReceiveCallback {
   UnixSocket::Message processUnmountMsg(folly::io::Cursor& cursor);
   UnixSocket::Message processNfsUnmountMsg(folly::io::Cursor& cursor);
   UnixSocket::Message processBindMountMsg(folly::io::Cursor& cursor);
+  UnixSocket::Message processBindMountBatchMsg(folly::io::Cursor& cursor);
   UnixSocket::Message processBindUnMountMsg(folly::io::Cursor& cursor);
   UnixSocket::Message processTakeoverShutdownMsg(folly::io::Cursor& cursor);
   UnixSocket::Message processTakeoverStartupMsg(folly::io::Cursor& cursor);
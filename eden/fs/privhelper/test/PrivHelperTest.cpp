@@ -395,6 +395,36 @@ TEST_F(PrivHelperTest, bindMounts) {
       UnorderedElementsAre("/bind/never/actually/mounted"));
 }
 
+TEST_F(PrivHelperTest, batchedBindMounts) {
+  auto abcMountPoint = makeTempDir("abc");
+  auto abcPath = abcMountPoint.path().string();
+  TemporaryFile tempFile;
+
+  server_.setFuseMountResult(abcPath).setValue(File(tempFile.fd(), false));
+  server_.setBindMountResult(abcPath + "/buck-out").setValue();
+  server_.setBindMountResult(abcPath + "/foo/buck-out")
+      .setException(std::runtime_error("bind mount failed"));
+  server_.setFuseUnmountResult(abcPath).setValue();
+  server_.setBindUnmountResult(abcPath + "/buck-out").setValue();
+
+  client_->fuseMount(abcPath, false).get(1s);
+  std::vector<std::pair<string, string>> bindMounts{
+      {"/bind/mount/source", abcPath + "/buck-out"},
+      {"/bind/mount/source", abcPath + "/foo/buck-out"},
+      {"/bind/mount/source", "/not/a/mount/buck-out"},
+  };
+  auto results = client_->bindMounts(std::move(bindMounts)).get(1s);
+
+  // Each entry fails or succeeds on its own.
+  ASSERT_EQ(3u, results.size());
+  EXPECT_TRUE(results[0].hasValue());
+  EXPECT_THROW_RE(results[1].value(), PrivHelperError, "bind mount failed");
+  EXPECT_THROW_RE(
+      results[2].value(),
+      PrivHelperError,
+      "No FUSE mount found for /not/a/mount/buck-out");
+}
+
 TEST_F(PrivHelperTest, takeoverShutdown) {
   auto abcMountPoint = makeTempDir("abc");
   auto abcPath = abcMountPoint.path().string();
@@ -9,6 +9,7 @@
 
 #include "eden/fs/prjfs/Enumerator.h"
 
+#include <algorithm>
 #include <optional>
 #include <string>
 
@@ -36,6 +37,22 @@ PrjfsDirEntry::PrjfsDirEntry(
                                        .via(folly::getGlobalCPUExecutor()))
               : std::nullopt} {}
 
+PrjfsDirEntry::PrjfsDirEntry(const Ready& ready)
+    : name_{ready.name},
+      sizeFuture_{folly::makeFuture(ready.size)},
+      isDir_{ready.isDir},
+      symlinkTarget_{
+          ready.symlinkTarget.has_value()
+              ? std::make_optional(
+                    folly::FutureSplitter<std::pair<std::string, bool>>{
+                        folly::makeFuture(std::make_pair(
+                            ready.symlinkTarget.value(), ready.isDir))})
+              : std::nullopt} {}
+
+bool PrjfsDirEntry::Ready::operator<(const Ready& other) const {
+  return PrjFileNameCompare(name.c_str(), other.name.c_str()) < 0;
+}
+
 bool PrjfsDirEntry::matchPattern(const std::wstring& pattern) const {
   return PrjFileNameMatch(name_.c_str(), pattern.c_str());
 }
@@ -78,6 +95,10 @@ Enumeration::Enumeration(std::vector<PrjfsDirEntry::Ready> dirEntries)
 
 Enumerator::Enumerator(std::vector<PrjfsDirEntry> entryList)
     : metadataList_(std::move(entryList)) {
+  // Entries built from a cached enumeration are already sorted.
+  if (std::is_sorted(metadataList_.begin(), metadataList_.end())) {
+    return;
+  }
   std::sort(
       metadataList_.begin(),
       metadataList_.end(),
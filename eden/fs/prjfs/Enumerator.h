@@ -40,8 +40,19 @@ class PrjfsDirEntry {
     bool isDir;
     /** Optional symlink target for symlinks */
     std::optional<std::string> symlinkTarget;
+
+    /**
+     * Same ordering as PrjfsDirEntry::operator<.
+     */
+    bool operator<(const Ready& other) const;
   };
 
+  /**
+   * Build an entry from a previously resolved one, without converting its name
+   * again.
+   */
+  explicit PrjfsDirEntry(const Ready& ready);
+
   /**
    * Test whether this entry matches the given pattern.
    */
@@ -766,47 +766,52 @@ HRESULT PrjfsChannelInner::queryFileName(
 
 namespace {
 
-struct PrjAlignedBufferDeleter {
-  void operator()(void* buffer) noexcept {
-    ::PrjFreeAlignedBuffer(buffer);
-  }
-};
+uint64_t BlockAlignTruncate(uint64_t ptr, uint32_t alignment) {
+  return ((ptr) & (0 - (static_cast<uint64_t>(alignment))));
+}
 
-HRESULT readMultipleFileChunks(
+constexpr uint32_t kMinChunkSize = 512 * 1024; // 512 KiB
+constexpr uint32_t kMaxChunkSize = 5 * 1024 * 1024; // 5 MiB
+
+// Number of write buffers of each size kept around for the next reads.
+constexpr size_t kMaxPooledSmallWriteBuffers = 8;
+constexpr size_t kMaxPooledLargeWriteBuffers = 2;
+
+/**
+ * Write content[startOffset, startOffset + length) to the file with
+ * PrjWriteFileData, copying it through writeBuffer. Writes larger than
+ * kMaxChunkSize are split into chunks ending on alignment boundaries.
+ */
+HRESULT writeFileChunks(
     PRJ_NAMESPACE_VIRTUALIZATION_CONTEXT namespaceVirtualizationContext,
     const Guid& dataStreamId,
-    const std::string& content,
+    folly::ByteRange content,
+    void* writeBuffer,
     uint64_t startOffset,
     uint64_t length,
-    uint64_t chunkSize) {
-  HRESULT result;
-  std::unique_ptr<void, PrjAlignedBufferDeleter> writeBuffer{
-      PrjAllocateAlignedBuffer(namespaceVirtualizationContext, chunkSize)};
-
-  if (writeBuffer.get() == nullptr) {
-    return E_OUTOFMEMORY;
-  }
-
-  uint64_t remainingLength = length;
-
-  while (remainingLength > 0) {
-    uint64_t copySize = std::min(remainingLength, chunkSize);
+    uint32_t alignment) {
+  uint64_t endOffset = startOffset + length;
+
+  while (startOffset < endOffset) {
+    uint64_t chunkEnd = endOffset;
+    if (chunkEnd - startOffset > kMaxChunkSize) {
+      chunkEnd = BlockAlignTruncate(startOffset + kMaxChunkSize, alignment);
+      XDCHECK_GT(chunkEnd, startOffset);
+    }
+    uint64_t copySize = chunkEnd - startOffset;
 
     //
     // TODO(puneetk): Once backing store has the support for chunking the file
     // contents, we can read the chunks of large files here and then write
     // them to FS.
     //
-    // TODO(puneetk): Build an interface to backing store so that we can pass
-    // the aligned buffer to avoid coping here.
-    //
-    RtlCopyMemory(writeBuffer.get(), content.data() + startOffset, copySize);
+    RtlCopyMemory(writeBuffer, content.data() + startOffset, copySize);
 
     // Write the data to the file in the local file system.
-    result = PrjWriteFileData(
+    HRESULT result = PrjWriteFileData(
         namespaceVirtualizationContext,
         dataStreamId,
-        writeBuffer.get(),
+        writeBuffer,
         startOffset,
         folly::to_narrow(copySize));
 
@@ -814,36 +819,43 @@ HRESULT readMultipleFileChunks(
       return result;
     }
 
-    remainingLength -= copySize;
-    startOffset += copySize;
+    startOffset = chunkEnd;
   }
 
   return S_OK;
 }
 
-HRESULT readSingleFileChunk(
-    PRJ_NAMESPACE_VIRTUALIZATION_CONTEXT namespaceVirtualizationContext,
-    const Guid& dataStreamId,
-    const std::string& content,
-    uint64_t startOffset,
-    uint64_t length) {
-  return readMultipleFileChunks(
-      namespaceVirtualizationContext,
-      dataStreamId,
-      content,
-      /*startOffset=*/startOffset,
-      /*length=*/length,
-      /*writeLength=*/length);
-}
+} // namespace
 
-uint64_t BlockAlignTruncate(uint64_t ptr, uint32_t alignment) {
-  return ((ptr) & (0 - (static_cast<uint64_t>(alignment))));
+void PrjfsChannelInner::PrjAlignedBufferDeleter::operator()(
+    void* buffer) noexcept {
+  ::PrjFreeAlignedBuffer(buffer);
+}
+
+PrjfsChannelInner::WriteBuffer PrjfsChannelInner::acquireWriteBuffer(
+    uint64_t size) {
+  XDCHECK_LE(size, kMaxChunkSize);
+  bool small = size <= kMinChunkSize;
+  {
+    auto pool = small ? smallWriteBuffers_.wlock() : largeWriteBuffers_.wlock();
+    if (!pool->empty()) {
+      auto buffer = std::move(pool->back());
+      pool->pop_back();
+      return buffer;
+    }
+  }
+  return WriteBuffer{PrjAllocateAlignedBuffer(
+      mountChannel_, small ? kMinChunkSize : kMaxChunkSize)};
 }
 
-constexpr uint32_t kMinChunkSize = 512 * 1024; // 512 KiB
-constexpr uint32_t kMaxChunkSize = 5 * 1024 * 1024; // 5 MiB
-
-} // namespace
+void PrjfsChannelInner::releaseWriteBuffer(WriteBuffer buffer, uint64_t size) {
+  bool small = size <= kMinChunkSize;
+  auto pool = small ? smallWriteBuffers_.wlock() : largeWriteBuffers_.wlock();
+  if (pool->size() <
+      (small ? kMaxPooledSmallWriteBuffers : kMaxPooledLargeWriteBuffers)) {
+    pool->push_back(std::move(buffer));
+  }
+}
 
 HRESULT PrjfsChannelInner::getFileData(
     std::shared_ptr<PrjfsRequestContext> context,
@@ -874,65 +886,55 @@ HRESULT PrjfsChannelInner::getFileData(
             length);
         return dispatcher_
             ->read(std::move(path), context->getObjectFetchContext())
-            .thenValue([context = std::move(context),
+            .thenValue([this,
+                        context = std::move(context),
                         virtualizationContext = virtualizationContext,
                         dataStreamId = std::move(dataStreamId),
                         byteOffset = byteOffset,
-                        length = length](const std::string content) {
+                        length = length](folly::IOBuf content) mutable {
+              // Blobs are usually held in a single buffer, coalescing them
+              // doesn't copy.
+              auto data = content.coalesce();
+
               //
               // We should return file data which is smaller than
               // our kMaxChunkSize and meets the memory alignment
               // requirements of the virtualization instance's storage
               // device.
               //
+              // If the file is small - copy the whole file in one shot.
+              // Otherwise copy the requested range, in multiple chunks when
+              // it's larger than kMaxChunkSize.
+              //
+              bool wholeFile = data.size() <= kMinChunkSize;
+              uint64_t startOffset = wholeFile ? 0 : byteOffset;
+              uint64_t writeLength = wholeFile ? data.size() : length;
 
-              HRESULT result;
-              if (content.length() <= kMinChunkSize) {
-                //
-                // If the file is small - copy the whole file in one shot.
-                //
-                result = readSingleFileChunk(
-                    virtualizationContext,
-                    dataStreamId,
-                    content,
-                    /*startOffset=*/0,
-                    /*writeLength=*/content.length());
-
-              } else if (length <= kMaxChunkSize) {
-                //
-                // If the request is with in our kMaxChunkSize - copy the
-                // entire request.
-                //
-                result = readSingleFileChunk(
-                    virtualizationContext,
-                    dataStreamId,
-                    content,
-                    /*startOffset=*/byteOffset,
-                    /*writeLength=*/length);
-              } else {
-                //
-                // When the request is larger than kMaxChunkSize we split
-                // the request into multiple chunks.
-                //
+              HRESULT result = S_OK;
+              uint32_t alignment = 1;
+              if (writeLength > kMaxChunkSize) {
                 PRJ_VIRTUALIZATION_INSTANCE_INFO instanceInfo;
                 result = PrjGetVirtualizationInstanceInfo(
                     virtualizationContext, &instanceInfo);
+                alignment = instanceInfo.WriteAlignment;
+              }
 
-                if (SUCCEEDED(result)) {
-                  uint64_t startOffset = byteOffset;
-                  uint64_t endOffset = BlockAlignTruncate(
-                      startOffset + kMaxChunkSize, instanceInfo.WriteAlignment);
-                  XDCHECK_GT(endOffset, 0ul);
-                  XDCHECK_GT(endOffset, startOffset);
-
-                  uint64_t chunkSize = endOffset - startOffset;
-                  result = readMultipleFileChunks(
+              if (SUCCEEDED(result)) {
+                uint64_t bufferSize = std::min<uint64_t>(
+                    std::max<uint64_t>(writeLength, 1), kMaxChunkSize);
+                auto writeBuffer = acquireWriteBuffer(bufferSize);
+                if (writeBuffer.get() == nullptr) {
+                  result = E_OUTOFMEMORY;
+                } else {
+                  result = writeFileChunks(
                       virtualizationContext,
                       dataStreamId,
-                      content,
-                      /*startOffset=*/startOffset,
-                      /*length=*/length,
-                      /*chunkSize=*/chunkSize);
+                      data,
+                      writeBuffer.get(),
+                      startOffset,
+                      writeLength,
+                      alignment);
+                  releaseWriteBuffer(std::move(writeBuffer), bufferSize);
                 }
               }
 
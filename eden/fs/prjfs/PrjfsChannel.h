@@ -436,6 +436,23 @@ class PrjfsChannelInner {
     return it->second;
   }
 
+  struct PrjAlignedBufferDeleter {
+    void operator()(void* buffer) noexcept;
+  };
+  using WriteBuffer = std::unique_ptr<void, PrjAlignedBufferDeleter>;
+
+  /**
+   * Return an aligned buffer of at least size bytes to pass to
+   * PrjWriteFileData, reusing one released by a previous read when possible.
+   * Returns nullptr if it couldn't be allocated.
+   */
+  WriteBuffer acquireWriteBuffer(uint64_t size);
+
+  /**
+   * Give a buffer returned by acquireWriteBuffer(size) back to the pool.
+   */
+  void releaseWriteBuffer(WriteBuffer buffer, uint64_t size);
+
   void removeDirectoryEnumeration(Guid& guid) {
     enumSessions_.wlock()->erase(guid);
     // In theory, we should check that we removed an entry, but ProjectedFS
@@ -471,6 +488,11 @@ class PrjfsChannelInner {
   std::vector<TraceSubscriptionHandle<PrjfsTraceEvent>>
       traceSubscriptionHandles_;
   std::atomic<size_t> traceDetailedArguments_;
+  // Aligned buffers released by reads, to be reused by the next ones. Small
+  // buffers hold kMinChunkSize bytes, large ones kMaxChunkSize bytes.
+  folly::Synchronized<std::vector<WriteBuffer>> smallWriteBuffers_;
+  folly::Synchronized<std::vector<WriteBuffer>> largeWriteBuffers_;
+
   // The TraceBus must be the last member because its subscribed functions may
   // close over `this` and can run until the TraceBus itself is deallocated.
   std::shared_ptr<TraceBus<PrjfsTraceEvent>> traceBus_;
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <folly/executors/SequencedExecutor.h>
+#include <folly/io/IOBuf.h>
 #include <folly/portability/Windows.h>
 
 #include "eden/fs/inodes/InodeTimestamps.h"
@@ -86,12 +87,13 @@ class PrjfsDispatcher {
   /**
    * Read the file with the given name
    *
-   * Returns the entire content of the file at path.
+   * Returns the entire content of the file at path. The returned IOBuf may
+   * share its buffer with the cached blob, it isn't copied.
    *
    * In the future, this will return only what's in between offset and
    * offset+length.
    */
-  virtual ImmediateFuture<std::string> read(
+  virtual ImmediateFuture<folly::IOBuf> read(
       RelativePath path,
       const ObjectFetchContextPtr& context) = 0;
 
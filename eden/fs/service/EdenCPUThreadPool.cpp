@@ -10,10 +10,19 @@
 #include <folly/portability/GFlags.h>
 
 DEFINE_int32(num_eden_threads, 12, "the number of eden CPU worker threads");
+DEFINE_bool(
+    eden_cpu_work_stealing,
+    false,
+    "run the eden CPU worker threads' tasks with a WorkStealingExecutor, "
+    "rather than from a single FIFO queue");
 
 namespace facebook::eden {
 
 EdenCPUThreadPool::EdenCPUThreadPool()
-    : UnboundedQueueExecutor(FLAGS_num_eden_threads, "EdenCPUThread") {}
+    : UnboundedQueueExecutor(
+          FLAGS_num_eden_threads,
+          "EdenCPUThread",
+          FLAGS_eden_cpu_work_stealing ? Scheduling::WorkStealing
+                                       : Scheduling::Fifo) {}
 
 } // namespace facebook::eden
@@ -14,6 +14,7 @@
 #include <fb303/TFunctionStatHandler.h>
 #include <folly/Conv.h>
 #include <folly/MapUtil.h>
+#include <folly/Utility.h>
 #include <folly/experimental/FunctionScheduler.h>
 #include <folly/init/Init.h>
 #include <folly/logging/Init.h>
@@ -154,6 +155,14 @@ void EdenMain::registerStandardBackingStores() {
                                  ->hgEnableBlobMetaLocalStoreCaching.getValue()
         ? LocalStoreCachedBackingStore::CachingPolicy::TreesAndBlobMetadata
         : LocalStoreCachedBackingStore::CachingPolicy::Trees;
+    if (reloadableConfig->getEdenConfig()
+            ->hgEnableDeduplicatedBlobLocalStoreCaching.getValue()) {
+      localStoreCaching =
+          static_cast<LocalStoreCachedBackingStore::CachingPolicy>(
+              folly::to_underlying(localStoreCaching) |
+              folly::to_underlying(LocalStoreCachedBackingStore::
+                                       CachingPolicy::DeduplicatedBlobs));
+    }
     return std::make_shared<LocalStoreCachedBackingStore>(
         std::make_shared<HgQueuedBackingStore>(
             params.localStore,
@@ -174,8 +183,10 @@ void EdenMain::registerStandardBackingStores() {
       [](const CreateParams& params) -> std::shared_ptr<BackingStore> {
 #ifdef EDEN_HAVE_GIT
         const auto repoPath = realpath(params.name);
+        auto numThreads = params.serverState->getEdenConfig()
+                              ->numBackingstoreThreads.getValue();
         return std::make_shared<LocalStoreCachedBackingStore>(
-            std::make_shared<GitBackingStore>(repoPath),
+            std::make_shared<GitBackingStore>(repoPath, numThreads),
             params.localStore,
             params.sharedStats.copy(),
             LocalStoreCachedBackingStore::CachingPolicy::TreesAndBlobMetadata);
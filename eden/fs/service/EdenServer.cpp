@@ -7,8 +7,10 @@
 
 #include "eden/fs/service/EdenServer.h"
 
+#include <boost/filesystem.hpp>
 #include <cpptoml.h>
 #include <algorithm>
+#include <array>
 #include <chrono>
 
 #include <sys/stat.h>
@@ -16,17 +18,21 @@
 #include <fstream>
 #include <functional>
 #include <iterator>
+#include <map>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 
 #include <fb303/ServiceData.h>
 #include <fmt/core.h>
+#include <fmt/format.h>
 #include <folly/Exception.h>
 #include <folly/FileUtil.h>
 #include <folly/SocketAddress.h>
 #include <folly/String.h>
 #include <folly/chrono/Conv.h>
+#include <folly/futures/Future.h>
 #include <folly/io/async/AsyncSignalHandler.h>
 #include <folly/io/async/HHWheelTimer.h>
 #include <folly/logging/xlog.h>
@@ -42,33 +48,41 @@
 #include "eden/common/utils/ProcessNameCache.h"
 #include "eden/fs/config/CheckoutConfig.h"
 #include "eden/fs/config/MountProtocol.h"
+#include "eden/fs/config/ReloadableConfig.h"
 #include "eden/fs/config/TomlConfig.h"
 #include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/inodes/FileInode.h"
 #include "eden/fs/inodes/InodeBase.h"
 #include "eden/fs/inodes/InodeMap.h"
+#include "eden/fs/inodes/PrefetchPredictor.h"
 #include "eden/fs/inodes/ServerState.h"
 #include "eden/fs/inodes/TreeInode.h"
 #include "eden/fs/journal/Journal.h"
 #include "eden/fs/nfs/NfsServer.h"
+#include "eden/fs/nfs/Nfsd3.h"
 #include "eden/fs/notifications/NullNotifier.h"
 #include "eden/fs/privhelper/PrivHelper.h"
 #include "eden/fs/service/EdenCPUThreadPool.h"
 #include "eden/fs/service/EdenServiceHandler.h"
 #include "eden/fs/service/StartupLogger.h"
 #include "eden/fs/service/StartupStatusSubscriber.h"
+#include "eden/fs/service/ThriftGlobImpl.h"
 #include "eden/fs/service/ThriftStreamStartupStatusSubscriber.h"
 #include "eden/fs/service/ThriftUtil.h"
 #include "eden/fs/service/UsageService.h"
 #include "eden/fs/service/gen-cpp2/eden_types.h"
 #include "eden/fs/store/BackingStoreLogger.h"
 #include "eden/fs/store/BlobCache.h"
+#include "eden/fs/store/BufferedLocalStore.h"
 #include "eden/fs/store/EmptyBackingStore.h"
 #include "eden/fs/store/LocalStore.h"
 #include "eden/fs/store/LocalStoreCachedBackingStore.h"
 #include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/store/ObjectStore.h"
 #include "eden/fs/store/RocksDbLocalStore.h"
 #include "eden/fs/store/SqliteLocalStore.h"
+#include "eden/fs/store/TieredLocalStore.h"
 #include "eden/fs/store/TreeCache.h"
 #include "eden/fs/store/hg/HgBackingStore.h"
 #include "eden/fs/store/hg/HgQueuedBackingStore.h"
@@ -204,6 +218,7 @@ std::shared_ptr<Notifier> getPlatformNotifier(
 
 constexpr StringPiece kRocksDBPath{"storage/rocks-db"};
 constexpr StringPiece kSqlitePath{"storage/sqlite.db"};
+constexpr StringPiece kHotTierPath{"storage/hot-tier"};
 constexpr StringPiece kHgStorePrefix{"store.hg"};
 #ifndef _WIN32
 constexpr StringPiece kFuseRequestPrefix{"fuse"};
@@ -240,6 +255,74 @@ std::string getCounterNameForImportMetric(
       RequestMetricsScope::stringOfRequestMetric(metric));
 }
 
+/**
+ * Fetches for the local predictive prefetch, which only makes use of idle
+ * time: they queue behind everything else and stop being imported once the
+ * PrefetchPredictor notices the mount getting busy.
+ */
+class PredictedPrefetchContext final : public ObjectFetchContext {
+ public:
+  explicit PredictedPrefetchContext(folly::CancellationToken token)
+      : token_{std::move(token)} {}
+
+  Cause getCause() const override {
+    return Cause::Prefetch;
+  }
+
+  std::optional<std::string_view> getCauseDetail() const override {
+    return "EdenServer::prefetchPredictedDirectories";
+  }
+
+  ImportPriority getPriority() const override {
+    return ImportPriority{ImportPriority::Class::Low};
+  }
+
+  const std::unordered_map<std::string, std::string>* getRequestInfo()
+      const override {
+    return nullptr;
+  }
+
+  folly::CancellationToken getCancellationToken() const override {
+    return token_;
+  }
+
+ private:
+  folly::CancellationToken token_;
+};
+
+/**
+ * Orders checkouts to be remounted: those in priority first, in that order,
+ * then the others by the modification time of their SNAPSHOT file, which is
+ * rewritten on every checkout and commit, most recent first.
+ */
+void sortForStartup(
+    std::vector<std::unique_ptr<CheckoutConfig>>& configs,
+    const std::vector<AbsolutePath>& priority) {
+  struct Rank {
+    size_t priority;
+    std::time_t lastUsed;
+  };
+  std::unordered_map<const CheckoutConfig*, Rank> ranks;
+  for (const auto& config : configs) {
+    auto it =
+        std::find(priority.begin(), priority.end(), config->getMountPath());
+    boost::system::error_code ec;
+    auto lastUsed = boost::filesystem::last_write_time(
+        config->getSnapshotPath().asString(), ec);
+    ranks[config.get()] = Rank{
+        static_cast<size_t>(it - priority.begin()), ec ? 0 : lastUsed};
+  }
+  std::stable_sort(
+      configs.begin(), configs.end(), [&](const auto& a, const auto& b) {
+        const auto& rankA = ranks[a.get()];
+        const auto& rankB = ranks[b.get()];
+        if (rankA.priority != rankB.priority) {
+          return rankA.priority < rankB.priority;
+        }
+        return rankA.lastUsed > rankB.lastUsed;
+      });
+}
+
 #ifndef _WIN32
 std::string getCounterNameForFuseRequests(
     RequestMetricsScope::RequestStage stage,
@@ -667,11 +750,12 @@ Future<TakeoverData> EdenServer::stopMountsForTakeover(
   // Use collectAll() rather than collect() to wait for all of the unmounts
   // to complete, and only check for errors once everything has finished.
   return folly::collectAll(futures).toUnsafeFuture().thenValue(
-      [takeoverPromise = std::move(takeoverPromise)](
+      [this, takeoverPromise = std::move(takeoverPromise)](
           std::vector<folly::Try<optional<TakeoverData::MountInfo>>>
               results) mutable {
         TakeoverData data;
         data.takeoverComplete = std::move(takeoverPromise);
+        data.treeCache = treeCache_->getAll();
         data.mountPoints.reserve(results.size());
         for (auto& result : results) {
           // If something went wrong shutting down a mount point,
@@ -728,9 +812,16 @@ void EdenServer::updatePeriodicTaskIntervals(const EdenConfig& config) {
   // Update all periodic tasks whose interval is
   // controlled by EdenConfig settings.
 
+  auto reloadInterval = config.configReloadInterval.getValue();
+  auto reloadInBackground = config.configReloadInBackground.getValue();
+  serverState_->getReloadableConfig()->setReloadInBackground(
+      reloadInBackground);
+  if (reloadInBackground) {
+    reloadInterval = std::min<std::chrono::nanoseconds>(
+        reloadInterval, ReloadableConfig::kAutoReloadInterval);
+  }
   reloadConfigTask_.updateInterval(
-      std::chrono::duration_cast<std::chrono::milliseconds>(
-          config.configReloadInterval.getValue()));
+      std::chrono::duration_cast<std::chrono::milliseconds>(reloadInterval));
 
   // The checkValidityTask_ isn't really needed on Windows, since the lock file
   // cannot be removed while we are holding it.
@@ -766,6 +857,24 @@ void EdenServer::updatePeriodicTaskIntervals(const EdenConfig& config) {
   } else {
     detectNfsCrawlTask_.updateInterval(0s);
   }
+
+  if (config.slowRequestThreshold.getValue().count() > 0) {
+    detectSlowRequestsTask_.updateInterval(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            config.slowRequestCheckInterval.getValue()));
+  } else {
+    detectSlowRequestsTask_.updateInterval(0s);
+  }
+
+#ifndef _WIN32
+  if (config.inodeUnloadRssWatermark.getValue() > 0) {
+    unloadIdleInodesTask_.updateInterval(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            config.inodeUnloadSweepInterval.getValue()));
+  } else {
+    unloadIdleInodesTask_.updateInterval(0s);
+  }
+#endif
 }
 
 void EdenServer::scheduleCallbackOnMainEventBase(
@@ -931,7 +1040,24 @@ Future<Unit> EdenServer::prepareImpl(std::shared_ptr<StartupLogger> logger) {
 
   startPeriodicTasks();
 
+  // TODO: The "state config" only has one configuration knob now. When
+  // another is required, introduce an EdenStateConfig class to manage
+  // defaults and save on update.
+  auto config = parseConfig();
+  bool shouldSaveConfig = createStorageEngine(*config);
+  if (shouldSaveConfig) {
+    saveConfig(*config);
+  }
+
 #ifndef _WIN32
+  // The backing stores only need the (not yet opened) local store object, so
+  // they can be created while the old process still owns the mounts.
+  if (doingTakeover &&
+      serverState_->getEdenConfig()
+          ->createBackingStoresBeforeTakeover.getValue()) {
+    createBackingStoresForTakeover(*logger);
+  }
+
   // If we are gracefully taking over from an existing edenfs process,
   // receive its lock, thrift socket, and mount points now.
   // This will shut down the old process.
@@ -949,6 +1075,13 @@ Future<Unit> EdenServer::prepareImpl(std::shared_ptr<StartupLogger> logger) {
         takeoverData.mountPoints.size(),
         " mount points");
 
+    // Start with the trees the old process had cached rather than refetching
+    // them from the local store as they are used again.
+    for (auto& tree : takeoverData.treeCache) {
+      treeCache_->insert(std::move(tree));
+    }
+    takeoverData.treeCache.clear();
+
     // Take over the eden lock file and the thrift server socket.
     edenDir_.takeoverLock(std::move(takeoverData.lockFile));
     server_->useExistingSocket(takeoverData.thriftSocket.release());
@@ -980,15 +1113,6 @@ Future<Unit> EdenServer::prepareImpl(std::shared_ptr<StartupLogger> logger) {
 #endif
   }
 
-  // TODO: The "state config" only has one configuration knob now. When
-  // another is required, introduce an EdenStateConfig class to manage
-  // defaults and save on update.
-  auto config = parseConfig();
-  bool shouldSaveConfig = createStorageEngine(*config);
-  if (shouldSaveConfig) {
-    saveConfig(*config);
-  }
-
 #ifndef _WIN32
   // Start listening for graceful takeover requests
   takeoverServer_.reset(new TakeoverServer(
@@ -1078,7 +1202,14 @@ bool EdenServer::createStorageEngine(cpptoml::table& config) {
     ensureDirectoryExists(parentDir);
     XLOG(DBG2) << "Creating local SQLite store " << path << "...";
     folly::stop_watch<std::chrono::milliseconds> watch;
-    localStore_ = make_shared<SqliteLocalStore>(path, getStats().copy());
+    auto edenConfig = serverState_->getReloadableConfig()->getEdenConfig();
+    SqliteLocalStore::Options options;
+    options.readConnections =
+        edenConfig->sqliteLocalStoreReadConnections.getValue();
+    options.mmapSize = edenConfig->sqliteLocalStoreMmapSize.getValue();
+    options.cacheSize = edenConfig->sqliteLocalStoreCacheSize.getValue();
+    localStore_ = make_shared<SqliteLocalStore>(
+        path, getStats().copy(), options);
     XLOG(DBG2) << "Opened SQLite store in " << watch.elapsed().count() / 1000.0
                << " seconds.";
   } else if (storageEngine == "rocksdb") {
@@ -1091,6 +1222,16 @@ bool EdenServer::createStorageEngine(cpptoml::table& config) {
         getStats().copy(),
         serverState_->getStructuredLogger(),
         &serverState_->getFaultInjector());
+    auto hotTierSize = serverState_->getReloadableConfig()
+                           ->getEdenConfig()
+                           ->localStoreHotTierSize.getValue();
+    if (hotTierSize > 0) {
+      localStore_ = make_shared<TieredLocalStore>(
+          edenDir_.getPath() + RelativePathPiece{kHotTierPath},
+          hotTierSize,
+          std::move(localStore_),
+          getStats().copy());
+    }
     XLOG(DBG2) << "Created RocksDB store in "
                << watch.elapsed().count() / 1000.0 << " seconds.";
   } else {
@@ -1098,6 +1239,17 @@ bool EdenServer::createStorageEngine(cpptoml::table& config) {
         folly::to<string>("invalid storage engine: ", storageEngine));
   }
 
+  auto edenConfig = serverState_->getReloadableConfig()->getEdenConfig();
+  auto writeBufferSize = edenConfig->localStoreWriteBufferSize.getValue();
+  if (writeBufferSize > 0) {
+    localStore_ = make_shared<BufferedLocalStore>(
+        std::move(localStore_),
+        writeBufferSize,
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            edenConfig->localStoreWriteFlushLatency.getValue()),
+        getStats().copy());
+  }
+
   return configUpdated;
 }
 
@@ -1152,6 +1304,42 @@ std::vector<Future<Unit>> EdenServer::prepareMountsTakeover(
   return mountFutures;
 }
 
+void EdenServer::createBackingStoresForTakeover(StartupLogger& logger) {
+  folly::dynamic dirs = folly::dynamic::object();
+  try {
+    dirs = CheckoutConfig::loadClientDirectoryMap(edenDir_.getPath());
+  } catch (const std::exception& ex) {
+    XLOG(WARN) << "not creating backing stores before takeover: "
+               << folly::exceptionStr(ex);
+    return;
+  }
+
+  folly::stop_watch<std::chrono::milliseconds> watch;
+  for (const auto& client : dirs.items()) {
+    try {
+      auto mountPath = canonicalPath(client.first.stringPiece());
+      auto edenClientPath =
+          edenDir_.getCheckoutStateDir(client.second.stringPiece());
+      auto config =
+          CheckoutConfig::loadFromClientDirectory(mountPath, edenClientPath);
+      getBackingStore(
+          toBackingStoreType(config->getRepoType()),
+          config->getRepoSource(),
+          *config);
+    } catch (const std::exception& ex) {
+      XLOG(WARN) << "failed to create the backing store of "
+                 << client.first.asString()
+                 << " before takeover: " << folly::exceptionStr(ex);
+    }
+  }
+  logger.log(
+      "Created backing stores for ",
+      dirs.size(),
+      " checkouts in ",
+      watch.elapsed().count() / 1000.0,
+      " seconds.");
+}
+
 std::vector<Future<Unit>> EdenServer::prepareMounts(
     shared_ptr<StartupLogger> logger) {
   std::vector<Future<Unit>> mountFutures;
@@ -1175,15 +1363,31 @@ std::vector<Future<Unit>> EdenServer::prepareMounts(
   }
   logger->log("Remounting ", dirs.size(), " mount points...");
 
+  std::vector<std::unique_ptr<CheckoutConfig>> configs;
   for (const auto& client : dirs.items()) {
-    auto mountFuture = makeFutureWith([&] {
+    try {
       auto mountPath = canonicalPath(client.first.stringPiece());
       auto edenClientPath =
           edenDir_.getCheckoutStateDir(client.second.stringPiece());
-      auto initialConfig =
-          CheckoutConfig::loadFromClientDirectory(mountPath, edenClientPath);
+      configs.push_back(
+          CheckoutConfig::loadFromClientDirectory(mountPath, edenClientPath));
+    } catch (...) {
+      auto ew = folly::exception_wrapper{std::current_exception()};
+      incrementStartupMountFailures();
+      logger->warn(
+          "Failed to remount ", client.first.asString(), ": ", ew.what());
+      mountFutures.emplace_back(std::move(ew));
+    }
+  }
+  sortForStartup(
+      configs,
+      serverState_->getEdenConfig()->startupMountPriority.getValue());
+
+  for (auto& initialConfig : configs) {
+    auto mountFuture = makeFutureWith([&] {
+      auto mountPath = initialConfig->getMountPath();
       auto progressIndex = progressManager_->wlock()->registerEntry(
-          client.first.asString(), initialConfig->getOverlayPath().c_str());
+          mountPath.asString(), initialConfig->getOverlayPath().c_str());
 
       return mount(
                  std::move(initialConfig),
@@ -1660,6 +1864,12 @@ folly::Future<std::shared_ptr<EdenMount>> EdenServer::mount(
               event.success = !t.hasException();
               event.clean = edenMount->getOverlay()->hadCleanStartup();
               serverState_->getStructuredLogger()->logEvent(event);
+              // A graceful restart keeps the caches warm; anything else
+              // starts from an empty cache.
+              if (!doTakeover && !t.hasException()) {
+                warmPredictedDirectories(
+                    EdenMountHandle{edenMount, edenMount->getRootInode()});
+              }
               return makeFuture(std::move(t));
             });
       });
@@ -1832,14 +2042,19 @@ Future<CheckoutResult> EdenServer::checkOutRevision(
           clientPid,
           callerName,
           checkoutMode)
-      .thenValue([this, checkoutMode, isNfs, mountPath = mountPath.copy()](
-                     CheckoutResult&& result) {
+      .thenValue([this,
+                  checkoutMode,
+                  isNfs,
+                  mountHandle,
+                  mountPath = mountPath.copy()](CheckoutResult&& result) {
         getServerState()->getNotifier()->signalCheckout(
             enumerateInProgressCheckouts());
         if (checkoutMode == CheckoutMode::DRY_RUN) {
           return std::move(result);
         }
 
+        prefetchPredictedDirectories(mountHandle);
+
         // In NFSv3 the kernel never tells us when its safe to unload
         // inodes ("safe" meaning all file handles to the inode have been
         // closed).
@@ -1914,6 +2129,26 @@ shared_ptr<BackingStore> EdenServer::getBackingStore(
   return store;
 }
 
+std::shared_ptr<ObjectStore> EdenServer::getRepoObjectStore(
+    const std::string& repoType,
+    StringPiece repoPath) {
+  // There may be no checkout of the repository to take the config from. The
+  // BackingStores are shared by all of the checkouts of a repository, so they
+  // do not depend on it, and the default settings of a checkout are used.
+  CheckoutConfig config{canonicalPath(repoPath), edenDir_.getPath()};
+  auto backingStore =
+      getBackingStore(toBackingStoreType(repoType), repoPath, config);
+  return ObjectStore::create(
+      std::move(backingStore),
+      treeCache_,
+      getStats().copy(),
+      serverState_->getProcessNameCache(),
+      serverState_->getStructuredLogger(),
+      serverState_->getReloadableConfig()->getEdenConfig(),
+      config.getEnableWindowsSymlinks(),
+      config.getCaseSensitive());
+}
+
 std::unordered_set<std::shared_ptr<BackingStore>>
 EdenServer::getBackingStores() {
   std::unordered_set<std::shared_ptr<BackingStore>> backingStores{};
@@ -1964,6 +2199,18 @@ Future<Unit> EdenServer::createThriftServer() {
   server_ = make_shared<ThriftServer>();
   server_->setMaxRequests(edenConfig->thriftMaxRequests.getValue());
   server_->setNumCPUWorkerThreads(edenConfig->thriftNumWorkers.getValue());
+  if (edenConfig->thriftPriorityLanes.getValue()) {
+    using namespace apache::thrift::concurrency;
+    // Methods are dispatched by their priority annotation in eden.thrift.
+    std::array<size_t, N_PRIORITIES> poolSizes;
+    poolSizes.fill(std::max<size_t>(
+        1, edenConfig->thriftNumImportantWorkers.getValue()));
+    poolSizes[NORMAL] = edenConfig->thriftNumWorkers.getValue();
+    poolSizes[BEST_EFFORT] = std::max<size_t>(
+        1, edenConfig->thriftNumBestEffortWorkers.getValue());
+    server_->setThreadManagerType(ThriftServer::ThreadManagerType::PRIORITY);
+    server_->setThreadManagerPoolSizes(poolSizes);
+  }
   server_->setCPUWorkerThreadName("Thrift");
   server_->setQueueTimeout(std::chrono::floor<std::chrono::milliseconds>(
       edenConfig->thriftQueueTimeout.getValue()));
@@ -2298,6 +2545,73 @@ ImmediateFuture<uint64_t> EdenServer::garbageCollectWorkingCopy(
       });
 }
 
+void EdenServer::prefetchPredictedDirectories(
+    const EdenMountHandle& mountHandle) {
+  auto* predictor = mountHandle.getEdenMount().getPrefetchPredictor();
+  if (!predictor) {
+    return;
+  }
+  predictor->checkoutCompleted();
+  warmPredictedDirectories(mountHandle);
+}
+
+void EdenServer::warmPredictedDirectories(
+    const EdenMountHandle& mountHandle) {
+  auto* predictor = mountHandle.getEdenMount().getPrefetchPredictor();
+  if (!predictor) {
+    return;
+  }
+  auto config = serverState_->getEdenConfig();
+  auto directories = predictor->getTopDirectories(
+      config->predictivePrefetchProfileSize.getValue());
+  if (directories.empty()) {
+    return;
+  }
+  auto params = std::make_shared<PrefetchParams>();
+  std::vector<std::string> globs;
+  globs.reserve(directories.size());
+  for (const auto& directory : directories) {
+    // Directory names may contain glob special characters.
+    std::string glob;
+    for (char c : directory.view()) {
+      if (c == '*' || c == '?' || c == '[' || c == '\\') {
+        glob.push_back('\\');
+      }
+      glob.push_back(c);
+    }
+    glob += directory.empty() ? "*" : "/*";
+    globs.push_back(std::move(glob));
+  }
+
+  XLOG(DBG3) << "Prefetching the files of " << globs.size()
+             << " predicted directories of "
+             << mountHandle.getEdenMount().getPath();
+  ObjectFetchContextPtr context =
+      makeRefPtr<PredictedPrefetchContext>(predictor->startWarmup(
+          config->localPredictivePrefetchMaxForegroundLoads.getValue()));
+  folly::futures::detachOn(
+      getServerState()->getThreadPool().get(),
+      ThriftGlobImpl{*params}
+          .glob(
+              mountHandle.getEdenMountPtr(),
+              serverState_,
+              std::move(globs),
+              context)
+          .thenTry([mountHandle, params, context = context.copy()](
+                       folly::Try<std::unique_ptr<Glob>>&& result) {
+            if (context->getCancellationToken().isCancellationRequested()) {
+              XLOG(DBG3) << "Prefetch of the predicted directories of "
+                         << mountHandle.getEdenMount().getPath()
+                         << " cancelled";
+            } else if (result.hasException()) {
+              XLOG(WARN) << "Error prefetching predicted directories of "
+                         << mountHandle.getEdenMount().getPath() << ": "
+                         << folly::exceptionStr(result.exception());
+            }
+          })
+          .semi());
+}
+
 void EdenServer::garbageCollectAllMounts() {
   auto config = serverState_->getReloadableConfig()->getEdenConfig();
   auto cutoffConfig =
@@ -2323,6 +2637,188 @@ void EdenServer::garbageCollectAllMounts() {
   }
 }
 
+void EdenServer::unloadIdleInodes() {
+#ifndef _WIN32
+  auto watermark = config_->getEdenConfig()->inodeUnloadRssWatermark.getValue();
+  if (watermark == 0) {
+    return;
+  }
+
+  // Sweep every mount even when there is no memory pressure, so that the idle
+  // counts are meaningful once there is.
+  struct MountSweep {
+    EdenMountHandle mountHandle;
+    std::vector<size_t> histogram;
+  };
+  std::vector<MountSweep> sweeps;
+  for (auto& mountHandle : getMountPoints()) {
+    auto histogram =
+        mountHandle.getEdenMount().getInodeMap()->sweepLoadedInodes();
+    sweeps.push_back(MountSweep{std::move(mountHandle), std::move(histogram)});
+  }
+
+  auto memoryStats = proc_util::readMemoryStats();
+  if (!memoryStats || memoryStats->resident <= watermark) {
+    return;
+  }
+  // Aim below the watermark so that we don't unload again on the next sweep.
+  auto excess = memoryStats->resident - watermark / 10 * 9;
+
+  for (auto& sweep : sweeps) {
+    auto& mount = sweep.mountHandle.getEdenMount();
+    auto* inodeMap = mount.getInodeMap();
+    auto counts = inodeMap->getInodeCounts();
+    auto loaded = counts.fileCount + counts.treeCount;
+    if (loaded == 0) {
+      continue;
+    }
+
+    // A lower bound of the memory held by a loaded inode: the inode object and
+    // its entry in the parent directory. Trees also hold their own entries,
+    // which are accounted for by their children.
+    auto bytesPerInode = (counts.fileCount * sizeof(FileInode) +
+                          counts.treeCount * sizeof(TreeInode)) /
+            loaded +
+        sizeof(DirContents::value_type);
+
+    // Unload as few inodes as possible: pick the longest idle time whose
+    // inodes are enough to relieve the pressure, or everything outside of the
+    // working set if none is.
+    uint8_t minIdleSweeps = 1;
+    size_t candidates = 0;
+    for (size_t idle = sweep.histogram.size() - 1; idle >= 1; --idle) {
+      candidates += sweep.histogram[idle];
+      if (candidates * bytesPerInode >= excess) {
+        minIdleSweeps = static_cast<uint8_t>(idle);
+        break;
+      }
+    }
+
+    auto unloaded =
+        sweep.mountHandle.getRootInode()->unloadChildrenIdleFor(minIdleSweeps);
+    if (unloaded) {
+      XLOG(INFO) << "Unloaded " << unloaded << " inodes idle for at least "
+                 << static_cast<int>(minIdleSweeps) << " sweeps from mount "
+                 << mount.getPath() << ", working set is "
+                 << sweep.histogram[0] << " of " << loaded << " inodes";
+    }
+    inodeMap->recordPeriodicInodeUnload(unloaded);
+
+    auto freed = unloaded * bytesPerInode;
+    if (freed >= excess) {
+      break;
+    }
+    excess -= freed;
+  }
+#endif // !_WIN32
+}
+
+namespace {
+// Bounds the size of the SlowRequests events of mounts with many outstanding
+// requests. The full count is logged anyway.
+constexpr size_t kMaxLoggedOutstandingRequests = 100;
+
+/**
+ * Describe the threads of EdenFS, grouping those with the same name, state and
+ * wait channel, as the many threads of a pool usually are.
+ */
+std::string describeThreadStates() {
+  std::map<std::string, size_t> groups;
+  for (const auto& thread : proc_util::readThreadStates()) {
+    ++groups[fmt::format(
+        "{} {} {}", thread.name, thread.state, thread.waitChannel)];
+  }
+  std::string description;
+  for (const auto& [group, count] : groups) {
+    fmt::format_to(
+        std::back_inserter(description), "{} x{}\n", group, count);
+  }
+  return description;
+}
+} // namespace
+
+void EdenServer::detectSlowRequests() {
+  auto edenConfig = config_->getEdenConfig();
+  auto threshold = edenConfig->slowRequestThreshold.getValue();
+  auto interval = edenConfig->slowRequestCheckInterval.getValue();
+  if (threshold.count() == 0) {
+    return;
+  }
+  auto now = std::chrono::steady_clock::now();
+
+  struct Request {
+    std::string description;
+    std::chrono::steady_clock::duration age;
+  };
+  for (auto& mountHandle : getMountPoints()) {
+    auto& mount = mountHandle.getEdenMount();
+    std::string protocol;
+    std::vector<Request> requests;
+#ifndef _WIN32
+    if (auto* fuseChannel = mount.getFuseChannel()) {
+      protocol = "fuse";
+      for (const auto& call : fuseChannel->getOutstandingRequests()) {
+        requests.push_back(Request{
+            fmt::format(
+                "{} {}", fuseOpcodeName(call.request.opcode), call.unique),
+            now - call.requestStartTime});
+      }
+    }
+#endif // !_WIN32
+    if (auto* nfsdChannel = mount.getNfsdChannel()) {
+      protocol = "nfs";
+      for (const auto& call : nfsdChannel->getOutstandingRequests()) {
+        requests.push_back(Request{
+            fmt::format("xid {}", call.xid), now - call.requestStartTime});
+      }
+    }
+
+    // A request is reported once, on the first check after it became slow,
+    // so that a hung request doesn't flood the logs. Its peers are reported
+    // with it, and are likely stuck on the same thing.
+    auto newlySlow = std::find_if(
+        requests.begin(), requests.end(), [&](const Request& request) {
+          return request.age >= threshold && request.age < threshold + interval;
+        });
+    if (newlySlow == requests.end()) {
+      continue;
+    }
+    SlowRequests event;
+    event.mount_protocol = protocol;
+    event.request = newlySlow->description;
+    event.request_age =
+        std::chrono::duration<double>{newlySlow->age}.count();
+    event.outstanding_request_count = requests.size();
+
+    std::sort(
+        requests.begin(),
+        requests.end(),
+        [](const Request& a, const Request& b) { return a.age > b.age; });
+    if (requests.size() > kMaxLoggedOutstandingRequests) {
+      requests.resize(kMaxLoggedOutstandingRequests);
+    }
+    for (const auto& request : requests) {
+      fmt::format_to(
+          std::back_inserter(event.outstanding_requests),
+          "{} {:.3f}s\n",
+          request.description,
+          std::chrono::duration<double>{request.age}.count());
+    }
+    event.thread_states = describeThreadStates();
+
+    XLOGF(
+        WARN,
+        "{} request {} on {} has been outstanding for {:.3f}s, "
+        "{} requests are outstanding",
+        protocol,
+        event.request,
+        mount.getPath(),
+        event.request_age,
+        event.outstanding_request_count);
+    serverState_->getStructuredLogger()->logEvent(std::move(event));
+  }
+}
+
 void EdenServer::detectNfsCrawl() {
   auto edenConfig = config_->getEdenConfig();
   auto readThreshold = edenConfig->nfsCrawlReadThreshold.getValue();
@@ -361,6 +361,16 @@ class EdenServer : private TakeoverHandler {
       folly::StringPiece name,
       const CheckoutConfig& config);
 
+  /**
+   * Return an ObjectStore reading from the BackingStore of the given
+   * repository, to access its commits without going through a mount. The
+   * repoType and repoPath are those of the checkout configs of the
+   * repository, which does not need to be mounted.
+   */
+  std::shared_ptr<ObjectStore> getRepoObjectStore(
+      const std::string& repoType,
+      folly::StringPiece repoPath);
+
   AbsolutePathPiece getEdenDir() const {
     return edenDir_.getPath();
   }
@@ -554,6 +564,13 @@ class EdenServer : private TakeoverHandler {
       std::vector<TakeoverData::MountInfo>&& takeoverMounts);
   FOLLY_NODISCARD std::vector<folly::Future<folly::Unit>> prepareMounts(
       std::shared_ptr<StartupLogger> logger);
+
+  /**
+   * Create the backing stores of the configured checkouts ahead of a
+   * graceful takeover, while the old process is still serving them.
+   * Failures are logged and left for the mount itself to report.
+   */
+  void createBackingStoresForTakeover(StartupLogger& logger);
   static void incrementStartupMountFailures();
 
   /**
@@ -627,9 +644,27 @@ class EdenServer : private TakeoverHandler {
   // Run a garbage collection cycle over the inodes hierarchy.
   void garbageCollectAllMounts();
 
+  // Update the PrefetchPredictor of the mount, if any, once a checkout has
+  // completed, and prefetch the files of the directories it predicts in the
+  // background.
+  void prefetchPredictedDirectories(const EdenMountHandle& mountHandle);
+
+  // Prefetch the files of the directories predicted by the PrefetchPredictor
+  // of the mount, if any, at low priority, until the mount gets busy.
+  void warmPredictedDirectories(const EdenMountHandle& mountHandle);
+
+  // Sweep the inodes of every mount, and unload the least recently used ones
+  // if the resident memory is over the inodeUnloadRssWatermark config.
+  void unloadIdleInodes();
+
   // Detects when NFS backed repos are being crawled.
   void detectNfsCrawl();
 
+  // Log the outstanding requests of a mount and the state of every thread
+  // when one of its FUSE or NFS requests crosses the slowRequestThreshold
+  // config, so that hangs can be diagnosed after the fact.
+  void detectSlowRequests();
+
   // Cancel all subscribers on all mounts so that we can tear
   // down the thrift server without blocking
   void shutdownSubscribers();
@@ -821,5 +856,11 @@ class EdenServer : private TakeoverHandler {
   PeriodicFnTask<&EdenServer::detectNfsCrawl> detectNfsCrawlTask_{
       this,
       "detect_nfs_crawl"};
+  PeriodicFnTask<&EdenServer::detectSlowRequests> detectSlowRequestsTask_{
+      this,
+      "detect_slow_requests"};
+  PeriodicFnTask<&EdenServer::unloadIdleInodes> unloadIdleInodesTask_{
+      this,
+      "unload_idle_inodes"};
 };
 } // namespace facebook::eden
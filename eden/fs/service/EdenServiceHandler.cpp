@@ -19,12 +19,14 @@
 #include <folly/Portability.h>
 #include <folly/String.h>
 #include <folly/chrono/Conv.h>
+#include <folly/container/F14Map.h>
 #include <folly/executors/SerialExecutor.h>
 #include <folly/futures/Future.h>
 #include <folly/logging/Logger.h>
 #include <folly/logging/xlog.h>
 #include <folly/stop_watch.h>
 #include <thrift/lib/cpp/util/EnumUtils.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
 #include <thrift/lib/cpp2/server/ThriftServer.h>
 
 #include "eden/common/utils/ProcessNameCache.h"
@@ -33,6 +35,7 @@
 #include "eden/fs/fuse/FuseChannel.h"
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/FileInode.h"
+#include "eden/fs/inodes/GlobCostLog.h"
 #include "eden/fs/inodes/GlobNode.h"
 #include "eden/fs/inodes/InodeError.h"
 #include "eden/fs/inodes/InodeMap.h"
@@ -72,6 +75,7 @@
 #include "eden/fs/store/ScmStatusDiffCallback.h"
 #include "eden/fs/store/TreeCache.h"
 #include "eden/fs/store/hg/HgQueuedBackingStore.h"
+#include "eden/fs/telemetry/ChromeTraceWriter.h"
 #include "eden/fs/telemetry/SessionInfo.h"
 #include "eden/fs/telemetry/TaskTrace.h"
 #include "eden/fs/telemetry/Tracing.h"
@@ -414,13 +418,11 @@ const char* const kServiceName = "EdenFS";
 
 std::optional<ActivityBuffer<ThriftRequestTraceEvent>>
 EdenServiceHandler::initThriftRequestActivityBuffer() {
-  if (server_->getServerState()
-          ->getEdenConfig()
-          ->enableActivityBuffer.getValue()) {
+  auto config = server_->getServerState()->getEdenConfig();
+  if (config->enableActivityBuffer.getValue()) {
     return std::make_optional<ActivityBuffer<ThriftRequestTraceEvent>>(
-        server_->getServerState()
-            ->getEdenConfig()
-            ->activityBufferMaxEvents.getValue());
+        config->activityBufferMaxEvents.getValue(),
+        config->activityBufferMaxBytes.getValue());
   }
   return std::nullopt;
 }
@@ -493,6 +495,22 @@ EdenServiceHandler::EdenServiceHandler(
       });
 }
 
+/**
+ * The subscriptions writing the events of a mount to a ChromeTraceWriter,
+ * which they share.
+ */
+struct EdenServiceHandler::ChromeTrace {
+#ifdef _WIN32
+  TraceSubscriptionHandle<PrjfsTraceEvent> prjfs;
+#else
+  TraceSubscriptionHandle<FuseTraceEvent> fuse;
+  TraceSubscriptionHandle<NfsTraceEvent> nfs;
+#endif // _WIN32
+  TraceSubscriptionHandle<InodeTraceEvent> inode;
+  TraceSubscriptionHandle<HgImportTraceEvent> hg;
+  TraceSubscriptionHandle<TaskTraceEvent> task;
+};
+
 EdenServiceHandler::~EdenServiceHandler() = default;
 
 EdenMountHandle EdenServiceHandler::lookupMount(const MountId& mountId) {
@@ -612,6 +630,38 @@ EdenServiceHandler::semifuture_checkOutRevision(
       .semi();
 }
 
+folly::SemiFuture<std::unique_ptr<EstimateCheckoutResult>>
+EdenServiceHandler::semifuture_estimateCheckout(
+    std::unique_ptr<EstimateCheckoutParams> params) {
+  auto* context = getRequestContext();
+  auto helper = INSTRUMENT_THRIFT_CALL(
+      DBG2, *params->mountPoint(), logHash(*params->snapshotHash()));
+  auto mountHandle = lookupMount(params->mountPoint());
+  auto snapshotHash =
+      mountHandle.getObjectStore().parseRootId(*params->snapshotHash());
+
+  auto estimateFuture =
+      mountHandle.getEdenMount().estimateCheckout(
+          snapshotHash,
+          context->getConnectionContext()->getCancellationToken());
+  return wrapImmediateFuture(
+             std::move(helper),
+             std::move(estimateFuture)
+                 .ensure([mountHandle] {})
+                 .thenValue([](CheckoutEstimate&& estimate) {
+                   auto result = std::make_unique<EstimateCheckoutResult>();
+                   result->changedFiles() = estimate.changedFiles;
+                   result->blobsToFetch() = estimate.blobsToFetch;
+                   result->treesFetched() = estimate.treesFetched;
+                   result->loadedInodesAffected() =
+                       estimate.loadedInodesAffected;
+                   result->materializedConflicts() =
+                       estimate.materializedConflicts;
+                   return result;
+                 }))
+      .semi();
+}
+
 folly::SemiFuture<folly::Unit>
 EdenServiceHandler::semifuture_resetParentCommits(
     std::unique_ptr<std::string> mountPoint,
@@ -952,15 +1002,66 @@ EdenServiceHandler::subscribeStreamTemporary(
   auto stream = std::make_shared<Publisher>(
       std::move(streamAndPublisher.second), std::move(disconnected));
 
+  // Notifications are at least this far apart, the ones arriving sooner being
+  // delayed. Since the journal doesn't notify subscribers again until the
+  // latest change is observed, delaying a notification coalesces the
+  // changes made in the meantime.
+  auto interval = server_->getServerState()
+                      ->getEdenConfig()
+                      ->journalNotificationInterval.getValue();
+  struct NotificationState {
+    std::chrono::steady_clock::time_point lastPublished;
+    bool isDelayed = false;
+  };
+  auto state = std::make_shared<folly::Synchronized<NotificationState>>();
+
+  auto publish = [weakMount, stream = std::move(stream), state] {
+    JournalPosition pos;
+    auto mount = weakMount.lock();
+    if (mount) {
+      // This is the current position, for the subscriber to query the changes
+      // up to it without calling getCurrentJournalPosition first. Reading it
+      // doesn't count as an observation: the journal notifies subscribers
+      // again once the subscriber queries the changes.
+      auto latest = mount->getJournal().getLatest(/*observe=*/false);
+      pos.mountGeneration_ref() = mount->getMountGeneration();
+      pos.sequenceNumber_ref() = latest ? latest->sequenceID : 0;
+      pos.snapshotHash_ref() = mount->getObjectStore()->renderRootId(
+          latest ? latest->toHash : RootId{});
+    }
+    state->wlock()->lastPublished = std::chrono::steady_clock::now();
+    stream->publisher.next(pos);
+  };
+
   // Register onJournalChange with the journal subsystem, and assign
   // the subscriber id into the handle so that the callbacks can consume it.
   handle->emplace(mountHandle.getEdenMount().getJournal().registerSubscriber(
-      [stream = std::move(stream)]() mutable {
-        JournalPosition pos;
-        // The value is intentionally undefined and should not be used. Instead,
-        // the subscriber should call getCurrentJournalPosition or
-        // getFilesChangedSince.
-        stream->publisher.next(pos);
+      [publish = std::move(publish),
+       state,
+       interval,
+       executor = server_->getServerState()->getThreadPool()]() mutable {
+        auto now = std::chrono::steady_clock::now();
+        std::chrono::steady_clock::duration delay;
+        {
+          auto lockedState = state->wlock();
+          if (lockedState->isDelayed) {
+            return;
+          }
+          delay = lockedState->lastPublished + interval - now;
+          lockedState->isDelayed = delay.count() > 0;
+        }
+        if (delay.count() <= 0) {
+          publish();
+          return;
+        }
+        folly::futures::detachOn(
+            executor.get(),
+            folly::futures::sleep(
+                std::chrono::duration_cast<folly::HighResDuration>(delay))
+                .deferValue([publish, state](auto&&) {
+                  state->wlock()->isDelayed = false;
+                  publish();
+                }));
       }));
 
   return std::move(streamAndPublisher.first);
@@ -1371,15 +1472,11 @@ apache::thrift::ServerStream<FsEvent> EdenServiceHandler::traceFsEvents(
 }
 
 /**
- * Helper function to get a cast a BackingStore shared_ptr to a
- * HgQueuedBackingStore shared_ptr. Returns an error if the type of backingStore
- * provided is not truly an HgQueuedBackingStore. Used in
- * EdenServiceHandler::traceHgEvents and
- * EdenServiceHandler::getRetroactiveHgEvents.
+ * Like castToHgQueuedBackingStore, but returns null if the type of
+ * backingStore is not truly an HgQueuedBackingStore.
  */
-std::shared_ptr<HgQueuedBackingStore> castToHgQueuedBackingStore(
-    std::shared_ptr<BackingStore>& backingStore,
-    AbsolutePathPiece mountPath) {
+std::shared_ptr<HgQueuedBackingStore> tryCastToHgQueuedBackingStore(
+    std::shared_ptr<BackingStore>& backingStore) {
   std::shared_ptr<HgQueuedBackingStore> hgBackingStore{nullptr};
 
   // TODO: remove these dynamic casts in favor of a QueryInterface method
@@ -1395,7 +1492,20 @@ std::shared_ptr<HgQueuedBackingStore> castToHgQueuedBackingStore(
     hgBackingStore = std::dynamic_pointer_cast<HgQueuedBackingStore>(
         localStoreCachedBackingStore->getBackingStore());
   }
+  return hgBackingStore;
+}
 
+/**
+ * Helper function to get a cast a BackingStore shared_ptr to a
+ * HgQueuedBackingStore shared_ptr. Returns an error if the type of backingStore
+ * provided is not truly an HgQueuedBackingStore. Used in
+ * EdenServiceHandler::traceHgEvents and
+ * EdenServiceHandler::getRetroactiveHgEvents.
+ */
+std::shared_ptr<HgQueuedBackingStore> castToHgQueuedBackingStore(
+    std::shared_ptr<BackingStore>& backingStore,
+    AbsolutePathPiece mountPath) {
+  auto hgBackingStore = tryCastToHgQueuedBackingStore(backingStore);
   if (!hgBackingStore) {
     // typeid() does not evaluate expressions
     auto& r = *backingStore.get();
@@ -1472,6 +1582,7 @@ void convertHgImportTraceEventToHgEvent(
   }
 
   te.unique_ref() = event.unique;
+  te.requestId_ref() = event.requestId;
 
   te.manifestNodeId_ref() = event.manifestNodeId.toString();
   te.path_ref() = event.getPath();
@@ -1607,26 +1718,31 @@ void publishFile(
   publisher.rlock()->next(std::move(fileResult));
 }
 
+/**
+ * A DiffCallback that publishes the files it is told about, ignoring the ones
+ * outside of root when it isn't empty.
+ */
 class StreamingDiffCallback : public DiffCallback {
  public:
-  explicit StreamingDiffCallback(
+  StreamingDiffCallback(
       std::shared_ptr<
           folly::Synchronized<ThriftStreamPublisherOwner<ChangedFileResult>>>
-          publisher)
-      : publisher_{std::move(publisher)} {}
+          publisher,
+      RelativePath root)
+      : publisher_{std::move(publisher)}, root_{std::move(root)} {}
 
   void ignoredPath(RelativePathPiece, dtype_t) override {}
 
   void addedPath(RelativePathPiece path, dtype_t type) override {
-    publishFile(*publisher_, path.view(), ScmFileStatus::ADDED, type);
+    publish(path, ScmFileStatus::ADDED, type);
   }
 
   void removedPath(RelativePathPiece path, dtype_t type) override {
-    publishFile(*publisher_, path.view(), ScmFileStatus::REMOVED, type);
+    publish(path, ScmFileStatus::REMOVED, type);
   }
 
   void modifiedPath(RelativePathPiece path, dtype_t type) override {
-    publishFile(*publisher_, path.view(), ScmFileStatus::MODIFIED, type);
+    publish(path, ScmFileStatus::MODIFIED, type);
   }
 
   void diffError(RelativePathPiece /*path*/, const folly::exception_wrapper& ew)
@@ -1636,9 +1752,100 @@ class StreamingDiffCallback : public DiffCallback {
   }
 
  private:
+  void publish(RelativePathPiece path, ScmFileStatus status, dtype_t type) {
+    if (root_.empty() || path.isSubDirOf(root_)) {
+      publishFile(*publisher_, path.view(), status, type);
+    }
+  }
+
   std::shared_ptr<
       folly::Synchronized<ThriftStreamPublisherOwner<ChangedFileResult>>>
       publisher_;
+  RelativePath root_;
+};
+
+/**
+ * A DiffCallback that publishes the status as the diff finds it, in chunks of
+ * at most chunkSize entries and errors.
+ */
+class ChunkedScmStatusDiffCallback : public DiffCallback {
+ public:
+  ChunkedScmStatusDiffCallback(
+      ThriftStreamPublisherOwner<ScmStatus> publisher,
+      size_t chunkSize)
+      : publisher_{std::move(publisher)},
+        chunkSize_{std::max(chunkSize, size_t{1})} {}
+
+  void ignoredPath(RelativePathPiece path, dtype_t type) override {
+    addEntry(path, ScmFileStatus::IGNORED, type);
+  }
+
+  void addedPath(RelativePathPiece path, dtype_t type) override {
+    addEntry(path, ScmFileStatus::ADDED, type);
+  }
+
+  void removedPath(RelativePathPiece path, dtype_t type) override {
+    addEntry(path, ScmFileStatus::REMOVED, type);
+  }
+
+  void modifiedPath(RelativePathPiece path, dtype_t type) override {
+    addEntry(path, ScmFileStatus::MODIFIED, type);
+  }
+
+  void diffError(RelativePathPiece path, const folly::exception_wrapper& ew)
+      override {
+    XLOG(WARNING) << "error computing status data for " << path << ": "
+                  << folly::exceptionStr(ew);
+    auto chunk = chunk_.wlock();
+    chunk->errors_ref()->emplace(
+        path.asString(), folly::exceptionStr(ew).toStdString());
+    publishIfFull(chunk);
+  }
+
+  /**
+   * Publish the entries and errors that are not part of a full chunk yet.
+   */
+  void flush() {
+    ScmStatus chunk;
+    std::swap(chunk, *chunk_.wlock());
+    if (!chunk.entries_ref()->empty() || !chunk.errors_ref()->empty()) {
+      publisher_.rlock()->next(std::move(chunk));
+    }
+  }
+
+  /**
+   * End the stream with the given error.
+   */
+  void fail(folly::exception_wrapper ew) {
+    auto publisher = std::move(*publisher_.wlock());
+    std::move(publisher).next(std::move(ew));
+  }
+
+ private:
+  void addEntry(RelativePathPiece path, ScmFileStatus status, dtype_t type) {
+    // Like ScmStatusDiffCallback, only report files.
+    if (type == dtype_t::Dir) {
+      return;
+    }
+    auto chunk = chunk_.wlock();
+    chunk->entries_ref()->emplace(path.asString(), status);
+    publishIfFull(chunk);
+  }
+
+  void publishIfFull(folly::Synchronized<ScmStatus>::LockedPtr& chunk) {
+    if (chunk->entries_ref()->size() + chunk->errors_ref()->size() <
+        chunkSize_) {
+      return;
+    }
+    ScmStatus full;
+    std::swap(full, *chunk);
+    chunk.unlock();
+    publisher_.rlock()->next(std::move(full));
+  }
+
+  folly::Synchronized<ThriftStreamPublisherOwner<ScmStatus>> publisher_;
+  const size_t chunkSize_;
+  folly::Synchronized<ScmStatus> chunk_;
 };
 
 /**
@@ -1654,7 +1861,8 @@ ImmediateFuture<folly::Unit> diffBetweenRoots(
     const CheckoutConfig& checkoutConfig,
     const std::shared_ptr<ObjectStore>& objectStore,
     folly::CancellationToken cancellation,
-    DiffCallback* callback) {
+    DiffCallback* callback,
+    std::shared_ptr<TreeDiffCache> treeDiffCache) {
   auto diffContext = std::make_unique<DiffContext>(
       callback,
       cancellation,
@@ -1663,6 +1871,7 @@ ImmediateFuture<folly::Unit> diffBetweenRoots(
       checkoutConfig.getEnableWindowsSymlinks(),
       objectStore,
       nullptr);
+  diffContext->setTreeDiffCache(std::move(treeDiffCache));
   auto fut = diffRoots(diffContext.get(), fromRoot, toRoot);
   return std::move(fut).ensure([diffContext = std::move(diffContext)] {});
 }
@@ -1695,8 +1904,9 @@ EdenServiceHandler::streamChangesSince(
   // The +1 is because the core merge stops at the item prior to
   // its limitSequence parameter and we want the changes *since*
   // the provided sequence number.
+  auto root = RelativePath{*params->root()};
   auto summed = mountHandle.getJournal().accumulateRange(
-      *fromPosition.sequenceNumber_ref() + 1);
+      *fromPosition.sequenceNumber_ref() + 1, root);
 
   ChangesSinceResult result;
   if (!summed) {
@@ -1758,7 +1968,8 @@ EdenServiceHandler::streamChangesSince(
   }
 
   if (summed->snapshotTransitions.size() > 1) {
-    auto callback = std::make_shared<StreamingDiffCallback>(sharedPublisher);
+    auto callback =
+        std::make_shared<StreamingDiffCallback>(sharedPublisher, root);
 
     std::vector<ImmediateFuture<folly::Unit>> futures;
     for (auto rootIt = summed->snapshotTransitions.begin();
@@ -1782,7 +1993,10 @@ EdenServiceHandler::streamChangesSince(
                 *mountHandle.getEdenMount().getCheckoutConfig(),
                 mountHandle.getObjectStorePtr(),
                 token,
-                callback);
+                callback,
+                mountHandle.getEdenMount()
+                    .getServerState()
+                    ->getTreeDiffCache());
           }));
     }
 
@@ -1811,6 +2025,69 @@ EdenServiceHandler::streamChangesSince(
   return {std::move(result), std::move(serverStream)};
 }
 
+apache::thrift::ResponseAndServerStream<StreamScmStatusResult, ScmStatus>
+EdenServiceHandler::streamScmStatus(
+    std::unique_ptr<GetScmStatusParams> params) {
+  auto helper = INSTRUMENT_THRIFT_CALL_WITH_STAT(
+      DBG3,
+      &ThriftStats::streamScmStatus,
+      *params->mountPoint_ref(),
+      folly::to<string>("commitHash=", logHash(*params->commit_ref())),
+      folly::to<string>("listIgnored=", *params->listIgnored_ref()));
+  auto mountHandle = lookupMount(params->mountPoint());
+  auto rootId = mountHandle.getObjectStore().parseRootId(*params->commit_ref());
+  auto config = server_->getServerState()->getEdenConfig();
+  auto enforceParents = config->enforceParents.getValue();
+
+  // As with streamChangesSince, the stream is published to as fast as the
+  // diff finds changes, so chunks queue up in memory if the client reads them
+  // more slowly than that. Closing the stream stops the diff.
+  auto cancellationSource = std::make_shared<folly::CancellationSource>();
+  auto [serverStream, publisher] =
+      apache::thrift::ServerStream<ScmStatus>::createPublisher(
+          [cancellationSource] { cancellationSource->requestCancellation(); });
+  auto callback = std::make_shared<ChunkedScmStatusDiffCallback>(
+      ThriftStreamPublisherOwner{std::move(publisher)},
+      config->statusStreamChunkSize.getValue());
+
+  // Start from a not ready ImmediateFuture so that the diff runs on a
+  // background thread rather than before this call returns.
+  auto diffFuture = makeNotReadyImmediateFuture().thenValue(
+      [mountHandle,
+       rootId = std::move(rootId),
+       listIgnored = *params->listIgnored_ref(),
+       enforceParents,
+       token = cancellationSource->getToken(),
+       callback = callback.get()](auto&&) {
+        return mountHandle.getEdenMount().diff(
+            mountHandle.getRootInode(),
+            callback,
+            rootId,
+            listIgnored,
+            enforceParents,
+            token);
+      });
+  folly::futures::detachOn(
+      server_->getServerState()->getThreadPool().get(),
+      std::move(diffFuture)
+          // Keep the mount, callback, helper and cancellationSource alive for
+          // the duration of the stream.
+          .thenTry([mountHandle,
+                    callback = std::move(callback),
+                    helper = std::move(helper),
+                    cancellationSource](folly::Try<folly::Unit>&& result) {
+            callback->flush();
+            if (result.hasException()) {
+              callback->fail(newEdenError(std::move(result).exception()));
+            }
+          })
+          .semi());
+
+  StreamScmStatusResult result;
+  result.version_ref() = server_->getVersion();
+  return {std::move(result), std::move(serverStream)};
+}
+
 void EdenServiceHandler::getFilesChangedSince(
     FileDelta& out,
     std::unique_ptr<std::string> mountPoint,
@@ -2100,24 +2377,34 @@ getAllEntryAttributes(
       });
 }
 
-template <typename SerializedT, typename T>
-bool fillErrorRef(
-    SerializedT& result,
-    std::optional<folly::Try<T>> rawResult,
+template <typename T>
+std::optional<EdenError> attributeError(
+    const std::optional<folly::Try<T>>& rawResult,
     folly::StringPiece path,
     folly::StringPiece attributeName) {
   if (!rawResult.has_value()) {
-    result.error_ref() = newEdenError(
+    return newEdenError(
         EdenErrorType::GENERIC_ERROR,
         fmt::format(
             "{}: {} requested, but no {} available",
             path,
             attributeName,
             attributeName));
-    return true;
   }
   if (rawResult.value().hasException()) {
-    result.error_ref() = newEdenError(rawResult.value().exception());
+    return newEdenError(rawResult.value().exception());
+  }
+  return std::nullopt;
+}
+
+template <typename SerializedT, typename T>
+bool fillErrorRef(
+    SerializedT& result,
+    std::optional<folly::Try<T>> rawResult,
+    folly::StringPiece path,
+    folly::StringPiece attributeName) {
+  if (auto error = attributeError(rawResult, path, attributeName)) {
+    result.error_ref() = std::move(*error);
     return true;
   }
   return false;
@@ -2184,6 +2471,116 @@ FileAttributeDataOrErrorV2 serializeEntryAttributes(
   return fileResult;
 }
 
+/**
+ * The error that keeps an entry out of the columns of
+ * getAttributesFromFilesColumnar(): the first of its requested attributes
+ * that is not available, if any.
+ */
+std::optional<EdenError> columnarEntryError(
+    folly::StringPiece entryPath,
+    const folly::Try<EntryAttributes>& attributes,
+    EntryAttributeFlags requestedAttributes) {
+  if (attributes.hasException()) {
+    return newEdenError(attributes.exception());
+  }
+  std::optional<EdenError> error;
+  if (requestedAttributes.contains(ENTRY_ATTRIBUTE_SHA1)) {
+    error = attributeError(attributes->sha1, entryPath, "sha1");
+  }
+  if (!error && requestedAttributes.contains(ENTRY_ATTRIBUTE_BLAKE3)) {
+    error = attributeError(attributes->blake3, entryPath, "blake3");
+  }
+  if (!error && requestedAttributes.contains(ENTRY_ATTRIBUTE_SIZE)) {
+    error = attributeError(attributes->size, entryPath, "size");
+  }
+  if (!error &&
+      requestedAttributes.contains(ENTRY_ATTRIBUTE_SOURCE_CONTROL_TYPE)) {
+    error = attributeError(attributes->type, entryPath, "type");
+  }
+  if (!error && requestedAttributes.contains(ENTRY_ATTRIBUTE_OBJECT_ID)) {
+    error = attributeError(attributes->objectId, entryPath, "objectid");
+  }
+  return error;
+}
+
+GetAttributesFromFilesColumnarResult serializeColumnarAttributes(
+    ObjectStore& objectStore,
+    const std::vector<std::string>& paths,
+    const std::vector<folly::Try<EntryAttributes>>& allAttributes,
+    EntryAttributeFlags requestedAttributes) {
+  auto count = allAttributes.size();
+  bool wantSha1 = requestedAttributes.contains(ENTRY_ATTRIBUTE_SHA1);
+  bool wantBlake3 = requestedAttributes.contains(ENTRY_ATTRIBUTE_BLAKE3);
+  bool wantSize = requestedAttributes.contains(ENTRY_ATTRIBUTE_SIZE);
+  bool wantType =
+      requestedAttributes.contains(ENTRY_ATTRIBUTE_SOURCE_CONTROL_TYPE);
+  bool wantObjectId = requestedAttributes.contains(ENTRY_ATTRIBUTE_OBJECT_ID);
+
+  GetAttributesFromFilesColumnarResult result;
+  auto& errorBitmap = *result.errorBitmap();
+  auto& sha1s = *result.sha1s();
+  auto& blake3s = *result.blake3s();
+  errorBitmap.resize((count + 7) / 8);
+  if (wantSha1) {
+    sha1s.reserve(count * Hash20::RAW_SIZE);
+  }
+  if (wantBlake3) {
+    blake3s.reserve(count * Hash32::RAW_SIZE);
+  }
+  if (wantSize) {
+    result.sizes()->reserve(count);
+  }
+  if (wantType) {
+    result.sourceControlTypes()->reserve(count);
+  }
+  if (wantObjectId) {
+    result.objectIds()->reserve(count);
+  }
+
+  for (size_t index = 0; index < count; ++index) {
+    const auto& attributes = allAttributes[index];
+    auto error = columnarEntryError(
+        basename(paths[index]), attributes, requestedAttributes);
+    if (error) {
+      errorBitmap[index / 8] |= static_cast<char>(1 << (index % 8));
+      result.errors()->push_back(std::move(*error));
+    }
+
+    if (wantSha1) {
+      if (error) {
+        sha1s.append(Hash20::RAW_SIZE, '\0');
+      } else {
+        auto bytes = attributes->sha1->value().getBytes();
+        sha1s.append(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+      }
+    }
+    if (wantBlake3) {
+      if (error) {
+        blake3s.append(Hash32::RAW_SIZE, '\0');
+      } else {
+        auto bytes = attributes->blake3->value().getBytes();
+        blake3s.append(
+            reinterpret_cast<const char*>(bytes.data()), bytes.size());
+      }
+    }
+    if (wantSize) {
+      result.sizes()->push_back(error ? 0 : attributes->size->value());
+    }
+    if (wantType) {
+      result.sourceControlTypes()->push_back(
+          error ? SourceControlType{}
+                : entryTypeToThriftType(attributes->type->value()));
+    }
+    if (wantObjectId) {
+      const std::optional<ObjectId>* oid =
+          error ? nullptr : &attributes->objectId->value();
+      result.objectIds()->push_back(
+          oid && *oid ? objectStore.renderObjectId(**oid) : std::string{});
+    }
+  }
+  return result;
+}
+
 DirListAttributeDataOrError serializeEntryAttributes(
     ObjectStore& objectStore,
     const folly::Try<
@@ -2282,53 +2679,100 @@ EdenServiceHandler::getEntryAttributes(
     SyncBehavior sync,
     const ObjectFetchContextPtr& fetchContext) {
   return waitForPendingWrites(edenMount, sync)
-      .thenValue([this,
-                  &edenMount,
+      .thenValue([&edenMount,
                   &paths,
                   fetchContext = fetchContext.copy(),
                   reqBitmask](auto&&) mutable {
-        vector<ImmediateFuture<EntryAttributes>> futures;
-        for (const auto& path : paths) {
-          futures.emplace_back(getEntryAttributesForPath(
-              edenMount, reqBitmask, path, fetchContext));
+        std::vector<folly::Try<EntryAttributes>> results(paths.size());
+
+        // IDEs and build systems ask for the attributes of thousands of files
+        // at a time, most of them in the same directories. Group the paths by
+        // parent directory so that each directory is only looked up once.
+        folly::F14FastMap<RelativePathPiece, std::vector<size_t>>
+            childrenByParent;
+        for (size_t index = 0; index < paths.size(); ++index) {
+          const auto& path = paths[index];
+          if (path.empty()) {
+            results[index] = folly::Try<EntryAttributes>{
+                folly::make_exception_wrapper<EdenError>(newEdenError(
+                    EINVAL,
+                    EdenErrorType::ARGUMENT_ERROR,
+                    "path cannot be the empty string"))};
+            continue;
+          }
+          try {
+            childrenByParent[RelativePathPiece{path}.dirname()].push_back(
+                index);
+          } catch (const std::exception& e) {
+            results[index] =
+                folly::Try<EntryAttributes>{folly::make_exception_wrapper<
+                    EdenError>(newEdenError(
+                    EINVAL, EdenErrorType::ARGUMENT_ERROR, e.what()))};
+          }
         }
 
-        // Collect all futures into a single tuple
-        return facebook::eden::collectAll(std::move(futures));
-      });
-}
-
-ImmediateFuture<EntryAttributes> EdenServiceHandler::getEntryAttributesForPath(
-    const EdenMount& edenMount,
-    EntryAttributeFlags reqBitmask,
-    std::string_view path,
-    const ObjectFetchContextPtr& fetchContext) {
-  if (path.empty()) {
-    return ImmediateFuture<EntryAttributes>(newEdenError(
-        EINVAL,
-        EdenErrorType::ARGUMENT_ERROR,
-        "path cannot be the empty string"));
-  }
+        std::vector<std::vector<size_t>> groupIndices;
+        std::vector<
+            ImmediateFuture<std::vector<folly::Try<EntryAttributes>>>>
+            groupFutures;
+        groupIndices.reserve(childrenByParent.size());
+        groupFutures.reserve(childrenByParent.size());
+        for (auto& [parent, indices] : childrenByParent) {
+          groupFutures.emplace_back(
+              edenMount.getVirtualInode(parent, fetchContext)
+                  .thenTry([&edenMount,
+                            &paths,
+                            indices,
+                            fetchContext = fetchContext.copy(),
+                            reqBitmask](folly::Try<VirtualInode> parentInode) {
+                    const auto& objectStore = edenMount.getObjectStore();
+                    std::vector<ImmediateFuture<EntryAttributes>> futures;
+                    futures.reserve(indices.size());
+                    for (auto index : indices) {
+                      if (parentInode.hasException()) {
+                        futures.emplace_back(parentInode.exception());
+                        continue;
+                      }
+                      RelativePathPiece path{paths[index]};
+                      futures.emplace_back(
+                          parentInode
+                              ->getOrFindChild(
+                                  path.basename(),
+                                  path,
+                                  objectStore,
+                                  fetchContext)
+                              .thenValue([reqBitmask,
+                                          path,
+                                          objectStore,
+                                          fetchContext = fetchContext.copy()](
+                                             VirtualInode child) {
+                                return child.getEntryAttributes(
+                                    reqBitmask,
+                                    path,
+                                    objectStore,
+                                    fetchContext);
+                              }));
+                    }
+                    return collectAll(std::move(futures));
+                  }));
+          groupIndices.push_back(std::move(indices));
+        }
 
-  try {
-    RelativePathPiece relativePath{path};
-
-    return edenMount.getVirtualInode(relativePath, fetchContext)
-        .thenValue([&edenMount,
-                    reqBitmask,
-                    relativePath = relativePath.copy(),
-                    fetchContext =
-                        fetchContext.copy()](const VirtualInode& virtualInode) {
-          return virtualInode.getEntryAttributes(
-              reqBitmask,
-              relativePath,
-              edenMount.getObjectStore(),
-              fetchContext);
-        });
-  } catch (const std::exception& e) {
-    return ImmediateFuture<EntryAttributes>(
-        newEdenError(EINVAL, EdenErrorType::ARGUMENT_ERROR, e.what()));
-  }
+        return collectAllSafe(std::move(groupFutures))
+            .thenValue(
+                [results = std::move(results),
+                 groupIndices = std::move(groupIndices)](
+                    std::vector<std::vector<folly::Try<EntryAttributes>>>
+                        groups) mutable {
+                  for (size_t group = 0; group < groups.size(); ++group) {
+                    auto& indices = groupIndices[group];
+                    for (size_t i = 0; i < indices.size(); ++i) {
+                      results[indices[i]] = std::move(groups[group][i]);
+                    }
+                  }
+                  return std::move(results);
+                });
+      });
 }
 
 // TODO(kmancini): we shouldn't need this for the long term, but needs to be
@@ -2493,6 +2937,44 @@ EdenServiceHandler::semifuture_getAttributesFromFilesV2(
       .semi();
 }
 
+folly::SemiFuture<std::unique_ptr<GetAttributesFromFilesColumnarResult>>
+EdenServiceHandler::semifuture_getAttributesFromFilesColumnar(
+    std::unique_ptr<GetAttributesFromFilesParams> params) {
+  auto mountHandle = lookupMount(params->mountPoint());
+  auto reqBitmask = EntryAttributeFlags::raw(*params->requestedAttributes());
+  std::vector<std::string>& paths = params->paths().value();
+  auto helper = INSTRUMENT_THRIFT_CALL(
+      DBG3,
+      *params->mountPoint(),
+      getSyncTimeout(*params->sync()),
+      toLogArg(paths));
+  auto& fetchContext = helper->getFetchContext();
+
+  auto entryAttributesFuture = getEntryAttributes(
+      mountHandle.getEdenMount(),
+      paths,
+      reqBitmask,
+      *params->sync(),
+      fetchContext);
+
+  return wrapImmediateFuture(
+             std::move(helper),
+             std::move(entryAttributesFuture)
+                 .thenValue(
+                     [reqBitmask, mountHandle, &paths](
+                         std::vector<folly::Try<EntryAttributes>>&& allRes) {
+                       return std::make_unique<
+                           GetAttributesFromFilesColumnarResult>(
+                           serializeColumnarAttributes(
+                               mountHandle.getObjectStore(),
+                               paths,
+                               allRes,
+                               reqBitmask));
+                     }))
+      .ensure([mountHandle, params = std::move(params)]() {})
+      .semi();
+}
+
 folly::SemiFuture<std::unique_ptr<SetPathObjectIdResult>>
 EdenServiceHandler::semifuture_setPathObjectId(
     std::unique_ptr<SetPathObjectIdParams> params) {
@@ -2829,11 +3311,6 @@ EdenServiceHandler::semifuture_globFiles(std::unique_ptr<GlobParams> params) {
   auto& context = helper->getFetchContext();
   auto isBackground = *params->background();
 
-  ImmediateFuture<folly::Unit> backgroundFuture{std::in_place};
-  if (isBackground) {
-    backgroundFuture = makeNotReadyImmediateFuture();
-  }
-
   maybeLogExpensiveGlob(
       *params->globs(),
       *params->searchRoot_ref(),
@@ -2843,18 +3320,45 @@ EdenServiceHandler::semifuture_globFiles(std::unique_ptr<GlobParams> params) {
 
   auto mountHandle = lookupMount(params->mountPoint());
 
-  auto globFut = std::move(backgroundFuture)
-                     .thenValue([mountHandle,
-                                 serverState = server_->getServerState(),
-                                 globs = std::move(*params->globs()),
-                                 globber = std::move(globber),
-                                 &context](auto&&) mutable {
-                       return globber.glob(
-                           mountHandle.getEdenMountPtr(),
-                           serverState,
-                           std::move(globs),
-                           context);
-                     });
+  // Build tools often issue the same glob from several processes at once.
+  // Foreground requests against an unchanged working copy share one glob.
+  std::optional<std::string> dedupKey;
+  if (!isBackground) {
+    auto latest = mountHandle.getJournal().getLatest();
+    dedupKey = fmt::format(
+        "{}:{}",
+        latest ? latest->sequenceID : 0,
+        apache::thrift::CompactSerializer::serialize<std::string>(*params));
+  }
+
+  auto runGlob = [mountHandle,
+                  serverState = server_->getServerState(),
+                  globs = std::move(*params->globs()),
+                  globber = std::move(globber),
+                  &context]() mutable {
+    return globber.glob(
+        mountHandle.getEdenMountPtr(),
+        serverState,
+        std::move(globs),
+        context);
+  };
+
+  auto globFut = dedupKey
+      ? inFlightGlobs_
+            .getOrCompute(
+                *dedupKey,
+                [runGlob = std::move(runGlob)]() mutable {
+                  return runGlob().thenValue([](std::unique_ptr<Glob> glob) {
+                    return std::move(*glob);
+                  });
+                })
+            .thenValue([](std::shared_ptr<const Glob> glob) {
+              return std::make_unique<Glob>(*glob);
+            })
+      : makeNotReadyImmediateFuture().thenValue(
+            [runGlob = std::move(runGlob)](auto&&) mutable {
+              return runGlob();
+            });
   globFut = std::move(globFut).ensure(
       [mountHandle, helper = std::move(helper), params = std::move(params)] {});
 
@@ -2874,6 +3378,113 @@ EdenServiceHandler::semifuture_globFiles(std::unique_ptr<GlobParams> params) {
   return std::move(globFut).semi().via(serial);
 }
 
+folly::SemiFuture<std::unique_ptr<Glob>>
+EdenServiceHandler::semifuture_globFilesInRepo(
+    std::unique_ptr<GlobRepoParams> params) {
+  TaskTraceBlock block{"EdenServiceHandler::globFilesInRepo"};
+  ThriftGlobImpl globber{*params};
+  auto helper = INSTRUMENT_THRIFT_CALL(
+      DBG3,
+      *params->repoPath(),
+      toLogArg(*params->globs()),
+      globber.logString());
+  auto& context = helper->getFetchContext();
+
+  std::shared_ptr<ObjectStore> objectStore;
+  try {
+    objectStore = server_->getRepoObjectStore(
+        *params->repoType(), *params->repoPath());
+  } catch (const std::exception& ex) {
+    throw newEdenError(
+        EINVAL,
+        EdenErrorType::ARGUMENT_ERROR,
+        "unable to open repository ",
+        *params->repoPath(),
+        ": ",
+        ex.what());
+  }
+
+  return globber
+      .globTrees(
+          std::move(objectStore),
+          server_->getServerState(),
+          std::move(*params->globs()),
+          context)
+      .ensure([helper = std::move(helper), params = std::move(params)] {})
+      .semi();
+}
+
+apache::thrift::ServerStream<Glob> EdenServiceHandler::streamGlobFiles(
+    std::unique_ptr<GlobParams> params) {
+  ThriftGlobImpl globber{*params};
+  auto helper = INSTRUMENT_THRIFT_CALL_WITH_STAT(
+      DBG3,
+      &ThriftStats::streamGlobFiles,
+      *params->mountPoint_ref(),
+      toLogArg(*params->globs_ref()),
+      globber.logString());
+  auto& context = helper->getFetchContext();
+  auto serverState = server_->getServerState();
+
+  maybeLogExpensiveGlob(
+      *params->globs(),
+      *params->searchRoot_ref(),
+      globber,
+      context,
+      serverState);
+
+  auto mountHandle = lookupMount(params->mountPoint());
+
+  // Globs cannot be interrupted, so closing the stream only drops the chunks
+  // that are found after it is closed.
+  auto [serverStream, publisher] =
+      apache::thrift::ServerStream<Glob>::createPublisher([] {});
+  auto sharedPublisher =
+      std::make_shared<folly::Synchronized<ThriftStreamPublisherOwner<Glob>>>(
+          ThriftStreamPublisherOwner{std::move(publisher)});
+
+  // Start from a not ready ImmediateFuture so that the glob is evaluated on a
+  // background thread rather than before this call returns.
+  auto globFuture = makeNotReadyImmediateFuture().thenValue(
+      [mountHandle,
+       serverState,
+       globs = std::move(*params->globs()),
+       globber = std::move(globber),
+       &context,
+       sharedPublisher](auto&&) mutable {
+        auto chunkSize =
+            serverState->getEdenConfig()->globStreamChunkSize.getValue();
+        return globber.streamGlob(
+            mountHandle.getEdenMountPtr(),
+            serverState,
+            std::move(globs),
+            context,
+            chunkSize,
+            [sharedPublisher](Glob&& chunk) {
+              sharedPublisher->rlock()->next(std::move(chunk));
+            });
+      });
+  folly::futures::detachOn(
+      serverState->getThreadPool().get(),
+      std::move(globFuture)
+          // Keep the mount, helper and params alive for the duration of the
+          // stream.
+          .thenTry([mountHandle,
+                    sharedPublisher,
+                    helper = std::move(helper),
+                    params = std::move(params)](
+                       folly::Try<folly::Unit>&& result) {
+            auto publisher = std::move(*sharedPublisher->wlock());
+            if (result.hasException()) {
+              std::move(publisher).next(
+                  newEdenError(std::move(result).exception()));
+            }
+          })
+          .semi());
+
+  return std::move(serverStream);
+}
+
 folly::SemiFuture<folly::Unit> EdenServiceHandler::semifuture_prefetchFiles(
     std::unique_ptr<PrefetchParams> params) {
   ThriftGlobImpl globber{*params};
@@ -2922,6 +3533,63 @@ folly::SemiFuture<folly::Unit> EdenServiceHandler::semifuture_prefetchFiles(
       .semi();
 }
 
+folly::SemiFuture<folly::Unit>
+EdenServiceHandler::semifuture_prefetchRootTrees(
+    std::unique_ptr<PrefetchRootTreesParams> params) {
+  auto helper = INSTRUMENT_THRIFT_CALL(
+      DBG2, *params->mountPoint(), toLogArg(*params->revisions()));
+  auto& revisions = *params->revisions();
+  auto& manifests = *params->hgRootManifests();
+  if (!manifests.empty() && manifests.size() != revisions.size()) {
+    throw newEdenError(
+        EINVAL,
+        EdenErrorType::ARGUMENT_ERROR,
+        "hgRootManifests must be empty or as long as revisions");
+  }
+  auto isBackground = *params->background();
+
+  ImmediateFuture<folly::Unit> backgroundFuture{std::in_place};
+  if (isBackground) {
+    backgroundFuture = makeNotReadyImmediateFuture();
+  }
+
+  auto mountHandle = lookupMount(params->mountPoint());
+  auto fut =
+      std::move(backgroundFuture)
+          .thenValue([mountHandle,
+                      revisions = std::move(revisions),
+                      manifests = std::move(manifests),
+                      context = helper->getPrefetchFetchContext().copy()](
+                         auto&&) {
+            auto& objectStore = mountHandle.getObjectStore();
+            std::vector<ImmediateFuture<folly::Unit>> futures;
+            futures.reserve(revisions.size());
+            for (size_t i = 0; i < revisions.size(); ++i) {
+              auto rootId = objectStore.parseRootId(revisions[i]);
+              ImmediateFuture<folly::Unit> imported{std::in_place};
+              if (!manifests.empty()) {
+                // As in resetParentCommits(), a known manifest saves asking
+                // the import helper.
+                imported = objectStore.getBackingStore()->importManifestForRoot(
+                    rootId, hash20FromThrift(manifests[i]));
+              }
+              futures.push_back(
+                  std::move(imported)
+                      .thenValue([&objectStore, rootId, context](auto&&) {
+                        return objectStore.getRootTree(rootId, context);
+                      })
+                      .unit());
+            }
+            return collectAllSafe(std::move(futures)).unit();
+          })
+          .ensure([mountHandle] {});
+  fut = std::move(fut).ensure(
+      [helper = std::move(helper), params = std::move(params)] {});
+  return detachIfBackgrounded(
+             std::move(fut), server_->getServerState(), isBackground)
+      .semi();
+}
+
 folly::SemiFuture<struct folly::Unit> EdenServiceHandler::semifuture_chown(
     FOLLY_MAYBE_UNUSED std::unique_ptr<std::string> mountPoint,
     FOLLY_MAYBE_UNUSED int32_t uid,
@@ -3037,7 +3705,8 @@ EdenServiceHandler::semifuture_getScmStatusBetweenRevisions(
       *mountHandle.getEdenMount().getCheckoutConfig(),
       mountHandle.getObjectStorePtr(),
       context->getConnectionContext()->getCancellationToken(),
-      callback.get());
+      callback.get(),
+      server_->getServerState()->getTreeDiffCache());
   return wrapImmediateFuture(
              std::move(helper),
              std::move(diffFuture)
@@ -3510,6 +4179,31 @@ void EdenServiceHandler::debugOutstandingFuseCalls(
 #endif // !_WIN32
 }
 
+void EdenServiceHandler::debugSlowestFuseCalls(
+    FOLLY_MAYBE_UNUSED std::vector<SlowFuseCall>& slowestCalls,
+    FOLLY_MAYBE_UNUSED std::unique_ptr<std::string> mountPoint) {
+#ifndef _WIN32
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG2);
+
+  auto mountHandle = lookupMount(mountPoint);
+
+  if (auto* fuseChannel = mountHandle.getEdenMount().getFuseChannel()) {
+    for (const auto& call : fuseChannel->getSlowestRequests()) {
+      SlowFuseCall slowCall;
+      slowCall.call_ref() = populateFuseCall(
+          call.unique,
+          call.request,
+          *server_->getServerState()->getProcessNameCache());
+      slowCall.durationNs_ref() = call.duration.count();
+      slowCall.result_ref().from_optional(call.result);
+      slowestCalls.push_back(std::move(slowCall));
+    }
+  }
+#else
+  NOT_IMPLEMENTED();
+#endif // !_WIN32
+}
+
 void EdenServiceHandler::debugOutstandingNfsCalls(
     std::vector<NfsCall>& outstandingCalls,
     std::unique_ptr<std::string> mountPoint) {
@@ -3555,6 +4249,36 @@ void EdenServiceHandler::debugOutstandingThriftRequests(
   }
 }
 
+void EdenServiceHandler::debugGetExpensiveGlobs(
+    std::vector<ExpensiveGlob>& result) {
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG3);
+  const auto& serverState = server_->getServerState();
+  const auto& costLog = serverState->getGlobCostLog();
+  if (!costLog) {
+    return;
+  }
+
+  auto processNames = serverState->getProcessNameCache()->getAllProcessNames();
+  for (auto& cost : costLog->getMostExpensive()) {
+    auto& glob = result.emplace_back();
+    glob.request() = std::move(cost.request);
+    if (cost.clientPid) {
+      auto pid = cost.clientPid.value().get();
+      glob.clientPid() = pid;
+      auto it = processNames.find(pid);
+      if (it != processNames.end()) {
+        glob.clientCmdline() = it->second;
+      }
+    }
+    glob.directoriesVisited() = cost.directoriesVisited;
+    glob.treesFromCache() = cost.treesFromCache;
+    glob.treesFromBackingStore() = cost.treesFromBackingStore;
+    glob.entriesMatched() = cost.entriesMatched;
+    glob.matchingTimeUs() = cost.matchingTime.count();
+    glob.durationUs() = cost.duration.count();
+  }
+}
+
 void EdenServiceHandler::debugStartRecordingActivity(
     ActivityRecorderResult& result,
     std::unique_ptr<std::string> mountPoint,
@@ -3942,6 +4666,10 @@ void EdenServiceHandler::getStatInfo(
     result.blobCacheStats_ref()->evictionCount_ref() =
         blobCacheStats.evictionCount;
     result.blobCacheStats_ref()->dropCount_ref() = blobCacheStats.dropCount;
+    result.blobCacheStats_ref()->admissionRejectCount_ref() =
+        blobCacheStats.admissionRejectCount;
+    result.blobCacheStats_ref()->evictionPolicy_ref() =
+        toString(blobCacheStats.policy).str();
 
     const auto treeCacheStats = server_->getTreeCache()->getStats();
     result.treeCacheStats_ref() = CacheStats{};
@@ -3952,6 +4680,35 @@ void EdenServiceHandler::getStatInfo(
     result.treeCacheStats_ref()->missCount_ref() = treeCacheStats.missCount;
     result.treeCacheStats_ref()->evictionCount_ref() =
         treeCacheStats.evictionCount;
+    result.treeCacheStats_ref()->admissionRejectCount_ref() =
+        treeCacheStats.admissionRejectCount;
+    result.treeCacheStats_ref()->evictionPolicy_ref() =
+        toString(treeCacheStats.policy).str();
+  }
+
+  if (statsMask & eden_constants::STATS_MEMORY_USAGE_) {
+    size_t inodes = 0;
+    size_t journal = 0;
+    for (auto& handle : server_->getMountPoints()) {
+      auto& mount = handle.getEdenMount();
+      inodes += mount.getInodeMap()->estimateMemoryUsage();
+      journal += mount.getJournal().estimateMemoryUsage();
+    }
+    size_t hgImportQueue = 0;
+    for (auto backingStore : server_->getBackingStores()) {
+      if (auto hgBackingStore = tryCastToHgQueuedBackingStore(backingStore)) {
+        hgImportQueue += hgBackingStore->estimateImportQueueMemoryUsage();
+      }
+    }
+
+    auto& memoryUsage = result.memoryUsage_ref().ensure();
+    memoryUsage["inodes"] = inodes;
+    memoryUsage["journal"] = journal;
+    memoryUsage["blob_cache"] =
+        server_->getBlobCache()->getStats().totalSizeInBytes;
+    memoryUsage["tree_cache"] =
+        server_->getTreeCache()->getStats().totalSizeInBytes;
+    memoryUsage["hg_import_queue"] = hgImportQueue;
   }
 }
 
@@ -4089,6 +4846,177 @@ void EdenServiceHandler::getTracePoints(std::vector<TracePoint>& result) {
   }
 }
 
+void EdenServiceHandler::startChromeTrace(
+    std::unique_ptr<StartChromeTraceParams> params) {
+  auto helper = INSTRUMENT_THRIFT_CALL(
+      DBG1, *params->mountPoint(), *params->outputPath());
+  auto mountHandle = lookupMount(params->mountPoint());
+  auto& edenMount = mountHandle.getEdenMount();
+
+  constexpr size_t kDefaultMaxFileSize = 100 * 1024 * 1024;
+  auto maxFileSize = *params->maxFileSize() > 0
+      ? static_cast<size_t>(*params->maxFileSize())
+      : kDefaultMaxFileSize;
+  auto writer = std::make_shared<ChromeTraceWriter>(
+      absolutePathFromThrift(*params->outputPath()), maxFileSize);
+  auto trace = std::make_unique<ChromeTrace>();
+  auto name = fmt::format("chrome-trace-{}", edenMount.getPath().basename());
+
+#ifdef _WIN32
+  if (auto prjfsChannel = edenMount.getPrjfsChannel()->getInner()) {
+    trace->prjfs = prjfsChannel->getTraceBusPtr()->subscribeFunction(
+        name, [writer](const PrjfsTraceEvent& event) {
+          auto callName = apache::thrift::util::enumNameSafe(
+              event.getCallType());
+          auto id = event.getData().commandId;
+          switch (event.getType()) {
+            case PrjfsTraceEvent::START:
+              writer->asyncBegin(
+                  "prjfs",
+                  callName,
+                  id,
+                  event.monotonicTime,
+                  folly::dynamic::object("pid", event.getData().pid));
+              break;
+            case PrjfsTraceEvent::FINISH:
+              writer->asyncEnd("prjfs", callName, id, event.monotonicTime);
+              break;
+          }
+        });
+  }
+#else
+  if (auto* fuseChannel = edenMount.getFuseChannel()) {
+    trace->fuse = fuseChannel->getTraceBus().subscribeFunction(
+        name, [writer](const FuseTraceEvent& event) {
+          auto& request = event.getRequest();
+          auto opcodeName = fuseOpcodeName(request.opcode);
+          switch (event.getType()) {
+            case FuseTraceEvent::START:
+              writer->asyncBegin(
+                  "fuse",
+                  opcodeName,
+                  event.getUnique(),
+                  event.monotonicTime,
+                  folly::dynamic::object("nodeid", request.nodeid)(
+                      "pid", request.pid));
+              break;
+            case FuseTraceEvent::FINISH:
+              writer->asyncEnd(
+                  "fuse", opcodeName, event.getUnique(), event.monotonicTime);
+              break;
+          }
+        });
+  } else if (auto* nfsdChannel = edenMount.getNfsdChannel()) {
+    trace->nfs = nfsdChannel->getTraceBus().subscribeFunction(
+        name, [writer](const NfsTraceEvent& event) {
+          auto procName = nfsProcName(event.getProcNumber());
+          switch (event.getType()) {
+            case NfsTraceEvent::START:
+              writer->asyncBegin(
+                  "nfs", procName, event.getXid(), event.monotonicTime);
+              break;
+            case NfsTraceEvent::FINISH:
+              writer->asyncEnd(
+                  "nfs", procName, event.getXid(), event.monotonicTime);
+              break;
+          }
+        });
+  }
+#endif // _WIN32
+
+  trace->inode = edenMount.getInodeTraceBus().subscribeFunction(
+      name, [writer](const InodeTraceEvent& event) {
+        auto eventName = apache::thrift::util::enumNameSafe(event.eventType);
+        auto id = event.ino.get();
+        switch (event.progress) {
+          case InodeEventProgress::START:
+            writer->asyncBegin(
+                "inode",
+                eventName,
+                id,
+                event.monotonicTime,
+                folly::dynamic::object("path", event.getPath()));
+            break;
+          case InodeEventProgress::END:
+            writer->asyncEnd("inode", eventName, id, event.monotonicTime);
+            break;
+          case InodeEventProgress::FAIL:
+            writer->asyncEnd(
+                "inode",
+                eventName,
+                id,
+                event.monotonicTime,
+                folly::dynamic::object("failed", true));
+            break;
+        }
+      });
+
+  auto backingStore = mountHandle.getObjectStore().getBackingStore();
+  if (auto hgBackingStore = tryCastToHgQueuedBackingStore(backingStore)) {
+    trace->hg = hgBackingStore->getTraceBus().subscribeFunction(
+        name, [writer](const HgImportTraceEvent& event) {
+          std::string_view resourceName;
+          switch (event.resourceType) {
+            case HgImportTraceEvent::BLOB:
+              resourceName = "blob";
+              break;
+            case HgImportTraceEvent::TREE:
+              resourceName = "tree";
+              break;
+            case HgImportTraceEvent::BLOBMETA:
+              resourceName = "blobmeta";
+              break;
+          }
+          switch (event.eventType) {
+            case HgImportTraceEvent::QUEUE:
+              writer->asyncBegin(
+                  "hg",
+                  resourceName,
+                  event.unique,
+                  event.monotonicTime,
+                  folly::dynamic::object("path", event.getPath())(
+                      "requestId", event.requestId));
+              break;
+            case HgImportTraceEvent::START:
+              writer->asyncInstant(
+                  "hg", "fetch", event.unique, event.monotonicTime);
+              break;
+            case HgImportTraceEvent::FINISH:
+              writer->asyncEnd(
+                  "hg", resourceName, event.unique, event.monotonicTime);
+              break;
+          }
+        });
+  }
+
+  trace->task = TaskTraceEvent::getTraceBus()->subscribeFunction(
+      name, [writer](const TaskTraceEvent& event) {
+        writer->complete(
+            "task",
+            event.name,
+            event.threadId,
+            ChromeTraceWriter::TimePoint{event.start},
+            event.duration);
+      });
+
+  chromeTraces_.wlock()->insert_or_assign(
+      edenMount.getPath().asString(), std::move(trace));
+}
+
+void EdenServiceHandler::stopChromeTrace(
+    std::unique_ptr<std::string> mountPoint) {
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG1, *mountPoint);
+  auto mountPath = absolutePathFromThrift(*mountPoint);
+  // The writer is closed once the TraceBuses release the subscribers.
+  if (chromeTraces_.wlock()->erase(mountPath.asString()) == 0) {
+    throw newEdenError(
+        EINVAL,
+        EdenErrorType::ARGUMENT_ERROR,
+        "no Chrome trace is being written for ",
+        mountPath);
+  }
+}
+
 void EdenServiceHandler::getRetroactiveThriftRequestEvents(
     GetRetroactiveThriftRequestEventsResult& result) {
   if (!thriftRequestActivityBuffer_.has_value()) {
@@ -4122,7 +5050,12 @@ void EdenServiceHandler::getRetroactiveHgEvents(
   std::vector<HgEvent> thriftEvents;
   auto bufferEvents = hgBackingStore->getActivityBuffer().getAllEvents();
   thriftEvents.reserve(bufferEvents.size());
+  auto requestId = params->requestId();
   for (auto const& event : bufferEvents) {
+    if (requestId.has_value() &&
+        event.requestId != static_cast<uint64_t>(*requestId)) {
+      continue;
+    }
     HgEvent thriftEvent{};
     convertHgImportTraceEventToHgEvent(
         event, *server_->getServerState()->getProcessNameCache(), thriftEvent);
@@ -4132,6 +5065,35 @@ void EdenServiceHandler::getRetroactiveHgEvents(
   result.events() = std::move(thriftEvents);
 }
 
+void EdenServiceHandler::getFetchHeatmap(
+    GetFetchHeatmapResult& result,
+    std::unique_ptr<GetFetchHeatmapParams> params) {
+  auto mountHandle = lookupMount(params->mountPoint());
+  auto backingStore = mountHandle.getObjectStore().getBackingStore();
+  std::shared_ptr<HgQueuedBackingStore> hgBackingStore =
+      castToHgQueuedBackingStore(
+          backingStore, mountHandle.getEdenMount().getPath());
+
+  auto count = *params->count();
+  if (count < 0) {
+    throw newEdenError(
+        EINVAL,
+        EdenErrorType::ARGUMENT_ERROR,
+        "count must not be negative: ",
+        count);
+  }
+
+  std::vector<DirectoryFetchCount> directories;
+  for (auto& directory :
+       hgBackingStore->getFetchHeatmap().getTopDirectories(count)) {
+    DirectoryFetchCount& fetchCount = directories.emplace_back();
+    fetchCount.directory() = std::move(directory.path).value();
+    fetchCount.fetchCount() = directory.count;
+    fetchCount.error() = directory.error;
+  }
+  result.directories() = std::move(directories);
+}
+
 void EdenServiceHandler::getRetroactiveInodeEvents(
     GetRetroactiveInodeEventsResult& result,
     std::unique_ptr<GetRetroactiveInodeEventsParams> params) {
@@ -16,6 +16,7 @@
 #include "eden/fs/service/gen-cpp2/StreamingEdenService.h"
 #include "eden/fs/telemetry/ActivityBuffer.h"
 #include "eden/fs/telemetry/TraceBus.h"
+#include "eden/fs/utils/InFlightDeduplicator.h"
 #include "eden/fs/utils/PathFuncs.h"
 #include "eden/fs/utils/RefPtr.h"
 
@@ -118,6 +119,10 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
       CheckoutMode checkoutMode,
       std::unique_ptr<CheckOutRevisionParams> params) override;
 
+  folly::SemiFuture<std::unique_ptr<EstimateCheckoutResult>>
+  semifuture_estimateCheckout(
+      std::unique_ptr<EstimateCheckoutParams> params) override;
+
   folly::SemiFuture<folly::Unit> semifuture_resetParentCommits(
       std::unique_ptr<std::string> mountPoint,
       std::unique_ptr<WorkingDirectoryParents> parents,
@@ -189,15 +194,25 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
   semifuture_getAttributesFromFilesV2(
       std::unique_ptr<GetAttributesFromFilesParams> params) override;
 
+  folly::SemiFuture<std::unique_ptr<GetAttributesFromFilesColumnarResult>>
+  semifuture_getAttributesFromFilesColumnar(
+      std::unique_ptr<GetAttributesFromFilesParams> params) override;
+
   folly::SemiFuture<std::unique_ptr<ReaddirResult>> semifuture_readdir(
       std::unique_ptr<ReaddirParams> params) override;
 
   folly::SemiFuture<std::unique_ptr<Glob>> semifuture_globFiles(
       std::unique_ptr<GlobParams> params) override;
 
+  folly::SemiFuture<std::unique_ptr<Glob>> semifuture_globFilesInRepo(
+      std::unique_ptr<GlobRepoParams> params) override;
+
   folly::SemiFuture<folly::Unit> semifuture_prefetchFiles(
       std::unique_ptr<PrefetchParams> params) override;
 
+  folly::SemiFuture<folly::Unit> semifuture_prefetchRootTrees(
+      std::unique_ptr<PrefetchRootTreesParams> params) override;
+
   folly::SemiFuture<std::unique_ptr<Glob>> semifuture_predictiveGlobFiles(
       std::unique_ptr<GlobParams> params) override;
 
@@ -237,6 +252,12 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
   apache::thrift::ResponseAndServerStream<ChangesSinceResult, ChangedFileResult>
   streamChangesSince(std::unique_ptr<StreamChangesSinceParams> params) override;
 
+  apache::thrift::ResponseAndServerStream<StreamScmStatusResult, ScmStatus>
+  streamScmStatus(std::unique_ptr<GetScmStatusParams> params) override;
+
+  apache::thrift::ServerStream<Glob> streamGlobFiles(
+      std::unique_ptr<GlobParams> params) override;
+
   folly::SemiFuture<std::unique_ptr<ScmStatus>> semifuture_getScmStatus(
       std::unique_ptr<std::string> mountPoint,
       bool listIgnored,
@@ -277,6 +298,10 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
       std::vector<FuseCall>& outstandingCalls,
       std::unique_ptr<std::string> mountPoint) override;
 
+  void debugSlowestFuseCalls(
+      std::vector<SlowFuseCall>& slowestCalls,
+      std::unique_ptr<std::string> mountPoint) override;
+
   void debugOutstandingNfsCalls(
       std::vector<NfsCall>& outstandingCalls,
       std::unique_ptr<std::string> mountPoint) override;
@@ -288,6 +313,8 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
   void debugOutstandingThriftRequests(
       std::vector<ThriftRequestMetadata>& outstandingCalls) override;
 
+  void debugGetExpensiveGlobs(std::vector<ExpensiveGlob>& result) override;
+
   void debugStartRecordingActivity(
       ActivityRecorderResult& result,
       std::unique_ptr<std::string> mountPoint,
@@ -345,6 +372,10 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
   void disableTracing() override;
   void getTracePoints(std::vector<TracePoint>& result) override;
 
+  void startChromeTrace(
+      std::unique_ptr<StartChromeTraceParams> params) override;
+  void stopChromeTrace(std::unique_ptr<std::string> mountPoint) override;
+
   void getRetroactiveThriftRequestEvents(
       GetRetroactiveThriftRequestEventsResult& result) override;
 
@@ -352,6 +383,10 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
       GetRetroactiveHgEventsResult& result,
       std::unique_ptr<GetRetroactiveHgEventsParams> params) override;
 
+  void getFetchHeatmap(
+      GetFetchHeatmapResult& result,
+      std::unique_ptr<GetFetchHeatmapParams> params) override;
+
   void getRetroactiveInodeEvents(
       GetRetroactiveInodeEventsResult& result,
       std::unique_ptr<GetRetroactiveInodeEventsParams> params) override;
@@ -446,15 +481,18 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
       EntryAttributeFlags reqBitmask,
       SyncBehavior sync,
       const ObjectFetchContextPtr& fetchContext);
-  ImmediateFuture<EntryAttributes> getEntryAttributesForPath(
-      const EdenMount& edenMount,
-      EntryAttributeFlags reqBitmask,
-      std::string_view path,
-      const ObjectFetchContextPtr& fetchContext);
 
   folly::Synchronized<std::unordered_map<uint64_t, ThriftRequestTraceEvent>>
       outstandingThriftRequests_;
 
+  struct ChromeTrace;
+  /**
+   * The Chrome traces being written, by mount path. See startChromeTrace.
+   */
+  folly::Synchronized<
+      std::unordered_map<std::string, std::unique_ptr<ChromeTrace>>>
+      chromeTraces_;
+
   const std::vector<std::string> originalCommandLine_;
   EdenServer* const server_;
 
@@ -466,5 +504,11 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
   TraceSubscriptionHandle<ThriftRequestTraceEvent> thriftRequestTraceHandle_;
 
   std::shared_ptr<TraceBus<ThriftRequestTraceEvent>> thriftRequestTraceBus_;
+
+  /**
+   * Foreground globFiles() calls in progress, keyed by journal position and
+   * the serialized GlobParams.
+   */
+  InFlightDeduplicator<std::string, Glob> inFlightGlobs_;
 };
 } // namespace facebook::eden
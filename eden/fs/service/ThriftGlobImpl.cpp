@@ -10,7 +10,12 @@
 #include <folly/futures/Future.h>
 #include <folly/logging/LogLevel.h>
 #include <folly/logging/xlog.h>
+#include <folly/stop_watch.h>
+#include <algorithm>
+#include <atomic>
+#include "eden/common/utils/ProcessNameCache.h"
 #include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/inodes/GlobCostLog.h"
 #include "eden/fs/inodes/GlobNode.h"
 #include "eden/fs/inodes/ServerState.h"
 #include "eden/fs/inodes/TreeInode.h"
@@ -18,6 +23,8 @@
 #include "eden/fs/service/gen-cpp2/eden_types.h"
 #include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/store/PathLoader.h"
+#include "eden/fs/telemetry/LogEvent.h"
+#include "eden/fs/telemetry/StructuredLogger.h"
 #include "eden/fs/utils/EdenError.h"
 #include "eden/fs/utils/UnboundedQueueExecutor.h"
 
@@ -38,19 +45,154 @@ ThriftGlobImpl::ThriftGlobImpl(const PrefetchParams& params)
       rootHashes_{*params.revisions_ref()},
       searchRootUser_{*params.searchRoot_ref()} {}
 
-ImmediateFuture<std::unique_ptr<Glob>> ThriftGlobImpl::glob(
-    std::shared_ptr<EdenMount> edenMount,
-    std::shared_ptr<ServerState> serverState,
-    std::vector<std::string> globs,
-    const ObjectFetchContextPtr& fetchContext) {
-  bool windowsSymlinksEnabled =
-      edenMount->getCheckoutConfig()->getEnableWindowsSymlinks();
-  // Compile the list of globs into a tree
-  auto globRoot = std::make_shared<GlobNode>(
-      includeDotfiles_,
-      serverState->getEdenConfig()->globUseMountCaseSensitivity.getValue()
-          ? edenMount->getCheckoutConfig()->getCaseSensitive()
-          : CaseSensitivity::Sensitive);
+ThriftGlobImpl::ThriftGlobImpl(const GlobRepoParams& params)
+    : includeDotfiles_{*params.includeDotfiles_ref()},
+      wantDtype_{*params.wantDtype_ref()},
+      listOnlyFiles_{*params.listOnlyFiles_ref()},
+      rootHashes_{*params.revisions_ref()},
+      searchRootUser_{*params.searchRoot_ref()} {}
+
+namespace {
+
+// Forwards to the fetch context of a glob request, counting the trees that
+// the glob reads.
+class GlobFetchContext : public ObjectFetchContext {
+ public:
+  explicit GlobFetchContext(ObjectFetchContextPtr inner)
+      : inner_{std::move(inner)} {}
+
+  void didFetch(ObjectType type, const ObjectId& id, Origin origin) override {
+    if (type == ObjectType::Tree) {
+      if (origin == Origin::FromNetworkFetch) {
+        treesFromBackingStore.fetch_add(1, std::memory_order_relaxed);
+      } else if (origin != Origin::NotFetched) {
+        treesFromCache.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    inner_->didFetch(type, id, origin);
+  }
+
+  OptionalProcessId getClientPid() const override {
+    return inner_->getClientPid();
+  }
+
+  Cause getCause() const override {
+    return inner_->getCause();
+  }
+
+  std::optional<std::string_view> getCauseDetail() const override {
+    return inner_->getCauseDetail();
+  }
+
+  ImportPriority getPriority() const override {
+    return inner_->getPriority();
+  }
+
+  const std::unordered_map<std::string, std::string>* getRequestInfo()
+      const override {
+    return inner_->getRequestInfo();
+  }
+
+  folly::CancellationToken getCancellationToken() const override {
+    return inner_->getCancellationToken();
+  }
+
+  std::optional<std::chrono::steady_clock::time_point> getDeadline()
+      const override {
+    return inner_->getDeadline();
+  }
+
+  void deprioritize(uint64_t delta) override {
+    inner_->deprioritize(delta);
+  }
+
+  std::atomic<uint64_t> treesFromCache{0};
+  std::atomic<uint64_t> treesFromBackingStore{0};
+
+ private:
+  ObjectFetchContextPtr inner_;
+};
+
+// Accounts for the work done by a glob request, from its creation until
+// finish() is called: the costs are then kept in the GlobCostLog, and logged
+// if the glob was slow.
+class GlobCostAccounting {
+ public:
+  GlobCostAccounting(
+      std::string request,
+      const ObjectFetchContextPtr& fetchContext,
+      std::shared_ptr<ServerState> serverState)
+      : request_{std::move(request)},
+        fetchContext_{makeRefPtr<GlobFetchContext>(fetchContext.copy())},
+        serverState_{std::move(serverState)} {}
+
+  // The fetch context to evaluate the glob with.
+  const ObjectFetchContextPtr& getFetchContext() const {
+    return fetchContext_.as<ObjectFetchContext>();
+  }
+
+  const std::shared_ptr<GlobNode::EvaluationStats>& getStats() const {
+    return stats_;
+  }
+
+  void finish() {
+    GlobCost cost;
+    cost.request = std::move(request_);
+    cost.clientPid = fetchContext_->getClientPid();
+    cost.directoriesVisited = stats_->directoriesVisited.load();
+    cost.treesFromCache = fetchContext_->treesFromCache.load();
+    cost.treesFromBackingStore = fetchContext_->treesFromBackingStore.load();
+    cost.entriesMatched = stats_->entriesMatched.load();
+    cost.matchingTime =
+        std::chrono::microseconds(stats_->matchingTimeUs.load());
+    cost.duration = timer_.elapsed();
+
+    if (cost.duration >=
+        serverState_->getEdenConfig()->globSlowThreshold.getValue()) {
+      std::string clientCmdline;
+      if (cost.clientPid) {
+        clientCmdline = serverState_->getProcessNameCache()
+                            ->lookup(cost.clientPid.value().get())
+                            .get();
+        std::replace(clientCmdline.begin(), clientCmdline.end(), '\0', ' ');
+      }
+      XLOG(WARN) << "slow glob by caller " << clientCmdline << " took "
+                 << cost.duration.count() << "us and visited "
+                 << cost.directoriesVisited << " directories: "
+                 << cost.request;
+      serverState_->getStructuredLogger()->logEvent(SlowGlob{
+          cost.request,
+          std::move(clientCmdline),
+          cost.directoriesVisited,
+          cost.treesFromCache,
+          cost.treesFromBackingStore,
+          cost.entriesMatched,
+          std::chrono::duration<double>{cost.matchingTime}.count(),
+          std::chrono::duration<double>{cost.duration}.count()});
+    }
+    if (const auto& costLog = serverState_->getGlobCostLog()) {
+      costLog->record(std::move(cost));
+    }
+  }
+
+ private:
+  std::string request_;
+  RefPtr<GlobFetchContext> fetchContext_;
+  std::shared_ptr<ServerState> serverState_;
+  std::shared_ptr<GlobNode::EvaluationStats> stats_{
+      std::make_shared<GlobNode::EvaluationStats>()};
+  folly::stop_watch<std::chrono::microseconds> timer_;
+};
+
+// Compile the list of globs into a tree. When concurrency is non-zero, the
+// subtrees are walked on the server thread pool.
+std::shared_ptr<GlobNode> compileGlobs(
+    bool includeDotfiles,
+    CaseSensitivity caseSensitive,
+    size_t concurrency,
+    ServerState& serverState,
+    const std::vector<std::string>& globs) {
+  auto globRoot = std::make_shared<GlobNode>(includeDotfiles, caseSensitive);
   try {
     for (auto& globString : globs) {
       try {
@@ -67,189 +209,484 @@ ImmediateFuture<std::unique_ptr<Glob>> ThriftGlobImpl::glob(
   } catch (const std::system_error& exc) {
     throw newEdenError(exc);
   }
+  if (const auto& resultCache = serverState.getGlobResultCache()) {
+    globRoot->setResultCache(resultCache);
+  }
+  if (concurrency) {
+    globRoot->setExecutor(serverState.getThreadPool(), concurrency);
+  }
+  return globRoot;
+}
 
-  auto fileBlobsToPrefetch =
-      prefetchFiles_ ? std::make_shared<GlobNode::PrefetchList>() : nullptr;
+// Compile the list of globs to evaluate in the given mount.
+std::shared_ptr<GlobNode> compileGlobs(
+    bool includeDotfiles,
+    const EdenMount& edenMount,
+    ServerState& serverState,
+    const std::vector<std::string>& globs) {
+  auto config = serverState.getEdenConfig();
+  return compileGlobs(
+      includeDotfiles,
+      config->globUseMountCaseSensitivity.getValue()
+          ? edenMount.getCheckoutConfig()->getCaseSensitive()
+          : CaseSensitivity::Sensitive,
+      config->globConcurrency.getValue(),
+      serverState,
+      globs);
+}
 
-  // These hashes must outlive the GlobResult created by evaluate as the
-  // GlobResults will hold on to references to these hashes
-  auto originRootIds = std::make_unique<std::vector<RootId>>();
+RelativePath parseSearchRoot(folly::StringPiece searchRootUser) {
+  if (searchRootUser.empty() || searchRootUser == ".") {
+    return RelativePath{};
+  }
+  return RelativePath{searchRootUser};
+}
 
-  // Globs will be evaluated against the specified commits or the current commit
-  // if none are specified. The results will be collected here.
+// Globs will be evaluated against the root trees of the given commits, read
+// from the object store. The results will be collected in globResults.
+//
+// The originRootIds must outlive the GlobResults created by evaluate as they
+// hold on to references to them.
+ImmediateFuture<std::vector<folly::Try<folly::Unit>>> evaluateTreeGlobs(
+    const std::shared_ptr<ObjectStore>& objectStore,
+    const std::shared_ptr<GlobNode>& globRoot,
+    const ObjectFetchContextPtr& fetchContext,
+    const std::vector<std::string>& rootHashes,
+    const RelativePath& searchRoot,
+    std::vector<RootId>& originRootIds,
+    std::shared_ptr<GlobNode::PrefetchList> fileBlobsToPrefetch,
+    std::shared_ptr<GlobNode::ResultList> globResults) {
   std::vector<ImmediateFuture<folly::Unit>> globFutures{};
-  auto globResults = std::make_shared<GlobNode::ResultList>();
-
-  RelativePath searchRoot;
-  if (!(searchRootUser_.empty() || searchRootUser_ == ".")) {
-    searchRoot = RelativePath{searchRootUser_};
-  }
 
-  if (!rootHashes_.empty()) {
-    // Note that we MUST reserve here, otherwise while emplacing we might
-    // invalidate the earlier commitHash refrences
-    globFutures.reserve(rootHashes_.size());
-    originRootIds->reserve(rootHashes_.size());
-    for (auto& rootHash : rootHashes_) {
-      const RootId& originRootId = originRootIds->emplace_back(
-          edenMount->getObjectStore()->parseRootId(rootHash));
-
-      globFutures.emplace_back(
-          edenMount->getObjectStore()
-              ->getRootTree(originRootId, fetchContext)
-              .thenValue([edenMount,
-                          globRoot,
-                          fetchContext = fetchContext.copy(),
-                          searchRoot](std::shared_ptr<const Tree>&& rootTree) {
-                return resolveTree(
-                    *edenMount->getObjectStore(),
-                    fetchContext,
-                    std::move(rootTree),
-                    searchRoot);
-              })
-              .thenValue(
-                  [edenMount,
-                   globRoot,
-                   fetchContext = fetchContext.copy(),
-                   fileBlobsToPrefetch,
-                   globResults,
-                   &originRootId](std::shared_ptr<const Tree>&& tree) mutable {
-                    return globRoot->evaluate(
-                        edenMount->getObjectStore(),
-                        fetchContext,
-                        RelativePathPiece(),
-                        std::move(tree),
-                        fileBlobsToPrefetch.get(),
-                        *globResults,
-                        originRootId);
-                  }));
-    }
-  } else {
+  // Note that we MUST reserve here, otherwise while emplacing we might
+  // invalidate the earlier commitHash refrences
+  globFutures.reserve(rootHashes.size());
+  originRootIds.reserve(rootHashes.size());
+  for (auto& rootHash : rootHashes) {
     const RootId& originRootId =
-        originRootIds->emplace_back(edenMount->getCheckedOutRootId());
+        originRootIds.emplace_back(objectStore->parseRootId(rootHash));
+
     globFutures.emplace_back(
-        edenMount->getInodeSlow(searchRoot, fetchContext)
-            .thenValue([fetchContext = fetchContext.copy(),
-                        globRoot,
-                        edenMount,
-                        fileBlobsToPrefetch,
-                        globResults,
-                        &originRootId](InodePtr inode) mutable {
-              return globRoot->evaluate(
-                  edenMount->getObjectStore(),
+        objectStore->getRootTree(originRootId, fetchContext)
+            .thenValue([objectStore,
+                        fetchContext = fetchContext.copy(),
+                        searchRoot](std::shared_ptr<const Tree>&& rootTree) {
+              return resolveTree(
+                  *objectStore,
                   fetchContext,
-                  RelativePathPiece(),
-                  inode.asTreePtr(),
-                  fileBlobsToPrefetch.get(),
-                  *globResults,
-                  originRootId);
-            }));
+                  std::move(rootTree),
+                  searchRoot);
+            })
+            .thenValue(
+                [objectStore,
+                 globRoot,
+                 fetchContext = fetchContext.copy(),
+                 fileBlobsToPrefetch,
+                 globResults,
+                 &originRootId](std::shared_ptr<const Tree>&& tree) mutable {
+                  return globRoot->evaluate(
+                      objectStore,
+                      fetchContext,
+                      RelativePathPiece(),
+                      std::move(tree),
+                      fileBlobsToPrefetch.get(),
+                      *globResults,
+                      originRootId);
+                }));
   }
 
-  auto prefetchFuture =
-      collectAll(std::move(globFutures))
-          .thenValue([fileBlobsToPrefetch,
-                      globResults = std::move(globResults),
-                      suppressFileList = suppressFileList_](
-                         std::vector<folly::Try<folly::Unit>>&& tries) {
-            std::vector<GlobNode::GlobResult> sortedResults;
+  return collectAll(std::move(globFutures));
+}
+
+// Globs will be evaluated against the given commits or the current commit of
+// the mount if none are given. The results will be collected in globResults.
+//
+// The originRootIds must outlive the GlobResults created by evaluate as they
+// hold on to references to them.
+ImmediateFuture<std::vector<folly::Try<folly::Unit>>> evaluateGlobs(
+    const std::shared_ptr<EdenMount>& edenMount,
+    const std::shared_ptr<GlobNode>& globRoot,
+    const ObjectFetchContextPtr& fetchContext,
+    const std::vector<std::string>& rootHashes,
+    folly::StringPiece searchRootUser,
+    std::vector<RootId>& originRootIds,
+    std::shared_ptr<GlobNode::PrefetchList> fileBlobsToPrefetch,
+    std::shared_ptr<GlobNode::ResultList> globResults) {
+  auto searchRoot = parseSearchRoot(searchRootUser);
+  if (!rootHashes.empty()) {
+    return evaluateTreeGlobs(
+        edenMount->getObjectStore(),
+        globRoot,
+        fetchContext,
+        rootHashes,
+        searchRoot,
+        originRootIds,
+        std::move(fileBlobsToPrefetch),
+        std::move(globResults));
+  }
+
+  std::vector<ImmediateFuture<folly::Unit>> globFutures{};
+  const RootId& originRootId =
+      originRootIds.emplace_back(edenMount->getCheckedOutRootId());
+  globFutures.emplace_back(
+      edenMount->getInodeSlow(searchRoot, fetchContext)
+          .thenValue([fetchContext = fetchContext.copy(),
+                      globRoot,
+                      edenMount,
+                      fileBlobsToPrefetch,
+                      globResults,
+                      &originRootId](InodePtr inode) mutable {
+            return globRoot->evaluate(
+                edenMount->getObjectStore(),
+                fetchContext,
+                RelativePathPiece(),
+                inode.asTreePtr(),
+                fileBlobsToPrefetch.get(),
+                *globResults,
+                originRootId);
+          }));
+
+  return collectAll(std::move(globFutures));
+}
+
+void appendResults(
+    Glob& out,
+    const std::vector<GlobNode::GlobResult>& results,
+    const ObjectStore& store,
+    bool wantDtype,
+    bool listOnlyFiles,
+    bool windowsSymlinksEnabled) {
+  for (auto& entry : results) {
+    if (!listOnlyFiles || entry.dtype != dtype_t::Dir) {
+      out.matchingFiles_ref()->emplace_back(entry.name.asString());
+
+      if (wantDtype) {
+        auto dtype = entry.dtype;
+        if (folly::kIsWindows && dtype == dtype_t::Symlink &&
+            !windowsSymlinksEnabled) {
+          dtype = dtype_t::Regular;
+        }
+        out.dtypes_ref()->emplace_back(static_cast<OsDtype>(dtype));
+      }
+
+      out.originHashes_ref()->emplace_back(
+          store.renderRootId(*entry.originHash));
+    }
+  }
+}
+
+// fileBlobsToPrefetch is deduplicated as an optimization. The BackingStore
+// layer does not deduplicate fetches, so lets avoid causing too many
+// duplicates here.
+void deduplicateBlobs(GlobNode::PrefetchList& fileBlobsToPrefetch) {
+  auto fileBlobsToPrefetchLocked = fileBlobsToPrefetch.wlock();
+  std::sort(
+      fileBlobsToPrefetchLocked->begin(),
+      fileBlobsToPrefetchLocked->end(),
+      std::less<ObjectId>{});
+  auto fileBlobsToPrefetchNewEnd = std::unique(
+      fileBlobsToPrefetchLocked->begin(),
+      fileBlobsToPrefetchLocked->end(),
+      std::equal_to<ObjectId>());
+  fileBlobsToPrefetchLocked->erase(
+      fileBlobsToPrefetchNewEnd, fileBlobsToPrefetchLocked->end());
+}
+
+ImmediateFuture<folly::Unit> prefetchBlobs(
+    ObjectStore& store,
+    std::shared_ptr<GlobNode::PrefetchList> fileBlobsToPrefetch,
+    const ObjectFetchContextPtr& fetchContext) {
+  std::vector<ImmediateFuture<folly::Unit>> futures;
+
+  auto blobs = fileBlobsToPrefetch->rlock();
+  auto range = folly::Range{blobs->data(), blobs->size()};
+
+  while (range.size() > 20480) {
+    auto curRange = range.subpiece(0, 20480);
+    range.advance(20480);
+    futures.emplace_back(store.prefetchBlobs(curRange, fetchContext));
+  }
+  if (!range.empty()) {
+    futures.emplace_back(store.prefetchBlobs(range, fetchContext));
+  }
+
+  return collectAll(std::move(futures))
+      .thenValue([fileBlobsToPrefetch](auto&&) { return folly::unit; });
+}
+
+// Sort and deduplicate the results of the evaluation, and prefetch the files
+// if requested.
+ImmediateFuture<std::unique_ptr<Glob>> collectGlob(
+    ImmediateFuture<std::vector<folly::Try<folly::Unit>>> globFuture,
+    std::shared_ptr<ObjectStore> objectStore,
+    std::shared_ptr<GlobNode::PrefetchList> fileBlobsToPrefetch,
+    std::shared_ptr<GlobNode::ResultList> globResults,
+    const ObjectFetchContextPtr& fetchContext,
+    bool wantDtype,
+    bool suppressFileList,
+    bool listOnlyFiles,
+    bool windowsSymlinksEnabled) {
+  return std::move(globFuture)
+      .thenValue([fileBlobsToPrefetch,
+                  globResults = std::move(globResults),
+                  suppressFileList](
+                     std::vector<folly::Try<folly::Unit>>&& tries) {
+        std::vector<GlobNode::GlobResult> sortedResults;
+        if (!suppressFileList) {
+          std::swap(sortedResults, *globResults->wlock());
+          for (auto& try_ : tries) {
+            try_.throwUnlessValue();
+          }
+          std::sort(sortedResults.begin(), sortedResults.end());
+          auto resultsNewEnd =
+              std::unique(sortedResults.begin(), sortedResults.end());
+          sortedResults.erase(resultsNewEnd, sortedResults.end());
+        }
+
+        if (fileBlobsToPrefetch) {
+          deduplicateBlobs(*fileBlobsToPrefetch);
+        }
+
+        return sortedResults;
+      })
+      .thenValue(
+          [objectStore = std::move(objectStore),
+           wantDtype,
+           fileBlobsToPrefetch,
+           suppressFileList,
+           listOnlyFiles,
+           fetchContext = fetchContext.copy(),
+           windowsSymlinksEnabled](
+              std::vector<GlobNode::GlobResult>&& results) mutable
+          -> ImmediateFuture<std::unique_ptr<Glob>> {
+            auto out = std::make_unique<Glob>();
+
             if (!suppressFileList) {
-              std::swap(sortedResults, *globResults->wlock());
-              for (auto& try_ : tries) {
-                try_.throwUnlessValue();
-              }
-              std::sort(sortedResults.begin(), sortedResults.end());
-              auto resultsNewEnd =
-                  std::unique(sortedResults.begin(), sortedResults.end());
-              sortedResults.erase(resultsNewEnd, sortedResults.end());
+              // already deduplicated at this point, no need to de-dup
+              appendResults(
+                  *out,
+                  results,
+                  *objectStore,
+                  wantDtype,
+                  listOnlyFiles,
+                  windowsSymlinksEnabled);
             }
-
-            // fileBlobsToPrefetch is deduplicated as an optimization.
-            // The BackingStore layer does not deduplicate fetches, so lets
-            // avoid causing too many duplicates here.
             if (fileBlobsToPrefetch) {
-              auto fileBlobsToPrefetchLocked = fileBlobsToPrefetch->wlock();
-              std::sort(
-                  fileBlobsToPrefetchLocked->begin(),
-                  fileBlobsToPrefetchLocked->end(),
-                  std::less<ObjectId>{});
-              auto fileBlobsToPrefetchNewEnd = std::unique(
-                  fileBlobsToPrefetchLocked->begin(),
-                  fileBlobsToPrefetchLocked->end(),
-                  std::equal_to<ObjectId>());
-              fileBlobsToPrefetchLocked->erase(
-                  fileBlobsToPrefetchNewEnd, fileBlobsToPrefetchLocked->end());
+              return prefetchBlobs(
+                         *objectStore, fileBlobsToPrefetch, fetchContext)
+                  .thenValue([glob = std::move(out)](auto&&) mutable {
+                    return std::move(glob);
+                  });
             }
-
-            return sortedResults;
-          })
-          .thenValue(
-              [edenMount,
-               wantDtype = wantDtype_,
-               fileBlobsToPrefetch,
-               suppressFileList = suppressFileList_,
-               listOnlyFiles = listOnlyFiles_,
-               fetchContext = fetchContext.copy(),
-               windowsSymlinksEnabled = windowsSymlinksEnabled,
-               config = serverState->getEdenConfig()](
-                  std::vector<GlobNode::GlobResult>&& results) mutable
-              -> ImmediateFuture<std::unique_ptr<Glob>> {
-                auto out = std::make_unique<Glob>();
-
-                if (!suppressFileList) {
-                  // already deduplicated at this point, no need to de-dup
-                  for (auto& entry : results) {
-                    if (!listOnlyFiles || entry.dtype != dtype_t::Dir) {
-                      out->matchingFiles_ref()->emplace_back(
-                          entry.name.asString());
-
-                      if (wantDtype) {
-                        auto dtype = entry.dtype;
-                        if (folly::kIsWindows && dtype == dtype_t::Symlink &&
-                            !windowsSymlinksEnabled) {
-                          dtype = dtype_t::Regular;
-                        }
-                        out->dtypes_ref()->emplace_back(
-                            static_cast<OsDtype>(dtype));
-                      }
-
-                      out->originHashes_ref()->emplace_back(
-                          edenMount->getObjectStore()->renderRootId(
-                              *entry.originHash));
-                    }
-                  }
-                }
-                if (fileBlobsToPrefetch) {
-                  std::vector<ImmediateFuture<folly::Unit>> futures;
-
-                  auto store = edenMount->getObjectStore();
-                  auto blobs = fileBlobsToPrefetch->rlock();
-                  auto range = folly::Range{blobs->data(), blobs->size()};
-
-                  while (range.size() > 20480) {
-                    auto curRange = range.subpiece(0, 20480);
-                    range.advance(20480);
-                    futures.emplace_back(
-                        store->prefetchBlobs(curRange, fetchContext));
-                  }
-                  if (!range.empty()) {
-                    futures.emplace_back(
-                        store->prefetchBlobs(range, fetchContext));
-                  }
-
-                  return collectAll(std::move(futures))
-                      .thenValue([glob = std::move(out),
-                                  fileBlobsToPrefetch](auto&&) mutable {
-                        return std::move(glob);
-                      });
-                }
-                return std::move(out);
-              })
-          .ensure([globRoot, originRootIds = std::move(originRootIds)]() {
-            // keep globRoot and originRootIds alive until the end
+            return std::move(out);
           });
+}
+
+} // namespace
+
+ImmediateFuture<std::unique_ptr<Glob>> ThriftGlobImpl::glob(
+    std::shared_ptr<EdenMount> edenMount,
+    std::shared_ptr<ServerState> serverState,
+    std::vector<std::string> globs,
+    const ObjectFetchContextPtr& fetchContext) {
+  bool windowsSymlinksEnabled =
+      edenMount->getCheckoutConfig()->getEnableWindowsSymlinks();
+  auto globRoot =
+      compileGlobs(includeDotfiles_, *edenMount, *serverState, globs);
+  auto accounting = std::make_shared<GlobCostAccounting>(
+      logString(globs), fetchContext, serverState);
+  globRoot->setEvaluationStats(accounting->getStats());
+
+  auto fileBlobsToPrefetch =
+      prefetchFiles_ ? std::make_shared<GlobNode::PrefetchList>() : nullptr;
+
+  // These hashes must outlive the GlobResult created by evaluate as the
+  // GlobResults will hold on to references to these hashes
+  auto originRootIds = std::make_unique<std::vector<RootId>>();
+
+  auto globResults = std::make_shared<GlobNode::ResultList>();
+  auto globFuture = evaluateGlobs(
+      edenMount,
+      globRoot,
+      accounting->getFetchContext(),
+      rootHashes_,
+      searchRootUser_,
+      *originRootIds,
+      fileBlobsToPrefetch,
+      globResults);
+
+  return collectGlob(
+             std::move(globFuture),
+             edenMount->getObjectStore(),
+             std::move(fileBlobsToPrefetch),
+             std::move(globResults),
+             fetchContext,
+             wantDtype_,
+             suppressFileList_,
+             listOnlyFiles_,
+             windowsSymlinksEnabled)
+      .ensure([globRoot,
+               edenMount,
+               originRootIds = std::move(originRootIds),
+               accounting]() {
+        // keep globRoot, edenMount and originRootIds alive until the end
+        accounting->finish();
+      });
+}
+
+ImmediateFuture<std::unique_ptr<Glob>> ThriftGlobImpl::globTrees(
+    std::shared_ptr<ObjectStore> objectStore,
+    std::shared_ptr<ServerState> serverState,
+    std::vector<std::string> globs,
+    const ObjectFetchContextPtr& fetchContext) {
+  if (rootHashes_.empty()) {
+    return makeImmediateFuture<std::unique_ptr<Glob>>(newEdenError(
+        EdenErrorType::ARGUMENT_ERROR,
+        "no revisions given to evaluate the globs against"));
+  }
+  auto globRoot = compileGlobs(
+      includeDotfiles_,
+      objectStore->getCaseSensitive(),
+      std::max(
+          serverState->getEdenConfig()->globRepoConcurrency.getValue(),
+          size_t{1}),
+      *serverState,
+      globs);
+  auto accounting = std::make_shared<GlobCostAccounting>(
+      logString(globs), fetchContext, serverState);
+  globRoot->setEvaluationStats(accounting->getStats());
+
+  auto fileBlobsToPrefetch =
+      prefetchFiles_ ? std::make_shared<GlobNode::PrefetchList>() : nullptr;
+  auto originRootIds = std::make_unique<std::vector<RootId>>();
+  auto globResults = std::make_shared<GlobNode::ResultList>();
+  auto globFuture = evaluateTreeGlobs(
+      objectStore,
+      globRoot,
+      accounting->getFetchContext(),
+      rootHashes_,
+      parseSearchRoot(searchRootUser_),
+      *originRootIds,
+      fileBlobsToPrefetch,
+      globResults);
+
+  return collectGlob(
+             std::move(globFuture),
+             objectStore,
+             std::move(fileBlobsToPrefetch),
+             std::move(globResults),
+             fetchContext,
+             wantDtype_,
+             suppressFileList_,
+             listOnlyFiles_,
+             objectStore->getWindowsSymlinksEnabled())
+      .ensure([globRoot,
+               originRootIds = std::move(originRootIds),
+               accounting]() {
+        // keep globRoot and originRootIds alive until the end
+        accounting->finish();
+      });
+}
+
+ImmediateFuture<folly::Unit> ThriftGlobImpl::streamGlob(
+    std::shared_ptr<EdenMount> edenMount,
+    std::shared_ptr<ServerState> serverState,
+    std::vector<std::string> globs,
+    const ObjectFetchContextPtr& fetchContext,
+    size_t chunkSize,
+    std::function<void(Glob&&)> onChunk) {
+  bool windowsSymlinksEnabled =
+      edenMount->getCheckoutConfig()->getEnableWindowsSymlinks();
+  auto globRoot =
+      compileGlobs(includeDotfiles_, *edenMount, *serverState, globs);
+  auto accounting = std::make_shared<GlobCostAccounting>(
+      logString(globs), fetchContext, serverState);
+  globRoot->setEvaluationStats(accounting->getStats());
+
+  auto fileBlobsToPrefetch =
+      prefetchFiles_ ? std::make_shared<GlobNode::PrefetchList>() : nullptr;
+  auto originRootIds = std::make_unique<std::vector<RootId>>();
+  auto globResults = std::make_shared<GlobNode::ResultList>();
+
+  // Take the results found so far out of globResults, and pass them on unless
+  // the file list is suppressed. Unless flushing, this waits for a full chunk.
+  auto publish = std::make_shared<std::function<void(bool)>>(
+      [edenMount,
+       globResults = globResults.get(),
+       onChunk = std::move(onChunk),
+       chunkSize = std::max(chunkSize, size_t{1}),
+       wantDtype = wantDtype_,
+       suppressFileList = suppressFileList_,
+       listOnlyFiles = listOnlyFiles_,
+       windowsSymlinksEnabled](bool flush) {
+        std::vector<GlobNode::GlobResult> results;
+        {
+          auto lockedResults = globResults->wlock();
+          if (lockedResults->empty() ||
+              (!flush && lockedResults->size() < chunkSize)) {
+            return;
+          }
+          std::swap(results, *lockedResults);
+        }
+        if (suppressFileList) {
+          return;
+        }
+        Glob chunk;
+        appendResults(
+            chunk,
+            results,
+            *edenMount->getObjectStore(),
+            wantDtype,
+            listOnlyFiles,
+            windowsSymlinksEnabled);
+        if (!chunk.matchingFiles_ref()->empty()) {
+          onChunk(std::move(chunk));
+        }
+      });
+  globRoot->setResultsCallback(std::make_shared<GlobNode::ResultsCallback>(
+      [publish, globResults = globResults.get()](
+          GlobNode::ResultList& results) {
+        // Leave alone the lists that the GlobNodes use internally.
+        if (&results == globResults) {
+          (*publish)(false);
+        }
+      }));
+
+  auto globFuture = evaluateGlobs(
+      edenMount,
+      globRoot,
+      accounting->getFetchContext(),
+      rootHashes_,
+      searchRootUser_,
+      *originRootIds,
+      fileBlobsToPrefetch,
+      globResults);
 
-  return prefetchFuture;
+  return std::move(globFuture)
+      .thenValue([edenMount,
+                  publish,
+                  fileBlobsToPrefetch,
+                  fetchContext = fetchContext.copy()](
+                     std::vector<folly::Try<folly::Unit>>&& tries)
+                     -> ImmediateFuture<folly::Unit> {
+        (*publish)(true);
+        for (auto& try_ : tries) {
+          try_.throwUnlessValue();
+        }
+        if (fileBlobsToPrefetch) {
+          deduplicateBlobs(*fileBlobsToPrefetch);
+          return prefetchBlobs(
+              *edenMount->getObjectStore(), fileBlobsToPrefetch, fetchContext);
+        }
+        return folly::unit;
+      })
+      .ensure([globRoot,
+               globResults = std::move(globResults),
+               originRootIds = std::move(originRootIds),
+               accounting]() {
+        // keep globRoot, globResults and originRootIds alive until the end
+        accounting->finish();
+      });
 }
 
 std::string ThriftGlobImpl::logString() {
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -18,9 +19,11 @@
 namespace facebook::eden {
 
 class EdenMount;
+class ObjectStore;
 class ServerState;
 class Glob;
 class GlobParams;
+class GlobRepoParams;
 class PrefetchParams;
 class ObjectFetchContext;
 using ObjectFetchContextPtr = RefPtr<ObjectFetchContext>;
@@ -29,6 +32,7 @@ class ThriftGlobImpl {
  public:
   explicit ThriftGlobImpl(const GlobParams& params);
   explicit ThriftGlobImpl(const PrefetchParams& params);
+  explicit ThriftGlobImpl(const GlobRepoParams& params);
 
   // TODO: shared_ptr<EdenMount> is not sufficient to ensure an EdenMount is
   // usable for the duration of this glob. Either pass EdenMountHandle or
@@ -39,6 +43,35 @@ class ThriftGlobImpl {
       std::vector<std::string> globs,
       const ObjectFetchContextPtr& fetchContext);
 
+  /**
+   * Evaluate the globs like glob(), but pass the matching files to onChunk
+   * while the evaluation is in progress, in chunks of at least chunkSize of
+   * them except for the last one. Chunks are neither sorted nor deduplicated
+   * against each other. Files are prefetched once all of the chunks are
+   * passed on.
+   */
+  ImmediateFuture<folly::Unit> streamGlob(
+      std::shared_ptr<EdenMount> edenMount,
+      std::shared_ptr<ServerState> serverState,
+      std::vector<std::string> globs,
+      const ObjectFetchContextPtr& fetchContext,
+      size_t chunkSize,
+      std::function<void(Glob&&)> onChunk);
+
+  /**
+   * Evaluate the globs against the root trees of the revisions, read from
+   * the given object store rather than from a mount, so that the commits of
+   * a repository can be globbed without checking them out. The trees are
+   * walked on the server thread pool, with the concurrency set by
+   * glob:repo-concurrency, and share the glob result cache with the globs of
+   * the mounts. Fails if no revisions are given.
+   */
+  ImmediateFuture<std::unique_ptr<Glob>> globTrees(
+      std::shared_ptr<ObjectStore> objectStore,
+      std::shared_ptr<ServerState> serverState,
+      std::vector<std::string> globs,
+      const ObjectFetchContextPtr& fetchContext);
+
   std::string logString();
   std::string logString(const std::vector<std::string>& globs) const;
 
@@ -477,6 +477,31 @@ struct GetAttributesFromFilesResultV2 {
   1: list<FileAttributeDataOrErrorV2> res;
 }
 
+/**
+ * Return value for the getAttributesFromFilesColumnar() function.
+ *
+ * Each requested attribute is returned as a column, indexed like the input
+ * paths; the columns of attributes that were not requested are left empty.
+ *
+ * A path is in error if it could not be looked up, or if any of the requested
+ * attributes is not available for it (eg; the sha1 of a directory). Bit
+ * (i % 8) of byte (i / 8) of errorBitmap is set when paths[i] is in error,
+ * and errors holds the error of each such path, in path order. The column
+ * entries of a path in error are zeroed.
+ */
+struct GetAttributesFromFilesColumnarResult {
+  1: binary errorBitmap;
+  2: list<EdenError> errors;
+  // The 20-byte SHA-1 of each path, concatenated.
+  3: binary sha1s;
+  // The 32-byte BLAKE3 hash of each path, concatenated.
+  4: binary blake3s;
+  5: list<i64> sizes;
+  6: list<SourceControlType> sourceControlTypes;
+  // Empty for paths that have been locally written to.
+  7: list<ThriftObjectId> objectIds;
+}
+
 struct ReaddirParams {
   1: PathString mountPoint;
   2: list<PathString> directoryPaths;
@@ -912,6 +937,10 @@ struct CacheStats {
   4: i64 missCount;
   5: i64 evictionCount;
   6: i64 dropCount;
+  // Number of inserts the admission policy declined to cache.
+  7: i64 admissionRejectCount;
+  // Name of the eviction policy, as in the eviction-policy config settings.
+  8: string evictionPolicy;
 }
 
 /*
@@ -923,6 +952,7 @@ const i64 STATS_SMAPS = 0x4;
 const i64 STATS_PRIVATE_BYTES = 0x8;
 const i64 STATS_RSS_BYTES = 0x10;
 const i64 STATS_CACHE_STATS = 0x20;
+const i64 STATS_MEMORY_USAGE = 0x40;
 const i64 STATS_ALL = 0xFFFF;
 
 /**
@@ -981,6 +1011,14 @@ struct InternalStats {
    * Populated if STATS_CACHE_STATS is set.
    */
   9: optional CacheStats treeCacheStats;
+  /**
+   * Estimated bytes held by each subsystem of EdenFS, keyed by subsystem
+   * name: "inodes", "journal", "blob_cache", "tree_cache" and
+   * "hg_import_queue". These are lower bounds computed from the objects each
+   * subsystem tracks, to be compared with vmRSSBytes.
+   * Populated if STATS_MEMORY_USAGE is set.
+   */
+  10: optional map<string, i64> memoryUsage;
 }
 
 /**
@@ -1063,6 +1101,10 @@ struct HgEvent {
   7: optional RequestInfo requestInfo;
   8: HgImportPriority importPriority;
   9: HgImportCause importCause;
+
+  // The ID of the filesystem request that caused this import, as reported in
+  // FuseCall.unique, or 0 if it wasn't caused by a traced request.
+  10: i64 requestId;
 }
 
 /**
@@ -1070,6 +1112,9 @@ struct HgEvent {
  */
 struct GetRetroactiveHgEventsParams {
   1: PathString mountPoint;
+  // If set, only return the events of the imports caused by this filesystem
+  // request. See HgEvent.requestId.
+  2: optional i64 requestId;
 }
 
 /**
@@ -1079,6 +1124,31 @@ struct GetRetroactiveHgEventsResult {
   1: list<HgEvent> events;
 }
 
+/**
+ * The number of objects imported under a directory, in the result of
+ * getFetchHeatmap().
+ */
+struct DirectoryFetchCount {
+  1: PathString directory;
+  // Imports of the objects under this directory, up to the configured
+  // hg:fetch-heatmap-max-depth levels below it.
+  2: i64 fetchCount;
+  // fetchCount overestimates the imports by at most this much, for
+  // directories which were not always counted.
+  3: i64 error;
+}
+
+struct GetFetchHeatmapParams {
+  1: PathString mountPoint;
+  // The maximum number of directories to return.
+  2: i64 count;
+}
+
+struct GetFetchHeatmapResult {
+  // The directories imported from the most, from the most imported.
+  1: list<DirectoryFetchCount> directories;
+}
+
 enum InodeType {
   TREE = 0,
   FILE = 1,
@@ -1149,6 +1219,13 @@ struct FuseCall {
   9: optional string processName;
 }
 
+struct SlowFuseCall {
+  1: FuseCall call;
+  2: i64 durationNs;
+  // The response code sent to the kernel, if any: negative for errors.
+  3: optional i64 result;
+}
+
 struct NfsCall {
   1: i32 xid;
   2: i32 procNumber;
@@ -1195,6 +1272,26 @@ struct ThriftRequestMetadata {
   3: pid_t clientPid;
 }
 
+/**
+ * The work done by one of the most expensive glob requests.
+ */
+struct ExpensiveGlob {
+  // The patterns and parameters of the request.
+  1: string request;
+  // 0 if the client is unknown.
+  2: pid_t clientPid;
+  3: binary clientCmdline;
+  4: i64 directoriesVisited;
+  // Trees read from the in-memory or on-disk caches.
+  5: i64 treesFromCache;
+  // Trees fetched from the backing store.
+  6: i64 treesFromBackingStore;
+  7: i64 entriesMatched;
+  // Time spent matching the entries of the directories.
+  8: i64 matchingTimeUs;
+  9: i64 durationUs;
+}
+
 struct GetConfigParams {
   // Whether to reload the config from disk to make sure it is up-to-date
   1: eden_config.ConfigReloadBehavior reload = eden_config.ConfigReloadBehavior.AutoReload;
@@ -1295,6 +1392,19 @@ struct PrefetchParams {
   7: optional PredictiveFetch predictiveGlob;
 }
 
+struct PrefetchRootTreesParams {
+  1: PathString mountPoint;
+  // The commits whose root trees should be fetched, for instance the heads
+  // that were just pulled.
+  2: list<ThriftRootId> revisions;
+  // The hg root manifests of revisions, in the same order, if known. Either
+  // empty or as long as revisions. Providing them saves EdenFS from resolving
+  // each commit through the import helper.
+  3: list<BinaryHash> hgRootManifests;
+  // If set, will run the prefetch but will not wait for the result.
+  4: bool background = false;
+}
+
 /** Params for globFiles(). */
 struct GlobParams {
   1: PathString mountPoint;
@@ -1335,6 +1445,25 @@ struct GlobParams {
   13: SyncBehavior sync;
 }
 
+/** Params for globFilesInRepo(). */
+struct GlobRepoParams {
+  // The type of the repository, as in the checkout configs: "hg" or "git".
+  1: string repoType;
+  // The path of the repository, as the backingRepoPath of its checkouts.
+  2: PathString repoPath;
+  3: list<string> globs;
+  4: bool includeDotfiles;
+  5: bool wantDtype;
+  // Commit hashes for the revisions against which the globs should be
+  // evaluated. Unlike for globFiles, this must not be empty.
+  6: list<ThriftRootId> revisions;
+  // The directory from which the glob should be evaluated. Defaults to the
+  // repository root.
+  7: PathString searchRoot;
+  // If true, only files, and not directories, are returned.
+  8: bool listOnlyFiles = false;
+}
+
 struct Glob {
   /**
    * matchingFiles can contain duplicate values and is not guaranteed to be
@@ -1402,6 +1531,19 @@ struct TracePoint {
   7: i64 threadId;
 }
 
+/**
+ * Parameters for the startChromeTrace() function.
+ */
+struct StartChromeTraceParams {
+  1: PathString mountPoint;
+  // The file the trace is written to. The previous part of the trace is kept
+  // next to it, with a ".1" suffix.
+  2: PathString outputPath;
+  // The size in bytes after which the trace moves to a new file. 0 selects a
+  // default of 100 MB.
+  3: i64 maxFileSize;
+}
+
 struct FaultDefinition {
   1: string keyClass;
   2: string keyValueRegex;
@@ -1515,6 +1657,33 @@ struct CheckOutRevisionParams {
   1: optional BinaryHash hgRootManifest;
 }
 
+struct EstimateCheckoutParams {
+  1: PathString mountPoint;
+  // The commit that would be checked out.
+  2: ThriftRootId snapshotHash;
+}
+
+/**
+ * The work that checking out a commit would do. See estimateCheckout().
+ */
+struct EstimateCheckoutResult {
+  // Files and symlinks that differ between the current and the new commit.
+  1: i64 changedFiles;
+  // Changed files that exist in the new commit. Checkout itself does not fetch
+  // their contents, but reading all of them afterwards would. EdenFS cannot
+  // tell which of them are already cached without fetching them.
+  2: i64 blobsToFetch;
+  // Source control trees that differ between the two commits and were not
+  // available locally. Computing the estimate fetched them.
+  3: i64 treesFetched;
+  // Changed files whose inode is loaded. Checkout updates these one by one,
+  // which is much slower than replacing unloaded directories.
+  4: i64 loadedInodesAffected;
+  // Changed files with local modifications, or inside a modified directory
+  // that is not loaded. Each of these may be reported as a conflict.
+  5: i64 materializedConflicts;
+}
+
 struct ResetParentCommitsParams {
   /**
    * The hg root manifest that corresponds to the commit (if known).
@@ -1571,7 +1740,9 @@ struct ChangeOwnershipRequest {
 struct ChangeOwnershipResponse {}
 
 service EdenService extends fb303_core.BaseService {
-  list<MountInfo> listMounts() throws (1: EdenError ex);
+  list<MountInfo> listMounts() throws (1: EdenError ex) (
+    priority = 'IMPORTANT',
+  );
   void mount(1: MountArgument info) throws (1: EdenError ex);
   void unmount(1: PathString mountPoint) throws (1: EdenError ex);
 
@@ -1606,6 +1777,19 @@ service EdenService extends fb303_core.BaseService {
     4: CheckOutRevisionParams params,
   ) throws (1: EdenError ex);
 
+  /**
+   * Estimate the work that checkOutRevision() would do to check out
+   * snapshotHash, without modifying the working copy.
+   *
+   * This diffs the source control trees of the current and the new commit, so
+   * it fetches the trees that differ between them, which also speeds up a
+   * subsequent checkout. Tools can use the result to prefetch files with
+   * prefetchFiles() or to defer large checkouts.
+   */
+  EstimateCheckoutResult estimateCheckout(
+    1: EstimateCheckoutParams params,
+  ) throws (1: EdenError ex);
+
   /**
    * Reset the working directory's parent commits, without changing the working
    * directory contents.
@@ -1717,7 +1901,7 @@ service EdenService extends fb303_core.BaseService {
    */
   JournalPosition getCurrentJournalPosition(1: PathString mountPoint) throws (
     1: EdenError ex,
-  );
+  ) (priority = 'IMPORTANT');
 
   /** Returns the set of files (and dirs) that changed since a prior point.
    * If fromPosition.mountGeneration is mismatched with the current
@@ -1810,6 +1994,16 @@ service EdenService extends fb303_core.BaseService {
     1: GetAttributesFromFilesParams params,
   ) throws (1: EdenError ex);
 
+  /**
+   * Same as getAttributesFromFilesV2, but with the attributes of all the
+   * paths laid out in columns rather than in a struct per path. This is much
+   * cheaper to encode and decode when asking about many thousands of paths,
+   * such as the whole input set of a build.
+   */
+  GetAttributesFromFilesColumnarResult getAttributesFromFilesColumnar(
+    1: GetAttributesFromFilesParams params,
+  ) throws (1: EdenError ex);
+
   /**
    * DEPRECATED - prefer getAttributesFromFilesV2.
    *
@@ -1862,6 +2056,14 @@ service EdenService extends fb303_core.BaseService {
    */
   Glob globFiles(1: GlobParams params) throws (1: EdenError ex);
 
+  /**
+   * Evaluate the globs against commits of a repository, reading their trees
+   * from source control rather than from a checkout, so that the repository
+   * does not need to be mounted, nor the commits checked out.
+   * There are no duplicate values in the result.
+   */
+  Glob globFilesInRepo(1: GlobRepoParams params) throws (1: EdenError ex);
+
   /**
    * Has the same behavior as globFiles, but should be called in the case of a prefetch.
    * This request could be deprioritized since it will be assumed that this call is used
@@ -1872,6 +2074,17 @@ service EdenService extends fb303_core.BaseService {
     priority = 'BEST_EFFORT',
   );
 
+  /**
+   * Resolve the given commits to their root trees and fetch them, so that a
+   * later checkout of, or status against, one of them starts right away.
+   * The mapping from commit to root tree is persisted in the LocalStore.
+   *
+   * Meant to be called after pulling new commits.
+   */
+  void prefetchRootTrees(1: PrefetchRootTreesParams params) throws (
+    1: EdenError ex,
+  ) (priority = 'BEST_EFFORT');
+
   /**
    * Gets a list of a user's most accessed directories, performs
    * prefetching as specified by PredictiveGlobParams, and returns
@@ -1971,7 +2184,7 @@ service EdenService extends fb303_core.BaseService {
    * getDaemonInfo instead. This method exists for Thrift clients that
    * predate getDaemonInfo, such as older versions of the CLI.
    */
-  i64 getPid() throws (1: EdenError ex);
+  i64 getPid() throws (1: EdenError ex) (priority = 'IMPORTANT');
 
   /**
    * Ask the server to shutdown and provide it some context for its logs
@@ -2076,6 +2289,15 @@ service EdenService extends fb303_core.BaseService {
    */
   list<FuseCall> debugOutstandingFuseCalls(1: PathString mountPoint);
 
+  /**
+   * Get the slowest fuse requests that completed since the mount was started,
+   * from the slowest to the fastest.
+   *
+   * The latency distribution of each opcode is available from the fuse.*_us
+   * counters; this is for finding out what the outliers were.
+   */
+  list<SlowFuseCall> debugSlowestFuseCalls(1: PathString mountPoint);
+
   /**
    * Get the list of outstanding NFS requests
    *
@@ -2096,6 +2318,13 @@ service EdenService extends fb303_core.BaseService {
    */
   list<ThriftRequestMetadata> debugOutstandingThriftRequests();
 
+  /**
+   * Get the most expensive glob requests since EdenFS started, by number of
+   * directories visited, from the most expensive to the least. Empty if
+   * glob:cost-log-size is 0.
+   */
+  list<ExpensiveGlob> debugGetExpensiveGlobs() throws (1: EdenError ex);
+
   /**
    * Start recording performance metrics such as files read
    *
@@ -2259,6 +2488,20 @@ service EdenService extends fb303_core.BaseService {
   void disableTracing();
   list<TracePoint> getTracePoints();
 
+  /**
+   * Write a timeline of the activity of a mount to a file in the Chrome
+   * trace event format, viewable in chrome://tracing or the Perfetto UI,
+   * until stopChromeTrace is called. It covers the filesystem requests, the
+   * inode loads and materializations, the source control imports, and the
+   * TaskTrace blocks, including the stages of checkouts.
+   *
+   * Starting a trace for a mount that already has one replaces it.
+   */
+  void startChromeTrace(1: StartChromeTraceParams params) throws (
+    1: EdenError ex,
+  );
+  void stopChromeTrace(1: PathString mountPoint) throws (1: EdenError ex);
+
   /**
    * Gets a list of thrift request events stored on the thrift server's ActivityBuffer.
    * Used for retroactive debugging by the `eden trace thrift --retroactive` command.
@@ -2275,6 +2518,15 @@ service EdenService extends fb303_core.BaseService {
     1: GetRetroactiveHgEventsParams params,
   ) throws (1: EdenError ex);
 
+  /**
+   * Gets the directories under which the most objects were imported from hg
+   * since EdenFS started, to plan which directories to prefetch. Only the
+   * imports which missed the local store are counted.
+   */
+  GetFetchHeatmapResult getFetchHeatmap(
+    1: GetFetchHeatmapParams params,
+  ) throws (1: EdenError ex);
+
   /**
    * Gets a list of inode events stored in a specified EdenMount's
    * ActivityBuffer. Used for retroactive debugging by the `eden trace inode
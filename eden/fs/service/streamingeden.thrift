@@ -88,6 +88,16 @@ struct ChangesSinceResult {
 struct StreamChangesSinceParams {
   1: eden.PathString mountPoint;
   2: eden.JournalPosition fromPosition;
+  // If set, only the changes to files under this directory are returned.
+  // Defaults to the repository root.
+  3: eden.PathString root;
+}
+
+/**
+ * Return value of the streamScmStatus.
+ */
+struct StreamScmStatusResult {
+  1: string version;
 }
 
 struct TraceTaskEventsRequest {}
@@ -105,13 +115,15 @@ service StreamingEdenService extends eden.EdenService {
    * Request notification about changes to the journal for
    * the specified mountPoint.
    *
-   * IMPORTANT: Do not use the JournalPosition values in the stream. They are
-   * meaningless. Instead, call getFilesChangedSince or
-   * getCurrentJournalPosition which will return up-to-date information and
-   * unblock future notifications on this subscription. If the subscriber
-   * never calls getFilesChangedSince or getCurrentJournalPosition in
-   * response to a notification on this stream, future notifications may not
-   * arrive.
+   * Each JournalPosition in the stream is the position of the journal when it
+   * was sent. Call getFilesChangedSince to get the changes up to it, which
+   * will also unblock future notifications on this subscription. If the
+   * subscriber never calls getFilesChangedSince or getCurrentJournalPosition
+   * in response to a notification on this stream, future notifications may
+   * not arrive.
+   *
+   * Notifications are at least thrift:journal-notification-interval apart,
+   * the changes made in between being coalesced in the next one.
    *
    * This is an implementation of the subscribe API using the
    * new rsocket based streaming thrift protocol.
@@ -188,6 +200,36 @@ service StreamingEdenService extends eden.EdenService {
     1: eden.EdenError ex,
   );
 
+  /**
+   * Same as getScmStatusV2, but the status is streamed in chunks as it is
+   * computed instead of being returned once complete. Each chunk holds at most
+   * hg:status-stream-chunk-size entries and errors, and the status is the union
+   * of all of the chunks. A path may be reported in more than one chunk, in
+   * which case the first status reported for it is the one getScmStatusV2
+   * would return.
+   *
+   * Closing the stream cancels the status computation.
+   */
+  StreamScmStatusResult, stream<
+    eden.ScmStatus throws (1: eden.EdenError ex)
+  > streamScmStatus(1: eden.GetScmStatusParams params) throws (
+    1: eden.EdenError ex,
+  );
+
+  /**
+   * Same as globFiles, but the matching files are streamed in chunks as they
+   * are found instead of being returned once the whole glob is evaluated. Each
+   * chunk holds at least glob:stream-chunk-size files, except for the last
+   * one. Files are reported in no particular order, and a file matched in
+   * several revisions may be reported more than once. The stream ends once the files to prefetch, if any, are fetched.
+   *
+   * The background parameter is ignored: the glob is always evaluated in
+   * the background of the stream.
+   */
+  stream<eden.Glob throws (1: eden.EdenError ex)> streamGlobFiles(
+    1: eden.GlobParams params,
+  ) throws (1: eden.EdenError ex);
+
   /**
    * Returns the basic status from EdenFS as one would get from getDaemonInfo
    * and a stream of updates of the EdenFS startup process if EdenFS is
@@ -6,10 +6,13 @@
  */
 
 #include <folly/portability/GTest.h>
+#include <algorithm>
 #include <cstddef>
 #include <memory>
 
+#include "eden/fs/inodes/GlobCostLog.h"
 #include "eden/fs/inodes/InodeMap.h"
+#include "eden/fs/inodes/ServerState.h"
 #include "eden/fs/service/ThriftGlobImpl.h"
 #include "eden/fs/service/gen-cpp2/eden_types.h"
 #include "eden/fs/store/ObjectFetchContext.h"
@@ -75,4 +78,103 @@ TEST(ThriftGlobImplTest, testGlobFilesNotLoadingInode) {
   // - foo/bar/dir2/file.txt
   assertInodeCounters(inodeMap, loaded + 6, unloaded);
 }
+
+TEST(ThriftGlobImplTest, testStreamGlobInChunks) {
+  auto serverState = createTestServerState();
+  FakeTreeBuilder builder;
+  builder.setFile("a/file.txt", "contents");
+  builder.setFile("b/file.txt", "contents");
+  builder.setFile("b/c/file.txt", "contents");
+  builder.setFile("b/c/other.cpp", "contents");
+  TestMount mount{builder};
+  auto edenMount = mount.getEdenMount();
+
+  std::vector<std::vector<std::string>> chunks;
+  auto globber = ThriftGlobImpl{GlobParams{}};
+  globber
+      .streamGlob(
+          edenMount,
+          serverState,
+          std::vector<std::string>{"**/*.txt"},
+          ObjectFetchContext::getNullContext(),
+          1,
+          [&chunks](Glob&& chunk) {
+            chunks.push_back(std::move(*chunk.matchingFiles_ref()));
+          })
+      .get();
+
+  // Each directory adds its own chunk.
+  ASSERT_EQ(3, chunks.size());
+  std::vector<std::string> files;
+  for (auto& chunk : chunks) {
+    EXPECT_EQ(1, chunk.size());
+    files.insert(files.end(), chunk.begin(), chunk.end());
+  }
+  std::sort(files.begin(), files.end());
+  EXPECT_EQ(
+      (std::vector<std::string>{"a/file.txt", "b/c/file.txt", "b/file.txt"}),
+      files);
+}
+
+TEST(ThriftGlobImplTest, testGlobCostIsRecorded) {
+  FakeTreeBuilder builder;
+  builder.setFile("a/file.txt", "contents");
+  builder.setFile("b/file.txt", "contents");
+  builder.setFile("b/other.cpp", "contents");
+  TestMount mount{builder};
+  const auto& costLog = mount.getServerState()->getGlobCostLog();
+  ASSERT_TRUE(costLog);
+
+  auto globber = ThriftGlobImpl{GlobParams{}};
+  globber
+      .glob(
+          mount.getEdenMount(),
+          mount.getServerState(),
+          std::vector<std::string>{"**/*.txt"},
+          ObjectFetchContext::getNullContext())
+      .get();
+
+  auto costs = costLog->getMostExpensive();
+  ASSERT_EQ(1, costs.size());
+  EXPECT_EQ(globber.logString({"**/*.txt"}), costs[0].request);
+  // The root, a and b.
+  EXPECT_EQ(3, costs[0].directoriesVisited);
+  EXPECT_EQ(2, costs[0].entriesMatched);
+}
+
+TEST(ThriftGlobImplTest, testGlobTreesWithoutMount) {
+  FakeTreeBuilder builder;
+  builder.setFile("a/file.txt", "contents");
+  builder.setFile("b/c/file.txt", "contents");
+  builder.setFile("b/c/other.cpp", "contents");
+  TestMount mount{builder};
+  auto edenMount = mount.getEdenMount();
+  const auto& objectStore = edenMount->getObjectStore();
+
+  GlobRepoParams params;
+  params.revisions_ref()->push_back(
+      objectStore->renderRootId(edenMount->getCheckedOutRootId()));
+  params.searchRoot_ref() = "b";
+  auto globber = ThriftGlobImpl{params};
+  auto globFuture = globber.globTrees(
+      objectStore,
+      mount.getServerState(),
+      std::vector<std::string>{"**/*.txt"},
+      ObjectFetchContext::getNullContext());
+  // The trees are walked on the server executor.
+  while (!globFuture.isReady()) {
+    mount.drainServerExecutor();
+  }
+  auto result = std::move(globFuture).get();
+  EXPECT_EQ(
+      std::vector<std::string>{"c/file.txt"}, *result->matchingFiles_ref());
+
+  // Without revisions there is nothing to evaluate the globs against.
+  auto noRevisions = ThriftGlobImpl{GlobRepoParams{}}.globTrees(
+      objectStore,
+      mount.getServerState(),
+      std::vector<std::string>{"**/*.txt"},
+      ObjectFetchContext::getNullContext());
+  EXPECT_THROW(std::move(noRevisions).get(), EdenError);
+}
 } // namespace facebook::eden
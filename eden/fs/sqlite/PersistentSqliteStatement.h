@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <folly/Conv.h>
+
 #include "eden/fs/sqlite/SqliteConnection.h"
 #include "eden/fs/sqlite/SqliteStatement.h"
 
@@ -87,4 +89,39 @@ class PersistentSqliteStatement {
  private:
   SqliteStatement stmt_;
 };
+
+/**
+ * Obtain the statement for `sql` from the per-connection cache of the locked
+ * connection, preparing it the first time it is used on that connection.
+ *
+ * This is meant for queries whose text is only known at runtime, such as
+ * those naming a table, and that aren't worth a dedicated
+ * `PersistentSqliteStatement` member.
+ */
+inline PersistentSqliteStatement::Guard getCachedStatement(
+    LockedSqliteConnection& db,
+    std::string sql) {
+  auto& stmt = db->statements[sql];
+  if (!stmt) {
+    stmt = std::make_unique<PersistentSqliteStatement>(db, sql);
+  }
+  return stmt->get(db);
+}
+
+/**
+ * Convenience overload that joins the arguments into the query string.
+ */
+template <typename Arg1, typename Arg2, typename... Args>
+PersistentSqliteStatement::Guard getCachedStatement(
+    LockedSqliteConnection& db,
+    Arg1&& first,
+    Arg2&& second,
+    Args&&... args) {
+  return getCachedStatement(
+      db,
+      folly::to<std::string>(
+          std::forward<Arg1>(first),
+          std::forward<Arg2>(second),
+          std::forward<Args>(args)...));
+}
 } // namespace facebook::eden
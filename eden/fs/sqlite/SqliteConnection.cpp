@@ -0,0 +1,21 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/sqlite/SqliteConnection.h"
+
+#include "eden/fs/sqlite/PersistentSqliteStatement.h"
+
+namespace facebook::eden {
+
+// Defined here, where PersistentSqliteStatement is a complete type.
+SqliteConnection::SqliteConnection() = default;
+SqliteConnection::~SqliteConnection() = default;
+SqliteConnection::SqliteConnection(SqliteConnection&&) noexcept = default;
+SqliteConnection& SqliteConnection::operator=(SqliteConnection&&) noexcept =
+    default;
+
+} // namespace facebook::eden
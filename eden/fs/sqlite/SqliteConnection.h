@@ -10,14 +10,31 @@
 #include <sqlite3.h>
 
 #include <folly/Synchronized.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
 
 namespace facebook::eden {
 
+class PersistentSqliteStatement;
+
 enum class SqliteDbStatus { NOT_YET_OPENED, FAILED_TO_OPEN, OPEN, CLOSED };
 
 struct SqliteConnection {
+  SqliteConnection();
+  ~SqliteConnection();
+  SqliteConnection(SqliteConnection&&) noexcept;
+  SqliteConnection& operator=(SqliteConnection&&) noexcept;
+
   sqlite3* db{nullptr};
   SqliteDbStatus status{SqliteDbStatus::NOT_YET_OPENED};
+
+  /**
+   * The statements prepared with `getCachedStatement`, keyed by their SQL
+   * text. They must be cleared before `db` is closed.
+   */
+  std::unordered_map<std::string, std::unique_ptr<PersistentSqliteStatement>>
+      statements;
 };
 
 using LockedSqliteConnection = folly::Synchronized<SqliteConnection>::LockedPtr;
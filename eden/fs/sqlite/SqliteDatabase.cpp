@@ -8,20 +8,40 @@
 #include "eden/fs/sqlite/SqliteDatabase.h"
 
 #include <folly/logging/xlog.h>
+#include <thread>
+
 #include "eden/fs/sqlite/PersistentSqliteStatement.h"
 
 namespace facebook::eden {
-struct SqliteDatabase::StatementCache {
-  explicit StatementCache(LockedSqliteConnection& conn)
-      : beginTransaction{conn, "BEGIN"},
-        commitTransaction{conn, "COMMIT"},
-        rollbackTransaction{conn, "ROLLBACK"} {}
-
-  PersistentSqliteStatement beginTransaction;
-  PersistentSqliteStatement commitTransaction;
-  PersistentSqliteStatement rollbackTransaction;
-};
+namespace {
+void checkOpen(const SqliteConnection& conn) {
+  switch (conn.status) {
+    case SqliteDbStatus::OPEN:
+      return;
+    case SqliteDbStatus::NOT_YET_OPENED:
+      throw std::runtime_error(
+          "the SqliteDatabase database has not yet been opened");
+    case SqliteDbStatus::FAILED_TO_OPEN:
+      throw std::runtime_error(
+          "the SqliteDatabase database failed to be opened");
+    case SqliteDbStatus::CLOSED:
+      throw std::runtime_error(
+          "the SqliteDatabase database has already been closed");
+  }
+}
 
+void closeConnection(SqliteConnection& conn) {
+  conn.status = SqliteDbStatus::CLOSED;
+  // We must clear the cached statements before closing the database.
+  // Otherwise `sqlite3_close` will fail with `SQLITE_BUSY`. This rule applies
+  // to any statement cache elsewhere too.
+  conn.statements.clear();
+  if (conn.db) {
+    sqlite3_close(conn.db);
+    conn.db = nullptr;
+  }
+}
+} // namespace
 void checkSqliteResult(sqlite3* db, int result) {
   if (result == SQLITE_OK) {
     return;
@@ -45,7 +65,7 @@ void checkSqliteResult(sqlite3* db, int result) {
 }
 
 SqliteDatabase::SqliteDatabase(AbsolutePathPiece path, DelayOpeningDB)
-    : dbPath_(path.copy().value()), conn_{}, cache_{nullptr} {}
+    : dbPath_(path.copy().value()), conn_{} {}
 
 SqliteDatabase::SqliteDatabase(std::string addr)
     : dbPath_(std::move(addr)), conn_{} {
@@ -76,21 +96,41 @@ void SqliteDatabase::openDb() {
   }
 
   lockedState->db = db;
+}
 
-  cache_ = std::make_unique<StatementCache>(lockedState);
+void SqliteDatabase::openReadConnections(
+    size_t count,
+    const std::function<void(LockedSqliteConnection&)>& initialize) {
+  checkOpen(*conn_.rlock());
+  if (dbPath_ == ":memory:") {
+    return;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    auto reader = std::make_unique<folly::Synchronized<SqliteConnection>>();
+    auto conn = reader->wlock();
+    sqlite3* db = nullptr;
+    auto result = sqlite3_open_v2(
+        dbPath_.c_str(), &db, SQLITE_OPEN_READONLY, nullptr);
+    if (result != SQLITE_OK) {
+      // @lint-ignore CLANGTIDY
+      sqlite3_close(db);
+      checkSqliteResult(nullptr, result);
+    }
+    conn->db = db;
+    conn->status = SqliteDbStatus::OPEN;
+    if (initialize) {
+      initialize(conn);
+    }
+    conn.unlock();
+    readers_.push_back(std::move(reader));
+  }
 }
 
 void SqliteDatabase::close() {
-  auto db = conn_.wlock();
-  db->status = SqliteDbStatus::CLOSED;
-  // We must clear the cached statement before closing the database. Otherwise
-  // `sqlite3_close` will fail with `SQLITE_BUSY`. This rule applies to any
-  // statement cache elsewhere too.
-  cache_.reset();
-  if (db->db) {
-    sqlite3_close(db->db);
-    db->db = nullptr;
+  for (auto& reader : readers_) {
+    closeConnection(*reader->wlock());
   }
+  closeConnection(*conn_.wlock());
 }
 
 SqliteDatabase::~SqliteDatabase() {
@@ -99,19 +139,26 @@ SqliteDatabase::~SqliteDatabase() {
 
 LockedSqliteConnection SqliteDatabase::lock() {
   auto db = conn_.wlock();
-  switch (db->status) {
-    case SqliteDbStatus::OPEN:
-      break;
-    case SqliteDbStatus::NOT_YET_OPENED:
-      throw std::runtime_error(
-          "the SqliteDatabase database has not yet been opened");
-    case SqliteDbStatus::FAILED_TO_OPEN:
-      throw std::runtime_error(
-          "the SqliteDatabase database failed to be opened");
-    case SqliteDbStatus::CLOSED:
-      throw std::runtime_error(
-          "the SqliteDatabase database has already been closed");
+  checkOpen(*db);
+  return db;
+}
+
+LockedSqliteConnection SqliteDatabase::lockRead() {
+  if (readers_.empty()) {
+    return lock();
+  }
+  // Start from a slot that depends on the calling thread, so that threads
+  // spread over the connections and keep reusing the same statements.
+  auto start = std::hash<std::thread::id>{}(std::this_thread::get_id());
+  for (size_t i = 0; i < readers_.size(); ++i) {
+    auto& reader = readers_[(start + i) % readers_.size()];
+    if (auto db = reader->tryWLock()) {
+      checkOpen(*db);
+      return db;
+    }
   }
+  auto db = readers_[start % readers_.size()]->wlock();
+  checkOpen(*db);
   return db;
 }
 
@@ -119,11 +166,11 @@ void SqliteDatabase::transaction(
     const std::function<void(LockedSqliteConnection&)>& func) {
   auto conn = lock();
   try {
-    cache_->beginTransaction.get(conn)->step();
+    getCachedStatement(conn, "BEGIN")->step();
     func(conn);
-    cache_->commitTransaction.get(conn)->step();
+    getCachedStatement(conn, "COMMIT")->step();
   } catch (const std::exception& ex) {
-    cache_->rollbackTransaction.get(conn)->step();
+    getCachedStatement(conn, "ROLLBACK")->step();
     XLOG(WARN) << "SQLite transaction failed: " << ex.what();
     throw;
   }
@@ -9,6 +9,9 @@
 
 #include <folly/Synchronized.h>
 #include <sqlite3.h>
+#include <functional>
+#include <memory>
+#include <vector>
 
 #include "eden/fs/sqlite/SqliteConnection.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -77,6 +80,27 @@ class SqliteDatabase {
    */
   LockedSqliteConnection lock();
 
+  /**
+   * Open `count` read-only connections to the database, on which `lockRead`
+   * will run queries concurrently with each other and with the writer. This
+   * only helps databases in WAL mode that aren't in exclusive locking mode,
+   * and must be called after `openDb` and after the journal mode has been
+   * set. `initialize` is called once per connection, e.g. to set pragmas.
+   *
+   * In-memory databases can't be shared between connections, so this does
+   * nothing for them.
+   */
+  void openReadConnections(
+      size_t count,
+      const std::function<void(LockedSqliteConnection&)>& initialize = {});
+
+  /**
+   * Obtain a locked connection for read-only queries. This is one of the read
+   * connections if any were opened, preferring one that no other thread is
+   * using, and the same connection as `lock` otherwise.
+   */
+  LockedSqliteConnection lockRead();
+
   /**
    * Executes a SQLite transaction. If the lambda body throws any error, the
    * transaction will be rolled back. This function returns a boolean to
@@ -96,14 +120,16 @@ class SqliteDatabase {
   void checkpoint();
 
  private:
-  struct StatementCache;
-
   explicit SqliteDatabase(std::string address);
 
   std::string dbPath_;
 
   folly::Synchronized<SqliteConnection> conn_;
 
-  std::unique_ptr<StatementCache> cache_;
+  // Read-only connections, see openReadConnections. They are only added
+  // before the database is used, and close closes but keeps them so that
+  // concurrent lockRead calls may still find them.
+  std::vector<std::unique_ptr<folly::Synchronized<SqliteConnection>>>
+      readers_;
 };
 } // namespace facebook::eden
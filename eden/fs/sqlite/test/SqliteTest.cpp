@@ -6,6 +6,7 @@
  */
 
 #include <folly/portability/GTest.h>
+#include <folly/testing/TestUtil.h>
 #include <cstddef>
 #include <memory>
 #include <stdexcept>
@@ -81,4 +82,76 @@ TEST_F(SqliteTest, testPersistentSqliteStatement) {
     exec->step();
   }
 }
+
+TEST_F(SqliteTest, testCachedStatement) {
+  auto conn = db.lock();
+  SqliteStatement* first;
+  {
+    auto stmt = getCachedStatement(conn, "SELECT ", 1);
+    first = &*stmt;
+    ASSERT_TRUE(stmt->step());
+    ASSERT_EQ(stmt->columnUint64(0), 1);
+  }
+  {
+    // The same statement is reused, and was reset by the previous guard.
+    auto stmt = getCachedStatement(conn, "SELECT 1");
+    ASSERT_EQ(&*stmt, first);
+    ASSERT_TRUE(stmt->step());
+    ASSERT_EQ(stmt->columnUint64(0), 1);
+  }
+  ASSERT_NE(&*getCachedStatement(conn, "SELECT 2"), first);
+}
+
+TEST_F(SqliteTest, testTransactionRollsBack) {
+  db.transaction([](auto& conn) {
+    SqliteStatement(conn, "CREATE TABLE test (id INTEGER)").step();
+  });
+  ASSERT_THROW(
+      db.transaction([](auto& conn) {
+        SqliteStatement(conn, "INSERT INTO test VALUES (1)").step();
+        throw std::runtime_error("failed");
+      }),
+      std::runtime_error);
+
+  auto conn = db.lock();
+  SqliteStatement stmt{conn, "SELECT COUNT(*) FROM test"};
+  ASSERT_TRUE(stmt.step());
+  ASSERT_EQ(stmt.columnUint64(0), 0);
+}
+
+TEST_F(SqliteTest, testLockReadWithoutReadConnections) {
+  db.openReadConnections(2);
+  auto conn = db.lockRead();
+  SqliteStatement stmt{conn, "SELECT 1"};
+  ASSERT_TRUE(stmt.step());
+}
+
+TEST(SqliteReadConnectionsTest, readersSeeCommittedWrites) {
+  folly::test::TemporaryDirectory dir;
+  SqliteDatabase db{canonicalPath((dir.path() / "db").string())};
+  {
+    auto conn = db.lock();
+    SqliteStatement(conn, "PRAGMA journal_mode=WAL").step();
+    SqliteStatement(conn, "CREATE TABLE test (id INTEGER)").step();
+  }
+  db.openReadConnections(2);
+
+  db.transaction([](auto& conn) {
+    for (int64_t id = 0; id < 3; ++id) {
+      auto stmt = getCachedStatement(conn, "INSERT INTO test VALUES (?)");
+      stmt->bind(1, id);
+      stmt->step();
+    }
+  });
+
+  auto reader = db.lockRead();
+  {
+    auto stmt = getCachedStatement(reader, "SELECT COUNT(*) FROM test");
+    ASSERT_TRUE(stmt->step());
+    ASSERT_EQ(stmt->columnUint64(0), 3);
+  }
+  ASSERT_THROW(
+      SqliteStatement(reader, "INSERT INTO test VALUES (4)").step(),
+      std::runtime_error);
+}
 } // namespace facebook::eden
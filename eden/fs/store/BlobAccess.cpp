@@ -7,6 +7,7 @@
 
 #include "eden/fs/store/BlobAccess.h"
 #include <folly/MapUtil.h>
+#include <folly/io/Cursor.h>
 #include "eden/fs/model/Blob.h"
 #include "eden/fs/store/BlobCache.h"
 #include "eden/fs/store/IObjectStore.h"
@@ -14,6 +15,21 @@
 
 namespace facebook::eden {
 
+namespace {
+BlobCache::RangeResult
+sliceBlob(const Blob& blob, size_t offset, size_t length) {
+  folly::io::Cursor cursor{&blob.getContents()};
+  if (!cursor.canAdvance(offset)) {
+    return BlobCache::RangeResult{folly::IOBuf::create(0), true};
+  }
+  cursor.skip(offset);
+
+  std::unique_ptr<folly::IOBuf> data;
+  cursor.cloneAtMost(data, length);
+  return BlobCache::RangeResult{std::move(data), cursor.isAtEnd()};
+}
+} // namespace
+
 BlobAccess::BlobAccess(
     std::shared_ptr<IObjectStore> objectStore,
     std::shared_ptr<BlobCache> blobCache)
@@ -41,4 +57,36 @@ folly::Future<BlobCache::GetResult> BlobAccess::getBlob(
       .via(&folly::QueuedImmediateExecutor::instance());
 }
 
+folly::Future<BlobCache::RangeResult> BlobAccess::getBlobRange(
+    const ObjectId& hash,
+    size_t offset,
+    size_t length,
+    const ObjectFetchContextPtr& context) {
+  if (auto result = blobCache_->get(hash); result.object) {
+    return folly::Future<BlobCache::RangeResult>{
+        sliceBlob(*result.object, offset, length)};
+  }
+  if (auto range = blobCache_->getRange(hash, offset, length)) {
+    return folly::Future<BlobCache::RangeResult>{std::move(*range)};
+  }
+
+  return objectStore_->getBlob(hash, context)
+      .thenValue([blobCache = blobCache_, hash = hash, offset, length](
+                     std::shared_ptr<const Blob> blob) {
+        if (!blobCache->isChunked(blob->getSize())) {
+          blobCache->insert(hash, blob);
+          return sliceBlob(*blob, offset, length);
+        }
+        // Return the cached chunks rather than a slice of the blob, which
+        // would keep all of it in memory.
+        blobCache->insertRange(hash, *blob, offset, length);
+        if (auto range = blobCache->getRange(hash, offset, length)) {
+          return std::move(*range);
+        }
+        return sliceBlob(*blob, offset, length);
+      })
+      .semi()
+      .via(&folly::QueuedImmediateExecutor::instance());
+}
+
 } // namespace facebook::eden
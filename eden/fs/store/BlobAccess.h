@@ -58,6 +58,19 @@ class BlobAccess {
       const ObjectFetchContextPtr& context,
       BlobCache::Interest interest = BlobCache::Interest::LikelyNeededAgain);
 
+  /**
+   * Loads [offset, offset + length) of the blob, clipped to its size.
+   *
+   * Blobs that the BlobCache caches by chunks are only kept in memory for
+   * the chunks that were read, so that reading a few ranges of a large blob
+   * does not cache all of it.
+   */
+  folly::Future<BlobCache::RangeResult> getBlobRange(
+      const ObjectId& hash,
+      size_t offset,
+      size_t length,
+      const ObjectFetchContextPtr& context);
+
  private:
   BlobAccess(const BlobAccess&) = delete;
   BlobAccess& operator=(const BlobAccess&) = delete;
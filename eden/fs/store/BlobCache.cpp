@@ -6,6 +6,8 @@
  */
 
 #include "eden/fs/store/BlobCache.h"
+#include <folly/io/Cursor.h>
+#include <folly/logging/xlog.h>
 #include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/config/ReloadableConfig.h"
 
@@ -15,11 +17,148 @@ BlobCache::BlobCache(PrivateTag, std::shared_ptr<ReloadableConfig> config)
     : BlobCache{
           PrivateTag{},
           config->getEdenConfig()->inMemoryBlobCacheSize.getValue(),
-          config->getEdenConfig()->inMemoryBlobCacheMinimumItems.getValue()} {}
+          config->getEdenConfig()->inMemoryBlobCacheMinimumItems.getValue(),
+          config->getEdenConfig()->inMemoryBlobCacheShards.getValue(),
+          config->getEdenConfig()->inMemoryBlobCacheEvictionPolicy.getValue(),
+          BlobChunkingOptions{
+              config->getEdenConfig()
+                  ->inMemoryBlobCacheChunkedThreshold.getValue(),
+              config->getEdenConfig()->inMemoryBlobCacheChunkSize.getValue(),
+              config->getEdenConfig()
+                  ->inMemoryBlobCacheChunkedSize.getValue()}} {}
 
-BlobCache::BlobCache(PrivateTag, size_t maximumSize, size_t minimumCount)
+BlobCache::BlobCache(
+    PrivateTag,
+    size_t maximumSize,
+    size_t minimumCount,
+    size_t shardCount,
+    CacheEvictionPolicy policy,
+    BlobChunkingOptions chunking)
     : ObjectCache<Blob, ObjectCacheFlavor::InterestHandle>{
           maximumSize,
-          minimumCount} {}
+          minimumCount,
+          shardCount,
+          policy},
+      chunking_{chunking} {}
+
+std::optional<BlobCache::RangeResult>
+BlobCache::getRange(const ObjectId& id, size_t offset, size_t length) {
+  auto state = chunked_.wlock();
+  auto it = state->blobs.find(id);
+  if (it == state->blobs.end()) {
+    return std::nullopt;
+  }
+  auto& blob = it->second;
+  auto begin = std::min(offset, blob.size);
+  auto end = begin + std::min(length, blob.size - begin);
+  if (!blob.cached.covers(begin, end)) {
+    return std::nullopt;
+  }
+
+  std::unique_ptr<folly::IOBuf> data;
+  auto chunkSize = chunking_.chunkSize;
+  for (auto chunkBegin = begin / chunkSize * chunkSize; chunkBegin < end;
+       chunkBegin += chunkSize) {
+    auto chunk = blob.chunks.at(chunkBegin);
+    state->lru.splice(state->lru.end(), state->lru, chunk);
+
+    auto buf = chunk->data->cloneOne();
+    auto chunkEnd = chunkBegin + buf->length();
+    buf->trimStart(std::max(begin, chunkBegin) - chunkBegin);
+    buf->trimEnd(chunkEnd - std::min(end, chunkEnd));
+    if (data) {
+      data->prependChain(std::move(buf));
+    } else {
+      data = std::move(buf);
+    }
+  }
+  if (!data) {
+    data = folly::IOBuf::create(0);
+  }
+  return RangeResult{std::move(data), end == blob.size};
+}
+
+void BlobCache::insertRange(
+    const ObjectId& id,
+    const Blob& blob,
+    size_t offset,
+    size_t length) {
+  XDCHECK(isChunked(blob.getSize()));
+  auto size = blob.getSize();
+  auto begin = std::min(offset, size);
+  auto end = begin + std::min(length, size - begin);
+  if (begin == end) {
+    return;
+  }
+
+  // Cached chunks are whole, so the gaps between them start on a chunk.
+  auto chunkSize = chunking_.chunkSize;
+  begin = begin / chunkSize * chunkSize;
+  end = std::min(size, (end + chunkSize - 1) / chunkSize * chunkSize);
+  std::vector<std::pair<size_t, size_t>> gaps;
+  {
+    auto state = chunked_.rlock();
+    auto it = state->blobs.find(id);
+    if (it == state->blobs.end()) {
+      gaps.emplace_back(begin, end);
+    } else {
+      gaps = it->second.cached.getGaps(begin, end);
+    }
+  }
+  if (gaps.empty()) {
+    return;
+  }
+
+  // Copy the chunks without holding the lock.
+  std::vector<Chunk> chunks;
+  folly::io::Cursor cursor{&blob.getContents()};
+  size_t position = 0;
+  for (auto [gapBegin, gapEnd] : gaps) {
+    for (auto chunkBegin = gapBegin; chunkBegin < gapEnd;
+         chunkBegin += chunkSize) {
+      auto chunkLength = std::min(chunkSize, size - chunkBegin);
+      auto data = folly::IOBuf::create(chunkLength);
+      cursor.skip(chunkBegin - position);
+      cursor.pull(data->writableData(), chunkLength);
+      data->append(chunkLength);
+      position = chunkBegin + chunkLength;
+      chunks.push_back(Chunk{id, chunkBegin, std::move(data)});
+    }
+  }
+
+  auto state = chunked_.wlock();
+  auto& entry = state->blobs[id];
+  entry.size = size;
+  for (auto& chunk : chunks) {
+    auto chunkBegin = chunk.begin;
+    auto chunkLength = chunk.data->length();
+    // Another thread may have cached it in the meantime.
+    if (entry.chunks.count(chunkBegin)) {
+      continue;
+    }
+    state->lru.push_back(std::move(chunk));
+    entry.chunks.emplace(chunkBegin, std::prev(state->lru.end()));
+    entry.cached.add(chunkBegin, chunkBegin + chunkLength);
+    state->totalSize += chunkLength;
+  }
+  while (state->totalSize > chunking_.maximumSize && !state->lru.empty()) {
+    evictChunk(*state);
+  }
+}
+
+void BlobCache::evictChunk(ChunkedState& state) {
+  auto& chunk = state.lru.front();
+  auto it = state.blobs.find(chunk.id);
+  XDCHECK(it != state.blobs.end());
+  auto& blob = it->second;
+  auto chunkLength = chunk.data->length();
+  blob.cached.remove(chunk.begin, chunk.begin + chunkLength);
+  blob.chunks.erase(chunk.begin);
+  if (blob.chunks.empty()) {
+    state.blobs.erase(it);
+  }
+  state.totalSize -= chunkLength;
+  state.lru.pop_front();
+}
 
 } // namespace facebook::eden
@@ -7,8 +7,15 @@
 
 #pragma once
 
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <folly/io/IOBuf.h>
+#include <list>
+#include <optional>
+
 #include "eden/fs/model/Blob.h"
 #include "eden/fs/store/ObjectCache.h"
+#include "eden/fs/utils/CoverageSet.h"
 
 namespace facebook::eden {
 
@@ -16,6 +23,22 @@ class ReloadableConfig;
 
 using BlobInterestHandle = ObjectInterestHandle<Blob>;
 
+/**
+ * How BlobCache caches large blobs by chunks. See BlobCache::insertRange().
+ */
+struct BlobChunkingOptions {
+  /**
+   * Blobs of at least this many bytes are cached by chunks. 0 disables
+   * chunking.
+   */
+  size_t blobThreshold{0};
+  size_t chunkSize{1024 * 1024};
+  /**
+   * The maximum number of bytes of chunks cached across all chunked blobs.
+   */
+  size_t maximumSize{0};
+};
+
 /**
  * An in-memory LRU cache for loaded blobs. It is parameterized by both a
  * maximum cache size and a minimum entry count. The cache tries to evict
@@ -26,6 +49,11 @@ using BlobInterestHandle = ObjectInterestHandle<Blob>;
  * frequently-accessed large blobs when they are larger than the maximum cache
  * size.
  *
+ * Blobs above a size threshold are instead cached by the chunks that have
+ * been read from them, in a separate LRU of chunks with its own budget. This
+ * keeps partially read multi-gigabyte files from evicting everything else,
+ * and lets their cold chunks be evicted while the hot ones stay cached.
+ *
  * It is safe to use this object from arbitrary threads.
  */
 class BlobCache : public ObjectCache<Blob, ObjectCacheFlavor::InterestHandle> {
@@ -38,12 +66,22 @@ class BlobCache : public ObjectCache<Blob, ObjectCacheFlavor::InterestHandle> {
   }
   static std::shared_ptr<BlobCache> create(
       size_t maximumSize,
-      size_t minimumCount) {
-    return std::make_shared<BlobCache>(PrivateTag{}, maximumSize, minimumCount);
+      size_t minimumCount,
+      size_t shardCount = 1,
+      CacheEvictionPolicy policy = CacheEvictionPolicy::Lru,
+      BlobChunkingOptions chunking = {}) {
+    return std::make_shared<BlobCache>(
+        PrivateTag{}, maximumSize, minimumCount, shardCount, policy, chunking);
   }
 
   explicit BlobCache(PrivateTag, std::shared_ptr<ReloadableConfig> config);
-  explicit BlobCache(PrivateTag, size_t maximumSize, size_t minimumCount);
+  explicit BlobCache(
+      PrivateTag,
+      size_t maximumSize,
+      size_t minimumCount,
+      size_t shardCount = 1,
+      CacheEvictionPolicy policy = CacheEvictionPolicy::Lru,
+      BlobChunkingOptions chunking = {});
   ~BlobCache() = default;
 
   /**
@@ -78,6 +116,85 @@ class BlobCache : public ObjectCache<Blob, ObjectCacheFlavor::InterestHandle> {
       Interest interest = Interest::LikelyNeededAgain) {
     return insertInterestHandle(std::move(id), std::move(blob), interest);
   }
+
+  /**
+   * A range of a blob cached by chunks.
+   */
+  struct RangeResult {
+    std::unique_ptr<folly::IOBuf> data;
+    /// Whether the range extends to the end of the blob.
+    bool eof{false};
+  };
+
+  /**
+   * Returns true if some blobs are cached with insertRange().
+   */
+  bool isChunkingEnabled() const {
+    return chunking_.blobThreshold != 0 && chunking_.chunkSize != 0;
+  }
+
+  /**
+   * Returns true if a blob of this size should be cached with insertRange()
+   * rather than insert().
+   */
+  bool isChunked(size_t blobSize) const {
+    return isChunkingEnabled() && blobSize >= chunking_.blobThreshold;
+  }
+
+  /**
+   * If the cached chunks of the blob cover [offset, offset + length), clipped
+   * to the size of the blob, return that range. The returned buffers share
+   * the cached chunks. Otherwise, return std::nullopt.
+   */
+  std::optional<RangeResult>
+  getRange(const ObjectId& id, size_t offset, size_t length);
+
+  /**
+   * Caches the chunks of the blob that overlap [offset, offset + length).
+   * They are copied out of the blob, so that the rest of it can be freed.
+   * When the chunks exceed their budget, the least recently read ones are
+   * evicted, whichever blob they belong to.
+   */
+  void insertRange(
+      const ObjectId& id,
+      const Blob& blob,
+      size_t offset,
+      size_t length);
+
+  /**
+   * Returns the number of bytes of chunks currently cached.
+   */
+  size_t getChunkedSize() const {
+    return chunked_.rlock()->totalSize;
+  }
+
+ private:
+  struct Chunk {
+    ObjectId id;
+    size_t begin;
+    std::unique_ptr<folly::IOBuf> data;
+  };
+  using ChunkList = std::list<Chunk>;
+
+  struct ChunkedBlob {
+    size_t size{0};
+    /// The bytes held by chunks, always whole chunks.
+    CoverageSet cached;
+    /// Keyed by the offset of the chunk in the blob.
+    folly::F14FastMap<size_t, ChunkList::iterator> chunks;
+  };
+
+  struct ChunkedState {
+    folly::F14NodeMap<ObjectId, ChunkedBlob> blobs;
+    /// All chunks, least recently read first.
+    ChunkList lru;
+    size_t totalSize{0};
+  };
+
+  void evictChunk(ChunkedState& state);
+
+  const BlobChunkingOptions chunking_;
+  folly::Synchronized<ChunkedState> chunked_;
 };
 
 } // namespace facebook::eden
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/BloomFilter.h"
+
+#include <folly/hash/SpookyHashV2.h>
+#include <algorithm>
+#include <cmath>
+
+namespace facebook::eden {
+
+namespace {
+
+// 10 bits per key and 7 probes give a false positive rate of about 1%.
+constexpr size_t kBitsPerKey = 10;
+constexpr size_t kProbeCount = 7;
+// Each probe takes 9 bits of the second hash to address a bit of its block.
+constexpr size_t kProbeBits = 9;
+constexpr uint64_t kProbeMask = (uint64_t{1} << kProbeBits) - 1;
+
+struct KeyHash {
+  uint64_t block;
+  uint64_t probes;
+};
+
+KeyHash hashKey(folly::ByteRange key) {
+  uint64_t h1 = 0;
+  uint64_t h2 = 0;
+  folly::hash::SpookyHashV2::Hash128(key.data(), key.size(), &h1, &h2);
+  return KeyHash{h1, h2};
+}
+
+} // namespace
+
+static_assert(kProbeCount * kProbeBits <= 64);
+
+BloomFilter::BloomFilter(size_t capacity)
+    : blockCount_{std::max<size_t>(
+          1,
+          (capacity * kBitsPerKey + kBitsPerBlock - 1) / kBitsPerBlock)},
+      // Value-initialization zeroes the bits.
+      blocks_{std::make_unique<Block[]>(blockCount_)} {
+  static_assert((uint64_t{1} << kProbeBits) == kBitsPerBlock);
+}
+
+BloomFilter::Block& BloomFilter::getBlock(uint64_t hash) const {
+  return blocks_[hash % blockCount_];
+}
+
+void BloomFilter::insert(folly::ByteRange key) {
+  auto hash = hashKey(key);
+  auto& block = getBlock(hash.block);
+  for (size_t i = 0; i < kProbeCount; ++i) {
+    auto bit = (hash.probes >> (i * kProbeBits)) & kProbeMask;
+    auto& word = block.words[bit / 64];
+    auto mask = uint64_t{1} << (bit % 64);
+    // Most bits are already set once the filter fills up; avoid dirtying the
+    // cache line for them.
+    if ((word.load(std::memory_order_relaxed) & mask) == 0) {
+      word.fetch_or(mask, std::memory_order_relaxed);
+    }
+  }
+  insertCount_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool BloomFilter::mayContain(folly::ByteRange key) const {
+  auto hash = hashKey(key);
+  const auto& block = getBlock(hash.block);
+  for (size_t i = 0; i < kProbeCount; ++i) {
+    auto bit = (hash.probes >> (i * kProbeBits)) & kProbeMask;
+    auto mask = uint64_t{1} << (bit % 64);
+    if ((block.words[bit / 64].load(std::memory_order_relaxed) & mask) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void BloomFilter::clear() {
+  for (size_t i = 0; i < blockCount_; ++i) {
+    for (auto& word : blocks_[i].words) {
+      word.store(0, std::memory_order_relaxed);
+    }
+  }
+  insertCount_.store(0, std::memory_order_relaxed);
+}
+
+size_t BloomFilter::getMemoryUsage() const {
+  return sizeof(*this) + blockCount_ * sizeof(Block);
+}
+
+double BloomFilter::getEstimatedFalsePositiveRate() const {
+  // The classic estimate for an unblocked filter; blocking makes the actual
+  // rate slightly higher.
+  auto bits = static_cast<double>(blockCount_ * kBitsPerBlock);
+  auto keys = static_cast<double>(getInsertCount());
+  return std::pow(1 - std::exp(-(kProbeCount * keys) / bits), kProbeCount);
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <atomic>
+#include <memory>
+
+namespace facebook::eden {
+
+/**
+ * A fixed-size, thread-safe bloom filter over byte strings.
+ *
+ * mayContain() never returns false for a key that was inserted since the last
+ * clear(). It returns true for keys that weren't inserted with a probability
+ * that grows with the number of keys inserted; it is about 1% at the
+ * capacity the filter was sized for.
+ *
+ * The filter is blocked: all the bits of a key fall in the same 64-byte block,
+ * so a lookup touches a single cache line. insert() and mayContain() are
+ * lock-free and can be called concurrently.
+ */
+class BloomFilter {
+ public:
+  /**
+   * Size the filter to hold capacity keys.
+   */
+  explicit BloomFilter(size_t capacity);
+
+  BloomFilter(const BloomFilter&) = delete;
+  BloomFilter& operator=(const BloomFilter&) = delete;
+
+  void insert(folly::ByteRange key);
+
+  bool mayContain(folly::ByteRange key) const;
+
+  /**
+   * Forget every key. Keys inserted concurrently with clear() may be
+   * forgotten as well.
+   */
+  void clear();
+
+  /**
+   * Number of insert() calls since the last clear(), including repeated keys.
+   */
+  size_t getInsertCount() const {
+    return insertCount_.load(std::memory_order_relaxed);
+  }
+
+  size_t getMemoryUsage() const;
+
+  /**
+   * The expected probability of mayContain() returning true for a key that
+   * wasn't inserted, given the number of inserts so far.
+   */
+  double getEstimatedFalsePositiveRate() const;
+
+ private:
+  static constexpr size_t kWordsPerBlock = 8;
+  static constexpr size_t kBitsPerBlock = kWordsPerBlock * 64;
+
+  struct alignas(64) Block {
+    std::atomic<uint64_t> words[kWordsPerBlock];
+  };
+
+  Block& getBlock(uint64_t hash) const;
+
+  const size_t blockCount_;
+  std::unique_ptr<Block[]> blocks_;
+  std::atomic<size_t> insertCount_{0};
+};
+
+} // namespace facebook::eden
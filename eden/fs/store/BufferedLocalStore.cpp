@@ -0,0 +1,365 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/BufferedLocalStore.h"
+
+#include <folly/futures/Future.h>
+#include <folly/logging/xlog.h>
+#include <folly/system/ThreadName.h>
+
+#include "eden/fs/store/StoreResult.h"
+#include "eden/fs/telemetry/EdenStats.h"
+
+namespace facebook::eden {
+
+using folly::ByteRange;
+using folly::StringPiece;
+
+namespace {
+
+template <typename Pending>
+bool isEmpty(const Pending& pending) {
+  for (const auto& map : pending) {
+    if (!map.empty()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+class BufferedLocalStore::BufferedWriteBatch : public LocalStore::WriteBatch {
+ public:
+  BufferedWriteBatch(BufferedLocalStore& store, size_t bufSize)
+      : store_{store}, bufSize_{bufSize} {}
+
+  void put(KeySpace keySpace, ByteRange key, ByteRange value) override {
+    entries_.push_back(
+        Entry{keySpace, StringPiece{key}.str(), StringPiece{value}.str()});
+    size_ += key.size() + value.size();
+    if (bufSize_ > 0 && size_ >= bufSize_) {
+      flush();
+    }
+  }
+
+  void put(KeySpace keySpace, ByteRange key, std::vector<ByteRange> valueSlices)
+      override {
+    std::string value;
+    for (const auto& slice : valueSlices) {
+      value.append(reinterpret_cast<const char*>(slice.data()), slice.size());
+    }
+    put(keySpace, key, StringPiece{value});
+  }
+
+  void flush() override {
+    if (entries_.empty()) {
+      return;
+    }
+    store_.enqueue(std::move(entries_));
+    entries_.clear();
+    size_ = 0;
+  }
+
+ private:
+  BufferedLocalStore& store_;
+  const size_t bufSize_;
+  std::vector<Entry> entries_;
+  size_t size_{0};
+};
+
+BufferedLocalStore::BufferedLocalStore(
+    std::shared_ptr<LocalStore> backingStore,
+    size_t bufferSize,
+    std::chrono::milliseconds flushLatency,
+    EdenStatsPtr edenStats)
+    : LocalStore{std::move(edenStats)},
+      backingStore_{std::move(backingStore)},
+      bufferSize_{bufferSize},
+      flushLatency_{flushLatency} {}
+
+BufferedLocalStore::~BufferedLocalStore() {
+  stopWorkerThread();
+}
+
+void BufferedLocalStore::open() {
+  backingStore_->open();
+
+  auto state = state_.lock();
+  if (state->running) {
+    return;
+  }
+  state->running = true;
+  state->stopRequested = false;
+  workerThread_ = std::thread{[this] {
+    folly::setThreadName("LocalStoreWriter");
+    processOnWorkerThread();
+  }};
+}
+
+void BufferedLocalStore::close() {
+  // Stopping the writer thread writes everything that is still queued, which
+  // must happen before the backing store is closed.
+  stopWorkerThread();
+  backingStore_->close();
+}
+
+void BufferedLocalStore::stopWorkerThread() {
+  {
+    auto state = state_.lock();
+    if (!state->running || state->stopRequested) {
+      return;
+    }
+    state->stopRequested = true;
+    workCV_.notify_one();
+  }
+
+  workerThread_.join();
+
+  auto state = state_.lock();
+  state->running = false;
+  fullCV_.notify_all();
+}
+
+void BufferedLocalStore::processOnWorkerThread() {
+  for (;;) {
+    std::vector<folly::Promise<folly::Unit>> promises;
+    const Pending* inflight = nullptr;
+    bool stop = false;
+    {
+      auto state = state_.lock();
+      // The previous batch has been written, readers can find it in the
+      // backing store now.
+      for (auto& map : state->inflight) {
+        map.clear();
+      }
+
+      workCV_.wait(state.as_lock(), [&] {
+        return !isEmpty(state->waiting) || state->stopRequested ||
+            !state->flushPromises.empty();
+      });
+
+      // Give other writers a chance to join this batch, unless there is a
+      // reason to write right away.
+      auto deadline = std::chrono::steady_clock::now() + flushLatency_;
+      workCV_.wait_until(state.as_lock(), deadline, [&] {
+        return state->totalSize >= bufferSize_ || state->stopRequested ||
+            !state->flushPromises.empty();
+      });
+
+      state->inflight.swap(state->waiting);
+      inflight = &state->inflight;
+      promises.swap(state->flushPromises);
+      stop = state->stopRequested;
+      bool shouldNotify = state->totalSize >= bufferSize_;
+      state->totalSize = 0;
+      if (shouldNotify) {
+        fullCV_.notify_all();
+      }
+      // As with any double buffering, up to twice bufferSize_ bytes can be
+      // held while this batch is written and the next one fills up.
+    }
+
+    write(*inflight);
+
+    for (auto& promise : promises) {
+      promise.setValue(folly::unit);
+    }
+
+    if (stop) {
+      // Nothing is queued once a stop is requested: enqueue() writes through
+      // instead.
+      auto state = state_.lock();
+      for (auto& map : state->inflight) {
+        map.clear();
+      }
+      return;
+    }
+  }
+}
+
+void BufferedLocalStore::write(const Pending& pending) {
+  // The inflight maps are only modified by this thread, so it is safe to read
+  // them without holding the lock.
+  try {
+    auto batch = backingStore_->beginWrite();
+    for (size_t i = 0; i < pending.size(); ++i) {
+      for (const auto& [key, value] : pending[i]) {
+        batch->put(KeySpace::kAll[i], StringPiece{key}, StringPiece{value});
+      }
+    }
+    batch->flush();
+  } catch (const std::exception& ex) {
+    // The LocalStore is a cache of the backing store, so losing a batch only
+    // costs a refetch.
+    XLOG(ERR) << "Failed to write buffered LocalStore batch: " << ex.what();
+  }
+}
+
+void BufferedLocalStore::enqueue(std::vector<Entry> entries) {
+  {
+    auto state = state_.lock();
+    fullCV_.wait(state.as_lock(), [&] {
+      return state->totalSize < bufferSize_ || !state->running ||
+          state->stopRequested;
+    });
+
+    if (state->running && !state->stopRequested) {
+      for (auto& entry : entries) {
+        auto& map = state->waiting[entry.keySpace->index];
+        auto entrySize = entry.key.size() + entry.value.size();
+        auto [it, inserted] = map.try_emplace(std::move(entry.key));
+        if (!inserted) {
+          state->totalSize -= it->first.size() + it->second.size();
+        }
+        it->second = std::move(entry.value);
+        state->totalSize += entrySize;
+      }
+      workCV_.notify_one();
+      return;
+    }
+  }
+
+  // The writer thread is not running: write through.
+  auto batch = backingStore_->beginWrite();
+  for (const auto& entry : entries) {
+    batch->put(
+        entry.keySpace, StringPiece{entry.key}, StringPiece{entry.value});
+  }
+  batch->flush();
+}
+
+const std::string* BufferedLocalStore::findPending(
+    const State& state,
+    KeySpace keySpace,
+    ByteRange key) {
+  for (const auto* pending : {&state.waiting, &state.inflight}) {
+    auto& map = (*pending)[keySpace->index];
+    auto it = map.find(StringPiece{key});
+    if (it != map.end()) {
+      return &it->second;
+    }
+  }
+  return nullptr;
+}
+
+void BufferedLocalStore::flush() {
+  folly::Promise<folly::Unit> promise;
+  auto future = promise.getFuture();
+  {
+    auto state = state_.lock();
+    if (!state->running || state->stopRequested) {
+      return;
+    }
+    state->flushPromises.push_back(std::move(promise));
+    workCV_.notify_one();
+  }
+  std::move(future).wait();
+}
+
+void BufferedLocalStore::clearKeySpace(KeySpace keySpace) {
+  // Write the queued data first, so that none of it lands in the backing
+  // store after it has been cleared.
+  flush();
+  backingStore_->clearKeySpace(keySpace);
+}
+
+void BufferedLocalStore::compactKeySpace(KeySpace keySpace) {
+  backingStore_->compactKeySpace(keySpace);
+}
+
+StoreResult BufferedLocalStore::get(KeySpace keySpace, ByteRange key) const {
+  {
+    auto state = state_.lock();
+    if (auto* value = findPending(*state, keySpace, key)) {
+      return StoreResult{*value};
+    }
+  }
+  return backingStore_->get(keySpace, key);
+}
+
+folly::Future<std::vector<StoreResult>> BufferedLocalStore::getBatch(
+    KeySpace keySpace,
+    const std::vector<ByteRange>& keys) const {
+  std::vector<std::optional<StoreResult>> hits;
+  hits.reserve(keys.size());
+  std::vector<ByteRange> misses;
+  {
+    auto state = state_.lock();
+    for (auto& key : keys) {
+      if (auto* value = findPending(*state, keySpace, key)) {
+        hits.emplace_back(StoreResult{*value});
+      } else {
+        hits.emplace_back(std::nullopt);
+        misses.push_back(key);
+      }
+    }
+  }
+  if (misses.size() == keys.size()) {
+    return backingStore_->getBatch(keySpace, keys);
+  }
+
+  auto missFuture = misses.empty()
+      ? folly::makeFuture(std::vector<StoreResult>{})
+      : backingStore_->getBatch(keySpace, misses);
+  return std::move(missFuture)
+      .thenValue([hits = std::move(hits)](
+                     std::vector<StoreResult>&& fetched) mutable {
+        std::vector<StoreResult> results;
+        results.reserve(hits.size());
+        size_t next = 0;
+        for (auto& hit : hits) {
+          if (hit) {
+            results.push_back(std::move(*hit));
+          } else {
+            results.push_back(std::move(fetched[next++]));
+          }
+        }
+        return results;
+      });
+}
+
+bool BufferedLocalStore::hasKey(KeySpace keySpace, ByteRange key) const {
+  {
+    auto state = state_.lock();
+    if (findPending(*state, keySpace, key)) {
+      return true;
+    }
+  }
+  return backingStore_->hasKey(keySpace, key);
+}
+
+bool BufferedLocalStore::mayContain(KeySpace keySpace, ByteRange key) const {
+  {
+    auto state = state_.lock();
+    if (findPending(*state, keySpace, key)) {
+      return true;
+    }
+  }
+  return backingStore_->mayContain(keySpace, key);
+}
+
+void BufferedLocalStore::put(
+    KeySpace keySpace,
+    ByteRange key,
+    ByteRange value) {
+  std::vector<Entry> entries;
+  entries.push_back(
+      Entry{keySpace, StringPiece{key}.str(), StringPiece{value}.str()});
+  enqueue(std::move(entries));
+}
+
+std::unique_ptr<LocalStore::WriteBatch> BufferedLocalStore::beginWrite(
+    size_t bufSize) {
+  return std::make_unique<BufferedWriteBatch>(*this, bufSize);
+}
+
+void BufferedLocalStore::periodicManagementTask(const EdenConfig& config) {
+  backingStore_->periodicManagementTask(config);
+}
+
+} // namespace facebook::eden
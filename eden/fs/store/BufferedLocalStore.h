@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <folly/futures/Promise.h>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+#include "eden/fs/store/LocalStore.h"
+
+namespace facebook::eden {
+
+class EdenStats;
+
+using EdenStatsPtr = RefPtr<EdenStats>;
+
+/**
+ * An implementation of LocalStore that moves writes off the caller's thread.
+ *
+ * put() and WriteBatch::flush() only queue the data in memory. A dedicated
+ * writer thread coalesces everything queued by all callers into a single
+ * WriteBatch against the backing store, waiting up to flushLatency for more
+ * writes to arrive unless the queue is already full. Once bufferSize bytes
+ * are queued, writers block until the writer thread catches up, which bounds
+ * the memory used.
+ *
+ * Queued and in-progress writes are looked up before the backing store, so
+ * reads always observe the writes that preceded them.
+ */
+class BufferedLocalStore final : public LocalStore {
+ public:
+  BufferedLocalStore(
+      std::shared_ptr<LocalStore> backingStore,
+      size_t bufferSize,
+      std::chrono::milliseconds flushLatency,
+      EdenStatsPtr edenStats);
+  ~BufferedLocalStore() override;
+
+  /**
+   * Opens the backing store and starts the writer thread.
+   */
+  void open() override;
+
+  /**
+   * Writes all queued data, then closes the backing store.
+   */
+  void close() override;
+
+  void clearKeySpace(KeySpace keySpace) override;
+  void compactKeySpace(KeySpace keySpace) override;
+  StoreResult get(KeySpace keySpace, folly::ByteRange key) const override;
+  using LocalStore::getBatch;
+  FOLLY_NODISCARD folly::Future<std::vector<StoreResult>> getBatch(
+      KeySpace keySpace,
+      const std::vector<folly::ByteRange>& keys) const override;
+  bool hasKey(KeySpace keySpace, folly::ByteRange key) const override;
+  using LocalStore::mayContain;
+  bool mayContain(KeySpace keySpace, folly::ByteRange key) const override;
+  void put(KeySpace keySpace, folly::ByteRange key, folly::ByteRange value)
+      override;
+  std::unique_ptr<LocalStore::WriteBatch> beginWrite(
+      size_t bufSize = 0) override;
+  void periodicManagementTask(const EdenConfig& config) override;
+
+  /**
+   * Returns once every write queued before the call has reached the backing
+   * store.
+   */
+  void flush();
+
+ private:
+  class BufferedWriteBatch;
+
+  struct Entry {
+    KeySpace keySpace;
+    std::string key;
+    std::string value;
+  };
+
+  using Pending = std::array<
+      folly::F14FastMap<std::string, std::string>,
+      KeySpace::kTotalCount>;
+
+  struct State {
+    bool running{false};
+    bool stopRequested{false};
+    // Writes that have not been picked up by the writer thread yet.
+    Pending waiting;
+    // Writes the writer thread is currently sending to the backing store. The
+    // writer thread reads this without the lock, so it is only modified by
+    // the writer thread while holding the lock.
+    Pending inflight;
+    // Bytes of keys and values in waiting.
+    size_t totalSize{0};
+    // Fulfilled once the writes queued before them have been written.
+    std::vector<folly::Promise<folly::Unit>> flushPromises;
+  };
+
+  /**
+   * Queue entries for the writer thread, blocking while the queue is full.
+   * Writes them synchronously if the writer thread isn't running.
+   */
+  void enqueue(std::vector<Entry> entries);
+
+  /**
+   * Look up key in the queued and in-progress writes.
+   */
+  static const std::string*
+  findPending(const State& state, KeySpace keySpace, folly::ByteRange key);
+
+  void processOnWorkerThread();
+
+  /**
+   * Send a batch of writes to the backing store.
+   */
+  void write(const Pending& pending);
+
+  void stopWorkerThread();
+
+  const std::shared_ptr<LocalStore> backingStore_;
+  const size_t bufferSize_;
+  const std::chrono::milliseconds flushLatency_;
+
+  std::thread workerThread_;
+  mutable folly::Synchronized<State, std::mutex> state_;
+  // Encodes the condition !state_.waiting.empty() || stopRequested ||
+  // !flushPromises.empty()
+  std::condition_variable workCV_;
+  // Encodes the condition state_->totalSize < bufferSize_ ||
+  // !state_->running
+  std::condition_variable fullCV_;
+};
+
+} // namespace facebook::eden
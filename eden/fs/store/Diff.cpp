@@ -8,9 +8,12 @@
 #include "eden/fs/store/Diff.h"
 
 #include <folly/Portability.h>
+#include <folly/ScopeGuard.h>
 #include <folly/Synchronized.h>
+#include <folly/futures/Future.h>
 #include <folly/logging/xlog.h>
 #include <memory>
+#include <optional>
 #include <vector>
 
 #include "eden/fs/model/Blob.h"
@@ -21,6 +24,7 @@
 #include "eden/fs/store/DiffContext.h"
 #include "eden/fs/store/ObjectStore.h"
 #include "eden/fs/store/ScmStatusDiffCallback.h"
+#include "eden/fs/store/TreeDiffCache.h"
 #include "eden/fs/utils/ImmediateFuture.h"
 #include "eden/fs/utils/PathFuncs.h"
 
@@ -273,30 +277,47 @@ FOLLY_NODISCARD ImmediateFuture<Unit> waitOnResults(
 }
 
 /**
- * Diff two trees.
- *
- * The path argument specifies the path to these trees, and will be prefixed
- * to all differences recorded in the results.
- *
- * The differences will be recorded using a callback provided by the caller.
+ * The two trees of a diff, as loaded from the ObjectStore. Either of them may
+ * be null.
  */
-FOLLY_NODISCARD ImmediateFuture<Unit> computeTreeDiff(
-    DiffContext* context,
-    RelativePathPiece currentPath,
-    std::shared_ptr<const Tree> scmTree,
-    std::shared_ptr<const Tree> wdTree,
-    std::unique_ptr<GitIgnoreStack> ignore,
-    bool isIgnored) {
-  // A list of Futures to wait on for our children's results.
-  ChildFutures childFutures;
+struct TreePair {
+  std::shared_ptr<const Tree> scmTree;
+  std::shared_ptr<const Tree> wdTree;
+};
+
+using TreeDiffSummaryPtr = std::shared_ptr<const TreeDiffSummary>;
 
-  // Walk through the entries in both trees.
+/**
+ * Find the .gitignore file of the working directory side of a diff.
+ */
+const Tree::value_type* findGitIgnore(const TreePair& trees) {
+  if (!trees.wdTree) {
+    return nullptr;
+  }
+  const auto it = trees.wdTree->find(kIgnoreFilename);
+  if (it == trees.wdTree->cend() || it->second.isTree()) {
+    return nullptr;
+  }
+  return &*it;
+}
+
+const Tree::value_type* findGitIgnore(const TreeDiffSummaryPtr& summary) {
+  return summary->gitIgnore ? &*summary->gitIgnore : nullptr;
+}
+
+/**
+ * Call fn with the entries of both trees that have the same name, in sorted
+ * order, passing nullptr for the tree that has no entry with that name.
+ */
+template <typename Fn>
+void forEachEntryPair(DiffContext* context, const TreePair& trees, Fn&& fn) {
   // This relies on the fact that the entry list in each tree is always sorted.
   Tree::container emptyEntries{kPathMapDefaultCaseSensitive};
-  auto scmIter = scmTree ? scmTree->cbegin() : emptyEntries.cbegin();
-  auto scmEnd = scmTree ? scmTree->cend() : emptyEntries.cend();
-  auto wdIter = wdTree ? wdTree->cbegin() : emptyEntries.cend();
-  auto wdEnd = wdTree ? wdTree->cend() : emptyEntries.cend();
+  auto scmIter =
+      trees.scmTree ? trees.scmTree->cbegin() : emptyEntries.cbegin();
+  auto scmEnd = trees.scmTree ? trees.scmTree->cend() : emptyEntries.cend();
+  auto wdIter = trees.wdTree ? trees.wdTree->cbegin() : emptyEntries.cend();
+  auto wdEnd = trees.wdTree ? trees.wdTree->cend() : emptyEntries.cend();
   while (true) {
     if (scmIter == scmEnd) {
       if (wdIter == wdEnd) {
@@ -304,42 +325,111 @@ FOLLY_NODISCARD ImmediateFuture<Unit> computeTreeDiff(
         break;
       }
       // This entry is present in wdTree but not scmTree
-      processAddedSide(
-          context, childFutures, currentPath, *wdIter, ignore.get(), isIgnored);
+      fn(nullptr, &*wdIter);
       ++wdIter;
     } else if (wdIter == wdEnd) {
       // This entry is present in scmTree but not wdTree
-      processRemovedSide(context, childFutures, currentPath, *scmIter);
+      fn(&*scmIter, nullptr);
       ++scmIter;
     } else {
       auto compare = comparePathPiece(
           scmIter->first, wdIter->first, context->getCaseSensitive());
       if (compare == CompareResult::BEFORE) {
-        processRemovedSide(context, childFutures, currentPath, *scmIter);
+        fn(&*scmIter, nullptr);
         ++scmIter;
       } else if (compare == CompareResult::AFTER) {
-        processAddedSide(
-            context,
-            childFutures,
-            currentPath,
-            *wdIter,
-            ignore.get(),
-            isIgnored);
+        fn(nullptr, &*wdIter);
         ++wdIter;
       } else {
-        processBothPresent(
-            context,
-            childFutures,
-            currentPath,
-            *scmIter,
-            *wdIter,
-            ignore.get(),
-            isIgnored);
+        fn(&*scmIter, &*wdIter);
         ++scmIter;
         ++wdIter;
       }
     }
   }
+}
+
+template <typename Fn>
+void forEachEntryPair(
+    DiffContext*,
+    const TreeDiffSummaryPtr& summary,
+    Fn&& fn) {
+  for (const auto& [scmEntry, wdEntry] : summary->differences) {
+    fn(scmEntry ? &*scmEntry : nullptr, wdEntry ? &*wdEntry : nullptr);
+  }
+}
+
+/**
+ * Record the entries of two trees that their diff has to look at, dropping
+ * the ones that are known to be identical on both sides, which the diff skips.
+ */
+TreeDiffSummaryPtr summarizeTreeDiff(
+    DiffContext* context,
+    const TreePair& trees) {
+  auto summary = std::make_shared<TreeDiffSummary>();
+  if (const auto* gitIgnore = findGitIgnore(trees)) {
+    summary->gitIgnore = *gitIgnore;
+  }
+  forEachEntryPair(
+      context,
+      trees,
+      [&](const Tree::value_type* scmEntry, const Tree::value_type* wdEntry) {
+        if (scmEntry && wdEntry &&
+            scmEntry->second.getType() == wdEntry->second.getType() &&
+            context->store->areObjectsKnownIdentical(
+                scmEntry->second.getHash(), wdEntry->second.getHash())) {
+          return;
+        }
+        summary->differences.emplace_back(
+            scmEntry ? std::optional{*scmEntry} : std::nullopt,
+            wdEntry ? std::optional{*wdEntry} : std::nullopt);
+      });
+  return summary;
+}
+
+/**
+ * Diff two trees, given either as a TreePair or as a TreeDiffSummary.
+ *
+ * The path argument specifies the path to these trees, and will be prefixed
+ * to all differences recorded in the results.
+ *
+ * The differences will be recorded using a callback provided by the caller.
+ */
+template <typename Source>
+FOLLY_NODISCARD ImmediateFuture<Unit> computeTreeDiff(
+    DiffContext* context,
+    RelativePathPiece currentPath,
+    const Source& source,
+    std::unique_ptr<GitIgnoreStack> ignore,
+    bool isIgnored) {
+  // A list of Futures to wait on for our children's results.
+  ChildFutures childFutures;
+
+  forEachEntryPair(
+      context,
+      source,
+      [&](const Tree::value_type* scmEntry, const Tree::value_type* wdEntry) {
+        if (!wdEntry) {
+          processRemovedSide(context, childFutures, currentPath, *scmEntry);
+        } else if (!scmEntry) {
+          processAddedSide(
+              context,
+              childFutures,
+              currentPath,
+              *wdEntry,
+              ignore.get(),
+              isIgnored);
+        } else {
+          processBothPresent(
+              context,
+              childFutures,
+              currentPath,
+              *scmEntry,
+              *wdEntry,
+              ignore.get(),
+              isIgnored);
+        }
+      });
 
   // Add an ensure() block that makes sure the ignore stack exists until all of
   // our children results have finished processing
@@ -382,11 +472,11 @@ ImmediateFuture<std::string> loadGitIgnore(
   }
 }
 
-FOLLY_NODISCARD ImmediateFuture<Unit> diffTrees(
+template <typename Source>
+FOLLY_NODISCARD ImmediateFuture<Unit> diffSource(
     DiffContext* context,
     RelativePathPiece currentPath,
-    std::shared_ptr<const Tree> scmTree,
-    std::shared_ptr<const Tree> wdTree,
+    Source source,
     const GitIgnoreStack* parentIgnore,
     bool isIgnored) {
   if (context->isCancelled()) {
@@ -404,43 +494,56 @@ FOLLY_NODISCARD ImmediateFuture<Unit> diffTrees(
     // We can pass in a null GitIgnoreStack pointer here.
     // Since the entire directory is ignored, we don't need to check ignore
     // status for any entries that aren't already tracked in source control.
-    return computeTreeDiff(
-        context,
-        currentPath,
-        std::move(scmTree),
-        std::move(wdTree),
-        nullptr,
-        isIgnored);
+    return computeTreeDiff(context, currentPath, source, nullptr, isIgnored);
   }
 
   ImmediateFuture<std::string> gitIgnore{std::in_place};
-  if (wdTree) {
-    // If this directory has a .gitignore file, load it first.
-    const auto it = wdTree->find(kIgnoreFilename);
-    if (it != wdTree->cend() && !it->second.isTree()) {
-      gitIgnore = loadGitIgnore(context, it->second, currentPath + it->first);
-    }
+  // If this directory has a .gitignore file, load it first.
+  if (const auto* gitIgnoreEntry = findGitIgnore(source)) {
+    gitIgnore = loadGitIgnore(
+        context, gitIgnoreEntry->second, currentPath + gitIgnoreEntry->first);
   }
 
   return std::move(gitIgnore).thenValue(
       [context,
        currentPath = currentPath.copy(),
-       scmTree = std::move(scmTree),
-       wdTree = std::move(wdTree),
+       source = std::move(source),
        parentIgnore,
        isIgnored](std::string gitIgnore) mutable {
         auto gitIgnoreStack =
-            std::make_unique<GitIgnoreStack>(parentIgnore, gitIgnore);
+            context->makeIgnoreStack(parentIgnore, std::move(gitIgnore));
         return computeTreeDiff(
             context,
             currentPath,
-            std::move(scmTree),
-            std::move(wdTree),
+            source,
             std::move(gitIgnoreStack),
             isIgnored);
       });
 }
 
+FOLLY_NODISCARD ImmediateFuture<Unit> diffTrees(
+    DiffContext* context,
+    RelativePathPiece currentPath,
+    std::shared_ptr<const Tree> scmTree,
+    std::shared_ptr<const Tree> wdTree,
+    const GitIgnoreStack* parentIgnore,
+    bool isIgnored) {
+  TreePair trees{std::move(scmTree), std::move(wdTree)};
+  auto* cache = context->getTreeDiffCache();
+  if (cache && trees.scmTree && trees.wdTree) {
+    auto summary = summarizeTreeDiff(context, trees);
+    cache->insert(
+        trees.scmTree->getHash(),
+        trees.wdTree->getHash(),
+        context->getCaseSensitive(),
+        summary);
+    return diffSource(
+        context, currentPath, std::move(summary), parentIgnore, isIgnored);
+  }
+  return diffSource(
+      context, currentPath, std::move(trees), parentIgnore, isIgnored);
+}
+
 FOLLY_NODISCARD ImmediateFuture<Unit> diffTrees(
     DiffContext* context,
     RelativePathPiece currentPath,
@@ -476,6 +579,37 @@ FOLLY_NODISCARD ImmediateFuture<Unit> diffTrees(
               return folly::unit;
             }
 
+            if (context->tryAcquireExecutorSlot()) {
+              // Diff this subtree on the executor so that the caller can move
+              // on to its remaining entries, and issue their fetches, without
+              // waiting for this subtree to be walked.
+              return folly::via(
+                  context->getExecutor(),
+                  [context,
+                   path = copiedCurrentPath.has_value()
+                       ? std::move(*copiedCurrentPath)
+                       : currentPath.copy(),
+                   scmTree = std::move(scmTree),
+                   wdTree = std::move(wdTree),
+                   ignore,
+                   isIgnored]() mutable {
+                    SCOPE_EXIT {
+                      // Only the synchronous part of the diff of this
+                      // subtree counts against the concurrency limit, since
+                      // the rest of it waits on fetches.
+                      context->releaseExecutorSlot();
+                    };
+                    return diffTrees(
+                               context,
+                               path,
+                               std::move(scmTree),
+                               std::move(wdTree),
+                               ignore,
+                               isIgnored)
+                        .semi();
+                  });
+            }
+
             auto pathPiece = copiedCurrentPath.has_value()
                 ? copiedCurrentPath->piece()
                 : currentPath;
@@ -511,6 +645,15 @@ ImmediateFuture<Unit> diffTrees(
     ObjectId wdHash,
     const GitIgnoreStack* ignore,
     bool isIgnored) {
+  if (auto* cache = context->getTreeDiffCache()) {
+    // These trees were diffed before, so their summary has everything this
+    // diff needs without fetching them.
+    if (auto summary =
+            cache->get(scmHash, wdHash, context->getCaseSensitive())) {
+      return diffSource(
+          context, currentPath, std::move(summary), ignore, isIgnored);
+    }
+  }
   return diffTrees(
       context,
       currentPath,
@@ -7,6 +7,9 @@
 
 #include "eden/fs/store/DiffContext.h"
 
+#include <folly/logging/xlog.h>
+
+#include "eden/fs/model/git/GitIgnoreCache.h"
 #include "eden/fs/model/git/GitIgnoreStack.h"
 #include "eden/fs/model/git/TopLevelIgnores.h"
 #include "eden/fs/store/ObjectStore.h"
@@ -35,8 +38,73 @@ const GitIgnoreStack* DiffContext::getToplevelIgnore() const {
   return topLevelIgnores_->getStack();
 }
 
+std::unique_ptr<GitIgnoreStack> DiffContext::makeIgnoreStack(
+    const GitIgnoreStack* parent,
+    std::string ignoreFileContents) const {
+  if (ignoreFileContents.empty()) {
+    return std::make_unique<GitIgnoreStack>(parent);
+  }
+  if (gitIgnoreCache_) {
+    return std::make_unique<GitIgnoreStack>(
+        parent, gitIgnoreCache_->get(std::move(ignoreFileContents)));
+  }
+  return std::make_unique<GitIgnoreStack>(parent, ignoreFileContents);
+}
+
 bool DiffContext::isCancelled() const {
   return cancellation_.isCancellationRequested();
 }
 
+void DiffContext::restrictTo(const std::vector<RelativePath>& paths) {
+  for (const auto& path : paths) {
+    XCHECK(!path.empty()) << "diffs can't be restricted to the root";
+    restrictedPaths_.emplace(path.value());
+    for (auto parent : path.dirname().allPaths()) {
+      restrictedParents_.emplace(parent.view());
+    }
+  }
+}
+
+void DiffContext::setExecutor(
+    std::shared_ptr<folly::Executor> executor,
+    size_t maxConcurrency) {
+  executor_ = std::move(executor);
+  maxConcurrency_ = maxConcurrency;
+}
+
+bool DiffContext::tryAcquireExecutorSlot() {
+  if (!executor_) {
+    return false;
+  }
+  auto inUse = executorSlotsInUse_.load(std::memory_order_relaxed);
+  do {
+    if (inUse >= maxConcurrency_) {
+      return false;
+    }
+  } while (!executorSlotsInUse_.compare_exchange_weak(
+      inUse, inUse + 1, std::memory_order_relaxed));
+  return true;
+}
+
+void DiffContext::releaseExecutorSlot() {
+  XDCHECK_GT(executorSlotsInUse_.load(std::memory_order_relaxed), 0u);
+  executorSlotsInUse_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool DiffContext::covers(RelativePathPiece path) const {
+  return restrictedParents_.count(path.view()) != 0 || coversAllOf(path);
+}
+
+bool DiffContext::coversAllOf(RelativePathPiece path) const {
+  if (!isRestricted()) {
+    return true;
+  }
+  for (auto prefix : path.paths()) {
+    if (restrictedPaths_.count(prefix.view()) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
 } // namespace facebook::eden
@@ -8,7 +8,13 @@
 #pragma once
 
 #include <folly/CancellationToken.h>
+#include <folly/Executor.h>
 #include <folly/Range.h>
+#include <folly/container/F14Set.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include "eden/fs/store/StatsFetchContext.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -18,10 +24,12 @@ namespace facebook::eden {
 template <typename T>
 class ImmediateFuture;
 class DiffCallback;
+class GitIgnoreCache;
 class GitIgnoreStack;
 class ObjectStore;
 class UserInfo;
 class TopLevelIgnores;
+class TreeDiffCache;
 class EdenMount;
 
 /**
@@ -61,8 +69,84 @@ class DiffContext {
   bool const listIgnored;
 
   const GitIgnoreStack* getToplevelIgnore() const;
+
+  /**
+   * Reuse the rules of .gitignore files that were parsed before, by this diff
+   * or by others, from the given cache.
+   */
+  void setGitIgnoreCache(std::shared_ptr<GitIgnoreCache> cache) {
+    gitIgnoreCache_ = std::move(cache);
+  }
+
+  /**
+   * Reuse the summaries of pairs of source control trees that were diffed
+   * before, by this diff or by others, from the given cache, and add the ones
+   * this diff computes to it.
+   */
+  void setTreeDiffCache(std::shared_ptr<TreeDiffCache> cache) {
+    treeDiffCache_ = std::move(cache);
+  }
+
+  TreeDiffCache* getTreeDiffCache() const {
+    return treeDiffCache_.get();
+  }
+
+  /**
+   * Create the GitIgnoreStack of a directory whose .gitignore file has the
+   * given contents, which are empty if it does not have one.
+   */
+  std::unique_ptr<GitIgnoreStack> makeIgnoreStack(
+      const GitIgnoreStack* parent,
+      std::string ignoreFileContents) const;
   bool isCancelled() const;
 
+  /**
+   * Only diff the given paths and everything inside them, for callers that
+   * know that nothing else changed since they last diffed. Paths outside of
+   * them may still be reported when they are inside a source control tree
+   * that is compared with another as a whole.
+   *
+   * The paths must not include the root.
+   */
+  void restrictTo(const std::vector<RelativePath>& paths);
+
+  bool isRestricted() const {
+    return !restrictedPaths_.empty();
+  }
+
+  /**
+   * Whether the diff covers the given path, or some of the paths inside it.
+   */
+  bool covers(RelativePathPiece path) const;
+
+  /**
+   * Whether the diff covers the given path and everything inside it.
+   */
+  bool coversAllOf(RelativePathPiece path) const;
+
+  /**
+   * Diff up to maxConcurrency subtrees at a time on the given executor once
+   * their trees are loaded, rather than on the thread that loaded them. This
+   * lets the diff of a directory issue the fetches of all of its children
+   * before any of them is diffed. Subtrees are diffed inline while all of the
+   * slots are taken.
+   */
+  void setExecutor(
+      std::shared_ptr<folly::Executor> executor,
+      size_t maxConcurrency);
+
+  folly::Executor* getExecutor() const {
+    return executor_.get();
+  }
+
+  /**
+   * Reserve one of the slots of the executor. Returns false if there is no
+   * executor or all of its slots are taken. A successful call must be
+   * followed by a call to releaseExecutorSlot().
+   */
+  bool tryAcquireExecutorSlot();
+  void releaseExecutorSlot();
+
   const StatsFetchContext& getStatsContext() {
     return *statsContext_;
   }
@@ -83,8 +167,19 @@ class DiffContext {
 
  private:
   std::unique_ptr<TopLevelIgnores> topLevelIgnores_;
+  std::shared_ptr<GitIgnoreCache> gitIgnoreCache_;
+  std::shared_ptr<TreeDiffCache> treeDiffCache_;
   const folly::CancellationToken cancellation_;
 
+  // Set by restrictTo(), along with all of the directories containing them.
+  folly::F14FastSet<std::string> restrictedPaths_;
+  folly::F14FastSet<std::string> restrictedParents_;
+
+  // Set by setExecutor().
+  std::shared_ptr<folly::Executor> executor_;
+  size_t maxConcurrency_{0};
+  std::atomic<size_t> executorSlotsInUse_{0};
+
   // TODO: We could populate pid and cause here.
   StatsFetchContextPtr statsContext_ = makeRefPtr<StatsFetchContext>();
 
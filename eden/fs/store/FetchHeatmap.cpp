@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/FetchHeatmap.h"
+
+#include <algorithm>
+
+namespace facebook::eden {
+
+FetchHeatmap::FetchHeatmap(size_t capacity, size_t maxDepth)
+    : capacity_{capacity}, maxDepth_{maxDepth} {}
+
+void FetchHeatmap::recordFetch(RelativePathPiece path) {
+  if (capacity_ == 0) {
+    return;
+  }
+  auto directory = path.dirname();
+  if (directory.empty()) {
+    return;
+  }
+  auto state = state_.lock();
+  size_t depth = 0;
+  for (auto parent : directory.paths()) {
+    if (++depth > maxDepth_) {
+      break;
+    }
+    increment(*state, parent.view());
+  }
+}
+
+void FetchHeatmap::increment(State& state, std::string_view directory) {
+  auto it = state.counters.find(directory);
+  if (it == state.counters.end()) {
+    Counter counter;
+    if (state.counters.size() >= capacity_) {
+      // Replace the least fetched directory, whose count is an upper bound
+      // of the fetches of the new one while it wasn't tracked.
+      auto least = state.byCount.begin();
+      counter.count = counter.error = least->first;
+      state.counters.erase(*least->second);
+      state.byCount.erase(least);
+    }
+    it = state.counters.emplace(std::string{directory}, counter).first;
+  } else {
+    state.byCount.erase({it->second.count, &it->first});
+  }
+  ++it->second.count;
+  state.byCount.emplace(it->second.count, &it->first);
+}
+
+std::vector<FetchHeatmap::Directory> FetchHeatmap::getTopDirectories(
+    size_t limit) const {
+  std::vector<Directory> directories;
+  auto state = state_.lock();
+  directories.reserve(std::min(limit, state->byCount.size()));
+  for (auto it = state->byCount.rbegin();
+       it != state->byCount.rend() && directories.size() < limit;
+       ++it) {
+    const auto& counter = state->counters.at(*it->second);
+    directories.push_back(
+        Directory{RelativePath{*it->second}, counter.count, counter.error});
+  }
+  return directories;
+}
+
+} // namespace facebook::eden
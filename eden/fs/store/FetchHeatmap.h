@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * Counts the objects fetched under each directory, for the directories
+ * fetched from the most, in bounded memory. This tells which subtrees cause
+ * the most fetches, to plan prefetches.
+ *
+ * A fetch counts for every parent directory of the fetched path, up to
+ * maxDepth levels deep. Directories are tracked with the Space-Saving
+ * algorithm: once capacity directories are tracked, a new directory replaces
+ * the least fetched one and inherits its count. Any directory whose count is
+ * higher than the smallest tracked count is therefore tracked. A count
+ * overestimates the directory's fetches by at most its error.
+ */
+class FetchHeatmap {
+ public:
+  struct Directory {
+    RelativePath path;
+    uint64_t count;
+    uint64_t error;
+  };
+
+  FetchHeatmap(size_t capacity, size_t maxDepth);
+
+  FetchHeatmap(const FetchHeatmap&) = delete;
+  FetchHeatmap& operator=(const FetchHeatmap&) = delete;
+
+  /**
+   * Record that the object at path was fetched.
+   */
+  void recordFetch(RelativePathPiece path);
+
+  /**
+   * Returns up to limit directories, from the most fetched.
+   */
+  std::vector<Directory> getTopDirectories(size_t limit) const;
+
+ private:
+  struct Counter {
+    uint64_t count = 0;
+    uint64_t error = 0;
+  };
+
+  struct State {
+    // Node map, so that the keys have a stable address for byCount.
+    folly::F14NodeMap<std::string, Counter> counters;
+    // The tracked directories, from the least fetched.
+    std::set<std::pair<uint64_t, const std::string*>> byCount;
+  };
+
+  void increment(State& state, std::string_view directory);
+
+  const size_t capacity_;
+  const size_t maxDepth_;
+  folly::Synchronized<State, std::mutex> state_;
+};
+
+} // namespace facebook::eden
@@ -6,6 +6,7 @@
  */
 
 #include "eden/fs/store/FilteredBackingStore.h"
+#include <algorithm>
 #include <stdexcept>
 #include <tuple>
 #include "eden/fs/model/Blob.h"
@@ -17,8 +18,13 @@ namespace facebook::eden {
 
 FilteredBackingStore::FilteredBackingStore(
     std::shared_ptr<BackingStore> backingStore,
-    std::unique_ptr<Filter> filter)
-    : backingStore_{std::move(backingStore)}, filter_{std::move(filter)} {};
+    std::unique_ptr<Filter> filter,
+    size_t filteredTreeCacheSize)
+    : backingStore_{std::move(backingStore)},
+      filter_{std::move(filter)},
+      filteredTrees_{
+          folly::in_place,
+          std::max(filteredTreeCacheSize, size_t{1})} {};
 
 FilteredBackingStore::~FilteredBackingStore() {}
 
@@ -137,9 +143,14 @@ PathMap<TreeEntry> FilteredBackingStore::filterImpl(
     RelativePathPiece treePath,
     folly::StringPiece filterId) {
   auto pathMap = PathMap<TreeEntry>{unfilteredTree->getCaseSensitivity()};
+  auto coverage = filter_->getCoverageForPath(treePath, filterId);
+  if (coverage == FilterCoverage::RecursivelyFiltered) {
+    return pathMap;
+  }
   for (const auto& [path, entry] : *unfilteredTree) {
     auto relPath = RelativePath{treePath} + path;
-    if (!filter_->isPathFiltered(relPath.piece(), filterId)) {
+    if (coverage == FilterCoverage::RecursivelyUnfiltered ||
+        !filter_->isPathFiltered(relPath.piece(), filterId)) {
       ObjectId oid;
       if (entry.getType() == TreeEntryType::TREE) {
         auto foid =
@@ -157,6 +168,27 @@ PathMap<TreeEntry> FilteredBackingStore::filterImpl(
   return pathMap;
 }
 
+TreePtr FilteredBackingStore::getFilteredTree(
+    const TreePtr& unfilteredTree,
+    const FilteredObjectId& filteredId) {
+  auto id = ObjectId{filteredId.getValue()};
+  {
+    auto cache = filteredTrees_.lock();
+    auto it = cache->find(id);
+    if (it != cache->end()) {
+      return it->second;
+    }
+  }
+
+  // Filter while the lock is not held. Concurrent misses for the same tree
+  // filter it more than once, but build equal trees.
+  auto pathMap =
+      filterImpl(unfilteredTree, filteredId.path(), filteredId.filter());
+  auto tree = std::make_shared<const Tree>(std::move(pathMap), id);
+  filteredTrees_.lock()->set(std::move(id), tree);
+  return tree;
+}
+
 ImmediateFuture<TreePtr> FilteredBackingStore::getRootTree(
     const RootId& rootId,
     const ObjectFetchContextPtr& context) {
@@ -169,12 +201,9 @@ ImmediateFuture<TreePtr> FilteredBackingStore::getRootTree(
         }
 
         // apply the filter to the tree
-        auto pathMap = self->filterImpl(rootTree, RelativePath{""}, filterId);
-
         auto rootFOID =
             FilteredObjectId{RelativePath{""}, filterId, rootTree->getHash()};
-        return std::make_shared<const Tree>(
-            std::move(pathMap), ObjectId{rootFOID.getValue()});
+        return self->getFilteredTree(rootTree, rootFOID);
       });
 }
 
@@ -196,10 +225,7 @@ folly::SemiFuture<BackingStore::GetTreeResult> FilteredBackingStore::getTree(
   return std::move(unfilteredTree)
       .deferValue(
           [self = shared_from_this(), filteredId](GetTreeResult&& result) {
-            auto pathMap = self->filterImpl(
-                result.tree, filteredId.path(), filteredId.filter());
-            auto tree = std::make_shared<Tree>(
-                std::move(pathMap), ObjectId{filteredId.getValue()});
+            auto tree = self->getFilteredTree(result.tree, filteredId);
             return GetTreeResult{std::move(tree), result.origin};
           });
 }
@@ -7,6 +7,10 @@
 
 #pragma once
 
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <mutex>
+
 #include "eden/fs/store/BackingStore.h"
 #include "eden/fs/store/filter/Filter.h"
 #include "eden/fs/store/filter/FilteredObjectId.h"
@@ -29,9 +33,16 @@ class FilteredBackingStore
     : public BackingStore,
       public std::enable_shared_from_this<FilteredBackingStore> {
  public:
+  static constexpr size_t kDefaultFilteredTreeCacheSize = 10000;
+
+  /**
+   * The last filteredTreeCacheSize filtered trees are kept, so that trees
+   * fetched again, by any mount using the same filter, aren't filtered again.
+   */
   FilteredBackingStore(
       std::shared_ptr<BackingStore> backingStore,
-      std::unique_ptr<Filter> filter);
+      std::unique_ptr<Filter> filter,
+      size_t filteredTreeCacheSize = kDefaultFilteredTreeCacheSize);
 
   ~FilteredBackingStore() override;
 
@@ -104,6 +115,20 @@ class FilteredBackingStore
   // filterId
   std::unique_ptr<Filter> filter_;
 
+  // Filtered trees, keyed by their FilteredObjectId. The id covers the path
+  // and the filter as well as the underlying tree, which is all filtering
+  // depends on.
+  folly::Synchronized<folly::EvictingCacheMap<ObjectId, TreePtr>, std::mutex>
+      filteredTrees_;
+
+  /*
+   * Returns the filtered version of a tree fetched from the underlying store,
+   * from the cache if it was filtered recently.
+   */
+  TreePtr getFilteredTree(
+      const TreePtr& unfilteredTree,
+      const FilteredObjectId& filteredId);
+
   /*
    * Does the actual filtering logic for tree and root-tree objects.
    */
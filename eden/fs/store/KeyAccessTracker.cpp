@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/KeyAccessTracker.h"
+
+#include <folly/hash/Hash.h>
+#include <algorithm>
+#include <vector>
+
+namespace facebook::eden {
+
+KeyAccessTracker::KeyAccessTracker(
+    uint32_t sampleRate,
+    size_t maxEntriesPerKeySpace)
+    : sampleRate_{std::max<uint32_t>(sampleRate, 1)},
+      maxEntriesPerKeySpace_{maxEntriesPerKeySpace} {}
+
+uint64_t KeyAccessTracker::hashKey(folly::ByteRange key) {
+  return folly::hash::SpookyHashV2::Hash64(key.data(), key.size(), 0);
+}
+
+void KeyAccessTracker::recordAccess(KeySpace keySpace, folly::ByteRange key) {
+  // A per-thread counter keeps sampling free of shared state.
+  static thread_local uint32_t counter = 0;
+  if (++counter % sampleRate_ != 0) {
+    return;
+  }
+
+  auto hash = hashKey(key);
+  auto epoch = getEpoch();
+  auto& map = maps_[keySpace->index];
+  {
+    // Most sampled keys are already tracked in the current epoch.
+    auto rlock = map.rlock();
+    auto it = rlock->find(hash);
+    if (it != rlock->end() && it->second == epoch) {
+      return;
+    }
+  }
+  map.wlock()->insert_or_assign(hash, epoch);
+}
+
+uint32_t KeyAccessTracker::getLastAccess(
+    KeySpace keySpace,
+    folly::ByteRange key) const {
+  auto rlock = maps_[keySpace->index].rlock();
+  auto it = rlock->find(hashKey(key));
+  return it == rlock->end() ? 0 : it->second;
+}
+
+void KeyAccessTracker::advanceEpoch() {
+  epoch_.fetch_add(1, std::memory_order_relaxed);
+
+  for (auto& map : maps_) {
+    auto wlock = map.wlock();
+    if (wlock->size() <= maxEntriesPerKeySpace_) {
+      continue;
+    }
+    std::vector<uint32_t> epochs;
+    epochs.reserve(wlock->size());
+    for (const auto& [hash, epoch] : *wlock) {
+      epochs.push_back(epoch);
+    }
+    auto median = epochs.begin() + epochs.size() / 2;
+    std::nth_element(epochs.begin(), median, epochs.end());
+    auto cutoff = *median;
+    // Dropping everything up to and including the median epoch frees at
+    // least half of the entries, even when many share that epoch.
+    for (auto it = wlock->begin(); it != wlock->end();) {
+      if (it->second <= cutoff) {
+        it = wlock->erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+}
+
+size_t KeyAccessTracker::getEntryCount(KeySpace keySpace) const {
+  return maps_[keySpace->index].rlock()->size();
+}
+
+} // namespace facebook::eden
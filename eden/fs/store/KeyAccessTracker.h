@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/SharedMutex.h>
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <array>
+#include <atomic>
+
+#include "eden/fs/store/KeySpace.h"
+
+namespace facebook::eden {
+
+/**
+ * Tracks, coarsely and approximately, when keys of the LocalStore were last
+ * read, so that garbage collection can evict the least recently used ones
+ * first.
+ *
+ * Time is measured in epochs, advanced by the caller (once per LocalStore
+ * management interval). Only one in sampleRate accesses is recorded, so keys
+ * that are read often are almost certainly tracked while keys read once or
+ * twice mostly are not; untracked keys report epoch 0, meaning unknown
+ * rather than old. Keys are tracked by hash, which makes each entry 12 bytes
+ * and collisions merely make a key look more recently used than it is.
+ *
+ * The state is not persisted: after a restart, only keys read since then are
+ * tracked.
+ */
+class KeyAccessTracker {
+ public:
+  KeyAccessTracker(uint32_t sampleRate, size_t maxEntriesPerKeySpace);
+
+  /**
+   * Possibly record that key was read during the current epoch.
+   */
+  void recordAccess(KeySpace keySpace, folly::ByteRange key);
+
+  /**
+   * The last epoch during which key was recorded as read, or 0 if it isn't
+   * tracked.
+   */
+  uint32_t getLastAccess(KeySpace keySpace, folly::ByteRange key) const;
+
+  uint32_t getEpoch() const {
+    return epoch_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Start a new epoch, and bound the memory used by forgetting at least the
+   * least recently used half of the entries of any KeySpace over its limit.
+   */
+  void advanceEpoch();
+
+  size_t getEntryCount(KeySpace keySpace) const;
+
+ private:
+  using Map = folly::F14ValueMap<uint64_t, uint32_t>;
+
+  static uint64_t hashKey(folly::ByteRange key);
+
+  const uint32_t sampleRate_;
+  const size_t maxEntriesPerKeySpace_;
+  // Epochs start at 1 so that 0 can mean "not tracked".
+  std::atomic<uint32_t> epoch_{1};
+  std::array<
+      folly::Synchronized<Map, folly::SharedMutex>,
+      KeySpace::kTotalCount>
+      maps_;
+};
+
+} // namespace facebook::eden
@@ -102,6 +102,17 @@ class KeySpace {
       8,
       "recasdigestproxyhash",
       Deprecated{}};
+  // Blob contents keyed by their BLAKE3 hash, so that identical contents are
+  // stored once whatever their ObjectIds.
+  static constexpr KeySpaceRecord BlobContentFamily{
+      9,
+      "blobcontent",
+      Ephemeral{&EdenConfig::localStoreBlobContentSizeLimit}};
+  // The BLAKE3 hash of the contents of a blob, keyed by its ObjectId.
+  static constexpr KeySpaceRecord BlobContentHashFamily{
+      10,
+      "blobcontenthash",
+      Ephemeral{&EdenConfig::localStoreBlobContentHashSizeLimit}};
 
   static constexpr const KeySpaceRecord* kAll[] = {
       &BlobFamily,
@@ -112,7 +123,9 @@ class KeySpace {
       &BlobSizeFamily,
       &ScsProxyHashFamily,
       &TreeMetaDataFamily,
-      &ReCasDigestProxyHashFamily};
+      &ReCasDigestProxyHashFamily,
+      &BlobContentFamily,
+      &BlobContentHashFamily};
   static constexpr size_t kTotalCount = std::size(kAll);
 
  private:
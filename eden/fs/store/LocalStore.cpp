@@ -18,6 +18,7 @@
 #include <array>
 
 #include "eden/fs/model/Blob.h"
+#include "eden/fs/model/Hash.h"
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/model/git/GitBlob.h"
 #include "eden/fs/model/git/GitTree.h"
@@ -51,6 +52,38 @@ FOLLY_ALWAYS_INLINE std::shared_ptr<T> parse(
 
   return def;
 }
+
+/**
+ * Store the blob under key with a git-style header, as deserializeGitBlob()
+ * expects.
+ */
+void putSerializedBlob(
+    LocalStore::WriteBatch& batch,
+    KeySpace keySpace,
+    ByteRange key,
+    const Blob& blob) {
+  const IOBuf& contents = blob.getContents();
+
+  // Add a git-style blob prefix
+  auto prefix = folly::to<string>("blob ", blob.getSize());
+  prefix.push_back('\0');
+  std::vector<ByteRange> bodySlices;
+  bodySlices.emplace_back(StringPiece(prefix));
+
+  // Add all of the IOBuf chunks
+  Cursor cursor(&contents);
+  while (true) {
+    auto bytes = cursor.peekBytes();
+    if (bytes.empty()) {
+      break;
+    }
+    bodySlices.push_back(bytes);
+    cursor.skip(bytes.size());
+  }
+
+  batch.put(keySpace, key, bodySlices);
+}
+
 } // namespace
 
 LocalStore::LocalStore(EdenStatsPtr edenStats) : stats_{std::move(edenStats)} {}
@@ -112,6 +145,17 @@ folly::Future<std::vector<StoreResult>> LocalStore::getBatch(
   });
 }
 
+folly::Future<std::vector<StoreResult>> LocalStore::getBatch(
+    KeySpace keySpace,
+    ObjectIdRange ids) const {
+  std::vector<folly::ByteRange> keys;
+  keys.reserve(ids.size());
+  for (const auto& id : ids) {
+    keys.push_back(id.getBytes());
+  }
+  return getBatch(keySpace, keys);
+}
+
 ImmediateFuture<TreePtr> LocalStore::getTree(const ObjectId& id) const {
   DurationScope stat{stats_, &LocalStoreStats::getTree};
   return getImmediateFuture(KeySpace::TreeFamily, id)
@@ -163,6 +207,36 @@ ImmediateFuture<BlobPtr> LocalStore::getBlob(const ObjectId& id) const {
           });
 }
 
+ImmediateFuture<BlobPtr> LocalStore::getBlobByContent(
+    const ObjectId& id) const {
+  DurationScope stat{stats_, &LocalStoreStats::getBlob};
+  return getImmediateFuture(KeySpace::BlobContentHashFamily, id)
+      .thenValue(
+          [self = shared_from_this(),
+           id,
+           stat = std::move(stat),
+           stats = stats_.copy()](StoreResult&& contentHash) -> BlobPtr {
+            if (contentHash.isValid()) {
+              auto data =
+                  self->get(KeySpace::BlobContentFamily, contentHash.bytes());
+              if (data.isValid()) {
+                return parse<const Blob>(
+                    id,
+                    "Blob",
+                    stats,
+                    &LocalStoreStats::getBlobFailure,
+                    [&data]() {
+                      auto buf = data.extractIOBuf();
+                      return deserializeGitBlob(&buf);
+                    });
+              }
+            }
+
+            stats->increment(&LocalStoreStats::getBlobByContentMiss);
+            return nullptr;
+          });
+}
+
 ImmediateFuture<BlobMetadataPtr> LocalStore::getBlobMetadata(
     const ObjectId& id) const {
   DurationScope stat{stats_, &LocalStoreStats::getBlobMetadata};
@@ -194,6 +268,19 @@ bool LocalStore::hasKey(KeySpace keySpace, const ObjectId& id) const {
   return hasKey(keySpace, id.getBytes());
 }
 
+bool LocalStore::mayContain(KeySpace /*keySpace*/, folly::ByteRange /*key*/)
+    const {
+  return true;
+}
+
+bool LocalStore::mayContain(KeySpace keySpace, const ObjectId& id) const {
+  return mayContain(keySpace, id.getBytes());
+}
+
+void LocalStore::recordAccess(
+    KeySpace /*keySpace*/,
+    folly::ByteRange /*key*/) const {}
+
 void LocalStore::putTree(const Tree& tree) {
   auto serialized = LocalStore::serializeTree(tree);
   ByteRange treeData = serialized.coalesce();
@@ -219,6 +306,22 @@ void LocalStore::putBlob(const ObjectId& id, const Blob* blob) {
   batch->flush();
 }
 
+void LocalStore::putBlobByContent(const ObjectId& id, const Blob* blob) {
+  auto contentHash = Hash32::blake3(blob->getContents());
+  auto contentKey = contentHash.getBytes();
+  auto batch = beginWrite(blob->getSize() + 64);
+  // Identical contents are common across paths and commits, so skip
+  // rewriting them. The contents and their hashes are evicted separately:
+  // whichever is missing makes getBlobByContent() miss, and the blob is
+  // stored again once it is refetched.
+  if (!mayContain(KeySpace::BlobContentFamily, contentKey) ||
+      !hasKey(KeySpace::BlobContentFamily, contentKey)) {
+    putSerializedBlob(*batch, KeySpace::BlobContentFamily, contentKey, *blob);
+  }
+  batch->put(KeySpace::BlobContentHashFamily, id.getBytes(), contentKey);
+  batch->flush();
+}
+
 void LocalStore::putBlobMetadata(
     const ObjectId& id,
     const BlobMetadata& metadata) {
@@ -256,27 +359,7 @@ void LocalStore::WriteBatch::put(
 }
 
 void LocalStore::WriteBatch::putBlob(const ObjectId& id, const Blob* blob) {
-  const IOBuf& contents = blob->getContents();
-  auto hashSlice = id.getBytes();
-
-  // Add a git-style blob prefix
-  auto prefix = folly::to<string>("blob ", blob->getSize());
-  prefix.push_back('\0');
-  std::vector<ByteRange> bodySlices;
-  bodySlices.emplace_back(StringPiece(prefix));
-
-  // Add all of the IOBuf chunks
-  Cursor cursor(&contents);
-  while (true) {
-    auto bytes = cursor.peekBytes();
-    if (bytes.empty()) {
-      break;
-    }
-    bodySlices.push_back(bytes);
-    cursor.skip(bytes.size());
-  }
-
-  put(KeySpace::BlobFamily, hashSlice, bodySlices);
+  putSerializedBlob(*this, KeySpace::BlobFamily, id.getBytes(), *blob);
 }
 
 LocalStore::WriteBatch::~WriteBatch() {}
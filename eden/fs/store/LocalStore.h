@@ -123,9 +123,22 @@ class LocalStore : public std::enable_shared_from_this<LocalStore> {
       KeySpace keySpace,
       const ObjectId& id) const;
 
+  /**
+   * Look up several keys at once. The results are returned in the same order
+   * as keys.
+   *
+   * The default implementation calls get() for each key; stores override this
+   * to amortize locking and lookup costs over the whole batch.
+   *
+   * The memory referenced by keys must remain valid until the returned future
+   * completes.
+   */
   FOLLY_NODISCARD virtual folly::Future<std::vector<StoreResult>> getBatch(
       KeySpace keySpace,
       const std::vector<folly::ByteRange>& keys) const;
+  FOLLY_NODISCARD folly::Future<std::vector<StoreResult>> getBatch(
+      KeySpace keySpace,
+      ObjectIdRange ids) const;
 
   /**
    * Get a Tree from the store.
@@ -147,6 +160,14 @@ class LocalStore : public std::enable_shared_from_this<LocalStore> {
    */
   ImmediateFuture<BlobPtr> getBlob(const ObjectId& id) const;
 
+  /**
+   * Get a Blob stored with putBlobByContent().
+   *
+   * Returns nullptr if either the hash of the blob's contents or the contents
+   * are not present in the store.
+   */
+  ImmediateFuture<BlobPtr> getBlobByContent(const ObjectId& id) const;
+
   /**
    * Get the size of a blob and the SHA-1 hash of its contents.
    *
@@ -161,6 +182,25 @@ class LocalStore : public std::enable_shared_from_this<LocalStore> {
   virtual bool hasKey(KeySpace keySpace, folly::ByteRange key) const = 0;
   bool hasKey(KeySpace keySpace, const ObjectId& id) const;
 
+  /**
+   * A cheap, in-memory test of whether the key may be stored.
+   *
+   * Returns false only if the key is definitely not stored, in which case
+   * callers can skip looking it up. Keys of ephemeral keyspaces written
+   * concurrently with clearKeySpace() may be reported missing even though
+   * stored. The default implementation always returns true.
+   */
+  virtual bool mayContain(KeySpace keySpace, folly::ByteRange key) const;
+  bool mayContain(KeySpace keySpace, const ObjectId& id) const;
+
+  /**
+   * Note that key was read from a store layered in front of this one, so that
+   * stores which evict by recency see every read. get() and getBatch()
+   * already account for the reads they serve. The default implementation
+   * does nothing.
+   */
+  virtual void recordAccess(KeySpace keySpace, folly::ByteRange key) const;
+
   /**
    * Store a Tree into the TreeFamily KeySpace.
    */
@@ -171,6 +211,13 @@ class LocalStore : public std::enable_shared_from_this<LocalStore> {
    */
   void putBlob(const ObjectId& id, const Blob* blob);
 
+  /**
+   * Store a Blob in the BlobContentFamily KeySpace under the BLAKE3 hash of
+   * its contents, unless it is already there, and map its ObjectId to that
+   * hash in the BlobContentHashFamily KeySpace.
+   */
+  void putBlobByContent(const ObjectId& id, const Blob* blob);
+
   /**
    * Store a blob metadata.
    */
@@ -261,6 +308,11 @@ class LocalStore : public std::enable_shared_from_this<LocalStore> {
 
   virtual void periodicManagementTask(const EdenConfig& config);
 
+ protected:
+  const EdenStatsPtr& getStats() const {
+    return stats_;
+  }
+
  private:
   /**
    * Compute the serialized version of the tree in a (not coalesced) IOBuf.
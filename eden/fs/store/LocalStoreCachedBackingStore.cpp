@@ -64,7 +64,9 @@ LocalStoreCachedBackingStore::getTree(
     const ObjectId& id,
     const ObjectFetchContextPtr& context) {
   auto localStoreGetTree = ImmediateFuture<TreePtr>{std::in_place, nullptr};
-  if (shouldCache(LocalStoreCachedBackingStore::CachingPolicy::Trees)) {
+  // Definite misses go straight to the backing store.
+  if (shouldCache(LocalStoreCachedBackingStore::CachingPolicy::Trees) &&
+      localStore_->mayContain(KeySpace::TreeFamily, id)) {
     localStoreGetTree = localStore_->getTree(id);
   }
 
@@ -96,7 +98,9 @@ LocalStoreCachedBackingStore::getTree(
                     const auto& size = treeEntry.getSize();
                     const auto& sha1 = treeEntry.getContentSha1();
                     const auto& blake3 = treeEntry.getContentBlake3();
-                    if (treeEntry.getType() == TreeEntryType::REGULAR_FILE &&
+                    auto type = treeEntry.getType();
+                    if ((type == TreeEntryType::REGULAR_FILE ||
+                         type == TreeEntryType::EXECUTABLE_FILE) &&
                         size && sha1) {
                       batch->putBlobMetadata(
                           treeEntry.getHash(),
@@ -121,7 +125,8 @@ LocalStoreCachedBackingStore::getBlobMetadata(
     const ObjectFetchContextPtr& context) {
   auto localStoreGetBlobMetadata =
       ImmediateFuture<BlobMetadataPtr>{std::in_place, nullptr};
-  if (shouldCache(LocalStoreCachedBackingStore::CachingPolicy::BlobMetadata)) {
+  if (shouldCache(LocalStoreCachedBackingStore::CachingPolicy::BlobMetadata) &&
+      localStore_->mayContain(KeySpace::BlobMetaDataFamily, id)) {
     localStoreGetBlobMetadata = localStore_->getBlobMetadata(id);
   }
   return std::move(localStoreGetBlobMetadata)
@@ -188,7 +193,13 @@ LocalStoreCachedBackingStore::getBlob(
     const ObjectFetchContextPtr& context) {
   auto localStoreGetBlob = ImmediateFuture<BlobPtr>{std::in_place, nullptr};
   if (shouldCache(LocalStoreCachedBackingStore::CachingPolicy::Blobs)) {
-    localStoreGetBlob = localStore_->getBlob(id);
+    if (localStore_->mayContain(KeySpace::BlobFamily, id)) {
+      localStoreGetBlob = localStore_->getBlob(id);
+    }
+  } else if (shouldCache(CachingPolicy::DeduplicatedBlobs)) {
+    if (localStore_->mayContain(KeySpace::BlobContentHashFamily, id)) {
+      localStoreGetBlob = localStore_->getBlobByContent(id);
+    }
   }
   return std::move(localStoreGetBlob)
       .thenValue([self = shared_from_this(), id = id, context = context.copy()](
@@ -208,6 +219,9 @@ LocalStoreCachedBackingStore::getBlob(
                 if (self->shouldCache(
                         LocalStoreCachedBackingStore::CachingPolicy::Blobs)) {
                   self->localStore_->putBlob(id, result.blob.get());
+                } else if (self->shouldCache(
+                               CachingPolicy::DeduplicatedBlobs)) {
+                  self->localStore_->putBlobByContent(id, result.blob.get());
                 }
                 self->stats_->increment(
                     &ObjectStoreStats::getBlobFromBackingStore);
@@ -221,7 +235,35 @@ LocalStoreCachedBackingStore::getBlob(
 folly::SemiFuture<folly::Unit> LocalStoreCachedBackingStore::prefetchBlobs(
     ObjectIdRange ids,
     const ObjectFetchContextPtr& context) {
-  return backingStore_->prefetchBlobs(ids, context);
+  auto blobKeySpace = getBlobKeySpace();
+  if (!blobKeySpace) {
+    return backingStore_->prefetchBlobs(ids, context);
+  }
+
+  // Only prefetch the blobs that are not in the LocalStore already. The key
+  // filter rules out most of the missing ones without a lookup. Deduplicated
+  // blobs whose contents were evicted are still skipped, and will be fetched
+  // when read.
+  auto missing = std::make_unique<std::vector<ObjectId>>();
+  for (const auto& id : ids) {
+    if (!localStore_->mayContain(*blobKeySpace, id) ||
+        !localStore_->hasKey(*blobKeySpace, id)) {
+      missing->push_back(id);
+    }
+  }
+  stats_->increment(
+      &ObjectStoreStats::prefetchBlobFromLocalStore,
+      ids.size() - missing->size());
+
+  if (missing->empty()) {
+    return folly::unit;
+  }
+  if (missing->size() == ids.size()) {
+    return backingStore_->prefetchBlobs(ids, context);
+  }
+  auto missingIds = ObjectIdRange{missing->data(), missing->size()};
+  return backingStore_->prefetchBlobs(missingIds, context)
+      .deferEnsure([missing = std::move(missing)] {});
 }
 
 void LocalStoreCachedBackingStore::periodicManagementTask() {
@@ -266,6 +308,16 @@ std::optional<folly::StringPiece> LocalStoreCachedBackingStore::getRepoName() {
   return backingStore_->getRepoName();
 }
 
+std::optional<KeySpace> LocalStoreCachedBackingStore::getBlobKeySpace() const {
+  if (shouldCache(LocalStoreCachedBackingStore::CachingPolicy::Blobs)) {
+    return KeySpace::BlobFamily;
+  }
+  if (shouldCache(CachingPolicy::DeduplicatedBlobs)) {
+    return KeySpace::BlobContentHashFamily;
+  }
+  return std::nullopt;
+}
+
 bool LocalStoreCachedBackingStore::shouldCache(CachingPolicy object) const {
   auto underlyingObject = folly::to_underlying(object);
   return (folly::to_underlying(cachingPolicy_) & underlyingObject) ==
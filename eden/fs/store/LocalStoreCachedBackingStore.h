@@ -7,7 +7,9 @@
 
 #pragma once
 
+#include <optional>
 #include "eden/fs/store/BackingStore.h"
+#include "eden/fs/store/KeySpace.h"
 #include "eden/fs/utils/RefPtr.h"
 
 namespace facebook::eden {
@@ -41,6 +43,11 @@ class LocalStoreCachedBackingStore
     Trees = 1 << 0,
     Blobs = 1 << 1,
     BlobMetadata = 1 << 2,
+    /**
+     * Cache blobs by the hash of their contents, see
+     * LocalStore::putBlobByContent(). Blobs takes precedence over this.
+     */
+    DeduplicatedBlobs = 1 << 3,
     TreesAndBlobMetadata = Trees | BlobMetadata,
     Everything = Trees | Blobs | BlobMetadata,
   };
@@ -115,6 +122,12 @@ class LocalStoreCachedBackingStore
    */
   bool shouldCache(CachingPolicy object) const;
 
+  /**
+   * The KeySpace holding the blobs cached in the LocalStore, keyed by
+   * ObjectId, if blobs are cached.
+   */
+  std::optional<KeySpace> getBlobKeySpace() const;
+
   std::shared_ptr<BackingStore> backingStore_;
   std::shared_ptr<LocalStore> localStore_;
   EdenStatsPtr stats_;
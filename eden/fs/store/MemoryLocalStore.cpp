@@ -7,6 +7,7 @@
 
 #include "eden/fs/store/MemoryLocalStore.h"
 #include <folly/String.h>
+#include <folly/futures/Future.h>
 #include "eden/fs/store/StoreResult.h"
 #include "eden/fs/telemetry/EdenStats.h"
 
@@ -76,6 +77,26 @@ StoreResult MemoryLocalStore::get(KeySpace keySpace, folly::ByteRange key)
   return StoreResult(std::string(it->second));
 }
 
+folly::Future<std::vector<StoreResult>> MemoryLocalStore::getBatch(
+    KeySpace keySpace,
+    const std::vector<folly::ByteRange>& keys) const {
+  return folly::makeFutureWith([&] {
+    std::vector<StoreResult> results;
+    results.reserve(keys.size());
+    auto store = storage_.rlock();
+    auto& map = (*store)[keySpace->index];
+    for (auto& key : keys) {
+      auto it = map.find(StringPiece(key));
+      if (it == map.end()) {
+        results.push_back(StoreResult::missing(keySpace, key));
+      } else {
+        results.emplace_back(std::string(it->second));
+      }
+    }
+    return results;
+  });
+}
+
 bool MemoryLocalStore::hasKey(KeySpace keySpace, folly::ByteRange key) const {
   auto store = storage_.rlock();
   auto it = (*store)[keySpace->index].find(StringPiece(key));
@@ -30,6 +30,10 @@ class MemoryLocalStore final : public LocalStore {
   void clearKeySpace(KeySpace keySpace) override;
   void compactKeySpace(KeySpace keySpace) override;
   StoreResult get(KeySpace keySpace, folly::ByteRange key) const override;
+  using LocalStore::getBatch;
+  FOLLY_NODISCARD folly::Future<std::vector<StoreResult>> getBatch(
+      KeySpace keySpace,
+      const std::vector<folly::ByteRange>& keys) const override;
   bool hasKey(KeySpace keySpace, folly::ByteRange key) const override;
   void put(KeySpace keySpace, folly::ByteRange key, folly::ByteRange value)
       override;
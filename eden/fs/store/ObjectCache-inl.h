@@ -6,7 +6,9 @@
  */
 
 #include <folly/MapUtil.h>
+#include <folly/hash/Hash.h>
 #include <folly/logging/xlog.h>
+#include <algorithm>
 #include <utility>
 
 #include "eden/fs/store/ObjectCache.h"
@@ -61,20 +63,57 @@ template <typename ObjectType, ObjectCacheFlavor Flavor>
 std::shared_ptr<ObjectCache<ObjectType, Flavor>>
 ObjectCache<ObjectType, Flavor>::create(
     size_t maximumCacheSizeBytes,
-    size_t minimumEntryCount) {
+    size_t minimumEntryCount,
+    size_t shardCount,
+    CacheEvictionPolicy policy) {
   // Allow make_shared with private constructor.
   struct OC : ObjectCache<ObjectType, Flavor> {
-    OC(size_t x, size_t y) : ObjectCache<ObjectType, Flavor>{x, y} {}
+    OC(size_t x, size_t y, size_t z, CacheEvictionPolicy p)
+        : ObjectCache<ObjectType, Flavor>{x, y, z, p} {}
   };
-  return std::make_shared<OC>(maximumCacheSizeBytes, minimumEntryCount);
+  return std::make_shared<OC>(
+      maximumCacheSizeBytes, minimumEntryCount, shardCount, policy);
 }
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 ObjectCache<ObjectType, Flavor>::ObjectCache(
     size_t maximumCacheSizeBytes,
-    size_t minimumEntryCount)
-    : maximumCacheSizeBytes_{maximumCacheSizeBytes},
-      minimumEntryCount_{minimumEntryCount} {}
+    size_t minimumEntryCount,
+    size_t shardCount,
+    CacheEvictionPolicy policy)
+    : maximumCacheSizeBytes_{
+          maximumCacheSizeBytes / std::max<size_t>(shardCount, 1)},
+      // Round up so that the cache as a whole keeps at least
+      // minimumEntryCount objects.
+      minimumEntryCount_{
+          (minimumEntryCount + std::max<size_t>(shardCount, 1) - 1) /
+          std::max<size_t>(shardCount, 1)},
+      policy_{policy},
+      shards_(std::max<size_t>(shardCount, 1)) {
+  if (policy_ == CacheEvictionPolicy::TinyLfu) {
+    // The sketch should track a few times more keys than fit in the shard so
+    // that it remembers the popularity of recently evicted objects. Object
+    // sizes vary wildly, so assume a conservative average.
+    constexpr size_t kAssumedAverageObjectSize = 1024;
+    auto expectedEntries = std::max(
+        minimumEntryCount_, maximumCacheSizeBytes_ / kAssumedAverageObjectSize);
+    for (auto& shard : shards_) {
+      shard.state.lock()->sketch = FrequencySketch{expectedEntries};
+    }
+  }
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+typename ObjectCache<ObjectType, Flavor>::SynchronizedState&
+ObjectCache<ObjectType, Flavor>::getShard(const ObjectId& hash) const {
+  if (shards_.size() == 1) {
+    return shards_[0].state;
+  }
+  // The per-shard F14 maps also index by the hash code, so remix it to keep
+  // the shard selection independent from the bucket selection.
+  auto index = folly::hash::twang_mix64(hash.getHashCode()) % shards_.size();
+  return shards_[index].state;
+}
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 template <ObjectCacheFlavor F>
@@ -90,7 +129,7 @@ ObjectCache<ObjectType, Flavor>::getInterestHandle(
   // runs after the lock is released.
   ObjectInterestHandle<ObjectType> interestHandle;
 
-  auto state = state_.lock();
+  auto state = getShard(hash).lock();
 
   auto item = getImpl(hash, *state);
   if (!item) {
@@ -129,7 +168,7 @@ typename std::enable_if_t<
     typename ObjectCache<ObjectType, Flavor>::ObjectPtr>
 ObjectCache<ObjectType, Flavor>::getSimple(const ObjectId& hash) {
   XLOG(DBG6) << "BlobCache::getSimple " << hash;
-  auto state = state_.lock();
+  auto state = getShard(hash).lock();
 
   if (auto item = getImpl(hash, *state)) {
     return item->object;
@@ -141,6 +180,9 @@ template <typename ObjectType, ObjectCacheFlavor Flavor>
 typename ObjectCache<ObjectType, Flavor>::CacheItem*
 ObjectCache<ObjectType, Flavor>::getImpl(const ObjectId& hash, State& state) {
   XLOG(DBG6) << "ObjectCache::getImpl " << hash;
+  // Both hits and misses count towards popularity: a miss that is followed by
+  // an insert is what lets a frequently requested object be admitted.
+  state.sketch.record(hash.getHashCode());
   auto* item = folly::get_ptr(state.items, hash);
   if (!item) {
     XLOG(DBG6) << "ObjectCache::getImpl missed";
@@ -188,8 +230,13 @@ ObjectCache<ObjectType, Flavor>::insertInterestHandle(
 
   XLOG(DBG6) << "  creating entry with generation=" << cacheItemGeneration;
 
-  auto state = state_.lock();
+  auto state = getShard(id).lock();
   auto [item, inserted] = insertImpl(std::move(id), std::move(object), *state);
+  if (!item) {
+    // Not admitted. The handle can still find the object while it remains in
+    // memory, and dropping it will not find anything to evict.
+    return interestHandle;
+  }
   switch (interest) {
     case Interest::UnlikelyNeededAgain:
       break;
@@ -218,7 +265,7 @@ ObjectCache<ObjectType, Flavor>::insertSimple(
     ObjectId id,
     ObjectCache<ObjectType, Flavor>::ObjectPtr object) {
   XLOG(DBG6) << "ObjectCache::insertSimple " << id;
-  auto state = state_.lock();
+  auto state = getShard(id).lock();
   insertImpl(std::move(id), std::move(object), *state);
 }
 
@@ -231,6 +278,13 @@ ObjectCache<ObjectType, Flavor>::insertImpl(
   XLOG(DBG6) << "ObjectCache::insertImpl " << id;
 
   auto size = object->getSizeBytes();
+  if (policy_ == CacheEvictionPolicy::TinyLfu &&
+      !shouldAdmit(id, size, state)) {
+    XLOG(DBG6) << "ObjectCache::insertImpl rejected " << id;
+    ++state.admissionRejectCount;
+    return std::make_pair(nullptr, false);
+  }
+
   ObjectId key = id;
 
   // the following should be no except
@@ -259,30 +313,50 @@ ObjectCache<ObjectType, Flavor>::insertImpl(
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 bool ObjectCache<ObjectType, Flavor>::contains(const ObjectId& hash) const {
-  auto state = state_.lock();
+  auto state = getShard(hash).lock();
   return 1 == state->items.count(hash);
 }
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 void ObjectCache<ObjectType, Flavor>::clear() {
   XLOG(DBG6) << "ObjectCache::clear";
-  auto state = state_.lock();
-  state->totalSize = 0;
-  state->evictionQueue.clear();
-  state->items.clear();
+  for (auto& shard : shards_) {
+    auto state = shard.state.lock();
+    state->totalSize = 0;
+    state->evictionQueue.clear();
+    state->items.clear();
+  }
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+std::vector<typename ObjectCache<ObjectType, Flavor>::ObjectPtr>
+ObjectCache<ObjectType, Flavor>::getAll() const {
+  std::vector<ObjectPtr> objects;
+  for (const auto& shard : shards_) {
+    auto state = shard.state.lock();
+    objects.reserve(objects.size() + state->evictionQueue.size());
+    for (const auto& item : state->evictionQueue) {
+      objects.push_back(item.object);
+    }
+  }
+  return objects;
 }
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 typename ObjectCache<ObjectType, Flavor>::Stats
 ObjectCache<ObjectType, Flavor>::getStats() const {
-  auto state = state_.lock();
   Stats stats;
-  stats.objectCount = state->items.size();
-  stats.totalSizeInBytes = state->totalSize;
-  stats.hitCount = state->hitCount;
-  stats.missCount = state->missCount;
-  stats.evictionCount = state->evictionCount;
-  stats.dropCount = state->dropCount;
+  for (const auto& shard : shards_) {
+    auto state = shard.state.lock();
+    stats.objectCount += state->items.size();
+    stats.totalSizeInBytes += state->totalSize;
+    stats.hitCount += state->hitCount;
+    stats.missCount += state->missCount;
+    stats.evictionCount += state->evictionCount;
+    stats.dropCount += state->dropCount;
+    stats.admissionRejectCount += state->admissionRejectCount;
+  }
+  stats.policy = policy_;
   return stats;
 }
 
@@ -291,7 +365,7 @@ void ObjectCache<ObjectType, Flavor>::dropInterestHandle(
     const ObjectId& hash,
     uint64_t generation) noexcept {
   XLOG(DBG6) << "dropInterestHandle " << hash << " generation=" << generation;
-  auto state = state_.lock();
+  auto state = getShard(hash).lock();
 
   auto* item = folly::get_ptr(state->items, hash);
   if (!item) {
@@ -319,6 +393,26 @@ void ObjectCache<ObjectType, Flavor>::dropInterestHandle(
   }
 }
 
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+bool ObjectCache<ObjectType, Flavor>::shouldAdmit(
+    const ObjectId& id,
+    size_t size,
+    State& state) noexcept {
+  if (state.totalSize + size <= maximumCacheSizeBytes_ ||
+      state.evictionQueue.size() < minimumEntryCount_ ||
+      state.evictionQueue.empty()) {
+    // Nothing would be evicted.
+    return true;
+  }
+  if (state.items.count(id) != 0) {
+    // Duplicate inserts only refresh the existing entry.
+    return true;
+  }
+  const auto& victim = state.evictionQueue.front();
+  return state.sketch.estimate(id.getHashCode()) >
+      state.sketch.estimate(victim.id.getHashCode());
+}
+
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 void ObjectCache<ObjectType, Flavor>::evictUntilFits(State& state) noexcept {
   XLOG(DBG6) << "ObjectCache::evictUntilFits "
@@ -10,11 +10,15 @@
 #include <folly/IntrusiveList.h>
 #include <folly/Synchronized.h>
 #include <folly/container/F14Map.h>
+#include <folly/lang/Align.h>
 #include <folly/synchronization/DistributedMutex.h>
 #include <list>
 #include <mutex>
+#include <vector>
 
+#include "eden/fs/config/CacheEvictionPolicy.h"
 #include "eden/fs/model/ObjectId.h"
+#include "eden/fs/utils/FrequencySketch.h"
 
 namespace facebook::eden {
 
@@ -101,6 +105,18 @@ class ObjectInterestHandle {
  * be used that only allow clients to use one flavor of get and insert. See
  * BlobCache and TreeCache for examples of each flavor.
  *
+ * The cache can optionally be split into a number of independent shards, each
+ * with its own lock, LRU queue and an equal share of the size budget. Objects
+ * are assigned to a shard by the hash of their ObjectId, so lookups and
+ * inserts of different objects rarely contend on the same lock. Eviction is
+ * LRU within a shard, which only approximates a global LRU.
+ *
+ * With the TinyLfu eviction policy, each shard additionally tracks how often
+ * every ObjectId has recently been looked up. When the shard is full, a new
+ * object is only admitted if it has been requested more often than the least
+ * recently used object it would replace. Scans that touch many objects once
+ * are thus rejected instead of flushing the frequently used working set.
+ *
  * It is safe to use this object from arbitrary threads.
  */
 template <typename ObjectType, ObjectCacheFlavor Flavor>
@@ -145,11 +161,29 @@ class ObjectCache
     uint64_t missCount{0};
     uint64_t evictionCount{0};
     uint64_t dropCount{0};
+    /// Number of inserts refused by the admission policy.
+    uint64_t admissionRejectCount{0};
+    CacheEvictionPolicy policy{CacheEvictionPolicy::Lru};
+
+    /**
+     * Fraction of lookups that were served from cache, in [0, 1].
+     */
+    double hitRatio() const {
+      auto lookups = hitCount + missCount;
+      return lookups == 0 ? 0.0 : static_cast<double>(hitCount) / lookups;
+    }
   };
 
+  /**
+   * Create a cache holding at most maximumCacheSizeBytes worth of objects
+   * (but always at least minimumEntryCount objects), split across shardCount
+   * independently locked shards. A shardCount of 0 is treated as 1.
+   */
   static std::shared_ptr<ObjectCache<ObjectType, Flavor>> create(
       size_t maximumCacheSizeBytes,
-      size_t minimumEntryCount);
+      size_t minimumEntryCount,
+      size_t shardCount = 1,
+      CacheEvictionPolicy policy = CacheEvictionPolicy::Lru);
   ~ObjectCache() {
     clear();
   }
@@ -187,7 +221,7 @@ class ObjectCache
   /**
    * Inserts a object into the cache for future lookup. If the new total size
    * exceeds the maximum cache size and the minimum entry count, old entries are
-   * evicted.
+   * evicted. The admission policy may decline to cache the object.
    *
    * Optionally returns an interest handle that, when dropped, evicts the
    * inserted object.
@@ -204,7 +238,7 @@ class ObjectCache
   /**
    * Inserts a object into the cache for future lookup. If the new total size
    * exceeds the maximum cache size and the minimum entry count, old entries are
-   * evicted.
+   * evicted. The admission policy may decline to cache the object.
    */
   template <ObjectCacheFlavor F = Flavor>
   typename std::enable_if_t<F == ObjectCacheFlavor::Simple, void> insertSimple(
@@ -221,14 +255,35 @@ class ObjectCache
    */
   void clear();
 
+  /**
+   * Returns every cached object, each shard's least recently used first, so
+   * that inserting them in order into another cache preserves their recency.
+   */
+  std::vector<ObjectPtr> getAll() const;
+
   /**
    * Return information about the current size of the cache and the total number
    * of hits and misses.
    */
   Stats getStats() const;
 
+  /**
+   * Return the number of independently locked shards in this cache.
+   */
+  size_t getShardCount() const {
+    return shards_.size();
+  }
+
+  CacheEvictionPolicy getEvictionPolicy() const {
+    return policy_;
+  }
+
  protected:
-  explicit ObjectCache(size_t maximumCacheSizeBytes, size_t minimumEntryCount);
+  explicit ObjectCache(
+      size_t maximumCacheSizeBytes,
+      size_t minimumEntryCount,
+      size_t shardCount = 1,
+      CacheEvictionPolicy policy = CacheEvictionPolicy::Lru);
 
  private:
   /*
@@ -281,8 +336,27 @@ class ObjectCache
     uint64_t missCount{0};
     uint64_t evictionCount{0};
     uint64_t dropCount{0};
+    uint64_t admissionRejectCount{0};
+
+    /// Recent lookup frequencies. Only populated for the TinyLfu policy.
+    FrequencySketch sketch;
   };
 
+  using SynchronizedState = folly::Synchronized<State, folly::DistributedMutex>;
+
+  /**
+   * Each shard lives on its own cache line so concurrent accesses to
+   * different shards do not false-share their locks.
+   */
+  struct alignas(folly::hardware_destructive_interference_size) Shard {
+    SynchronizedState state;
+  };
+
+  /**
+   * Return the shard responsible for the given ObjectId.
+   */
+  SynchronizedState& getShard(const ObjectId& hash) const;
+
   /**
    * If an object for the given hash is in cache, return it. If the object is
    * not in cache, return nullptr (and an empty interest handle).
@@ -296,7 +370,8 @@ class ObjectCache
    * exceeds the maximum cache size and the minimum entry count, old entries are
    * evicted. Returns the item inserted (or already in the cache if this is a
    * duplicate insert) and a boolean indicating if this item was freshly
-   * inserted (returns false if this is a duplicate insert).
+   * inserted (returns false if this is a duplicate insert). Returns a null
+   * item if the admission policy rejected the object.
    *
    * Does not do anything related to InterestHandles
    */
@@ -305,13 +380,29 @@ class ObjectCache
 
   void dropInterestHandle(const ObjectId& hash, uint64_t generation) noexcept;
 
+  /**
+   * Returns true if the admission policy allows caching an object of the
+   * given size, possibly at the expense of the least recently used object.
+   */
+  bool shouldAdmit(const ObjectId& id, size_t size, State& state) noexcept;
+
   void evictUntilFits(State& state) noexcept;
   void evictOne(State& state) noexcept;
   void evictItem(State&, const CacheItem& item) noexcept;
 
+  /**
+   * Per-shard budgets: the configured maximum size and minimum entry count are
+   * split evenly between all the shards.
+   */
   const size_t maximumCacheSizeBytes_;
   const size_t minimumEntryCount_;
-  folly::Synchronized<State, folly::DistributedMutex> state_;
+  const CacheEvictionPolicy policy_;
+
+  /**
+   * Never resized after construction. Mutable as shard lookup is needed from
+   * const methods.
+   */
+  mutable std::vector<Shard> shards_;
 
   friend class ObjectInterestHandle<ObjectType>;
 };
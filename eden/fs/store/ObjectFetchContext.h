@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <folly/CancellationToken.h>
+#include <chrono>
 #include <optional>
 #include <string_view>
 #include <unordered_map>
@@ -89,6 +91,33 @@ class ObjectFetchContext : public RefCounted {
   virtual const std::unordered_map<std::string, std::string>* getRequestInfo()
       const = 0;
 
+  /**
+   * Cancelled once nobody is waiting for the objects fetched with this
+   * context anymore, for instance because the request that caused the fetch
+   * was interrupted. Fetches that haven't started can then be skipped.
+   */
+  virtual folly::CancellationToken getCancellationToken() const {
+    return {};
+  }
+
+  /**
+   * If set, the time after which nobody will be waiting for the objects
+   * fetched with this context anymore.
+   */
+  virtual std::optional<std::chrono::steady_clock::time_point> getDeadline()
+      const {
+    return std::nullopt;
+  }
+
+  /**
+   * The process-unique ID of the filesystem request that caused this fetch,
+   * as reported in its trace events, or 0 if there is none. Lets the imports
+   * made on behalf of a request be found from it.
+   */
+  virtual uint64_t getRequestId() const {
+    return 0;
+  }
+
   /**
    * Support deprioritizing in sub-classes.
    * Note: Normally, each ObjectFetchContext is designed to be used for only one
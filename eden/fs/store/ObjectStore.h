@@ -289,6 +289,10 @@ class ObjectStore : public IObjectStore,
     return windowsSymlinksEnabled_;
   }
 
+  CaseSensitivity getCaseSensitive() const {
+    return caseSensitive_;
+  }
+
  private:
   // Forbidden constructor. Use create().
   ObjectStore(
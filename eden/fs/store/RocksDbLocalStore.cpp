@@ -15,6 +15,7 @@
 #include <folly/futures/Future.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
+#include <folly/lang/Assume.h>
 #include <folly/lang/Bits.h>
 #include <folly/logging/xlog.h>
 #include <rocksdb/convenience.h>
@@ -46,6 +47,89 @@ using std::chrono::duration_cast;
 namespace {
 using namespace facebook::eden;
 
+/**
+ * How aggressively the column families are compressed.
+ *
+ * The preferred settings depend on zstd, which is not linked into every
+ * RocksDB build, so opening the database falls back to the next profile when
+ * a compression type is unavailable.
+ */
+enum class CompressionProfile {
+  // Compression tuned for each KeySpace, see keySpaceCompression().
+  Tuned,
+  // Like Tuned, but with LZ4 in place of zstd.
+  Portable,
+  // Whatever RocksDB picks by default.
+  Default,
+};
+
+constexpr CompressionProfile kCompressionProfiles[] = {
+    CompressionProfile::Tuned,
+    CompressionProfile::Portable,
+    CompressionProfile::Default,
+};
+
+folly::StringPiece toString(CompressionProfile profile) {
+  switch (profile) {
+    case CompressionProfile::Tuned:
+      return "tuned";
+    case CompressionProfile::Portable:
+      return "portable";
+    case CompressionProfile::Default:
+      return "default";
+  }
+  return "unknown";
+}
+
+/**
+ * Size of the zstd dictionary trained for each SST file of the column
+ * families that use one, and how much sampled data it is trained on.
+ */
+constexpr uint32_t kZstdDictionaryBytes = 16 * 1024;
+constexpr uint32_t kZstdTrainingBytes = 100 * kZstdDictionaryBytes;
+
+/**
+ * The KeySpaces hold data with very different compressibility:
+ * - Blob contents are frequently already compressed (images, archives,
+ *   binaries), and are the bulk of the data, so spending CPU compressing
+ *   them rarely pays off.
+ * - Trees are small records made of names and hashes with a lot of
+ *   redundancy across records, which a shared zstd dictionary captures much
+ *   better than compressing each block on its own.
+ * - Metadata and proxy hashes are small and hot, so a cheap LZ4 pass keeps
+ *   reads fast.
+ */
+void keySpaceCompression(
+    rocksdb::ColumnFamilyOptions& options,
+    KeySpace keySpace,
+    CompressionProfile profile) {
+  if (profile == CompressionProfile::Default) {
+    return;
+  }
+
+  if (keySpace->index == KeySpace::BlobFamily.index) {
+    options.compression = rocksdb::kNoCompression;
+    return;
+  }
+
+  if (keySpace->index == KeySpace::TreeFamily.index &&
+      profile == CompressionProfile::Tuned) {
+    // RocksDB samples the data of every SST file it writes during flushes
+    // and compactions, trains a dictionary from the samples and stores it in
+    // the file, so dictionaries keep up with the data without a separate
+    // training job.
+    options.compression = rocksdb::kZSTD;
+    options.compression_opts.max_dict_bytes = kZstdDictionaryBytes;
+    options.compression_opts.zstd_max_train_bytes = kZstdTrainingBytes;
+    options.bottommost_compression = rocksdb::kZSTD;
+    options.bottommost_compression_opts = options.compression_opts;
+    options.bottommost_compression_opts.enabled = true;
+    return;
+  }
+
+  options.compression = rocksdb::kLZ4Compression;
+}
+
 rocksdb::ColumnFamilyOptions makeColumnOptions(uint64_t LRUblockCacheSizeMB) {
   rocksdb::ColumnFamilyOptions options;
 
@@ -64,7 +148,8 @@ rocksdb::ColumnFamilyOptions makeColumnOptions(uint64_t LRUblockCacheSizeMB) {
  */
 const std::vector<rocksdb::ColumnFamilyDescriptor> columnFamilies(
     const rocksdb::DBOptions& db_options,
-    const std::string& name) {
+    const std::string& name,
+    CompressionProfile profile = CompressionProfile::Default) {
   // Most of the column families will share the same cache.  We
   // want the blob data to live in its own smaller cache; the assumption
   // is that the vfs cache will compensate for that, together with the
@@ -83,9 +168,11 @@ const std::vector<rocksdb::ColumnFamilyDescriptor> columnFamilies(
 
   std::vector<rocksdb::ColumnFamilyDescriptor> families;
   for (auto& ks : KeySpace::kAll) {
-    families.emplace_back(
-        ks->name.str(),
-        (ks->index == KeySpace::BlobFamily.index) ? blobOptions : options);
+    // Copies share the block cache, only the compression settings differ.
+    auto keySpaceOptions =
+        (ks->index == KeySpace::BlobFamily.index) ? blobOptions : options;
+    keySpaceCompression(keySpaceOptions, *ks, profile);
+    families.emplace_back(ks->name.str(), keySpaceOptions);
     auto oldFamily = find(
         oldUnopenedColumnFamilies.begin(),
         oldUnopenedColumnFamilies.end(),
@@ -133,6 +220,98 @@ rocksdb::Range getFullRange(std::string& rangeStorage) {
   return rocksdb::Range(begin, end);
 }
 
+/**
+ * Record one in this many reads of ephemeral keys for garbage collection.
+ */
+constexpr uint32_t kAccessSampleRate = 8;
+
+/**
+ * Bounds the access tracker to about 12MB per keyspace.
+ */
+constexpr size_t kMaxTrackedKeysPerKeySpace = 1'000'000;
+
+/**
+ * Number of keys each automatic GC slice examines.
+ */
+constexpr size_t kAutoGCSliceKeys = 10'000;
+
+/**
+ * Each automatic GC pass deletes the tracked keys that haven't been read for
+ * this many epochs. Epochs advance every store:stats-interval, a minute by
+ * default, so the passes roughly delete keys not read in the last day, hour
+ * and ten minutes. If a keyspace is still over its target after all of them,
+ * it is cleared entirely.
+ */
+constexpr std::array<uint32_t, 3> kAutoGCCutoffAges{
+    24 * 60,
+    60,
+    10};
+
+/**
+ * Number of keys each key filter building slice adds.
+ */
+constexpr size_t kKeyFilterSliceKeys = 100'000;
+
+/**
+ * Key filters are sized for at least this many keys, and for 50% more keys
+ * than the keyspace holds at open, so that they don't degrade right away as
+ * the keyspace grows. They are sized again on the next open.
+ */
+constexpr uint64_t kMinKeyFilterCapacity = 1'000'000;
+
+/**
+ * rewriteKeySpace() writes its updates in batches of about this many bytes.
+ */
+constexpr size_t kRewriteBatchBytes = 16 * 1024 * 1024;
+
+/**
+ * Trees and blob metadata are looked up for every object of a new commit,
+ * and their keyspaces are cheap to scan when building the filter. Scanning
+ * the blob keyspace would read every blob, so it isn't filtered.
+ */
+bool usesKeyFilter(KeySpace keySpace) {
+  return keySpace->index == KeySpace::TreeFamily.index ||
+      keySpace->index == KeySpace::BlobMetaDataFamily.index;
+}
+
+/**
+ * An iterator over every key of keySpace, starting at resumeKey if set.
+ */
+std::unique_ptr<rocksdb::Iterator> newScanIterator(
+    RocksHandles& handles,
+    KeySpace keySpace,
+    const std::optional<std::string>& resumeKey) {
+  ReadOptions readOptions;
+  // The column families are tuned for point lookups; make sure the iterator
+  // visits every key regardless.
+  readOptions.total_order_seek = true;
+  // Scanning a whole keyspace shouldn't push the hot blocks out of the block
+  // cache.
+  readOptions.fill_cache = false;
+  std::unique_ptr<rocksdb::Iterator> it{handles.db->NewIterator(
+      readOptions, handles.columns[keySpace->index].get())};
+  if (resumeKey) {
+    it->Seek(*resumeKey);
+  } else {
+    it->SeekToFirst();
+  }
+  return it;
+}
+
+ByteRange toByteRange(const Slice& slice) {
+  return ByteRange{
+      reinterpret_cast<const uint8_t*>(slice.data()), slice.size()};
+}
+
+/**
+ * The epoch before which keys are deleted by the given automatic GC pass.
+ */
+uint32_t autoGCCutoff(size_t pass, uint32_t epoch) {
+  auto age = kAutoGCCutoffAges[pass];
+  // Keys that were read in epoch 1 or later are tracked.
+  return epoch > age ? epoch - age : 1;
+}
+
 rocksdb::Slice _createSlice(folly::ByteRange bytes) {
   return Slice(reinterpret_cast<const char*>(bytes.data()), bytes.size());
 }
@@ -150,12 +329,14 @@ class RocksDbWriteBatch : public LocalStore::WriteBatch {
   // Use LocalStore::beginWrite() to create a write batch
   RocksDbWriteBatch(
       Synchronized<RocksDbLocalStore::RockDBState>::ConstRLockedPtr&& dbHandles,
+      const RocksDbLocalStore::KeyFilters& keyFilters,
       size_t bufferSize);
 
   void flushIfNeeded();
 
   folly::Synchronized<RocksDbLocalStore::RockDBState>::ConstRLockedPtr
       lockedDB_;
+  const RocksDbLocalStore::KeyFilters& keyFilters_;
   rocksdb::WriteBatch writeBatch_;
   size_t bufSize_;
 };
@@ -190,9 +371,11 @@ void RocksDbWriteBatch::flushIfNeeded() {
 
 RocksDbWriteBatch::RocksDbWriteBatch(
     Synchronized<RocksDbLocalStore::RockDBState>::ConstRLockedPtr&& dbHandles,
+    const RocksDbLocalStore::KeyFilters& keyFilters,
     size_t bufSize)
     : LocalStore::WriteBatch(),
       lockedDB_(std::move(dbHandles)),
+      keyFilters_(keyFilters),
       writeBatch_(bufSize),
       bufSize_(bufSize) {}
 
@@ -207,6 +390,9 @@ void RocksDbWriteBatch::put(
     KeySpace keySpace,
     folly::ByteRange key,
     folly::ByteRange value) {
+  if (auto& filter = keyFilters_[keySpace->index]) {
+    filter->insert(key);
+  }
   writeBatch_.Put(
       lockedDB_->handles->columns[keySpace->index].get(),
       _createSlice(key),
@@ -225,6 +411,9 @@ void RocksDbWriteBatch::put(
     slices.emplace_back(_createSlice(valueSlice));
   }
 
+  if (auto& filter = keyFilters_[keySpace->index]) {
+    filter->insert(key);
+  }
   auto keySlice = _createSlice(key);
   SliceParts keyParts(&keySlice, 1);
   writeBatch_.Put(
@@ -251,27 +440,45 @@ rocksdb::Options getRocksdbOptions() {
   return options;
 }
 
+/**
+ * Whether opening the database failed because a compression type configured
+ * for a column family is not linked into this RocksDB build.
+ */
+bool isUnsupportedCompression(const RocksException& ex) {
+  return ex.getStatus().IsInvalidArgument() &&
+      ex.getStatus().ToString().find("not linked") != std::string::npos;
+}
+
 RocksHandles openDB(AbsolutePathPiece path, RocksDBOpenMode mode) {
   auto options = getRocksdbOptions();
-  const auto columnDescriptors =
-      columnFamilies(rocksdb::DBOptions{options}, path.stringWithoutUNC());
-  try {
-    return RocksHandles(
-        path.viewWithoutUNC(), mode, options, columnDescriptors);
-  } catch (const RocksException& ex) {
-    XLOG(ERR) << "Error opening RocksDB storage at " << path << ": "
-              << ex.what();
-    if (mode == RocksDBOpenMode::ReadOnly) {
-      // In read-only mode fail rather than attempting to repair the DB.
-      throw;
+  for (auto profile : kCompressionProfiles) {
+    const auto columnDescriptors = columnFamilies(
+        rocksdb::DBOptions{options}, path.stringWithoutUNC(), profile);
+    try {
+      return RocksHandles(
+          path.viewWithoutUNC(), mode, options, columnDescriptors);
+    } catch (const RocksException& ex) {
+      if (profile != CompressionProfile::Default &&
+          isUnsupportedCompression(ex)) {
+        XLOG(WARN) << "RocksDB compression profile " << toString(profile)
+                   << " is not supported by this build: " << ex.what();
+        continue;
+      }
+      XLOG(ERR) << "Error opening RocksDB storage at " << path << ": "
+                << ex.what();
+      if (mode == RocksDBOpenMode::ReadOnly) {
+        // In read-only mode fail rather than attempting to repair the DB.
+        throw;
+      }
+      // Fall through and attempt to repair the DB
+      RocksDbLocalStore::repairDB(path);
+
+      // Now try opening the DB again.
+      return RocksHandles(
+          path.viewWithoutUNC(), mode, options, columnDescriptors);
     }
-    // Fall through and attempt to repair the DB
   }
-
-  RocksDbLocalStore::repairDB(path);
-
-  // Now try opening the DB again.
-  return RocksHandles(path.viewWithoutUNC(), mode, options, columnDescriptors);
+  folly::assume_unreachable();
 }
 
 } // namespace
@@ -293,6 +500,7 @@ RocksDbLocalStore::RocksDbLocalStore(
       structuredLogger_{std::move(structuredLogger)},
       faultInjector_(*faultInjector),
       ioPool_(12, "RocksLocalStore"),
+      accessTracker_{kAccessSampleRate, kMaxTrackedKeysPerKeySpace},
       pathToDb_{pathToRocksDb.copy()},
       mode_{mode} {
   XLOG(DBG2) << "Making a new RockDB localstore ( " << this
@@ -318,6 +526,7 @@ void RocksDbLocalStore::open() {
         std::make_unique<RocksHandles>(openDB(pathToDb_.piece(), mode_));
     handles->status = RockDbHandleStatus::OPEN;
   }
+  startKeyFilterBuild();
   // Publish fb303 stats once when we first open the DB.
   // These will be kept up-to-date later by the periodicManagementTask() call.
   XLOG(DBG2) << "RocksDB opened, computing statistics ...";
@@ -418,6 +627,10 @@ void RocksDbLocalStore::clearKeySpace(KeySpace keySpace) {
         columnFamily->GetName(),
         "\" column family");
   }
+
+  if (auto& filter = keyFilters_[keySpace->index]) {
+    filter->clear();
+  }
 }
 
 void RocksDbLocalStore::compactKeySpace(KeySpace keySpace) {
@@ -439,18 +652,68 @@ void RocksDbLocalStore::compactKeySpace(KeySpace keySpace) {
   }
 }
 
+size_t RocksDbLocalStore::rewriteKeySpace(
+    KeySpace keySpace,
+    folly::FunctionRef<std::optional<std::string>(ByteRange, ByteRange)> fn) {
+  auto handlesLock = getHandles();
+  auto& handles = handlesLock->handles;
+  auto columnFamily = handles->columns[keySpace->index].get();
+  XLOG(DBG2) << "rewriting column family \"" << columnFamily->GetName()
+             << "\"";
+
+  size_t rewritten = 0;
+  rocksdb::WriteBatch batch;
+  auto flush = [&] {
+    RocksException::check(
+        handles->db->Write(WriteOptions(), &batch),
+        "error rewriting \"",
+        columnFamily->GetName(),
+        "\" column family");
+    rewritten += batch.Count();
+    batch.Clear();
+  };
+
+  // The iterator reads from an implicit snapshot, so it doesn't see the
+  // updates written along the way.
+  auto it = newScanIterator(*handles, keySpace, std::nullopt);
+  for (; it->Valid(); it->Next()) {
+    auto value = fn(toByteRange(it->key()), toByteRange(it->value()));
+    if (!value) {
+      continue;
+    }
+    batch.Put(columnFamily, it->key(), *value);
+    if (batch.GetDataSize() >= kRewriteBatchBytes) {
+      flush();
+    }
+  }
+  RocksException::check(
+      it->status(),
+      "error iterating over \"",
+      columnFamily->GetName(),
+      "\" column family");
+  if (batch.Count() > 0) {
+    flush();
+  }
+  return rewritten;
+}
+
 StoreResult RocksDbLocalStore::get(KeySpace keySpace, ByteRange key) const {
   TaskTraceBlock block{"RocksDbLocalStore::get"};
   auto handlesLock = getHandles();
   auto& handles = handlesLock->handles;
-  string value;
+  // Read into a PinnableSlice rather than a std::string: on a block cache hit
+  // this references the cached block directly instead of copying the value.
+  // StoreResults are short-lived and never outlive the database, and
+  // StoreResult::extractIOBuf() copies the data out for long-lived users.
+  auto value = std::make_unique<rocksdb::PinnableSlice>();
   auto status = handles->db->Get(
       ReadOptions(),
       handles->columns[keySpace->index].get(),
       _createSlice(key),
-      &value);
+      value.get());
   if (!status.ok()) {
     if (status.IsNotFound()) {
+      recordKeyFilterMiss(keySpace, key);
       // Return an empty StoreResult
       return StoreResult::missing(keySpace, key);
     }
@@ -463,7 +726,10 @@ StoreResult RocksDbLocalStore::get(KeySpace keySpace, ByteRange key) const {
     throw RocksException::build(
         status, "failed to get ", folly::hexlify(key), " from local store");
   }
-  return StoreResult(std::move(value));
+  recordAccess(keySpace, key);
+  auto data = folly::ByteRange{
+      reinterpret_cast<const uint8_t*>(value->data()), value->size()};
+  return StoreResult::pinned(std::move(value), data);
 }
 
 FOLLY_NODISCARD folly::Future<std::vector<StoreResult>>
@@ -495,24 +761,36 @@ RocksDbLocalStore::getBatch(
               auto handlesLock = store->getHandles();
               auto& handles = handlesLock->handles;
               std::vector<Slice> keySlices;
-              std::vector<std::string> values;
-              std::vector<rocksdb::ColumnFamilyHandle*> columns;
+              keySlices.reserve(keys->size());
               for (auto& key : *keys) {
                 keySlices.emplace_back(key);
-                columns.emplace_back(handles->columns[keySpace->index].get());
               }
-              auto statuses = handles->db->MultiGet(
-                  ReadOptions(), columns, keySlices, &values);
+              // Use the batched single column family MultiGet: it looks up
+              // all the keys in one pass over the memtables and SST files,
+              // and, like get(), pins the values instead of copying them.
+              // The results share ownership of the pinned values.
+              auto values = std::make_shared<
+                  std::vector<rocksdb::PinnableSlice>>(keys->size());
+              std::vector<rocksdb::Status> statuses(keys->size());
+              handles->db->MultiGet(
+                  ReadOptions(),
+                  handles->columns[keySpace->index].get(),
+                  keySlices.size(),
+                  keySlices.data(),
+                  values->data(),
+                  statuses.data());
 
               std::vector<StoreResult> results;
+              results.reserve(keys->size());
               for (size_t i = 0; i < keys->size(); ++i) {
                 auto& status = statuses[i];
                 if (!status.ok()) {
                   if (status.IsNotFound()) {
+                    auto key =
+                        folly::ByteRange{folly::StringPiece{keys->at(i)}};
+                    store->recordKeyFilterMiss(keySpace, key);
                     // Return an empty StoreResult
-                    results.push_back(StoreResult::missing(
-                        keySpace,
-                        folly::ByteRange{folly::StringPiece{keys->at(i)}}));
+                    results.push_back(StoreResult::missing(keySpace, key));
                     continue;
                   }
 
@@ -529,7 +807,15 @@ RocksDbLocalStore::getBatch(
                       folly::hexlify(keys->at(i)),
                       " from local store");
                 }
-                results.emplace_back(std::move(values[i]));
+                store->recordAccess(
+                    keySpace,
+                    folly::ByteRange{folly::StringPiece{keys->at(i)}});
+                auto& value = (*values)[i];
+                results.push_back(StoreResult::pinned(
+                    values,
+                    folly::ByteRange{
+                        reinterpret_cast<const uint8_t*>(value.data()),
+                        value.size()}));
               }
               return results;
             }));
@@ -559,6 +845,7 @@ bool RocksDbLocalStore::hasKey(KeySpace keySpace, folly::ByteRange key) const {
       &value);
   if (!status.ok()) {
     if (status.IsNotFound()) {
+      recordKeyFilterMiss(keySpace, key);
       return false;
     }
 
@@ -573,15 +860,115 @@ bool RocksDbLocalStore::hasKey(KeySpace keySpace, folly::ByteRange key) const {
   return true;
 }
 
+bool RocksDbLocalStore::mayContain(KeySpace keySpace, folly::ByteRange key)
+    const {
+  if (!keyFilterReady_[keySpace->index].load(std::memory_order_acquire) ||
+      keyFilters_[keySpace->index]->mayContain(key)) {
+    return true;
+  }
+  getStats()->increment(&LocalStoreStats::keyFilterNegative);
+  return false;
+}
+
+void RocksDbLocalStore::recordAccess(KeySpace keySpace, folly::ByteRange key)
+    const {
+  if (keySpace->isEphemeral()) {
+    accessTracker_.recordAccess(keySpace, key);
+  }
+}
+
+void RocksDbLocalStore::recordKeyFilterMiss(
+    KeySpace keySpace,
+    folly::ByteRange key) const {
+  if (keyFilterReady_[keySpace->index].load(std::memory_order_acquire) &&
+      keyFilters_[keySpace->index]->mayContain(key)) {
+    getStats()->increment(&LocalStoreStats::keyFilterFalsePositive);
+  }
+}
+
+void RocksDbLocalStore::startKeyFilterBuild() {
+  {
+    auto handlesLock = getHandles();
+    auto& handles = handlesLock->handles;
+    for (auto& ks : KeySpace::kAll) {
+      if (!usesKeyFilter(ks)) {
+        continue;
+      }
+      uint64_t keyCount = 0;
+      handles->db->GetIntProperty(
+          handles->columns[ks->index].get(),
+          rocksdb::DB::Properties::kEstimateNumKeys,
+          &keyCount);
+      keyFilters_[ks->index] = std::make_unique<BloomFilter>(
+          std::max(keyCount + keyCount / 2, kMinKeyFilterCapacity));
+    }
+  }
+
+  // Building the filters in the background requires shared ownership, which
+  // tools that open the store directly don't bother with: they just don't get
+  // to use the filters.
+  if (weak_from_this().expired()) {
+    return;
+  }
+  for (auto& ks : KeySpace::kAll) {
+    if (keyFilters_[ks->index]) {
+      ioPool_.add([store = getSharedFromThis(), keySpace = KeySpace{ks}] {
+        store->buildKeyFilterSlice(keySpace, std::nullopt);
+      });
+    }
+  }
+}
+
+void RocksDbLocalStore::buildKeyFilterSlice(
+    KeySpace keySpace,
+    std::optional<std::string> resumeKey) {
+  auto& filter = *keyFilters_[keySpace->index];
+  try {
+    // Writes are added to the filter as they happen, so a key is either
+    // visited by the scan or added by its writer.
+    auto handlesLock = getHandles();
+    auto it = newScanIterator(*handlesLock->handles, keySpace, resumeKey);
+    for (size_t added = 0; it->Valid() && added < kKeyFilterSliceKeys;
+         it->Next(), ++added) {
+      filter.insert(toByteRange(it->key()));
+    }
+    RocksException::check(
+        it->status(), "error building the key filter of ", keySpace->name);
+    resumeKey = it->Valid() ? std::make_optional(it->key().ToString())
+                            : std::nullopt;
+  } catch (const std::exception& ex) {
+    // Most likely, the store was closed. Either way, the filter stays unused.
+    XLOG(WARN) << "not using a key filter for " << keySpace->name << ": "
+               << folly::exceptionStr(ex);
+    return;
+  }
+
+  if (!resumeKey) {
+    XLOG(DBG2) << "key filter for " << keySpace->name << " ready with "
+               << filter.getInsertCount() << " keys";
+    keyFilterReady_[keySpace->index].store(true, std::memory_order_release);
+    return;
+  }
+  ioPool_.add([store = getSharedFromThis(),
+               keySpace,
+               resumeKey = std::move(resumeKey)]() mutable {
+    store->buildKeyFilterSlice(keySpace, std::move(resumeKey));
+  });
+}
+
 std::unique_ptr<LocalStore::WriteBatch> RocksDbLocalStore::beginWrite(
     size_t bufSize) {
-  return std::make_unique<RocksDbWriteBatch>(getHandles(), bufSize);
+  return std::make_unique<RocksDbWriteBatch>(
+      getHandles(), keyFilters_, bufSize);
 }
 
 void RocksDbLocalStore::put(
     KeySpace keySpace,
     folly::ByteRange key,
     folly::ByteRange value) {
+  if (auto& filter = keyFilters_[keySpace->index]) {
+    filter->insert(key);
+  }
   auto handlesLock = getHandles();
   auto& handles = handlesLock->handles;
   handles->db->Put(
@@ -638,6 +1025,8 @@ uint64_t RocksDbLocalStore::getApproximateSize(KeySpace keySpace) const {
 }
 
 void RocksDbLocalStore::periodicManagementTask(const EdenConfig& config) {
+  accessTracker_.advanceEpoch();
+
   // Compute and publish the stats
   auto before = computeStats(/*publish=*/true, &config);
 
@@ -670,12 +1059,28 @@ RocksDbLocalStore::SizeSummary RocksDbLocalStore::computeStats(
     if (publish) {
       fb303::fbData->setCounter(
           folly::to<string>(statsPrefix_, ks->name, ".size"), size);
+      if (auto& filter = keyFilters_[ks->index]) {
+        fb303::fbData->setCounter(
+            folly::to<string>(
+                statsPrefix_, ks->name, ".key_filter.memory_bytes"),
+            filter->getMemoryUsage());
+        // fb303 counters are integers: publish parts per million.
+        fb303::fbData->setCounter(
+            folly::to<string>(
+                statsPrefix_, ks->name, ".key_filter.estimated_fp_ppm"),
+            static_cast<int64_t>(
+                filter->getEstimatedFalsePositiveRate() * 1'000'000));
+      }
     }
     if (auto* ephemeral = std::get_if<Ephemeral>(&ks->persistence)) {
       result.ephemeral += size;
       if (config) {
-        if (size > (config->*(ephemeral->cacheLimit)).getValue()) {
+        auto limit = (config->*(ephemeral->cacheLimit)).getValue();
+        if (size > limit) {
           result.excessiveKeySpaces.set(ks->index);
+          auto percent =
+              std::min(config->localStoreGcTargetPercent.getValue(), 100u);
+          result.targetSizes[ks->index] = limit / 100 * percent;
         }
       }
     } else if (!ks->isDeprecated()) {
@@ -721,24 +1126,118 @@ void RocksDbLocalStore::triggerAutoGC(SizeSummary before) {
     state->inProgress_ = true;
   }
 
-  ioPool_.add([store = getSharedFromThis(), before] {
-    try {
-      for (auto& ks : KeySpace::kAll) {
-        if (before.excessiveKeySpaces.test(ks->index)) {
-          store->clearKeySpace(ks);
-          store->compactKeySpace(ks);
+  auto job = std::make_shared<AutoGCJob>();
+  job->before = before;
+  job->remaining = before.excessiveKeySpaces;
+  job->cutoff = autoGCCutoff(0, accessTracker_.getEpoch());
+  ioPool_.add([store = getSharedFromThis(), job = std::move(job)]() mutable {
+    store->runAutoGCSlice(std::move(job));
+  });
+}
+
+void RocksDbLocalStore::runAutoGCSlice(std::shared_ptr<AutoGCJob> job) {
+  try {
+    size_t index = 0;
+    while (index < KeySpace::kTotalCount && !job->remaining.test(index)) {
+      ++index;
+    }
+    if (index == KeySpace::kTotalCount) {
+      XLOG(DBG2) << "automatic local store garbage collection deleted "
+                 << job->deletedKeys << " keys";
+      autoGCFinished(/*successful=*/true, job->before.ephemeral);
+      return;
+    }
+    auto keySpace = KeySpace::kAll[index];
+
+    bool passComplete;
+    if (job->pass < kAutoGCCutoffAges.size()) {
+      passComplete = evictColdKeys(*job, keySpace, job->cutoff);
+    } else {
+      // Everything left was read recently, there is no better choice than
+      // starting over.
+      clearKeySpace(keySpace);
+      passComplete = true;
+    }
+
+    if (passComplete) {
+      // Deleted keys only free space once they are compacted away.
+      compactKeySpace(keySpace);
+      job->resumeKey.reset();
+      auto epoch = accessTracker_.getEpoch();
+      if (job->pass >= kAutoGCCutoffAges.size() ||
+          getApproximateSize(keySpace) <= job->before.targetSizes[index]) {
+        job->remaining.reset(index);
+        job->pass = 0;
+        job->cutoff = autoGCCutoff(0, epoch);
+      } else {
+        // Skip the passes that wouldn't delete anything more, which happens
+        // when EdenFS hasn't been running for long.
+        auto previousCutoff = job->cutoff;
+        do {
+          ++job->pass;
+        } while (job->pass < kAutoGCCutoffAges.size() &&
+                 autoGCCutoff(job->pass, epoch) <= previousCutoff);
+        if (job->pass < kAutoGCCutoffAges.size()) {
+          job->cutoff = autoGCCutoff(job->pass, epoch);
         }
       }
-    } catch (const std::exception& ex) {
-      XLOG(ERR) << "error during automatic local store garbage collection: "
-                << folly::exceptionStr(ex);
-      store->autoGCFinished(/*successful=*/false, before.ephemeral);
-      return;
     }
-    store->autoGCFinished(/*successful=*/true, before.ephemeral);
+  } catch (const std::exception& ex) {
+    XLOG(ERR) << "error during automatic local store garbage collection: "
+              << folly::exceptionStr(ex);
+    autoGCFinished(/*successful=*/false, job->before.ephemeral);
+    return;
+  }
+
+  // Reschedule rather than loop, so that other I/O gets a turn between
+  // slices.
+  ioPool_.add([store = getSharedFromThis(), job = std::move(job)]() mutable {
+    store->runAutoGCSlice(std::move(job));
   });
 }
 
+bool RocksDbLocalStore::evictColdKeys(
+    AutoGCJob& job,
+    KeySpace keySpace,
+    uint32_t cutoff) {
+  auto handlesLock = getHandles();
+  auto& handles = handlesLock->handles;
+  auto columnFamily = handles->columns[keySpace->index].get();
+  auto it = newScanIterator(*handles, keySpace, job.resumeKey);
+
+  rocksdb::WriteBatch batch;
+  for (size_t examined = 0; it->Valid() && examined < kAutoGCSliceKeys;
+       it->Next(), ++examined) {
+    auto key = it->key();
+    // Untracked keys may well be hot: only a sample of reads is tracked,
+    // and not across restarts. Leave them to the final clearing pass.
+    auto lastAccess = accessTracker_.getLastAccess(keySpace, toByteRange(key));
+    if (lastAccess != 0 && lastAccess < cutoff) {
+      batch.Delete(columnFamily, key);
+    }
+  }
+  RocksException::check(
+      it->status(),
+      "error iterating over \"",
+      columnFamily->GetName(),
+      "\" column family");
+
+  bool passComplete = !it->Valid();
+  if (!passComplete) {
+    job.resumeKey = it->key().ToString();
+  }
+
+  if (batch.Count() > 0) {
+    RocksException::check(
+        handles->db->Write(WriteOptions(), &batch),
+        "error deleting cold keys of \"",
+        columnFamily->GetName(),
+        "\" column family");
+    job.deletedKeys += batch.Count();
+  }
+  return passComplete;
+}
+
 void RocksDbLocalStore::autoGCFinished(
     bool successful,
     uint64_t ephemeralSizeBefore) {
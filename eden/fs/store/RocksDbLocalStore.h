@@ -8,10 +8,16 @@
 #pragma once
 
 #include <folly/CppAttributes.h>
+#include <folly/Function.h>
 #include <folly/Synchronized.h>
+#include <array>
+#include <atomic>
 #include <bitset>
+#include <optional>
 
 #include "eden/fs/rocksdb/RocksHandles.h"
+#include "eden/fs/store/BloomFilter.h"
+#include "eden/fs/store/KeyAccessTracker.h"
 #include "eden/fs/store/LocalStore.h"
 #include "eden/fs/utils/UnboundedQueueExecutor.h"
 
@@ -44,10 +50,14 @@ class RocksDbLocalStore final : public LocalStore {
   void clearKeySpace(KeySpace keySpace) override;
   void compactKeySpace(KeySpace keySpace) override;
   StoreResult get(KeySpace keySpace, folly::ByteRange key) const override;
+  using LocalStore::getBatch;
   FOLLY_NODISCARD folly::Future<std::vector<StoreResult>> getBatch(
       KeySpace keySpace,
       const std::vector<folly::ByteRange>& keys) const override;
   bool hasKey(KeySpace keySpace, folly::ByteRange key) const override;
+  using LocalStore::mayContain;
+  bool mayContain(KeySpace keySpace, folly::ByteRange key) const override;
+  void recordAccess(KeySpace keySpace, folly::ByteRange key) const override;
   void put(KeySpace keySpace, folly::ByteRange key, folly::ByteRange value)
       override;
   std::unique_ptr<WriteBatch> beginWrite(size_t bufSize = 0) override;
@@ -59,6 +69,19 @@ class RocksDbLocalStore final : public LocalStore {
   // specified key space.
   uint64_t getApproximateSize(KeySpace keySpace) const;
 
+  /**
+   * Call fn with every key and value of keySpace. When fn returns a value,
+   * it replaces the stored one. Returns the number of values replaced.
+   *
+   * This is meant for offline maintenance, as done by eden_store_util: values
+   * written concurrently may be overwritten.
+   */
+  size_t rewriteKeySpace(
+      KeySpace keySpace,
+      folly::FunctionRef<std::optional<std::string>(
+          folly::ByteRange key,
+          folly::ByteRange value)> fn);
+
   void periodicManagementTask(const EdenConfig& config) override;
 
   enum class RockDbHandleStatus { NOT_YET_OPENED, OPEN, CLOSED };
@@ -70,6 +93,9 @@ class RocksDbLocalStore final : public LocalStore {
     RockDBState();
   };
 
+  using KeyFilters =
+      std::array<std::unique_ptr<BloomFilter>, KeySpace::kTotalCount>;
+
  private:
   /**
    * Get a pointer to the RocksHandles object in order to perform an I/O
@@ -113,6 +139,34 @@ class RocksDbLocalStore final : public LocalStore {
      * cleared.
      */
     std::bitset<KeySpace::kTotalCount> excessiveKeySpaces;
+    /**
+     * The size garbage collection should bring each excessive keyspace down
+     * to.
+     */
+    std::array<uint64_t, KeySpace::kTotalCount> targetSizes{};
+  };
+
+  /**
+   * Progress of an automatic garbage collection.
+   *
+   * GC makes passes over each excessive keyspace, deleting the keys that
+   * haven't been read since a cutoff epoch. Every pass that doesn't bring the
+   * keyspace under its target moves the cutoff closer to the present. Passes
+   * are split into slices of bounded size, each scheduled separately on the
+   * ioPool_ so that GC doesn't hold up other I/O for long.
+   */
+  struct AutoGCJob {
+    SizeSummary before;
+    // Keyspaces that are still over their target.
+    std::bitset<KeySpace::kTotalCount> remaining;
+    // Index into kAutoGCCutoffAges of the current pass.
+    size_t pass{0};
+    // Keys last read before this epoch are deleted by the current pass.
+    uint32_t cutoff{0};
+    // Where the next slice of the current pass starts, or nullopt at the
+    // start of a pass.
+    std::optional<std::string> resumeKey;
+    uint64_t deletedKeys{0};
   };
 
   /**
@@ -121,7 +175,35 @@ class RocksDbLocalStore final : public LocalStore {
    */
   SizeSummary computeStats(bool publish, const EdenConfig* config);
 
+  /**
+   * Size the key filters from the current number of keys, and populate them
+   * in the background. Until a filter holds every key of its keyspace,
+   * mayContain() doesn't use it.
+   */
+  void startKeyFilterBuild();
+  /**
+   * Add a slice of the keys of keySpace, starting at resumeKey, to its key
+   * filter, then schedule the next slice.
+   */
+  void buildKeyFilterSlice(
+      KeySpace keySpace,
+      std::optional<std::string> resumeKey);
+  /**
+   * Count a lookup that missed even though the key filter let it through.
+   */
+  void recordKeyFilterMiss(KeySpace keySpace, folly::ByteRange key) const;
+
   void triggerAutoGC(SizeSummary before);
+  /**
+   * Run one slice of job, then schedule the next one or finish the GC.
+   */
+  void runAutoGCSlice(std::shared_ptr<AutoGCJob> job);
+  /**
+   * Delete up to a slice's worth of keys of keySpace that were last read
+   * before cutoff, starting at job.resumeKey. Returns whether the pass over
+   * the keyspace is complete.
+   */
+  bool evictColdKeys(AutoGCJob& job, KeySpace keySpace, uint32_t cutoff);
   void autoGCFinished(bool successful, uint64_t ephemeralSizeBefore);
 
   std::shared_ptr<StructuredLogger> structuredLogger_;
@@ -129,6 +211,12 @@ class RocksDbLocalStore final : public LocalStore {
   FaultInjector& faultInjector_;
   mutable UnboundedQueueExecutor ioPool_;
   folly::Synchronized<AutoGCState> autoGCState_;
+  // Records reads of ephemeral keyspaces so that GC can evict cold keys first.
+  mutable KeyAccessTracker accessTracker_;
+  // Created by open() for the keyspaces that are looked up on the import
+  // path, and updated on every write.
+  KeyFilters keyFilters_;
+  std::array<std::atomic<bool>, KeySpace::kTotalCount> keyFilterReady_{};
   AbsolutePath pathToDb_;
   RocksDBOpenMode mode_;
   folly::Synchronized<RockDBState> dbHandles_;
@@ -9,8 +9,10 @@
 
 #include <folly/String.h>
 #include <folly/container/Array.h>
+#include <folly/futures/Future.h>
 #include <folly/logging/xlog.h>
 
+#include "eden/fs/sqlite/PersistentSqliteStatement.h"
 #include "eden/fs/sqlite/SqliteStatement.h"
 #include "eden/fs/store/StoreResult.h"
 #include "eden/fs/telemetry/EdenStats.h"
@@ -23,16 +25,36 @@ using std::string;
 
 namespace {
 
+// See commentary in SqliteLocalStore::put re: `or ignore`
+PersistentSqliteStatement::Guard getInsertStatement(
+    LockedSqliteConnection& db,
+    KeySpace keySpace) {
+  return getCachedStatement(
+      db, "insert or ignore into ", keySpace->name, " VALUES(?, ?)");
+}
+
+PersistentSqliteStatement::Guard getSelectStatement(
+    LockedSqliteConnection& db,
+    KeySpace keySpace) {
+  return getCachedStatement(
+      db, "select value from ", keySpace->name, " where key = ?");
+}
+
+void configureConnection(
+    LockedSqliteConnection& db,
+    const SqliteLocalStore::Options& options) {
+  SqliteStatement(db, "PRAGMA mmap_size=", options.mmapSize).step();
+  SqliteStatement(db, "PRAGMA cache_size=", options.cacheSize).step();
+}
+
 /**
  * Implements the write batching helper.
  * In an ideal world, we'd just start a transaction and have the WriteBatch
  * methods accumulate against that transaction, committing on flush.
  * To do that we'd either need to lock the underlying sqlite handle
  * for the lifetime of the WriteBatch, or open a separate database connection.
- * The latter might be interesting to explore if the cost of opening the
- * connection is cheap enough.
  * For now though, we batch up the incoming data and then send it to the
- * database in the flush method.
+ * database in a single transaction in the flush method.
  */
 class SqliteWriteBatch : public LocalStore::WriteBatch {
  public:
@@ -55,42 +77,25 @@ class SqliteWriteBatch : public LocalStore::WriteBatch {
   }
 
   void flush() override {
-    auto db = db_.lock();
-
-    // Start a transaction for the flush operation
-    SqliteStatement(db, "BEGIN").step();
-
-    try {
+    db_.transaction([&](LockedSqliteConnection& db) {
       for (size_t i = 0; i < buffer_.size(); ++i) {
         auto& items = buffer_[i];
         if (items.empty()) {
           continue;
         }
 
-        // See commentary in SqliteLocalStore::put re: `or ignore`
-        SqliteStatement stmt(
-            db,
-            "insert or ignore into ",
-            KeySpace::kAll[i]->name,
-            " VALUES(?, ?)");
-
-        for (const auto& item : items) {
-          const auto& key = item.first;
-          const auto& value = item.second;
-
-          stmt.bind(1, key);
-          stmt.bind(2, value);
-          stmt.step();
+        auto stmt = getInsertStatement(db, KeySpace::kAll[i]);
+        for (const auto& [key, value] : items) {
+          stmt->bind(1, key);
+          stmt->bind(2, value);
+          stmt->step();
         }
-        items.clear();
       }
-
-      SqliteStatement(db, "COMMIT").step();
-    } catch (const std::exception&) {
-      // Speculative rollback to make sure that we're not still in a
-      // transaction if we bail out in the error path
-      SqliteStatement(db, "ROLLBACK").step();
-      throw;
+    });
+    // Only drop the items once they are committed, so that a failed flush
+    // can be retried.
+    for (auto& items : buffer_) {
+      items.clear();
     }
   }
 
@@ -104,7 +109,14 @@ class SqliteWriteBatch : public LocalStore::WriteBatch {
 SqliteLocalStore::SqliteLocalStore(
     AbsolutePathPiece pathToDb,
     EdenStatsPtr edenStats)
+    : SqliteLocalStore{pathToDb, std::move(edenStats), Options{}} {}
+
+SqliteLocalStore::SqliteLocalStore(
+    AbsolutePathPiece pathToDb,
+    EdenStatsPtr edenStats,
+    Options options)
     : LocalStore{std::move(edenStats)},
+      options_{options},
       db_(pathToDb, SqliteDatabase::DelayOpeningDB{}) {}
 
 void SqliteLocalStore::open() {
@@ -112,9 +124,11 @@ void SqliteLocalStore::open() {
   {
     auto db = db_.lock();
 
-    // Write ahead log for faster perf
+    // Write ahead log for faster perf, and so that the read connections
+    // don't block the writer.
     // https://www.sqlite.org/wal.html
     SqliteStatement(db, "PRAGMA journal_mode=WAL").step();
+    configureConnection(db, options_);
 
     for (const auto& ks : KeySpace::kAll) {
       SqliteStatement(
@@ -130,6 +144,11 @@ void SqliteLocalStore::open() {
     }
   }
 
+  db_.openReadConnections(
+      options_.readConnections, [this](LockedSqliteConnection& db) {
+        configureConnection(db, options_);
+      });
+
   clearDeprecatedKeySpaces();
 }
 
@@ -147,47 +166,65 @@ void SqliteLocalStore::clearKeySpace(KeySpace keySpace) {
 void SqliteLocalStore::compactKeySpace(KeySpace) {}
 
 StoreResult SqliteLocalStore::get(KeySpace keySpace, ByteRange key) const {
-  auto db = db_.lock();
-
-  SqliteStatement stmt(
-      db, "select value from ", keySpace->name, " where key = ?");
+  auto db = db_.lockRead();
+  auto stmt = getSelectStatement(db, keySpace);
 
   // Bind the key; parameters are 1-based
-  stmt.bind(1, key);
+  stmt->bind(1, key);
 
-  if (stmt.step()) {
+  if (stmt->step()) {
     // Return the result; columns are 0-based!
-    return StoreResult(stmt.columnBlob(0).str());
+    return StoreResult(stmt->columnBlob(0).str());
   }
 
   // the key does not exist
   return StoreResult::missing(keySpace, key);
 }
 
-bool SqliteLocalStore::hasKey(KeySpace keySpace, ByteRange key) const {
-  auto db = db_.lock();
+folly::Future<std::vector<StoreResult>> SqliteLocalStore::getBatch(
+    KeySpace keySpace,
+    const std::vector<ByteRange>& keys) const {
+  return folly::makeFutureWith([&] {
+    std::vector<StoreResult> results;
+    results.reserve(keys.size());
+
+    // Hold the lock and reuse the prepared statement for the whole batch
+    // rather than locking once per key.
+    auto db = db_.lockRead();
+    auto stmt = getSelectStatement(db, keySpace);
+    for (auto& key : keys) {
+      stmt->bind(1, key);
+      if (stmt->step()) {
+        results.emplace_back(stmt->columnBlob(0).str());
+        stmt->reset();
+      } else {
+        // step() already reset the statement once it ran out of rows.
+        results.push_back(StoreResult::missing(keySpace, key));
+      }
+    }
+    return results;
+  });
+}
 
-  SqliteStatement stmt(db, "select 1 from ", keySpace->name, " where key = ?");
+bool SqliteLocalStore::hasKey(KeySpace keySpace, ByteRange key) const {
+  auto db = db_.lockRead();
+  auto stmt = getCachedStatement(
+      db, "select 1 from ", keySpace->name, " where key = ?");
 
-  stmt.bind(1, key);
-  return stmt.step();
+  stmt->bind(1, key);
+  return stmt->step();
 }
 
 void SqliteLocalStore::put(KeySpace keySpace, ByteRange key, ByteRange value) {
   auto db = db_.lock();
-
-  SqliteStatement stmt(
-      db,
-      // TODO: we need `or ignore` otherwise we hit primary key violations
-      // when running our integration tests.  This implies that we're
-      // over-fetching and that we have a perf improvement opportunity.
-      "insert or ignore into ",
-      keySpace->name,
-      " VALUES(?, ?)");
-
-  stmt.bind(1, key);
-  stmt.bind(2, value);
-  stmt.step();
+  // TODO: we need `or ignore` otherwise we hit primary key violations
+  // when running our integration tests.  This implies that we're
+  // over-fetching and that we have a perf improvement opportunity.
+  auto stmt = getInsertStatement(db, keySpace);
+
+  stmt->bind(1, key);
+  stmt->bind(2, value);
+  stmt->step();
 }
 
 std::unique_ptr<LocalStore::WriteBatch> SqliteLocalStore::beginWrite(size_t) {
@@ -22,12 +22,41 @@ using EdenStatsPtr = RefPtr<EdenStats>;
  * */
 class SqliteLocalStore final : public LocalStore {
  public:
+  struct Options {
+    /**
+     * Read-only connections serving get, getBatch and hasKey, so that they
+     * don't wait for each other or for writes. With none, every query runs
+     * on the single read-write connection.
+     */
+    size_t readConnections = 4;
+
+    /**
+     * Bytes of the database file that every connection may memory map, see
+     * https://www.sqlite.org/pragma.html#pragma_mmap_size
+     */
+    int64_t mmapSize = 256 * 1024 * 1024;
+
+    /**
+     * Page cache size of every connection, in pages when positive and in KiB
+     * when negative, see https://www.sqlite.org/pragma.html#pragma_cache_size
+     */
+    int64_t cacheSize = -16 * 1024;
+  };
+
   explicit SqliteLocalStore(AbsolutePathPiece pathToDb, EdenStatsPtr edenStats);
+  SqliteLocalStore(
+      AbsolutePathPiece pathToDb,
+      EdenStatsPtr edenStats,
+      Options options);
   void open() override;
   void close() override;
   void clearKeySpace(KeySpace keySpace) override;
   void compactKeySpace(KeySpace keySpace) override;
   StoreResult get(KeySpace keySpace, folly::ByteRange key) const override;
+  using LocalStore::getBatch;
+  FOLLY_NODISCARD folly::Future<std::vector<StoreResult>> getBatch(
+      KeySpace keySpace,
+      const std::vector<folly::ByteRange>& keys) const override;
   bool hasKey(KeySpace keySpace, folly::ByteRange key) const override;
   void put(KeySpace keySpace, folly::ByteRange key, folly::ByteRange value)
       override;
@@ -35,6 +64,7 @@ class SqliteLocalStore final : public LocalStore {
       size_t bufSize = 0) override;
 
  private:
+  Options options_;
   mutable SqliteDatabase db_;
 };
 
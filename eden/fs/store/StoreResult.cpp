@@ -31,6 +31,15 @@ StoreResult StoreResult::missing(KeySpace keySpace, folly::ByteRange key) {
           keySpace->name)};
 }
 
+StoreResult StoreResult::pinned(
+    std::shared_ptr<const void> owner,
+    folly::ByteRange data) {
+  StoreResult result{true, std::string{}};
+  result.pinnedOwner_ = std::move(owner);
+  result.pinnedData_ = data;
+  return result;
+}
+
 IOBuf StoreResult::iobufWrapper() const {
   ensureValid();
   return IOBuf{IOBuf::WRAP_BUFFER, bytes()};
@@ -38,6 +47,7 @@ IOBuf StoreResult::iobufWrapper() const {
 
 folly::IOBuf StoreResult::extractIOBuf() {
   ensureValid();
+  unpin();
 
   // Unfortunately RocksDB returns data to us in a std::string.  This makes it
   // difficult for us to control the lifetime.  We end up having to allocate a
@@ -53,6 +63,16 @@ folly::IOBuf StoreResult::extractIOBuf() {
       IOBuf::TAKE_OWNERSHIP, data, size, freeString, stringPtr.release());
 }
 
+void StoreResult::unpin() const {
+  if (!pinnedOwner_) {
+    return;
+  }
+  data_.assign(
+      reinterpret_cast<const char*>(pinnedData_.data()), pinnedData_.size());
+  pinnedOwner_.reset();
+  pinnedData_ = folly::ByteRange{};
+}
+
 [[noreturn]] void StoreResult::throwInvalidError() const {
   // Maybe we should define our own more specific error type in the future
   throw std::domain_error("value not present in store: " + data_);
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <folly/Range.h>
+#include <memory>
 #include <string>
 #include <utility>
 
@@ -31,6 +32,12 @@ class KeySpace;
  * - It is move-only, so prevents us from ever unintentionally copying the
  *   string data.
  * - It provides APIs for creating IOBuf objects around the string result.
+ *
+ * Stores that can hand out a view into memory they manage (e.g. a RocksDB
+ * PinnableSlice pointing into the block cache) can construct a "pinned"
+ * StoreResult instead, which keeps that memory alive without copying it into
+ * a std::string. Consumers that only need bytes() or piece() for the lifetime
+ * of the StoreResult, like tree deserialization, then avoid a copy entirely.
  */
 class StoreResult {
  public:
@@ -44,10 +51,23 @@ class StoreResult {
    */
   explicit StoreResult(std::string data) : StoreResult{true, std::move(data)} {}
 
+  /**
+   * Construct a StoreResult from payload data that lives in memory owned by
+   * owner. The data must remain valid for as long as owner is alive.
+   *
+   * Several results may share the same owner, e.g. the values returned by a
+   * single batched lookup.
+   */
+  static StoreResult pinned(
+      std::shared_ptr<const void> owner,
+      folly::ByteRange data);
+
   StoreResult(StoreResult&& that) noexcept
       : valid_{false}, data_{"moved-from"} {
     std::swap(valid_, that.valid_);
     std::swap(data_, that.data_);
+    std::swap(pinnedOwner_, that.pinnedOwner_);
+    std::swap(pinnedData_, that.pinnedData_);
   }
 
   StoreResult& operator=(StoreResult&& that) noexcept {
@@ -55,6 +75,8 @@ class StoreResult {
     // Allocate the new std::string before performing the no-except swaps.
     valid_ = std::exchange(that.valid_, false);
     data_ = std::exchange(that.data_, std::move(data));
+    pinnedOwner_ = std::move(that.pinnedOwner_);
+    pinnedData_ = std::exchange(that.pinnedData_, folly::ByteRange{});
     return *this;
   }
 
@@ -66,13 +88,25 @@ class StoreResult {
     return valid_;
   }
 
+  /**
+   * Returns true if the payload points into store-owned memory rather than
+   * being held in a std::string.
+   */
+  bool isPinned() const {
+    return pinnedOwner_ != nullptr;
+  }
+
   /**
    * Get a reference to the std::string result.
    *
+   * If the result is pinned, this copies the data into a std::string and
+   * releases the pinned memory.
+   *
    * Throws std::domain_error if the key was not present in the store.
    */
   const std::string& asString() const {
     ensureValid();
+    unpin();
     return data_;
   }
 
@@ -83,6 +117,9 @@ class StoreResult {
    */
   folly::ByteRange bytes() const {
     ensureValid();
+    if (pinnedOwner_) {
+      return pinnedData_;
+    }
     return folly::StringPiece{data_};
   }
 
@@ -92,8 +129,7 @@ class StoreResult {
    * Throws std::domain_error if the key was not present in the store.
    */
   folly::StringPiece piece() const {
-    ensureValid();
-    return folly::StringPiece{data_};
+    return folly::StringPiece{bytes()};
   }
 
   /**
@@ -110,6 +146,7 @@ class StoreResult {
    */
   std::string extractValue() {
     ensureValid();
+    unpin();
     valid_ = false;
     return std::move(data_);
   }
@@ -123,6 +160,10 @@ class StoreResult {
    * This does require a memory allocation to move the stored std::string onto
    * the heap (but it just does a small allocation for the string object
    * itself, and not the string data).
+   *
+   * Pinned data is copied out, rather than shared, so that long-lived objects
+   * built from the IOBuf do not keep store-owned memory (such as RocksDB block
+   * cache blocks) pinned indefinitely.
    */
   folly::IOBuf extractIOBuf();
 
@@ -147,12 +188,20 @@ class StoreResult {
   [[noreturn]] void throwInvalidError() const;
 
   /**
-   * If true, data_ contains the payload from the store.
-   * If false, it contains an error message that includes context about what was
-   * looked up.
+   * Copy pinned data, if any, into data_ and release the pinned memory.
+   */
+  void unpin() const;
+
+  /**
+   * If true, data_ (or pinnedData_, if pinned) contains the payload from the
+   * store. If false, data_ contains an error message that includes context
+   * about what was looked up.
    */
   bool valid_{false};
-  std::string data_;
+  // Mutable so that const accessors that need a std::string can unpin.
+  mutable std::string data_;
+  mutable std::shared_ptr<const void> pinnedOwner_;
+  mutable folly::ByteRange pinnedData_;
 };
 
 } // namespace facebook::eden
@@ -0,0 +1,418 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/TieredLocalStore.h"
+
+#include <cstring>
+
+#include <folly/Exception.h>
+#include <folly/futures/Future.h>
+#include <folly/hash/Checksum.h>
+#include <folly/logging/xlog.h>
+#include <folly/portability/Fcntl.h>
+#include <folly/portability/SysMman.h>
+#include <folly/portability/SysStat.h>
+#include <folly/portability/Unistd.h>
+
+#include "eden/fs/store/StoreResult.h"
+#include "eden/fs/telemetry/EdenStats.h"
+
+namespace facebook::eden {
+
+using folly::ByteRange;
+using folly::StringPiece;
+
+namespace {
+
+/**
+ * Layout of the segment file:
+ *
+ *   SegmentHeader
+ *   RecordHeader, key, value
+ *   RecordHeader, key, value
+ *   ...
+ *   zeroed RecordHeader (end marker, unless the segment is exactly full)
+ *
+ * The checksum covers the rest of the record header, the key and the value,
+ * so records torn by a crash are detected when the segment is loaded.
+ */
+struct SegmentHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t reserved;
+};
+static_assert(sizeof(SegmentHeader) == 16);
+
+struct RecordHeader {
+  uint32_t checksum;
+  uint32_t valueLength;
+  uint16_t keyLength;
+  uint8_t keySpace;
+  uint8_t reserved;
+};
+static_assert(sizeof(RecordHeader) == 12);
+
+constexpr uint32_t kSegmentMagic = 0x534c5445; // "ETLS"
+constexpr uint32_t kSegmentVersion = 1;
+
+/**
+ * Values larger than this fraction of the segment are not worth evicting
+ * everything else for.
+ */
+constexpr size_t kMaxValueFraction = 8;
+
+uint32_t recordChecksum(
+    const RecordHeader& header,
+    ByteRange key,
+    ByteRange value) {
+  auto crc = folly::crc32c(
+      reinterpret_cast<const uint8_t*>(&header) + sizeof(header.checksum),
+      sizeof(RecordHeader) - sizeof(header.checksum));
+  crc = folly::crc32c(key.data(), key.size(), crc);
+  return folly::crc32c(value.data(), value.size(), crc);
+}
+
+} // namespace
+
+TieredLocalStore::TieredLocalStore(
+    AbsolutePathPiece segmentPath,
+    size_t segmentSize,
+    std::shared_ptr<LocalStore> backingStore,
+    EdenStatsPtr edenStats)
+    : LocalStore{std::move(edenStats)},
+      segmentPath_{segmentPath.copy()},
+      segmentSize_{std::min<size_t>(
+          segmentSize,
+          std::numeric_limits<uint32_t>::max())},
+      backingStore_{std::move(backingStore)} {}
+
+TieredLocalStore::~TieredLocalStore() {
+  auto segment = segment_.wlock();
+  if (segment->data) {
+    munmap(segment->data, segment->size);
+  }
+}
+
+bool TieredLocalStore::isHotKeySpace(KeySpace keySpace) {
+  return keySpace->index == KeySpace::TreeFamily.index ||
+      keySpace->index == KeySpace::BlobMetaDataFamily.index;
+}
+
+void TieredLocalStore::open() {
+  backingStore_->open();
+
+  if (segmentSize_ < sizeof(SegmentHeader) + sizeof(RecordHeader)) {
+    XLOG(DBG2) << "Hot tier disabled, segment size is " << segmentSize_;
+    return;
+  }
+
+  // The segment is only a cache: if it can't be opened, run without it
+  // rather than failing to start.
+  try {
+    auto segment = segment_.wlock();
+    segment->file = folly::File{
+        segmentPath_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644};
+
+    struct stat st;
+    folly::checkUnixError(fstat(segment->file.fd(), &st), "fstat failed");
+    bool resized = static_cast<size_t>(st.st_size) != segmentSize_;
+    if (resized) {
+      folly::checkUnixError(
+          ftruncate(segment->file.fd(), segmentSize_), "ftruncate failed");
+    }
+
+    auto* data = mmap(
+        nullptr,
+        segmentSize_,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED,
+        segment->file.fd(),
+        0);
+    if (data == MAP_FAILED) {
+      folly::throwSystemError("mmap failed");
+    }
+    segment->data = static_cast<uint8_t*>(data);
+    segment->size = segmentSize_;
+
+    SegmentHeader header;
+    memcpy(&header, segment->data, sizeof(header));
+    if (resized || header.magic != kSegmentMagic ||
+        header.version != kSegmentVersion) {
+      header = SegmentHeader{kSegmentMagic, kSegmentVersion, 0};
+      memcpy(segment->data, &header, sizeof(header));
+      resetSegment(*segment);
+    } else {
+      loadSegment(*segment);
+    }
+    XLOG(DBG2) << "Opened hot tier " << segmentPath_ << " with "
+               << segment->writeOffset << " bytes in use";
+  } catch (const std::exception& ex) {
+    XLOG(WARN) << "Unable to open hot tier " << segmentPath_ << ": "
+               << ex.what();
+    auto segment = segment_.wlock();
+    if (segment->data) {
+      munmap(segment->data, segment->size);
+    }
+    *segment = Segment{};
+  }
+}
+
+void TieredLocalStore::close() {
+  {
+    auto segment = segment_.wlock();
+    if (segment->data) {
+      munmap(segment->data, segment->size);
+    }
+    *segment = Segment{};
+  }
+  backingStore_->close();
+}
+
+void TieredLocalStore::loadSegment(Segment& segment) {
+  size_t offset = sizeof(SegmentHeader);
+  while (offset + sizeof(RecordHeader) <= segment.size) {
+    RecordHeader header;
+    memcpy(&header, segment.data + offset, sizeof(header));
+    if (header.keyLength == 0) {
+      break;
+    }
+
+    auto keyOffset = offset + sizeof(RecordHeader);
+    auto valueOffset = keyOffset + header.keyLength;
+    auto end = valueOffset + header.valueLength;
+    if (end > segment.size || header.keySpace >= KeySpace::kTotalCount) {
+      XLOG(WARN) << "Hot tier record at offset " << offset
+                 << " is out of bounds, ignoring the rest of the segment";
+      break;
+    }
+    auto key = ByteRange{segment.data + keyOffset, header.keyLength};
+    auto value = ByteRange{segment.data + valueOffset, header.valueLength};
+    if (recordChecksum(header, key, value) != header.checksum) {
+      XLOG(WARN) << "Hot tier record at offset " << offset
+                 << " is corrupted, ignoring the rest of the segment";
+      break;
+    }
+
+    segment.indexes[header.keySpace].insert_or_assign(
+        std::string{StringPiece{key}},
+        Location{
+            static_cast<uint32_t>(valueOffset),
+            static_cast<uint32_t>(header.valueLength)});
+    offset = end;
+  }
+  segment.writeOffset = offset;
+}
+
+void TieredLocalStore::resetSegment(Segment& segment) {
+  for (auto& index : segment.indexes) {
+    index.clear();
+  }
+  segment.writeOffset = sizeof(SegmentHeader);
+  memset(segment.data + segment.writeOffset, 0, sizeof(RecordHeader));
+}
+
+void TieredLocalStore::append(
+    Segment& segment,
+    KeySpace keySpace,
+    ByteRange key,
+    ByteRange value) {
+  auto recordSize = sizeof(RecordHeader) + key.size() + value.size();
+  if (key.empty() || key.size() > std::numeric_limits<uint16_t>::max() ||
+      value.size() > segment.size / kMaxValueFraction) {
+    return;
+  }
+  if (segment.writeOffset + recordSize > segment.size) {
+    resetSegment(segment);
+  }
+
+  RecordHeader header{};
+  header.valueLength = static_cast<uint32_t>(value.size());
+  header.keyLength = static_cast<uint16_t>(key.size());
+  header.keySpace = keySpace->index;
+  header.checksum = recordChecksum(header, key, value);
+
+  auto* out = segment.data + segment.writeOffset;
+  // Write the end marker first, so that a crash in the middle of this append
+  // can't make the loader pick up a record from the previous pass over the
+  // segment.
+  auto end = segment.writeOffset + recordSize;
+  if (end + sizeof(RecordHeader) <= segment.size) {
+    memset(segment.data + end, 0, sizeof(RecordHeader));
+  }
+  memcpy(out + sizeof(RecordHeader), key.data(), key.size());
+  memcpy(out + sizeof(RecordHeader) + key.size(), value.data(), value.size());
+  memcpy(out, &header, sizeof(header));
+
+  segment.indexes[keySpace->index].insert_or_assign(
+      std::string{StringPiece{key}},
+      Location{
+          static_cast<uint32_t>(
+              segment.writeOffset + sizeof(RecordHeader) + key.size()),
+          static_cast<uint32_t>(value.size())});
+  segment.writeOffset = end;
+}
+
+std::optional<StoreResult> TieredLocalStore::getHot(
+    KeySpace keySpace,
+    ByteRange key) const {
+  auto segment = segment_.rlock();
+  if (!segment->data) {
+    return std::nullopt;
+  }
+  auto& index = segment->indexes[keySpace->index];
+  auto it = index.find(StringPiece{key});
+  if (it == index.end()) {
+    return std::nullopt;
+  }
+  // Copy the value out while holding the lock: the segment may be rewound
+  // and overwritten as soon as it is released.
+  return StoreResult{std::string{
+      reinterpret_cast<const char*>(segment->data + it->second.offset),
+      it->second.length}};
+}
+
+void TieredLocalStore::recordHot(
+    KeySpace keySpace,
+    ByteRange key,
+    const StoreResult& result) const {
+  if (!result.isValid()) {
+    return;
+  }
+  auto segment = segment_.wlock();
+  if (!segment->data) {
+    return;
+  }
+  append(*segment, keySpace, key, result.bytes());
+}
+
+size_t TieredLocalStore::getHotEntryCount() const {
+  auto segment = segment_.rlock();
+  size_t count = 0;
+  for (const auto& index : segment->indexes) {
+    count += index.size();
+  }
+  return count;
+}
+
+void TieredLocalStore::clearKeySpace(KeySpace keySpace) {
+  if (isHotKeySpace(keySpace)) {
+    // Records of all the hot KeySpaces are interleaved in the segment, so
+    // they are dropped together.
+    auto segment = segment_.wlock();
+    if (segment->data) {
+      resetSegment(*segment);
+    }
+  }
+  backingStore_->clearKeySpace(keySpace);
+}
+
+void TieredLocalStore::compactKeySpace(KeySpace keySpace) {
+  backingStore_->compactKeySpace(keySpace);
+}
+
+StoreResult TieredLocalStore::get(KeySpace keySpace, ByteRange key) const {
+  if (!isHotKeySpace(keySpace)) {
+    return backingStore_->get(keySpace, key);
+  }
+  if (auto hot = getHot(keySpace, key)) {
+    backingStore_->recordAccess(keySpace, key);
+    return std::move(*hot);
+  }
+  auto result = backingStore_->get(keySpace, key);
+  recordHot(keySpace, key, result);
+  return result;
+}
+
+folly::Future<std::vector<StoreResult>> TieredLocalStore::getBatch(
+    KeySpace keySpace,
+    const std::vector<ByteRange>& keys) const {
+  if (!isHotKeySpace(keySpace)) {
+    return backingStore_->getBatch(keySpace, keys);
+  }
+
+  std::vector<std::optional<StoreResult>> hits;
+  hits.reserve(keys.size());
+  std::vector<ByteRange> misses;
+  for (auto& key : keys) {
+    hits.push_back(getHot(keySpace, key));
+    if (hits.back()) {
+      backingStore_->recordAccess(keySpace, key);
+    } else {
+      misses.push_back(key);
+    }
+  }
+
+  auto self = std::static_pointer_cast<const TieredLocalStore>(
+      shared_from_this());
+  auto missFuture = misses.empty()
+      ? folly::makeFuture(std::vector<StoreResult>{})
+      : backingStore_->getBatch(keySpace, misses);
+  return std::move(missFuture)
+      .thenValue([self = std::move(self),
+                  keySpace,
+                  hits = std::move(hits),
+                  misses = std::move(misses)](
+                     std::vector<StoreResult>&& fetched) mutable {
+        std::vector<StoreResult> results;
+        results.reserve(hits.size());
+        size_t next = 0;
+        for (auto& hit : hits) {
+          if (hit) {
+            results.push_back(std::move(*hit));
+          } else {
+            self->recordHot(keySpace, misses[next], fetched[next]);
+            results.push_back(std::move(fetched[next]));
+            ++next;
+          }
+        }
+        return results;
+      });
+}
+
+void TieredLocalStore::recordAccess(KeySpace keySpace, ByteRange key) const {
+  backingStore_->recordAccess(keySpace, key);
+}
+
+bool TieredLocalStore::hasKey(KeySpace keySpace, ByteRange key) const {
+  if (isHotKeySpace(keySpace)) {
+    auto segment = segment_.rlock();
+    if (segment->indexes[keySpace->index].contains(StringPiece{key})) {
+      return true;
+    }
+  }
+  return backingStore_->hasKey(keySpace, key);
+}
+
+bool TieredLocalStore::mayContain(KeySpace keySpace, ByteRange key) const {
+  // The segment outlives restarts, so it may hold keys the backing store has
+  // since garbage collected.
+  if (isHotKeySpace(keySpace)) {
+    auto segment = segment_.rlock();
+    if (segment->indexes[keySpace->index].contains(StringPiece{key})) {
+      return true;
+    }
+  }
+  return backingStore_->mayContain(keySpace, key);
+}
+
+void TieredLocalStore::put(
+    KeySpace keySpace,
+    ByteRange key,
+    ByteRange value) {
+  backingStore_->put(keySpace, key, value);
+}
+
+std::unique_ptr<LocalStore::WriteBatch> TieredLocalStore::beginWrite(
+    size_t bufSize) {
+  return backingStore_->beginWrite(bufSize);
+}
+
+void TieredLocalStore::periodicManagementTask(const EdenConfig& config) {
+  backingStore_->periodicManagementTask(config);
+}
+
+} // namespace facebook::eden
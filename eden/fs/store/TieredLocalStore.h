@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/File.h>
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <array>
+
+#include "eden/fs/store/LocalStore.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+class EdenStats;
+
+using EdenStatsPtr = RefPtr<EdenStats>;
+
+/**
+ * An implementation of LocalStore that keeps recently read trees and blob
+ * metadata in a bounded, memory-mapped segment file in front of another
+ * LocalStore (typically a RocksDbLocalStore).
+ *
+ * The segment file has a fixed size and is filled append-only with the
+ * entries read from the backing store. When it is full it is rewound and
+ * starts over, so it always holds a subset of the most recently read
+ * entries. Every record is checksummed, and open() rebuilds the index by
+ * scanning the segment, so after a restart the hot entries are served
+ * without touching the backing store at all.
+ *
+ * Since the LocalStore is content-addressed, entries in the segment never go
+ * stale. Writes go straight to the backing store; only reads populate the
+ * segment.
+ */
+class TieredLocalStore final : public LocalStore {
+ public:
+  /**
+   * Create a TieredLocalStore backed by the given store. The segment file at
+   * segmentPath is created if needed and sized to segmentSize bytes.
+   */
+  TieredLocalStore(
+      AbsolutePathPiece segmentPath,
+      size_t segmentSize,
+      std::shared_ptr<LocalStore> backingStore,
+      EdenStatsPtr edenStats);
+  ~TieredLocalStore() override;
+
+  void open() override;
+  void close() override;
+  void clearKeySpace(KeySpace keySpace) override;
+  void compactKeySpace(KeySpace keySpace) override;
+  StoreResult get(KeySpace keySpace, folly::ByteRange key) const override;
+  using LocalStore::getBatch;
+  FOLLY_NODISCARD folly::Future<std::vector<StoreResult>> getBatch(
+      KeySpace keySpace,
+      const std::vector<folly::ByteRange>& keys) const override;
+  bool hasKey(KeySpace keySpace, folly::ByteRange key) const override;
+  using LocalStore::mayContain;
+  bool mayContain(KeySpace keySpace, folly::ByteRange key) const override;
+  void recordAccess(KeySpace keySpace, folly::ByteRange key) const override;
+  void put(KeySpace keySpace, folly::ByteRange key, folly::ByteRange value)
+      override;
+  std::unique_ptr<LocalStore::WriteBatch> beginWrite(
+      size_t bufSize = 0) override;
+  void periodicManagementTask(const EdenConfig& config) override;
+
+  /**
+   * Whether entries of the given KeySpace are kept in the segment.
+   */
+  static bool isHotKeySpace(KeySpace keySpace);
+
+  /**
+   * Number of entries currently indexed in the segment.
+   */
+  size_t getHotEntryCount() const;
+
+ private:
+  struct Location {
+    uint32_t offset;
+    uint32_t length;
+  };
+
+  using Index = folly::F14FastMap<std::string, Location>;
+
+  struct Segment {
+    folly::File file;
+    uint8_t* data{nullptr};
+    size_t size{0};
+    // Where the next record will be appended.
+    size_t writeOffset{0};
+    std::array<Index, KeySpace::kTotalCount> indexes;
+  };
+
+  /**
+   * Rebuild the indexes by scanning the records in the segment, stopping at
+   * the first missing or corrupted one.
+   */
+  static void loadSegment(Segment& segment);
+
+  /**
+   * Drop every record and start writing from the beginning of the segment.
+   */
+  static void resetSegment(Segment& segment);
+
+  /**
+   * Append a record to the segment, rewinding it first if it is full.
+   */
+  static void append(
+      Segment& segment,
+      KeySpace keySpace,
+      folly::ByteRange key,
+      folly::ByteRange value);
+
+  /**
+   * Copy the value of key out of the segment, if present.
+   */
+  std::optional<StoreResult> getHot(KeySpace keySpace, folly::ByteRange key)
+      const;
+
+  /**
+   * Record a value read from the backing store in the segment.
+   */
+  void recordHot(
+      KeySpace keySpace,
+      folly::ByteRange key,
+      const StoreResult& result) const;
+
+  const AbsolutePath segmentPath_;
+  const size_t segmentSize_;
+  const std::shared_ptr<LocalStore> backingStore_;
+  // Readers copy values out under the read lock; appends take the write lock.
+  mutable folly::Synchronized<Segment> segment_;
+};
+
+} // namespace facebook::eden
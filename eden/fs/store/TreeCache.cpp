@@ -26,7 +26,10 @@ void TreeCache::insert(std::shared_ptr<const Tree> tree) {
 TreeCache::TreeCache(std::shared_ptr<ReloadableConfig> config)
       : ObjectCache<Tree, ObjectCacheFlavor::Simple>{
             config->getEdenConfig()->inMemoryTreeCacheSize.getValue(),
-            config->getEdenConfig()->inMemoryTreeCacheMinimumItems.getValue()},
+            config->getEdenConfig()->inMemoryTreeCacheMinimumItems.getValue(),
+            config->getEdenConfig()->inMemoryTreeCacheShards.getValue(),
+            config->getEdenConfig()
+                ->inMemoryTreeCacheEvictionPolicy.getValue()},
         config_{config} {}
 
 } // namespace facebook::eden
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/TreeDiffCache.h"
+
+#include <algorithm>
+
+namespace facebook::eden {
+
+TreeDiffCache::TreeDiffCache(size_t maxEntries)
+    : cache_{folly::in_place, std::max(maxEntries, size_t{1})} {}
+
+std::string TreeDiffCache::makeKey(
+    const ObjectId& scmTree,
+    const ObjectId& wdTree,
+    CaseSensitivity caseSensitive) {
+  // Object ids have variable lengths, so prefix the first one with its length
+  // to keep the keys of different pairs distinct.
+  auto scmBytes = scmTree.getBytes();
+  auto wdBytes = wdTree.getBytes();
+  std::string key;
+  key.reserve(2 + scmBytes.size() + wdBytes.size());
+  key.push_back(caseSensitive == CaseSensitivity::Sensitive ? 's' : 'i');
+  key.push_back(static_cast<char>(scmBytes.size()));
+  key.append(reinterpret_cast<const char*>(scmBytes.data()), scmBytes.size());
+  key.append(reinterpret_cast<const char*>(wdBytes.data()), wdBytes.size());
+  return key;
+}
+
+std::shared_ptr<const TreeDiffSummary> TreeDiffCache::get(
+    const ObjectId& scmTree,
+    const ObjectId& wdTree,
+    CaseSensitivity caseSensitive) {
+  auto key = makeKey(scmTree, wdTree, caseSensitive);
+  auto cache = cache_.lock();
+  auto it = cache->find(key);
+  if (it == cache->end()) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+void TreeDiffCache::insert(
+    const ObjectId& scmTree,
+    const ObjectId& wdTree,
+    CaseSensitivity caseSensitive,
+    std::shared_ptr<const TreeDiffSummary> summary) {
+  auto key = makeKey(scmTree, wdTree, caseSensitive);
+  cache_.lock()->set(std::move(key), std::move(summary));
+}
+
+} // namespace facebook::eden
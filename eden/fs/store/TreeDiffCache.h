@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/utils/CaseSensitivity.h"
+
+namespace facebook::eden {
+
+/**
+ * The entries of two source control trees that a diff has to look at: every
+ * name whose entries are not known to be identical, and the .gitignore file of
+ * the second tree. This is all that a diff of the two trees needs, so a diff
+ * that finds it cached does not have to fetch either tree.
+ */
+struct TreeDiffSummary {
+  using EntryPair = std::pair<
+      std::optional<Tree::value_type>,
+      std::optional<Tree::value_type>>;
+
+  // The entries of each tree with the same name, sorted by name. An entry is
+  // missing if its tree has no entry with that name.
+  std::vector<EntryPair> differences;
+  std::optional<Tree::value_type> gitIgnore;
+};
+
+/**
+ * The summaries of recently diffed pairs of source control trees, keyed by
+ * their ids, so that diffs of commits that share subtrees, in every mount,
+ * do not fetch and compare the same pairs of trees again.
+ */
+class TreeDiffCache {
+ public:
+  explicit TreeDiffCache(size_t maxEntries);
+
+  TreeDiffCache(const TreeDiffCache&) = delete;
+  TreeDiffCache& operator=(const TreeDiffCache&) = delete;
+
+  /**
+   * Returns the summary of the diff of the given trees, or nullptr if it is
+   * not cached.
+   */
+  std::shared_ptr<const TreeDiffSummary> get(
+      const ObjectId& scmTree,
+      const ObjectId& wdTree,
+      CaseSensitivity caseSensitive);
+
+  void insert(
+      const ObjectId& scmTree,
+      const ObjectId& wdTree,
+      CaseSensitivity caseSensitive,
+      std::shared_ptr<const TreeDiffSummary> summary);
+
+ private:
+  static std::string makeKey(
+      const ObjectId& scmTree,
+      const ObjectId& wdTree,
+      CaseSensitivity caseSensitive);
+
+  folly::Synchronized<
+      folly::EvictingCacheMap<
+          std::string,
+          std::shared_ptr<const TreeDiffSummary>>,
+      std::mutex>
+      cache_;
+};
+
+} // namespace facebook::eden
@@ -21,10 +21,12 @@
 
 #include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/config/ReloadableConfig.h"
+#include "eden/fs/model/Tree.h"
 #include "eden/fs/service/EdenInit.h"
 #include "eden/fs/service/EdenStateDir.h"
 #include "eden/fs/store/KeySpace.h"
 #include "eden/fs/store/RocksDbLocalStore.h"
+#include "eden/fs/store/hg/HgProxyHash.h"
 #include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/telemetry/NullStructuredLogger.h"
 #include "eden/fs/utils/FaultInjector.h"
@@ -207,13 +209,107 @@ class ShowSizesCommand : public Command {
   }
 };
 
+class MigrateProxyHashesCommand : public Command {
+ public:
+  static constexpr auto name = StringPiece("migrate_proxy_hashes");
+  static constexpr auto help = StringPiece(
+      "Rewrite the entries of cached trees to the hash-only object ID format");
+
+  void run() override {
+    if (config_->hgObjectIdFormat.getValue() != HgObjectIdFormat::HashOnly) {
+      throw ArgumentError(
+          "hg:object-id-format must be set to hashonly\n"
+          "Otherwise, trees fetched later keep using path-based object IDs.");
+    }
+
+    auto localStore = openLocalStore(RocksDBOpenMode::ReadWrite);
+    size_t trees = 0;
+    size_t entries = 0;
+    size_t unresolved = 0;
+    auto rewritten = localStore->rewriteKeySpace(
+        KeySpace::TreeFamily,
+        [&](folly::ByteRange key,
+            folly::ByteRange value) -> optional<std::string> {
+          ++trees;
+          auto tree =
+              Tree::tryDeserialize(ObjectId{key}, folly::StringPiece{value});
+          if (!tree) {
+            return std::nullopt;
+          }
+
+          Tree::container migrated{tree->getCaseSensitivity()};
+          bool changed = false;
+          for (const auto& [entryName, entry] : *tree) {
+            auto id = migrateObjectId(*localStore, entry.getObjectId());
+            if (!id) {
+              ++unresolved;
+              migrated.emplace(entryName, entry);
+              continue;
+            }
+            changed = true;
+            ++entries;
+            migrated.emplace(
+                entryName,
+                TreeEntry{
+                    *id,
+                    entry.getType(),
+                    entry.getSize(),
+                    entry.getContentSha1(),
+                    entry.getContentBlake3()});
+          }
+          if (!changed) {
+            return std::nullopt;
+          }
+          auto buf = Tree{std::move(migrated), tree->getHash()}.serialize();
+          return buf.moveToFbString().toStdString();
+        });
+
+    // The hgproxyhash key space is kept: the overlay of existing checkouts
+    // may still refer to legacy object IDs.
+    XLOG(INFO) << "Rewrote " << entries << " entries of " << rewritten
+               << " out of " << trees << " trees; " << unresolved
+               << " entries were left as is.";
+  }
+
+ private:
+  /**
+   * The hash-only object ID of id, or std::nullopt if id already is one or
+   * can't be resolved, e.g. because it isn't a Mercurial object ID.
+   */
+  static optional<ObjectId> migrateObjectId(
+      LocalStore& localStore,
+      const ObjectId& id) {
+    if (id.size() == 20) {
+      auto result = localStore.get(KeySpace::HgProxyHashFamily, id);
+      if (!result.isValid()) {
+        return std::nullopt;
+      }
+      return HgProxyHash::makeEmbeddedProxyHash2(
+          HgProxyHash{id, result.extractValue()}.revHash());
+    }
+
+    std::optional<HgProxyHash> embedded;
+    try {
+      embedded = HgProxyHash::tryParseEmbeddedProxyHash(id);
+    } catch (const std::exception&) {
+      return std::nullopt;
+    }
+    auto hashOnly = HgProxyHash::makeEmbeddedProxyHash2(embedded->revHash());
+    if (hashOnly == id) {
+      return std::nullopt;
+    }
+    return hashOnly;
+  }
+};
+
 std::unique_ptr<Command> createCommand(StringPiece name) {
   auto commands = make_array<std::unique_ptr<CommandFactory>>(
       make_unique<CommandFactoryT<GcCommand>>(),
       make_unique<CommandFactoryT<ClearCommand>>(),
       make_unique<CommandFactoryT<CompactCommand>>(),
       make_unique<CommandFactoryT<RepairCommand>>(),
-      make_unique<CommandFactoryT<ShowSizesCommand>>());
+      make_unique<CommandFactoryT<ShowSizesCommand>>(),
+      make_unique<CommandFactoryT<MigrateProxyHashesCommand>>());
 
   std::unique_ptr<Command> command;
   for (const auto& factory : commands) {
@@ -237,14 +333,12 @@ int main(int argc, char** argv) {
   auto loggingConfig = folly::parseLogConfig("eden=DBG2; default:async=true");
   folly::LoggerDB::get().updateConfig(loggingConfig);
 
-  std::unique_ptr<Command> command;
   try {
-    command = createCommand(argv[1]);
+    auto command = createCommand(argv[1]);
+    command->run();
   } catch (const ArgumentError& ex) {
     fprintf(stderr, "error: %s\n", ex.what());
     return EX_SOFTWARE;
   }
-
-  command->run();
   return 0;
 }
@@ -13,6 +13,18 @@
 
 namespace facebook::eden {
 
+/**
+ * How a filter applies to everything below a directory.
+ */
+enum class FilterCoverage {
+  /** Every path below the directory is filtered. */
+  RecursivelyFiltered,
+  /** No path below the directory is filtered. */
+  RecursivelyUnfiltered,
+  /** Paths below the directory must be checked one at a time. */
+  Unknown,
+};
+
 class Filter {
  public:
   virtual ~Filter() {}
@@ -23,5 +35,15 @@ class Filter {
   virtual bool isPathFiltered(
       RelativePathPiece path,
       folly::StringPiece filterId) = 0;
+
+  /*
+   * Checks whether the given filter applies the same way to everything below
+   * a directory, so that its entries don't have to be checked one at a time.
+   */
+  virtual FilterCoverage getCoverageForPath(
+      RelativePathPiece /*path*/,
+      folly::StringPiece /*filterId*/) {
+    return FilterCoverage::Unknown;
+  }
 };
 } // namespace facebook::eden
@@ -8,6 +8,9 @@
 #include "eden/fs/store/git/GitBackingStore.h"
 
 #include <folly/Conv.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/ExecutorWithPriority.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
 #include <folly/futures/Future.h>
 #include <folly/logging/xlog.h>
 #include <git2.h>
@@ -31,7 +34,6 @@
 
 using folly::ByteRange;
 using folly::IOBuf;
-using folly::makeSemiFuture;
 using folly::SemiFuture;
 using folly::StringPiece;
 using std::make_unique;
@@ -56,35 +58,95 @@ void freeBlobIOBufData(void* /*blobData*/, void* blobObject) {
   git_blob_free(gitBlob);
 }
 
-} // namespace
-
-GitBackingStore::GitBackingStore(AbsolutePathPiece repository) {
-  // Make sure libgit2 is initialized.
-  // (git_libgit2_init() is safe to call multiple times if multiple
-  // GitBackingStore objects are created.  git_libgit2_shutdown() should be
-  // called once for each call to git_libgit2_init().)
-  git_libgit2_init();
-
+git_repository* openRepository(AbsolutePathPiece repository) {
+  git_repository* repo = nullptr;
 #if defined(__has_feature)
 #if __has_feature(address_sanitizer)
   __lsan_disable();
 #endif
 #endif
   auto error =
-      git_repository_open(&repo_, std::string{repository.value()}.c_str());
+      git_repository_open(&repo, std::string{repository.value()}.c_str());
 #if defined(__has_feature)
 #if __has_feature(address_sanitizer)
   __lsan_enable();
 #endif
 #endif
   gitCheckError(error, "error opening git repository", repository);
+  return repo;
+}
+
+int8_t toExecutorPriority(ImportPriority priority) {
+  switch (priority.getClass()) {
+    case ImportPriority::Class::Low:
+      return folly::Executor::LO_PRI;
+    case ImportPriority::Class::Normal:
+      return folly::Executor::MID_PRI;
+    case ImportPriority::Class::High:
+      return folly::Executor::HI_PRI;
+  }
+  return folly::Executor::MID_PRI;
+}
+
+} // namespace
+
+GitBackingStore::GitBackingStore(
+    AbsolutePathPiece repository,
+    size_t numThreads)
+    : repoPath_{repository} {
+  // Make sure libgit2 is initialized.
+  // (git_libgit2_init() is safe to call multiple times if multiple
+  // GitBackingStore objects are created.  git_libgit2_shutdown() should be
+  // called once for each call to git_libgit2_init().)
+  git_libgit2_init();
+
+  repo_ = openRepository(repository);
+
+  if (numThreads == 0) {
+    XLOG(WARN)
+        << "GitBackingStore configured to use 0 threads, using one instead";
+    numThreads = 1;
+  }
+  threadPool_ = std::make_unique<folly::CPUThreadPoolExecutor>(
+      numThreads,
+      /*numPriorities=*/3,
+      std::make_shared<folly::NamedThreadFactory>("GitImport"));
 }
 
 GitBackingStore::~GitBackingStore() {
+  // The per-thread repositories are freed as the threads exit, which must
+  // happen before libgit2 is shut down.
+  threadPool_->join();
+  threadPool_.reset();
   git_repository_free(repo_);
   git_libgit2_shutdown();
 }
 
+void GitBackingStore::RepositoryDeleter::operator()(
+    git_repository* repo) const {
+  git_repository_free(repo);
+}
+
+git_repository* GitBackingStore::getThreadRepository() {
+  auto& repo = *threadRepos_;
+  if (!repo) {
+    repo.reset(openRepository(repoPath_));
+  }
+  return repo.get();
+}
+
+template <typename Func>
+auto GitBackingStore::runOnThreadPool(
+    const ObjectFetchContextPtr& context,
+    Func&& func) {
+  return folly::via(
+             folly::ExecutorWithPriority::create(
+                 folly::getKeepAliveToken(*threadPool_),
+                 toExecutorPriority(context->getPriority())),
+             std::forward<Func>(func))
+      .semi();
+}
+
 const char* GitBackingStore::getPath() const {
   return git_repository_path(repo_);
 }
@@ -109,8 +171,12 @@ std::string GitBackingStore::renderObjectId(const ObjectId& objectId) {
 
 ImmediateFuture<TreePtr> GitBackingStore::getRootTree(
     const RootId& rootId,
-    const ObjectFetchContextPtr& /*context*/) {
-  // TODO: Use a separate thread pool to do the git I/O
+    const ObjectFetchContextPtr& context) {
+  return runOnThreadPool(
+      context, [this, rootId] { return getRootTreeImpl(rootId); });
+}
+
+TreePtr GitBackingStore::getRootTreeImpl(const RootId& rootId) {
   XLOG(DBG4) << "resolving tree for commit " << rootId;
 
   // Look up the commit info
@@ -121,7 +187,7 @@ ImmediateFuture<TreePtr> GitBackingStore::getRootTree(
   __lsan_disable();
 #endif
 #endif
-  auto error = git_commit_lookup(&commit, repo_, &commitOID);
+  auto error = git_commit_lookup(&commit, getThreadRepository(), &commitOID);
 #if defined(__has_feature)
 #if __has_feature(address_sanitizer)
   __lsan_enable();
@@ -146,10 +212,11 @@ ImmediateFuture<TreePtr> GitBackingStore::getRootTree(
 
 SemiFuture<BackingStore::GetTreeResult> GitBackingStore::getTree(
     const ObjectId& id,
-    const ObjectFetchContextPtr& /*context*/) {
-  // TODO: Use a separate thread pool to do the git I/O
-  return makeSemiFuture(BackingStore::GetTreeResult{
-      getTreeImpl(id), ObjectFetchContext::Origin::FromDiskCache});
+    const ObjectFetchContextPtr& context) {
+  return runOnThreadPool(context, [this, id] {
+    return BackingStore::GetTreeResult{
+        getTreeImpl(id), ObjectFetchContext::Origin::FromDiskCache};
+  });
 }
 
 TreePtr GitBackingStore::getTreeImpl(const ObjectId& id) {
@@ -162,7 +229,7 @@ TreePtr GitBackingStore::getTreeImpl(const ObjectId& id) {
   __lsan_disable();
 #endif
 #endif
-  auto error = git_tree_lookup(&gitTree, repo_, &treeOID);
+  auto error = git_tree_lookup(&gitTree, getThreadRepository(), &treeOID);
 #if defined(__has_feature)
 #if __has_feature(address_sanitizer)
   __lsan_enable();
@@ -208,10 +275,11 @@ TreePtr GitBackingStore::getTreeImpl(const ObjectId& id) {
 
 SemiFuture<BackingStore::GetBlobResult> GitBackingStore::getBlob(
     const ObjectId& id,
-    const ObjectFetchContextPtr& /*context*/) {
-  // TODO: Use a separate thread pool to do the git I/O
-  return makeSemiFuture(BackingStore::GetBlobResult{
-      getBlobImpl(id), ObjectFetchContext::Origin::FromDiskCache});
+    const ObjectFetchContextPtr& context) {
+  return runOnThreadPool(context, [this, id] {
+    return BackingStore::GetBlobResult{
+        getBlobImpl(id), ObjectFetchContext::Origin::FromDiskCache};
+  });
 }
 
 BlobPtr GitBackingStore::getBlobImpl(const ObjectId& id) {
@@ -224,7 +292,7 @@ BlobPtr GitBackingStore::getBlobImpl(const ObjectId& id) {
   __lsan_disable();
 #endif
 #endif
-  int error = git_blob_lookup(&blob, repo_, &blobOID);
+  int error = git_blob_lookup(&blob, getThreadRepository(), &blobOID);
 #if defined(__has_feature)
 #if __has_feature(address_sanitizer)
   __lsan_enable();
@@ -8,6 +8,8 @@
 #pragma once
 
 #include <folly/Range.h>
+#include <folly/ThreadLocal.h>
+#include <memory>
 
 #include "eden/fs/store/BackingStore.h"
 #include "eden/fs/store/ObjectFetchContext.h"
@@ -16,10 +18,18 @@
 struct git_oid;
 struct git_repository;
 
+namespace folly {
+class CPUThreadPoolExecutor;
+} // namespace folly
+
 namespace facebook::eden {
 
 /**
  * A BackingStore implementation that loads data out of a git repository.
+ *
+ * Objects are read on a pool of threads, in the order of the priority of
+ * their fetch context, so that reads from the filesystem aren't blocked on
+ * git I/O nor on each other.
  */
 class GitBackingStore final : public BijectiveBackingStore {
  public:
@@ -29,8 +39,11 @@ class GitBackingStore final : public BijectiveBackingStore {
    * The LocalStore object is owned by the EdenServer (which also owns this
    * GitBackingStore object).  It is guaranteed to be valid for the lifetime of
    * the GitBackingStore object.
+   *
+   * Objects are read by numThreads threads, each with its own handle to the
+   * repository.
    */
-  explicit GitBackingStore(AbsolutePathPiece repository);
+  GitBackingStore(AbsolutePathPiece repository, size_t numThreads);
   ~GitBackingStore() override;
 
   /**
@@ -76,6 +89,25 @@ class GitBackingStore final : public BijectiveBackingStore {
   GitBackingStore(GitBackingStore const&) = delete;
   GitBackingStore& operator=(GitBackingStore const&) = delete;
 
+  struct RepositoryDeleter {
+    void operator()(git_repository* repo) const;
+  };
+  using RepositoryPtr = std::unique_ptr<git_repository, RepositoryDeleter>;
+
+  /**
+   * Returns the repository handle of the calling thread, opening it on first
+   * use. libgit2 handles must not be used by several threads at once.
+   */
+  git_repository* getThreadRepository();
+
+  /**
+   * Runs func on the thread pool, ahead of the work of lower priority
+   * contexts.
+   */
+  template <typename Func>
+  auto runOnThreadPool(const ObjectFetchContextPtr& context, Func&& func);
+
+  TreePtr getRootTreeImpl(const RootId& rootId);
   TreePtr getTreeImpl(const ObjectId& id);
   BlobPtr getBlobImpl(const ObjectId& id);
 
@@ -84,7 +116,10 @@ class GitBackingStore final : public BijectiveBackingStore {
   static git_oid hash2Oid(const ObjectId& hash);
   static ObjectId oid2Hash(const git_oid* oid);
 
+  AbsolutePath repoPath_;
   git_repository* repo_{nullptr};
+  folly::ThreadLocal<RepositoryPtr> threadRepos_;
+  std::unique_ptr<folly::CPUThreadPoolExecutor> threadPool_;
 };
 
 } // namespace facebook::eden
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/hg/AdaptiveBatchSize.h"
+
+#include <algorithm>
+
+namespace facebook::eden {
+
+uint32_t AdaptiveBatchSize::recordBatch(
+    size_t batchSize,
+    size_t limit,
+    std::chrono::nanoseconds latency,
+    std::chrono::nanoseconds targetLatency,
+    uint32_t minSize,
+    uint32_t maxSize) {
+  maxSize = std::max(minSize, maxSize);
+  auto current = size_.load(std::memory_order_relaxed);
+  uint32_t next;
+  do {
+    next = current;
+    if (latency > targetLatency) {
+      if (limit >= current) {
+        next = current / 2;
+      }
+    } else if (batchSize >= limit && limit >= current) {
+      next = current + kAdditiveIncrease;
+    }
+    next = std::clamp(next, minSize, maxSize);
+    if (next == current) {
+      return current;
+    }
+  } while (!size_.compare_exchange_weak(
+      current, next, std::memory_order_relaxed));
+  return next;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace facebook::eden {
+
+/**
+ * A batch size that adapts to how long batches take to process, using
+ * additive increase and multiplicative decrease.
+ *
+ * A batch that took longer than the target latency halves the size. A batch
+ * that completed in time and was full, meaning that more requests were
+ * likely waiting in the queue, grows it by a constant step. A batch that
+ * wasn't full says nothing about larger batches and leaves the size alone.
+ *
+ * Batches are processed concurrently by several threads. Only a batch that
+ * was dequeued with the current size can decrease it, so that a burst of
+ * slow batches dequeued together halves the size once rather than once per
+ * batch.
+ */
+class AdaptiveBatchSize {
+ public:
+  static constexpr uint32_t kAdditiveIncrease = 8;
+
+  explicit AdaptiveBatchSize(uint32_t initialSize) : size_{initialSize} {}
+
+  uint32_t get() const {
+    return size_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Record that a batch of batchSize requests, dequeued while the size was
+   * limit, took latency to process. The new size is clamped to
+   * [minSize, maxSize] and returned.
+   */
+  uint32_t recordBatch(
+      size_t batchSize,
+      size_t limit,
+      std::chrono::nanoseconds latency,
+      std::chrono::nanoseconds targetLatency,
+      uint32_t minSize,
+      uint32_t maxSize);
+
+ private:
+  std::atomic<uint32_t> size_;
+};
+
+} // namespace facebook::eden
@@ -174,7 +174,7 @@ HgBackingStore::HgBackingStore(
           std::make_shared<HgImporterThreadFactory>(repository, stats.copy()))),
       config_(config),
       serverThreadPool_(serverThreadPool),
-      datapackStore_(repository, computeOptions(), config),
+      datapackStore_(repository, computeOptions(), config, serverThreadPool_),
       logger_(logger) {
   HgImporter importer(repository, stats.copy());
   const auto& options = importer.getOptions();
@@ -197,7 +197,7 @@ HgBackingStore::HgBackingStore(
       importThreadPool_{std::make_unique<HgImporterTestExecutor>(importer)},
       config_(std::move(config)),
       serverThreadPool_{importThreadPool_.get()},
-      datapackStore_(repository, testOptions(), config_),
+      datapackStore_(repository, testOptions(), config_, serverThreadPool_),
       logger_(nullptr) {
   const auto& options = importer->getOptions();
   repoName_ = options.repoName;
@@ -266,6 +266,14 @@ Future<TreePtr> HgBackingStore::importTreeImpl(
         "of FLAGS_hg_fetch_missing_trees"}};
     return folly::makeFuture<TreePtr>(std::move(ew));
   }
+  if (!config_->getEdenConfig()->hgImporterFallback.getValue()) {
+    auto ew = folly::exception_wrapper{std::runtime_error{fmt::format(
+        "tree {} for path \"{}\" not available via edenapi, and "
+        "hg:importer-fallback is disabled",
+        manifestNode,
+        path)}};
+    return folly::makeFuture<TreePtr>(std::move(ew));
+  }
 
   folly::stop_watch<std::chrono::milliseconds> watch;
   auto writeBatch = localStore_->beginWrite();
@@ -284,6 +292,7 @@ folly::Future<TreePtr> HgBackingStore::fetchTreeFromImporter(
     ObjectId edenTreeID,
     RelativePath path,
     std::shared_ptr<LocalStore::WriteBatch> writeBatch) {
+  stats_->increment(&HgBackingStoreStats::importerFallbackTree);
   auto fut = folly::via(
                  importThreadPool_.get(),
                  [this,
@@ -492,6 +501,7 @@ folly::Future<folly::Unit> HgBackingStore::importTreeManifestForRoot(
 
 folly::Future<TreePtr> HgBackingStore::importTreeManifest(
     const ObjectId& commitId) {
+  stats_->increment(&HgBackingStoreStats::importerFallbackManifest);
   return folly::via(
              importThreadPool_.get(),
              [commitId] {
@@ -538,6 +548,14 @@ folly::Future<TreePtr> HgBackingStore::importTreeManifestImpl(
 
 SemiFuture<BlobPtr> HgBackingStore::fetchBlobFromHgImporter(
     HgProxyHash hgInfo) {
+  if (!config_->getEdenConfig()->hgImporterFallback.getValue()) {
+    return folly::makeSemiFuture<BlobPtr>(std::runtime_error{fmt::format(
+        "blob {} for path \"{}\" not available via edenapi, and "
+        "hg:importer-fallback is disabled",
+        hgInfo.revHash(),
+        hgInfo.path())});
+  }
+  stats_->increment(&HgBackingStoreStats::importerFallbackBlob);
   return folly::via(
       importThreadPool_.get(),
       [this,
@@ -8,12 +8,14 @@
 #include "eden/fs/store/hg/HgDatapackStore.h"
 
 #include <folly/Optional.h>
+#include <folly/futures/Future.h>
 #include <folly/io/IOBuf.h>
 #include <folly/logging/xlog.h>
 #include <memory>
 #include <optional>
 
 #include "eden/fs/config/ReloadableConfig.h"
+#include "eden/fs/digest/HashMany.h"
 #include "eden/fs/model/Blob.h"
 #include "eden/fs/model/BlobMetadata.h"
 #include "eden/fs/model/Hash.h"
@@ -93,7 +95,8 @@ TreePtr fromRawTree(
       // need to change to a Trie like datastructure for fast filtering.
       if (filteredPaths.empty() ||
           filteredPaths.count(path + entry.first) == 0) {
-        entries.emplace(entry.first, std::move(entry.second));
+        // Entries come sorted, so this appends without copying the name.
+        entries.insert(std::move(entry));
       }
     } catch (const PathComponentContainsDirectorySeparator& ex) {
       XLOG(WARN) << "Ignoring directory entry: " << ex.what();
@@ -126,11 +129,17 @@ void HgDatapackStore::getTreeBatch(
   auto hgObjectIdFormat = config_->getEdenConfig()->hgObjectIdFormat.getValue();
   const auto& filteredPaths =
       config_->getEdenConfig()->hgFilteredPaths.getValue();
+  auto fetchChildAux =
+      config_->getEdenConfig()->fetchTreeChildAuxMetadata.getValue();
 
+  std::vector<folly::SemiFuture<folly::Unit>> completions;
+  completions.reserve(count);
   store_.getTreeBatch(
       folly::range(requests),
       false,
-      // store_.getTreeBatch is blocking, hence we can take these by reference.
+      fetchChildAux,
+      // We wait for every completion before returning, hence we can take
+      // these by reference.
       [&](size_t index,
           folly::Try<std::shared_ptr<sapling::Tree>> content) mutable {
         if (config_->getEdenConfig()->hgTreeFetchFallback.getValue() &&
@@ -141,27 +150,37 @@ void HgDatapackStore::getTreeBatch(
           return;
         }
         XLOGF(DBG4, "Imported tree node={}", folly::hexlify(requests[index]));
-        auto& importRequest = importRequests[index];
-        auto* treeRequest =
-            importRequest->getRequest<HgImportRequest::TreeImport>();
-        // A proposed folly::Try::and_then would make the following much
-        // simpler.
-        importRequest->getPromise<TreePtr>()->setWith(
-            [&]() -> folly::Try<TreePtr> {
-              if (content.hasException()) {
-                return folly::Try<TreePtr>{std::move(content).exception()};
-              }
-              return folly::Try{fromRawTree(
-                  content.value().get(),
-                  treeRequest->hash,
-                  treeRequest->proxyHash.path(),
-                  hgObjectIdFormat,
-                  filteredPaths)};
-            });
-
-        // Make sure that we're stopping this watch.
-        requestsWatches[index].reset();
+        // Converting the tree, and the callbacks of its promise, which store
+        // it, run while the rest of the batch is fetched.
+        completions.push_back(
+            folly::via(
+                folly::getKeepAliveToken(completionExecutor_),
+                [&, index, content = std::move(content)]() mutable {
+                  auto& importRequest = importRequests[index];
+                  auto* treeRequest =
+                      importRequest->getRequest<HgImportRequest::TreeImport>();
+                  // A proposed folly::Try::and_then would make the following
+                  // much simpler.
+                  importRequest->getPromise<TreePtr>()->setWith(
+                      [&]() -> folly::Try<TreePtr> {
+                        if (content.hasException()) {
+                          return folly::Try<TreePtr>{
+                              std::move(content).exception()};
+                        }
+                        return folly::Try{fromRawTree(
+                            content.value().get(),
+                            treeRequest->hash,
+                            treeRequest->proxyHash.path(),
+                            hgObjectIdFormat,
+                            filteredPaths)};
+                      });
+
+                  // Make sure that we're stopping this watch.
+                  requestsWatches[index].reset();
+                })
+                .semi());
       });
+  folly::collectAll(completions).wait();
 }
 
 TreePtr HgDatapackStore::getTree(
@@ -231,10 +250,13 @@ void HgDatapackStore::getBlobBatch(
     requestsWatches.emplace_back(&liveBatchedBlobWatches_);
   }
 
+  std::vector<folly::SemiFuture<folly::Unit>> completions;
+  completions.reserve(count);
   store_.getBlobBatch(
       folly::range(requests),
       false,
-      // store_.getBlobBatch is blocking, hence we can take these by reference.
+      // We wait for every completion before returning, hence we can take
+      // these by reference.
       [&](size_t index, folly::Try<std::unique_ptr<folly::IOBuf>> content) {
         if (config_->getEdenConfig()->hgBlobFetchFallback.getValue() &&
             content.hasException()) {
@@ -245,21 +267,30 @@ void HgDatapackStore::getBlobBatch(
         }
 
         XLOGF(DBG9, "Imported node={}", folly::hexlify(requests[index]));
-        auto& importRequest = importRequests[index];
-        // A proposed folly::Try::and_then would make the following much
-        // simpler.
-        importRequest->getPromise<BlobPtr>()->setWith(
-            [&]() -> folly::Try<BlobPtr> {
-              if (content.hasException()) {
-                return folly::Try<BlobPtr>{std::move(content).exception()};
-              }
-              return folly::Try{
-                  std::make_shared<BlobPtr::element_type>(*content.value())};
-            });
-
-        // Make sure that we're stopping this watch.
-        requestsWatches[index].reset();
+        completions.push_back(
+            folly::via(
+                folly::getKeepAliveToken(completionExecutor_),
+                [&, index, content = std::move(content)]() mutable {
+                  auto& importRequest = importRequests[index];
+                  // A proposed folly::Try::and_then would make the following
+                  // much simpler.
+                  importRequest->getPromise<BlobPtr>()->setWith(
+                      [&]() -> folly::Try<BlobPtr> {
+                        if (content.hasException()) {
+                          return folly::Try<BlobPtr>{
+                              std::move(content).exception()};
+                        }
+                        return folly::Try{
+                            std::make_shared<BlobPtr::element_type>(
+                                std::move(*content.value()))};
+                      });
+
+                  // Make sure that we're stopping this watch.
+                  requestsWatches[index].reset();
+                })
+                .semi());
       });
+  folly::collectAll(completions).wait();
 }
 
 BlobPtr HgDatapackStore::getBlobLocal(const HgProxyHash& hgInfo) {
@@ -340,6 +371,44 @@ void HgDatapackStore::getBlobMetadataBatch(
       });
 }
 
+void HgDatapackStore::computeLocalBlobMetadataBatch(
+    const std::vector<std::shared_ptr<HgImportRequest>>& importRequests) {
+  std::vector<std::shared_ptr<HgImportRequest>> found;
+  std::vector<BlobPtr> blobs;
+  std::vector<folly::ByteRange> contents;
+  for (const auto& importRequest : importRequests) {
+    auto blob = getBlobLocal(
+        importRequest->getRequest<HgImportRequest::BlobMetaImport>()
+            ->proxyHash);
+    // Chained contents are rare enough to leave to the caller's fallback.
+    if (!blob || blob->getContents().isChained()) {
+      continue;
+    }
+    const auto& buf = blob->getContents();
+    contents.emplace_back(buf.data(), buf.length());
+    found.push_back(importRequest);
+    blobs.push_back(std::move(blob));
+  }
+  if (found.empty()) {
+    return;
+  }
+
+  auto sha1s = sha1Many(folly::range(contents));
+  auto config = config_->getEdenConfig();
+  const auto& blake3Key = config->blake3Key.getValue();
+  std::optional<folly::ByteRange> key;
+  if (blake3Key) {
+    key.emplace(folly::StringPiece{*blake3Key});
+  }
+  auto blake3s = blake3Many(folly::range(contents), key);
+
+  for (size_t i = 0; i < found.size(); ++i) {
+    found[i]->getPromise<BlobMetadataPtr>()->setValue(
+        std::make_shared<BlobMetadataPtr::element_type>(
+            Hash20{sha1s[i]}, Hash32{blake3s[i]}, contents[i].size()));
+  }
+}
+
 void HgDatapackStore::flush() {
   store_.flush();
 }
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <folly/Executor.h>
 #include <folly/Range.h>
 #include <folly/futures/Promise.h>
 
@@ -29,12 +30,25 @@ class HgDatapackStore {
  public:
   using Options = sapling::BackingStoreOptions;
 
+  /**
+   * The objects fetched by batches are converted, and their requests
+   * fulfilled, on completionExecutor, while the rest of the batch is still
+   * being fetched.
+   */
   HgDatapackStore(
       AbsolutePathPiece repository,
       const Options& options,
-      std::shared_ptr<ReloadableConfig> config)
-      : store_{repository.view(), options}, config_{std::move(config)} {}
+      std::shared_ptr<ReloadableConfig> config,
+      folly::Executor* completionExecutor)
+      : store_{repository.view(), options},
+        config_{std::move(config)},
+        completionExecutor_{completionExecutor} {}
 
+  /**
+   * Import multiple trees at once. Returns once the promises of all the
+   * imported trees have been fulfilled. Promises of trees that failed to
+   * import are left untouched when falling back to HgImporter.
+   */
   void getTreeBatch(
       const std::vector<std::shared_ptr<HgImportRequest>>& requests);
 
@@ -54,7 +68,8 @@ class HgDatapackStore {
   /**
    * Import multiple blobs at once. The vector parameters have to be the same
    * length. Promises passed in will be resolved if a blob is successfully
-   * imported. Otherwise the promise will be left untouched.
+   * imported. Otherwise the promise will be left untouched. Returns once all
+   * the promises have been fulfilled.
    */
   void getBlobBatch(
       const std::vector<std::shared_ptr<HgImportRequest>>& requests);
@@ -78,6 +93,14 @@ class HgDatapackStore {
   void getBlobMetadataBatch(
       const std::vector<std::shared_ptr<HgImportRequest>>& requests);
 
+  /**
+   * Compute the metadata of the blobs that are available locally, hashing
+   * them together, and resolve the promises of their requests with it.
+   * Requests whose blob isn't available locally are left untouched.
+   */
+  void computeLocalBlobMetadataBatch(
+      const std::vector<std::shared_ptr<HgImportRequest>>& requests);
+
   /**
    * Flush any pending writes to disk.
    *
@@ -113,6 +136,7 @@ class HgDatapackStore {
  private:
   sapling::SaplingNativeBackingStore store_;
   std::shared_ptr<ReloadableConfig> config_;
+  folly::Executor* completionExecutor_;
 
   mutable RequestMetricsScope::LockedRequestWatchList liveBatchedBlobWatches_;
   mutable RequestMetricsScope::LockedRequestWatchList liveBatchedTreeWatches_;
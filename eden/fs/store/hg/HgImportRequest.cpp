@@ -10,6 +10,7 @@
 #include <folly/Try.h>
 #include <folly/futures/Future.h>
 #include <folly/futures/Promise.h>
+#include <algorithm>
 
 #include "eden/fs/telemetry/RequestMetricsScope.h"
 
@@ -70,4 +71,33 @@ std::shared_ptr<HgImportRequest> HgImportRequest::makeBlobMetaImportRequest(
   return makeRequest<BlobMetaImport>(priority, cause, pid, hash, proxyHash);
 }
 
+void HgImportRequest::setCancellation(
+    folly::CancellationToken cancellationToken,
+    std::optional<std::chrono::steady_clock::time_point> deadline) {
+  callers_.clear();
+  abandonable_ = cancellationToken.canBeCancelled() || deadline.has_value();
+  if (abandonable_) {
+    callers_.push_back(Caller{std::move(cancellationToken), deadline});
+  }
+}
+
+void HgImportRequest::addCallers(const HgImportRequest& other) {
+  if (!other.abandonable_) {
+    abandonable_ = false;
+    callers_.clear();
+  } else if (abandonable_) {
+    callers_.insert(
+        callers_.end(), other.callers_.begin(), other.callers_.end());
+  }
+}
+
+bool HgImportRequest::isAbandoned(
+    std::chrono::steady_clock::time_point now) const {
+  return abandonable_ &&
+      std::all_of(callers_.begin(), callers_.end(), [&](const Caller& caller) {
+           return caller.cancellationToken.isCancellationRequested() ||
+               (caller.deadline.has_value() && now >= *caller.deadline);
+         });
+}
+
 } // namespace facebook::eden
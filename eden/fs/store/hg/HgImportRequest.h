@@ -7,9 +7,13 @@
 
 #pragma once
 
+#include <folly/CancellationToken.h>
 #include <folly/futures/Promise.h>
+#include <chrono>
+#include <optional>
 #include <utility>
 #include <variant>
+#include <vector>
 
 #include "eden/fs/model/Blob.h"
 #include "eden/fs/model/Hash.h"
@@ -123,6 +127,34 @@ class HgImportRequest {
     priority_ = priority;
   }
 
+  /**
+   * Once the token is cancelled or the deadline has passed, the caller that
+   * made this request doesn't wait for it anymore.
+   */
+  void setCancellation(
+      folly::CancellationToken cancellationToken,
+      std::optional<std::chrono::steady_clock::time_point> deadline);
+
+  /**
+   * Also wait for this request on behalf of the callers of other, a request
+   * for the same object that was de-duplicated into this one.
+   *
+   * Like the promises of the de-duplicated requests, this is guarded by the
+   * HgImportRequestQueue.
+   */
+  void addCallers(const HgImportRequest& other);
+
+  /**
+   * Whether none of the callers waiting for this request still do.
+   */
+  bool isAbandoned(std::chrono::steady_clock::time_point now) const;
+
+  const ObjectId& getHash() const noexcept {
+    return std::visit(
+        [](const auto& request) -> const ObjectId& { return request.hash; },
+        request_);
+  }
+
   template <typename T>
   folly::Promise<T>* getPromise() {
     auto promise = std::get_if<folly::Promise<T>>(&promise_); // Promise<T>
@@ -137,10 +169,35 @@ class HgImportRequest {
     return unique_;
   }
 
+  /**
+   * The ID of the filesystem request that made this import, see
+   * ObjectFetchContext::getRequestId. De-duplicated requests keep the ID of
+   * the first one.
+   */
+  uint64_t getRequestId() const {
+    return requestId_;
+  }
+
+  void setRequestId(uint64_t requestId) {
+    requestId_ = requestId;
+  }
+
   std::chrono::steady_clock::time_point getRequestTime() const {
     return requestTime_;
   }
 
+  /**
+   * When a worker took this request out of the queue. Only valid once it
+   * did.
+   */
+  std::chrono::steady_clock::time_point getDequeueTime() const {
+    return dequeueTime_;
+  }
+
+  void setDequeueTime(std::chrono::steady_clock::time_point time) {
+    dequeueTime_ = time;
+  }
+
  private:
   /**
    * Implementation detail of the various make*Request functions.
@@ -167,8 +224,22 @@ class HgImportRequest {
   OptionalProcessId pid_;
   Response promise_;
   uint64_t unique_ = generateUniqueID();
+  uint64_t requestId_ = 0;
   std::chrono::steady_clock::time_point requestTime_ =
       std::chrono::steady_clock::now();
+  std::chrono::steady_clock::time_point dequeueTime_;
+
+  struct Caller {
+    folly::CancellationToken cancellationToken;
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+  };
+
+  /**
+   * False once one of the callers will wait for the request until it
+   * completes, in which case callers_ is empty.
+   */
+  bool abandonable_ = false;
+  std::vector<Caller> callers_;
 
   friend bool operator<(
       const HgImportRequest& lhs,
@@ -6,19 +6,55 @@
  */
 
 #include "eden/fs/store/hg/HgImportRequestQueue.h"
+#include <folly/CancellationToken.h>
 #include <folly/MapUtil.h>
 #include <folly/futures/Future.h>
+#include <folly/logging/xlog.h>
 #include <algorithm>
+#include <chrono>
+#include <limits>
 #include "eden/fs/config/ReloadableConfig.h"
 
 namespace facebook::eden {
 
+namespace {
+
+template <typename ImportType>
+void cancelImport(HgImportRequest& request) {
+  auto error = folly::make_exception_wrapper<folly::OperationCancelled>();
+  for (auto& promise : request.getRequest<ImportType>()->promises) {
+    promise.setException(error);
+  }
+  request.getPromise<typename ImportType::Response>()->setException(error);
+}
+
+} // namespace
+
 void HgImportRequestQueue::stop() {
-  auto state = state_.lock();
-  if (state->running) {
-    state->running = false;
-    queueCV_.notify_all();
+  if (running_.exchange(false)) {
+    std::lock_guard<std::mutex> lock{sleepMutex_};
+    for (auto& sleepers : sleepers_) {
+      sleepers.cv.notify_all();
+    }
+  }
+}
+
+size_t HgImportRequestQueue::estimateMemoryUsage() const {
+  // Every request is shared by its tracker entry and its bucket entries.
+  constexpr size_t kRequestSize =
+      sizeof(std::pair<const ObjectId, std::shared_ptr<QueuedRequest>>) +
+      sizeof(QueuedRequest) + sizeof(HgImportRequest);
+  size_t requestCount = 0;
+  for (const auto* importQueue : {&treeQueue_, &blobQueue_, &blobMetaQueue_}) {
+    for (const auto& trackerShard : importQueue->trackerShards) {
+      requestCount += trackerShard.lock()->size();
+    }
+  }
+  size_t entryCount = 0;
+  for (const auto& queuedEntries : queuedEntries_) {
+    entryCount += queuedEntries.load(std::memory_order_relaxed);
   }
+  return requestCount * kRequestSize + entryCount * sizeof(BucketEntry);
 }
 
 folly::Future<BlobPtr> HgImportRequestQueue::enqueueBlob(
@@ -37,156 +73,252 @@ folly::Future<BlobMetadataPtr> HgImportRequestQueue::enqueueBlobMeta(
       std::move(request));
 }
 
+size_t HgImportRequestQueue::getBucketIndex(ImportPriority priority) {
+  // The class is in the most significant bits of a priority, so every
+  // priority of a bucket is higher than every priority of the next one.
+  auto cls = priority.getClass();
+  if (cls > ImportPriority::Class::Normal) {
+    return 0;
+  } else if (cls == ImportPriority::Class::Normal) {
+    return 1;
+  } else {
+    return 2;
+  }
+}
+
+void HgImportRequestQueue::push(
+    ImportQueue& importQueue,
+    ImportPriority priority,
+    std::shared_ptr<QueuedRequest> queued) {
+  auto bucketIndex = getBucketIndex(priority);
+  // Count the entry before it can be popped, so that the count never
+  // underflows.
+  queuedEntries_[bucketIndex].fetch_add(1);
+  {
+    auto bucket = importQueue.buckets[bucketIndex].lock();
+    bucket->push_back(BucketEntry{priority, std::move(queued)});
+    std::push_heap(bucket->begin(), bucket->end());
+  }
+
+  // Pairs with dequeue() counting itself as sleeping before checking
+  // queuedEntries_: either it sees the new entry, or this sees it sleeping.
+  // Wake up the dequeue() that serves the fewest buckets, leaving the others
+  // available for lower priority requests.
+  for (auto index = bucketIndex; index < kClassCount; ++index) {
+    if (sleepers_[index].count.load() > 0) {
+      std::lock_guard<std::mutex> lock{sleepMutex_};
+      sleepers_[index].cv.notify_one();
+      return;
+    }
+  }
+}
+
 template <typename T, typename ImportType>
 folly::Future<std::shared_ptr<const T>> HgImportRequestQueue::enqueue(
     std::shared_ptr<HgImportRequest> request) {
-  auto state = state_.lock();
-  auto* importQueue = getImportQueue<const T>(state);
-  auto* requestQueue = &importQueue->queue;
-
+  auto& importQueue = getImportQueue<const T>();
   const auto& hash = request->getRequest<ImportType>()->hash;
-  if (auto* existingRequestPtr =
-          folly::get_ptr(importQueue->requestTracker, hash)) {
-    auto& existingRequest = *existingRequestPtr;
-    auto* trackedImport = existingRequest->template getRequest<ImportType>();
-
-    auto [promise, future] =
-        folly::makePromiseContract<std::shared_ptr<const T>>();
-    trackedImport->promises.emplace_back(std::move(promise));
-
-    if (existingRequest->getPriority() < request->getPriority()) {
-      existingRequest->setPriority(request->getPriority());
-
-      // Since the new request has a higher priority than the already present
-      // one, we need to re-order the heap.
-      //
-      // TODO(xavierd): this has a O(n) complexity, and enqueing tons of
-      // duplicated requests will thus lead to a quadratic complexity.
-      std::make_heap(
-          requestQueue->begin(),
-          requestQueue->end(),
-          [](const std::shared_ptr<HgImportRequest>& lhs,
-             const std::shared_ptr<HgImportRequest>& rhs) {
-            return (*lhs) < (*rhs);
-          });
+  auto priority = request->getPriority();
+
+  std::shared_ptr<QueuedRequest> queued;
+  {
+    auto requestTracker = importQueue.getTrackerShard(hash).lock();
+    if (auto* existingPtr = folly::get_ptr(*requestTracker, hash)) {
+      auto& existing = *existingPtr;
+      auto* trackedImport =
+          existing->request->template getRequest<ImportType>();
+
+      auto [promise, future] =
+          folly::makePromiseContract<std::shared_ptr<const T>>();
+      trackedImport->promises.emplace_back(std::move(promise));
+      existing->request->addCallers(*request);
+
+      if (!existing->claimed.load() &&
+          existing->request->getPriority() < priority) {
+        existing->request->setPriority(priority);
+
+        // Rather than reordering the bucket, push the request again at the
+        // new priority, possibly into a higher class bucket. Whichever entry
+        // is popped first claims it.
+        push(importQueue, priority, existing);
+      }
+
+      return std::move(future).toUnsafeFuture();
     }
 
-    return std::move(future).toUnsafeFuture();
+    queued = std::make_shared<QueuedRequest>(request);
+    requestTracker->emplace(hash, queued);
   }
 
-  requestQueue->emplace_back(request);
-  auto promise = request->getPromise<std::shared_ptr<const T>>();
+  // Get the future before the request is visible to dequeue(): the promise
+  // isn't safe to use from several threads at once.
+  auto future = request->getPromise<std::shared_ptr<const T>>()->getFuture();
+  push(importQueue, priority, std::move(queued));
+  return future;
+}
 
-  importQueue->requestTracker.emplace(hash, std::move(request));
+void HgImportRequestQueue::popRequests(
+    ImportQueue& importQueue,
+    size_t firstBucket,
+    size_t lastBucket,
+    size_t count,
+    std::vector<std::shared_ptr<HgImportRequest>>& result) {
+  for (size_t index = firstBucket; index <= lastBucket && result.size() < count;
+       ++index) {
+    auto bucket = importQueue.buckets[index].lock();
+    while (!bucket->empty() && result.size() < count) {
+      std::pop_heap(bucket->begin(), bucket->end());
+      auto queued = std::move(bucket->back().queued);
+      bucket->pop_back();
+      queuedEntries_[index].fetch_sub(1);
 
-  std::push_heap(
-      requestQueue->begin(),
-      requestQueue->end(),
-      [](const std::shared_ptr<HgImportRequest>& lhs,
-         const std::shared_ptr<HgImportRequest>& rhs) {
-        return (*lhs) < (*rhs);
-      });
+      if (!queued->claimed.exchange(true)) {
+        result.emplace_back(queued->request);
+      }
+    }
+  }
+}
 
-  queueCV_.notify_one();
+void HgImportRequestQueue::dropAbandonedRequests(
+    ImportQueue& importQueue,
+    std::vector<std::shared_ptr<HgImportRequest>>& requests) {
+  auto now = std::chrono::steady_clock::now();
+  std::vector<std::shared_ptr<HgImportRequest>> abandoned;
+  auto kept = requests.begin();
+  for (auto& request : requests) {
+    // Checked under the lock of the tracker shard so that no caller joins the
+    // request after it's found abandoned: they enqueue a new request instead.
+    auto requestTracker =
+        importQueue.getTrackerShard(request->getHash()).lock();
+    if (request->isAbandoned(now)) {
+      requestTracker->erase(request->getHash());
+      abandoned.push_back(std::move(request));
+    } else {
+      *kept++ = std::move(request);
+    }
+  }
+  requests.erase(kept, requests.end());
 
-  return promise->getFuture();
+  for (auto& request : abandoned) {
+    XLOGF(DBG4, "Dropping abandoned import of {}", request->getHash());
+    if (request->isType<HgImportRequest::BlobImport>()) {
+      cancelImport<HgImportRequest::BlobImport>(*request);
+    } else if (request->isType<HgImportRequest::TreeImport>()) {
+      cancelImport<HgImportRequest::TreeImport>(*request);
+    } else if (request->isType<HgImportRequest::BlobMetaImport>()) {
+      cancelImport<HgImportRequest::BlobMetaImport>(*request);
+    }
+  }
 }
 
 std::vector<std::shared_ptr<HgImportRequest>>
 HgImportRequestQueue::combineAndClearRequestQueues() {
-  auto state = state_.lock();
-  auto treeQSz = state->treeQueue.queue.size();
-  auto blobQSz = state->blobQueue.queue.size();
-  auto blobMetaQSz = state->blobMetaQueue.queue.size();
+  std::vector<std::shared_ptr<HgImportRequest>> res;
+  constexpr auto kAll = std::numeric_limits<size_t>::max();
+  popRequests(treeQueue_, 0, kClassCount - 1, kAll, res);
+  auto treeQSz = res.size();
+  popRequests(blobQueue_, 0, kClassCount - 1, kAll, res);
+  auto blobQSz = res.size() - treeQSz;
+  popRequests(blobMetaQueue_, 0, kClassCount - 1, kAll, res);
+  auto blobMetaQSz = res.size() - treeQSz - blobQSz;
   XLOGF(
       DBG5,
       "combineAndClearRequestQueues: tree queue size = {}, blob queue size = {}, blob metadata queue size = {}",
       treeQSz,
       blobQSz,
       blobMetaQSz);
-  auto res = std::move(state->treeQueue.queue);
-  res.insert(
-      res.end(),
-      std::make_move_iterator(state->blobQueue.queue.begin()),
-      std::make_move_iterator(state->blobQueue.queue.end()));
-  res.insert(
-      res.end(),
-      std::make_move_iterator(state->blobMetaQueue.queue.begin()),
-      std::make_move_iterator(state->blobMetaQueue.queue.end()));
-  state->treeQueue.queue.clear();
-  state->blobQueue.queue.clear();
-  state->blobMetaQueue.queue.clear();
-  XCHECK_EQ(res.size(), treeQSz + blobQSz + blobMetaQSz);
   return res;
 }
 
 std::vector<std::shared_ptr<HgImportRequest>> HgImportRequestQueue::dequeue() {
-  size_t count;
-  std::vector<std::shared_ptr<HgImportRequest>>* queue = nullptr;
+  auto config = config_->getEdenConfig();
+  return dequeue(BatchSizes{
+      config->importBatchSizeTree.getValue(),
+      config->importBatchSizeBlobMeta.getValue(),
+      config->importBatchSize.getValue(),
+  });
+}
+
+std::vector<std::shared_ptr<HgImportRequest>> HgImportRequestQueue::dequeue(
+    const BatchSizes& batchSizes,
+    ImportPriority::Class minimumClass) {
+  std::vector<std::shared_ptr<HgImportRequest>> result;
+  auto lastBucket = getBucketIndex(ImportPriority{minimumClass});
+  auto dropAbandoned =
+      config_->getEdenConfig()->hgDropAbandonedImports.getValue();
 
-  auto state = state_.lock();
   while (true) {
-    if (!state->running) {
-      state->treeQueue.queue.clear();
-      state->blobQueue.queue.clear();
-      state->blobMetaQueue.queue.clear();
+    if (!running_.load()) {
+      combineAndClearRequestQueues();
       return std::vector<std::shared_ptr<HgImportRequest>>();
     }
 
-    auto highestPriority = ImportPriority::minimumValue();
-
     // Trees have a higher priority than blobs, thus check the queues in that
     // order.  The reason for trees having a higher priority is due to trees
     // allowing a higher fan-out and thus increasing concurrency of fetches
     // which translate onto a higher overall throughput.
-    if (!state->treeQueue.queue.empty()) {
-      count = config_->getEdenConfig()->importBatchSizeTree.getValue();
-      highestPriority = state->treeQueue.queue.front()->getPriority();
-      queue = &state->treeQueue.queue;
-    }
+    const std::array<std::pair<ImportQueue*, size_t>, 3> queues{{
+        {&treeQueue_, batchSizes.tree},
+        {&blobMetaQueue_, batchSizes.blobMeta},
+        {&blobQueue_, batchSizes.blob},
+    }};
 
-    if (!state->blobMetaQueue.queue.empty()) {
-      auto priority = state->blobMetaQueue.queue.front()->getPriority();
-      if (!queue || priority > highestPriority) {
-        queue = &state->blobMetaQueue.queue;
-        count = config_->getEdenConfig()->importBatchSizeBlobMeta.getValue();
-        highestPriority = priority;
-      }
-    }
-
-    if (!state->blobQueue.queue.empty()) {
-      auto priority = state->blobQueue.queue.front()->getPriority();
-      if (!queue || priority > highestPriority) {
-        queue = &state->blobQueue.queue;
-        count = config_->getEdenConfig()->importBatchSize.getValue();
-        highestPriority = priority;
+    // Buckets are ordered by priority class, so the highest priority request
+    // is at the front of the first non-empty bucket of one of the queues.
+    ImportQueue* queue = nullptr;
+    size_t count = 0;
+    size_t bucketIndex = 0;
+    for (; bucketIndex <= lastBucket && !queue; ++bucketIndex) {
+      auto highestPriority = ImportPriority::minimumValue();
+      for (auto [importQueue, batchSize] : queues) {
+        auto bucket = importQueue->buckets[bucketIndex].lock();
+        if (!bucket->empty() &&
+            (!queue || bucket->front().priority > highestPriority)) {
+          queue = importQueue;
+          count = batchSize;
+          highestPriority = bucket->front().priority;
+        }
       }
     }
 
     if (queue) {
-      break;
-    } else {
-      queueCV_.wait(state.as_lock());
+      // Other dequeues may have emptied the bucket in the meantime, or it
+      // may only hold requests that were claimed already: try again then.
+      popRequests(
+          *queue,
+          bucketIndex - 1,
+          lastBucket,
+          std::max<size_t>(count, 1),
+          result);
+      if (dropAbandoned) {
+        dropAbandonedRequests(*queue, result);
+      }
+      if (!result.empty()) {
+        auto now = std::chrono::steady_clock::now();
+        for (auto& request : result) {
+          request->setDequeueTime(now);
+        }
+        return result;
+      }
+      continue;
     }
-  }
 
-  count = std::min(count, queue->size());
-  std::vector<std::shared_ptr<HgImportRequest>> result;
-  result.reserve(count);
-  for (size_t i = 0; i < count; i++) {
-    std::pop_heap(
-        queue->begin(),
-        queue->end(),
-        [](const std::shared_ptr<HgImportRequest>& lhs,
-           const std::shared_ptr<HgImportRequest>& rhs) {
-          return (*lhs) < (*rhs);
-        });
-
-    result.emplace_back(std::move(queue->back()));
-    queue->pop_back();
+    auto& sleepers = sleepers_[lastBucket];
+    std::unique_lock<std::mutex> lock{sleepMutex_};
+    sleepers.count.fetch_add(1);
+    sleepers.cv.wait(lock, [&] {
+      if (!running_.load()) {
+        return true;
+      }
+      for (size_t index = 0; index <= lastBucket; ++index) {
+        if (queuedEntries_[index].load() > 0) {
+          return true;
+        }
+      }
+      return false;
+    });
+    sleepers.count.fetch_sub(1);
   }
-
-  return result;
 }
 
 } // namespace facebook::eden
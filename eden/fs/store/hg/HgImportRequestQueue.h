@@ -10,6 +10,8 @@
 #include <folly/Synchronized.h>
 #include <folly/Try.h>
 #include <folly/container/F14Map.h>
+#include <array>
+#include <atomic>
 #include <condition_variable>
 #include <mutex>
 #include <vector>
@@ -59,6 +61,32 @@ class HgImportRequestQueue {
    */
   std::vector<std::shared_ptr<HgImportRequest>> dequeue();
 
+  /**
+   * The maximum number of requests of each type dequeue() returns at once.
+   */
+  struct BatchSizes {
+    size_t tree;
+    size_t blobMeta;
+    size_t blob;
+  };
+
+  /**
+   * Like dequeue(), but with the batch sizes given by the caller rather than
+   * the config. Sizes of 0 are treated as 1.
+   *
+   * Only requests of minimumClass or a higher priority class are returned,
+   * which lets the caller reserve workers for interactive requests.
+   */
+  std::vector<std::shared_ptr<HgImportRequest>> dequeue(
+      const BatchSizes& batchSizes,
+      ImportPriority::Class minimumClass = ImportPriority::Class::Low);
+
+  /**
+   * Estimate the memory used by the requests that are queued or being
+   * imported. The objects they import, once fetched, are not counted.
+   */
+  size_t estimateMemoryUsage() const;
+
   /**
    * Destroy the queue.
    *
@@ -70,9 +98,14 @@ class HgImportRequestQueue {
 
   /* ====== De-duplication methods ====== */
 
+  /**
+   * Complete the callers de-duplicated into request with importTry, and stop
+   * tracking it. Does nothing unless request is the one tracked for its
+   * object and was dequeued.
+   */
   template <typename T>
   void markImportAsFinished(
-      const ObjectId& id,
+      const std::shared_ptr<HgImportRequest>& request,
       folly::Try<std::shared_ptr<const T>>& importTry);
 
   /**
@@ -91,53 +124,158 @@ class HgImportRequestQueue {
   HgImportRequestQueue(HgImportRequestQueue&&) = delete;
   HgImportRequestQueue& operator=(HgImportRequestQueue&&) = delete;
 
-  struct ImportQueue {
-    std::vector<std::shared_ptr<HgImportRequest>> queue;
+  /**
+   * A request waiting in the queue, shared by its request tracker shard and
+   * the buckets it is in.
+   */
+  struct QueuedRequest {
+    explicit QueuedRequest(std::shared_ptr<HgImportRequest> request)
+        : request{std::move(request)} {}
 
+    std::shared_ptr<HgImportRequest> request;
     /**
-     * Map of a ObjectId to an element in the queue. Any changes to this type
-     * can have a significant effect on EdenFS performance and thus changes to
-     * it needs to be carefully studied and measured. The
-     * store/hg/tests/HgImportRequestQueueBenchmark.cpp is a good way to measure
-     * the potential performance impact.
+     * Set by the first of dequeue() and combineAndClearRequestQueues() to
+     * take the request out of the queue. Raising the priority of a queued
+     * request pushes it again rather than reordering a bucket, so the same
+     * request can be in several buckets; the other entries are skipped.
      */
-    folly::F14FastMap<ObjectId, std::shared_ptr<HgImportRequest>>
-        requestTracker;
+    std::atomic<bool> claimed{false};
+  };
+
+  struct BucketEntry {
+    /**
+     * The priority of the request when this entry was pushed. The request's
+     * own priority can be raised concurrently, and must not be read by the
+     * heap comparisons.
+     */
+    ImportPriority priority;
+    std::shared_ptr<QueuedRequest> queued;
+
+    friend bool operator<(const BucketEntry& lhs, const BucketEntry& rhs) {
+      return lhs.priority < rhs.priority;
+    }
   };
 
-  struct State {
-    bool running = true;
-    ImportQueue treeQueue;
-    ImportQueue blobQueue;
-    ImportQueue blobMetaQueue;
+  /**
+   * A max heap of the requests of one type and ImportPriority::Class.
+   */
+  using Bucket = folly::Synchronized<std::vector<BucketEntry>, std::mutex>;
+
+  /**
+   * Map of a ObjectId to an element in the queue. Any changes to this type
+   * can have a significant effect on EdenFS performance and thus changes to
+   * it needs to be carefully studied and measured. The
+   * store/hg/tests/HgImportRequestQueueBenchmark.cpp is a good way to measure
+   * the potential performance impact.
+   */
+  using RequestTracker = folly::Synchronized<
+      folly::F14FastMap<ObjectId, std::shared_ptr<QueuedRequest>>,
+      std::mutex>;
+
+  static constexpr size_t kClassCount = 3;
+  static constexpr size_t kTrackerShardCount = 64;
+
+  /**
+   * The queue of one type of request.
+   *
+   * Rather than a single lock, every priority class has its own bucket, and
+   * the in-flight requests are sharded by id, so that concurrent enqueues of
+   * different objects rarely contend.
+   */
+  struct ImportQueue {
+    /**
+     * Indexed by getBucketIndex(), from the highest priority class to the
+     * lowest.
+     */
+    std::array<Bucket, kClassCount> buckets;
+    std::array<RequestTracker, kTrackerShardCount> trackerShards;
+
+    RequestTracker& getTrackerShard(const ObjectId& id) {
+      return trackerShards[std::hash<ObjectId>{}(id) % kTrackerShardCount];
+    }
   };
 
+  static size_t getBucketIndex(ImportPriority priority);
+
+  /**
+   * Add an entry for queued to the bucket of priority, and wake up a
+   * dequeue() if one is waiting.
+   */
+  void push(
+      ImportQueue& importQueue,
+      ImportPriority priority,
+      std::shared_ptr<QueuedRequest> queued);
+
+  /**
+   * Take up to count unclaimed requests out of the buckets of importQueue
+   * with indices from firstBucket to lastBucket.
+   */
+  void popRequests(
+      ImportQueue& importQueue,
+      size_t firstBucket,
+      size_t lastBucket,
+      size_t count,
+      std::vector<std::shared_ptr<HgImportRequest>>& result);
+
   /**
-   * Short-hand to map the request type to the appropriate request tracker map.
+   * Remove from requests, and fail with folly::OperationCancelled, the ones
+   * nobody waits for anymore.
+   */
+  void dropAbandonedRequests(
+      ImportQueue& importQueue,
+      std::vector<std::shared_ptr<HgImportRequest>>& requests);
+
+  /**
+   * Short-hand to map the request type to the appropriate import queue.
    */
   template <typename T>
-  HgImportRequestQueue::ImportQueue* getImportQueue(
-      folly::Synchronized<HgImportRequestQueue::State, std::mutex>::LockedPtr&
-          state);
+  ImportQueue& getImportQueue();
 
   std::shared_ptr<ReloadableConfig> config_;
-  folly::Synchronized<State, std::mutex> state_;
-  std::condition_variable queueCV_;
+  ImportQueue treeQueue_;
+  ImportQueue blobQueue_;
+  ImportQueue blobMetaQueue_;
+
+  std::atomic<bool> running_{true};
+  /**
+   * Number of entries in the buckets of each index, over all request types,
+   * including the ones of claimed requests.
+   */
+  std::array<std::atomic<size_t>, kClassCount> queuedEntries_{};
+
+  struct Sleepers {
+    std::condition_variable cv;
+    std::atomic<size_t> count{0};
+  };
+
+  /**
+   * Only used to put dequeue() to sleep while the buckets it serves are
+   * empty: enqueues don't take it unless a dequeue() is waiting.
+   */
+  std::mutex sleepMutex_;
+  /**
+   * The sleeping dequeue()s, grouped by the index of the last bucket they
+   * serve.
+   */
+  std::array<Sleepers, kClassCount> sleepers_;
 };
 
 template <typename T>
 void HgImportRequestQueue::markImportAsFinished(
-    const ObjectId& id,
+    const std::shared_ptr<HgImportRequest>& request,
     folly::Try<std::shared_ptr<const T>>& importTry) {
+  const auto& id = request->getHash();
   std::shared_ptr<HgImportRequest> import;
   {
-    auto state = state_.lock();
-
-    auto& requestTracker = getImportQueue<T>(state)->requestTracker;
-    auto importReq = requestTracker.find(id);
-    if (importReq != requestTracker.end()) {
-      import = std::move(importReq->second);
-      requestTracker.erase(importReq);
+    auto requestTracker = getImportQueue<T>().getTrackerShard(id).lock();
+    auto importReq = requestTracker->find(id);
+    // The request may have been dropped, and another one for the same object
+    // queued and dequeued since: only finish this very request.
+    if (importReq != requestTracker->end() &&
+        importReq->second->request == request &&
+        importReq->second->claimed.load()) {
+      import = importReq->second->request;
+      requestTracker->erase(importReq);
     }
   }
 
@@ -179,18 +317,16 @@ void HgImportRequestQueue::markImportAsFinished(
 }
 
 template <typename T>
-HgImportRequestQueue::ImportQueue* HgImportRequestQueue::getImportQueue(
-    folly::Synchronized<HgImportRequestQueue::State, std::mutex>::LockedPtr&
-        state) {
+HgImportRequestQueue::ImportQueue& HgImportRequestQueue::getImportQueue() {
   if constexpr (std::is_same_v<T, const Tree>) {
-    return &state->treeQueue;
+    return treeQueue_;
   } else if constexpr (std::is_same_v<T, const BlobMetadata>) {
-    return &state->blobMetaQueue;
+    return blobMetaQueue_;
   } else {
     static_assert(
         std::is_same_v<T, const Blob>,
         "getImportQueue can only be called with Tree, Blob or BlobMetadata types");
-    return &state->blobQueue;
+    return blobQueue_;
   }
 }
 } // namespace facebook::eden
@@ -76,6 +76,7 @@ HgImporter::HgImporter(
     EdenStatsPtr stats,
     std::optional<AbsolutePath> importHelperScript)
     : stats_{std::move(stats)} {
+  stats_->increment(&HgImporterStats::start);
   std::vector<string> cmd;
 
   // importHelperScript takes precedence if it was specified; this is used
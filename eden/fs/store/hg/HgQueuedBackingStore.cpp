@@ -7,11 +7,14 @@
 
 #include "eden/fs/store/hg/HgQueuedBackingStore.h"
 
+#include <algorithm>
 #include <chrono>
+#include <numeric>
 #include <thread>
 #include <utility>
 #include <variant>
 
+#include <fb303/ServiceData.h>
 #include <re2/re2.h>
 
 #include <folly/Range.h>
@@ -45,11 +48,71 @@ namespace facebook::eden {
 namespace {
 // 100,000 hg object fetches in a short term is plausible.
 constexpr size_t kTraceBusCapacity = 100000;
-static_assert(CheckSize<HgImportTraceEvent, 72>());
+static_assert(CheckSize<HgImportTraceEvent, 80>());
 // TraceBus is double-buffered, so the following capacity should be doubled.
 // 10 MB overhead per backing repo is tolerable.
 static_assert(
-    CheckEqual<7200000, kTraceBusCapacity * sizeof(HgImportTraceEvent)>());
+    CheckEqual<8000000, kTraceBusCapacity * sizeof(HgImportTraceEvent)>());
+
+struct ImportStageStats {
+  HgBackingStoreStats::DurationPtr queueWait;
+  HgBackingStoreStats::DurationPtr fetch;
+  HgBackingStoreStats::DurationPtr total;
+};
+
+// Gauges holding the current adaptive batch size of each import type.
+constexpr folly::StringPiece kTreeBatchSizeGauge{
+    "store.hg.import_batch_size.tree"};
+constexpr folly::StringPiece kBlobMetaBatchSizeGauge{
+    "store.hg.import_batch_size.blobmeta"};
+constexpr folly::StringPiece kBlobBatchSizeGauge{
+    "store.hg.import_batch_size.blob"};
+
+const ImportStageStats& getImportStageStats(ImportPriority priority) {
+  static constexpr ImportStageStats kHigh{
+      &HgBackingStoreStats::importQueueWaitHigh,
+      &HgBackingStoreStats::importFetchHigh,
+      &HgBackingStoreStats::importTotalHigh};
+  static constexpr ImportStageStats kNormal{
+      &HgBackingStoreStats::importQueueWaitNormal,
+      &HgBackingStoreStats::importFetchNormal,
+      &HgBackingStoreStats::importTotalNormal};
+  static constexpr ImportStageStats kLow{
+      &HgBackingStoreStats::importQueueWaitLow,
+      &HgBackingStoreStats::importFetchLow,
+      &HgBackingStoreStats::importTotalLow};
+  auto cls = priority.getClass();
+  if (cls > ImportPriority::Class::Normal) {
+    return kHigh;
+  } else if (cls == ImportPriority::Class::Normal) {
+    return kNormal;
+  } else {
+    return kLow;
+  }
+}
+
+/**
+ * Record how long requests waited in the queue and were fetched for, given
+ * that the native backing store returned at fetched.
+ */
+void recordFetchStages(
+    EdenStats& stats,
+    const std::vector<std::shared_ptr<HgImportRequest>>& requests,
+    std::chrono::steady_clock::time_point fetched) {
+  for (const auto& request : requests) {
+    const auto& stageStats = getImportStageStats(request->getPriority());
+    stats.addDuration(
+        stageStats.queueWait,
+        request->getDequeueTime() - request->getRequestTime());
+    stats.addDuration(stageStats.fetch, fetched - request->getDequeueTime());
+  }
+}
+
+void recordImportCompleted(EdenStats& stats, const HgImportRequest& request) {
+  stats.addDuration(
+      getImportStageStats(request.getPriority()).total,
+      std::chrono::steady_clock::now() - request.getRequestTime());
+}
 } // namespace
 
 HgImportTraceEvent::HgImportTraceEvent(
@@ -59,14 +122,16 @@ HgImportTraceEvent::HgImportTraceEvent(
     const HgProxyHash& proxyHash,
     ImportPriority::Class priority,
     ObjectFetchContext::Cause cause,
-    OptionalProcessId pid)
+    OptionalProcessId pid,
+    uint64_t requestId)
     : unique{unique},
       manifestNodeId{proxyHash.revHash()},
       eventType{eventType},
       resourceType{resourceType},
       importPriority{priority},
       importCause{cause},
-      pid{pid} {
+      pid{pid},
+      requestId{requestId} {
   auto hgPath = proxyHash.path().view();
   // TODO: If HgProxyHash (and correspondingly ObjectId) used an immutable,
   // refcounted string, we wouldn't need to allocate here.
@@ -87,13 +152,26 @@ HgQueuedBackingStore::HgQueuedBackingStore(
       config_(config),
       backingStore_(std::move(backingStore)),
       queue_(std::move(config)),
+      treeBatchSize_{
+          config_->getEdenConfig()->importBatchSizeTree.getValue()},
+      blobMetaBatchSize_{
+          config_->getEdenConfig()->importBatchSizeBlobMeta.getValue()},
+      blobBatchSize_{config_->getEdenConfig()->importBatchSize.getValue()},
       structuredLogger_{std::move(structuredLogger)},
       logger_(std::move(logger)),
       activityBuffer_{
-          config_->getEdenConfig()->hgActivityBufferSize.getValue()},
+          config_->getEdenConfig()->hgActivityBufferSize.getValue(),
+          config_->getEdenConfig()->activityBufferMaxBytes.getValue()},
+      fetchHeatmap_{
+          config_->getEdenConfig()->hgFetchHeatmapCapacity.getValue(),
+          config_->getEdenConfig()->hgFetchHeatmapMaxDepth.getValue()},
       traceBus_{TraceBus<HgImportTraceEvent>::create(
           "hg",
           config_->getEdenConfig()->HgTraceBusCapacity.getValue())} {
+  fb303::fbData->setCounter(kTreeBatchSizeGauge, treeBatchSize_.get());
+  fb303::fbData->setCounter(kBlobMetaBatchSizeGauge, blobMetaBatchSize_.get());
+  fb303::fbData->setCounter(kBlobBatchSizeGauge, blobBatchSize_.get());
+
   uint8_t numberThreads =
       config_->getEdenConfig()->numBackingstoreThreads.getValue();
   if (!numberThreads) {
@@ -101,9 +179,16 @@ HgQueuedBackingStore::HgQueuedBackingStore(
         << "HgQueuedBackingStore configured to use 0 threads. Invalid, using one thread instead";
     numberThreads = 1;
   }
+  uint8_t numberHighPriorityThreads = std::min<uint8_t>(
+      config_->getEdenConfig()->numHighPriorityBackingstoreThreads.getValue(),
+      numberThreads - 1);
   threads_.reserve(numberThreads);
   for (uint16_t i = 0; i < numberThreads; i++) {
-    threads_.emplace_back(&HgQueuedBackingStore::processRequest, this);
+    threads_.emplace_back(
+        &HgQueuedBackingStore::processRequest,
+        this,
+        i < numberHighPriorityThreads ? ImportPriority::Class::High
+                                      : ImportPriority::Class::Low);
   }
 
   hgTraceHandle_ = traceBus_->subscribeFunction(
@@ -137,12 +222,15 @@ void HgQueuedBackingStore::processBlobImportRequests(
         blobImport->proxyHash,
         request->getPriority().getClass(),
         request->getCause(),
-        request->getPid()));
+        request->getPid(),
+        request->getRequestId()));
+    fetchHeatmap_.recordFetch(blobImport->proxyHash.path());
 
     XLOGF(DBG4, "Processing blob request for {}", blobImport->hash);
   }
 
   backingStore_->getDatapackStore().getBlobBatch(requests);
+  recordFetchStages(*stats_, requests, std::chrono::steady_clock::now());
 
   {
     std::vector<folly::SemiFuture<folly::Unit>> futures;
@@ -152,6 +240,7 @@ void HgQueuedBackingStore::processBlobImportRequests(
       auto* promise = request->getPromise<BlobPtr>();
       if (promise->isFulfilled()) {
         stats_->addDuration(&HgBackingStoreStats::fetchBlob, watch.elapsed());
+        recordImportCompleted(*stats_, *request);
         continue;
       }
 
@@ -172,6 +261,7 @@ void HgQueuedBackingStore::processBlobImportRequests(
                     &HgBackingStoreStats::fetchBlob, watch.elapsed());
                 request->getPromise<HgImportRequest::BlobImport::Response>()
                     ->setTry(std::forward<decltype(result)>(result));
+                recordImportCompleted(*stats, *request);
               }));
     }
 
@@ -194,12 +284,15 @@ void HgQueuedBackingStore::processTreeImportRequests(
         treeImport->proxyHash,
         request->getPriority().getClass(),
         request->getCause(),
-        request->getPid()));
+        request->getPid(),
+        request->getRequestId()));
+    fetchHeatmap_.recordFetch(treeImport->proxyHash.path());
 
     XLOGF(DBG4, "Processing tree request for {}", treeImport->hash);
   }
 
   backingStore_->getDatapackStore().getTreeBatch(requests);
+  recordFetchStages(*stats_, requests, std::chrono::steady_clock::now());
 
   {
     std::vector<folly::SemiFuture<folly::Unit>> futures;
@@ -209,6 +302,7 @@ void HgQueuedBackingStore::processTreeImportRequests(
       auto* promise = request->getPromise<TreePtr>();
       if (promise->isFulfilled()) {
         stats_->addDuration(&HgBackingStoreStats::fetchTree, watch.elapsed());
+        recordImportCompleted(*stats_, *request);
         continue;
       }
 
@@ -229,6 +323,7 @@ void HgQueuedBackingStore::processTreeImportRequests(
                     &HgBackingStoreStats::fetchTree, watch.elapsed());
                 request->getPromise<HgImportRequest::TreeImport::Response>()
                     ->setTry(std::forward<decltype(result)>(result));
+                recordImportCompleted(*stats, *request);
               }));
     }
 
@@ -252,12 +347,28 @@ void HgQueuedBackingStore::processBlobMetaImportRequests(
         blobMetaImport->proxyHash,
         request->getPriority().getClass(),
         request->getCause(),
-        request->getPid()));
+        request->getPid(),
+        request->getRequestId()));
 
     XLOGF(DBG4, "Processing blob meta request for {}", blobMetaImport->hash);
   }
 
-  backingStore_->getDatapackStore().getBlobMetadataBatch(requests);
+  auto& datapackStore = backingStore_->getDatapackStore();
+  datapackStore.getBlobMetadataBatch(requests);
+
+  // Blobs without aux data are often already in the local cache, in which
+  // case hashing them here, together, is cheaper than having each caller
+  // fetch and hash its blob separately.
+  std::vector<std::shared_ptr<HgImportRequest>> missing;
+  for (const auto& request : requests) {
+    if (!request->getPromise<BlobMetadataPtr>()->isFulfilled()) {
+      missing.push_back(request);
+    }
+  }
+  if (!missing.empty()) {
+    datapackStore.computeLocalBlobMetadataBatch(missing);
+  }
+  recordFetchStages(*stats_, requests, std::chrono::steady_clock::now());
 
   {
     for (auto& request : requests) {
@@ -265,6 +376,7 @@ void HgQueuedBackingStore::processBlobMetaImportRequests(
       if (promise->isFulfilled()) {
         stats_->addDuration(
             &HgBackingStoreStats::fetchBlobMetadata, watch.elapsed());
+        recordImportCompleted(*stats_, *request);
         continue;
       }
 
@@ -273,28 +385,75 @@ void HgQueuedBackingStore::processBlobMetaImportRequests(
       // the risk of running into a deadlock: if all import thread are in this
       // code path, there are no free importer to fetch blobs.
       promise->setValue(nullptr);
+      recordImportCompleted(*stats_, *request);
     }
   }
 }
 
-void HgQueuedBackingStore::processRequest() {
+void HgQueuedBackingStore::processRequest(
+    ImportPriority::Class minimumClass) {
   folly::setThreadName("hgqueue");
   for (;;) {
-    auto requests = queue_.dequeue();
+    auto config = config_->getEdenConfig();
+    auto adaptive = config->adaptiveImportBatchSize.getValue();
+    HgImportRequestQueue::BatchSizes batchSizes{
+        config->importBatchSizeTree.getValue(),
+        config->importBatchSizeBlobMeta.getValue(),
+        config->importBatchSize.getValue()};
+    if (adaptive) {
+      batchSizes.tree = treeBatchSize_.get();
+      batchSizes.blobMeta = blobMetaBatchSize_.get();
+      batchSizes.blob = blobBatchSize_.get();
+    }
+
+    auto requests = queue_.dequeue(batchSizes, minimumClass);
 
     if (requests.empty()) {
       break;
     }
 
     const auto& first = requests.at(0);
+    auto count = requests.size();
+    AdaptiveBatchSize* batchSize = nullptr;
+    folly::StringPiece batchSizeGauge;
+    size_t limit = 0;
+    folly::stop_watch<> watch;
 
     if (first->isType<HgImportRequest::BlobImport>()) {
+      batchSize = &blobBatchSize_;
+      batchSizeGauge = kBlobBatchSizeGauge;
+      limit = batchSizes.blob;
+      stats_->increment(&HgBackingStoreStats::importBatchBlob, count);
       processBlobImportRequests(std::move(requests));
     } else if (first->isType<HgImportRequest::TreeImport>()) {
+      batchSize = &treeBatchSize_;
+      batchSizeGauge = kTreeBatchSizeGauge;
+      limit = batchSizes.tree;
+      stats_->increment(&HgBackingStoreStats::importBatchTree, count);
       processTreeImportRequests(std::move(requests));
     } else if (first->isType<HgImportRequest::BlobMetaImport>()) {
+      batchSize = &blobMetaBatchSize_;
+      batchSizeGauge = kBlobMetaBatchSizeGauge;
+      limit = batchSizes.blobMeta;
+      stats_->increment(&HgBackingStoreStats::importBatchBlobMeta, count);
       processBlobMetaImportRequests(std::move(requests));
     }
+
+    if (adaptive && batchSize) {
+      // The config may have been reloaded while this thread was waiting for
+      // requests.
+      config = config_->getEdenConfig();
+      auto newSize = batchSize->recordBatch(
+          count,
+          limit,
+          watch.elapsed(),
+          config->adaptiveImportBatchTargetLatency.getValue(),
+          config->adaptiveImportBatchSizeMin.getValue(),
+          config->adaptiveImportBatchSizeMax.getValue());
+      if (newSize != limit) {
+        fb303::fbData->setCounter(batchSizeGauge, newSize);
+      }
+    }
   }
 }
 
@@ -426,13 +585,17 @@ HgQueuedBackingStore::getTreeImpl(
     const ObjectId& id,
     const HgProxyHash& proxyHash,
     const ObjectFetchContextPtr& context) {
+  std::shared_ptr<HgImportRequest> request;
   auto getTreeFuture = folly::makeFutureWith([&] {
-    auto request = HgImportRequest::makeTreeImportRequest(
+    request = HgImportRequest::makeTreeImportRequest(
         id,
         proxyHash,
         context->getPriority(),
         context->getCause(),
         context->getClientPid());
+    request->setCancellation(
+        context->getCancellationToken(), context->getDeadline());
+    request->setRequestId(context->getRequestId());
     uint64_t unique = request->getUnique();
 
     auto importTracker =
@@ -443,9 +606,10 @@ HgQueuedBackingStore::getTreeImpl(
         proxyHash,
         context->getPriority().getClass(),
         context->getCause(),
-        context->getClientPid()));
+        context->getClientPid(),
+        context->getRequestId()));
 
-    return queue_.enqueueTree(std::move(request))
+    return queue_.enqueueTree(request)
         .ensure([this,
                  unique,
                  proxyHash,
@@ -457,13 +621,15 @@ HgQueuedBackingStore::getTreeImpl(
               proxyHash,
               context->getPriority().getClass(),
               context->getCause(),
-              context->getClientPid()));
+              context->getClientPid(),
+              context->getRequestId()));
         });
   });
 
   return std::move(getTreeFuture)
-      .thenTry([this, id](folly::Try<TreePtr>&& result) {
-        this->queue_.markImportAsFinished<TreePtr::element_type>(id, result);
+      .thenTry([this, request](folly::Try<TreePtr>&& result) {
+        this->queue_.markImportAsFinished<TreePtr::element_type>(
+            request, result);
         auto tree = std::move(result).value();
         return GetTreeResult{
             std::move(tree), ObjectFetchContext::Origin::FromNetworkFetch};
@@ -502,16 +668,20 @@ HgQueuedBackingStore::getBlobImpl(
     const ObjectId& id,
     const HgProxyHash& proxyHash,
     const ObjectFetchContextPtr& context) {
+  std::shared_ptr<HgImportRequest> request;
   auto getBlobFuture = folly::makeFutureWith([&] {
     XLOG(DBG4) << "make blob import request for " << proxyHash.path()
                << ", hash is:" << id;
 
-    auto request = HgImportRequest::makeBlobImportRequest(
+    request = HgImportRequest::makeBlobImportRequest(
         id,
         proxyHash,
         context->getPriority(),
         context->getCause(),
         context->getClientPid());
+    request->setCancellation(
+        context->getCancellationToken(), context->getDeadline());
+    request->setRequestId(context->getRequestId());
     auto unique = request->getUnique();
 
     auto importTracker =
@@ -522,9 +692,10 @@ HgQueuedBackingStore::getBlobImpl(
         proxyHash,
         context->getPriority().getClass(),
         context->getCause(),
-        context->getClientPid()));
+        context->getClientPid(),
+        context->getRequestId()));
 
-    return queue_.enqueueBlob(std::move(request))
+    return queue_.enqueueBlob(request)
         .ensure([this,
                  unique,
                  proxyHash,
@@ -536,13 +707,15 @@ HgQueuedBackingStore::getBlobImpl(
               proxyHash,
               context->getPriority().getClass(),
               context->getCause(),
-              context->getClientPid()));
+              context->getClientPid(),
+              context->getRequestId()));
         });
   });
 
   return std::move(getBlobFuture)
-      .thenTry([this, id](folly::Try<BlobPtr>&& result) {
-        this->queue_.markImportAsFinished<BlobPtr::element_type>(id, result);
+      .thenTry([this, request](folly::Try<BlobPtr>&& result) {
+        this->queue_.markImportAsFinished<BlobPtr::element_type>(
+            request, result);
         auto blob = std::move(result).value();
         return GetBlobResult{
             std::move(blob), ObjectFetchContext::Origin::FromNetworkFetch};
@@ -589,16 +762,20 @@ HgQueuedBackingStore::getBlobMetadataImpl(
         nullptr, ObjectFetchContext::Origin::NotFetched};
   }
 
+  std::shared_ptr<HgImportRequest> request;
   auto getBlobMetaFuture = folly::makeFutureWith([&] {
     XLOG(DBG4) << "make blob meta import request for " << proxyHash.path()
                << ", hash is:" << id;
 
-    auto request = HgImportRequest::makeBlobMetaImportRequest(
+    request = HgImportRequest::makeBlobMetaImportRequest(
         id,
         proxyHash,
         context->getPriority(),
         context->getCause(),
         context->getClientPid());
+    request->setCancellation(
+        context->getCancellationToken(), context->getDeadline());
+    request->setRequestId(context->getRequestId());
     auto unique = request->getUnique();
 
     auto importTracker =
@@ -609,9 +786,10 @@ HgQueuedBackingStore::getBlobMetadataImpl(
         proxyHash,
         context->getPriority().getClass(),
         context->getCause(),
-        context->getClientPid()));
+        context->getClientPid(),
+        context->getRequestId()));
 
-    return queue_.enqueueBlobMeta(std::move(request))
+    return queue_.enqueueBlobMeta(request)
         .ensure([this,
                  unique,
                  proxyHash,
@@ -623,14 +801,15 @@ HgQueuedBackingStore::getBlobMetadataImpl(
               proxyHash,
               context->getPriority().getClass(),
               context->getCause(),
-              context->getClientPid()));
+              context->getClientPid(),
+              context->getRequestId()));
         });
   });
 
   return std::move(getBlobMetaFuture)
-      .thenTry([this, id](folly::Try<BlobMetadataPtr>&& result) {
+      .thenTry([this, request](folly::Try<BlobMetadataPtr>&& result) {
         this->queue_.markImportAsFinished<BlobMetadataPtr::element_type>(
-            id, result);
+            request, result);
         auto blobMeta = std::move(result).value();
         return GetBlobMetaResult{
             std::move(blobMeta), ObjectFetchContext::Origin::FromNetworkFetch};
@@ -666,10 +845,21 @@ folly::SemiFuture<folly::Unit> HgQueuedBackingStore::prefetchBlobs(
         // oriented ones. Mercurial will anyway not re-fetch a blob that is
         // already present locally, so the check for local blob is pure overhead
         // when prefetching.
+        //
+        // Requests are queued in path order so that the files of a directory
+        // end up in the same import batches, which Mercurial serves with
+        // fewer round trips than scattered ones.
+        std::vector<size_t> order(ids.size());
+        std::iota(order.begin(), order.end(), size_t{0});
+        std::stable_sort(
+            order.begin(), order.end(), [&proxyHashes](size_t a, size_t b) {
+              return proxyHashes[a].path() < proxyHashes[b].path();
+            });
+
         std::vector<folly::SemiFuture<GetBlobResult>> futures;
         futures.reserve(ids.size());
 
-        for (size_t i = 0; i < ids.size(); i++) {
+        for (auto i : order) {
           const auto& id = ids[i];
           const auto& proxyHash = proxyHashes[i];
 
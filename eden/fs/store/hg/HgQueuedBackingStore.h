@@ -16,8 +16,10 @@
 
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/store/BackingStore.h"
+#include "eden/fs/store/FetchHeatmap.h"
 #include "eden/fs/store/ImportPriority.h"
 #include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/store/hg/AdaptiveBatchSize.h"
 #include "eden/fs/store/hg/HgBackingStore.h"
 #include "eden/fs/store/hg/HgImportRequestQueue.h"
 #include "eden/fs/telemetry/ActivityBuffer.h"
@@ -53,9 +55,17 @@ struct HgImportTraceEvent : TraceEventBase {
       const HgProxyHash& proxyHash,
       ImportPriority::Class priority,
       ObjectFetchContext::Cause cause,
-      OptionalProcessId pid) {
+      OptionalProcessId pid,
+      uint64_t requestId) {
     return HgImportTraceEvent{
-        unique, QUEUE, resourceType, proxyHash, priority, cause, pid};
+        unique,
+        QUEUE,
+        resourceType,
+        proxyHash,
+        priority,
+        cause,
+        pid,
+        requestId};
   }
 
   static HgImportTraceEvent start(
@@ -64,9 +74,17 @@ struct HgImportTraceEvent : TraceEventBase {
       const HgProxyHash& proxyHash,
       ImportPriority::Class priority,
       ObjectFetchContext::Cause cause,
-      OptionalProcessId pid) {
+      OptionalProcessId pid,
+      uint64_t requestId) {
     return HgImportTraceEvent{
-        unique, START, resourceType, proxyHash, priority, cause, pid};
+        unique,
+        START,
+        resourceType,
+        proxyHash,
+        priority,
+        cause,
+        pid,
+        requestId};
   }
 
   static HgImportTraceEvent finish(
@@ -75,9 +93,17 @@ struct HgImportTraceEvent : TraceEventBase {
       const HgProxyHash& proxyHash,
       ImportPriority::Class priority,
       ObjectFetchContext::Cause cause,
-      OptionalProcessId pid) {
+      OptionalProcessId pid,
+      uint64_t requestId) {
     return HgImportTraceEvent{
-        unique, FINISH, resourceType, proxyHash, priority, cause, pid};
+        unique,
+        FINISH,
+        resourceType,
+        proxyHash,
+        priority,
+        cause,
+        pid,
+        requestId};
   }
 
   HgImportTraceEvent(
@@ -87,7 +113,8 @@ struct HgImportTraceEvent : TraceEventBase {
       const HgProxyHash& proxyHash,
       ImportPriority::Class priority,
       ObjectFetchContext::Cause cause,
-      OptionalProcessId pid);
+      OptionalProcessId pid,
+      uint64_t requestId);
 
   // Simple accessor that hides the internal memory representation of paths.
   std::string getPath() const {
@@ -108,6 +135,9 @@ struct HgImportTraceEvent : TraceEventBase {
   ImportPriority::Class importPriority;
   ObjectFetchContext::Cause importCause;
   OptionalProcessId pid;
+  // The filesystem request that caused the import, or 0. See
+  // ObjectFetchContext::getRequestId.
+  uint64_t requestId;
 };
 
 /**
@@ -132,6 +162,14 @@ class HgQueuedBackingStore final : public BackingStore {
     return activityBuffer_;
   }
 
+  /**
+   * Counts of the imports under each directory, for the directories imported
+   * from the most.
+   */
+  const FetchHeatmap& getFetchHeatmap() const {
+    return fetchHeatmap_;
+  }
+
   TraceBus<HgImportTraceEvent>& getTraceBus() const {
     return *traceBus_;
   }
@@ -207,11 +245,23 @@ class HgQueuedBackingStore final : public BackingStore {
 
   int64_t dropAllPendingRequestsFromQueue() override;
 
+  /**
+   * Estimate the memory used by the imports that are queued or in progress,
+   * see HgImportRequestQueue::estimateMemoryUsage().
+   */
+  size_t estimateImportQueueMemoryUsage() const {
+    return queue_.estimateMemoryUsage();
+  }
+
  private:
   // Forbidden copy constructor and assignment operator
   HgQueuedBackingStore(const HgQueuedBackingStore&) = delete;
   HgQueuedBackingStore& operator=(const HgQueuedBackingStore&) = delete;
 
+  // Lets the import queue benchmark call getBlobImpl() and getTreeImpl(), so
+  // that its fetches go through the queue even when the hgcache has them.
+  friend class HgQueuedBackingStoreBenchmarkAccess;
+
   void processBlobImportRequests(
       std::vector<std::shared_ptr<HgImportRequest>>&& requests);
   void processTreeImportRequests(
@@ -220,9 +270,10 @@ class HgQueuedBackingStore final : public BackingStore {
       std::vector<std::shared_ptr<HgImportRequest>>&& requests);
 
   /**
-   * The worker runloop function.
+   * The worker runloop function. Only serves requests of minimumClass or a
+   * higher priority class.
    */
-  void processRequest();
+  void processRequest(ImportPriority::Class minimumClass);
 
   void logMissingProxyHash();
 
@@ -326,6 +377,14 @@ class HgQueuedBackingStore final : public BackingStore {
    */
   HgImportRequestQueue queue_;
 
+  /**
+   * The batch sizes processRequest() dequeues with when
+   * hg:adaptive-import-batch-size is enabled.
+   */
+  AdaptiveBatchSize treeBatchSize_;
+  AdaptiveBatchSize blobMetaBatchSize_;
+  AdaptiveBatchSize blobBatchSize_;
+
   /**
    * The worker thread pool. These threads will be running `processRequest`
    * forever to process incoming import requests
@@ -354,6 +413,8 @@ class HgQueuedBackingStore final : public BackingStore {
 
   ActivityBuffer<HgImportTraceEvent> activityBuffer_;
 
+  FetchHeatmap fetchHeatmap_;
+
   // The traceBus_ and hgTraceHandle_ should be last so any internal subscribers
   // can capture [this].
   std::shared_ptr<TraceBus<HgImportTraceEvent>> traceBus_;
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/hg/AdaptiveBatchSize.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+constexpr auto kTarget = 100ms;
+constexpr uint32_t kMin = 1;
+constexpr uint32_t kMax = 64;
+} // namespace
+
+TEST(AdaptiveBatchSizeTest, full_fast_batches_grow_additively) {
+  AdaptiveBatchSize size{4};
+  EXPECT_EQ(12, size.recordBatch(4, 4, 10ms, kTarget, kMin, kMax));
+  EXPECT_EQ(20, size.recordBatch(12, 12, 10ms, kTarget, kMin, kMax));
+  EXPECT_EQ(20, size.get());
+}
+
+TEST(AdaptiveBatchSizeTest, partial_batches_leave_size_alone) {
+  AdaptiveBatchSize size{16};
+  EXPECT_EQ(16, size.recordBatch(3, 16, 10ms, kTarget, kMin, kMax));
+}
+
+TEST(AdaptiveBatchSizeTest, slow_batches_halve_size) {
+  AdaptiveBatchSize size{32};
+  EXPECT_EQ(16, size.recordBatch(32, 32, 1s, kTarget, kMin, kMax));
+  // A slow batch that was dequeued before the decrease doesn't decrease it
+  // again.
+  EXPECT_EQ(16, size.recordBatch(32, 32, 1s, kTarget, kMin, kMax));
+  EXPECT_EQ(8, size.recordBatch(16, 16, 1s, kTarget, kMin, kMax));
+}
+
+TEST(AdaptiveBatchSizeTest, size_stays_within_bounds) {
+  AdaptiveBatchSize size{60};
+  EXPECT_EQ(kMax, size.recordBatch(60, 60, 10ms, kTarget, kMin, kMax));
+  EXPECT_EQ(kMax, size.recordBatch(64, 64, 10ms, kTarget, kMin, kMax));
+
+  AdaptiveBatchSize small{1};
+  EXPECT_EQ(kMin, small.recordBatch(1, 1, 1s, kTarget, kMin, kMax));
+
+  // Bounds are re-read from the config on every batch, and may have changed.
+  EXPECT_EQ(32, size.recordBatch(1, 64, 10ms, kTarget, kMin, 32));
+}
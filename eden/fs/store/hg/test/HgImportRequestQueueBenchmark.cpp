@@ -5,8 +5,14 @@
  * GNU General Public License version 2.
  */
 
+#include <folly/Random.h>
+#include <folly/futures/Future.h>
+#include <thread>
+
 #include "eden/common/utils/benchharness/Bench.h"
 #include "eden/fs/config/ReloadableConfig.h"
+#include "eden/fs/model/Blob.h"
+#include "eden/fs/model/Tree.h"
 #include "eden/fs/store/ImportPriority.h"
 #include "eden/fs/store/hg/HgImportRequest.h"
 #include "eden/fs/store/hg/HgImportRequestQueue.h"
@@ -72,6 +78,105 @@ void dequeue(benchmark::State& state) {
   }
 }
 
+/**
+ * Simulates the fetches of a build: many FUSE threads concurrently read the
+ * trees and files of the source tree, mostly at filesystem priority with some
+ * prefetches mixed in, and often for objects another thread is already
+ * waiting on, while import threads drain the queue. An iteration is one wave
+ * of reads, which completes once every read got its object.
+ */
+void buildFetchPattern(benchmark::State& state) {
+  constexpr size_t kFuseThreads = 16;
+  constexpr size_t kImportThreads = 8;
+  constexpr size_t kReadsPerThread = 256;
+  // Every object is read by two threads on average.
+  constexpr size_t kObjectCount = kFuseThreads * kReadsPerThread / 2;
+
+  auto rawEdenConfig = EdenConfig::createTestEdenConfig();
+  auto edenConfig = std::make_shared<ReloadableConfig>(
+      rawEdenConfig, ConfigReloadBehavior::NoReload);
+  HgImportRequestQueue queue{edenConfig};
+
+  std::vector<HgProxyHash> proxyHashes;
+  proxyHashes.reserve(kObjectCount);
+  for (size_t i = 0; i < kObjectCount; i++) {
+    proxyHashes.emplace_back(RelativePath{"some_path"}, uniqueHash());
+  }
+
+  std::vector<std::thread> importThreads;
+  for (size_t i = 0; i < kImportThreads; i++) {
+    importThreads.emplace_back([&queue] {
+      for (;;) {
+        auto requests = queue.dequeue();
+        if (requests.empty()) {
+          return;
+        }
+        for (auto& request : requests) {
+          if (auto* treeImport =
+                  request->getRequest<HgImportRequest::TreeImport>()) {
+            auto tree = folly::makeTryWith([&] {
+              return std::make_shared<TreePtr::element_type>(
+                  Tree::container{kPathMapDefaultCaseSensitive},
+                  treeImport->hash);
+            });
+            request->getPromise<TreePtr>()->setValue(tree.value());
+            queue.markImportAsFinished<TreePtr::element_type>(request, tree);
+          } else {
+            auto blob = folly::makeTryWith([] {
+              return std::make_shared<BlobPtr::element_type>(folly::IOBuf{});
+            });
+            request->getPromise<BlobPtr>()->setValue(blob.value());
+            queue.markImportAsFinished<BlobPtr::element_type>(request, blob);
+          }
+        }
+      }
+    });
+  }
+
+  for (auto _ : state) {
+    std::vector<std::thread> fuseThreads;
+    for (size_t i = 0; i < kFuseThreads; i++) {
+      fuseThreads.emplace_back([&] {
+        std::vector<folly::Future<folly::Unit>> reads;
+        reads.reserve(kReadsPerThread);
+        for (size_t j = 0; j < kReadsPerThread; j++) {
+          auto index = folly::Random::rand32(kObjectCount);
+          auto& proxyHash = proxyHashes[index];
+          auto priority = folly::Random::oneIn(5) ? kReaddirPrefetchPriority
+                                                  : kDefaultFsImportPriority;
+          // About one object in eight is a directory.
+          if (index % 8 == 0) {
+            auto request = HgImportRequest::makeTreeImportRequest(
+                proxyHash.sha1(),
+                proxyHash,
+                priority,
+                ObjectFetchContext::Cause::Fs,
+                std::nullopt);
+            reads.push_back(queue.enqueueTree(std::move(request)).unit());
+          } else {
+            auto request = HgImportRequest::makeBlobImportRequest(
+                proxyHash.sha1(),
+                proxyHash,
+                priority,
+                ObjectFetchContext::Cause::Fs,
+                std::nullopt);
+            reads.push_back(queue.enqueueBlob(std::move(request)).unit());
+          }
+        }
+        folly::collectAll(reads).wait();
+      });
+    }
+    for (auto& thread : fuseThreads) {
+      thread.join();
+    }
+  }
+
+  queue.stop();
+  for (auto& thread : importThreads) {
+    thread.join();
+  }
+}
+
 BENCHMARK(enqueue)
     ->Unit(benchmark::kNanosecond)
     ->Threads(1)
@@ -89,6 +194,8 @@ BENCHMARK(dequeue)
     ->Threads(8)
     ->Threads(16)
     ->Threads(32);
+
+BENCHMARK(buildFetchPattern)->Unit(benchmark::kMicrosecond)->UseRealTime();
 } // namespace
 
 EDEN_BENCHMARK_MAIN();
@@ -10,6 +10,7 @@
 #include <folly/portability/GTest.h>
 #include <array>
 #include <memory>
+#include <thread>
 
 #include "eden/fs/config/ReloadableConfig.h"
 #include "eden/fs/model/Hash.h"
@@ -174,8 +175,7 @@ TEST_F(HgImportRequestQueueTest, getRequestByPriority) {
       return std::make_shared<BlobPtr::element_type>(folly::IOBuf{});
     });
 
-    queue.markImportAsFinished<BlobPtr::element_type>(
-        request->getRequest<HgImportRequest::BlobImport>()->hash, blob);
+    queue.markImportAsFinished<BlobPtr::element_type>(request, blob);
   }
 
   auto smallRequestDequeue = queue.dequeue().at(0);
@@ -187,8 +187,7 @@ TEST_F(HgImportRequestQueueTest, getRequestByPriority) {
       [] { return std::make_shared<BlobPtr::element_type>(folly::IOBuf{}); });
 
   queue.markImportAsFinished<BlobPtr::element_type>(
-      smallRequestDequeue->getRequest<HgImportRequest::BlobImport>()->hash,
-      smallBlob);
+      smallRequestDequeue, smallBlob);
 }
 
 TEST_F(HgImportRequestQueueTest, getRequestByPriorityReverse) {
@@ -216,8 +215,7 @@ TEST_F(HgImportRequestQueueTest, getRequestByPriorityReverse) {
   folly::Try<BlobPtr> largeBlob = folly::makeTryWith(
       [] { return std::make_shared<BlobPtr::element_type>(folly::IOBuf{}); });
   queue.markImportAsFinished<BlobPtr::element_type>(
-      largeHashDequeue->getRequest<HgImportRequest::BlobImport>()->hash,
-      largeBlob);
+      largeHashDequeue, largeBlob);
 
   while (!enqueued.empty()) {
     auto expected = enqueued.front();
@@ -230,8 +228,7 @@ TEST_F(HgImportRequestQueueTest, getRequestByPriorityReverse) {
 
     auto blob = folly::makeTryWith(
         [] { return std::make_shared<BlobPtr::element_type>(folly::IOBuf{}); });
-    queue.markImportAsFinished<BlobPtr::element_type>(
-        request->getRequest<HgImportRequest::BlobImport>()->hash, blob);
+    queue.markImportAsFinished<BlobPtr::element_type>(request, blob);
   }
 }
 
@@ -277,8 +274,7 @@ TEST_F(HgImportRequestQueueTest, mixedPriority) {
           return std::make_shared<TreePtr::element_type>(
               Tree::container{kPathMapDefaultCaseSensitive}, hash);
         });
-    queue.markImportAsFinished<TreePtr::element_type>(
-        dequeuedRequest->getRequest<HgImportRequest::TreeImport>()->hash, tree);
+    queue.markImportAsFinished<TreePtr::element_type>(dequeuedRequest, tree);
   }
 
   // Pre dequeue, queue has tree requests from priority 1 to 8 and blob
@@ -298,8 +294,7 @@ TEST_F(HgImportRequestQueueTest, mixedPriority) {
 
     auto blob = folly::makeTryWith(
         [] { return std::make_shared<BlobPtr::element_type>(folly::IOBuf{}); });
-    queue.markImportAsFinished<BlobPtr::element_type>(
-        dequeuedRequest->getRequest<HgImportRequest::BlobImport>()->hash, blob);
+    queue.markImportAsFinished<BlobPtr::element_type>(dequeuedRequest, blob);
   }
 }
 
@@ -337,8 +332,7 @@ TEST_F(HgImportRequestQueueTest, getMultipleRequests) {
           return std::make_shared<TreePtr::element_type>(
               Tree::container{kPathMapDefaultCaseSensitive}, hash);
         });
-    queue.markImportAsFinished<TreePtr::element_type>(
-        dequeuedRequest->getRequest<HgImportRequest::TreeImport>()->hash, tree);
+    queue.markImportAsFinished<TreePtr::element_type>(dequeuedRequest, tree);
   }
 
   rawEdenConfig->importBatchSize.setValue(
@@ -355,8 +349,7 @@ TEST_F(HgImportRequestQueueTest, getMultipleRequests) {
 
     auto blob = folly::makeTryWith(
         [] { return std::make_shared<BlobPtr::element_type>(folly::IOBuf{}); });
-    queue.markImportAsFinished<BlobPtr::element_type>(
-        dequeuedRequest->getRequest<HgImportRequest::BlobImport>()->hash, blob);
+    queue.markImportAsFinished<BlobPtr::element_type>(dequeuedRequest, blob);
   }
 }
 
@@ -390,8 +383,7 @@ TEST_F(HgImportRequestQueueTest, duplicateRequestAfterEnqueue) {
 
   auto blob = folly::makeTryWith(
       [] { return std::make_shared<BlobPtr::element_type>(folly::IOBuf{}); });
-  queue.markImportAsFinished<BlobPtr::element_type>(
-      dequeuedRequest->getRequest<HgImportRequest::BlobImport>()->hash, blob);
+  queue.markImportAsFinished<BlobPtr::element_type>(dequeuedRequest, blob);
 }
 
 TEST_F(HgImportRequestQueueTest, duplicateRequestAfterDequeue) {
@@ -426,8 +418,7 @@ TEST_F(HgImportRequestQueueTest, duplicateRequestAfterDequeue) {
 
   auto blob = folly::makeTryWith(
       [] { return std::make_shared<BlobPtr::element_type>(folly::IOBuf{}); });
-  queue.markImportAsFinished<BlobPtr::element_type>(
-      dequeuedRequest->getRequest<HgImportRequest::BlobImport>()->hash, blob);
+  queue.markImportAsFinished<BlobPtr::element_type>(dequeuedRequest, blob);
 }
 
 TEST_F(HgImportRequestQueueTest, duplicateRequestAfterMarkedDone) {
@@ -459,8 +450,7 @@ TEST_F(HgImportRequestQueueTest, duplicateRequestAfterMarkedDone) {
 
   auto blob = folly::makeTryWith(
       [] { return std::make_shared<BlobPtr::element_type>(folly::IOBuf{}); });
-  queue.markImportAsFinished<BlobPtr::element_type>(
-      dequeuedRequest->getRequest<HgImportRequest::BlobImport>()->hash, blob);
+  queue.markImportAsFinished<BlobPtr::element_type>(dequeuedRequest, blob);
 }
 
 TEST_F(HgImportRequestQueueTest, multipleDuplicateRequests) {
@@ -503,8 +493,7 @@ TEST_F(HgImportRequestQueueTest, multipleDuplicateRequests) {
 
   auto blob = folly::makeTryWith(
       [] { return std::make_shared<BlobPtr::element_type>(folly::IOBuf{}); });
-  queue.markImportAsFinished<BlobPtr::element_type>(
-      dequeuedRequest->getRequest<HgImportRequest::BlobImport>()->hash, blob);
+  queue.markImportAsFinished<BlobPtr::element_type>(dequeuedRequest, blob);
 }
 
 TEST_F(HgImportRequestQueueTest, twoDuplicateRequestsDifferentPriority) {
@@ -557,8 +546,7 @@ TEST_F(HgImportRequestQueueTest, twoDuplicateRequestsDifferentPriority) {
 
     auto blob = folly::makeTryWith(
         [] { return std::make_shared<BlobPtr::element_type>(folly::IOBuf{}); });
-    queue.markImportAsFinished<BlobPtr::element_type>(
-        request->getRequest<HgImportRequest::BlobImport>()->hash, blob);
+    queue.markImportAsFinished<BlobPtr::element_type>(request, blob);
   }
 
   auto expLowPri = queue.dequeue().at(0);
@@ -568,8 +556,7 @@ TEST_F(HgImportRequestQueueTest, twoDuplicateRequestsDifferentPriority) {
 
   auto blob = folly::makeTryWith(
       [] { return std::make_shared<BlobPtr::element_type>(folly::IOBuf{}); });
-  queue.markImportAsFinished<BlobPtr::element_type>(
-      expLowPri->getRequest<HgImportRequest::BlobImport>()->hash, blob);
+  queue.markImportAsFinished<BlobPtr::element_type>(expLowPri, blob);
 
   for (int i = 5; i > 0; i--) {
     auto expected = enqueued.back();
@@ -582,7 +569,194 @@ TEST_F(HgImportRequestQueueTest, twoDuplicateRequestsDifferentPriority) {
 
     auto expBlob = folly::makeTryWith(
         [] { return std::make_shared<BlobPtr::element_type>(folly::IOBuf{}); });
-    queue.markImportAsFinished<BlobPtr::element_type>(
-        request->getRequest<HgImportRequest::BlobImport>()->hash, expBlob);
+    queue.markImportAsFinished<BlobPtr::element_type>(request, expBlob);
   }
 }
+
+TEST_F(HgImportRequestQueueTest, duplicateRequestRaisesPriorityClass) {
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  auto proxyHash = HgProxyHash{RelativePath{"some_blob"}, uniqueHash()};
+  auto [lowHash, lowRequest] = makeBlobImportRequestWithHash(
+      ImportPriority{ImportPriority::Class::Low}, proxyHash);
+  queue.enqueueBlob(std::move(lowRequest));
+  auto normalHash = insertBlobImportRequest(
+      queue, ImportPriority{ImportPriority::Class::Normal});
+
+  // A filesystem read of the prefetched blob moves it ahead of the normal
+  // priority one.
+  auto [highHash, highRequest] = makeBlobImportRequestWithHash(
+      ImportPriority{ImportPriority::Class::High}, proxyHash);
+  queue.enqueueBlob(std::move(highRequest));
+
+  auto first = queue.dequeue().at(0);
+  EXPECT_EQ(lowHash, first->getRequest<HgImportRequest::BlobImport>()->hash);
+  EXPECT_EQ(ImportPriority::Class::High, first->getPriority().getClass());
+  EXPECT_EQ(
+      1, first->getRequest<HgImportRequest::BlobImport>()->promises.size());
+
+  // The request was only dequeued once, even though it was queued at both
+  // priorities.
+  auto second = queue.dequeue();
+  ASSERT_EQ(1, second.size());
+  EXPECT_EQ(
+      normalHash,
+      second.at(0)->getRequest<HgImportRequest::BlobImport>()->hash);
+
+  auto blob = folly::makeTryWith(
+      [] { return std::make_shared<BlobPtr::element_type>(folly::IOBuf{}); });
+  queue.markImportAsFinished<BlobPtr::element_type>(first, blob);
+  queue.markImportAsFinished<BlobPtr::element_type>(second.at(0), blob);
+}
+
+TEST_F(HgImportRequestQueueTest, abandonedRequestsAreDropped) {
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  folly::CancellationSource cancellation;
+  auto proxyHash = HgProxyHash{RelativePath{"some_blob"}, uniqueHash()};
+  auto [cancelledHash, cancelledRequest] = makeBlobImportRequestWithHash(
+      ImportPriority{ImportPriority::Class::High}, proxyHash);
+  cancelledRequest->setCancellation(cancellation.getToken(), std::nullopt);
+  auto cancelledFuture = queue.enqueueBlob(std::move(cancelledRequest));
+
+  auto [expiredHash, expiredRequest] =
+      makeBlobImportRequest(ImportPriority{ImportPriority::Class::High});
+  expiredRequest->setCancellation(
+      folly::CancellationToken{}, std::chrono::steady_clock::now());
+  auto expiredFuture = queue.enqueueBlob(std::move(expiredRequest));
+
+  auto hash = insertBlobImportRequest(
+      queue, ImportPriority{ImportPriority::Class::Normal});
+
+  cancellation.requestCancellation();
+
+  auto requests = queue.dequeue();
+  ASSERT_EQ(1, requests.size());
+  EXPECT_EQ(hash, requests.at(0)->getHash());
+  EXPECT_THROW(std::move(cancelledFuture).get(), folly::OperationCancelled);
+  EXPECT_THROW(std::move(expiredFuture).get(), folly::OperationCancelled);
+
+  // The dropped object is imported for a new caller.
+  auto [againHash, againRequest] = makeBlobImportRequestWithHash(
+      ImportPriority{ImportPriority::Class::Normal}, proxyHash);
+  queue.enqueueBlob(std::move(againRequest));
+  EXPECT_EQ(cancelledHash, queue.dequeue().at(0)->getHash());
+}
+
+TEST_F(HgImportRequestQueueTest, lateFinishOfDroppedRequestIsIgnored) {
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  folly::CancellationSource cancellation;
+  auto proxyHash = HgProxyHash{RelativePath{"some_blob"}, uniqueHash()};
+  auto [droppedHash, dropped] = makeBlobImportRequestWithHash(
+      ImportPriority{ImportPriority::Class::Normal}, proxyHash);
+  dropped->setCancellation(cancellation.getToken(), std::nullopt);
+  queue.enqueueBlob(dropped);
+  insertBlobImportRequest(queue, ImportPriority{ImportPriority::Class::Low});
+  cancellation.requestCancellation();
+  EXPECT_NE(droppedHash, queue.dequeue().at(0)->getHash());
+
+  // A new request for the same object, joined by a second caller.
+  auto [againHash, again] = makeBlobImportRequestWithHash(
+      ImportPriority{ImportPriority::Class::Normal}, proxyHash);
+  queue.enqueueBlob(again);
+  auto [duplicateHash, duplicate] = makeBlobImportRequestWithHash(
+      ImportPriority{ImportPriority::Class::Normal}, proxyHash);
+  auto duplicateFuture = queue.enqueueBlob(std::move(duplicate));
+  EXPECT_EQ(again, queue.dequeue().at(0));
+
+  // The caller of the dropped request finishing doesn't complete the new one.
+  folly::Try<BlobPtr> cancelled{
+      folly::make_exception_wrapper<folly::OperationCancelled>()};
+  queue.markImportAsFinished<BlobPtr::element_type>(dropped, cancelled);
+  EXPECT_FALSE(duplicateFuture.isReady());
+
+  auto blob = folly::makeTryWith(
+      [] { return std::make_shared<BlobPtr::element_type>(folly::IOBuf{}); });
+  queue.markImportAsFinished<BlobPtr::element_type>(again, blob);
+  EXPECT_EQ(blob.value(), std::move(duplicateFuture).get());
+}
+
+TEST_F(HgImportRequestQueueTest, requestIsKeptWhileACallerWaits) {
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  folly::CancellationSource cancellation;
+  auto proxyHash = HgProxyHash{RelativePath{"some_blob"}, uniqueHash()};
+  auto [hash, request] = makeBlobImportRequestWithHash(
+      ImportPriority{ImportPriority::Class::Normal}, proxyHash);
+  request->setCancellation(cancellation.getToken(), std::nullopt);
+  queue.enqueueBlob(std::move(request));
+
+  // A duplicate request from a caller that can't be cancelled.
+  auto [duplicateHash, duplicate] = makeBlobImportRequestWithHash(
+      ImportPriority{ImportPriority::Class::Normal}, proxyHash);
+  auto duplicateFuture = queue.enqueueBlob(std::move(duplicate));
+
+  cancellation.requestCancellation();
+
+  auto requests = queue.dequeue();
+  ASSERT_EQ(1, requests.size());
+  EXPECT_EQ(hash, requests.at(0)->getHash());
+
+  auto blob = folly::makeTryWith(
+      [] { return std::make_shared<BlobPtr::element_type>(folly::IOBuf{}); });
+  queue.markImportAsFinished<BlobPtr::element_type>(requests.at(0), blob);
+  EXPECT_EQ(blob.value(), std::move(duplicateFuture).get());
+}
+
+TEST_F(HgImportRequestQueueTest, highPriorityDequeueSkipsLowerClasses) {
+  auto queue = HgImportRequestQueue{edenConfig};
+  auto batchSizes = HgImportRequestQueue::BatchSizes{1, 1, 1};
+
+  auto lowHash = insertBlobImportRequest(
+      queue, ImportPriority{ImportPriority::Class::Low});
+
+  // Waits until a high priority request is queued, even though a low
+  // priority one already is.
+  std::vector<std::shared_ptr<HgImportRequest>> highRequests;
+  std::thread reserved{[&] {
+    highRequests = queue.dequeue(batchSizes, ImportPriority::Class::High);
+  }};
+  auto highHash = insertBlobImportRequest(
+      queue, ImportPriority{ImportPriority::Class::High});
+  reserved.join();
+
+  ASSERT_EQ(1, highRequests.size());
+  EXPECT_EQ(highHash, highRequests.at(0)->getHash());
+  EXPECT_EQ(lowHash, queue.dequeue(batchSizes).at(0)->getHash());
+}
+
+TEST_F(HgImportRequestQueueTest, dequeueRecordsDequeueTime) {
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  auto [hash, request] =
+      makeBlobImportRequest(ImportPriority{ImportPriority::Class::Normal});
+  queue.enqueueBlob(request);
+  auto before = std::chrono::steady_clock::now();
+
+  auto dequeued = queue.dequeue().at(0);
+  EXPECT_EQ(hash, dequeued->getHash());
+  EXPECT_GE(dequeued->getDequeueTime(), before);
+  EXPECT_GE(dequeued->getDequeueTime(), dequeued->getRequestTime());
+}
+
+TEST_F(HgImportRequestQueueTest, estimateMemoryUsageCountsQueuedRequests) {
+  auto queue = HgImportRequestQueue{edenConfig};
+  EXPECT_EQ(0, queue.estimateMemoryUsage());
+
+  auto [hash, request] =
+      makeBlobImportRequest(ImportPriority{ImportPriority::Class::Normal});
+  auto future = queue.enqueueBlob(std::move(request));
+  auto queued = queue.estimateMemoryUsage();
+  EXPECT_GE(queued, sizeof(HgImportRequest));
+
+  // Requests being imported are still counted, until they finish.
+  auto dequeued = queue.dequeue().at(0);
+  EXPECT_EQ(hash, dequeued->getHash());
+  EXPECT_GE(queue.estimateMemoryUsage(), sizeof(HgImportRequest));
+
+  auto blob = folly::makeTryWith(
+      [] { return std::make_shared<BlobPtr::element_type>(folly::IOBuf{}); });
+  queue.markImportAsFinished<BlobPtr::element_type>(dequeued, blob);
+  EXPECT_EQ(0, queue.estimateMemoryUsage());
+}
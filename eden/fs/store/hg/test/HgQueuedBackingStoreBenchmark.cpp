@@ -0,0 +1,387 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <fb303/ServiceData.h>
+#include <folly/Conv.h>
+#include <folly/Random.h>
+#include <folly/futures/Future.h>
+#include <folly/init/Init.h>
+#include <folly/portability/GFlags.h>
+#include <folly/stop_watch.h>
+#include <folly/synchronization/test/Barrier.h>
+#include <algorithm>
+#include <cinttypes>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/config/ReloadableConfig.h"
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/BackingStoreLogger.h"
+#include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/store/hg/HgBackingStore.h"
+#include "eden/fs/store/hg/HgProxyHash.h"
+#include "eden/fs/store/hg/HgQueuedBackingStore.h"
+#include "eden/fs/telemetry/EdenStats.h"
+#include "eden/fs/telemetry/NullStructuredLogger.h"
+#include "eden/fs/utils/PathFuncs.h"
+#include "eden/fs/utils/UnboundedQueueExecutor.h"
+
+DEFINE_string(repo, "", "Sapling repository whose local cache holds --commit");
+DEFINE_string(commit, "", "The commit whose trees and files are fetched");
+DEFINE_uint64(objects, 10000, "Number of the commit's objects to fetch from");
+DEFINE_uint32(requesters, 16, "The number of concurrent requesting threads");
+DEFINE_uint64(requests, 10000, "Number of fetches per requester");
+DEFINE_uint32(inflight, 64, "Fetches each requester keeps outstanding");
+DEFINE_uint32(treePercent, 10, "Percentage of the fetches that are trees");
+DEFINE_uint32(
+    metadataPercent,
+    30,
+    "Percentage of the fetches that are blob metadata, the rest being blobs");
+DEFINE_uint32(
+    prefetchPercent,
+    20,
+    "Percentage of the fetches made at prefetch rather than filesystem "
+    "priority");
+
+using namespace facebook::eden;
+
+namespace facebook::eden {
+
+class HgQueuedBackingStoreBenchmarkAccess {
+ public:
+  static folly::SemiFuture<BackingStore::GetBlobResult> getBlobImpl(
+      HgQueuedBackingStore& store,
+      const ObjectId& id,
+      const HgProxyHash& proxyHash,
+      const ObjectFetchContextPtr& context) {
+    return store.getBlobImpl(id, proxyHash, context);
+  }
+
+  static folly::SemiFuture<BackingStore::GetTreeResult> getTreeImpl(
+      HgQueuedBackingStore& store,
+      const ObjectId& id,
+      const HgProxyHash& proxyHash,
+      const ObjectFetchContextPtr& context) {
+    return store.getTreeImpl(id, proxyHash, context);
+  }
+};
+
+} // namespace facebook::eden
+
+namespace {
+
+class BenchmarkFetchContext : public ObjectFetchContext {
+ public:
+  BenchmarkFetchContext(ImportPriority priority, Cause cause)
+      : priority_{priority}, cause_{cause} {}
+
+  ImportPriority getPriority() const override {
+    return priority_;
+  }
+  Cause getCause() const override {
+    return cause_;
+  }
+  const std::unordered_map<std::string, std::string>* getRequestInfo()
+      const override {
+    return nullptr;
+  }
+
+ private:
+  ImportPriority priority_;
+  Cause cause_;
+};
+
+struct Object {
+  ObjectId id;
+  HgProxyHash proxyHash;
+};
+
+/**
+ * Lists up to FLAGS_objects trees and files of the commit, breadth first.
+ */
+void listObjects(
+    HgQueuedBackingStore& store,
+    LocalStore& localStore,
+    EdenStats& stats,
+    std::vector<Object>& trees,
+    std::vector<Object>& files) {
+  const auto& context = ObjectFetchContext::getNullContext();
+  auto root = store.getRootTree(store.parseRootId(FLAGS_commit), context).get();
+  std::deque<TreePtr> pending{root};
+  while (!pending.empty() && trees.size() + files.size() < FLAGS_objects) {
+    auto tree = std::move(pending.front());
+    pending.pop_front();
+    trees.push_back(Object{
+        tree->getHash(),
+        HgProxyHash::load(&localStore, tree->getHash(), __func__, stats)});
+    for (const auto& [name, entry] : *tree) {
+      if (entry.isTree()) {
+        pending.push_back(store.getTree(entry.getHash(), context).get().tree);
+      } else {
+        files.push_back(Object{
+            entry.getHash(),
+            HgProxyHash::load(&localStore, entry.getHash(), __func__, stats)});
+      }
+    }
+  }
+}
+
+/**
+ * The difference of a counter between two snapshots of the fb303 counters.
+ */
+int64_t delta(
+    const std::map<std::string, int64_t>& before,
+    const std::map<std::string, int64_t>& after,
+    const std::string& key) {
+  auto value = [&](const std::map<std::string, int64_t>& counters) {
+    auto it = counters.find(key);
+    return it == counters.end() ? 0 : it->second;
+  };
+  return value(after) - value(before);
+}
+
+void printAverage(
+    const char* label,
+    const std::map<std::string, int64_t>& before,
+    const std::map<std::string, int64_t>& after,
+    const std::string& stat) {
+  auto count = delta(before, after, stat + ".count");
+  if (count == 0) {
+    return;
+  }
+  printf(
+      "  %-24s %10.1f\n",
+      label,
+      static_cast<double>(delta(before, after, stat + ".sum")) / count);
+}
+
+void printLatencies(const char* label, std::vector<uint64_t>& latencies) {
+  if (latencies.empty()) {
+    return;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  auto at = [&](double quantile) {
+    return latencies[static_cast<size_t>(quantile * (latencies.size() - 1))];
+  };
+  printf(
+      "  %-10s %8zu requests, p50 %8" PRIu64 " us, p90 %8" PRIu64
+      " us, p99 %8" PRIu64 " us, max %8" PRIu64 " us\n",
+      label,
+      latencies.size(),
+      at(0.5),
+      at(0.9),
+      at(0.99),
+      latencies.back());
+}
+
+} // namespace
+
+/*
+ * Measures the throughput of HgQueuedBackingStore's import queue, batching
+ * and datapack store against a local Sapling cache.
+ *
+ * Requesters enqueue a mix of tree, blob and blob metadata imports at
+ * filesystem and prefetch priorities, bypassing the hgcache check that would
+ * otherwise serve them inline, as a cold EdenFS sees them.
+ */
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  if (FLAGS_repo.empty() || FLAGS_commit.empty()) {
+    fprintf(stderr, "--repo and --commit are required\n");
+    return 1;
+  }
+
+  auto config = std::make_shared<ReloadableConfig>(
+      EdenConfig::createTestEdenConfig(), ConfigReloadBehavior::NoReload);
+  auto stats = makeRefPtr<EdenStats>();
+  auto localStore = std::make_shared<MemoryLocalStore>(stats.copy());
+  UnboundedQueueExecutor serverThreadPool{4, "serverpool"};
+  auto structuredLogger = std::make_shared<NullStructuredLogger>();
+  HgQueuedBackingStore store{
+      localStore,
+      stats.copy(),
+      std::make_unique<HgBackingStore>(
+          realpath(FLAGS_repo),
+          localStore,
+          &serverThreadPool,
+          config,
+          stats.copy(),
+          structuredLogger),
+      config,
+      structuredLogger,
+      std::make_unique<BackingStoreLogger>()};
+
+  std::vector<Object> trees;
+  std::vector<Object> files;
+  listObjects(store, *localStore, *stats, trees, files);
+  printf("Fetching from %zu trees and %zu files\n", trees.size(), files.size());
+  if (files.empty()) {
+    fprintf(stderr, "The commit has no files\n");
+    return 1;
+  }
+
+  ObjectFetchContextPtr fsContext = makeRefPtr<BenchmarkFetchContext>(
+      kDefaultFsImportPriority, ObjectFetchContext::Cause::Fs);
+  ObjectFetchContextPtr prefetchContext = makeRefPtr<BenchmarkFetchContext>(
+      kReaddirPrefetchPriority, ObjectFetchContext::Cause::Prefetch);
+
+  enum Kind { kTree, kBlob, kBlobMeta, kKindCount };
+  static constexpr const char* kKindNames[] = {"tree", "blob", "blobmeta"};
+
+  std::mutex resultMutex;
+  std::vector<uint64_t> latencies[kKindCount];
+  std::vector<uint64_t> fsLatencies;
+  std::vector<uint64_t> prefetchLatencies;
+
+  auto requester = [&] {
+    std::vector<uint64_t> kindLatencies[kKindCount];
+    std::vector<uint64_t> priorityLatencies[2];
+
+    for (uint64_t done = 0; done < FLAGS_requests;) {
+      auto batch = std::min<uint64_t>(FLAGS_inflight, FLAGS_requests - done);
+      std::vector<Kind> kinds(batch);
+      std::vector<bool> prefetches(batch);
+      std::vector<uint64_t> elapsed(batch);
+      std::vector<folly::Future<folly::Unit>> fetches;
+      fetches.reserve(batch);
+
+      for (uint64_t i = 0; i < batch; ++i) {
+        auto percent = folly::Random::rand32(100);
+        kinds[i] = percent < FLAGS_treePercent ? kTree
+            : percent < FLAGS_treePercent + FLAGS_metadataPercent
+            ? kBlobMeta
+            : kBlob;
+        prefetches[i] = folly::Random::rand32(100) < FLAGS_prefetchPercent;
+        const auto& context = prefetches[i] ? prefetchContext : fsContext;
+
+        folly::SemiFuture<folly::Unit> fetch = folly::makeSemiFuture();
+        if (kinds[i] == kTree) {
+          const auto& tree = trees[folly::Random::rand32(trees.size())];
+          fetch = HgQueuedBackingStoreBenchmarkAccess::getTreeImpl(
+                      store, tree.id, tree.proxyHash, context)
+                      .unit();
+        } else {
+          const auto& file = files[folly::Random::rand32(files.size())];
+          fetch = kinds[i] == kBlob
+              ? HgQueuedBackingStoreBenchmarkAccess::getBlobImpl(
+                    store, file.id, file.proxyHash, context)
+                    .unit()
+              : store.getBlobMetadataImpl(file.id, file.proxyHash, context)
+                    .unit();
+        }
+
+        // Completion is recorded on the thread that fulfills the fetch, so
+        // that waiting on the other fetches doesn't count.
+        fetches.push_back(
+            std::move(fetch).toUnsafeFuture().thenTry(
+                [watch = folly::stop_watch<std::chrono::microseconds>{},
+                 &result = elapsed[i]](folly::Try<folly::Unit>&& fetched) {
+                  result = watch.elapsed().count();
+                  fetched.value();
+                }));
+      }
+
+      folly::collectAllUnsafe(fetches).wait();
+      for (uint64_t i = 0; i < batch; ++i) {
+        kindLatencies[kinds[i]].push_back(elapsed[i]);
+        priorityLatencies[prefetches[i]].push_back(elapsed[i]);
+      }
+      done += batch;
+    }
+
+    std::lock_guard guard{resultMutex};
+    for (size_t kind = 0; kind < kKindCount; ++kind) {
+      latencies[kind].insert(
+          latencies[kind].end(),
+          kindLatencies[kind].begin(),
+          kindLatencies[kind].end());
+    }
+    fsLatencies.insert(
+        fsLatencies.end(),
+        priorityLatencies[0].begin(),
+        priorityLatencies[0].end());
+    prefetchLatencies.insert(
+        prefetchLatencies.end(),
+        priorityLatencies[1].begin(),
+        priorityLatencies[1].end());
+  };
+
+  auto* serviceData = facebook::fb303::ServiceData::get();
+  stats->flush();
+  auto before = serviceData->getCounters();
+
+  folly::test::Barrier gate{FLAGS_requesters + 1};
+  std::vector<std::thread> threads;
+  threads.reserve(FLAGS_requesters);
+  for (uint32_t t = 0; t < FLAGS_requesters; ++t) {
+    threads.emplace_back([&] {
+      gate.wait();
+      requester();
+    });
+  }
+
+  folly::stop_watch<std::chrono::microseconds> watch;
+  gate.wait();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto elapsed = watch.elapsed();
+
+  stats->flush();
+  auto after = serviceData->getCounters();
+
+  auto total = uint64_t{FLAGS_requesters} * FLAGS_requests;
+  printf(
+      "%" PRIu64 " requests in %.3f s: %.0f requests/s\n",
+      total,
+      elapsed.count() / 1000000.0,
+      total * 1000000.0 / elapsed.count());
+
+  printf("Latency by kind\n");
+  for (size_t kind = 0; kind < kKindCount; ++kind) {
+    printLatencies(kKindNames[kind], latencies[kind]);
+  }
+  printf("Latency by priority\n");
+  printLatencies("fs", fsLatencies);
+  printLatencies("prefetch", prefetchLatencies);
+
+  printf("Average queue wait (us)\n");
+  printAverage("high", before, after, "store.hg.import_queue_wait.high_us");
+  printAverage("normal", before, after, "store.hg.import_queue_wait.normal_us");
+  printAverage("low", before, after, "store.hg.import_queue_wait.low_us");
+
+  printf("Average batch size (limit)\n");
+  for (size_t kind = 0; kind < kKindCount; ++kind) {
+    auto batches = delta(
+        before,
+        after,
+        folly::to<std::string>(
+            "store.hg.import_batch.", kKindNames[kind], ".count"));
+    if (batches == 0) {
+      continue;
+    }
+    auto sum = [&](folly::StringPiece stat) {
+      return static_cast<double>(delta(
+          before,
+          after,
+          folly::to<std::string>(
+              "store.hg.", stat, ".", kKindNames[kind], ".sum")));
+    };
+    printf(
+        "  %-10s %8" PRId64 " batches of %6.1f (%6.1f)\n",
+        kKindNames[kind],
+        batches,
+        sum("import_batch") / batches,
+        sum("import_batch_size") / batches);
+  }
+
+  return 0;
+}
@@ -34,6 +34,8 @@ const auto hash5 =
     ObjectId::fromHex("0000000000000000000000000000000000000002");
 const auto hash6 =
     ObjectId::fromHex("0000000000000000000000000000000000000003");
+const auto hash16 =
+    ObjectId::fromHex("0000000000000000000000000000000000000004");
 
 const auto blob3 = std::make_shared<Blob>("333"_sp);
 const auto blob4 = std::make_shared<Blob>("4444"_sp);
@@ -111,6 +113,7 @@ struct BlobAccessTest : ::testing::Test {
     backingStore->putBlob(hash4, "4444"_sp)->setReady();
     backingStore->putBlob(hash5, "55555"_sp)->setReady();
     backingStore->putBlob(hash6, "666666"_sp)->setReady();
+    backingStore->putBlob(hash16, "0123456789abcdef"_sp)->setReady();
   }
 
   std::shared_ptr<const Blob> getBlobBlocking(const ObjectId& hash) {
@@ -175,3 +178,44 @@ TEST_F(BlobAccessTest, drops_oldest_blobs) {
   EXPECT_EQ(2, backingStore->getAccessCount(hash4));
   EXPECT_EQ(1, backingStore->getAccessCount(hash5));
 }
+
+TEST_F(BlobAccessTest, caches_read_chunks_of_large_blobs) {
+  // Cache hash16 by 4 byte chunks, at most 2 of them.
+  auto chunkedCache = BlobCache::create(
+      10, 0, 1, CacheEvictionPolicy::Lru, BlobChunkingOptions{8, 4, 8});
+  BlobAccess chunkedAccess{objectStore, chunkedCache};
+  auto readRange = [&](size_t offset, size_t length) {
+    auto range = chunkedAccess
+                     .getBlobRange(
+                         hash16,
+                         offset,
+                         length,
+                         ObjectFetchContext::getNullContext())
+                     .get(0ms);
+    EXPECT_EQ(offset + length >= 16, range.eof);
+    return range.data->to<std::string>();
+  };
+
+  EXPECT_EQ("23456", readRange(2, 5));
+  EXPECT_EQ(8, chunkedCache->getChunkedSize());
+  EXPECT_EQ(0, chunkedCache->getStats().objectCount);
+  EXPECT_EQ("0123", readRange(0, 4));
+  EXPECT_EQ(1, backingStore->getAccessCount(hash16));
+
+  // Evicts [4, 8), which was read less recently than [0, 4).
+  EXPECT_EQ("cdef", readRange(12, 10));
+  EXPECT_EQ(2, backingStore->getAccessCount(hash16));
+  EXPECT_EQ(8, chunkedCache->getChunkedSize());
+  EXPECT_EQ("0123", readRange(0, 4));
+  EXPECT_EQ(2, backingStore->getAccessCount(hash16));
+  EXPECT_EQ("45", readRange(4, 2));
+  EXPECT_EQ(3, backingStore->getAccessCount(hash16));
+
+  // Blobs below the threshold are still cached whole.
+  auto range =
+      chunkedAccess
+          .getBlobRange(hash4, 1, 2, ObjectFetchContext::getNullContext())
+          .get(0ms);
+  EXPECT_EQ("44", range.data->to<std::string>());
+  EXPECT_EQ(4, chunkedCache->getStats().totalSizeInBytes);
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/BloomFilter.h"
+
+#include <folly/Conv.h>
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using namespace folly::string_piece_literals;
+
+namespace {
+
+std::string makeKey(size_t i) {
+  return folly::to<std::string>("key", i);
+}
+
+} // namespace
+
+TEST(BloomFilterTest, empty_filter_contains_nothing) {
+  BloomFilter filter{100};
+  EXPECT_FALSE(filter.mayContain("key"_sp));
+  EXPECT_EQ(0, filter.getInsertCount());
+  EXPECT_EQ(0.0, filter.getEstimatedFalsePositiveRate());
+}
+
+TEST(BloomFilterTest, no_false_negatives) {
+  BloomFilter filter{10'000};
+  for (size_t i = 0; i < 10'000; ++i) {
+    filter.insert(folly::StringPiece{makeKey(i)});
+  }
+  for (size_t i = 0; i < 10'000; ++i) {
+    EXPECT_TRUE(filter.mayContain(folly::StringPiece{makeKey(i)})) << i;
+  }
+  EXPECT_EQ(10'000, filter.getInsertCount());
+}
+
+TEST(BloomFilterTest, false_positive_rate_at_capacity) {
+  BloomFilter filter{10'000};
+  for (size_t i = 0; i < 10'000; ++i) {
+    filter.insert(folly::StringPiece{makeKey(i)});
+  }
+  size_t falsePositives = 0;
+  for (size_t i = 10'000; i < 110'000; ++i) {
+    if (filter.mayContain(folly::StringPiece{makeKey(i)})) {
+      ++falsePositives;
+    }
+  }
+  // About 1% is expected; leave room for the blocking and for variance.
+  EXPECT_LT(falsePositives, 2'500);
+  EXPECT_GT(filter.getEstimatedFalsePositiveRate(), 0.005);
+  EXPECT_LT(filter.getEstimatedFalsePositiveRate(), 0.02);
+}
+
+TEST(BloomFilterTest, clear_forgets_keys) {
+  BloomFilter filter{100};
+  filter.insert("key"_sp);
+  EXPECT_TRUE(filter.mayContain("key"_sp));
+  filter.clear();
+  EXPECT_FALSE(filter.mayContain("key"_sp));
+  EXPECT_EQ(0, filter.getInsertCount());
+}
+
+TEST(BloomFilterTest, memory_usage_scales_with_capacity) {
+  BloomFilter small{1'000};
+  BloomFilter large{1'000'000};
+  // 10 bits per key.
+  EXPECT_GE(large.getMemoryUsage(), 1'000'000 * 10 / 8);
+  EXPECT_LT(small.getMemoryUsage(), large.getMemoryUsage() / 100);
+}
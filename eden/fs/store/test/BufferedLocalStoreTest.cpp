@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/BufferedLocalStore.h"
+
+#include <folly/portability/GTest.h>
+#include <thread>
+
+#include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/store/StoreResult.h"
+#include "eden/fs/telemetry/EdenStats.h"
+
+using namespace facebook::eden;
+using namespace folly::string_piece_literals;
+using namespace std::chrono_literals;
+
+namespace {
+
+class BufferedLocalStoreTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    backing_ = std::make_shared<MemoryLocalStore>(makeRefPtr<EdenStats>());
+    // A long flush latency keeps writes queued until the test flushes them.
+    store_ = std::make_shared<BufferedLocalStore>(
+        backing_, 1024 * 1024, 1h, makeRefPtr<EdenStats>());
+    store_->open();
+  }
+
+  void TearDown() override {
+    store_->close();
+  }
+
+  std::shared_ptr<MemoryLocalStore> backing_;
+  std::shared_ptr<BufferedLocalStore> store_;
+};
+
+} // namespace
+
+TEST_F(BufferedLocalStoreTest, reads_observe_queued_writes) {
+  store_->put(KeySpace::BlobFamily, "key"_sp, "value"_sp);
+
+  EXPECT_FALSE(backing_->hasKey(KeySpace::BlobFamily, "key"_sp));
+  EXPECT_TRUE(store_->hasKey(KeySpace::BlobFamily, "key"_sp));
+  EXPECT_EQ("value", store_->get(KeySpace::BlobFamily, "key"_sp).piece());
+
+  std::vector<folly::ByteRange> keys{
+      folly::ByteRange{"key"_sp}, folly::ByteRange{"missing"_sp}};
+  auto results = store_->getBatch(KeySpace::BlobFamily, keys).get();
+  ASSERT_EQ(2, results.size());
+  EXPECT_EQ("value", results[0].piece());
+  EXPECT_FALSE(results[1].isValid());
+}
+
+TEST_F(BufferedLocalStoreTest, flush_writes_to_backing_store) {
+  auto batch = store_->beginWrite();
+  batch->put(KeySpace::BlobFamily, "a"_sp, "A"_sp);
+  batch->put(KeySpace::TreeFamily, "b"_sp, "B"_sp);
+  // Nothing is queued until the batch is flushed.
+  EXPECT_FALSE(store_->hasKey(KeySpace::BlobFamily, "a"_sp));
+  batch->flush();
+  EXPECT_TRUE(store_->hasKey(KeySpace::BlobFamily, "a"_sp));
+
+  store_->flush();
+  EXPECT_EQ("A", backing_->get(KeySpace::BlobFamily, "a"_sp).piece());
+  EXPECT_EQ("B", backing_->get(KeySpace::TreeFamily, "b"_sp).piece());
+}
+
+TEST_F(BufferedLocalStoreTest, close_writes_queued_data) {
+  store_->put(KeySpace::BlobFamily, "key"_sp, "value"_sp);
+  store_->close();
+  backing_->open();
+  EXPECT_EQ("value", backing_->get(KeySpace::BlobFamily, "key"_sp).piece());
+
+  // Once closed, writes go straight through.
+  store_->put(KeySpace::BlobFamily, "other"_sp, "value"_sp);
+  EXPECT_TRUE(backing_->hasKey(KeySpace::BlobFamily, "other"_sp));
+}
+
+TEST_F(BufferedLocalStoreTest, full_buffer_is_written_without_waiting) {
+  auto store = std::make_shared<BufferedLocalStore>(
+      backing_, 16, 1h, makeRefPtr<EdenStats>());
+  store->open();
+  std::string value(64, 'x');
+  store->put(KeySpace::BlobFamily, "key"_sp, folly::StringPiece{value});
+
+  // The queue is over its limit, so the writer doesn't wait for the flush
+  // latency.
+  auto deadline = std::chrono::steady_clock::now() + 10s;
+  while (!backing_->hasKey(KeySpace::BlobFamily, "key"_sp) &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(1ms);
+  }
+  EXPECT_TRUE(backing_->hasKey(KeySpace::BlobFamily, "key"_sp));
+  store->close();
+}
+
+TEST_F(BufferedLocalStoreTest, clear_key_space_drops_queued_writes) {
+  store_->put(KeySpace::BlobFamily, "key"_sp, "value"_sp);
+  store_->clearKeySpace(KeySpace::BlobFamily);
+  EXPECT_FALSE(store_->hasKey(KeySpace::BlobFamily, "key"_sp));
+  EXPECT_FALSE(backing_->hasKey(KeySpace::BlobFamily, "key"_sp));
+}
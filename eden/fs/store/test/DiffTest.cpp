@@ -7,6 +7,8 @@
 
 #include "eden/fs/store/Diff.h"
 
+#include <fmt/format.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
 #include <folly/executors/QueuedImmediateExecutor.h>
 #include <folly/portability/GMock.h>
 #include <folly/portability/GTest.h>
@@ -21,6 +23,7 @@
 #include "eden/fs/store/ObjectStore.h"
 #include "eden/fs/store/ScmStatusDiffCallback.h"
 #include "eden/fs/store/TreeCache.h"
+#include "eden/fs/store/TreeDiffCache.h"
 #include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/telemetry/NullStructuredLogger.h"
 #include "eden/fs/testharness/FakeBackingStore.h"
@@ -1375,3 +1378,104 @@ TEST_F(DiffTest, directoryDiff) {
   // TODO(xavierd): Are we missing a change to the root whenever a file to the
   // root is created/removed?
 }
+
+TEST_F(DiffTest, diffOnExecutor) {
+  FakeTreeBuilder builder;
+
+  for (int dir = 0; dir < 10; ++dir) {
+    for (int file = 0; file < 5; ++file) {
+      builder.setFile(
+          fmt::format("dir{}/sub/file{}.txt", dir, file), "contents");
+    }
+  }
+  builder.finalize(backingStore_, /* setReady */ true);
+  backingStore_->putCommit("1", builder)->setReady();
+
+  auto builder2 = builder.clone();
+  builder2.replaceFile("dir0/sub/file0.txt", "new contents");
+  builder2.removeFile("dir3/sub/file4.txt");
+  builder2.setFile("dir9/sub/new/file.txt", "contents");
+  builder2.finalize(backingStore_, /* setReady */ true);
+  backingStore_->putCommit("2", builder2)->setReady();
+
+  auto callback = std::make_unique<ScmStatusDiffCallback>();
+  auto topLevelIgnores = std::make_unique<TopLevelIgnores>("", "");
+  auto gitIgnoreStack = topLevelIgnores->getStack();
+  auto diffContext =
+      makeDiffContext(callback.get(), std::move(topLevelIgnores));
+  diffContext->setExecutor(
+      std::make_shared<folly::CPUThreadPoolExecutor>(4), 2);
+
+  diffTrees(
+      diffContext.get(),
+      RelativePathPiece{},
+      builder.getRoot()->get().getHash(),
+      builder2.getRoot()->get().getHash(),
+      gitIgnoreStack,
+      false)
+      .get(10s);
+  auto result = callback->extractStatus();
+  EXPECT_THAT(*result.errors_ref(), UnorderedElementsAre());
+  EXPECT_THAT(
+      *result.entries_ref(),
+      UnorderedElementsAre(
+          Pair("dir0/sub/file0.txt", ScmFileStatus::MODIFIED),
+          Pair("dir3/sub/file4.txt", ScmFileStatus::REMOVED),
+          Pair("dir9/sub/new/file.txt", ScmFileStatus::ADDED)));
+}
+
+TEST_F(DiffTest, treeDiffCache) {
+  FakeTreeBuilder builder;
+  builder.setFile("src/foo/a.txt", "a");
+  builder.setFile("src/bar/c.txt", "c");
+  builder.setFile("src/bar/.gitignore", "foo/e.txt");
+  builder.setFile("doc/readme.txt", "docs");
+  builder.finalize(backingStore_, /* setReady */ true);
+  backingStore_->putCommit("1", builder)->setReady();
+
+  auto builder2 = builder.clone();
+  builder2.replaceFile("src/foo/a.txt", "new a");
+  builder2.setFile("src/bar/foo/e.txt", "e");
+  builder2.removeFile("doc/readme.txt");
+  builder2.finalize(backingStore_, /* setReady */ true);
+  backingStore_->putCommit("2", builder2)->setReady();
+
+  auto cache = std::make_shared<TreeDiffCache>(100);
+  auto diff = [&](uint64_t& treeFetches) {
+    auto callback = std::make_unique<ScmStatusDiffCallback>();
+    auto diffContext = makeDiffContext(
+        callback.get(), std::make_unique<TopLevelIgnores>("", ""));
+    diffContext->setTreeDiffCache(cache);
+    diffTrees(
+        diffContext.get(),
+        RelativePathPiece{},
+        builder.getRoot()->get().getHash(),
+        builder2.getRoot()->get().getHash(),
+        nullptr,
+        false)
+        .get(10s);
+    treeFetches = diffContext->getStatsContext().countFetchesOfType(
+        ObjectFetchContext::Tree);
+    return callback->extractStatus();
+  };
+
+  uint64_t firstTreeFetches = 0;
+  auto first = diff(firstTreeFetches);
+  EXPECT_THAT(*first.errors_ref(), UnorderedElementsAre());
+  EXPECT_THAT(
+      *first.entries_ref(),
+      UnorderedElementsAre(
+          Pair("src/foo/a.txt", ScmFileStatus::MODIFIED),
+          Pair("src/bar/foo/e.txt", ScmFileStatus::IGNORED),
+          Pair("doc/readme.txt", ScmFileStatus::REMOVED)));
+  EXPECT_NE(0, firstTreeFetches);
+
+  // The second diff finds every pair of trees that differ in the cache, and
+  // only fetches the trees that exist on one side only: the added src/bar/foo
+  // and the removed doc.
+  uint64_t secondTreeFetches = 0;
+  auto second = diff(secondTreeFetches);
+  EXPECT_THAT(*second.errors_ref(), UnorderedElementsAre());
+  EXPECT_EQ(*first.entries_ref(), *second.entries_ref());
+  EXPECT_EQ(2, secondTreeFetches);
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/FetchHeatmap.h"
+
+#include <fmt/format.h>
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using namespace facebook::eden::path_literals;
+
+namespace {
+std::vector<std::pair<std::string, uint64_t>> counts(
+    const std::vector<FetchHeatmap::Directory>& directories) {
+  std::vector<std::pair<std::string, uint64_t>> result;
+  for (const auto& directory : directories) {
+    result.emplace_back(directory.path.asString(), directory.count);
+  }
+  return result;
+}
+} // namespace
+
+TEST(FetchHeatmapTest, counts_parent_directories) {
+  FetchHeatmap heatmap{100, 10};
+  heatmap.recordFetch("a/b/file1"_relpath);
+  heatmap.recordFetch("a/b/file2"_relpath);
+  heatmap.recordFetch("a/c/file"_relpath);
+  heatmap.recordFetch("top-level-file"_relpath);
+
+  using Counts = std::vector<std::pair<std::string, uint64_t>>;
+  EXPECT_EQ(
+      (Counts{{"a", 3}, {"a/b", 2}, {"a/c", 1}}),
+      counts(heatmap.getTopDirectories(10)));
+  EXPECT_EQ((Counts{{"a", 3}}), counts(heatmap.getTopDirectories(1)));
+}
+
+TEST(FetchHeatmapTest, stops_at_max_depth) {
+  FetchHeatmap heatmap{100, 2};
+  heatmap.recordFetch("a/b/c/d/file"_relpath);
+
+  auto directories = heatmap.getTopDirectories(10);
+  ASSERT_EQ(2, directories.size());
+  EXPECT_EQ("a"_relpath, directories[0].path);
+  EXPECT_EQ("a/b"_relpath, directories[1].path);
+}
+
+TEST(FetchHeatmapTest, keeps_most_fetched_directories_when_full) {
+  FetchHeatmap heatmap{2, 1};
+  for (int i = 0; i < 11; ++i) {
+    heatmap.recordFetch("hot/file"_relpath);
+  }
+  for (int i = 0; i < 10; ++i) {
+    heatmap.recordFetch(RelativePath{fmt::format("cold{}/file", i)});
+  }
+
+  auto directories = heatmap.getTopDirectories(10);
+  ASSERT_EQ(2, directories.size());
+  EXPECT_EQ("hot"_relpath, directories[0].path);
+  EXPECT_EQ(11, directories[0].count);
+  EXPECT_EQ(0, directories[0].error);
+  // The last cold directory took the place of the previous ones, so its
+  // count is overestimated by the fetches of those.
+  EXPECT_EQ("cold9"_relpath, directories[1].path);
+  EXPECT_EQ(10, directories[1].count);
+  EXPECT_EQ(9, directories[1].error);
+}
+
+TEST(FetchHeatmapTest, zero_capacity_disables_counting) {
+  FetchHeatmap heatmap{0, 10};
+  heatmap.recordFetch("a/file"_relpath);
+  EXPECT_TRUE(heatmap.getTopDirectories(10).empty());
+}
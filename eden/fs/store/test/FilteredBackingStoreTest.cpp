@@ -593,4 +593,109 @@ TEST_F(FilteredBackingStoreTest, testCompareTreeObjectsById) {
       filteredStore_->compareObjectsById(grandchildOID, grandchildOID2) ==
       ObjectComparison::Unknown);
 }
+
+TEST_F(FilteredBackingStoreTest, filteredTreesAreCached) {
+  auto [foo, fooId] = wrappedStore_->putBlob("this is foo\n");
+  auto [bar, barId] = wrappedStore_->putBlob("this is bar\n");
+  auto* dir = wrappedStore_->putTree({{"foo", fooId}, {"bar", barId}});
+  dir->setReady();
+  auto dirFOID =
+      FilteredObjectId(RelativePath{"dir"}, kTestFilter1, dir->get().getHash());
+  auto dirOID = ObjectId{dirFOID.getValue()};
+
+  auto tree1 =
+      filteredStore_->getTree(dirOID, ObjectFetchContext::getNullContext())
+          .get(0ms)
+          .tree;
+  auto tree2 =
+      filteredStore_->getTree(dirOID, ObjectFetchContext::getNullContext())
+          .get(0ms)
+          .tree;
+  EXPECT_EQ(1, tree1->size());
+  // The second fetch reuses the tree filtered by the first one.
+  EXPECT_EQ(tree1, tree2);
+
+  // The same tree under another filter is filtered separately.
+  auto otherFOID =
+      FilteredObjectId(RelativePath{"dir"}, kTestFilter5, dir->get().getHash());
+  auto tree3 = filteredStore_
+                   ->getTree(
+                       ObjectId{otherFOID.getValue()},
+                       ObjectFetchContext::getNullContext())
+                   .get(0ms)
+                   .tree;
+  EXPECT_EQ(2, tree3->size());
+}
+
+TEST_F(FilteredBackingStoreTest, recursivelyFilteredTreeIsEmpty) {
+  auto [bar, barId] = wrappedStore_->putBlob("this is bar\n");
+  auto* dir = wrappedStore_->putTree({{"bar", barId}});
+  dir->setReady();
+  // Everything below a directory named after the filter is filtered.
+  auto dirFOID =
+      FilteredObjectId(RelativePath{"foo"}, kTestFilter1, dir->get().getHash());
+
+  auto tree = filteredStore_
+                  ->getTree(
+                      ObjectId{dirFOID.getValue()},
+                      ObjectFetchContext::getNullContext())
+                  .get(0ms)
+                  .tree;
+  EXPECT_EQ(0, tree->size());
+}
+
+/**
+ * Filters nothing, and reports that no path below the given directory is
+ * filtered.
+ */
+class UnfilteredBelowFilter final : public Filter {
+ public:
+  explicit UnfilteredBelowFilter(RelativePath directory)
+      : directory_{std::move(directory)} {}
+
+  bool isPathFiltered(RelativePathPiece /*path*/, folly::StringPiece)
+      override {
+    ++checks;
+    return false;
+  }
+
+  FilterCoverage getCoverageForPath(
+      RelativePathPiece path,
+      folly::StringPiece /*filterId*/) override {
+    return path == directory_.piece() ? FilterCoverage::RecursivelyUnfiltered
+                              : FilterCoverage::Unknown;
+  }
+
+  size_t checks = 0;
+
+ private:
+  RelativePath directory_;
+};
+
+TEST_F(FilteredBackingStoreTest, recursivelyUnfilteredTreeSkipsChecks) {
+  auto filter = std::make_unique<UnfilteredBelowFilter>(RelativePath{"dir"});
+  auto* filterPtr = filter.get();
+  auto store =
+      std::make_shared<FilteredBackingStore>(wrappedStore_, std::move(filter));
+
+  auto [foo, fooId] = wrappedStore_->putBlob("this is foo\n");
+  auto [bar, barId] = wrappedStore_->putBlob("this is bar\n");
+  auto* tree = wrappedStore_->putTree({{"foo", fooId}, {"bar", barId}});
+  tree->setReady();
+
+  auto getTree = [&](RelativePathPiece path) {
+    auto foid = FilteredObjectId(path, kTestFilter1, tree->get().getHash());
+    return store
+        ->getTree(
+            ObjectId{foid.getValue()}, ObjectFetchContext::getNullContext())
+        .get(0ms)
+        .tree;
+  };
+
+  EXPECT_EQ(2, getTree(RelativePathPiece{"dir"})->size());
+  EXPECT_EQ(0, filterPtr->checks);
+
+  EXPECT_EQ(2, getTree(RelativePathPiece{"other"})->size());
+  EXPECT_EQ(2, filterPtr->checks);
+}
 } // namespace
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/KeyAccessTracker.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using namespace folly::string_piece_literals;
+
+TEST(KeyAccessTrackerTest, untracked_keys_report_epoch_zero) {
+  KeyAccessTracker tracker{1, 100};
+  EXPECT_EQ(1, tracker.getEpoch());
+  EXPECT_EQ(0, tracker.getLastAccess(KeySpace::BlobFamily, "key"_sp));
+}
+
+TEST(KeyAccessTrackerTest, records_latest_epoch) {
+  KeyAccessTracker tracker{1, 100};
+  tracker.recordAccess(KeySpace::BlobFamily, "key"_sp);
+  EXPECT_EQ(1, tracker.getLastAccess(KeySpace::BlobFamily, "key"_sp));
+
+  tracker.advanceEpoch();
+  tracker.advanceEpoch();
+  EXPECT_EQ(1, tracker.getLastAccess(KeySpace::BlobFamily, "key"_sp));
+  tracker.recordAccess(KeySpace::BlobFamily, "key"_sp);
+  EXPECT_EQ(3, tracker.getLastAccess(KeySpace::BlobFamily, "key"_sp));
+
+  // Keyspaces are tracked independently.
+  EXPECT_EQ(0, tracker.getLastAccess(KeySpace::TreeFamily, "key"_sp));
+}
+
+TEST(KeyAccessTrackerTest, samples_accesses) {
+  KeyAccessTracker tracker{4, 100};
+  for (int i = 0; i < 4; ++i) {
+    tracker.recordAccess(KeySpace::BlobFamily, "key"_sp);
+  }
+  EXPECT_EQ(1, tracker.getEntryCount(KeySpace::BlobFamily));
+}
+
+TEST(KeyAccessTrackerTest, forgets_oldest_entries_over_limit) {
+  KeyAccessTracker tracker{1, 4};
+  for (char c : std::string{"abcdef"}) {
+    tracker.recordAccess(KeySpace::BlobFamily, folly::StringPiece{&c, 1});
+    tracker.advanceEpoch();
+  }
+  // Keys a..f were read in epochs 1..6. The limit is enforced when the epoch
+  // advances, so the oldest half was dropped once e was tracked.
+  EXPECT_LE(tracker.getEntryCount(KeySpace::BlobFamily), 4);
+  EXPECT_EQ(0, tracker.getLastAccess(KeySpace::BlobFamily, "a"_sp));
+  EXPECT_EQ(6, tracker.getLastAccess(KeySpace::BlobFamily, "f"_sp));
+}
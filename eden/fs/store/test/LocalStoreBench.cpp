@@ -0,0 +1,327 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <fmt/format.h>
+#include <atomic>
+#include <cmath>
+#include <optional>
+#include <random>
+#include <thread>
+
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/model/Hash.h"
+#include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/store/RocksDbLocalStore.h"
+#include "eden/fs/store/SqliteLocalStore.h"
+#include "eden/fs/store/StoreResult.h"
+#include "eden/fs/telemetry/EdenStats.h"
+#include "eden/fs/telemetry/NullStructuredLogger.h"
+#include "eden/fs/testharness/TempFile.h"
+#include "eden/fs/utils/FaultInjector.h"
+
+/*
+ * Runs the same workloads against every LocalStore implementation, so that
+ * their costs can be compared on a given host.
+ *
+ * Every benchmark takes the store and the workload as arguments. A workload
+ * is a key space and the distribution of its value sizes.
+ */
+
+namespace {
+
+using namespace facebook::eden;
+
+// The single connection variant of SQLite serializes reads with each other
+// and with writes, as SqliteLocalStore did before it had read connections.
+enum StoreType { kMemory, kSqlite, kSqliteSingleConnection, kRocksDb };
+constexpr const char* kStoreNames[] = {
+    "memory", "sqlite", "sqlite-single", "rocksdb"};
+
+struct Workload {
+  const char* name;
+  KeySpace keySpace;
+  size_t count;
+  // Value sizes are log-uniformly distributed between the two.
+  size_t minValueSize;
+  size_t maxValueSize;
+};
+
+constexpr Workload kWorkloads[] = {
+    {"blobmeta", KeySpace::BlobMetaDataFamily, 1'000'000, 28, 60},
+    {"tree", KeySpace::TreeFamily, 100'000, 64, 64 * 1024},
+    {"blob", KeySpace::BlobFamily, 8'000, 256, 256 * 1024},
+};
+
+constexpr size_t kKeySize = Hash20::RAW_SIZE;
+constexpr size_t kBatchSize = 64;
+
+/**
+ * A store of the given type, filled with the entries of a workload.
+ */
+class Fixture {
+ public:
+  Fixture(StoreType type, const Workload& workload) : workload_{workload} {
+    auto stats = makeRefPtr<EdenStats>();
+    switch (type) {
+      case kMemory:
+        store_ = std::make_shared<MemoryLocalStore>(std::move(stats));
+        break;
+      case kSqlite:
+        tempDir_ = makeTempDir();
+        store_ = std::make_shared<SqliteLocalStore>(
+            canonicalPath(tempDir_->path().string()) + "sqlite"_pc,
+            std::move(stats));
+        break;
+      case kSqliteSingleConnection: {
+        tempDir_ = makeTempDir();
+        SqliteLocalStore::Options options;
+        options.readConnections = 0;
+        store_ = std::make_shared<SqliteLocalStore>(
+            canonicalPath(tempDir_->path().string()) + "sqlite"_pc,
+            std::move(stats),
+            options);
+        break;
+      }
+      case kRocksDb:
+        tempDir_ = makeTempDir();
+        store_ = std::make_shared<RocksDbLocalStore>(
+            canonicalPath(tempDir_->path().string()),
+            std::move(stats),
+            std::make_shared<NullStructuredLogger>(),
+            &faultInjector_);
+        break;
+    }
+    store_->open();
+
+    std::mt19937_64 rng{0};
+    std::uniform_int_distribution<int> byte{0, 255};
+    values_.resize(workload.maxValueSize);
+    for (auto& c : values_) {
+      c = static_cast<char>(byte(rng));
+    }
+
+    // Twice as many keys as stored entries: the second half are misses, and
+    // fresh keys for puts.
+    keys_.resize(2 * workload.count * kKeySize);
+    for (auto& c : keys_) {
+      c = static_cast<char>(byte(rng));
+    }
+
+    std::uniform_real_distribution<double> logSize{
+        std::log(static_cast<double>(workload.minValueSize)),
+        std::log(static_cast<double>(workload.maxValueSize))};
+    sizes_.reserve(2 * workload.count);
+    for (size_t i = 0; i < 2 * workload.count; ++i) {
+      sizes_.push_back(static_cast<size_t>(std::exp(logSize(rng))));
+    }
+
+    auto batch = store_->beginWrite();
+    for (size_t i = 0; i < workload.count; ++i) {
+      batch->put(workload.keySpace, key(i), value(i));
+    }
+    batch->flush();
+  }
+
+  LocalStore& store() {
+    return *store_;
+  }
+
+  KeySpace keySpace() const {
+    return workload_.keySpace;
+  }
+
+  size_t count() const {
+    return workload_.count;
+  }
+
+  /**
+   * Keys [0, count()) are stored, keys [count(), 2 * count()) are not.
+   */
+  folly::ByteRange key(size_t index) const {
+    return folly::ByteRange{
+        reinterpret_cast<const uint8_t*>(keys_.data()) + index * kKeySize,
+        kKeySize};
+  }
+
+  folly::ByteRange value(size_t index) const {
+    return folly::ByteRange{
+        reinterpret_cast<const uint8_t*>(values_.data()), sizes_[index]};
+  }
+
+ private:
+  Workload workload_;
+  FaultInjector faultInjector_{/*enabled=*/false};
+  std::optional<folly::test::TemporaryDirectory> tempDir_;
+  std::shared_ptr<LocalStore> store_;
+  std::string keys_;
+  std::string values_;
+  std::vector<size_t> sizes_;
+};
+
+std::unique_ptr<Fixture> makeFixture(benchmark::State& state) {
+  auto type = static_cast<StoreType>(state.range(0));
+  const auto& workload = kWorkloads[state.range(1)];
+  state.SetLabel(fmt::format("{}/{}", kStoreNames[type], workload.name));
+  return std::make_unique<Fixture>(type, workload);
+}
+
+void storesAndWorkloads(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"store", "workload"});
+  for (int64_t store : {kMemory, kSqlite, kSqliteSingleConnection, kRocksDb}) {
+    for (size_t workload = 0; workload < std::size(kWorkloads); ++workload) {
+      b->Args({store, static_cast<int64_t>(workload)});
+    }
+  }
+}
+
+void get(benchmark::State& state) {
+  auto fixture = makeFixture(state);
+  std::mt19937_64 rng{1};
+  std::uniform_int_distribution<size_t> index{0, fixture->count() - 1};
+
+  for (auto _ : state) {
+    auto result =
+        fixture->store().get(fixture->keySpace(), fixture->key(index(rng)));
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(get)->Apply(storesAndWorkloads);
+
+void getBatch(benchmark::State& state) {
+  auto fixture = makeFixture(state);
+  std::mt19937_64 rng{1};
+  std::uniform_int_distribution<size_t> index{0, fixture->count() - 1};
+  std::vector<folly::ByteRange> keys(kBatchSize);
+
+  for (auto _ : state) {
+    for (auto& key : keys) {
+      key = fixture->key(index(rng));
+    }
+    auto results = fixture->store().getBatch(fixture->keySpace(), keys).get();
+    benchmark::DoNotOptimize(results);
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+BENCHMARK(getBatch)->Apply(storesAndWorkloads);
+
+/**
+ * Looks up stored and missing keys, in equal proportions.
+ */
+void hasKey(benchmark::State& state) {
+  auto fixture = makeFixture(state);
+  std::mt19937_64 rng{1};
+  std::uniform_int_distribution<size_t> index{0, 2 * fixture->count() - 1};
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        fixture->store().hasKey(fixture->keySpace(), fixture->key(index(rng))));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(hasKey)->Apply(storesAndWorkloads);
+
+/**
+ * Writes keys that aren't stored yet, then overwrites them once every key
+ * has been written.
+ */
+void put(benchmark::State& state) {
+  auto fixture = makeFixture(state);
+  auto count = fixture->count();
+  size_t i = 0;
+
+  for (auto _ : state) {
+    auto index = count + i;
+    fixture->store().put(
+        fixture->keySpace(), fixture->key(index), fixture->value(index));
+    if (++i == count) {
+      i = 0;
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(put)->Apply(storesAndWorkloads);
+
+void writeBatch(benchmark::State& state) {
+  auto fixture = makeFixture(state);
+  auto count = fixture->count();
+  size_t i = 0;
+
+  for (auto _ : state) {
+    auto batch = fixture->store().beginWrite();
+    for (size_t j = 0; j < kBatchSize; ++j) {
+      auto index = count + i;
+      batch->put(
+          fixture->keySpace(), fixture->key(index), fixture->value(index));
+      if (++i == count) {
+        i = 0;
+      }
+    }
+    batch->flush();
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+BENCHMARK(writeBatch)->Apply(storesAndWorkloads);
+
+std::unique_ptr<Fixture> compactionFixture;
+std::atomic<bool> stopCompacting;
+std::thread compactionThread;
+
+/**
+ * Gets from every benchmark thread while another thread keeps overwriting
+ * entries and compacting the key space, as the periodic garbage collection
+ * of a busy EdenFS would.
+ */
+void getDuringCompaction(benchmark::State& state) {
+  if (state.thread_index() == 0) {
+    compactionFixture = makeFixture(state);
+    stopCompacting = false;
+    compactionThread = std::thread{[fixture = compactionFixture.get()] {
+      auto count = fixture->count();
+      size_t i = 0;
+      while (!stopCompacting) {
+        auto batch = fixture->store().beginWrite();
+        for (size_t j = 0; j < count / 10; ++j) {
+          batch->put(fixture->keySpace(), fixture->key(i), fixture->value(i));
+          if (++i == count) {
+            i = 0;
+          }
+        }
+        batch->flush();
+        fixture->store().compactKeySpace(fixture->keySpace());
+      }
+    }};
+  }
+
+  std::mt19937_64 rng{static_cast<uint64_t>(state.thread_index())};
+  for (auto _ : state) {
+    // The fixture is only read once every thread has entered the loop, after
+    // thread 0 created it.
+    auto& fixture = *compactionFixture;
+    std::uniform_int_distribution<size_t> index{0, fixture.count() - 1};
+    auto result =
+        fixture.store().get(fixture.keySpace(), fixture.key(index(rng)));
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  if (state.thread_index() == 0) {
+    stopCompacting = true;
+    compactionThread.join();
+    compactionFixture.reset();
+  }
+}
+BENCHMARK(getDuringCompaction)
+    ->Apply(storesAndWorkloads)
+    ->Threads(1)
+    ->Threads(4)
+    ->Threads(16)
+    ->UseRealTime();
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -5,9 +5,13 @@
  * GNU General Public License version 2.
  */
 
+#include <folly/futures/Future.h>
+
 #include "eden/fs/store/test/LocalStoreTest.h"
+#include "eden/fs/store/BufferedLocalStore.h"
 #include "eden/fs/store/MemoryLocalStore.h"
 #include "eden/fs/store/SqliteLocalStore.h"
+#include "eden/fs/store/TieredLocalStore.h"
 #include "eden/fs/telemetry/EdenStats.h"
 
 namespace {
@@ -30,6 +34,26 @@ LocalStoreImplResult makeSqliteLocalStore(FaultInjector*) {
   return {std::move(tempDir), std::move(store)};
 }
 
+LocalStoreImplResult makeTieredLocalStore(FaultInjector*) {
+  auto tempDir = makeTempDir();
+  auto store = std::make_shared<TieredLocalStore>(
+      canonicalPath(tempDir.path().string()) + "hot-tier"_pc,
+      1024 * 1024,
+      std::make_shared<MemoryLocalStore>(makeRefPtr<EdenStats>()),
+      makeRefPtr<EdenStats>());
+  return {std::move(tempDir), std::move(store)};
+}
+
+LocalStoreImplResult makeBufferedLocalStore(FaultInjector*) {
+  return {
+      std::nullopt,
+      std::make_shared<BufferedLocalStore>(
+          std::make_shared<MemoryLocalStore>(makeRefPtr<EdenStats>()),
+          1024 * 1024,
+          std::chrono::milliseconds{1},
+          makeRefPtr<EdenStats>())};
+}
+
 TEST_P(OpenCloseLocalStoreTest, closeBeforeOpen) {
   auto tempDir = makeTempDir();
   store_->close();
@@ -80,6 +104,29 @@ TEST_P(LocalStoreTest, testReadAndWriteBlob) {
   }
 }
 
+TEST_P(LocalStoreTest, testReadAndWriteBlobByContent) {
+  ObjectId id1 = ObjectId::fromHex("3a8f8eb91101860fd8484154885838bf322964d0");
+  ObjectId id2 = ObjectId::fromHex("b0f1d4e5a5c3e0c2a3a6e0f2a7e3c9d8e1f0a2b3");
+
+  StringPiece contents("vendored\n");
+  auto blob = Blob{folly::IOBuf{folly::IOBuf::COPY_BUFFER, contents}};
+  store_->putBlobByContent(id1, &blob);
+  store_->putBlobByContent(id2, &blob);
+
+  for (const auto& id : {id1, id2}) {
+    auto outBlob = store_->getBlobByContent(id).get(10s);
+    ASSERT_NE(outBlob, nullptr);
+    EXPECT_EQ(contents, outBlob->getContents().to<std::string>());
+  }
+  EXPECT_TRUE(store_->hasKey(
+      KeySpace::BlobContentFamily, Hash32::blake3(contents.str()).getBytes()));
+  EXPECT_EQ(store_->getBlob(id1).get(10s), nullptr);
+
+  ObjectId missing =
+      ObjectId::fromHex("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa");
+  EXPECT_EQ(store_->getBlobByContent(missing).get(10s), nullptr);
+}
+
 TEST_P(LocalStoreTest, testReadAndWriteMetadata) {
   ObjectId id = ObjectId::fromHex("3a8f8eb91101860fd8484154885838bf322964d0");
   auto sha1 = Hash20::sha1("foobar");
@@ -197,6 +244,49 @@ TEST_P(LocalStoreTest, testGetResult) {
   EXPECT_THROW(result2.piece(), std::domain_error);
 }
 
+TEST_P(LocalStoreTest, testGetBatch) {
+  StringPiece key1 = "foo";
+  StringPiece key2 = "bar";
+  StringPiece key3 = "baz";
+
+  store_->put(KeySpace::BlobFamily, key1, "hello"_sp);
+  store_->put(KeySpace::BlobFamily, key3, "world"_sp);
+
+  std::vector<folly::ByteRange> keys{
+      folly::ByteRange{key1}, folly::ByteRange{key2}, folly::ByteRange{key3}};
+  auto results = store_->getBatch(KeySpace::BlobFamily, keys).get(10s);
+  ASSERT_EQ(3, results.size());
+  ASSERT_TRUE(results[0].isValid());
+  EXPECT_EQ("hello", results[0].piece());
+  EXPECT_FALSE(results[1].isValid());
+  ASSERT_TRUE(results[2].isValid());
+  EXPECT_EQ("world", results[2].piece());
+
+  std::vector<ObjectId> ids{
+      ObjectId{folly::ByteRange{key3}}, ObjectId{folly::ByteRange{key1}}};
+  auto idResults = store_
+                       ->getBatch(
+                           KeySpace::BlobFamily,
+                           ObjectIdRange{ids.data(), ids.size()})
+                       .get(10s);
+  ASSERT_EQ(2, idResults.size());
+  EXPECT_EQ("world", idResults[0].piece());
+  EXPECT_EQ("hello", idResults[1].piece());
+}
+
+TEST_P(LocalStoreTest, mayContain_stored_keys) {
+  StringPiece key1 = "foo";
+  StringPiece key2 = "bar";
+
+  store_->put(KeySpace::TreeFamily, key1, "hello"_sp);
+  auto batch = store_->beginWrite();
+  batch->put(KeySpace::BlobMetaDataFamily, key2, "world"_sp);
+  batch->flush();
+
+  EXPECT_TRUE(store_->mayContain(KeySpace::TreeFamily, key1));
+  EXPECT_TRUE(store_->mayContain(KeySpace::BlobMetaDataFamily, key2));
+}
+
 TEST_P(LocalStoreTest, StoreResult_contains_keyspace_name_and_key) {
   auto key = ObjectId{kEmptySha1.getBytes()};
   auto result = store_->get(KeySpace::BlobFamily, key);
@@ -281,6 +371,16 @@ INSTANTIATE_TEST_CASE_P(
     LocalStoreTest,
     ::testing::Values(makeSqliteLocalStore));
 
+INSTANTIATE_TEST_CASE_P(
+    Tiered,
+    LocalStoreTest,
+    ::testing::Values(makeTieredLocalStore));
+
+INSTANTIATE_TEST_CASE_P(
+    Buffered,
+    LocalStoreTest,
+    ::testing::Values(makeBufferedLocalStore));
+
 INSTANTIATE_TEST_CASE_P(
     Memory,
     OpenCloseLocalStoreTest,
@@ -290,6 +390,16 @@ INSTANTIATE_TEST_CASE_P(
     Sqlite,
     OpenCloseLocalStoreTest,
     ::testing::Values(makeSqliteLocalStore));
+
+INSTANTIATE_TEST_CASE_P(
+    Tiered,
+    OpenCloseLocalStoreTest,
+    ::testing::Values(makeTieredLocalStore));
+
+INSTANTIATE_TEST_CASE_P(
+    Buffered,
+    OpenCloseLocalStoreTest,
+    ::testing::Values(makeBufferedLocalStore));
 #pragma clang diagnostic pop
 
 } // namespace
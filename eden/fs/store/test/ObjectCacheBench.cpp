@@ -101,6 +101,60 @@ void longInsertSimple(benchmark::State& st) {
 }
 BENCHMARK(longInsertSimple);
 
+/**
+ * Many threads concurrently looking up and inserting distinct objects from a
+ * single shared cache. The benchmark argument is the number of shards, so
+ * comparing the 1-shard run against the others shows how much the cache lock
+ * contends.
+ */
+void concurrentGetInsertSimple(benchmark::State& st) {
+  constexpr size_t kNumObjects = 100000;
+  static std::shared_ptr<SimpleObjectCache> cache;
+  static std::vector<ObjectId> ids;
+  static std::vector<std::shared_ptr<Object>> objects;
+
+  if (st.thread_index() == 0) {
+    cache = SimpleObjectCache::create(
+        40 * 1024 * 1024, 1, static_cast<size_t>(st.range(0)));
+    ids.clear();
+    objects.clear();
+    ids.reserve(kNumObjects);
+    objects.reserve(kNumObjects);
+    for (size_t i = 0; i < kNumObjects; ++i) {
+      ids.push_back(ObjectId::sha1(fmt::to_string(i)));
+      objects.push_back(std::make_shared<Object>());
+      // Pre-populate half of the objects so the loop mixes hits and misses.
+      if (i % 2 == 0) {
+        cache->insertSimple(ids[i], objects[i]);
+      }
+    }
+  }
+
+  // Spread the threads over the key space so they don't walk in lockstep.
+  size_t i = (kNumObjects / st.threads()) * st.thread_index();
+  for (auto _ : st) {
+    if (!cache->getSimple(ids[i])) {
+      cache->insertSimple(ids[i], objects[i]);
+    }
+    if (++i == kNumObjects) {
+      i = 0;
+    }
+  }
+
+  if (st.thread_index() == 0) {
+    cache.reset();
+  }
+}
+BENCHMARK(concurrentGetInsertSimple)
+    ->Unit(benchmark::kNanosecond)
+    ->Arg(1)
+    ->Arg(16)
+    ->Arg(64)
+    ->Threads(1)
+    ->Threads(8)
+    ->Threads(32)
+    ->Threads(64);
+
 } // namespace
 
 EDEN_BENCHMARK_MAIN();
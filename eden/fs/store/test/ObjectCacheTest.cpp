@@ -6,6 +6,7 @@
  */
 
 #include "eden/fs/store/ObjectCache.h"
+#include <fmt/format.h>
 #include <folly/portability/GTest.h>
 
 using namespace folly::literals;
@@ -219,6 +220,20 @@ TEST(ObjectCache, testReinsert) {
   EXPECT_EQ(object3c, cache->getSimple(object3c->getHash()));
 }
 
+TEST(ObjectCache, testGetAllInRecencyOrder) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(10, 1);
+
+  cache->insertSimple(object3->getHash(), object3);
+  cache->insertSimple(object3a->getHash(), object3a);
+  cache->insertSimple(object3b->getHash(), object3b);
+  cache->getSimple(object3->getHash());
+
+  std::vector<std::shared_ptr<const CacheObject>> expected{
+      object3a, object3b, object3};
+  EXPECT_EQ(expected, cache->getAll());
+}
+
 /**
  * Interest-handle test cases
  */
@@ -553,3 +568,172 @@ TEST(
   handle3.reset();
   EXPECT_TRUE(cache->contains(hash3));
 }
+
+/**
+ * sharded cache test cases
+ */
+
+TEST(ObjectCache, zero_shards_is_treated_as_one) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(10, 1, 0);
+  EXPECT_EQ(1, cache->getShardCount());
+
+  cache->insertSimple(object3->getHash(), object3);
+  EXPECT_EQ(object3, cache->getSimple(object3->getHash()));
+}
+
+TEST(ObjectCache, sharded_cache_finds_all_inserted_objects) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(1000, 0, 8);
+  EXPECT_EQ(8, cache->getShardCount());
+
+  std::vector<std::shared_ptr<CacheObject>> objects;
+  for (size_t i = 0; i < 64; ++i) {
+    auto id = ObjectId::sha1(fmt::to_string(i));
+    objects.push_back(std::make_shared<CacheObject>(id, 1));
+    cache->insertSimple(id, objects.back());
+  }
+
+  for (const auto& object : objects) {
+    EXPECT_TRUE(cache->contains(object->getHash()));
+    EXPECT_EQ(object, cache->getSimple(object->getHash()));
+  }
+
+  auto stats = cache->getStats();
+  EXPECT_EQ(64, stats.objectCount);
+  EXPECT_EQ(64, stats.totalSizeInBytes);
+  EXPECT_EQ(64, stats.hitCount);
+  EXPECT_EQ(0, stats.missCount);
+
+  cache->clear();
+  stats = cache->getStats();
+  EXPECT_EQ(0, stats.objectCount);
+  EXPECT_EQ(0, stats.totalSizeInBytes);
+}
+
+TEST(ObjectCache, sharded_cache_splits_size_budget_between_shards) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(40, 0, 4);
+
+  for (size_t i = 0; i < 1000; ++i) {
+    auto id = ObjectId::sha1(fmt::to_string(i));
+    cache->insertSimple(id, std::make_shared<CacheObject>(id, 1));
+  }
+
+  // Each shard holds at most a quarter of the budget.
+  auto stats = cache->getStats();
+  EXPECT_EQ(40, stats.totalSizeInBytes);
+  EXPECT_EQ(40, stats.objectCount);
+  EXPECT_EQ(960, stats.evictionCount);
+}
+
+TEST(ObjectCache, sharded_interest_handle_drop_evicts_from_its_shard) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::InterestHandle>::create(
+          100, 0, 4);
+  auto handle3 = cache->insertInterestHandle(
+      object3->getHash(),
+      object3,
+      ObjectCache<CacheObject, ObjectCacheFlavor::InterestHandle>::Interest::
+          WantHandle);
+  cache->insertInterestHandle(object4->getHash(), object4);
+  EXPECT_TRUE(cache->contains(hash3));
+
+  handle3.reset();
+  EXPECT_FALSE(cache->contains(hash3));
+  EXPECT_TRUE(cache->contains(hash4));
+  EXPECT_EQ(1, cache->getStats().dropCount);
+}
+
+/**
+ * eviction policy test cases
+ */
+
+TEST(ObjectCache, tinylfu_rejects_one_hit_objects_when_full) {
+  auto cache = ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(
+      6, 0, 1, CacheEvictionPolicy::TinyLfu);
+  EXPECT_EQ(CacheEvictionPolicy::TinyLfu, cache->getEvictionPolicy());
+
+  cache->insertSimple(object3->getHash(), object3);
+  cache->insertSimple(object3a->getHash(), object3a);
+  cache->getSimple(object3->getHash());
+  cache->getSimple(object3->getHash());
+  cache->getSimple(object3a->getHash());
+
+  // object3b has only been looked up once, so it loses against the least
+  // recently used entry.
+  EXPECT_EQ(nullptr, cache->getSimple(object3b->getHash()));
+  cache->insertSimple(object3b->getHash(), object3b);
+
+  EXPECT_TRUE(cache->contains(object3->getHash()));
+  EXPECT_TRUE(cache->contains(object3a->getHash()));
+  EXPECT_FALSE(cache->contains(object3b->getHash()));
+  EXPECT_EQ(1, cache->getStats().admissionRejectCount);
+  EXPECT_EQ(0, cache->getStats().evictionCount);
+}
+
+TEST(ObjectCache, tinylfu_admits_objects_more_popular_than_the_victim) {
+  auto cache = ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(
+      6, 0, 1, CacheEvictionPolicy::TinyLfu);
+
+  cache->insertSimple(object3->getHash(), object3);
+  cache->insertSimple(object3a->getHash(), object3a);
+  cache->getSimple(object3->getHash());
+  cache->getSimple(object3a->getHash());
+
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(nullptr, cache->getSimple(object3b->getHash()));
+  }
+  cache->insertSimple(object3b->getHash(), object3b);
+
+  EXPECT_FALSE(cache->contains(object3->getHash()));
+  EXPECT_TRUE(cache->contains(object3a->getHash()));
+  EXPECT_TRUE(cache->contains(object3b->getHash()));
+  EXPECT_EQ(0, cache->getStats().admissionRejectCount);
+  EXPECT_EQ(1, cache->getStats().evictionCount);
+}
+
+TEST(ObjectCache, tinylfu_always_admits_when_minimum_entry_count_not_reached) {
+  auto cache = ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(
+      1, 3, 1, CacheEvictionPolicy::TinyLfu);
+
+  cache->insertSimple(object3->getHash(), object3);
+  cache->insertSimple(object3a->getHash(), object3a);
+  cache->insertSimple(object3b->getHash(), object3b);
+
+  EXPECT_EQ(3, cache->getStats().objectCount);
+  EXPECT_EQ(0, cache->getStats().admissionRejectCount);
+}
+
+TEST(ObjectCache, tinylfu_rejected_interest_handle_insert_is_harmless) {
+  using Cache = ObjectCache<CacheObject, ObjectCacheFlavor::InterestHandle>;
+  auto cache = Cache::create(3, 0, 1, CacheEvictionPolicy::TinyLfu);
+
+  cache->insertInterestHandle(object3->getHash(), object3);
+  cache->getInterestHandle(object3->getHash());
+
+  auto handle = cache->insertInterestHandle(
+      object3a->getHash(), object3a, Cache::Interest::WantHandle);
+  EXPECT_FALSE(cache->contains(object3a->getHash()));
+  EXPECT_EQ(object3a, handle.getObject());
+
+  handle.reset();
+  EXPECT_TRUE(cache->contains(object3->getHash()));
+  EXPECT_EQ(0, cache->getStats().dropCount);
+}
+
+TEST(ObjectCache, stats_report_policy_and_hit_ratio) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(10, 1);
+  EXPECT_EQ(0.0, cache->getStats().hitRatio());
+
+  cache->insertSimple(object3->getHash(), object3);
+  cache->getSimple(object3->getHash());
+  cache->getSimple(object3->getHash());
+  cache->getSimple(object3->getHash());
+  cache->getSimple(object4->getHash());
+
+  auto stats = cache->getStats();
+  EXPECT_EQ(CacheEvictionPolicy::Lru, stats.policy);
+  EXPECT_DOUBLE_EQ(0.75, stats.hitRatio());
+}
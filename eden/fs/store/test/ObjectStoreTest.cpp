@@ -148,6 +148,19 @@ TEST_F(ObjectStoreTest, getBlob_tracks_second_read_from_cache) {
   EXPECT_EQ(ObjectFetchContext::FromDiskCache, request.origin);
 }
 
+TEST_F(ObjectStoreTest, prefetchBlobs_skips_blobs_in_local_store) {
+  auto otherBlobId = putReadyBlob("otherblob");
+  // Reading the blob caches it in the LocalStore.
+  objectStore->getBlob(readyBlobId, context).get(0ms);
+
+  std::vector<ObjectId> ids{readyBlobId, otherBlobId};
+  objectStore->prefetchBlobs(ObjectIdRange{ids.data(), ids.size()}, context)
+      .get(0ms);
+  EXPECT_EQ(
+      std::vector<ObjectId>{otherBlobId},
+      fakeBackingStore->getPrefetchedBlobs());
+}
+
 TEST_F(ObjectStoreTest, getTree_tracks_backing_store_read) {
   objectStore->getTree(readyTreeId, context).get(0ms);
   ASSERT_EQ(1, loggingContext->requests.size());
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/StoreResult.h"
+
+#include <folly/io/IOBuf.h>
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using namespace folly::string_piece_literals;
+
+namespace {
+
+StoreResult makePinned(std::unique_ptr<std::string>& owner) {
+  auto bytes = folly::ByteRange{folly::StringPiece{*owner}};
+  return StoreResult::pinned(std::move(owner), bytes);
+}
+
+} // namespace
+
+TEST(StoreResultTest, pinned_result_does_not_copy) {
+  auto owner = std::make_unique<std::string>("hello world");
+  auto* expectedData = owner->data();
+  auto result = makePinned(owner);
+
+  ASSERT_TRUE(result.isValid());
+  EXPECT_TRUE(result.isPinned());
+  EXPECT_EQ("hello world"_sp, result.piece());
+  EXPECT_EQ(
+      reinterpret_cast<const uint8_t*>(expectedData), result.bytes().data());
+
+  auto wrapper = result.iobufWrapper();
+  EXPECT_EQ(result.bytes().data(), wrapper.data());
+}
+
+TEST(StoreResultTest, pinned_result_survives_moves) {
+  auto owner = std::make_unique<std::string>("hello world");
+  auto* expectedData = owner->data();
+  auto result = makePinned(owner);
+
+  StoreResult moved{std::move(result)};
+  EXPECT_TRUE(moved.isPinned());
+  EXPECT_EQ(
+      reinterpret_cast<const uint8_t*>(expectedData), moved.bytes().data());
+
+  auto other = StoreResult{"other"};
+  other = std::move(moved);
+  EXPECT_TRUE(other.isPinned());
+  EXPECT_EQ("hello world"_sp, other.piece());
+}
+
+TEST(StoreResultTest, asString_unpins) {
+  auto owner = std::make_unique<std::string>("hello world");
+  auto result = makePinned(owner);
+
+  EXPECT_EQ("hello world", result.asString());
+  EXPECT_FALSE(result.isPinned());
+  EXPECT_EQ("hello world"_sp, result.piece());
+}
+
+TEST(StoreResultTest, extractIOBuf_copies_pinned_data) {
+  auto owner = std::make_unique<std::string>("hello world");
+  auto* expectedData = owner->data();
+  auto result = makePinned(owner);
+
+  auto buf = result.extractIOBuf();
+  EXPECT_NE(reinterpret_cast<const uint8_t*>(expectedData), buf.data());
+  EXPECT_EQ("hello world"_sp, folly::StringPiece{buf.coalesce()});
+}
+
+TEST(StoreResultTest, extractValue_copies_pinned_data) {
+  auto owner = std::make_unique<std::string>("hello world");
+  auto result = makePinned(owner);
+
+  EXPECT_EQ("hello world", result.extractValue());
+  EXPECT_FALSE(result.isValid());
+}
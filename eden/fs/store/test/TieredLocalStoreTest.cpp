@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/TieredLocalStore.h"
+
+#include <fmt/format.h>
+#include <folly/FileUtil.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/store/StoreResult.h"
+#include "eden/fs/telemetry/EdenStats.h"
+#include "eden/fs/testharness/TempFile.h"
+
+using namespace facebook::eden;
+using namespace folly::string_piece_literals;
+
+namespace {
+
+constexpr size_t kSegmentSize = 64 * 1024;
+
+class TieredLocalStoreTest : public ::testing::Test {
+ protected:
+  std::shared_ptr<TieredLocalStore> makeStore(
+      std::shared_ptr<LocalStore> backing,
+      size_t segmentSize = kSegmentSize) {
+    auto store = std::make_shared<TieredLocalStore>(
+        segmentPath_, segmentSize, std::move(backing), makeRefPtr<EdenStats>());
+    store->open();
+    return store;
+  }
+
+  std::shared_ptr<LocalStore> makeBacking() {
+    return std::make_shared<MemoryLocalStore>(makeRefPtr<EdenStats>());
+  }
+
+  folly::test::TemporaryDirectory tempDir_ = makeTempDir();
+  AbsolutePath segmentPath_ =
+      canonicalPath(tempDir_.path().string()) + "segment"_pc;
+};
+
+} // namespace
+
+TEST_F(TieredLocalStoreTest, reads_populate_hot_tier) {
+  auto backing = makeBacking();
+  auto store = makeStore(backing);
+
+  store->put(KeySpace::TreeFamily, "tree"_sp, "tree data"_sp);
+  store->put(KeySpace::BlobFamily, "blob"_sp, "blob data"_sp);
+  EXPECT_EQ(0, store->getHotEntryCount());
+
+  EXPECT_EQ("tree data", store->get(KeySpace::TreeFamily, "tree"_sp).piece());
+  EXPECT_EQ("blob data", store->get(KeySpace::BlobFamily, "blob"_sp).piece());
+  // Only the tree is hot.
+  EXPECT_EQ(1, store->getHotEntryCount());
+
+  // Once hot, reads no longer reach the backing store.
+  backing->clearKeySpace(KeySpace::TreeFamily);
+  EXPECT_EQ("tree data", store->get(KeySpace::TreeFamily, "tree"_sp).piece());
+}
+
+TEST_F(TieredLocalStoreTest, restart_warms_from_segment) {
+  {
+    auto store = makeStore(makeBacking());
+    store->put(KeySpace::TreeFamily, "tree"_sp, "tree data"_sp);
+    store->put(KeySpace::BlobMetaDataFamily, "meta"_sp, "metadata"_sp);
+    store->get(KeySpace::TreeFamily, "tree"_sp);
+    store->get(KeySpace::BlobMetaDataFamily, "meta"_sp);
+    store->close();
+  }
+
+  // The new backing store is empty: everything comes from the segment.
+  auto store = makeStore(makeBacking());
+  EXPECT_EQ(2, store->getHotEntryCount());
+  EXPECT_EQ("tree data", store->get(KeySpace::TreeFamily, "tree"_sp).piece());
+  EXPECT_EQ(
+      "metadata", store->get(KeySpace::BlobMetaDataFamily, "meta"_sp).piece());
+  EXPECT_TRUE(store->hasKey(KeySpace::TreeFamily, "tree"_sp));
+  EXPECT_FALSE(store->get(KeySpace::TreeFamily, "other"_sp).isValid());
+}
+
+TEST_F(TieredLocalStoreTest, batch_reads_mix_hot_and_cold_entries) {
+  auto backing = makeBacking();
+  auto store = makeStore(backing);
+  store->put(KeySpace::TreeFamily, "a"_sp, "A"_sp);
+  store->put(KeySpace::TreeFamily, "b"_sp, "B"_sp);
+  store->get(KeySpace::TreeFamily, "a"_sp);
+
+  std::vector<folly::ByteRange> keys{
+      folly::ByteRange{"b"_sp},
+      folly::ByteRange{"missing"_sp},
+      folly::ByteRange{"a"_sp}};
+  auto results = store->getBatch(KeySpace::TreeFamily, keys).get();
+  ASSERT_EQ(3, results.size());
+  EXPECT_EQ("B", results[0].piece());
+  EXPECT_FALSE(results[1].isValid());
+  EXPECT_EQ("A", results[2].piece());
+  EXPECT_EQ(2, store->getHotEntryCount());
+}
+
+TEST_F(TieredLocalStoreTest, full_segment_starts_over) {
+  auto store = makeStore(makeBacking(), 1024);
+  std::string value(100, 'x');
+  for (int i = 0; i < 20; ++i) {
+    auto key = fmt::format("key{}", i);
+    store->put(
+        KeySpace::TreeFamily,
+        folly::StringPiece{key},
+        folly::StringPiece{value});
+    store->get(KeySpace::TreeFamily, folly::StringPiece{key});
+  }
+  EXPECT_LT(store->getHotEntryCount(), 20);
+  EXPECT_GT(store->getHotEntryCount(), 0);
+  EXPECT_EQ(value, store->get(KeySpace::TreeFamily, "key19"_sp).piece());
+}
+
+TEST_F(TieredLocalStoreTest, corrupted_segment_is_ignored) {
+  {
+    auto store = makeStore(makeBacking());
+    store->put(KeySpace::TreeFamily, "a"_sp, "first value"_sp);
+    store->put(KeySpace::TreeFamily, "b"_sp, "second value"_sp);
+    store->get(KeySpace::TreeFamily, "a"_sp);
+    store->get(KeySpace::TreeFamily, "b"_sp);
+    store->close();
+  }
+
+  // Corrupt the value of the second record: the first one survives.
+  std::string contents;
+  ASSERT_TRUE(folly::readFile(segmentPath_.c_str(), contents));
+  auto pos = contents.find("second value");
+  ASSERT_NE(std::string::npos, pos);
+  contents[pos] = 'S';
+  ASSERT_TRUE(folly::writeFile(contents, segmentPath_.c_str()));
+
+  auto store = makeStore(makeBacking());
+  EXPECT_EQ(1, store->getHotEntryCount());
+  EXPECT_EQ("first value", store->get(KeySpace::TreeFamily, "a"_sp).piece());
+  EXPECT_FALSE(store->get(KeySpace::TreeFamily, "b"_sp).isValid());
+}
+
+TEST_F(TieredLocalStoreTest, clearing_hot_keyspace_drops_segment) {
+  auto store = makeStore(makeBacking());
+  store->put(KeySpace::TreeFamily, "a"_sp, "A"_sp);
+  store->get(KeySpace::TreeFamily, "a"_sp);
+  EXPECT_EQ(1, store->getHotEntryCount());
+
+  store->clearKeySpace(KeySpace::TreeFamily);
+  EXPECT_EQ(0, store->getHotEntryCount());
+  EXPECT_FALSE(store->get(KeySpace::TreeFamily, "a"_sp).isValid());
+}
@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/takeover/InodeMapPacking.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include <folly/Varint.h>
+#include <folly/container/F14Map.h>
+
+#include "eden/fs/utils/Throw.h"
+
+namespace facebook::eden {
+
+namespace {
+
+/*
+ * Layout, where every number is a varint:
+ *
+ * <version byte><entry count><name count><names: length, bytes>
+ * <inode number deltas, zigzag><parent - inode number, zigzag>
+ * <name indices><flag bytes><numFsReferences, zigzag><modes>
+ * <hashes: length, bytes, for the entries flagged with one>
+ */
+constexpr uint8_t kFormatVersion = 1;
+
+enum EntryFlag : uint8_t {
+  kUnlinked = 1 << 0,
+  kHasHash = 1 << 1,
+};
+
+void appendVarint(std::string& out, uint64_t value) {
+  uint8_t buf[folly::kMaxVarintLength64];
+  auto length = folly::encodeVarint(value, buf);
+  out.append(reinterpret_cast<const char*>(buf), length);
+}
+
+void appendBytes(std::string& out, folly::StringPiece bytes) {
+  appendVarint(out, bytes.size());
+  out.append(bytes.data(), bytes.size());
+}
+
+class Reader {
+ public:
+  explicit Reader(folly::ByteRange data) : data_{data} {}
+
+  uint64_t varint() {
+    auto value = folly::tryDecodeVarint(data_);
+    if (!value) {
+      throwf<std::runtime_error>(
+          "malformed varint in packed inode map, {} bytes left",
+          data_.size());
+    }
+    return *value;
+  }
+
+  uint8_t byte() {
+    need(1);
+    auto value = data_.front();
+    data_.advance(1);
+    return value;
+  }
+
+  folly::StringPiece bytes() {
+    auto size = varint();
+    need(size);
+    folly::StringPiece value{
+        reinterpret_cast<const char*>(data_.data()), size};
+    data_.advance(size);
+    return value;
+  }
+
+  /**
+   * Every column has at least one byte per entry, which bounds the number of
+   * entries before anything is allocated for them.
+   */
+  void needPerEntry(uint64_t count) {
+    need(count);
+  }
+
+  bool empty() const {
+    return data_.empty();
+  }
+
+ private:
+  void need(uint64_t size) {
+    if (size > data_.size()) {
+      throwf<std::runtime_error>(
+          "truncated packed inode map: need {} bytes, {} left",
+          size,
+          data_.size());
+    }
+  }
+
+  folly::ByteRange data_;
+};
+
+} // namespace
+
+std::string packInodeMap(const SerializedInodeMap& inodeMap) {
+  const auto& entries = *inodeMap.unloadedInodes_ref();
+
+  // Sorted, the gaps between inode numbers mostly fit in a byte.
+  std::vector<const SerializedInodeMapEntry*> sorted;
+  sorted.reserve(entries.size());
+  for (const auto& entry : entries) {
+    sorted.push_back(&entry);
+  }
+  std::sort(sorted.begin(), sorted.end(), [](auto* a, auto* b) {
+    return *a->inodeNumber_ref() < *b->inodeNumber_ref();
+  });
+
+  folly::F14FastMap<folly::StringPiece, uint64_t> nameIndices;
+  std::vector<folly::StringPiece> names;
+  std::vector<uint64_t> entryNames;
+  entryNames.reserve(sorted.size());
+  for (auto* entry : sorted) {
+    auto [it, inserted] =
+        nameIndices.try_emplace(*entry->name_ref(), names.size());
+    if (inserted) {
+      names.push_back(it->first);
+    }
+    entryNames.push_back(it->second);
+  }
+
+  std::string out;
+  // A rough guess: a few bytes per column, plus a 20-byte hash.
+  out.reserve(sorted.size() * 32);
+  out.push_back(kFormatVersion);
+  appendVarint(out, sorted.size());
+  appendVarint(out, names.size());
+  for (auto name : names) {
+    appendBytes(out, name);
+  }
+
+  int64_t previous = 0;
+  for (auto* entry : sorted) {
+    appendVarint(
+        out, folly::encodeZigZag(*entry->inodeNumber_ref() - previous));
+    previous = *entry->inodeNumber_ref();
+  }
+  for (auto* entry : sorted) {
+    appendVarint(
+        out,
+        folly::encodeZigZag(
+            *entry->parentInode_ref() - *entry->inodeNumber_ref()));
+  }
+  for (auto index : entryNames) {
+    appendVarint(out, index);
+  }
+  for (auto* entry : sorted) {
+    uint8_t flags = 0;
+    if (*entry->isUnlinked_ref()) {
+      flags |= kUnlinked;
+    }
+    if (entry->hash_ref().has_value()) {
+      flags |= kHasHash;
+    }
+    out.push_back(static_cast<char>(flags));
+  }
+  for (auto* entry : sorted) {
+    appendVarint(out, folly::encodeZigZag(*entry->numFsReferences_ref()));
+  }
+  for (auto* entry : sorted) {
+    appendVarint(out, static_cast<uint32_t>(*entry->mode_ref()));
+  }
+  for (auto* entry : sorted) {
+    if (entry->hash_ref().has_value()) {
+      appendBytes(out, *entry->hash_ref());
+    }
+  }
+  return out;
+}
+
+SerializedInodeMap unpackInodeMap(folly::ByteRange packed) {
+  Reader reader{packed};
+  auto version = reader.byte();
+  if (version != kFormatVersion) {
+    throwf<std::runtime_error>(
+        "unsupported packed inode map version {}", version);
+  }
+
+  auto count = reader.varint();
+  auto nameCount = reader.varint();
+  reader.needPerEntry(nameCount);
+  std::vector<folly::StringPiece> names;
+  names.reserve(nameCount);
+  for (uint64_t i = 0; i < nameCount; ++i) {
+    names.push_back(reader.bytes());
+  }
+
+  reader.needPerEntry(count);
+  SerializedInodeMap result;
+  auto& entries = *result.unloadedInodes_ref();
+  entries.resize(count);
+
+  int64_t previous = 0;
+  for (auto& entry : entries) {
+    previous += folly::decodeZigZag(reader.varint());
+    entry.inodeNumber_ref() = previous;
+  }
+  for (auto& entry : entries) {
+    entry.parentInode_ref() =
+        *entry.inodeNumber_ref() + folly::decodeZigZag(reader.varint());
+  }
+  for (auto& entry : entries) {
+    auto index = reader.varint();
+    if (index >= names.size()) {
+      throwf<std::runtime_error>(
+          "packed inode map refers to name {} of {}", index, names.size());
+    }
+    entry.name_ref() = names[index].str();
+  }
+  std::vector<uint8_t> flags(count);
+  for (uint64_t i = 0; i < count; ++i) {
+    flags[i] = reader.byte();
+    entries[i].isUnlinked_ref() = (flags[i] & kUnlinked) != 0;
+  }
+  for (auto& entry : entries) {
+    entry.numFsReferences_ref() = folly::decodeZigZag(reader.varint());
+  }
+  for (auto& entry : entries) {
+    entry.mode_ref() = static_cast<int32_t>(reader.varint());
+  }
+  for (uint64_t i = 0; i < count; ++i) {
+    if (flags[i] & kHasHash) {
+      entries[i].hash_ref() = reader.bytes().str();
+    }
+  }
+
+  if (!reader.empty()) {
+    throw std::runtime_error("trailing bytes after packed inode map");
+  }
+  return result;
+}
+
+} // namespace facebook::eden
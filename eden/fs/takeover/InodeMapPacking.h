@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <string>
+
+#include <folly/Range.h>
+
+#include "eden/fs/takeover/gen-cpp2/takeover_types.h"
+
+namespace facebook::eden {
+
+/**
+ * Encodes the unloaded inodes of a SerializedInodeMap column by column, for
+ * sending a mount's InodeMap to the new process during graceful restart.
+ *
+ * Entries are sorted by inode number, which is then stored as the varint
+ * delta from the previous entry's, and parent inode numbers as the delta
+ * from the entry's own. Each distinct name is stored once and referred to by
+ * its index, since the same names recur in many directories. The result is
+ * smaller, and cheaper to produce and parse, than the equivalent thrift list
+ * of SerializedInodeMapEntry structs.
+ */
+std::string packInodeMap(const SerializedInodeMap& inodeMap);
+
+/**
+ * Decodes the output of packInodeMap(). The entries come back sorted by inode
+ * number. Throws std::runtime_error if the data is truncated or malformed.
+ */
+SerializedInodeMap unpackInodeMap(folly::ByteRange packed);
+
+} // namespace facebook::eden
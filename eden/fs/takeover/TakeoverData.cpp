@@ -18,6 +18,8 @@
 
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/takeover/InodeMapPacking.h"
 #include "eden/fs/utils/Bug.h"
 #include "eden/fs/utils/Throw.h"
 #include "eden/fs/utils/UnixSocket.h"
@@ -46,6 +48,37 @@ TakeoverMountProtocol getTakeoverMountProtocol(
       mountInfo.mountPath);
 }
 
+std::vector<SerializedTree> serializeTreeCache(
+    const std::vector<std::shared_ptr<const Tree>>& trees) {
+  std::vector<SerializedTree> serialized;
+  serialized.reserve(trees.size());
+  for (const auto& tree : trees) {
+    SerializedTree serializedTree;
+    serializedTree.id_ref() =
+        folly::StringPiece{tree->getHash().getBytes()}.str();
+    serializedTree.data_ref() =
+        tree->serialize().moveToFbString().toStdString();
+    serialized.push_back(std::move(serializedTree));
+  }
+  return serialized;
+}
+
+std::vector<std::shared_ptr<const Tree>> deserializeTreeCache(
+    const std::vector<SerializedTree>& serialized) {
+  std::vector<std::shared_ptr<const Tree>> trees;
+  trees.reserve(serialized.size());
+  for (const auto& serializedTree : serialized) {
+    // A tree in a format this build can't read is simply not cached.
+    if (auto tree = Tree::tryDeserialize(
+            ObjectId{folly::ByteRange{folly::StringPiece{
+                *serializedTree.id_ref()}}},
+            *serializedTree.data_ref())) {
+      trees.push_back(std::move(tree));
+    }
+  }
+  return trees;
+}
+
 } // namespace
 #endif
 
@@ -79,7 +112,8 @@ const uint64_t kSupportedCapabilities = TakeoverCapabilities::FUSE |
     TakeoverCapabilities::RESULT_TYPE_SERIALIZATION |
     TakeoverCapabilities::ORDERED_FDS | TakeoverCapabilities::OPTIONAL_MOUNTD |
     TakeoverCapabilities::CAPABILITY_MATCHING |
-    TakeoverCapabilities::INCLUDE_HEADER_SIZE;
+    TakeoverCapabilities::INCLUDE_HEADER_SIZE |
+    TakeoverCapabilities::TREE_CACHE | TakeoverCapabilities::PACKED_INODE_MAP;
 
 std::optional<int32_t> TakeoverData::computeCompatibleVersion(
     const std::set<int32_t>& versions,
@@ -167,6 +201,13 @@ int32_t TakeoverData::capabilitiesToVersion(uint64_t capabilities) {
   if (capabilities == 0) {
     return kTakeoverProtocolVersionNeverSupported;
   }
+  if (capabilities & TakeoverCapabilities::CAPABILITY_MATCHING) {
+    // Capabilities added after version seven don't have versions of their
+    // own: they are only ever negotiated through capability matching.
+    capabilities &= ~uint64_t{
+        TakeoverCapabilities::TREE_CACHE |
+        TakeoverCapabilities::PACKED_INODE_MAP};
+  }
   if (capabilities ==
       (TakeoverCapabilities::CUSTOM_SERIALIZATION |
        TakeoverCapabilities::FUSE)) {
@@ -557,7 +598,11 @@ IOBuf TakeoverData::serializeThrift(uint64_t protocolCapabilities) {
           sizeof(fuseChannelInfo->connInfo)};
     }
 
-    serializedMount.inodeMap_ref() = mount.inodeMap;
+    if (protocolCapabilities & TakeoverCapabilities::PACKED_INODE_MAP) {
+      serializedMount.packedInodeMap_ref() = packInodeMap(mount.inodeMap);
+    } else {
+      serializedMount.inodeMap_ref() = mount.inodeMap;
+    }
 
     serializedMount.mountProtocol_ref() = mountProtocol;
 
@@ -573,8 +618,11 @@ IOBuf TakeoverData::serializeThrift(uint64_t protocolCapabilities) {
     if (protocolCapabilities & TakeoverCapabilities::ORDERED_FDS) {
       serialized.fileDescriptors_ref() = generalFDOrder;
     }
+    if (protocolCapabilities & TakeoverCapabilities::TREE_CACHE) {
+      serialized.treeCache_ref() = serializeTreeCache(treeCache);
+    }
     SerializedTakeoverResult result;
-    result.takeoverData_ref() = serialized;
+    result.takeoverData_ref() = std::move(serialized);
 
     CompactSerializer::serialize(result, &bufQ);
   } else {
@@ -635,6 +683,10 @@ TakeoverData TakeoverData::deserializeThrift(
           takeoverData.generalFDOrder =
               *(serialized.takeoverData_ref()->fileDescriptors_ref());
         }
+        if (protocolCapabilities & TakeoverCapabilities::TREE_CACHE) {
+          takeoverData.treeCache = deserializeTreeCache(
+              *serialized.takeoverData_ref()->treeCache_ref());
+        }
         return takeoverData;
       }
       case SerializedTakeoverResult::Type::__EMPTY__:
@@ -669,6 +721,11 @@ TakeoverData TakeoverData::deserializeThriftMounts(
     std::vector<SerializedMountInfo>& serializedMounts) {
   TakeoverData data;
   for (auto& serializedMount : serializedMounts) {
+    if (protocolCapabilities & TakeoverCapabilities::PACKED_INODE_MAP) {
+      serializedMount.inodeMap_ref() = unpackInodeMap(folly::ByteRange{
+          folly::StringPiece{*serializedMount.packedInodeMap_ref()}});
+      serializedMount.packedInodeMap_ref()->clear();
+    }
     switch (*serializedMount.mountProtocol_ref()) {
       case TakeoverMountProtocol::UNKNOWN:
         if (protocolCapabilities & TakeoverCapabilities::MOUNT_TYPES) {
@@ -29,6 +29,8 @@ class exception_wrapper;
 
 namespace facebook::eden {
 
+class Tree;
+
 // Holds the versions supported by this build.
 // TODO(T104382350): The code is being migrated to use capability bits instead
 // of version numbers as the former makes it less error prone to check for
@@ -110,6 +112,16 @@ class TakeoverCapabilities {
     // Indicates that we include the size of the header in the header itself.
     // This will allow us to more safely evolve the header in the future.
     INCLUDE_HEADER_SIZE = 1 << 10,
+
+    // Indicates that the contents of the in-memory TreeCache are sent along
+    // with the mount points, so that the new process starts with a warm
+    // cache. Versions after seven are only negotiated through capability
+    // matching, so this is still advertised as version seven.
+    TREE_CACHE = 1 << 11,
+
+    // Indicates that each mount's SerializedInodeMap is sent in the compact
+    // columnar format of packInodeMap() rather than as a thrift list.
+    PACKED_INODE_MAP = 1 << 12,
   };
 };
 
@@ -349,6 +361,13 @@ class TakeoverData {
    */
   std::vector<MountInfo> mountPoints;
 
+  /**
+   * The trees held by the old process's TreeCache, least recently used first
+   * so that inserting them in order preserves their recency. Empty unless
+   * both processes support TakeoverCapabilities::TREE_CACHE.
+   */
+  std::vector<std::shared_ptr<const Tree>> treeCache;
+
   /**
    * The takeoverComplete promise will be fulfilled by the TakeoverServer code
    * once the TakeoverData has been sent to the remote process.
@@ -20,6 +20,7 @@
 #include <folly/io/async/EventBase.h>
 #include <folly/io/async/EventHandler.h>
 #include <folly/logging/xlog.h>
+#include <folly/stop_watch.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 
 #include "eden/fs/takeover/TakeoverData.h"
@@ -96,6 +97,9 @@ class TakeoverServer::ConnHandler {
     int32_t protocolVersion =
         TakeoverData::kTakeoverProtocolVersionNeverSupported;
     uint64_t protocolCapabilities = 0;
+    // Started when the mounts stop serving requests for the takeover, which
+    // they never resume if it succeeds.
+    folly::stop_watch<std::chrono::milliseconds> freezeTimer;
   };
 
   TakeoverServer* const server_;
@@ -180,6 +184,7 @@ Future<Unit> TakeoverServer::ConnHandler::start() noexcept {
 
         state.shouldPing =
             (state.protocolCapabilities & TakeoverCapabilities::PING);
+        state.freezeTimer.reset();
         return server_->getTakeoverHandler()->startTakeoverShutdown();
       })
       .via(server_->eventBase_)
@@ -187,6 +192,8 @@ Future<Unit> TakeoverServer::ConnHandler::start() noexcept {
         if (!data.hasValue()) {
           return sendError(data.exception());
         }
+        XLOG(INFO) << "Stopped mounts for takeover in "
+                   << state_.get().freezeTimer.elapsed().count() << "ms";
         if (state_.get().shouldPing) {
           XLOG(DBG7) << "sending ready ping to takeover client";
           return pingThenSendTakeoverData(std::move(data.value()));
@@ -265,6 +272,7 @@ Future<Unit> TakeoverServer::ConnHandler::sendTakeoverData(
 
   auto& state = state_.get();
 
+  auto serializeStart = state.freezeTimer.elapsed();
   UnixSocket::Message msg;
   try {
     data.serialize(state.protocolCapabilities, msg);
@@ -279,14 +287,18 @@ Future<Unit> TakeoverServer::ConnHandler::sendTakeoverData(
   }
 
   XLOG(INFO) << "Sending takeover data to new process: "
-             << msg.data.computeChainDataLength() << " bytes";
+             << msg.data.computeChainDataLength() << " bytes, serialized in "
+             << (state.freezeTimer.elapsed() - serializeStart).count() << "ms";
 
   return state.socket.send(std::move(msg))
-      .thenTry([promise = std::move(data.takeoverComplete)](
+      .thenTry([promise = std::move(data.takeoverComplete),
+                freezeTimer = state.freezeTimer](
                    folly::Try<Unit>&& sendResult) mutable {
         if (sendResult.hasException()) {
           promise.setException(sendResult.exception());
         } else {
+          XLOG(INFO) << "Sent takeover data; mounts were frozen for "
+                     << freezeTimer.elapsed().count() << "ms in total";
           // Set an uninitalized optional here to avoid an attempted recovery
           promise.setValue(std::nullopt);
         }
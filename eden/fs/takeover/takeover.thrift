@@ -69,6 +69,10 @@ struct SerializedMountInfo {
   6: SerializedInodeMap inodeMap;
 
   7: TakeoverMountProtocol mountProtocol = TakeoverMountProtocol.UNKNOWN;
+
+  // With the PACKED_INODE_MAP capability, inodeMap is left empty and sent in
+  // the format of packInodeMap() instead.
+  8: binary packedInodeMap;
 }
 
 // TODO(T110300475): remove after SerializedTakeoverResult becomes stable. Should be
@@ -88,9 +92,17 @@ enum FileDescriptorType {
   MOUNTD_SOCKET = 2,
 }
 
+// A tree from the in-memory TreeCache, in the format of Tree::serialize().
+struct SerializedTree {
+  1: binary id;
+  2: binary data;
+}
+
 struct SerializedTakeoverInfo {
   1: list<SerializedMountInfo> mounts;
   2: list<FileDescriptorType> fileDescriptors;
+  // Only sent with the TREE_CACHE capability.
+  3: list<SerializedTree> treeCache;
 }
 
 // This is the highlevel structure we use to send takeover data between the
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/takeover/InodeMapPacking.h"
+
+#include <algorithm>
+
+#include <fmt/format.h>
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+
+namespace {
+
+SerializedInodeMapEntry makeEntry(
+    int64_t inodeNumber,
+    int64_t parentInode,
+    std::string name,
+    std::optional<std::string> hash) {
+  SerializedInodeMapEntry entry;
+  entry.inodeNumber_ref() = inodeNumber;
+  entry.parentInode_ref() = parentInode;
+  entry.name_ref() = std::move(name);
+  entry.isUnlinked_ref() = inodeNumber % 3 == 0;
+  entry.numFsReferences_ref() = inodeNumber % 4;
+  if (hash) {
+    entry.hash_ref() = std::move(*hash);
+  }
+  entry.mode_ref() = inodeNumber % 2 ? 0100644 : 040755;
+  return entry;
+}
+
+SerializedInodeMap roundTrip(const SerializedInodeMap& inodeMap) {
+  auto packed = packInodeMap(inodeMap);
+  return unpackInodeMap(folly::ByteRange{folly::StringPiece{packed}});
+}
+
+TEST(InodeMapPacking, roundTripSortsByInodeNumber) {
+  SerializedInodeMap inodeMap;
+  auto& entries = *inodeMap.unloadedInodes_ref();
+  entries.push_back(makeEntry(900, 2, "BUCK", std::string(20, 'a')));
+  entries.push_back(makeEntry(12, 900, "__init__.py", std::nullopt));
+  entries.push_back(makeEntry(901, 2, "BUCK", std::string(20, 'b')));
+  // LEGACY: the empty hash must survive as distinct from no hash at all.
+  entries.push_back(makeEntry(13, 900, "", std::string{}));
+
+  auto result = roundTrip(inodeMap);
+  auto expected = entries;
+  std::sort(expected.begin(), expected.end(), [](auto& a, auto& b) {
+    return *a.inodeNumber_ref() < *b.inodeNumber_ref();
+  });
+  EXPECT_EQ(expected, *result.unloadedInodes_ref());
+}
+
+TEST(InodeMapPacking, empty) {
+  EXPECT_TRUE(roundTrip(SerializedInodeMap{}).unloadedInodes_ref()->empty());
+}
+
+TEST(InodeMapPacking, rejectsTruncatedData) {
+  SerializedInodeMap inodeMap;
+  for (int64_t i = 2; i < 100; ++i) {
+    inodeMap.unloadedInodes_ref()->push_back(
+        makeEntry(i, i / 2, fmt::format("dir{}", i % 7), std::string(20, 'x')));
+  }
+  auto packed = packInodeMap(inodeMap);
+  for (size_t size = 0; size < packed.size(); ++size) {
+    SCOPED_TRACE(size);
+    EXPECT_THROW(
+        unpackInodeMap(folly::ByteRange{folly::StringPiece{packed}.subpiece(
+            0, size)}),
+        std::runtime_error);
+  }
+}
+
+} // namespace
@@ -14,6 +14,7 @@
 #include <folly/test/TestUtils.h>
 
 #include <eden/fs/takeover/gen-cpp2/takeover_types.h>
+#include "eden/fs/model/Tree.h"
 #include "eden/fs/takeover/TakeoverClient.h"
 #include "eden/fs/takeover/TakeoverData.h"
 #include "eden/fs/takeover/TakeoverHandler.h"
@@ -183,6 +184,12 @@ TEST(Takeover, roundTripVersionCapabilities) {
   }
 }
 
+TEST(Takeover, laterCapabilitiesAdvertiseVersionSeven) {
+  EXPECT_EQ(
+      TakeoverData::capabilitiesToVersion(kSupportedCapabilities),
+      TakeoverData::kTakeoverProtocolVersionSeven);
+}
+
 TEST(Takeover, unsupportedVersionCapabilities) {
   EXPECT_EQ(
       TakeoverData::versionToCapabilities(
@@ -484,6 +491,50 @@ TEST(Takeover, noMounts) {
   EXPECT_EQ(0, clientData.mountPoints.size());
 }
 
+TEST(Takeover, treeCache) {
+  auto tree = std::make_shared<const Tree>(
+      Tree::container{
+          {{PathComponent{"file"},
+            TreeEntry{
+                ObjectId::fromHex("0123456789abcdef0123456789abcdef01234567"),
+                TreeEntryType::REGULAR_FILE}}},
+          kPathMapDefaultCaseSensitive},
+      ObjectId::fromHex("fedcba9876543210fedcba9876543210fedcba98"));
+
+  auto takeoverTrees = [&](uint64_t clientCapabilities) {
+    TemporaryDirectory tmpDir("eden_takeover_test");
+    AbsolutePath tmpDirPath = canonicalPath(tmpDir.path().string());
+
+    TakeoverData serverData;
+    serverData.lockFile =
+        folly::File{(tmpDirPath + "lock"_pc).view(), O_RDWR | O_CREAT};
+    serverData.thriftSocket =
+        folly::File{(tmpDirPath + "thrift"_pc).view(), O_RDWR | O_CREAT};
+    serverData.treeCache.push_back(tree);
+
+    TestHandler handler{std::move(serverData)};
+    auto result = runTakeover(
+        tmpDir,
+        &handler,
+        kSupportedTakeoverVersions,
+        kSupportedTakeoverVersions,
+        clientCapabilities);
+    EXPECT_TRUE(result.hasValue());
+    return std::move(result.value().treeCache);
+  };
+
+  auto trees = takeoverTrees(kSupportedCapabilities);
+  ASSERT_EQ(1, trees.size());
+  EXPECT_EQ(tree->getHash(), trees[0]->getHash());
+  EXPECT_EQ(*tree, *trees[0]);
+
+  // A client without the capability starts with an empty cache.
+  EXPECT_TRUE(takeoverTrees(
+                  kSupportedCapabilities &
+                  ~uint64_t{TakeoverCapabilities::TREE_CACHE})
+                  .empty());
+}
+
 TEST(Takeover, manyMounts) {
   TemporaryDirectory tmpDir("eden_takeover_test");
   AbsolutePath tmpDirPath = canonicalPath(tmpDir.path().string());
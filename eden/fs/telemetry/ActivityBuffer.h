@@ -8,11 +8,27 @@
 #pragma once
 
 #include <folly/Synchronized.h>
-
-#include "eden/fs/utils/RingBuffer.h"
+#include <folly/memory/Malloc.h>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <type_traits>
+#include <vector>
 
 namespace facebook::eden {
 
+namespace detail {
+template <typename TraceEvent, typename = void>
+struct HasPath : std::false_type {};
+
+template <typename TraceEvent>
+struct HasPath<
+    TraceEvent,
+    std::void_t<decltype(std::declval<const TraceEvent&>().path.get())>>
+    : std::true_type {};
+} // namespace detail
+
 /**
  * ActivityBuffer is a fixed size buffer of stored EdenFS trace events whose
  * maximum size can be set when initialized. To be filled, an ActivityBuffer
@@ -21,6 +37,14 @@ namespace facebook::eden {
  * adding recent events (evicting old events in the process) as well as reading
  * all trace events currently stored in a thread safe manner.
  *
+ * The size of the buffer is bounded both by a number of events and by an
+ * estimate of the memory they use, which counts the heap-allocated path of
+ * events that have one. The memory bound makes it safe to keep many events of
+ * mounts whose paths are long.
+ *
+ * Events are added by the thread of the TraceBus the buffer subscribes to, so
+ * the lock is only contended while events are read, which is rare.
+ *
  * With the ActivityBuffer, we enable functionality for retroactive debugging of
  * expensive events in EdenFS by storing past event changes that users will be
  * able view at any time through retroactive versions of Eden's tracing CLI.
@@ -28,7 +52,9 @@ namespace facebook::eden {
 template <typename TraceEvent>
 class ActivityBuffer {
  public:
-  explicit ActivityBuffer(size_t maxEvents);
+  explicit ActivityBuffer(
+      size_t maxEvents,
+      size_t maxBytes = std::numeric_limits<size_t>::max());
 
   ActivityBuffer(const ActivityBuffer&) = delete;
   ActivityBuffer(ActivityBuffer&&) = delete;
@@ -37,8 +63,8 @@ class ActivityBuffer {
 
   /**
    * Adds a new TraceEvent to the ActivityBuffer. Evicts the oldest
-   * event if the buffer was full (meaning maxEvents events were already stored
-   * in the buffer).
+   * events if the buffer was full (meaning maxEvents events were already stored
+   * in the buffer, or they used maxBytes).
    */
   template <typename T>
   void addEvent(T&& event);
@@ -49,23 +75,75 @@ class ActivityBuffer {
    */
   std::vector<TraceEvent> getAllEvents() const;
 
+  /**
+   * Estimate the memory used by the events stored in the ActivityBuffer.
+   */
+  size_t estimateMemoryUsage() const;
+
+  /**
+   * Estimate the memory used by one event once stored: its own size, and
+   * the size of its path if it has one.
+   */
+  static size_t estimateMemoryUsage(const TraceEvent& event);
+
  private:
-  folly::Synchronized<RingBuffer<TraceEvent>> events_;
+  struct State {
+    std::deque<TraceEvent> events;
+    size_t bytes = 0;
+  };
+
+  const size_t maxEvents_;
+  const size_t maxBytes_;
+  folly::Synchronized<State, std::mutex> state_;
 };
 
 template <typename TraceEvent>
-ActivityBuffer<TraceEvent>::ActivityBuffer(size_t maxEvents)
-    : events_{folly::in_place, maxEvents} {}
+ActivityBuffer<TraceEvent>::ActivityBuffer(size_t maxEvents, size_t maxBytes)
+    : maxEvents_{maxEvents}, maxBytes_{maxBytes} {}
+
+template <typename TraceEvent>
+size_t ActivityBuffer<TraceEvent>::estimateMemoryUsage(
+    const TraceEvent& event) {
+  size_t usage = sizeof(TraceEvent);
+  if constexpr (detail::HasPath<TraceEvent>::value) {
+    if (const char* path = event.path.get()) {
+      usage += folly::goodMallocSize(std::strlen(path) + 1);
+    }
+  }
+  return usage;
+}
 
 template <typename TraceEvent>
 template <typename T>
 void ActivityBuffer<TraceEvent>::addEvent(T&& event) {
-  events_.wlock()->push(std::forward<T>(event));
+  if (maxEvents_ == 0) {
+    return;
+  }
+  auto eventBytes = estimateMemoryUsage(event);
+  if (eventBytes > maxBytes_) {
+    return;
+  }
+
+  auto state = state_.lock();
+  while (!state->events.empty() &&
+         (state->events.size() >= maxEvents_ ||
+          state->bytes + eventBytes > maxBytes_)) {
+    state->bytes -= estimateMemoryUsage(state->events.front());
+    state->events.pop_front();
+  }
+  state->events.push_back(std::forward<T>(event));
+  state->bytes += eventBytes;
 }
 
 template <typename TraceEvent>
 std::vector<TraceEvent> ActivityBuffer<TraceEvent>::getAllEvents() const {
-  return events_.rlock()->toVector();
+  auto state = state_.lock();
+  return std::vector<TraceEvent>{state->events.begin(), state->events.end()};
+}
+
+template <typename TraceEvent>
+size_t ActivityBuffer<TraceEvent>::estimateMemoryUsage() const {
+  return state_.lock()->bytes;
 }
 
 } // namespace facebook::eden
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/ChromeTraceWriter.h"
+
+#include <fcntl.h>
+#include <folly/Exception.h>
+#include <folly/FileUtil.h>
+#include <folly/json.h>
+#include <folly/system/Pid.h>
+#include <filesystem>
+
+namespace facebook::eden {
+
+namespace {
+// The start of the JSON array of events, which is never closed.
+constexpr std::string_view kFileHeader = "[\n";
+
+/** Chrome trace timestamps and durations are in microseconds. */
+double toMicroseconds(std::chrono::steady_clock::duration duration) {
+  return std::chrono::duration<double, std::micro>{duration}.count();
+}
+} // namespace
+
+ChromeTraceWriter::ChromeTraceWriter(AbsolutePath path, size_t maxFileSize)
+    : path_{std::move(path)},
+      maxFileSize_{maxFileSize},
+      pid_{folly::get_cached_pid()} {
+  auto state = state_.lock();
+  openFile(*state);
+}
+
+void ChromeTraceWriter::complete(
+    std::string_view category,
+    std::string_view name,
+    uint64_t threadId,
+    TimePoint start,
+    std::chrono::steady_clock::duration duration,
+    folly::dynamic args) {
+  auto event = folly::dynamic::object("tid", threadId)(
+      "dur", toMicroseconds(duration));
+  if (!args.isNull()) {
+    event["args"] = std::move(args);
+  }
+  write("X", category, name, start, std::move(event));
+}
+
+void ChromeTraceWriter::asyncBegin(
+    std::string_view category,
+    std::string_view name,
+    uint64_t id,
+    TimePoint time,
+    folly::dynamic args) {
+  auto event = folly::dynamic::object("id", id);
+  if (!args.isNull()) {
+    event["args"] = std::move(args);
+  }
+  write("b", category, name, time, std::move(event));
+}
+
+void ChromeTraceWriter::asyncInstant(
+    std::string_view category,
+    std::string_view name,
+    uint64_t id,
+    TimePoint time,
+    folly::dynamic args) {
+  auto event = folly::dynamic::object("id", id);
+  if (!args.isNull()) {
+    event["args"] = std::move(args);
+  }
+  write("n", category, name, time, std::move(event));
+}
+
+void ChromeTraceWriter::asyncEnd(
+    std::string_view category,
+    std::string_view name,
+    uint64_t id,
+    TimePoint time,
+    folly::dynamic args) {
+  auto event = folly::dynamic::object("id", id);
+  if (!args.isNull()) {
+    event["args"] = std::move(args);
+  }
+  write("e", category, name, time, std::move(event));
+}
+
+void ChromeTraceWriter::write(
+    std::string_view phase,
+    std::string_view category,
+    std::string_view name,
+    TimePoint time,
+    folly::dynamic event) {
+  event["ph"] = folly::StringPiece{phase};
+  event["cat"] = folly::StringPiece{category};
+  event["name"] = folly::StringPiece{name};
+  event["ts"] = toMicroseconds(time.time_since_epoch());
+  event["pid"] = pid_;
+  if (!event.count("tid")) {
+    event["tid"] = 0;
+  }
+  auto line = folly::toJson(event);
+  line += ",\n";
+
+  auto state = state_.lock();
+  // Always write at least one event per file, however large.
+  if (state->fileSize + line.size() > maxFileSize_ &&
+      state->fileSize > kFileHeader.size()) {
+    openFile(*state);
+  }
+  append(*state, line);
+}
+
+void ChromeTraceWriter::openFile(State& state) {
+  if (state.file) {
+    state.file.close();
+    auto rotatedPath = path_.asString() + ".1";
+    std::filesystem::rename(path_.view(), rotatedPath);
+  }
+  state.file = folly::File{
+      path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644};
+  state.fileSize = 0;
+  append(state, kFileHeader);
+}
+
+void ChromeTraceWriter::append(State& state, std::string_view data) {
+  folly::checkUnixError(
+      folly::writeFull(state.file.fd(), data.data(), data.size()),
+      "failed to write to the trace file ",
+      path_.view());
+  state.fileSize += data.size();
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/File.h>
+#include <folly/Synchronized.h>
+#include <folly/dynamic.h>
+#include <chrono>
+#include <mutex>
+#include <string_view>
+
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * Writes trace events to a file in the Chrome trace event format, which
+ * chrome://tracing and the Perfetto UI display as a timeline with a track per
+ * thread and per asynchronous request.
+ *
+ * The file is a JSON array that is never closed, which these viewers accept,
+ * so that it stays readable while being written and if EdenFS dies.
+ *
+ * To bound its size, once the file grows past maxFileSize it is renamed with a
+ * ".1" suffix, replacing the previous one, and a new file is started: the
+ * latest events are always kept in these two files.
+ *
+ * Times are steady clock time points, like TraceEventBase::monotonicTime.
+ *
+ * This class is thread-safe: TraceBus subscribers on different threads can
+ * share a writer. Errors writing to the file are thrown.
+ */
+class ChromeTraceWriter {
+ public:
+  using TimePoint = std::chrono::steady_clock::time_point;
+
+  ChromeTraceWriter(AbsolutePath path, size_t maxFileSize);
+
+  ChromeTraceWriter(const ChromeTraceWriter&) = delete;
+  ChromeTraceWriter& operator=(const ChromeTraceWriter&) = delete;
+
+  /**
+   * Record a span of work done on a thread.
+   */
+  void complete(
+      std::string_view category,
+      std::string_view name,
+      uint64_t threadId,
+      TimePoint start,
+      std::chrono::steady_clock::duration duration,
+      folly::dynamic args = nullptr);
+
+  /**
+   * Record the start of an asynchronous span, such as a filesystem request,
+   * which may be handled by several threads. The span is identified by its
+   * category, name and id.
+   */
+  void asyncBegin(
+      std::string_view category,
+      std::string_view name,
+      uint64_t id,
+      TimePoint time,
+      folly::dynamic args = nullptr);
+
+  /**
+   * Record a step of an asynchronous span started with asyncBegin.
+   */
+  void asyncInstant(
+      std::string_view category,
+      std::string_view name,
+      uint64_t id,
+      TimePoint time,
+      folly::dynamic args = nullptr);
+
+  /**
+   * Record the end of an asynchronous span started with asyncBegin.
+   */
+  void asyncEnd(
+      std::string_view category,
+      std::string_view name,
+      uint64_t id,
+      TimePoint time,
+      folly::dynamic args = nullptr);
+
+  AbsolutePathPiece getPath() const {
+    return path_;
+  }
+
+ private:
+  struct State {
+    folly::File file;
+    size_t fileSize = 0;
+  };
+
+  void write(
+      std::string_view phase,
+      std::string_view category,
+      std::string_view name,
+      TimePoint time,
+      folly::dynamic event);
+
+  /** Start a new file at path_, moving the current one aside if any. */
+  void openFile(State& state);
+
+  void append(State& state, std::string_view data);
+
+  const AbsolutePath path_;
+  const size_t maxFileSize_;
+  const int64_t pid_;
+  folly::Synchronized<State, std::mutex> state_;
+};
+
+} // namespace facebook::eden
@@ -8,11 +8,25 @@
 #include "eden/fs/telemetry/EdenStats.h"
 
 #include <folly/logging/xlog.h>
+#include <array>
 #include <chrono>
 #include <memory>
 
 namespace facebook::eden {
 
+namespace {
+// The quantiles exported for durations. Filesystem requests are waited on
+// by the applications making them, so the tail beyond p99 matters too.
+constexpr std::array<double, 6> kDurationQuantiles{
+    0.01,
+    0.1,
+    0.5,
+    0.9,
+    0.99,
+    0.999,
+};
+} // namespace
+
 void EdenStats::flush() {
   // This method is only really useful while testing to ensure that the service
   // data singleton instance has the latest stats. Since all our stats are now
@@ -37,7 +51,7 @@ StatsGroupBase::Duration::Duration(std::string_view name)
     : Stat{
           name,
           fb303::ExportTypeConsts::kSumCountAvgRate,
-          fb303::QuantileConsts::kP1_P10_P50_P90_P99,
+          kDurationQuantiles,
           fb303::SlidingWindowPeriodConsts::kOneMinTenMinHour} {
   // This should be a compile-time check but I don't know how to spell that in a
   // convenient way. :) Asserting at startup in debug mode should be sufficient.
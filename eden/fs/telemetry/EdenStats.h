@@ -218,6 +218,7 @@ struct FuseStats : StatsGroup<FuseStats> {
   Duration fsync{"fuse.fsync_us"};
   Duration opendir{"fuse.opendir_us"};
   Duration readdir{"fuse.readdir_us"};
+  Duration readdirplus{"fuse.readdirplus_us"};
   Duration releasedir{"fuse.releasedir_us"};
   Duration fsyncdir{"fuse.fsyncdir_us"};
   Duration statfs{"fuse.statfs_us"};
@@ -232,6 +233,20 @@ struct FuseStats : StatsGroup<FuseStats> {
   Duration poll{"fuse.poll_us"};
   Duration forgetmulti{"fuse.forgetmulti_us"};
   Duration fallocate{"fuse.fallocate_us"};
+
+  Counter invalidateInode{"fuse.invalidation.inode"};
+  Counter invalidateEntry{"fuse.invalidation.entry"};
+
+  // Requests for the inodes sampled by KernelCacheTracker, and those of them
+  // repeated while the kernel could still have cached the previous reply.
+  Counter sampledLookup{"fuse.kernel_cache.lookup.sampled"};
+  Counter repeatedLookup{"fuse.kernel_cache.lookup.repeated"};
+  Counter sampledGetattr{"fuse.kernel_cache.getattr.sampled"};
+  Counter repeatedGetattr{"fuse.kernel_cache.getattr.repeated"};
+  // Bytes read from the sampled files which are not materialized, and those
+  // of them which were already read.
+  Counter sampledReadBytes{"fuse.kernel_cache.read_bytes.sampled"};
+  Counter repeatedReadBytes{"fuse.kernel_cache.read_bytes.repeated"};
 };
 
 struct NfsStats : StatsGroup<NfsStats> {
@@ -257,11 +272,27 @@ struct NfsStats : StatsGroup<NfsStats> {
   Duration nfsFsinfo{"nfs.fsinfo_us"};
   Duration nfsPathconf{"nfs.pathconf_us"};
   Duration nfsCommit{"nfs.commit_us"};
+
+  Counter attrCacheHit{"nfs.attr_cache.hit"};
+  Counter attrCacheMiss{"nfs.attr_cache.miss"};
+
+  Counter invalidationRequested{"nfs.invalidation.requested"};
+  Counter invalidationPerformed{"nfs.invalidation.performed"};
+
+  // See the kernel_cache counters of FuseStats.
+  Counter sampledLookup{"nfs.kernel_cache.lookup.sampled"};
+  Counter repeatedLookup{"nfs.kernel_cache.lookup.repeated"};
+  Counter sampledGetattr{"nfs.kernel_cache.getattr.sampled"};
+  Counter repeatedGetattr{"nfs.kernel_cache.getattr.repeated"};
+  Counter sampledReadBytes{"nfs.kernel_cache.read_bytes.sampled"};
+  Counter repeatedReadBytes{"nfs.kernel_cache.read_bytes.repeated"};
 };
 
 struct PrjfsStats : StatsGroup<PrjfsStats> {
   Counter outOfOrderCreate{"prjfs.out_of_order_create"};
   Duration queuedFileNotification{"prjfs.queued_file_notification_us"};
+  Counter fileNotificationQueued{"prjfs.file_notification.queued"};
+  Counter fileNotificationCoalesced{"prjfs.file_notification.coalesced"};
   Duration filesystemSync{"prjfs.filesystem_sync_us"};
 
   Duration newFileCreated{"prjfs.newFileCreated_us"};
@@ -295,6 +326,8 @@ struct ObjectStoreStats : StatsGroup<ObjectStoreStats> {
 
   Counter getBlobFromLocalStore{"object_store.get_blob.local_store"};
   Counter getBlobFromBackingStore{"object_store.get_blob.backing_store"};
+  // Blobs that were not prefetched since they were in the LocalStore already.
+  Counter prefetchBlobFromLocalStore{"object_store.prefetch_blob.local_store"};
 
   Counter getTreeFromLocalStore{"object_store.get_tree.local_store"};
   Counter getTreeFromBackingStore{"object_store.get_tree.backing_store"};
@@ -317,6 +350,14 @@ struct LocalStoreStats : StatsGroup<LocalStoreStats> {
   Counter getTreeFailure{"local_store.get_tree_failure"};
   Counter getBlobFailure{"local_store.get_blob_failure"};
   Counter getBlobMetadataFailure{"local_store.get_blob_metadata_failure"};
+  // getBlobByContent() lookups with no content hash recorded for the blob,
+  // or whose contents are no longer stored.
+  Counter getBlobByContentMiss{"local_store.get_blob_by_content_miss"};
+  // Lookups that the key filter answered as definite misses.
+  Counter keyFilterNegative{"local_store.key_filter.negative"};
+  // Lookups that the key filter let through but that missed. Divided by the
+  // sum of both, this is the observed false positive rate.
+  Counter keyFilterFalsePositive{"local_store.key_filter.false_positive"};
 };
 
 /**
@@ -337,6 +378,27 @@ struct HgBackingStoreStats : StatsGroup<HgBackingStoreStats> {
   Duration getBlobMetadata{"store.hg.get_blob_metadata_us"};
   Duration fetchBlobMetadata{"store.hg.fetch_blob_metadata_us"};
   Counter loadProxyHash{"store.hg.load_proxy_hash"};
+  // The number of requests in each import batch.
+  Counter importBatchTree{"store.hg.import_batch.tree"};
+  Counter importBatchBlob{"store.hg.import_batch.blob"};
+  Counter importBatchBlobMeta{"store.hg.import_batch.blobmeta"};
+  // Requests the native backing store couldn't serve, which fell back on the
+  // hg debugedenimporthelper process.
+  Counter importerFallbackTree{"store.hg.importer_fallback.tree"};
+  Counter importerFallbackBlob{"store.hg.importer_fallback.blob"};
+  Counter importerFallbackManifest{"store.hg.importer_fallback.manifest"};
+  // The time import requests spend in each stage, by priority class: waiting
+  // in the queue, fetching through the native backing store, and from being
+  // queued to completion, importer fallback included.
+  Duration importQueueWaitHigh{"store.hg.import_queue_wait.high_us"};
+  Duration importQueueWaitNormal{"store.hg.import_queue_wait.normal_us"};
+  Duration importQueueWaitLow{"store.hg.import_queue_wait.low_us"};
+  Duration importFetchHigh{"store.hg.import_fetch.high_us"};
+  Duration importFetchNormal{"store.hg.import_fetch.normal_us"};
+  Duration importFetchLow{"store.hg.import_fetch.low_us"};
+  Duration importTotalHigh{"store.hg.import_total.high_us"};
+  Duration importTotalNormal{"store.hg.import_total.normal_us"};
+  Duration importTotalLow{"store.hg.import_total.low_us"};
 };
 
 /**
@@ -349,20 +411,31 @@ struct HgImporterStats : StatsGroup<HgImporterStats> {
   Counter manifest{"hg_importer.manifest"};
   Counter manifestNodeForCommit{"hg_importer.manifest_node_for_commit"};
   Counter prefetchFiles{"hg_importer.prefetch_files"};
+  // Spawns of the hg debugedenimporthelper process.
+  Counter start{"hg_importer.start"};
 };
 
 struct JournalStats : StatsGroup<JournalStats> {
   Counter truncatedReads{"journal.truncated_reads"};
   Counter filesAccumulated{"journal.files_accumulated"};
+  Counter statusCacheHit{"journal.status_cache_hit"};
+  Counter statusCacheIncremental{"journal.status_cache_incremental"};
+  Counter statusCacheMiss{"journal.status_cache_miss"};
 };
 
 struct ThriftStats : StatsGroup<ThriftStats> {
   Duration streamChangesSince{
       "thrift.StreamingEdenService.streamChangesSince.streaming_time_us"};
+  Duration streamScmStatus{
+      "thrift.StreamingEdenService.streamScmStatus.streaming_time_us"};
+  Duration streamGlobFiles{
+      "thrift.StreamingEdenService.streamGlobFiles.streaming_time_us"};
 };
 
 struct TelemetryStats : StatsGroup<TelemetryStats> {
   Counter subprocessLoggerFailure{"telemetry.subprocess_logger_failure"};
+  Counter scribeLoggerDroppedMessages{
+      "telemetry.scribe_logger.dropped_messages"};
 };
 
 struct OverlayStats : StatsGroup<OverlayStats> {
@@ -376,6 +449,11 @@ struct OverlayStats : StatsGroup<OverlayStats> {
   Duration removeChild{"overlay.remove_child_us"};
   Duration removeChildren{"overlay.remove_children_us"};
   Duration renameChild{"overlay.rename_child_us"};
+
+  Counter fileAccessCacheHit{"overlay.file_access.cache_hit"};
+  Counter fileAccessCacheMiss{"overlay.file_access.cache_miss"};
+  Counter fileAccessCacheEviction{"overlay.file_access.cache_eviction"};
+  Counter contentHashHit{"overlay.file_access.content_hash_hit"};
 };
 
 /**
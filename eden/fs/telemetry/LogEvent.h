@@ -84,6 +84,53 @@ struct StarGlob {
   }
 };
 
+struct SlowGlob {
+  static constexpr const char* type = "slow_glob";
+
+  std::string glob_request;
+  std::string client_cmdline;
+  uint64_t directories_visited;
+  uint64_t trees_from_cache;
+  uint64_t trees_from_backing_store;
+  uint64_t entries_matched;
+  double matching_time;
+  double duration;
+
+  void populate(DynamicEvent& event) const {
+    event.addString("glob_request", glob_request);
+    event.addString("client_cmdline", client_cmdline);
+    event.addInt("directories_visited", directories_visited);
+    event.addInt("trees_from_cache", trees_from_cache);
+    event.addInt("trees_from_backing_store", trees_from_backing_store);
+    event.addInt("entries_matched", entries_matched);
+    event.addDouble("matching_time", matching_time);
+    event.addDouble("duration", duration);
+  }
+};
+
+struct SlowRequests {
+  static constexpr const char* type = "slow_requests";
+
+  std::string mount_protocol;
+  // The request that became slow, and for how long it had been outstanding.
+  std::string request;
+  double request_age = 0.0;
+  // All the outstanding requests of the mount, from the oldest.
+  std::string outstanding_requests;
+  uint64_t outstanding_request_count = 0;
+  // The threads of EdenFS, grouped by name, state and wait channel.
+  std::string thread_states;
+
+  void populate(DynamicEvent& event) const {
+    event.addString("mount_protocol", mount_protocol);
+    event.addString("request", request);
+    event.addDouble("request_age", request_age);
+    event.addString("outstanding_requests", outstanding_requests);
+    event.addInt("outstanding_request_count", outstanding_request_count);
+    event.addString("thread_states", thread_states);
+  }
+};
+
 struct MissingProxyHash {
   static constexpr const char* type = "missing_proxy_hash";
 
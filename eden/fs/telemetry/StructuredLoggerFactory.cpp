@@ -36,8 +36,8 @@ std::shared_ptr<StructuredLogger> makeDefaultStructuredLogger(
   }
 
   try {
-    auto logger =
-        std::make_unique<SubprocessScribeLogger>(binary.c_str(), category);
+    auto logger = std::make_unique<SubprocessScribeLogger>(
+        binary.c_str(), category, edenStats.copy());
     return std::make_shared<ScubaStructuredLogger>(
         std::move(logger), std::move(sessionInfo));
   } catch (const std::exception& ex) {
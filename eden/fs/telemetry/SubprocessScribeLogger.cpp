@@ -9,14 +9,21 @@
 
 #include <folly/logging/xlog.h>
 #include <folly/system/ThreadName.h>
+#include <algorithm>
 
 namespace {
 /**
  * If the writer process is backed up, limit the message queue size to the
- * following bytes.
+ * following bytes. The batch being written is not counted.
  */
 constexpr size_t kQueueLimitBytes = 128 * 1024;
 
+/**
+ * Each message takes two iovecs, and writev accepts up to IOV_MAX of them,
+ * which is 1024 on Linux and macOS.
+ */
+constexpr size_t kMaxMessagesPerWrite = 512;
+
 constexpr std::chrono::seconds kFlushTimeout{1};
 constexpr std::chrono::seconds kProcessExitTimeout{1};
 constexpr std::chrono::seconds kProcessTerminateTimeout{1};
@@ -24,15 +31,49 @@ constexpr std::chrono::seconds kProcessTerminateTimeout{1};
 
 namespace facebook::eden {
 
+namespace {
+/**
+ * Write messages to fd, each followed by a newline, with as few system calls
+ * as possible. Returns false if fd can't be written to.
+ */
+bool writeMessages(
+    const FileDescriptor& fd,
+    const std::vector<std::string>& messages) {
+  char newline = '\n';
+  std::vector<iovec> iov;
+  iov.reserve(2 * std::min(messages.size(), kMaxMessagesPerWrite));
+
+  for (size_t start = 0; start < messages.size();
+       start += kMaxMessagesPerWrite) {
+    auto end = std::min(messages.size(), start + kMaxMessagesPerWrite);
+    iov.clear();
+    for (size_t i = start; i < end; ++i) {
+      auto& message = messages[i];
+      iov.push_back({const_cast<char*>(message.data()), message.size()});
+      iov.push_back({&newline, sizeof(newline)});
+    }
+    if (fd.writevFull(iov.data(), iov.size()).hasException()) {
+      return false;
+    }
+  }
+  return true;
+}
+} // namespace
+
 SubprocessScribeLogger::SubprocessScribeLogger(
     const char* executable,
-    folly::StringPiece category)
+    folly::StringPiece category,
+    EdenStatsPtr edenStats)
     : SubprocessScribeLogger{
-          std::vector<std::string>{executable, category.str()}} {}
+          std::vector<std::string>{executable, category.str()},
+          FileDescriptor(),
+          std::move(edenStats)} {}
 
 SubprocessScribeLogger::SubprocessScribeLogger(
     const std::vector<std::string>& argv,
-    FileDescriptor stdoutFd) {
+    FileDescriptor stdoutFd,
+    EdenStatsPtr edenStats)
+    : edenStats_{std::move(edenStats)} {
   SpawnedProcess::Options options;
   options.pipeStdin();
 
@@ -102,8 +143,11 @@ void SubprocessScribeLogger::log(std::string message) {
       return;
     }
     if (state->totalBytes + messageSize > kQueueLimitBytes) {
+      state.unlock();
       XLOG_EVERY_MS(DBG7, 10000) << "ScribeLogger queue full, dropping message";
-      // queue full, dropping!
+      if (edenStats_) {
+        edenStats_->increment(&TelemetryStats::scribeLoggerDroppedMessages);
+      }
       return;
     }
 
@@ -118,7 +162,9 @@ void SubprocessScribeLogger::writerThread() {
   auto fd = process_.stdinFd();
 
   for (;;) {
-    std::string message;
+    // Take all the queued messages at once, so that the lock is taken once
+    // per batch rather than once per message.
+    std::vector<std::string> messages;
 
     {
       auto state = state_.lock();
@@ -126,13 +172,9 @@ void SubprocessScribeLogger::writerThread() {
         return state->shouldStop || !state->messages.empty();
       });
       if (!state->messages.empty()) {
-        XCHECK_LE(state->messages.front().size(), state->totalBytes)
-            << "totalSize accounting fell out of sync!";
-
         // The below statements are all noexcept.
-        std::swap(message, state->messages.front());
-        state->messages.pop_front();
-        state->totalBytes -= message.size();
+        std::swap(messages, state->messages);
+        state->totalBytes = 0;
       } else {
         // If the predicate succeeded but we have no messages, then we're
         // shutting down cleanly.
@@ -146,13 +188,7 @@ void SubprocessScribeLogger::writerThread() {
       }
     }
 
-    char newline = '\n';
-    std::array<iovec, 2> iov;
-    iov[0].iov_base = message.data();
-    iov[0].iov_len = message.size();
-    iov[1].iov_base = &newline;
-    iov[1].iov_len = sizeof(newline);
-    if (fd.writevFull(iov.data(), iov.size()).hasException()) {
+    if (!writeMessages(fd, messages)) {
       // TODO: We could attempt to restart the process here.
       XLOG(ERR) << "Failed to writev to logger process stdin: "
                 << folly::errnoStr(errno) << ". Giving up!";
@@ -8,7 +8,8 @@
 #pragma once
 
 #include <folly/Synchronized.h>
-#include <list>
+#include <vector>
+#include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/telemetry/ScribeLogger.h"
 #include "eden/fs/utils/SpawnedProcess.h"
 
@@ -17,13 +18,21 @@ namespace facebook::eden {
 /**
  * SubprocessScribeLogger manages an external unix process and asynchronously
  * forwards newline-delimited messages to its stdin.
+ *
+ * Messages are queued in memory, up to a bounded size, and written in batches
+ * by a background thread, so that logging doesn't block on the process.
+ * Messages that don't fit in the queue are dropped and counted in the
+ * telemetry.scribe_logger.dropped_messages stat.
  */
 class SubprocessScribeLogger : public ScribeLogger {
  public:
   /**
    * Launch `executable` with `category` as the first argument.
    */
-  SubprocessScribeLogger(const char* executable, folly::StringPiece category);
+  SubprocessScribeLogger(
+      const char* executable,
+      folly::StringPiece category,
+      EdenStatsPtr edenStats = {});
 
   /**
    * Launch the process specified at argv[0] with the given argv, and forward
@@ -32,7 +41,8 @@ class SubprocessScribeLogger : public ScribeLogger {
    */
   explicit SubprocessScribeLogger(
       const std::vector<std::string>& argv,
-      FileDescriptor stdoutFd = FileDescriptor());
+      FileDescriptor stdoutFd = FileDescriptor(),
+      EdenStatsPtr edenStats = {});
 
   /**
    * Waits for the managed process to exit. If it is hung and doesn't complete,
@@ -61,9 +71,10 @@ class SubprocessScribeLogger : public ScribeLogger {
     /// Sum of sizes of queued messages.
     size_t totalBytes = 0;
     /// Invariant: empty if didStop is true
-    std::list<std::string> messages;
+    std::vector<std::string> messages;
   };
 
+  EdenStatsPtr edenStats_;
   SpawnedProcess process_;
   std::thread writerThread_;
 
@@ -9,6 +9,10 @@
 #include <folly/init/Init.h>
 #include <folly/portability/GFlags.h>
 #include <folly/stop_watch.h>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "eden/fs/telemetry/ActivityBuffer.h"
 #include "eden/fs/utils/SpawnedProcess.h"
 
 using namespace facebook::eden;
@@ -20,6 +24,13 @@ constexpr uint32_t kNumWriteIterations = 10;
 constexpr size_t kPageSize = 4096;
 
 DEFINE_uint64(filesize, kPageSize, "File size in bytes");
+DEFINE_bool(
+    in_memory,
+    false,
+    "Only measure adding events to an ActivityBuffer from several threads, "
+    "which doesn't need a checkout");
+DEFINE_uint32(producers, 4, "Number of threads adding events with --in_memory");
+DEFINE_uint32(capacity, 100000, "Maximum events stored with --in_memory");
 
 SpawnedProcess::Options pipe_stdout_opts() {
   SpawnedProcess::Options opts;
@@ -100,10 +111,53 @@ void ActivityBuffer_repeatedly_create_inodes() {
   printf("ActivityBufferBenchmark finished\n");
 }
 
+/**
+ * Stands for the trace events stored in ActivityBuffers, which hold a path.
+ */
+struct PathEvent {
+  explicit PathEvent(std::string_view p) : path{new char[p.size() + 1]} {
+    std::memcpy(path.get(), p.data(), p.size());
+    path[p.size()] = 0;
+  }
+
+  std::shared_ptr<char[]> path;
+};
+
+void ActivityBuffer_concurrent_add_events() {
+  constexpr uint32_t kEventsPerProducer = 1000000;
+  ActivityBuffer<PathEvent> buffer{FLAGS_capacity};
+  PathEvent event{"fbcode/eden/fs/telemetry/ActivityBuffer.h"};
+
+  printf("Adding events from %u threads...\n", FLAGS_producers);
+  folly::stop_watch<> add_timer;
+  std::vector<std::thread> producers;
+  for (uint32_t i = 0; i < FLAGS_producers; i++) {
+    producers.emplace_back([&] {
+      for (uint32_t j = 0; j < kEventsPerProducer; j++) {
+        buffer.addEvent(event);
+      }
+    });
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  printf(
+      "Average elapsed time for adding an event: %.9f s\n",
+      get_time_elapsed(add_timer) / (kEventsPerProducer * FLAGS_producers));
+  printf(
+      "Memory used by %zu events: %zu bytes\n",
+      buffer.getAllEvents().size(),
+      buffer.estimateMemoryUsage());
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
   folly::init(&argc, &argv);
-  ActivityBuffer_repeatedly_create_inodes();
+  if (FLAGS_in_memory) {
+    ActivityBuffer_concurrent_add_events();
+  } else {
+    ActivityBuffer_repeatedly_create_inodes();
+  }
   return 0;
 }
@@ -7,6 +7,9 @@
 
 #include "eden/fs/telemetry/ActivityBuffer.h"
 #include <folly/portability/GTest.h>
+#include <cstring>
+#include <memory>
+#include <string>
 
 using namespace facebook::eden;
 namespace {
@@ -63,3 +66,44 @@ TEST(ActivityBufferTest, add_exceed_capacity) {
     EXPECT_TRUE(buffer_contains_int(buff, i));
   }
 }
+
+namespace {
+struct PathEvent {
+  explicit PathEvent(std::string_view p) : path{new char[p.size() + 1]} {
+    std::memcpy(path.get(), p.data(), p.size());
+    path[p.size()] = 0;
+  }
+
+  std::shared_ptr<char[]> path;
+};
+} // namespace
+
+TEST(ActivityBufferTest, path_memory_is_estimated) {
+  auto shortPath =
+      ActivityBuffer<PathEvent>::estimateMemoryUsage(PathEvent{"a"});
+  auto longPath = ActivityBuffer<PathEvent>::estimateMemoryUsage(
+      PathEvent{std::string(1000, 'a')});
+  EXPECT_GE(shortPath, sizeof(PathEvent) + 2);
+  EXPECT_GE(longPath, sizeof(PathEvent) + 1001);
+  EXPECT_EQ(sizeof(int), ActivityBuffer<int>::estimateMemoryUsage(1));
+}
+
+TEST(ActivityBufferTest, add_exceed_memory) {
+  auto eventBytes = ActivityBuffer<PathEvent>::estimateMemoryUsage(
+      PathEvent{std::string(100, 'a')});
+  ActivityBuffer<PathEvent> buff(kMaxBufLength, 3 * eventBytes);
+  for (uint64_t i = 0; i < kMaxBufLength; i++) {
+    buff.addEvent(PathEvent{std::string(100, static_cast<char>('a' + i))});
+  }
+
+  // Only the most recent events that fit in the memory bound are kept.
+  auto last = static_cast<char>('a' + kMaxBufLength - 1);
+  auto events = buff.getAllEvents();
+  ASSERT_EQ(3, events.size());
+  EXPECT_EQ(last, events.back().path[0]);
+  EXPECT_EQ(3 * eventBytes, buff.estimateMemoryUsage());
+
+  // An event larger than the bound is never stored.
+  buff.addEvent(PathEvent{std::string(4 * eventBytes, 'z')});
+  EXPECT_EQ(last, buff.getAllEvents().back().path[0]);
+}
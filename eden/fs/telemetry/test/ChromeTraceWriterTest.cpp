@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/ChromeTraceWriter.h"
+
+#include <folly/FileUtil.h>
+#include <folly/experimental/TestUtil.h>
+#include <folly/json.h>
+#include <folly/portability/GTest.h>
+
+using namespace std::chrono_literals;
+using namespace facebook::eden;
+
+namespace {
+
+/** Parse a trace file, closing its JSON array. */
+folly::dynamic readTrace(AbsolutePathPiece path) {
+  std::string contents;
+  EXPECT_TRUE(folly::readFile(path.c_str(), contents));
+  EXPECT_TRUE(contents.ends_with(",\n"));
+  contents.resize(contents.size() - 2);
+  contents += "]";
+  return folly::parseJson(contents);
+}
+
+struct ChromeTraceWriterTest : ::testing::Test {
+  folly::test::TemporaryDirectory testDir{"eden_chrome_trace_writer_test"};
+  AbsolutePath tracePath =
+      canonicalPath(testDir.path().string()) + "trace.json"_pc;
+  std::chrono::steady_clock::time_point start{1s};
+};
+
+} // namespace
+
+TEST_F(ChromeTraceWriterTest, writes_events) {
+  ChromeTraceWriter writer{tracePath, 1024 * 1024};
+  writer.complete("task", "work", 42, start, 3ms);
+  writer.asyncBegin(
+      "fuse", "lookup", 7, start, folly::dynamic::object("nodeid", 1));
+  writer.asyncEnd("fuse", "lookup", 7, start + 5ms);
+
+  auto events = readTrace(tracePath);
+  ASSERT_EQ(3, events.size());
+
+  EXPECT_EQ("X", events[0]["ph"].asString());
+  EXPECT_EQ("task", events[0]["cat"].asString());
+  EXPECT_EQ("work", events[0]["name"].asString());
+  EXPECT_EQ(42, events[0]["tid"].asInt());
+  EXPECT_EQ(1000000.0, events[0]["ts"].asDouble());
+  EXPECT_EQ(3000.0, events[0]["dur"].asDouble());
+
+  EXPECT_EQ("b", events[1]["ph"].asString());
+  EXPECT_EQ(7, events[1]["id"].asInt());
+  EXPECT_EQ(1, events[1]["args"]["nodeid"].asInt());
+
+  EXPECT_EQ("e", events[2]["ph"].asString());
+  EXPECT_EQ(7, events[2]["id"].asInt());
+  EXPECT_EQ(1005000.0, events[2]["ts"].asDouble());
+}
+
+TEST_F(ChromeTraceWriterTest, rotates_full_files) {
+  ChromeTraceWriter writer{tracePath, 256};
+  for (uint64_t i = 0; i < 20; ++i) {
+    writer.asyncInstant("hg", "fetch", i, start);
+  }
+
+  auto rotatedPath = AbsolutePath{tracePath.asString() + ".1"};
+  auto current = readTrace(tracePath);
+  auto rotated = readTrace(rotatedPath);
+  ASSERT_FALSE(current.empty());
+  ASSERT_FALSE(rotated.empty());
+
+  // The latest events are split between the two files, without a gap.
+  EXPECT_EQ(19, current[current.size() - 1]["id"].asInt());
+  EXPECT_EQ(
+      current[0]["id"].asInt() - 1, rotated[rotated.size() - 1]["id"].asInt());
+}
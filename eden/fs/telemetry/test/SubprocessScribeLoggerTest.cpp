@@ -7,6 +7,7 @@
 
 #include "eden/fs/telemetry/SubprocessScribeLogger.h"
 
+#include <fmt/format.h>
 #include <folly/FileUtil.h>
 #include <folly/experimental/TestUtil.h>
 #include <folly/portability/GTest.h>
@@ -31,3 +32,26 @@ TEST(ScribeLogger, log_messages_are_written_with_newlines) {
   folly::readFile(output.fd(), contents);
   EXPECT_EQ("foo\nbar\n", contents);
 }
+
+TEST(ScribeLogger, batches_of_messages_are_written_in_order) {
+  folly::test::TemporaryFile output;
+
+  // More messages than fit in one write.
+  std::string expected;
+  {
+    SubprocessScribeLogger logger{
+        std::vector<std::string>{"/bin/cat"},
+        FileDescriptor(
+            ::dup(output.fd()), "dup", FileDescriptor::FDType::Generic)};
+    for (size_t i = 0; i < 2000; ++i) {
+      auto message = fmt::format("message {}", i);
+      expected += message + "\n";
+      logger.log(std::move(message));
+    }
+  }
+
+  folly::checkUnixError(lseek(output.fd(), 0, SEEK_SET));
+  std::string contents;
+  folly::readFile(output.fd(), contents);
+  EXPECT_EQ(expected, contents);
+}
@@ -129,6 +129,15 @@ SemiFuture<BackingStore::GetBlobResult> FakeBackingStore::getBlob(
   });
 }
 
+folly::SemiFuture<folly::Unit> FakeBackingStore::prefetchBlobs(
+    ObjectIdRange ids,
+    const ObjectFetchContextPtr& /*context*/) {
+  auto data = data_.wlock();
+  data->prefetchedBlobs.insert(
+      data->prefetchedBlobs.end(), ids.begin(), ids.end());
+  return folly::unit;
+}
+
 folly::SemiFuture<BackingStore::GetBlobMetaResult>
 FakeBackingStore::getBlobMetadata(
     const ObjectId& id,
@@ -71,6 +71,13 @@ class FakeBackingStore final : public BackingStore {
       const ObjectId& id,
       const ObjectFetchContextPtr& context) override;
 
+  /**
+   * Record the ids, which can be retrieved with getPrefetchedBlobs().
+   */
+  folly::SemiFuture<folly::Unit> prefetchBlobs(
+      ObjectIdRange ids,
+      const ObjectFetchContextPtr& context) override;
+
   /**
    * Add a Blob to the backing store
    *
@@ -176,6 +183,10 @@ class FakeBackingStore final : public BackingStore {
     return data_.rlock()->metadataLookups;
   }
 
+  std::vector<ObjectId> getPrefetchedBlobs() const {
+    return data_.rlock()->prefetchedBlobs;
+  }
+
  private:
   struct Data {
     std::unordered_map<RootId, std::unique_ptr<StoredHash>> commits;
@@ -185,6 +196,7 @@ class FakeBackingStore final : public BackingStore {
     std::unordered_map<RootId, size_t> commitAccessCounts;
     std::unordered_map<ObjectId, size_t> accessCounts;
     std::vector<ObjectId> metadataLookups;
+    std::vector<ObjectId> prefetchedBlobs;
   };
 
   static Tree::container buildTreeEntries(
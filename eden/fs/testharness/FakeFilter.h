@@ -25,5 +25,15 @@ class FakeFilter final : public Filter {
       override {
     return path.view().find(filterId) != std::string::npos;
   }
+
+  /*
+   * Every path below a filtered directory contains the filter id as well.
+   */
+  FilterCoverage getCoverageForPath(
+      RelativePathPiece path,
+      folly::StringPiece filterId) override {
+    return isPathFiltered(path, filterId) ? FilterCoverage::RecursivelyFiltered
+                                          : FilterCoverage::Unknown;
+  }
 };
 } // namespace facebook::eden
@@ -0,0 +1,271 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/testharness/SyntheticBackingStore.h"
+
+#include <fmt/format.h>
+#include <folly/Conv.h>
+#include <folly/futures/Future.h>
+#include <folly/hash/Hash.h>
+#include <folly/io/IOBuf.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+#include "eden/fs/model/Blob.h"
+#include "eden/fs/model/BlobMetadata.h"
+#include "eden/fs/model/Hash.h"
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/model/TreeEntry.h"
+#include "eden/fs/utils/Throw.h"
+
+namespace facebook::eden {
+
+namespace {
+constexpr char kTreeKind = 'T';
+constexpr char kBlobKind = 'B';
+constexpr size_t kObjectIdSize = 1 + 1 + 4 + 8;
+/** Roughly what one serialized tree entry costs on the wire. */
+constexpr size_t kTreeEntryBytes = 64;
+constexpr size_t kBlobMetadataBytes = 64;
+} // namespace
+
+SyntheticBackingStore::SyntheticBackingStore(Options options)
+    : options_{options} {
+  if (options_.fanOut == 0 && options_.maxDepth > 0) {
+    throw std::invalid_argument("fanOut must be positive");
+  }
+  if (options_.minFileSize == 0 ||
+      options_.minFileSize > options_.maxFileSize) {
+    throw std::invalid_argument("invalid file size range");
+  }
+}
+
+uint64_t SyntheticBackingStore::getFileCount() const {
+  uint64_t dirs = 0;
+  uint64_t dirsAtDepth = 1;
+  for (uint8_t depth = 0; depth <= options_.maxDepth; ++depth) {
+    dirs += dirsAtDepth;
+    dirsAtDepth *= options_.fanOut;
+  }
+  return dirs * options_.filesPerDir;
+}
+
+RootId SyntheticBackingStore::parseRootId(folly::StringPiece rootId) {
+  return RootId{rootId.str()};
+}
+
+std::string SyntheticBackingStore::renderRootId(const RootId& rootId) {
+  return rootId.value();
+}
+
+ObjectId SyntheticBackingStore::parseObjectId(folly::StringPiece objectId) {
+  return ObjectId::fromHex(objectId);
+}
+
+std::string SyntheticBackingStore::renderObjectId(const ObjectId& objectId) {
+  return objectId.asHexString();
+}
+
+ObjectId SyntheticBackingStore::encode(const Node& node) {
+  std::array<uint8_t, kObjectIdSize> bytes;
+  bytes[0] = node.kind;
+  bytes[1] = node.depth;
+  std::memcpy(&bytes[2], &node.commit, sizeof(node.commit));
+  std::memcpy(&bytes[6], &node.index, sizeof(node.index));
+  return ObjectId{folly::ByteRange{bytes.data(), bytes.size()}};
+}
+
+SyntheticBackingStore::Node SyntheticBackingStore::decode(const ObjectId& id) {
+  auto bytes = id.getBytes();
+  if (bytes.size() != kObjectIdSize ||
+      (bytes[0] != kTreeKind && bytes[0] != kBlobKind)) {
+    throwf<std::domain_error>("object {} not found", id);
+  }
+  Node node;
+  node.kind = static_cast<char>(bytes[0]);
+  node.depth = bytes[1];
+  std::memcpy(&node.commit, &bytes[2], sizeof(node.commit));
+  std::memcpy(&node.index, &bytes[6], sizeof(node.index));
+  return node;
+}
+
+uint64_t SyntheticBackingStore::hashOf(
+    uint8_t depth,
+    uint64_t index,
+    uint32_t commit) const {
+  return folly::hash::hash_combine(options_.seed, depth, index, commit);
+}
+
+uint32_t SyntheticBackingStore::lastChange(
+    uint8_t depth,
+    uint64_t index,
+    uint32_t commit) const {
+  for (uint32_t candidate = commit; candidate > 1; --candidate) {
+    if (hashOf(depth, index, candidate) % 100 < options_.changedFilesPercent) {
+      return candidate;
+    }
+  }
+  return 1;
+}
+
+TreePtr SyntheticBackingStore::makeTree(const Node& node) const {
+  Tree::container entries{kPathMapDefaultCaseSensitive};
+  if (node.depth < options_.maxDepth) {
+    for (uint32_t i = 0; i < options_.fanOut; ++i) {
+      Node child{
+          kTreeKind,
+          static_cast<uint8_t>(node.depth + 1),
+          node.commit,
+          node.index * options_.fanOut + i};
+      entries.emplace(
+          PathComponent{fmt::format("dir{}", i)},
+          encode(child),
+          TreeEntryType::TREE);
+    }
+  }
+  for (uint32_t i = 0; i < options_.filesPerDir; ++i) {
+    auto fileIndex = node.index * options_.filesPerDir + i;
+    auto commit = lastChange(node.depth, fileIndex, node.commit);
+    entries.emplace(
+        PathComponent{fmt::format("file{}", i)},
+        encode(Node{kBlobKind, node.depth, commit, fileIndex}),
+        TreeEntryType::REGULAR_FILE);
+  }
+  return std::make_shared<TreePtr::element_type>(
+      std::move(entries), encode(node));
+}
+
+BlobPtr SyntheticBackingStore::makeBlob(const Node& node) const {
+  auto hash = hashOf(node.depth, node.index, node.commit);
+
+  // Log-uniform between the smallest and largest file sizes: most files are
+  // small, and a few are large.
+  auto fraction = static_cast<double>(hash >> 11) * 0x1.0p-53;
+  auto logMin = std::log(static_cast<double>(options_.minFileSize));
+  auto logMax = std::log(static_cast<double>(options_.maxFileSize));
+  auto size = static_cast<size_t>(
+      std::llround(std::exp(logMin + fraction * (logMax - logMin))));
+
+  folly::IOBuf contents{folly::IOBuf::CREATE, size};
+  auto* data = contents.writableData();
+  for (size_t offset = 0; offset < size; offset += sizeof(hash)) {
+    std::memcpy(data + offset, &hash, std::min(sizeof(hash), size - offset));
+  }
+  contents.append(size);
+  return std::make_shared<BlobPtr::element_type>(std::move(contents));
+}
+
+folly::SemiFuture<folly::Unit> SyntheticBackingStore::transfer(size_t bytes) {
+  auto now = std::chrono::steady_clock::now();
+  auto sent = now;
+  if (options_.bandwidthBytesPerSecond > 0) {
+    auto busyUntil = linkBusyUntil_.wlock();
+    auto start = std::max(now, *busyUntil);
+    sent = start +
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+               std::chrono::duration<double>(
+                   static_cast<double>(bytes) /
+                   options_.bandwidthBytesPerSecond));
+    *busyUntil = sent;
+  }
+  auto done = sent + options_.latency;
+  if (done <= now) {
+    return folly::unit;
+  }
+  return folly::futures::sleep(
+      std::chrono::duration_cast<folly::HighResDuration>(done - now));
+}
+
+ImmediateFuture<TreePtr> SyntheticBackingStore::getRootTree(
+    const RootId& rootId,
+    const ObjectFetchContextPtr& /*context*/) {
+  auto commit = folly::tryTo<uint32_t>(rootId.value());
+  if (!commit.hasValue() || commit.value() == 0) {
+    throwf<std::domain_error>("commit {} not found", rootId.value());
+  }
+  auto tree = makeTree(Node{kTreeKind, 0, commit.value(), 0});
+  auto bytes = tree->size() * kTreeEntryBytes;
+  return transfer(bytes).deferValue(
+      [tree = std::move(tree)](auto&&) mutable { return std::move(tree); });
+}
+
+ImmediateFuture<std::shared_ptr<TreeEntry>>
+SyntheticBackingStore::getTreeEntryForObjectId(
+    const ObjectId& objectId,
+    TreeEntryType treeEntryType,
+    const ObjectFetchContextPtr& /*context*/) {
+  return std::make_shared<TreeEntry>(objectId, treeEntryType);
+}
+
+folly::SemiFuture<BackingStore::GetTreeResult> SyntheticBackingStore::getTree(
+    const ObjectId& id,
+    const ObjectFetchContextPtr& /*context*/) {
+  auto node = decode(id);
+  if (node.kind != kTreeKind) {
+    throwf<std::domain_error>("{} is not a tree", id);
+  }
+  auto tree = makeTree(node);
+  auto bytes = tree->size() * kTreeEntryBytes;
+  return transfer(bytes).deferValue(
+      [tree = std::move(tree)](auto&&) mutable {
+        return GetTreeResult{
+            std::move(tree), ObjectFetchContext::FromNetworkFetch};
+      });
+}
+
+folly::SemiFuture<BackingStore::GetBlobResult> SyntheticBackingStore::getBlob(
+    const ObjectId& id,
+    const ObjectFetchContextPtr& /*context*/) {
+  auto node = decode(id);
+  if (node.kind != kBlobKind) {
+    throwf<std::domain_error>("{} is not a blob", id);
+  }
+  auto blob = makeBlob(node);
+  auto bytes = blob->getSize();
+  return transfer(bytes).deferValue(
+      [blob = std::move(blob)](auto&&) mutable {
+        return GetBlobResult{
+            std::move(blob), ObjectFetchContext::FromNetworkFetch};
+      });
+}
+
+folly::SemiFuture<BackingStore::GetBlobMetaResult>
+SyntheticBackingStore::getBlobMetadata(
+    const ObjectId& id,
+    const ObjectFetchContextPtr& /*context*/) {
+  auto node = decode(id);
+  if (node.kind != kBlobKind) {
+    throwf<std::domain_error>("{} is not a blob", id);
+  }
+  auto blob = makeBlob(node);
+  auto metadata = std::make_shared<BlobMetadataPtr::element_type>(
+      Hash20::sha1(blob->getContents()),
+      Hash32::blake3(blob->getContents()),
+      blob->getSize());
+  return transfer(kBlobMetadataBytes)
+      .deferValue([metadata = std::move(metadata)](auto&&) mutable {
+        return GetBlobMetaResult{
+            std::move(metadata), ObjectFetchContext::FromNetworkFetch};
+      });
+}
+
+folly::SemiFuture<folly::Unit> SyntheticBackingStore::prefetchBlobs(
+    ObjectIdRange ids,
+    const ObjectFetchContextPtr& /*context*/) {
+  size_t bytes = 0;
+  for (const auto& id : ids) {
+    auto node = decode(id);
+    if (node.kind == kBlobKind) {
+      bytes += makeBlob(node)->getSize();
+    }
+  }
+  return transfer(bytes);
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <chrono>
+#include <cstdint>
+
+#include "eden/fs/store/BackingStore.h"
+
+namespace facebook::eden {
+
+/**
+ * A BackingStore that generates a deterministic synthetic repository and
+ * serves it with simulated network costs, for benchmarks.
+ *
+ * The repository is a balanced tree: every directory above maxDepth has
+ * fanOut subdirectories "dirN", and every directory has filesPerDir files
+ * "fileN". File sizes follow a log-uniform distribution between minFileSize
+ * and maxFileSize. Nothing is stored: objects are generated from their IDs on
+ * demand, so repositories of any size cost no memory.
+ *
+ * Root IDs are commit numbers, starting at "1". Each commit modifies about
+ * changedFilesPercent of the files relative to the previous one, and every
+ * tree gets a new ID in every commit.
+ *
+ * Every fetch waits for its response to be transferred over a single link of
+ * bandwidthBytesPerSecond, shared by all concurrent fetches, and then for
+ * latency. Concurrent fetches pay the latency in parallel, as a batched
+ * request would.
+ */
+class SyntheticBackingStore final : public BijectiveBackingStore {
+ public:
+  struct Options {
+    uint8_t maxDepth = 3;
+    uint32_t fanOut = 8;
+    uint32_t filesPerDir = 16;
+    uint64_t minFileSize = 128;
+    uint64_t maxFileSize = 64 * 1024;
+    uint32_t changedFilesPercent = 1;
+    uint64_t seed = 0;
+
+    std::chrono::microseconds latency{0};
+    /** 0 means unlimited. */
+    uint64_t bandwidthBytesPerSecond = 0;
+  };
+
+  explicit SyntheticBackingStore(Options options);
+
+  /**
+   * The number of files in every commit of the repository.
+   */
+  uint64_t getFileCount() const;
+
+  RootId parseRootId(folly::StringPiece rootId) override;
+  std::string renderRootId(const RootId& rootId) override;
+  ObjectId parseObjectId(folly::StringPiece objectId) override;
+  std::string renderObjectId(const ObjectId& objectId) override;
+
+  ImmediateFuture<TreePtr> getRootTree(
+      const RootId& rootId,
+      const ObjectFetchContextPtr& context) override;
+  ImmediateFuture<std::shared_ptr<TreeEntry>> getTreeEntryForObjectId(
+      const ObjectId& objectId,
+      TreeEntryType treeEntryType,
+      const ObjectFetchContextPtr& context) override;
+  folly::SemiFuture<GetTreeResult> getTree(
+      const ObjectId& id,
+      const ObjectFetchContextPtr& context) override;
+  folly::SemiFuture<GetBlobResult> getBlob(
+      const ObjectId& id,
+      const ObjectFetchContextPtr& context) override;
+  folly::SemiFuture<GetBlobMetaResult> getBlobMetadata(
+      const ObjectId& id,
+      const ObjectFetchContextPtr& context) override;
+
+  /**
+   * Transfers all of the blobs as one batch, paying the latency once.
+   */
+  folly::SemiFuture<folly::Unit> prefetchBlobs(
+      ObjectIdRange ids,
+      const ObjectFetchContextPtr& context) override;
+
+  int64_t dropAllPendingRequestsFromQueue() override {
+    return 0;
+  }
+
+ private:
+  struct Node {
+    char kind;
+    uint8_t depth;
+    uint32_t commit;
+    uint64_t index;
+  };
+
+  static ObjectId encode(const Node& node);
+  static Node decode(const ObjectId& id);
+
+  /**
+   * The most recent commit, up to commit, that modified the given file.
+   */
+  uint32_t lastChange(uint8_t depth, uint64_t index, uint32_t commit) const;
+  uint64_t hashOf(uint8_t depth, uint64_t index, uint32_t commit) const;
+
+  TreePtr makeTree(const Node& node) const;
+  BlobPtr makeBlob(const Node& node) const;
+
+  /**
+   * Completes once a response of the given size has been sent.
+   */
+  folly::SemiFuture<folly::Unit> transfer(size_t bytes);
+
+  const Options options_;
+  folly::Synchronized<std::chrono::steady_clock::time_point> linkBusyUntil_;
+};
+
+} // namespace facebook::eden
@@ -279,6 +279,17 @@ void TestMount::initialize(
   initializeEdenMount();
 }
 
+void TestMount::initialize(
+    std::shared_ptr<BackingStore> backingStore,
+    const RootId& initialCommitHash) {
+  setInitialCommit(initialCommitHash);
+  createMount(
+      std::move(backingStore),
+      kDefaultInodeCatalogType,
+      kDefaultInodeCatalogOptions);
+  initializeEdenMount();
+}
+
 void TestMount::initializeEdenMount() {
   edenMount_->initialize().getVia(serverExecutor_.get());
   rootInode_ = edenMount_->getRootInodeUnchecked();
@@ -307,8 +318,15 @@ void TestMount::createMountWithoutInitializing(
 void TestMount::createMount(
     InodeCatalogType inodeCatalogType,
     InodeCatalogOptions inodeCatalogOptions) {
+  createMount(backingStore_, inodeCatalogType, inodeCatalogOptions);
+}
+
+void TestMount::createMount(
+    std::shared_ptr<BackingStore> backingStore,
+    InodeCatalogType inodeCatalogType,
+    InodeCatalogOptions inodeCatalogOptions) {
   shared_ptr<ObjectStore> objectStore = ObjectStore::create(
-      backingStore_,
+      std::move(backingStore),
       treeCache_,
       stats_.copy(),
       std::make_shared<ProcessNameCache>(),
@@ -37,6 +37,7 @@ class TemporaryDirectory;
 
 namespace facebook::eden {
 
+class BackingStore;
 class BlobCache;
 class TreeCache;
 class CheckoutConfig;
@@ -169,6 +170,18 @@ class TestMount {
       InodeCatalogType inodeCatalogType = kDefaultInodeCatalogType,
       InodeCatalogOptions inodeCatalogOptions = kDefaultInodeCatalogOptions);
   void initialize(FakeTreeBuilder& rootBuilder, bool startReady = true);
+
+  /**
+   * Initialize the mount on top of the given BackingStore instead of the
+   * FakeBackingStore, checked out at initialCommitHash.
+   *
+   * This should only be used if the TestMount was default-constructed. The
+   * helpers that populate the FakeBackingStore have no effect on such a
+   * mount, and remount() is not supported.
+   */
+  void initialize(
+      std::shared_ptr<BackingStore> backingStore,
+      const RootId& initialCommitHash);
   void initialize(
       FakeTreeBuilder& rootBuilder,
       InodeCatalogType inodeCatalogType,
@@ -394,6 +407,10 @@ class TestMount {
   void createMount(
       InodeCatalogType InodeCatalogType = kDefaultInodeCatalogType,
       InodeCatalogOptions inodeCatalogOptions = kDefaultInodeCatalogOptions);
+  void createMount(
+      std::shared_ptr<BackingStore> backingStore,
+      InodeCatalogType inodeCatalogType,
+      InodeCatalogOptions inodeCatalogOptions);
   void initTestDirectory(CaseSensitivity caseSensitivity);
   void setInitialCommit(const RootId& commitHash);
   void setInitialCommit(const RootId& commitHash, ObjectId rootTreeHash);
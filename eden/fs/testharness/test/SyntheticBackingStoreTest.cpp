@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/testharness/SyntheticBackingStore.h"
+
+#include <folly/io/IOBuf.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/model/Blob.h"
+#include "eden/fs/model/Tree.h"
+
+using namespace facebook::eden;
+
+namespace {
+
+SyntheticBackingStore::Options smallRepo() {
+  SyntheticBackingStore::Options options;
+  options.maxDepth = 1;
+  options.fanOut = 2;
+  options.filesPerDir = 4;
+  options.minFileSize = 10;
+  options.maxFileSize = 1000;
+  return options;
+}
+
+TreePtr getRootTree(SyntheticBackingStore& store, const RootId& rootId) {
+  return store.getRootTree(rootId, ObjectFetchContext::getNullContext()).get();
+}
+
+TEST(SyntheticBackingStore, generatesTheConfiguredShape) {
+  SyntheticBackingStore store{smallRepo()};
+  EXPECT_EQ(12u, store.getFileCount());
+
+  auto root = getRootTree(store, RootId{"1"});
+  EXPECT_EQ(6u, root->size());
+  auto dir = store
+                 .getTree(
+                     root->find(PathComponentPiece{"dir0"})->second.getHash(),
+                     ObjectFetchContext::getNullContext())
+                 .get()
+                 .tree;
+  EXPECT_EQ(4u, dir->size());
+
+  for (const auto& [name, entry] : *dir) {
+    auto blob =
+        store.getBlob(entry.getHash(), ObjectFetchContext::getNullContext())
+            .get()
+            .blob;
+    EXPECT_GE(blob->getSize(), 10u);
+    EXPECT_LE(blob->getSize(), 1000u);
+  }
+}
+
+TEST(SyntheticBackingStore, isDeterministic) {
+  SyntheticBackingStore first{smallRepo()};
+  SyntheticBackingStore second{smallRepo()};
+  auto root = getRootTree(first, RootId{"1"});
+  auto id = root->find(PathComponentPiece{"file0"})->second.getHash();
+  auto blob1 =
+      first.getBlob(id, ObjectFetchContext::getNullContext()).get().blob;
+  auto blob2 =
+      second.getBlob(id, ObjectFetchContext::getNullContext()).get().blob;
+  EXPECT_TRUE(
+      folly::IOBufEqualTo{}(blob1->getContents(), blob2->getContents()));
+}
+
+TEST(SyntheticBackingStore, commitsChangeTheConfiguredShareOfFiles) {
+  auto options = smallRepo();
+  options.changedFilesPercent = 0;
+  SyntheticBackingStore unchanged{options};
+  options.changedFilesPercent = 100;
+  SyntheticBackingStore allChanged{options};
+
+  auto file0 = PathComponentPiece{"file0"};
+  EXPECT_EQ(
+      getRootTree(unchanged, RootId{"1"})->find(file0)->second.getHash(),
+      getRootTree(unchanged, RootId{"2"})->find(file0)->second.getHash());
+  EXPECT_NE(
+      getRootTree(allChanged, RootId{"1"})->find(file0)->second.getHash(),
+      getRootTree(allChanged, RootId{"2"})->find(file0)->second.getHash());
+}
+
+TEST(SyntheticBackingStore, unknownObjectsAreNotFound) {
+  SyntheticBackingStore store{smallRepo()};
+  EXPECT_THROW(getRootTree(store, RootId{"0"}), std::domain_error);
+  EXPECT_THROW(
+      store.getBlob(ObjectId{"nope"}, ObjectFetchContext::getNullContext()),
+      std::domain_error);
+}
+
+} // namespace
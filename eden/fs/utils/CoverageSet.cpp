@@ -79,6 +79,29 @@ void CoverageSet::add(size_t begin, size_t end) {
   }
 }
 
+void CoverageSet::remove(size_t begin, size_t end) {
+  XCHECK_LE(begin, end)
+      << "End of interval must be greater than or equal to begin";
+  if (begin == end) {
+    return;
+  }
+
+  auto it = set_.upper_bound(Interval{begin, end});
+  if (it != set_.begin() && std::prev(it)->end > begin) {
+    --it;
+  }
+  while (it != set_.end() && it->begin < end) {
+    auto removed = *it;
+    it = set_.erase(it);
+    if (removed.begin < begin) {
+      set_.insert(it, Interval{removed.begin, begin});
+    }
+    if (end < removed.end) {
+      set_.insert(it, Interval{end, removed.end});
+    }
+  }
+}
+
 bool CoverageSet::covers(size_t begin, size_t end) const noexcept {
   XCHECK_LE(begin, end)
       << "End of interval must be greater than or equal to begin";
@@ -94,6 +117,32 @@ bool CoverageSet::covers(size_t begin, size_t end) const noexcept {
   return left->begin <= begin && end <= left->end;
 }
 
+std::vector<std::pair<size_t, size_t>> CoverageSet::getGaps(
+    size_t begin,
+    size_t end) const {
+  XCHECK_LE(begin, end)
+      << "End of interval must be greater than or equal to begin";
+  std::vector<std::pair<size_t, size_t>> gaps;
+
+  auto it = set_.upper_bound(Interval{begin, end});
+  if (it != set_.begin()) {
+    auto left = std::prev(it);
+    if (left->end > begin) {
+      begin = std::min(left->end, end);
+    }
+  }
+  while (begin < end) {
+    if (it == set_.end() || it->begin >= end) {
+      gaps.emplace_back(begin, end);
+      break;
+    }
+    gaps.emplace_back(begin, it->begin);
+    begin = it->end;
+    ++it;
+  }
+  return gaps;
+}
+
 size_t CoverageSet::getIntervalCount() const noexcept {
   return set_.size();
 }
@@ -9,6 +9,8 @@
 
 #include <cstddef>
 #include <set>
+#include <utility>
+#include <vector>
 
 namespace facebook::eden {
 
@@ -33,12 +35,25 @@ class CoverageSet {
    */
   void add(size_t begin, size_t end);
 
+  /**
+   * Removes the interval [begin, end) from the set, splitting the intervals
+   * it falls inside of.
+   */
+  void remove(size_t begin, size_t end);
+
   /**
    * Returns true if the interval [begin, end) is fully covered by the
    * previously-inserted intervals.
    */
   bool covers(size_t begin, size_t end) const noexcept;
 
+  /**
+   * Returns the maximal subintervals of [begin, end) that are not covered, in
+   * increasing order.
+   */
+  std::vector<std::pair<size_t, size_t>> getGaps(size_t begin, size_t end)
+      const;
+
   /**
    * Returns the number of intervals currently being tracked. This function is
    * primarily for tests.
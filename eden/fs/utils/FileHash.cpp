@@ -7,6 +7,7 @@
 
 #include <folly/portability/OpenSSL.h>
 #include <filesystem>
+#include <memory>
 
 #include "eden/common/utils/WinError.h"
 #include "eden/fs/digest/Blake3.h"
@@ -17,7 +18,9 @@ namespace facebook::eden {
 #ifdef _WIN32
 
 namespace {
-constexpr size_t kBufSize = 8192;
+// Read in large blocks, like OverlayFileAccess does when hashing the
+// materialized files of other platforms.
+constexpr size_t kBufSize = 256 * 1024;
 
 template <typename Hasher>
 void hash(Hasher&& hasher, AbsolutePathPiece filePath) {
@@ -65,10 +68,11 @@ void hash(Hasher&& hasher, AbsolutePathPiece filePath) {
     CloseHandle(fileHandle);
   };
 
-  uint8_t buf[kBufSize];
+  // Not zeroed: most files are much smaller than the buffer.
+  std::unique_ptr<uint8_t[]> buf{new uint8_t[kBufSize]};
   while (true) {
     DWORD bytesRead;
-    if (!ReadFile(fileHandle, buf, sizeof(buf), &bytesRead, nullptr)) {
+    if (!ReadFile(fileHandle, buf.get(), kBufSize, &bytesRead, nullptr)) {
       throw makeWin32ErrorExplicit(
           GetLastError(),
           fmt::format(
@@ -79,7 +83,7 @@ void hash(Hasher&& hasher, AbsolutePathPiece filePath) {
       break;
     }
 
-    hasher(buf, bytesRead);
+    hasher(buf.get(), bytesRead);
   }
 }
 } // namespace
@@ -89,7 +93,9 @@ Hash32 getFileBlake3(
     const std::optional<std::string>& maybeBlake3Key) {
   auto hasher = Blake3::create(maybeBlake3Key);
   hash(
-      [&hasher](const auto* buf, auto len) { hasher.update(buf, len); },
+      [&hasher](const auto* buf, auto len) {
+        hasher.updateParallel(buf, len);
+      },
       filePath);
   static_assert(Hash32::RAW_SIZE == BLAKE3_OUT_LEN);
   Hash32 blake3;
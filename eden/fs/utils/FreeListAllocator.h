@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include <folly/CPortability.h>
+#include <folly/Indestructible.h>
+
+namespace facebook::eden {
+
+/**
+ * Allocates blocks of kSize bytes aligned to kAlign, recycling freed blocks
+ * instead of handing each of them back to malloc.
+ *
+ * Each thread caches up to 2 * kBatchSize freed blocks, from which it serves
+ * its own allocations without any synchronization. When a thread frees more
+ * than that, a batch of kBatchSize blocks moves to a shared depot, and a
+ * thread whose cache runs dry takes a whole batch from there. This matters
+ * for inodes, which are allocated by the threads loading them but freed by
+ * the one unloading them.
+ *
+ * The depot holds at most kMaxDepotBatches batches. Blocks that don't fit go
+ * back to malloc, so unloading many inodes at once still releases memory.
+ *
+ * Sanitized builds always use malloc, so that use-after-free bugs on these
+ * blocks remain detectable.
+ */
+template <size_t kSize, size_t kAlign = alignof(std::max_align_t)>
+class FreeListAllocator {
+ public:
+  static constexpr size_t kBatchSize = 64;
+  static constexpr size_t kMaxDepotBatches = 256;
+
+  static void* allocate() {
+#ifndef FOLLY_SANITIZE
+    auto& cache = localCache();
+    if (!cache.head) {
+      cache.refill();
+    }
+    if (auto* node = cache.head) {
+      cache.head = node->next;
+      --cache.count;
+      return node;
+    }
+#endif
+    return allocateFromMalloc();
+  }
+
+  static void deallocate(void* block) noexcept {
+#ifndef FOLLY_SANITIZE
+    auto& cache = localCache();
+    if (cache.count == 2 * kBatchSize) {
+      cache.spill();
+    }
+    auto* node = static_cast<Node*>(block);
+    node->next = cache.head;
+    cache.head = node;
+    ++cache.count;
+#else
+    freeToMalloc(block);
+#endif
+  }
+
+ private:
+  static_assert(kSize >= sizeof(void*));
+
+  struct Node {
+    Node* next;
+  };
+
+  static void* allocateFromMalloc() {
+    if constexpr (kAlign > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+      return ::operator new(kSize, std::align_val_t{kAlign});
+    } else {
+      return ::operator new(kSize);
+    }
+  }
+
+  static void freeToMalloc(void* block) noexcept {
+    if constexpr (kAlign > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+      ::operator delete(block, std::align_val_t{kAlign});
+    } else {
+      ::operator delete(block);
+    }
+  }
+
+  static void freeListToMalloc(Node* head) noexcept {
+    while (head) {
+      auto* next = head->next;
+      freeToMalloc(head);
+      head = next;
+    }
+  }
+
+  /** Batches of exactly kBatchSize blocks, shared by all threads. */
+  struct Depot {
+    Depot() {
+      batches.reserve(kMaxDepotBatches);
+    }
+
+    std::mutex mutex;
+    std::vector<Node*> batches;
+  };
+
+  static Depot& depot() {
+    // Never destroyed: objects freed by thread-local or static destructors
+    // can still spill into it during shutdown.
+    static folly::Indestructible<Depot> depot;
+    return *depot;
+  }
+
+  struct Cache {
+    ~Cache() {
+      freeListToMalloc(head);
+    }
+
+    void refill() {
+      auto& shared = depot();
+      std::lock_guard lock{shared.mutex};
+      if (!shared.batches.empty()) {
+        head = shared.batches.back();
+        count = kBatchSize;
+        shared.batches.pop_back();
+      }
+    }
+
+    void spill() noexcept {
+      auto* batch = head;
+      auto* last = head;
+      for (size_t i = 1; i < kBatchSize; ++i) {
+        last = last->next;
+      }
+      head = last->next;
+      last->next = nullptr;
+      count -= kBatchSize;
+
+      auto& shared = depot();
+      {
+        std::lock_guard lock{shared.mutex};
+        if (shared.batches.size() < kMaxDepotBatches) {
+          shared.batches.push_back(batch);
+          return;
+        }
+      }
+      freeListToMalloc(batch);
+    }
+
+    Node* head{nullptr};
+    size_t count{0};
+  };
+
+  static Cache& localCache() {
+    static thread_local Cache cache;
+    return cache;
+  }
+};
+
+/**
+ * Gives T, by inheritance, class-specific operator new and delete that use a
+ * FreeListAllocator. Subclasses of T, whose objects are larger, fall back to
+ * the global operators.
+ */
+template <typename T>
+class FreeListAllocated {
+ public:
+  static void* operator new(size_t size) {
+    if (size != sizeof(T)) {
+      return ::operator new(size);
+    }
+    return FreeListAllocator<sizeof(T), alignof(T)>::allocate();
+  }
+
+  static void operator delete(void* block, size_t size) noexcept {
+    if (size != sizeof(T)) {
+      ::operator delete(block);
+      return;
+    }
+    FreeListAllocator<sizeof(T), alignof(T)>::deallocate(block);
+  }
+};
+
+} // namespace facebook::eden
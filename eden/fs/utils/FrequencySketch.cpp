@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/FrequencySketch.h"
+
+#include <folly/Bits.h>
+#include <folly/hash/Hash.h>
+#include <algorithm>
+
+namespace facebook::eden {
+
+namespace {
+constexpr size_t kMinimumWidth = 64;
+constexpr size_t kMaximumWidth = size_t{1} << 24;
+} // namespace
+
+FrequencySketch::FrequencySketch(size_t expectedEntries) {
+  auto width = folly::nextPowTwo(
+      std::clamp(expectedEntries, kMinimumWidth, kMaximumWidth));
+  counters_.resize(width * kRows);
+  mask_ = width - 1;
+  sampleSize_ = width * 10;
+}
+
+size_t FrequencySketch::indexOf(uint64_t mixed, size_t row) const noexcept {
+  // Double hashing: derive each row's index from both halves of one mixed
+  // hash rather than hashing the key kRows times.
+  auto h = (mixed & 0xffffffff) + row * ((mixed >> 32) | 1);
+  return row * width() + (h & mask_);
+}
+
+void FrequencySketch::record(uint64_t hash) noexcept {
+  if (counters_.empty()) {
+    return;
+  }
+  auto mixed = folly::hash::twang_mix64(hash);
+  bool incremented = false;
+  for (size_t row = 0; row < kRows; ++row) {
+    auto& counter = counters_[indexOf(mixed, row)];
+    if (counter < kMaxFrequency) {
+      ++counter;
+      incremented = true;
+    }
+  }
+  if (incremented && ++additions_ >= sampleSize_) {
+    age();
+  }
+}
+
+uint8_t FrequencySketch::estimate(uint64_t hash) const noexcept {
+  if (counters_.empty()) {
+    return 0;
+  }
+  auto mixed = folly::hash::twang_mix64(hash);
+  uint8_t result = kMaxFrequency;
+  for (size_t row = 0; row < kRows; ++row) {
+    result = std::min(result, counters_[indexOf(mixed, row)]);
+  }
+  return result;
+}
+
+void FrequencySketch::clear() noexcept {
+  std::fill(counters_.begin(), counters_.end(), 0);
+  additions_ = 0;
+}
+
+void FrequencySketch::age() noexcept {
+  for (auto& counter : counters_) {
+    counter >>= 1;
+  }
+  additions_ /= 2;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace facebook::eden {
+
+/**
+ * Approximate, aging access-frequency counter, as used by TinyLFU cache
+ * admission policies.
+ *
+ * This is a count-min sketch with 4 rows of 4-bit saturating counters. Once
+ * the number of recorded accesses reaches 10x the sketch width, every counter
+ * is halved so that the estimated frequencies favor recent history over
+ * ancient history.
+ *
+ * Estimates never under-count (until aged) but may over-count due to hash
+ * collisions. The sketch costs 4 bytes per unit of width, so it remains small
+ * compared to the objects whose popularity it tracks.
+ *
+ * Not synchronized.
+ */
+class FrequencySketch {
+ public:
+  static constexpr uint8_t kMaxFrequency = 15;
+
+  /**
+   * Creates an empty sketch that tracks nothing: record() is a no-op and
+   * estimate() always returns 0.
+   */
+  FrequencySketch() = default;
+
+  /**
+   * Creates a sketch sized to track approximately expectedEntries distinct
+   * keys.
+   */
+  explicit FrequencySketch(size_t expectedEntries);
+
+  /**
+   * Records one access to the key with the given hash.
+   */
+  void record(uint64_t hash) noexcept;
+
+  /**
+   * Returns the estimated number of recent accesses to the key with the given
+   * hash, in [0, kMaxFrequency].
+   */
+  uint8_t estimate(uint64_t hash) const noexcept;
+
+  /**
+   * Forgets all recorded accesses.
+   */
+  void clear() noexcept;
+
+  /**
+   * Returns the number of counters per row.
+   */
+  size_t width() const noexcept {
+    return mask_ + 1;
+  }
+
+ private:
+  static constexpr size_t kRows = 4;
+
+  size_t indexOf(uint64_t mixed, size_t row) const noexcept;
+
+  /**
+   * Halves every counter.
+   */
+  void age() noexcept;
+
+  std::vector<uint8_t> counters_;
+  size_t mask_{0};
+  size_t additions_{0};
+  size_t sampleSize_{0};
+};
+
+} // namespace facebook::eden
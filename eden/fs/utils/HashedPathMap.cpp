@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/HashedPathMap.h"
+
+#include <folly/hash/Hash.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define EDEN_PATH_MAP_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define EDEN_PATH_MAP_NEON 1
+#endif
+
+namespace facebook::eden::detail {
+
+uint32_t hashPathComponent(
+    PathComponentPiece name,
+    CaseSensitivity caseSensitive) noexcept {
+  // FNV-1a, folding ASCII case like folly::AsciiCaseInsensitive when the
+  // names are compared insensitively.
+  uint64_t hash = 0xcbf29ce484222325;
+  for (unsigned char c : name.view()) {
+    if (caseSensitive == CaseSensitivity::Insensitive && c >= 'A' &&
+        c <= 'Z') {
+      c += 'a' - 'A';
+    }
+    hash = (hash ^ c) * 0x100000001b3;
+  }
+  return folly::hash::twang_32from64(hash);
+}
+
+void PathComponentIndex::clear() noexcept {
+  groups_ = 0;
+  ctrl_ = {};
+  positions_ = {};
+}
+
+size_t PathComponentIndex::getSizeBytes() const {
+  return folly::goodMallocSize(ctrl_.capacity()) +
+      folly::goodMallocSize(positions_.capacity() * sizeof(uint32_t));
+}
+
+void PathComponentIndex::rebuild(const std::vector<uint32_t>& hashes) {
+  // Keep the load factor under 7/8, so that every probe sequence ends in an
+  // empty slot, and shrink the table when it is mostly empty.
+  size_t groups = 1;
+  while (groups * kGroupSize * 7 / 8 < hashes.size() + 1) {
+    groups *= 2;
+  }
+  if (groups > groups_ || groups * 4 <= groups_) {
+    groups_ = groups;
+  }
+  ctrl_.assign(groups_ * kGroupSize, kEmpty);
+  positions_.resize(groups_ * kGroupSize);
+  for (size_t position = 0; position < hashes.size(); ++position) {
+    place(hashes[position], position);
+  }
+}
+
+void PathComponentIndex::append(const std::vector<uint32_t>& hashes) {
+  if (hashes.size() + 1 > groups_ * kGroupSize * 7 / 8) {
+    rebuild(hashes);
+    return;
+  }
+  place(hashes.back(), hashes.size() - 1);
+}
+
+void PathComponentIndex::place(uint32_t hash, uint32_t position) {
+  auto group = hash & (groups_ - 1);
+  while (true) {
+    auto* ctrl = &ctrl_[group * kGroupSize];
+    if (auto mask = matchByte(ctrl, kEmpty)) {
+      auto slot = group * kGroupSize + folly::findFirstSet(mask) - 1;
+      ctrl_[slot] = tagOf(hash);
+      positions_[slot] = position;
+      return;
+    }
+    group = (group + 1) & (groups_ - 1);
+  }
+}
+
+uint32_t PathComponentIndex::matchByte(
+    const uint8_t* group,
+    uint8_t byte) noexcept {
+#if defined(EDEN_PATH_MAP_SSE2)
+  auto ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+  auto matches = _mm_cmpeq_epi8(ctrl, _mm_set1_epi8(static_cast<char>(byte)));
+  return static_cast<uint32_t>(_mm_movemask_epi8(matches));
+#elif defined(EDEN_PATH_MAP_NEON)
+  // NEON has no movemask: weight each matching byte by its bit in its half,
+  // and add up each half.
+  static const uint8_t kBits[kGroupSize] = {
+      1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+  auto matches = vceqq_u8(vld1q_u8(group), vdupq_n_u8(byte));
+  auto bits = vandq_u8(matches, vld1q_u8(kBits));
+  return vaddv_u8(vget_low_u8(bits)) | (vaddv_u8(vget_high_u8(bits)) << 8);
+#else
+  uint32_t mask = 0;
+  for (size_t i = 0; i < kGroupSize; ++i) {
+    mask |= uint32_t{group[i] == byte} << i;
+  }
+  return mask;
+#endif
+}
+
+} // namespace facebook::eden::detail
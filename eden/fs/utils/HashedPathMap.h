@@ -0,0 +1,394 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+#include <folly/FBVector.h>
+#include <folly/lang/Bits.h>
+#include <folly/memory/Malloc.h>
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include "eden/fs/utils/CaseSensitivity.h"
+#include "eden/fs/utils/PathFuncs.h"
+#include "eden/fs/utils/Throw.h"
+
+namespace facebook::eden {
+
+namespace detail {
+
+/**
+ * Hash a path component such that names that are equal with the given case
+ * sensitivity have the same hash.
+ */
+uint32_t hashPathComponent(
+    PathComponentPiece name,
+    CaseSensitivity caseSensitive) noexcept;
+
+/**
+ * An open addressing hash table from name hashes to positions in a vector, in
+ * the style of Swiss tables: every slot has a control byte holding 7 bits of
+ * the hash, and lookups compare a group of 16 control bytes at once (with
+ * SSE2 or NEON where available) before looking at any name.
+ */
+class PathComponentIndex {
+ public:
+  static constexpr size_t kNotFound = ~size_t{0};
+
+  bool empty() const {
+    return groups_ == 0;
+  }
+
+  /** Free the table. */
+  void clear() noexcept;
+
+  /** Heap memory used by the table. */
+  size_t getSizeBytes() const;
+
+  /**
+   * Index hashes[i] at position i for all i, replacing the current contents.
+   */
+  void rebuild(const std::vector<uint32_t>& hashes);
+
+  /**
+   * Index the last element of hashes, whose other elements are already
+   * indexed.
+   */
+  void append(const std::vector<uint32_t>& hashes);
+
+  /**
+   * Returns the first position indexed with the given hash for which
+   * matches(position) is true, or kNotFound.
+   */
+  template <typename Matches>
+  size_t find(uint32_t hash, Matches&& matches) const {
+    if (empty()) {
+      return kNotFound;
+    }
+    auto tag = tagOf(hash);
+    auto group = hash & (groups_ - 1);
+    for (size_t probes = 0; probes < groups_; ++probes) {
+      const auto* ctrl = &ctrl_[group * kGroupSize];
+      for (auto mask = matchByte(ctrl, tag); mask != 0; mask &= mask - 1) {
+        auto slot = group * kGroupSize + folly::findFirstSet(mask) - 1;
+        if (matches(positions_[slot])) {
+          return positions_[slot];
+        }
+      }
+      // The probe sequence for a hash never skips an empty slot.
+      if (matchByte(ctrl, kEmpty) != 0) {
+        break;
+      }
+      group = (group + 1) & (groups_ - 1);
+    }
+    return kNotFound;
+  }
+
+ private:
+  static constexpr size_t kGroupSize = 16;
+  static constexpr uint8_t kEmpty = 0x80;
+
+  static uint8_t tagOf(uint32_t hash) {
+    return hash >> 25;
+  }
+
+  /** Returns a mask with bit i set if group[i] == byte. */
+  static uint32_t matchByte(const uint8_t* group, uint8_t byte) noexcept;
+
+  /** Store position in the first empty slot of the hash's probe sequence. */
+  void place(uint32_t hash, uint32_t position);
+
+  // Number of groups of kGroupSize slots: 0 or a power of two.
+  size_t groups_{0};
+  std::vector<uint8_t> ctrl_;
+  std::vector<uint32_t> positions_;
+};
+
+} // namespace detail
+
+/**
+ * An alternative to PathMap<Value> for maps that are mostly looked up by
+ * name, like directory contents.
+ *
+ * Entries are still kept in a sorted vector, so iteration is ordered and
+ * iterators are the same as PathMap's, but the hash of each name is kept in
+ * a separate dense array. Maps with more than kIndexThreshold entries
+ * also maintain a Swiss table style index of those hashes, so that find(),
+ * and insert() of an existing name, compare a couple of names instead of
+ * the log(n) of a binary search. Smaller maps scan the hash array.
+ *
+ * Inserting a new name still moves the entries after it, and re-indexes the
+ * map unless it is appended at the end. Erasing re-indexes the map. As with
+ * PathMap, inserts and erases invalidate iterators.
+ */
+template <typename Value>
+class HashedPathMap
+    : private folly::fbvector<std::pair<PathComponent, Value>> {
+  using Key = PathComponent;
+  using Pair = std::pair<Key, Value>;
+  using Vector = folly::fbvector<Pair>;
+  using Piece = PathComponentPiece;
+
+ public:
+  using key_type = Key;
+  using mapped_type = Value;
+  using value_type = typename Vector::value_type;
+  using allocator_type = typename Vector::allocator_type;
+  using reference = Pair&;
+  using const_reference = const Pair&;
+  using iterator = typename Vector::iterator;
+  using const_iterator = typename Vector::const_iterator;
+  using size_type = typename Vector::size_type;
+  using difference_type = typename Vector::difference_type;
+  using pointer = Pair*;
+  using const_pointer = const Pair*;
+  using reverse_iterator = typename Vector::reverse_iterator;
+  using const_reverse_iterator = typename Vector::const_reverse_iterator;
+
+  /** Maps up to this size are searched without the index. */
+  static constexpr size_t kIndexThreshold = 16;
+
+  explicit HashedPathMap(CaseSensitivity caseSensitive)
+      : caseSensitive_{caseSensitive} {}
+
+  HashedPathMap(
+      std::initializer_list<value_type> init,
+      CaseSensitivity caseSensitive)
+      : HashedPathMap(caseSensitive) {
+    reserve(init.size());
+    for (const auto& value : init) {
+      insert(value);
+    }
+  }
+
+  HashedPathMap(const HashedPathMap&) = default;
+  HashedPathMap& operator=(const HashedPathMap&) = default;
+  HashedPathMap(HashedPathMap&&) = default;
+  HashedPathMap& operator=(HashedPathMap&&) = default;
+
+  using Vector::begin;
+  using Vector::capacity;
+  using Vector::cbegin;
+  using Vector::cend;
+  using Vector::crbegin;
+  using Vector::crend;
+  using Vector::empty;
+  using Vector::end;
+  using Vector::max_size;
+  using Vector::rbegin;
+  using Vector::rend;
+  using Vector::size;
+
+  void clear() noexcept {
+    Vector::clear();
+    hashes_.clear();
+    index_.clear();
+  }
+
+  void reserve(size_type capacity) {
+    Vector::reserve(capacity);
+    hashes_.reserve(capacity);
+  }
+
+  void swap(HashedPathMap& other) noexcept {
+    Vector::swap(other);
+    hashes_.swap(other.hashes_);
+    std::swap(index_, other.index_);
+    std::swap(caseSensitive_, other.caseSensitive_);
+  }
+
+  /** Binary search for the first entry not ordered before key. */
+  iterator lower_bound(Piece key) {
+    return begin() + lowerBoundPosition(key);
+  }
+
+  const_iterator lower_bound(Piece key) const {
+    return begin() + lowerBoundPosition(key);
+  }
+
+  iterator find(Piece key) {
+    return begin() + findPosition(key, hash(key));
+  }
+
+  const_iterator find(Piece key) const {
+    return begin() + findPosition(key, hash(key));
+  }
+
+  /** Insert a new key-value pair, leaving an existing key unaltered. */
+  std::pair<iterator, bool> insert(const value_type& val) {
+    auto keyHash = hash(val.first);
+    auto position = findPosition(val.first, keyHash);
+    if (position != size()) {
+      return std::make_pair(begin() + position, false);
+    }
+    return std::make_pair(
+        insertAt(insertPosition(val.first), keyHash, val), true);
+  }
+
+  /**
+   * Construct a value in place from args if key is not present. Returns the
+   * position for key and whether an insert took place.
+   */
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Piece key, Args&&... args) {
+    auto keyHash = hash(key);
+    auto position = findPosition(key, keyHash);
+    if (position != size()) {
+      return std::make_pair(begin() + position, false);
+    }
+    auto iter = insertAt(
+        insertPosition(key),
+        keyHash,
+        std::make_pair(Key(key), Value(std::forward<Args>(args)...)));
+    return std::make_pair(iter, true);
+  }
+
+  mapped_type& operator[](Piece key) {
+    return emplace(key).first->second;
+  }
+
+  const mapped_type& operator[](Piece key) const {
+    return at(key);
+  }
+
+  mapped_type& at(Piece key) {
+    auto iter = find(key);
+    if (iter == end()) {
+      throwf<std::out_of_range>("no such key {}", key);
+    }
+    return iter->second;
+  }
+
+  const mapped_type& at(Piece key) const {
+    auto iter = find(key);
+    if (iter == end()) {
+      throwf<std::out_of_range>("no such key {}", key);
+    }
+    return iter->second;
+  }
+
+  iterator erase(const_iterator pos) {
+    return erase(pos, pos + 1);
+  }
+
+  iterator erase(const_iterator first, const_iterator last) {
+    auto firstPosition = first - cbegin();
+    auto lastPosition = last - cbegin();
+    auto iter = Vector::erase(first, last);
+    hashes_.erase(
+        hashes_.begin() + firstPosition, hashes_.begin() + lastPosition);
+    reindex();
+    return iter;
+  }
+
+  /** Erase the value associated with key, returning 1 if there was one. */
+  size_type erase(Piece key) {
+    auto iter = find(key);
+    if (iter == end()) {
+      return 0;
+    }
+    erase(iter);
+    return 1;
+  }
+
+  size_type count(Piece key) const {
+    return find(key) != end();
+  }
+
+  CaseSensitivity getCaseSensitivity() const {
+    return caseSensitive_;
+  }
+
+  /**
+   * Heap memory used in addition to the vector of entries, for the hashes and
+   * the index.
+   */
+  size_t getIndexSizeBytes() const {
+    return folly::goodMallocSize(hashes_.capacity() * sizeof(uint32_t)) +
+        index_.getSizeBytes();
+  }
+
+  friend bool operator==(const HashedPathMap& lhs, const HashedPathMap& rhs) {
+    return static_cast<const Vector&>(lhs) == static_cast<const Vector&>(rhs);
+  }
+
+  friend bool operator!=(const HashedPathMap& lhs, const HashedPathMap& rhs) {
+    return !(lhs == rhs);
+  }
+
+ private:
+  uint32_t hash(Piece key) const {
+    return detail::hashPathComponent(key, caseSensitive_);
+  }
+
+  size_t lowerBoundPosition(Piece key) const {
+    auto iter = std::lower_bound(
+        begin(), end(), key, [this](const Pair& entry, Piece value) {
+          return isPathPieceLess(Piece(entry.first), value, caseSensitive_);
+        });
+    return iter - begin();
+  }
+
+  /** Where to insert key, which is not present. */
+  size_t insertPosition(Piece key) const {
+    // Maps are often built from sorted data: check for an append first.
+    if (empty() ||
+        isPathPieceLess(Piece(rbegin()->first), key, caseSensitive_)) {
+      return size();
+    }
+    return lowerBoundPosition(key);
+  }
+
+  /** Returns the position of key, or size() if it is not present. */
+  size_t findPosition(Piece key, uint32_t keyHash) const {
+    auto matches = [&](size_t position) {
+      return isPathPieceEqual(
+          Piece(begin()[position].first), key, caseSensitive_);
+    };
+    if (!index_.empty()) {
+      auto position = index_.find(keyHash, matches);
+      return position == detail::PathComponentIndex::kNotFound ? size()
+                                                               : position;
+    }
+    for (size_t position = 0; position < hashes_.size(); ++position) {
+      if (hashes_[position] == keyHash && matches(position)) {
+        return position;
+      }
+    }
+    return size();
+  }
+
+  template <typename Arg>
+  iterator insertAt(size_t position, uint32_t keyHash, Arg&& arg) {
+    // Make sure that inserting into hashes_ cannot throw once the entry is
+    // in place.
+    hashes_.reserve(hashes_.size() + 1);
+    auto iter = Vector::emplace(begin() + position, std::forward<Arg>(arg));
+    hashes_.insert(hashes_.begin() + position, keyHash);
+    if (position + 1 == size() && !index_.empty()) {
+      index_.append(hashes_);
+    } else {
+      reindex();
+    }
+    return iter;
+  }
+
+  void reindex() {
+    if (size() > kIndexThreshold) {
+      index_.rebuild(hashes_);
+    } else {
+      index_.clear();
+    }
+  }
+
+  // hashes_[i] is the hash of the key of the i-th entry.
+  std::vector<uint32_t> hashes_;
+  // Empty for maps of up to kIndexThreshold entries.
+  detail::PathComponentIndex index_;
+  CaseSensitivity caseSensitive_;
+};
+
+} // namespace facebook::eden
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <folly/lang/Assume.h>
+#include <utility>
 
 namespace facebook::eden {
 
@@ -25,6 +26,12 @@ void ImmediateFuture<T>::destroy() {
       break;
     case Kind::Nothing:
       break;
+#if FOLLY_HAS_COROUTINES
+    case Kind::Coroutine:
+      kind_ = Kind::Nothing;
+      coro_.destroy();
+      break;
+#endif
   }
 }
 
@@ -91,6 +98,13 @@ ImmediateFuture<T>::ImmediateFuture(ImmediateFuture&& other) noexcept {
     case Kind::Nothing:
       kind_ = Kind::Nothing;
       break;
+#if FOLLY_HAS_COROUTINES
+    case Kind::Coroutine:
+      new (&coro_) CoroutineHandle{other.coro_};
+      kind_ = Kind::Coroutine;
+      other.kind_ = Kind::Nothing;
+      break;
+#endif
   }
 }
 
@@ -117,10 +131,45 @@ ImmediateFuture<T>& ImmediateFuture<T>::operator=(
       break;
     case Kind::Nothing:
       break;
+#if FOLLY_HAS_COROUTINES
+    case Kind::Coroutine:
+      new (&coro_) CoroutineHandle{other.coro_};
+      kind_ = Kind::Coroutine;
+      other.kind_ = Kind::Nothing;
+      break;
+#endif
   }
   return *this;
 }
 
+#if FOLLY_HAS_COROUTINES
+template <typename T>
+ImmediateFuture<T>::ImmediateFuture(CoroutineHandle coro) noexcept
+    : kind_{Kind::Coroutine} {
+  new (&coro_) CoroutineHandle{coro};
+}
+
+template <typename T>
+void ImmediateFuture<T>::settleCoroutine() {
+  auto& promise = coro_.promise();
+  if (coro_.done()) {
+    auto result = std::move(promise.result());
+    *this = ImmediateFuture{std::move(result)};
+    return;
+  }
+
+  // The coroutine frame is owned by the continuation resuming it, and is thus
+  // destroyed with it if the awaited future is never completed.
+  auto awaited = promise.takeAwaited();
+  *this = ImmediateFuture<folly::Unit>{std::move(awaited)}.thenTry(
+      [coroutine = std::move(*this)](folly::Try<folly::Unit>&&) mutable {
+        coroutine.coro_.resume();
+        coroutine.settleCoroutine();
+        return std::move(coroutine);
+      });
+}
+#endif
+
 namespace detail {
 template <typename Func, typename... Args>
 ImmediateFuture<detail::continuation_result_t<Func, Args...>>
@@ -215,6 +264,13 @@ bool ImmediateFuture<T>::isReady() const {
       return false;
     case Kind::Nothing:
       throw folly::FutureInvalid{};
+#if FOLLY_HAS_COROUTINES
+    case Kind::Coroutine:
+      if (detail::kImmediateFutureAlwaysDefer) {
+        return false;
+      }
+      return coro_.done();
+#endif
   }
   folly::assume_unreachable();
 }
@@ -252,6 +308,11 @@ T ImmediateFuture<T>::get() && {
       return std::move(semi_).get();
     case Kind::Nothing:
       throw folly::FutureInvalid();
+#if FOLLY_HAS_COROUTINES
+    case Kind::Coroutine:
+      settleCoroutine();
+      return std::move(*this).get();
+#endif
   }
   folly::assume_unreachable();
 }
@@ -266,6 +327,11 @@ folly::Try<T> ImmediateFuture<T>::getTry() && {
       return std::move(semi_).getTry();
     case Kind::Nothing:
       throw folly::FutureInvalid();
+#if FOLLY_HAS_COROUTINES
+    case Kind::Coroutine:
+      settleCoroutine();
+      return std::move(*this).getTry();
+#endif
   }
   folly::assume_unreachable();
 }
@@ -280,6 +346,11 @@ T ImmediateFuture<T>::get(folly::HighResDuration timeout) && {
       return std::move(semi_).get(timeout);
     case Kind::Nothing:
       throw folly::FutureInvalid();
+#if FOLLY_HAS_COROUTINES
+    case Kind::Coroutine:
+      settleCoroutine();
+      return std::move(*this).get(timeout);
+#endif
   }
   folly::assume_unreachable();
 }
@@ -294,6 +365,11 @@ folly::Try<T> ImmediateFuture<T>::getTry(folly::HighResDuration timeout) && {
       return std::move(semi_).getTry(timeout);
     case Kind::Nothing:
       throw folly::FutureInvalid();
+#if FOLLY_HAS_COROUTINES
+    case Kind::Coroutine:
+      settleCoroutine();
+      return std::move(*this).getTry(timeout);
+#endif
   }
   folly::assume_unreachable();
 }
@@ -308,6 +384,11 @@ folly::SemiFuture<T> ImmediateFuture<T>::semi() && {
       return std::move(semi_);
     case Kind::Nothing:
       throw folly::FutureInvalid();
+#if FOLLY_HAS_COROUTINES
+    case Kind::Coroutine:
+      settleCoroutine();
+      return std::move(*this).semi();
+#endif
   }
   folly::assume_unreachable();
 }
@@ -442,4 +523,136 @@ collectAllSafe(Fs&&... fs) {
                  res) { return unwrapTryTuple(std::move(res)); });
 }
 
+#if FOLLY_HAS_COROUTINES
+namespace detail {
+
+/**
+ * The result of co_await'ing an ImmediateFuture in a coroutine returning an
+ * ImmediateFuture.
+ */
+template <typename T>
+class ImmediateAwaiter {
+ public:
+  explicit ImmediateAwaiter(ImmediateFuture<T>&& future) noexcept
+      : future_{std::move(future)} {}
+
+  bool await_ready() {
+    if (!future_.isReady()) {
+      return false;
+    }
+    result_ = std::move(future_).getTry();
+    return true;
+  }
+
+  template <typename Promise>
+  void await_suspend(folly::coro::coroutine_handle<Promise> coro) {
+    // The awaiter lives in the coroutine frame, which outlives the returned
+    // SemiFuture: ImmediateFuture::settleCoroutine resumes the coroutine once
+    // it completes.
+    coro.promise().setAwaited(std::move(future_).semi().defer(
+        [this](folly::Try<T>&& result) { result_ = std::move(result); }));
+  }
+
+  T await_resume() {
+    return std::move(result_).value();
+  }
+
+ private:
+  ImmediateFuture<T> future_;
+  folly::Try<T> result_;
+};
+
+/**
+ * The parts of ImmediatePromise which don't depend on the coroutine's return
+ * type.
+ */
+class ImmediatePromiseBase {
+ public:
+  // The coroutine starts running on the calling thread, and the
+  // ImmediateFuture it returns owns its frame until it completes.
+  folly::coro::suspend_never initial_suspend() noexcept {
+    return {};
+  }
+  folly::coro::suspend_always final_suspend() noexcept {
+    return {};
+  }
+
+  template <typename U>
+  ImmediateAwaiter<U> await_transform(ImmediateFuture<U>&& future) noexcept {
+    return ImmediateAwaiter<U>{std::move(future)};
+  }
+  template <typename U>
+  ImmediateAwaiter<U> await_transform(folly::SemiFuture<U>&& future) noexcept {
+    return ImmediateAwaiter<U>{std::move(future)};
+  }
+  template <typename U>
+  ImmediateAwaiter<U> await_transform(folly::Future<U>&& future) noexcept {
+    return ImmediateAwaiter<U>{std::move(future)};
+  }
+
+  /**
+   * Set the future the coroutine is suspended on. It completes once the
+   * coroutine can be resumed.
+   */
+  void setAwaited(folly::SemiFuture<folly::Unit> awaited) noexcept {
+    awaited_ = std::move(awaited);
+  }
+
+  folly::SemiFuture<folly::Unit> takeAwaited() noexcept {
+    return std::exchange(
+        awaited_, folly::SemiFuture<folly::Unit>::makeEmpty());
+  }
+
+ private:
+  folly::SemiFuture<folly::Unit> awaited_{
+      folly::SemiFuture<folly::Unit>::makeEmpty()};
+};
+
+template <typename T>
+class ImmediatePromiseReturn : public ImmediatePromiseBase {
+ public:
+  template <typename U = T>
+  void return_value(U&& value) {
+    result_.emplace(std::forward<U>(value));
+  }
+
+ protected:
+  folly::Try<T> result_;
+};
+
+template <>
+class ImmediatePromiseReturn<folly::Unit> : public ImmediatePromiseBase {
+ public:
+  void return_void() {
+    result_.emplace();
+  }
+
+ protected:
+  folly::Try<folly::Unit> result_;
+};
+
+/**
+ * The promise_type of the coroutines returning an ImmediateFuture<T>.
+ */
+template <typename T>
+class ImmediatePromise : public ImmediatePromiseReturn<T> {
+ public:
+  ImmediateFuture<T> get_return_object() noexcept {
+    return ImmediateFuture<T>{
+        folly::coro::coroutine_handle<ImmediatePromise>::from_promise(*this)};
+  }
+
+  void unhandled_exception() noexcept {
+    this->result_ =
+        folly::Try<T>{folly::exception_wrapper{std::current_exception()}};
+  }
+
+  folly::Try<T>& result() noexcept {
+    return this->result_;
+  }
+};
+
+} // namespace detail
+#endif
+
 } // namespace facebook::eden
@@ -7,8 +7,12 @@
 
 #pragma once
 
+#include <folly/Portability.h>
 #include <folly/Try.h>
 #include <folly/futures/Future.h>
+#if FOLLY_HAS_COROUTINES
+#include <folly/experimental/coro/Coroutine.h>
+#endif
 
 namespace facebook::eden {
 
@@ -78,5 +82,10 @@ using continuation_result_t = typename continuation_result<
 constexpr bool kImmediateFutureAlwaysDefer =
     folly::kIsDebug || folly::kIsSanitize;
 
+#if FOLLY_HAS_COROUTINES
+template <typename T>
+class ImmediatePromise;
+#endif
+
 } // namespace detail
 } // namespace facebook::eden
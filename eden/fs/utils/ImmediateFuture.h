@@ -30,7 +30,23 @@ namespace facebook::eden {
  *
  * When detail::kImmediateFutureAlwaysDefer is set, all ImmediateFuture
  * constructor are pessimized to behave as if constructed from a non-ready
- * SemiFuture.
+ * SemiFuture. *
+ * A function returning an ImmediateFuture can be a coroutine, which co_await's
+ * ImmediateFuture, SemiFuture and Future:
+ *
+ *   ImmediateFuture<size_t> countEntries(InodeNumber ino) {
+ *     auto tree = co_await inodeMap->lookupTreeInode(ino);
+ *     co_return tree->getContents().rlock()->entries.size();
+ *   }
+ *
+ * The coroutine runs eagerly, on the calling thread, until it awaits a future
+ * that isn't ready. If it completes then, the returned ImmediateFuture holds
+ * its value like an immediate one, and no SemiFuture is allocated: a chain of
+ * co_await's only allocates the coroutine frame, where the same chain of
+ * thenValue() allocates a SemiFuture at each step once one is not ready.
+ * Otherwise, the rest of the coroutine runs as a continuation of the awaited
+ * future: like any other continuation, once the returned ImmediateFuture is
+ * consumed and on the executor the SemiFuture chain is scheduled on.
  */
 template <typename T>
 class ImmediateFuture {
@@ -57,6 +73,13 @@ class ImmediateFuture {
    */
   using value_type = T;
 
+#if FOLLY_HAS_COROUTINES
+  /**
+   * Allows functions returning an ImmediateFuture to be coroutines.
+   */
+  using promise_type = detail::ImmediatePromise<T>;
+#endif
+
   /**
    * To match Future and SemiFuture, the default constructor is deleted.
    * In-place construction should use the std::in_place constructor.
@@ -311,6 +334,24 @@ class ImmediateFuture {
 
   friend ImmediateFuture<folly::Unit> makeNotReadyImmediateFuture();
 
+#if FOLLY_HAS_COROUTINES
+  using CoroutineHandle = folly::coro::coroutine_handle<promise_type>;
+
+  friend promise_type;
+
+  /**
+   * Take ownership of the frame of a coroutine returning this future.
+   */
+  explicit ImmediateFuture(CoroutineHandle coro) noexcept;
+
+  /**
+   * Replace the coroutine held by this future with its result if it has
+   * completed, or with a SemiFuture that resumes it once the future it awaits
+   * is ready otherwise.
+   */
+  void settleCoroutine();
+#endif
+
   /**
    * Clear this ImmediateFuture's contents, marking it empty.
    *
@@ -328,6 +369,10 @@ class ImmediateFuture {
     LazySemiFuture,
     /** Doesn't hold anything, neither immediate_ nor semi_ are valid. */
     Nothing,
+#if FOLLY_HAS_COROUTINES
+    /** Holds a coroutine, which is suspended or completed, coro_ is valid. */
+    Coroutine,
+#endif
   };
 
   // TODO: At the cost of reimplementing parts of Try, we could save a byte or
@@ -338,6 +383,9 @@ class ImmediateFuture {
   union {
     Try immediate_;
     SemiFuture semi_;
+#if FOLLY_HAS_COROUTINES
+    CoroutineHandle coro_;
+#endif
   };
 };
 
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+
+#include <folly/CancellationToken.h>
+#include <folly/Synchronized.h>
+#include <folly/futures/SharedPromise.h>
+
+#include "eden/fs/utils/ImmediateFuture.h"
+
+namespace facebook::eden {
+
+/**
+ * Shares the result of an asynchronous computation among the callers that
+ * ask for the same key while it is running.
+ *
+ * The first caller for a key runs the computation; callers that arrive
+ * before it completes wait for its result instead of starting their own.
+ * Nothing is kept once the computation completes, so the key must capture
+ * everything the result depends on. This is not a cache.
+ *
+ * If the computation fails with folly::OperationCancelled, the callers that
+ * joined it start over, since only the first caller asked for the
+ * cancellation.
+ *
+ * The deduplicator must outlive the futures returned by getOrCompute().
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class InFlightDeduplicator {
+ public:
+  using ValuePtr = std::shared_ptr<const Value>;
+
+  /**
+   * Returns the result of the computation running for key, or runs
+   * compute(), which must return an ImmediateFuture<Value>, if there is none.
+   */
+  template <typename Func>
+  ImmediateFuture<ValuePtr> getOrCompute(const Key& key, Func compute) {
+    auto promise = std::make_shared<folly::SharedPromise<ValuePtr>>();
+    {
+      auto inFlight = inFlight_.wlock();
+      auto [it, inserted] = inFlight->running.try_emplace(key, promise);
+      if (!inserted) {
+        ++inFlight->joined;
+        return ImmediateFuture<ValuePtr>{it->second->getSemiFuture()}.thenTry(
+            [this, key, compute = std::move(compute)](
+                folly::Try<ValuePtr>&& result) mutable
+            -> ImmediateFuture<ValuePtr> {
+              if (result.template hasException<folly::OperationCancelled>()) {
+                return getOrCompute(key, std::move(compute));
+              }
+              return std::move(result);
+            });
+      }
+    }
+
+    return makeImmediateFutureWith(std::move(compute))
+        .thenTry([this, key, promise](folly::Try<Value>&& result) {
+          folly::Try<ValuePtr> shared;
+          if (result.hasException()) {
+            shared.emplaceException(std::move(result).exception());
+          } else {
+            shared.emplace(std::make_shared<const Value>(
+                std::move(result).value()));
+          }
+          // Erase before fulfilling, so that a caller woken up by the
+          // promise never finds the completed computation.
+          inFlight_.wlock()->running.erase(key);
+          promise->setTry(folly::Try<ValuePtr>{shared});
+          return shared;
+        });
+  }
+
+  /**
+   * The number of computations currently running.
+   */
+  size_t inFlight() const {
+    return inFlight_.rlock()->running.size();
+  }
+
+  /**
+   * The number of calls that waited for another caller's computation instead
+   * of running their own.
+   */
+  uint64_t joined() const {
+    return inFlight_.rlock()->joined;
+  }
+
+ private:
+  struct State {
+    std::unordered_map<
+        Key,
+        std::shared_ptr<folly::SharedPromise<ValuePtr>>,
+        Hash>
+        running;
+    uint64_t joined = 0;
+  };
+
+  folly::Synchronized<State> inFlight_;
+};
+
+} // namespace facebook::eden
@@ -38,6 +38,76 @@ inline size_t roundUpToNonzeroPageSize(size_t s) {
   return std::max(kPageSize, (s + kPageSize - 1) & ~(kPageSize - 1));
 }
 
+/**
+ * Minimum address space reserved for a mapping, so that small files can grow
+ * for a while without being moved. Reserving address space costs no memory.
+ */
+constexpr size_t kMinReservationBytes = 64 * 1024 * 1024;
+
+/**
+ * Address space to reserve for a mapping of mapSize bytes: the mapping can
+ * grow in place until it doubles in size.
+ */
+inline size_t reservationFor(size_t mapSize) {
+  return std::max(kMinReservationBytes, 2 * mapSize);
+}
+
+/**
+ * Reserve size bytes of address space, without any memory or file behind it.
+ */
+inline void* reserveAddressSpace(size_t size) {
+  auto addr = mmap(
+      nullptr,
+      size,
+      PROT_NONE,
+      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+      -1,
+      0);
+  if (addr == MAP_FAILED) {
+    folly::throwSystemError(
+        "failed to reserve ", size, " bytes of address space");
+  }
+  return addr;
+}
+
+/**
+ * Map [offset, offset + size) of fd at addr + offset, which must be inside a
+ * reservation.
+ *
+ * offset only needs to be a multiple of kPageSize: it is rounded down to the
+ * system page size, remapping the start of the range if needed.
+ */
+inline void mapFileAt(
+    void* addr,
+    int fd,
+    size_t offset,
+    size_t size,
+    bool populate = false) {
+  static const size_t systemPageSize = sysconf(_SC_PAGESIZE);
+  size_t alignedOffset = offset - offset % systemPageSize;
+  auto map = mmap(
+      static_cast<char*>(addr) + alignedOffset,
+      offset + size - alignedOffset,
+      PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_FIXED
+#ifdef MAP_POPULATE
+          | (populate ? MAP_POPULATE : 0)
+#endif
+          ,
+      fd,
+      alignedOffset);
+  if (map == MAP_FAILED) {
+    folly::throwSystemError(
+        "mmap failed mapping ", size, " bytes at offset ", offset);
+  }
+#ifndef MAP_POPULATE
+  if (populate) {
+    // Best effort: start reading the file in without waiting for it.
+    madvise(map, offset + size - alignedOffset, MADV_WILLNEED);
+  }
+#endif
+}
+
 /**
  * Enforce required properties of
  */
@@ -83,6 +153,12 @@ struct Migrator;
  * responsible for synchronization. It is safe for multiple threads to
  * simultaneously read, however.
  *
+ * The file is mapped at the start of a larger range of reserved address
+ * space, and grows by mapping its new pages right after the existing ones.
+ * Entries therefore keep their address, and the pages already faulted in
+ * stay mapped, until the file outgrows the reservation. The reservation then
+ * doubles, moving the mapping, so this happens a logarithmic number of times.
+ *
  * While alive, MappedDiskVector does acquire an exclusive flock on the
  * underlying fd to avoid multiple processes manipulating it at the same time.
  *
@@ -246,16 +322,18 @@ class MappedDiskVector {
     end_ = other.end_;
     map_ = other.map_;
     mapSizeInBytes_ = other.mapSizeInBytes_;
+    reservedBytes_ = other.reservedBytes_;
 
     other.begin_ = nullptr;
     other.end_ = nullptr;
     other.map_ = nullptr;
     other.mapSizeInBytes_ = 0;
+    other.reservedBytes_ = 0;
   }
 
   MappedDiskVector& operator=(MappedDiskVector&& other) {
     if (map_) {
-      munmap(map_, mapSizeInBytes_);
+      munmap(map_, reservedBytes_);
     }
 
     file_ = std::move(other.file_);
@@ -263,16 +341,19 @@ class MappedDiskVector {
     end_ = other.end_;
     map_ = other.map_;
     mapSizeInBytes_ = other.mapSizeInBytes_;
+    reservedBytes_ = other.reservedBytes_;
 
     other.begin_ = nullptr;
     other.end_ = nullptr;
     other.map_ = nullptr;
     other.mapSizeInBytes_ = 0;
+    other.reservedBytes_ = 0;
+    return *this;
   }
 
   ~MappedDiskVector() {
     if (map_) {
-      munmap(map_, mapSizeInBytes_);
+      munmap(map_, reservedBytes_);
     }
   }
 
@@ -285,6 +366,14 @@ class MappedDiskVector {
     return (mapSizeInBytes_ - sizeof(Header)) / sizeof(T);
   }
 
+  /**
+   * The number of entries the vector can hold before its entries move to a
+   * new address.
+   */
+  size_t reservedCapacity() const {
+    return (reservedBytes_ - sizeof(Header)) / sizeof(T);
+  }
+
   T& operator[](size_t index) {
     return begin_[index];
   }
@@ -311,33 +400,29 @@ class MappedDiskVector {
         folly::throwSystemError("ftruncateNoInt failed when growing capacity");
       }
 
-#ifdef __APPLE__
-      auto newMap = mmap(
-          nullptr,
-          newFileSize,
-          PROT_READ | PROT_WRITE,
-          MAP_SHARED,
-          file_.fd(),
-          0);
-#else
-      auto newMap = mremap(map_, mapSizeInBytes_, newFileSize, MREMAP_MAYMOVE);
-#endif
-      if (newMap == MAP_FAILED) {
-        folly::throwSystemError(folly::to<std::string>(
-            "mremap failed when growing capacity from ",
+      if (newFileSize <= reservedBytes_) {
+        // Map the new pages after the existing ones, leaving those alone.
+        detail::mapFileAt(
+            map_,
+            file_.fd(),
             mapSizeInBytes_,
-            " to ",
-            newFileSize));
+            newFileSize - mapSizeInBytes_);
+      } else {
+        auto reservedBytes = detail::reservationFor(newFileSize);
+        auto newMap = detail::reserveAddressSpace(reservedBytes);
+        try {
+          detail::mapFileAt(newMap, file_.fd(), 0, newFileSize);
+        } catch (const std::exception&) {
+          munmap(newMap, reservedBytes);
+          throw;
+        }
+        munmap(map_, reservedBytes_);
+        map_ = newMap;
+        reservedBytes_ = reservedBytes;
+        begin_ = reinterpret_cast<T*>(static_cast<Header*>(newMap) + 1);
+        end_ = begin_ + oldSize;
       }
-
-#ifdef __APPLE__
-      munmap(map_, mapSizeInBytes_);
-#endif
-      map_ = newMap;
       mapSizeInBytes_ = newFileSize;
-
-      begin_ = reinterpret_cast<T*>(static_cast<Header*>(newMap) + 1);
-      end_ = begin_ + oldSize;
     }
 
     T* out = end_;
@@ -355,6 +440,50 @@ class MappedDiskVector {
     --header().entryCount;
   }
 
+  /**
+   * The file never shrinks as entries are removed. Give back the space of
+   * removed entries once more than two rounds of growth are unused, keeping
+   * one round of headroom so that alternating inserts and removals don't
+   * resize the file every time.
+   *
+   * Returns whether the file was shrunk. Pointers to the remaining entries
+   * stay valid.
+   */
+  bool releaseUnusedCapacity() {
+    constexpr size_t kGrowthBytes = GROWTH_IN_PAGES * detail::kPageSize;
+    size_t usedBytes = sizeof(Header) + size() * sizeof(T);
+    if (mapSizeInBytes_ - usedBytes <= 2 * kGrowthBytes) {
+      return false;
+    }
+
+    // Keep the size a multiple of the growth, like emplace_back() does, so
+    // that the tail starts on a system page boundary even when system pages
+    // are larger than kPageSize.
+    size_t newFileSize =
+        ((usedBytes + kGrowthBytes) / kGrowthBytes + 1) * kGrowthBytes;
+    XCHECK_LT(newFileSize, mapSizeInBytes_);
+
+    // Unmap the tail before truncating the file: accessing a mapping past the
+    // end of its file raises SIGBUS. Map reserved address space in its place,
+    // so that the file can grow back in place.
+    if (MAP_FAILED ==
+        mmap(
+            static_cast<char*>(map_) + newFileSize,
+            mapSizeInBytes_ - newFileSize,
+            PROT_NONE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED,
+            -1,
+            0)) {
+      folly::throwSystemError("mmap failed when releasing capacity");
+    }
+    mapSizeInBytes_ = newFileSize;
+
+    if (-1 == folly::ftruncateNoInt(file_.fd(), newFileSize)) {
+      folly::throwSystemError("ftruncateNoInt failed when releasing capacity");
+    }
+    return true;
+  }
+
   T& front() {
     XDCHECK_GT(end_, begin_);
     return begin_[0];
@@ -439,32 +568,22 @@ class MappedDiskVector {
       }
     }
 
-    // Call readahead() here?  Offer it as optional functionality?
-    // InodeTable needs to traverse every record immediately after opening.
-
-    auto map = mmap(
-        0,
-        desiredSize,
-        PROT_READ | PROT_WRITE,
-        MAP_SHARED
-#ifdef MAP_POPULATE
-            | (populate ? MAP_POPULATE : 0)
-#endif
-            ,
-        file_.fd(),
-        0);
-    if (map == MAP_FAILED) {
-      folly::throwSystemError("mmap failed on file open");
+    // InodeTable traverses every record immediately after opening, so it asks
+    // for the whole file to be read in up front.
+    auto reservedBytes = detail::reservationFor(desiredSize);
+    auto map = detail::reserveAddressSpace(reservedBytes);
+    try {
+      detail::mapFileAt(map, file_.fd(), 0, desiredSize, populate);
+    } catch (const std::exception&) {
+      munmap(map, reservedBytes);
+      throw;
     }
 
-#ifndef MAP_POPULATE
-    (void)populate;
-#endif
-
     // Throw no exceptions between assigning the fields.
 
     map_ = map;
     mapSizeInBytes_ = desiredSize;
+    reservedBytes_ = reservedBytes;
     static_assert(
         alignof(Header) >= alignof(T),
         "T must not have stricter alignment requirements than Header");
@@ -517,8 +636,10 @@ class MappedDiskVector {
   T* begin_{nullptr};
   T* end_{nullptr};
 
+  // The start of the reserved address space, where the file is mapped.
   void* map_{nullptr};
   size_t mapSizeInBytes_{0}; // must be nonzero, multiple of page size
+  size_t reservedBytes_{0}; // at least mapSizeInBytes_
 
   folly::File file_;
 
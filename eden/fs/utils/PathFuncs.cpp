@@ -11,6 +11,7 @@
 #include <boost/filesystem/path.hpp>
 
 #include <folly/Exception.h>
+#include <folly/lang/Bits.h>
 #include <folly/logging/xlog.h>
 #include <folly/portability/Stdlib.h>
 #include <folly/portability/Unistd.h>
@@ -22,10 +23,129 @@
 #include <mach-o/dyld.h> // @manual
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define EDEN_PATH_SSE2 1
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define EDEN_PATH_NEON 1
+#endif
+
 using folly::Expected;
 
 namespace facebook::eden {
 
+namespace detail {
+
+namespace {
+
+#if defined(EDEN_PATH_SSE2)
+constexpr size_t kChunkSize = 16;
+// Bits of the match mask per byte of the chunk.
+constexpr unsigned kBitsPerByte = 1;
+
+/**
+ * Returns a mask with kBitsPerByte bits set for each of the kChunkSize bytes
+ * at p that is one of Cs.
+ */
+template <char... Cs>
+uint64_t matchMask(const char* p) {
+  auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  auto matches = _mm_setzero_si128();
+  ((matches = _mm_or_si128(matches, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(Cs)))),
+   ...);
+  return static_cast<uint32_t>(_mm_movemask_epi8(matches));
+}
+#elif defined(EDEN_PATH_NEON)
+constexpr size_t kChunkSize = 16;
+constexpr unsigned kBitsPerByte = 4;
+
+template <char... Cs>
+uint64_t matchMask(const char* p) {
+  auto chunk = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+  auto matches = vdupq_n_u8(0);
+  ((matches = vorrq_u8(matches, vceqq_u8(chunk, vdupq_n_u8(Cs)))), ...);
+  // NEON has no movemask: narrowing each 16-bit lane by 4 bits keeps a nibble
+  // per byte.
+  auto nibbles = vshrn_n_u16(vreinterpretq_u16_u8(matches), 4);
+  return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0);
+}
+#else
+constexpr size_t kChunkSize = 0;
+#endif
+
+template <char... Cs>
+bool isAny(char c) {
+  return ((c == Cs) || ...);
+}
+
+template <char... Cs>
+const char* findAny(const char* begin, const char* end) {
+#if defined(EDEN_PATH_SSE2) || defined(EDEN_PATH_NEON)
+  for (; end - begin >= static_cast<ptrdiff_t>(kChunkSize);
+       begin += kChunkSize) {
+    if (auto mask = matchMask<Cs...>(begin)) {
+      return begin + (folly::findFirstSet(mask) - 1) / kBitsPerByte;
+    }
+  }
+#endif
+  for (; begin != end; ++begin) {
+    if (isAny<Cs...>(*begin)) {
+      return begin;
+    }
+  }
+  return end;
+}
+
+template <char... Cs>
+const char* rfindAny(const char* begin, const char* end) {
+#if defined(EDEN_PATH_SSE2) || defined(EDEN_PATH_NEON)
+  for (; end - begin >= static_cast<ptrdiff_t>(kChunkSize);
+       end -= kChunkSize) {
+    if (auto mask = matchMask<Cs...>(end - kChunkSize)) {
+      return end - kChunkSize + (folly::findLastSet(mask) - 1) / kBitsPerByte;
+    }
+  }
+#endif
+  while (end != begin) {
+    --end;
+    if (isAny<Cs...>(*end)) {
+      return end;
+    }
+  }
+  return nullptr;
+}
+
+} // namespace
+
+const char* findPathSeparator(const char* begin, const char* end) noexcept {
+  if constexpr (folly::kIsWindows) {
+    return findAny<kDirSeparator, kWinDirSeparator>(begin, end);
+  } else {
+    return findAny<kDirSeparator>(begin, end);
+  }
+}
+
+const char* rfindPathSeparator(const char* begin, const char* end) noexcept {
+  if constexpr (folly::kIsWindows) {
+    return rfindAny<kDirSeparator, kWinDirSeparator>(begin, end);
+  } else {
+    return rfindAny<kDirSeparator>(begin, end);
+  }
+}
+
+const char* findPathSeparatorOrNul(
+    const char* begin,
+    const char* end) noexcept {
+  if constexpr (folly::kIsWindows) {
+    return findAny<kDirSeparator, kWinDirSeparator, '\0'>(begin, end);
+  } else {
+    return findAny<kDirSeparator, '\0'>(begin, end);
+  }
+}
+
+} // namespace detail
+
 std::string_view dirname(std::string_view path) {
   auto dirSeparator = detail::rfindPathSeparator(path);
 
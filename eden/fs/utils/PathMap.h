@@ -215,6 +215,19 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
     return std::make_pair(Vector::insert(iter, val), true);
   }
 
+  /** Insert a new key-value pair, moving it into the map.
+   * If the key already exists, it is left unaltered and val isn't moved
+   * from. Returns the same as the copying insert. */
+  std::pair<iterator, bool> insert(value_type&& val) {
+    auto iter = lower_bound(val.first);
+
+    if (iter != end() && !compare_(val.first, iter->first)) {
+      return std::make_pair(iter, false);
+    }
+
+    return std::make_pair(Vector::insert(iter, std::move(val)), true);
+  }
+
   /** Emplace a new key-value pair by constructing it in-place.
    * If the key already exists, it is left unaltered.
    * If an insertion happens, the args are forwarded to the Value
@@ -223,7 +236,11 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
    * a boolean that is true if an insert took place. */
   template <typename... Args>
   std::pair<iterator, bool> emplace(Piece key, Args&&... args) {
-    auto iter = lower_bound(key);
+    // Deserialized trees are mostly in order already, so check for an append
+    // before searching.
+    auto iter = Vector::empty() || compare_(Vector::back(), key)
+        ? end()
+        : lower_bound(key);
 
     if (iter != end() && !compare_(key, iter->first)) {
       // Found it; leave it alone
@@ -237,6 +237,53 @@ std::optional<size_t> calculatePrivateBytes() {
 #endif
 }
 
+std::vector<ThreadState> readThreadStates() {
+  std::vector<ThreadState> threads;
+#ifdef __linux__
+  auto taskDir = canonicalPath("/proc/self/task");
+  auto tids = getAllDirectoryEntryNames(taskDir);
+  if (tids.hasException()) {
+    XLOGF(
+        DBG2, "failed to list threads: {}", tids.exception().what().c_str());
+    return threads;
+  }
+  threads.reserve(tids->size());
+  for (const auto& tid : *tids) {
+    ThreadState thread;
+    auto parsedTid = folly::tryTo<pid_t>(tid.view());
+    if (!parsedTid) {
+      continue;
+    }
+    thread.tid = *parsedTid;
+    // Threads may exit while they are listed.
+    auto stat = readFile(taskDir + tid + "stat"_pc);
+    if (stat.hasException() || !parseThreadStat(*stat, thread)) {
+      continue;
+    }
+    auto waitChannel = readFile(taskDir + tid + "wchan"_pc);
+    if (waitChannel.hasValue() && *waitChannel != "0") {
+      thread.waitChannel = std::move(*waitChannel);
+    }
+    threads.push_back(std::move(thread));
+  }
+#endif
+  return threads;
+}
+
+bool parseThreadStat(StringPiece data, ThreadState& thread) {
+  // The name is between parentheses and may contain anything, including
+  // spaces and parentheses, so look for the last closing one.
+  auto nameStart = data.find('(');
+  auto nameEnd = data.rfind(')');
+  if (nameStart == StringPiece::npos || nameEnd == StringPiece::npos ||
+      nameEnd < nameStart || nameEnd + 2 >= data.size()) {
+    return false;
+  }
+  thread.name = data.subpiece(nameStart + 1, nameEnd - nameStart - 1).str();
+  thread.state = data[nameEnd + 2];
+  return true;
+}
+
 ProcessList readProcessIdsForPath(FOLLY_MAYBE_UNUSED const AbsolutePath& path) {
   ProcessList pids;
 #ifdef __APPLE__
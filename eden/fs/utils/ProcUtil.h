@@ -122,6 +122,33 @@ std::optional<size_t> calculatePrivateBytes(
 
 #endif
 
+/**
+ * What a thread of the current process is doing, as reported by the kernel.
+ */
+struct ThreadState {
+  pid_t tid = 0;
+  std::string name;
+  /// The state letter of /proc/<pid>/stat, like R for running, S for sleeping
+  /// or D for an uninterruptible wait, such as on I/O.
+  char state = '?';
+  /// The kernel function the thread is waiting in, if it is waiting.
+  std::string waitChannel;
+};
+
+/**
+ * Read the state of every thread of the current process.
+ *
+ * Only implemented on Linux, returns an empty list elsewhere or if /proc can't
+ * be read.
+ */
+std::vector<ThreadState> readThreadStates();
+
+/**
+ * Parse the contents of a /proc/<pid>/stat file, filling the name and state
+ * of the thread. Returns false if it is malformed.
+ */
+bool parseThreadStat(folly::StringPiece data, ThreadState& thread);
+
 /**
  * Stores a list of process IDs.
  */
@@ -11,6 +11,7 @@
 #include <folly/MapUtil.h>
 #include <folly/MicroLock.h>
 #include <folly/ThreadLocal.h>
+#include <folly/chrono/Clock.h>
 
 #include "eden/common/utils/ProcessNameCache.h"
 
@@ -33,12 +34,10 @@ struct ThreadLocalBucket {
       pid_t pid,
       ProcessAccessLog::AccessType type) {
     auto state = state_.lock();
-
-    // isNewPid must be initialized because BucketedLog::add will not call
-    // Bucket::add if secondsSinceStart is too old and the sample is dropped.
-    // (In that case, it's unnecessary to record the process name.)
     bool isNewPid = false;
-    state->buckets.add(secondsSinceStart, pid, isNewPid, type);
+    if (auto* counts = getCounts(*state, secondsSinceStart, pid, isNewPid)) {
+      (*counts)[type]++;
+    }
     return isNewPid;
   }
 
@@ -47,9 +46,10 @@ struct ThreadLocalBucket {
       pid_t pid,
       std::chrono::nanoseconds duration) {
     auto state = state_.lock();
-
     bool isNewPid = false;
-    state->buckets.add(secondsSinceStart, pid, isNewPid, duration);
+    if (auto* counts = getCounts(*state, secondsSinceStart, pid, isNewPid)) {
+      counts->duration += duration;
+    }
     return isNewPid;
   }
 
@@ -61,6 +61,7 @@ struct ThreadLocalBucket {
     state->owner->state_.withWLock(
         [&](auto& ownerState) { ownerState.buckets.merge(state->buckets); });
     state->buckets.clear();
+    state->lastCounts = nullptr;
   }
 
   void clearOwnerIfMe(ProcessAccessLog* owner) {
@@ -87,8 +88,46 @@ struct ThreadLocalBucket {
     explicit State(ProcessAccessLog* pal) : owner{pal} {}
     ProcessAccessLog::Buckets buckets;
     ProcessAccessLog* owner;
+
+    /**
+     * The counts of the pid of the previous access, which is very likely to
+     * be the pid of the next one: a process usually issues bursts of
+     * requests. Only valid during lastSecond, as the bucket it's in is
+     * cleared when the window moves past it, and reset when the buckets are
+     * cleared.
+     */
+    ProcessAccessLog::PerBucketAccessCounts* lastCounts = nullptr;
+    uint64_t lastSecond = 0;
+    pid_t lastPid = 0;
   };
 
+  /**
+   * Returns the counts of pid in the bucket of secondsSinceStart, or nullptr
+   * if that second is too old to be recorded.
+   */
+  static ProcessAccessLog::PerBucketAccessCounts* getCounts(
+      State& state,
+      uint64_t secondsSinceStart,
+      pid_t pid,
+      bool& isNewPid) {
+    if (state.lastCounts && state.lastSecond == secondsSinceStart &&
+        state.lastPid == pid) {
+      return state.lastCounts;
+    }
+
+    // counts must be initialized because BucketedLog::add will not call
+    // Bucket::add if secondsSinceStart is too old and the sample is dropped.
+    // (In that case, it's unnecessary to record the process name.)
+    ProcessAccessLog::PerBucketAccessCounts* counts = nullptr;
+    state.buckets.add(secondsSinceStart, pid, isNewPid, counts);
+    if (counts) {
+      state.lastCounts = counts;
+      state.lastSecond = secondsSinceStart;
+      state.lastPid = pid;
+    }
+    return counts;
+  }
+
   folly::Synchronized<State, folly::MicroLock> state_;
 };
 
@@ -104,19 +143,10 @@ void ProcessAccessLog::Bucket::clear() {
 void ProcessAccessLog::Bucket::add(
     pid_t pid,
     bool& isNewPid,
-    ProcessAccessLog::AccessType type) {
-  auto [it, contains] = accessCountsByPid.emplace(pid, PerBucketAccessCounts{});
-  it->second[type]++;
-  isNewPid = contains;
-}
-
-void ProcessAccessLog::Bucket::add(
-    pid_t pid,
-    bool& isNewPid,
-    std::chrono::nanoseconds duration) {
-  auto [it, contains] = accessCountsByPid.emplace(pid, PerBucketAccessCounts{});
-  it->second.duration += duration;
-  isNewPid = contains;
+    PerBucketAccessCounts*& counts) {
+  auto [it, inserted] = accessCountsByPid.emplace(pid, PerBucketAccessCounts{});
+  isNewPid = inserted;
+  counts = &it->second;
 }
 
 void ProcessAccessLog::Bucket::merge(const Bucket& other) {
@@ -152,8 +182,10 @@ ThreadLocalBucket* ProcessAccessLog::getTlb() {
 }
 
 uint64_t ProcessAccessLog::getSecondsSinceEpoch() {
+  // Only whole seconds are needed, which the coarse clock gives more cheaply:
+  // it's read on every access.
   return std::chrono::duration_cast<std::chrono::seconds>(
-             std::chrono::steady_clock::now().time_since_epoch())
+             folly::chrono::coarse_steady_clock::now().time_since_epoch())
       .count();
 }
 
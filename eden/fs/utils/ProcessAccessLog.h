@@ -80,8 +80,11 @@ class ProcessAccessLog {
   // Data for one second.
   struct Bucket {
     void clear();
-    void add(pid_t pid, bool& isNew, AccessType type);
-    void add(pid_t pid, bool& isNew, std::chrono::nanoseconds duration);
+    /**
+     * Find or insert the counts of pid, setting isNew to whether they were
+     * inserted. The pointer stays valid until the bucket is cleared.
+     */
+    void add(pid_t pid, bool& isNew, PerBucketAccessCounts*& counts);
     void merge(const Bucket& other);
 
     std::unordered_map<pid_t, PerBucketAccessCounts> accessCountsByPid;
@@ -30,6 +30,11 @@
 #include <sys/wait.h>
 #endif
 
+#if defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29))
+#define EDEN_HAVE_SPAWN_ADDCHDIR 1
+#endif
+
 using folly::checkPosixError;
 using namespace std::chrono_literals;
 
@@ -466,18 +471,25 @@ SpawnedProcess::SpawnedProcess(
   // Reset signals to default for the child process
   posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGDEF);
 
-  // We make a copy because posix_spawnp requires that the argv be non-const.
-  // In addition, if combining chdir and executablePath we need to modify the
-  // argv array.
-  std::vector<std::string> argStrings = args;
+  // Only used when a shell has to change the working directory of the child,
+  // otherwise argv points directly into args.
+  std::vector<std::string> shellArgs;
+  const std::vector<std::string>* argStrings = &args;
 
   if (options.cwd_.has_value()) {
+#ifdef EDEN_HAVE_SPAWN_ADDCHDIR
+    // glibc 2.29 added posix_spawn_file_actions_addchdir_np(), which spares
+    // us from running a shell for every spawn that changes directory.
+    checkPosixError(
+        posix_spawn_file_actions_addchdir_np(&actions, options.cwd_->c_str()),
+        "posix_spawn_file_actions_addchdir_np");
+#else
     // There isn't a portably defined way to inform posix_spawn to use an
     // alternate cwd.
     //
     // Solaris 11.3 lead the way with posix_spawn_file_actions_addchdir_np(3C).
-    // glibc added support for this same function in 2.29, but that isn't yet
-    // in wide circulation.  macOS doesn't have any functions for this.
+    // glibc added support for this same function in 2.29, which is used above
+    // when available.  macOS doesn't have any functions for this.
     //
     // Instead, the recommendation for a multi-threaded program is to spawn a
     // helper child process that will perform the chdir and then exec the final
@@ -487,44 +499,46 @@ SpawnedProcess::SpawnedProcess(
     std::string shellCommand =
         "cd " + folly::shellQuote(options.cwd_->view()) + " && exec";
 
-    if (options.execPath_.has_value()) {
-      // When using the shell for chdir, we need to jump through a couple
-      // more hoops for ARGV0 munging.
-      // We're setting some environment variables to persuade zsh and bash
-      // to change argv0 to our desired value.
-      // Modern versions of both of those shells accept `exec -a argv0`,
-      // but that behavior isn't defined by posix and since we use `/bin/sh`
-      // we can't rely on anything other than the baseline bourne shell
-      // behavior.
-      options.environment().set("ARGV0", argStrings[0]);
-      options.environment().set("BASH_ARGV0", argStrings[0]);
-      // Explicitly exec the intended executable path
-      argStrings[0] = options.execPath_->c_str();
-
-      // Clear the argv0 override for posix_spawnp as we're doing it in the
-      // shell and if we leave this set, we'd run execPath instead of /bin/sh
-      // and that isn't at all what we want.
-      options.execPath_ = std::nullopt;
-    }
-
-    for (auto& word : argStrings) {
+    for (size_t i = 0; i < args.size(); ++i) {
+      std::string_view word = args[i];
+      if (i == 0 && options.execPath_.has_value()) {
+        // When using the shell for chdir, we need to jump through a couple
+        // more hoops for ARGV0 munging.
+        // We're setting some environment variables to persuade zsh and bash
+        // to change argv0 to our desired value.
+        // Modern versions of both of those shells accept `exec -a argv0`,
+        // but that behavior isn't defined by posix and since we use `/bin/sh`
+        // we can't rely on anything other than the baseline bourne shell
+        // behavior.
+        options.environment().set("ARGV0", args[0]);
+        options.environment().set("BASH_ARGV0", args[0]);
+        // Explicitly exec the intended executable path
+        word = options.execPath_->view();
+      }
       shellCommand.push_back(' ');
       shellCommand.append(folly::shellQuote(word));
     }
 
+    // Clear the argv0 override for posix_spawnp as we're doing it in the
+    // shell and if we leave this set, we'd run execPath instead of /bin/sh
+    // and that isn't at all what we want.
+    options.execPath_ = std::nullopt;
+
     XLOG(DBG6) << "will run : " << shellCommand;
 
-    argStrings.clear();
-    argStrings.emplace_back("/bin/sh");
-    argStrings.emplace_back("-c");
-    argStrings.emplace_back(std::move(shellCommand));
+    shellArgs.emplace_back("/bin/sh");
+    shellArgs.emplace_back("-c");
+    shellArgs.emplace_back(std::move(shellCommand));
+    argStrings = &shellArgs;
+#endif
   }
 
+  // posix_spawnp takes a non-const argv, but doesn't modify it.
   std::vector<char*> argv;
-  argv.reserve(argStrings.size() + 1);
-  for (auto& a : argStrings) {
+  argv.reserve(argStrings->size() + 1);
+  for (const auto& a : *argStrings) {
     XLOG(DBG6) << "argv[" << argv.size() << "] = " << a;
-    argv.push_back(a.data());
+    argv.push_back(const_cast<char*>(a.c_str()));
   }
   // The argv array is required to be NULL terminated
   argv.emplace_back(nullptr);
@@ -11,17 +11,37 @@
 #include <folly/executors/ManualExecutor.h>
 #include <folly/executors/task_queue/UnboundedBlockingQueue.h>
 #include <folly/executors/thread_factory/NamedThreadFactory.h>
+#include <folly/lang/Assume.h>
+
+#include "eden/fs/utils/WorkStealingExecutor.h"
 
 namespace facebook::eden {
 
-UnboundedQueueExecutor::UnboundedQueueExecutor(
+namespace {
+std::shared_ptr<folly::Executor> makeExecutor(
     size_t threadCount,
-    folly::StringPiece threadNamePrefix)
-    : executor_{std::make_unique<folly::CPUThreadPoolExecutor>(
+    folly::StringPiece threadNamePrefix,
+    UnboundedQueueExecutor::Scheduling scheduling) {
+  switch (scheduling) {
+    case UnboundedQueueExecutor::Scheduling::Fifo:
+      return std::make_unique<folly::CPUThreadPoolExecutor>(
           threadCount,
           std::make_unique<folly::UnboundedBlockingQueue<
               folly::CPUThreadPoolExecutor::CPUTask>>(),
-          std::make_unique<folly::NamedThreadFactory>(threadNamePrefix))} {}
+          std::make_unique<folly::NamedThreadFactory>(threadNamePrefix));
+    case UnboundedQueueExecutor::Scheduling::WorkStealing:
+      return std::make_unique<WorkStealingExecutor>(
+          threadCount, threadNamePrefix);
+  }
+  folly::assume_unreachable();
+}
+} // namespace
+
+UnboundedQueueExecutor::UnboundedQueueExecutor(
+    size_t threadCount,
+    folly::StringPiece threadNamePrefix,
+    Scheduling scheduling)
+    : executor_{makeExecutor(threadCount, threadNamePrefix, scheduling)} {}
 
 UnboundedQueueExecutor::UnboundedQueueExecutor(
     std::shared_ptr<folly::ManualExecutor> executor)
@@ -25,13 +25,22 @@ namespace facebook::eden {
  */
 class UnboundedQueueExecutor : public folly::Executor {
  public:
+  enum class Scheduling {
+    /** A single queue of tasks, run in FIFO order. */
+    Fifo,
+    /** See WorkStealingExecutor. */
+    WorkStealing,
+  };
+
   /**
    * Instantiates with a folly::CPUThreadPoolExecutor with the given threadCount
-   * and threadNamePrefix but with an unlimited queue.
+   * and threadNamePrefix but with an unlimited queue, or with a
+   * WorkStealingExecutor.
    */
   explicit UnboundedQueueExecutor(
       size_t threadCount,
-      folly::StringPiece threadNamePrefix);
+      folly::StringPiece threadNamePrefix,
+      Scheduling scheduling = Scheduling::Fifo);
 
   /**
    * ManualExecutors are unbounded too.
@@ -8,15 +8,67 @@
 #include "eden/fs/utils/Utf8.h"
 
 #include <folly/Unicode.h>
+#include <folly/lang/Bits.h>
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define EDEN_UTF8_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define EDEN_UTF8_NEON 1
+#endif
 
 namespace facebook::eden {
 
+namespace detail {
+
+const char* findNonAscii(const char* begin, const char* end) noexcept {
+#if defined(EDEN_UTF8_SSE2) || defined(EDEN_UTF8_NEON)
+  constexpr std::ptrdiff_t kChunkSize = 16;
+  for (; end - begin >= kChunkSize; begin += kChunkSize) {
+#if defined(EDEN_UTF8_SSE2)
+    // Only bytes outside of ASCII have their top bit, which movemask gathers.
+    auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+    if (auto mask = static_cast<uint32_t>(_mm_movemask_epi8(chunk))) {
+      return begin + folly::findFirstSet(mask) - 1;
+    }
+#else
+    auto chunk = vld1q_u8(reinterpret_cast<const uint8_t*>(begin));
+    if (vmaxvq_u8(chunk) & 0x80) {
+      // Let the loop below find the byte within this chunk.
+      break;
+    }
+#endif
+  }
+#endif
+  for (; begin != end; ++begin) {
+    if (isBitSet(*begin, 7)) {
+      return begin;
+    }
+  }
+  return end;
+}
+
+} // namespace detail
+
 std::string ensureValidUtf8(folly::ByteRange str) {
   std::string output;
   output.reserve(str.size());
   const unsigned char* begin = str.begin();
   const unsigned char* const end = str.end();
   while (begin != end) {
+    // Copy runs of ASCII characters at once rather than decoding and
+    // re-encoding them one at a time.
+    auto* asciiBegin = reinterpret_cast<const char*>(begin);
+    auto* nonAscii = detail::findNonAscii(
+        asciiBegin, reinterpret_cast<const char*>(end));
+    output.append(asciiBegin, nonAscii);
+    begin += nonAscii - asciiBegin;
+    if (begin == end) {
+      break;
+    }
+
     folly::appendCodePointToUtf8(
         folly::utf8ToCodePoint(begin, end, true), output);
   }
@@ -9,6 +9,7 @@
 
 #include <folly/Range.h>
 #include <folly/Utility.h>
+#include <type_traits>
 
 namespace facebook::eden {
 
@@ -57,6 +58,13 @@ constexpr bool isValidContinuation(
 
   return true;
 }
+
+/**
+ * Returns the first byte in [begin, end) that isn't ASCII, or end if there
+ * are none. Scans 16 bytes at a time with SIMD where available, since nearly
+ * every path is entirely ASCII.
+ */
+const char* findNonAscii(const char* begin, const char* end) noexcept;
 } // namespace detail
 
 /**
@@ -70,6 +78,13 @@ constexpr bool isValidUtf8(folly::StringPiece str) {
   const char* const end = str.end();
 
   while (begin != end) {
+    if (!std::is_constant_evaluated() && !detail::isBitSet(*begin, 7)) {
+      begin = detail::findNonAscii(begin, end);
+      if (begin == end) {
+        break;
+      }
+    }
+
     char first = *begin++;
     if (!detail::isBitSet(first, 7)) {
       // ASCII character, nothing to do.
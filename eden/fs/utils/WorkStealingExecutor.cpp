@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/WorkStealingExecutor.h"
+
+#include <folly/Conv.h>
+#include <folly/ExceptionString.h>
+#include <folly/logging/xlog.h>
+#include <folly/system/ThreadName.h>
+
+namespace facebook::eden {
+
+namespace {
+/**
+ * The worker of a WorkStealingExecutor running on this thread, if any.
+ */
+struct CurrentWorker {
+  const WorkStealingExecutor* executor = nullptr;
+  size_t index = 0;
+};
+
+thread_local CurrentWorker currentWorker;
+} // namespace
+
+WorkStealingExecutor::WorkStealingExecutor(
+    size_t threadCount,
+    folly::StringPiece threadNamePrefix) {
+  threadCount = std::max<size_t>(threadCount, 1);
+  workers_.reserve(threadCount);
+  for (size_t i = 0; i < threadCount; ++i) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  // Start the threads once all the workers exist, since they steal from each
+  // other.
+  for (size_t i = 0; i < threadCount; ++i) {
+    workers_[i]->thread = std::thread{
+        &WorkStealingExecutor::run,
+        this,
+        i,
+        folly::to<std::string>(threadNamePrefix, i)};
+  }
+}
+
+WorkStealingExecutor::~WorkStealingExecutor() {
+  {
+    std::lock_guard lock{sleepMutex_};
+    stopping_ = true;
+  }
+  wakeup_.notify_all();
+  for (auto& worker : workers_) {
+    worker->thread.join();
+  }
+}
+
+size_t WorkStealingExecutor::laneForPriority(int8_t priority) {
+  if (priority < 0) {
+    return 0;
+  }
+  return priority == 0 ? 1 : 2;
+}
+
+void WorkStealingExecutor::add(folly::Func func) {
+  push(std::move(func), laneForPriority(folly::Executor::MID_PRI));
+}
+
+void WorkStealingExecutor::addWithPriority(folly::Func func, int8_t priority) {
+  push(std::move(func), laneForPriority(priority));
+}
+
+void WorkStealingExecutor::push(folly::Func func, size_t lane) {
+  // Count the task before queueing it, so that a thread taking it never sees
+  // the counts go below 0. A thread seeing the count before the task is queued
+  // looks for it again.
+  pending_[lane].fetch_add(1);
+  totalPending_.fetch_add(1);
+  if (currentWorker.executor == this) {
+    workers_[currentWorker.index]->lanes.lock()->at(lane).push_back(
+        std::move(func));
+  } else {
+    injected_.lock()->at(lane).push_back(std::move(func));
+  }
+
+  // A thread about to sleep counts itself in sleepers_ before checking
+  // totalPending_ under sleepMutex_, so either it sees this task, or this sees
+  // it sleeping and wakes it up once it waits.
+  if (sleepers_.load() > 0) {
+    std::lock_guard lock{sleepMutex_};
+    wakeup_.notify_one();
+  }
+}
+
+folly::Func WorkStealingExecutor::take(size_t self) {
+  auto popped = [&](folly::Func func, size_t lane) {
+    pending_[lane].fetch_sub(1);
+    totalPending_.fetch_sub(1);
+    return func;
+  };
+
+  for (size_t lane = kNumLanes; lane-- > 0;) {
+    if (pending_[lane].load() == 0) {
+      continue;
+    }
+
+    {
+      auto lanes = workers_[self]->lanes.lock();
+      auto& tasks = (*lanes)[lane];
+      if (!tasks.empty()) {
+        auto func = std::move(tasks.back());
+        tasks.pop_back();
+        return popped(std::move(func), lane);
+      }
+    }
+
+    {
+      auto lanes = injected_.lock();
+      auto& tasks = (*lanes)[lane];
+      if (!tasks.empty()) {
+        auto func = std::move(tasks.front());
+        tasks.pop_front();
+        return popped(std::move(func), lane);
+      }
+    }
+
+    for (size_t i = 1; i < workers_.size(); ++i) {
+      auto victim = (self + i) % workers_.size();
+      auto lanes = workers_[victim]->lanes.lock();
+      auto& tasks = (*lanes)[lane];
+      if (!tasks.empty()) {
+        auto func = std::move(tasks.front());
+        tasks.pop_front();
+        return popped(std::move(func), lane);
+      }
+    }
+  }
+  return {};
+}
+
+bool WorkStealingExecutor::waitForTasks() {
+  std::unique_lock lock{sleepMutex_};
+  sleepers_.fetch_add(1);
+  wakeup_.wait(lock, [&] { return totalPending_.load() > 0 || stopping_; });
+  sleepers_.fetch_sub(1);
+  return totalPending_.load() > 0 || !stopping_;
+}
+
+void WorkStealingExecutor::run(size_t self, std::string threadName) {
+  folly::setThreadName(threadName);
+  currentWorker = CurrentWorker{this, self};
+
+  do {
+    while (auto func = take(self)) {
+      try {
+        func();
+      } catch (const std::exception& ex) {
+        XLOG(ERR) << "Exception thrown by a task of " << threadName << ": "
+                  << folly::exceptionStr(ex);
+      }
+    }
+  } while (waitForTasks());
+}
+
+} // namespace facebook::eden
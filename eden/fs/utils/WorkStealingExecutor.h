@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Executor.h>
+#include <folly/Range.h>
+#include <folly/Synchronized.h>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace facebook::eden {
+
+/**
+ * A thread pool where each thread has its own queue of tasks.
+ *
+ * Tasks added from one of the pool's threads go to the back of that thread's
+ * queue, which the thread runs from the back: the children of recursive work
+ * like diff, glob or checkout run next, on the same thread, while the data
+ * they share is still in its caches. Tasks added from other threads go to a
+ * shared queue, run in FIFO order. Idle threads steal the oldest tasks from
+ * the front of the other threads' queues.
+ *
+ * Tasks have 3 priorities: those added with addWithPriority() with a negative
+ * priority run after the others, and those with a positive priority before.
+ * Tasks of the same priority are not ordered across threads.
+ *
+ * Like UnboundedQueueExecutor, adding a task never blocks nor runs it inline.
+ * The tasks left when the executor is destroyed are run before it returns.
+ */
+class WorkStealingExecutor : public folly::Executor {
+ public:
+  WorkStealingExecutor(size_t threadCount, folly::StringPiece threadNamePrefix);
+  ~WorkStealingExecutor() override;
+
+  WorkStealingExecutor(const WorkStealingExecutor&) = delete;
+  WorkStealingExecutor& operator=(const WorkStealingExecutor&) = delete;
+
+  void add(folly::Func func) override;
+  void addWithPriority(folly::Func func, int8_t priority) override;
+
+  uint8_t getNumPriorities() const override {
+    return kNumLanes;
+  }
+
+ private:
+  // One queue per priority, from the lowest.
+  static constexpr size_t kNumLanes = 3;
+  using Lanes = std::array<std::deque<folly::Func>, kNumLanes>;
+
+  struct Worker {
+    folly::Synchronized<Lanes, std::mutex> lanes;
+    std::thread thread;
+  };
+
+  static size_t laneForPriority(int8_t priority);
+
+  void push(folly::Func func, size_t lane);
+
+  /**
+   * Returns the next task for the given worker to run, or an empty function
+   * if none was found.
+   */
+  folly::Func take(size_t self);
+
+  /** Returns whether the worker should keep running. */
+  bool waitForTasks();
+
+  void run(size_t self, std::string threadName);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  folly::Synchronized<Lanes, std::mutex> injected_;
+
+  // The number of tasks queued in each lane, which lets the threads looking
+  // for a task skip the empty lanes without locking every queue.
+  std::array<std::atomic<size_t>, kNumLanes> pending_{};
+  std::atomic<size_t> totalPending_{0};
+
+  std::mutex sleepMutex_;
+  std::condition_variable wakeup_;
+  std::atomic<size_t> sleepers_{0};
+  bool stopping_{false};
+};
+
+} // namespace facebook::eden
@@ -95,3 +95,42 @@ TEST(CoverageSetTest, merge_can_replace_many_nodes) {
   EXPECT_FALSE(s.covers(7, 9));
   EXPECT_TRUE(s.covers(1, 8));
 }
+
+TEST(CoverageSetTest, gaps_are_the_uncovered_parts_of_a_range) {
+  using Gaps = std::vector<std::pair<size_t, size_t>>;
+  CoverageSet s;
+  EXPECT_EQ((Gaps{{0, 10}}), s.getGaps(0, 10));
+  EXPECT_EQ(Gaps{}, s.getGaps(4, 4));
+
+  s.add(2, 4);
+  s.add(6, 8);
+  EXPECT_EQ((Gaps{{0, 2}, {4, 6}, {8, 10}}), s.getGaps(0, 10));
+  EXPECT_EQ((Gaps{{4, 6}}), s.getGaps(3, 7));
+  EXPECT_EQ((Gaps{{5, 6}}), s.getGaps(5, 6));
+  EXPECT_EQ(Gaps{}, s.getGaps(2, 4));
+  EXPECT_EQ(Gaps{}, s.getGaps(6, 7));
+  EXPECT_EQ((Gaps{{8, 9}}), s.getGaps(7, 9));
+}
+
+TEST(CoverageSetTest, removing_ranges_splits_intervals) {
+  using Gaps = std::vector<std::pair<size_t, size_t>>;
+  CoverageSet s;
+  s.add(0, 10);
+  s.remove(3, 5);
+  EXPECT_EQ(2, s.getIntervalCount());
+  EXPECT_TRUE(s.covers(0, 3));
+  EXPECT_TRUE(s.covers(5, 10));
+  EXPECT_EQ((Gaps{{3, 5}}), s.getGaps(0, 10));
+
+  s.add(12, 14);
+  s.remove(0, 13);
+  EXPECT_EQ(1, s.getIntervalCount());
+  EXPECT_TRUE(s.covers(13, 14));
+  EXPECT_EQ((Gaps{{0, 13}}), s.getGaps(0, 14));
+
+  s.remove(20, 30);
+  s.remove(13, 13);
+  EXPECT_TRUE(s.covers(13, 14));
+  s.remove(10, 20);
+  EXPECT_TRUE(s.empty());
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/FreeListAllocator.h"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <folly/CPortability.h>
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+
+namespace {
+
+struct Base {
+  virtual ~Base() = default;
+  uint64_t value{0};
+};
+
+struct Pooled final : Base, FreeListAllocated<Pooled> {
+  char padding[100];
+};
+
+struct alignas(64) OverAligned final : FreeListAllocated<OverAligned> {
+  char padding[100];
+};
+
+} // namespace
+
+TEST(FreeListAllocator, reusesFreedBlocks) {
+  auto* first = new Pooled;
+  Base* base = first;
+  // Deleting through the base class uses Pooled's operator delete.
+  delete base;
+  auto* second = new Pooled;
+#ifndef FOLLY_SANITIZE
+  EXPECT_EQ(static_cast<void*>(first), static_cast<void*>(second));
+#endif
+  delete second;
+}
+
+TEST(FreeListAllocator, freesOnOtherThreads) {
+  // Allocate on one thread and free on another, with enough objects to move
+  // batches through the depot and overflow it.
+  constexpr size_t kCount = 2 * FreeListAllocator<sizeof(Pooled)>::kBatchSize *
+      FreeListAllocator<sizeof(Pooled)>::kMaxDepotBatches;
+  for (int round = 0; round < 2; ++round) {
+    std::vector<std::unique_ptr<Base>> objects;
+    std::thread allocator{[&] {
+      for (size_t i = 0; i < kCount; ++i) {
+        objects.emplace_back(new Pooled);
+        objects.back()->value = i;
+      }
+    }};
+    allocator.join();
+    for (size_t i = 0; i < kCount; ++i) {
+      EXPECT_EQ(i, objects[i]->value);
+    }
+    std::thread deallocator{[&] { objects.clear(); }};
+    deallocator.join();
+  }
+}
+
+TEST(FreeListAllocator, respectsAlignment) {
+  std::vector<std::unique_ptr<OverAligned>> objects;
+  for (int i = 0; i < 1000; ++i) {
+    objects.emplace_back(new OverAligned);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(objects.back().get()) % 64);
+  }
+  objects.clear();
+  for (int i = 0; i < 1000; ++i) {
+    objects.emplace_back(new OverAligned);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(objects.back().get()) % 64);
+  }
+}
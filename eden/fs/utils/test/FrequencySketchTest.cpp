@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/FrequencySketch.h"
+#include <folly/portability/GTest.h>
+
+namespace {
+
+using namespace facebook::eden;
+
+TEST(FrequencySketchTest, default_constructed_sketch_tracks_nothing) {
+  FrequencySketch sketch;
+  sketch.record(1);
+  EXPECT_EQ(0, sketch.estimate(1));
+}
+
+TEST(FrequencySketchTest, width_is_a_power_of_two) {
+  EXPECT_EQ(64, FrequencySketch{1}.width());
+  EXPECT_EQ(1024, FrequencySketch{1000}.width());
+  EXPECT_EQ(1024, FrequencySketch{1024}.width());
+}
+
+TEST(FrequencySketchTest, counts_accesses) {
+  FrequencySketch sketch{1024};
+  EXPECT_EQ(0, sketch.estimate(42));
+  sketch.record(42);
+  sketch.record(42);
+  sketch.record(42);
+  EXPECT_EQ(3, sketch.estimate(42));
+  EXPECT_EQ(0, sketch.estimate(43));
+}
+
+TEST(FrequencySketchTest, counters_saturate) {
+  FrequencySketch sketch{1024};
+  for (int i = 0; i < 100; ++i) {
+    sketch.record(7);
+  }
+  EXPECT_EQ(FrequencySketch::kMaxFrequency, sketch.estimate(7));
+}
+
+TEST(FrequencySketchTest, clear_forgets_everything) {
+  FrequencySketch sketch{1024};
+  sketch.record(7);
+  sketch.clear();
+  EXPECT_EQ(0, sketch.estimate(7));
+}
+
+TEST(FrequencySketchTest, old_accesses_age_out) {
+  FrequencySketch sketch{64};
+  for (int i = 0; i < 100; ++i) {
+    sketch.record(7);
+  }
+  EXPECT_EQ(FrequencySketch::kMaxFrequency, sketch.estimate(7));
+
+  // Recording roughly 10x width accesses triggers an aging pass, which halves
+  // the saturated counters.
+  for (uint64_t key = 1000; key < 1000 + 64 * 11; ++key) {
+    sketch.record(key);
+  }
+  EXPECT_LT(sketch.estimate(7), FrequencySketch::kMaxFrequency);
+}
+
+} // namespace
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/HashedPathMap.h"
+
+#include <benchmark/benchmark.h>
+#include <fmt/format.h>
+#include <algorithm>
+#include "eden/fs/utils/PathMap.h"
+
+using namespace facebook::eden;
+
+namespace {
+
+std::vector<PathComponent> makeNames(size_t count) {
+  std::vector<PathComponent> names;
+  names.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    names.emplace_back(fmt::format("source_file_{:08}.cpp", i * 7919));
+  }
+  return names;
+}
+
+template <typename Map>
+void find(benchmark::State& state) {
+  auto names = makeNames(state.range(0));
+  Map map{kPathMapDefaultCaseSensitive};
+  for (const auto& name : names) {
+    map.emplace(name, 0);
+  }
+
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(map.find(names[i]));
+    i = (i + 1) % names.size();
+  }
+}
+BENCHMARK(find<PathMap<int>>)->Arg(8)->Arg(64)->Arg(1024)->Arg(65536);
+BENCHMARK(find<HashedPathMap<int>>)->Arg(8)->Arg(64)->Arg(1024)->Arg(65536);
+
+template <typename Map>
+void build_sorted(benchmark::State& state) {
+  auto names = makeNames(state.range(0));
+  std::sort(names.begin(), names.end());
+  for (auto _ : state) {
+    Map map{kPathMapDefaultCaseSensitive};
+    map.reserve(names.size());
+    for (const auto& name : names) {
+      map.emplace(name, 0);
+    }
+    benchmark::DoNotOptimize(map);
+  }
+}
+BENCHMARK(build_sorted<PathMap<int>>)->Arg(64)->Arg(1024)->Arg(65536);
+BENCHMARK(build_sorted<HashedPathMap<int>>)->Arg(64)->Arg(1024)->Arg(65536);
+
+} // namespace
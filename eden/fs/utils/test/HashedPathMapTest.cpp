@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/HashedPathMap.h"
+
+#include <fmt/format.h>
+#include <folly/Random.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/utils/PathMap.h"
+
+using namespace facebook::eden;
+using namespace facebook::eden::path_literals;
+
+namespace {
+
+/** Checks that map has the same entries, in the same order, as expected. */
+void expectSameEntries(
+    const PathMap<int>& expected,
+    const HashedPathMap<int>& map) {
+  ASSERT_EQ(expected.size(), map.size());
+  auto iter = map.begin();
+  for (const auto& [name, value] : expected) {
+    EXPECT_EQ(name, iter->first);
+    EXPECT_EQ(value, iter->second);
+    ++iter;
+  }
+  for (const auto& [name, value] : expected) {
+    auto found = map.find(name);
+    ASSERT_NE(map.end(), found) << name;
+    EXPECT_EQ(value, found->second);
+  }
+}
+
+} // namespace
+
+TEST(HashedPathMap, caseSensitive) {
+  HashedPathMap<bool> map(CaseSensitivity::Sensitive);
+
+  map.insert(std::make_pair(PathComponent("foo"), true));
+  EXPECT_TRUE(map.at("foo"_pc));
+  EXPECT_EQ(map.find("Foo"_pc), map.end());
+
+  EXPECT_TRUE(map.insert(std::make_pair(PathComponent("FOO"), false)).second);
+  EXPECT_EQ(map.size(), 2);
+  EXPECT_TRUE(map.at("foo"_pc));
+  EXPECT_FALSE(map.at("FOO"_pc));
+  EXPECT_EQ(map.erase("FOO"_pc), 1);
+  EXPECT_EQ(map.size(), 1);
+
+  map["FOO"_pc] = true;
+  map["Foo"_pc] = false;
+  EXPECT_EQ(map.size(), 3);
+}
+
+TEST(HashedPathMap, caseInsensitive) {
+  HashedPathMap<bool> map(CaseSensitivity::Insensitive);
+
+  map.insert(std::make_pair(PathComponent("foo"), true));
+  EXPECT_TRUE(map.at("foo"_pc));
+  EXPECT_TRUE(map.at("Foo"_pc));
+
+  EXPECT_FALSE(map.insert(std::make_pair(PathComponent("FOO"), false)).second);
+  EXPECT_EQ(map.size(), 1);
+  EXPECT_EQ(map.begin()->first, "foo"_pc);
+  EXPECT_EQ(map.erase("FOO"_pc), 1);
+  EXPECT_TRUE(map.empty());
+}
+
+TEST(HashedPathMap, copyMoveAndSwap) {
+  HashedPathMap<int> map(CaseSensitivity::Sensitive);
+  for (int i = 0; i < 100; ++i) {
+    map.emplace(PathComponent{fmt::format("name{}", i)}, i);
+  }
+
+  HashedPathMap<int> copied(map);
+  EXPECT_EQ(42, copied.at("name42"_pc));
+  EXPECT_TRUE(map == copied);
+
+  HashedPathMap<int> moved(std::move(copied));
+  EXPECT_EQ(42, moved.at("name42"_pc));
+
+  HashedPathMap<int> other(CaseSensitivity::Insensitive);
+  other.emplace("only"_pc, 1);
+  other.swap(moved);
+  EXPECT_EQ(42, other.at("name42"_pc));
+  EXPECT_EQ(CaseSensitivity::Sensitive, other.getCaseSensitivity());
+  EXPECT_EQ(1, moved.at("ONLY"_pc));
+}
+
+TEST(HashedPathMap, matchesPathMap) {
+  // Exercise both the scan of small maps and the index of larger ones, with
+  // names inserted and erased at random positions.
+  for (auto caseSensitive :
+       {CaseSensitivity::Sensitive, CaseSensitivity::Insensitive}) {
+    PathMap<int> expected(caseSensitive);
+    HashedPathMap<int> map(caseSensitive);
+    for (int i = 0; i < 2000; ++i) {
+      auto name = PathComponent{fmt::format(
+          "{}{}", i % 2 ? "File" : "file", folly::Random::rand32(500))};
+      if (folly::Random::oneIn(4)) {
+        EXPECT_EQ(expected.erase(name), map.erase(name));
+      } else {
+        auto [expectedIter, expectedInserted] = expected.emplace(name, i);
+        auto [iter, inserted] = map.emplace(name, i);
+        EXPECT_EQ(expectedInserted, inserted);
+        EXPECT_EQ(expectedIter->second, iter->second);
+      }
+      if (i % 100 == 0) {
+        expectSameEntries(expected, map);
+      }
+    }
+    expectSameEntries(expected, map);
+    EXPECT_EQ(map.end(), map.find("missing"_pc));
+
+    map.clear();
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(map.end(), map.find("file1"_pc));
+  }
+}
+
+TEST(HashedPathMap, lowerBoundAndOrderedErase) {
+  HashedPathMap<int> map(CaseSensitivity::Sensitive);
+  for (int i = 0; i < 50; ++i) {
+    map.emplace(PathComponent{fmt::format("{:02}", i)}, i);
+  }
+
+  auto iter = map.lower_bound("25a"_pc);
+  ASSERT_NE(map.end(), iter);
+  EXPECT_EQ("26"_pc, iter->first);
+
+  iter = map.erase(iter, map.end());
+  EXPECT_EQ(map.end(), iter);
+  EXPECT_EQ(26, map.size());
+  EXPECT_EQ(map.end(), map.find("30"_pc));
+  EXPECT_EQ(25, map.at("25"_pc));
+}
@@ -74,6 +74,71 @@ void ImmediateFuture_thenValue_with_exc(benchmark::State& state) {
 }
 BENCHMARK(ImmediateFuture_thenValue_with_exc);
 
+// Four steps of a computation, where each but the first may complete
+// immediately or asynchronously, written as a chain of continuations and as a
+// coroutine.
+ImmediateFuture<uint64_t> step(uint64_t value, bool ready) {
+  if (ready) {
+    return value + 1;
+  }
+  return folly::makeSemiFuture().deferValue(
+      [value](folly::Unit) { return value + 1; });
+}
+
+ImmediateFuture<uint64_t> thenValueChain(uint64_t value, bool ready) {
+  return step(value, ready)
+      .thenValue([ready](uint64_t v) { return step(v, ready); })
+      .thenValue([ready](uint64_t v) { return step(v, ready); })
+      .thenValue([ready](uint64_t v) { return step(v, ready); });
+}
+
+#if FOLLY_HAS_COROUTINES
+ImmediateFuture<uint64_t> coroutineChain(uint64_t value, bool ready) {
+  value = co_await step(value, ready);
+  value = co_await step(value, ready);
+  value = co_await step(value, ready);
+  co_return co_await step(value, ready);
+}
+#endif
+
+void ImmediateFuture_thenValue_chain_ready(benchmark::State& state) {
+  uint64_t value = 0;
+  for (auto _ : state) {
+    value = thenValueChain(value, true).get();
+  }
+  state.SetItemsProcessed(value);
+}
+BENCHMARK(ImmediateFuture_thenValue_chain_ready);
+
+void ImmediateFuture_thenValue_chain_not_ready(benchmark::State& state) {
+  uint64_t value = 0;
+  for (auto _ : state) {
+    value = thenValueChain(value, false).get();
+  }
+  state.SetItemsProcessed(value);
+}
+BENCHMARK(ImmediateFuture_thenValue_chain_not_ready);
+
+#if FOLLY_HAS_COROUTINES
+void ImmediateFuture_coroutine_chain_ready(benchmark::State& state) {
+  uint64_t value = 0;
+  for (auto _ : state) {
+    value = coroutineChain(value, true).get();
+  }
+  state.SetItemsProcessed(value);
+}
+BENCHMARK(ImmediateFuture_coroutine_chain_ready);
+
+void ImmediateFuture_coroutine_chain_not_ready(benchmark::State& state) {
+  uint64_t value = 0;
+  for (auto _ : state) {
+    value = coroutineChain(value, false).get();
+  }
+  state.SetItemsProcessed(value);
+}
+BENCHMARK(ImmediateFuture_coroutine_chain_not_ready);
+#endif
+
 void folly_Future_thenValue_with_int(benchmark::State& state) {
   folly::Future<int> fut{0};
   for (auto _ : state) {
@@ -744,4 +744,84 @@ TEST(ImmediateFuture, QueuedImmediateExecutor_is_unsafe) {
   EXPECT_EQ(1, sideEffects.size());
 }
 
+#if FOLLY_HAS_COROUTINES
+ImmediateFuture<int> addOne(ImmediateFuture<int> fut) {
+  auto value = co_await std::move(fut);
+  co_return value + 1;
+}
+
+TEST(ImmediateFuture, coroutine_with_ready_futures_is_immediate) {
+  auto fut = addOne(addOne(41));
+  EXPECT_NE(fut.isReady(), detail::kImmediateFutureAlwaysDefer);
+  EXPECT_NE(fut.debugIsImmediate(), detail::kImmediateFutureAlwaysDefer);
+  EXPECT_EQ(43, std::move(fut).get());
+}
+
+TEST(ImmediateFuture, coroutine_resumes_when_awaited_future_completes) {
+  auto [p, sf] = folly::makePromiseContract<int>();
+  auto fut = addOne(addOne(std::move(sf)));
+  EXPECT_FALSE(fut.isReady());
+  p.setValue(1);
+  EXPECT_EQ(3, std::move(fut).get());
+}
+
+TEST(ImmediateFuture, coroutine_runs_lazily_after_suspending) {
+  auto [p, sf] = folly::makePromiseContract<int>();
+  std::vector<int> sideEffects;
+  auto coroutine = [&](folly::SemiFuture<int> awaited) -> ImmediateFuture<int> {
+    sideEffects.push_back(1);
+    auto value = co_await std::move(awaited);
+    sideEffects.push_back(value);
+    co_return value;
+  };
+
+  auto fut = coroutine(std::move(sf));
+  EXPECT_EQ(std::vector<int>{1}, sideEffects);
+  p.setValue(2);
+  // Like a deferred continuation, the rest of the coroutine only runs once
+  // the returned future is consumed.
+  EXPECT_EQ(std::vector<int>{1}, sideEffects);
+  EXPECT_EQ(2, std::move(fut).get());
+  EXPECT_EQ((std::vector<int>{1, 2}), sideEffects);
+}
+
+TEST(ImmediateFuture, coroutine_propagates_exceptions) {
+  auto throwing = []() -> ImmediateFuture<int> {
+    co_await makeImmediateFuture<folly::Unit>(std::logic_error("awaited"));
+    co_return 1;
+  };
+  EXPECT_THROW_RE(throwing().get(), std::logic_error, "awaited");
+
+  auto [p, sf] = folly::makePromiseContract<int>();
+  auto fut = addOne(std::move(sf));
+  p.setException(std::runtime_error("later"));
+  EXPECT_THROW_RE(std::move(fut).get(), std::runtime_error, "later");
+}
+
+TEST(ImmediateFuture, unit_coroutine_returns_void) {
+  int count = 0;
+  auto increment = [&]() -> ImmediateFuture<folly::Unit> {
+    co_await ImmediateFuture<folly::Unit>{folly::unit};
+    ++count;
+    co_return;
+  };
+  std::move(increment()).get();
+  EXPECT_EQ(1, count);
+}
+
+TEST(ImmediateFuture, destroying_suspended_coroutine_destroys_frame) {
+  auto [p, sf] = folly::makePromiseContract<int>();
+  auto alive = std::make_shared<int>(0);
+  std::weak_ptr<int> weak = alive;
+  {
+    auto fut = [](std::shared_ptr<int> owned,
+                  folly::SemiFuture<int> awaited) -> ImmediateFuture<int> {
+      co_return *owned + co_await std::move(awaited);
+    }(std::move(alive), std::move(sf));
+    EXPECT_FALSE(weak.expired());
+  }
+  EXPECT_TRUE(weak.expired());
+}
+#endif
+
 } // namespace
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/InFlightDeduplicator.h"
+
+#include <folly/futures/Promise.h>
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+
+namespace {
+
+TEST(InFlightDeduplicator, joinsRunningComputation) {
+  InFlightDeduplicator<std::string, int> dedup;
+  auto [promise, semi] = folly::makePromiseContract<int>();
+  int calls = 0;
+
+  auto first = dedup.getOrCompute("key", [&, semi = std::move(semi)]() mutable {
+    ++calls;
+    return ImmediateFuture<int>{std::move(semi)};
+  });
+  auto second = dedup.getOrCompute("key", [&] {
+    ++calls;
+    return ImmediateFuture<int>{0};
+  });
+  EXPECT_EQ(1u, dedup.inFlight());
+  EXPECT_EQ(1u, dedup.joined());
+
+  promise.setValue(42);
+  auto firstResult = std::move(first).get();
+  auto secondResult = std::move(second).get();
+  EXPECT_EQ(42, *firstResult);
+  EXPECT_EQ(firstResult, secondResult);
+  EXPECT_EQ(1, calls);
+  EXPECT_EQ(0u, dedup.inFlight());
+}
+
+TEST(InFlightDeduplicator, completedComputationsAreNotReused) {
+  InFlightDeduplicator<std::string, int> dedup;
+  int calls = 0;
+  auto compute = [&] { return ImmediateFuture<int>{++calls}; };
+
+  EXPECT_EQ(1, *std::move(dedup.getOrCompute("key", compute)).get());
+  EXPECT_EQ(2, *std::move(dedup.getOrCompute("key", compute)).get());
+  EXPECT_EQ(0u, dedup.joined());
+}
+
+TEST(InFlightDeduplicator, differentKeysDoNotJoin) {
+  InFlightDeduplicator<std::string, int> dedup;
+  auto [promise, semi] = folly::makePromiseContract<int>();
+
+  auto first = dedup.getOrCompute("a", [semi = std::move(semi)]() mutable {
+    return ImmediateFuture<int>{std::move(semi)};
+  });
+  auto second = dedup.getOrCompute("b", [] { return ImmediateFuture<int>{7}; });
+  EXPECT_EQ(7, *std::move(second).get());
+  EXPECT_EQ(0u, dedup.joined());
+
+  promise.setValue(1);
+  EXPECT_EQ(1, *std::move(first).get());
+}
+
+TEST(InFlightDeduplicator, errorsAreShared) {
+  InFlightDeduplicator<std::string, int> dedup;
+  auto [promise, semi] = folly::makePromiseContract<int>();
+
+  auto first = dedup.getOrCompute("key", [semi = std::move(semi)]() mutable {
+    return ImmediateFuture<int>{std::move(semi)};
+  });
+  auto second =
+      dedup.getOrCompute("key", [] { return ImmediateFuture<int>{0}; });
+
+  promise.setException(std::runtime_error("oops"));
+  EXPECT_THROW(std::move(first).get(), std::runtime_error);
+  EXPECT_THROW(std::move(second).get(), std::runtime_error);
+}
+
+TEST(InFlightDeduplicator, joinersRetryWhenComputationIsCancelled) {
+  InFlightDeduplicator<std::string, int> dedup;
+  auto [promise, semi] = folly::makePromiseContract<int>();
+
+  auto first = dedup.getOrCompute("key", [semi = std::move(semi)]() mutable {
+    return ImmediateFuture<int>{std::move(semi)};
+  });
+  auto second =
+      dedup.getOrCompute("key", [] { return ImmediateFuture<int>{2}; });
+
+  promise.setException(folly::OperationCancelled{});
+  EXPECT_THROW(std::move(first).get(), folly::OperationCancelled);
+  EXPECT_EQ(2, *std::move(second).get());
+}
+
+} // namespace
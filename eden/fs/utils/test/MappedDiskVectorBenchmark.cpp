@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/utils/MappedDiskVector.h"
+
+#include <benchmark/benchmark.h>
+#include <folly/experimental/TestUtil.h>
+
+using namespace facebook::eden;
+
+namespace {
+
+/** The size of an InodeTable entry for InodeMetadata. */
+struct Record {
+  enum { VERSION = 0 };
+
+  /* implicit */ Record(uint64_t v) : value{v} {}
+  uint64_t value;
+  uint64_t padding[5]{};
+};
+
+std::string makePath(const folly::test::TemporaryDirectory& dir) {
+  return (dir.path() / "bench.mdv").string();
+}
+
+/**
+ * Appends records, growing the file 1MB at a time, as the InodeTable does
+ * when a checkout or build allocates many inodes.
+ */
+void grow(benchmark::State& state) {
+  folly::test::TemporaryDirectory dir{"eden_mdv_bench_"};
+  for (auto _ : state) {
+    auto mdv = MappedDiskVector<Record>::createOrOverwrite(makePath(dir));
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      mdv.emplace_back(i);
+    }
+    benchmark::DoNotOptimize(mdv.back());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(grow)->Arg(100'000)->Arg(1'000'000)->Unit(benchmark::kMillisecond);
+
+/**
+ * Opens an existing file and reads every record, as the InodeTable does when
+ * it builds its index, with and without prefaulting the mapping.
+ */
+void open_and_scan(benchmark::State& state) {
+  folly::test::TemporaryDirectory dir{"eden_mdv_bench_"};
+  {
+    auto mdv = MappedDiskVector<Record>::createOrOverwrite(makePath(dir));
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      mdv.emplace_back(i);
+    }
+  }
+
+  bool populate = state.range(1);
+  for (auto _ : state) {
+    auto mdv = MappedDiskVector<Record>::open(makePath(dir), populate);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < mdv.size(); ++i) {
+      sum += mdv[i].value;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(open_and_scan)
+    ->Args({1'000'000, false})
+    ->Args({1'000'000, true})
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+#endif
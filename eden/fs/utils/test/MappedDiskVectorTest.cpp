@@ -92,6 +92,76 @@ TEST_F(MappedDiskVectorTest, pop_back) {
   EXPECT_EQ(3, mdv[1]);
 }
 
+TEST_F(MappedDiskVectorTest, releases_unused_capacity) {
+  auto mdv = MappedDiskVector<U64>::open(mdvPath);
+  constexpr uint64_t N = 1000000;
+  for (uint64_t i = 0; i < N; ++i) {
+    mdv.emplace_back(i);
+  }
+  // Nothing to release while the vector is full.
+  EXPECT_FALSE(mdv.releaseUnusedCapacity());
+
+  struct stat st;
+  ASSERT_EQ(0, stat(mdvPath.c_str(), &st));
+  auto fullSize = st.st_size;
+
+  while (mdv.size() > 10) {
+    mdv.pop_back();
+  }
+  EXPECT_TRUE(mdv.releaseUnusedCapacity());
+  EXPECT_FALSE(mdv.releaseUnusedCapacity());
+  ASSERT_EQ(0, stat(mdvPath.c_str(), &st));
+  EXPECT_LT(st.st_size, fullSize);
+
+  // The remaining entries survive, and the vector can grow again.
+  EXPECT_EQ(9, mdv[9]);
+  for (uint64_t i = 10; i < N; ++i) {
+    mdv.emplace_back(i);
+  }
+  EXPECT_EQ(N - 1, mdv[N - 1]);
+}
+
+TEST_F(MappedDiskVectorTest, grows_in_place_within_reservation) {
+  auto mdv = MappedDiskVector<U64>::open(mdvPath);
+  mdv.emplace_back(0ull);
+  auto* first = &mdv[0];
+  auto initialCapacity = mdv.capacity();
+  ASSERT_GT(mdv.reservedCapacity(), initialCapacity * 4);
+
+  for (uint64_t i = 1; i < initialCapacity * 4; ++i) {
+    mdv.emplace_back(i);
+  }
+  EXPECT_GT(mdv.capacity(), initialCapacity);
+  EXPECT_EQ(first, &mdv[0]);
+  EXPECT_EQ(initialCapacity * 4 - 1, mdv.back());
+}
+
+namespace {
+/**
+ * A record that leaves most of its bytes unwritten, so that a vector of them
+ * can outgrow its address space reservation without writing as much data.
+ */
+struct Sparse {
+  enum { VERSION = 0 };
+
+  /* implicit */ Sparse(uint64_t v) : value{v} {}
+  uint64_t value;
+  char unused[16 * 1024 - sizeof(uint64_t)];
+};
+} // namespace
+
+TEST_F(MappedDiskVectorTest, moves_entries_when_outgrowing_reservation) {
+  auto mdv = MappedDiskVector<Sparse>::open(mdvPath);
+  auto reservedCapacity = mdv.reservedCapacity();
+  for (uint64_t i = 0; i <= reservedCapacity; ++i) {
+    mdv.emplace_back(i);
+  }
+  EXPECT_GT(mdv.reservedCapacity(), reservedCapacity);
+  for (uint64_t i = 0; i <= reservedCapacity; ++i) {
+    EXPECT_EQ(i, mdv[i].value);
+  }
+}
+
 namespace {
 struct Small {
   enum { VERSION = 0 };
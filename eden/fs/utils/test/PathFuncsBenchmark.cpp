@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/PathFuncs.h"
+
+#include <benchmark/benchmark.h>
+
+using namespace facebook::eden;
+
+namespace {
+
+/**
+ * A repository path with the given number of components, with names of the
+ * lengths commonly found in large repositories.
+ */
+std::string makePath(size_t depth) {
+  static constexpr std::string_view kNames[] = {
+      "fbcode",
+      "eden",
+      "fs",
+      "inodes",
+      "test",
+      "TreeInodeDirectoryEntriesTest.cpp",
+      "third-party-buck",
+      "platform010",
+  };
+  std::string path;
+  for (size_t i = 0; i < depth; ++i) {
+    if (i != 0) {
+      path += kDirSeparator;
+    }
+    path += kNames[i % std::size(kNames)];
+  }
+  return path;
+}
+
+void construct_relative_path(benchmark::State& state) {
+  auto path = makePath(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(RelativePathPiece{path});
+  }
+}
+BENCHMARK(construct_relative_path)->Arg(1)->Arg(4)->Arg(16);
+
+void construct_path_component(benchmark::State& state) {
+  std::string name(state.range(0), 'a');
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(PathComponentPiece{name});
+  }
+}
+BENCHMARK(construct_path_component)->Arg(8)->Arg(32)->Arg(128);
+
+void iterate_components(benchmark::State& state) {
+  auto path = makePath(state.range(0));
+  RelativePathPiece piece{path};
+  for (auto _ : state) {
+    for (auto component : piece.components()) {
+      benchmark::DoNotOptimize(component);
+    }
+  }
+}
+BENCHMARK(iterate_components)->Arg(4)->Arg(16);
+
+void iterate_components_reverse(benchmark::State& state) {
+  auto path = makePath(state.range(0));
+  RelativePathPiece piece{path};
+  for (auto _ : state) {
+    for (auto component : piece.rcomponents()) {
+      benchmark::DoNotOptimize(component);
+    }
+  }
+}
+BENCHMARK(iterate_components_reverse)->Arg(4)->Arg(16);
+
+void iterate_parents_reverse(benchmark::State& state) {
+  auto path = makePath(state.range(0));
+  RelativePathPiece piece{path};
+  for (auto _ : state) {
+    for (auto parent : piece.rpaths()) {
+      benchmark::DoNotOptimize(parent);
+    }
+  }
+}
+BENCHMARK(iterate_parents_reverse)->Arg(4)->Arg(16);
+
+void split_dirname_basename(benchmark::State& state) {
+  auto path = makePath(state.range(0));
+  RelativePathPiece piece{path};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(piece.dirname());
+    benchmark::DoNotOptimize(piece.basename());
+  }
+}
+BENCHMARK(split_dirname_basename)->Arg(4)->Arg(16);
+
+} // namespace
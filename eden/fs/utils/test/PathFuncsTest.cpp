@@ -749,6 +749,43 @@ TEST(PathFuncs, basename) {
   EXPECT_EQ("foo", basename(StringPiece("foo")));
 }
 
+TEST(PathFuncs, separatorScansCrossChunks) {
+  // Separators are searched for 16 bytes at a time: put one on either side of
+  // each chunk boundary.
+  for (size_t pos = 1; pos < 40; ++pos) {
+    std::string path(pos, 'a');
+    path += '/';
+    path += std::string(40 - pos, 'b');
+    SCOPED_TRACE(path);
+
+    EXPECT_EQ(std::string(pos, 'a'), dirname(path));
+    EXPECT_EQ(std::string(40 - pos, 'b'), basename(std::string_view{path}));
+
+    RelativePathPiece piece{path};
+    std::vector<std::string> components;
+    for (auto component : piece.components()) {
+      components.emplace_back(component.view());
+    }
+    EXPECT_EQ(
+        (std::vector<std::string>{
+            std::string(pos, 'a'), std::string(40 - pos, 'b')}),
+        components);
+    components.clear();
+    for (auto component : piece.rcomponents()) {
+      components.emplace_back(component.view());
+    }
+    EXPECT_EQ(
+        (std::vector<std::string>{
+            std::string(40 - pos, 'b'), std::string(pos, 'a')}),
+        components);
+
+    EXPECT_THROW(
+        PathComponentPiece{path}, PathComponentContainsDirectorySeparator);
+    path[pos] = '\0';
+    EXPECT_THROW(PathComponentPiece{path}, PathComponentValidationError);
+  }
+}
+
 TEST(PathFuncs, isSubDir) {
   // Helper functions that convert string arguments to RelativePathPiece
   auto isSubdir = [](StringPiece a, StringPiece b) {
@@ -244,6 +244,30 @@ TEST(PathMap, emplace) {
   EXPECT_TRUE(map.at("one"_pc).dummy) << "didn't change value to false";
 }
 
+TEST(PathMap, emplace_keeps_order_whatever_the_insertion_order) {
+  PathMap<int> map(kPathMapDefaultCaseSensitive);
+  map.emplace("b"_pc, 1);
+  map.emplace("d"_pc, 2);
+  map.emplace("a"_pc, 3);
+  map.emplace("c"_pc, 4);
+  map.emplace("e"_pc, 5);
+  EXPECT_FALSE(map.emplace("d"_pc, 6).second);
+
+  std::vector<PathComponentPiece> keys;
+  for (const auto& it : map) {
+    keys.emplace_back(it.first);
+  }
+  std::vector<PathComponentPiece> expect{
+      "a"_pc,
+      "b"_pc,
+      "c"_pc,
+      "d"_pc,
+      "e"_pc,
+  };
+  EXPECT_EQ(expect, keys);
+  EXPECT_EQ(2, map.at("d"_pc));
+}
+
 TEST(PathMap, swap) {
   PathMap<std::string> b(kPathMapDefaultCaseSensitive),
       a({std::make_pair(PathComponent("foo"), "foo")},
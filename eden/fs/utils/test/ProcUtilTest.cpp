@@ -9,10 +9,12 @@
 
 #include "eden/fs/utils/ProcUtil.h"
 
+#include <algorithm>
 #include <fstream>
 
 #include <folly/Portability.h>
 #include <folly/portability/GTest.h>
+#include <folly/system/ThreadId.h>
 #include "eden/fs/utils/PathFuncs.h"
 
 using namespace facebook::eden;
@@ -176,4 +178,30 @@ TEST(proc_util, noProcSmapsNoThrow) {
   EXPECT_EQ(privateBytes, 0);
 }
 
+TEST(proc_util, parseThreadStat) {
+  proc_util::ThreadState thread;
+  EXPECT_TRUE(proc_util::parseThreadStat(
+      "1234 (fuse (worker)) D 1 1234 1234 0 -1 4194624\n", thread));
+  EXPECT_EQ("fuse (worker)", thread.name);
+  EXPECT_EQ('D', thread.state);
+
+  EXPECT_FALSE(proc_util::parseThreadStat("1234 (truncated", thread));
+  EXPECT_FALSE(proc_util::parseThreadStat("1234 (edenfs)", thread));
+}
+
+TEST(proc_util, readThreadStates) {
+  auto threads = proc_util::readThreadStates();
+  if (!folly::kIsLinux) {
+    EXPECT_TRUE(threads.empty());
+    return;
+  }
+  // At least the thread running this test is there, and running.
+  auto self = std::find_if(
+      threads.begin(), threads.end(), [](const proc_util::ThreadState& t) {
+        return t.tid == static_cast<pid_t>(folly::getOSThreadID());
+      });
+  ASSERT_NE(self, threads.end());
+  EXPECT_EQ('R', self->state);
+}
+
 #endif
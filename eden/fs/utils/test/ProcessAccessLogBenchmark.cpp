@@ -33,3 +33,20 @@ BENCHMARK_DEFINE_F(ProcessAccessLogFixture, add_self)(benchmark::State& state) {
 }
 
 BENCHMARK_REGISTER_F(ProcessAccessLogFixture, add_self)->Threads(kThreadCount);
+
+/**
+ * Accesses interleaved from several processes, which miss the per-thread
+ * cache of the last pid's counts.
+ */
+BENCHMARK_DEFINE_F(ProcessAccessLogFixture, add_interleaved)
+(benchmark::State& state) {
+  auto myPid = getpid();
+  pid_t i = 0;
+  for (auto _ : state) {
+    processAccessLog.recordAccess(
+        myPid + (i++ % 4), ProcessAccessLog::AccessType::FsChannelOther);
+  }
+}
+
+BENCHMARK_REGISTER_F(ProcessAccessLogFixture, add_interleaved)
+    ->Threads(kThreadCount);
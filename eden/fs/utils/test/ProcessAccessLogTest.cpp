@@ -44,6 +44,26 @@ TEST(ProcessAccessLog, accessIncrementsAccessCount) {
   EXPECT_THAT(log.getAccessCounts(10s), Contains(std::pair{pid, ac}));
 }
 
+TEST(ProcessAccessLog, interleavedAccessesAreCountedAcrossReads) {
+  auto log = ProcessAccessLog{std::make_shared<ProcessNameCache>()};
+  auto read = ProcessAccessLog::AccessType::FsChannelRead;
+
+  log.recordAccess(42, read);
+  log.recordAccess(43, read);
+  log.recordAccess(42, read);
+  log.recordDuration(42, 5ns);
+  // Reading merges and clears the thread's buckets, later accesses must not
+  // be lost.
+  log.getAccessCounts(10s);
+  log.recordAccess(42, read);
+  log.recordDuration(42, 5ns);
+
+  auto counts = log.getAccessCounts(10s);
+  EXPECT_EQ(3, *counts[42].fsChannelReads_ref());
+  EXPECT_EQ(10, *counts[42].fsChannelDurationNs_ref());
+  EXPECT_EQ(1, *counts[43].fsChannelReads_ref());
+}
+
 TEST(ProcessAccessLog, accessAddsProcessToProcessNameCache) {
   auto pid = pid_t{1};
   auto processNameCache = std::make_shared<ProcessNameCache>();
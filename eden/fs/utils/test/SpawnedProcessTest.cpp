@@ -30,6 +30,20 @@ TEST(SpawnedProcess, cwd_slash) {
   EXPECT_EQ("/\n", outputs.first);
 }
 
+TEST(SpawnedProcess, cwd_with_executable_path) {
+  Options opts;
+  opts.nullStdin();
+  opts.pipeStdout();
+  opts.chdir(kRootAbsPath);
+  opts.executablePath(canonicalPath("/bin/sh"));
+  SpawnedProcess proc({"custom-argv0", "-c", "pwd"}, std::move(opts));
+
+  auto outputs = proc.communicate();
+  proc.wait();
+
+  EXPECT_EQ("/\n", outputs.first);
+}
+
 TEST(SpawnedProcess, cwd_inherit) {
   Options opts;
   opts.nullStdin();
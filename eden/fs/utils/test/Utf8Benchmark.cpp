@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/Utf8.h"
+
+#include <benchmark/benchmark.h>
+#include <fmt/format.h>
+
+using namespace facebook::eden;
+
+namespace {
+
+/**
+ * Paths shaped like those of a large source repository. One in every
+ * nonAsciiEvery paths has a non-ASCII component, as in localized resources.
+ */
+std::vector<std::string> makePaths(size_t nonAsciiEvery) {
+  std::vector<std::string> paths;
+  for (size_t i = 0; i < 10000; ++i) {
+    auto path = fmt::format(
+        "fbcode/project{}/src/module_{}/subdir/source_file_{}.cpp",
+        i % 37,
+        i % 101,
+        i);
+    if (nonAsciiEvery && i % nonAsciiEvery == 0) {
+      path += reinterpret_cast<const char*>(u8"/r\u00E9sum\u00E9.txt");
+    }
+    paths.push_back(std::move(path));
+  }
+  return paths;
+}
+
+void is_valid_utf8(benchmark::State& state) {
+  auto paths = makePaths(state.range(0));
+  size_t bytes = 0;
+  for (auto _ : state) {
+    for (const auto& path : paths) {
+      benchmark::DoNotOptimize(isValidUtf8(path));
+      bytes += path.size();
+    }
+  }
+  state.SetBytesProcessed(bytes);
+}
+BENCHMARK(is_valid_utf8)->Arg(0)->Arg(10);
+
+void ensure_valid_utf8(benchmark::State& state) {
+  auto paths = makePaths(state.range(0));
+  size_t bytes = 0;
+  for (auto _ : state) {
+    for (const auto& path : paths) {
+      benchmark::DoNotOptimize(
+          ensureValidUtf8(folly::ByteRange{folly::StringPiece{path}}));
+      bytes += path.size();
+    }
+  }
+  state.SetBytesProcessed(bytes);
+}
+BENCHMARK(ensure_valid_utf8)->Arg(0)->Arg(10);
+
+} // namespace
@@ -50,3 +50,22 @@ TEST(Utf8String, ensureValidUtf8) {
       reinterpret_cast<const char*>(u8"\uFFFDprefix\uFFFD"),
       ensureValidUtf8("\xA0prefix\xB0"));
 }
+
+TEST(Utf8Test, nonAsciiAcrossChunks) {
+  // ASCII runs are skipped 16 bytes at a time: put the non-ASCII bytes at
+  // every offset around the chunk boundaries.
+  for (size_t pos = 0; pos < 40; ++pos) {
+    SCOPED_TRACE(pos);
+    std::string valid = std::string(pos, 'a') +
+        reinterpret_cast<const char*>(u8"\u00A2") + std::string(40 - pos, 'b');
+    EXPECT_TRUE(isValidUtf8(valid));
+    EXPECT_EQ(valid, ensureValidUtf8(folly::StringPiece{valid}));
+
+    std::string invalid = std::string(pos, 'a') + "\xff" + std::string(40, 'b');
+    EXPECT_FALSE(isValidUtf8(invalid));
+    EXPECT_EQ(
+        std::string(pos, 'a') + reinterpret_cast<const char*>(u8"\uFFFD") +
+            std::string(40, 'b'),
+        ensureValidUtf8(folly::StringPiece{invalid}));
+  }
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/WorkStealingExecutor.h"
+
+#include <benchmark/benchmark.h>
+#include <folly/synchronization/Baton.h>
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/utils/UnboundedQueueExecutor.h"
+
+using namespace facebook::eden;
+
+namespace {
+
+constexpr size_t kThreadCount = 8;
+
+/**
+ * A node of a tree walk, like diff or checkout: it reads the data of its
+ * parent, writes its own, and adds a task per child.
+ */
+struct TreeWalk {
+  folly::Executor& executor;
+  size_t fanOut;
+  std::atomic<size_t> remaining{1};
+  folly::Baton<> done;
+
+  void visit(size_t depth, std::shared_ptr<std::vector<uint64_t>> parent) {
+    auto data = std::make_shared<std::vector<uint64_t>>(parent->size());
+    for (size_t i = 0; i < parent->size(); ++i) {
+      (*data)[i] = (*parent)[i] * 31 + depth;
+    }
+    benchmark::DoNotOptimize(data->data());
+
+    if (depth > 0) {
+      remaining.fetch_add(fanOut);
+      for (size_t i = 0; i < fanOut; ++i) {
+        executor.add([this, depth, data] { visit(depth - 1, data); });
+      }
+    }
+    if (remaining.fetch_sub(1) == 1) {
+      done.post();
+    }
+  }
+};
+
+void walkTrees(benchmark::State& state, UnboundedQueueExecutor& executor) {
+  // 8^5 = 37449 nodes, each with 2KiB of data.
+  constexpr size_t kDepth = 5;
+  constexpr size_t kFanOut = 8;
+  auto root = std::make_shared<std::vector<uint64_t>>(256, 1);
+  for (auto _ : state) {
+    TreeWalk walk{executor, kFanOut};
+    executor.add([&] { walk.visit(kDepth, root); });
+    walk.done.wait();
+  }
+}
+
+void tree_walk_fifo(benchmark::State& state) {
+  UnboundedQueueExecutor executor{
+      kThreadCount, "fifo", UnboundedQueueExecutor::Scheduling::Fifo};
+  walkTrees(state, executor);
+}
+BENCHMARK(tree_walk_fifo)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+void tree_walk_work_stealing(benchmark::State& state) {
+  UnboundedQueueExecutor executor{
+      kThreadCount,
+      "work-stealing",
+      UnboundedQueueExecutor::Scheduling::WorkStealing};
+  walkTrees(state, executor);
+}
+BENCHMARK(tree_walk_work_stealing)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+} // namespace
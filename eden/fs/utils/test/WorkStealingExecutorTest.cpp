@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/WorkStealingExecutor.h"
+
+#include <folly/portability/GTest.h>
+#include <folly/synchronization/Baton.h>
+
+using namespace facebook::eden;
+
+namespace {
+/**
+ * Add a task which adds fanOut children, down to the given depth, and post
+ * done once the last one has run.
+ */
+void addTree(
+    folly::Executor& executor,
+    size_t depth,
+    size_t fanOut,
+    std::atomic<size_t>& remaining,
+    folly::Baton<>& done) {
+  executor.add([&executor, depth, fanOut, &remaining, &done] {
+    if (depth > 0) {
+      remaining.fetch_add(fanOut);
+      for (size_t i = 0; i < fanOut; ++i) {
+        addTree(executor, depth - 1, fanOut, remaining, done);
+      }
+    }
+    if (remaining.fetch_sub(1) == 1) {
+      done.post();
+    }
+  });
+}
+} // namespace
+
+TEST(WorkStealingExecutorTest, runs_recursively_added_tasks) {
+  WorkStealingExecutor executor{4, "test"};
+  std::atomic<size_t> remaining{1};
+  folly::Baton<> done;
+  addTree(executor, 5, 4, remaining, done);
+  done.wait();
+  EXPECT_EQ(0, remaining.load());
+}
+
+TEST(WorkStealingExecutorTest, runs_tasks_added_by_a_task_last_first) {
+  WorkStealingExecutor executor{1, "test"};
+  std::vector<int> order;
+  folly::Baton<> done;
+  executor.add([&] {
+    executor.add([&] {
+      order.push_back(1);
+      done.post();
+    });
+    executor.add([&] { order.push_back(2); });
+  });
+  done.wait();
+  EXPECT_EQ((std::vector<int>{2, 1}), order);
+}
+
+TEST(WorkStealingExecutorTest, runs_tasks_added_from_outside_in_order) {
+  WorkStealingExecutor executor{1, "test"};
+  folly::Baton<> blocked;
+  executor.add([&] { blocked.wait(); });
+
+  std::vector<int> order;
+  folly::Baton<> done;
+  executor.add([&] { order.push_back(1); });
+  executor.add([&] { order.push_back(2); });
+  executor.add([&] {
+    order.push_back(3);
+    done.post();
+  });
+  blocked.post();
+  done.wait();
+  EXPECT_EQ((std::vector<int>{1, 2, 3}), order);
+}
+
+TEST(WorkStealingExecutorTest, runs_higher_priorities_first) {
+  WorkStealingExecutor executor{1, "test"};
+  EXPECT_EQ(3, executor.getNumPriorities());
+  folly::Baton<> blocked;
+  executor.add([&] { blocked.wait(); });
+
+  std::vector<int> order;
+  folly::Baton<> done;
+  executor.addWithPriority(
+      [&] {
+        order.push_back(folly::Executor::LO_PRI);
+        done.post();
+      },
+      folly::Executor::LO_PRI);
+  executor.add([&] { order.push_back(folly::Executor::MID_PRI); });
+  executor.addWithPriority(
+      [&] { order.push_back(folly::Executor::HI_PRI); },
+      folly::Executor::HI_PRI);
+  blocked.post();
+  done.wait();
+  EXPECT_EQ(
+      (std::vector<int>{
+          folly::Executor::HI_PRI,
+          folly::Executor::MID_PRI,
+          folly::Executor::LO_PRI}),
+      order);
+}
+
+TEST(WorkStealingExecutorTest, runs_remaining_tasks_when_destroyed) {
+  std::atomic<size_t> count{0};
+  {
+    WorkStealingExecutor executor{2, "test"};
+    for (size_t i = 0; i < 100; ++i) {
+      executor.add([&] { ++count; });
+    }
+  }
+  EXPECT_EQ(100, count.load());
+}
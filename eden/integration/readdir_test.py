@@ -24,6 +24,7 @@ from facebook.eden.ttypes import (
     FileAttributeDataOrErrorV2,
     FileAttributeDataV2,
     FileAttributes,
+    GetAttributesFromFilesColumnarResult,
     GetAttributesFromFilesParams,
     GetAttributesFromFilesResult,
     GetAttributesFromFilesResultV2,
@@ -187,6 +188,17 @@ class ReaddirTest(testcase.EdenRepoTest):
             )
             return client.getAttributesFromFilesV2(thrift_params)
 
+    def get_attributes_columnar(
+        self, files: List[bytes], req_attr: int
+    ) -> GetAttributesFromFilesColumnarResult:
+        with self.get_thrift_client_legacy() as client:
+            thrift_params = GetAttributesFromFilesParams(
+                self.mount_path_bytes,
+                files,
+                req_attr,
+            )
+            return client.getAttributesFromFilesColumnar(thrift_params)
+
     def get_all_attributes(self, files: List[bytes]) -> GetAttributesFromFilesResult:
         return self.get_attributes(files, ALL_ATTRIBUTES)
 
@@ -485,6 +497,53 @@ class ReaddirTest(testcase.EdenRepoTest):
         self.assertEqual(1, len(results_v2.res))
         self.assertEqual(expected_result_v2, results_v2)
 
+    def test_get_attributes_columnar(self) -> None:
+        paths = [b"hello", b"i_do_not_exist", b"adir/file", b"adir"]
+        columns = self.get_attributes_columnar(paths, ALL_ATTRIBUTES)
+        results_v2 = self.get_all_attributes_v2(paths)
+
+        # Only the missing file and the directory, which has no sha1, are
+        # in error.
+        self.assertEqual(bytes([0b1010]), columns.errorBitmap)
+        self.assertEqual(
+            [
+                results_v2.res[1].get_error(),
+                results_v2.res[3].fileAttributeData.sha1.get_error(),
+            ],
+            columns.errors,
+        )
+
+        for index in (0, 2):
+            data = results_v2.res[index].fileAttributeData
+            self.assertEqual(
+                data.sha1.get_sha1(), columns.sha1s[index * 20 : (index + 1) * 20]
+            )
+            self.assertEqual(
+                data.blake3.get_blake3(),
+                columns.blake3s[index * 32 : (index + 1) * 32],
+            )
+            self.assertEqual(data.size.get_size(), columns.sizes[index])
+            self.assertEqual(
+                data.sourceControlType.get_sourceControlType(),
+                columns.sourceControlTypes[index],
+            )
+            self.assertEqual(data.objectId.get_objectId(), columns.objectIds[index])
+        self.assertEqual(bytes(20), columns.sha1s[20:40])
+        self.assertEqual(0, columns.sizes[3])
+
+    def test_get_attributes_columnar_only_fills_requested_columns(self) -> None:
+        columns = self.get_attributes_columnar(
+            [b"hello", b"adir"], FileAttributes.SOURCE_CONTROL_TYPE
+        )
+        self.assertEqual(bytes([0]), columns.errorBitmap)
+        self.assertEqual([], columns.errors)
+        self.assertEqual(
+            [SourceControlType.REGULAR_FILE, SourceControlType.TREE],
+            columns.sourceControlTypes,
+        )
+        self.assertEqual(b"", columns.sha1s)
+        self.assertEqual([], columns.sizes)
+
     def test_get_attributes_socket(self) -> None:
         sockpath = self.get_path("adir/asock")
         # UDS are not supported in python on Win until 3.9:
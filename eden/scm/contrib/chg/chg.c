@@ -43,6 +43,13 @@ struct cmdserveropts {
   const char* cli_name;
 };
 
+/* seconds spent in the phases of chg_main, see printtimings */
+static struct {
+  double spawn; /* waiting for new servers to listen */
+  double validate; /* checking servers are compatible, restarting if not */
+  double run; /* running the command */
+} timings;
+
 static void initcmdserveropts(struct cmdserveropts* opts) {
   memset(opts, 0, sizeof(struct cmdserveropts));
 }
@@ -168,6 +175,7 @@ static hgclient_t* retryconnectcmdserver(
     pid_t pid) {
   static const struct timespec sleepreq = {0, 10 * 1000000};
   int pst = 0;
+  double startedat = chg_now();
 
   debugmsg("try connect to %s repeatedly", opts->initsockname);
 
@@ -183,6 +191,7 @@ static hgclient_t* retryconnectcmdserver(
       int r = unlink(opts->initsockname);
       if (r != 0)
         abortmsgerrno("cannot unlink");
+      timings.spawn += chg_now() - startedat;
       return hgc;
     }
 
@@ -297,6 +306,25 @@ static void execoriginalhg(const char* argv[], const char* cli_name) {
     abortmsgerrno("failed to exec original hg");
 }
 
+/*
+ * Report where the time before the command ran went, to tell a slow server
+ * startup or validation from a slow command. Connect, hello and attach are
+ * those of the server that ran the command.
+ */
+static void printtimings(const hgclient_t* hgc) {
+  const hgc_timings_t* t = hgc_timings(hgc);
+  fprintf(
+      stderr,
+      "chg: timing: spawn %.6f s, connect %.6f s, hello %.6f s, "
+      "attach %.6f s, validate %.6f s, run %.6f s\n",
+      timings.spawn,
+      t->connect,
+      t->hello,
+      t->attach,
+      timings.validate,
+      timings.run);
+}
+
 static int configint(const char* name, int fallback) {
   const char* str = getenv(name);
   int value = fallback;
@@ -342,11 +370,16 @@ int chg_main(
   initcmdserveropts(&opts);
   setcmdserveropts(&opts, cli_name);
 
+  /* with --prewarm-chg-daemon, only start a server, or restart the running
+   * one if it is not compatible. scripts run after an upgrade or at login
+   * can use this to take the server startup out of the next command. */
+  int prewarm = 0;
   if (argc == 2) {
     if (strcmp(argv[1], "--kill-chg-daemon") == 0) {
       killcmdserver(&opts);
       return 0;
     }
+    prewarm = strcmp(argv[1], "--prewarm-chg-daemon") == 0;
   }
 
   hgclient_t* hgc;
@@ -355,6 +388,7 @@ int chg_main(
     hgc = connectcmdserver(&opts);
     if (!hgc)
       abortmsg("cannot open hg client");
+    double validatestartedat = chg_now();
     int needreconnect = 0;
 #ifdef HAVE_VERSIONHASH
     unsigned long long versionhash = hgc_versionhash(hgc);
@@ -402,6 +436,9 @@ int chg_main(
       debugmsg("groups match");
     }
 
+    timings.validate += chg_now() - validatestartedat;
+    debugmsg("validated in %.6f s", chg_now() - validatestartedat);
+
     if (!needreconnect) {
       hgc_setenv(hgc, envp);
     }
@@ -418,10 +455,20 @@ int chg_main(
           gethgcmd(cli_name));
   }
 
+  if (prewarm) {
+    debugmsg("server is ready, not running a command");
+    hgc_close(hgc);
+    return 0;
+  }
+
   setupsignalhandler(hgc_peerpid(hgc), hgc_peerpgid(hgc));
   atexit(waitpager);
+  double runstartedat = chg_now();
   int exitcode = hgc_runcommand(hgc, argv + 1, argc - 1);
+  timings.run = chg_now() - runstartedat;
   restoresignalhandler();
+  if (getenv("CHGTIMING"))
+    printtimings(hgc);
   hgc_close(hgc);
 
   return exitcode;
@@ -69,6 +69,7 @@ struct hgclient_tag_ {
   unsigned long long versionhash;
   unsigned long nofile;
   double connectedat;
+  hgc_timings_t timings;
   int num_groups;
   gid_t* groups;
 };
@@ -499,6 +500,7 @@ static void forwardumask(hgclient_t* hgc) {
  * If no background server running, returns NULL.
  */
 hgclient_t* hgc_open(const char* sockname) {
+  double startedat = chg_now();
   int fd = socket(AF_UNIX, SOCK_STREAM, 0);
   if (fd < 0)
     abortmsgerrno("cannot create socket");
@@ -553,15 +555,16 @@ hgclient_t* hgc_open(const char* sockname) {
     close(fd);
     return NULL;
   }
-  debugmsg("connected to %s", addr.sun_path);
-
   hgclient_t* hgc = chg_mallocx(sizeof(hgclient_t));
   memset(hgc, 0, sizeof(*hgc));
   hgc->connectedat = chg_now();
+  hgc->timings.connect = hgc->connectedat - startedat;
+  debugmsg("connected to %s in %.6f s", addr.sun_path, hgc->timings.connect);
   hgc->sockfd = fd;
   initcontext(&hgc->ctx);
 
   readhello(hgc);
+  hgc->timings.hello = chg_now() - hgc->connectedat;
   if (!(hgc->capflags & CAP_RUNCOMMAND))
     abortmsg("insufficient capability: runcommand");
   if (hgc->capflags & CAP_SETPROCNAME)
@@ -572,6 +575,11 @@ hgclient_t* hgc_open(const char* sockname) {
     chdirtocwd(hgc);
   if (hgc->capflags & CAP_SETUMASK)
     forwardumask(hgc);
+  hgc->timings.attach = hgc_elapsed(hgc) - hgc->timings.hello;
+  debugmsg(
+      "hello took %.6f s, attach took %.6f s",
+      hgc->timings.hello,
+      hgc->timings.attach);
 
   return hgc;
 }
@@ -700,3 +708,11 @@ void hgc_setenv(hgclient_t* hgc, const char* const envp[]) {
 double hgc_elapsed(hgclient_t* hgc) {
   return chg_now() - hgc->connectedat;
 }
+
+/*!
+ * How long the phases of hgc_open took.
+ */
+const hgc_timings_t* hgc_timings(const hgclient_t* hgc) {
+  assert(hgc);
+  return &hgc->timings;
+}
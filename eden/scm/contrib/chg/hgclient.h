@@ -15,6 +15,13 @@
 struct hgclient_tag_;
 typedef struct hgclient_tag_ hgclient_t;
 
+/* seconds spent in the phases of hgc_open */
+typedef struct {
+  double connect; /* connecting the socket */
+  double hello; /* reading the hello message */
+  double attach; /* sending procname, stdio, cwd and umask */
+} hgc_timings_t;
+
 hgclient_t* hgc_open(const char* sockname);
 void hgc_close(hgclient_t* hgc);
 
@@ -31,5 +38,6 @@ void hgc_attachio(hgclient_t* hgc);
 void hgc_setenv(hgclient_t* hgc, const char* const envp[]);
 
 double hgc_elapsed(hgclient_t* hgc);
+const hgc_timings_t* hgc_timings(const hgclient_t* hgc);
 
 #endif /* HGCLIENT_H_ */
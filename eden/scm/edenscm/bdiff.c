@@ -24,27 +24,51 @@
 #include "eden/scm/edenscm/bitmanipulation.h"
 #include "eden/scm/edenscm/compat.h"
 
-/* Hash implementation from diffutils */
-#define ROL(v, n) ((v) << (n) | (v) >> (sizeof(v) * CHAR_BIT - (n)))
-#define HASH(h, c) ((c) + ROL(h, 7))
-
 struct pos {
   int pos, len;
 };
 
+/*
+ * Hash a line a word at a time. The hash only needs to be consistent within
+ * a single diff: lines are grouped by their contents and the hash merely
+ * picks their bucket, so it doesn't affect the output.
+ */
+static inline unsigned hashline(const char* p, ssize_t len) {
+  const uint64_t k = 0x9e3779b97f4a7c15ULL;
+  uint64_t h = (uint64_t)len * k, w;
+
+  for (; len >= 8; p += 8, len -= 8) {
+    memcpy(&w, p, 8);
+    h = ((h << 5 | h >> 59) ^ w) * k;
+  }
+  if (len > 0) {
+    w = 0;
+    memcpy(&w, p, len);
+    h = ((h << 5 | h >> 59) ^ w) * k;
+  }
+
+  /* mix the high bits into the low ones, which pick the bucket */
+  h ^= h >> 32;
+  h *= k;
+  h ^= h >> 29;
+  return (unsigned)h;
+}
+
 int bdiff_splitlines(const char* a, ssize_t len, struct bdiff_line** lr) {
-  unsigned hash;
   int i;
-  const char *p, *b = a;
-  const char* const plast = a + len - 1;
+  const char *p, *b;
+  const char* const end = a + len;
   struct bdiff_line* l;
 
-  /* count the lines */
+  /* count the lines, letting memchr scan for newlines in bulk */
   i = 1; /* extra line for sentinel */
-  for (p = a; p < plast; p++)
-    if (*p == '\n')
-      i++;
-  if (p == plast)
+  for (p = a; p < end; p++) {
+    p = (const char*)memchr(p, '\n', end - p);
+    if (!p)
+      break;
+    i++;
+  }
+  if (len > 0 && a[len - 1] != '\n')
     i++;
 
   *lr = l = (struct bdiff_line*)malloc(sizeof(struct bdiff_line) * i);
@@ -52,25 +76,11 @@ int bdiff_splitlines(const char* a, ssize_t len, struct bdiff_line** lr) {
     return -1;
 
   /* build the line array and calculate hashes */
-  hash = 0;
-  for (p = a; p < plast; p++) {
-    hash = HASH(hash, *p);
-
-    if (*p == '\n') {
-      l->hash = hash;
-      hash = 0;
-      l->len = p - b + 1;
-      l->l = b;
-      l->n = INT_MAX;
-      l++;
-      b = p + 1;
-    }
-  }
-
-  if (p == plast) {
-    hash = HASH(hash, *p);
-    l->hash = hash;
-    l->len = p - b + 1;
+  for (b = a; b < end; b = p) {
+    p = (const char*)memchr(b, '\n', end - b);
+    p = p ? p + 1 : end;
+    l->len = p - b;
+    l->hash = (int)hashline(b, l->len);
     l->l = b;
     l->n = INT_MAX;
     l++;
@@ -18,6 +18,14 @@
 #include <Python.h>
 #include <assert.h>
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CHARENCODE_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define CHARENCODE_NEON 1
+#endif
+
 #include "eden/scm/edenscm/cext/charencode.h"
 #include "eden/scm/edenscm/cext/util.h"
 #include "eden/scm/edenscm/compat.h"
@@ -123,6 +131,90 @@ static const char hexchartable[16] = {
     'f',
 };
 
+#if defined(CHARENCODE_SSE2) || defined(CHARENCODE_NEON)
+/*
+ * The vectorized paths below look at 16 bytes at a time and leave the rest
+ * of a string, and any chunk they can't handle on their own, to the loops
+ * over single bytes.
+ */
+#define CHARENCODE_SIMD 1
+#define SIMD_WIDTH 16
+
+/* Whether none of the 16 bytes at p has its top bit set. */
+static inline bool isascii16(const char* p) {
+#ifdef CHARENCODE_SSE2
+  __m128i c = _mm_loadu_si128((const __m128i*)p);
+  return _mm_movemask_epi8(c) == 0;
+#else
+  return vmaxvq_u8(vld1q_u8((const uint8_t*)p)) < 0x80;
+#endif
+}
+
+/*
+ * Copy the 16 ASCII bytes at src to dst, flipping the case of the letters
+ * from first to first + 25: 'A' lowers them and 'a' uppers them, as
+ * lowertable and uppertable do.
+ */
+static inline void flipcase16(char* dst, const char* src, char first) {
+#ifdef CHARENCODE_SSE2
+  __m128i c = _mm_loadu_si128((const __m128i*)src);
+  /* signed comparisons are fine as no byte is above 0x7f */
+  __m128i letter = _mm_and_si128(
+      _mm_cmpgt_epi8(c, _mm_set1_epi8(first - 1)),
+      _mm_cmplt_epi8(c, _mm_set1_epi8(first + 26)));
+  _mm_storeu_si128(
+      (__m128i*)dst,
+      _mm_xor_si128(c, _mm_and_si128(letter, _mm_set1_epi8(0x20))));
+#else
+  uint8x16_t c = vld1q_u8((const uint8_t*)src);
+  uint8x16_t letter = vandq_u8(
+      vcgeq_u8(c, vdupq_n_u8(first)), vcleq_u8(c, vdupq_n_u8(first + 25)));
+  vst1q_u8(
+      (uint8_t*)dst, veorq_u8(c, vandq_u8(letter, vdupq_n_u8(0x20))));
+#endif
+}
+
+/*
+ * Whether the 16 bytes at p are all left alone by JSON escaping, i.e. have
+ * a length of 1 in jsonlentable, or in jsonparanoidlentable if paranoid.
+ */
+static inline bool jsonplain16(const char* p, bool paranoid) {
+#ifdef CHARENCODE_SSE2
+  __m128i c = _mm_loadu_si128((const __m128i*)p);
+  /* control characters are those left unchanged by min(c, 0x1f) */
+  __m128i esc = _mm_or_si128(
+      _mm_cmpeq_epi8(_mm_min_epu8(c, _mm_set1_epi8(0x1f)), c),
+      _mm_or_si128(
+          _mm_or_si128(
+              _mm_cmpeq_epi8(c, _mm_set1_epi8('"')),
+              _mm_cmpeq_epi8(c, _mm_set1_epi8('\\'))),
+          _mm_cmpeq_epi8(c, _mm_set1_epi8(0x7f))));
+  if (paranoid) {
+    /* movemask below picks up non-ASCII bytes by their top bit */
+    esc = _mm_or_si128(
+        _mm_or_si128(esc, c),
+        _mm_or_si128(
+            _mm_cmpeq_epi8(c, _mm_set1_epi8('<')),
+            _mm_cmpeq_epi8(c, _mm_set1_epi8('>'))));
+  }
+  return _mm_movemask_epi8(esc) == 0;
+#else
+  uint8x16_t c = vld1q_u8((const uint8_t*)p);
+  uint8x16_t esc = vorrq_u8(
+      vcleq_u8(c, vdupq_n_u8(0x1f)),
+      vorrq_u8(
+          vorrq_u8(vceqq_u8(c, vdupq_n_u8('"')), vceqq_u8(c, vdupq_n_u8('\\'))),
+          vceqq_u8(c, vdupq_n_u8(0x7f))));
+  if (paranoid) {
+    esc = vorrq_u8(
+        vorrq_u8(esc, vcgeq_u8(c, vdupq_n_u8(0x80))),
+        vorrq_u8(vceqq_u8(c, vdupq_n_u8('<')), vceqq_u8(c, vdupq_n_u8('>'))));
+  }
+  return vmaxvq_u8(esc) == 0;
+#endif
+}
+#endif /* CHARENCODE_SSE2 || CHARENCODE_NEON */
+
 /*
  * Turn a hex-encoded string into binary.
  */
@@ -153,6 +245,12 @@ PyObject* isasciistr(PyObject* self, PyObject* args) {
   if (!PyArg_ParseTuple(args, "s#:isasciistr", &buf, &len))
     return NULL;
   i = 0;
+#ifdef CHARENCODE_SIMD
+  for (; len - i >= SIMD_WIDTH; i += SIMD_WIDTH) {
+    if (!isascii16(buf + i))
+      Py_RETURN_FALSE;
+  }
+#else
   /* char array in PyStringObject should be at least 4-byte aligned */
   if (((uintptr_t)buf & 3) == 0) {
     const uint32_t* p = (const uint32_t*)buf;
@@ -162,6 +260,7 @@ PyObject* isasciistr(PyObject* self, PyObject* args) {
     }
     i *= 4;
   }
+#endif
   for (; i < len; i++) {
     if (buf[i] & 0x80)
       Py_RETURN_FALSE;
@@ -201,7 +300,12 @@ static inline PyObject* _asciitransform(
 
   newstr = PyBytes_AS_STRING(newobj);
 
-  for (i = 0; i < len; i++) {
+  i = 0;
+#ifdef CHARENCODE_SIMD
+  for (; len - i >= SIMD_WIDTH && isascii16(str + i); i += SIMD_WIDTH)
+    flipcase16(newstr + i, str + i, table == lowertable ? 'A' : 'a');
+#endif
+  for (; i < len; i++) {
     char c = str[i];
     if (c & 0x80) {
       if (fallback_fn != NULL) {
@@ -312,7 +416,7 @@ quit:
 
 /* calculate length of JSON-escaped string; returns -1 if unsupported */
 static Py_ssize_t
-jsonescapelen(const char* buf, Py_ssize_t len, bool paranoid) {
+jsonescapelenbytes(const char* buf, Py_ssize_t len, bool paranoid) {
   Py_ssize_t i, esclen = 0;
 
   if (paranoid) {
@@ -343,6 +447,35 @@ jsonescapelen(const char* buf, Py_ssize_t len, bool paranoid) {
   return esclen;
 }
 
+static Py_ssize_t
+jsonescapelen(const char* buf, Py_ssize_t len, bool paranoid) {
+#ifdef CHARENCODE_SIMD
+  Py_ssize_t i, l, esclen = 0;
+
+  for (i = 0; len - i >= SIMD_WIDTH; i += SIMD_WIDTH) {
+    if (jsonplain16(buf + i, paranoid))
+      l = SIMD_WIDTH;
+    else if ((l = jsonescapelenbytes(buf + i, SIMD_WIDTH, paranoid)) < 0)
+      return -1;
+    esclen += l;
+    if (esclen < 0) {
+      PyErr_SetString(PyExc_MemoryError, "overflow in jsonescapelen");
+      return -1;
+    }
+  }
+  if ((l = jsonescapelenbytes(buf + i, len - i, paranoid)) < 0)
+    return -1;
+  esclen += l;
+  if (esclen < 0) {
+    PyErr_SetString(PyExc_MemoryError, "overflow in jsonescapelen");
+    return -1;
+  }
+  return esclen;
+#else
+  return jsonescapelenbytes(buf, len, paranoid);
+#endif
+}
+
 /* map '\<c>' escape character */
 static char jsonescapechar2(char c) {
   switch (c) {
@@ -374,9 +507,28 @@ static void encodejsonescape(
     bool paranoid) {
   const uint8_t* lentable = (paranoid) ? jsonparanoidlentable : jsonlentable;
   Py_ssize_t i, j;
+#ifdef CHARENCODE_SIMD
+  Py_ssize_t chunkend = 0;
+#endif
 
   for (i = 0, j = 0; i < origlen; i++) {
-    char c = origbuf[i];
+    char c;
+#ifdef CHARENCODE_SIMD
+    /* Copy chunks with nothing to escape as they are. Those that have
+     * something are escaped a byte at a time up to chunkend. */
+    while (i >= chunkend && origlen - i >= SIMD_WIDTH) {
+      chunkend = i + SIMD_WIDTH;
+      if (!jsonplain16(origbuf + i, paranoid))
+        break;
+      assert(j + SIMD_WIDTH <= esclen);
+      memcpy(escbuf + j, origbuf + i, SIMD_WIDTH);
+      i += SIMD_WIDTH;
+      j += SIMD_WIDTH;
+    }
+    if (i == origlen)
+      break;
+#endif
+    c = origbuf[i];
     uint8_t l = lentable[(unsigned char)c];
     assert(j + l <= esclen);
     switch (l) {
@@ -35,6 +35,7 @@ typedef struct {
   char hash_suffix;
   bool from_malloc;
   bool deleted;
+  int plen; /* length of the path, up to its null byte */
 } line;
 
 typedef struct {
@@ -44,15 +45,28 @@ typedef struct {
   int livelines; /* number of non-deleted lines */
   int maxlines; /* allocated number of lines */
   bool dirty;
+  /* lines[fanout[c]] is the first line whose path starts with a byte of at
+   * least c, so the lines starting with c are those up to fanout[c + 1] */
+  int fanout[257];
 } lazymanifest;
 
 #define MANIFEST_OOM -1
 #define MANIFEST_NOT_SORTED -2
 #define MANIFEST_MALFORMED -3
+#define MANIFEST_BAD_LINE -4
 
 /* get the length of the path for a line */
 static size_t pathlen(line* l) {
-  return strlen(l->start);
+  return l->plen;
+}
+
+/* compare two paths the way strcmp would */
+static int pathcmp(const char* a, size_t alen, const char* b, size_t blen) {
+  int c = memcmp(a, b, alen < blen ? alen : blen);
+  if (c != 0) {
+    return c;
+  }
+  return (alen > blen) - (alen < blen);
 }
 
 /* get the node value of a single line */
@@ -111,36 +125,73 @@ static bool realloc_if_full(lazymanifest* self) {
   return !!self->lines;
 }
 
+/* rebuild the first byte index of the (sorted) lines of 'self' */
+static void index_lines(lazymanifest* self) {
+  int i, c = 0;
+  for (i = 0; i < self->numlines; i++) {
+    int first = (unsigned char)self->lines[i].start[0];
+    while (c <= first) {
+      self->fanout[c++] = i;
+    }
+  }
+  while (c <= 256) {
+    self->fanout[c++] = self->numlines;
+  }
+}
+
 /*
  * Find the line boundaries in the manifest that 'data' points to and store
  * information about each line in 'self'.
+ *
+ * Both the newline and the null byte ending the path are found with memchr,
+ * and the order is checked on the paths alone, so every byte of the path is
+ * looked at a bounded number of times. The first byte index is filled in
+ * along the way.
  */
 static int find_lines(lazymanifest* self, char* data, Py_ssize_t len) {
   char* prev = NULL;
+  size_t prevlen = 0;
+  int c = 0;
   while (len > 0) {
     line* l;
+    char* nul;
+    int first;
     char* next = memchr(data, '\n', len);
     if (!next) {
       return MANIFEST_MALFORMED;
     }
     next++; /* advance past newline */
+    /* the path must be followed by a null byte and 40 hex digits */
+    nul = memchr(data, '\0', next - data);
+    if (!nul || next - nul < 42) {
+      return MANIFEST_BAD_LINE;
+    }
     if (!realloc_if_full(self)) {
       return MANIFEST_OOM; /* no memory */
     }
-    if (prev && strcmp(prev, data) > -1) {
+    if (prev && pathcmp(prev, prevlen, data, nul - data) >= 0) {
       /* This data isn't sorted, so we have to abort. */
       return MANIFEST_NOT_SORTED;
     }
+    first = (unsigned char)data[0];
+    while (c <= first) {
+      self->fanout[c++] = self->numlines;
+    }
     l = self->lines + ((self->numlines)++);
     l->start = data;
     l->len = next - data;
     l->hash_suffix = '\0';
     l->from_malloc = false;
     l->deleted = false;
+    l->plen = nul - data;
     len = len - l->len;
     prev = data;
+    prevlen = l->plen;
     data = next;
   }
+  while (c <= 256) {
+    self->fanout[c++] = self->numlines;
+  }
   self->livelines = self->numlines;
   return 0;
 }
@@ -179,6 +230,9 @@ static int lazymanifest_init(lazymanifest* self, PyObject* args) {
     case MANIFEST_MALFORMED:
       PyErr_Format(PyExc_ValueError, "Manifest did not end in a newline.");
       break;
+    case MANIFEST_BAD_LINE:
+      PyErr_Format(PyExc_ValueError, "Manifest line has no path and node.");
+      break;
     default:
       PyErr_Format(PyExc_ValueError, "Unknown problem parsing manifest.");
   }
@@ -394,12 +448,76 @@ static Py_ssize_t lazymanifest_size(lazymanifest* self) {
   return self->livelines;
 }
 
-static int linecmp(const void* left, const void* right) {
-  return strcmp(((const line*)left)->start, ((const line*)right)->start);
+static int linecmp(const line* left, const line* right) {
+  return pathcmp(left->start, left->plen, right->start, right->plen);
+}
+
+/*
+ * Compare path to the path of l, knowing that their first *lcp bytes are the
+ * same, and update *lcp to the length of their common prefix.
+ */
+static int
+comparefrom(const char* path, size_t plen, const line* l, size_t* lcp) {
+  const unsigned char* a = (const unsigned char*)path;
+  const unsigned char* b = (const unsigned char*)l->start;
+  size_t i = *lcp, n = plen < (size_t)l->plen ? plen : (size_t)l->plen;
+  while (i < n && a[i] == b[i]) {
+    i++;
+  }
+  *lcp = i;
+  if (i < n) {
+    return a[i] - b[i];
+  }
+  return (plen > (size_t)l->plen) - (plen < (size_t)l->plen);
+}
+
+/*
+ * Find the line for path, or the position where it would be inserted.
+ *
+ * Only the lines starting with the same byte are searched. Paths in a
+ * manifest share long directory prefixes, so the search also keeps the
+ * common prefix of path with the lines bounding the range: every line in
+ * between starts with the shorter of the two, which needn't be compared
+ * again.
+ */
+static int
+findline(lazymanifest* self, const char* path, size_t plen, bool* found) {
+  int c = (unsigned char)path[0];
+  int lo = self->fanout[c], hi = self->fanout[c + 1];
+  /* an empty path starts with the null byte, and only matches itself */
+  size_t lolcp = plen > 0 ? 1 : 0, hilcp = lolcp;
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    size_t lcp = lolcp < hilcp ? lolcp : hilcp;
+    int cmp = comparefrom(path, plen, self->lines + mid, &lcp);
+    if (cmp < 0) {
+      hi = mid;
+      hilcp = lcp;
+    } else if (cmp > 0) {
+      lo = mid + 1;
+      lolcp = lcp;
+    } else {
+      *found = true;
+      return mid;
+    }
+  }
+  *found = false;
+  return lo;
+}
+
+/* find the live line for path, or NULL */
+static line* lookup(lazymanifest* self, const char* path, Py_ssize_t plen) {
+  bool found;
+  int pos = findline(self, path, plen, &found);
+  if (!found || self->lines[pos].deleted) {
+    return NULL;
+  }
+  return self->lines + pos;
 }
 
 static PyObject* lazymanifest_getitem(lazymanifest* self, PyObject* key) {
-  line needle;
+  const char* path;
+  Py_ssize_t plen;
   line* hit;
 #ifdef IS_PY3K
   if (!PyUnicode_Check(key)) {
@@ -407,16 +525,21 @@ static PyObject* lazymanifest_getitem(lazymanifest* self, PyObject* key) {
         PyExc_TypeError, "getitem: manifest keys must be a unicode str.");
     return NULL;
   }
-  needle.start = PyUnicode_AsUTF8(key);
+  path = PyUnicode_AsUTF8AndSize(key, &plen);
+  if (!path) {
+    return NULL;
+  }
 #else
   if (!PyBytes_Check(key)) {
     PyErr_Format(PyExc_TypeError, "getitem: manifest keys must be a string.");
     return NULL;
   }
-  needle.start = PyBytes_AsString(key);
+  if (PyBytes_AsStringAndSize(key, (char**)&path, &plen) == -1) {
+    return NULL;
+  }
 #endif
-  hit = bsearch(&needle, self->lines, self->numlines, sizeof(line), &linecmp);
-  if (!hit || hit->deleted) {
+  hit = lookup(self, path, plen);
+  if (!hit) {
     PyErr_Format(PyExc_KeyError, "No such manifest entry.");
     return NULL;
   }
@@ -424,23 +547,29 @@ static PyObject* lazymanifest_getitem(lazymanifest* self, PyObject* key) {
 }
 
 static int lazymanifest_delitem(lazymanifest* self, PyObject* key) {
-  line needle;
+  const char* path;
+  Py_ssize_t plen;
   line* hit;
 #ifdef IS_PY3K
   if (!PyUnicode_Check(key)) {
     PyErr_Format(PyExc_TypeError, "delitem: manifest keys must be a str.");
     return -1;
   }
-  needle.start = PyUnicode_AsUTF8(key);
+  path = PyUnicode_AsUTF8AndSize(key, &plen);
+  if (!path) {
+    return -1;
+  }
 #else
   if (!PyBytes_Check(key)) {
     PyErr_Format(PyExc_TypeError, "delitem: manifest keys must be a string.");
     return -1;
   }
-  needle.start = PyBytes_AsString(key);
+  if (PyBytes_AsStringAndSize(key, (char**)&path, &plen) == -1) {
+    return -1;
+  }
 #endif
-  hit = bsearch(&needle, self->lines, self->numlines, sizeof(line), &linecmp);
-  if (!hit || hit->deleted) {
+  hit = lookup(self, path, plen);
+  if (!hit) {
     PyErr_Format(PyExc_KeyError, "Tried to delete nonexistent manifest entry.");
     return -1;
   }
@@ -453,22 +582,15 @@ static int lazymanifest_delitem(lazymanifest* self, PyObject* key) {
 /* Do a binary search for the insertion point for new, creating the
  * new entry if needed. */
 static int internalsetitem(lazymanifest* self, line* new) {
-  int start = 0, end = self->numlines;
-  while (start < end) {
-    int pos = start + (end - start) / 2;
-    int c = linecmp(new, self->lines + pos);
-    if (c < 0)
-      end = pos;
-    else if (c > 0)
-      start = pos + 1;
-    else {
-      if (self->lines[pos].deleted)
-        self->livelines++;
-      if (self->lines[pos].from_malloc)
-        free((void*)self->lines[pos].start);
-      start = pos;
-      goto finish;
-    }
+  bool found;
+  int c;
+  int start = findline(self, new->start, new->plen, &found);
+  if (found) {
+    if (self->lines[start].deleted)
+      self->livelines++;
+    if (self->lines[start].from_malloc)
+      free((void*)self->lines[start].start);
+    goto finish;
   }
   /* being here means we need to do an insert */
   if (!realloc_if_full(self)) {
@@ -481,6 +603,10 @@ static int internalsetitem(lazymanifest* self, line* new) {
       (self->numlines - start) * sizeof(line));
   self->numlines++;
   self->livelines++;
+  /* the lines starting with a later byte moved up by one */
+  for (c = (unsigned char)new->start[0] + 1; c <= 256; c++) {
+    self->fanout[c]++;
+  }
 finish:
   self->lines[start] = *new;
   self->dirty = true;
@@ -589,6 +715,7 @@ lazymanifest_setitem(lazymanifest* self, PyObject* key, PyObject* value) {
   }
   new.from_malloc = true; /* is `start` a pointer we allocated? */
   new.deleted = false; /* is this entry deleted? */
+  new.plen = plen;
   if (internalsetitem(self, &new)) {
     return -1;
   }
@@ -604,8 +731,8 @@ static PyMappingMethods lazymanifest_mapping_methods = {
 /* sequence methods (important or __contains__ builds an iterator) */
 
 static int lazymanifest_contains(lazymanifest* self, PyObject* key) {
-  line needle;
-  line* hit;
+  const char* path;
+  Py_ssize_t plen;
   if (
 #ifdef IS_PY3K
       !PyUnicode_Check(key)
@@ -618,15 +745,16 @@ static int lazymanifest_contains(lazymanifest* self, PyObject* key) {
     return 0;
   }
 #ifdef IS_PY3K
-  needle.start = PyUnicode_AsUTF8(key);
+  path = PyUnicode_AsUTF8AndSize(key, &plen);
+  if (!path) {
+    return -1;
+  }
 #else
-  needle.start = PyBytes_AsString(key);
-#endif
-  hit = bsearch(&needle, self->lines, self->numlines, sizeof(line), &linecmp);
-  if (!hit || hit->deleted) {
-    return 0;
+  if (PyBytes_AsStringAndSize(key, (char**)&path, &plen) == -1) {
+    return -1;
   }
-  return 1;
+#endif
+  return lookup(self, path, plen) != NULL;
 }
 
 static PySequenceMethods lazymanifest_seq_meths = {
@@ -687,6 +815,7 @@ static int compact(lazymanifest* self) {
   self->pydata = pydata;
   self->numlines = self->livelines;
   self->dirty = false;
+  index_lines(self);
   return 0;
 }
 
@@ -716,6 +845,7 @@ static lazymanifest* lazymanifest_copy(lazymanifest* self) {
     goto nomem;
   }
   memcpy(copy->lines, self->lines, self->numlines * sizeof(line));
+  memcpy(copy->fanout, self->fanout, sizeof(self->fanout));
   copy->maxlines = self->maxlines;
   copy->pydata = self->pydata;
   Py_INCREF(copy->pydata);
@@ -776,6 +906,7 @@ static lazymanifest* lazymanifest_filtercopy(
     Py_DECREF(result);
   }
   copy->livelines = copy->numlines;
+  index_lines(copy);
   return copy;
 nomem:
   PyErr_NoMemory();
@@ -834,15 +965,27 @@ static PyObject* lazymanifest_diff(lazymanifest* self, PyObject* args) {
       result = 1;
     } else if (oneedle == other->numlines) {
       result = -1;
+    } else if (
+        !listclean && left->len == right->len &&
+        left->hash_suffix == right->hash_suffix &&
+        (left->start == right->start ||
+         memcmp(left->start, right->start, left->len) == 0)) {
+      /* Whole lines are equal, so path, node and flags are. Most entries
+       * of two manifests being compared are, and there is nothing to
+       * report for them. Manifests copied from each other share their
+       * text, so those entries don't even need reading. */
+      sneedle++;
+      oneedle++;
+      continue;
     } else {
       result = linecmp(left, right);
     }
 #ifdef IS_PY3K
-    key = result <= 0 ? PyUnicode_FromString(left->start)
-                      : PyUnicode_FromString(right->start);
+    key = result <= 0 ? PyUnicode_FromStringAndSize(left->start, left->plen)
+                      : PyUnicode_FromStringAndSize(right->start, right->plen);
 #else
-    key = result <= 0 ? PyBytes_FromString(left->start)
-                      : PyBytes_FromString(right->start);
+    key = result <= 0 ? PyBytes_FromStringAndSize(left->start, left->plen)
+                      : PyBytes_FromStringAndSize(right->start, right->plen);
 #endif
     if (!key)
       goto nomem;
@@ -28,6 +28,7 @@
 #include <windows.h>
 #else
 #include <dirent.h>
+#include <pthread.h>
 #include <signal.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
@@ -35,6 +36,11 @@
 #include <unistd.h>
 #endif
 
+#ifdef __linux__
+#include <stdint.h>
+#include <sys/syscall.h>
+#endif
+
 #ifdef __APPLE__
 #include <crt_externs.h> // @manual
 #include <sys/attr.h> // @manual
@@ -405,9 +411,9 @@ error_nomem:
 
 #else
 
-int entkind(struct dirent* ent) {
+static int dtkind(int type) {
 #ifdef DT_REG
-  switch (ent->d_type) {
+  switch (type) {
     case DT_REG:
       return S_IFREG;
     case DT_DIR:
@@ -427,6 +433,14 @@ int entkind(struct dirent* ent) {
   return -1;
 }
 
+int entkind(struct dirent* ent) {
+#ifdef DT_REG
+  return dtkind(ent->d_type);
+#else
+  return -1;
+#endif
+}
+
 static PyObject* makestat(const struct stat* st) {
   PyObject* stat;
 
@@ -749,66 +763,470 @@ _listdir(const char* path, int pathlen, int keepstat, const char* skip) {
   return _listdir_stat(path, pathlen, keepstat, skip);
 }
 
-static PyObject* statfiles(PyObject* self, PyObject* args) {
-  PyObject *names, *stats;
+/* the most threads parallel_for runs at once */
+#define PARALLEL_MAX_THREADS 16
+
+struct parallel_work {
+  pthread_mutex_t lock;
+  size_t next;
+  size_t count;
+  void (*fn)(void* ctx, size_t i);
+  void* ctx;
+};
+
+static void* parallel_worker(void* arg) {
+  struct parallel_work* work = arg;
+  for (;;) {
+    size_t i;
+    pthread_mutex_lock(&work->lock);
+    i = work->next++;
+    pthread_mutex_unlock(&work->lock);
+    if (i >= work->count)
+      return NULL;
+    work->fn(work->ctx, i);
+  }
+}
+
+/*
+ * Call fn(ctx, i) for every i below count, from as many threads as there are
+ * CPUs but with at least grain items for every thread. The calling thread is
+ * one of them, so this still completes if no thread can be started. This
+ * must be called without the GIL, and fn can't use the Python API.
+ */
+static void parallel_for(
+    size_t count,
+    size_t grain,
+    void (*fn)(void* ctx, size_t i),
+    void* ctx) {
+  pthread_t threads[PARALLEL_MAX_THREADS - 1];
+  struct parallel_work work;
+  size_t nthreads = count / grain, started = 0, i;
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+  if (cpus > 0 && nthreads > (size_t)cpus)
+    nthreads = cpus;
+  if (nthreads > PARALLEL_MAX_THREADS)
+    nthreads = PARALLEL_MAX_THREADS;
+
+  pthread_mutex_init(&work.lock, NULL);
+  work.next = 0;
+  work.count = count;
+  work.fn = fn;
+  work.ctx = ctx;
+  for (i = 1; i < nthreads; i++) {
+    if (pthread_create(&threads[started], NULL, parallel_worker, &work) == 0)
+      started++;
+  }
+  parallel_worker(&work);
+  for (i = 0; i < started; i++)
+    pthread_join(threads[i], NULL);
+  pthread_mutex_destroy(&work.lock);
+}
+
+#ifdef AT_SYMLINK_NOFOLLOW
+
+/* bytes of directory entries read by every getdents64 call */
+#define LISTDIRS_BUFFER_SIZE (64 * 1024)
+
+/* directories listed by one listdirs thread at a time, at least */
+#define LISTDIRS_GRAIN 4
+
+#ifdef __linux__
+struct linux_dirent64 {
+  uint64_t d_ino;
+  int64_t d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+  char d_name[];
+};
+#endif
+
+struct dirlisting_entry {
+  size_t name; /* offset of the name in dirlisting.names */
+  int kind;
+  struct stat st;
+};
+
+/* What listdirs found in one directory, before it becomes Python objects. */
+struct dirlisting {
+  const char* path;
+  char* names;
+  size_t namesused, namesalloc;
+  struct dirlisting_entry* entries;
+  size_t count, alloc;
+  /* the errno of a failure, and the offset in names of the entry it is
+     about, or -1 if it is about the directory itself */
+  int err;
+  Py_ssize_t errname;
+  /* whether the directory held the skip directory */
+  bool skipped;
+};
+
+struct listdirs_job {
+  struct dirlisting* listings;
+  int keepstat;
+  const char* skip;
+};
+
+static Py_ssize_t dirlisting_addname(struct dirlisting* l, const char* name) {
+  size_t len = strlen(name) + 1;
+  size_t offset = l->namesused;
+  if (l->namesused + len > l->namesalloc) {
+    size_t alloc = l->namesalloc ? l->namesalloc * 2 : 4096;
+    char* names;
+    while (alloc < l->namesused + len)
+      alloc *= 2;
+    names = realloc(l->names, alloc);
+    if (!names)
+      return -1;
+    l->names = names;
+    l->namesalloc = alloc;
+  }
+  memcpy(l->names + offset, name, len);
+  l->namesused += len;
+  return offset;
+}
+
+/* Record one entry of a directory, and return whether to stop listing it. */
+static bool dirlisting_visit(
+    struct dirlisting* l,
+    int dfd,
+    const char* name,
+    int kind,
+    int keepstat,
+    const char* skip) {
+  struct dirlisting_entry* entry;
+  struct stat st;
+  Py_ssize_t offset;
+
+  if (name[0] == '.' &&
+      (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+    return false;
+
+  if (kind == -1 || keepstat) {
+    if (fstatat(dfd, name, &st, AT_SYMLINK_NOFOLLOW) == -1) {
+      /* race with file deletion? */
+      if (errno == ENOENT)
+        return false;
+      l->err = errno;
+      l->errname = dirlisting_addname(l, name);
+      return true;
+    }
+    kind = st.st_mode & S_IFMT;
+  }
+
+  /* quit early? */
+  if (skip && kind == S_IFDIR && !strcmp(name, skip)) {
+    l->skipped = true;
+    return true;
+  }
+
+  if (l->count == l->alloc) {
+    size_t alloc = l->alloc ? l->alloc * 2 : 64;
+    struct dirlisting_entry* entries =
+        realloc(l->entries, alloc * sizeof(*entries));
+    if (!entries) {
+      l->err = ENOMEM;
+      return true;
+    }
+    l->entries = entries;
+    l->alloc = alloc;
+  }
+  offset = dirlisting_addname(l, name);
+  if (offset == -1) {
+    l->err = ENOMEM;
+    return true;
+  }
+  entry = &l->entries[l->count++];
+  entry->name = offset;
+  entry->kind = kind;
+  if (keepstat)
+    entry->st = st;
+  return false;
+}
+
+/*
+ * List a directory without the GIL. On Linux the entries are read with
+ * getdents64 into a large buffer rather than through readdir, and are
+ * stat'ed relative to the directory, so that no path is resolved twice.
+ */
+static void listdirs_run(void* ctx, size_t i) {
+  struct listdirs_job* job = ctx;
+  struct dirlisting* l = &job->listings[i];
+  int dfd = open(l->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+#ifdef __linux__
+  char* buf;
+  long n, offset;
+#else
+  DIR* dir;
+  struct dirent* ent;
+#endif
+
+  if (dfd == -1) {
+    l->err = errno;
+    return;
+  }
+
+#ifdef __linux__
+  buf = malloc(LISTDIRS_BUFFER_SIZE);
+  if (!buf) {
+    l->err = ENOMEM;
+    close(dfd);
+    return;
+  }
+  while ((n = syscall(SYS_getdents64, dfd, buf, LISTDIRS_BUFFER_SIZE)) > 0) {
+    for (offset = 0; offset < n;) {
+      struct linux_dirent64* ent = (struct linux_dirent64*)(buf + offset);
+      if (dirlisting_visit(
+              l,
+              dfd,
+              ent->d_name,
+              dtkind(ent->d_type),
+              job->keepstat,
+              job->skip))
+        goto done;
+      offset += ent->d_reclen;
+    }
+  }
+  if (n == -1)
+    l->err = errno;
+done:
+  free(buf);
+  close(dfd);
+#else
+  dir = fdopendir(dfd);
+  if (!dir) {
+    l->err = errno;
+    close(dfd);
+    return;
+  }
+  while ((ent = readdir(dir))) {
+    if (dirlisting_visit(
+            l, dfd, ent->d_name, entkind(ent), job->keepstat, job->skip))
+      break;
+  }
+  /* closedir also closes its dirfd */
+  closedir(dir);
+#endif
+}
+
+/* Turn a listing into what listdir would have returned or raised. */
+static PyObject* dirlisting_result(struct dirlisting* l, int keepstat) {
+  PyObject *list, *elem, *stat;
+  size_t i;
+
+  if (l->err) {
+    PyObject* ret;
+    char* fullpath;
+    if (l->errname == -1)
+      return PyObject_CallFunction(
+          PyExc_OSError, "iss", l->err, strerror(l->err), l->path);
+    fullpath = malloc(strlen(l->path) + strlen(l->names + l->errname) + 2);
+    if (!fullpath)
+      return PyErr_NoMemory();
+    sprintf(fullpath, "%s/%s", l->path, l->names + l->errname);
+    ret = PyObject_CallFunction(
+        PyExc_OSError, "iss", l->err, strerror(l->err), fullpath);
+    free(fullpath);
+    return ret;
+  }
+  if (l->skipped)
+    return PyList_New(0);
+
+  list = PyList_New(l->count);
+  if (!list)
+    return NULL;
+  for (i = 0; i < l->count; i++) {
+    struct dirlisting_entry* entry = &l->entries[i];
+    if (keepstat) {
+      stat = makestat(&entry->st);
+      if (!stat)
+        goto error;
+      elem = Py_BuildValue("siN", l->names + entry->name, entry->kind, stat);
+    } else
+      elem = Py_BuildValue("si", l->names + entry->name, entry->kind);
+    if (!elem)
+      goto error;
+    PyList_SET_ITEM(list, i, elem);
+  }
+  return list;
+
+error:
+  Py_DECREF(list);
+  return NULL;
+}
+
+static PyObject* listdirs(PyObject* self, PyObject* args, PyObject* kwargs) {
+  PyObject *pathsobj, *fast, *ret = NULL;
+  PyObject* statobj = NULL; /* initialize - optional arg */
+  PyObject* skipobj = NULL; /* initialize - optional arg */
+  struct listdirs_job job;
+  PyThreadState* ts;
   Py_ssize_t i, count;
 
-  if (!PyArg_ParseTuple(args, "O:statfiles", &names))
+  static char* kwlist[] = {"paths", "stat", "skip", NULL};
+
+  if (!PyArg_ParseTupleAndKeywords(
+          args, kwargs, "O|OO:listdirs", kwlist, &pathsobj, &statobj, &skipobj))
     return NULL;
 
-  count = PySequence_Length(names);
-  if (count == -1) {
-    PyErr_SetString(PyExc_TypeError, "not a sequence");
+  job.keepstat = statobj && PyObject_IsTrue(statobj);
+  job.skip = NULL;
+  if (skipobj && skipobj != Py_None) {
+#ifdef IS_PY3K
+    job.skip = PyUnicode_AsUTF8(skipobj);
+#else
+    job.skip = PyBytes_AsString(skipobj);
+#endif
+    if (!job.skip)
+      return NULL;
+  }
+
+  fast = PySequence_Fast(pathsobj, "not a sequence");
+  if (!fast)
     return NULL;
+  count = PySequence_Fast_GET_SIZE(fast);
+  job.listings = calloc(count ? count : 1, sizeof(struct dirlisting));
+  if (!job.listings) {
+    PyErr_NoMemory();
+    goto done;
+  }
+  for (i = 0; i < count; i++) {
+    PyObject* pathobj = PySequence_Fast_GET_ITEM(fast, i);
+#ifdef IS_PY3K
+    job.listings[i].path = PyUnicode_AsUTF8(pathobj);
+#else
+    job.listings[i].path = PyBytes_AsString(pathobj);
+#endif
+    if (!job.listings[i].path)
+      goto done;
+    job.listings[i].errname = -1;
+  }
+
+  ts = PyEval_SaveThread();
+  parallel_for(count, LISTDIRS_GRAIN, listdirs_run, &job);
+  PyEval_RestoreThread(ts);
+
+  ret = PyList_New(count);
+  if (!ret)
+    goto done;
+  for (i = 0; i < count; i++) {
+    PyObject* result = dirlisting_result(&job.listings[i], job.keepstat);
+    if (!result) {
+      Py_CLEAR(ret);
+      goto done;
+    }
+    PyList_SET_ITEM(ret, i, result);
   }
 
+done:
+  if (job.listings) {
+    for (i = 0; i < count; i++) {
+      free(job.listings[i].names);
+      free(job.listings[i].entries);
+    }
+    free(job.listings);
+  }
+  Py_DECREF(fast);
+  return ret;
+}
+
+#endif /* AT_SYMLINK_NOFOLLOW */
+
+/* paths stat'ed by one statfiles thread at a time, at least */
+#define STATFILES_GRAIN 256
+
+/* paths stat'ed between checks for signals (issue4878) */
+#define STATFILES_CHUNK 8192
+
+struct statfiles_job {
+  const char** paths;
+  struct stat* sts;
+  int* rets;
+};
+
+static void statfiles_run(void* ctx, size_t i) {
+  struct statfiles_job* job = ctx;
+  job->rets[i] = lstat(job->paths[i], &job->sts[i]);
+}
+
+static PyObject* statfiles(PyObject* self, PyObject* args) {
+  PyObject *names, *fast, *stats = NULL;
+  struct statfiles_job job = {NULL, NULL, NULL};
+  PyThreadState* ts;
+  Py_ssize_t start, i, count;
+
+  if (!PyArg_ParseTuple(args, "O:statfiles", &names))
+    return NULL;
+
+  fast = PySequence_Fast(names, "not a sequence");
+  if (!fast)
+    return NULL;
+  count = PySequence_Fast_GET_SIZE(fast);
+
   stats = PyList_New(count);
   if (stats == NULL)
-    return NULL;
+    goto done;
 
-  for (i = 0; i < count; i++) {
-    PyObject *stat, *pypath;
-    struct stat st;
-    int ret, kind;
-    const char* path;
+  job.paths = malloc(STATFILES_CHUNK * sizeof(*job.paths));
+  job.sts = malloc(STATFILES_CHUNK * sizeof(*job.sts));
+  job.rets = malloc(STATFILES_CHUNK * sizeof(*job.rets));
+  if (!job.paths || !job.sts || !job.rets) {
+    PyErr_NoMemory();
+    goto bail;
+  }
+
+  for (start = 0; start < count; start += STATFILES_CHUNK) {
+    Py_ssize_t n = count - start;
+    if (n > STATFILES_CHUNK)
+      n = STATFILES_CHUNK;
 
     /* With a large file count or on a slow filesystem,
        don't block signals for long (issue4878). */
-    if ((i % 1000) == 999 && PyErr_CheckSignals() == -1)
+    if (start > 0 && PyErr_CheckSignals() == -1)
       goto bail;
 
-    pypath = PySequence_GetItem(names, i);
-    if (!pypath)
-      goto bail;
+    for (i = 0; i < n; i++) {
+      PyObject* pypath = PySequence_Fast_GET_ITEM(fast, start + i);
 #ifdef IS_PY3K
-    path = PyUnicode_AsUTF8(pypath);
+      job.paths[i] = PyUnicode_Check(pypath) ? PyUnicode_AsUTF8(pypath) : NULL;
 #else
-    path = PyBytes_AsString(pypath);
+      job.paths[i] = PyBytes_Check(pypath) ? PyBytes_AsString(pypath) : NULL;
 #endif
-    if (path == NULL) {
-      Py_DECREF(pypath);
-      PyErr_SetString(PyExc_TypeError, "not a str");
-      goto bail;
-    }
-    ret = lstat(path, &st);
-    Py_DECREF(pypath);
-    kind = st.st_mode & S_IFMT;
-    if (ret != -1 && (kind == S_IFREG || kind == S_IFLNK)) {
-      stat = makestat(&st);
-      if (stat == NULL)
+      if (job.paths[i] == NULL) {
+        PyErr_SetString(PyExc_TypeError, "not a str");
         goto bail;
-      PyList_SET_ITEM(stats, i, stat);
-    } else {
-      Py_INCREF(Py_None);
-      PyList_SET_ITEM(stats, i, Py_None);
+      }
     }
-  }
 
-  return stats;
+    ts = PyEval_SaveThread();
+    parallel_for(n, STATFILES_GRAIN, statfiles_run, &job);
+    PyEval_RestoreThread(ts);
+
+    for (i = 0; i < n; i++) {
+      PyObject* stat;
+      int kind = job.rets[i] != -1 ? job.sts[i].st_mode & S_IFMT : 0;
+      if (kind == S_IFREG || kind == S_IFLNK) {
+        stat = makestat(&job.sts[i]);
+        if (stat == NULL)
+          goto bail;
+        PyList_SET_ITEM(stats, start + i, stat);
+      } else {
+        Py_INCREF(Py_None);
+        PyList_SET_ITEM(stats, start + i, Py_None);
+      }
+    }
+  }
+  goto done;
 
 bail:
-  Py_DECREF(stats);
-  return NULL;
+  Py_CLEAR(stats);
+done:
+  free(job.paths);
+  free(job.sts);
+  free(job.rets);
+  Py_DECREF(fast);
+  return stats;
 }
 
 /*
@@ -1204,6 +1622,14 @@ static PyMethodDef methods[] = {
      METH_VARARGS | METH_KEYWORDS,
      "stat a series of files or symlinks\n"
      "Returns None for non-existent entries and entries of other types.\n"},
+#ifdef AT_SYMLINK_NOFOLLOW
+    {"listdirs",
+     (PyCFunction)listdirs,
+     METH_VARARGS | METH_KEYWORDS,
+     "list several directories at once, using threads\n"
+     "Returns what listdir returns for every path, or the OSError that it\n"
+     "would raise.\n"},
+#endif
 #ifdef CMSG_LEN
     {"recvfds",
      (PyCFunction)recvfds,
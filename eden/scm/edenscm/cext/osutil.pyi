@@ -18,6 +18,11 @@ class stat:
 def listdir(
     path: str, stat: Optional[bool] = None, skip: Optional[str] = None
 ) -> Union[List[Tuple[str, int]], List[Tuple[str, int, stat]]]: ...
+def listdirs(
+    paths: List[str], stat: Optional[bool] = None, skip: Optional[str] = None
+) -> List[
+    Union[List[Tuple[str, int]], List[Tuple[str, int, stat]], OSError]
+]: ...
 def posixfile(name: str, mode: str = "rb", bufsize: int = -1) -> BinaryIO: ...
 def recvfds(fd: int) -> List[int]: ...
 def setprocname(name: Union[str, bytes]) -> None: ...
@@ -256,20 +256,23 @@ static PyObject* parse_dirstate(PyObject* self, PyObject* args) {
   char state, *cur, *str, *cpos;
   int mode, size, mtime;
   unsigned int flen, pos = 40;
-  Py_ssize_t readlen, len;
+  Py_ssize_t len;
+  Py_buffer data;
 
+  /* Any buffer will do, so that the caller can hand us an mmap of the
+   * dirstate file rather than a copy of its contents. */
   if (!PyArg_ParseTuple(
           args,
-          "O!O!s#:parse_dirstate",
+          "O!O!s*:parse_dirstate",
           &PyDict_Type,
           &dmap,
           &PyDict_Type,
           &cmap,
-          &str,
-          &readlen))
-    goto quit;
+          &data))
+    return NULL;
 
-  len = readlen;
+  str = data.buf;
+  len = data.len;
 
   /* read parents */
   if (len < 40) {
@@ -344,6 +347,7 @@ quit:
   Py_XDECREF(cname);
   Py_XDECREF(entry);
   Py_XDECREF(parents);
+  PyBuffer_Release(&data);
   return ret;
 }
 
@@ -413,7 +417,7 @@ static PyObject* pack_dirstate(PyObject* self, PyObject* args) {
   const char* utf8c = NULL;
   const char* utf8k = NULL;
 #endif
-  int now;
+  int now, hascopies;
 
   if (!PyArg_ParseTuple(
           args,
@@ -431,6 +435,9 @@ static PyObject* pack_dirstate(PyObject* self, PyObject* args) {
     return NULL;
   }
 
+  /* Copies are rare: don't look every file up when there are none. */
+  hascopies = PyDict_Size(copymap) > 0;
+
   /* Figure out how much we need to allocate. */
   for (nbytes = 40, pos = 0; PyDict_Next(map, &pos, &k, &v);) {
     PyObject* c;
@@ -446,7 +453,7 @@ static PyObject* pack_dirstate(PyObject* self, PyObject* args) {
     }
     nbytes += utf8k_size + 17;
 
-    c = PyDict_GetItem(copymap, k);
+    c = hascopies ? PyDict_GetItem(copymap, k) : NULL;
 
     if (c) {
       if (!PyUnicode_Check(c)) {
@@ -466,7 +473,7 @@ static PyObject* pack_dirstate(PyObject* self, PyObject* args) {
       goto bail;
     }
     nbytes += PyBytes_GET_SIZE(k) + 17;
-    c = PyDict_GetItem(copymap, k);
+    c = hascopies ? PyDict_GetItem(copymap, k) : NULL;
     if (c) {
       if (!PyBytes_Check(c)) {
         PyErr_SetString(PyExc_TypeError, "expected string key");
@@ -545,7 +552,7 @@ static PyObject* pack_dirstate(PyObject* self, PyObject* args) {
     memcpy(p, PyBytes_AS_STRING(k), len);
 #endif
     p += len;
-    o = PyDict_GetItem(copymap, k);
+    o = hascopies ? PyDict_GetItem(copymap, k) : NULL;
     if (o) {
       *p++ = '\0';
 #ifdef IS_PY3K
@@ -48,6 +48,22 @@ typedef struct {
   int children[16];
 } nodetree;
 
+/*
+ * Header of a serialized trie, see index_nodemapdata. It is followed by
+ * `length` nodetree entries, in native byte order.
+ */
+typedef struct {
+  char magic[8];
+  uint32_t byteorder; /* nodemap_byteorder, to reject foreign files */
+  uint32_t revs; /* the trie maps revs [0, revs) */
+  uint32_t length; /* # nodes */
+  char tipnode[20]; /* node of rev revs - 1, to detect rewritten revlogs */
+  char padding[24]; /* keep nodes aligned */
+} nodemapheader;
+
+static const char nodemap_magic[8] = "nodetree";
+static const uint32_t nodemap_byteorder = 0x01020304;
+
 /*
  * This class has two behaviors.
  *
@@ -72,6 +88,10 @@ typedef struct {
   PyObject* added; /* populated on demand */
   PyObject* headrevs; /* cache, invalidated on changes */
   nodetree* nt; /* base-16 trie */
+  Py_buffer ntbasebuf; /* buffer of ntbase */
+  const nodetree* ntbase; /* read-only trie of revs [0, ntbaserevs) */
+  size_t ntbaselength; /* # nodes in ntbase */
+  int ntbaserevs; /* revs below are looked up in ntbase, not scanned */
   size_t ntlength; /* # nodes in use */
   size_t ntcapacity; /* # nodes allocated */
   int ntdepth; /* maximum depth of tree */
@@ -265,6 +285,7 @@ static const char* index_node(indexObject* self, Py_ssize_t pos) {
 }
 
 static int nt_insert(indexObject* self, const char* node, int rev);
+static void nt_dropbase(indexObject* self);
 
 static int node_check(PyObject* obj, char** node, Py_ssize_t* nodelen) {
   if (PyBytes_AsStringAndSize(obj, node, nodelen) == -1)
@@ -335,6 +356,7 @@ static void _index_clearcaches(indexObject* self) {
     free(self->nt);
     self->nt = NULL;
   }
+  nt_dropbase(self);
   Py_CLEAR(self->headrevs);
 }
 
@@ -384,6 +406,10 @@ static PyObject* index_stats(indexObject* self) {
   istat(ntmisses, "node trie misses");
   istat(ntrev, "node trie last rev scanned");
   istat(ntsplits, "node trie splits");
+  if (self->ntbase) {
+    istat(ntbaselength, "node trie persisted count");
+    istat(ntbaserevs, "node trie persisted revs");
+  }
 
 #undef istat
 
@@ -907,15 +933,20 @@ static inline int nt_level(const char* node, Py_ssize_t level) {
  *   -2: not found
  * rest: valid rev
  */
-static int
-nt_find(indexObject* self, const char* node, Py_ssize_t nodelen, int hex) {
+static int nt_find(
+    indexObject* self,
+    const nodetree* nt,
+    size_t ntlength,
+    const char* node,
+    Py_ssize_t nodelen,
+    int hex) {
   int (*getnybble)(const char*, Py_ssize_t) = hex ? hexdigit : nt_level;
   int level, maxlevel, off;
 
   if (nodelen == 20 && node[0] == '\0' && memcmp(node, nullid, 20) == 0)
     return -1;
 
-  if (self->nt == NULL)
+  if (nt == NULL)
     return -2;
 
   if (hex)
@@ -925,7 +956,7 @@ nt_find(indexObject* self, const char* node, Py_ssize_t nodelen, int hex) {
 
   for (level = off = 0; level < maxlevel; level++) {
     int k = getnybble(node, level);
-    nodetree* n = &self->nt[off];
+    const nodetree* n = &nt[off];
     int v = n->children[k];
 
     if (v < 0) {
@@ -941,7 +972,8 @@ nt_find(indexObject* self, const char* node, Py_ssize_t nodelen, int hex) {
           return -2;
       return v;
     }
-    if (v == 0)
+    /* ntbase comes from a file, do not trust it */
+    if (v == 0 || (size_t)v >= ntlength)
       return -2;
     off = v;
   }
@@ -949,6 +981,45 @@ nt_find(indexObject* self, const char* node, Py_ssize_t nodelen, int hex) {
   return -4;
 }
 
+/*
+ * nt_find in the in-memory trie, then in the persisted one. The former
+ * takes precedence, it reflects changes made after ntbase was loaded.
+ */
+static int nt_findany(
+    indexObject* self,
+    const char* node,
+    Py_ssize_t nodelen,
+    int hex) {
+  int rev = nt_find(self, self->nt, self->ntlength, node, nodelen, hex);
+  int baserev;
+
+  if (rev == -4 || self->ntbase == NULL)
+    return rev;
+  baserev =
+      nt_find(self, self->ntbase, self->ntbaselength, node, nodelen, hex);
+  if (rev == -2)
+    return baserev;
+  if (baserev == -4 || (baserev != -2 && baserev != rev))
+    return -4;
+  return rev;
+}
+
+/*
+ * Stop using ntbase. The revs it mapped will be scanned into the in-memory
+ * trie on demand.
+ */
+static void nt_dropbase(indexObject* self) {
+  if (self->ntbase == NULL)
+    return;
+  if (self->ntrev < self->ntbaserevs)
+    self->ntrev = self->ntbaserevs;
+  PyBuffer_Release(&self->ntbasebuf);
+  memset(&self->ntbasebuf, 0, sizeof(self->ntbasebuf));
+  self->ntbase = NULL;
+  self->ntbaselength = 0;
+  self->ntbaserevs = 0;
+}
+
 static int nt_new(indexObject* self) {
   if (self->ntlength == self->ntcapacity) {
     if (self->ntcapacity >= SIZE_MAX / (sizeof(nodetree) * 2)) {
@@ -1048,7 +1119,7 @@ index_find_node(indexObject* self, const char* node, Py_ssize_t nodelen) {
   int rev;
 
   self->ntlookups++;
-  rev = nt_find(self, node, nodelen, 0);
+  rev = nt_findany(self, node, nodelen, 0);
   if (rev >= -1)
     return rev;
 
@@ -1065,7 +1136,7 @@ index_find_node(indexObject* self, const char* node, Py_ssize_t nodelen) {
    * bulk performance, e.g. for "hg log".
    */
   if (self->ntmisses++ < 4) {
-    for (rev = self->ntrev - 1; rev >= 0; rev--) {
+    for (rev = self->ntrev - 1; rev >= self->ntbaserevs; rev--) {
       const char* n = index_node(self, rev);
       if (n == NULL)
         return -2;
@@ -1076,7 +1147,7 @@ index_find_node(indexObject* self, const char* node, Py_ssize_t nodelen) {
       }
     }
   } else {
-    for (rev = self->ntrev - 1; rev >= 0; rev--) {
+    for (rev = self->ntrev - 1; rev >= self->ntbaserevs; rev--) {
       const char* n = index_node(self, rev);
       if (n == NULL) {
         self->ntrev = rev + 1;
@@ -1093,7 +1164,7 @@ index_find_node(indexObject* self, const char* node, Py_ssize_t nodelen) {
     self->ntrev = rev;
   }
 
-  if (rev >= 0)
+  if (rev >= self->ntbaserevs)
     return rev;
   return -2;
 }
@@ -1144,16 +1215,23 @@ static PyObject* index_getitem(indexObject* self, PyObject* value) {
   return NULL;
 }
 
-static int
-nt_partialmatch(indexObject* self, const char* node, Py_ssize_t nodelen) {
+/*
+ * Insert every rev not in the tries yet, so that they map all revs.
+ *
+ * Return values:
+ *
+ *   -3: error (exception set)
+ *   -2: a rev could not be read (no exception set)
+ *    0: success
+ */
+static int nt_populate(indexObject* self) {
   int rev;
 
   if (nt_init(self) == -1)
     return -3;
 
-  if (self->ntrev > 0) {
-    /* ensure that the radix tree is fully populated */
-    for (rev = self->ntrev - 1; rev >= 0; rev--) {
+  if (self->ntrev > self->ntbaserevs) {
+    for (rev = self->ntrev - 1; rev >= self->ntbaserevs; rev--) {
       const char* n = index_node(self, rev);
       if (n == NULL)
         return -2;
@@ -1162,8 +1240,15 @@ nt_partialmatch(indexObject* self, const char* node, Py_ssize_t nodelen) {
     }
     self->ntrev = rev;
   }
+  return 0;
+}
 
-  return nt_find(self, node, nodelen, 1);
+static int
+nt_partialmatch(indexObject* self, const char* node, Py_ssize_t nodelen) {
+  int r = nt_populate(self);
+  if (r < 0)
+    return r;
+  return nt_findany(self, node, nodelen, 1);
 }
 
 static PyObject* index_partialmatch(indexObject* self, PyObject* args) {
@@ -1671,6 +1756,9 @@ static int index_slice_del(indexObject* self, PyObject* item) {
     return -1;
   }
 
+  if (start < self->ntbaserevs)
+    nt_dropbase(self);
+
   if (start < self->length - 1) {
     if (self->nt) {
       Py_ssize_t i;
@@ -1733,8 +1821,11 @@ index_assign_subscript(indexObject* self, PyObject* item, PyObject* value) {
   if (node_check(item, &node, &nodelen) == -1)
     return -1;
 
-  if (value == NULL)
+  if (value == NULL) {
+    if (nt_find(self, self->ntbase, self->ntbaselength, node, nodelen, 0) >= 0)
+      nt_dropbase(self);
     return self->nt ? nt_insert(self, node, -1) : 0;
+  }
   rev = PyInt_AsLong(value);
   if (rev > INT_MAX || rev < 0) {
     if (!PyErr_Occurred())
@@ -1791,6 +1882,10 @@ static int index_init(indexObject* self, PyObject* args) {
   self->headrevs = NULL;
   Py_INCREF(Py_None);
   self->nt = NULL;
+  memset(&self->ntbasebuf, 0, sizeof(self->ntbasebuf));
+  self->ntbase = NULL;
+  self->ntbaselength = 0;
+  self->ntbaserevs = 0;
   self->offsets = NULL;
 
   if (!PyArg_ParseTuple(args, "OO", &data_obj, &inlined_obj))
@@ -1833,6 +1928,138 @@ bail:
   return -1;
 }
 
+/*
+ * Use a trie serialized by index_nodemapdata for node lookups, typically
+ * mmapped, so that lookups do not have to scan the index first. Revs added
+ * since it was written are scanned into the in-memory trie as usual.
+ *
+ * Return the number of revs the trie maps, or None if it does not belong
+ * to this index and was ignored.
+ */
+static PyObject* index_loadnodemap(indexObject* self, PyObject* args) {
+  PyObject* data;
+  Py_buffer buf;
+  nodemapheader header;
+  size_t length;
+  const char* tipnode;
+
+  if (!PyArg_ParseTuple(args, "O", &data))
+    return NULL;
+  if (PyObject_GetBuffer(data, &buf, PyBUF_SIMPLE) == -1)
+    return NULL;
+
+  if ((size_t)buf.len < sizeof(header) ||
+      (uintptr_t)buf.buf % sizeof(int) != 0)
+    goto ignore;
+  memcpy(&header, buf.buf, sizeof(header));
+  length = ((size_t)buf.len - sizeof(header)) / sizeof(nodetree);
+  if (memcmp(header.magic, nodemap_magic, sizeof(header.magic)) != 0 ||
+      header.byteorder != nodemap_byteorder || header.length == 0 ||
+      header.length != length ||
+      sizeof(header) + length * sizeof(nodetree) != (size_t)buf.len ||
+      header.revs == 0 || header.revs > INT_MAX ||
+      (Py_ssize_t)header.revs > index_length(self) - 1)
+    goto ignore;
+  tipnode = index_node(self, header.revs - 1);
+  if (tipnode == NULL) {
+    if (PyErr_Occurred())
+      goto bail;
+    goto ignore;
+  }
+  if (memcmp(tipnode, header.tipnode, 20) != 0)
+    goto ignore;
+
+  nt_dropbase(self);
+  self->ntbasebuf = buf;
+  self->ntbase = (const nodetree*)((const char*)buf.buf + sizeof(header));
+  self->ntbaselength = length;
+  self->ntbaserevs = (int)header.revs;
+  return PyInt_FromLong(self->ntbaserevs);
+
+ignore:
+  PyBuffer_Release(&buf);
+  Py_RETURN_NONE;
+bail:
+  PyBuffer_Release(&buf);
+  return NULL;
+}
+
+/*
+ * Serialize a trie mapping every rev, for index_loadnodemap. The persisted
+ * trie is copied and completed rather than rebuilt, so this costs little
+ * more than writing it out.
+ */
+static PyObject* index_nodemapdata(indexObject* self) {
+  Py_ssize_t revs = index_length(self) - 1;
+  nodemapheader header;
+  PyObject* result;
+  const char* tipnode;
+  char* p;
+  int rev;
+
+  if (revs > INT_MAX) {
+    PyErr_SetString(PyExc_OverflowError, "too many revs for a nodemap");
+    return NULL;
+  }
+
+  if (self->ntbase) {
+    /* start over from ntbase, it already maps the oldest revs */
+    size_t capacity = self->ntbaselength * 2;
+    nodetree* nt = calloc(capacity, sizeof(nodetree));
+    if (nt == NULL)
+      return PyErr_NoMemory();
+    memcpy(nt, self->ntbase, self->ntbaselength * sizeof(nodetree));
+    free(self->nt);
+    self->nt = nt;
+    self->ntlength = self->ntbaselength;
+    self->ntcapacity = capacity;
+    for (rev = self->ntbaserevs; rev < revs; rev++) {
+      const char* n = index_node(self, rev);
+      if (n == NULL || nt_insert(self, n, rev) == -1)
+        goto bail;
+    }
+    self->ntrev = -1;
+    PyBuffer_Release(&self->ntbasebuf);
+    memset(&self->ntbasebuf, 0, sizeof(self->ntbasebuf));
+    self->ntbase = NULL;
+    self->ntbaselength = 0;
+    self->ntbaserevs = 0;
+  } else {
+    switch (nt_populate(self)) {
+      case -3:
+        return NULL;
+      case -2:
+        goto bail;
+    }
+  }
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, nodemap_magic, sizeof(header.magic));
+  header.byteorder = nodemap_byteorder;
+  header.revs = (uint32_t)revs;
+  header.length = (uint32_t)self->ntlength;
+  tipnode = revs > 0 ? index_node(self, revs - 1) : nullid;
+  if (tipnode == NULL)
+    goto bail;
+  memcpy(header.tipnode, tipnode, 20);
+
+  result = PyBytes_FromStringAndSize(
+      NULL, sizeof(header) + self->ntlength * sizeof(nodetree));
+  if (result == NULL)
+    return NULL;
+  p = PyBytes_AS_STRING(result);
+  memcpy(p, &header, sizeof(header));
+  memcpy(p + sizeof(header), self->nt, self->ntlength * sizeof(nodetree));
+  return result;
+
+bail:
+  /* the in-memory trie may be incomplete, rebuild it on demand */
+  _index_clearcaches(self);
+  if (!PyErr_Occurred())
+    PyErr_SetString(PyExc_ValueError, "could not read every node");
+  return NULL;
+}
+
 static PyObject* index_nodemap(indexObject* self) {
   Py_INCREF(self);
   return (PyObject*)self;
@@ -1900,6 +2127,14 @@ static PyMethodDef index_methods[] = {
      (PyCFunction)index_insert,
      METH_VARARGS,
      "insert an index entry"},
+    {"loadnodemap",
+     (PyCFunction)index_loadnodemap,
+     METH_VARARGS,
+     "use a serialized node trie for lookups"},
+    {"nodemapdata",
+     (PyCFunction)index_nodemapdata,
+     METH_NOARGS,
+     "serialize the node trie of all revs"},
     {"partialmatch",
      (PyCFunction)index_partialmatch,
      METH_VARARGS,
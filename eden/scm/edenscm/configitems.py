@@ -249,6 +249,7 @@ coreconfigitem("experimental", "evolution.exchange", default=None)
 coreconfigitem("experimental", "evolution.track-operation", default=True)
 coreconfigitem("experimental", "worddiff", default=False)
 coreconfigitem("experimental", "mmapindexthreshold", default=1)
+coreconfigitem("experimental", "nodetreethreshold", default=None)
 coreconfigitem("experimental", "nonnormalparanoidcheck", default=False)
 coreconfigitem("experimental", "exportableenviron", default=list)
 coreconfigitem("experimental", "extendedheader.index", default=None)
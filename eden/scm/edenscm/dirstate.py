@@ -1708,7 +1708,9 @@ class dirstatemap(object):
         try:
             fp = self._opendirstatefile()
             try:
-                st = fp.read()
+                # parse_dirstate decodes straight from the mapping, which
+                # saves copying the whole file into memory first.
+                st = util.mmapread(fp)
             finally:
                 fp.close()
         except IOError as err:
@@ -1744,7 +1746,10 @@ class dirstatemap(object):
         #
         # (we cannot decorate the function directly since it is in a C module)
         parse_dirstate = util.nogc(parsers.parse_dirstate)
-        p = parse_dirstate(self._map, self.copymap, st)
+        try:
+            p = parse_dirstate(self._map, self.copymap, st)
+        finally:
+            st.close()
         if not self._dirtyparents:
             self.setparents(*p)
 
@@ -40,14 +40,20 @@ cdef extern from "lib/linelog/linelog.c":
         linelog_lineinfo *lines
         linelog_linenum linecount
         linelog_linenum maxlinecount
+    ctypedef struct linelog_annotatecache:
+        pass
 
     cdef void linelog_annotateresult_clear(linelog_annotateresult *ar)
+    cdef void linelog_annotatecache_clear(linelog_annotatecache *cache)
     cdef linelog_result linelog_clear(linelog_buf *buf)
     cdef size_t linelog_getactualsize(const linelog_buf *buf)
     cdef linelog_revnum linelog_getmaxrev(const linelog_buf *buf)
 
     cdef linelog_result linelog_annotate(const linelog_buf *buf,
             linelog_annotateresult *ar, linelog_revnum rev)
+    cdef linelog_result linelog_annotate_cached(const linelog_buf *buf,
+            linelog_annotateresult *ar, linelog_revnum rev,
+            linelog_annotatecache *cache)
     cdef linelog_result linelog_replacelines(linelog_buf *buf,
             linelog_annotateresult *ar, linelog_revnum brev,
             linelog_linenum a1, linelog_linenum a2,
@@ -111,8 +117,9 @@ cdef class _buffer: # thin wrapper around linelog_buf
     cdef clear(self):
         self._eval(lambda: linelog_clear(&self.buf))
 
-    cdef annotate(self, linelog_annotateresult *ar, linelog_revnum rev):
-        self._eval(lambda: linelog_annotate(&self.buf, ar, rev))
+    cdef annotate(self, linelog_annotateresult *ar, linelog_revnum rev,
+                  linelog_annotatecache *cache):
+        self._eval(lambda: linelog_annotate_cached(&self.buf, ar, rev, cache))
 
     cdef replacelines(self, linelog_annotateresult *ar, linelog_revnum brev,
                       linelog_linenum a1, linelog_linenum a2,
@@ -175,10 +182,12 @@ IF UNAME_SYSNAME != "Windows":
         cdef int fd
         cdef size_t maplen
         cdef char *path
+        cdef bint readonly
 
-        def __cinit__(self, path):
+        def __cinit__(self, path, readonly=False):
             self.fd = -1
             self.maplen = 0
+            self.readonly = readonly
             self.path = strdup(path)
             if self.path == NULL:
                 raise MemoryError()
@@ -189,6 +198,8 @@ IF UNAME_SYSNAME != "Windows":
             self.close()
 
         cdef resize(self, size_t newsize):
+            if self.readonly:
+                raise IOError(b'cannot resize a read-only linelog')
             if self.fd == -1:
                 self._open()
             self._unmap()
@@ -198,7 +209,7 @@ IF UNAME_SYSNAME != "Windows":
             self._map()
 
         cdef flush(self):
-            if self.buf.data == NULL:
+            if self.buf.data == NULL or self.readonly:
                 return
             r = mman.msync(self.buf.data, self.buf.size, mman.MS_ASYNC)
             if r != 0:
@@ -214,7 +225,10 @@ IF UNAME_SYSNAME != "Windows":
 
         cdef _open(self):
             self.close()
-            fd = fcntl.open(self.path, fcntl.O_RDWR | fcntl.O_CREAT, 0o644)
+            if self.readonly:
+                fd = fcntl.open(self.path, fcntl.O_RDONLY)
+            else:
+                fd = fcntl.open(self.path, fcntl.O_RDWR | fcntl.O_CREAT, 0o644)
             if fd == -1:
                 raise _excwitherrno(IOError, None, self.path)
             self.fd = fd
@@ -231,9 +245,11 @@ IF UNAME_SYSNAME != "Windows":
 
             cdef size_t filelen = <size_t>st.st_size
             self.maplen = (1 if filelen == 0 else filelen) # cannot be 0
-            p = mman.mmap(NULL, self.maplen, mman.PROT_READ | mman.PROT_WRITE,
-                          mman.MAP_SHARED, self.fd, 0)
-            if p == NULL:
+            prot = mman.PROT_READ
+            if not self.readonly:
+                prot |= mman.PROT_WRITE
+            p = mman.mmap(NULL, self.maplen, prot, mman.MAP_SHARED, self.fd, 0)
+            if p == mman.MAP_FAILED:
                 raise _excwitherrno(OSError, b'mmap')
 
             self.buf.data = <uint8_t *>p
@@ -260,44 +276,57 @@ cdef class linelog:
     """Python wrapper around linelog"""
 
     cdef linelog_annotateresult ar
+    cdef linelog_annotatecache cache
     cdef readonly _buffer buf
     cdef readonly bint closed
     cdef readonly object path
+    cdef readonly bint readonly
 
     def __cinit__(self):
         self.closed = 0
         memset(&self.ar, 0, sizeof(linelog_annotateresult))
+        memset(&self.cache, 0, sizeof(linelog_annotatecache))
 
-    def __init__(self, path=None):
-        """L(path : str?). Open a linelog.
+    def __init__(self, path=None, readonly=False):
+        """L(path : str?, readonly : bool). Open a linelog.
 
         If path is empty or None, the linelog will be in-memory. Otherwise
         it's based on an on-disk file.
 
+        A read-only linelog maps an existing file without copying it, which
+        suits annotating huge files. It can only be annotated and read.
+
         The linelog object does not protect concurrent accesses to a same
         file. The caller should have some lock mechanism (like flock) to
         ensure one file is only accessed by one linelog object.
         """
         self.path = path
+        self.readonly = readonly
+        if readonly and not path:
+            raise ValueError(b'in-memory linelog cannot be read-only')
         if path:
             IF UNAME_SYSNAME == b'Windows':
                 raise RuntimeError(b'on-disk linelog is unavailable on Windows')
             ELSE:
-                self.buf = _filebuffer(path)
+                self.buf = _filebuffer(path, readonly)
         else:
             self.buf = _memorybuffer()
         if self.buf.getactualsize() == 0:
+            if readonly:
+                raise LinelogError(LINELOG_RESULT_EILLDATA)
             # initialize empty linelog automatically
             self.clear()
             self.annotate(0)
 
     def __dealloc__(self):
         self._clearannotateresult()
+        linelog_annotatecache_clear(&self.cache)
 
     def clear(self):
         """L.close() -> None. Close the file and free resources."""
-        self._checkclosed()
+        self._checkwritable()
         self._clearannotateresult()
+        linelog_annotatecache_clear(&self.cache)
         self.buf.clear()
 
     def flush(self):
@@ -309,8 +338,10 @@ cdef class linelog:
         """L.close() -> None. Close the file."""
         if self.closed:
             return
-        self.buf.resize(self.buf.getactualsize())
+        if not self.readonly:
+            self.buf.resize(self.buf.getactualsize())
         self.buf.close()
+        linelog_annotatecache_clear(&self.cache)
         self.closed = 1
 
     def copyfrom(self, rhs):
@@ -318,7 +349,8 @@ cdef class linelog:
 
         Copy content from another linelog object."""
         assert isinstance(rhs, linelog)
-        self._checkclosed()
+        self._checkwritable()
+        linelog_annotatecache_clear(&self.cache)
         self.buf.copyfrom(rhs.buf)
 
     @property
@@ -338,10 +370,13 @@ cdef class linelog:
 
         Annotate lines for specified revision. The result can be obtained
         via L.annotateresult.
+
+        Checkpoints of the previous call are reused, so annotating several
+        revisions of an unchanged linelog is cheaper than the first one.
         """
         self._checkclosed()
         try:
-            self.buf.annotate(&self.ar, rev)
+            self.buf.annotate(&self.ar, rev, &self.cache)
         except LinelogError:
             self._clearannotateresult()
             raise
@@ -352,7 +387,7 @@ cdef class linelog:
         Replace lines[a1:a2] with lines[b1:b2] in rev. See comments above
         linelog_replacelines in linelog.h for details.
         """
-        self._checkclosed()
+        self._checkwritable()
         try:
             self.buf.replacelines(&self.ar, rev, a1, a2, b1, b2)
         except LinelogError:
@@ -366,7 +401,7 @@ cdef class linelog:
         by rev. See comments above linelog_replacelines_vec in linelog.h for
         details.
         """
-        self._checkclosed()
+        self._checkwritable()
         # prepare blinecount, brevs, blinenums
         cdef linelog_linenum i = 0, blinecount = <linelog_linenum>len(blines)
         cdef linelog_revnum *brevs = <linelog_revnum *>malloc(
@@ -412,6 +447,11 @@ cdef class linelog:
         if self.closed:
             raise ValueError(b'I/O operation on closed linelog')
 
+    cdef _checkwritable(self):
+        self._checkclosed()
+        if self.readonly:
+            raise ValueError(b'write operation on read-only linelog')
+
     cdef _clearannotateresult(self):
         linelog_annotateresult_clear(&self.ar)
 
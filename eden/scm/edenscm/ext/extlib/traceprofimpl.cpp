@@ -16,11 +16,14 @@
 #include <algorithm>
 #include <cassert>
 #include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <list>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -206,6 +209,68 @@ static void disable() {
   rdtscratio = (t2 - t1) / (double)(r2 - r1);
 }
 
+/* sampling ----------------------------------------------------------------- */
+
+/*
+ * Instead of hooking every call and return, a timer thread takes the GIL
+ * every sampleinterval and records the stack of the thread being profiled,
+ * like sys._current_frames() does. The GIL is what keeps samples, frames
+ * and the profiled stack consistent, so no other lock is needed. Each
+ * sample is recorded as a PyTrace_CALL of its innermost frame, which the
+ * report turns into time spent on that stack.
+ */
+
+static bool sampling = false;
+static bool samplingactive = false; /* protected by samplermutex */
+static PyThreadState* sampledthread;
+static std::thread sampler;
+static std::mutex samplermutex;
+static std::condition_variable samplercv;
+
+static void takesample() {
+  PyGILState_STATE gil = PyGILState_Ensure();
+#if PY_VERSION_HEX < 0x03090000
+  recordframe(sampledthread->frame, PyTrace_CALL);
+#else
+  PyFrameObject* frame = PyThreadState_GetFrame(sampledthread);
+  recordframe(frame, PyTrace_CALL);
+  Py_XDECREF(frame);
+#endif
+  PyGILState_Release(gil);
+}
+
+static void runsampler(std::chrono::microseconds interval) {
+  std::unique_lock<std::mutex> lock(samplermutex);
+  while (!samplercv.wait_for(lock, interval, [] { return !samplingactive; })) {
+    /* disablesampling releases the GIL before it takes the lock */
+    takesample();
+  }
+}
+
+static void enablesampling(uint64_t intervalus) {
+  sampling = true;
+  samplingactive = true;
+  sampledthread = PyThreadState_Get();
+  r1 = rdtsc();
+  t1 = now_microseconds() / 1000;
+  sampler = std::thread(runsampler, std::chrono::microseconds(intervalus));
+}
+
+static void disablesampling() {
+  /* the sampler may be waiting for the GIL */
+  Py_BEGIN_ALLOW_THREADS;
+  {
+    std::lock_guard<std::mutex> lock(samplermutex);
+    samplingactive = false;
+  }
+  samplercv.notify_one();
+  sampler.join();
+  Py_END_ALLOW_THREADS;
+  r2 = rdtsc();
+  t2 = now_microseconds() / 1000;
+  rdtscratio = (t2 - t1) / (double)(r2 - r1);
+}
+
 /* reporting ---------------------------------------------------------------- */
 
 struct FrameSummary {
@@ -281,6 +346,21 @@ static void buildsummaries() {
   }
 }
 
+/* fill summaries from stack samples: every frame on a sampled stack is
+   charged with the time since the previous sample */
+static void buildsampledsummaries() {
+  rdtsc_t last = r1;
+  for (auto& s : samples) {
+    rdtsc_t elapsed = s.time - last;
+    last = s.time;
+    for (frameid_t fid = s.frameid; fid; fid = frames[fid].back) {
+      auto& sum = summaries[dedupfid(fid)];
+      sum.time += elapsed;
+      sum.count += 1;
+    }
+  }
+}
+
 /* fill framechildren */
 static void buildframetree() {
   for (auto& s : samples) {
@@ -417,8 +497,8 @@ static void fprintframetree(
     /* frame name */
     ncol += fprintf(fp, "%s ", f.name());
 
-    /* call count */
-    if (s.count >= countthreshold) {
+    /* call count, which samples do not tell */
+    if (!sampling && s.count >= countthreshold) {
       ncol += fprintf(fp, "(%d times) ", s.count);
     }
 
@@ -451,12 +531,17 @@ static void clear() {
   hash2fid.clear();
   samples.clear();
   frames.clear();
+  sampling = false;
 }
 
 static void report(FILE* fp = stderr) {
-  if (dedup)
+  /* frames sampled at different times only match by their code */
+  if (dedup || sampling)
     buildframededup();
-  buildsummaries();
+  if (sampling)
+    buildsampledsummaries();
+  else
+    buildsummaries();
   buildframetree();
   fprintframetree(fp, dedupfid(0));
   fprintf(fp, "Total time: %.0f ms\n", (double)(r2 - r1) * rdtscratio);
@@ -25,6 +25,9 @@ from .node import hex
 
 _rangemask = 0x7FFFFFFF
 
+# The most directories the walk lists with one util.listdirs call.
+_walkbatchsize = 256
+
 
 class physicalfilesystem(object):
     def __init__(self, root, dirstate):
@@ -298,7 +301,7 @@ class physicalfilesystem(object):
     @util.timefunction("fswalk", 0, "ui")
     def _walk(self, match, listignored=False):
         join = self.opener.join
-        listdir = util.listdir
+        listdirs = util.listdirs
         dirkind = stat.S_IFDIR
         regkind = stat.S_IFREG
         lnkkind = stat.S_IFLNK
@@ -332,49 +335,59 @@ class physicalfilesystem(object):
         wadd = work.append
         seen = set()
         while work:
-            nd = work.pop()
-            if not match.visitdir(nd) or nd == dotdir:
-                continue
-            skip = None
-            if nd != "":
-                skip = dotdir
-            try:
-                entries = listdir(join(nd), stat=True, skip=skip)
-            except OSError as inst:
-                if inst.errno in (errno.EACCES, errno.ENOENT):
-                    match.bad(nd, encoding.strtolocal(inst.strerror))
-                    continue
-                raise
-            for f, kind, st in entries:
-                if not util.isvalidutf8(f):
-                    self.ui.warn(_("skipping invalid utf-8 filename: '%s'\n") % f)
-                    continue
-
-                if normalizefile:
-                    # even though f might be a directory, we're only
-                    # interested in comparing it to files currently in the
-                    # dmap -- therefore normalizefile is enough
-                    nf = normalizefile(nd and (nd + "/" + f) or f, True, True)
-                else:
-                    nf = nd and (nd + "/" + f) or f
-                if nf not in seen:
-                    seen.add(nf)
-                    if kind == dirkind:
-                        if not dirignore(nf) or nf in explicitdirs:
-                            if matchtdir:
-                                matchtdir(nf)
-                            nf = normalize(nf, True, True)
-                            wadd(nf)
-                    elif matchalways or matchfn(nf):
-                        if kind == regkind or kind == lnkkind:
-                            if nf in dmap:
-                                yield (nf, st)
-                            elif not ignore(nf):
-                                # unknown file
-                                yield (nf, st)
-                        else:
-                            # Invalid file types invoke match.bad in dirstate.py.
-                            pass
+            # List the most recently found directories together, so that
+            # listdirs can spread them over threads.
+            batch = [
+                nd
+                for nd in work[-_walkbatchsize:]
+                if match.visitdir(nd) and nd != dotdir
+            ]
+            del work[-_walkbatchsize:]
+            # The walk starts from the root alone, which is the only
+            # directory that may hold the dot directory.
+            skip = None if batch == [""] else dotdir
+            results = listdirs([join(nd) for nd in batch], stat=True, skip=skip)
+            for nd, entries in zip(batch, results):
+                if isinstance(entries, OSError):
+                    if entries.errno in (errno.EACCES, errno.ENOENT):
+                        match.bad(nd, encoding.strtolocal(entries.strerror))
+                        continue
+                    raise entries
+                for f, kind, st in entries:
+                    if not util.isvalidutf8(f):
+                        self.ui.warn(
+                            _("skipping invalid utf-8 filename: '%s'\n") % f
+                        )
+                        continue
+
+                    if normalizefile:
+                        # even though f might be a directory, we're only
+                        # interested in comparing it to files currently in the
+                        # dmap -- therefore normalizefile is enough
+                        nf = normalizefile(
+                            nd and (nd + "/" + f) or f, True, True
+                        )
+                    else:
+                        nf = nd and (nd + "/" + f) or f
+                    if nf not in seen:
+                        seen.add(nf)
+                        if kind == dirkind:
+                            if not dirignore(nf) or nf in explicitdirs:
+                                if matchtdir:
+                                    matchtdir(nf)
+                                nf = normalize(nf, True, True)
+                                wadd(nf)
+                        elif matchalways or matchfn(nf):
+                            if kind == regkind or kind == lnkkind:
+                                if nf in dmap:
+                                    yield (nf, st)
+                                elif not ignore(nf):
+                                    # unknown file
+                                    yield (nf, st)
+                            else:
+                                # Invalid file types invoke match.bad in
+                                # dirstate.py.
+                                pass
 
     def purge(self, match, removefiles, removedirs, removeignored, dryrun):
         """Deletes untracked files and directories from the filesystem.
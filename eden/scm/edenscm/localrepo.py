@@ -915,6 +915,10 @@ class localrepository(object):
         mmapindexthreshold = self.ui.configbytes("experimental", "mmapindexthreshold")
         if mmapindexthreshold is not None:
             self.svfs.options["mmapindexthreshold"] = mmapindexthreshold
+        # experimental config: experimental.nodetreethreshold
+        nodetreethreshold = self.ui.configint("experimental", "nodetreethreshold")
+        if nodetreethreshold is not None:
+            self.svfs.options["nodetreethreshold"] = nodetreethreshold
         withsparseread = self.ui.configbool("experimental", "sparse-read")
         srdensitythres = float(
             self.ui.config("experimental", "sparse-read.density-threshold")
@@ -190,10 +190,21 @@ static struct mpatch_flist* combine(
 int mpatch_decode(const char* bin, ssize_t len, struct mpatch_flist** res) {
   struct mpatch_flist* l;
   struct mpatch_frag* lt;
+  ssize_t end, count = 0;
   int pos = 0;
 
-  /* assume worst case size, we won't have many of these lists */
-  l = lalloc(len / 12 + 1);
+  /* Count the hunks first rather than assume the worst case of one per
+   * 12 bytes, which for a patch carrying a lot of text would allocate
+   * twice its size in hunks. */
+  for (end = 0; end < len - 11; count++) {
+    int hunklen = getbe32(bin + end + 8);
+    if (hunklen < 0)
+      break; /* rejected by the sanity check below */
+    end += 12 + (ssize_t)hunklen;
+  }
+
+  /* the loop below may write one more hunk before it gives up */
+  l = lalloc(count + 1);
   if (!l)
     return MPATCH_ERR_NO_MEM;
 
@@ -342,6 +342,7 @@ class revlog(object):
         """
         self.indexfile = indexfile
         self.datafile = datafile or (indexfile[:-2] + ".d")
+        self.nodetreefile = indexfile[:-2] + ".nodetree"
         self.opener = opener
         #  When True, indexfile is opened with checkambig=True at writing, to
         #  avoid file stat ambiguity.
@@ -367,6 +368,8 @@ class revlog(object):
         self._withsparseread = False
         self._srdensitythreshold = 0.25
         self._srmingapsize = 262144
+        # Persist the node->rev trie after this many new revs, or never.
+        self._nodetreethreshold = None
 
         mmapindexthreshold = None
         v = REVLOG_DEFAULT_VERSION
@@ -393,6 +396,7 @@ class revlog(object):
                 self._srdensitythreshold = opts["sparse-read-density-threshold"]
             if "sparse-read-min-gap-size" in opts:
                 self._srmingapsize = opts["sparse-read-min-gap-size"]
+            self._nodetreethreshold = opts.get("nodetreethreshold")
 
         if self._chunkcachesize <= 0:
             raise RevlogError(
@@ -471,6 +475,10 @@ class revlog(object):
         self.index, nodemap, self._chunkcache = d
         if nodemap is not None:
             self.nodemap = self._nodecache = nodemap
+        # Number of revs the loaded node trie maps.
+        self._nodetreerevs = 0
+        if self._nodetreethreshold is not None:
+            self._loadnodetree()
         if not self._chunkcache:
             self._chunkclear()
         # revnum -> (chain-length, sum-delta-length)
@@ -1015,10 +1023,16 @@ class revlog(object):
 
             bins = self._chunks(chain, df=_df)
             if rawtext is None:
-                rawtext = bytes(bins[0])
+                rawtext = bins[0]
                 bins = bins[1:]
 
-            rawtext = mdiff.patches(rawtext, bins)
+            # mpatch reads the base text from any buffer, so an uncompressed
+            # chunk only needs copying out of the segment when nothing is
+            # applied on top of it.
+            if bins:
+                rawtext = mdiff.patches(rawtext, bins)
+            else:
+                rawtext = bytes(rawtext)
             self._cache = (node, rev, rawtext)
 
         if flags is None:
@@ -1551,6 +1565,33 @@ class revlog(object):
         self._chainbasecache[curr] = chainbase
         return node
 
+    def _loadnodetree(self):
+        """Look up nodes in the trie written by _writenodetree
+
+        The file is mmapped, so that lookups need not scan the index or read
+        the whole trie first.
+        """
+        loadnodemap = getattr(self.index, "loadnodemap", None)
+        if loadnodemap is None:
+            return
+        try:
+            with self.opener(self.nodetreefile) as f:
+                data = util.mmapread(f)
+        except IOError as inst:
+            if inst.errno != errno.ENOENT:
+                raise
+            return
+        # None if the file is stale, for example after a strip
+        self._nodetreerevs = loadnodemap(data) or 0
+
+    def _writenodetree(self, tr):
+        if len(self) - self._nodetreerevs < self._nodetreethreshold:
+            return
+        data = self.index.nodemapdata()
+        with self.opener(self.nodetreefile, "w", atomictemp=True) as f:
+            f.write(data)
+        self._nodetreerevs = len(self)
+
     def _writeentry(self, transaction, ifh, dfh, entry, data, link, offset):
         # Files opened in a+ mode have inconsistent behavior on various
         # platforms. Windows requires that a file positioning call be made
@@ -1567,6 +1608,13 @@ class revlog(object):
             dfh.seek(0, os.SEEK_END)
 
         curr = len(self) - 1
+        if self._nodetreethreshold is not None and util.safehasattr(
+            self.index, "nodemapdata"
+        ):
+            # rewrite the trie once the revs are on disk
+            transaction.addpostclose(
+                "nodetree-%s" % self.indexfile, self._writenodetree
+            )
         if not self._inline:
             if not self._bypasstransaction:
                 transaction.add(self.datafile, offset)
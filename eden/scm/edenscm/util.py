@@ -199,6 +199,21 @@ unixsocket = platform.unixsocket
 unlink = platform.unlink
 username = platform.username
 
+
+def _listdirs(paths, stat=False, skip=None):
+    """listdir() every path in turn, with the OSError it raises in place of
+    the entries of a directory that can't be listed"""
+    results = []
+    for path in paths:
+        try:
+            results.append(listdir(path, stat=stat, skip=skip))
+        except OSError as ex:
+            results.append(ex)
+    return results
+
+
+listdirs = getattr(osutil, "listdirs", _listdirs)
+
 try:
     recvfds = osutil.recvfds
 except AttributeError:
@@ -26,6 +26,10 @@ Config::
 
     # frame de-duplication (slower to print outputs)
     framededup = yes
+
+    # if positive, sample the stack every that many microseconds instead
+    # of tracing every call: much cheaper, but calls are not counted
+    sampleinterval = 0
 """
 
 from libc.stdio cimport fopen, fclose, FILE
@@ -41,6 +45,8 @@ from edenscm import pycompat
 cdef extern from "edenscm/ext/extlib/traceprofimpl.cpp":
     void enable()
     void disable()
+    void enablesampling(unsigned long long)
+    void disablesampling()
     void report(FILE *)
     void settimethreshold(double)
     void setcountthreshold(size_t)
@@ -63,11 +69,20 @@ def profile(ui, fp, section="profiling"):
             setcountthreshold(count)
         dedup = ui.configbool('traceprof', 'framededup', True)
         setdedup(<int>dedup)
-    enable()
+        interval = ui.configint('traceprof', 'sampleinterval')
+    else:
+        interval = None
+    if interval:
+        enablesampling(interval)
+    else:
+        enable()
     try:
         yield
     finally:
-        disable()
+        if interval:
+            disablesampling()
+        else:
+            disable()
         # "report" only accepts a real file. "fp" could be stringio.
         # Therefore always use a temporary file as a buffer.
         pyfd, filename = tempfile.mkstemp("traceprof")
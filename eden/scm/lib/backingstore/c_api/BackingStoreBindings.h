@@ -33,13 +33,16 @@ enum class TreeEntryType : uint8_t {
 
 struct BackingStore;
 
+/// Owns the bytes a `CBytes` points to. Opaque to C++.
+struct CBytesOwner;
+
 template<typename T = void>
 struct Vec;
 
 struct CBytes {
   uint8_t *ptr;
   size_t len;
-  Vec<uint8_t> *vec;
+  CBytesOwner *owner;
   folly::ByteRange asByteRange() const {
     return folly::ByteRange(ptr, len);
   }
@@ -114,6 +117,7 @@ CFallibleBase sapling_backingstore_get_tree(BackingStore *store, Slice<uint8_t>
 void sapling_backingstore_get_tree_batch(BackingStore *store,
                                          Slice<Request> requests,
                                          bool local,
+                                         bool fetch_child_aux,
                                          void *data,
                                          void (*resolve)(void*, uintptr_t, CFallibleBase));
 
@@ -68,6 +68,7 @@ std::shared_ptr<Tree> SaplingNativeBackingStore::getTree(
 void SaplingNativeBackingStore::getTreeBatch(
     NodeIdRange requests,
     bool local,
+    bool fetchChildAux,
     folly::FunctionRef<void(size_t, folly::Try<std::shared_ptr<Tree>>)>
         resolve) {
   size_t count = requests.size();
@@ -113,6 +114,7 @@ void SaplingNativeBackingStore::getTreeBatch(
       store_.get(),
       folly::crange(raw_requests),
       local,
+      fetchChildAux,
       &inner_resolve,
       +[](void* fn, size_t index, CFallibleBase result) {
         (*static_cast<decltype(inner_resolve)*>(fn))(index, result);
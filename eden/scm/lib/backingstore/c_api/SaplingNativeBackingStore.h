@@ -51,6 +51,8 @@ using NodeIdRange = folly::Range<const NodeId*>;
  * - Batch methods take a callback function which is evaluated once per
  *   returned result. Compared to returning a vector, this minimizes the
  *   amount of time that heavyweight objects are in RAM.
+ * - The callback runs on the thread fetching the rest of the batch, so
+ *   expensive work on the results should be handed off to another thread.
  */
 class SaplingNativeBackingStore {
  public:
@@ -60,9 +62,15 @@ class SaplingNativeBackingStore {
 
   std::shared_ptr<Tree> getTree(NodeId node, bool local);
 
+  /**
+   * If fetchChildAux is true, the aux data of the files of the trees is
+   * fetched too if it didn't come with them, and resolve is only called once
+   * it's available.
+   */
   void getTreeBatch(
       NodeIdRange requests,
       bool local,
+      bool fetchChildAux,
       folly::FunctionRef<void(size_t, folly::Try<std::shared_ptr<Tree>>)>
           resolve);
 
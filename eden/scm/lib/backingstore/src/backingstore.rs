@@ -7,13 +7,16 @@
 
 use std::collections::hash_map::Entry;
 use std::collections::HashMap;
+use std::collections::HashSet;
 use std::path::Path;
 use std::sync::Arc;
 
 use anyhow::anyhow;
 use anyhow::Result;
 use log::warn;
+use manifest::FsNodeMetadata;
 use manifest::List;
+use minibytes::Bytes;
 use revisionstore::scmstore::file::FileAuxData;
 use revisionstore::scmstore::FetchMode;
 use revisionstore::scmstore::FileAttributes;
@@ -82,14 +85,14 @@ impl BackingStore {
         })
     }
 
-    pub fn get_blob(&self, node: &[u8], fetch_mode: FetchMode) -> Result<Option<Vec<u8>>> {
+    pub fn get_blob(&self, node: &[u8], fetch_mode: FetchMode) -> Result<Option<Bytes>> {
         let hgid = HgId::from_slice(node)?;
         let key = Key::new(RepoPathBuf::new(), hgid);
         self.get_blob_by_key(key, fetch_mode)
     }
 
     #[instrument(level = "debug", skip(self))]
-    fn get_blob_by_key(&self, key: Key, fetch_mode: FetchMode) -> Result<Option<Vec<u8>>> {
+    fn get_blob_by_key(&self, key: Key, fetch_mode: FetchMode) -> Result<Option<Bytes>> {
         if let FetchMode::LocalOnly = fetch_mode {
             event!(Level::TRACE, "attempting to fetch blob locally");
         }
@@ -99,7 +102,7 @@ impl BackingStore {
             .single();
 
         Ok(if let Some(mut file) = fetch_result? {
-            Some(file.file_content()?.into_vec())
+            Some(blob_content(file.file_content()?))
         } else {
             None
         })
@@ -179,7 +182,7 @@ impl BackingStore {
     #[instrument(level = "debug", skip(self, resolve))]
     pub fn get_blob_batch<F>(&self, keys: Vec<Key>, fetch_mode: FetchMode, resolve: F)
     where
-        F: Fn(usize, Result<Option<Vec<u8>>>) -> (),
+        F: Fn(usize, Result<Option<Bytes>>) -> (),
     {
         self.get_file_attrs_batch(
             keys,
@@ -188,11 +191,7 @@ impl BackingStore {
                 resolve(
                     idx,
                     res.transpose()
-                        .map(|res| {
-                            res.and_then(|mut file| {
-                                file.file_content().map(|content| content.into_vec())
-                            })
-                        })
+                        .map(|res| res.and_then(|mut file| file.file_content().map(blob_content)))
                         .transpose(),
                 )
             },
@@ -220,11 +219,23 @@ impl BackingStore {
     /// Fetch tree contents in batch. Whenever a tree is fetched, the supplied `resolve` function is
     /// called with the tree content or an error message, and the index of the tree in the request
     /// array.
+    ///
+    /// When `fetch_child_aux` is set, the aux data of the files of the trees that wasn't fetched
+    /// along with them, as for trees read from the local caches, is fetched in one more batch
+    /// before the trees are resolved. This saves the callers a round trip per directory when they
+    /// need the file sizes or hashes.
     #[instrument(level = "debug", skip(self, resolve))]
-    pub fn get_tree_batch<F>(&self, keys: Vec<Key>, fetch_mode: FetchMode, resolve: F)
-    where
+    pub fn get_tree_batch<F>(
+        &self,
+        keys: Vec<Key>,
+        fetch_mode: FetchMode,
+        fetch_child_aux: bool,
+        resolve: F,
+    ) where
         F: Fn(usize, Result<Option<(List, HashMap<HgId, FileAuxData>)>>),
     {
+        let local = matches!(fetch_mode, FetchMode::LocalOnly);
+
         // Handle key errors
         let requests = keys.into_iter().enumerate();
 
@@ -251,19 +262,22 @@ impl BackingStore {
             .treestore
             .fetch_batch(indexes.keys().cloned(), fetch_mode);
 
+        // Trees waiting for the aux data of their files.
+        let mut fetched_trees: Vec<(usize, (List, HashMap<HgId, FileAuxData>))> = Vec::new();
+
         // Handle pey-key fetch results
         for result in fetch_results {
             match result {
                 Ok((key, mut value)) => {
                     if let Some(index) = indexes.remove(&key) {
-                        resolve(
-                            index,
-                            Some(value.manifest_tree_entry().and_then(|tree| {
-                                let aux_data = value.aux_data()?;
-                                Ok((tree.try_into()?, aux_data))
-                            }))
-                            .transpose(),
-                        );
+                        let tree = value.manifest_tree_entry().and_then(|tree| {
+                            let aux_data = value.aux_data()?;
+                            Ok((tree.try_into()?, aux_data))
+                        });
+                        match tree {
+                            Ok(tree) if fetch_child_aux => fetched_trees.push((index, tree)),
+                            tree => resolve(index, tree.map(Some)),
+                        }
                     }
                 }
                 Err(err) => {
@@ -289,6 +303,72 @@ impl BackingStore {
                 }
             }
         }
+
+        if !fetched_trees.is_empty() {
+            let fetch_mode = if local {
+                FetchMode::LocalOnly
+            } else {
+                FetchMode::AllowRemote
+            };
+            self.fill_child_aux_data(&mut fetched_trees, fetch_mode);
+            for (index, tree) in fetched_trees {
+                resolve(index, Ok(Some(tree)));
+            }
+        }
+    }
+
+    /// Add the aux data of the files of `trees` that are missing it, fetched in a single batch.
+    /// Files whose aux data can't be fetched are left without.
+    fn fill_child_aux_data(
+        &self,
+        trees: &mut [(usize, (List, HashMap<HgId, FileAuxData>))],
+        fetch_mode: FetchMode,
+    ) {
+        let missing: HashSet<HgId> = trees
+            .iter()
+            .flat_map(|(_, (list, aux))| {
+                let children = match list {
+                    List::Directory(children) => children.as_slice(),
+                    _ => &[],
+                };
+                children.iter().filter_map(move |(_, node)| match node {
+                    FsNodeMetadata::File(metadata) if !aux.contains_key(&metadata.hgid) => {
+                        Some(metadata.hgid)
+                    }
+                    _ => None,
+                })
+            })
+            .collect();
+        if missing.is_empty() {
+            return;
+        }
+
+        let keys = missing
+            .into_iter()
+            .map(|hgid| Key::new(RepoPathBuf::new(), hgid));
+        let mut fetched: HashMap<HgId, FileAuxData> = HashMap::new();
+        for (key, file) in self
+            .filestore
+            .fetch(keys, FileAttributes::AUX, fetch_mode)
+            .into_iter()
+            .flatten()
+        {
+            if let Ok(aux) = file.aux_data() {
+                fetched.insert(key.hgid, aux);
+            }
+        }
+
+        for (_, (list, aux)) in trees.iter_mut() {
+            if let List::Directory(children) = list {
+                for (_, node) in children.iter() {
+                    if let FsNodeMetadata::File(metadata) = node {
+                        if let Some(child_aux) = fetched.get(&metadata.hgid) {
+                            aux.entry(metadata.hgid).or_insert(*child_aux);
+                        }
+                    }
+                }
+            }
+        }
     }
 
     pub fn get_file_aux(&self, node: &[u8], fetch_mode: FetchMode) -> Result<Option<FileAuxData>> {
@@ -342,3 +422,15 @@ impl Drop for BackingStore {
         self.flush();
     }
 }
+
+/// The blob content to hand to EdenFS. Usually the store's own `Bytes`, which may point into an
+/// mmap'd store file, so that large files aren't copied. On Windows, a mapped file can't be
+/// deleted, and EdenFS may cache blobs long enough to hold back the store's log rotation: copy
+/// them instead.
+fn blob_content(content: Bytes) -> Bytes {
+    if cfg!(windows) {
+        Bytes::from(content.to_vec())
+    } else {
+        content
+    }
+}
@@ -82,18 +82,24 @@ pub extern "C" fn sapling_backingstore_get_tree_batch(
     store: &mut BackingStore,
     requests: Slice<Request>,
     local: bool,
+    fetch_child_aux: bool,
     data: *mut c_void,
     resolve: unsafe extern "C" fn(*mut c_void, usize, CFallibleBase),
 ) {
     let keys: Vec<Key> = requests.slice().iter().map(|req| req.key()).collect();
 
-    store.get_tree_batch(keys, fetch_mode_from_local(local), |idx, result| {
-        let result: Result<(List, HashMap<HgId, ScmStoreFileAuxData>)> =
-            result.and_then(|opt| opt.ok_or_else(|| Error::msg("no tree found")));
-        let result: Result<Tree> = result.and_then(|list| list.try_into());
-        let result: CFallible<Tree> = result.into();
-        unsafe { resolve(data, idx, result.into()) };
-    });
+    store.get_tree_batch(
+        keys,
+        fetch_mode_from_local(local),
+        fetch_child_aux,
+        |idx, result| {
+            let result: Result<(List, HashMap<HgId, ScmStoreFileAuxData>)> =
+                result.and_then(|opt| opt.ok_or_else(|| Error::msg("no tree found")));
+            let result: Result<Tree> = result.and_then(|list| list.try_into());
+            let result: CFallible<Tree> = result.into();
+            unsafe { resolve(data, idx, result.into()) };
+        },
+    );
 }
 
 #[no_mangle]
@@ -106,7 +112,7 @@ pub extern "C" fn sapling_backingstore_get_blob(
         store
             .get_blob(node.slice(), fetch_mode_from_local(local))
             .and_then(|opt| opt.ok_or_else(|| Error::msg("no blob found")))
-            .map(CBytes::from_vec)
+            .map(CBytes::from_bytes)
     })
     .into()
 }
@@ -123,7 +129,7 @@ pub extern "C" fn sapling_backingstore_get_blob_batch(
     store.get_blob_batch(keys, fetch_mode_from_local(local), |idx, result| {
         let result: CFallible<CBytes> = result
             .and_then(|opt| opt.ok_or_else(|| Error::msg("no blob found")))
-            .map(CBytes::from_vec)
+            .map(CBytes::from_bytes)
             .into();
         unsafe { resolve(data, idx, result.into()) };
     });
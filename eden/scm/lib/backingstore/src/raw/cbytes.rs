@@ -5,28 +5,40 @@
  * GNU General Public License version 2.
  */
 
-//! Provides a struct to pass a Rust `vec` to C++. However, the C++ code must hold a reference to
-//! the underlying Rust `vec` since `Vec::as_ptr` requires the vector remain valid and alive over
-//! the lifetime of the pointer it returns.
+//! Provides a struct to pass Rust bytes to C++. However, the C++ code must hold a reference to
+//! the underlying Rust `Bytes` since the pointer is only valid while the bytes are alive.
+//!
+//! Blob contents are passed as the `Bytes` the store returned rather than copied into a `Vec`:
+//! for large files backed by an mmap'd store, this avoids a transient copy of the whole file.
 
 use libc::size_t;
+use minibytes::Bytes;
+
+/// Owns the bytes a `CBytes` points to. Opaque to C++.
+pub struct CBytesOwner(Bytes);
 
 #[repr(C)]
 pub struct CBytes {
     ptr: *mut u8,
     len: size_t,
-    vec: *mut Vec<u8>,
+    owner: *mut CBytesOwner,
 }
 
 impl CBytes {
     pub fn from_vec(vec: Vec<u8>) -> Self {
-        let mut vec = Box::new(vec);
-        let ptr = vec.as_mut_ptr();
+        CBytes::from_bytes(Bytes::from(vec))
+    }
+
+    pub fn from_bytes(bytes: Bytes) -> Self {
+        let owner = Box::new(CBytesOwner(bytes));
+        // C++ never writes through the pointer, it's only mutable to match
+        // folly::IOBuf::takeOwnership.
+        let ptr = owner.0.as_ptr() as *mut u8;
 
         Self {
             ptr,
-            len: vec.len(),
-            vec: Box::into_raw(vec),
+            len: owner.0.len(),
+            owner: Box::into_raw(owner),
         }
     }
 }
@@ -37,10 +49,16 @@ impl From<Vec<u8>> for CBytes {
     }
 }
 
+impl From<Bytes> for CBytes {
+    fn from(bytes: Bytes) -> Self {
+        CBytes::from_bytes(bytes)
+    }
+}
+
 impl Drop for CBytes {
     fn drop(&mut self) {
-        let vec = unsafe { Box::from_raw(self.vec) };
-        drop(vec);
+        let owner = unsafe { Box::from_raw(self.owner) };
+        drop(owner);
     }
 }
 
@@ -208,21 +208,94 @@ inline static linelog_result appendline(
   return LINELOG_RESULT_OK;
 }
 
-linelog_result linelog_annotate(
+/* a checkpoint is recorded every CHECKPOINT_INTERVAL instructions run */
+#define CHECKPOINT_INTERVAL 128
+
+/* number of leading checkpoints in cache that rev can resume from. every
+   checkpoint of a run is valid for a subset of the revisions of the previous
+   one, so they form a prefix */
+static size_t findcheckpoint(
+    const linelog_annotatecache* cache,
+    linelog_revnum rev) {
+  size_t lo = 0, hi = cache->count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    const linelog_checkpoint* cp = &cache->checkpoints[mid];
+    if (cp->minrev <= rev && rev <= cp->maxrev)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+static linelog_result addcheckpoint(
+    linelog_annotatecache* cache,
+    const linelog_checkpoint* cp) {
+  if (cache->count == cache->maxcount) {
+    size_t maxcount = cache->maxcount ? cache->maxcount * 2 : 16;
+    void* p = realloc(cache->checkpoints, sizeof(*cp) * maxcount);
+    if (p == NULL)
+      return LINELOG_RESULT_ENOMEM;
+    cache->checkpoints = (linelog_checkpoint*)p;
+    cache->maxcount = maxcount;
+  }
+  cache->checkpoints[cache->count++] = *cp;
+  return LINELOG_RESULT_OK;
+}
+
+/* linelog_annotate, resuming from and recording checkpoints if cache is not
+   NULL. the caller is responsible for copying ar to cache->ar afterwards */
+static linelog_result annotate(
     const linelog_buf* buf,
     linelog_annotateresult* ar,
-    linelog_revnum rev) {
+    linelog_revnum rev,
+    linelog_annotatecache* cache) {
   linelog_inst inst0;
   returnonerror(readinst(buf, &inst0, 0));
 
   linelog_offset pc, nextpc = 1, endoffset = 0;
   ar->linecount = 0;
   size_t step = (size_t)inst0.offset;
+  /* revisions that would have run the same instructions so far */
+  linelog_revnum minrev = 0, maxrev = UINT32_MAX;
+
+  if (cache) {
+    if (cache->bufmaxrev != inst0.rev || cache->buflen != inst0.offset) {
+      cache->count = 0;
+      cache->bufmaxrev = inst0.rev;
+      cache->buflen = inst0.offset;
+    }
+    size_t k = findcheckpoint(cache, rev);
+    cache->count = k;
+    if (k > 0) {
+      const linelog_checkpoint* cp = &cache->checkpoints[k - 1];
+      /* the last checkpoint of a complete run has pc 0, and its lines are
+         followed by the END marker line */
+      size_t count = (size_t)cp->linecount + (cp->pc == 0);
+      assert(count <= cache->ar.linecount + 1u);
+      returnonerror(reservelines(ar, count));
+      memcpy(ar->lines, cache->ar.lines, sizeof(linelog_lineinfo) * count);
+      ar->linecount = cp->linecount;
+      if (cp->pc == 0)
+        return LINELOG_RESULT_OK;
+      cache->count = k - 1; /* recorded again when the loop resumes at it */
+      nextpc = cp->pc;
+      step = cp->step + 1; /* pre-decrement value, see below */
+      minrev = cp->minrev;
+      maxrev = cp->maxrev;
+    }
+  }
 
   while ((pc = nextpc++) != 0 && --step) {
     linelog_inst i;
     returnonerror(readinst(buf, &i, pc));
 
+    if (cache && step % CHECKPOINT_INTERVAL == 0) {
+      linelog_checkpoint cp = {pc, ar->linecount, minrev, maxrev, step};
+      returnonerror(addcheckpoint(cache, &cp));
+    }
+
     switch (i.opcode) {
       case JGE:
       case JL: /* conditional jump */
@@ -231,6 +304,13 @@ linelog_result linelog_annotate(
           if (nextpc == 0) /* met the END marker */
             endoffset = pc;
         }
+        /* narrow [minrev, maxrev] to the side of i.rev that rev is on */
+        if (rev >= i.rev) {
+          if (minrev < i.rev)
+            minrev = i.rev;
+        } else if (maxrev > i.rev - 1) {
+          maxrev = i.rev - 1;
+        }
         break;
       case LINE: /* append a line */
         returnonerror(appendline(ar, &i, pc));
@@ -246,6 +326,49 @@ linelog_result linelog_annotate(
   /* ar->lines[ar->linecount].offset records the endoffset */
   returnonerror(appendline(ar, NULL, endoffset));
   ar->linecount--; /* do not include this special line */
+
+  if (cache) {
+    linelog_checkpoint cp = {0, ar->linecount, minrev, maxrev, 0};
+    returnonerror(addcheckpoint(cache, &cp));
+  }
+  return LINELOG_RESULT_OK;
+}
+
+linelog_result linelog_annotate(
+    const linelog_buf* buf,
+    linelog_annotateresult* ar,
+    linelog_revnum rev) {
+  return annotate(buf, ar, rev, NULL);
+}
+
+void linelog_annotatecache_clear(linelog_annotatecache* cache) {
+  free(cache->checkpoints);
+  linelog_annotateresult_clear(&cache->ar);
+  memset(cache, 0, sizeof(linelog_annotatecache));
+}
+
+linelog_result linelog_annotate_cached(
+    const linelog_buf* buf,
+    linelog_annotateresult* ar,
+    linelog_revnum rev,
+    linelog_annotatecache* cache) {
+  linelog_result result = annotate(buf, ar, rev, cache);
+  if (result != LINELOG_RESULT_OK) {
+    cache->count = 0;
+    return result;
+  }
+
+  /* keep the lines the checkpoints refer to */
+  if (reservelines(&cache->ar, (size_t)ar->linecount + 1) !=
+      LINELOG_RESULT_OK) {
+    cache->count = 0; /* ar is still fine */
+    return LINELOG_RESULT_OK;
+  }
+  memcpy(
+      cache->ar.lines,
+      ar->lines,
+      sizeof(linelog_lineinfo) * ((size_t)ar->linecount + 1));
+  cache->ar.linecount = ar->linecount;
   return LINELOG_RESULT_OK;
 }
 
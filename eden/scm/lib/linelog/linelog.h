@@ -53,6 +53,34 @@ typedef struct {
 /* free memory used by ar, useful to reset ar from an invalid state */
 void linelog_annotateresult_clear(linelog_annotateresult* ar);
 
+/* a point of a linelog_annotate run: the instruction it is about to execute
+   and the lines it has produced so far, which are the same for every
+   revision in range(minrev, maxrev + 1) */
+typedef struct {
+  linelog_offset pc;
+  linelog_linenum linecount;
+  linelog_revnum minrev;
+  linelog_revnum maxrev;
+  size_t step; /* instructions left before giving up on a loop */
+} linelog_checkpoint;
+
+/* checkpoints of the last linelog_annotate_cached run, and its result.
+   another run for a revision within the range of a checkpoint resumes from
+   it rather than from the start of the program.
+   memset to 0 before use, call linelog_annotatecache_clear to free memory */
+typedef struct {
+  linelog_checkpoint* checkpoints;
+  size_t count;
+  size_t maxcount;
+  linelog_annotateresult ar;
+  /* inst0 of the buf the cache was filled from, see linelog.c */
+  linelog_revnum bufmaxrev;
+  linelog_offset buflen;
+} linelog_annotatecache;
+
+/* free memory used by cache, and forget what it held */
+void linelog_annotatecache_clear(linelog_annotatecache* cache);
+
 /* (re-)initialize the buffer, make it represent an empty file */
 linelog_result linelog_clear(linelog_buf* buf);
 
@@ -79,6 +107,19 @@ linelog_result linelog_annotate(
     linelog_annotateresult* ar,
     linelog_revnum rev);
 
+/* like linelog_annotate, but resume from a checkpoint in cache if there is
+   one for rev, and update cache with the checkpoints of this run
+
+   changes made with linelog_replacelines* are noticed and empty the cache.
+   clear the cache if buf is replaced with other content.
+
+   on error, cache is emptied and ar may be in an invalid state */
+linelog_result linelog_annotate_cached(
+    const linelog_buf* buf,
+    linelog_annotateresult* ar,
+    linelog_revnum rev,
+    linelog_annotatecache* cache);
+
 /* update buf and ar, replace existing lines[a1:a2] with lines[b1:b2] in brev
 
    ar should be obtained using linelog_annotate(brev).
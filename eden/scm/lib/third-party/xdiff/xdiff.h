@@ -35,6 +35,15 @@ extern "C" {
 
 #define XDF_INDENT_HEURISTIC (1 << 23)
 
+/* diff algorithm. Without either flag, histogram diff is used when at least
+ * XDL_HISTOGRAM_MIN_RECORDS lines remain to be diffed after the common prefix,
+ * suffix and unmatchable lines are removed, and Myers otherwise.
+ * XDF_NEED_MINIMAL implies Myers unless XDF_HISTOGRAM_DIFF is set. */
+#define XDF_MYERS_DIFF (1 << 14)
+#define XDF_HISTOGRAM_DIFF (1 << 15)
+#define XDF_DIFF_ALGORITHM_MASK (XDF_MYERS_DIFF | XDF_HISTOGRAM_DIFF)
+#define XDL_HISTOGRAM_MIN_RECORDS 10000
+
 /* only need edit cost without hunks.
  * max edit cost set by xpparam_t max_edit_cost. */
 #define XDF_CAPPED_EDIT_COST_ONLY (1 << 22)
@@ -353,6 +353,21 @@ int64_t xdl_recs_cmp_vendored(diffdata_t *dd1, int64_t off1, int64_t lim1,
 }
 
 
+static int use_histogram(xpparam_t const *xpp, int need_min, int64_t nrec) {
+	/* Only Myers can compute the capped edit cost. */
+	if (need_min == 2)
+		return 0;
+	switch (xpp->flags & XDF_DIFF_ALGORITHM_MASK) {
+	case XDF_HISTOGRAM_DIFF:
+		return 1;
+	case XDF_MYERS_DIFF:
+		return 0;
+	default:
+		return !need_min && nrec >= XDL_HISTOGRAM_MIN_RECORDS;
+	}
+}
+
+
 int64_t xdl_do_diff_vendored(mmfile_t *mf1, mmfile_t *mf2, xpparam_t const *xpp,
 		xdfenv_t *xe) {
 	int64_t ndiags;
@@ -411,8 +426,13 @@ int64_t xdl_do_diff_vendored(mmfile_t *mf1, mmfile_t *mf2, xpparam_t const *xpp,
 	dd2.rchg = xe->xdf2.rchg;
 	dd2.rindex = xe->xdf2.rindex;
 
-	int64_t ret = xdl_recs_cmp_vendored(&dd1, 0, dd1.nrec, &dd2, 0, dd2.nrec,
-			 kvdf, kvdb, need_min, &xenv);
+	int64_t ret;
+	if (use_histogram(xpp, need_min, dd1.nrec + dd2.nrec))
+		ret = xdl_histogram_diff_vendored(&dd1, &dd2, kvdf, kvdb, need_min,
+						  &xenv);
+	else
+		ret = xdl_recs_cmp_vendored(&dd1, 0, dd1.nrec, &dd2, 0, dd2.nrec,
+					    kvdf, kvdb, need_min, &xenv);
 	if (need_min == 2 || ret < 0) {
 		xdl_free_env_vendored(xe);
 	}
@@ -49,6 +49,9 @@ typedef struct s_xdchange {
 int64_t xdl_recs_cmp_vendored(diffdata_t *dd1, int64_t off1, int64_t lim1,
 		 diffdata_t *dd2, int64_t off2, int64_t lim2,
 		 int64_t *kvdf, int64_t *kvdb, int need_min, xdalgoenv_t *xenv);
+int64_t xdl_histogram_diff_vendored(diffdata_t *dd1, diffdata_t *dd2,
+				    int64_t *kvdf, int64_t *kvdb, int need_min,
+				    xdalgoenv_t *xenv);
 int64_t xdl_do_diff_vendored(mmfile_t *mf1, mmfile_t *mf2, xpparam_t const *xpp,
 		xdfenv_t *xe);
 int xdl_change_compact_vendored(xdfile_t *xdf, xdfile_t *xdfo, int64_t flags);
@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+/*
+ * Histogram diff, as in JGit and git: split the region around the longest
+ * run of common lines that contains the rarest line, and recurse into both
+ * sides. Unlike Myers, the work depends little on how many lines repeat,
+ * which makes it a better fit for large inputs such as lockfiles.
+ *
+ * Like xdl_recs_cmp_vendored, this works on the records left after
+ * xdl_prepare_env_vendored removed the common prefix and suffix and the
+ * lines that can't match, and marks the changed ones in rchg.
+ */
+
+#include "xinclude.h"
+
+/* Lines occurring more often than this in a region never anchor a split. */
+#define XDL_HISTOGRAM_MAX_OCCURRENCES 64
+
+/*
+ * The histogram diff of a pair of inputs may look at every line this many
+ * times over. The regions left once that budget is spent are diffed with
+ * Myers and its heuristics instead.
+ */
+#define XDL_HISTOGRAM_COST_FACTOR 16
+
+/* A distinct line of the first side of a region. */
+typedef struct s_xhrecord {
+	uint64_t ha;
+	/* its first occurrence, and the number of occurrences */
+	int64_t first, cnt;
+} xhrecord_t;
+
+typedef struct s_xhindex {
+	xhrecord_t *records;
+	/* open addressing table of indices into records, -1 when empty */
+	int64_t *table;
+	unsigned int tbits;
+	/* for every line of the region, relative to its start: the next
+	 * occurrence of the same line or -1, and its index in records */
+	int64_t *next;
+	int64_t *recidx;
+} xhindex_t;
+
+typedef struct s_xhregion {
+	int64_t off1, lim1, off2, lim2;
+} xhregion_t;
+
+typedef struct s_xhlcs {
+	int64_t i1, i2, len;
+	/* distance from the diagonal of the region */
+	int64_t skew;
+} xhlcs_t;
+
+enum {
+	XH_FOUND,
+	XH_NO_COMMON,
+	XH_TOO_COMMON,
+};
+
+
+static int64_t *xh_slot(xhindex_t *ix, uint64_t ha) {
+	uint64_t mask = ((uint64_t) 1 << ix->tbits) - 1;
+	uint64_t i = (ha * 0x9e3779b97f4a7c15ULL) >> (64 - ix->tbits);
+
+	for (; ix->table[i] >= 0 && ix->records[ix->table[i]].ha != ha;
+	     i = (i + 1) & mask);
+	return &ix->table[i];
+}
+
+
+static int xh_find_lcs(xhindex_t *ix, diffdata_t *dd1, int64_t off1,
+		       int64_t lim1, diffdata_t *dd2, int64_t off2,
+		       int64_t lim2, xhlcs_t *lcs) {
+	uint64_t const *ha1 = dd1->ha, *ha2 = dd2->ha;
+	int64_t i, a, b, bnext, as, bs, ae, be, rc, skew, *slot;
+	int64_t nrecords = 0, lowcnt = XDL_HISTOGRAM_MAX_OCCURRENCES;
+	int has_common = 0;
+	xhrecord_t *rec;
+
+	/* A table at most half full, so that probe sequences stay short. */
+	for (ix->tbits = 1; ((int64_t) 1 << ix->tbits) < 2 * (lim1 - off1);
+	     ix->tbits++);
+	memset(ix->table, -1, sizeof(int64_t) << ix->tbits);
+
+	/* Index the first side backwards, so that chains are in order. */
+	for (i = lim1 - 1; i >= off1; i--) {
+		slot = xh_slot(ix, ha1[i]);
+		if (*slot < 0) {
+			*slot = nrecords++;
+			rec = &ix->records[*slot];
+			rec->ha = ha1[i];
+			rec->first = -1;
+			rec->cnt = 0;
+		}
+		rec = &ix->records[*slot];
+		ix->next[i - off1] = rec->first;
+		ix->recidx[i - off1] = *slot;
+		rec->first = i;
+		rec->cnt++;
+	}
+
+	lcs->len = 0;
+	lcs->skew = 0;
+	for (b = off2; b < lim2; b = bnext) {
+		bnext = b + 1;
+		slot = xh_slot(ix, ha2[b]);
+		if (*slot < 0)
+			continue;
+		has_common = 1;
+		rec = &ix->records[*slot];
+		if (rec->cnt > lowcnt)
+			continue;
+
+		for (a = rec->first; a >= 0; ) {
+			/* Extend the match both ways, tracking its rarest line. */
+			rc = rec->cnt;
+			for (as = a, bs = b; as > off1 && bs > off2 &&
+			     ha1[as - 1] == ha2[bs - 1]; as--, bs--)
+				if (rc > 1)
+					rc = XDL_MIN(rc, ix->records[ix->recidx[as - 1 - off1]].cnt);
+			for (ae = a, be = b; ae + 1 < lim1 && be + 1 < lim2 &&
+			     ha1[ae + 1] == ha2[be + 1]; ae++, be++)
+				if (rc > 1)
+					rc = XDL_MIN(rc, ix->records[ix->recidx[ae + 1 - off1]].cnt);
+
+			if (bnext <= be)
+				bnext = be + 1;
+			/*
+			 * Of equally long and rare matches, keep the one closest
+			 * to the diagonal: when a block of lines repeats, as in
+			 * concatenated or generated files, this pairs up the
+			 * same copy on both sides rather than the first one.
+			 */
+			skew = XDL_ABS((as - off1) - (bs - off2));
+			if (lcs->len < ae - as + 1 || rc < lowcnt ||
+			    (lcs->len == ae - as + 1 && rc == lowcnt &&
+			     skew < lcs->skew)) {
+				lcs->i1 = as;
+				lcs->i2 = bs;
+				lcs->len = ae - as + 1;
+				lcs->skew = skew;
+				lowcnt = rc;
+			}
+
+			/* Occurrences inside this match can't start a longer one. */
+			for (a = ix->next[a - off1]; a >= 0 && a <= ae;
+			     a = ix->next[a - off1]);
+		}
+	}
+
+	if (lcs->len > 0)
+		return XH_FOUND;
+	return has_common ? XH_TOO_COMMON : XH_NO_COMMON;
+}
+
+
+static void xh_mark_changed(diffdata_t *dd, int64_t off, int64_t lim) {
+	for (; off < lim; off++)
+		dd->rchg[dd->rindex[off]] = 1;
+}
+
+
+static int xh_push(xhregion_t **stack, int64_t *size, int64_t *alloc,
+		   int64_t off1, int64_t lim1, int64_t off2, int64_t lim2) {
+	xhregion_t *grown;
+
+	if (off1 == lim1 && off2 == lim2)
+		return 0;
+	if (*size == *alloc) {
+		*alloc *= 2;
+		if (!(grown = (xhregion_t *) xdl_realloc(*stack,
+				*alloc * sizeof(xhregion_t))))
+			return -1;
+		*stack = grown;
+	}
+	(*stack)[*size].off1 = off1;
+	(*stack)[*size].lim1 = lim1;
+	(*stack)[*size].off2 = off2;
+	(*stack)[*size].lim2 = lim2;
+	(*size)++;
+	return 0;
+}
+
+
+int64_t xdl_histogram_diff_vendored(diffdata_t *dd1, diffdata_t *dd2,
+				    int64_t *kvdf, int64_t *kvdb, int need_min,
+				    xdalgoenv_t *xenv) {
+	uint64_t const *ha1 = dd1->ha, *ha2 = dd2->ha;
+	int64_t n1 = dd1->nrec, n2 = dd2->nrec;
+	int64_t off1, lim1, off2, lim2, size = 0, alloc = 64;
+	int64_t budget = XDL_HISTOGRAM_COST_FACTOR * (n1 + n2);
+	int64_t ret = -1;
+	xhregion_t *stack = NULL;
+	xhindex_t ix;
+	xhlcs_t lcs;
+	int64_t tsize;
+
+	for (tsize = 2; tsize < 2 * n1; tsize *= 2);
+	ix.records = (xhrecord_t *) xdl_malloc((n1 + 1) * sizeof(xhrecord_t));
+	ix.table = (int64_t *) xdl_malloc(tsize * sizeof(int64_t));
+	ix.next = (int64_t *) xdl_malloc((n1 + 1) * sizeof(int64_t));
+	ix.recidx = (int64_t *) xdl_malloc((n1 + 1) * sizeof(int64_t));
+	stack = (xhregion_t *) xdl_malloc(alloc * sizeof(xhregion_t));
+	if (!ix.records || !ix.table || !ix.next || !ix.recidx || !stack)
+		goto out;
+
+	if (xh_push(&stack, &size, &alloc, 0, n1, 0, n2) < 0)
+		goto out;
+	while (size > 0) {
+		size--;
+		off1 = stack[size].off1;
+		lim1 = stack[size].lim1;
+		off2 = stack[size].off2;
+		lim2 = stack[size].lim2;
+
+		for (; off1 < lim1 && off2 < lim2 && ha1[off1] == ha2[off2];
+		     off1++, off2++);
+		for (; off1 < lim1 && off2 < lim2 &&
+		     ha1[lim1 - 1] == ha2[lim2 - 1]; lim1--, lim2--);
+		if (off1 == lim1 || off2 == lim2) {
+			xh_mark_changed(dd1, off1, lim1);
+			xh_mark_changed(dd2, off2, lim2);
+			continue;
+		}
+
+		budget -= (lim1 - off1) + (lim2 - off2);
+		switch (budget < 0 ? XH_TOO_COMMON :
+			xh_find_lcs(&ix, dd1, off1, lim1, dd2, off2, lim2, &lcs)) {
+		case XH_FOUND:
+			if (xh_push(&stack, &size, &alloc, lcs.i1 + lcs.len,
+				    lim1, lcs.i2 + lcs.len, lim2) < 0 ||
+			    xh_push(&stack, &size, &alloc, off1, lcs.i1,
+				    off2, lcs.i2) < 0)
+				goto out;
+			break;
+		case XH_NO_COMMON:
+			xh_mark_changed(dd1, off1, lim1);
+			xh_mark_changed(dd2, off2, lim2);
+			break;
+		case XH_TOO_COMMON:
+			if (xdl_recs_cmp_vendored(dd1, off1, lim1, dd2, off2,
+						  lim2, kvdf, kvdb, need_min,
+						  xenv) < 0)
+				goto out;
+			break;
+		}
+	}
+	ret = 0;
+
+out:
+	xdl_free(stack);
+	xdl_free(ix.recidx);
+	xdl_free(ix.next);
+	xdl_free(ix.table);
+	xdl_free(ix.records);
+	return ret;
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+use std::os::raw::c_char;
+use std::os::raw::c_int;
+use std::os::raw::c_void;
+
+use minibench::bench;
+use minibench::elapsed;
+use xdiff_sys::mmfile_t;
+use xdiff_sys::xdemitcb_t;
+use xdiff_sys::xdemitconf_t;
+use xdiff_sys::xdl_diff_vendored;
+use xdiff_sys::xpparam_t;
+
+extern "C" fn hunk_func(_a1: i64, _a2: i64, _b1: i64, _b2: i64, _priv: *mut c_void) -> c_int {
+    0
+}
+
+fn diff(a: &[u8], b: &[u8]) {
+    let mut a_mmfile = mmfile_t {
+        ptr: a.as_ptr() as *mut c_char,
+        size: a.len() as i64,
+    };
+    let mut b_mmfile = mmfile_t {
+        ptr: b.as_ptr() as *mut c_char,
+        size: b.len() as i64,
+    };
+    let xpp = xpparam_t {
+        flags: 0,
+        max_edit_cost: 0,
+    };
+    let xecfg = xdemitconf_t {
+        flags: 0,
+        hunk_func: Some(hunk_func),
+    };
+    let mut ecb = xdemitcb_t {
+        priv_: std::ptr::null_mut(),
+    };
+    unsafe {
+        xdl_diff_vendored(&mut a_mmfile, &mut b_mmfile, &xpp, &xecfg, &mut ecb);
+    }
+}
+
+/// Generated-looking source: many similar lines of a few hundred bytes.
+fn generated_file(lines: usize) -> Vec<u8> {
+    let mut out = Vec::new();
+    for i in 0..lines {
+        out.extend_from_slice(
+            format!(
+                "    {{\"id\": {}, \"name\": \"field_{}\", \"type\": \"string\", \"doc\": \"{}\"}},\n",
+                i,
+                i,
+                "generated ".repeat(i % 32)
+            )
+            .as_bytes(),
+        );
+    }
+    out
+}
+
+/// Inserts a line before one in every `every` lines.
+fn edit(a: &[u8], every: usize) -> Vec<u8> {
+    let mut out = Vec::with_capacity(a.len());
+    for (i, line) in a.split_inclusive(|&c| c == b'\n').enumerate() {
+        if i % every == 0 {
+            out.extend_from_slice(b"// edited\n");
+        }
+        out.extend_from_slice(line);
+    }
+    out
+}
+
+fn main() {
+    // Set XDIFF_BENCH_FILES to a colon-separated list of large files, e.g.
+    // generated sources, to measure real-world inputs as well.
+    let mut inputs: Vec<(String, Vec<u8>)> = vec![(
+        "generated (200k lines)".to_string(),
+        generated_file(200_000),
+    )];
+    if let Ok(files) = std::env::var("XDIFF_BENCH_FILES") {
+        for path in files.split(':').filter(|p| !p.is_empty()) {
+            inputs.push((path.to_string(), std::fs::read(path).unwrap()));
+        }
+    }
+
+    for (name, a) in &inputs {
+        let b = edit(a, 1000);
+        bench(format!("xdiff {} ({} bytes)", name, a.len()), || {
+            elapsed(|| {
+                diff(a, &b);
+            })
+        });
+        bench(format!("xdiff {} identical", name), || {
+            elapsed(|| {
+                diff(a, a);
+            })
+        });
+    }
+}
@@ -9,6 +9,7 @@ fn main() {
     cc::Build::new()
         .files(&[
             "../third-party/xdiff/xdiffi.c",
+            "../third-party/xdiff/xhistogram.c",
             "../third-party/xdiff/xprepare.c",
             "../third-party/xdiff/xutils.c",
         ])
@@ -10,6 +10,10 @@
 pub const XDF_NEED_MINIMAL: u32 = 1;
 pub const XDF_INDENT_HEURISTIC: u32 = 8388608;
 pub const XDF_CAPPED_EDIT_COST_ONLY: u32 = 4194304;
+pub const XDF_MYERS_DIFF: u32 = 16384;
+pub const XDF_HISTOGRAM_DIFF: u32 = 32768;
+pub const XDF_DIFF_ALGORITHM_MASK: u32 = 49152;
+pub const XDL_HISTOGRAM_MIN_RECORDS: u32 = 10000;
 pub const XDL_EMIT_BDIFFHUNK: u32 = 16;
 #[repr(C)]
 #[derive(Debug, Copy, Clone)]
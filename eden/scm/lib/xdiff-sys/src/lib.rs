@@ -21,16 +21,53 @@ mod tests {
 
     use super::*;
 
-    #[test]
-    fn test_xdl_diff_vendored() {
-        extern "C" fn hunk_func(a1: i64, a2: i64, b1: i64, b2: i64, _priv: *mut c_void) -> c_int {
-            let mut _priv = unsafe { (_priv as *mut Vec<(i64, i64, i64, i64)>).as_mut() };
-            if let Some(result) = _priv {
-                result.push((a1, a2, b1, b2));
-            }
-            return 0;
+    extern "C" fn hunk_func(a1: i64, a2: i64, b1: i64, b2: i64, _priv: *mut c_void) -> c_int {
+        let mut _priv = unsafe { (_priv as *mut Vec<(i64, i64, i64, i64)>).as_mut() };
+        if let Some(result) = _priv {
+            result.push((a1, a2, b1, b2));
         }
+        return 0;
+    }
 
+    fn diff(a: &str, b: &str, flags: u64) -> Vec<(i64, i64, i64, i64)> {
+        let mut a_mmfile = mmfile_t {
+            ptr: a.as_ptr() as *mut c_char,
+            size: a.len() as i64,
+        };
+        let mut b_mmfile = mmfile_t {
+            ptr: b.as_ptr() as *mut c_char,
+            size: b.len() as i64,
+        };
+        let xpp = xpparam_t {
+            flags,
+            max_edit_cost: 0,
+        };
+        let xecfg = xdemitconf_t {
+            flags: 0,
+            hunk_func: Some(hunk_func),
+        };
+        let mut result: Vec<(i64, i64, i64, i64)> = Vec::new();
+        let mut ecb = xdemitcb_t {
+            priv_: &mut result as *mut Vec<(i64, i64, i64, i64)> as *mut c_void,
+        };
+        let ret =
+            unsafe { xdl_diff_vendored(&mut a_mmfile, &mut b_mmfile, &xpp, &xecfg, &mut ecb) };
+        assert_eq!(ret, 0);
+        result
+    }
+
+    #[test]
+    fn test_histogram_diff() {
+        let a = "a\nb\nc\nd\n";
+        let b = "a\nc\nd\ne\n";
+        assert_eq!(
+            diff(a, b, XDF_HISTOGRAM_DIFF as u64),
+            [(1, 1, 1, 0), (4, 0, 3, 1)]
+        );
+    }
+
+    #[test]
+    fn test_xdl_diff_vendored() {
         let a = "a\nb\nc\nd\n".to_owned();
         let b = "a\nc\nd\ne\n".to_owned();
         let mut a_mmfile = mmfile_t {
@@ -1513,6 +1513,8 @@ if library_dirs is None:
 extra_libs = get_env_path_list("EXTRA_LIBS", [])
 
 osutil_cflags = []
+# listdirs and statfiles use threads
+osutil_libs = [] if iswindows else ["pthread"]
 
 # platform specific macros
 for plat, func in [("bsd", "setproctitle")]:
@@ -1561,6 +1563,7 @@ extmodules = [
         ["edenscm/cext/osutil.c"],
         include_dirs=include_dirs,
         extra_compile_args=osutil_cflags,
+        libraries=osutil_libs,
         depends=common_depends,
     ),
     Extension(
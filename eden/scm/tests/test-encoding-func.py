@@ -26,6 +26,49 @@ class IsasciistrTest(unittest.TestCase):
                 self.assertFalse(encoding.isasciistr(bytes(t)))
 
 
+class LongStringTest(unittest.TestCase):
+    """The C functions take 16 bytes at a time where they can, so check
+    strings long enough for that with the byte of interest everywhere."""
+
+    def strings(self):
+        base = bytes(range(32, 127)) * 2
+        for i in range(len(base)):
+            s = base[: i + 1]
+            yield s
+            for c in (b"\0", b"\n", b'"', b"\\", b"<", b"\x7f", b"\xc3"):
+                yield s[:i] + c + s[i + 1 :]
+
+    def testisasciistr(self):
+        for s in self.strings():
+            self.assertEqual(encoding.isasciistr(s), max(s) < 0x80)
+
+    def testasciicase(self):
+        for s in self.strings():
+            if max(s) < 0x80:
+                self.assertEqual(encoding.asciilower(s), s.lower())
+                self.assertEqual(encoding.asciiupper(s), s.upper())
+            else:
+                self.assertRaises(UnicodeDecodeError, encoding.asciilower, s)
+
+    def testjsonescape(self):
+        def escape(c, paranoid):
+            i = b'\b\t\n\f\r"\\'.find(c)
+            if i >= 0:
+                return b"\\" + b'btnfr"\\'[i : i + 1]
+            if ord(c) < 0x20 or c == b"\x7f" or (paranoid and c in b"<>"):
+                return b"\\u%04x" % ord(c)
+            return c
+
+        for s in self.strings():
+            if max(s) >= 0x80:
+                continue
+            for paranoid in (False, True):
+                expected = b"".join(
+                    escape(s[i : i + 1], paranoid) for i in range(len(s))
+                )
+                self.assertEqual(encoding.jsonescape(s, paranoid), expected)
+
+
 class LocalEncodingTest(unittest.TestCase):
     def testasciifastpath(self):
         s = b"\0" * 100
@@ -6,8 +6,10 @@
 
 from __future__ import absolute_import
 
+import os
 import random
 import sys
+import tempfile
 
 from edenscmnative import linelog
 
@@ -71,3 +73,27 @@ for lines, rev, a1, a2, b1, b2, blines, usevec in generator(seed, endrev):
 for lines, rev, a1, a2, b1, b2, blines, usevec in generator(seed, endrev):
     log.annotate(rev)
     ensure(lines == log.annotateresult)
+
+# annotating out of order resumes from the checkpoints of previous calls
+states = [list(t[0]) for t in generator(seed, endrev)]
+revs = list(range(1, endrev + 1))
+random.shuffle(revs)
+for rev in revs:
+    log.annotate(rev)
+    ensure(states[rev - 1] == log.annotateresult)
+
+# a read-only linelog maps the file as is
+path = os.path.join(tempfile.mkdtemp(), "linelog")
+filelog = linelog.linelog(path)
+filelog.copyfrom(log)
+filelog.close()
+rolog = linelog.linelog(path, readonly=True)
+for rev in revs[:100]:
+    rolog.annotate(rev)
+    ensure(states[rev - 1] == rolog.annotateresult)
+try:
+    rolog.replacelines(endrev + 1, 0, 0, 0, 1)
+    ensure(False)
+except ValueError:
+    pass
+rolog.close()
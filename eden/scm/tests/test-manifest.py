@@ -288,6 +288,26 @@ class basemanifesttests(object):
         except ValueError as v:
             self.assertIn("Manifest did not end in a newline.", str(v))
 
+    def testNoNode(self):
+        with self.assertRaises(ValueError):
+            self.parsemanifest(b"foo\n")
+
+    def testSetItemKeepsOrder(self):
+        m = self.parsemanifest(A_DEEPER_MANIFEST)
+        added = ["", "0", "a/b/c", "a/b/c/bar.pz", "b", "z/z", "\x7f"]
+        for f in added:
+            m[f] = BIN_HASH_1
+        want = sorted(list(self.parsemanifest(A_DEEPER_MANIFEST)) + added)
+        self.assertEqual(want, list(m))
+        for f in want:
+            self.assertIn(f, m)
+        for f in ["a/b/c/", "a/b/c/bar", "a/b/c/bar.py/", "c", "zz"]:
+            self.assertNotIn(f, m)
+        del m["b"]
+        want.remove("b")
+        self.assertEqual(want, list(m.copy()))
+        self.assertNotIn("b", m)
+
     def testHugeManifest(self):
         m = self.parsemanifest(A_HUGE_MANIFEST)
         self.assertEqual(HUGE_MANIFEST_ENTRIES, len(m))
@@ -0,0 +1,89 @@
+from __future__ import absolute_import
+
+import random
+import struct
+import unittest
+
+import silenttestrunner
+from edenscmnative import parsers
+
+
+def randomnode(rng):
+    return bytes(rng.getrandbits(8) for _ in range(20))
+
+
+def makeindex(nodes):
+    entries = [
+        struct.pack(">Qiiiiii20s12x", 0, 0, 0, rev, rev, rev - 1, -1, node)
+        for rev, node in enumerate(nodes)
+    ]
+    return parsers.parse_index2(b"".join(entries), False)[0]
+
+
+def append(index, nodes, start):
+    for rev, node in enumerate(nodes, start):
+        index.insert(-1, (0, 0, 0, rev, rev, rev - 1, -1, node))
+
+
+class testnodetree(unittest.TestCase):
+    def setUp(self):
+        rng = random.Random(0)
+        self.nodes = [randomnode(rng) for _ in range(3000)]
+        self.newnodes = [randomnode(rng) for _ in range(50)]
+        self.data = makeindex(self.nodes[:2000]).nodemapdata()
+
+    def assertMapsAll(self, index, nodes):
+        for rev, node in enumerate(nodes):
+            self.assertEqual(index[node], rev)
+            self.assertEqual(index.partialmatch(node.hex()), node)
+        self.assertNotIn(b"\1" * 20, index)
+
+    def testLookupsUseLoadedTrie(self):
+        index = makeindex(self.nodes)
+        self.assertEqual(index.loadnodemap(self.data), 2000)
+        self.assertEqual(index[self.nodes[10]], 10)
+        stats = index.stats()
+        self.assertEqual(stats["node trie misses"], 0)
+        self.assertEqual(stats["node trie persisted revs"], 2000)
+        self.assertMapsAll(index, self.nodes)
+
+    def testStaleDataIsIgnored(self):
+        self.assertIsNone(makeindex(self.nodes[1000:]).loadnodemap(self.data))
+        self.assertIsNone(makeindex(self.nodes[:1000]).loadnodemap(self.data))
+        self.assertIsNone(makeindex(self.nodes).loadnodemap(self.data[:-64]))
+        self.assertIsNone(makeindex(self.nodes).loadnodemap(b""))
+
+    def testAppendAndSave(self):
+        index = makeindex(self.nodes)
+        index.loadnodemap(self.data)
+        append(index, self.newnodes, len(self.nodes))
+        self.assertMapsAll(index, self.nodes + self.newnodes)
+
+        data = index.nodemapdata()
+        self.assertMapsAll(index, self.nodes + self.newnodes)
+        index = makeindex(self.nodes)
+        append(index, self.newnodes, len(self.nodes))
+        self.assertEqual(index.loadnodemap(data), len(self.nodes) + 50)
+        self.assertMapsAll(index, self.nodes + self.newnodes)
+
+    def testStripBelowLoadedTrie(self):
+        index = makeindex(self.nodes)
+        index.loadnodemap(self.data)
+        del index[1000:-1]
+        self.assertMapsAll(index, self.nodes[:1000])
+        for node in self.nodes[1000:]:
+            self.assertNotIn(node, index)
+
+    def testAmbiguousPrefix(self):
+        # the same prefix in the loaded trie and in an appended rev
+        node = self.nodes[5][:4] + b"\0" * 16
+        index = makeindex(self.nodes)
+        index.loadnodemap(self.data)
+        append(index, [node], len(self.nodes))
+        with self.assertRaises(Exception):
+            index.partialmatch(node[:4].hex())
+        self.assertEqual(index.partialmatch(node.hex()), node)
+
+
+if __name__ == "__main__":
+    silenttestrunner.main(__name__)